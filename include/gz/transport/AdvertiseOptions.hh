@@ -18,12 +18,15 @@
 #ifndef GZ_TRANSPORT_ADVERTISEOPTIONS_HH_
 #define GZ_TRANSPORT_ADVERTISEOPTIONS_HH_
 
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <string>
 
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
+#include "gz/transport/QueuePolicy.hh"
 
 namespace gz
 {
@@ -33,6 +36,7 @@ namespace gz
     inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
     //
     // Forward declarations.
+    class Clock;
     class AdvertiseOptionsPrivate;
     class AdvertiseMessageOptionsPrivate;
     class AdvertiseServiceOptionsPrivate;
@@ -51,6 +55,18 @@ namespace gz
       ALL
     };
 
+    /// \brief This strongly typed enum defines the codecs available to
+    /// compress the messages of a topic sent to other processes.
+    enum class Compression_t
+    {
+      /// \brief No compression (default).
+      NONE,
+      /// \brief LZ4, fast with a moderate compression ratio.
+      LZ4,
+      /// \brief Zstandard, slower with a better compression ratio.
+      ZSTD
+    };
+
     /// \class AdvertiseOptions AdvertiseOptions.hh
     /// gz/transport/AdvertiseOptions.hh
     /// \brief A class for customizing the publication options for a topic or
@@ -176,6 +192,68 @@ namespace gz
         }
         else
           _out << "\tThrottled? No" << std::endl;
+        if (_other.RateLimit() > 0)
+        {
+          _out << "\tRate limit: " << _other.RateLimit() << " msgs/sec (burst "
+               << _other.RateLimitBurst() << ")" << std::endl;
+        }
+        if (_other.BandwidthLimit() > 0)
+        {
+          _out << "\tBandwidth limit: " << _other.BandwidthLimit()
+               << " bytes/sec (burst " << _other.BandwidthBurst() << ")"
+               << std::endl;
+        }
+        if (_other.RateLimitRemoteOnly())
+          _out << "\tRate limit: remote only" << std::endl;
+        if (_other.Batched())
+        {
+          _out << "\tBatch size: " << _other.BatchSize() << " msgs"
+               << std::endl;
+          _out << "\tBatch period: " << _other.BatchPeriod().count() << " us"
+               << std::endl;
+        }
+        if (_other.Compression() != Compression_t::NONE)
+        {
+          _out << "\tCompression: "
+               << (_other.Compression() == Compression_t::LZ4 ? "LZ4" : "Zstd")
+               << " (level " << _other.CompressionLevel() << ")" << std::endl;
+        }
+        if (_other.Latched())
+        {
+          _out << "\tLatched: " << _other.LatchDepth() << " msgs"
+               << std::endl;
+        }
+        if (_other.Queued())
+        {
+          _out << "\tQueue: " << _other.QueueDepth() << " msgs (";
+          if (_other.QueuePolicy() == QueuePolicy_t::DROP_NEWEST)
+            _out << "drop newest";
+          else if (_other.QueuePolicy() == QueuePolicy_t::KEEP_ALL)
+            _out << "keep all";
+          else
+            _out << "drop oldest";
+          _out << ")" << std::endl;
+        }
+        if (_other.HighPriority())
+          _out << "\tPriority: high" << std::endl;
+        if (!_other.Interface().empty())
+          _out << "\tInterface: " << _other.Interface() << std::endl;
+        if (_other.Multicast())
+          _out << "\tMulticast: true" << std::endl;
+        if (_other.RealTime())
+        {
+          _out << "\tReal-time: " << _other.RealTimeSlots() << " slots of "
+               << _other.RealTimeSlotSize() << " bytes" << std::endl;
+        }
+        if (_other.FdPassing())
+          _out << "\tFile descriptor passing: true" << std::endl;
+        if (_other.Reliable())
+        {
+          _out << "\tReliable: " << _other.ReliableDepth() << " msgs"
+               << std::endl;
+        }
+        if (_other.Blackboard())
+          _out << "\tBlackboard: true" << std::endl;
 
         return _out;
       }
@@ -197,6 +275,402 @@ namespace gz
       /// \param[in] _newMsgsPerSec Maximum number of messages per second.
       public: void SetMsgsPerSec(const uint64_t _newMsgsPerSec);
 
+      /// \brief Measure the throttling period with a clock instead of the
+      /// steady clock of the system, e.g. with a NetworkClock following the
+      /// time of a simulation. The rate set with SetMsgsPerSec() is then
+      /// expressed in the time of the clock, and a paused simulation
+      /// publishes nothing after the first message. When the clock goes
+      /// back, e.g. when the simulation is reset, the next message is
+      /// published. Until the clock is ready, the steady clock is used.
+      /// \param[in] _clock The clock, or nullptr for the steady clock.
+      /// \sa ThrottleClock
+      public: void SetThrottleClock(std::shared_ptr<const Clock> _clock);
+
+      /// \brief Get the clock of the throttling.
+      /// \return The clock, or nullptr if the steady clock is used.
+      /// \sa SetThrottleClock
+      public: const std::shared_ptr<const Clock> &ThrottleClock() const;
+
+      /// \brief Get the average number of messages per second allowed by
+      /// the rate limit.
+      /// \return The rate, or 0 if the messages aren't limited.
+      /// \sa SetRateLimit
+      public: uint64_t RateLimit() const;
+
+      /// \brief Get the number of messages that can be published at once
+      /// after an idle period.
+      /// \return The burst size.
+      /// \sa SetRateLimit
+      public: uint64_t RateLimitBurst() const;
+
+      /// \brief Limit the average publication rate with a token bucket.
+      /// Unlike SetMsgsPerSec, which drops every message published less
+      /// than a period after the previous one, the bucket lets up to _burst
+      /// messages through at once after an idle period, so bursty but
+      /// legitimate traffic isn't dropped as long as its average rate stays
+      /// below the limit. The messages above the limit are dropped and
+      /// counted in PublisherStatistics::RateLimitedCount().
+      /// \param[in] _msgsPerSec Average number of messages per second, or 0
+      /// (the default) to disable the limit.
+      /// \param[in] _burst Capacity of the bucket (messages).
+      /// \sa SetBandwidthLimit
+      /// \sa SetRateLimitRemoteOnly
+      public: void SetRateLimit(const uint64_t _msgsPerSec,
+                                const uint64_t _burst = 1);
+
+      /// \brief Get the average number of bytes per second allowed by the
+      /// bandwidth limit.
+      /// \return The bandwidth, or 0 if it isn't limited.
+      /// \sa SetBandwidthLimit
+      public: uint64_t BandwidthLimit() const;
+
+      /// \brief Get the number of bytes that can be published at once after
+      /// an idle period.
+      /// \return The burst size (bytes).
+      /// \sa SetBandwidthLimit
+      public: uint64_t BandwidthBurst() const;
+
+      /// \brief Limit the average bandwidth of the publications, measured
+      /// on the serialized messages, with a token bucket, e.g. to share a
+      /// radio link between topics. A message larger than the burst is
+      /// published when the bucket is full and delays the next ones. The
+      /// messages above the limit are dropped and counted in
+      /// PublisherStatistics::RateLimitedCount().
+      /// \param[in] _bytesPerSec Average number of bytes per second, or 0
+      /// (the default) to disable the limit.
+      /// \param[in] _burst Capacity of the bucket (bytes). The default
+      /// value (0) allows one second worth of bytes.
+      /// \sa SetRateLimit
+      /// \sa SetRateLimitRemoteOnly
+      public: void SetBandwidthLimit(const uint64_t _bytesPerSec,
+                                     const uint64_t _burst = 0);
+
+      /// \brief Whether the rate and bandwidth limits only apply to the
+      /// messages sent to other processes.
+      /// \return True if the local subscribers receive every message.
+      /// \sa SetRateLimitRemoteOnly
+      public: bool RateLimitRemoteOnly() const;
+
+      /// \brief Apply the rate and bandwidth limits to the messages sent to
+      /// other processes only, e.g. over a shared radio link, while the
+      /// subscribers of this process receive every message.
+      /// \param[in] _remoteOnly Whether the limits only apply to the remote
+      /// subscribers. By default they apply to every subscriber.
+      public: void SetRateLimitRemoteOnly(const bool _remoteOnly);
+
+      /// \brief Whether the remote publications are sent in batches.
+      /// \return true when more than one message is sent per batch.
+      /// \sa SetBatchSize
+      public: bool Batched() const;
+
+      /// \brief Get the maximum number of messages sent in a batch.
+      /// \return The maximum number of messages per batch.
+      public: uint64_t BatchSize() const;
+
+      /// \brief Set the maximum number of messages sent in a batch. When it
+      /// is greater than one, the messages published to other processes are
+      /// coalesced and sent together once the batch is full or its period
+      /// has elapsed, whichever comes first. Subscribers receive the messages
+      /// one by one and in order. This reduces the per message overhead of
+      /// small high rate messages at the cost of some latency. Intraprocess
+      /// subscribers are not affected. Batching is disabled when topic
+      /// statistics are enabled.
+      /// \param[in] _batchSize Maximum number of messages per batch. The
+      /// default value (1) disables batching.
+      /// \sa SetBatchPeriod
+      public: void SetBatchSize(const uint64_t _batchSize);
+
+      /// \brief Get the maximum time that a message waits in a batch.
+      /// \return The batch period.
+      public: std::chrono::microseconds BatchPeriod() const;
+
+      /// \brief Set the maximum time that a message waits in a batch before
+      /// the batch is sent.
+      /// \param[in] _period The batch period.
+      /// \sa SetBatchSize
+      public: void SetBatchPeriod(const std::chrono::microseconds &_period);
+
+      /// \brief Get the codec used to compress the messages sent to other
+      /// processes.
+      /// \return The codec.
+      /// \sa SetCompression
+      public: Compression_t Compression() const;
+
+      /// \brief Get the compression level.
+      /// \return The compression level.
+      /// \sa SetCompression
+      public: int CompressionLevel() const;
+
+      /// \brief Compress the messages sent to other processes. Each message
+      /// (or batch of messages) is compressed once by the publisher and
+      /// decompressed once by every subscriber process. The codec is
+      /// advertised during discovery, and messages are sent uncompressed
+      /// while any remote subscriber doesn't support it (e.g. it was built
+      /// without the codec). Intraprocess and shared memory subscribers are
+      /// not affected.
+      /// \param[in] _codec The codec.
+      /// \param[in] _level Compression level. With Zstd, higher values
+      /// compress more and 0 selects the default level. With LZ4, this is
+      /// the acceleration factor: higher values are faster but compress
+      /// less, and values lower than 1 select the default (1).
+      public: void SetCompression(const Compression_t _codec,
+                                  const int _level = 0);
+
+      /// \brief Whether the last messages published are kept for late
+      /// subscribers.
+      /// \return true when the latch depth is greater than zero.
+      /// \sa SetLatchDepth
+      public: bool Latched() const;
+
+      /// \brief Get the number of messages kept for late subscribers.
+      /// \return The latch depth.
+      /// \sa SetLatchDepth
+      public: uint64_t LatchDepth() const;
+
+      /// \brief Keep the last messages published on the topic and deliver
+      /// them to every subscriber node in another process that discovers the
+      /// topic after they were published. Only the new subscriber receives
+      /// them. Intraprocess subscribers and topics advertised with
+      /// Scope_t::PROCESS are not affected.
+      /// \param[in] _depth Number of messages kept. The default value (0)
+      /// disables latching.
+      public: void SetLatchDepth(const uint64_t _depth);
+
+      /// \brief Whether the messages delivered to the subscribers of this
+      /// process are bounded per publisher.
+      /// \return true when the queue depth is greater than zero.
+      /// \sa SetQueue
+      public: bool Queued() const;
+
+      /// \brief Get the maximum number of messages of this publisher
+      /// waiting to be delivered to the subscribers of this process.
+      /// \return The queue depth, or 0 if the messages are not bounded.
+      /// \sa SetQueue
+      public: uint64_t QueueDepth() const;
+
+      /// \brief Get what happens when the queue of the publisher is full.
+      /// \return The queue policy.
+      /// \sa SetQueue
+      public: QueuePolicy_t QueuePolicy() const;
+
+      /// \brief Bound the messages of this publisher waiting in the queue
+      /// shared by all the local publications of the process, so a bursty
+      /// topic can't fill it and delay the other topics. When the bound is
+      /// reached, the oldest or the newest message of the publisher is
+      /// dropped, or Publish() waits for room (QueuePolicy_t::KEEP_ALL).
+      /// Dropped messages are counted in the topic statistics. Subscribers
+      /// in other processes are not affected.
+      /// \param[in] _depth Maximum number of queued messages. The default
+      /// value (0) only bounds the messages with the size of the shared
+      /// queue (GZ_TRANSPORT_PUB_QUEUE_SIZE).
+      /// \param[in] _policy What happens when the queue is full.
+      public: void SetQueue(const uint64_t _depth,
+                            const QueuePolicy_t _policy =
+                              QueuePolicy_t::DROP_OLDEST);
+
+      /// \brief Whether the topic is sent and delivered apart from the
+      /// regular topics.
+      /// \return true when the topic has high priority.
+      /// \sa SetHighPriority
+      public: bool HighPriority() const;
+
+      /// \brief Send and deliver the messages of the topic through a
+      /// dedicated lane: a separate socket and I/O thread for the remote
+      /// subscribers, a separate reception thread in the subscriber
+      /// processes and a separate queue and thread for the local
+      /// subscribers. A large message on a regular topic doesn't delay the
+      /// messages of a high priority topic (e.g. commands). Use it for a
+      /// few small and frequent topics only.
+      /// \param[in] _highPriority Whether the topic has high priority.
+      public: void SetHighPriority(const bool _highPriority);
+
+      /// \brief Get the network interface used to send the topic.
+      /// \return The IPv4 address of the interface, or an empty string for
+      /// the interface of the process (the default).
+      /// \sa SetInterface
+      public: std::string Interface() const;
+
+      /// \brief Send the messages of the topic to the remote subscribers
+      /// through a specific network interface, e.g. a fast network
+      /// dedicated to sensor data, instead of the interface of the process
+      /// (GZ_IP). The topic is sent through its own socket bound to the
+      /// interface, whose address is advertised to the subscribers. The
+      /// option is ignored by high priority topics.
+      /// \param[in] _ip IPv4 address of a local interface, or an empty
+      /// string for the interface of the process.
+      public: void SetInterface(const std::string &_ip);
+
+      /// \brief Whether the topic is sent through UDP multicast.
+      /// \return True if the topic is sent through multicast.
+      /// \sa SetMulticast
+      public: bool Multicast() const;
+
+      /// \brief Send the messages of the topic to the remote subscribers
+      /// through reliable UDP multicast (ZeroMQ's PGM transport) instead of
+      /// one TCP connection per subscriber. Every message is sent once,
+      /// whatever the number of subscribers, which suits large topics with
+      /// many remote subscribers, e.g. cameras. The publisher advertises
+      /// its multicast group, see GZ_TRANSPORT_MULTICAST_GROUP, and the
+      /// remote subscribers join it. Subscribers of the same host, and
+      /// those whose ZeroMQ library lacks PGM support, connect through TCP.
+      /// The topic falls back to TCP when the multicast socket can't be
+      /// created, the scope isn't ALL or authentication is enabled. The
+      /// option is ignored by high priority topics and by topics sent
+      /// through a specific interface.
+      /// \param[in] _multicast Whether the topic is sent through multicast.
+      /// \sa SetInterface
+      public: void SetMulticast(const bool _multicast);
+
+      /// \brief Get the topic where the publisher statistics are published.
+      /// \return The topic name, or an empty string if they aren't
+      /// published.
+      /// \sa SetStatisticsTopic
+      public: std::string StatisticsTopic() const;
+
+      /// \brief Get the publication rate of the publisher statistics.
+      /// \return The rate (messages per second).
+      /// \sa SetStatisticsTopic
+      public: uint64_t StatisticsRate() const;
+
+      /// \brief Publish the statistics of the publisher (see
+      /// Node::Publisher::Statistics) as gz.msgs.Metric messages. They are
+      /// published along with the messages of the publisher, at most
+      /// _msgsPerSec times per second.
+      /// \param[in] _topic Topic of the statistics, advertised by the same
+      /// node. An empty topic (the default) disables them.
+      /// \param[in] _msgsPerSec Publication rate of the statistics.
+      public: void SetStatisticsTopic(const std::string &_topic,
+                                      const uint64_t _msgsPerSec = 1);
+
+      /// \brief Whether the publisher can be used from a real-time thread.
+      /// \return True when the number of real-time slots is greater than
+      /// zero.
+      /// \sa SetRealTime
+      public: bool RealTime() const;
+
+      /// \brief Get the number of messages that the real-time thread can
+      /// publish ahead of the sender thread.
+      /// \return The number of slots, or 0 if the publisher isn't real-time.
+      /// \sa SetRealTime
+      public: uint64_t RealTimeSlots() const;
+
+      /// \brief Get the maximum size of a message published from the
+      /// real-time thread.
+      /// \return The size of a slot (bytes).
+      /// \sa SetRealTime
+      public: uint64_t RealTimeSlotSize() const;
+
+      /// \brief Make Node::Publisher::Publish() safe to call from a hard
+      /// real-time thread: it neither allocates, locks nor prints. The
+      /// message is serialized into one of the slots pre-allocated by
+      /// Node::Advertise() and handed over, lock-free, to a sender thread
+      /// that delivers it to the subscribers like any other publication.
+      /// Publish() returns false when all the slots are in use or the
+      /// message doesn't fit in a slot; these drops are counted in
+      /// PublisherStatistics::RealTimeDropCount(). The publisher must be
+      /// used by one thread at a time, and the real-time path only supports
+      /// protobuf messages of the advertised type.
+      /// \param[in] _slots Number of slots. The default value (0) disables
+      /// the real-time mode.
+      /// \param[in] _slotSize Maximum size of a serialized message (bytes).
+      public: void SetRealTime(const uint64_t _slots,
+                               const uint64_t _slotSize = 4096);
+
+      /// \brief Whether the publisher can pass file descriptors to the
+      /// subscribers of its host.
+      /// \return True if Node::Publisher::PublishFd() is enabled.
+      /// \sa SetFdPassing
+      public: bool FdPassing() const;
+
+      /// \brief Let Node::Publisher::PublishFd() pass file descriptors,
+      /// e.g. DMA-BUF camera frames or GPU buffers, along with a metadata
+      /// message to the subscribers of this host, which import the buffer
+      /// without any copy. Node::Advertise() opens a local socket for the
+      /// topic, advertised during discovery, and the subscriber processes
+      /// of the same host connect to it. Only one publisher per topic and
+      /// process can pass descriptors. This is only available on POSIX
+      /// systems.
+      /// \param[in] _fdPassing Whether descriptors can be passed.
+      public: void SetFdPassing(const bool _fdPassing);
+
+      /// \brief Whether the messages lost by the remote subscribers are
+      /// sent again.
+      /// \return true when the retransmit depth is greater than zero.
+      /// \sa SetReliableDepth
+      public: bool Reliable() const;
+
+      /// \brief Get the number of messages kept for retransmission.
+      /// \return The retransmit depth.
+      /// \sa SetReliableDepth
+      public: uint64_t ReliableDepth() const;
+
+      /// \brief Recover the messages that the subscribers in other
+      /// processes lose, e.g. when a high water mark overflows. The
+      /// publications are numbered and the last ones are kept, charged to
+      /// the memory budget. A subscriber that sees a gap in the numbers
+      /// asks the publisher for the missing messages, a few times, and
+      /// delivers them when they arrive, possibly after newer ones: use
+      /// MessageInfo::SequenceNumber() to reorder them. A message is lost
+      /// for good once it has left the buffer. The last message of a burst
+      /// is sent again shortly after it, so the subscribers that lost the
+      /// end of the burst find the gap.
+      /// The publications of a reliable topic are neither batched nor sent
+      /// through shared memory. Intraprocess subscribers and topics
+      /// advertised with Scope_t::PROCESS are not affected.
+      /// \param[in] _depth Number of messages kept. The default value (0)
+      /// disables the recovery.
+      public: void SetReliableDepth(const uint64_t _depth);
+
+      /// \brief Whether the latest message is kept in a shared memory
+      /// blackboard.
+      /// \return True if the processes of this host can read the latest
+      /// message with Node::OpenBlackboard().
+      /// \sa SetBlackboard
+      public: bool Blackboard() const;
+
+      /// \brief Keep the latest message of a state topic (a pose, the joint
+      /// states, a mode...) in a shared memory segment that the processes
+      /// of this host read with Node::OpenBlackboard(), when they want and
+      /// at their own rate, without subscribing. Every publication is
+      /// written to the segment once, so its cost doesn't depend on the
+      /// number of readers, and the readers never block the publisher. The
+      /// topic is still delivered to its subscribers as usual. There is one
+      /// blackboard per topic and host: the last process to advertise the
+      /// topic with a blackboard owns it. Messages larger than the slots
+      /// of the shared memory transport (GZ_TRANSPORT_SHM_SLOT_SIZE) are
+      /// not written. This is only available on POSIX systems.
+      /// \param[in] _blackboard Whether the latest message is kept.
+      public: void SetBlackboard(const bool _blackboard);
+
+      /// \brief Whether the rate of the remote publications adapts to the
+      /// capacity of the links to the subscribers.
+      /// \return True if a latency target is set.
+      /// \sa SetLatencyTarget
+      public: bool Adaptive() const;
+
+      /// \brief Get the latency target of the adaptive rate.
+      /// \return The target, or 0 if the rate isn't adaptive.
+      /// \sa SetLatencyTarget
+      public: std::chrono::milliseconds LatencyTarget() const;
+
+      /// \brief Adapt the rate of the remote publications to keep their
+      /// latency below a target, e.g. over a lossy wireless link where the
+      /// queues of ZeroMQ would otherwise grow for seconds before the
+      /// messages are dropped. The publisher probes the round trip time
+      /// to every subscriber process several times per second, through
+      /// the sockets of the publications, so the probes wait in the same
+      /// queues as the messages. While the slowest subscriber is above the
+      /// target, the rate of the remote publications is halved, down to one
+      /// message per second; once it is well below the target, the rate
+      /// increases again until the publications aren't limited any more.
+      /// The messages over the rate are conflated: the latest one is sent
+      /// when the rate allows it, if no newer message replaced it.
+      /// Intraprocess subscribers and topics advertised with
+      /// Scope_t::PROCESS are not affected.
+      /// \param[in] _target Latency target. The default value (0) disables
+      /// the adaptive rate.
+      public: void SetLatencyTarget(const std::chrono::milliseconds &_target);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -254,6 +728,71 @@ namespace gz
         return _out;
       }
 
+      /// \brief Get the maximum number of requests of the service executed
+      /// at the same time.
+      /// \return The concurrency, or 0 if the requests are executed by the
+      /// reception thread.
+      /// \sa SetConcurrency
+      public: unsigned int Concurrency() const;
+
+      /// \brief Execute the requests received from other processes on a
+      /// pool of workers (GZ_TRANSPORT_SERVICE_THREADS), so a slow service
+      /// doesn't block the reception of the topics and the other services.
+      /// The replies are sent in completion order. Requests from the same
+      /// process are not affected.
+      /// \param[in] _concurrency Maximum number of requests executed at the
+      /// same time. The default value (0) executes them one by one on the
+      /// reception thread.
+      public: void SetConcurrency(const unsigned int _concurrency);
+
+      /// \brief Get the maximum number of requests waiting for a worker.
+      /// \return The bound, or 0 if the waiting requests are not bounded.
+      /// \sa SetMaxPending
+      public: uint64_t MaxPending() const;
+
+      /// \brief Bound the requests waiting for a worker when the concurrency
+      /// is greater than 0. The requests received while the queue is full
+      /// fail right away.
+      /// \param[in] _maxPending Maximum number of waiting requests. The
+      /// default value (0) doesn't bound them.
+      public: void SetMaxPending(const uint64_t _maxPending);
+
+      /// \brief Whether the service returns the same response for the same
+      /// request.
+      /// \return True if the responses are cached by the requesters.
+      /// \sa SetIdempotent
+      public: bool Idempotent() const;
+
+      /// \brief Get the time that the requesters keep a response.
+      /// \return The time to live of the cached responses.
+      /// \sa SetIdempotent
+      public: std::chrono::milliseconds CacheTtl() const;
+
+      /// \brief Mark the service as idempotent: it returns the same response
+      /// for the same request (e.g. a robot description). The requesters in
+      /// other processes keep the successful responses and answer the same
+      /// requests locally until the time to live expires, the service is
+      /// unadvertised or Node::InvalidateServiceCache() is called.
+      /// \param[in] _idempotent Whether the service is idempotent.
+      /// \param[in] _ttl Time to live of the cached responses.
+      public: void SetIdempotent(const bool _idempotent,
+        const std::chrono::milliseconds &_ttl = std::chrono::seconds(1));
+
+      /// \brief Get the callback group of the service.
+      /// \return The name of the group, or an empty string if the requests
+      /// run on the threads shared by all the nodes.
+      /// \sa SetCallbackGroup
+      public: std::string CallbackGroup() const;
+
+      /// \brief Execute the requests received from other processes on the
+      /// threads of a callback group of the advertising node, see
+      /// Node::CreateCallbackGroup(). It takes precedence over
+      /// SetConcurrency(). If the node has no such group, the option is
+      /// ignored.
+      /// \param[in] _group The name of the group. The default (empty) uses
+      /// the shared threads.
+      public: void SetCallbackGroup(const std::string &_group);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
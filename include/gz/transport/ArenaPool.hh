@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_ARENAPOOL_HH_
+#define GZ_TRANSPORT_ARENAPOOL_HH_
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+#include <google/protobuf/arena.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <cstddef>
+#include <memory>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    class ArenaPoolPrivate;
+
+    /// \class ArenaPool ArenaPool.hh gz/transport/ArenaPool.hh
+    /// \brief A pool of recycled protobuf arenas.
+    ///
+    /// Every arena owns an initial memory block of a fixed size. When an
+    /// acquired arena is released, it is reset and returned to the pool, so
+    /// its initial block is reused by the next message. Messages that fit in
+    /// the block are deserialized without any heap allocation and all their
+    /// memory is returned wholesale at once.
+    class GZ_TRANSPORT_VISIBLE ArenaPool
+    {
+      /// \brief Default size of the initial block of an arena (bytes).
+      public: static constexpr std::size_t kDefaultBlockSize = 16 * 1024;
+
+      /// \brief Default maximum number of idle arenas kept in the pool.
+      public: static constexpr std::size_t kDefaultMaxIdle = 8;
+
+      /// \brief Constructor.
+      /// \param[in] _blockSize Size of the initial block of every arena.
+      /// \param[in] _maxIdle Maximum number of idle arenas kept for reuse.
+      /// Arenas released when the pool is full are destroyed.
+      public: explicit ArenaPool(std::size_t _blockSize = kDefaultBlockSize,
+                                 std::size_t _maxIdle = kDefaultMaxIdle);
+
+      /// \brief Destructor. Arenas still in use remain valid until they are
+      /// released.
+      public: ~ArenaPool();
+
+      /// \brief Acquire an arena. This function is thread safe.
+      /// \return The arena. It is reset and returned to the pool when the
+      /// last reference is released. Use the aliasing constructor of
+      /// std::shared_ptr to tie the lifetime of a message to its arena.
+      public: std::shared_ptr<google::protobuf::Arena> Acquire();
+
+      /// \brief Number of idle arenas ready to be reused.
+      /// \return The number of idle arenas.
+      public: std::size_t IdleCount() const;
+
+      /// \brief Size of the initial block of every arena.
+      /// \return The block size (bytes).
+      public: std::size_t BlockSize() const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::shared_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Pointer to private data. It is shared with the released
+      /// arenas, which return themselves to the pool while it exists.
+      private: std::shared_ptr<ArenaPoolPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
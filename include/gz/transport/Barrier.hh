@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_BARRIER_HH_
+#define GZ_TRANSPORT_BARRIER_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+#include "gz/transport/NodeOptions.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    // Forward declarations.
+    class BarrierPrivate;
+
+    /// \class Barrier Barrier.hh gz/transport/Barrier.hh
+    /// \brief A barrier shared by the participants of a lockstep
+    /// computation, e.g. the workers of a distributed simulation: every
+    /// participant calls Wait() at the end of a step, and all of them are
+    /// released when the last one arrives.
+    ///
+    /// The participants are the Barrier objects created with the same name
+    /// in the same partition, in any process. Each of them advertises the
+    /// topic of the barrier and announces its arrivals there, so an
+    /// arrival costs a single publication to the other participants, over
+    /// the sockets already connected by the discovery, and a participant is
+    /// released as soon as the last arrival is received. Participants that
+    /// miss an arrival, e.g. while they are still being connected, get it
+    /// again: a waiting participant repeats its arrival periodically.
+    ///
+    /// Example:
+    /// \code
+    /// gz::transport::Barrier barrier("/world/step", 4);
+    /// while (running)
+    /// {
+    ///   Step();
+    ///   if (!barrier.Wait(std::chrono::seconds(5)))
+    ///     std::cerr << "A worker is late" << std::endl;
+    /// }
+    /// \endcode
+    class GZ_TRANSPORT_VISIBLE Barrier
+    {
+      /// \brief Constructor.
+      /// \param[in] _name Name of the barrier, the topic of its arrivals.
+      /// Nothing else should be published on it.
+      /// \param[in] _participants Number of participants, this one
+      /// included. 0 counts the participants discovered when the steps are
+      /// released instead: the steps should then only start once all of
+      /// them are discovered, see Participants().
+      /// \param[in] _options Options of the node of the barrier, e.g. its
+      /// partition or namespace.
+      public: explicit Barrier(const std::string &_name,
+                               unsigned int _participants = 0,
+                               const NodeOptions &_options = NodeOptions());
+
+      /// \brief Destructor.
+      public: ~Barrier();
+
+      /// \brief Whether the barrier could advertise and subscribe to its
+      /// topic.
+      /// \return False if the name isn't a valid topic name.
+      public: bool Valid() const;
+
+      /// \brief Arrive at the barrier at the end of the current step and
+      /// wait until all the participants have arrived.
+      /// \param[in] _timeout Maximum time to wait.
+      /// \return True if the participants were released, and the step is
+      /// complete. False on timeout or if the barrier isn't valid: the
+      /// participant stays arrived at the current step, and the next call
+      /// waits for the same step.
+      public: bool Wait(const std::chrono::milliseconds &_timeout);
+
+      /// \brief Get the number of steps completed.
+      /// \return The number of successful calls to Wait().
+      public: uint64_t Step() const;
+
+      /// \brief Get the number of participants released together.
+      /// \return The number of participants given to the constructor, or
+      /// the number of participants currently discovered.
+      public: unsigned int Participants() const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Smart pointer to private data.
+      private: std::unique_ptr<BarrierPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_BRIDGE_HH_
+#define GZ_TRANSPORT_BRIDGE_HH_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+#include "gz/transport/NodeOptions.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    // Forward declarations.
+    class BridgePrivate;
+
+    /// \class Bridge Bridge.hh gz/transport/Bridge.hh
+    /// \brief Forward the topics of a partition to another partition.
+    ///
+    /// The bridge watches the topics published in the source partition and
+    /// forwards the ones matching its patterns to the same topic in the
+    /// destination partition. The messages are received with a raw
+    /// subscription and published from the serialized bytes, so they are
+    /// never parsed. Each pattern has its own advertise options, which can
+    /// cap the rate of the forwarded topics and batch and compress them on
+    /// the way to the other processes, e.g. over a WAN link.
+    ///
+    /// A bridge forwards in a single direction. Two bridges forwarding the
+    /// same topic in opposite directions would loop.
+    class GZ_TRANSPORT_VISIBLE Bridge
+    {
+      /// \brief Constructor.
+      /// \param[in] _from Options of the node subscribing in the source
+      /// partition.
+      /// \param[in] _to Options of the node publishing in the destination
+      /// partition.
+      public: Bridge(const NodeOptions &_from, const NodeOptions &_to);
+
+      /// \brief Destructor. It stops the bridge.
+      public: ~Bridge();
+
+      /// \brief Forward the topics matching a pattern. Call this before
+      /// Start(). A topic matching several patterns uses the options of the
+      /// first one.
+      /// \param[in] _pattern ECMAScript regular expression matching the
+      /// whole topic name, e.g. "/robot/.*".
+      /// \param[in] _opts Options of the topics in the destination
+      /// partition.
+      /// \return False if the pattern is invalid or the bridge is running.
+      public: bool AddTopics(const std::string &_pattern,
+                             const AdvertiseMessageOptions &_opts =
+                               AdvertiseMessageOptions());
+
+      /// \brief Create the nodes and start forwarding.
+      /// \return False if the bridge is already running, there is no
+      /// pattern or both partitions are the same.
+      public: bool Start();
+
+      /// \brief Stop forwarding. Start() can be called again later.
+      public: void Stop();
+
+      /// \brief Get the topics forwarded so far.
+      /// \return The topic names.
+      public: std::vector<std::string> Topics() const;
+
+      /// \brief Get the number of messages forwarded so far.
+      /// \return The number of messages.
+      public: uint64_t ForwardedMessages() const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Smart pointer to private data.
+      private: std::unique_ptr<BridgePrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
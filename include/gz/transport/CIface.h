@@ -18,6 +18,8 @@
 #ifndef INCLUDE_GZ_TRANSPORT_CIFACE_H_
 #define INCLUDE_GZ_TRANSPORT_CIFACE_H_
 
+#include <stddef.h>
+
 #include "gz/transport/Export.hh"
 
 #ifdef __cplusplus
@@ -32,6 +34,33 @@ extern "C" {
   /// \brief A transport node.
   typedef struct GzTransportNode GzTransportNode;
 
+  /// \brief A publisher handle, see gzTransportAdvertisePublisher.
+  typedef struct GzTransportPublisher GzTransportPublisher;
+
+  /// \brief A writable buffer lent by a publisher, see
+  /// gzTransportLoanAcquire.
+  typedef struct GzTransportLoan GzTransportLoan;
+
+  /// \brief A received message borrowed from the transport. The pointers
+  /// are only valid during the callback.
+  typedef struct GzTransportMsgView
+  {
+    /// \brief Serialized message.
+    const void *data;
+
+    /// \brief Size of the serialized message.
+    size_t size;
+
+    /// \brief Name of the message type.
+    const char *msgType;
+
+    /// \brief Name of the topic, without the partition.
+    const char *topic;
+
+    /// \brief Non-zero if the publisher lives in this process.
+    int intraProcess;
+  } GzTransportMsgView;
+
   /// \brief Create a transport node.
   /// \param[in] _partition Optional name of the partition to use.
   /// Use nullptr to use the default value, which is specified via the
@@ -69,6 +98,100 @@ extern "C" {
                       const void *_data,
                       const char *_msgType);
 
+  /// \brief Advertise a topic and get a handle to publish on it. Publishing
+  /// through the handle skips the lookup of the topic in the node.
+  /// \param[in] _node Pointer to a node.
+  /// \param[in] _topic Topic on which to publish the messages.
+  /// \param[in] _msgType Name of the message type.
+  /// \return A pointer to the publisher or NULL on error. Destroy it with
+  /// gzTransportPublisherDestroy before destroying the node.
+  GzTransportPublisher GZ_TRANSPORT_VISIBLE *gzTransportAdvertisePublisher(
+      GzTransportNode *_node,
+      const char *_topic,
+      const char *_msgType);
+
+  /// \brief Destroy a publisher handle. The topic stays advertised until
+  /// the node unadvertises it or is destroyed.
+  /// \param[in, out] _pub The publisher to destroy. It is set to NULL.
+  void GZ_TRANSPORT_VISIBLE
+  gzTransportPublisherDestroy(GzTransportPublisher **_pub);
+
+  /// \brief Publish a message with a publisher handle.
+  /// \param[in] _pub Pointer to a publisher.
+  /// \param[in] _data Serialized message of the advertised type.
+  /// \param[in] _size Size (bytes) of the serialized message.
+  /// \return 0 on success.
+  int GZ_TRANSPORT_VISIBLE
+  gzTransportPublisherPublish(GzTransportPublisher *_pub,
+                              const void *_data,
+                              size_t _size);
+
+  /// \brief Publish several messages with a publisher handle.
+  /// \param[in] _pub Pointer to a publisher.
+  /// \param[in] _data Array of _count serialized messages of the advertised
+  /// type.
+  /// \param[in] _sizes Array of _count sizes (bytes) of the messages.
+  /// \param[in] _count Number of messages.
+  /// \return The number of messages published, in order, or -1 if the
+  /// arguments are not valid.
+  int GZ_TRANSPORT_VISIBLE
+  gzTransportPublisherPublishBatch(GzTransportPublisher *_pub,
+                                   const void *const *_data,
+                                   const size_t *_sizes,
+                                   size_t _count);
+
+  /// \brief Borrow a buffer to serialize a message in place, advertising
+  /// the topic if needed. The buffer is shared with the transport, so
+  /// committing it doesn't copy the message. Every loan must be either
+  /// committed with gzTransportLoanCommit or returned with
+  /// gzTransportLoanRelease.
+  /// \param[in] _node Pointer to a node.
+  /// \param[in] _topic Topic on which to publish the message.
+  /// \param[in] _msgType Name of the message type.
+  /// \param[in] _size Size (bytes) of the serialized message.
+  /// \return A pointer to the loan or NULL on error.
+  GzTransportLoan GZ_TRANSPORT_VISIBLE *gzTransportLoanAcquire(
+      GzTransportNode *_node,
+      const char *_topic,
+      const char *_msgType,
+      size_t _size);
+
+  /// \brief Get the buffer of a loan.
+  /// \param[in] _loan Pointer to a loan.
+  /// \return Pointer to the buffer or NULL if the loan is NULL.
+  void GZ_TRANSPORT_VISIBLE *gzTransportLoanData(GzTransportLoan *_loan);
+
+  /// \brief Get the size of the buffer of a loan.
+  /// \param[in] _loan Pointer to a loan.
+  /// \return The size requested in gzTransportLoanAcquire or 0 if the loan
+  /// is NULL.
+  size_t GZ_TRANSPORT_VISIBLE gzTransportLoanSize(
+      const GzTransportLoan *_loan);
+
+  /// \brief Publish the message serialized in a loaned buffer. The loan is
+  /// consumed, even if the publication fails.
+  /// \param[in, out] _loan The loan to publish. It is set to NULL.
+  /// \return 0 on success.
+  int GZ_TRANSPORT_VISIBLE gzTransportLoanCommit(GzTransportLoan **_loan);
+
+  /// \brief Give back a loan without publishing it.
+  /// \param[in, out] _loan The loan to release. It is set to NULL.
+  void GZ_TRANSPORT_VISIBLE gzTransportLoanRelease(GzTransportLoan **_loan);
+
+  /// \brief Subscribe to a topic, and register a callback that receives
+  /// the message borrowed from the transport, without copies.
+  /// \param[in] _node Pointer to a node.
+  /// \param[in] _topic Name of the topic.
+  /// \param[in] _callback The function to call when a message is received.
+  /// The view and the data it points to are only valid during the call.
+  /// \param[in] _userData Arbitrary user data pointer.
+  /// \return 0 on success.
+  int GZ_TRANSPORT_VISIBLE
+  gzTransportSubscribeView(GzTransportNode *_node,
+                const char *_topic,
+                void (*_callback)(const GzTransportMsgView *, void *),
+                void *_userData);
+
   /// \brief Subscribe to a topic, and register a callback.
   /// \param[in] _node Pointer to a node.
   /// \param[in] _topic Name of the topic.
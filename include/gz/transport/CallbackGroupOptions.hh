@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_CALLBACKGROUPOPTIONS_HH_
+#define GZ_TRANSPORT_CALLBACKGROUPOPTIONS_HH_
+
+#include <memory>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    class CallbackGroupOptionsPrivate;
+
+    /// \brief This strongly typed enum defines whether the callbacks of a
+    /// callback group may run at the same time.
+    /// \sa CallbackGroupOptions::SetType
+    enum class CallbackGroup_t
+    {
+      /// \brief The callbacks of the group run one at a time (default).
+      MUTUALLY_EXCLUSIVE,
+      /// \brief The callbacks of different subscriptions and services of the
+      /// group run in parallel. The callbacks of the same subscription or
+      /// service still run one at a time, in order.
+      REENTRANT
+    };
+
+    /// \class CallbackGroupOptions CallbackGroupOptions.hh
+    /// gz/transport/CallbackGroupOptions.hh
+    /// \brief Options of a callback group: the threads running the
+    /// callbacks of the subscriptions and services assigned to the group,
+    /// instead of the threads shared by all the nodes.
+    /// \sa Node::CreateCallbackGroup
+    class GZ_TRANSPORT_VISIBLE CallbackGroupOptions
+    {
+      /// \brief Constructor.
+      public: CallbackGroupOptions();
+
+      /// \brief Copy constructor.
+      /// \param[in] _other CallbackGroupOptions to copy.
+      public: CallbackGroupOptions(const CallbackGroupOptions &_other);
+
+      /// \brief Destructor.
+      public: ~CallbackGroupOptions();
+
+      /// \brief Assignment operator.
+      /// \param[in] _other The other CallbackGroupOptions.
+      /// \return A reference to this instance.
+      public: CallbackGroupOptions &operator=(
+        const CallbackGroupOptions &_other);
+
+      /// \brief Get whether the callbacks of the group may run at the same
+      /// time.
+      /// \return The type of the group.
+      /// \sa SetType
+      public: CallbackGroup_t Type() const;
+
+      /// \brief Set whether the callbacks of the group may run at the same
+      /// time.
+      /// \param[in] _type The type of the group. The default is
+      /// CallbackGroup_t::MUTUALLY_EXCLUSIVE.
+      public: void SetType(const CallbackGroup_t _type);
+
+      /// \brief Get the number of threads of the group.
+      /// \return The number of threads.
+      /// \sa SetThreads
+      public: unsigned int Threads() const;
+
+      /// \brief Set the number of threads of the group. A mutually
+      /// exclusive group only uses one of them at a time.
+      /// \param[in] _threads The number of threads. The default value is 1,
+      /// and 0 is treated as 1.
+      public: void SetThreads(const unsigned int _threads);
+
+      /// \brief Get the real-time priority of the threads of the group.
+      /// \return The priority, or 0 for the default scheduling.
+      /// \sa SetPriority
+      public: int Priority() const;
+
+      /// \brief Run the threads of the group with the SCHED_FIFO real-time
+      /// policy. It requires the CAP_SYS_NICE capability or a suitable
+      /// RLIMIT_RTPRIO, otherwise a warning is printed and the threads keep
+      /// the default scheduling. Only supported on Linux.
+      /// \param[in] _priority Priority between 1 and 99, or 0 (default) for
+      /// the default scheduling.
+      public: void SetPriority(const int _priority);
+
+      /// \brief Get the CPUs on which the threads of the group run.
+      /// \return The CPU indices, or an empty vector for any CPU.
+      /// \sa SetCpus
+      public: const std::vector<int> &Cpus() const;
+
+      /// \brief Pin the threads of the group to a set of CPUs, e.g. cores
+      /// isolated for the real-time callbacks. Only supported on Linux.
+      /// \param[in] _cpus The CPU indices. The default (empty) doesn't pin
+      /// the threads.
+      public: void SetCpus(const std::vector<int> &_cpus);
+
+      /// \brief Get the NUMA node of the threads of the group.
+      /// \return The NUMA node, or -1 for none.
+      /// \sa SetNumaNode
+      public: int NumaNode() const;
+
+      /// \brief Run the threads of the group on a NUMA node, e.g. the node
+      /// of the threads consuming the messages of its subscriptions: the
+      /// memory allocated by the callbacks comes from that node and, unless
+      /// SetCpus() is used, the threads run on its CPUs. Only supported on
+      /// Linux.
+      /// \param[in] _node The NUMA node, or -1 (default) for none.
+      public: void SetNumaNode(const int _node);
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Smart pointer to private data.
+      private: std::unique_ptr<CallbackGroupOptionsPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
@@ -85,6 +85,25 @@ namespace gz
         // Documentation inherited
         public: bool IsReady() const override;
 
+        /// \brief Set whether the time advances between the clock messages.
+        /// The rate of the clock relative to the steady clock of this host
+        /// is estimated from the messages, and Time() extrapolates the time
+        /// of the last message at that rate, at most until the next message
+        /// is expected. The time never goes back, except when the clock
+        /// itself does, e.g. on a reset of a simulation: if a message is
+        /// behind the extrapolated time, as when a simulation is paused,
+        /// the time holds until the messages catch up. The clock can then
+        /// be published at a fraction of the rate of its consumers.
+        /// Disabled by default.
+        /// \param[in] _interpolate True to extrapolate the time.
+        /// \sa Interpolation
+        public: void SetInterpolation(bool _interpolate);
+
+        /// \brief Whether the time advances between the clock messages.
+        /// \return True if the time is extrapolated.
+        /// \sa SetInterpolation
+        public: bool Interpolation() const;
+
         /// \internal Implementation of this class
         private: class Implementation;
 
@@ -59,13 +59,21 @@
 #include <gz/msgs/discovery.pb.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdio>
+#include <fstream>
 #include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <random>
+#include <set>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <gz/msgs/Utility.hh>
@@ -105,6 +113,18 @@ namespace gz
       const std::vector<int> &_sockets,
       const int _timeout);
 
+    /// \internal
+    /// \brief Discovery helper function to poll several sockets.
+    /// \param[in] _sockets Sockets on which to listen.
+    /// \param[in] _timeout Length of time to poll (milliseconds), or -1 to
+    /// wait forever.
+    /// \param[out] _readable Whether each socket can be read.
+    /// \return True if any socket can be read.
+    bool GZ_TRANSPORT_VISIBLE pollSockets(
+      const std::vector<int> &_sockets,
+      const int _timeout,
+      std::vector<bool> &_readable);
+
     /// \class Discovery Discovery.hh gz/transport/Discovery.hh
     /// \brief A discovery class that implements a distributed topic discovery
     /// protocol. It uses UDP multicast for sending/receiving messages and
@@ -122,10 +142,14 @@ namespace gz
       /// \param[in] _ip IP address used for discovery traffic.
       /// \param[in] _port UDP port used for discovery traffic.
       /// \param[in] _verbose true for enabling verbose mode.
+      /// \param[in] _open False to create the sockets later, with Open() or
+      /// Start(). Until then, only the publishers with a process scope can be
+      /// advertised.
       public: Discovery(const std::string &_pUuid,
                         const std::string &_ip,
                         const int _port,
-                        const bool _verbose = false)
+                        const bool _verbose = false,
+                        const bool _open = true)
         : multicastGroup(_ip),
           port(_port),
           hostAddr(determineHost()),
@@ -152,6 +176,52 @@ namespace gz
           this->hostInterfaces = determineInterfaces();
         }
 
+        // With a discovery server, we only talk to the server and the first
+        // socket doesn't need the shared discovery port.
+        std::string gzServer;
+        this->serverMode =
+          env("GZ_DISCOVERY_SERVER", gzServer) && !gzServer.empty();
+
+        this->deferred = !_open;
+        if (_open)
+          this->Open();
+
+        // Set 'mcastAddr' to the multicast discovery group.
+        memset(&this->mcastAddr, 0, sizeof(this->mcastAddr));
+        this->mcastAddr.sin_family = AF_INET;
+        this->mcastAddr.sin_addr.s_addr =
+          inet_addr(this->multicastGroup.c_str());
+        this->mcastAddr.sin_port = htons(static_cast<u_short>(this->port));
+
+        std::vector<std::string> relays;
+        std::string gzRelay = "";
+        if (this->serverMode)
+        {
+          // The server is our only peer.
+          relays = {gzServer};
+        }
+        else if (env("GZ_RELAY", gzRelay) && !gzRelay.empty())
+        {
+          relays = transport::split(gzRelay, ':');
+        }
+
+        // Register all unicast relays.
+        for (auto const &relayAddr : relays)
+          this->AddRelayAddress(relayAddr);
+
+        if (this->verbose)
+          this->PrintCurrentState();
+      }
+
+      /// \brief Create the sockets used to exchange the discovery messages,
+      /// if the constructor didn't. Start() calls it too.
+      /// \return False if the sockets couldn't be created.
+      public: bool Open()
+      {
+        if (this->opened)
+          return !this->sockets.empty();
+        this->opened = true;
+
 #ifdef _WIN32
         WORD wVersionRequested;
         WSADATA wsaData;
@@ -162,7 +232,7 @@ namespace gz
         if (WSAStartup(wVersionRequested, &wsaData) != 0)
         {
           std::cerr << "Unable to load WinSock DLL" << std::endl;
-          return;
+          return false;
         }
 #endif
         for (const auto &netIface : this->hostInterfaces)
@@ -184,6 +254,8 @@ namespace gz
           }
         }
 
+        this->CreateHostSocket();
+
         // Socket option: SO_REUSEADDR. This options is used only for receiving
         // data. We can reuse the same socket for receiving multicast data from
         // multiple interfaces. We will use the socket at position 0 for
@@ -194,7 +266,7 @@ namespace gz
         {
           std::cerr << "Error setting socket option (SO_REUSEADDR)."
                     << std::endl;
-          return;
+          return false;
         }
 
 #ifdef SO_REUSEPORT
@@ -209,7 +281,7 @@ namespace gz
         {
           std::cerr << "Error setting socket option (SO_REUSEPORT)."
                     << std::endl;
-          return;
+          return false;
         }
 #endif
         // Bind the first socket to the discovery port.
@@ -217,35 +289,41 @@ namespace gz
         memset(&localAddr, 0, sizeof(localAddr));
         localAddr.sin_family = AF_INET;
         localAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-        localAddr.sin_port = htons(static_cast<u_short>(this->port));
+        localAddr.sin_port = this->serverMode ?
+          0 : htons(static_cast<u_short>(this->port));
 
         if (bind(this->sockets.at(0),
           reinterpret_cast<sockaddr *>(&localAddr), sizeof(sockaddr_in)) < 0)
         {
           std::cerr << "Binding to a local port failed." << std::endl;
-          return;
+          return false;
         }
 
-        // Set 'mcastAddr' to the multicast discovery group.
-        memset(&this->mcastAddr, 0, sizeof(this->mcastAddr));
-        this->mcastAddr.sin_family = AF_INET;
-        this->mcastAddr.sin_addr.s_addr =
-          inet_addr(this->multicastGroup.c_str());
-        this->mcastAddr.sin_port = htons(static_cast<u_short>(this->port));
-
-        std::vector<std::string> relays;
-        std::string gzRelay = "";
-        if (env("GZ_RELAY", gzRelay) && !gzRelay.empty())
+        // The kernel stamps the heartbeats, so the clock offsets of the
+        // peers don't include the scheduling delay of our thread.
+        enableReceiveTimestamps(this->sockets.at(0));
+
+        // Socket used to interrupt the reception thread, so it can sleep
+        // until the next deadline.
+        this->wakeSocket = static_cast<int>(socket(AF_INET, SOCK_DGRAM, 0));
+        memset(&this->wakeAddr, 0, sizeof(this->wakeAddr));
+        this->wakeAddr.sin_family = AF_INET;
+        this->wakeAddr.sin_addr.s_addr = inet_addr("127.0.0.1");
+        socklen_t wakeAddrLen = sizeof(this->wakeAddr);
+        if (this->wakeSocket < 0 ||
+            bind(this->wakeSocket,
+              reinterpret_cast<sockaddr *>(&this->wakeAddr),
+              sizeof(this->wakeAddr)) != 0 ||
+            getsockname(this->wakeSocket,
+              reinterpret_cast<sockaddr *>(&this->wakeAddr),
+              &wakeAddrLen) != 0)
         {
-          relays = transport::split(gzRelay, ':');
+          std::cerr << "Discovery: Unable to create the wake up socket."
+                    << std::endl;
+          this->CloseWakeSocket();
         }
 
-        // Register all unicast relays.
-        for (auto const &relayAddr : relays)
-          this->AddRelayAddress(relayAddr);
-
-        if (this->verbose)
-          this->PrintCurrentState();
+        return true;
       }
 
       /// \brief Destructor.
@@ -256,14 +334,29 @@ namespace gz
         this->exit = true;
         this->exitMutex.unlock();
 
+        // It might be waiting for the next heartbeat.
+        if (this->wakeSocket >= 0)
+        {
+          const char signal = 0;
+          sendto(this->wakeSocket, reinterpret_cast<const raw_type *>(&signal),
+            sizeof(signal), 0,
+            reinterpret_cast<const sockaddr *>(&this->wakeAddr),
+            sizeof(this->wakeAddr));
+        }
+
         // Wait for the service threads to finish before exit.
         if (this->threadReception.joinable())
           this->threadReception.join();
 
+        this->SaveCache();
+
         // Broadcast a BYE message to trigger the remote cancellation of
         // all our advertised topics.
-        this->SendMsg(DestinationType::ALL, msgs::Discovery::BYE,
-          Publisher("", "", this->pUuid, "", AdvertiseOptions()));
+        if (!this->sockets.empty())
+        {
+          this->SendMsg(DestinationType::ALL, msgs::Discovery::BYE,
+            Publisher("", "", this->pUuid, "", AdvertiseOptions()));
+        }
 
         // Close sockets.
         for (const auto &sock : this->sockets)
@@ -275,13 +368,42 @@ namespace gz
           close(sock);
 #endif
         }
+        this->CloseWakeSocket();
+
+        if (this->hostSocket >= 0)
+        {
+#ifdef _WIN32
+          closesocket(this->hostSocket);
+#else
+          close(this->hostSocket);
+#endif
+        }
+      }
+
+      /// \brief Close the socket used to interrupt the reception thread.
+      private: void CloseWakeSocket()
+      {
+        if (this->wakeSocket < 0)
+          return;
+
+#ifdef _WIN32
+        closesocket(this->wakeSocket);
+#else
+        close(this->wakeSocket);
+#endif
+        this->wakeSocket = -1;
       }
 
       /// \brief Start the discovery service. You probably want to register the
       /// callbacks for receiving discovery notifications before starting the
       /// service.
-      public: void Start()
+      /// \param[in] _ownThread Whether the service runs on its own thread.
+      /// Otherwise the caller polls Socket() and calls Process() within
+      /// Timeout(), e.g. from its own event loop.
+      public: void Start(const bool _ownThread = true)
       {
+        this->Open();
+
         {
           std::lock_guard<std::mutex> lock(this->mutex);
 
@@ -295,29 +417,90 @@ namespace gz
         auto now = std::chrono::steady_clock::now();
         this->timeNextHeartbeat = now;
         this->timeNextActivity = now;
+        this->timeNextBurst = now;
+        this->burstDelay = kFirstBurstDelay;
+        this->burstsLeft = this->fastStart ? kStartupBursts : 0;
+
+        // Reconnect to the publishers known by a previous run.
+        this->LoadCache();
 
         // Start the thread that receives discovery information.
-        this->threadReception = std::thread(&Discovery::RecvMessages, this);
+        if (_ownThread)
+          this->threadReception = std::thread(&Discovery::RecvMessages, this);
+      }
+
+      /// \brief Get the socket receiving the discovery messages, to poll it
+      /// when the service doesn't run on its own thread.
+      /// \return The socket.
+      /// \sa Start
+      public: int Socket() const
+      {
+        return this->sockets.at(0);
+      }
+
+      /// \brief Get the time left before Process() has to be called, to
+      /// send the heartbeats and expire the silent peers, when the service
+      /// doesn't run on its own thread.
+      /// \return The timeout (milliseconds).
+      /// \sa Start
+      public: int Timeout() const
+      {
+        return this->NextTimeout();
+      }
+
+      /// \brief Receive a discovery message if there is one, then send the
+      /// heartbeats and expire the silent peers if it is time to. Only used
+      /// when the service doesn't run on its own thread.
+      /// \param[in] _readable Whether Socket() is readable.
+      /// \sa Start
+      public: void Process(const bool _readable)
+      {
+        if (_readable)
+        {
+          this->RecvDiscoveryUpdate();
+
+          if (this->verbose)
+            this->PrintCurrentState();
+        }
+
+        this->UpdateBurst();
+        this->UpdateHeartbeat();
+        this->UpdateActivity();
+        this->UpdateSubscribersRep();
       }
 
       /// \brief Advertise a new message.
       /// \param[in] _publisher Publisher's information to advertise.
+      /// \param[in] _announce False to only register the publisher. The
+      /// caller then announces it with Announce(), e.g. together with other
+      /// publishers.
       /// \return True if the method succeed or false otherwise
       /// (e.g. if the discovery has not been started).
-      public: bool Advertise(const Pub &_publisher)
+      public: bool Advertise(const Pub &_publisher, const bool _announce = true)
       {
         DiscoveryCallback<Pub> cb;
 
         {
           std::lock_guard<std::mutex> lock(this->mutex);
 
-          if (!this->enabled)
+          // When the sockets are created later, the publishers of this
+          // process can already be registered.
+          if (!this->enabled && (!this->deferred ||
+                _publisher.Options().Scope() != Scope_t::PROCESS))
+          {
             return false;
+          }
 
           // Add the addressing information (local publisher).
           if (!this->info.AddPublisher(_publisher))
             return false;
 
+          if (_publisher.Options().Scope() != Scope_t::PROCESS)
+          {
+            ++this->advVersion;
+            this->GraphChanged();
+          }
+
           cb = this->connectionCb;
         }
 
@@ -326,13 +509,27 @@ namespace gz
 
         // Only advertise a message outside this process if the scope
         // is not 'Process'
-        if (_publisher.Options().Scope() != Scope_t::PROCESS)
+        if (_announce && _publisher.Options().Scope() != Scope_t::PROCESS)
           this->SendMsg(DestinationType::ALL, msgs::Discovery::ADVERTISE,
               _publisher);
 
         return true;
       }
 
+      /// \brief Announce publishers registered with Advertise(). The
+      /// messages are packed in as few datagrams as possible when batching
+      /// is enabled.
+      /// \param[in] _publishers Publishers' information to announce.
+      /// \sa SetBatching.
+      public: void Announce(const std::vector<Pub> &_publishers) const
+      {
+        if (!_publishers.empty())
+        {
+          this->SendMsgs(
+            DestinationType::ALL, msgs::Discovery::ADVERTISE, _publishers);
+        }
+      }
+
       /// \brief Request discovery information about a topic.
       /// When using this method, the user might want to use
       /// SetConnectionsCb() and SetDisconnectionCb(), that registers callbacks
@@ -356,6 +553,7 @@ namespace gz
             return false;
 
           cb = this->connectionCb;
+          this->discoveredTopics.insert(_topic);
         }
 
         Pub pub;
@@ -391,6 +589,62 @@ namespace gz
         return true;
       }
 
+      /// \brief Request discovery information about several topics. The
+      /// requests are packed in as few datagrams as possible when batching
+      /// is enabled.
+      /// \param[in] _topics Topic names requested.
+      /// \return True if the method succeeded or false otherwise
+      /// (e.g. if the discovery has not been started).
+      /// \sa Discover(const std::string &).
+      /// \sa SetBatching.
+      public: bool Discover(const std::vector<std::string> &_topics) const
+      {
+        DiscoveryCallback<Pub> cb;
+        std::vector<Pub> pubs;
+        pubs.reserve(_topics.size());
+
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+
+          if (!this->enabled)
+            return false;
+
+          cb = this->connectionCb;
+          for (const auto &topic : _topics)
+          {
+            this->discoveredTopics.insert(topic);
+            pubs.emplace_back();
+            pubs.back().SetTopic(topic);
+            pubs.back().SetPUuid(this->pUuid);
+          }
+        }
+
+        // Send the discovery requests.
+        this->SendMsgs(DestinationType::ALL, msgs::Discovery::SUBSCRIBE, pubs);
+
+        if (!cb)
+          return true;
+
+        // Notify the publishers that I already know.
+        for (const auto &topic : _topics)
+        {
+          Addresses_M<Pub> addresses;
+          {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->info.Publishers(topic, addresses))
+              continue;
+          }
+
+          for (const auto &proc : addresses)
+          {
+            for (const auto &node : proc.second)
+              cb(node);
+          }
+        }
+
+        return true;
+      }
+
       /// \brief Send the response to a SUBSCRIBERS_REQ message.
       /// \param[in] _pub Information to send.
       public: void SendSubscribersRep(const MessagePublisher &_pub) const
@@ -399,6 +653,17 @@ namespace gz
           DestinationType::ALL, msgs::Discovery::SUBSCRIBERS_REP, _pub);
       }
 
+      /// \brief Send the response to a SUBSCRIBERS_REQ message, or announce
+      /// new subscribers, for several subscribers at once. When batching is
+      /// enabled, they are packed in as few datagrams as possible.
+      /// \param[in] _pubs Information to send.
+      /// \sa SetBatching.
+      public: void SendSubscribersReps(const std::vector<Pub> &_pubs) const
+      {
+        this->SendMsgs(
+          DestinationType::ALL, msgs::Discovery::SUBSCRIBERS_REP, _pubs);
+      }
+
       /// \brief Register a node from this process as a remote subscriber.
       /// \param[in] _pub Contains information about the subscriber.
       public: void Register(const MessagePublisher &_pub) const
@@ -434,6 +699,20 @@ namespace gz
         return this->info.Publishers(_topic, _publishers);
       }
 
+      /// \brief Visit all the publishers known for a given topic without
+      /// copying them.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _visitor Function called with every publisher, as
+      /// `void(const Pub &)`. It runs with the discovery locked, so it must
+      /// not call this discovery.
+      /// \return True if the topic is found and there is at least one publisher
+      public: template<typename F>
+      bool VisitPublishers(const std::string &_topic, F &&_visitor) const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->info.VisitPublishers(_topic, std::forward<F>(_visitor));
+      }
+
       /// \brief Get all the subscribers' information known for a given topic.
       /// \param[in] _topic Topic name.
       /// \param[out] _subscribers All remote subscribers for this topic.
@@ -459,7 +738,9 @@ namespace gz
         {
           std::lock_guard<std::mutex> lock(this->mutex);
 
-          if (!this->enabled)
+          // Before Start(), only the publishers with a process scope can be
+          // registered.
+          if (!this->enabled && !this->deferred)
             return false;
 
           // Don't do anything if the topic is not advertised by any of my nodes
@@ -468,6 +749,12 @@ namespace gz
 
           // Remove the topic information.
           this->info.DelPublisherByNode(_topic, this->pUuid, _nUuid);
+
+          if (inf.Options().Scope() != Scope_t::PROCESS)
+          {
+            ++this->advVersion;
+            this->GraphChanged();
+          }
         }
 
         // Only unadvertise a message outside this process if the scope
@@ -547,6 +834,113 @@ namespace gz
         this->silenceInterval = _ms;
       }
 
+      /// \brief Enable or disable the delta mode. In delta mode the
+      /// heartbeats carry the version of the set of publishers advertised by
+      /// the process, which increases with every advertisement change.
+      /// The local publishers are no longer re-advertised on every heartbeat:
+      /// a peer that misses a change (or sees the process for the first time)
+      /// requests a full sync from it, and a full refresh is still sent every
+      /// kFullSyncHeartbeats heartbeats to recover from lost packets.
+      /// Call this before Start().
+      /// \param[in] _enabled True to enable the delta mode.
+      public: void SetDeltaMode(const bool _enabled)
+      {
+        this->deltaMode = _enabled;
+      }
+
+      /// \brief Whether the delta mode is enabled.
+      /// \return True if the delta mode is enabled.
+      /// \sa SetDeltaMode
+      public: bool DeltaMode() const
+      {
+        return this->deltaMode;
+      }
+
+      /// \brief Enable or disable the adaptive heartbeats. While the graph is
+      /// stable, the period between two heartbeats doubles after every
+      /// heartbeat, up to kMaxHeartbeatBackoff heartbeat intervals, and it
+      /// goes back to the heartbeat interval as soon as a publisher or a
+      /// process appears or disappears. Every period is randomized by
+      /// +/- kHeartbeatJitter percent so that processes started together
+      /// don't send their heartbeats at the same time. The heartbeats carry
+      /// their period, and the peers scale the silence interval of the
+      /// sender accordingly. Call this before Start().
+      /// \param[in] _enabled True to enable the adaptive heartbeats.
+      public: void SetAdaptive(const bool _enabled)
+      {
+        this->adaptive = _enabled;
+      }
+
+      /// \brief Whether the adaptive heartbeats are enabled.
+      /// \return True if the adaptive heartbeats are enabled.
+      /// \sa SetAdaptive
+      public: bool Adaptive() const
+      {
+        return this->adaptive;
+      }
+
+      /// \brief Enable or disable the batching of the discovery messages.
+      /// When enabled, the bulk re-advertisements and discovery requests pack
+      /// as many messages as fit in each datagram instead of sending one
+      /// datagram per publisher. Processes using an older version of Gazebo
+      /// Transport ignore the batches.
+      /// \param[in] _enabled True to enable batching.
+      public: void SetBatching(const bool _enabled)
+      {
+        this->batching = _enabled;
+      }
+
+      /// \brief Whether the discovery messages are batched.
+      /// \return True if batching is enabled.
+      /// \sa SetBatching
+      public: bool Batching() const
+      {
+        return this->batching;
+      }
+
+      /// \brief Enable or disable the fast start. After Start(), the
+      /// discovery sends kStartupBursts bursts spaced with an exponential
+      /// backoff (0, 25, 75, 175 and 375 ms). Each burst asks all the peers
+      /// to re-advertise their publishers, advertises ours and repeats the
+      /// pending discovery requests. The discovery is initialized one backoff
+      /// step after the last burst, instead of after two heartbeats.
+      /// Call this before Start().
+      /// \param[in] _enabled True to enable the fast start.
+      public: void SetFastStart(const bool _enabled)
+      {
+        this->fastStart = _enabled;
+      }
+
+      /// \brief Whether the fast start is enabled.
+      /// \return True if the fast start is enabled.
+      /// \sa SetFastStart
+      public: bool FastStart() const
+      {
+        return this->fastStart;
+      }
+
+      /// \brief Set the file used to cache the publishers of the other
+      /// processes. The publishers stored there are loaded by Start(), so a
+      /// restarted process connects to them before hearing from them. The
+      /// ones that are gone expire after the silence interval. The file is
+      /// updated on every heartbeat when the publishers change.
+      /// Call this before Start().
+      /// \param[in] _path Path of the cache file, or empty to disable it.
+      public: void SetCacheFile(const std::string &_path)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->cacheFile = _path;
+      }
+
+      /// \brief Get the file used to cache the publishers.
+      /// \return The path of the cache file, or empty if it's disabled.
+      /// \sa SetCacheFile
+      public: std::string CacheFile() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->cacheFile;
+      }
+
       /// \brief Register a callback to receive discovery connection events.
       /// Each time a new topic is connected, the callback will be executed.
       /// This version uses a free function as callback.
@@ -586,8 +980,10 @@ namespace gz
       }
 
       /// \brief Register a callback to receive an event when a node requests
-      /// the list of remote subscribers.
+      /// the list of remote subscribers. The callback runs after a random
+      /// delay, once for all the requests received during that delay.
       /// \param[in] _cb Function callback.
+      /// \sa SendSubscribersReps.
       public: void SubscribersCb(const std::function<void()> &_cb)
       {
         std::lock_guard<std::mutex> lock(this->mutex);
@@ -637,21 +1033,33 @@ namespace gz
       }
 
       /// \brief Get the list of topics currently advertised and subscribed
-      /// in the network.
+      /// in the network. The remote subscribers are kept up to date by their
+      /// announcements, they are only requested from all the peers by the
+      /// first call, which waits for the answers.
       /// \param[out] _topics List of advertised topics.
       public: void TopicList(std::vector<std::string> &_topics)
       {
+        bool sync;
         {
           std::lock_guard<std::mutex> lock(this->mutex);
-          this->remoteSubscribers.Clear();
+          sync = !this->subscribersSynced;
+          this->subscribersSynced = true;
         }
 
         // Request the list of subscribers.
-        Publisher pub("", "", this->pUuid, "", AdvertiseOptions());
-        this->SendMsg(
-          DestinationType::ALL, msgs::Discovery::SUBSCRIBERS_REQ, pub);
+        const auto deadline = std::chrono::steady_clock::now() +
+          std::chrono::milliseconds(2 * kSubscribersRepDelay);
+        if (sync)
+        {
+          Publisher pub("", "", this->pUuid, "", AdvertiseOptions());
+          this->SendMsg(
+            DestinationType::ALL, msgs::Discovery::SUBSCRIBERS_REQ, pub);
+        }
 
         this->WaitForInit();
+        if (sync)
+          std::this_thread::sleep_until(deadline);
+
         std::lock_guard<std::mutex> lock(this->mutex);
         this->info.TopicList(_topics);
 
@@ -708,10 +1116,15 @@ namespace gz
 
             // This publisher has expired.
             if (std::chrono::duration_cast<std::chrono::milliseconds>
-                 (elapsed).count() > this->silenceInterval)
+                 (elapsed).count() > this->PeerSilence(it->first))
             {
               // Remove all the info entries for this process UUID.
-              this->info.DelPublishersByProc(it->first);
+              if (this->info.DelPublishersByProc(it->first))
+                this->cacheDirty = true;
+              this->remoteSubscribers.DelPublishersByProc(it->first);
+              this->peerVersions.erase(it->first);
+              this->clockOffsets.erase(it->first);
+              this->peerPeriods.erase(it->first);
 
               uuids.push_back(it->first);
 
@@ -722,8 +1135,19 @@ namespace gz
               ++it;
           }
 
-          this->timeNextActivity = std::chrono::steady_clock::now() +
-            std::chrono::milliseconds(this->activityInterval);
+          if (!uuids.empty())
+            this->GraphChanged();
+
+          // Sleep until the next process may expire, checking no more often
+          // than the activity interval.
+          Timestamp expiry = now + std::chrono::hours(1);
+          for (const auto &peer : this->activity)
+          {
+            expiry = std::min(expiry, peer.second +
+              std::chrono::milliseconds(this->PeerSilence(peer.first) + 1));
+          }
+          this->timeNextActivity = std::max(expiry,
+            now + std::chrono::milliseconds(this->activityInterval));
         }
 
         if (!disconnectCb)
@@ -740,6 +1164,38 @@ namespace gz
         }
       }
 
+      /// \brief Get the estimated offset of the system clock of a process
+      /// running on another host, measured with its heartbeats. The estimate
+      /// includes the shortest transmission delay of the last heartbeats,
+      /// i.e. tens of microseconds on a local network.
+      /// \param[in] _pUuid Process UUID of the peer.
+      /// \param[out] _offset Offset to add to the peer's clock to get ours.
+      /// \return False if the peer is unknown or runs on this host, whose
+      /// processes share our clock.
+      public: bool ClockOffset(const std::string &_pUuid,
+                               std::chrono::microseconds &_offset) const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->clockOffsets.find(_pUuid);
+        if (it == this->clockOffsets.end() || it->second.count == 0)
+          return false;
+
+        const ClockEstimate &estimate = it->second;
+        const std::size_t count = std::min(estimate.count, kClockSamples);
+        _offset = std::chrono::microseconds(*std::min_element(
+          estimate.samples.begin(), estimate.samples.begin() + count));
+        return true;
+      }
+
+      /// \brief Whether this discovery talks to a discovery server instead of
+      /// the multicast group. This is enabled by setting GZ_DISCOVERY_SERVER
+      /// to the IP address of the server.
+      /// \return True if a discovery server is used.
+      public: bool ServerMode() const
+      {
+        return this->serverMode;
+      }
+
       /// \brief Register a new relay address.
       /// \param[in] _ip New IP address.
       public: void AddRelayAddress(const std::string &_ip)
@@ -776,38 +1232,61 @@ namespace gz
         return result;
       }
 
-      /// \brief Broadcast periodic heartbeats.
+      /// \brief Broadcast periodic heartbeats. In delta mode, the local
+      /// publishers are re-advertised only when a peer requested a sync or
+      /// every kFullSyncHeartbeats heartbeats.
       private: void UpdateHeartbeat()
       {
         Timestamp now = std::chrono::steady_clock::now();
 
+        bool heartbeat;
+        bool readvertise;
         {
           std::lock_guard<std::mutex> lock(this->mutex);
 
-          if (now < this->timeNextHeartbeat)
+          // Sync requests are coalesced and served at a bounded rate.
+          const bool sync = this->syncRequested && now >= this->timeNextSync;
+          heartbeat = now >= this->timeNextHeartbeat;
+          if (!heartbeat && !sync)
             return;
-        }
 
-        Publisher pub("", "", this->pUuid, "", AdvertiseOptions());
-        this->SendMsg(DestinationType::ALL, msgs::Discovery::HEARTBEAT, pub);
+          readvertise = !this->deltaMode || sync ||
+            (heartbeat &&
+             ++this->heartbeatsSinceSync >= kFullSyncHeartbeats);
+          if (readvertise)
+          {
+            this->heartbeatsSinceSync = 0;
+            this->syncRequested = false;
+            this->timeNextSync = now + std::chrono::milliseconds(kSyncPeriod);
+          }
+        }
 
-        std::map<std::string, std::vector<Pub>> nodes;
+        if (heartbeat)
         {
-          std::lock_guard<std::mutex> lock(this->mutex);
-
-          // Re-advertise topics that are advertised inside this process.
-          this->info.PublishersByProc(this->pUuid, nodes);
+          Publisher pub("", "", this->pUuid, "", AdvertiseOptions());
+          this->SendMsg(DestinationType::ALL, msgs::Discovery::HEARTBEAT, pub);
         }
 
-        for (const auto &topic : nodes)
+        if (readvertise)
         {
-          for (const auto &node : topic.second)
+          std::map<std::string, std::vector<Pub>> nodes;
           {
-            this->SendMsg(DestinationType::ALL,
-                msgs::Discovery::ADVERTISE, node);
+            std::lock_guard<std::mutex> lock(this->mutex);
+
+            // Re-advertise topics that are advertised inside this process.
+            this->info.PublishersByProc(this->pUuid, nodes);
           }
+
+          std::vector<Pub> pubs;
+          for (const auto &topic : nodes)
+            pubs.insert(pubs.end(), topic.second.begin(), topic.second.end());
+          this->SendMsgs(DestinationType::ALL, msgs::Discovery::ADVERTISE,
+            pubs);
         }
 
+        if (!heartbeat)
+          return;
+
         {
           std::lock_guard<std::mutex> lock(this->mutex);
           if (!this->initialized)
@@ -824,73 +1303,366 @@ namespace gz
           }
 
           this->timeNextHeartbeat = std::chrono::steady_clock::now() +
-            std::chrono::milliseconds(this->heartbeatInterval);
+            this->NextHeartbeatDelay();
         }
-      }
-
-      /// \brief Calculate the next timeout. There are three main activities to
-      /// perform by the discovery component:
-      /// 1. Receive discovery messages.
-      /// 2. Send heartbeats.
-      /// 3. Maintain the discovery information up to date.
-      ///
-      /// Tasks (2) and (3) need to be checked at fixed intervals. This function
-      /// calculates the next timeout to satisfy (2) and (3).
-      /// \return A timeout (milliseconds).
-      private: int NextTimeout() const
-      {
-        auto now = std::chrono::steady_clock::now();
-        auto timeUntilNextHeartbeat = this->timeNextHeartbeat - now;
-        auto timeUntilNextActivity = this->timeNextActivity - now;
 
-        int t = static_cast<int>(
-          std::chrono::duration_cast<std::chrono::milliseconds>
-            (std::min(timeUntilNextHeartbeat, timeUntilNextActivity)).count());
-        int t2 = std::min(t, this->kTimeout);
-        return std::max(t2, 0);
+        this->SaveCache();
       }
 
-      /// \brief Receive discovery messages.
-      private: void RecvMessages()
+      /// \brief Answer the pending SUBSCRIBERS_REQ messages once their random
+      /// delay has elapsed.
+      private: void UpdateSubscribersRep()
       {
-        bool timeToExit = false;
-        while (!timeToExit)
+        std::function<void()> cb;
         {
-          // Calculate the timeout.
-          int timeout = this->NextTimeout();
-
-          if (pollSockets(this->sockets, timeout))
+          std::lock_guard<std::mutex> lock(this->mutex);
+          if (!this->subscribersRepPending ||
+              std::chrono::steady_clock::now() < this->timeSubscribersRep)
           {
-            this->RecvDiscoveryUpdate();
-
-            if (this->verbose)
-              this->PrintCurrentState();
+            return;
           }
 
-          this->UpdateHeartbeat();
-          this->UpdateActivity();
-
-          // Is it time to exit?
-          {
-            std::lock_guard<std::mutex> lock(this->exitMutex);
-            if (this->exit)
-              timeToExit = true;
-          }
+          this->subscribersRepPending = false;
+          cb = this->subscribersCb;
         }
+
+        if (cb)
+          cb();
       }
 
-      /// \brief Method in charge of receiving the discovery updates.
-      private: void RecvDiscoveryUpdate()
+      /// \brief Get the delay until the next heartbeat and, in adaptive mode,
+      /// back off the period of the following one. Must be called with the
+      /// mutex locked.
+      /// \return The delay.
+      /// \sa SetAdaptive.
+      private: std::chrono::milliseconds NextHeartbeatDelay()
       {
-        char rcvStr[Discovery::kMaxRcvStr];
-        sockaddr_in clntAddr;
-        socklen_t addrLen = sizeof(clntAddr);
+        if (!this->adaptive)
+          return std::chrono::milliseconds(this->heartbeatInterval);
+
+        const unsigned int period =
+          std::max(this->heartbeatPeriod.load(), this->heartbeatInterval);
+        this->heartbeatPeriod = std::min(period * 2,
+          this->heartbeatInterval * kMaxHeartbeatBackoff);
+        return this->Jitter(period);
+      }
 
-        int64_t received = recvfrom(this->sockets.at(0),
+      /// \brief Randomize a period by +/- kHeartbeatJitter percent. Must be
+      /// called with the mutex locked.
+      /// \param[in] _ms The period in milliseconds.
+      /// \return The randomized period.
+      private: std::chrono::milliseconds Jitter(const unsigned int _ms)
+      {
+        const int spread = static_cast<int>(_ms * kHeartbeatJitter / 100);
+        std::uniform_int_distribution<int> dist(-spread, spread);
+        return std::chrono::milliseconds(
+          static_cast<int>(_ms) + dist(this->randomEngine));
+      }
+
+      /// \brief In adaptive mode, go back to the fastest heartbeats after a
+      /// change of the graph. Must be called with the mutex locked.
+      /// \sa SetAdaptive.
+      private: void GraphChanged()
+      {
+        if (!this->adaptive)
+          return;
+
+        this->heartbeatPeriod = this->heartbeatInterval;
+        const Timestamp next = std::chrono::steady_clock::now() +
+          this->Jitter(this->heartbeatInterval);
+        if (this->timeNextHeartbeat > next)
+          this->timeNextHeartbeat = next;
+      }
+
+      /// \brief Get the silence interval of a peer, scaled by the period of
+      /// its adaptive heartbeats. Must be called with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the peer.
+      /// \return The silence interval in milliseconds.
+      private: unsigned int PeerSilence(const std::string &_pUuid) const
+      {
+        auto it = this->peerPeriods.find(_pUuid);
+        if (it == this->peerPeriods.end() || this->heartbeatInterval == 0 ||
+            it->second <= this->heartbeatInterval)
+        {
+          return this->silenceInterval;
+        }
+
+        return static_cast<unsigned int>(
+          static_cast<uint64_t>(this->silenceInterval) * it->second /
+          this->heartbeatInterval);
+      }
+
+      /// \brief Track the heartbeat period announced by a peer in adaptive
+      /// mode. Must be called with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the peer.
+      /// \param[in] _msg A heartbeat of the peer.
+      private: void UpdatePeerPeriod(const std::string &_pUuid,
+                                     const msgs::Discovery &_msg)
+      {
+        std::string value;
+        if (!HeaderValue(_msg, kPeriodKey, value))
+          return;
+
+        try
+        {
+          this->peerPeriods[_pUuid] =
+            static_cast<unsigned int>(std::stoul(value));
+        }
+        catch (...)
+        {
+        }
+      }
+
+      /// \brief Send the startup bursts of the fast start.
+      /// \sa SetFastStart.
+      private: void UpdateBurst()
+      {
+        Timestamp now = std::chrono::steady_clock::now();
+
+        std::map<std::string, std::vector<Pub>> nodes;
+        std::set<std::string> topics;
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+
+          if (this->burstsLeft == 0 || now < this->timeNextBurst)
+            return;
+
+          this->timeNextBurst = now +
+            std::chrono::milliseconds(this->burstDelay);
+          this->burstDelay *= 2;
+
+          // The last step only waits for the answers to the bursts.
+          if (--this->burstsLeft == 0)
+          {
+            this->initialized = true;
+            this->initializedCv.notify_all();
+            return;
+          }
+
+          this->info.PublishersByProc(this->pUuid, nodes);
+          topics = this->discoveredTopics;
+        }
+
+        // Ask everybody to re-advertise its publishers.
+        this->SendSyncRequest(kSyncAll);
+
+        std::vector<Pub> pubs;
+        for (const auto &topic : nodes)
+          pubs.insert(pubs.end(), topic.second.begin(), topic.second.end());
+        this->SendMsgs(DestinationType::ALL, msgs::Discovery::ADVERTISE, pubs);
+
+        std::vector<Pub> subs;
+        for (const auto &topic : topics)
+        {
+          Pub pub;
+          pub.SetTopic(topic);
+          pub.SetPUuid(this->pUuid);
+          subs.push_back(pub);
+        }
+        this->SendMsgs(DestinationType::ALL, msgs::Discovery::SUBSCRIBE, subs);
+      }
+
+      /// \brief Load the publishers stored in the cache file.
+      /// \sa SetCacheFile.
+      private: void LoadCache()
+      {
+        std::vector<Pub> added;
+        DiscoveryCallback<Pub> connectCb;
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          if (this->cacheFile.empty())
+            return;
+
+          std::ifstream in(this->cacheFile, std::ios::binary);
+          uint32_t size = 0;
+          std::string data;
+          while (in.read(reinterpret_cast<char *>(&size), sizeof(size)))
+          {
+            data.resize(size);
+            if (!in.read(&data[0], size))
+              break;
+
+            msgs::Discovery msg;
+            if (!msg.ParseFromString(data) ||
+                msg.process_uuid() == this->pUuid)
+            {
+              continue;
+            }
+
+            Pub publisher;
+            publisher.SetFromDiscovery(msg);
+            if (!this->info.AddPublisher(publisher))
+              continue;
+
+            // The publisher expires if we don't hear from its process.
+            this->activity[publisher.PUuid()] =
+              std::chrono::steady_clock::now();
+            added.push_back(publisher);
+          }
+
+          connectCb = this->connectionCb;
+        }
+
+        if (!connectCb)
+          return;
+
+        for (const auto &publisher : added)
+          connectCb(publisher);
+      }
+
+      /// \brief Store the publishers of the other processes in the cache
+      /// file, if they changed since the last call.
+      /// \sa SetCacheFile.
+      private: void SaveCache()
+      {
+        std::string path;
+        std::vector<std::string> entries;
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          if (this->cacheFile.empty() || !this->cacheDirty)
+            return;
+          this->cacheDirty = false;
+          path = this->cacheFile;
+
+          std::vector<std::string> topics;
+          this->info.TopicList(topics);
+          for (const auto &topic : topics)
+          {
+            this->info.VisitPublishers(topic, [&](const Pub &_publisher)
+            {
+              if (_publisher.PUuid() == this->pUuid)
+                return;
+
+              msgs::Discovery msg;
+              msg.set_type(msgs::Discovery::ADVERTISE);
+              msg.set_process_uuid(_publisher.PUuid());
+              _publisher.FillDiscovery(msg);
+              entries.push_back(msg.SerializeAsString());
+            });
+          }
+        }
+
+        // Replace the file atomically, other processes may share it.
+        const std::string tmpPath = path + "." + this->pUuid;
+        {
+          std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+          for (const auto &entry : entries)
+          {
+            const uint32_t size = static_cast<uint32_t>(entry.size());
+            out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            out.write(entry.data(), entry.size());
+          }
+          if (!out)
+          {
+            std::cerr << "Discovery: Unable to write the cache file ["
+                      << tmpPath << "]" << std::endl;
+            return;
+          }
+        }
+
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        {
+          std::cerr << "Discovery: Unable to replace the cache file ["
+                    << path << "]" << std::endl;
+          std::remove(tmpPath.c_str());
+        }
+      }
+
+      /// \brief Calculate the next timeout. There are three main activities to
+      /// perform by the discovery component:
+      /// 1. Receive discovery messages.
+      /// 2. Send heartbeats.
+      /// 3. Maintain the discovery information up to date.
+      ///
+      /// Tasks (2) and (3) need to be checked at fixed intervals. This function
+      /// calculates the next timeout to satisfy (2) and (3).
+      /// \return A timeout (milliseconds).
+      private: int NextTimeout() const
+      {
+        auto now = std::chrono::steady_clock::now();
+        auto timeUntilNextHeartbeat = this->timeNextHeartbeat - now;
+        auto timeUntilNextActivity = this->timeNextActivity - now;
+        auto timeUntilNext =
+          std::min(timeUntilNextHeartbeat, timeUntilNextActivity);
+        if (this->burstsLeft > 0)
+          timeUntilNext = std::min(timeUntilNext, this->timeNextBurst - now);
+        if (this->subscribersRepPending)
+        {
+          timeUntilNext =
+            std::min(timeUntilNext, this->timeSubscribersRep - now);
+        }
+
+        int t = static_cast<int>(
+          std::chrono::duration_cast<std::chrono::milliseconds>
+            (timeUntilNext).count());
+
+        // Without a way to interrupt the poll, check the exit flag
+        // periodically.
+        if (this->wakeSocket < 0)
+          t = std::min(t, this->kTimeout);
+        return std::max(t, 0);
+      }
+
+      /// \brief Receive discovery messages.
+      private: void RecvMessages()
+      {
+        setupThread("DISCOVERY", "gz-discovery");
+
+        bool timeToExit = false;
+        while (!timeToExit)
+        {
+          // Calculate the timeout.
+          int timeout = this->NextTimeout();
+
+          std::vector<bool> readable;
+          std::vector<int> pollList = {this->sockets.at(0)};
+          if (this->wakeSocket >= 0)
+            pollList.push_back(this->wakeSocket);
+
+          this->Process(pollSockets(pollList, timeout, readable) &&
+            readable[0]);
+
+          // Is it time to exit?
+          {
+            std::lock_guard<std::mutex> lock(this->exitMutex);
+            if (this->exit)
+              timeToExit = true;
+          }
+        }
+      }
+
+      /// \brief Method in charge of receiving the discovery updates.
+      private: void RecvDiscoveryUpdate()
+      {
+        char rcvStr[Discovery::kMaxRcvStr];
+        sockaddr_in clntAddr;
+        socklen_t addrLen = sizeof(clntAddr);
+
+        this->receiveStampUs = 0;
+#ifdef _WIN32
+        int64_t received = recvfrom(this->sockets.at(0),
               reinterpret_cast<raw_type *>(rcvStr),
               this->kMaxRcvStr, 0,
               reinterpret_cast<sockaddr *>(&clntAddr),
               reinterpret_cast<socklen_t *>(&addrLen));
+#else
+        iovec iov;
+        iov.iov_base = rcvStr;
+        iov.iov_len = this->kMaxRcvStr;
+        alignas(cmsghdr) char control[kReceiveTimestampControlSize];
+        msghdr rcvMsg;
+        memset(&rcvMsg, 0, sizeof(rcvMsg));
+        rcvMsg.msg_name = &clntAddr;
+        rcvMsg.msg_namelen = addrLen;
+        rcvMsg.msg_iov = &iov;
+        rcvMsg.msg_iovlen = 1;
+        rcvMsg.msg_control = control;
+        rcvMsg.msg_controllen = sizeof(control);
+
+        int64_t received = recvmsg(this->sockets.at(0), &rcvMsg, 0);
+        if (received > 0)
+          receiveTimestamp(rcvMsg, this->receiveStampUs);
+#endif
         if (received > 0)
         {
           uint16_t len = 0;
@@ -916,9 +1688,26 @@ namespace gz
           // It is possible that two incompatible versions of Gazebo
           // Transport exist on the same network. If we receive an
           // unexpected size, then we ignore the message.
+          //
+          // A batch packs several frames in the same datagram:
+          //
+          // <frame_delimiter><frame_body><frame_delimiter><frame_body>...
+          //
+          // The datagram is valid (version 8+) if the frames fill it exactly.
+          std::vector<std::pair<char *, uint16_t>> frames;
+          int64_t offset = 0;
+          while (offset + static_cast<int64_t>(sizeof(len)) <= received)
+          {
+            memcpy(&len, &rcvStr[offset], sizeof(len));
+            offset += sizeof(len);
+            if (offset + len > received)
+              break;
 
-          // If-condition for version 8+
-          if (len + sizeof(len) == static_cast<uint16_t>(received))
+            frames.emplace_back(rcvStr + offset, len);
+            offset += len;
+          }
+
+          if (offset == received && !frames.empty())
           {
             std::string srcAddr = inet_ntoa(clntAddr.sin_addr);
             uint16_t srcPort = ntohs(clntAddr.sin_port);
@@ -926,10 +1715,12 @@ namespace gz
             if (this->verbose)
             {
               std::cout << "\nReceived discovery update from "
-                << srcAddr << ": " << srcPort << std::endl;
+                << srcAddr << ": " << srcPort << " (" << frames.size()
+                << " messages)" << std::endl;
             }
 
-            this->DispatchDiscoveryMsg(srcAddr, rcvStr + sizeof(len), len);
+            for (const auto &frame : frames)
+              this->DispatchDiscoveryMsg(srcAddr, frame.first, frame.second);
           }
         }
         else if (received < 0)
@@ -973,7 +1764,14 @@ namespace gz
         // forward it to the multicast group, and it will be dispatched once
         // received there. Note that we also unset the RELAY flag and set the
         // NO_RELAY flag, to avoid forwarding the message anymore.
-        if (msg.has_flags() && msg.flags().relay())
+        std::string fromIp = _fromIp;
+        if (this->serverMode)
+        {
+          // The server forwards the messages of the other processes. It tells
+          // us where they come from.
+          HeaderValue(msg, kOriginKey, fromIp);
+        }
+        else if (msg.has_flags() && msg.flags().relay())
         {
           // Unset the RELAY flag in the header and set the NO_RELAY.
           msg.mutable_flags()->set_relay(false);
@@ -997,25 +1795,67 @@ namespace gz
         }
 
         bool isSenderLocal = (std::find(this->hostInterfaces.begin(),
-          this->hostInterfaces.end(), _fromIp) != this->hostInterfaces.end()) ||
-          (_fromIp.find("127.") == 0);
+          this->hostInterfaces.end(), fromIp) != this->hostInterfaces.end()) ||
+          (fromIp.find("127.") == 0);
 
         // Update timestamp and cache the callbacks.
         DiscoveryCallback<Pub> connectCb;
         DiscoveryCallback<Pub> disconnectCb;
         DiscoveryCallback<Pub> registerCb;
         DiscoveryCallback<Pub> unregisterCb;
-        std::function<void()> subscribersReqCb;
+        bool requestSync = false;
         {
           std::lock_guard<std::mutex> lock(this->mutex);
-          this->activity[recvPUuid] = std::chrono::steady_clock::now();
+          const auto now = std::chrono::steady_clock::now();
+          if (this->activity.find(recvPUuid) == this->activity.end())
+            this->GraphChanged();
+          this->activity[recvPUuid] = now;
+
+          if (msg.type() == msgs::Discovery::HEARTBEAT)
+            this->UpdatePeerPeriod(recvPUuid, msg);
+
+          // Check the activity when this process may expire, if that's
+          // earlier than planned.
+          const auto expiry = now +
+            std::chrono::milliseconds(this->PeerSilence(recvPUuid) + 1);
+          if (this->timeNextActivity > expiry)
+            this->timeNextActivity = expiry;
           connectCb = this->connectionCb;
           disconnectCb = this->disconnectionCb;
           registerCb = this->registrationCb;
           unregisterCb = this->unregistrationCb;
-          subscribersReqCb = this->subscribersCb;
+
+          // A peer asked us (or everybody) to re-advertise our publishers.
+          std::string target;
+          if (msg.type() == msgs::Discovery::HEARTBEAT &&
+              HeaderValue(msg, kSyncKey, target) &&
+              (target == this->pUuid || target == kSyncAll))
+          {
+            this->syncRequested = true;
+          }
+
+          // The server only forwards the changes. Its heartbeats vouch for
+          // the processes that it knows, and it says goodbye on behalf of
+          // the ones that went silent.
+          std::string value;
+          if (this->serverMode && msg.type() == msgs::Discovery::HEARTBEAT &&
+              HeaderValue(msg, kServerKey, value))
+          {
+            for (auto &peer : this->activity)
+              peer.second = now;
+          }
+
+          if (this->deltaMode)
+            requestSync = this->UpdatePeerVersion(recvPUuid, msg);
+
+          // Processes on this host share our system clock.
+          if (msg.type() == msgs::Discovery::HEARTBEAT && !isSenderLocal)
+            this->UpdateClockOffset(recvPUuid, msg);
         }
 
+        if (requestSync)
+          this->SendSyncRequest(recvPUuid);
+
         switch (msg.type())
         {
           case msgs::Discovery::ADVERTISE:
@@ -1037,6 +1877,9 @@ namespace gz
             {
               std::lock_guard<std::mutex> lock(this->mutex);
               added = this->info.AddPublisher(publisher);
+              this->cacheDirty |= added;
+              if (added)
+                this->GraphChanged();
             }
 
             if (added && connectCb)
@@ -1063,19 +1906,20 @@ namespace gz
             }
 
             // Check if at least one of my nodes advertises the topic requested.
-            Addresses_M<Pub> addresses;
+            std::vector<Pub> localPubs;
             {
               std::lock_guard<std::mutex> lock(this->mutex);
-              if (!this->info.HasAnyPublishers(recvTopic, this->pUuid))
+              if (!this->info.VisitPublishers(recvTopic, this->pUuid,
+                    [&localPubs](const Pub &_pub)
+                    {
+                      localPubs.push_back(_pub);
+                    }))
               {
                 break;
               }
-
-              if (!this->info.Publishers(recvTopic, addresses))
-                break;
             }
 
-            for (const auto &nodeInfo : addresses[this->pUuid])
+            for (const auto &nodeInfo : localPubs)
             {
               // Check scope of the topic.
               if ((nodeInfo.Options().Scope() == Scope_t::PROCESS) ||
@@ -1094,8 +1938,18 @@ namespace gz
           }
           case msgs::Discovery::SUBSCRIBERS_REQ:
           {
-            if (subscribersReqCb)
-              subscribersReqCb();
+            // Every peer receives the request. The answers are spread over
+            // kSubscribersRepDelay, and a single answer serves all the
+            // requests received in the meantime.
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->subscribersRepPending)
+            {
+              std::uniform_int_distribution<unsigned int> dist(
+                0, kSubscribersRepDelay);
+              this->subscribersRepPending = true;
+              this->timeSubscribersRep = std::chrono::steady_clock::now() +
+                std::chrono::milliseconds(dist(this->randomEngine));
+            }
 
             break;
           }
@@ -1117,6 +1971,12 @@ namespace gz
             Pub publisher;
             publisher.SetFromDiscovery(msg);
 
+            // A remote subscriber connected to a publisher.
+            {
+              std::lock_guard<std::mutex> lock(this->mutex);
+              this->remoteSubscribers.AddPublisher(publisher);
+            }
+
             if (registerCb)
               registerCb(publisher);
 
@@ -1128,6 +1988,13 @@ namespace gz
             Pub publisher;
             publisher.SetFromDiscovery(msg);
 
+            // A remote subscriber is gone.
+            {
+              std::lock_guard<std::mutex> lock(this->mutex);
+              this->remoteSubscribers.DelPublisherByNode(
+                publisher.Topic(), publisher.PUuid(), publisher.NUuid());
+            }
+
             if (unregisterCb)
               unregisterCb(publisher);
 
@@ -1144,6 +2011,10 @@ namespace gz
             {
               std::lock_guard<std::mutex> lock(this->mutex);
               this->activity.erase(recvPUuid);
+              this->peerVersions.erase(recvPUuid);
+              this->clockOffsets.erase(recvPUuid);
+              this->peerPeriods.erase(recvPUuid);
+              this->GraphChanged();
             }
 
             if (disconnectCb)
@@ -1157,7 +2028,8 @@ namespace gz
             // Remove the address entry for this topic.
             {
               std::lock_guard<std::mutex> lock(this->mutex);
-              this->info.DelPublishersByProc(recvPUuid);
+              this->cacheDirty |= this->info.DelPublishersByProc(recvPUuid);
+              this->remoteSubscribers.DelPublishersByProc(recvPUuid);
             }
 
             break;
@@ -1185,8 +2057,8 @@ namespace gz
             // Remove the address entry for this topic.
             {
               std::lock_guard<std::mutex> lock(this->mutex);
-              this->info.DelPublisherByNode(publisher.Topic(),
-                publisher.PUuid(), publisher.NUuid());
+              this->cacheDirty |= this->info.DelPublisherByNode(
+                publisher.Topic(), publisher.PUuid(), publisher.NUuid());
             }
 
             break;
@@ -1210,7 +2082,173 @@ namespace gz
                    const msgs::Discovery::Type _type,
                    const T &_pub) const
       {
+        // Process scoped topics are never announced outside this process.
+        const Scope_t scope = MsgScope(_type, _pub);
+        if (scope == Scope_t::PROCESS)
+          return;
+
         gz::msgs::Discovery discoveryMsg;
+        if (!this->FillMsg(_type, _pub, discoveryMsg))
+          return;
+
+        // Host scoped topics never leave this host.
+        if (scope == Scope_t::HOST && this->HostOnly())
+        {
+          std::string buffer;
+          if (AppendFrame(discoveryMsg, buffer))
+            this->SendHostBuffer(buffer);
+          return;
+        }
+
+        if (_destType == DestinationType::MULTICAST ||
+            _destType == DestinationType::ALL)
+        {
+          this->SendMulticast(discoveryMsg);
+        }
+
+        // Send the discovery message to the unicast relays.
+        if (_destType == DestinationType::UNICAST ||
+            _destType == DestinationType::ALL)
+        {
+          // Set the RELAY flag in the header.
+          discoveryMsg.mutable_flags()->set_relay(true);
+          this->SendUnicast(discoveryMsg);
+        }
+
+        if (this->verbose)
+        {
+          std::cout << "\t* Sending " << msgs::ToString(_type)
+                    << " msg [" << _pub.Topic() << "]" << std::endl;
+        }
+      }
+
+      /// \brief Broadcast a discovery message for each publisher. When
+      /// batching is enabled, the messages are packed in as few datagrams as
+      /// possible.
+      /// \param[in] _destType Destination type.
+      /// \param[in] _type Message type.
+      /// \param[in] _pubs Publishers's information to send.
+      /// \sa SetBatching.
+      private: void SendMsgs(const DestinationType &_destType,
+                             const msgs::Discovery::Type _type,
+                             const std::vector<Pub> &_pubs) const
+      {
+        if (!this->batching)
+        {
+          for (const auto &pub : _pubs)
+            this->SendMsg(_destType, _type, pub);
+          return;
+        }
+
+        const bool multicast = _destType == DestinationType::MULTICAST ||
+          _destType == DestinationType::ALL;
+        const bool unicast = _destType == DestinationType::UNICAST ||
+          _destType == DestinationType::ALL;
+
+        std::string multicastBatch;
+        std::string unicastBatch;
+        std::string hostBatch;
+        std::string frame;
+        for (const auto &pub : _pubs)
+        {
+          const Scope_t scope = MsgScope(_type, pub);
+          if (scope == Scope_t::PROCESS)
+            continue;
+
+          gz::msgs::Discovery discoveryMsg;
+          if (!this->FillMsg(_type, pub, discoveryMsg))
+            continue;
+
+          if (scope == Scope_t::HOST && this->HostOnly())
+          {
+            if (AppendFrame(discoveryMsg, frame))
+            {
+              if (hostBatch.size() + frame.size() > kMaxRcvStr)
+              {
+                this->SendHostBuffer(hostBatch);
+                hostBatch.clear();
+              }
+              hostBatch += frame;
+              frame.clear();
+            }
+            continue;
+          }
+
+          if (multicast && AppendFrame(discoveryMsg, frame))
+          {
+            if (multicastBatch.size() + frame.size() > kMaxRcvStr)
+            {
+              this->SendMulticastBuffer(multicastBatch);
+              multicastBatch.clear();
+            }
+            multicastBatch += frame;
+            frame.clear();
+          }
+
+          // Set the RELAY flag in the header.
+          discoveryMsg.mutable_flags()->set_relay(true);
+          if (unicast && AppendFrame(discoveryMsg, frame))
+          {
+            if (unicastBatch.size() + frame.size() > kMaxRcvStr)
+            {
+              this->SendUnicastBuffer(unicastBatch);
+              unicastBatch.clear();
+            }
+            unicastBatch += frame;
+            frame.clear();
+          }
+        }
+
+        if (!multicastBatch.empty())
+          this->SendMulticastBuffer(multicastBatch);
+        if (!unicastBatch.empty())
+          this->SendUnicastBuffer(unicastBatch);
+        if (!hostBatch.empty())
+          this->SendHostBuffer(hostBatch);
+
+        if (this->verbose)
+        {
+          std::cout << "\t* Sending " << _pubs.size() << " "
+                    << msgs::ToString(_type) << " msgs" << std::endl;
+        }
+      }
+
+      /// \brief Get the scope of the topic announced by a discovery message.
+      /// \param[in] _type Message type.
+      /// \param[in] _pub Publishers's information to send.
+      /// \return The scope of the publisher for advertisements, or
+      /// Scope_t::ALL for the other messages.
+      private: template<typename T>
+      static Scope_t MsgScope(const msgs::Discovery::Type _type,
+                              const T &_pub)
+      {
+        if (_type != msgs::Discovery::ADVERTISE &&
+            _type != msgs::Discovery::UNADVERTISE)
+        {
+          return Scope_t::ALL;
+        }
+        return _pub.Options().Scope();
+      }
+
+      /// \brief Whether host scoped messages can be kept inside this host.
+      /// \return True if they are sent through the host socket.
+      private: bool HostOnly() const
+      {
+        // A discovery server relays everything, including the messages
+        // between the processes of this host.
+        return this->hostSocket >= 0 && !this->serverMode;
+      }
+
+      /// \brief Fill a discovery message.
+      /// \param[in] _type Message type.
+      /// \param[in] _pub Publishers's information to send.
+      /// \param[out] _msg The message.
+      /// \return False if the message type is not recognized.
+      private: template<typename T>
+      bool FillMsg(const msgs::Discovery::Type _type, const T &_pub,
+                   msgs::Discovery &_msg) const
+      {
+        gz::msgs::Discovery &discoveryMsg = _msg;
         discoveryMsg.set_version(this->Version());
         discoveryMsg.set_type(_type);
         discoveryMsg.set_process_uuid(this->pUuid);
@@ -1239,34 +2277,170 @@ namespace gz
           default:
             std::cerr << "Discovery::SendMsg() error: Unrecognized message"
                       << " type [" << _type << "]" << std::endl;
-            return;
+            return false;
         }
 
-        if (_destType == DestinationType::MULTICAST ||
-            _destType == DestinationType::ALL)
+        // In delta mode, the advertisement changes and the heartbeats carry
+        // the version of our set of publishers.
+        if (this->deltaMode &&
+            (_type == msgs::Discovery::HEARTBEAT ||
+             _type == msgs::Discovery::ADVERTISE ||
+             _type == msgs::Discovery::UNADVERTISE))
         {
-          this->SendMulticast(discoveryMsg);
+          SetHeaderValue(discoveryMsg, kVersionKey,
+            std::to_string(this->advVersion.load()));
         }
 
-        // Send the discovery message to the unicast relays.
-        if (_destType == DestinationType::UNICAST ||
-            _destType == DestinationType::ALL)
+        // The heartbeats let the peers estimate the offset of our clock.
+        if (_type == msgs::Discovery::HEARTBEAT)
+          SetHeaderValue(discoveryMsg, kClockKey, std::to_string(WallTimeUs()));
+
+        // Adaptive heartbeats announce the period until the next one.
+        if (this->adaptive && _type == msgs::Discovery::HEARTBEAT)
         {
-          // Set the RELAY flag in the header.
-          discoveryMsg.mutable_flags()->set_relay(true);
-          this->SendUnicast(discoveryMsg);
+          SetHeaderValue(discoveryMsg, kPeriodKey, std::to_string(
+            std::max(this->heartbeatPeriod.load(), this->heartbeatInterval)));
         }
 
-        if (this->verbose)
+        return true;
+      }
+
+      /// \brief Get the time of the system clock.
+      /// \return Microseconds since the Unix epoch.
+      private: static int64_t WallTimeUs()
+      {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+      }
+
+      /// \brief Measure the clock offset of a peer with one of its
+      /// heartbeats. Must be called with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the peer.
+      /// \param[in] _msg Heartbeat received from the peer.
+      private: void UpdateClockOffset(const std::string &_pUuid,
+                                      const msgs::Discovery &_msg)
+      {
+        std::string value;
+        if (!HeaderValue(_msg, kClockKey, value))
+          return;
+
+        int64_t sent;
+        try
         {
-          std::cout << "\t* Sending " << msgs::ToString(_type)
-                    << " msg [" << _pub.Topic() << "]" << std::endl;
+          sent = std::stoll(value);
         }
+        catch (const std::exception &)
+        {
+          return;
+        }
+
+        // The difference is the clock offset plus the transmission delay.
+        // The kernel stamp of the heartbeat, if any, leaves out the time it
+        // waited for our thread.
+        const int64_t now =
+          this->receiveStampUs > 0 ? this->receiveStampUs : WallTimeUs();
+        ClockEstimate &estimate = this->clockOffsets[_pUuid];
+        estimate.samples[estimate.count % kClockSamples] = now - sent;
+        ++estimate.count;
       }
 
-      /// \brief Send a discovery message through all unicast relays.
+      /// \brief Track the version of the publishers of a peer. Must be
+      /// called with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the peer.
+      /// \param[in] _msg Discovery message received from the peer.
+      /// \return True if we missed a change, i.e. a full sync has to be
+      /// requested from the peer.
+      private: bool UpdatePeerVersion(const std::string &_pUuid,
+                                      const msgs::Discovery &_msg)
+      {
+        std::string value;
+        uint64_t version;
+        if (!HeaderValue(_msg, kVersionKey, value))
+          return false;
+
+        try
+        {
+          version = std::stoull(value);
+        }
+        catch (const std::exception &)
+        {
+          return false;
+        }
+
+        auto it = this->peerVersions.find(_pUuid);
+        if (_msg.type() == msgs::Discovery::HEARTBEAT)
+        {
+          // A peer that never advertised anything has nothing to sync.
+          const bool missed = it == this->peerVersions.end() ?
+            version > 0 : it->second != version;
+          this->peerVersions[_pUuid] = version;
+          return missed;
+        }
+
+        // Follow the changes received in order. A gap is detected by the
+        // next heartbeat.
+        if (it != this->peerVersions.end() && it->second + 1 == version)
+          it->second = version;
+
+        return false;
+      }
+
+      /// \brief Ask a peer to re-advertise all its publishers.
+      /// \param[in] _pUuid Process UUID of the peer, or kSyncAll to ask all
+      /// the peers.
+      private: void SendSyncRequest(const std::string &_pUuid) const
+      {
+        gz::msgs::Discovery discoveryMsg;
+        discoveryMsg.set_version(this->Version());
+        discoveryMsg.set_type(msgs::Discovery::HEARTBEAT);
+        discoveryMsg.set_process_uuid(this->pUuid);
+        SetHeaderValue(discoveryMsg, kSyncKey, _pUuid);
+
+        this->SendMulticast(discoveryMsg);
+
+        discoveryMsg.mutable_flags()->set_relay(true);
+        this->SendUnicast(discoveryMsg);
+      }
+
+      /// \brief Get a value of the header data of a discovery message.
       /// \param[in] _msg Discovery message.
-      private: void SendUnicast(const msgs::Discovery &_msg) const
+      /// \param[in] _key Key of the header data.
+      /// \param[out] _value First value of the key.
+      /// \return True if the key was found.
+      private: static bool HeaderValue(const msgs::Discovery &_msg,
+                                       const std::string &_key,
+                                       std::string &_value)
+      {
+        for (const auto &data : _msg.header().data())
+        {
+          if (data.key() == _key && data.value_size() > 0)
+          {
+            _value = data.value(0);
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /// \brief Set a value of the header data of a discovery message.
+      /// \param[in, out] _msg Discovery message.
+      /// \param[in] _key Key of the header data.
+      /// \param[in] _value The value.
+      private: static void SetHeaderValue(msgs::Discovery &_msg,
+                                          const std::string &_key,
+                                          const std::string &_value)
+      {
+        auto *data = _msg.mutable_header()->add_data();
+        data->set_key(_key);
+        data->add_value(_value);
+      }
+
+      /// \brief Append a framed discovery message to a buffer.
+      /// \param[in] _msg Discovery message.
+      /// \param[in, out] _buffer Buffer where the frame is appended.
+      /// \return False if the message is too large or can't be serialized.
+      private: static bool AppendFrame(const msgs::Discovery &_msg,
+                                       std::string &_buffer)
       {
         uint16_t msgSize;
 
@@ -1275,111 +2449,168 @@ namespace gz
 #else
         int msgSizeFull = _msg.ByteSize();
 #endif
-        if (msgSizeFull + sizeof(msgSize) > this->kMaxRcvStr)
+        if (msgSizeFull + sizeof(msgSize) > kMaxRcvStr)
         {
           std::cerr << "Discovery message too large to send. Discovery won't "
             << "work. This shouldn't happen.\n";
-          return;
+          return false;
         }
         msgSize = msgSizeFull;
 
-        uint16_t totalSize = sizeof(msgSize) + msgSize;
-        char *buffer = static_cast<char *>(new char[totalSize]);
-        memcpy(&buffer[0], &msgSize, sizeof(msgSize));
+        const std::size_t offset = _buffer.size();
+        _buffer.resize(offset + sizeof(msgSize) + msgSize);
+        memcpy(&_buffer[offset], &msgSize, sizeof(msgSize));
 
-        if (_msg.SerializeToArray(buffer + sizeof(msgSize), msgSize))
+        if (!_msg.SerializeToArray(&_buffer[offset + sizeof(msgSize)],
+              msgSize))
         {
-          // Send the discovery message to the unicast relays.
-          std::lock_guard<std::mutex> lock(this->mutex);
+          std::cerr << "Discovery: Error serializing data." << std::endl;
+          _buffer.resize(offset);
+          return false;
+        }
+
+        return true;
+      }
 
-          for (const auto &sockAddr : this->relayAddrs)
+      /// \brief Send a discovery message through all unicast relays.
+      /// \param[in] _msg Discovery message.
+      private: void SendUnicast(const msgs::Discovery &_msg) const
+      {
+        std::string buffer;
+        if (AppendFrame(_msg, buffer))
+          this->SendUnicastBuffer(buffer);
+      }
+
+      /// \brief Send a datagram through all unicast relays.
+      /// \param[in] _buffer One or more framed discovery messages.
+      private: void SendUnicastBuffer(const std::string &_buffer) const
+      {
+        const auto totalSize = static_cast<uint16_t>(_buffer.size());
+
+        // Send the discovery message to the unicast relays.
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        for (const auto &sockAddr : this->relayAddrs)
+        {
+          errno = 0;
+          auto sent = sendto(this->sockets.at(0),
+            reinterpret_cast<const raw_type *>(_buffer.data()),
+            totalSize, 0,
+            reinterpret_cast<const sockaddr *>(&sockAddr),
+            sizeof(sockAddr));
+
+          if (sent != totalSize)
           {
-            errno = 0;
-            auto sent = sendto(this->sockets.at(0),
-              reinterpret_cast<const raw_type *>(
-                reinterpret_cast<const unsigned char*>(buffer)),
-              totalSize, 0,
-              reinterpret_cast<const sockaddr *>(&sockAddr),
-              sizeof(sockAddr));
-
-            if (sent != totalSize)
-            {
-              std::cerr << "Exception sending a unicast message:" << std::endl;
-              std::cerr << "  Return value: " << sent << std::endl;
-              std::cerr << "  Error code: " << strerror(errno) << std::endl;
-              break;
-            }
+            std::cerr << "Exception sending a unicast message:" << std::endl;
+            std::cerr << "  Return value: " << sent << std::endl;
+            std::cerr << "  Error code: " << strerror(errno) << std::endl;
+            break;
           }
         }
-        else
-        {
-          std::cerr << "Discovery::SendUnicast: Error serializing data."
-            << std::endl;
-        }
-
-        delete [] buffer;
       }
 
       /// \brief Send a discovery message through the multicast group.
       /// \param[in] _msg Discovery message.
       private: void SendMulticast(const msgs::Discovery &_msg) const
       {
-        uint16_t msgSize;
+        // Everything goes through the server.
+        if (this->serverMode)
+          return;
 
-#if GOOGLE_PROTOBUF_VERSION >= 3004000
-        size_t msgSizeFull = _msg.ByteSizeLong();
-#else
-        int msgSizeFull = _msg.ByteSize();
-#endif
-        if (msgSizeFull + sizeof(msgSize) > this->kMaxRcvStr)
-        {
-          std::cerr << "Discovery message too large to send. Discovery won't "
-            << "work. This shouldn't happen.\n";
+        std::string buffer;
+        if (AppendFrame(_msg, buffer))
+          this->SendMulticastBuffer(buffer);
+      }
+
+      /// \brief Send a datagram through the multicast group.
+      /// \param[in] _buffer One or more framed discovery messages.
+      private: void SendMulticastBuffer(const std::string &_buffer) const
+      {
+        // Everything goes through the server.
+        if (this->serverMode)
           return;
-        }
 
-        msgSize = msgSizeFull;
-        uint16_t totalSize = sizeof(msgSize) + msgSize;
-        char *buffer = static_cast<char *>(new char[totalSize]);
-        memcpy(&buffer[0], &msgSize, sizeof(msgSize));
+        const auto totalSize = static_cast<uint16_t>(_buffer.size());
 
-        if (_msg.SerializeToArray(buffer + sizeof(msgSize), msgSize))
+        // Send the discovery message to the multicast group through all the
+        // sockets.
+        for (const auto &sock : this->Sockets())
         {
-          // Send the discovery message to the multicast group through all the
-          // sockets.
-          for (const auto &sock : this->Sockets())
+          errno = 0;
+          if (sendto(sock, reinterpret_cast<const raw_type *>(_buffer.data()),
+            totalSize, 0,
+            reinterpret_cast<const sockaddr *>(this->MulticastAddr()),
+            sizeof(*(this->MulticastAddr()))) != totalSize)
           {
-            errno = 0;
-            if (sendto(sock, reinterpret_cast<const raw_type *>(
-              reinterpret_cast<const unsigned char*>(buffer)),
-              totalSize, 0,
-              reinterpret_cast<const sockaddr *>(this->MulticastAddr()),
-              sizeof(*(this->MulticastAddr()))) != totalSize)
+            // Ignore EPERM and ENOBUFS errors.
+            //
+            // See issue #106
+            //
+            // Rationale drawn from:
+            //
+            // * https://groups.google.com/forum/#!topic/comp.protocols.tcp-ip/Qou9Sfgr77E
+            // * https://stackoverflow.com/questions/16555101/sendto-dgrams-do-not-block-for-enobufs-on-osx
+            if (errno != EPERM && errno != ENOBUFS)
             {
-              // Ignore EPERM and ENOBUFS errors.
-              //
-              // See issue #106
-              //
-              // Rationale drawn from:
-              //
-              // * https://groups.google.com/forum/#!topic/comp.protocols.tcp-ip/Qou9Sfgr77E
-              // * https://stackoverflow.com/questions/16555101/sendto-dgrams-do-not-block-for-enobufs-on-osx
-              if (errno != EPERM && errno != ENOBUFS)
-              {
-                std::cerr << "Exception sending a multicast message:"
-                  << strerror(errno) << std::endl;
-              }
-              break;
+              std::cerr << "Exception sending a multicast message:"
+                << strerror(errno) << std::endl;
             }
+            break;
           }
         }
-        else
+      }
+
+      /// \brief Send a datagram to the multicast group, only to the processes
+      /// of this host.
+      /// \param[in] _buffer One or more framed discovery messages.
+      private: void SendHostBuffer(const std::string &_buffer) const
+      {
+        const auto totalSize = static_cast<uint16_t>(_buffer.size());
+
+        errno = 0;
+        if (sendto(this->hostSocket,
+          reinterpret_cast<const raw_type *>(_buffer.data()), totalSize, 0,
+          reinterpret_cast<const sockaddr *>(this->MulticastAddr()),
+          sizeof(*(this->MulticastAddr()))) != totalSize)
         {
-          std::cerr << "Discovery::SendMulticast: Error serializing data."
-            << std::endl;
+          if (errno != EPERM && errno != ENOBUFS)
+          {
+            std::cerr << "Exception sending a host message:"
+              << strerror(errno) << std::endl;
+          }
         }
+      }
+
+      /// \brief Create the socket used to send the host scoped messages. Its
+      /// multicast datagrams have a TTL of 0, so the kernel only loops them
+      /// back to the processes of this host.
+      private: void CreateHostSocket()
+      {
+        int sock = static_cast<int>(socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP));
+        if (sock < 0)
+          return;
 
-        delete [] buffer;
+        struct in_addr ifAddr;
+        ifAddr.s_addr = inet_addr(this->hostAddr.c_str());
+        const int ttl = 0;
+        const int loop = 1;
+        if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF,
+              reinterpret_cast<const char*>(&ifAddr), sizeof(ifAddr)) != 0 ||
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL,
+              reinterpret_cast<const char*>(&ttl), sizeof(ttl)) != 0 ||
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP,
+              reinterpret_cast<const char*>(&loop), sizeof(loop)) != 0)
+        {
+          // Host scoped messages will use the regular sockets.
+#ifdef _WIN32
+          closesocket(sock);
+#else
+          close(sock);
+#endif
+          return;
+        }
+
+        this->hostSocket = sock;
       }
 
       /// \brief Get the list of sockets used for discovery.
@@ -1487,6 +2718,89 @@ namespace gz
       /// the wire protocol (for discovery or message/service exchange).
       private: static const uint8_t kWireVersion = 10;
 
+      /// \brief In delta mode, number of heartbeats between two full
+      /// refreshes of the local publishers.
+      /// \sa SetDeltaMode.
+      private: static const unsigned int kFullSyncHeartbeats = 10;
+
+      /// \brief In adaptive mode, longest heartbeat period, in heartbeat
+      /// intervals.
+      /// \sa SetAdaptive.
+      private: static const unsigned int kMaxHeartbeatBackoff = 16;
+
+      /// \brief In adaptive mode, randomization of the heartbeat periods
+      /// (percent).
+      /// \sa SetAdaptive.
+      private: static const unsigned int kHeartbeatJitter = 10;
+
+      /// \brief Key of the discovery header data that contains the version
+      /// of the publishers of the sender.
+      private: static constexpr const char *kVersionKey =
+               "gz.transport.discovery_version";
+
+      /// \brief Key of the discovery header data that contains the process
+      /// UUID of a peer asked to re-advertise its publishers.
+      public: static constexpr const char *kSyncKey =
+               "gz.transport.discovery_sync";
+
+      /// \brief Value of the sync request that targets all the peers.
+      public: static constexpr const char *kSyncAll = "*";
+
+      /// \brief Key of the discovery header data that marks the heartbeats
+      /// of a discovery server.
+      public: static constexpr const char *kServerKey =
+               "gz.transport.discovery_server";
+
+      /// \brief Key of the discovery header data that contains the IP
+      /// address of the process whose message is forwarded by a discovery
+      /// server.
+      public: static constexpr const char *kOriginKey =
+               "gz.transport.discovery_origin";
+
+      /// \brief Key of the discovery header data that contains the time of
+      /// the system clock of the sender of a heartbeat (microseconds since
+      /// the Unix epoch).
+      public: static constexpr const char *kClockKey =
+               "gz.transport.discovery_clock";
+
+      /// \brief Key of the discovery header data that contains the period
+      /// until the next adaptive heartbeat of the sender (milliseconds).
+      /// \sa SetAdaptive.
+      public: static constexpr const char *kPeriodKey =
+               "gz.transport.discovery_period";
+
+      /// \brief Number of heartbeats kept to estimate the clock offset of a
+      /// peer.
+      private: static constexpr std::size_t kClockSamples = 16;
+
+      /// \brief Clock differences measured with the last heartbeats of a
+      /// peer. The smallest one is the closest to the clock offset.
+      private: class ClockEstimate
+      {
+        /// \brief Reception time minus sending time (microseconds).
+        public: std::array<int64_t, kClockSamples> samples{};
+
+        /// \brief Number of heartbeats measured.
+        public: std::size_t count = 0;
+      };
+
+      /// \brief Minimum time between two re-advertisements requested by the
+      /// peers (ms.).
+      private: static constexpr unsigned int kSyncPeriod = 100;
+
+      /// \brief Longest random delay before answering a SUBSCRIBERS_REQ
+      /// message (ms.).
+      private: static constexpr unsigned int kSubscribersRepDelay = 100;
+
+      /// \brief Number of startup bursts of the fast start, including the
+      /// final step that only waits for the answers.
+      /// \sa SetFastStart.
+      private: static constexpr unsigned int kStartupBursts = 6;
+
+      /// \brief Delay between the first two startup bursts (ms.). It doubles
+      /// after every burst.
+      private: static constexpr unsigned int kFirstBurstDelay = 25;
+
       /// \brief Port used to broadcast the discovery messages.
       private: int port;
 
@@ -1553,6 +2867,20 @@ namespace gz
       /// \brief Collection of socket addresses used as remote relays.
       private: std::vector<sockaddr_in> relayAddrs;
 
+      /// \brief Socket used to send the host scoped messages, or -1.
+      private: int hostSocket = -1;
+
+      /// \brief Socket used to interrupt the reception thread, or -1.
+      private: int wakeSocket = -1;
+
+      /// \brief Address of the wake up socket.
+      private: sockaddr_in wakeAddr;
+
+      /// \brief Whether we talk to a discovery server instead of the
+      /// multicast group.
+      /// \sa ServerMode.
+      private: bool serverMode = false;
+
       /// \brief Mutex to guarantee exclusive access between the threads.
       private: mutable std::mutex mutex;
 
@@ -1585,6 +2913,97 @@ namespace gz
 
       /// \brief When true, the service is enabled.
       private: bool enabled;
+
+      /// \brief Whether Open() was called.
+      private: bool opened = false;
+
+      /// \brief Whether the constructor left the sockets to Open().
+      private: bool deferred = false;
+
+      /// \brief Whether the delta mode is enabled.
+      /// \sa SetDeltaMode.
+      private: std::atomic<bool> deltaMode{false};
+
+      /// \brief Version of the publishers advertised outside this process.
+      private: std::atomic<uint64_t> advVersion{0};
+
+      /// \brief Last version of the publishers of every peer, in delta mode.
+      /// The key is the process uuid.
+      private: std::map<std::string, uint64_t> peerVersions;
+
+      /// \brief Clock offsets of the peers running on other hosts. The key is
+      /// the process uuid.
+      private: std::map<std::string, ClockEstimate> clockOffsets;
+
+      /// \brief Time at which the kernel received the datagram being
+      /// processed (microseconds since the Unix epoch), or 0 if it wasn't
+      /// stamped.
+      private: int64_t receiveStampUs = 0;
+
+      /// \brief Whether a peer asked us to re-advertise our publishers.
+      private: bool syncRequested = false;
+
+      /// \brief Heartbeats sent since the last full refresh.
+      private: unsigned int heartbeatsSinceSync = 0;
+
+      /// \brief Earliest time of the next re-advertisement requested by a
+      /// peer.
+      private: Timestamp timeNextSync;
+
+      /// \brief Whether the fast start is enabled.
+      /// \sa SetFastStart.
+      private: std::atomic<bool> fastStart{false};
+
+      /// \brief Whether the discovery messages are batched.
+      /// \sa SetBatching.
+      private: std::atomic<bool> batching{false};
+
+      /// \brief Whether the adaptive heartbeats are enabled.
+      /// \sa SetAdaptive.
+      private: std::atomic<bool> adaptive{false};
+
+      /// \brief Period until the heartbeat after the next one, in adaptive
+      /// mode (ms.).
+      private: std::atomic<unsigned int> heartbeatPeriod{0};
+
+      /// \brief Heartbeat periods announced by the peers in adaptive mode.
+      /// The key is the process uuid.
+      private: std::map<std::string, unsigned int> peerPeriods;
+
+      /// \brief Random engine of the heartbeat jitter.
+      private: std::minstd_rand randomEngine{std::random_device{}()};
+
+      /// \brief Startup bursts still to send.
+      private: unsigned int burstsLeft = 0;
+
+      /// \brief Time of the next startup burst.
+      private: Timestamp timeNextBurst;
+
+      /// \brief Whether the subscribers were requested from the peers.
+      /// \sa TopicList.
+      private: bool subscribersSynced = false;
+
+      /// \brief Whether a SUBSCRIBERS_REQ message is waiting for its answer.
+      private: bool subscribersRepPending = false;
+
+      /// \brief Time of the answer to the pending SUBSCRIBERS_REQ messages.
+      private: Timestamp timeSubscribersRep;
+
+      /// \brief Delay until the startup burst after the next one (ms.).
+      private: unsigned int burstDelay = kFirstBurstDelay;
+
+      /// \brief Topics requested with Discover(), repeated by the startup
+      /// bursts.
+      private: mutable std::set<std::string> discoveredTopics;
+
+      /// \brief File caching the publishers of the other processes, or
+      /// empty.
+      /// \sa SetCacheFile.
+      private: std::string cacheFile;
+
+      /// \brief Whether the publishers changed since the last time the
+      /// cache file was written.
+      private: bool cacheDirty = false;
     };
 
     /// \def MsgDiscovery
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_DISCOVERYSERVER_HH_
+#define GZ_TRANSPORT_DISCOVERYSERVER_HH_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    // Forward declarations.
+    class DiscoveryServerPrivate;
+
+    /// \class DiscoveryServer DiscoveryServer.hh
+    /// gz/transport/DiscoveryServer.hh
+    /// \brief A discovery server for networks without multicast.
+    ///
+    /// The processes started with GZ_DISCOVERY_SERVER set to the IP address
+    /// of the server send all their discovery messages to it, instead of
+    /// the multicast group. The server holds the authoritative list of
+    /// topics and services: it answers the discovery requests, sends the
+    /// whole list to the processes that join and forwards the changes to the
+    /// other processes. It also tracks the heartbeats of the processes and
+    /// says goodbye on behalf of the ones that go silent. The discovery
+    /// traffic grows linearly with the number of processes.
+    ///
+    /// The server listens on the message and service discovery ports, which
+    /// can't be shared with processes using the multicast discovery on the
+    /// same host.
+    class GZ_TRANSPORT_VISIBLE DiscoveryServer
+    {
+      /// \brief Constructor.
+      /// \param[in] _msgPort UDP port used for message discovery.
+      /// \param[in] _srvPort UDP port used for service discovery.
+      /// \param[in] _verbose Whether to print the discovery activity.
+      public: DiscoveryServer(const int _msgPort, const int _srvPort,
+                              const bool _verbose = false);
+
+      /// \brief Destructor. It stops the server.
+      public: ~DiscoveryServer();
+
+      /// \brief Bind the sockets and start serving.
+      /// \return False if the server is already running or a port couldn't
+      /// be bound.
+      public: bool Start();
+
+      /// \brief Stop serving. Start() can be called again later, but the
+      /// processes have to join again.
+      public: void Stop();
+
+      /// \brief Set the interval between the heartbeats of the server.
+      /// Call this before Start().
+      /// \param[in] _ms Heartbeat interval (ms.).
+      public: void SetHeartbeatInterval(const unsigned int _ms);
+
+      /// \brief Set the time after which a silent process is considered
+      /// gone. Call this before Start().
+      /// \param[in] _ms Silence interval (ms.).
+      public: void SetSilenceInterval(const unsigned int _ms);
+
+      /// \brief Number of processes connected for message discovery.
+      /// \return The number of processes.
+      public: std::size_t MsgClientCount() const;
+
+      /// \brief Number of processes connected for service discovery.
+      /// \return The number of processes.
+      public: std::size_t SrvClientCount() const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Smart pointer to private data.
+      private: std::unique_ptr<DiscoveryServerPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
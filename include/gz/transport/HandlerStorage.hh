@@ -166,6 +166,13 @@ namespace gz
         return this->data;
       }
 
+      /// \brief Get a const reference to all the handlers.
+      /// \return All the handlers.
+      public: const TopicServiceCalls_M &AllHandlers() const
+      {
+        return this->data;
+      }
+
       /// \brief Add a request handler to a topic. A request handler stores
       /// the callback and types associated to a service call request.
       /// \param[in] _topic Topic name.
@@ -43,6 +43,10 @@
   #endif
 #endif
 
+#ifndef _WIN32
+struct msghdr;
+#endif
+
 namespace gz
 {
   namespace transport
@@ -72,6 +76,112 @@ namespace gz
     /// \returns id of current process
     unsigned int GZ_TRANSPORT_VISIBLE getProcessId();
 
+    /// \brief Append a message to a buffer of messages, each one preceded
+    /// by its size (32 bits, little endian).
+    /// \param[in, out] _buffer The buffer.
+    /// \param[in] _data The message.
+    /// \return False if the message is too large (4 GiB or more).
+    bool GZ_TRANSPORT_VISIBLE appendSizePrefixed(std::string &_buffer,
+                                                 const std::string &_data);
+
+    /// \brief Split a buffer created with appendSizePrefixed().
+    /// \param[in] _buffer The buffer.
+    /// \param[out] _items The messages.
+    /// \return False if the buffer is malformed.
+    bool GZ_TRANSPORT_VISIBLE splitSizePrefixed(
+        const std::string &_buffer,
+        std::vector<std::string> &_items);
+
+    /// \brief Get a new identifier for a service request. The identifiers
+    /// are unique within the process and never reused.
+    /// \return The identifier.
+    uint64_t GZ_TRANSPORT_VISIBLE nextRequestId();
+
+    /// \brief Parse a list of CPUs, e.g. "0,2-3".
+    /// \param[in] _list The list.
+    /// \param[out] _cpus The CPUs.
+    /// \return False if the list is malformed.
+    bool GZ_TRANSPORT_VISIBLE parseCpuList(const std::string &_list,
+                                           std::vector<int> &_cpus);
+
+    /// \brief Set the CPU affinity and the SCHED_FIFO priority of the
+    /// calling thread. It is only supported on Linux.
+    /// \param[in] _thread Description of the thread for the error messages.
+    /// \param[in] _cpus CPUs of the thread, or empty to keep its affinity.
+    /// \param[in] _priority SCHED_FIFO priority, or 0 to keep its policy.
+    /// \return False if the affinity or the priority couldn't be set.
+    bool GZ_TRANSPORT_VISIBLE setThreadScheduling(const std::string &_thread,
+                                                  const std::vector<int> &_cpus,
+                                                  const int _priority);
+
+    /// \brief Get the CPUs of a NUMA node. It is only supported on Linux.
+    /// \param[in] _node The NUMA node.
+    /// \param[out] _cpus The CPUs of the node.
+    /// \return False if the node doesn't exist.
+    bool GZ_TRANSPORT_VISIBLE numaNodeCpus(const int _node,
+                                           std::vector<int> &_cpus);
+
+    /// \brief Allocate the memory of the calling thread on a NUMA node
+    /// when it has free pages: the pages touched for the first time by the
+    /// thread afterwards, e.g. its message buffers, come from that node. It
+    /// is only supported on Linux.
+    /// \param[in] _thread Description of the thread for the error messages.
+    /// \param[in] _node The NUMA node.
+    /// \return False if the memory policy couldn't be set.
+    bool GZ_TRANSPORT_VISIBLE setThreadMemoryNode(const std::string &_thread,
+                                                  const int _node);
+
+    /// \brief Place a range of memory on a NUMA node when it has free
+    /// pages, moving the pages already allocated. It is only supported on
+    /// Linux.
+    /// \param[in] _addr Start of the range, aligned on a page.
+    /// \param[in] _size Size of the range (bytes).
+    /// \param[in] _node The NUMA node.
+    /// \return False if the memory policy couldn't be set.
+    bool GZ_TRANSPORT_VISIBLE bindMemoryNode(void *_addr,
+                                             const std::size_t _size,
+                                             const int _node);
+
+    /// \brief Name the calling thread, an internal thread of the transport,
+    /// and set the CPU affinity and the SCHED_FIFO priority configured for
+    /// its kind by GZ_TRANSPORT_<KIND>_THREAD_CPUS and
+    /// GZ_TRANSPORT_<KIND>_THREAD_PRIORITY, or else by
+    /// GZ_TRANSPORT_THREAD_CPUS and GZ_TRANSPORT_THREAD_PRIORITY. The NUMA
+    /// node set by GZ_TRANSPORT_<KIND>_THREAD_NUMA_NODE, or else by
+    /// GZ_TRANSPORT_THREAD_NUMA_NODE, provides the memory of the thread and,
+    /// unless a CPU list is set, its CPUs.
+    /// \param[in] _kind Kind of thread, e.g. "RECEPTION".
+    /// \param[in] _name Name of the thread shown by the debuggers and the
+    /// profilers, at most 15 characters.
+    /// \return False if the configuration couldn't be applied.
+    bool GZ_TRANSPORT_VISIBLE setupThread(const std::string &_kind,
+                                          const std::string &_name);
+
+    /// \brief Ask the kernel to stamp the packets received by a socket when
+    /// they leave the network driver, before any thread reads them. The
+    /// stamps are in the system clock. It is only supported on Linux.
+    /// \param[in] _socket The socket.
+    /// \return False if the socket can't be stamped.
+    /// \sa receiveTimestamp
+    bool GZ_TRANSPORT_VISIBLE enableReceiveTimestamps(const int _socket);
+
+#ifndef _WIN32
+    /// \brief Get the kernel stamp of a packet received with recvmsg() on a
+    /// socket with receive timestamps.
+    /// \param[in] _msg The message filled by recvmsg(), with room for
+    /// kReceiveTimestampControlSize bytes of control data.
+    /// \param[out] _stampUs Reception time (microseconds since the Unix
+    /// epoch).
+    /// \return False if the packet has no stamp.
+    /// \sa enableReceiveTimestamps
+    bool GZ_TRANSPORT_VISIBLE receiveTimestamp(const msghdr &_msg,
+                                               int64_t &_stampUs);
+
+    /// \brief Size of the control data needed by receiveTimestamp()
+    /// (bytes).
+    constexpr std::size_t kReceiveTimestampControlSize = 256;
+#endif
+
     // Use safer functions on Windows
     #ifdef _MSC_VER
       #define gz_strcat strcat_s
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_INTROSPECTIONDAEMON_HH_
+#define GZ_TRANSPORT_INTROSPECTIONDAEMON_HH_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+#include "gz/transport/Publisher.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    // Forward declarations.
+    class IntrospectionClientPrivate;
+    class IntrospectionDaemonPrivate;
+
+    /// \class IntrospectionDaemon IntrospectionDaemon.hh
+    /// gz/transport/IntrospectionDaemon.hh
+    /// \brief A long-lived process that keeps the discovery graph of a
+    /// partition warm and answers graph queries over a local socket.
+    ///
+    /// Creating a Node brings up the sockets and threads of the transport
+    /// and waits for the discovery, which takes hundreds of milliseconds
+    /// and generates discovery traffic. Short-lived tools, like the command
+    /// line tools, ask the daemon instead with an IntrospectionClient and
+    /// only fall back to their own Node when no daemon is running.
+    ///
+    /// The daemon discovers the partition of its environment, so the
+    /// default endpoint includes the partition name: there is one daemon
+    /// per partition and user on a host.
+    class GZ_TRANSPORT_VISIBLE IntrospectionDaemon
+    {
+      /// \brief Constructor.
+      /// \param[in] _endpoint ZeroMQ endpoint where the daemon listens.
+      /// An empty string uses DefaultEndpoint().
+      public: explicit IntrospectionDaemon(const std::string &_endpoint = "");
+
+      /// \brief Destructor. It stops the daemon.
+      public: ~IntrospectionDaemon();
+
+      /// \brief Start discovering and bind the socket.
+      /// \return False if the daemon is already running, another daemon
+      /// answers on the same endpoint or the socket couldn't be bound.
+      public: bool Start();
+
+      /// \brief Stop serving and remove the socket.
+      public: void Stop();
+
+      /// \brief Get the endpoint where the daemon listens.
+      /// \return The ZeroMQ endpoint.
+      public: std::string Endpoint() const;
+
+      /// \brief Get the endpoint of the daemon of the current partition.
+      /// It's an IPC socket in the temporary directory, named after the
+      /// partition.
+      /// \return The ZeroMQ endpoint.
+      public: static std::string DefaultEndpoint();
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Smart pointer to private data.
+      private: std::unique_ptr<IntrospectionDaemonPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+
+    /// \class IntrospectionClient IntrospectionDaemon.hh
+    /// gz/transport/IntrospectionDaemon.hh
+    /// \brief Queries the graph known by an IntrospectionDaemon.
+    ///
+    /// The functions mirror the introspection functions of Node. All of
+    /// them return false when there's no daemon or it doesn't reply in
+    /// time, and the caller should then fall back to a Node.
+    class GZ_TRANSPORT_VISIBLE IntrospectionClient
+    {
+      /// \brief Constructor.
+      /// \param[in] _endpoint ZeroMQ endpoint of the daemon. An empty
+      /// string uses IntrospectionDaemon::DefaultEndpoint().
+      /// \param[in] _timeout Maximum time to wait for every reply (ms.).
+      public: explicit IntrospectionClient(const std::string &_endpoint = "",
+                                           const unsigned int _timeout = 250);
+
+      /// \brief Destructor.
+      public: ~IntrospectionClient();
+
+      /// \brief Check whether a daemon replies.
+      /// \return True if a daemon replied.
+      public: bool Available() const;
+
+      /// \brief Get the list of topics advertised in the partition.
+      /// \param[out] _topics List of topics.
+      /// \return True if the daemon replied.
+      /// \sa Node::TopicList
+      public: bool TopicList(std::vector<std::string> &_topics) const;
+
+      /// \brief Get the publishers and subscribers of a topic.
+      /// \param[in] _topic Name of the topic.
+      /// \param[out] _publishers Publishers of the topic.
+      /// \param[out] _subscribers Subscribers of the topic.
+      /// \return True if the daemon replied.
+      /// \sa Node::TopicInfo
+      public: bool TopicInfo(const std::string &_topic,
+                             std::vector<MessagePublisher> &_publishers,
+                             std::vector<MessagePublisher> &_subscribers)
+                             const;
+
+      /// \brief Get the list of services advertised in the partition.
+      /// \param[out] _services List of services.
+      /// \return True if the daemon replied.
+      /// \sa Node::ServiceList
+      public: bool ServiceList(std::vector<std::string> &_services) const;
+
+      /// \brief Get the providers of a service.
+      /// \param[in] _service Name of the service.
+      /// \param[out] _publishers Providers of the service.
+      /// \return True if the daemon replied.
+      /// \sa Node::ServiceInfo
+      public: bool ServiceInfo(const std::string &_service,
+                               std::vector<ServicePublisher> &_publishers)
+                               const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \internal
+      /// \brief Smart pointer to private data.
+      private: std::unique_ptr<IntrospectionClientPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
@@ -18,6 +18,8 @@
 #ifndef GZ_TRANSPORT_MESSAGEINFO_HH_
 #define GZ_TRANSPORT_MESSAGEINFO_HH_
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -48,6 +50,11 @@ namespace gz
       /// \param[in] _other an instance data is moved from
       public: MessageInfo(MessageInfo &&_other);  // NOLINT
 
+      /// \brief Copy assignment operator.
+      /// \param[in] _other an instance to copy data from
+      /// \return Reference to this instance.
+      public: MessageInfo &operator=(const MessageInfo &_other);
+
       /// \brief Destructor.
       public: ~MessageInfo();
 
@@ -89,6 +96,67 @@ namespace gz
       /// \param[in] _value The intra-process value.
       public: void SetIntraProcess(bool _value);
 
+      /// \brief Get the file descriptor passed along with the message, see
+      /// Node::Publisher::PublishFd(). It stays open as long as this object
+      /// or a copy of it exists, so a callback that keeps the buffer longer
+      /// must duplicate it (e.g. with dup()).
+      /// \return The descriptor, or -1 if the message doesn't carry one.
+      public: int Fd() const;
+
+      /// \brief Set the file descriptor passed along with the message. The
+      /// object takes its ownership: it is closed once this object and all
+      /// its copies are destroyed.
+      /// \param[in] _fd The descriptor, or -1.
+      public: void SetFd(int _fd);
+
+      /// \brief Whether the message carries the metadata of its
+      /// publication: its publication and reception times, its sequence
+      /// number and its publisher. The metadata is only available for the
+      /// messages received from other processes, when the publisher sets
+      /// GZ_TRANSPORT_MESSAGE_METADATA (or GZ_TRANSPORT_TOPIC_STATISTICS).
+      /// The subscriber doesn't need to set it.
+      /// \return True if the publication time is set.
+      public: bool HasMetadata() const;
+
+      /// \brief Get the time the message was published, on the system
+      /// clock of this process: the clock offset of publishers running on
+      /// other hosts, estimated by the discovery, is corrected.
+      /// \return The publication time, or the epoch if unknown.
+      public: std::chrono::system_clock::time_point PublicationTime() const;
+
+      /// \brief Set the time the message was published.
+      /// \param[in] _time The publication time.
+      public: void SetPublicationTime(
+                  const std::chrono::system_clock::time_point &_time);
+
+      /// \brief Get the time the message was received, before its
+      /// callbacks were triggered.
+      /// \return The reception time, or the epoch if unknown.
+      public: std::chrono::system_clock::time_point ReceptionTime() const;
+
+      /// \brief Set the time the message was received.
+      /// \param[in] _time The reception time.
+      public: void SetReceptionTime(
+                  const std::chrono::system_clock::time_point &_time);
+
+      /// \brief Get the sequence number of the message. The publications
+      /// of a process are numbered per topic, from 0, so a gap between two
+      /// messages of the same publisher reveals lost messages.
+      /// \return The sequence number, or 0 if unknown.
+      public: uint64_t SequenceNumber() const;
+
+      /// \brief Set the sequence number of the message.
+      /// \param[in] _seq The sequence number.
+      public: void SetSequenceNumber(uint64_t _seq);
+
+      /// \brief Get the UUID of the process that published the message.
+      /// \return The process UUID, or an empty string if unknown.
+      public: const std::string &PublisherUuid() const;
+
+      /// \brief Set the UUID of the process that published the message.
+      /// \param[in] _pUuid The process UUID.
+      public: void SetPublisherUuid(const std::string &_pUuid);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_MESSAGEPOOL_HH_
+#define GZ_TRANSPORT_MESSAGEPOOL_HH_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \class MessagePool MessagePool.hh gz/transport/MessagePool.hh
+    /// \brief A pool of recycled protobuf messages of type 'T'.
+    ///
+    /// When an acquired message is released, it is returned to the pool
+    /// as is. Parsing into it again clears the message but keeps the
+    /// capacity of its strings and repeated fields, so messages of similar
+    /// shape are deserialized without any heap allocation.
+    template <typename T> class MessagePool
+    {
+      /// \brief Default maximum number of idle messages kept in the pool.
+      public: static constexpr std::size_t kDefaultMaxIdle = 8;
+
+      /// \brief Constructor.
+      /// \param[in] _maxIdle Maximum number of idle messages kept for reuse.
+      /// Messages released when the pool is full are destroyed.
+      public: explicit MessagePool(std::size_t _maxIdle = kDefaultMaxIdle)
+        : state(std::make_shared<State>())
+      {
+        this->state->maxIdle = _maxIdle;
+      }
+
+      /// \brief Acquire a message. This function is thread safe.
+      /// \return The message, which may hold the data of a previous use.
+      /// It is returned to the pool when the last reference is released.
+      public: std::shared_ptr<T> Acquire()
+      {
+        std::unique_ptr<T> msg;
+        {
+          std::lock_guard<std::mutex> lk(this->state->mutex);
+          if (!this->state->idle.empty())
+          {
+            msg = std::move(this->state->idle.back());
+            this->state->idle.pop_back();
+          }
+        }
+
+        if (!msg)
+          msg = std::make_unique<T>();
+
+        // Messages released after the pool are simply deleted.
+        std::weak_ptr<State> weak = this->state;
+        return std::shared_ptr<T>(msg.release(), [weak](T *_msg)
+        {
+          std::unique_ptr<T> owned(_msg);
+          auto s = weak.lock();
+          if (!s)
+            return;
+
+          std::lock_guard<std::mutex> lk(s->mutex);
+          if (s->idle.size() < s->maxIdle)
+            s->idle.push_back(std::move(owned));
+        });
+      }
+
+      /// \brief Number of idle messages ready to be reused.
+      /// \return The number of idle messages.
+      public: std::size_t IdleCount() const
+      {
+        std::lock_guard<std::mutex> lk(this->state->mutex);
+        return this->state->idle.size();
+      }
+
+      /// \brief State shared with the released messages.
+      private: struct State
+      {
+        /// \brief Protects the idle messages.
+        std::mutex mutex;
+
+        /// \brief Messages ready to be reused.
+        std::vector<std::unique_ptr<T>> idle;
+
+        /// \brief Maximum number of idle messages.
+        std::size_t maxIdle = kDefaultMaxIdle;
+      };
+
+      /// \brief Shared state. The released messages return to the pool
+      /// while it exists.
+      private: std::shared_ptr<State> state;
+    };
+    }
+  }
+}
+#endif
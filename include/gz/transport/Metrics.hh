@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_METRICS_HH_
+#define GZ_TRANSPORT_METRICS_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+#include "gz/transport/TopicStatistics.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    // Forward declarations.
+    class MetricsPrivate;
+
+    /// \class Metrics Metrics.hh gz/transport/Metrics.hh
+    /// \brief Process wide counters of the traffic of every topic and
+    /// service, always on unless GZ_TRANSPORT_METRICS is set to 0.
+    ///
+    /// Every counter is split in stripes written by different threads with
+    /// relaxed atomic increments, so counting doesn't contend on a lock or
+    /// a cache line. The stripes are only summed when the counters are read,
+    /// e.g. by OpenMetrics(), which renders all the counters and gauges in
+    /// the OpenMetrics (Prometheus) text format. Setting
+    /// GZ_TRANSPORT_METRICS_PORT serves that text over HTTP.
+    ///
+    /// The counters of a topic or a service are never removed, as required
+    /// by monotonic counters.
+    class GZ_TRANSPORT_VISIBLE Metrics
+    {
+      /// \brief Counters. The topic counters come first.
+      public: enum class Counter : std::size_t
+      {
+        /// \brief Messages published.
+        MSGS_SENT = 0,
+
+        /// \brief Bytes sent to remote subscribers.
+        BYTES_SENT,
+
+        /// \brief Time spent serializing the published messages (ns).
+        SERIALIZATION_NS,
+
+        /// \brief Messages received from remote publishers.
+        MSGS_RECEIVED,
+
+        /// \brief Bytes received from remote publishers.
+        BYTES_RECEIVED,
+
+        /// \brief Messages dropped by the subscription queues.
+        DROPPED_MSGS,
+
+        /// \brief Messages of a reliable topic lost, then received again.
+        RECOVERED_MSGS,
+
+        /// \brief Messages of a reliable topic lost for good.
+        LOST_MSGS,
+
+        /// \brief Requests sent.
+        REQUESTS_SENT,
+
+        /// \brief Successful responses received.
+        RESPONSES_RECEIVED,
+
+        /// \brief Requests that failed or expired.
+        FAILED_REQUESTS,
+
+        /// \brief Sum of the latencies of the completed requests (ns).
+        REQUEST_LATENCY_NS,
+
+        /// \brief Requests served by the responders of this process.
+        REQUESTS_SERVED,
+
+        /// \brief Time spent in the responder callbacks (ns).
+        SERVE_NS
+      };
+
+      /// \brief Number of counters.
+      public: static constexpr std::size_t kCounterCount = 14;
+
+      /// \brief Number of topic counters, see Counter.
+      public: static constexpr std::size_t kTopicCounterCount = 8;
+
+      /// \brief Counters of a topic or a service, defined in the source
+      /// file.
+      public: class Entry;
+
+      /// \brief Get the registry of this process.
+      /// \return The registry.
+      public: static Metrics &Instance();
+
+      /// \brief No copy.
+      public: Metrics(const Metrics &) = delete;
+
+      /// \brief No assignment.
+      public: Metrics &operator=(const Metrics &) = delete;
+
+      /// \brief Whether the metrics are collected.
+      /// \return True if enabled.
+      public: bool Enabled() const;
+
+      /// \brief Turn the collection of metrics on or off.
+      /// \param[in] _enabled True to collect the metrics.
+      public: void SetEnabled(const bool _enabled);
+
+      /// \brief Get the counters of a topic, creating them if needed. The
+      /// result can be kept, it remains valid for the process lifetime.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The counters, or nullptr if the metrics are disabled.
+      public: Entry *Topic(const std::string &_topic);
+
+      /// \brief Get the counters of a service, creating them if needed.
+      /// \param[in] _service Fully qualified service name.
+      /// \return The counters, or nullptr if the metrics are disabled.
+      public: Entry *Service(const std::string &_service);
+
+      /// \brief Increment a counter.
+      /// \param[in] _entry Counters of a topic or service, or nullptr, in
+      /// which case nothing is counted.
+      /// \param[in] _counter Counter to increment.
+      /// \param[in] _value Increment.
+      public: static void Add(Entry *_entry, const Counter _counter,
+                              const uint64_t _value = 1u);
+
+      /// \brief Count a completed request made by this process.
+      /// \param[in] _service Fully qualified service name.
+      /// \param[in] _latency Time between the request and its response.
+      /// \param[in] _result Result of the request.
+      public: void RecordRequest(const std::string &_service,
+                                 const std::chrono::nanoseconds &_latency,
+                                 const bool _result);
+
+      /// \brief Count a request served by a responder of this process to
+      /// a requester of this process, without using the network.
+      /// \param[in] _service Fully qualified service name.
+      /// \param[in] _latency Execution time of the responder.
+      /// \param[in] _result Result of the request.
+      public: void RecordLocalRequest(const std::string &_service,
+                                      const std::chrono::nanoseconds &_latency,
+                                      const bool _result);
+
+      /// \brief Get the value of a counter.
+      /// \param[in] _name Fully qualified name of the topic, for the topic
+      /// counters, or of the service.
+      /// \param[in] _counter Counter.
+      /// \return The value of the counter, 0 if it doesn't exist.
+      public: uint64_t Value(const std::string &_name,
+                             const Counter _counter) const;
+
+      /// \brief Get the values of a counter for every topic, for the topic
+      /// counters, or for every service.
+      /// \param[in] _counter Counter.
+      /// \return The values, by fully qualified name.
+      public: std::map<std::string, uint64_t> Values(
+        const Counter _counter) const;
+
+      /// \brief Get the distribution of the latencies of the requests
+      /// completed by a service.
+      /// \param[in] _service Fully qualified service name.
+      /// \return Latency histogram (microseconds).
+      public: LatencyHistogram RequestLatency(
+        const std::string &_service) const;
+
+      /// \brief Add or replace a gauge, sampled when the metrics are read.
+      /// \param[in] _name Metric name, e.g. "gz_transport_pub_queue_depth".
+      /// \param[in] _help Description of the gauge.
+      /// \param[in] _value Function returning the current value. It must
+      /// not block and must not use this registry.
+      public: void SetGauge(const std::string &_name,
+                            const std::string &_help,
+                            std::function<double()> _value);
+
+      /// \brief Add or replace a family of gauges sharing a name, one per
+      /// value of a label, sampled when the metrics are read.
+      /// \param[in] _name Metric name, e.g. "gz_transport_topic_memory_bytes".
+      /// \param[in] _help Description of the gauges.
+      /// \param[in] _label Name of the label, e.g. "topic".
+      /// \param[in] _values Function returning the current value for every
+      /// value of the label. It must not block and must not use this
+      /// registry.
+      public: void SetGaugeFamily(const std::string &_name,
+                  const std::string &_help,
+                  const std::string &_label,
+                  std::function<std::map<std::string, double>()> _values);
+
+      /// \brief Remove a gauge or a family of gauges.
+      /// \param[in] _name Metric name.
+      public: void RemoveGauge(const std::string &_name);
+
+      /// \brief Render all the metrics.
+      /// \return The metrics in the OpenMetrics text format.
+      public: std::string OpenMetrics() const;
+
+      /// \brief Constructor.
+      private: Metrics();
+
+      /// \brief Destructor.
+      private: ~Metrics();
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Private data pointer.
+      private: std::unique_ptr<MetricsPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
@@ -66,6 +66,20 @@ namespace gz
     /// of your login name failes then a string of the form "error-UUID"
     /// is returned where UUID is a universally unique identifier.
     std::string GZ_TRANSPORT_VISIBLE username();
+
+    /// \brief Derive a discovery channel from a partition name, so the
+    /// processes of different partitions don't receive each other's
+    /// discovery traffic. Every process of the partition derives the same
+    /// channel.
+    /// \param[in] _partition The partition name.
+    /// \param[out] _ip Multicast group, in 239.255.0.0/16.
+    /// \param[out] _msgPort UDP port of the message discovery, an even
+    /// number between 20000 and 29998.
+    /// \param[out] _srvPort UDP port of the service discovery, the port
+    /// following _msgPort.
+    void GZ_TRANSPORT_VISIBLE partitionDiscoveryChannel(
+      const std::string &_partition, std::string &_ip, int &_msgPort,
+      int &_srvPort);
     }
   }
 }
@@ -18,22 +18,30 @@
 #define GZ_TRANSPORT_NODE_HH_
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <unordered_set>
 #include <vector>
 
 #include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/CallbackGroupOptions.hh"
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
+#include "gz/transport/Metrics.hh"
 #include "gz/transport/NodeOptions.hh"
 #include "gz/transport/NodeShared.hh"
 #include "gz/transport/Publisher.hh"
 #include "gz/transport/RepHandler.hh"
 #include "gz/transport/ReqHandler.hh"
+#include "gz/transport/SerializationTraits.hh"
+#include "gz/transport/ServiceContext.hh"
 #include "gz/transport/SubscribeOptions.hh"
 #include "gz/transport/SubscriptionHandler.hh"
 #include "gz/transport/TopicStatistics.hh"
@@ -86,6 +94,7 @@ namespace gz
     class GZ_TRANSPORT_VISIBLE Node
     {
       class PublisherPrivate;
+      class BlackboardReaderPrivate;
 
       /// \brief A class that is used to store information about an
       /// advertised publisher. An instance of this class is returned
@@ -137,6 +146,94 @@ namespace gz
         /// \return true when success.
         public: bool Publish(const ProtoMsg &_msg);
 
+        /// \brief Publish a message shared with the caller. The local
+        /// (intraprocess) subscribers receive this same object instead of a
+        /// copy, and the message is only serialized if there are remote or
+        /// raw subscribers or the topic is latched. The message must not be
+        /// modified after this call.
+        /// \param[in] _msg The message.
+        /// \return true when success.
+        public: bool Publish(std::shared_ptr<const ProtoMsg> _msg);
+
+        /// \brief Publish a message handed over by the caller. The local
+        /// subscribers receive this same object instead of a copy.
+        /// \param[in] _msg The message. The publisher takes its ownership.
+        /// \return true when success.
+        /// \sa Publish(std::shared_ptr<const ProtoMsg>)
+        public: template<typename MessageT>
+        bool Publish(std::unique_ptr<MessageT> &&_msg);
+
+        /// \brief Publish a message that isn't a protobuf message. Its type
+        /// must specialize SerializationTraits, and the publisher must be
+        /// advertised with the same type.
+        /// \param[in] _msg The message.
+        /// \return true when success.
+        /// \sa SerializationTraits
+        public: template<typename MessageT, typename = std::enable_if_t<
+                           HasSerializationTraits<MessageT>::value>>
+        bool Publish(const MessageT &_msg);
+
+        /// \brief A writable buffer lent by a publisher. The caller
+        /// serializes a message directly into the buffer and commits it with
+        /// Publish(Loan &). The buffer is shared with the transport, so no
+        /// intermediate serialization buffer or copy is needed, and it is
+        /// recycled by the next LoanBuffer() call once the transport is done
+        /// with it.
+        ///
+        /// ## Pseudo code example ##
+        ///
+        ///    auto loan = pub.LoanBuffer(msg.ByteSizeLong());
+        ///    msg.SerializeToArray(loan.Data(), loan.Size());
+        ///    pub.Publish(loan);
+        public: class GZ_TRANSPORT_VISIBLE Loan
+        {
+          /// \brief Default constructor. The loan is not valid.
+          public: Loan();
+
+          /// \brief Whether the loan holds a buffer.
+          /// \return True if the buffer can be written, false otherwise.
+          public: bool Valid() const;
+
+          /// \brief Get the buffer.
+          /// \return Pointer to the buffer or nullptr if the loan is not
+          /// valid.
+          public: char *Data();
+
+          /// \brief Get the size of the buffer.
+          /// \return The size (bytes) requested in LoanBuffer().
+          public: std::size_t Size() const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::shared_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+          /// \brief The buffer.
+          private: std::shared_ptr<char[]> buffer;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+          /// \brief Size of the buffer.
+          private: std::size_t size = 0;
+
+          friend class Publisher;
+        };
+
+        /// \brief Borrow a buffer to serialize a message in place.
+        /// \param[in] _size Size (bytes) of the serialized message.
+        /// \return The loan. It is not valid if the publisher isn't valid.
+        /// \sa Publish(Loan &)
+        public: Loan LoanBuffer(std::size_t _size);
+
+        /// \brief Publish a message serialized in a loaned buffer. The
+        /// buffer must contain a message of the advertised type. The loan is
+        /// consumed (and becomes invalid) even if the publication fails.
+        /// \param[in, out] _loan A loan obtained with LoanBuffer().
+        /// \return true when success.
+        public: bool Publish(Loan &_loan);
+
         /// \brief Publish a raw pre-serialized message.
         ///
         /// \warning This function is only intended for advanced users. The
@@ -162,6 +259,40 @@ namespace gz
           const std::string &_msgData,
           const std::string &_msgType);
 
+        /// \brief Publish a raw pre-serialized message held in a shared
+        /// buffer, without copying it. The transport keeps a reference to
+        /// the buffer until every subscriber got the message, then releases
+        /// it, e.g. calling the deleter of the buffer. The buffer must not
+        /// be modified until then. This suits messages read from a log or a
+        /// device into memory that can be lent.
+        ///
+        /// \warning See PublishRaw(const std::string &, const std::string &).
+        /// The message is copied anyway if the publisher was advertised with
+        /// a generic message type.
+        ///
+        /// \param[in] _msgData The serialized google::protobuf message.
+        /// \param[in] _size Size (bytes) of the serialized message.
+        /// \param[in] _msgType The message type name.
+        /// \return true when success.
+        public: bool PublishRaw(
+          const std::shared_ptr<const char[]> &_msgData,
+          std::size_t _size,
+          const std::string &_msgType);
+
+        /// \brief Pass a file descriptor, e.g. a DMA-BUF camera frame or a
+        /// GPU buffer, along with a metadata message to the subscribers of
+        /// this host, which import the buffer without any copy. Their
+        /// callbacks receive the message as usual, and the descriptor in
+        /// MessageInfo::Fd(). Subscribers on other hosts don't receive
+        /// these messages. The publisher must be advertised with
+        /// AdvertiseMessageOptions::SetFdPassing().
+        /// \param[in] _msg The metadata message, serialized in at most
+        /// 64 KiB.
+        /// \param[in] _fd The descriptor. The caller keeps its ownership:
+        /// the subscribers receive duplicates of it.
+        /// \return true when success.
+        public: bool PublishFd(const ProtoMsg &_msg, int _fd);
+
         /// \brief Check if message publication is throttled. If so, verify
         /// whether the next message should be published or not.
         ///
@@ -177,10 +308,27 @@ namespace gz
         /// \return true if the message should be published or false otherwise.
         private: bool UpdateThrottling();
 
+        /// \brief Publish a message known to be of the advertised type,
+        /// without checking its type name.
+        /// \param[in] _msg The message.
+        /// \param[in] _owned The same message, shared with the caller, or
+        /// nullptr.
+        /// \return true when success.
+        /// \sa TypedPublisher
+        protected: bool PublishTyped(const ProtoMsg &_msg,
+                                     std::shared_ptr<const ProtoMsg> _owned);
+
         /// \brief Return true if this publisher has subscribers.
         /// \return True if subscribers have connected to this publisher.
         public: bool HasConnections() const;
 
+        /// \brief Get the statistics measured by this publisher: what its
+        /// publications cost in this process. They are all zero if the
+        /// transport metrics are disabled (GZ_TRANSPORT_METRICS=0).
+        /// \return The publisher statistics.
+        /// \sa AdvertiseMessageOptions::SetStatisticsTopic
+        public: PublisherStatistics Statistics() const;
+
         /// \internal
         /// \brief Smart pointer to private data.
         /// This is std::shared_ptr because we want to trigger the destructor
@@ -196,6 +344,127 @@ namespace gz
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
+
+        friend class Node;
+      };
+
+      /// \brief A publisher whose message type is fixed at compile time.
+      /// Its messages can't be of another type, so they are published
+      /// without comparing their type name with the advertised one. It
+      /// can be used wherever a Publisher is expected. E.g.:
+      ///
+      ///    auto pub = node.AdvertiseTyped<msgs::Int32>("/counter");
+      ///    msgs::Int32 msg;
+      ///    pub.Publish(msg);
+      public: template<typename MessageT>
+      class TypedPublisher : public Publisher
+      {
+        static_assert(std::is_base_of_v<ProtoMsg, MessageT>,
+          "The message must be a protobuf message");
+
+        /// \brief Default constructor. The publisher isn't valid.
+        public: TypedPublisher() = default;
+
+        /// \brief Get the name of the message type, computed once.
+        /// \return The type name.
+        public: static const std::string &TypeName();
+
+        /// \brief Publish a message. This function will copy the message
+        /// when publishing to local subscribers.
+        /// \param[in] _msg The message.
+        /// \return true when success.
+        /// \sa Publisher::Publish(const ProtoMsg &)
+        public: bool Publish(const MessageT &_msg);
+
+        /// \brief Publish a message shared with the caller. The local
+        /// subscribers receive this same object. The message must not be
+        /// modified after this call.
+        /// \param[in] _msg The message.
+        /// \return true when success.
+        /// \sa Publisher::Publish(std::shared_ptr<const ProtoMsg>)
+        public: bool Publish(std::shared_ptr<const MessageT> _msg);
+
+        /// \brief Publish a message handed over by the caller. The local
+        /// subscribers receive this same object.
+        /// \param[in] _msg The message. The publisher takes its ownership.
+        /// \return true when success.
+        public: bool Publish(std::unique_ptr<MessageT> &&_msg);
+
+        /// \brief Publish a message serialized in a loaned buffer.
+        /// \param[in, out] _loan A loan obtained with LoanBuffer().
+        /// \return true when success.
+        /// \sa Publisher::Publish(Loan &)
+        public: bool Publish(Loan &_loan);
+
+        /// \brief Constructor.
+        /// \param[in] _publisher Publisher advertised with TypeName().
+        private: explicit TypedPublisher(const Publisher &_publisher);
+
+        friend class Node;
+      };
+
+      /// \brief Reads the latest message of a topic from its blackboard,
+      /// the shared memory segment written by a publisher of this host
+      /// advertised with AdvertiseMessageOptions::SetBlackboard. Nothing is
+      /// sent to the reader: it copies the message when it wants it. E.g.:
+      ///
+      ///    auto reader = node.OpenBlackboard("/pose");
+      ///    msgs::Pose pose;
+      ///    if (reader.Read(pose))
+      ///      ...
+      ///
+      /// The blackboard is opened on the first read, so the reader may be
+      /// created before the publisher. A reader keeps reading the
+      /// blackboard that it opened: create a new one if the publisher
+      /// process restarts. A reader can be used by several threads.
+      public: class GZ_TRANSPORT_VISIBLE BlackboardReader
+      {
+        /// \brief Default constructor. The reader is not valid.
+        public: BlackboardReader();
+
+        /// \brief Destructor.
+        public: ~BlackboardReader();
+
+        /// \brief Whether the reader has a valid topic.
+        /// \return True if Read() can be called.
+        public: bool Valid() const;
+
+        /// \brief Whether a message newer than the last one read has been
+        /// published, which costs no copy.
+        /// \return True if Read() would return a new message.
+        public: bool Updated();
+
+        /// \brief Read the latest message, if it is newer than the last one
+        /// read.
+        /// \param[out] _msg The message. Its type must be the one of the
+        /// topic.
+        /// \return True if a new message was read, false if there is
+        /// nothing new, no blackboard on this host or the type doesn't
+        /// match.
+        public: bool Read(ProtoMsg &_msg);
+
+        /// \brief Read the latest message serialized, if it is newer than
+        /// the last one read.
+        /// \param[out] _data The serialized message.
+        /// \param[out] _msgType The message type.
+        /// \return True if a new message was read.
+        public: bool ReadRaw(std::string &_data, std::string &_msgType);
+
+        /// \internal
+        /// \brief Smart pointer to private data, shared by the copies of
+        /// the reader.
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::shared_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+        private: std::shared_ptr<BlackboardReaderPrivate> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+        friend class Node;
       };
 
       public: Node();
@@ -236,10 +505,60 @@ namespace gz
           const std::string &_msgTypeName,
           const AdvertiseMessageOptions &_options = AdvertiseMessageOptions());
 
+      /// \brief Advertise several topics of the same type at once. The
+      /// topics are registered under a single lock and announced together,
+      /// in as few datagrams as possible when the discovery messages are
+      /// batched (GZ_DISCOVERY_BATCH).
+      /// \param[in] _topics Topic names to be advertised.
+      /// \param[in] _options Advertise options, shared by all the topics.
+      /// \return A publisher for each topic, in the same order. A
+      /// publisher evaluates to false if its topic couldn't be advertised.
+      /// \sa Advertise.
+      public: template<typename MessageT>
+      std::vector<Node::Publisher> AdvertiseMany(
+          const std::vector<std::string> &_topics,
+          const AdvertiseMessageOptions &_options = AdvertiseMessageOptions());
+
+      /// \brief Advertise a new topic with a publisher whose message type
+      /// is fixed at compile time.
+      /// \param[in] _topic Topic name to be advertised.
+      /// \param[in] _options Advertise options.
+      /// \return The publisher, which evaluates to false if the topic
+      /// couldn't be advertised.
+      /// \sa TypedPublisher
+      public: template<typename MessageT>
+      TypedPublisher<MessageT> AdvertiseTyped(
+          const std::string &_topic,
+          const AdvertiseMessageOptions &_options = AdvertiseMessageOptions());
+
+      /// \brief Advertise several topics of the same type at once. The
+      /// topics are registered under a single lock and announced together,
+      /// in as few datagrams as possible when the discovery messages are
+      /// batched (GZ_DISCOVERY_BATCH).
+      /// \param[in] _topics Topic names to be advertised.
+      /// \param[in] _msgTypeName Name of the message type that will be
+      /// published on the topics.
+      /// \param[in] _options Advertise options, shared by all the topics.
+      /// \return A publisher for each topic, in the same order. A
+      /// publisher evaluates to false if its topic couldn't be advertised.
+      /// \sa Advertise.
+      public: std::vector<Node::Publisher> AdvertiseMany(
+          const std::vector<std::string> &_topics,
+          const std::string &_msgTypeName,
+          const AdvertiseMessageOptions &_options = AdvertiseMessageOptions());
+
       /// \brief Get the list of topics advertised by this node.
       /// \return A vector containing all the topics advertised by this node.
       public: std::vector<std::string> AdvertisedTopics() const;
 
+      /// \brief Read the latest messages of a topic from its blackboard,
+      /// without subscribing to it.
+      /// \param[in] _topic Topic name, advertised by a process of this host
+      /// with AdvertiseMessageOptions::SetBlackboard.
+      /// \return The reader, which isn't valid if the topic name is not.
+      /// \sa BlackboardReader
+      public: BlackboardReader OpenBlackboard(const std::string &_topic) const;
+
       /// \brief Subscribe to a topic registering a callback.
       /// Note that this callback does not include any message information.
       /// In this version the callback is a free function.
@@ -318,6 +637,26 @@ namespace gz
                              const MessageInfo &_info)> _callback,
           const SubscribeOptions &_opts = SubscribeOptions());
 
+      /// \brief Subscribe to a topic registering a callback.
+      /// In this version the callback is any callable object (e.g. a
+      /// lambda or a functor), called with the following parameters:
+      ///   * _msg Protobuf message containing a new topic update.
+      ///   * _info Message information (optional).
+      /// The callable is stored by value with its own type, so delivering a
+      /// message doesn't go through a std::function.
+      /// \param[in] _topic Topic to be subscribed.
+      /// \param[in] _callback The callable object.
+      /// \param[in] _opts Subscription options.
+      /// \return true when successfully subscribed or false otherwise.
+      public: template<typename MessageT, typename CallbackT,
+                       typename = std::enable_if_t<
+                         std::is_class_v<std::decay_t<CallbackT>> &&
+                         !IsStdFunction<std::decay_t<CallbackT>>::value>>
+      bool Subscribe(
+          const std::string &_topic,
+          CallbackT &&_callback,
+          const SubscribeOptions &_opts = SubscribeOptions());
+
       /// \brief Subscribe to a topic registering a callback.
       /// Note that this callback includes message information.
       /// In this version the callback is a member function.
@@ -337,6 +676,27 @@ namespace gz
           ClassT *_obj,
           const SubscribeOptions &_opts = SubscribeOptions());
 
+      /// \brief Subscribe to several topics of the same type with the same
+      /// callback. The handlers are registered under a single lock and the
+      /// discovery requests are sent together, in as few datagrams as
+      /// possible when the discovery messages are batched
+      /// (GZ_DISCOVERY_BATCH). The topic of every message is available in
+      /// its MessageInfo.
+      /// \param[in] _topics Topics to be subscribed.
+      /// \param[in] _callback Lambda function with the following parameters:
+      ///   * _msg Protobuf message containing a new topic update.
+      ///   * _info Message information (e.g.: topic name).
+      /// \param[in] _opts Subscription options, shared by all the topics.
+      /// \return true when successfully subscribed to all the topics. No
+      /// topic is subscribed if any of them isn't valid.
+      /// \sa Subscribe.
+      public: template<typename MessageT>
+      bool SubscribeMany(
+          const std::vector<std::string> &_topics,
+          std::function<void(const MessageT &_msg,
+                             const MessageInfo &_info)> _callback,
+          const SubscribeOptions &_opts = SubscribeOptions());
+
       /// \brief Get the list of topics subscribed by this node. Note that
       /// we might be interested in one topic but we still don't know the
       /// address of a publisher.
@@ -509,6 +869,51 @@ namespace gz
           ClassT *_obj,
           const AdvertiseServiceOptions &_options = AdvertiseServiceOptions());
 
+      /// \brief Advertise a new service that processes the requests of a
+      /// batch together (e.g. on a GPU). Single requests are passed as a
+      /// batch of one. The services advertised with a regular callback also
+      /// accept batches, running their requests one by one.
+      /// \param[in] _topic Topic name associated to the service.
+      /// \param[in] _callback Callback to handle the batches with the
+      /// following parameters:
+      ///   * _requests Protobuf messages containing the requests.
+      ///   * _replies Protobuf messages containing the responses, one per
+      ///   request and in the same order.
+      ///   * Returns Service call result, shared by all the requests.
+      /// \param[in] _options Advertise options.
+      /// \return true when the topic has been successfully advertised or
+      /// false otherwise.
+      /// \sa RequestBatch
+      public: template<typename RequestT, typename ReplyT>
+      bool AdvertiseBatch(
+          const std::string &_topic,
+          std::function<bool(const std::vector<RequestT> &_requests,
+                             std::vector<ReplyT> &_replies)> _callback,
+          const AdvertiseServiceOptions &_options = AdvertiseServiceOptions());
+
+      /// \brief Advertise a new service that streams its response in chunks
+      /// (e.g. the rows of a large result). Requesters get the chunks as
+      /// they are emitted, see RequestStream(). The regular requests get all
+      /// the chunks merged (ReplyT::MergeFrom()) in one response.
+      /// \param[in] _topic Topic name associated to the service.
+      /// \param[in] _callback Callback to handle the service request with
+      /// the following parameters:
+      ///   * _request Protobuf message containing the request.
+      ///   * _emit Function sending a chunk of the response. It returns false
+      ///   if the chunk couldn't be sent.
+      ///   * Returns Service call result, sent after the last chunk.
+      /// \param[in] _options Advertise options.
+      /// \return true when the topic has been successfully advertised or
+      /// false otherwise.
+      /// \sa RequestStream
+      public: template<typename RequestT, typename ReplyT>
+      bool AdvertiseStream(
+          const std::string &_topic,
+          std::function<bool(const RequestT &_request,
+            const std::function<bool(const ReplyT &_chunk)> &_emit)>
+              _callback,
+          const AdvertiseServiceOptions &_options = AdvertiseServiceOptions());
+
       /// \brief Get the list of services advertised by this node.
       /// \return A vector containing all services advertised by this node.
       public: std::vector<std::string> AdvertisedServices() const;
@@ -615,6 +1020,162 @@ namespace gz
           void(ClassT::*_callback)(const ReplyT &_reply, const bool _result),
           ClassT *_obj);
 
+      /// \brief Request a new service and get a future of the response.
+      /// The future is completed by the thread receiving the response, so
+      /// many calls can be in flight without dedicating a thread to each of
+      /// them.
+      /// E.g.: auto rep = node.RequestAsync<msgs::Int32>("/echo", req);
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \return A future of the response. It holds no value if the service
+      /// call failed or couldn't be requested. Like the non-blocking
+      /// Request(), there is no timeout: use std::future::wait_for().
+      public: template<typename ReplyT, typename RequestT>
+      std::future<std::optional<ReplyT>> RequestAsync(
+          const std::string &_topic,
+          const RequestT &_request);
+
+      /// \brief Request a new service without input parameter and get a
+      /// future of the response.
+      /// \param[in] _topic Service name requested.
+      /// \return A future of the response. It holds no value if the service
+      /// call failed or couldn't be requested.
+      /// \sa RequestAsync(const std::string &, const RequestT &)
+      public: template<typename ReplyT>
+      std::future<std::optional<ReplyT>> RequestAsync(
+          const std::string &_topic);
+
+      /// \brief A service client prepared by CreateServiceClient(). The
+      /// service name is remapped, validated and qualified once, and its
+      /// balancing policy looked up once, so that a service called at a high
+      /// rate only pays for the call itself. The responders are still found
+      /// on every call, so they can come and go.
+      ///
+      /// The client is a lightweight handle and must not outlive its node.
+      /// E.g.:
+      ///
+      ///    auto client =
+      ///      node.CreateServiceClient<msgs::Int32, msgs::Int32>("/echo");
+      ///    bool result;
+      ///    msgs::Int32 rep;
+      ///    client.Request(req, 1000, rep, result);
+      public: template<typename RequestT, typename ReplyT>
+      class ServiceClient
+      {
+        /// \brief Default constructor. The client isn't valid.
+        public: ServiceClient() = default;
+
+        /// \brief Return true if the client was created for a valid
+        /// service name.
+        /// \return True if the client can be used.
+        public: bool Valid() const;
+
+        /// \brief Allows this class to be evaluated as a boolean.
+        /// \return True if valid.
+        /// \sa Valid
+        public: explicit operator bool() const;
+
+        /// \brief Get the service name, before remapping.
+        /// \return The name given to CreateServiceClient().
+        public: const std::string &Service() const;
+
+        /// \brief Request the service using a blocking call.
+        /// \param[in] _request Protobuf message containing the request's
+        /// parameters.
+        /// \param[in] _timeout The request will timeout after '_timeout' ms.
+        /// \param[out] _reply Protobuf message containing the response.
+        /// \param[out] _result Result of the service call.
+        /// \return true when the request was executed or false if the
+        /// timeout expired or the client isn't valid.
+        /// \sa Node::Request
+        public: bool Request(const RequestT &_request,
+                             const unsigned int _timeout,
+                             ReplyT &_reply,
+                             bool &_result) const;
+
+        /// \brief Request the service using a non-blocking call.
+        /// \param[in] _request Protobuf message containing the request's
+        /// parameters.
+        /// \param[in] _cb Callback executed when the response arrives.
+        /// \return true when the service call was succesfully requested.
+        /// \sa Node::Request
+        public: bool Request(const RequestT &_request,
+                             std::function<void(const ReplyT &_reply,
+                                                const bool _result)> _cb)
+                             const;
+
+        /// \brief Request the service and get a future of the response.
+        /// \param[in] _request Protobuf message containing the request's
+        /// parameters.
+        /// \return A future of the response. It holds no value if the
+        /// service call failed or couldn't be requested.
+        /// \sa Node::RequestAsync
+        public: std::future<std::optional<ReplyT>> RequestAsync(
+                    const RequestT &_request) const;
+
+        /// \brief The node that created the client.
+        private: Node *node = nullptr;
+
+        /// \brief Service name, before remapping.
+        private: std::string topic;
+
+        /// \brief Fully qualified service name, owned by the node.
+        private: const std::string *fullyQualifiedTopic = nullptr;
+
+        /// \brief Balancing policy of the service.
+        private: ServiceBalancing_t balancing = ServiceBalancing_t::FIRST;
+
+        friend class Node;
+      };
+
+      /// \brief Prepare a client of a service, to call it repeatedly
+      /// without resolving its name every time.
+      /// \param[in] _topic Service name.
+      /// \return The client, which is not valid if the name isn't valid.
+      /// \sa ServiceClient
+      public: template<typename RequestT, typename ReplyT>
+      ServiceClient<RequestT, ReplyT> CreateServiceClient(
+          const std::string &_topic);
+
+      /// \brief Request a batch of calls of a service using a blocking call.
+      /// All the requests are sent to one responder in a single message,
+      /// saving a round trip per request.
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _requests Protobuf messages containing the parameters
+      /// of each request.
+      /// \param[in] _timeout The request will timeout after '_timeout' ms.
+      /// \param[out] _replies Protobuf messages containing the responses,
+      /// one per request and in the same order.
+      /// \param[out] _results Result of each service call.
+      /// \return true when the batch was executed or false if it timed out
+      /// (e.g. the responder runs a version without batches).
+      public: template<typename RequestT, typename ReplyT>
+      bool RequestBatch(
+          const std::string &_topic,
+          const std::vector<RequestT> &_requests,
+          const unsigned int &_timeout,
+          std::vector<ReplyT> &_replies,
+          std::vector<bool> &_results);
+
+      /// \brief Request a new service whose response is streamed in chunks,
+      /// using a non-blocking call. The services advertised with a regular
+      /// callback send their response as a single chunk.
+      /// \param[in] _topic Service name requested.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \param[in] _chunkCb Callback executed with each chunk, in order.
+      /// \param[in] _doneCb Callback executed after the last chunk with the
+      /// result of the service call.
+      /// \return true when the service call was succesfully requested.
+      /// \sa AdvertiseStream
+      public: template<typename RequestT, typename ReplyT>
+      bool RequestStream(
+          const std::string &_topic,
+          const RequestT &_request,
+          std::function<void(const ReplyT &_chunk)> _chunkCb,
+          std::function<void(const bool _result)> _doneCb);
+
       /// \brief Request a new service using a blocking call.
       /// \param[in] _topic Service name requested.
       /// \param[in] _request Protobuf message containing the request's
@@ -680,6 +1241,15 @@ namespace gz
       /// \return true if the service was successfully unadvertised.
       public: bool UnadvertiseSrv(const std::string &_topic);
 
+      /// \brief Make the requesters in other processes drop the cached
+      /// responses of an idempotent service advertised by this node (e.g.
+      /// after the robot description changed). The service is advertised
+      /// again.
+      /// \param[in] _topic Service name.
+      /// \return true if the requesters were notified.
+      /// \sa AdvertiseServiceOptions::SetIdempotent
+      public: bool InvalidateServiceCache(const std::string &_topic);
+
       /// \brief Get the list of topics currently advertised in the network.
       /// Note that this function can block for some time if the
       /// discovery is in its initialization phase.
@@ -704,6 +1274,24 @@ namespace gz
                              std::vector<MessagePublisher> &_publishers,
                              std::vector<MessagePublisher> &_subscribers) const;
 
+      /// \brief Get the topic publishers currently known in this node's
+      /// partition and watch the changes. The snapshot and the stream of
+      /// changes are consistent: every change that isn't part of the
+      /// snapshot is notified exactly once, so a monitor can keep the graph
+      /// up to date without discovering it again. A new call replaces the
+      /// previous watch of this node.
+      /// The callback runs on the discovery thread and must not block.
+      /// \param[out] _publishers Publishers known when the function returns.
+      /// Their topics are fully qualified.
+      /// \param[in] _cb Callback executed with every change that follows.
+      /// \return True if the watch was registered.
+      public: bool WatchTopicGraph(std::vector<MessagePublisher> &_publishers,
+                                   const TopicGraphCallback &_cb);
+
+      /// \brief Stop watching the topic graph.
+      /// \return True if this node was watching the topic graph.
+      public: bool UnwatchTopicGraph();
+
       /// \brief Get the list of topics currently advertised in the network.
       /// Note that this function can block for some time if the
       /// discovery is in its initialization phase.
@@ -775,6 +1363,47 @@ namespace gz
       /// \return The relay addresses.
       public: std::vector<std::string> GlobalRelays() const;
 
+      /// \brief Run the oldest callback of this node waiting to be spun,
+      /// on the calling thread. Only the nodes in spin mode wait to be
+      /// spun, see NodeOptions::SetSpinMode().
+      /// \param[in] _timeout Maximum time to wait for a callback.
+      /// \return True if a callback was run, false if none arrived before
+      /// the timeout or if the node isn't in spin mode.
+      public: bool SpinOnce(const std::chrono::milliseconds &_timeout =
+                              std::chrono::milliseconds(0));
+
+      /// \brief Run the callbacks of this node waiting to be spun, on the
+      /// calling thread, without waiting for new ones. The callbacks
+      /// posted while they run wait for the next call.
+      /// \return Number of callbacks run, 0 if the node isn't in spin mode.
+      /// \sa SpinOnce
+      public: std::size_t SpinSome();
+
+      /// \brief Get a file descriptor that is readable while callbacks of
+      /// this node wait to be spun, to wait for them in an existing event
+      /// loop (epoll, asio, libuv...). When it becomes readable, call
+      /// SpinSome(), which doesn't block. Don't read from the file
+      /// descriptor or close it: it stays valid as long as the node.
+      /// \return The file descriptor, or -1 if the node isn't in spin mode
+      /// or the platform doesn't support it (Windows).
+      /// \sa SpinSome
+      public: int SpinFd();
+
+      /// \brief Create a callback group: threads running the callbacks of
+      /// the subscriptions and services of this node assigned to the group,
+      /// see SubscribeOptions::SetCallbackGroup() and
+      /// AdvertiseServiceOptions::SetCallbackGroup(), instead of the threads
+      /// shared by all the nodes. E.g. a controller can run on isolated
+      /// cores with a real-time priority while the logging runs on best
+      /// effort threads. The groups are destroyed with the node. A node in
+      /// spin mode runs all its callbacks when it is spun.
+      /// \param[in] _name Name of the group, unique for this node.
+      /// \param[in] _opts Options of the group.
+      /// \return False if the name is empty or already used.
+      public: bool CreateCallbackGroup(const std::string &_name,
+                                       const CallbackGroupOptions &_opts =
+                                         CallbackGroupOptions());
+
       /// \brief Get a pointer to the shared node (singleton shared by all the
       /// nodes).
       /// \return The pointer to the shared node.
@@ -792,11 +1421,101 @@ namespace gz
       /// \return The set of advertised services.
       private: std::unordered_set<std::string> &SrvsAdvertised() const;
 
+      /// \brief Get the fully qualified name of a topic or service, after
+      /// remapping it with the options of this node. The names are cached
+      /// by the node, so repeated calls, e.g. service requests, don't
+      /// validate and build the name again.
+      /// \param[in] _topic Topic or service name, before remapping.
+      /// \return The fully qualified name, which lives as long as the node,
+      /// or nullptr if the name isn't valid.
+      /// \sa TopicUtils::FullyQualifiedName
+      private: const std::string *FullyQualifiedName(
+                   const std::string &_topic) const;
+
+      /// \brief Non-blocking request of a service whose name is resolved.
+      /// \param[in] _topic Service name, before remapping.
+      /// \param[in] _fullyQualifiedTopic Fully qualified service name.
+      /// \param[in] _balancing Balancing policy of the service.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \param[in] _cb Callback executed when the response arrives.
+      /// \return true when the service call was succesfully requested.
+      private: template<typename RequestT, typename ReplyT>
+      bool RequestResolved(
+          const std::string &_topic,
+          const std::string &_fullyQualifiedTopic,
+          const ServiceBalancing_t _balancing,
+          const RequestT &_request,
+          std::function<void(const ReplyT &_reply, const bool _result)> &_cb);
+
+      /// \brief Blocking request of a service whose name is resolved.
+      /// \param[in] _topic Service name, before remapping.
+      /// \param[in] _fullyQualifiedTopic Fully qualified service name.
+      /// \param[in] _balancing Balancing policy of the service.
+      /// \param[in] _request Protobuf message containing the request's
+      /// parameters.
+      /// \param[in] _timeout The request will timeout after '_timeout' ms.
+      /// \param[out] _reply Protobuf message containing the response.
+      /// \param[out] _result Result of the service call.
+      /// \return true when the request was executed or false if the timeout
+      /// expired.
+      private: template<typename RequestT, typename ReplyT>
+      bool RequestResolved(
+          const std::string &_topic,
+          const std::string &_fullyQualifiedTopic,
+          const ServiceBalancing_t _balancing,
+          const RequestT &_request,
+          const unsigned int _timeout,
+          ReplyT &_reply,
+          bool &_result);
+
       /// \brief Helper function for Subscribe.
       /// \param[in] _fullyQualifiedTopic Fully qualified topic name
       /// \return True on success.
       private: bool SubscribeHelper(const std::string &_fullyQualifiedTopic);
 
+      /// \brief Register a subscription handler. Used by Subscribe.
+      /// \param[in] _topic Topic to be subscribed.
+      /// \param[in] _handler The subscription handler.
+      /// \return True on success.
+      private: bool SubscribeHandler(const std::string &_topic,
+                                     const ISubscriptionHandlerPtr &_handler);
+
+      /// \brief Subscribe to a topic whose type isn't a protobuf message
+      /// but specializes SerializationTraits. Used by Subscribe.
+      /// \param[in] _topic Topic to be subscribed.
+      /// \param[in] _callback Callable object accepting the message and,
+      /// optionally, its information.
+      /// \param[in] _opts Subscription options.
+      /// \return True on success.
+      private: template<typename MessageT, typename CallbackT>
+      bool SubscribeSerialized(
+          const std::string &_topic,
+          CallbackT &&_callback,
+          const SubscribeOptions &_opts);
+
+      /// \brief Register a subscription handler for each topic. Used by
+      /// SubscribeMany.
+      /// \param[in] _topics Topics to be subscribed.
+      /// \param[in] _handlers The subscription handler of every topic.
+      /// \return True on success.
+      private: bool SubscribeHandlers(
+                   const std::vector<std::string> &_topics,
+                   const std::vector<ISubscriptionHandlerPtr> &_handlers);
+
+      /// \brief Advertise a topic. Used by Advertise and AdvertiseMany.
+      /// \param[in] _topic Topic name to be advertised.
+      /// \param[in] _msgTypeName Name of the message type.
+      /// \param[in] _options Advertise options.
+      /// \param[in] _announce False to only register the topic, which the
+      /// caller announces later.
+      /// \return The publisher.
+      private: Node::Publisher AdvertiseHelper(
+                   const std::string &_topic,
+                   const std::string &_msgTypeName,
+                   const AdvertiseMessageOptions &_options,
+                   const bool _announce);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -23,6 +23,7 @@
 
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
+#include "gz/transport/ServiceBalancing.hh"
 
 namespace gz
 {
@@ -126,6 +127,55 @@ namespace gz
       public: bool TopicRemap(const std::string &_fromTopic,
                               std::string &_toTopic) const;
 
+      /// \brief Set how the requests of this node to a service pick a
+      /// responder when several processes advertise it.
+      /// \param[in] _service Service name, as passed to Request().
+      /// \param[in] _policy The balancing policy.
+      /// \return True if the service name is valid or false otherwise.
+      /// \sa ServiceBalancing_t
+      public: bool SetServiceBalancing(const std::string &_service,
+                                       const ServiceBalancing_t _policy);
+
+      /// \brief Get the balancing policy of a service.
+      /// \param[in] _service Service name, as passed to Request().
+      /// \return The balancing policy, ServiceBalancing_t::FIRST unless
+      /// another one was set.
+      public: ServiceBalancing_t ServiceBalancing(
+                const std::string &_service) const;
+
+      /// \brief Set whether the application runs the callbacks of this
+      /// node. In spin mode, the subscription callbacks and the service
+      /// callbacks of the node don't run on the transport threads: they
+      /// wait until the application calls Node::SpinOnce() or
+      /// Node::SpinSome(), and run on the calling thread. This suits
+      /// single threaded loops, e.g. deterministic simulations.
+      /// \param[in] _spin True to enable the spin mode.
+      /// \sa Node::SpinOnce
+      public: void SetSpinMode(const bool _spin);
+
+      /// \brief Get whether the application runs the callbacks of this
+      /// node.
+      /// \return True if the spin mode is enabled. The default is false.
+      /// \sa SetSpinMode
+      public: bool SpinMode() const;
+
+      /// \brief Set the NUMA node of the shared memory segments of the
+      /// topics advertised by this node, e.g. the node of the threads that
+      /// produce or consume them. The segments are allocated there when it
+      /// has free pages. It overrides GZ_TRANSPORT_SHM_NUMA_NODE. Only
+      /// supported on Linux. The internal threads of the transport are
+      /// placed with GZ_TRANSPORT_<KIND>_THREAD_NUMA_NODE and the callbacks
+      /// with CallbackGroupOptions::SetNumaNode().
+      /// \param[in] _node The NUMA node, or -1 (default) for the node set
+      /// by GZ_TRANSPORT_SHM_NUMA_NODE, if any.
+      public: void SetNumaNode(const int _node);
+
+      /// \brief Get the NUMA node of the shared memory segments of the
+      /// topics advertised by this node.
+      /// \return The NUMA node, or -1 if none was set.
+      /// \sa SetNumaNode
+      public: int NumaNode() const;
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
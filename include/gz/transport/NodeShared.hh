@@ -27,9 +27,11 @@
 #pragma warning(pop)
 #endif
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>  //NOLINT
 #include <string>
 #include <thread>
 #include <vector>
@@ -38,6 +40,7 @@
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
 #include "gz/transport/HandlerStorage.hh"
+#include "gz/transport/ReqHandlerStorage.hh"
 #include "gz/transport/Publisher.hh"
 #include "gz/transport/RepHandler.hh"
 #include "gz/transport/ReqHandler.hh"
@@ -91,24 +94,57 @@ namespace gz
                            DeallocFunc *_ffn,
                            const std::string &_msgType);
 
+      /// \brief Publish data.
+      /// \param[in] _topic Topic to be published.
+      /// \param[in, out] _data Serialized data. The buffer is owned by the
+      /// caller until ZeroMQ calls _ffn with _data and _hint.
+      /// \param[in] _dataSize Data size (bytes).
+      /// \param[in, out] _ffn Deallocation function. This function is
+      /// executed by ZeroMQ when the data is published.
+      /// \param[in] _hint Opaque pointer forwarded to _ffn. This can be used
+      /// to release a reference counted buffer shared with other consumers.
+      /// \sa http://zeromq.org/blog:zero-copy
+      /// \param[in] _msgType Message type in string format.
+      /// \return true when success or false otherwise.
+      public: bool Publish(const std::string &_topic,
+                           char *_data,
+                           const size_t _dataSize,
+                           DeallocFunc *_ffn,
+                           void *_hint,
+                           const std::string &_msgType);
+
       /// \brief Method in charge of receiving the topic updates.
       public: void RecvMsgUpdate();
 
+      /// \brief Immutable snapshot of the local handlers subscribed to a
+      /// topic. A new snapshot is built every time a handler of the topic is
+      /// added or removed, so the receive and publish paths only need to
+      /// copy a pointer instead of the handler maps.
+      public: struct TopicHandlers
+      {
+        /// \brief Version of the snapshot. It grows every time the
+        /// handlers of any topic change.
+        public: uint64_t version = 0;
+
+        /// \brief Standard local callback handlers.
+        public: std::vector<ISubscriptionHandlerPtr> normal;
+
+        /// \brief Raw local callback handlers.
+        public: std::vector<RawSubscriptionHandlerPtr> raw;
+      };
+
+      /// \brief Shared pointer to a topic handlers snapshot.
+      public: using TopicHandlersPtr = std::shared_ptr<const TopicHandlers>;
+
       /// \brief HandlerInfo contains information about callback handlers which
       /// is useful for local publishers and message receivers. You should only
       /// retrieve a HandlerInfo by calling
       /// CheckHandlerInfo(const std::string &_topic) const
       public: struct HandlerInfo
       {
-        /// \brief This is a map of the standard local callback handlers. The
-        /// key is the topic name, and the value is another map whose key is
-        /// the node UUID and whose value is a smart pointer to the handler.
-        public: std::map<std::string, ISubscriptionHandler_M> localHandlers;
-
-        /// \brief This is a map of the raw local callback handlers. The key is
-        /// the topic name, and the value is another map whose key is the node
-        /// UUID and whose value is a smart pointer to the handler.
-        public: std::map<std::string, RawSubscriptionHandler_M> rawHandlers;
+        /// \brief Snapshot of the local and raw handlers of the topic. It
+        /// is nullptr if the topic doesn't have local subscribers.
+        public: TopicHandlersPtr handlers;
 
         /// \brief True iff there are any standard local subscribers.
         public: bool haveLocal;
@@ -177,6 +213,32 @@ namespace gz
       /// \brief Method in charge of receiving the service call requests.
       public: void RecvSrvRequest();
 
+      /// \brief Send the response of a service call request.
+      /// \param[in] _sender Address of the requester.
+      /// \param[in] _dstId Socket identity of the requester.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nodeUuid UUID of the requester node.
+      /// \param[in] _reqUuid UUID of the request.
+      /// \param[in] _rep Serialized response.
+      /// \param[in] _result Result of the service call.
+      /// \param[in] _more Whether this is a chunk of a streamed response,
+      /// followed by more chunks.
+      /// \param[in] _envelope Whether the response is sent in a single
+      /// frame, because the request was.
+      public: void SendSrvReply(const std::string &_sender,
+                                const std::string &_dstId,
+                                const std::string &_topic,
+                                const std::string &_nodeUuid,
+                                const std::string &_reqUuid,
+                                const std::string &_rep,
+                                const bool _result,
+                                const bool _more = false,
+                                const bool _envelope = false);
+
+      /// \brief Send the responses of the service calls executed by the
+      /// service workers. Only called by the reception thread.
+      public: void SendPendingSrvReplies();
+
       /// \brief Method in charge of receiving the service call responses.
       public: void RecvSrvResponse();
 
@@ -189,6 +251,50 @@ namespace gz
                                          const std::string &_reqType,
                                          const std::string &_repType);
 
+      /// \brief Send a service call request to a responder, connecting to
+      /// it first if needed.
+      /// \param[in] _responderAddr Address of the responder.
+      /// \param[in] _responderId Socket identity of the responder.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nodeUuid UUID of the requester node.
+      /// \param[in] _reqUuid UUID of the request.
+      /// \param[in] _data Serialized request.
+      /// \param[in] _reqType Type of the request in string format.
+      /// \param[in] _repType Type of the response in string format.
+      /// \param[in] _envelope Whether the request is sent in a single frame.
+      /// Otherwise, each field is sent in its own frame.
+      /// \param[in] _deadline Deadline of the request, sent to the responder
+      /// with the single frame requests, or
+      /// std::chrono::steady_clock::time_point::max() if it has none.
+      public: void SendRemoteReq(const std::string &_responderAddr,
+                                 const std::string &_responderId,
+                                 const std::string &_topic,
+                                 const std::string &_nodeUuid,
+                                 const std::string &_reqUuid,
+                                 const std::string &_data,
+                                 const std::string &_reqType,
+                                 const std::string &_repType,
+                                 const bool _envelope,
+                                 const std::chrono::steady_clock::time_point
+                                   &_deadline);
+
+      /// \brief Send the copies of the hedged requests that are due to
+      /// another responder. Only called by the reception thread.
+      public: void SendHedgedReqs();
+
+      /// \brief Get the cached response of a request to an idempotent
+      /// service in another process.
+      /// \param[in] _topic Fully qualified service name.
+      /// \param[in] _req The request.
+      /// \param[in] _repType Type of the response in string format.
+      /// \param[out] _rep The serialized response.
+      /// \return True if a response is cached and didn't expire.
+      /// \sa AdvertiseServiceOptions::SetIdempotent
+      public: bool CachedResponse(const std::string &_topic,
+                                  const ProtoMsg &_req,
+                                  const std::string &_repType,
+                                  std::string &_rep);
+
       /// \brief Callback executed when the discovery detects new topics.
       /// \param[in] _pub Information of the publisher in charge of the topic.
       public: void OnNewConnection(const MessagePublisher &_pub);
@@ -266,6 +372,35 @@ namespace gz
       /// If your buffer reaches the maximum capacity data will be dropped.
       public: int SndHwm();
 
+      /// \brief Get the number of publications waiting to be delivered to
+      /// local (intra-process) subscribers.
+      /// \return The current depth of the local publication queue.
+      public: std::size_t PubQueueDepth() const;
+
+      /// \brief Get the maximum number of publications that have been
+      /// waiting at the same time to be delivered to local subscribers.
+      /// A value close to the queue capacity (GZ_TRANSPORT_PUB_QUEUE_SIZE)
+      /// means that local callbacks can't keep up with the publishers.
+      /// \return The high-water mark of the local publication queue.
+      public: std::size_t PubQueueHighWaterMark() const;
+
+      /// \brief Get the number of local publications dropped because the
+      /// local publication queue was full.
+      /// \return The number of dropped local publications.
+      public: uint64_t PubQueueDropped() const;
+
+      /// \brief Get the memory held by the local publications waiting to be
+      /// delivered and by the latched messages, see
+      /// GZ_TRANSPORT_MEMORY_BUDGET.
+      /// \return The number of bytes.
+      public: uint64_t MemoryUsage() const;
+
+      /// \brief Get the memory held by the local publications waiting to be
+      /// delivered and by the latched messages of a topic.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The number of bytes.
+      public: uint64_t MemoryUsage(const std::string &_topic) const;
+
       /// \brief Turn topic statistics on or off.
       /// \param[in] _topic The name of the topic on which to enable or disable
       /// statistics.
@@ -284,6 +419,42 @@ namespace gz
       public: std::optional<TopicStatistics> TopicStats(
                   const std::string &_topic) const;
 
+      /// \brief Topic on which the processes that profile their callbacks
+      /// publish the profiles, once per second, as gz.msgs.Metric messages.
+      /// The header data holds the "process_uuid" and every statistics
+      /// group is a CallbackProfile.
+      public: static constexpr const char *kCallbackProfileTopic =
+        "/gz/transport/callback_profile";
+
+      /// \brief Topic on which the processes that advertise topics publish
+      /// the traffic of their publications, once per second and only while
+      /// it has subscribers, as gz.msgs.Metric messages. The header data
+      /// holds the "process_uuid", the header stamp the time of the report,
+      /// and every statistics group named "topic_report" holds the
+      /// fully qualified "topic" in its header data and the "msgs_sent" and
+      /// "bytes_sent" counters of Metrics, since the start of the process.
+      /// The rates are the differences between two reports. The topic lives
+      /// in kTopicReportPartition, so the reports of all the partitions are
+      /// received together and the topic isn't listed with the others. The
+      /// reports are disabled with the metrics, see Metrics.
+      public: static constexpr const char *kTopicReportTopic =
+        "/gz/transport/topic_report";
+
+      /// \brief Partition of kTopicReportTopic.
+      public: static constexpr const char *kTopicReportPartition =
+        "gz_transport";
+
+      /// \brief Turn the profiling of the subscription callbacks of this
+      /// process on or off. Setting GZ_TRANSPORT_CALLBACK_PROFILE to 1
+      /// enables it at startup.
+      /// \param[in] _enable True to measure the callbacks.
+      public: void EnableCallbackProfile(bool _enable);
+
+      /// \brief Get the execution profile of the callbacks of this process.
+      /// \return One profile per subscription handler that ran a callback
+      /// while profiling was enabled.
+      public: std::vector<CallbackProfile> CallbackProfiles() const;
+
       /// \brief Adds a unicast relay IP. All nodes in this process will send
       /// UDP unicast traffic to the address to connect networks when UDP
       /// multicast traffic is not forwarded.
@@ -297,6 +468,14 @@ namespace gz
       /// \return The relay addresses.
       public: std::vector<std::string> GlobalRelays() const;
 
+      /// \brief Create the sockets, the discovery and the threads that talk
+      /// to other processes, unless it's already done. The constructor does
+      /// it, except when GZ_TRANSPORT_LAZY_INIT is set: then the nodes call
+      /// this function before their first operation involving other
+      /// processes.
+      /// \return False if the sockets couldn't be created.
+      public: bool EnsureNetwork();
+
       /// \brief Constructor.
       protected: NodeShared();
 
@@ -308,6 +487,11 @@ namespace gz
       /// return false if any operation on a ZMQ socket triggered an exception.
       private: bool InitializeSockets();
 
+      /// \brief Initialize the sockets and start the discovery and the
+      /// reception threads, see EnsureNetwork().
+      /// \return False if the sockets couldn't be created.
+      private: bool StartNetwork();
+
       //////////////////////////////////////////////////
       /////// Declare here other member variables //////
       //////////////////////////////////////////////////
@@ -364,6 +548,11 @@ namespace gz
       /// handlers: normal (deserialized) and raw (serialized). This wrapper
       /// keeps the two sets of subscription handlers coordinated while allowing
       /// them to act independently when necessary.
+      ///
+      /// The member functions of this struct lock HandlerWrapper::mutex
+      /// internally. Direct accesses to #normal and #raw must hold the mutex
+      /// shared. Handlers must be added and removed with the member
+      /// functions, so the topic snapshots are kept up to date.
       struct HandlerWrapper
       {
         /// \brief Returns true if this wrapper contains any subscriber that
@@ -395,6 +584,29 @@ namespace gz
             const std::string &_fullyQualifiedTopic,
             const std::string &_msgTypeName) const;
 
+        /// \brief Add a normal local subscription handler.
+        /// \param[in] _fullyQualifiedTopic Fully-qualified topic name.
+        /// \param[in] _nUuid Node's unique identifier.
+        /// \param[in] _handler Subscription handler.
+        public: void AddHandler(const std::string &_fullyQualifiedTopic,
+                                const std::string &_nUuid,
+                                const ISubscriptionHandlerPtr &_handler);
+
+        /// \brief Add a raw local subscription handler.
+        /// \param[in] _fullyQualifiedTopic Fully-qualified topic name.
+        /// \param[in] _nUuid Node's unique identifier.
+        /// \param[in] _handler Raw subscription handler.
+        public: void AddHandler(const std::string &_fullyQualifiedTopic,
+                                const std::string &_nUuid,
+                                const RawSubscriptionHandlerPtr &_handler);
+
+        /// \brief Get the current snapshot of the handlers of a topic.
+        /// \param[in] _fullyQualifiedTopic Fully-qualified topic name.
+        /// \return The snapshot or nullptr if the topic doesn't have local
+        /// subscribers.
+        public: TopicHandlersPtr Snapshot(
+            const std::string &_fullyQualifiedTopic) const;
+
         /// \brief Remove the handlers for the given topic name that belong to
         /// a specific node.
         /// \param[in] _fullyQualifiedTopic The fully-qualified name of the
@@ -420,6 +632,24 @@ namespace gz
         /// localSubscriptions allows us to avoid an unnecessary deserialization
         /// followed by an immediate reserialization.
         public: HandlerStorage<RawSubscriptionHandler> raw;
+
+        /// \brief Read-mostly lock protecting #normal and #raw. Handler
+        /// lookups for every published or received message only take it
+        /// shared, so they don't contend with each other nor with the
+        /// discovery and service traffic serialized by NodeShared::mutex.
+        /// When both are needed, NodeShared::mutex must be locked first.
+        public: mutable std::shared_mutex mutex;
+
+        /// \brief Rebuild the snapshot of a topic. The caller must hold
+        /// #mutex exclusively.
+        /// \param[in] _fullyQualifiedTopic Fully-qualified topic name.
+        private: void RefreshSnapshot(const std::string &_fullyQualifiedTopic);
+
+        /// \brief Handler snapshots. The key is the fully-qualified topic.
+        private: std::map<std::string, TopicHandlersPtr> snapshots;
+
+        /// \brief Version of the last snapshot built.
+        private: uint64_t snapshotVersion = 0;
       };
 
       public: HandlerWrapper localSubscribers;
@@ -434,7 +664,7 @@ namespace gz
       public: HandlerStorage<IRepHandler> repliers;
 
       /// \brief Pending service call requests.
-      public: HandlerStorage<IReqHandler> requests;
+      public: ReqHandlerStorage requests;
 
       /// \brief Print activity to stdout.
       public: int verbose;
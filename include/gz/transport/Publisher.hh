@@ -20,12 +20,15 @@
 
 #include <gz/msgs/discovery.pb.h>
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "gz/transport/AdvertiseOptions.hh"
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
+#include "gz/transport/Helpers.hh"
 
 namespace gz
 {
@@ -41,6 +44,10 @@ namespace gz
     /// gz/transport/Publisher.hh
     /// \brief This class stores all the information about a publisher.
     /// It stores the topic name that publishes, addresses, UUIDs, scope, etc.
+    ///
+    /// The strings are interned: the publishers with the same address, UUID
+    /// or type share a single immutable copy of it, so storing and copying
+    /// many publishers only costs a few pointers each.
     class GZ_TRANSPORT_VISIBLE Publisher
     {
       /// \brief Default constructor.
@@ -64,22 +71,22 @@ namespace gz
       /// \brief Get the topic published by this publisher.
       /// \return Topic name.
       /// \sa SetTopic.
-      public: std::string Topic() const;
+      public: const std::string &Topic() const;
 
       /// \brief Get the ZeroMQ address of the publisher.
       /// \return ZeroMQ address.
       /// \sa SetAddr.
-      public: std::string Addr() const;
+      public: const std::string &Addr() const;
 
       /// \brief Get the process UUID of the publisher.
       /// return Process UUID.
       /// \sa SetPUuid.
-      public: std::string PUuid() const;
+      public: const std::string &PUuid() const;
 
       /// \brief Get the node UUID of the publisher.
       /// \return Node UUID.
       /// \sa SetNUuid.
-      public: std::string NUuid() const;
+      public: const std::string &NUuid() const;
 
       /// \brief Get the advertised options.
       /// \return The advertised options.
@@ -151,21 +158,33 @@ namespace gz
 
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
-// std::string
+// std::shared_ptr
 #pragma warning(push)
 #pragma warning(disable: 4251)
 #endif
+      /// \brief Get the shared copy of a string.
+      /// \param[in] _str The string.
+      /// \return The shared copy, or nullptr for an empty string.
+      protected: static std::shared_ptr<const std::string> Intern(
+                   const std::string &_str);
+
+      /// \brief Get the value of an interned string.
+      /// \param[in] _str The interned string.
+      /// \return The value, empty for nullptr.
+      protected: static const std::string &Str(
+                   const std::shared_ptr<const std::string> &_str);
+
       /// \brief Topic name.
-      protected: std::string topic;
+      protected: std::shared_ptr<const std::string> topic;
 
       /// \brief ZeroMQ address of the publisher.
-      protected: std::string addr;
+      protected: std::shared_ptr<const std::string> addr;
 
       /// \brief Process UUID of the publisher.
-      protected: std::string pUuid;
+      protected: std::shared_ptr<const std::string> pUuid;
 
       /// \brief Node UUID of the publisher.
-      protected: std::string nUuid;
+      protected: std::shared_ptr<const std::string> nUuid;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
@@ -206,7 +225,7 @@ namespace gz
       /// subscribers to notify the publisher about the new subscription.
       /// \return ZeroMQ control address of the publisher.
       /// \sa SetCtrl.
-      public: std::string Ctrl() const;
+      public: const std::string &Ctrl() const;
 
       /// \brief Set the ZeroMQ control address of the publisher.
       /// \param[in] _ctrl New control address.
@@ -215,7 +234,7 @@ namespace gz
 
       /// \brief Get the message type advertised by this publisher.
       /// \return Message type.
-      public: std::string MsgTypeName() const;
+      public: const std::string &MsgTypeName() const;
 
       /// \brief Set the message type advertised by this publisher.
       /// \param[in] _msgTypeName New message type.
@@ -232,6 +251,69 @@ namespace gz
       /// \sa Options.
       public: void SetOptions(const AdvertiseMessageOptions &_opts);
 
+      /// \brief Get the maximum rate at which the subscribers of a node
+      /// consume messages. This is only meaningful when this object describes
+      /// the registration of a remote subscriber with a publisher.
+      /// \return The maximum number of messages per second, or kUnthrottled
+      /// if a subscriber of the node is not throttled.
+      /// \sa SetSubscriberMsgsPerSec
+      public: uint64_t SubscriberMsgsPerSec() const;
+
+      /// \brief Set the maximum rate at which the subscribers of a node
+      /// consume messages.
+      /// \param[in] _msgsPerSec Maximum number of messages per second, or
+      /// kUnthrottled.
+      /// \sa SubscriberMsgsPerSec
+      public: void SetSubscriberMsgsPerSec(const uint64_t _msgsPerSec);
+
+      /// \brief Get the content filter of the subscribers of a node. This is
+      /// only meaningful when this object describes the registration of a
+      /// remote subscriber with a publisher.
+      /// \return The filter expression, or an empty string if the node
+      /// wants every message.
+      /// \sa SubscribeOptions::SetFilter
+      public: const std::string &SubscriberFilter() const;
+
+      /// \brief Set the content filter of the subscribers of a node.
+      /// \param[in] _filter The filter expression, or an empty string.
+      /// \sa SubscriberFilter
+      public: void SetSubscriberFilter(const std::string &_filter);
+
+      /// \brief Get the credits of the flow control of the subscribers of a
+      /// node. This is only meaningful when this object describes the
+      /// registration of a remote subscriber with a publisher.
+      /// \return The number of credits, or 0 if a subscriber of the node
+      /// doesn't use the flow control.
+      /// \sa SubscribeOptions::SetCredits
+      public: uint64_t SubscriberCredits() const;
+
+      /// \brief Whether the subscribers of a node with credits want the
+      /// latest message skipped while they had none.
+      /// \return True if the subscribers are conflated.
+      /// \sa SubscribeOptions::SetConflate
+      public: bool SubscriberConflated() const;
+
+      /// \brief Set the flow control of the subscribers of a node.
+      /// \param[in] _credits Number of credits, or 0.
+      /// \param[in] _conflated Whether the subscribers want the latest
+      /// message skipped while they had no credits.
+      /// \sa SubscriberCredits
+      public: void SetSubscriberCredits(const uint64_t _credits,
+                                        const bool _conflated = false);
+
+      /// \brief Get the multicast group where the publisher sends its
+      /// messages, in addition to its address.
+      /// \return The group and port, e.g. "239.255.0.8:11320", or an empty
+      /// string if the topic isn't sent through multicast.
+      /// \sa AdvertiseMessageOptions::SetMulticast
+      public: const std::string &MulticastGroup() const;
+
+      /// \brief Set the multicast group where the publisher sends its
+      /// messages.
+      /// \param[in] _group The group and port, or an empty string.
+      /// \sa MulticastGroup
+      public: void SetMulticastGroup(const std::string &_group);
+
       /// \brief Populate a discovery message.
       /// \param[in] _msg Message to fill.
       public: virtual void FillDiscovery(msgs::Discovery &_msg) const final;
@@ -278,16 +360,32 @@ namespace gz
 #pragma warning(disable: 4251)
 #endif
       /// \brief ZeroMQ control address of the publisher.
-      private: std::string ctrl;
+      private: std::shared_ptr<const std::string> ctrl;
 
       /// \brief Message type advertised by this publisher.
-      private: std::string msgTypeName;
+      private: std::shared_ptr<const std::string> msgTypeName;
+
+      /// \brief Multicast group of the publisher, if any.
+      private: std::shared_ptr<const std::string> multicastGroup;
+
+      /// \brief Content filter of the subscribers of a node, if any.
+      private: std::shared_ptr<const std::string> subscriberFilter;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
 
       /// \brief Advertise options (e.g.: msgsPerSec).
       private: AdvertiseMessageOptions msgOpts;
+
+      /// \brief Maximum rate of the subscribers of a node.
+      private: uint64_t subscriberMsgsPerSec = kUnthrottled;
+
+      /// \brief Credits of the subscribers of a node, or 0.
+      private: uint64_t subscriberCredits = 0;
+
+      /// \brief Whether the subscribers of a node with credits are
+      /// conflated.
+      private: bool subscriberConflated = false;
     };
 
     /// \class ServicePublisher Publisher.hh
@@ -322,7 +420,7 @@ namespace gz
       /// \brief Get the ZeroMQ socket ID used by this publisher.
       /// \return The socket ID.
       /// \sa SetSocketId.
-      public: std::string SocketId() const;
+      public: const std::string &SocketId() const;
 
       /// \brief Set the ZeroMQ socket ID for this publisher.
       /// \param[in] _socketId New socket ID.
@@ -332,12 +430,12 @@ namespace gz
       /// \brief Get the name of the request's protobuf message advertised.
       /// \return The protobuf message type.
       /// \sa SetReqTypeName.
-      public: std::string ReqTypeName() const;
+      public: const std::string &ReqTypeName() const;
 
       /// \brief Get the name of the response's protobuf message advertised.
       /// \return The protobuf message type.
       /// \sa SetRepTypeName.
-      public: std::string RepTypeName() const;
+      public: const std::string &RepTypeName() const;
 
       /// \brief Set the name of the request's protobuf message advertised.
       /// \param[in] _reqTypeName The protobuf message type.
@@ -359,6 +457,19 @@ namespace gz
       /// \sa Options.
       public: void SetOptions(const AdvertiseServiceOptions &_opts);
 
+      /// \brief Whether the responder accepts the requests sent in a single
+      /// frame. Responders that don't advertise it only understand the
+      /// legacy request with one frame per field.
+      /// \return True if the single frame requests are accepted.
+      /// \sa SetEnvelope
+      public: bool Envelope() const;
+
+      /// \brief Set whether the responder accepts the requests sent in a
+      /// single frame.
+      /// \param[in] _envelope True if the single frame requests are accepted.
+      /// \sa Envelope
+      public: void SetEnvelope(const bool _envelope);
+
       /// \brief Populate a discovery message.
       /// \param[in] _msg Message to fill.
       public: virtual void FillDiscovery(msgs::Discovery &_msg) const final;
@@ -408,19 +519,22 @@ namespace gz
 #pragma warning(disable: 4251)
 #endif
       /// \brief ZeroMQ socket ID used by this publisher.
-      private: std::string socketId;
+      private: std::shared_ptr<const std::string> socketId;
 
       /// \brief The name of the request's protobuf message advertised.
-      private: std::string reqTypeName;
+      private: std::shared_ptr<const std::string> reqTypeName;
 
       /// \brief The name of the response's protobuf message advertised.
-      private: std::string repTypeName;
+      private: std::shared_ptr<const std::string> repTypeName;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
 
       /// \brief Advertise options.
       private: AdvertiseServiceOptions srvOpts;
+
+      /// \brief Whether the responder accepts single frame requests.
+      private: bool envelope = true;
     };
     }
   }
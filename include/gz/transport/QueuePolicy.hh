@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_QUEUEPOLICY_HH_
+#define GZ_TRANSPORT_QUEUEPOLICY_HH_
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief This strongly typed enum defines what happens when a bounded
+    /// message queue of a topic is full.
+    /// \sa AdvertiseMessageOptions::SetQueue
+    /// \sa SubscribeOptions::SetQueue
+    enum class QueuePolicy_t
+    {
+      /// \brief Best effort: the oldest queued message is dropped to make
+      /// room for the new one (default).
+      DROP_OLDEST,
+      /// \brief Best effort: the new message is dropped.
+      DROP_NEWEST,
+      /// \brief Keep all: the producer waits until there is room.
+      KEEP_ALL
+    };
+    }
+  }
+}
+#endif
@@ -35,6 +35,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
@@ -68,6 +69,20 @@ namespace gz
       public: virtual bool RunLocalCallback(const transport::ProtoMsg &_msgReq,
                                             transport::ProtoMsg &_msgRep) = 0;
 
+      /// \brief Executes the local callback registered for this handler with
+      /// a request whose response is streamed in chunks.
+      /// \param[in] _msgReq Input parameter (Protobuf message).
+      /// \param[in] _emit Function receiving each chunk (Protobuf message).
+      /// \return Service call result.
+      public: virtual bool RunLocalStreamCallback(
+        const transport::ProtoMsg &/*_msgReq*/,
+        const std::function<bool(const transport::ProtoMsg &)> &/*_emit*/)
+      {
+        std::cerr << "IRepHandler::RunLocalStreamCallback() error: "
+                  << "Not supported" << std::endl;
+        return false;
+      }
+
       /// \brief Executes the callback registered for this handler.
       /// \param[in] _req Serialized data received. The data will be used
       /// to compose a specific protobuf message and will be passed to the
@@ -77,9 +92,40 @@ namespace gz
       public: virtual bool RunCallback(const std::string &_req,
                                        std::string &_rep) = 0;
 
+      /// \brief Executes the callback registered for this handler with a
+      /// request whose response is streamed in chunks. By default, the
+      /// whole response is a single chunk.
+      /// \param[in] _req Serialized request.
+      /// \param[in] _emit Function sending a serialized chunk.
+      /// \return Service call result.
+      public: virtual bool RunStreamCallback(const std::string &_req,
+        const std::function<bool(const std::string &)> &_emit)
+      {
+        std::string rep;
+        if (!this->RunCallback(_req, rep))
+          return false;
+        return _emit(rep);
+      }
+
+      /// \brief Executes the callback registered for this handler with a
+      /// batch of requests. By default, the requests run one by one.
+      /// \param[in] _reqs Serialized requests.
+      /// \param[out] _reps Serialized responses, one per request.
+      /// \param[out] _results Service call result of each request.
+      public: virtual void RunBatchCallback(
+        const std::vector<std::string> &_reqs,
+        std::vector<std::string> &_reps,
+        std::vector<bool> &_results)
+      {
+        _reps.assign(_reqs.size(), std::string());
+        _results.assign(_reqs.size(), false);
+        for (std::size_t i = 0; i < _reqs.size(); ++i)
+          _results[i] = this->RunCallback(_reqs[i], _reps[i]);
+      }
+
       /// \brief Get the unique UUID of this handler.
       /// \return a string representation of the handler UUID.
-      public: std::string HandlerUuid() const
+      public: const std::string &HandlerUuid() const
       {
         return this->hUuid;
       }
@@ -129,32 +175,107 @@ namespace gz
         this->cb = _cb;
       }
 
+      /// \brief Set the batch callback for this handler. It receives all
+      /// the requests of a batch together. Single requests are passed as a
+      /// batch of one when there is no regular callback.
+      /// \param[in] _cb The callback with the following parameters:
+      /// * _reqs Protobuf messages containing the service requests params
+      /// * _reps Protobuf messages containing the service responses, one
+      /// per request.
+      /// * Returns true when the service responses are considered
+      /// successful or false otherwise.
+      public: void SetBatchCallback(
+        const std::function<bool(const std::vector<Req> &,
+                                 std::vector<Rep> &)> &_cb)
+      {
+        this->batchCb = _cb;
+      }
+
+      /// \brief Set the streaming callback for this handler. It sends the
+      /// response of a request in chunks. Requests that are not streamed
+      /// get all the chunks merged (Rep::MergeFrom()) in one response.
+      /// \param[in] _cb The callback with the following parameters:
+      /// * _req Protobuf message containing the service request params
+      /// * _emit Function sending a chunk of the response
+      /// * Returns true when the service response is considered
+      /// successful or false otherwise.
+      public: void SetStreamCallback(
+        const std::function<bool(const Req &,
+          const std::function<bool(const Rep &)> &)> &_cb)
+      {
+        this->streamCb = _cb;
+      }
+
       // Documentation inherited.
       public: bool RunLocalCallback(const transport::ProtoMsg &_msgReq,
                                     transport::ProtoMsg &_msgRep)
       {
         // Execute the callback (if existing)
-        if (!this->cb)
+        if (!this->cb && !this->batchCb && !this->streamCb)
         {
           std::cerr << "RepHandler::RunLocalCallback() error: "
                     << "Callback is NULL" << std::endl;
           return false;
         }
 
-#if GOOGLE_PROTOBUF_VERSION >= 4022000
-        auto msgReq =
-          google::protobuf::internal::DownCast<const Req*>(&_msgReq);
-        auto msgRep = google::protobuf::internal::DownCast<Rep*>(&_msgRep);
-#elif GOOGLE_PROTOBUF_VERSION > 2999999
-        auto msgReq = google::protobuf::down_cast<const Req*>(&_msgReq);
-        auto msgRep = google::protobuf::down_cast<Rep*>(&_msgRep);
-#else
-        auto msgReq =
-          google::protobuf::internal::down_cast<const Req*>(&_msgReq);
-        auto msgRep = google::protobuf::internal::down_cast<Rep*>(&_msgRep);
-#endif
+        // The caller's messages are passed as they are when their C++ types
+        // match, without serialization.
+        auto msgReq = dynamic_cast<const Req *>(&_msgReq);
+        auto msgRep = dynamic_cast<Rep *>(&_msgRep);
+        if (msgReq && msgRep)
+          return this->RunTypedCallback(*msgReq, *msgRep);
+
+        // Messages with the same type name but another C++ type (e.g. a
+        // dynamic message created by RequestRaw()) are serialized.
+        Req req;
+        Rep rep;
+        if (!msgReq)
+        {
+          if (!req.ParseFromString(_msgReq.SerializeAsString()))
+            return false;
+          msgReq = &req;
+        }
+
+        if (msgRep)
+          return this->RunTypedCallback(*msgReq, *msgRep);
+
+        const bool result = this->RunTypedCallback(*msgReq, rep);
+        return _msgRep.ParseFromString(rep.SerializeAsString()) && result;
+      }
+
+      // Documentation inherited.
+      public: bool RunLocalStreamCallback(const transport::ProtoMsg &_msgReq,
+        const std::function<bool(const transport::ProtoMsg &)> &_emit)
+      {
+        if (!this->cb && !this->batchCb && !this->streamCb)
+        {
+          std::cerr << "RepHandler::RunLocalStreamCallback() error: "
+                    << "Callback is NULL" << std::endl;
+          return false;
+        }
+
+        Req req;
+        auto msgReq = dynamic_cast<const Req *>(&_msgReq);
+        if (!msgReq)
+        {
+          if (!req.ParseFromString(_msgReq.SerializeAsString()))
+            return false;
+          msgReq = &req;
+        }
+
+        if (this->streamCb)
+        {
+          return this->streamCb(*msgReq, [&_emit](const Rep &_chunk)
+          {
+            return _emit(_chunk);
+          });
+        }
 
-        return this->cb(*msgReq, *msgRep);
+        // The whole response is a single chunk.
+        Rep rep;
+        if (!this->RunTypedCallback(*msgReq, rep))
+          return false;
+        return _emit(rep);
       }
 
       // Documentation inherited.
@@ -162,7 +283,7 @@ namespace gz
                                std::string &_rep)
       {
         // Check if we have a callback registered.
-        if (!this->cb)
+        if (!this->cb && !this->batchCb && !this->streamCb)
         {
           std::cerr << "RepHandler::RunCallback() error: "
                     << "Callback is NULL" << std::endl;
@@ -177,7 +298,7 @@ namespace gz
         }
 
         Rep msgRep;
-        if (!this->cb(*msgReq, msgRep))
+        if (!this->RunTypedCallback(*msgReq, msgRep))
           return false;
 
         if (!msgRep.SerializeToString(&_rep))
@@ -190,6 +311,75 @@ namespace gz
         return true;
       }
 
+      // Documentation inherited.
+      public: bool RunStreamCallback(const std::string &_req,
+        const std::function<bool(const std::string &)> &_emit)
+      {
+        if (!this->streamCb)
+          return IRepHandler::RunStreamCallback(_req, _emit);
+
+        auto msgReq = this->CreateMsg(_req);
+        std::string data;
+        return this->streamCb(*msgReq, [&_emit, &data](const Rep &_chunk)
+        {
+          if (!_chunk.SerializeToString(&data))
+          {
+            std::cerr << "RepHandler::RunStreamCallback(): Error serializing "
+                      << "a chunk" << std::endl;
+            return false;
+          }
+          return _emit(data);
+        });
+      }
+
+      // Documentation inherited.
+      public: void RunBatchCallback(const std::vector<std::string> &_reqs,
+                                    std::vector<std::string> &_reps,
+                                    std::vector<bool> &_results)
+      {
+        if (!this->batchCb)
+        {
+          IRepHandler::RunBatchCallback(_reqs, _reps, _results);
+          return;
+        }
+
+        _reps.assign(_reqs.size(), std::string());
+        _results.assign(_reqs.size(), false);
+
+        std::vector<Req> msgReqs(_reqs.size());
+        for (std::size_t i = 0; i < _reqs.size(); ++i)
+        {
+          if (!msgReqs[i].ParseFromString(_reqs[i]))
+          {
+            std::cerr << "RepHandler::RunBatchCallback() error: "
+                      << "ParseFromString failed" << std::endl;
+            return;
+          }
+        }
+
+        std::vector<Rep> msgReps;
+        if (!this->batchCb(msgReqs, msgReps))
+          return;
+
+        if (msgReps.size() != msgReqs.size())
+        {
+          std::cerr << "RepHandler::RunBatchCallback() error: "
+                    << msgReps.size() << " responses for " << msgReqs.size()
+                    << " requests" << std::endl;
+          return;
+        }
+
+        for (std::size_t i = 0; i < msgReps.size(); ++i)
+        {
+          _results[i] = msgReps[i].SerializeToString(&_reps[i]);
+          if (!_results[i])
+          {
+            std::cerr << "RepHandler::RunBatchCallback(): Error serializing "
+                      << "the response" << std::endl;
+          }
+        }
+      }
+
       // Documentation inherited.
       public: virtual std::string ReqTypeName() const
       {
@@ -202,6 +392,49 @@ namespace gz
         return Rep().GetTypeName();
       }
 
+      /// \brief Run the batch callback with a single request.
+      /// \param[in] _req The request.
+      /// \param[out] _rep The response.
+      /// \return Service call result.
+      private: bool RunBatchOfOne(const Req &_req, Rep &_rep)
+      {
+        std::vector<Req> reqs(1);
+        reqs[0].CopyFrom(_req);
+        std::vector<Rep> reps;
+        if (!this->batchCb(reqs, reps) || reps.size() != 1u)
+          return false;
+
+        _rep.CopyFrom(reps[0]);
+        return true;
+      }
+
+      /// \brief Run the registered callback with typed messages.
+      /// \param[in] _req The request.
+      /// \param[out] _rep The response.
+      /// \return Service call result.
+      private: bool RunTypedCallback(const Req &_req, Rep &_rep)
+      {
+        if (this->cb)
+          return this->cb(_req, _rep);
+        if (this->batchCb)
+          return this->RunBatchOfOne(_req, _rep);
+        return this->RunMergedStream(_req, _rep);
+      }
+
+      /// \brief Run the streaming callback and merge all the chunks.
+      /// \param[in] _req The request.
+      /// \param[out] _rep The merged response.
+      /// \return Service call result.
+      private: bool RunMergedStream(const Req &_req, Rep &_rep)
+      {
+        _rep.Clear();
+        return this->streamCb(_req, [&_rep](const Rep &_chunk)
+        {
+          _rep.MergeFrom(_chunk);
+          return true;
+        });
+      }
+
       /// \brief Create a specific protobuf message given its serialized data.
       /// \param[in] _data The serialized data.
       /// \return Pointer to the specific protobuf message.
@@ -222,6 +455,14 @@ namespace gz
 
       /// \brief Callback to the function registered for this handler.
       private: std::function<bool(const Req &, Rep &)> cb;
+
+      /// \brief Batch callback registered for this handler.
+      private: std::function<bool(const std::vector<Req> &,
+                                  std::vector<Rep> &)> batchCb;
+
+      /// \brief Streaming callback registered for this handler.
+      private: std::function<bool(const Req &,
+        const std::function<bool(const Rep &)> &)> streamCb;
     };
     }
   }
@@ -27,13 +27,18 @@
 #pragma warning(pop)
 #endif
 
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
+#include "gz/transport/Helpers.hh"
+#include "gz/transport/ServiceBalancing.hh"
 #include "gz/transport/TransportTypes.hh"
 #include "gz/transport/Uuid.hh"
 
@@ -52,7 +57,8 @@ namespace gz
       /// \param[in] _nUuid UUID of the node registering the request handler.
       public: explicit IReqHandler(const std::string &_nUuid)
         : rep(""),
-          hUuid(Uuid().ToString()),
+          id(nextRequestId()),
+          hUuid(std::to_string(id)),
           nUuid(_nUuid),
           result(false),
           requested(false),
@@ -74,7 +80,7 @@ namespace gz
 
       /// \brief Get the node UUID.
       /// \return The string representation of the node UUID.
-      public: std::string NodeUuid() const
+      public: const std::string &NodeUuid() const
       {
         return this->nUuid;
       }
@@ -107,18 +113,102 @@ namespace gz
         this->requested = _value;
       }
 
+      /// \brief Whether this handler carries a batch of requests.
+      /// \return True for a batch.
+      public: virtual bool Batched() const
+      {
+        return false;
+      }
+
+      /// \brief Whether the response of this request is streamed in chunks.
+      /// \return True for a streamed response.
+      public: virtual bool Streamed() const
+      {
+        return false;
+      }
+
+      /// \brief Executes the callback registered for a chunk of a streamed
+      /// response. NotifyResult() is called after the last chunk.
+      /// \param[in] _rep Serialized chunk.
+      public: virtual void NotifyChunk(const std::string &/*_rep*/)
+      {
+      }
+
+      /// \brief Get how this request picks a responder.
+      /// \return The balancing policy.
+      public: ServiceBalancing_t Balancing() const
+      {
+        return this->balancing;
+      }
+
+      /// \brief Set how this request picks a responder.
+      /// \param[in] _policy The balancing policy.
+      public: void SetBalancing(const ServiceBalancing_t _policy)
+      {
+        this->balancing = _policy;
+      }
+
+      /// \brief Get the time that a successful response is cached.
+      /// \return The time to live, or 0 if the response is not cached.
+      public: std::chrono::milliseconds CacheTtl() const
+      {
+        return this->cacheTtl;
+      }
+
+      /// \brief Cache the successful response of this request, because the
+      /// responder is idempotent.
+      /// \param[in] _ttl The time to live of the response.
+      public: void SetCacheTtl(const std::chrono::milliseconds &_ttl)
+      {
+        this->cacheTtl = _ttl;
+      }
+
+      /// \brief Get the deadline of the request, sent to the responder.
+      /// \return The deadline, or std::chrono::steady_clock::time_point::max()
+      /// if the request has none.
+      public: std::chrono::steady_clock::time_point Deadline() const
+      {
+        return this->deadline;
+      }
+
+      /// \brief Set the deadline of the request. The request isn't sent
+      /// once it passed.
+      /// \param[in] _deadline The deadline.
+      public: void SetDeadline(
+        const std::chrono::steady_clock::time_point &_deadline)
+      {
+        this->deadline = _deadline;
+      }
+
+      /// \brief Get the creation time of the request, used to measure its
+      /// latency.
+      /// \return The creation time.
+      public: std::chrono::steady_clock::time_point Created() const
+      {
+        return this->created;
+      }
+
       /// \brief Serialize the Req protobuf message stored.
       /// \param[out] _buffer The serialized data.
       /// \return True if the serialization succeed or false otherwise.
       public: virtual bool Serialize(std::string &_buffer) const = 0;
 
-      /// \brief Returns the unique handler UUID.
+      /// \brief Returns the unique handler UUID. It is the decimal form of
+      /// Id(), sent with the request and echoed in the response.
       /// \return The handler's UUID.
-      public: std::string HandlerUuid() const
+      public: const std::string &HandlerUuid() const
       {
         return this->hUuid;
       }
 
+      /// \brief Returns the identifier of the request, unique within the
+      /// process.
+      /// \return The request identifier.
+      public: uint64_t Id() const
+      {
+        return this->id;
+      }
+
       /// \brief Block the current thread until the response to the
       /// service request is available or until the timeout expires.
       /// This method uses a condition variable to notify when the response is
@@ -130,8 +220,19 @@ namespace gz
                                                     const unsigned int _timeout)
       {
         auto now = std::chrono::steady_clock::now();
-        return this->condition.wait_until(_lock,
-          now + std::chrono::milliseconds(_timeout),
+        return this->WaitUntil(_lock,
+          now + std::chrono::milliseconds(_timeout));
+      }
+
+      /// \brief Block the current thread until the response to the
+      /// service request is available or until a deadline.
+      /// \param[in] _lock Lock used to protect the condition variable.
+      /// \param[in] _deadline Time when to stop waiting.
+      /// \return True if the service call was executed or false otherwise.
+      public: template<typename Lock> bool WaitUntil(Lock &_lock,
+        const std::chrono::steady_clock::time_point &_deadline)
+      {
+        return this->condition.wait_until(_lock, _deadline,
           [this]
           {
             return this->repAvailable;
@@ -159,6 +260,9 @@ namespace gz
       /// \brief Stores the service response as raw bytes.
       protected: std::string rep;
 
+      /// \brief Request identifier.
+      private: uint64_t id;
+
       /// \brief Unique handler's UUID.
       protected: std::string hUuid;
 
@@ -175,6 +279,20 @@ namespace gz
       /// its way. Used to not resend the same REQ more than one time.
       private: bool requested;
 
+      /// \brief How the request picks a responder.
+      private: ServiceBalancing_t balancing = ServiceBalancing_t::FIRST;
+
+      /// \brief Time to live of the cached response.
+      private: std::chrono::milliseconds cacheTtl{0};
+
+      /// \brief Deadline of the request.
+      private: std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();
+
+      /// \brief Creation time of the request.
+      private: std::chrono::steady_clock::time_point created =
+        std::chrono::steady_clock::now();
+
       /// \brief When there is a blocking service call request, the call can
       /// be unlocked when a service call REP is available. This variable
       /// captures if we have found a node that can satisty our request.
@@ -410,6 +528,178 @@ namespace gz
       /// \brief Protobuf message containing the response.
       private: google::protobuf::Message *repMsg = nullptr;
     };
+
+    /// \class BatchReqHandler ReqHandler.hh
+    /// \brief Request handler carrying a batch of requests of the same
+    /// type, sent in a single message. The response contains the response
+    /// and the result of each request, see Node::RequestBatch().
+    template <typename Req, typename Rep> class BatchReqHandler
+      : public IReqHandler
+    {
+      // Documentation inherited.
+      public: explicit BatchReqHandler(const std::string &_nUuid)
+        : IReqHandler(_nUuid)
+      {
+      }
+
+      /// \brief Set the requests of the batch.
+      /// \param[in] _reqMsgs Protobuf messages containing the input
+      /// parameters of each request.
+      /// \return False if a request can't be serialized.
+      public: bool SetMessages(const std::vector<Req> &_reqMsgs)
+      {
+        this->reqData.clear();
+        std::string data;
+        for (const auto &msg : _reqMsgs)
+        {
+          if (!msg.SerializeToString(&data) ||
+              !appendSizePrefixed(this->reqData, data))
+          {
+            std::cerr << "BatchReqHandler::SetMessages(): Error serializing "
+                      << "a request" << std::endl;
+            return false;
+          }
+        }
+        return true;
+      }
+
+      // Documentation inherited
+      public: bool Serialize(std::string &_buffer) const
+      {
+        _buffer = this->reqData;
+        return true;
+      }
+
+      // Documentation inherited.
+      public: void NotifyResult(const std::string &_rep, const bool _result)
+      {
+        this->rep = _rep;
+        this->result = _result;
+        this->repAvailable = true;
+        this->condition.notify_one();
+      }
+
+      // Documentation inherited.
+      public: bool Batched() const
+      {
+        return true;
+      }
+
+      // Documentation inherited.
+      public: virtual std::string ReqTypeName() const
+      {
+        return Req().GetTypeName();
+      }
+
+      // Documentation inherited.
+      public: virtual std::string RepTypeName() const
+      {
+        return Rep().GetTypeName();
+      }
+
+      /// \brief The requests, each one preceded by its size.
+      private: std::string reqData;
+    };
+
+    /// \class StreamReqHandler ReqHandler.hh
+    /// \brief Request handler whose response is streamed in chunks, see
+    /// Node::RequestStream().
+    template <typename Req, typename Rep> class StreamReqHandler
+      : public IReqHandler
+    {
+      // Documentation inherited.
+      public: explicit StreamReqHandler(const std::string &_nUuid)
+        : IReqHandler(_nUuid)
+      {
+      }
+
+      /// \brief Set the REQ protobuf message for this handler.
+      /// \param[in] _reqMsg Protofub message containing the input parameters
+      /// of the service request.
+      public: void SetMessage(const Req &_reqMsg)
+      {
+        this->reqMsg.CopyFrom(_reqMsg);
+      }
+
+      /// \brief Set the callbacks for this handler.
+      /// \param[in] _chunkCb The callback executed with each chunk.
+      /// \param[in] _doneCb The callback executed after the last chunk, with
+      /// the result of the service call.
+      public: void SetCallbacks(
+        const std::function<void(const Rep &_chunk)> &_chunkCb,
+        const std::function<void(const bool _result)> &_doneCb)
+      {
+        this->chunkCb = _chunkCb;
+        this->doneCb = _doneCb;
+      }
+
+      // Documentation inherited
+      public: bool Serialize(std::string &_buffer) const
+      {
+        if (!this->reqMsg.SerializeToString(&_buffer))
+        {
+          std::cerr << "StreamReqHandler::Serialize(): Error serializing the "
+                    << "request" << std::endl;
+          return false;
+        }
+
+        return true;
+      }
+
+      // Documentation inherited.
+      public: void NotifyChunk(const std::string &_rep)
+      {
+        Rep msg;
+        if (!msg.ParseFromString(_rep))
+        {
+          std::cerr << "StreamReqHandler::NotifyChunk() error: "
+                    << "ParseFromString failed" << std::endl;
+          return;
+        }
+
+        if (this->chunkCb)
+          this->chunkCb(msg);
+      }
+
+      // Documentation inherited.
+      public: void NotifyResult(const std::string &/*_rep*/,
+                                const bool _result)
+      {
+        if (this->doneCb)
+          this->doneCb(_result);
+
+        this->result = _result;
+        this->repAvailable = true;
+        this->condition.notify_one();
+      }
+
+      // Documentation inherited.
+      public: bool Streamed() const
+      {
+        return true;
+      }
+
+      // Documentation inherited.
+      public: virtual std::string ReqTypeName() const
+      {
+        return Req().GetTypeName();
+      }
+
+      // Documentation inherited.
+      public: virtual std::string RepTypeName() const
+      {
+        return Rep().GetTypeName();
+      }
+
+      /// \brief Protobuf message containing the request's parameters.
+      private: Req reqMsg;
+
+      /// \brief Callback executed with each chunk.
+      private: std::function<void(const Rep &_chunk)> chunkCb;
+
+      /// \brief Callback executed after the last chunk.
+      private: std::function<void(const bool _result)> doneCb;
+    };
     }
   }
 }
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_REQHANDLERSTORAGE_HH_
+#define GZ_TRANSPORT_REQHANDLERSTORAGE_HH_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/ReqHandler.hh"
+#include "gz/transport/TransportTypes.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \class ReqHandlerStorage ReqHandlerStorage.hh
+    /// gz/transport/ReqHandlerStorage.hh
+    /// \brief Class to store the pending service call requests. The requests
+    /// are kept in a flat hash table keyed by their identifier
+    /// (IReqHandler::Id()), so a response finds its request in constant
+    /// time. The requests that weren't sent yet are also queued per service.
+    class ReqHandlerStorage
+    {
+      /// \brief Constructor.
+      public: ReqHandlerStorage() = default;
+
+      /// \brief Destructor.
+      public: virtual ~ReqHandlerStorage() = default;
+
+      /// \brief Add a request handler to a service.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nUuid Node's unique identifier.
+      /// \param[in] _handler Request handler.
+      public: void AddHandler(const std::string &_topic,
+                              const std::string &_nUuid,
+                              const IReqHandlerPtr &_handler)
+      {
+        auto &entry = this->handlers[_handler->Id()];
+        entry.topic = _topic;
+        entry.nUuid = _nUuid;
+        entry.handler = _handler;
+
+        if (!_handler->Requested())
+          this->unsent[_topic].push_back(_handler);
+      }
+
+      /// \brief Get a request handler.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nUuid Node's unique identifier.
+      /// \param[in] _hUuid Handler UUID (IReqHandler::HandlerUuid()).
+      /// \param[out] _handler Request handler.
+      /// \return True if the handler was found.
+      public: bool Handler(const std::string &_topic,
+                           const std::string &_nUuid,
+                           const std::string &_hUuid,
+                           IReqHandlerPtr &_handler) const
+      {
+        auto it = this->Find(_topic, _nUuid, _hUuid);
+        if (it == this->handlers.end())
+          return false;
+
+        _handler = it->second.handler;
+        return true;
+      }
+
+      /// \brief Get a request handler from its identifier only.
+      /// \param[in] _id Request identifier (IReqHandler::Id()).
+      /// \param[out] _topic Service name.
+      /// \param[out] _nUuid Node's unique identifier.
+      /// \param[out] _handler Request handler.
+      /// \return True if the handler was found.
+      public: bool Handler(const uint64_t _id,
+                           std::string &_topic,
+                           std::string &_nUuid,
+                           IReqHandlerPtr &_handler) const
+      {
+        auto it = this->handlers.find(_id);
+        if (it == this->handlers.end())
+          return false;
+
+        _topic = it->second.topic;
+        _nUuid = it->second.nUuid;
+        _handler = it->second.handler;
+        return true;
+      }
+
+      /// \brief Get the first request handler of a service that wasn't sent
+      /// yet and matches a pair of request/response types.
+      /// \param[in] _topic Service name.
+      /// \param[in] _reqType Type of the request.
+      /// \param[in] _repType Type of the response.
+      /// \param[out] _handler Request handler.
+      /// \return True if a handler was found.
+      public: bool FirstHandler(const std::string &_topic,
+                                const std::string &_reqType,
+                                const std::string &_repType,
+                                IReqHandlerPtr &_handler) const
+      {
+        auto it = this->unsent.find(_topic);
+        if (it == this->unsent.end())
+          return false;
+
+        for (const auto &handler : it->second)
+        {
+          if (handler->ReqTypeName() == _reqType &&
+              handler->RepTypeName() == _repType)
+          {
+            _handler = handler;
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /// \brief Take the request handlers of a service that weren't sent yet
+      /// and match a pair of request/response types. They stay stored until
+      /// they are removed.
+      /// \param[in] _topic Service name.
+      /// \param[in] _reqType Type of the request.
+      /// \param[in] _repType Type of the response.
+      /// \param[out] _handlers Request handlers, in the order they were
+      /// added.
+      /// \return True if at least one handler was taken.
+      public: bool TakeUnsent(const std::string &_topic,
+                              const std::string &_reqType,
+                              const std::string &_repType,
+                              std::vector<IReqHandlerPtr> &_handlers)
+      {
+        _handlers.clear();
+        auto it = this->unsent.find(_topic);
+        if (it == this->unsent.end())
+          return false;
+
+        auto &queue = it->second;
+        auto keep = queue.begin();
+        for (auto &handler : queue)
+        {
+          if (handler->ReqTypeName() == _reqType &&
+              handler->RepTypeName() == _repType)
+          {
+            _handlers.push_back(std::move(handler));
+          }
+          else
+          {
+            *keep++ = std::move(handler);
+          }
+        }
+        queue.erase(keep, queue.end());
+        if (queue.empty())
+          this->unsent.erase(it);
+
+        return !_handlers.empty();
+      }
+
+      /// \brief Return true if we have stored at least one request for the
+      /// service.
+      /// \param[in] _topic Service name.
+      /// \return true if we have stored at least one request for the service.
+      public: bool HasHandlersForTopic(const std::string &_topic) const
+      {
+        for (const auto &entry : this->handlers)
+        {
+          if (entry.second.topic == _topic)
+            return true;
+        }
+        return false;
+      }
+
+      /// \brief Remove a request handler.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nUuid Node's unique identifier.
+      /// \param[in] _reqUuid Request's UUID to remove.
+      /// \return True when the handler is removed or false otherwise.
+      public: bool RemoveHandler(const std::string &_topic,
+                                 const std::string &_nUuid,
+                                 const std::string &_reqUuid)
+      {
+        auto it = this->Find(_topic, _nUuid, _reqUuid);
+        if (it == this->handlers.end())
+          return false;
+
+        // A request that wasn't sent is still queued.
+        auto queueIt = this->unsent.find(_topic);
+        if (queueIt != this->unsent.end())
+        {
+          auto &queue = queueIt->second;
+          queue.erase(std::remove(queue.begin(), queue.end(),
+            it->second.handler), queue.end());
+          if (queue.empty())
+            this->unsent.erase(queueIt);
+        }
+
+        this->handlers.erase(it);
+        return true;
+      }
+
+      /// \brief Number of stored request handlers.
+      /// \return The number of handlers.
+      public: std::size_t Size() const
+      {
+        return this->handlers.size();
+      }
+
+      /// \brief Parse a handler UUID.
+      /// \param[in] _hUuid Handler UUID (IReqHandler::HandlerUuid()).
+      /// \param[out] _id Request identifier.
+      /// \return False if the UUID isn't the decimal form of an identifier.
+      public: static bool ParseId(const std::string &_hUuid, uint64_t &_id)
+      {
+        if (_hUuid.empty() || _hUuid.size() > 20)
+          return false;
+
+        _id = 0;
+        for (char c : _hUuid)
+        {
+          if (c < '0' || c > '9')
+            return false;
+          _id = _id * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return true;
+      }
+
+      /// \brief A stored request handler.
+      private: struct Entry
+      {
+        /// \brief Service name.
+        std::string topic;
+
+        /// \brief Node's unique identifier.
+        std::string nUuid;
+
+        /// \brief Request handler.
+        IReqHandlerPtr handler;
+      };
+
+      /// \brief Find a request handler.
+      /// \param[in] _topic Service name.
+      /// \param[in] _nUuid Node's unique identifier.
+      /// \param[in] _hUuid Handler UUID.
+      /// \return Iterator to the handler or end().
+      private: std::unordered_map<uint64_t, Entry>::const_iterator Find(
+        const std::string &_topic, const std::string &_nUuid,
+        const std::string &_hUuid) const
+      {
+        uint64_t id;
+        if (!ParseId(_hUuid, id))
+          return this->handlers.end();
+
+        auto it = this->handlers.find(id);
+        if (it == this->handlers.end() || it->second.topic != _topic ||
+            it->second.nUuid != _nUuid)
+        {
+          return this->handlers.end();
+        }
+        return it;
+      }
+
+      /// \brief All the stored request handlers. The key is the request
+      /// identifier.
+      private: std::unordered_map<uint64_t, Entry> handlers;
+
+      /// \brief Request handlers that weren't sent yet. The key is the
+      /// service name.
+      private: std::unordered_map<std::string, std::deque<IReqHandlerPtr>>
+        unsent;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_SERIALIZATIONTRAITS_HH_
+#define GZ_TRANSPORT_SERIALIZATIONTRAITS_HH_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Customization point to publish and subscribe to messages that
+    /// are not protobuf messages, e.g. FlatBuffers tables or plain structs.
+    ///
+    /// Node::Advertise<T>(), Node::Publisher::Publish() and
+    /// Node::Subscribe<T>() accept any type 'T' that specializes this
+    /// template with the following static functions:
+    ///
+    ///    // Unique name of the message type.
+    ///    static std::string TypeName();
+    ///    // Serialize a message, replacing the content of the buffer.
+    ///    static bool Serialize(const T &_msg, std::string &_buffer);
+    ///    // Deserialize a message.
+    ///    static bool Deserialize(const char *_data, std::size_t _size,
+    ///                            T &_msg);
+    ///
+    /// The messages travel as raw publications, so they can be recorded
+    /// and relayed, and subscribers of other types don't receive them.
+    /// \sa PodSerializationTraits
+    template <typename T>
+    struct SerializationTraits;
+
+    /// \brief Serialization of trivially copyable types, which are copied
+    /// as is, without any encoding. The publishers and the subscribers must
+    /// share the same memory layout (compiler, architecture and
+    /// endianness). Inherit from it and add the TypeName() function.
+    ///
+    /// ## Pseudo code example ##
+    ///
+    ///    template<>
+    ///    struct gz::transport::SerializationTraits<ImuSample>
+    ///      : gz::transport::PodSerializationTraits<ImuSample>
+    ///    {
+    ///      static std::string TypeName() { return "example.ImuSample"; }
+    ///    };
+    template <typename T>
+    struct PodSerializationTraits
+    {
+      static_assert(std::is_trivially_copyable_v<T>,
+        "The message must be trivially copyable");
+
+      /// \brief Serialize a message.
+      /// \param[in] _msg The message.
+      /// \param[out] _buffer The bytes of the message.
+      /// \return True.
+      static bool Serialize(const T &_msg, std::string &_buffer)
+      {
+        _buffer.assign(reinterpret_cast<const char *>(&_msg), sizeof(T));
+        return true;
+      }
+
+      /// \brief Deserialize a message.
+      /// \param[in] _data The bytes of the message.
+      /// \param[in] _size The number of bytes.
+      /// \param[out] _msg The message.
+      /// \return False if the size isn't the size of the message.
+      static bool Deserialize(const char *_data, std::size_t _size, T &_msg)
+      {
+        if (_size != sizeof(T))
+          return false;
+        std::memcpy(&_msg, _data, sizeof(T));
+        return true;
+      }
+    };
+
+    /// \brief Whether a type specializes SerializationTraits.
+    template <typename T, typename = void>
+    struct HasSerializationTraits : std::false_type {};
+
+    /// \brief Specialization for the types with SerializationTraits.
+    template <typename T>
+    struct HasSerializationTraits<T,
+      std::void_t<decltype(SerializationTraits<T>::TypeName())>>
+      : std::true_type {};
+    }
+  }
+}
+#endif
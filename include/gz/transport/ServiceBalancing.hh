@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_SERVICEBALANCING_HH_
+#define GZ_TRANSPORT_SERVICEBALANCING_HH_
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief This strongly typed enum defines how a service request picks
+    /// a responder when several processes advertise the same service.
+    /// \sa NodeOptions::SetServiceBalancing
+    enum class ServiceBalancing_t
+    {
+      /// \brief Always use the first responder discovered (default).
+      FIRST,
+      /// \brief Use each responder in turn.
+      ROUND_ROBIN,
+      /// \brief Use the responder with the fewest requests of this process
+      /// waiting for a response.
+      LEAST_OUTSTANDING,
+      /// \brief Like LEAST_OUTSTANDING, and send a copy of the request to
+      /// another responder when there is no response after the 95th
+      /// percentile of the recent response times. The first response wins.
+      HEDGED
+    };
+    }
+  }
+}
+#endif
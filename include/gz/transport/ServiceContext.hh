@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_SERVICECONTEXT_HH_
+#define GZ_TRANSPORT_SERVICECONTEXT_HH_
+
+#include <chrono>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \class ServiceContext ServiceContext.hh gz/transport/ServiceContext.hh
+    /// \brief Deadline of the service calls made by the current thread.
+    ///
+    /// While a service callback runs, the deadline of the request that it
+    /// serves is available from Deadline(), similar to the MessageInfo of a
+    /// subscriber. A long running callback can check Expired() and give up
+    /// once the requester doesn't wait anymore.
+    ///
+    /// The requests made by the same thread can't outlive that deadline:
+    /// the timeout of a blocking Node::Request() is shortened to the
+    /// deadline, and the responders of any request receive it. Hence, when
+    /// a service calls another service, which calls a third one, all the
+    /// calls of the chain stop when the first requester gives up.
+    ///
+    /// A ServiceContext object sets a deadline for the current thread
+    /// until it is destroyed, e.g. to bound the total time of several
+    /// requests:
+    /// ~~~{.cpp}
+    /// transport::ServiceContext context(
+    ///   std::chrono::steady_clock::now() + std::chrono::milliseconds(500));
+    /// node.Request("/a", req, 1000, rep, result);
+    /// node.Request("/b", req, 1000, rep, result);
+    /// ~~~
+    class GZ_TRANSPORT_VISIBLE ServiceContext
+    {
+      /// \brief Set the deadline of the current thread. The deadline can
+      /// only get earlier: a later deadline than the current one is ignored.
+      /// \param[in] _deadline The deadline.
+      public: explicit ServiceContext(
+        const std::chrono::steady_clock::time_point &_deadline);
+
+      /// \brief Destructor. Restores the previous deadline.
+      public: ~ServiceContext();
+
+      /// \brief No copy.
+      public: ServiceContext(const ServiceContext &) = delete;
+
+      /// \brief No assignment.
+      public: ServiceContext &operator=(const ServiceContext &) = delete;
+
+      /// \brief Get the deadline of the current thread.
+      /// \return The deadline, or std::chrono::steady_clock::time_point::max()
+      /// if there is none.
+      public: static std::chrono::steady_clock::time_point Deadline();
+
+      /// \brief Get the deadline of a request made by the current thread.
+      /// \param[in] _timeout Timeout of the request (milliseconds).
+      /// \return The earliest of the deadline of the thread and the end of
+      /// the timeout.
+      public: static std::chrono::steady_clock::time_point Deadline(
+        const unsigned int _timeout);
+
+      /// \brief Whether the deadline of the current thread passed.
+      /// \return True if the deadline passed.
+      public: static bool Expired();
+
+      /// \brief Get the time left before the deadline of the current thread.
+      /// \return The remaining time, zero if the deadline passed, or
+      /// std::chrono::milliseconds::max() if there is no deadline.
+      public: static std::chrono::milliseconds Remaining();
+
+      /// \brief Deadline of the thread before this object was created.
+      private: std::chrono::steady_clock::time_point previous;
+    };
+    }
+  }
+}
+#endif
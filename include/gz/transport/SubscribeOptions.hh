@@ -20,9 +20,12 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
+#include "gz/transport/QueuePolicy.hh"
 
 namespace gz
 {
@@ -31,6 +34,7 @@ namespace gz
     // Inline bracket to help doxygen filtering.
     inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
     //
+    class Clock;
     class SubscribeOptionsPrivate;
 
     /// \class SubscribeOptions SubscribeOptions.hh
@@ -66,6 +70,25 @@ namespace gz
       /// \return The maximum number of messages per second.
       public: uint64_t MsgsPerSec() const;
 
+      /// \brief Measure the throttling period with a clock instead of the
+      /// steady clock of the system, e.g. with a NetworkClock following the
+      /// time of a simulation. The rate set with SetMsgsPerSec() is then
+      /// expressed in the time of the clock: a simulation running faster
+      /// than real time delivers more messages per wall second, and a
+      /// paused simulation delivers none after the first. When the clock
+      /// goes back, e.g. when the simulation is reset, the next message is
+      /// delivered. Until the clock is ready, the steady clock is used.
+      /// The publishers of other processes don't skip messages for such a
+      /// subscription, since they don't know its clock.
+      /// \param[in] _clock The clock, or nullptr for the steady clock.
+      /// \sa ThrottleClock
+      public: void SetThrottleClock(std::shared_ptr<const Clock> _clock);
+
+      /// \brief Get the clock of the throttling.
+      /// \return The clock, or nullptr if the steady clock is used.
+      /// \sa SetThrottleClock
+      public: const std::shared_ptr<const Clock> &ThrottleClock() const;
+
       /// \brief Set the value to ignore local messages or not.
       /// \param[in] _ignore True when ignoring local messages
       /// or false otherwise.
@@ -78,6 +101,171 @@ namespace gz
       /// \sa SetIgnoreLocalMessages
       public: bool IgnoreLocalMessages() const;
 
+      /// \brief Set whether received messages are deserialized into a
+      /// protobuf arena. The arenas are drawn from a pool owned by the
+      /// subscription and recycled once the callbacks have completed, which
+      /// saves most of the allocations of large nested messages. The message
+      /// passed to the callback must not be retained after it returns.
+      /// \param[in] _useArena True to deserialize into an arena.
+      /// \sa UseArena
+      public: void SetUseArena(bool _useArena);
+
+      /// \brief Whether received messages are deserialized into an arena.
+      /// \return True when an arena is used or false otherwise.
+      /// \sa SetUseArena
+      public: bool UseArena() const;
+
+      /// \brief Set whether received messages are deserialized into
+      /// recycled message objects. Typed subscriptions keep a small pool of
+      /// messages, which are cleared and parsed again, keeping the capacity
+      /// of their strings and repeated fields. High rate topics are then
+      /// received without allocations once the pool is warm. The message
+      /// passed to the callback must not be retained after it returns. Arenas
+      /// take precedence over this option, and subscriptions to generic
+      /// messages ignore it.
+      /// \param[in] _reuse True to reuse the message objects.
+      /// \sa ReuseMessages
+      /// \sa SetUseArena
+      public: void SetReuseMessages(bool _reuse);
+
+      /// \brief Whether received messages are deserialized into recycled
+      /// message objects.
+      /// \return True when the messages are reused or false otherwise.
+      /// \sa SetReuseMessages
+      public: bool ReuseMessages() const;
+
+      /// \brief Set the fields of the messages that the subscription uses.
+      /// Messages received from other processes are scanned without
+      /// parsing them and only the fields of the mask are parsed, so large
+      /// fields that the callback doesn't read, e.g. the data of an image,
+      /// are never copied. The other fields of the message passed to the
+      /// callback are left empty. Messages published in the same process
+      /// are delivered as usual.
+      /// \param[in] _paths Paths of the fields to parse. A path is a list of
+      /// field names separated by dots, e.g. "header.stamp". Unknown
+      /// fields are ignored. An empty mask parses the whole message.
+      /// \sa FieldMask
+      public: void SetFieldMask(const std::vector<std::string> &_paths);
+
+      /// \brief Get the fields of the messages that the subscription uses.
+      /// \return The paths of the fields, or an empty vector if the whole
+      /// messages are parsed.
+      /// \sa SetFieldMask
+      public: const std::vector<std::string> &FieldMask() const;
+
+      /// \brief Set a predicate over the fields of the messages. The
+      /// callback only receives the messages matching it. The expression is
+      /// sent to the publishers of other processes, which don't send a
+      /// message that no remote subscriber of the topic wants, so those
+      /// messages never cross the network. Example:
+      /// "confidence > 0.8 && header.frame_id == 'camera'".
+      ///
+      /// The fields are names separated by dots, compared with ==, !=, <,
+      /// <=, > or >= to a number, a string between quotes, true, false or
+      /// the name of an enum value. The comparisons are combined with &&,
+      /// || and ! and grouped with parentheses. A comparison through a
+      /// repeated field holds if it holds for any element. Raw
+      /// subscriptions ignore the filter. When the subscription also has a
+      /// field mask, the mask must include the fields of the filter.
+      /// \param[in] _expression The expression, or an empty string to
+      /// receive every message.
+      /// \sa Filter
+      public: void SetFilter(const std::string &_expression);
+
+      /// \brief Get the predicate over the fields of the messages.
+      /// \return The expression, or an empty string if there is no filter.
+      /// \sa SetFilter
+      public: const std::string &Filter() const;
+
+      /// \brief Set whether the subscription only delivers the latest
+      /// message (conflation). Messages received from other processes are
+      /// stored in a single-slot mailbox that is overwritten by newer
+      /// arrivals, and the callback runs in a separate thread with the most
+      /// recent message whenever it is ready. Superseded messages are never
+      /// deserialized. This is useful for subscribers that only care about
+      /// the current value, e.g. GUIs. Messages published in the same
+      /// process are delivered as usual.
+      /// \param[in] _conflate True to deliver only the latest message.
+      /// \sa Conflate
+      public: void SetConflate(bool _conflate);
+
+      /// \brief Whether the subscription only delivers the latest message.
+      /// \return True when the subscription is conflated or false otherwise.
+      /// \sa SetConflate
+      public: bool Conflate() const;
+
+      /// \brief Whether the messages received from other processes wait in
+      /// a bounded queue of the subscription.
+      /// \return True when the queue depth is greater than zero.
+      /// \sa SetQueue
+      public: bool Queued() const;
+
+      /// \brief Get the maximum number of messages waiting for the callback.
+      /// \return The queue depth, or 0 if the messages are not queued.
+      /// \sa SetQueue
+      public: uint64_t QueueDepth() const;
+
+      /// \brief Get what happens when the queue of the subscription is full.
+      /// \return The queue policy.
+      /// \sa SetQueue
+      public: QueuePolicy_t QueuePolicy() const;
+
+      /// \brief Give the subscription its own bounded queue. Messages
+      /// received from other processes are stored in the queue and the
+      /// callback runs in a separate thread, so a slow callback doesn't
+      /// delay the other topics received by the process. When the queue is
+      /// full, the oldest or the newest message is dropped, or the
+      /// reception waits for room (QueuePolicy_t::KEEP_ALL). Dropped
+      /// messages are counted in the topic statistics. Messages published
+      /// in the same process are delivered as usual. Conflation takes
+      /// precedence over this option.
+      /// \param[in] _depth Maximum number of queued messages. The default
+      /// value (0) disables the queue.
+      /// \param[in] _policy What happens when the queue is full.
+      /// \sa SetConflate
+      public: void SetQueue(const uint64_t _depth,
+                            const QueuePolicy_t _policy =
+                              QueuePolicy_t::DROP_OLDEST);
+
+      /// \brief Get the credits of the flow control of the subscription.
+      /// \return The number of credits, or 0 if the flow control is
+      /// disabled.
+      /// \sa SetCredits
+      public: uint64_t Credits() const;
+
+      /// \brief Enable the credit-based flow control of the messages
+      /// received from other processes. The publishers of the topic send at
+      /// most _credits messages ahead of those that this process has taken
+      /// out of its reception queue, which it acknowledges as it goes.
+      /// When a subscriber can't keep up, the publishers skip the
+      /// serialization and the sending of the messages instead of piling
+      /// them up in the queues of ZeroMQ, where they would be dropped
+      /// silently (GZ_TRANSPORT_RCVHWM). A conflated subscription receives
+      /// the latest message skipped as soon as it catches up.
+      ///
+      /// The publishers send a message while any subscriber process has
+      /// credits, and only if every remote subscriber of the topic uses the
+      /// flow control. The credits should stay below the high water marks
+      /// of ZeroMQ.
+      /// \param[in] _credits Maximum number of messages in flight. The
+      /// default value (0) disables the flow control.
+      /// \sa SetConflate
+      public: void SetCredits(const uint64_t _credits);
+
+      /// \brief Get the callback group of the subscription.
+      /// \return The name of the group, or an empty string if the callbacks
+      /// run on the threads shared by all the nodes.
+      /// \sa SetCallbackGroup
+      public: const std::string &CallbackGroup() const;
+
+      /// \brief Run the callbacks of the subscription on the threads of a
+      /// callback group of the subscribing node, see
+      /// Node::CreateCallbackGroup(). If the node has no such group, the
+      /// callbacks run on the threads shared by all the nodes.
+      /// \param[in] _group The name of the group. The default (empty) uses
+      /// the shared threads.
+      public: void SetCallbackGroup(const std::string &_group);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
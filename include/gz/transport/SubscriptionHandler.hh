@@ -31,17 +31,24 @@
 #pragma warning(pop)
 #endif
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include <gz/msgs/Factory.hh>
 
+#include "gz/transport/ArenaPool.hh"
 #include "gz/transport/config.hh"
 #include "gz/transport/Export.hh"
 #include "gz/transport/MessageInfo.hh"
+#include "gz/transport/MessagePool.hh"
 #include "gz/transport/SubscribeOptions.hh"
 #include "gz/transport/TransportTypes.hh"
 #include "gz/transport/Uuid.hh"
@@ -53,6 +60,10 @@ namespace gz
     // Inline bracket to help doxygen filtering.
     inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
     //
+    class ContentFilter;
+    class FieldFilter;
+    class SubscriptionQueue;
+
     /// \brief SubscriptionHandlerBase contains functions and data which are
     /// common to all SubscriptionHandler types.
     class GZ_TRANSPORT_VISIBLE SubscriptionHandlerBase
@@ -74,16 +85,91 @@ namespace gz
 
       /// \brief Get the node UUID.
       /// \return The string representation of the node UUID.
-      public: std::string NodeUuid() const;
+      public: const std::string &NodeUuid() const;
 
       /// \brief Get the unique UUID of this handler.
       /// \return A string representation of the handler UUID.
-      public: std::string HandlerUuid() const;
+      public: const std::string &HandlerUuid() const;
+
+      /// \brief Get the callback group of the subscription.
+      /// \return The name of the group, or an empty string.
+      /// \sa SubscribeOptions::SetCallbackGroup
+      public: const std::string &CallbackGroup() const;
 
       /// \brief Return whether local messages are ignored or not.
       /// \return True when local messages are ignored or false otherwise.
       public: bool IgnoreLocalMessages() const;
 
+      /// \brief Get the predicate over the fields of the messages.
+      /// \return The expression, or an empty string if there is no filter.
+      /// \sa SubscribeOptions::SetFilter
+      public: const std::string &Filter() const;
+
+      /// \brief Get the maximum number of messages per second delivered to
+      /// the callback.
+      /// \return The maximum rate, or kUnthrottled if the subscription is
+      /// not throttled or if it is throttled with its own clock.
+      /// \sa SubscribeOptions::SetMsgsPerSec
+      /// \sa SubscribeOptions::SetThrottleClock
+      public: uint64_t MsgsPerSec() const;
+
+      /// \brief Whether the subscription only delivers the latest message.
+      /// \return True when the subscription is conflated.
+      /// \sa SubscribeOptions::SetConflate
+      public: bool Conflated() const;
+
+      /// \brief Get the credits of the flow control of the subscription.
+      /// \return The number of credits, or 0 if the flow control is
+      /// disabled.
+      /// \sa SubscribeOptions::SetCredits
+      public: uint64_t Credits() const;
+
+      /// \brief Whether the messages received from other processes wait in
+      /// the queue of the subscription, i.e. the subscription is conflated
+      /// or queued.
+      /// \return True when the subscription has a queue.
+      /// \sa SubscribeOptions::SetQueue
+      public: bool Queued() const;
+
+      /// \brief Store a message in the queue of the subscription. When the
+      /// queue is full, a message is dropped or the caller waits for room,
+      /// depending on the queue policy. A conflated subscription replaces
+      /// the message that is still waiting for the callback, if any.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _info Message information.
+      /// \param[in] _abort Flag checked while waiting for room. The message
+      /// is dropped if it becomes true.
+      /// \param[out] _dropped True if a message was dropped.
+      /// \return True if the queue was empty, i.e. the caller has to
+      /// schedule a delivery.
+      public: bool Enqueue(const std::string &_data,
+                           const MessageInfo &_info,
+                           const std::atomic<bool> &_abort,
+                           bool &_dropped);
+
+      /// \brief Take the oldest message stored in the queue of the
+      /// subscription.
+      /// \param[out] _data Serialized message.
+      /// \param[out] _info Message information.
+      /// \return False if the queue is empty.
+      public: bool Dequeue(std::string &_data, MessageInfo &_info);
+
+      /// \brief Whether the handler is still subscribed. The messages
+      /// already on their way to a handler are discarded once it's
+      /// detached.
+      /// \return False after Detach().
+      public: bool Alive() const;
+
+      /// \brief Stop delivering messages to the handler, e.g. because its
+      /// node unsubscribed from the topic.
+      public: void Detach();
+
+      /// \brief Number of messages dropped by the queue of the subscription,
+      /// including the messages of a conflated subscription replaced by a
+      /// newer one before reaching the callback.
+      /// \return The number of dropped messages.
+      public: uint64_t DroppedCount() const;
+
       /// \brief Check if message subscription is throttled. If so, verify
       /// whether the callback should be executed or not.
       /// \return true if the callback should be executed or false otherwise.
@@ -108,8 +194,18 @@ namespace gz
       /// \brief Timestamp of the last callback executed.
       protected: Timestamp lastCbTimestamp;
 
+      /// \brief Time of the throttling clock at the last callback executed,
+      /// or a negative value before the first one.
+      private: std::chrono::nanoseconds lastClockTime{-1};
+
       /// \brief Node UUID.
       private: std::string nUuid;
+
+      /// \brief Queue of a conflated or queued subscription, or nullptr.
+      private: std::shared_ptr<SubscriptionQueue> queue;
+
+      /// \brief False once the handler is detached.
+      private: std::atomic<bool> alive{true};
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
@@ -151,6 +247,44 @@ namespace gz
       public: virtual const std::shared_ptr<ProtoMsg> CreateMsg(
         const std::string &_data,
         const std::string &_type) const = 0;
+
+      /// \brief Parse a serialized message, keeping only the fields of the
+      /// field mask of the subscription, if any.
+      /// \param[in] _data The serialized data.
+      /// \param[out] _msg The message.
+      /// \return True if the message was parsed.
+      /// \sa SubscribeOptions::SetFieldMask
+      protected: bool ParseMsg(const std::string &_data,
+                               ProtoMsg &_msg) const;
+
+      /// \brief Check the filter of the subscription.
+      /// \param[in] _msg The message.
+      /// \return True if the callback has to receive the message.
+      /// \sa SubscribeOptions::SetFilter
+      protected: bool Accept(const ProtoMsg &_msg) const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::shared_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Pool of arenas used to deserialize messages when the
+      /// subscription uses arenas, or nullptr otherwise.
+      /// \sa SubscribeOptions::SetUseArena
+      protected: std::shared_ptr<ArenaPool> arenaPool;
+
+      /// \brief Filter of the fields parsed when the subscription has a
+      /// field mask, or nullptr otherwise.
+      /// \sa SubscribeOptions::SetFieldMask
+      private: std::shared_ptr<FieldFilter> fieldFilter;
+
+      /// \brief Filter of the messages delivered, or nullptr.
+      /// \sa SubscribeOptions::SetFilter
+      private: std::shared_ptr<ContentFilter> contentFilter;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
     };
 
     /// \class SubscriptionHandler SubscriptionHandler.hh
@@ -165,6 +299,8 @@ namespace gz
         const SubscribeOptions &_opts = SubscribeOptions())
         : ISubscriptionHandler(_nUuid, _opts)
       {
+        if (_opts.ReuseMessages() && !this->arenaPool)
+          this->msgPool = std::make_shared<MessagePool<T>>();
       }
 
       // Documentation inherited.
@@ -172,11 +308,44 @@ namespace gz
         const std::string &_data,
         const std::string &/*_type*/) const
       {
+        // Parse into a recycled message, which keeps the capacity of its
+        // strings and repeated fields.
+        if (this->msgPool)
+        {
+          auto msg = this->msgPool->Acquire();
+          if (!this->ParseMsg(_data, *msg))
+          {
+            std::cerr << "SubscriptionHandler::CreateMsg() error: "
+                      << "ParseFromString failed" << std::endl;
+          }
+
+          return msg;
+        }
+
+        // Deserialize into a pooled arena. The message keeps the arena
+        // alive and the arena returns to the pool with the last reference.
+        if (this->arenaPool)
+        {
+          auto arena = this->arenaPool->Acquire();
+#if GOOGLE_PROTOBUF_VERSION >= 4022000
+          T *msg = google::protobuf::Arena::Create<T>(arena.get());
+#else
+          T *msg = google::protobuf::Arena::CreateMessage<T>(arena.get());
+#endif
+          if (!this->ParseMsg(_data, *msg))
+          {
+            std::cerr << "SubscriptionHandler::CreateMsg() error: "
+                      << "ParseFromString failed" << std::endl;
+          }
+
+          return std::shared_ptr<ProtoMsg>(arena, msg);
+        }
+
         // Instantiate a specific protobuf message
         auto msgPtr = std::make_shared<T>();
 
         // Create the message using some serialized data
-        if (!msgPtr->ParseFromString(_data))
+        if (!this->ParseMsg(_data, *msgPtr))
         {
           std::cerr << "SubscriptionHandler::CreateMsg() error: ParseFromString"
                     << " failed" << std::endl;
@@ -188,7 +357,9 @@ namespace gz
       // Documentation inherited.
       public: std::string TypeName()
       {
-        return T().GetTypeName();
+        // Computed once, this is queried for every received message.
+        static const std::string typeName = T().GetTypeName();
+        return typeName;
       }
 
       /// \brief Set the callback for this handler.
@@ -210,8 +381,8 @@ namespace gz
           return false;
         }
 
-        // Check the subscription throttling option.
-        if (!this->UpdateThrottling())
+        // Check the filter and the subscription throttling option.
+        if (!this->Accept(_msg) || !this->UpdateThrottling())
           return true;
 
 #if GOOGLE_PROTOBUF_VERSION >= 4022000
@@ -228,6 +399,11 @@ namespace gz
 
       /// \brief Callback to the function registered for this handler.
       private: MsgCallback<T> cb;
+
+      /// \brief Pool of recycled messages when the subscription reuses
+      /// them, or nullptr otherwise.
+      /// \sa SubscribeOptions::SetReuseMessages
+      private: std::shared_ptr<MessagePool<T>> msgPool;
     };
 
     /// \brief Specialized template when the user prefers a callbacks that
@@ -249,28 +425,25 @@ namespace gz
       {
         std::shared_ptr<google::protobuf::Message> msgPtr;
 
-        const google::protobuf::Descriptor *desc =
-          google::protobuf::DescriptorPool::generated_pool()
-            ->FindMessageTypeByName(_type);
-
-        // First, check if we have the descriptor from the generated proto
-        // classes.
-        if (desc)
+        const std::shared_ptr<const ProtoMsg> prototype =
+          this->Prototype(_type);
+        if (prototype && this->arenaPool)
         {
-          msgPtr.reset(google::protobuf::MessageFactory::generated_factory()
-            ->GetPrototype(desc)->New());
+          // The message keeps its pooled arena alive.
+          auto arena = this->arenaPool->Acquire();
+          msgPtr = std::shared_ptr<ProtoMsg>(arena,
+            prototype->New(arena.get()));
         }
-        else
+        else if (prototype)
         {
-          // Fallback on Gazebo Msgs if the message type is not found.
-          msgPtr = gz::msgs::Factory::New(_type);
+          msgPtr.reset(prototype->New());
         }
 
         if (!msgPtr)
           return nullptr;
 
         // Create the message using some serialized data
-        if (!msgPtr->ParseFromString(_data))
+        if (!this->ParseMsg(_data, *msgPtr))
         {
           std::cerr << "CreateMsg() error: ParseFromString failed" << std::endl;
           return nullptr;
@@ -304,16 +477,139 @@ namespace gz
           return false;
         }
 
-        // Check the subscription throttling option.
-        if (!this->UpdateThrottling())
+        // Check the filter and the subscription throttling option.
+        if (!this->Accept(_msg) || !this->UpdateThrottling())
           return true;
 
         this->cb(_msg, _info);
         return true;
       }
 
+      /// \brief Get the prototype of a message type. The prototype is
+      /// resolved by name the first time and cached, as a generic
+      /// subscription usually receives a single type.
+      /// \param[in] _type Message type name.
+      /// \return The prototype, or nullptr if the type is unknown.
+      private: std::shared_ptr<const ProtoMsg> Prototype(
+        const std::string &_type) const
+      {
+        std::lock_guard<std::mutex> lk(this->prototypeMutex);
+        if (this->prototype && this->prototypeType == _type)
+          return this->prototype;
+
+        std::shared_ptr<const ProtoMsg> result;
+        const google::protobuf::Descriptor *desc =
+          google::protobuf::DescriptorPool::generated_pool()
+            ->FindMessageTypeByName(_type);
+
+        // First, check if we have the descriptor from the generated proto
+        // classes. The generated prototypes live as long as the program.
+        if (desc)
+        {
+          const google::protobuf::Message *generated =
+            google::protobuf::MessageFactory::generated_factory()
+              ->GetPrototype(desc);
+          if (generated)
+            result.reset(generated, [](const ProtoMsg *) {});
+        }
+        else
+        {
+          // Fallback on Gazebo Msgs if the message type is not found. The
+          // created message is the prototype of the next ones.
+          result = gz::msgs::Factory::New(_type);
+        }
+
+        // Unknown types are resolved again, they might be loaded later.
+        if (result)
+        {
+          this->prototype = result;
+          this->prototypeType = _type;
+        }
+        return result;
+      }
+
       /// \brief Callback to the function registered for this handler.
       private: MsgCallback<ProtoMsg> cb;
+
+      /// \brief Protects the cached prototype.
+      private: mutable std::mutex prototypeMutex;
+
+      /// \brief Type name of the cached prototype.
+      private: mutable std::string prototypeType;
+
+      /// \brief Prototype of the last received message type.
+      private: mutable std::shared_ptr<const ProtoMsg> prototype;
+    };
+
+    /// \brief Whether a type is a std::function.
+    template <typename T> struct IsStdFunction : std::false_type {};
+
+    /// \brief Specialization for std::function.
+    template <typename R, typename... Args>
+    struct IsStdFunction<std::function<R(Args...)>> : std::true_type {};
+
+    /// \class CallableSubscriptionHandler SubscriptionHandler.hh
+    /// \brief Subscription handler that stores the callable registered in
+    /// Node::Subscribe() inline, preserving its type. The callable is invoked
+    /// directly, without a std::function in between, and the received
+    /// message is cast to 'T' without any runtime check (the message type was
+    /// already matched against the handler before the dispatch).
+    /// 'CallbackT' accepts either (const T &, const MessageInfo &) or
+    /// (const T &). The first signature is preferred when both are valid.
+    template <typename T, typename CallbackT>
+    class CallableSubscriptionHandler final
+      : public SubscriptionHandler<T>
+    {
+      static_assert(std::is_invocable_v<CallbackT &, const T &,
+                                        const MessageInfo &> ||
+                    std::is_invocable_v<CallbackT &, const T &>,
+        "The callback must accept (const T &, const MessageInfo &) or "
+        "(const T &)");
+
+      /// \brief Constructor.
+      /// \param[in] _nUuid UUID of the node registering the handler.
+      /// \param[in] _cb The callback.
+      /// \param[in] _opts Subscription options.
+      public: template <typename F>
+      CallableSubscriptionHandler(const std::string &_nUuid, F &&_cb,
+        const SubscribeOptions &_opts = SubscribeOptions())
+        : SubscriptionHandler<T>(_nUuid, _opts),
+          cb(std::forward<F>(_cb))
+      {
+      }
+
+      // Documentation inherited.
+      public: bool RunLocalCallback(const ProtoMsg &_msg,
+                                    const MessageInfo &_info) override
+      {
+        // Check the filter and the subscription throttling option.
+        if (!this->Accept(_msg) || !this->UpdateThrottling())
+          return true;
+
+        const T &msg = static_cast<const T &>(_msg);
+        if constexpr (std::is_invocable_v<CallbackT &, const T &,
+                                          const MessageInfo &>)
+        {
+          this->cb(msg, _info);
+        }
+        else
+        {
+          this->cb(msg);
+        }
+        return true;
+      }
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// CallbackT
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief The callback, stored by value.
+      private: CallbackT cb;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
     };
 
     //////////////////////////////////////////////////
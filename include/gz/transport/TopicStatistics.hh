@@ -20,6 +20,9 @@
 #include <gz/msgs/statistic.pb.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <string>
@@ -45,6 +48,8 @@ namespace gz
     inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
     //
     // Forward declarations.
+    class CallbackProfiler;
+    class Node;
     class TopicStatisticsPrivate;
 
     /// \brief Computes the rolling average, min, max, and standard
@@ -98,6 +103,85 @@ namespace gz
       private: double max = std::numeric_limits<double>::min();
     };
 
+    /// \brief Log-linear histogram of non-negative integer samples, used to
+    /// compute latency percentiles such as p50, p99 and p99.9.
+    ///
+    /// Values below 2^kSubBucketBits have their own bucket. Above that, every
+    /// power of two is split into 2^kSubBucketBits linear sub-buckets, so the
+    /// relative error of a percentile is below 1 / 2^kSubBucketBits (~3%)
+    /// regardless of the magnitude of the samples. Values above
+    /// 2^kMaxValueBits - 1 are clamped. Record() only performs relaxed
+    /// atomic increments, so it never blocks concurrent readers.
+    class GZ_TRANSPORT_VISIBLE LatencyHistogram
+    {
+      /// \brief Number of bits of precision of every bucket.
+      public: static constexpr unsigned int kSubBucketBits = 5;
+
+      /// \brief Number of bits of the largest value tracked.
+      public: static constexpr unsigned int kMaxValueBits = 36;
+
+      /// \brief Total number of buckets.
+      public: static constexpr std::size_t kBucketCount =
+        (kMaxValueBits - kSubBucketBits + 1u) << kSubBucketBits;
+
+      /// \brief Default constructor.
+      public: LatencyHistogram();
+
+      /// \brief Copy constructor.
+      /// \param[in] _other Histogram to copy.
+      public: LatencyHistogram(const LatencyHistogram &_other);
+
+      /// \brief Assignment operator.
+      /// \param[in] _other Histogram to copy.
+      /// \return Reference to this histogram.
+      public: LatencyHistogram &operator=(const LatencyHistogram &_other);
+
+      /// \brief Default destructor.
+      public: ~LatencyHistogram() = default;
+
+      /// \brief Add a sample.
+      /// \param[in] _value New sample.
+      public: void Record(uint64_t _value);
+
+      /// \brief Get the number of samples.
+      /// \return The number of samples.
+      public: uint64_t Count() const;
+
+      /// \brief Get the value below which a percentage of the samples fall.
+      /// \param[in] _percentile Percentile, in the [0, 100] range, e.g. 99.9.
+      /// \return The midpoint of the bucket holding the percentile or 0 if
+      /// there are no samples.
+      public: uint64_t Percentile(double _percentile) const;
+
+      /// \brief Remove all the samples.
+      public: void Reset();
+
+      /// \brief Get the bucket of a value.
+      /// \param[in] _value Sample value.
+      /// \return Bucket index.
+      private: static std::size_t BucketIndex(uint64_t _value);
+
+      /// \brief Get the midpoint of the values stored in a bucket.
+      /// \param[in] _index Bucket index.
+      /// \return Representative value of the bucket.
+      private: static uint64_t BucketValue(std::size_t _index);
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Sample count per bucket.
+      private: std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+
+      /// \brief Total number of samples.
+      private: std::atomic<uint64_t> count{0};
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+
     /// \brief Encapsulates statistics for a single topic. The set of
     /// statistics include:
     ///
@@ -110,6 +194,17 @@ namespace gz
     /// Publication statistics utilize time stamps generated by the
     /// publisher. Receive statistics use time stamps generated by the
     /// subscriber.
+    ///
+    /// Every set of statistics is also recorded in a LatencyHistogram, in
+    /// microseconds, to report percentiles. Update() with time stamps in
+    /// milliseconds bounds the resolution of the publication and age
+    /// histograms to one millisecond. The transport passes microsecond
+    /// time points, with the publication time moved to the local clock.
+    ///
+    /// When the arrival time of the publications is known, their age is
+    /// split in the transit statistics, until they arrived in this process,
+    /// and the queueing statistics, while they waited for the reception
+    /// thread.
     class GZ_TRANSPORT_VISIBLE TopicStatistics
     {
       /// \brief Default constructor.
@@ -124,11 +219,41 @@ namespace gz
 
       /// \brief Update the topic statistics.
       /// \param[in] _sender Address of the sender.
-      /// \param[in] _stamp Publication time stamp.
+      /// \param[in] _stamp Publication time stamp (milliseconds, local
+      /// steady clock).
       /// \param[in] _seq Publication sequence number.
       public: void Update(const std::string &_sender,
                           uint64_t _stamp, uint64_t _seq);
 
+      /// \brief Update the topic statistics with a publication received
+      /// earlier, e.g. when the samples are aggregated off the reception
+      /// thread. Both times have microsecond resolution.
+      /// \param[in] _sender Address of the sender.
+      /// \param[in] _published Publication time, in the local clock.
+      /// \param[in] _seq Publication sequence number.
+      /// \param[in] _received Time at which the publication was received.
+      public: void Update(const std::string &_sender,
+                          std::chrono::steady_clock::time_point _published,
+                          uint64_t _seq,
+                          std::chrono::steady_clock::time_point _received);
+
+      /// \brief Update the topic statistics with a publication received
+      /// earlier, splitting its age in the transit time, until it arrived
+      /// in this process, and the time it waited in this process until it
+      /// was handed to the subscribers. All times have microsecond
+      /// resolution.
+      /// \param[in] _sender Address of the sender.
+      /// \param[in] _published Publication time, in the local clock.
+      /// \param[in] _seq Publication sequence number.
+      /// \param[in] _arrived Time at which the publication arrived in this
+      /// process, e.g. when the reception thread was woken up by its socket.
+      /// \param[in] _received Time at which the publication was received.
+      public: void Update(const std::string &_sender,
+                          std::chrono::steady_clock::time_point _published,
+                          uint64_t _seq,
+                          std::chrono::steady_clock::time_point _arrived,
+                          std::chrono::steady_clock::time_point _received);
+
       /// \brief Populate a gz::msgs::Metric message with topic
       /// statistics.
       /// \param[in] _msg Message to populate.
@@ -138,6 +263,11 @@ namespace gz
       /// \return Number of dropped messages.
       public: uint64_t DroppedMsgCount() const;
 
+      /// \brief Count messages dropped by this process, e.g. when the
+      /// queue of a subscription is full.
+      /// \param[in] _count Number of dropped messages.
+      public: void AddDroppedMsgs(uint64_t _count);
+
       /// \brief Get statistics about publication of messages.
       /// \return Publication statistics.
       public: Statistics PublicationStatistics() const;
@@ -149,6 +279,38 @@ namespace gz
       /// \brief Get the message age statistics.
       /// \return Age statistics.
       public: Statistics AgeStatistics() const;
+
+      /// \brief Get the statistics of the transit time of the messages,
+      /// from their publication until they arrived in this process. Only
+      /// the publications with an arrival time are counted.
+      /// \return Transit statistics.
+      public: Statistics TransitStatistics() const;
+
+      /// \brief Get the statistics of the time that the messages waited in
+      /// this process, from their arrival until they were received. Only the
+      /// publications with an arrival time are counted.
+      /// \return Queueing statistics.
+      public: Statistics QueueingStatistics() const;
+
+      /// \brief Get the histogram of the time between publications.
+      /// \return Publication period histogram (microseconds).
+      public: LatencyHistogram PublicationHistogram() const;
+
+      /// \brief Get the histogram of the time between receptions.
+      /// \return Reception period histogram (microseconds).
+      public: LatencyHistogram ReceptionHistogram() const;
+
+      /// \brief Get the histogram of the message age.
+      /// \return Age histogram (microseconds).
+      public: LatencyHistogram AgeHistogram() const;
+
+      /// \brief Get the histogram of the transit time.
+      /// \return Transit histogram (microseconds).
+      public: LatencyHistogram TransitHistogram() const;
+
+      /// \brief Get the histogram of the queueing time.
+      /// \return Queueing histogram (microseconds).
+      public: LatencyHistogram QueueingHistogram() const;
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -161,6 +323,205 @@ namespace gz
 #pragma warning(pop)
 #endif
     };
+
+    /// \brief Statistics measured by a publisher, which tell how much the
+    /// publications cost in this process. They complement TopicStatistics,
+    /// measured by the subscribers. They are collected unless the transport
+    /// metrics are disabled (GZ_TRANSPORT_METRICS=0).
+    /// \sa Node::Publisher::Statistics
+    class GZ_TRANSPORT_VISIBLE PublisherStatistics
+    {
+      /// \brief Number of publications, not counting the throttled ones.
+      /// \return The publication count.
+      public: uint64_t PublicationCount() const;
+
+      /// \brief Number of publications that had no subscriber at all, e.g.
+      /// when HasConnections() would have returned false.
+      /// \return The count of publications without subscribers.
+      public: uint64_t UnsubscribedCount() const;
+
+      /// \brief Number of messages serialized by the publisher.
+      /// \return The serialization count.
+      public: uint64_t SerializationCount() const;
+
+      /// \brief Total time spent serializing the messages.
+      /// \return The serialization time.
+      public: std::chrono::nanoseconds SerializationTime() const;
+
+      /// \brief Longest serialization of a message.
+      /// \return The maximum serialization time.
+      public: std::chrono::nanoseconds MaxSerializationTime() const;
+
+      /// \brief Total size of the published messages, serialized.
+      /// \return The number of bytes published.
+      public: uint64_t Bytes() const;
+
+      /// \brief Number of messages that ZeroMQ refused to send, e.g. because
+      /// the socket would block (EAGAIN).
+      /// \return The send failure count.
+      public: uint64_t SendFailureCount() const;
+
+      /// \brief Number of publications delivered through the local
+      /// publication queue.
+      /// \return The queued publication count.
+      public: uint64_t QueuedCount() const;
+
+      /// \brief Total time that the publications waited in the local
+      /// publication queue.
+      /// \return The queue wait time.
+      public: std::chrono::nanoseconds QueueWaitTime() const;
+
+      /// \brief Longest wait of a publication in the local publication
+      /// queue.
+      /// \return The maximum queue wait time.
+      public: std::chrono::nanoseconds MaxQueueWaitTime() const;
+
+      /// \brief Number of messages that a real-time publisher couldn't
+      /// publish, because its slots were full or the message didn't fit.
+      /// It is counted even if the transport metrics are disabled.
+      /// \return The real-time drop count.
+      /// \sa AdvertiseMessageOptions::SetRealTime
+      public: uint64_t RealTimeDropCount() const;
+
+      /// \brief Number of messages dropped by the rate or bandwidth limit
+      /// of the publisher. With a remote only limit, the messages still
+      /// delivered to the subscribers of this process are counted too. It
+      /// is counted even if the transport metrics are disabled.
+      /// \return The rate limited count.
+      /// \sa AdvertiseMessageOptions::SetRateLimit
+      /// \sa AdvertiseMessageOptions::SetBandwidthLimit
+      public: uint64_t RateLimitedCount() const;
+
+      /// \brief Populate a gz::msgs::Metric message with the publisher
+      /// statistics. Times are in milliseconds.
+      /// \param[in] _msg Message to populate.
+      public: void FillMessage(msgs::Metric &_msg) const;
+
+      /// \brief Number of publications.
+      private: uint64_t publications = 0;
+
+      /// \brief Number of publications without subscribers.
+      private: uint64_t unsubscribed = 0;
+
+      /// \brief Number of serializations.
+      private: uint64_t serializations = 0;
+
+      /// \brief Total serialization time (ns).
+      private: uint64_t serializationNs = 0;
+
+      /// \brief Maximum serialization time (ns).
+      private: uint64_t maxSerializationNs = 0;
+
+      /// \brief Bytes published.
+      private: uint64_t bytes = 0;
+
+      /// \brief Number of send failures.
+      private: uint64_t sendFailures = 0;
+
+      /// \brief Number of queued publications.
+      private: uint64_t queued = 0;
+
+      /// \brief Total queue wait time (ns).
+      private: uint64_t queueWaitNs = 0;
+
+      /// \brief Maximum queue wait time (ns).
+      private: uint64_t maxQueueWaitNs = 0;
+
+      /// \brief Number of real-time drops.
+      private: uint64_t realTimeDropped = 0;
+
+      /// \brief Number of messages dropped by the rate limits.
+      private: uint64_t rateLimited = 0;
+
+      friend class Node;
+    };
+
+    /// \brief Execution profile of the callback of a subscription handler,
+    /// which tells which handler delays the thread that runs it. Profiles
+    /// are only collected when GZ_TRANSPORT_CALLBACK_PROFILE is set to 1 or
+    /// NodeShared::EnableCallbackProfile() is called.
+    ///
+    /// A callback overruns when it takes longer than the time elapsed since
+    /// the previous message of the topic arrived: the handler can't keep up
+    /// with the topic rate and the following messages wait behind it.
+    /// \sa NodeShared::CallbackProfiles
+    class GZ_TRANSPORT_VISIBLE CallbackProfile
+    {
+      /// \brief Topic of the subscription.
+      /// \return The topic name, without the partition.
+      public: const std::string &Topic() const;
+
+      /// \brief UUID of the node that subscribed.
+      /// \return The node UUID.
+      public: const std::string &NodeUuid() const;
+
+      /// \brief UUID of the subscription handler.
+      /// \return The handler UUID.
+      public: const std::string &HandlerUuid() const;
+
+      /// \brief Number of callbacks executed.
+      /// \return The callback count.
+      public: uint64_t CallCount() const;
+
+      /// \brief Number of callbacks that took longer than the time between
+      /// the arrival of the message and the previous one.
+      /// \return The overrun count.
+      public: uint64_t OverrunCount() const;
+
+      /// \brief Total time spent in the callback.
+      /// \return The callback time.
+      public: std::chrono::nanoseconds TotalTime() const;
+
+      /// \brief Longest execution of the callback.
+      /// \return The maximum callback time.
+      public: std::chrono::nanoseconds MaxTime() const;
+
+      /// \brief Distribution of the callback durations.
+      /// \return Duration histogram (microseconds).
+      public: const LatencyHistogram &Durations() const;
+
+      /// \brief Populate a gz::msgs::StatisticsGroup message with the
+      /// profile. The topic and the UUIDs are stored in the header data,
+      /// under the "topic", "node_uuid" and "handler_uuid" keys. Times are
+      /// in milliseconds.
+      /// \param[in] _group Message to populate.
+      public: void FillMessage(msgs::StatisticsGroup &_group) const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::string
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Topic of the subscription.
+      private: std::string topic;
+
+      /// \brief Node UUID.
+      private: std::string nodeUuid;
+
+      /// \brief Handler UUID.
+      private: std::string handlerUuid;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+      /// \brief Number of callbacks.
+      private: uint64_t calls = 0;
+
+      /// \brief Number of overruns.
+      private: uint64_t overruns = 0;
+
+      /// \brief Total callback time (ns).
+      private: uint64_t totalNs = 0;
+
+      /// \brief Maximum callback time (ns).
+      private: uint64_t maxNs = 0;
+
+      /// \brief Callback durations (us).
+      private: LatencyHistogram durations;
+
+      friend class CallbackProfiler;
+    };
     }
   }
 }
@@ -20,7 +20,9 @@
 
 #include <algorithm>
 #include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "gz/transport/config.hh"
@@ -38,6 +40,11 @@ namespace gz
     /// \class TopicStorage TopicStorage.hh gz/transport/TopicStorage.hh
     /// \brief Store address information about topics and provide convenient
     /// methods for adding new topics, removing them, etc.
+    ///
+    /// The publishers are stored by topic. Secondary hash indexes by process
+    /// UUID, node UUID and address keep the operations on a single process
+    /// or node proportional to the size of that process, not of the whole
+    /// graph.
     template<typename T> class TopicStorage
     {
       /// \brief Constructor.
@@ -80,6 +87,11 @@ namespace gz
 
         // Add a new Publisher entry.
         m[_publisher.PUuid()].push_back(T(_publisher));
+
+        // Update the indexes.
+        this->procIndex[_publisher.PUuid()][_publisher.NUuid()].insert(
+          _publisher.Topic());
+        ++this->addrIndex[_publisher.Addr()];
         return true;
       }
 
@@ -146,18 +158,7 @@ namespace gz
       /// \return true if the publisher's address is stored.
       public: bool HasPublisher(const std::string &_addr) const
       {
-        for (auto const &topic : this->data)
-        {
-          for (auto const &proc : topic.second)
-          {
-            for (auto const &pub : proc.second)
-            {
-              if (pub.Addr() == _addr)
-                return true;
-            }
-          }
-        }
-        return false;
+        return this->addrIndex.find(_addr) != this->addrIndex.end();
       }
 
       /// \brief Get the address information for a given topic and node UUID.
@@ -214,6 +215,51 @@ namespace gz
         return true;
       }
 
+      /// \brief Visit the publishers stored for a given topic without
+      /// copying them.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _visitor Function called with every publisher, as
+      /// `void(const T &)`. It must not modify this storage.
+      /// \return true if at least there is one publisher stored.
+      public: template<typename F>
+      bool VisitPublishers(const std::string &_topic, F &&_visitor) const
+      {
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
+          return false;
+
+        for (auto const &proc : it->second)
+        {
+          for (auto const &pub : proc.second)
+            _visitor(pub);
+        }
+        return true;
+      }
+
+      /// \brief Visit the publishers stored for a given topic and process
+      /// UUID without copying them.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _pUuid Process UUID of the publishers.
+      /// \param[in] _visitor Function called with every publisher, as
+      /// `void(const T &)`. It must not modify this storage.
+      /// \return true if at least there is one publisher stored.
+      public: template<typename F>
+      bool VisitPublishers(const std::string &_topic,
+                           const std::string &_pUuid, F &&_visitor) const
+      {
+        auto it = this->data.find(_topic);
+        if (it == this->data.end())
+          return false;
+
+        auto proc = it->second.find(_pUuid);
+        if (proc == it->second.end())
+          return false;
+
+        for (auto const &pub : proc->second)
+          _visitor(pub);
+        return true;
+      }
+
       /// \brief Remove a publisher associated to a given topic and UUID pair.
       /// \param[in] _topic Topic name
       /// \param[in] _pUuid Process UUID of the publisher.
@@ -236,14 +282,15 @@ namespace gz
           {
             // Vector of 0MQ known addresses for a given topic and pUuid.
             auto &v = m[_pUuid];
-            auto priorSize = v.size();
-            v.erase(std::remove_if(v.begin(), v.end(),
+            auto removed = std::stable_partition(v.begin(), v.end(),
               [&](const T &_pub)
               {
-                return _pub.NUuid() == _nUuid;
-              }),
-              v.end());
-            counter = priorSize - v.size();
+                return _pub.NUuid() != _nUuid;
+              });
+            for (auto it = removed; it != v.end(); ++it)
+              this->ReleaseAddr(it->Addr());
+            counter = static_cast<size_t>(v.end() - removed);
+            v.erase(removed, v.end());
 
             if (v.empty())
               m.erase(_pUuid);
@@ -253,6 +300,17 @@ namespace gz
           }
         }
 
+        if (counter > 0)
+        {
+          auto proc = this->procIndex.find(_pUuid);
+          auto node = proc->second.find(_nUuid);
+          node->second.erase(_topic);
+          if (node->second.empty())
+            proc->second.erase(node);
+          if (proc->second.empty())
+            this->procIndex.erase(proc);
+        }
+
         return counter > 0;
       }
 
@@ -261,21 +319,36 @@ namespace gz
       /// \return True when at least one address was removed or false otherwise.
       public: bool DelPublishersByProc(const std::string &_pUuid)
       {
-        size_t counter = 0;
+        auto proc = this->procIndex.find(_pUuid);
+        if (proc == this->procIndex.end())
+          return false;
 
-        // Iterate over all the topics.
-        for (auto it = this->data.begin(); it != this->data.end();)
+        // Only visit the topics of the process.
+        for (auto const &node : proc->second)
         {
-          // m is {pUUID=>Publisher}.
-          auto &m = it->second;
-          counter += m.erase(_pUuid);
-          if (m.empty())
-            this->data.erase(it++);
-          else
-            ++it;
+          for (auto const &topic : node.second)
+          {
+            auto it = this->data.find(topic);
+            if (it == this->data.end())
+              continue;
+
+            // m is {pUUID=>Publisher}.
+            auto &m = it->second;
+            auto procPubs = m.find(_pUuid);
+            if (procPubs == m.end())
+              continue;
+
+            for (auto const &pub : procPubs->second)
+              this->ReleaseAddr(pub.Addr());
+            m.erase(procPubs);
+
+            if (m.empty())
+              this->data.erase(it);
+          }
         }
 
-        return counter > 0;
+        this->procIndex.erase(proc);
+        return true;
       }
 
       /// \brief Given a process UUID, the function returns the list of
@@ -288,19 +361,15 @@ namespace gz
       {
         _pubs.clear();
 
-        // Iterate over all the topics.
-        for (auto const &topic : this->data)
+        auto proc = this->procIndex.find(_pUuid);
+        if (proc == this->procIndex.end())
+          return;
+
+        for (auto const &node : proc->second)
         {
-          // m is {pUUID=>Publisher}.
-          auto &m = topic.second;
-          if (m.find(_pUuid) != m.end())
-          {
-            auto &v = m.at(_pUuid);
-            for (auto const &pub : v)
-            {
-              _pubs[pub.NUuid()].push_back(T(pub));
-            }
-          }
+          std::vector<T> pubs;
+          this->PublishersByNode(_pUuid, node.first, pubs);
+          _pubs[node.first] = std::move(pubs);
         }
       }
 
@@ -315,20 +384,23 @@ namespace gz
       {
         _pubs.clear();
 
-        // Iterate over all the topics.
-        for (auto const &topic : this->data)
+        auto proc = this->procIndex.find(_pUuid);
+        if (proc == this->procIndex.end())
+          return;
+
+        auto node = proc->second.find(_nUuid);
+        if (node == proc->second.end())
+          return;
+
+        // Only visit the topics of the node.
+        for (auto const &topic : node->second)
         {
-          // m is {pUUID=>Publisher}.
-          auto const &m = topic.second;
-          if (m.find(_pUuid) != m.end())
+          auto const &v = this->data.at(topic).at(_pUuid);
+          for (auto const &pub : v)
           {
-            auto const &v = m.at(_pUuid);
-            for (auto const &pub : v)
+            if (pub.NUuid() == _nUuid)
             {
-              if (pub.NUuid() == _nUuid)
-              {
-                _pubs.push_back(T(pub));
-              }
+              _pubs.push_back(T(pub));
             }
           }
         }
@@ -366,12 +438,32 @@ namespace gz
       public: void Clear()
       {
         this->data.clear();
+        this->procIndex.clear();
+        this->addrIndex.clear();
+      }
+
+      /// \brief Forget one publisher stored with a given address.
+      /// \param[in] _addr Address of the publisher.
+      private: void ReleaseAddr(const std::string &_addr)
+      {
+        auto it = this->addrIndex.find(_addr);
+        if (it != this->addrIndex.end() && --it->second == 0)
+          this->addrIndex.erase(it);
       }
 
       /// \brief The keys are topics. The values are another map, where the key
       /// is the process UUID and the value a vector of publishers.
       private: std::map<std::string,
                         std::map<std::string, std::vector<T>>> data;
+
+      /// \brief Index of the topics of every node. The keys are process
+      /// UUIDs, the values map node UUIDs to their topics.
+      private: std::unordered_map<std::string,
+                 std::unordered_map<std::string, std::set<std::string>>>
+                 procIndex;
+
+      /// \brief Number of publishers stored for every address.
+      private: std::unordered_map<std::string, size_t> addrIndex;
     };
     }
   }
@@ -133,6 +133,14 @@ namespace gz
     using SrvDiscoveryCallback =
       std::function<void(const ServicePublisher &_publisher)>;
 
+    /// \def TopicGraphCallback
+    /// \brief Callback used to watch the changes of the topic graph:
+    ///   \param[in] _publisher Publisher that appeared or disappeared.
+    ///   \param[in] _added True if the publisher is new or false if it is
+    ///   gone.
+    using TopicGraphCallback =
+      std::function<void(const MessagePublisher &_publisher, bool _added)>;
+
     /// \def MsgCallback
     /// \brief User callback used for receiving messages:
     ///   \param[in] _msg Protobuf message containing the topic update.
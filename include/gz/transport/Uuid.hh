@@ -18,6 +18,10 @@
 #ifndef GZ_TRANSPORT_UUID_HH_
 #define GZ_TRANSPORT_UUID_HH_
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <string>
 
@@ -42,11 +46,23 @@ namespace gz
     //
     /// \class Uuid Uuid.hh gz/transport/Uuid.hh
     /// \brief A portable class for representing a Universally Unique Identifier
+    ///
+    /// A Uuid is a 128-bit value (a random RFC 4122 version 4 UUID) that can
+    /// be compared, ordered and hashed without converting it to text.
+    /// New UUIDs come from a per-thread generator seeded by the system, so
+    /// creating one doesn't make a system call.
     class GZ_TRANSPORT_VISIBLE Uuid
     {
-      /// \brief Constructor.
+      /// \brief The 16 bytes of a UUID.
+      public: using Bytes = std::array<uint8_t, 16>;
+
+      /// \brief Constructor. It generates a new random UUID.
       public: Uuid();
 
+      /// \brief Constructor from the bytes of an existing UUID.
+      /// \param[in] _bytes The bytes of the UUID.
+      public: explicit Uuid(const Bytes &_bytes);
+
       /// \brief Destructor.
       public: virtual ~Uuid();
 
@@ -54,6 +70,36 @@ namespace gz
       /// \return the UUID in string format.
       public: std::string ToString() const;
 
+      /// \brief Parse the string representation of a UUID.
+      /// \param[in] _str UUID in the format given by ToString(). Upper case
+      /// hexadecimal digits are accepted.
+      /// \param[out] _uuid The parsed UUID.
+      /// \return True if _str is a valid UUID.
+      public: static bool FromString(const std::string &_str, Uuid &_uuid);
+
+      /// \brief Get the bytes of the UUID.
+      /// \return The 16 bytes, in the order of the string representation.
+      public: const Bytes &Data() const;
+
+      /// \brief Get a hash of the UUID, e.g. for unordered containers.
+      /// \return The hash.
+      public: std::size_t Hash() const;
+
+      /// \brief Equality operator.
+      /// \param[in] _other Another UUID.
+      /// \return True if both UUIDs are the same.
+      public: bool operator==(const Uuid &_other) const;
+
+      /// \brief Inequality operator.
+      /// \param[in] _other Another UUID.
+      /// \return True if the UUIDs are different.
+      public: bool operator!=(const Uuid &_other) const;
+
+      /// \brief Less than operator, comparing the bytes in order.
+      /// \param[in] _other Another UUID.
+      /// \return True if this UUID sorts before _other.
+      public: bool operator<(const Uuid &_other) const;
+
       /// \brief Stream insertion operator.
       /// \param[out] _out The output stream.
       /// \param[in] _uuid UUID to write to the stream.
@@ -73,9 +119,25 @@ namespace gz
       private: static const int UuidStrLen = 37;
 
       /// \brief Internal representation.
-      private: portable_uuid_t data;
+      private: Bytes data;
     };
     }
   }
 }
+
+namespace std
+{
+  /// \brief Hash of a UUID, to use it as the key of unordered containers.
+  template<>
+  struct hash<gz::transport::Uuid>
+  {
+    /// \brief Hash a UUID.
+    /// \param[in] _uuid The UUID.
+    /// \return The hash.
+    std::size_t operator()(const gz::transport::Uuid &_uuid) const
+    {
+      return _uuid.Hash();
+    }
+  };
+}
 #endif
@@ -20,9 +20,14 @@
 
 #include <gz/msgs/empty.pb.h>
 
+#include <future>
+#include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace gz
 {
@@ -34,7 +39,121 @@ namespace gz
         const std::string &_topic,
         const AdvertiseMessageOptions &_options)
     {
-      return this->Advertise(_topic, MessageT().GetTypeName(), _options);
+      if constexpr (HasSerializationTraits<MessageT>::value)
+      {
+        return this->Advertise(_topic,
+          SerializationTraits<MessageT>::TypeName(), _options);
+      }
+      else
+      {
+        return this->Advertise(_topic, MessageT().GetTypeName(), _options);
+      }
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    std::vector<Node::Publisher> Node::AdvertiseMany(
+        const std::vector<std::string> &_topics,
+        const AdvertiseMessageOptions &_options)
+    {
+      if constexpr (HasSerializationTraits<MessageT>::value)
+      {
+        return this->AdvertiseMany(_topics,
+          SerializationTraits<MessageT>::TypeName(), _options);
+      }
+      else
+      {
+        return this->AdvertiseMany(_topics, MessageT().GetTypeName(),
+          _options);
+      }
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    Node::TypedPublisher<MessageT> Node::AdvertiseTyped(
+        const std::string &_topic,
+        const AdvertiseMessageOptions &_options)
+    {
+      return TypedPublisher<MessageT>(this->Advertise(_topic,
+        TypedPublisher<MessageT>::TypeName(), _options));
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    Node::TypedPublisher<MessageT>::TypedPublisher(
+        const Publisher &_publisher)
+      : Publisher(_publisher)
+    {
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    const std::string &Node::TypedPublisher<MessageT>::TypeName()
+    {
+      static const std::string typeName(
+        MessageT::descriptor()->full_name());
+      return typeName;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::TypedPublisher<MessageT>::Publish(const MessageT &_msg)
+    {
+      return this->PublishTyped(_msg, nullptr);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::TypedPublisher<MessageT>::Publish(
+        std::shared_ptr<const MessageT> _msg)
+    {
+      if (!_msg)
+        return false;
+
+      const MessageT &msg = *_msg;
+      return this->PublishTyped(msg, std::move(_msg));
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::TypedPublisher<MessageT>::Publish(
+        std::unique_ptr<MessageT> &&_msg)
+    {
+      return this->Publish(std::shared_ptr<const MessageT>(std::move(_msg)));
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::TypedPublisher<MessageT>::Publish(Loan &_loan)
+    {
+      return Publisher::Publish(_loan);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::Publisher::Publish(std::unique_ptr<MessageT> &&_msg)
+    {
+      static_assert(std::is_base_of_v<ProtoMsg, MessageT>,
+        "The message must be a protobuf message");
+      return this->Publish(std::shared_ptr<const ProtoMsg>(std::move(_msg)));
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT, typename>
+    bool Node::Publisher::Publish(const MessageT &_msg)
+    {
+      // The buffer keeps its capacity for the next messages.
+      thread_local std::string buffer;
+      if (!SerializationTraits<MessageT>::Serialize(_msg, buffer))
+      {
+        std::cerr << "Node::Publisher::Publish(): Error serializing a ["
+                  << SerializationTraits<MessageT>::TypeName() << "] message"
+                  << std::endl;
+        return false;
+      }
+
+      return this->PublishRaw(buffer,
+        SerializationTraits<MessageT>::TypeName());
     }
 
     //////////////////////////////////////////////////
@@ -44,14 +163,11 @@ namespace gz
         void(*_cb)(const MessageT &_msg),
         const SubscribeOptions &_opts)
     {
-      std::function<void(const MessageT &, const MessageInfo &)> f =
-        [_cb](const MessageT & _internalMsg,
-              const MessageInfo &/*_internalInfo*/)
-      {
-        (*_cb)(_internalMsg);
-      };
-
-      return this->Subscribe<MessageT>(_topic, f, _opts);
+      return this->Subscribe<MessageT>(_topic,
+        [_cb](const MessageT &_internalMsg)
+        {
+          (*_cb)(_internalMsg);
+        }, _opts);
     }
 
     //////////////////////////////////////////////////
@@ -79,15 +195,11 @@ namespace gz
         ClassT *_obj,
         const SubscribeOptions &_opts)
     {
-      std::function<void(const MessageT &, const MessageInfo &)> f =
-        [_cb, _obj](const MessageT & _internalMsg,
-                    const MessageInfo &/*_internalInfo*/)
-      {
-        auto cb = std::bind(_cb, _obj, std::placeholders::_1);
-        cb(_internalMsg);
-      };
-
-      return this->Subscribe<MessageT>(_topic, f, _opts);
+      return this->Subscribe<MessageT>(_topic,
+        [_cb, _obj](const MessageT &_internalMsg)
+        {
+          (_obj->*_cb)(_internalMsg);
+        }, _opts);
     }
 
     //////////////////////////////////////////////////
@@ -97,14 +209,11 @@ namespace gz
         void(*_cb)(const MessageT &_msg, const MessageInfo &_info),
         const SubscribeOptions &_opts)
     {
-      std::function<void(const MessageT &, const MessageInfo &)> f =
-        [_cb](const MessageT & _internalMsg,
-              const MessageInfo &_internalInfo)
-      {
-        (*_cb)(_internalMsg, _internalInfo);
-      };
-
-      return this->Subscribe<MessageT>(_topic, f, _opts);
+      return this->Subscribe<MessageT>(_topic,
+        [_cb](const MessageT &_internalMsg, const MessageInfo &_internalInfo)
+        {
+          (*_cb)(_internalMsg, _internalInfo);
+        }, _opts);
     }
 
     //////////////////////////////////////////////////
@@ -115,35 +224,112 @@ namespace gz
                            const MessageInfo &_info)> _cb,
         const SubscribeOptions &_opts)
     {
-      // Topic remapping.
-      std::string topic = _topic;
-      this->Options().TopicRemap(_topic, topic);
+      if constexpr (HasSerializationTraits<MessageT>::value)
+      {
+        return this->SubscribeSerialized<MessageT>(_topic, std::move(_cb),
+          _opts);
+      }
+      else
+      {
+        // Create a new subscription handler.
+        std::shared_ptr<SubscriptionHandler<MessageT>> subscrHandlerPtr(
+            new SubscriptionHandler<MessageT>(this->NodeUuid(), _opts));
 
-      std::string fullyQualifiedTopic;
-      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
-        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+        // Insert the callback into the handler.
+        subscrHandlerPtr->SetCallback(std::move(_cb));
+
+        return this->SubscribeHandler(_topic, subscrHandlerPtr);
+      }
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT, typename CallbackT, typename>
+    bool Node::Subscribe(
+        const std::string &_topic,
+        CallbackT &&_cb,
+        const SubscribeOptions &_opts)
+    {
+      if constexpr (HasSerializationTraits<MessageT>::value)
       {
-        std::cerr << "Topic [" << topic << "] is not valid." << std::endl;
-        return false;
+        return this->SubscribeSerialized<MessageT>(_topic,
+          std::forward<CallbackT>(_cb), _opts);
       }
+      else
+      {
+        // The handler keeps the callable with its own type.
+        using HandlerT =
+          CallableSubscriptionHandler<MessageT, std::decay_t<CallbackT>>;
+        auto subscrHandlerPtr = std::make_shared<HandlerT>(
+          this->NodeUuid(), std::forward<CallbackT>(_cb), _opts);
 
-      // Create a new subscription handler.
-      std::shared_ptr<SubscriptionHandler<MessageT>> subscrHandlerPtr(
-          new SubscriptionHandler<MessageT>(this->NodeUuid(), _opts));
+        return this->SubscribeHandler(_topic, subscrHandlerPtr);
+      }
+    }
 
-      // Insert the callback into the handler.
-      subscrHandlerPtr->SetCallback(std::move(_cb));
+    //////////////////////////////////////////////////
+    template<typename MessageT, typename CallbackT>
+    bool Node::SubscribeSerialized(
+        const std::string &_topic,
+        CallbackT &&_cb,
+        const SubscribeOptions &_opts)
+    {
+      using Traits = SerializationTraits<MessageT>;
+      using CallableT = std::decay_t<CallbackT>;
+      static_assert(std::is_invocable_v<CallableT &, const MessageT &,
+                                        const MessageInfo &> ||
+                    std::is_invocable_v<CallableT &, const MessageT &>,
+        "The callback must accept (const T &, const MessageInfo &) or "
+        "(const T &)");
+
+      // The messages are received raw and deserialized by the traits.
+      RawCallback rawCb =
+        [cb = CallableT(std::forward<CallbackT>(_cb))](
+          const char *_data, const size_t _size,
+          const MessageInfo &_info) mutable
+        {
+          MessageT msg;
+          if (!Traits::Deserialize(_data, _size, msg))
+          {
+            std::cerr << "Node::Subscribe(): Error deserializing a ["
+                      << Traits::TypeName() << "] message" << std::endl;
+            return;
+          }
 
-      std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+          if constexpr (std::is_invocable_v<CallableT &, const MessageT &,
+                                            const MessageInfo &>)
+          {
+            cb(msg, _info);
+          }
+          else
+          {
+            cb(msg);
+          }
+        };
 
-      // Store the subscription handler. Each subscription handler is
-      // associated with a topic. When the receiving thread gets new data,
-      // it will recover the subscription handler associated to the topic and
-      // will invoke the callback.
-      this->Shared()->localSubscribers.normal.AddHandler(
-        fullyQualifiedTopic, this->NodeUuid(), subscrHandlerPtr);
+      return this->SubscribeRaw(_topic, rawCb, Traits::TypeName(), _opts);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename MessageT>
+    bool Node::SubscribeMany(
+        const std::vector<std::string> &_topics,
+        std::function<void(const MessageT &_msg,
+                           const MessageInfo &_info)> _cb,
+        const SubscribeOptions &_opts)
+    {
+      // Each topic has its own subscription handler.
+      std::vector<ISubscriptionHandlerPtr> handlers;
+      handlers.reserve(_topics.size());
+      for (std::size_t i = 0; i < _topics.size(); ++i)
+      {
+        auto subscrHandlerPtr =
+          std::make_shared<SubscriptionHandler<MessageT>>(
+            this->NodeUuid(), _opts);
+        subscrHandlerPtr->SetCallback(_cb);
+        handlers.push_back(subscrHandlerPtr);
+      }
 
-      return this->SubscribeHelper(fullyQualifiedTopic);
+      return this->SubscribeHandlers(_topics, handlers);
     }
 
     //////////////////////////////////////////////////
@@ -154,16 +340,12 @@ namespace gz
         ClassT *_obj,
         const SubscribeOptions &_opts)
     {
-      std::function<void(const MessageT &, const MessageInfo &)> f =
-        [_cb, _obj](const MessageT & _internalMsg,
+      return this->Subscribe<MessageT>(_topic,
+        [_cb, _obj](const MessageT &_internalMsg,
                     const MessageInfo &_internalInfo)
-      {
-        auto cb = std::bind(_cb, _obj, std::placeholders::_1,
-          std::placeholders::_2);
-        cb(_internalMsg, _internalInfo);
-      };
-
-      return this->Subscribe<MessageT>(_topic, f, _opts);
+        {
+          (_obj->*_cb)(_internalMsg, _internalInfo);
+        }, _opts);
     }
 
     //////////////////////////////////////////////////
@@ -262,6 +444,9 @@ namespace gz
       this->Shared()->repliers.AddHandler(
         fullyQualifiedTopic, this->NodeUuid(), repHandlerPtr);
 
+      // Other processes may call the service.
+      this->Shared()->EnsureNetwork();
+
       // Notify the discovery service to register and advertise my responser.
       ServicePublisher publisher(fullyQualifiedTopic,
         this->Shared()->myReplierAddress,
@@ -281,6 +466,136 @@ namespace gz
       return true;
     }
 
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::AdvertiseBatch(
+      const std::string &_topic,
+      std::function<bool(const std::vector<RequestT> &,
+                         std::vector<ReplyT> &)> _cb,
+      const AdvertiseServiceOptions &_options)
+    {
+      // Topic remapping.
+      std::string topic = _topic;
+      this->Options().TopicRemap(_topic, topic);
+
+      std::string fullyQualifiedTopic;
+      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+      {
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        return false;
+      }
+
+      if (!_cb)
+      {
+        std::cerr << "Node::AdvertiseBatch(): Invalid callback" << std::endl;
+        return false;
+      }
+
+      // Create a new service reply handler.
+      std::shared_ptr<RepHandler<RequestT, ReplyT>> repHandlerPtr(
+        new RepHandler<RequestT, ReplyT>());
+
+      // Insert the callback into the handler.
+      repHandlerPtr->SetBatchCallback(_cb);
+
+      std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+      // Add the topic to the list of advertised services.
+      this->SrvsAdvertised().insert(fullyQualifiedTopic);
+
+      // Store the replier handler.
+      this->Shared()->repliers.AddHandler(
+        fullyQualifiedTopic, this->NodeUuid(), repHandlerPtr);
+
+      // Other processes may call the service.
+      this->Shared()->EnsureNetwork();
+
+      // Notify the discovery service to register and advertise my responser.
+      // Batches use the same request and response types.
+      ServicePublisher publisher(fullyQualifiedTopic,
+        this->Shared()->myReplierAddress,
+        this->Shared()->replierId.ToString(),
+        this->Shared()->pUuid, this->NodeUuid(),
+        RequestT().GetTypeName(), ReplyT().GetTypeName(), _options);
+
+      if (!this->Shared()->AdvertisePublisher(publisher))
+      {
+        std::cerr << "Node::AdvertiseBatch(): Error advertising service ["
+                  << topic
+                  << "]. Did you forget to start the discovery service?"
+                  << std::endl;
+        return false;
+      }
+
+      return true;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::AdvertiseStream(
+      const std::string &_topic,
+      std::function<bool(const RequestT &,
+        const std::function<bool(const ReplyT &)> &)> _cb,
+      const AdvertiseServiceOptions &_options)
+    {
+      // Topic remapping.
+      std::string topic = _topic;
+      this->Options().TopicRemap(_topic, topic);
+
+      std::string fullyQualifiedTopic;
+      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+      {
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        return false;
+      }
+
+      if (!_cb)
+      {
+        std::cerr << "Node::AdvertiseStream(): Invalid callback" << std::endl;
+        return false;
+      }
+
+      // Create a new service reply handler.
+      std::shared_ptr<RepHandler<RequestT, ReplyT>> repHandlerPtr(
+        new RepHandler<RequestT, ReplyT>());
+
+      // Insert the callback into the handler.
+      repHandlerPtr->SetStreamCallback(_cb);
+
+      std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+      // Add the topic to the list of advertised services.
+      this->SrvsAdvertised().insert(fullyQualifiedTopic);
+
+      // Store the replier handler.
+      this->Shared()->repliers.AddHandler(
+        fullyQualifiedTopic, this->NodeUuid(), repHandlerPtr);
+
+      // Other processes may call the service.
+      this->Shared()->EnsureNetwork();
+
+      // Notify the discovery service to register and advertise my responser.
+      // Streams use the same request and response types.
+      ServicePublisher publisher(fullyQualifiedTopic,
+        this->Shared()->myReplierAddress,
+        this->Shared()->replierId.ToString(),
+        this->Shared()->pUuid, this->NodeUuid(),
+        RequestT().GetTypeName(), ReplyT().GetTypeName(), _options);
+
+      if (!this->Shared()->AdvertisePublisher(publisher))
+      {
+        std::cerr << "Node::AdvertiseStream(): Error advertising service ["
+                  << topic
+                  << "]. Did you forget to start the discovery service?"
+                  << std::endl;
+        return false;
+      }
+
+      return true;
+    }
+
     //////////////////////////////////////////////////
     template<typename ReplyT>
     bool Node::Advertise(
@@ -402,25 +717,41 @@ namespace gz
       const RequestT &_request,
       std::function<void(const ReplyT &_reply, const bool _result)> &_cb)
     {
-      // Topic remapping.
-      std::string topic = _topic;
-      this->Options().TopicRemap(_topic, topic);
-
-      std::string fullyQualifiedTopic;
-      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
-        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+      const std::string *name = this->FullyQualifiedName(_topic);
+      if (!name)
       {
+        std::string topic = _topic;
+        this->Options().TopicRemap(_topic, topic);
         std::cerr << "Service [" << topic << "] is not valid." << std::endl;
         return false;
       }
 
+      return this->RequestResolved(_topic, *name,
+        this->Options().ServiceBalancing(_topic), _request, _cb);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::RequestResolved(
+      const std::string &_topic,
+      const std::string &_fullyQualifiedTopic,
+      const ServiceBalancing_t _balancing,
+      const RequestT &_request,
+      std::function<void(const ReplyT &_reply, const bool _result)> &_cb)
+    {
+      const std::string &fullyQualifiedTopic = _fullyQualifiedTopic;
+
+      // The service call being served by this thread already gave up.
+      if (ServiceContext::Expired())
+        return false;
+
       bool localResponserFound;
       IRepHandlerPtr repHandler;
       {
         std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
         localResponserFound = this->Shared()->repliers.FirstHandler(
               fullyQualifiedTopic,
-              RequestT().GetTypeName(),
+              _request.GetTypeName(),
               ReplyT().GetTypeName(),
               repHandler);
       }
@@ -430,18 +761,36 @@ namespace gz
       {
         // There is a responser in my process, let's use it.
         ReplyT rep;
+        const auto start = std::chrono::steady_clock::now();
         bool result = repHandler->RunLocalCallback(_request, rep);
+        Metrics::Instance().RecordLocalRequest(fullyQualifiedTopic,
+          std::chrono::steady_clock::now() - start, result);
 
         _cb(rep, result);
         return true;
       }
 
+      // An idempotent service in another process may have answered already.
+      std::string cached;
+      if (this->Shared()->CachedResponse(fullyQualifiedTopic, _request,
+        ReplyT().GetTypeName(), cached))
+      {
+        ReplyT rep;
+        if (rep.ParseFromString(cached))
+        {
+          _cb(rep, true);
+          return true;
+        }
+      }
+
       // Create a new request handler.
       std::shared_ptr<ReqHandler<RequestT, ReplyT>> reqHandlerPtr(
         new ReqHandler<RequestT, ReplyT>(this->NodeUuid()));
 
       // Insert the request's parameters.
       reqHandlerPtr->SetMessage(&_request);
+      reqHandlerPtr->SetBalancing(_balancing);
+      reqHandlerPtr->SetDeadline(ServiceContext::Deadline());
 
       // Insert the callback into the handler.
       reqHandlerPtr->SetCallback(_cb);
@@ -453,12 +802,15 @@ namespace gz
         this->Shared()->requests.AddHandler(
           fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
 
+        // The responsers may run in other processes.
+        this->Shared()->EnsureNetwork();
+
         // If the responser's address is known, make the request.
         SrvAddresses_M addresses;
         if (this->Shared()->TopicPublishers(fullyQualifiedTopic, addresses))
         {
           this->Shared()->SendPendingRemoteReqs(fullyQualifiedTopic,
-            RequestT().GetTypeName(), ReplyT().GetTypeName());
+            _request.GetTypeName(), ReplyT().GetTypeName());
         }
         else
         {
@@ -466,7 +818,7 @@ namespace gz
           if (!this->Shared()->DiscoverService(fullyQualifiedTopic))
           {
             std::cerr << "Node::Request(): Error discovering service ["
-                      << topic
+                      << _topic
                       << "]. Did you forget to start the discovery service?"
                       << std::endl;
             return false;
@@ -487,6 +839,377 @@ namespace gz
       return this->Request(_topic, req, _cb);
     }
 
+    //////////////////////////////////////////////////
+    template<typename ReplyT, typename RequestT>
+    std::future<std::optional<ReplyT>> Node::RequestAsync(
+      const std::string &_topic,
+      const RequestT &_request)
+    {
+      auto promise = std::make_shared<std::promise<std::optional<ReplyT>>>();
+      auto future = promise->get_future();
+
+      std::function<void(const ReplyT &, const bool)> f =
+        [promise](const ReplyT &_rep, const bool _result)
+      {
+        if (_result)
+          promise->set_value(_rep);
+        else
+          promise->set_value(std::nullopt);
+      };
+
+      if (!this->Request<RequestT, ReplyT>(_topic, _request, f))
+      {
+        // The callback can't run anymore.
+        std::promise<std::optional<ReplyT>> failed;
+        failed.set_value(std::nullopt);
+        return failed.get_future();
+      }
+
+      return future;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename ReplyT>
+    std::future<std::optional<ReplyT>> Node::RequestAsync(
+      const std::string &_topic)
+    {
+      msgs::Empty req;
+      return this->RequestAsync<ReplyT>(_topic, req);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    Node::ServiceClient<RequestT, ReplyT> Node::CreateServiceClient(
+      const std::string &_topic)
+    {
+      ServiceClient<RequestT, ReplyT> client;
+      const std::string *name = this->FullyQualifiedName(_topic);
+      if (!name)
+      {
+        std::string topic = _topic;
+        this->Options().TopicRemap(_topic, topic);
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        return client;
+      }
+
+      client.node = this;
+      client.topic = _topic;
+      client.fullyQualifiedTopic = name;
+      client.balancing = this->Options().ServiceBalancing(_topic);
+      return client;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::ServiceClient<RequestT, ReplyT>::Valid() const
+    {
+      return this->node != nullptr;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    Node::ServiceClient<RequestT, ReplyT>::operator bool() const
+    {
+      return this->Valid();
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    const std::string &Node::ServiceClient<RequestT, ReplyT>::Service() const
+    {
+      return this->topic;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::ServiceClient<RequestT, ReplyT>::Request(
+      const RequestT &_request,
+      const unsigned int _timeout,
+      ReplyT &_reply,
+      bool &_result) const
+    {
+      if (!this->Valid())
+        return false;
+
+      return this->node->RequestResolved(this->topic,
+        *this->fullyQualifiedTopic, this->balancing, _request, _timeout,
+        _reply, _result);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::ServiceClient<RequestT, ReplyT>::Request(
+      const RequestT &_request,
+      std::function<void(const ReplyT &_reply, const bool _result)> _cb)
+      const
+    {
+      if (!this->Valid())
+        return false;
+
+      return this->node->RequestResolved(this->topic,
+        *this->fullyQualifiedTopic, this->balancing, _request, _cb);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    std::future<std::optional<ReplyT>>
+    Node::ServiceClient<RequestT, ReplyT>::RequestAsync(
+      const RequestT &_request) const
+    {
+      auto promise = std::make_shared<std::promise<std::optional<ReplyT>>>();
+      auto future = promise->get_future();
+
+      std::function<void(const ReplyT &, const bool)> f =
+        [promise](const ReplyT &_rep, const bool _result)
+      {
+        if (_result)
+          promise->set_value(_rep);
+        else
+          promise->set_value(std::nullopt);
+      };
+
+      if (!this->Request(_request, f))
+      {
+        // The callback can't run anymore.
+        std::promise<std::optional<ReplyT>> failed;
+        failed.set_value(std::nullopt);
+        return failed.get_future();
+      }
+
+      return future;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::RequestStream(
+      const std::string &_topic,
+      const RequestT &_request,
+      std::function<void(const ReplyT &)> _chunkCb,
+      std::function<void(const bool)> _doneCb)
+    {
+      const std::string *name = this->FullyQualifiedName(_topic);
+      if (!name)
+      {
+        std::string topic = _topic;
+        this->Options().TopicRemap(_topic, topic);
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        return false;
+      }
+      const std::string &fullyQualifiedTopic = *name;
+
+      // The service call being served by this thread already gave up.
+      if (ServiceContext::Expired())
+        return false;
+
+      bool localResponserFound;
+      IRepHandlerPtr repHandler;
+      {
+        std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+        localResponserFound = this->Shared()->repliers.FirstHandler(
+              fullyQualifiedTopic,
+              _request.GetTypeName(),
+              ReplyT().GetTypeName(),
+              repHandler);
+      }
+
+      // If the responser is within my process.
+      if (localResponserFound)
+      {
+        // There is a responser in my process, the chunks are delivered
+        // while the callback runs.
+        const auto start = std::chrono::steady_clock::now();
+        bool result = repHandler->RunLocalStreamCallback(_request,
+          [&_chunkCb](const ProtoMsg &_msg)
+          {
+            if (!_chunkCb)
+              return true;
+
+            auto chunk = dynamic_cast<const ReplyT *>(&_msg);
+            if (chunk)
+            {
+              _chunkCb(*chunk);
+              return true;
+            }
+
+            ReplyT copy;
+            if (!copy.ParseFromString(_msg.SerializeAsString()))
+              return false;
+            _chunkCb(copy);
+            return true;
+          });
+        Metrics::Instance().RecordLocalRequest(fullyQualifiedTopic,
+          std::chrono::steady_clock::now() - start, result);
+
+        if (_doneCb)
+          _doneCb(result);
+        return true;
+      }
+
+      // Create a new request handler.
+      std::shared_ptr<StreamReqHandler<RequestT, ReplyT>> reqHandlerPtr(
+        new StreamReqHandler<RequestT, ReplyT>(this->NodeUuid()));
+
+      // Insert the request's parameters and the callbacks.
+      reqHandlerPtr->SetMessage(_request);
+      reqHandlerPtr->SetCallbacks(_chunkCb, _doneCb);
+      reqHandlerPtr->SetBalancing(this->Options().ServiceBalancing(_topic));
+      reqHandlerPtr->SetDeadline(ServiceContext::Deadline());
+
+      std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+      // Store the request handler.
+      this->Shared()->requests.AddHandler(
+        fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
+
+      // The responsers may run in other processes.
+      this->Shared()->EnsureNetwork();
+
+      // If the responser's address is known, make the request.
+      SrvAddresses_M addresses;
+      if (this->Shared()->TopicPublishers(fullyQualifiedTopic, addresses))
+      {
+        this->Shared()->SendPendingRemoteReqs(fullyQualifiedTopic,
+          _request.GetTypeName(), ReplyT().GetTypeName());
+      }
+      else
+      {
+        // Discover the service responser.
+        if (!this->Shared()->DiscoverService(fullyQualifiedTopic))
+        {
+          std::cerr << "Node::RequestStream(): Error discovering service ["
+                    << _topic
+                    << "]. Did you forget to start the discovery service?"
+                    << std::endl;
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::RequestBatch(
+      const std::string &_topic,
+      const std::vector<RequestT> &_requests,
+      const unsigned int &_timeout,
+      std::vector<ReplyT> &_replies,
+      std::vector<bool> &_results)
+    {
+      _replies.assign(_requests.size(), ReplyT());
+      _results.assign(_requests.size(), false);
+      if (_requests.empty())
+        return true;
+
+      const std::string *name = this->FullyQualifiedName(_topic);
+      if (!name)
+      {
+        std::string topic = _topic;
+        this->Options().TopicRemap(_topic, topic);
+        std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+        return false;
+      }
+      const std::string &fullyQualifiedTopic = *name;
+
+      // Create a new request handler.
+      std::shared_ptr<BatchReqHandler<RequestT, ReplyT>> reqHandlerPtr(
+        new BatchReqHandler<RequestT, ReplyT>(this->NodeUuid()));
+
+      // The batch can't outlive the service call being served.
+      const auto deadline = ServiceContext::Deadline(_timeout);
+      if (deadline <= std::chrono::steady_clock::now())
+        return false;
+
+      // Insert the requests' parameters.
+      if (!reqHandlerPtr->SetMessages(_requests))
+        return false;
+      reqHandlerPtr->SetBalancing(this->Options().ServiceBalancing(_topic));
+      reqHandlerPtr->SetDeadline(deadline);
+
+      std::unique_lock<std::recursive_mutex> lk(this->Shared()->mutex);
+
+      // If the responser is within my process.
+      IRepHandlerPtr repHandler;
+      if (this->Shared()->repliers.FirstHandler(fullyQualifiedTopic,
+        RequestT().GetTypeName(), ReplyT().GetTypeName(), repHandler))
+      {
+        lk.unlock();
+
+        // There is a responser in my process, let's use it.
+        ServiceContext context(deadline);
+        std::vector<std::string> reqs(_requests.size());
+        for (std::size_t i = 0; i < _requests.size(); ++i)
+          _requests[i].SerializeToString(&reqs[i]);
+
+        std::vector<std::string> reps;
+        std::vector<bool> results;
+        const auto start = std::chrono::steady_clock::now();
+        repHandler->RunBatchCallback(reqs, reps, results);
+        Metrics::Instance().RecordLocalRequest(fullyQualifiedTopic,
+          std::chrono::steady_clock::now() - start, true);
+        for (std::size_t i = 0; i < _requests.size(); ++i)
+          _results[i] = results[i] && _replies[i].ParseFromString(reps[i]);
+        return true;
+      }
+
+      // Store the request handler.
+      this->Shared()->requests.AddHandler(
+        fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
+
+      // The responsers may run in other processes.
+      this->Shared()->EnsureNetwork();
+
+      // If the responser's address is known, make the request.
+      SrvAddresses_M addresses;
+      if (this->Shared()->TopicPublishers(fullyQualifiedTopic, addresses))
+      {
+        this->Shared()->SendPendingRemoteReqs(fullyQualifiedTopic,
+          RequestT().GetTypeName(), ReplyT().GetTypeName());
+      }
+      else
+      {
+        // Discover the service responser.
+        if (!this->Shared()->DiscoverService(fullyQualifiedTopic))
+        {
+          std::cerr << "Node::RequestBatch(): Error discovering service ["
+                    << _topic
+                    << "]. Did you forget to start the discovery service?"
+                    << std::endl;
+          return false;
+        }
+      }
+
+      // Wait until the REP is available.
+      if (!reqHandlerPtr->WaitUntil(lk, deadline))
+      {
+        this->Shared()->requests.RemoveHandler(fullyQualifiedTopic,
+          this->NodeUuid(), reqHandlerPtr->HandlerUuid());
+        return false;
+      }
+
+      // The batch was executed but did not succeed.
+      if (!reqHandlerPtr->Result())
+        return true;
+
+      // Each response is preceded by the result of its request.
+      std::vector<std::string> reps;
+      if (!splitSizePrefixed(reqHandlerPtr->Response(), reps) ||
+          reps.size() != _requests.size())
+      {
+        std::cerr << "Node::RequestBatch(): Error Parsing the responses"
+                  << std::endl;
+        return true;
+      }
+
+      for (std::size_t i = 0; i < reps.size(); ++i)
+      {
+        _results[i] = !reps[i].empty() && reps[i][0] == '1' &&
+          _replies[i].ParseFromArray(reps[i].data() + 1,
+            static_cast<int>(reps[i].size() - 1));
+      }
+      return true;
+    }
+
     //////////////////////////////////////////////////
     template<typename ClassT, typename RequestT, typename ReplyT>
     bool Node::Request(
@@ -526,25 +1249,47 @@ namespace gz
             ReplyT &_reply,
             bool &_result)
     {
-      // Topic remapping.
-      std::string topic = _topic;
-      this->Options().TopicRemap(_topic, topic);
-
-      std::string fullyQualifiedTopic;
-      if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
-        this->Options().NameSpace(), topic, fullyQualifiedTopic))
+      const std::string *name = this->FullyQualifiedName(_topic);
+      if (!name)
       {
+        std::string topic = _topic;
+        this->Options().TopicRemap(_topic, topic);
         std::cerr << "Service [" << topic << "] is not valid." << std::endl;
         return false;
       }
 
+      return this->RequestResolved(_topic, *name,
+        this->Options().ServiceBalancing(_topic), _request, _timeout, _reply,
+        _result);
+    }
+
+    //////////////////////////////////////////////////
+    template<typename RequestT, typename ReplyT>
+    bool Node::RequestResolved(
+            const std::string &_topic,
+            const std::string &_fullyQualifiedTopic,
+            const ServiceBalancing_t _balancing,
+            const RequestT &_request,
+            const unsigned int _timeout,
+            ReplyT &_reply,
+            bool &_result)
+    {
+      const std::string &fullyQualifiedTopic = _fullyQualifiedTopic;
+
       // Create a new request handler.
       std::shared_ptr<ReqHandler<RequestT, ReplyT>> reqHandlerPtr(
         new ReqHandler<RequestT, ReplyT>(this->NodeUuid()));
 
+      // The request can't outlive the service call being served.
+      const auto deadline = ServiceContext::Deadline(_timeout);
+      if (deadline <= std::chrono::steady_clock::now())
+        return false;
+
       // Insert the request's parameters.
       reqHandlerPtr->SetMessage(&_request);
+      reqHandlerPtr->SetBalancing(_balancing);
       reqHandlerPtr->SetResponse(&_reply);
+      reqHandlerPtr->SetDeadline(deadline);
 
       std::unique_lock<std::recursive_mutex> lk(this->Shared()->mutex);
 
@@ -554,7 +1299,20 @@ namespace gz
         _request.GetTypeName(), _reply.GetTypeName(), repHandler))
       {
         // There is a responser in my process, let's use it.
+        ServiceContext context(deadline);
+        const auto start = std::chrono::steady_clock::now();
         _result = repHandler->RunLocalCallback(_request, _reply);
+        Metrics::Instance().RecordLocalRequest(fullyQualifiedTopic,
+          std::chrono::steady_clock::now() - start, _result);
+        return true;
+      }
+
+      // An idempotent service in another process may have answered already.
+      std::string cached;
+      if (this->Shared()->CachedResponse(fullyQualifiedTopic, _request,
+        _reply.GetTypeName(), cached) && _reply.ParseFromString(cached))
+      {
+        _result = true;
         return true;
       }
 
@@ -562,6 +1320,9 @@ namespace gz
       this->Shared()->requests.AddHandler(
         fullyQualifiedTopic, this->NodeUuid(), reqHandlerPtr);
 
+      // The responsers may run in other processes.
+      this->Shared()->EnsureNetwork();
+
       // If the responser's address is known, make the request.
       SrvAddresses_M addresses;
       if (this->Shared()->TopicPublishers(fullyQualifiedTopic, addresses))
@@ -575,7 +1336,7 @@ namespace gz
         if (!this->Shared()->DiscoverService(fullyQualifiedTopic))
         {
           std::cerr << "Node::Request(): Error discovering service ["
-                    << topic
+                    << _topic
                     << "]. Did you forget to start the discovery service?"
                     << std::endl;
           return false;
@@ -583,11 +1344,15 @@ namespace gz
       }
 
       // Wait until the REP is available.
-      bool executed = reqHandlerPtr->WaitUntil(lk, _timeout);
+      bool executed = reqHandlerPtr->WaitUntil(lk, deadline);
 
-      // The request was not executed.
+      // The request was not executed. A late response is ignored.
       if (!executed)
+      {
+        this->Shared()->requests.RemoveHandler(fullyQualifiedTopic,
+          this->NodeUuid(), reqHandlerPtr->HandlerUuid());
         return false;
+      }
 
       // The request was executed but did not succeed.
       if (!reqHandlerPtr->Result())
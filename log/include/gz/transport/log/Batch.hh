@@ -18,6 +18,8 @@
 #ifndef GZ_TRANSPORT_LOG_BATCH_HH_
 #define GZ_TRANSPORT_LOG_BATCH_HH_
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
 
 #include <gz/transport/config.hh>
@@ -77,6 +79,43 @@ namespace gz
         ///   to a valid message
         public: iterator end();
 
+        /// \brief Read the messages ahead of the iterators created after
+        /// this call. A background thread decodes up to _messages messages
+        /// (and up to _bytes bytes of data) before they are reached, so that
+        /// the time spent reading the log overlaps with the processing of
+        /// the messages. The messages and their order are the same.
+        /// \remarks The log file must stay open while iterating, and the
+        /// sqlite3 library must be threadsafe to read SQLite logs ahead.
+        /// \param[in] _messages Maximum number of messages read ahead, or 0
+        /// to read the messages only when the iterator is advanced (default)
+        /// \param[in] _bytes Maximum size of the messages read ahead, or 0 for
+        /// no limit. A message larger than this is still read ahead, alone.
+        public: void SetReadAhead(std::size_t _messages,
+                                  std::size_t _bytes = 0);
+
+        /// \brief Read every message of the batch into a single buffer, so
+        /// that the iterators created after this call give them without
+        /// reading the log again. Rewinding to the first message or finding
+        /// the message at a time is then immediate, which suits short logs
+        /// that are played back repeatedly.
+        /// \param[in] _maxBytes Maximum size of the messages, or 0 for no
+        /// limit. The batch keeps reading the log if they don't fit.
+        /// \return True if the messages are in memory.
+        public: bool Preload(std::size_t _maxBytes = 0);
+
+        /// \brief Tell whether the messages were read into memory by
+        /// Preload().
+        /// \return True if the messages are in memory.
+        public: bool Preloaded() const;
+
+        /// \brief Iterator to the first message received at or after a
+        /// time, assuming that the messages are in time order. The message
+        /// is found by a binary search if the batch was preloaded, and by
+        /// skipping the earlier messages otherwise.
+        /// \param[in] _time Time received
+        /// \return An iterator to the message, or end() if there is none.
+        public: iterator Find(const std::chrono::nanoseconds &_time);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::*
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_LOG_COLUMNEXPORTER_HH_
+#define GZ_TRANSPORT_LOG_COLUMNEXPORTER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <gz/transport/config.hh>
+#include <gz/transport/log/Export.hh>
+#include <gz/transport/log/Log.hh>
+#include <gz/transport/log/QualifiedTime.hh>
+
+namespace gz
+{
+  namespace transport
+  {
+    namespace log
+    {
+      // Inline bracket to help doxygen filtering.
+      inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+      //
+      /// \brief Exports the messages of a topic of a log as a table, with a
+      /// row per message and a column per field, e.g. to load a topic into
+      /// data analysis tools without decoding each message there. The
+      /// messages are decoded on several threads, in blocks, and the rows are
+      /// written in time order.
+      class GZ_TRANSPORT_LOG_VISIBLE ColumnExporter
+      {
+        /// \brief Constructor.
+        public: ColumnExporter();
+
+        /// \brief Destructor.
+        public: ~ColumnExporter();
+
+        /// \brief Add a column, after the ones already added.
+        /// \param[in] _path Path of a scalar field of the messages, with the
+        /// names of the fields separated by dots, e.g. "position.x". An
+        /// element of a repeated field is selected by its index, e.g.
+        /// "pose[2].name". A repeated scalar field without an index gives all
+        /// its values, separated by spaces.
+        public: void AddColumn(const std::string &_path);
+
+        /// \brief Get the columns.
+        /// \return The path of each column, in order.
+        public: const std::vector<std::string> &Columns() const;
+
+        /// \brief Set the number of threads decoding the messages.
+        /// \param[in] _threads Number of threads, or 0 for the number of
+        /// cores (default).
+        public: void SetThreads(std::size_t _threads);
+
+        /// \brief Export the messages of a topic as CSV. The first row names
+        /// the columns, the first column is the time each message was
+        /// received (ns). A field missing from a message, e.g. an element
+        /// past the end of a repeated field, gives an empty cell. Enums are
+        /// written by name and bytes in hexadecimal.
+        /// \param[in] _log The log to read
+        /// \param[in] _topic The topic to export. All its messages must be of
+        /// the same type, which must be known to gz-msgs.
+        /// \param[out] _output Stream to write to
+        /// \param[in] _range Time range of the messages to export
+        /// \return Number of rows written, not counting the header, or -1 if
+        /// the topic or a column doesn't exist, or the stream failed.
+        public: int64_t ExportCsv(Log &_log, const std::string &_topic,
+            std::ostream &_output,
+            const QualifiedTimeRange &_range =
+              QualifiedTimeRange::AllTime()) const;
+
+        /// \internal Implementation of this class
+        private: class Implementation;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+        /// \internal Pointer to the implementation of this class
+        private: std::unique_ptr<Implementation> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+      };
+      }
+    }
+  }
+}
+#endif
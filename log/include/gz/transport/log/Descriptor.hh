@@ -77,6 +77,13 @@ namespace gz
           const std::string &_topicName,
           const std::string &_msgType) const;
 
+        /// \brief Whether the messages of the log are indexed by topic and
+        /// time received, so that a query can read the messages of a topic
+        /// without scanning the messages of the other topics.
+        /// \return True if the log has a (topic_id, time_recv) index. Logs
+        /// with a schema older than 0.2.0 don't have it, see Log::Migrate().
+        public: bool TopicTimeIndexed() const;
+
         // The Log class is a friend so that it can construct a Descriptor
         friend class Log;
 
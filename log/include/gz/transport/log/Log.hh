@@ -19,15 +19,21 @@
 #define GZ_TRANSPORT_LOG_LOG_HH_
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <ios>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <gz/transport/config.hh>
 #include <gz/transport/log/Batch.hh>
 #include <gz/transport/log/QueryOptions.hh>
+#include <gz/transport/log/RecordOptions.hh>
 #include <gz/transport/log/Descriptor.hh>
 #include <gz/transport/log/Export.hh>
+#include <gz/transport/log/Message.hh>
 
 namespace gz
 {
@@ -41,6 +47,76 @@ namespace gz
       /// \brief Name of Environment variable containing path to schema
       const std::string SchemaLocationEnvVar = "GZ_TRANSPORT_LOG_SQL_PATH";
 
+      /// \brief Summary of the messages of a topic in a log
+      struct TopicSummary
+      {
+        /// \brief Name of the topic
+        std::string topic;
+
+        /// \brief Message type of the topic
+        std::string type;
+
+        /// \brief Number of messages
+        uint64_t messages = 0;
+
+        /// \brief Total size of the serialized messages (bytes)
+        uint64_t bytes = 0;
+
+        /// \brief Time the first message was received
+        std::chrono::nanoseconds startTime{0};
+
+        /// \brief Time the last message was received
+        std::chrono::nanoseconds endTime{0};
+      };
+
+      /// \brief Metadata of a message in a log, without its data
+      struct MessageMetadata
+      {
+        /// \brief Time the message was received
+        std::chrono::nanoseconds timeReceived{0};
+
+        /// \brief Name of the topic
+        std::string topic;
+
+        /// \brief Message type of the topic
+        std::string type;
+
+        /// \brief Size of the serialized message (bytes)
+        uint64_t size = 0;
+      };
+
+      /// \brief Messages of a topic received during a bucket of time
+      struct TopicBucket
+      {
+        /// \brief Name of the topic
+        std::string topic;
+
+        /// \brief Message type of the topic
+        std::string type;
+
+        /// \brief Beginning of the bucket, a multiple of its duration
+        std::chrono::nanoseconds start{0};
+
+        /// \brief Number of messages
+        uint64_t messages = 0;
+
+        /// \brief Total size of the serialized messages (bytes)
+        uint64_t bytes = 0;
+      };
+
+      /// \brief How Log::QueryMessagesParallel() splits a query between
+      /// threads
+      enum class QueryPartitioning
+      {
+        /// \brief Each thread gets every message of some of the topics. The
+        /// topics are balanced by size when the log keeps their summaries.
+        TOPIC,
+
+        /// \brief Each thread gets every message of a slice of the time
+        /// range of the query, the slices being of equal duration
+        TIME
+      };
+
       /// \brief Interface to a log file
       class GZ_TRANSPORT_LOG_VISIBLE Log
       {
@@ -72,9 +148,62 @@ namespace gz
         public: bool Open(const std::string &_file,
             std::ios_base::openmode _mode = std::ios_base::in);
 
+        /// \brief Open a log file
+        /// \param[in] _file path to log file
+        /// \param[in] _mode flag indicating read only or read/write
+        ///   Can use (in or out)
+        /// \param[in] _options Durability and performance options, used
+        /// when the log file is opened for writing
+        /// \return True if the log file was successfully opened, false
+        /// otherwise.
+        public: bool Open(const std::string &_file,
+            std::ios_base::openmode _mode, const RecordOptions &_options);
+
+        /// \brief Open the files of a split recording for reading, as a
+        /// single log. Queries return the messages of every file, one file
+        /// after the other, so the files must be given in recording order.
+        /// \param[in] _files Paths of the files, e.g. from SplitFiles().
+        /// \return True if every file was successfully opened.
+        public: bool OpenSplit(const std::vector<std::string> &_files);
+
+        /// \brief Open several logs recorded at the same time for reading,
+        /// e.g. by the recorders of different processes, as a single log.
+        /// Queries merge the messages of the files in time order as they
+        /// are read, holding one message of each file at a time, so the
+        /// files don't need to be merged into a new log first. Messages
+        /// received at the same time are given in the order of the files.
+        /// \param[in] _files Paths of the files.
+        /// \return True if every file was successfully opened.
+        public: bool OpenMerged(const std::vector<std::string> &_files);
+
+        /// \brief Get the name of a file of a split recording.
+        /// \param[in] _file Path given to Recorder::Start(), which is also
+        /// the path of the first file.
+        /// \param[in] _index Index of the file, starting at 0.
+        /// \return The path of the file, e.g. "rec_2.tlog" for "rec.tlog"
+        /// and 2.
+        public: static std::string SplitFileName(const std::string &_file,
+                                                 std::size_t _index);
+
+        /// \brief Get the files of a split recording that exist.
+        /// \param[in] _file Path given to Recorder::Start().
+        /// \return The paths of the files, in recording order, or an empty
+        /// list if _file doesn't exist.
+        public: static std::vector<std::string> SplitFiles(
+            const std::string &_file);
+
+        /// \brief Update the schema of a log file to the latest version, e.g.
+        /// to add the indexes of newer versions to an older log. The log must
+        /// not be open.
+        /// \param[in] _file Path to the log file
+        /// \return True if the log has the latest schema. Chunked logs have no
+        /// schema and are left as they are.
+        public: static bool Migrate(const std::string &_file);
+
         /// \brief Get the name of the log file.
-        /// \return The name of the log file, or an empty string if Open has
-        /// not been successfully called.
+        /// \return The name of the log file, the first file of a split
+        /// recording, or an empty string if Open has not been successfully
+        /// called.
         public: std::string Filename() const;
 
         /// \brief Get a Descriptor for this log. The Descriptor will be
@@ -96,6 +225,36 @@ namespace gz
             const std::string &_topic, const std::string &_type,
             const void *_data, std::size_t _len);
 
+        /// \brief A message to insert with InsertMessages(). The topic, the
+        /// type and the data are borrowed and must outlive the call.
+        public: struct PendingMessage
+        {
+          /// \brief Time the message was received (ns since Unix epoch)
+          std::chrono::nanoseconds time;
+
+          /// \brief Name of the topic the message was on
+          const std::string &topic;
+
+          /// \brief Name of the message type
+          const std::string &type;
+
+          /// \brief Pointer to a buffer containing the message data
+          const void *data;
+
+          /// \brief Number of bytes of data
+          std::size_t len;
+        };
+
+        /// \brief Insert several messages into the log file. This is faster
+        /// than calling InsertMessage() for each one, as the messages are
+        /// written in the same transaction and consecutive messages of the
+        /// same topic share the topic lookup.
+        /// \param[in] _messages Pointer to the first message to insert
+        /// \param[in] _count Number of messages to insert
+        /// \return Number of messages successfully inserted
+        public: std::size_t InsertMessages(
+            const PendingMessage *_messages, std::size_t _count);
+
         /// \brief Get messages according to the specified options. By default,
         /// it will query all messages over the entire time range of the log.
         /// \param[in] _options A QueryOptions type to indicate what kind of
@@ -104,6 +263,128 @@ namespace gz
         public: Batch QueryMessages(
             const QueryOptions &_options = AllTopics());
 
+        /// \brief Get the messages committed to a SQLite log since the
+        /// previous call, to follow a log while it is being recorded, e.g. by
+        /// a Recorder in another process. The first call gets the messages
+        /// committed so far. Each call also reads again the topics, times and
+        /// summaries of the log if messages were committed since they were
+        /// read, so that Descriptor(), StartTime(), EndTime() and
+        /// TopicSummaries() include the new messages.
+        /// \remarks A log recorded with JournalMode::WAL can be read while
+        /// the recorder commits. Otherwise the reader waits for the commits
+        /// to finish.
+        /// \param[in] _options The messages to get, which must be built-in
+        /// options. A message committed since the previous call but not
+        /// selected by the options isn't given by the next call either.
+        /// \return A Batch with the new messages, in the order they were
+        /// inserted, which is empty if there is none.
+        public: Batch QueryNewMessages(
+            const QueryOptions &_options = AllTopics());
+
+        /// \brief Called with each message of a parallel query.
+        /// \param[in] _partition Index of the partition of the query the
+        /// message belongs to. The messages of a partition are given in time
+        /// order, by the same thread.
+        /// \param[in] _msg The message, valid until the callback returns
+        public: using PartitionCallback = std::function<void(
+            std::size_t _partition, const Message &_msg)>;
+
+        /// \brief Get messages according to the specified options on
+        /// several threads, e.g. to parse the messages of many topics on
+        /// several cores. The query is split in up to _threads partitions,
+        /// each read from its own connection to the log by its own thread,
+        /// which calls _callback with its messages. The callback is called
+        /// concurrently for different partitions.
+        /// \remarks The log file is opened again for reading by each thread,
+        /// so this doesn't see the messages this instance hasn't committed
+        /// yet. Custom query options can't be split, and run on one thread.
+        /// \param[in] _options The messages to get
+        /// \param[in] _threads Maximum number of threads
+        /// \param[in] _callback Called with each message
+        /// \param[in] _partitioning How to split the query
+        /// \return Number of partitions the query was split in, or 0 if the
+        /// query failed
+        public: std::size_t QueryMessagesParallel(
+            const QueryOptions &_options,
+            std::size_t _threads,
+            const PartitionCallback &_callback,
+            QueryPartitioning _partitioning = QueryPartitioning::TOPIC);
+
+        /// \brief Get messages according to the specified options, read by
+        /// several threads. The query is split like QueryMessagesParallel()
+        /// does, each partition being read ahead of the iterators by its own
+        /// thread from its own connection, and the partitions are merged in
+        /// time order. Messages received at the same time are given in
+        /// partition order.
+        /// \remarks The log file must stay available while iterating, and
+        /// the sqlite3 library must be threadsafe to read SQLite logs
+        /// ahead. Otherwise the partitions are read when the iterators are
+        /// advanced.
+        /// \param[in] _options The messages to get
+        /// \param[in] _threads Maximum number of threads
+        /// \param[in] _partitioning How to split the query
+        /// \return A Batch which matches the requested QueryOptions.
+        public: Batch QueryMessagesMerged(
+            const QueryOptions &_options,
+            std::size_t _threads,
+            QueryPartitioning _partitioning = QueryPartitioning::TOPIC);
+
+        /// \brief Copy the messages selected by a query into a new log file,
+        /// e.g. to keep only some topics or a time window of a large log.
+        /// The messages are not decoded. When both logs are SQLite logs and
+        /// the query uses the built-in options, SQLite copies the messages
+        /// itself, without reading them into memory. Otherwise they are
+        /// copied one by one.
+        /// \param[in] _file Path of the new log file. It must not exist.
+        /// \param[in] _options The messages to copy
+        /// \param[in] _recordOptions The options of the new log file
+        /// \return True if the messages were copied. The new file is removed
+        /// otherwise.
+        public: bool Extract(const std::string &_file,
+            const QueryOptions &_options = AllTopics(),
+            const RecordOptions &_recordOptions = RecordOptions());
+
+        /// \brief Called with the metadata of each message of a query.
+        /// \param[in] _metadata The metadata, valid until the callback
+        /// returns
+        public: using MetadataCallback = std::function<void(
+            const MessageMetadata &_metadata)>;
+
+        /// \brief Get the time, topic, type and size of the messages
+        /// selected by a query, without their data, e.g. to draw the
+        /// timeline of a log. SQLite reads the sizes from the headers of
+        /// the records when the query uses the built-in options, so the
+        /// messages themselves are not read. Chunked logs, merged logs and
+        /// custom options read the messages.
+        /// \param[in] _options The messages to get
+        /// \param[in] _callback Called with the metadata of each message,
+        /// in time order
+        /// \return False if the query failed
+        public: bool QueryMetadata(const QueryOptions &_options,
+            const MetadataCallback &_callback);
+
+        /// \brief Count the messages and bytes of each topic per bucket of
+        /// time, e.g. to plot the rate of the topics of a log. SQLite
+        /// aggregates the messages itself when the query uses the built-in
+        /// options, without reading them.
+        /// \param[in] _bucket Duration of the buckets. They start at the
+        /// multiples of their duration.
+        /// \param[in] _options The messages to count
+        /// \return The buckets with messages, ordered by start time, topic
+        /// name and message type, or an empty list if the query failed.
+        public: std::vector<TopicBucket> QueryHistogram(
+            const std::chrono::nanoseconds &_bucket,
+            const QueryOptions &_options = AllTopics());
+
+        /// \brief Get the plan SQLite uses to run a query, to check which
+        /// indexes it uses. The plan is also printed with the debug messages
+        /// of the log library when a query runs.
+        /// \param[in] _options The query
+        /// \return One line per step of the plan of each SQL statement of the
+        /// query, or an empty list if the log isn't a SQLite database.
+        public: std::vector<std::string> QueryPlan(
+            const QueryOptions &_options = AllTopics());
+
         /// \brief Get start time of the log, or in other words the
         /// time of the first message found in the log
         /// \return start time of the log, or zero if the log is not
@@ -116,6 +397,15 @@ namespace gz
         /// valid or if data retrieval failed.
         public: std::chrono::nanoseconds EndTime() const;
 
+        /// \brief Get the summary of every topic of the log. SQLite logs
+        /// with schema 0.3.0 or later keep the summaries up to date as
+        /// messages are inserted, so they are read without reading the
+        /// messages. Older logs and chunked logs are summarized by reading
+        /// their messages.
+        /// \return The summary of each topic with messages, ordered by topic
+        /// name and message type, or an empty list if the log is not valid.
+        public: std::vector<TopicSummary> TopicSummaries() const;
+
         /// \internal Implementation for this class
         private: class Implementation;
 
@@ -20,6 +20,7 @@
 #include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include <gz/transport/config.hh>
 #include <gz/transport/log/Export.hh>
@@ -61,6 +62,25 @@ namespace gz
             const char *_type, std::size_t _typeLen,
             const char *_topic, std::size_t _topicLen);
 
+        /// \brief Construct with data kept alive by an owner, so that it can
+        /// be shared beyond the life of the message, see SharedData().
+        /// \internal
+        /// The type and topic are borrowed as in the other constructor.
+        /// \param[in] _timeRecv time the message was received
+        /// \param[in] _owner keeps _data alive
+        /// \param[in] _data the serialized message
+        /// \param[in] _dataLen number of bytes in _data
+        /// \param[in] _type the name of the message type
+        /// \param[in] _typeLen the length of _type
+        /// \param[in] _topic the name of the topic the message was published to
+        /// \param[in] _topicLen the length of _topic
+        public: Message(
+            const std::chrono::nanoseconds &_timeRecv,
+            const std::shared_ptr<const void> &_owner,
+            const void *_data, std::size_t _dataLen,
+            const char *_type, std::size_t _typeLen,
+            const char *_topic, std::size_t _topicLen);
+
         /// \brief No move constructor to prevent borrowed pointers from
         /// living beyond creator's expectations.
         public: Message(Message && _other) = delete;
@@ -76,6 +96,24 @@ namespace gz
         /// \return The raw data for this message
         public: std::string Data() const;
 
+        /// \brief Get the message data without copying it. When the message
+        /// comes from a MsgIter, the view points to the storage of the log
+        /// (a memory-mapped chunk or the SQLite row) and is only valid until
+        /// the iterator is advanced or destroyed. Copy it with Data() to
+        /// keep it longer.
+        /// \return View of the raw data for this message
+        public: std::string_view DataView() const;
+
+        /// \brief Get the message data in a buffer that may outlive the
+        /// message and its iterator, e.g. to publish it with
+        /// Node::Publisher::PublishRaw() without copying it. The buffer is
+        /// shared with the batch when its messages are read ahead (see
+        /// Batch::SetReadAhead()) or preloaded (see Batch::Preload()), and
+        /// the data is copied otherwise.
+        /// \return The raw data for this message, of DataView().size()
+        /// bytes
+        public: std::shared_ptr<const char[]> SharedData() const;
+
         /// \brief Get the message type as a string
         /// \return The message type name
         public: std::string Type() const;
@@ -18,12 +18,17 @@
 #define GZ_TRANSPORT_LOG_PLAYBACK_HH_
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <regex>
 #include <string>
+#include <vector>
 
+#include <gz/transport/Clock.hh>
 #include <gz/transport/config.hh>
 #include <gz/transport/log/Export.hh>
+#include <gz/transport/log/QualifiedTime.hh>
 #include <gz/transport/NodeOptions.hh>
 
 namespace gz
@@ -39,6 +44,32 @@ namespace gz
       class PlaybackHandle;
       using PlaybackHandlePtr = std::shared_ptr<PlaybackHandle>;
 
+      /// \brief Timing of a playback, see PlaybackHandle::Statistics(). The
+      /// scheduling error of a message is the time it was published minus
+      /// the time it was due. Only the messages published at the time of
+      /// their timestamps are counted, not those of a playback as fast as
+      /// possible.
+      struct PlaybackStatistics
+      {
+        /// \brief Messages published at a scheduled time.
+        uint64_t scheduledMessages = 0;
+
+        /// \brief Messages published more than 1 ms after their time.
+        uint64_t lateMessages = 0;
+
+        /// \brief Scheduling error of the last message.
+        std::chrono::nanoseconds lastError{0};
+
+        /// \brief Largest scheduling error.
+        std::chrono::nanoseconds maxError{0};
+
+        /// \brief Mean scheduling error (ns).
+        double meanError = 0;
+
+        /// \brief Standard deviation of the scheduling error (ns).
+        double jitter = 0;
+      };
+
       //////////////////////////////////////////////////
       /// \brief Initiates playback of Gazebo Transport topics
       /// This class makes it easy to play topics from a log file
@@ -47,11 +78,22 @@ namespace gz
       class GZ_TRANSPORT_LOG_VISIBLE Playback
       {
         /// \brief Constructor
-        /// \param[in] _file path to log file
+        /// \param[in] _file path to log file. If it's the first file of a
+        /// split recording, the following files are played too, see
+        /// Log::SplitFiles().
         /// \param[in] _nodeOptions Options for creating a node.
         public: explicit Playback(const std::string &_file,
                                const NodeOptions &_nodeOptions = NodeOptions());
 
+        /// \brief Constructor to play several logs recorded at the same
+        /// time together, e.g. by the recorders of different processes. The
+        /// messages of the files are merged in time order as they are
+        /// played, see Log::OpenMerged().
+        /// \param[in] _files Paths of the log files.
+        /// \param[in] _nodeOptions Options for creating a node.
+        public: explicit Playback(const std::vector<std::string> &_files,
+                               const NodeOptions &_nodeOptions = NodeOptions());
+
         /// \brief move constructor
         /// \param[in] _old the instance being moved into this one
         public: Playback(Playback &&_old);  // NOLINT
@@ -62,7 +104,8 @@ namespace gz
         /// \brief Begin playing messages
         /// \param[in] _waitAfterAdvertising How long to wait before the
         /// publications begin after advertising the topics that will be played
-        /// back.
+        /// back. If SetWaitForSubscribers() is enabled, this is the longest
+        /// wait for the subscribers.
         /// \param[in] _msgWaiting True to wait between publication of
         /// messages based on the message timestamps. False to playback
         /// messages as fast as possible. Default value is true.
@@ -70,7 +113,8 @@ namespace gz
         /// \note The topic discovery process will need some time before
         /// publishing begins, or else subscribers in other processes will miss
         /// the outgoing messages. The default value is recommended unless you
-        /// are confident in the timing of your system.
+        /// are confident in the timing of your system, or wait for the
+        /// subscribers with SetWaitForSubscribers().
         ///
         /// \remark If your application uses another library that uses sqlite3,
         /// it may be unsafe to start multiple simultaneous PlaybackHandles from
@@ -93,6 +137,95 @@ namespace gz
             std::chrono::seconds(1),
             bool _msgWaiting = true) const;
 
+        /// \brief Set the rate of the playbacks started after this call,
+        /// relative to the time the messages were recorded. The default rate
+        /// is 1. See PlaybackHandle::SetRate().
+        /// \param[in] _rate Playback rate, between 0.1 and 100
+        /// \return True if the rate is valid, false otherwise.
+        public: bool SetRate(double _rate);
+
+        /// \brief Limit the number of messages that the playbacks started
+        /// after this call publish before they are acknowledged. See
+        /// PlaybackHandle::SetAcknowledgeWindow().
+        /// \param[in] _messages Maximum number of unacknowledged messages, or
+        /// 0 to publish without waiting for acknowledgements (default).
+        public: void SetAcknowledgeWindow(std::size_t _messages);
+
+        /// \brief Run the playbacks started after this call with a
+        /// real-time scheduling priority (SCHED_FIFO), so that other
+        /// processes don't delay the publications. This is only supported on
+        /// Linux, and needs the CAP_SYS_NICE capability or an RLIMIT_RTPRIO
+        /// limit; otherwise a warning is printed and the playback runs with
+        /// the normal priority.
+        /// \param[in] _realTime True to use a real-time priority
+        public: void SetRealTimePriority(bool _realTime);
+
+        /// \brief Publish the messages of the playbacks started after this
+        /// call from several threads, so that the publication of a large
+        /// message (e.g. a point cloud) doesn't delay the messages of other
+        /// topics due at the same time. The topics are spread over the
+        /// threads, and the messages of a topic are always published in
+        /// order by the same thread. Use as many threads as topics to give
+        /// each topic its own thread.
+        /// \param[in] _threads Number of publishing threads, or 0 to publish
+        /// from the playback thread (default)
+        public: void SetPublishThreads(std::size_t _threads);
+
+        /// \brief Pace the playbacks started after this call against a
+        /// clock, e.g. a NetworkClock driven by a simulator, instead of the
+        /// steady clock. A message is published once the clock has advanced
+        /// by the time since the previous one (scaled by the rate), so the
+        /// playback follows the clock when it runs faster or slower than real
+        /// time. The playback waits for the clock to be ready before it
+        /// starts.
+        /// \param[in] _clock The clock, or nullptr to use the steady clock
+        /// (default). It must outlive the playbacks.
+        public: void SetClock(const Clock *_clock);
+
+        /// \brief Publish the time of the playbacks started after this call
+        /// on a topic, as gz::msgs::Clock messages whose simulation time is
+        /// the time of the last message published. It must not be the topic
+        /// of the clock the playback is paced against.
+        /// \param[in] _topic Name of the topic, or empty to not publish the
+        /// time (default)
+        public: void SetClockTopic(const std::string &_topic);
+
+        /// \brief Play only the messages received in a time range in the
+        /// playbacks started after this call.
+        /// \param[in] _range Time range of the messages (default: all time)
+        public: void SetTimeRange(const QualifiedTimeRange &_range);
+
+        /// \brief Read the messages of the playbacks started after this call
+        /// into memory before they start, so that the playback doesn't read
+        /// the log. This suits short logs or ranges, especially when they are
+        /// looped (see SetLoop()). If the messages exceed the given size, a
+        /// warning is printed and they are read from the log during the
+        /// playback as usual.
+        /// \param[in] _maxBytes Maximum size of the messages, or 0 to not
+        /// preload them (default)
+        public: void SetPreload(std::size_t _maxBytes);
+
+        /// \brief Play the messages of the playbacks started after this call
+        /// over and over, until they are stopped. The first message of a
+        /// loop is due one time range after the first message of the
+        /// previous loop, i.e. the duration of the time range set with
+        /// SetTimeRange(), or of the log if its ends are not set. A playback
+        /// whose range lasts no time isn't looped. A looping playback never
+        /// finishes on its own.
+        /// \param[in] _loop True to loop the playbacks
+        public: void SetLoop(bool _loop);
+
+        /// \brief Start the playbacks started after this call as soon as
+        /// every topic played has a subscriber connected, instead of after
+        /// the fixed delay given to Start(). That delay becomes a timeout: if
+        /// some topics still have no subscriber when it expires, a warning is
+        /// printed and the playback starts anyway. Restrict the topics played
+        /// with AddTopic() to the ones that have subscribers, otherwise the
+        /// playback always waits for the whole timeout.
+        /// \param[in] _wait True to wait for the subscribers, false to wait
+        /// for the fixed delay (default)
+        public: void SetWaitForSubscribers(bool _wait);
+
         /// \brief Check if this Playback object has a valid log to play back
         /// \return true if this has a valid log to play back, otherwise false.
         public: bool Valid() const;
@@ -183,6 +316,40 @@ namespace gz
         /// \brief Check pause status
         public: bool IsPaused() const;
 
+        /// \brief Change the rate of the playback, relative to the time the
+        /// messages were recorded: at a rate of 2, a log of 10 minutes plays
+        /// in 5 minutes. Step() durations are in log time, so they are scaled
+        /// too. The rate has no effect on a playback started without waiting
+        /// between messages, which publishes them as fast as possible.
+        /// \param[in] _rate Playback rate, between 0.1 and 100
+        /// \return True if the rate is valid, false otherwise.
+        public: bool SetRate(double _rate);
+
+        /// \brief Get the rate of the playback
+        /// \return The playback rate
+        public: double Rate() const;
+
+        /// \brief Limit the number of messages published before they are
+        /// acknowledged with Acknowledge(). The playback waits before
+        /// publishing a message while this many messages are unacknowledged,
+        /// so that it does not get ahead of slow subscribers, e.g. when
+        /// publishing as fast as possible.
+        /// \param[in] _messages Maximum number of unacknowledged messages, or
+        /// 0 to publish without waiting for acknowledgements.
+        public: void SetAcknowledgeWindow(std::size_t _messages);
+
+        /// \brief Acknowledge messages published by the playback, e.g. once a
+        /// subscriber processed them. Only used when an acknowledge window is
+        /// set.
+        /// \param[in] _messages Number of messages to acknowledge
+        public: void Acknowledge(std::size_t _messages = 1);
+
+        /// \brief Get the timing of the messages published so far. The
+        /// scheduling error of each message is also printed with the debug
+        /// messages of the log library.
+        /// \return The statistics
+        public: PlaybackStatistics Statistics() const;
+
         /// \brief Block until playback runs out of messages to publish
         public: void WaitUntilFinished();
 
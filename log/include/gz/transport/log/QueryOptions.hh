@@ -234,6 +234,13 @@ namespace gz
         /// this option will query for.
         public: const std::regex &Pattern() const;
 
+        /// \brief Check whether a topic matches the pattern. The result of
+        /// each topic is kept, and shared with the copies of this option,
+        /// until the pattern is modified through Pattern().
+        /// \param[in] _topic The topic name.
+        /// \return True if the pattern matches the whole topic name.
+        public: bool Match(const std::string &_topic) const;
+
         // Documentation inherited
         public: std::vector<SqlStatement> GenerateStatements(
           const Descriptor &_descriptor) const override;
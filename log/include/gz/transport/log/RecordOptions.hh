@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_LOG_RECORDOPTIONS_HH_
+#define GZ_TRANSPORT_LOG_RECORDOPTIONS_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include <gz/transport/AdvertiseOptions.hh>
+#include <gz/transport/config.hh>
+#include <gz/transport/log/Export.hh>
+
+namespace gz
+{
+  namespace transport
+  {
+    namespace log
+    {
+      // Inline bracket to help doxygen filtering.
+      inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+      //
+      /// \brief Storage format of a log file.
+      enum class LogFormat
+      {
+        /// \brief SQLite database with a row per message (default).
+        SQLITE,
+
+        /// \brief Append-only file of compressed chunks of messages, with
+        /// an index per chunk and a summary at the end. Recording is
+        /// sequential I/O, at the cost of the flexibility of SQL queries.
+        /// The SQLite options don't apply to this format.
+        CHUNKED
+      };
+
+      /// \brief SQLite journal mode of a log file.
+      enum class JournalMode
+      {
+        /// \brief Rollback journal, deleted at the end of every transaction.
+        /// This is the SQLite default.
+        ROLLBACK,
+
+        /// \brief Write-ahead log. Readers don't block the writer and a
+        /// commit needs fewer writes, at the cost of a -wal file next to the
+        /// log while it's open. Not available for in-memory databases.
+        WAL,
+
+        /// \brief Rollback journal kept in memory. A crash in the middle of a
+        /// transaction may corrupt the log.
+        MEMORY,
+
+        /// \brief No journal. A crash in the middle of a transaction may
+        /// corrupt the log.
+        OFF
+      };
+
+      /// \brief How carefully SQLite syncs the log file to disk.
+      enum class Synchronous
+      {
+        /// \brief Never sync. A power loss or an OS crash may corrupt the log.
+        OFF,
+
+        /// \brief Sync at the critical moments only. With WAL a power loss
+        /// may lose the last transactions, but the log stays consistent.
+        NORMAL,
+
+        /// \brief Sync every transaction. This is the SQLite default.
+        FULL
+      };
+
+      /// \brief How SQLite returns the free pages of a log file to the file
+      /// system. It can only be chosen when the log file is created.
+      enum class AutoVacuum
+      {
+        /// \brief Keep the free pages in the file for later inserts. This
+        /// is the SQLite default.
+        NONE,
+
+        /// \brief Truncate the file at every commit that frees pages.
+        FULL,
+
+        /// \brief Keep the free pages until the log file is closed, when
+        /// they are truncated at once, so recording never waits for it.
+        INCREMENTAL
+      };
+
+      /// \brief Options to trade crash durability of a log file for write
+      /// throughput. The default options keep the SQLite defaults.
+      class GZ_TRANSPORT_LOG_VISIBLE RecordOptions
+      {
+        /// \brief Constructor.
+        public: RecordOptions();
+
+        /// \brief Copy constructor.
+        /// \param[in] _other RecordOptions to copy.
+        public: RecordOptions(const RecordOptions &_other);
+
+        /// \brief Destructor.
+        public: ~RecordOptions();
+
+        /// \brief Assignment operator.
+        /// \param[in] _other The other RecordOptions.
+        /// \return A reference to this instance.
+        public: RecordOptions &operator=(const RecordOptions &_other);
+
+        /// \brief Equality operator.
+        /// \param[in] _other The options to compare against.
+        /// \return True if this object matches the provided object.
+        public: bool operator==(const RecordOptions &_other) const;
+
+        /// \brief Inequality operator.
+        /// \param[in] _other The options to compare against.
+        /// \return True if this object doesn't match the provided object.
+        public: bool operator!=(const RecordOptions &_other) const;
+
+        /// \brief Get the journal mode.
+        /// \return The journal mode. Default: ROLLBACK.
+        public: JournalMode Journal() const;
+
+        /// \brief Set the journal mode.
+        /// \param[in] _mode The journal mode.
+        public: void SetJournal(JournalMode _mode);
+
+        /// \brief Get the synchronous mode.
+        /// \return The synchronous mode. Default: FULL.
+        public: log::Synchronous Synchronous() const;
+
+        /// \brief Set the synchronous mode.
+        /// \param[in] _mode The synchronous mode.
+        public: void SetSynchronous(log::Synchronous _mode);
+
+        /// \brief Get the page size of new log files.
+        /// \return Page size (bytes) or 0 for the SQLite default.
+        public: uint32_t PageSize() const;
+
+        /// \brief Set the page size of new log files. It must be a power of
+        /// two between 512 and 65536. Larger pages reduce the number of
+        /// writes of large messages. Existing log files keep their page size.
+        /// \param[in] _size Page size (bytes) or 0 for the SQLite default.
+        /// \return False if the size is invalid.
+        public: bool SetPageSize(uint32_t _size);
+
+        /// \brief Get the size of the page cache.
+        /// \return Cache size (KiB) or 0 for the SQLite default.
+        public: uint64_t CacheSize() const;
+
+        /// \brief Set the size of the page cache.
+        /// \param[in] _size Cache size (KiB) or 0 for the SQLite default.
+        public: void SetCacheSize(uint64_t _size);
+
+        /// \brief Get the size of the steps in which the log file grows.
+        /// \return Preallocation size (bytes) or 0 for the default of the
+        /// format. Default: 0.
+        public: uint64_t PreallocateSize() const;
+
+        /// \brief Set the size of the steps in which the log file grows.
+        /// Space is reserved on disk ahead of the writes in steps of this
+        /// size, so the file stays contiguous and the writes don't wait for
+        /// the file system to allocate blocks. SQLite log files otherwise
+        /// grow page by page (SQLITE_FCNTL_CHUNK_SIZE), and their size stays
+        /// a multiple of this size. Chunked log files reserve 64 MiB at a
+        /// time by default, on Linux only, and are truncated to their data
+        /// when closed.
+        /// \param[in] _size Preallocation size (bytes) or 0 for the
+        /// default of the format. SQLite takes at most 2 GiB - 1.
+        public: void SetPreallocateSize(uint64_t _size);
+
+        /// \brief Get the auto-vacuum mode of new log files.
+        /// \return The auto-vacuum mode. Default: NONE.
+        public: log::AutoVacuum AutoVacuum() const;
+
+        /// \brief Set the auto-vacuum mode of new log files. Existing log
+        /// files keep their mode.
+        /// \param[in] _mode The auto-vacuum mode.
+        public: void SetAutoVacuum(log::AutoVacuum _mode);
+
+        /// \brief Get the maximum duration of a transaction. Messages are
+        /// inserted in transactions and written to disk when a transaction
+        /// ends, so this is also how much data a crash can lose.
+        /// \return The transaction period. Default: 500 ms.
+        public: std::chrono::milliseconds TransactionPeriod() const;
+
+        /// \brief Set the maximum duration of a transaction.
+        /// \param[in] _period The transaction period.
+        public: void SetTransactionPeriod(
+            const std::chrono::milliseconds &_period);
+
+        /// \brief Get the format of new log files.
+        /// \return The format. Default: SQLITE.
+        public: LogFormat Format() const;
+
+        /// \brief Set the format of new log files. The format of an existing
+        /// log file is detected when it's opened.
+        /// \param[in] _format The format.
+        public: void SetFormat(LogFormat _format);
+
+        /// \brief Get the size of the chunks of the CHUNKED format.
+        /// \return Uncompressed size of a chunk (bytes). Default: 4 MiB.
+        public: uint64_t ChunkSize() const;
+
+        /// \brief Set the size of the chunks of the CHUNKED format. A chunk is
+        /// written when its messages reach this size or when the transaction
+        /// period ends.
+        /// \param[in] _size Uncompressed size of a chunk (bytes).
+        public: void SetChunkSize(uint64_t _size);
+
+        /// \brief Get the codec used to compress the chunks.
+        /// \return The codec. Default: NONE.
+        public: Compression_t ChunkCompression() const;
+
+        /// \brief Get the level used to compress the chunks.
+        /// \return The compression level.
+        public: int ChunkCompressionLevel() const;
+
+        /// \brief Compress the chunks of the CHUNKED format.
+        /// \param[in] _codec The codec.
+        /// \param[in] _level Compression level, as in
+        /// AdvertiseMessageOptions::SetCompression().
+        /// \return False if the codec isn't available in this build.
+        public: bool SetChunkCompression(Compression_t _codec,
+                                         int _level = 0);
+
+        /// \brief Get the number of threads compressing the chunks.
+        /// \return The number of threads. Default: 0.
+        public: uint32_t CompressionThreads() const;
+
+        /// \brief Set the number of threads compressing the chunks of the
+        /// CHUNKED format. With 0, chunks are compressed by the thread that
+        /// writes the messages. Otherwise full chunks are compressed in
+        /// parallel while the next ones are filled, and written in order.
+        /// \param[in] _threads The number of threads.
+        public: void SetCompressionThreads(uint32_t _threads);
+
+        /// \brief Get the size after which a recording continues in a new
+        /// file.
+        /// \return Size of the messages of a file (bytes), or 0 if the
+        /// recording isn't split by size. Default: 0.
+        public: uint64_t SplitSize() const;
+
+        /// \brief Split a recording in files of a given size. Only used by
+        /// Recorder, see Log::SplitFileName() for the names of the files.
+        /// \param[in] _size Size of the messages of a file (bytes), or 0 to
+        /// not split by size.
+        public: void SetSplitSize(uint64_t _size);
+
+        /// \brief Get the duration after which a recording continues in a
+        /// new file.
+        /// \return The duration, or 0 if the recording isn't split by
+        /// duration. Default: 0.
+        public: std::chrono::milliseconds SplitDuration() const;
+
+        /// \brief Split a recording in files of a given duration. Only used
+        /// by Recorder, see Log::SplitFileName() for the names of the files.
+        /// \param[in] _duration Duration of a file, or 0 to not split by
+        /// duration.
+        public: void SetSplitDuration(
+            const std::chrono::milliseconds &_duration);
+
+        /// \brief Whether the chunked log files are written with direct
+        /// I/O.
+        /// \return True if the writes bypass the page cache. Default: false.
+        public: bool DirectWrites() const;
+
+        /// \brief Write the chunked log files with direct I/O (O_DIRECT),
+        /// which bypasses the page cache. This keeps fast recordings from
+        /// filling the memory with dirty pages. It is ignored where direct
+        /// I/O isn't available, such as on Windows or some file systems.
+        /// \param[in] _direct True to bypass the page cache.
+        public: void SetDirectWrites(bool _direct);
+
+        /// \brief Whether identical messages are stored once per chunk.
+        /// \return True if the messages are deduplicated. Default: false.
+        public: bool Deduplicate() const;
+
+        /// \brief Store the messages of the CHUNKED format that are
+        /// identical to an earlier message of the same chunk, of any topic,
+        /// as a reference to it, found by the hash of their contents. This
+        /// shrinks the logs of topics that publish the same message again
+        /// and again, such as static transforms or configurations. The
+        /// messages are read back whole.
+        /// \param[in] _deduplicate True to deduplicate the messages.
+        public: void SetDeduplicate(bool _deduplicate);
+
+        /// \brief Whether messages are delta encoded.
+        /// \return True if the messages are delta encoded. Default: false.
+        public: bool DeltaEncode() const;
+
+        /// \brief Store the messages of the CHUNKED format that differ
+        /// little from the last message of their topic stored whole in the
+        /// same chunk as the bytes that differ, e.g. the state of a robot
+        /// at rest of which only the header changes. A message is stored
+        /// whole, and becomes the base of the next ones, when the delta
+        /// isn't less than half of its size. The messages are read back
+        /// whole.
+        /// \param[in] _delta True to delta encode the messages.
+        public: void SetDeltaEncode(bool _delta);
+
+        /// \brief Get the number of messages of a topic from which the
+        /// dictionary that compresses the next ones is trained.
+        /// \return The number of messages, or 0 if the messages aren't
+        /// compressed with dictionaries. Default: 0.
+        public: uint32_t DictionaryMessages() const;
+
+        /// \brief Get the level used to compress the messages with
+        /// dictionaries.
+        /// \return The compression level.
+        public: int DictionaryCompressionLevel() const;
+
+        /// \brief Compress the messages of the SQLITE format with a zstd
+        /// dictionary per topic. The dictionary of a topic is trained from
+        /// its first messages, which are stored as they are, and is stored
+        /// in the log. Each next message is compressed on its own, so it is
+        /// still read without the messages before it, e.g. after a seek,
+        /// and small messages of the same type, which compress poorly one
+        /// by one, shrink several-fold. The messages are read back whole.
+        /// A topic whose first messages are too few or too small to train a
+        /// dictionary isn't compressed. QueryMetadata() and QueryHistogram()
+        /// of Log give the compressed size of the messages.
+        /// \param[in] _messages Number of messages of a topic the dictionary
+        /// is trained from, or 0 to not compress the messages.
+        /// \param[in] _level Compression level, or 0 for the default.
+        /// \return False if zstd isn't available in this build.
+        public: bool SetDictionaryCompression(uint32_t _messages,
+                                              int _level = 0);
+
+        /// \internal Implementation of this class
+        private: class Implementation;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unique_ptr
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+        /// \internal Pointer to the implementation of this class
+        private: std::unique_ptr<Implementation> dataPtr;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+      };
+      }
+    }
+  }
+}
+#endif
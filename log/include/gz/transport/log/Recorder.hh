@@ -17,15 +17,20 @@
 #ifndef GZ_TRANSPORT_LOG_RECORDER_HH_
 #define GZ_TRANSPORT_LOG_RECORDER_HH_
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <regex>
 #include <set>
 #include <string>
 
 #include <gz/transport/Clock.hh>
+#include <gz/transport/TopicStatistics.hh>
 #include <gz/transport/config.hh>
 #include <gz/transport/log/Export.hh>
+#include <gz/transport/log/RecordOptions.hh>
 
 namespace gz
 {
@@ -47,6 +52,117 @@ namespace gz
         ALREADY_SUBSCRIBED_TO_TOPIC = -6,
       };
 
+      /// \brief What the recorder does with a message that doesn't fit in
+      /// its buffer.
+      enum class OverflowPolicy
+      {
+        /// \brief Drop the oldest message of the buffer.
+        DROP_OLDEST = 0,
+        /// \brief Drop the message received.
+        DROP_NEWEST,
+        /// \brief Block the subscriber callback until the buffer has room.
+        /// This slows down the delivery of every topic of the recorder.
+        BLOCK,
+        /// \brief Drop the oldest message of a topic that isn't a priority
+        /// topic. A message of a topic that isn't a priority topic is dropped
+        /// if the buffer only holds messages of priority topics.
+        PRIORITIZE,
+      };
+
+      /// \brief Counters of a recording, see Recorder::Statistics().
+      struct RecorderStatistics
+      {
+        /// \brief Messages waiting to be written.
+        std::size_t queuedMessages = 0;
+
+        /// \brief Bytes waiting to be written.
+        std::size_t queuedBytes = 0;
+
+        /// \brief Messages received since the recording started.
+        uint64_t receivedMessages = 0;
+
+        /// \brief Messages written to the log file.
+        uint64_t writtenMessages = 0;
+
+        /// \brief Bytes handed to the log file.
+        uint64_t writtenBytes = 0;
+
+        /// \brief Bytes handed to the log file per second, over the last
+        /// second.
+        double writeRate = 0;
+
+        /// \brief Messages the log file failed to insert.
+        uint64_t failedMessages = 0;
+
+        /// \brief Messages dropped because the buffer was full.
+        uint64_t droppedMessages = 0;
+
+        /// \brief Bytes dropped because the buffer was full.
+        uint64_t droppedBytes = 0;
+
+        /// \brief Messages dropped, by topic.
+        std::map<std::string, uint64_t> droppedByTopic;
+
+        /// \brief Messages skipped by the topic policies, see
+        /// Recorder::SetTopicPolicy(). They are counted as received.
+        uint64_t skippedMessages = 0;
+
+        /// \brief Time the writer thread spent handing each batch of
+        /// messages to the log file, commits included (microseconds). Its
+        /// percentiles show the stalls of the disk, see
+        /// RecordOptions::SetPreallocateSize().
+        LatencyHistogram writeLatency;
+      };
+
+      /// \brief Which messages of a topic are recorded, see
+      /// Recorder::SetTopicPolicy(). A message is recorded if it meets all
+      /// the conditions. The default policy records every message.
+      struct RecordPolicy
+      {
+        /// \brief Maximum number of messages recorded per second, or 0 for
+        /// no limit. A message received less than 1 / maxRate seconds after
+        /// the last recorded message of the topic is skipped.
+        double maxRate = 0;
+
+        /// \brief Record one message out of keepEveryNth, among the messages
+        /// that meet the other conditions. 0 and 1 record every message.
+        uint64_t keepEveryNth = 1;
+
+        /// \brief Whether to skip a message whose data is identical to the
+        /// last recorded message of the topic.
+        bool onChange = false;
+
+        /// \brief Topic whose messages open a recording window, or empty to
+        /// record at any time. The trigger topic must be recorded as well,
+        /// but its own policy may skip its messages.
+        std::string triggerTopic;
+
+        /// \brief How long the messages are recorded after a message of the
+        /// trigger topic.
+        std::chrono::nanoseconds triggerWindow{0};
+
+        /// \brief Equality operator.
+        /// \param[in] _other The policy to compare.
+        /// \return True if the policies have the same conditions.
+        bool operator==(const RecordPolicy &_other) const
+        {
+          return this->maxRate == _other.maxRate &&
+            std::max<uint64_t>(this->keepEveryNth, 1) ==
+              std::max<uint64_t>(_other.keepEveryNth, 1) &&
+            this->onChange == _other.onChange &&
+            this->triggerTopic == _other.triggerTopic &&
+            this->triggerWindow == _other.triggerWindow;
+        }
+
+        /// \brief Inequality operator.
+        /// \param[in] _other The policy to compare.
+        /// \return True if the policies have different conditions.
+        bool operator!=(const RecordPolicy &_other) const
+        {
+          return !(*this == _other);
+        }
+      };
+
       /// \brief Records Gazebo Transport topics
       /// This class makes it easy to record topics to a log file.
       /// Responsibilities: topic name matching, time received tracking,
@@ -77,6 +193,18 @@ namespace gz
         /// already existed, this will return FAILED_TO_OPEN.
         public: RecorderError Start(const std::string &_file);
 
+        /// \brief Begin recording topics
+        /// \param[in] _file path to log file
+        /// \param[in] _options Durability and performance options of the
+        /// log file
+        /// \return NO_ERROR if recording was successfully started. If the file
+        /// already existed, this will return FAILED_TO_OPEN.
+        /// \note If _options splits the recording, it continues in the files
+        /// given by Log::SplitFileName(_file, 1), 2, ... as each file is
+        /// complete.
+        public: RecorderError Start(const std::string &_file,
+                                    const RecordOptions &_options);
+
         /// \brief Stop recording topics. This function will block if there is
         /// any data in the internal buffer that has not yet been written to
         /// disk.
@@ -100,7 +228,8 @@ namespace gz
 
         /// \brief Get the name of the log file.
         /// \return The name of the log file, or an empty string if Start has
-        /// not been successfully called.
+        /// not been successfully called. When the recording is split, this is
+        /// the name of the file being written.
         public: std::string Filename() const;
 
         /// \brief Get the set of topics have have been added.
@@ -115,11 +244,46 @@ namespace gz
 
         /// \brief Set the maximum size (in MB) of the buffer that is used to
         /// store data from topic callbacks. When the buffer reaches this size,
-        /// the recorder will start dropping older messages to make room for new
-        /// ones.
+        /// the recorder will start dropping messages as set by
+        /// SetOverflowPolicy(), and count them in Statistics().
         /// \param[in] _size Buffer size in MB
         public: void SetBufferSize(std::size_t _size);
 
+        /// \brief Get what happens to messages that don't fit in the buffer.
+        /// \return The policy. Default: DROP_OLDEST.
+        public: log::OverflowPolicy OverflowPolicy() const;
+
+        /// \brief Set what happens to messages that don't fit in the buffer.
+        /// \param[in] _policy The policy.
+        public: void SetOverflowPolicy(log::OverflowPolicy _policy);
+
+        /// \brief Get the topics kept by the PRIORITIZE policy.
+        /// \return The topic names.
+        public: std::set<std::string> PriorityTopics() const;
+
+        /// \brief Set the topics kept by the PRIORITIZE policy.
+        /// \param[in] _topics The topic names.
+        public: void SetPriorityTopics(const std::set<std::string> &_topics);
+
+        /// \brief Get the policy of a topic.
+        /// \param[in] _topic The topic name.
+        /// \return The policy, the default policy if none was set.
+        public: RecordPolicy TopicPolicy(const std::string &_topic) const;
+
+        /// \brief Set which messages of a topic are recorded. The messages
+        /// skipped are neither copied nor buffered. The state of the policy,
+        /// such as the last recorded message, is reset.
+        /// \param[in] _topic The topic name.
+        /// \param[in] _policy The policy. The default policy removes the
+        /// policy of the topic.
+        public: void SetTopicPolicy(const std::string &_topic,
+                                    const RecordPolicy &_policy);
+
+        /// \brief Get the counters of the current or last recording. They
+        /// are reset by Start().
+        /// \return The counters.
+        public: RecorderStatistics Statistics() const;
+
         /// \internal Implementation of this class
         private: class Implementation;
 
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/* Migrates a database from schema 0.1.0 to 0.2.0 */
+
+/* Queries by topic and time received read the messages of the selected topics
+   from this index, in order, instead of scanning every message by time */
+CREATE INDEX idx_topic_time_recv ON messages (topic_id, time_recv);
+
+INSERT INTO migrations (from_version, to_version) VALUES ('0.1.0', '0.2.0');
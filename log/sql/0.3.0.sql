@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/* Migrates a database from schema 0.2.0 to 0.3.0 */
+
+/* Summary of the messages of each topic, updated by the writer as messages are
+   inserted, so a log can be summarized without reading its messages */
+CREATE TABLE topic_stats (
+  /* Topic the summary is about */
+  topic_id INTEGER PRIMARY KEY REFERENCES topics (id) ON DELETE CASCADE,
+  /* Number of messages received on the topic */
+  message_count INTEGER NOT NULL,
+  /* Total size of the serialized messages (bytes) */
+  total_bytes INTEGER NOT NULL,
+  /* Timestamp of the first message received (utc nanoseconds) */
+  first_time_recv INTEGER NOT NULL,
+  /* Timestamp of the last message received (utc nanoseconds) */
+  last_time_recv INTEGER NOT NULL
+);
+
+/* Summarize the messages already in the database */
+INSERT INTO topic_stats
+  SELECT topic_id, COUNT(*), SUM(LENGTH(message)), MIN(time_recv),
+    MAX(time_recv)
+  FROM messages WHERE topic_id IS NOT NULL GROUP BY topic_id;
+
+INSERT INTO migrations (from_version, to_version) VALUES ('0.2.0', '0.3.0');
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/* Migrates a database from schema 0.3.0 to 0.4.0 */
+
+/* Zstd dictionary of each topic whose messages are compressed, trained from
+   the first messages of the topic. Each message is compressed on its own. */
+CREATE TABLE dictionaries (
+  /* Topic whose messages are compressed */
+  topic_id INTEGER PRIMARY KEY REFERENCES topics (id) ON DELETE CASCADE,
+  /* Id of the first compressed message. The messages of the topic from this
+     one on are compressed, the ones before it are stored as they are. */
+  first_message_id INTEGER NOT NULL,
+  /* The dictionary */
+  dictionary BLOB NOT NULL
+);
+
+INSERT INTO migrations (from_version, to_version) VALUES ('0.3.0', '0.4.0');
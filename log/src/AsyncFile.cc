@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "AsyncFile.hh"
+#include "Console.hh"
+
+using namespace gz::transport::log;
+
+namespace
+{
+  /// \brief Round a size up to the alignment of direct I/O.
+  /// \param[in] _size The size.
+  /// \return The aligned size.
+  std::size_t alignUp(const std::size_t _size)
+  {
+    return (_size + AsyncFile::kAlignment - 1) & ~(AsyncFile::kAlignment - 1);
+  }
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<AsyncFile> AsyncFile::Create(const std::string &_path,
+    const bool _direct, const uint64_t _preallocate)
+{
+  std::unique_ptr<AsyncFile> file(new AsyncFile());
+  file->path = _path;
+  file->preallocate = _preallocate;
+
+#ifndef _WIN32
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_CLOEXEC
+  flags |= O_CLOEXEC;
+#endif
+#ifdef O_DIRECT
+  if (_direct)
+  {
+    file->fd = ::open(_path.c_str(), flags | O_DIRECT, 0644);
+    file->direct = file->fd >= 0;
+    if (file->fd < 0 && errno == EINVAL)
+    {
+      LWRN("Direct I/O isn't supported for [" << _path
+          << "], writing through the page cache\n");
+    }
+  }
+#else
+  if (_direct)
+  {
+    LWRN("Direct I/O isn't supported on this platform, writing through "
+        << "the page cache\n");
+  }
+#endif
+  if (file->fd < 0)
+    file->fd = ::open(_path.c_str(), flags, 0644);
+  if (file->fd < 0)
+    return nullptr;
+#else
+  (void)_direct;
+  file->out.open(_path, std::ios::binary | std::ios::trunc);
+  if (!file->out)
+    return nullptr;
+#endif
+
+  file->current = file->NewBuffer();
+  file->thread = std::thread(&AsyncFile::WriteThread, file.get());
+  return file;
+}
+
+//////////////////////////////////////////////////
+AsyncFile::~AsyncFile()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Write(const void *_data, std::size_t _len)
+{
+  if (this->closed)
+    return false;
+
+  const char *data = static_cast<const char *>(_data);
+  while (_len > 0)
+  {
+    const std::size_t n = std::min(_len, kBufferSize - this->current.used);
+    std::memcpy(this->current.data + this->current.used, data, n);
+    this->current.used += n;
+    data += n;
+    _len -= n;
+
+    if (this->current.used == kBufferSize)
+    {
+      const uint64_t next = this->current.offset + kBufferSize;
+      this->current.writeLen = kBufferSize;
+      if (!this->Submit(std::move(this->current)))
+        return false;
+      this->current = this->NewBuffer();
+      this->current.offset = next;
+    }
+  }
+  return this->Good();
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Commit()
+{
+  if (this->closed)
+    return false;
+
+  // With direct I/O, the next buffer must start at an aligned offset.
+  if (this->direct || this->current.used == 0)
+    return this->Good();
+
+  const uint64_t next = this->current.offset + this->current.used;
+  this->current.writeLen = this->current.used;
+  if (!this->Submit(std::move(this->current)))
+    return false;
+  this->current = this->NewBuffer();
+  this->current.offset = next;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Flush()
+{
+  if (this->closed)
+    return false;
+
+  if (this->direct && this->current.used > 0)
+  {
+    // The current buffer is kept and a padded copy of its data is written.
+    // The data appended next overwrites the padding.
+    Buffer copy = this->NewBuffer();
+    copy.used = this->current.used;
+    copy.writeLen = alignUp(copy.used);
+    copy.offset = this->current.offset;
+    std::memcpy(copy.data, this->current.data, copy.used);
+    std::memset(copy.data + copy.used, 0, copy.writeLen - copy.used);
+    this->Submit(std::move(copy));
+  }
+  else
+  {
+    this->Commit();
+  }
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->doneCondVar.wait(lock, [this]
+      {
+        return (this->queue.empty() && !this->writing) || this->failed;
+      });
+  return !this->failed;
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Close()
+{
+  if (this->closed)
+    return true;
+
+  bool ok = this->Flush();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->workCondVar.notify_one();
+  if (this->thread.joinable())
+    this->thread.join();
+  this->closed = true;
+
+#ifndef _WIN32
+  // Remove the padding of the last block and the extents allocated ahead.
+  const uint64_t end = this->Size();
+  if (ftruncate(this->fd, static_cast<off_t>(end)) != 0)
+    ok = false;
+  if (::close(this->fd) != 0)
+    ok = false;
+  this->fd = -1;
+#else
+  this->out.close();
+  ok = ok && !this->out.fail();
+#endif
+
+  if (!ok)
+    LERR("Failed to write log file [" << this->path << "]\n");
+  return ok;
+}
+
+//////////////////////////////////////////////////
+uint64_t AsyncFile::Size() const
+{
+  return this->current.offset + this->current.used;
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Direct() const
+{
+  return this->direct;
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Good() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return !this->failed;
+}
+
+//////////////////////////////////////////////////
+AsyncFile::Buffer AsyncFile::NewBuffer()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->spare.empty())
+    {
+      Buffer buffer = std::move(this->spare.back());
+      this->spare.pop_back();
+      buffer.used = 0;
+      buffer.writeLen = 0;
+      buffer.offset = 0;
+      return buffer;
+    }
+  }
+
+  Buffer buffer;
+  buffer.storage.reset(new char[kBufferSize + kAlignment]);
+  const auto address = reinterpret_cast<std::uintptr_t>(buffer.storage.get());
+  buffer.data = buffer.storage.get() +
+    (alignUp(address) - address);
+  return buffer;
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::Submit(Buffer &&_buffer)
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->doneCondVar.wait(lock, [this]
+      {
+        return this->queue.size() < kMaxQueued || this->failed;
+      });
+  if (this->failed)
+    return false;
+
+  this->queue.push_back(std::move(_buffer));
+  lock.unlock();
+  this->workCondVar.notify_one();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void AsyncFile::WriteThread()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true)
+  {
+    this->workCondVar.wait(lock, [this]
+        {
+          return !this->queue.empty() || this->stop;
+        });
+    if (this->queue.empty())
+      return;
+
+    Buffer buffer = std::move(this->queue.front());
+    this->queue.pop_front();
+    this->writing = true;
+    lock.unlock();
+
+    const bool ok = this->failed ||
+      this->WriteAt(buffer.data, buffer.writeLen, buffer.offset);
+
+    lock.lock();
+    this->writing = false;
+    this->failed = this->failed || !ok;
+    if (this->spare.size() < kMaxQueued)
+      this->spare.push_back(std::move(buffer));
+    this->doneCondVar.notify_all();
+  }
+}
+
+//////////////////////////////////////////////////
+bool AsyncFile::WriteAt(const char *_data, std::size_t _len,
+    uint64_t _offset)
+{
+#ifndef _WIN32
+#ifdef __linux__
+  // Allocate the extents ahead of the writes, without changing the size of
+  // the file, so they are contiguous and the writes don't allocate blocks.
+  // File systems that can't allocate ahead just skip it.
+  if (_offset + _len > this->allocated)
+  {
+    const uint64_t end = std::max<uint64_t>(_offset + _len,
+        this->allocated + this->preallocate);
+    // A failure is reported by the writes themselves.
+    (void)fallocate(this->fd, FALLOC_FL_KEEP_SIZE,
+        static_cast<off_t>(this->allocated),
+        static_cast<off_t>(end - this->allocated));
+    this->allocated = end;
+  }
+#endif
+  while (_len > 0)
+  {
+    const ssize_t n = pwrite(this->fd, _data, _len,
+        static_cast<off_t>(_offset));
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    _data += n;
+    _len -= static_cast<std::size_t>(n);
+    _offset += static_cast<uint64_t>(n);
+  }
+  return true;
+#else
+  this->out.seekp(static_cast<std::streamoff>(_offset));
+  return static_cast<bool>(
+    this->out.write(_data, static_cast<std::streamsize>(_len)));
+#endif
+}
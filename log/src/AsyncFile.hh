@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_LOG_ASYNCFILE_HH_
+#define GZ_TRANSPORT_LOG_ASYNCFILE_HH_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/log/Export.hh"
+
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  /// \brief A file written in the background. The data is appended to large
+  /// buffers, which a thread writes at their offsets, so the caller only
+  /// waits when the disk is slower than the data for several buffers in a
+  /// row, or when it asks for the data to be in the file.
+  ///
+  /// On Linux, the extents of the file are allocated ahead of the writes.
+  /// With direct I/O, the buffers are aligned and written bypassing the page
+  /// cache; the last partial block is padded when it is flushed, and written
+  /// again once it is complete. The padding is removed when the file is
+  /// closed.
+  /// \internal
+  class GZ_TRANSPORT_LOG_VISIBLE AsyncFile
+  {
+    /// \brief Create a file, truncating it if it exists.
+    /// \param[in] _path Path of the file.
+    /// \param[in] _direct Whether to bypass the page cache. The file is
+    /// written through the page cache if direct I/O isn't available.
+    /// \param[in] _preallocate Size of the extents allocated ahead of the
+    /// writes (bytes).
+    /// \return The file or nullptr on error.
+    public: static std::unique_ptr<AsyncFile> Create(
+        const std::string &_path, bool _direct,
+        uint64_t _preallocate = kPreallocateSize);
+
+    /// \brief Destructor. Closes the file.
+    public: ~AsyncFile();
+
+    /// \brief Append data.
+    /// \param[in] _data The data.
+    /// \param[in] _len Size of the data.
+    /// \return False if a write failed.
+    public: bool Write(const void *_data, std::size_t _len);
+
+    /// \brief Hand the data appended so far to the writer thread, without
+    /// waiting for it to be written. With direct I/O, the last partial
+    /// block is only written by Flush().
+    /// \return False if a write failed.
+    public: bool Commit();
+
+    /// \brief Wait for the data appended so far to be written to the file,
+    /// so it can be read.
+    /// \return False if a write failed.
+    public: bool Flush();
+
+    /// \brief Write the remaining data and close the file.
+    /// \return False if a write failed.
+    public: bool Close();
+
+    /// \brief Get the size of the data appended.
+    /// \return The number of bytes.
+    public: uint64_t Size() const;
+
+    /// \brief Whether the file bypasses the page cache.
+    /// \return True if the file is written with direct I/O.
+    public: bool Direct() const;
+
+    /// \brief Whether every write succeeded so far.
+    /// \return False if a write failed.
+    public: bool Good() const;
+
+    /// \brief Size of a buffer (bytes).
+    public: static constexpr std::size_t kBufferSize = 4u << 20;
+
+    /// \brief Alignment of the buffers and their offsets with direct I/O.
+    public: static constexpr std::size_t kAlignment = 4096;
+
+    /// \brief Maximum number of buffers waiting to be written.
+    public: static constexpr std::size_t kMaxQueued = 4;
+
+    /// \brief Default size of the extents allocated ahead of the writes
+    /// (bytes).
+    public: static constexpr uint64_t kPreallocateSize = 64u << 20;
+
+    /// \brief A buffer of data and its location in the file.
+    private: struct Buffer
+    {
+      /// \brief Memory of the buffer, with room for the alignment.
+      std::unique_ptr<char[]> storage;
+
+      /// \brief Aligned start of the buffer.
+      char *data = nullptr;
+
+      /// \brief Bytes of data in the buffer.
+      std::size_t used = 0;
+
+      /// \brief Bytes to write, including the padding.
+      std::size_t writeLen = 0;
+
+      /// \brief Offset of the buffer in the file.
+      uint64_t offset = 0;
+    };
+
+    /// \brief Constructor.
+    private: AsyncFile() = default;
+
+    /// \brief Get an empty buffer, reusing a written one if possible.
+    /// \return The buffer.
+    private: Buffer NewBuffer();
+
+    /// \brief Hand a buffer to the writer thread, waiting if too many
+    /// buffers are queued.
+    /// \param[in] _buffer The buffer.
+    /// \return False if a write failed.
+    private: bool Submit(Buffer &&_buffer);
+
+    /// \brief Writer thread.
+    private: void WriteThread();
+
+    /// \brief Write data at an offset. Only called by the writer thread.
+    /// \param[in] _data The data.
+    /// \param[in] _len Size of the data.
+    /// \param[in] _offset Offset in the file.
+    /// \return False if the write failed.
+    private: bool WriteAt(const char *_data, std::size_t _len,
+                          uint64_t _offset);
+
+    /// \brief Path of the file.
+    private: std::string path;
+
+#ifndef _WIN32
+    /// \brief Descriptor of the file.
+    private: int fd = -1;
+#else
+    /// \brief The file.
+    private: std::ofstream out;
+#endif
+
+    /// \brief Whether the file bypasses the page cache.
+    private: bool direct = false;
+
+    /// \brief Whether the file is closed.
+    private: bool closed = false;
+
+    /// \brief Buffer being filled.
+    private: Buffer current;
+
+    /// \brief End of the extents allocated, only used by the writer thread.
+    private: uint64_t allocated = 0;
+
+    /// \brief Size of the extents allocated ahead of the writes (bytes).
+    private: uint64_t preallocate = kPreallocateSize;
+
+    /// \brief Buffers waiting to be written, protected by mutex.
+    private: std::deque<Buffer> queue;
+
+    /// \brief Written buffers kept for reuse, protected by mutex.
+    private: std::vector<Buffer> spare;
+
+    /// \brief Whether the writer thread is writing a buffer, protected by
+    /// mutex.
+    private: bool writing = false;
+
+    /// \brief Whether a write failed, protected by mutex.
+    private: bool failed = false;
+
+    /// \brief Whether the writer thread must stop, protected by mutex.
+    private: bool stop = false;
+
+    /// \brief Protects the state shared with the writer thread.
+    private: mutable std::mutex mutex;
+
+    /// \brief Signals the writer thread that there is a buffer to write or
+    /// it must stop.
+    private: std::condition_variable workCondVar;
+
+    /// \brief Signals that a buffer was written.
+    private: std::condition_variable doneCondVar;
+
+    /// \brief The writer thread.
+    private: std::thread thread;
+  };
+}
+}
+}
+}
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "AsyncFile.hh"
+#include "gtest/gtest.h"
+
+using namespace gz::transport::log;
+
+/// \brief Read a whole file.
+/// \param[in] _path Path of the file.
+/// \return The contents of the file.
+std::string readFile(const std::string &_path)
+{
+  std::ifstream in(_path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+/// \brief Write data in a file, flushing it halfway, and check its
+/// contents.
+/// \param[in] _direct Whether to use direct I/O.
+/// \param[in] _preallocate Size of the extents allocated ahead (bytes).
+void checkWrites(const bool _direct,
+    const uint64_t _preallocate = AsyncFile::kPreallocateSize)
+{
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "gz_async_file.bin").string();
+
+  // Cross the buffers with writes of varied sizes.
+  std::string expected;
+  for (int i = 0; expected.size() < 3 * AsyncFile::kBufferSize; ++i)
+    expected += std::string(1 + (i * 7919) % 100000, static_cast<char>(i));
+
+  auto file = AsyncFile::Create(path, _direct, _preallocate);
+  ASSERT_NE(nullptr, file);
+  const std::size_t half = expected.size() / 2 + 13;
+  EXPECT_TRUE(file->Write(expected.data(), half));
+  EXPECT_TRUE(file->Flush());
+  EXPECT_EQ(half, file->Size());
+
+  // The flushed data can be read while the file is written.
+  const std::string flushed = readFile(path);
+  ASSERT_LE(half, flushed.size());
+  EXPECT_EQ(expected.substr(0, half), flushed.substr(0, half));
+
+  EXPECT_TRUE(file->Write(expected.data() + half, expected.size() - half));
+  EXPECT_TRUE(file->Commit());
+  EXPECT_TRUE(file->Good());
+  EXPECT_TRUE(file->Close());
+  EXPECT_FALSE(file->Write("a", 1));
+  EXPECT_TRUE(file->Close());
+
+  EXPECT_EQ(expected, readFile(path));
+  std::filesystem::remove(path);
+}
+
+//////////////////////////////////////////////////
+/// \brief Write through the page cache.
+TEST(AsyncFileTest, Write)
+{
+  checkWrites(false);
+}
+
+//////////////////////////////////////////////////
+/// \brief Write with direct I/O, or through the page cache if it isn't
+/// available.
+TEST(AsyncFileTest, DirectWrite)
+{
+  checkWrites(true);
+}
+
+//////////////////////////////////////////////////
+/// \brief Allocate the extents in steps smaller than the buffers, so every
+/// write allocates. The file is truncated to its data when closed.
+TEST(AsyncFileTest, SmallPreallocation)
+{
+  checkWrites(false, 1u << 20);
+}
+
+//////////////////////////////////////////////////
+/// \brief A file that can't be created.
+TEST(AsyncFileTest, CreateFailure)
+{
+  EXPECT_EQ(nullptr, AsyncFile::Create("/this/path/does/not/exist", false));
+}
@@ -15,11 +15,20 @@
  *
 */
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "gz/transport/log/Batch.hh"
 #include "BatchPrivate.hh"
 #include "build_config.hh"
+#include "Console.hh"
+#include "Descriptor.hh"
 #include "MsgIterPrivate.hh"
 #include "raii-sqlite3.hh"
 
@@ -28,8 +37,28 @@ using namespace gz::transport::log;
 
 //////////////////////////////////////////////////
 BatchPrivate::BatchPrivate(const std::shared_ptr<raii_sqlite3::Database> &_db,
-      std::vector<SqlStatement> &&_statements)  // NOLINT(build/c++11)
-  : statements(new std::vector<SqlStatement>(std::move(_statements))), db(_db)
+      std::vector<SqlStatement> &&_statements,  // NOLINT(build/c++11)
+      const std::shared_ptr<const MessageDictionaries> &_dictionaries)
+  : statements(new std::vector<SqlStatement>(std::move(_statements))), db(_db),
+    dictionaries(_dictionaries)
+{
+}
+
+//////////////////////////////////////////////////
+BatchPrivate::BatchPrivate(
+    const std::shared_ptr<const ChunkedLogSummary> &_chunked,
+    const ChunkedQuery &_query)
+  : chunked(_chunked), query(_query)
+{
+}
+
+//////////////////////////////////////////////////
+BatchPrivate::BatchPrivate(
+    std::vector<std::unique_ptr<BatchPrivate>> &&_parts,  // NOLINT
+    const bool _merge)
+  : parts(std::make_shared<std::vector<std::unique_ptr<BatchPrivate>>>(
+        std::move(_parts))),
+    merge(_merge)
 {
 }
 
@@ -38,6 +67,37 @@ BatchPrivate::~BatchPrivate()
 {
 }
 
+//////////////////////////////////////////////////
+std::unique_ptr<MsgIterPrivate> BatchPrivate::CreateIterator() const
+{
+  // The messages in memory are given as they are, without reading ahead
+  if (this->preloaded)
+    return std::make_unique<MsgIterPrivate>(this->preloaded, 0);
+
+  if (this->readAheadMessages > 0)
+  {
+    // Wrap an iterator over the same messages, which is stepped on the
+    // background thread of the new one
+    BatchPrivate source(*this);
+    source.readAheadMessages = 0;
+    return std::make_unique<MsgIterPrivate>(
+        source.CreateIterator(), this->readAheadMessages,
+        this->readAheadBytes);
+  }
+
+  if (this->parts)
+    return std::make_unique<MsgIterPrivate>(this->parts, this->merge);
+
+  if (this->chunked)
+  {
+    return std::make_unique<MsgIterPrivate>(
+        std::make_unique<ChunkedLogCursor>(this->chunked, this->query));
+  }
+
+  return std::make_unique<MsgIterPrivate>(this->db, this->statements,
+      this->dictionaries);
+}
+
 //////////////////////////////////////////////////
 Batch::Batch()
   : dataPtr(nullptr)
@@ -73,9 +133,87 @@ Batch::iterator Batch::begin()
     return Batch::iterator();
   }
 
-  std::unique_ptr<MsgIterPrivate> msgPriv(new MsgIterPrivate(
-        this->dataPtr->db, this->dataPtr->statements));
-  return Batch::iterator(std::move(msgPriv));
+  return Batch::iterator(this->dataPtr->CreateIterator());
+}
+
+//////////////////////////////////////////////////
+void Batch::SetReadAhead(const std::size_t _messages, const std::size_t _bytes)
+{
+  if (!this->dataPtr)
+    return;
+
+  this->dataPtr->readAheadMessages = _messages;
+  this->dataPtr->readAheadBytes = _bytes;
+}
+
+//////////////////////////////////////////////////
+bool Batch::Preload(const std::size_t _maxBytes)
+{
+  if (!this->dataPtr)
+    return false;
+
+  if (this->dataPtr->preloaded)
+    return true;
+
+  auto preloaded = std::make_shared<PreloadedBatch>();
+  std::unordered_map<TopicKey, uint32_t> topicIndexes;
+  for (const Message &msg : *this)
+  {
+    const std::string_view data = msg.DataView();
+    if (_maxBytes > 0 && preloaded->data.size() + data.size() > _maxBytes)
+    {
+      LDBG("The messages of the batch exceed [" << _maxBytes
+           << "] bytes, they are not preloaded\n");
+      return false;
+    }
+
+    TopicKey key{msg.Topic(), msg.Type()};
+    auto inserted = topicIndexes.emplace(
+        key, static_cast<uint32_t>(preloaded->topics.size()));
+    if (inserted.second)
+      preloaded->topics.push_back(std::move(key));
+
+    preloaded->entries.push_back({msg.TimeReceived(), inserted.first->second,
+        preloaded->data.size(), data.size()});
+    preloaded->data.append(data.data(), data.size());
+  }
+  preloaded->data.shrink_to_fit();
+  preloaded->entries.shrink_to_fit();
+
+  this->dataPtr->preloaded = std::move(preloaded);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Batch::Preloaded() const
+{
+  return this->dataPtr && this->dataPtr->preloaded;
+}
+
+//////////////////////////////////////////////////
+Batch::iterator Batch::Find(const std::chrono::nanoseconds &_time)
+{
+  if (!this->dataPtr)
+    return Batch::iterator();
+
+  if (this->dataPtr->preloaded)
+  {
+    const auto &entries = this->dataPtr->preloaded->entries;
+    const auto found = std::lower_bound(entries.begin(), entries.end(), _time,
+        [](const PreloadedBatch::Entry &_entry,
+           const std::chrono::nanoseconds &_t)
+        {
+          return _entry.time < _t;
+        });
+    return Batch::iterator(std::make_unique<MsgIterPrivate>(
+          this->dataPtr->preloaded,
+          static_cast<std::size_t>(found - entries.begin())));
+  }
+
+  Batch::iterator iter = this->begin();
+  while (iter != this->end() && iter->TimeReceived() < _time)
+    ++iter;
+  return iter;
 }
 
 //////////////////////////////////////////////////
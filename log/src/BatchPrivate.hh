@@ -17,15 +17,69 @@
 #ifndef GZ_TRANSPORT_LOG_BATCHPRIVATE_HH_
 #define GZ_TRANSPORT_LOG_BATCHPRIVATE_HH_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "gz/transport/config.hh"
+#include "gz/transport/log/Batch.hh"
 #include "gz/transport/log/SqlStatement.hh"
+#include "ChunkedLog.hh"
+#include "MessageDictionary.hh"
 #include "raii-sqlite3.hh"
 
 using namespace gz::transport;
 using namespace gz::transport::log;
 
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  class MsgIterPrivate;
+  struct PreloadedBatch;
+}
+}
+}
+}
+
+/// \brief Messages of a batch read into memory by Batch::Preload()
+/// \internal
+struct gz::transport::log::PreloadedBatch
+{
+  /// \brief A message of the batch
+  struct Entry
+  {
+    /// \brief Time the message was received
+    std::chrono::nanoseconds time;
+
+    /// \brief Index of the topic of the message in topics
+    uint32_t topic;
+
+    /// \brief Offset of the serialized message in data
+    std::size_t offset;
+
+    /// \brief Size of the serialized message
+    std::size_t size;
+  };
+
+  /// \brief Topics and message types of the messages
+  std::vector<TopicKey> topics;
+
+  /// \brief Messages in iteration order
+  std::vector<Entry> entries;
+
+  /// \brief Serialized messages, one after the other
+  std::string data;
+};
+
 /// \brief Private implementation for Batch
 /// \internal
 class gz::transport::log::BatchPrivate
@@ -33,18 +87,71 @@ class gz::transport::log::BatchPrivate
   /// \brief constructor
   /// \param[in] _db an open sqlite3 database handle wrapper
   /// \param[in] _statements a list of statments to be executed to get messages
+  /// \param[in] _dictionaries Dictionaries of the compressed topics of the
+  /// database, or nullptr if it has none
   public: explicit BatchPrivate(
       const std::shared_ptr<raii_sqlite3::Database> &_db,
-      std::vector<SqlStatement> &&_statements);  // NOLINT(build/c++11)
+      std::vector<SqlStatement> &&_statements,  // NOLINT(build/c++11)
+      const std::shared_ptr<const MessageDictionaries> &_dictionaries =
+        nullptr);
+
+  /// \brief constructor
+  /// \param[in] _chunked Topics and chunks of a chunked log
+  /// \param[in] _query The messages to get
+  public: BatchPrivate(
+      const std::shared_ptr<const ChunkedLogSummary> &_chunked,
+      const ChunkedQuery &_query);
+
+  /// \brief constructor
+  /// \param[in] _parts Batches of the files of a split recording, in
+  /// recording order, or of the partitions of a query
+  /// \param[in] _merge True to merge the messages of the parts in time
+  /// order, false to give the messages of each part after the previous one
+  public: explicit BatchPrivate(
+      std::vector<std::unique_ptr<BatchPrivate>> &&_parts,  // NOLINT
+      bool _merge = false);
 
   /// \brief destructor
   public: ~BatchPrivate();
 
+  /// \brief Create an iterator over the messages of this batch, before the
+  /// first message.
+  /// \return The iterator.
+  public: std::unique_ptr<MsgIterPrivate> CreateIterator() const;
+
   /// \brief topic names that should be queried
   public: std::shared_ptr<std::vector<SqlStatement>> statements;
 
   /// \brief SQLite3 database pointer wrapper
   public: std::shared_ptr<raii_sqlite3::Database> db;
+
+  /// \brief Dictionaries of the compressed topics of db, or nullptr
+  public: std::shared_ptr<const MessageDictionaries> dictionaries;
+
+  /// \brief Topics and chunks of a chunked log, or nullptr for a SQLite log
+  public: std::shared_ptr<const ChunkedLogSummary> chunked;
+
+  /// \brief The messages to get from a chunked log
+  public: ChunkedQuery query;
+
+  /// \brief Batches of the files of a split recording, or nullptr
+  public: std::shared_ptr<const std::vector<std::unique_ptr<BatchPrivate>>>
+    parts;
+
+  /// \brief True to merge the messages of the parts in time order
+  public: bool merge = false;
+
+  /// \brief Messages read into memory, or nullptr to read them from the
+  /// log
+  public: std::shared_ptr<const PreloadedBatch> preloaded;
+
+  /// \brief Number of messages read ahead of the iterators, or 0 to read
+  /// them when the iterators are advanced
+  public: std::size_t readAheadMessages = 0;
+
+  /// \brief Size of the messages read ahead of the iterators (bytes), or 0
+  /// for no limit
+  public: std::size_t readAheadBytes = 0;
 };
 
 #endif
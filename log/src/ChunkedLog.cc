@@ -0,0 +1,1384 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ChunkedLog.hh"
+#include "Compression.hh"
+#include "Console.hh"
+
+using namespace gz::transport;
+using namespace gz::transport::log;
+
+namespace
+{
+  /// \brief First bytes of a chunked log file.
+  const char kMagic[8] = {'\x89', 'G', 'Z', 'L', 'O', 'G', '\r', '\n'};
+
+  /// \brief Version of the format.
+  const uint32_t kFormatVersion = 1;
+
+  /// \brief Version of the format of the logs with deduplicated or delta
+  /// encoded messages, which older readers can't read.
+  const uint32_t kEncodedFormatVersion = 2;
+
+  /// \brief Size of the file header: magic and version.
+  const uint64_t kHeaderSize = sizeof(kMagic) + 4;
+
+  /// \brief Size of the footer: offset of the summary and magic.
+  const uint64_t kFooterSize = 8 + sizeof(kMagic);
+
+  /// \brief Size of the header of a record: opcode and length.
+  const uint64_t kRecordHeaderSize = 1 + 8;
+
+  /// \brief Size of the header of a message in a chunk: time, topic id and
+  /// length.
+  const uint64_t kMessageHeaderSize = 8 + 4 + 4;
+
+  /// \brief Flags stored in the topic id of a message in a chunk. A
+  /// reference holds the offset of an identical message of the chunk. A
+  /// delta holds the offset of the message it is based on, the sizes of the
+  /// prefix and suffix they share, and the bytes in between.
+  const uint32_t kReferenceFlag = 0x80000000u;
+  const uint32_t kDeltaFlag = 0x40000000u;
+  const uint32_t kTopicIdMask = 0x3FFFFFFFu;
+
+  /// \brief Size of the header of a delta: offset of the base, sizes of
+  /// the prefix and suffix.
+  const uint64_t kDeltaHeaderSize = 8 + 4 + 4;
+
+  /// \brief Messages smaller than this are always stored whole.
+  const std::size_t kMinEncodedSize = 32;
+
+  /// \brief Record types.
+  const uint8_t kTopicRecord = 1;
+  const uint8_t kChunkRecord = 2;
+  const uint8_t kChunkIndexRecord = 3;
+  const uint8_t kSummaryRecord = 4;
+
+  //////////////////////////////////////////////////
+  /// \brief Append an unsigned integer (little endian).
+  /// \param[in] _value The value.
+  /// \param[in] _bytes Size of the value.
+  /// \param[in,out] _out Buffer to append to.
+  void Put(uint64_t _value, std::size_t _bytes, std::string &_out)
+  {
+    for (std::size_t i = 0; i < _bytes; ++i)
+      _out.push_back(static_cast<char>((_value >> (8 * i)) & 0xFF));
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append a string, prefixed with its length.
+  /// \param[in] _str The string.
+  /// \param[in,out] _out Buffer to append to.
+  void PutString(const std::string &_str, std::string &_out)
+  {
+    Put(_str.size(), 4, _out);
+    _out += _str;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Reads the values written with Put() from a buffer. Reading past
+  /// the end of the buffer fails and leaves the reader in a failed state.
+  class BufferReader
+  {
+    /// \brief Constructor.
+    /// \param[in] _data The buffer.
+    /// \param[in] _size Size of the buffer.
+    public: BufferReader(const char *_data, std::size_t _size)
+      : data(_data), size(_size)
+    {
+    }
+
+    /// \brief Read an unsigned integer.
+    /// \param[in] _bytes Size of the value.
+    /// \return The value, or 0 on error.
+    public: uint64_t Get(std::size_t _bytes)
+    {
+      const auto *src =
+        reinterpret_cast<const unsigned char *>(this->data + this->pos);
+      if (!this->Skip(_bytes))
+        return 0;
+      uint64_t value = 0;
+      for (std::size_t i = 0; i < _bytes; ++i)
+        value |= static_cast<uint64_t>(src[i]) << (8 * i);
+      return value;
+    }
+
+    /// \brief Read a string written with PutString().
+    /// \return The string.
+    public: std::string GetString()
+    {
+      const std::size_t len = static_cast<std::size_t>(this->Get(4));
+      const std::size_t start = this->pos;
+      if (!this->Skip(len))
+        return std::string();
+      return std::string(this->data + start, len);
+    }
+
+    /// \brief Skip bytes.
+    /// \param[in] _bytes Number of bytes.
+    /// \return False if there are not enough bytes left.
+    public: bool Skip(std::size_t _bytes)
+    {
+      if (!this->ok || _bytes > this->size - this->pos)
+      {
+        this->ok = false;
+        return false;
+      }
+      this->pos += _bytes;
+      return true;
+    }
+
+    /// \brief Current position.
+    /// \return Offset in the buffer.
+    public: std::size_t Pos() const
+    {
+      return this->pos;
+    }
+
+    /// \brief Whether all the reads succeeded.
+    /// \return True if no read failed.
+    public: bool Ok() const
+    {
+      return this->ok;
+    }
+
+    /// \brief The buffer.
+    private: const char *data;
+
+    /// \brief Size of the buffer.
+    private: std::size_t size;
+
+    /// \brief Current position.
+    private: std::size_t pos = 0;
+
+    /// \brief Whether all the reads succeeded.
+    private: bool ok = true;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Read a record.
+  /// \param[in,out] _in The file.
+  /// \param[in] _offset Offset of the record.
+  /// \param[out] _opcode Type of the record.
+  /// \param[out] _payload Contents of the record.
+  /// \return False if the record is truncated.
+  bool ReadRecord(std::ifstream &_in, uint64_t _offset, uint8_t &_opcode,
+                  std::string &_payload)
+  {
+    char header[kRecordHeaderSize];
+    _in.clear();
+    _in.seekg(static_cast<std::streamoff>(_offset));
+    if (!_in.read(header, sizeof(header)))
+      return false;
+
+    BufferReader reader(header, sizeof(header));
+    _opcode = static_cast<uint8_t>(reader.Get(1));
+    const uint64_t len = reader.Get(8);
+    // Don't trust the length of a corrupt record.
+    const std::streamoff here = _in.tellg();
+    _in.seekg(0, std::ios::end);
+    const std::streamoff end = _in.tellg();
+    if (here < 0 || end < here || len > static_cast<uint64_t>(end - here))
+      return false;
+
+    _in.seekg(here);
+    _payload.resize(static_cast<std::size_t>(len));
+    return len == 0 || static_cast<bool>(_in.read(&_payload[0],
+        static_cast<std::streamsize>(len)));
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Read the uncompressed messages of a chunk record.
+  /// Uncompressed messages are not copied.
+  /// \param[in] _payload Contents of the chunk record.
+  /// \param[in] _len Size of the contents.
+  /// \param[out] _start Time of the first message.
+  /// \param[out] _end Time of the last message.
+  /// \param[out] _storage Receives the messages if they are compressed.
+  /// \param[out] _messages Uncompressed messages, in _payload or _storage.
+  /// \param[out] _size Size of the messages.
+  /// \return False if the chunk is malformed.
+  bool ReadChunk(const char *_payload, const std::size_t _len,
+                 int64_t &_start, int64_t &_end, std::string &_storage,
+                 const char *&_messages, std::size_t &_size)
+  {
+    BufferReader reader(_payload, _len);
+    _start = static_cast<int64_t>(reader.Get(8));
+    _end = static_cast<int64_t>(reader.Get(8));
+    const auto codec = static_cast<Compression_t>(reader.Get(1));
+    const uint64_t rawSize = reader.Get(8);
+    if (!reader.Ok())
+      return false;
+
+    const char *data = _payload + reader.Pos();
+    const std::size_t size = _len - reader.Pos();
+    if (codec == Compression_t::NONE)
+    {
+      _messages = data;
+      _size = size;
+    }
+    else if (Compression::Decompress(codec, data, size, _storage))
+    {
+      _messages = _storage.data();
+      _size = _storage.size();
+    }
+    else
+    {
+      LERR("Failed to decompress a chunk with codec ["
+          << Compression::Name(codec) << "]\n");
+      return false;
+    }
+    return _size == rawSize;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Whether a time is inside a range.
+  /// \param[in] _range The range.
+  /// \param[in] _time The time (ns).
+  /// \return True if the time is inside.
+  bool InRange(const QualifiedTimeRange &_range, int64_t _time)
+  {
+    const QualifiedTime &begin = _range.Beginning();
+    if (!begin.IsIndeterminate())
+    {
+      const int64_t t = begin.GetTime()->count();
+      if (*begin.GetQualifier() == QualifiedTime::Qualifier::INCLUSIVE ?
+          _time < t : _time <= t)
+      {
+        return false;
+      }
+    }
+
+    const QualifiedTime &end = _range.Ending();
+    if (!end.IsIndeterminate())
+    {
+      const int64_t t = end.GetTime()->count();
+      if (*end.GetQualifier() == QualifiedTime::Qualifier::INCLUSIVE ?
+          _time > t : _time >= t)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Whether an interval may overlap a range.
+  /// \param[in] _range The range.
+  /// \param[in] _start Beginning of the interval (ns).
+  /// \param[in] _end End of the interval (ns).
+  /// \return False if no time of the interval is inside the range.
+  bool Overlaps(const QualifiedTimeRange &_range, int64_t _start,
+                int64_t _end)
+  {
+    const QualifiedTime &begin = _range.Beginning();
+    if (!begin.IsIndeterminate() && _end < begin.GetTime()->count())
+      return false;
+
+    const QualifiedTime &end = _range.Ending();
+    if (!end.IsIndeterminate() && _start > end.GetTime()->count())
+      return false;
+
+    return true;
+  }
+}
+
+//////////////////////////////////////////////////
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+  if (this->data)
+    munmap(const_cast<char *>(this->data), this->size);
+#endif
+}
+
+//////////////////////////////////////////////////
+bool MappedFile::Open(const std::string &_path)
+{
+#ifndef _WIN32
+  const int fd = ::open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  void *addr = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+  {
+    addr = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ,
+                MAP_SHARED, fd, 0);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    return false;
+
+  // Chunks are mostly read front to back.
+  madvise(addr, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+  this->data = static_cast<const char *>(addr);
+  this->size = static_cast<std::size_t>(info.st_size);
+  return true;
+#else
+  (void)_path;
+  return false;
+#endif
+}
+
+//////////////////////////////////////////////////
+const char *MappedFile::Range(const uint64_t _offset,
+                              const uint64_t _size) const
+{
+  if (!this->data || _offset > this->size || _size > this->size - _offset)
+    return nullptr;
+  return this->data + _offset;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogCursor::Entry::operator>(const Entry &_other) const
+{
+  if (this->time != _other.time)
+    return this->time > _other.time;
+  if (this->chunk != _other.chunk)
+    return this->chunk > _other.chunk;
+  return this->offset > _other.offset;
+}
+
+//////////////////////////////////////////////////
+ChunkedLogCursor::ChunkedLogCursor(
+    const std::shared_ptr<const ChunkedLogSummary> &_summary,
+    const ChunkedQuery &_query)
+  : summary(_summary), query(_query)
+{
+  for (const ChunkInfo &info : this->summary->chunks)
+  {
+    if (!Overlaps(this->query.range, info.start, info.end))
+      continue;
+
+    const bool hasTopic = std::any_of(info.topics.begin(), info.topics.end(),
+        [this](uint32_t _id)
+        {
+          return this->query.topics.count(_id) > 0;
+        });
+    if (hasTopic)
+      this->candidates.push_back(&info);
+  }
+
+  std::stable_sort(this->candidates.begin(), this->candidates.end(),
+      [](const ChunkInfo *_a, const ChunkInfo *_b)
+      {
+        return _a->start < _b->start;
+      });
+
+  // Read the file with the system calls only if it can't be mapped.
+  if (!this->candidates.empty() && !this->mapped.Open(this->summary->path))
+  {
+    this->in.open(this->summary->path, std::ios::binary);
+    if (!this->in)
+    {
+      LERR("Failed to open [" << this->summary->path << "]\n");
+      this->candidates.clear();
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogCursor::Next()
+{
+  // A chunk that starts before the oldest pending message may contain the
+  // next one.
+  while (this->nextCandidate < this->candidates.size() &&
+         (this->pending.empty() ||
+          this->candidates[this->nextCandidate]->start <=
+            this->pending.top().time))
+  {
+    if (!this->Load(this->nextCandidate))
+    {
+      LERR("Failed to read a chunk of [" << this->summary->path
+          << "], its messages are skipped\n");
+    }
+    ++this->nextCandidate;
+  }
+
+  if (this->pending.empty())
+  {
+    this->current = Chunk();
+    return false;
+  }
+
+  const Entry entry = this->pending.top();
+  this->pending.pop();
+
+  this->current = this->loaded[entry.chunk];
+  if (--this->remaining[entry.chunk] == 0)
+  {
+    this->loaded.erase(entry.chunk);
+    this->remaining.erase(entry.chunk);
+  }
+
+  BufferReader reader(this->current.data + entry.offset,
+                      this->current.size - entry.offset);
+  this->currentTime = static_cast<int64_t>(reader.Get(8));
+  const auto word = static_cast<uint32_t>(reader.Get(4));
+  const uint32_t topicId = word & kTopicIdMask;
+  this->currentSize = static_cast<std::size_t>(reader.Get(4));
+
+  // Skip messages that point outside the chunk or to unknown topics. They
+  // can only come from a corrupt file.
+  if (!reader.Skip(this->currentSize) || topicId == 0 ||
+      topicId > this->summary->topics.size() ||
+      !this->Decode(word & ~kTopicIdMask, entry.offset))
+  {
+    LWRN("Skipping a malformed message of [" << this->summary->path
+        << "]\n");
+    return this->Next();
+  }
+
+  this->currentTopic = &this->summary->topics[topicId - 1];
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogCursor::Decode(const uint32_t _flags, const uint64_t _offset)
+{
+  const char *payload = this->current.data + _offset + kMessageHeaderSize;
+  if (_flags == 0)
+  {
+    this->currentData = payload;
+    return true;
+  }
+
+  // References and deltas point to an earlier message stored whole.
+  BufferReader reader(payload, this->currentSize);
+  const uint64_t baseOffset = reader.Get(8);
+  if (!reader.Ok() || baseOffset >= _offset)
+    return false;
+
+  BufferReader baseReader(this->current.data + baseOffset,
+                          static_cast<std::size_t>(_offset - baseOffset));
+  baseReader.Get(8);
+  const auto baseFlags =
+    static_cast<uint32_t>(baseReader.Get(4)) & ~kTopicIdMask;
+  const std::size_t baseSize = static_cast<std::size_t>(baseReader.Get(4));
+  if (!baseReader.Skip(baseSize) || baseFlags != 0)
+    return false;
+  const char *base = this->current.data + baseOffset + kMessageHeaderSize;
+
+  if (_flags == kReferenceFlag)
+  {
+    this->currentData = base;
+    this->currentSize = baseSize;
+    return true;
+  }
+
+  const std::size_t prefix = static_cast<std::size_t>(reader.Get(4));
+  const std::size_t suffix = static_cast<std::size_t>(reader.Get(4));
+  if (_flags != kDeltaFlag || !reader.Ok() || prefix > baseSize ||
+      suffix > baseSize - prefix)
+  {
+    return false;
+  }
+
+  this->delta.assign(base, prefix);
+  this->delta.append(payload + kDeltaHeaderSize,
+                     this->currentSize - kDeltaHeaderSize);
+  this->delta.append(base + baseSize - suffix, suffix);
+  this->currentData = this->delta.data();
+  this->currentSize = this->delta.size();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogCursor::Record(const uint64_t _offset, uint8_t &_opcode,
+    std::string &_storage, const char *&_payload, std::size_t &_len)
+{
+  const char *header = this->mapped.Range(_offset, kRecordHeaderSize);
+  if (!header)
+  {
+    if (!ReadRecord(this->in, _offset, _opcode, _storage))
+      return false;
+    _payload = _storage.data();
+    _len = _storage.size();
+    return true;
+  }
+
+  BufferReader reader(header, kRecordHeaderSize);
+  _opcode = static_cast<uint8_t>(reader.Get(1));
+  const uint64_t len = reader.Get(8);
+  _payload = this->mapped.Range(_offset + kRecordHeaderSize, len);
+  _len = static_cast<std::size_t>(len);
+  return _payload != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLogCursor::Load(const std::size_t _candidate)
+{
+  const ChunkInfo &info = *this->candidates[_candidate];
+  uint8_t opcode = 0;
+  std::string storage;
+  const char *payload = nullptr;
+  std::size_t len = 0;
+  if (!this->Record(info.offset, opcode, storage, payload, len) ||
+      opcode != kChunkRecord)
+  {
+    return false;
+  }
+
+  // The messages point to the mapped file when they are not compressed,
+  // otherwise the chunk owns them.
+  Chunk chunk;
+  chunk.buffer = std::make_shared<std::string>();
+  int64_t start = 0;
+  int64_t end = 0;
+  if (!ReadChunk(payload, len, start, end, *chunk.buffer, chunk.data,
+        chunk.size))
+  {
+    return false;
+  }
+  if (chunk.data != chunk.buffer->data())
+  {
+    if (payload == storage.data())
+    {
+      // The file isn't mapped, keep the record that was read.
+      const std::size_t skip = static_cast<std::size_t>(chunk.data - payload);
+      chunk.buffer->swap(storage);
+      chunk.data = chunk.buffer->data() + skip;
+    }
+    else
+    {
+      chunk.buffer.reset();
+    }
+  }
+
+  std::size_t count = 0;
+  auto add = [&](int64_t _time, uint64_t _offset)
+  {
+    this->pending.push({_time, _candidate, _offset});
+    ++count;
+  };
+
+  std::string indexStorage;
+  if (info.indexOffset > 0 &&
+      this->Record(info.indexOffset, opcode, indexStorage, payload, len) &&
+      opcode == kChunkIndexRecord)
+  {
+    // Use the index to visit only the messages of the selected topics.
+    BufferReader reader(payload, len);
+    reader.Get(8);
+    const uint32_t topics = static_cast<uint32_t>(reader.Get(4));
+    for (uint32_t i = 0; i < topics && reader.Ok(); ++i)
+    {
+      const auto id = static_cast<uint32_t>(reader.Get(4));
+      const uint32_t entries = static_cast<uint32_t>(reader.Get(4));
+      const bool selected = this->query.topics.count(id) > 0;
+      if (!selected)
+      {
+        reader.Skip(static_cast<std::size_t>(entries) * 16u);
+        continue;
+      }
+      for (uint32_t j = 0; j < entries && reader.Ok(); ++j)
+      {
+        const auto time = static_cast<int64_t>(reader.Get(8));
+        const uint64_t msgOffset = reader.Get(8);
+        if (reader.Ok() &&
+            msgOffset + kMessageHeaderSize <= chunk.size &&
+            InRange(this->query.range, time))
+        {
+          add(time, msgOffset);
+        }
+      }
+    }
+    if (!reader.Ok())
+      return false;
+  }
+  else
+  {
+    // Without index, visit every message.
+    BufferReader reader(chunk.data, chunk.size);
+    while (reader.Pos() < chunk.size)
+    {
+      const uint64_t msgOffset = reader.Pos();
+      const auto time = static_cast<int64_t>(reader.Get(8));
+      const auto id = static_cast<uint32_t>(reader.Get(4)) & kTopicIdMask;
+      const std::size_t msgLen = static_cast<std::size_t>(reader.Get(4));
+      if (!reader.Skip(msgLen))
+        break;
+      if (this->query.topics.count(id) > 0 &&
+          InRange(this->query.range, time))
+      {
+        add(time, msgOffset);
+      }
+    }
+  }
+
+  if (count > 0)
+  {
+    this->loaded[_candidate] = std::move(chunk);
+    this->remaining[_candidate] = count;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds ChunkedLogCursor::Time() const
+{
+  return std::chrono::nanoseconds(this->currentTime);
+}
+
+//////////////////////////////////////////////////
+const TopicKey &ChunkedLogCursor::Topic() const
+{
+  return *this->currentTopic;
+}
+
+//////////////////////////////////////////////////
+const char *ChunkedLogCursor::Data() const
+{
+  return this->currentData;
+}
+
+//////////////////////////////////////////////////
+std::size_t ChunkedLogCursor::Size() const
+{
+  return this->currentSize;
+}
+
+//////////////////////////////////////////////////
+ChunkedLog::ChunkedLog()
+  : summary(std::make_shared<ChunkedLogSummary>())
+{
+}
+
+//////////////////////////////////////////////////
+ChunkedLog::~ChunkedLog()
+{
+  if (this->writable)
+    this->Close();
+
+  {
+    std::lock_guard<std::mutex> lock(this->workMutex);
+    this->stopWorkers = true;
+  }
+  this->workCondVar.notify_all();
+  for (std::thread &worker : this->workers)
+    worker.join();
+}
+
+//////////////////////////////////////////////////
+std::string ChunkedLog::Version()
+{
+  return "chunked-" + std::to_string(kFormatVersion);
+}
+
+//////////////////////////////////////////////////
+std::string ChunkedLog::FileVersion() const
+{
+  return "chunked-" + std::to_string(this->version);
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::IsChunkedLog(const std::string &_path)
+{
+  std::ifstream in(_path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  return in.read(magic, sizeof(magic)) &&
+    std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<ChunkedLog> ChunkedLog::Create(const std::string &_path,
+    const RecordOptions &_options)
+{
+  std::error_code ec;
+  if (std::filesystem::exists(_path, ec))
+  {
+    LERR("Log file [" << _path << "] already exists\n");
+    return nullptr;
+  }
+
+  std::unique_ptr<ChunkedLog> log(new ChunkedLog());
+  const uint64_t preallocate = _options.PreallocateSize() > 0 ?
+    _options.PreallocateSize() : AsyncFile::kPreallocateSize;
+  log->out = AsyncFile::Create(_path, _options.DirectWrites(), preallocate);
+  if (!log->out)
+  {
+    LERR("Failed to create log file [" << _path << "]\n");
+    return nullptr;
+  }
+
+  // Older readers can't read encoded messages, the other logs keep the
+  // first version of the format.
+  log->deduplicate = _options.Deduplicate();
+  log->deltaEncode = _options.DeltaEncode();
+  log->version = log->deduplicate || log->deltaEncode ?
+    kEncodedFormatVersion : kFormatVersion;
+
+  std::string header(kMagic, sizeof(kMagic));
+  Put(log->version, 4, header);
+  if (!log->out->Write(header.data(), header.size()))
+  {
+    LERR("Failed to write log file [" << _path << "]\n");
+    return nullptr;
+  }
+
+  log->writable = true;
+  log->offset = header.size();
+  log->summary->path = _path;
+  log->chunkSize = std::max<uint64_t>(_options.ChunkSize(), 1u);
+  log->codec = _options.ChunkCompression();
+  log->level = _options.ChunkCompressionLevel();
+  log->period = _options.TransactionPeriod();
+
+  // Workers are only useful when there is something to compress.
+  if (log->codec != Compression_t::NONE)
+  {
+    for (uint32_t i = 0; i < _options.CompressionThreads(); ++i)
+      log->workers.emplace_back(&ChunkedLog::CompressThread, log.get());
+  }
+  return log;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<ChunkedLog> ChunkedLog::Open(const std::string &_path)
+{
+  std::unique_ptr<ChunkedLog> log(new ChunkedLog());
+  log->summary->path = _path;
+  if (!log->ReadSummary())
+    return nullptr;
+
+  for (std::size_t i = 0; i < log->summary->topics.size(); ++i)
+    log->topicIds[log->summary->topics[i]] = static_cast<int64_t>(i + 1);
+  return log;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::ReadSummary()
+{
+  const std::string &path = this->summary->path;
+  std::ifstream in(path, std::ios::binary);
+  char header[kHeaderSize];
+  if (!in.read(header, sizeof(header)) ||
+      std::memcmp(header, kMagic, sizeof(kMagic)) != 0)
+  {
+    LERR("[" << path << "] is not a chunked log\n");
+    return false;
+  }
+  BufferReader headerReader(header + sizeof(kMagic), 4);
+  const uint64_t fileVersion = headerReader.Get(4);
+  if (fileVersion < kFormatVersion || fileVersion > kEncodedFormatVersion)
+  {
+    LERR("Chunked log version [" << fileVersion << "] of [" << path
+        << "] is unsupported by this tool\n");
+    return false;
+  }
+  this->version = static_cast<uint32_t>(fileVersion);
+
+  in.seekg(0, std::ios::end);
+  const uint64_t size = static_cast<uint64_t>(in.tellg());
+
+  uint8_t opcode = 0;
+  std::string payload;
+
+  // Fast path: the footer points to the summary.
+  if (size >= kHeaderSize + kFooterSize)
+  {
+    char footer[kFooterSize];
+    in.seekg(static_cast<std::streamoff>(size - kFooterSize));
+    if (in.read(footer, sizeof(footer)) &&
+        std::memcmp(footer + 8, kMagic, sizeof(kMagic)) == 0)
+    {
+      BufferReader footerReader(footer, 8);
+      const uint64_t summaryOffset = footerReader.Get(8);
+      if (ReadRecord(in, summaryOffset, opcode, payload) &&
+          opcode == kSummaryRecord)
+      {
+        BufferReader reader(payload.data(), payload.size());
+        const uint32_t numTopics = static_cast<uint32_t>(reader.Get(4));
+        for (uint32_t i = 0; i < numTopics && reader.Ok(); ++i)
+        {
+          reader.Get(4);
+          TopicKey key;
+          key.topic = reader.GetString();
+          key.type = reader.GetString();
+          this->summary->topics.push_back(key);
+        }
+        const uint64_t numChunks = reader.Get(8);
+        for (uint64_t i = 0; i < numChunks && reader.Ok(); ++i)
+        {
+          ChunkInfo info;
+          info.offset = reader.Get(8);
+          info.indexOffset = reader.Get(8);
+          info.start = static_cast<int64_t>(reader.Get(8));
+          info.end = static_cast<int64_t>(reader.Get(8));
+          const uint32_t chunkTopics = static_cast<uint32_t>(reader.Get(4));
+          for (uint32_t j = 0; j < chunkTopics && reader.Ok(); ++j)
+            info.topics.push_back(static_cast<uint32_t>(reader.Get(4)));
+          this->summary->chunks.push_back(std::move(info));
+        }
+        if (reader.Ok())
+          return true;
+      }
+    }
+    LWRN("[" << path << "] has no valid summary, the recording may have "
+        << "been interrupted. Scanning the log.\n");
+  }
+
+  // Slow path: scan the records.
+  this->summary->topics.clear();
+  this->summary->chunks.clear();
+  std::unordered_map<uint64_t, std::size_t> chunkByOffset;
+  uint64_t pos = kHeaderSize;
+  while (pos < size && ReadRecord(in, pos, opcode, payload))
+  {
+    BufferReader reader(payload.data(), payload.size());
+    if (opcode == kTopicRecord)
+    {
+      const uint32_t id = static_cast<uint32_t>(reader.Get(4));
+      TopicKey key;
+      key.topic = reader.GetString();
+      key.type = reader.GetString();
+      // Topics are written in order of id.
+      if (reader.Ok() && id == this->summary->topics.size() + 1)
+        this->summary->topics.push_back(key);
+    }
+    else if (opcode == kChunkRecord)
+    {
+      ChunkInfo info;
+      info.offset = pos;
+      int64_t start = 0;
+      int64_t end = 0;
+      std::string storage;
+      const char *messages = nullptr;
+      std::size_t messagesSize = 0;
+      if (ReadChunk(payload.data(), payload.size(), start, end, storage,
+            messages, messagesSize))
+      {
+        info.start = start;
+        info.end = end;
+
+        // The topics of the chunk, in case its index is missing.
+        std::unordered_set<uint32_t> topics;
+        BufferReader msgReader(messages, messagesSize);
+        while (msgReader.Pos() < messagesSize && msgReader.Ok())
+        {
+          msgReader.Get(8);
+          topics.insert(
+              static_cast<uint32_t>(msgReader.Get(4)) & kTopicIdMask);
+          msgReader.Skip(static_cast<std::size_t>(msgReader.Get(4)));
+        }
+        info.topics.assign(topics.begin(), topics.end());
+        std::sort(info.topics.begin(), info.topics.end());
+        chunkByOffset[pos] = this->summary->chunks.size();
+        this->summary->chunks.push_back(std::move(info));
+      }
+    }
+    else if (opcode == kChunkIndexRecord)
+    {
+      auto it = chunkByOffset.find(reader.Get(8));
+      if (reader.Ok() && it != chunkByOffset.end())
+        this->summary->chunks[it->second].indexOffset = pos;
+    }
+    else if (opcode == kSummaryRecord)
+    {
+      break;
+    }
+    pos += kRecordHeaderSize + payload.size();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint32_t ChunkedLog::TopicId(const std::string &_topic,
+                             const std::string &_type)
+{
+  // Messages usually arrive in runs of the same topic
+  if (this->lastTopicId > 0 && _topic == this->lastTopic.topic &&
+      _type == this->lastTopic.type)
+  {
+    return this->lastTopicId;
+  }
+
+  TopicKey key;
+  key.topic = _topic;
+  key.type = _type;
+  uint32_t id = 0;
+  auto it = this->topicIds.find(key);
+  if (it != this->topicIds.end())
+  {
+    id = static_cast<uint32_t>(it->second);
+  }
+  else
+  {
+    id = static_cast<uint32_t>(this->summary->topics.size() + 1);
+    std::string payload;
+    Put(id, 4, payload);
+    PutString(_topic, payload);
+    PutString(_type, payload);
+    if (!this->WriteRecord(kTopicRecord, payload))
+      return 0;
+
+    this->topicIds[key] = id;
+    this->summary->topics.push_back(key);
+    this->summaryChanged = true;
+  }
+
+  this->lastTopic = std::move(key);
+  this->lastTopicId = id;
+  return id;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::WriteRecord(const uint8_t _opcode,
+                             const std::string &_payload)
+{
+  std::string header;
+  Put(_opcode, 1, header);
+  Put(_payload.size(), 8, header);
+  if (!this->out->Write(header.data(), header.size()) ||
+      !this->out->Write(_payload.data(), _payload.size()))
+  {
+    LERR("Failed to write log file [" << this->summary->path << "]\n");
+    return false;
+  }
+  this->offset += header.size() + _payload.size();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::Write(const std::chrono::nanoseconds &_time,
+    const std::string &_topic, const std::string &_type,
+    const void *_data, const std::size_t _len)
+{
+  if (!this->writable)
+    return false;
+
+  if (_len > std::numeric_limits<uint32_t>::max())
+  {
+    LERR("Message of [" << _topic << "] is too large for a chunked log\n");
+    return false;
+  }
+
+  const uint32_t id = this->TopicId(_topic, _type);
+  if (id == 0 || id > kTopicIdMask)
+    return false;
+
+  const int64_t time = _time.count();
+  if (this->chunk.empty())
+  {
+    this->chunkBegan = std::chrono::steady_clock::now();
+    this->chunkStart = time;
+    this->chunkEnd = time;
+  }
+  else
+  {
+    this->chunkStart = std::min(this->chunkStart, time);
+    this->chunkEnd = std::max(this->chunkEnd, time);
+  }
+
+  const uint64_t msgOffset = this->chunk.size();
+  this->chunkIndex[id].emplace_back(time, msgOffset);
+  Put(static_cast<uint64_t>(time), 8, this->chunk);
+  this->Append(id, reinterpret_cast<const char *>(_data), _len, msgOffset);
+
+  if (this->chunk.size() >= this->chunkSize ||
+      std::chrono::steady_clock::now() - this->chunkBegan >= this->period)
+  {
+    return this->Seal();
+  }
+
+  // Write the chunks the workers finished meanwhile.
+  return this->inFlight.empty() || this->WriteEncoded(false);
+}
+
+//////////////////////////////////////////////////
+void ChunkedLog::Append(const uint32_t _id, const char *_data,
+                        const std::size_t _len, const uint64_t _msgOffset)
+{
+  const bool encode =
+    _len >= kMinEncodedSize && (this->deduplicate || this->deltaEncode);
+
+  // A message identical to a message of the chunk refers to it.
+  std::size_t hash = 0;
+  if (encode && this->deduplicate)
+  {
+    hash = std::hash<std::string_view>()(std::string_view(_data, _len));
+    const auto range = this->chunkHashes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      BufferReader reader(this->chunk.data() + it->second + 12, 4);
+      const char *other =
+        this->chunk.data() + it->second + kMessageHeaderSize;
+      if (reader.Get(4) == _len && std::memcmp(other, _data, _len) == 0)
+      {
+        Put(_id | kReferenceFlag, 4, this->chunk);
+        Put(8, 4, this->chunk);
+        Put(it->second, 8, this->chunk);
+        return;
+      }
+    }
+  }
+
+  // A message close to the base of its topic is stored as the bytes that
+  // differ between their common prefix and suffix.
+  if (encode && this->deltaEncode)
+  {
+    const auto base = this->chunkBases.find(_id);
+    if (base != this->chunkBases.end())
+    {
+      BufferReader reader(this->chunk.data() + base->second + 12, 4);
+      const std::size_t baseLen = static_cast<std::size_t>(reader.Get(4));
+      const char *baseData =
+        this->chunk.data() + base->second + kMessageHeaderSize;
+      const std::size_t common = std::min(baseLen, _len);
+      std::size_t prefix = 0;
+      while (prefix < common && baseData[prefix] == _data[prefix])
+        ++prefix;
+      std::size_t suffix = 0;
+      while (suffix < common - prefix &&
+             baseData[baseLen - 1 - suffix] == _data[_len - 1 - suffix])
+      {
+        ++suffix;
+      }
+
+      const std::size_t middle = _len - prefix - suffix;
+      if (kDeltaHeaderSize + middle < _len / 2)
+      {
+        Put(_id | kDeltaFlag, 4, this->chunk);
+        Put(kDeltaHeaderSize + middle, 4, this->chunk);
+        Put(base->second, 8, this->chunk);
+        Put(prefix, 4, this->chunk);
+        Put(suffix, 4, this->chunk);
+        this->chunk.append(_data + prefix, middle);
+        return;
+      }
+    }
+    this->chunkBases[_id] = _msgOffset;
+  }
+
+  if (encode && this->deduplicate)
+    this->chunkHashes.emplace(hash, _msgOffset);
+
+  Put(_id, 4, this->chunk);
+  Put(_len, 4, this->chunk);
+  this->chunk.append(_data, _len);
+}
+
+//////////////////////////////////////////////////
+void ChunkedLog::Encode(PendingChunk &_chunk, const Compression_t _codec,
+                        const int _level)
+{
+  // Compress the chunk, or store it as is if the codec fails.
+  std::string compressed;
+  Compression_t chunkCodec = _codec;
+  if (chunkCodec != Compression_t::NONE &&
+      !Compression::Compress(chunkCodec, _level, _chunk.messages.data(),
+        _chunk.messages.size(), compressed))
+  {
+    chunkCodec = Compression_t::NONE;
+  }
+  const std::string &data =
+    chunkCodec == Compression_t::NONE ? _chunk.messages : compressed;
+
+  std::string &payload = _chunk.record;
+  payload.reserve(25 + data.size());
+  Put(static_cast<uint64_t>(_chunk.start), 8, payload);
+  Put(static_cast<uint64_t>(_chunk.end), 8, payload);
+  Put(static_cast<uint64_t>(chunkCodec), 1, payload);
+  Put(_chunk.messages.size(), 8, payload);
+  payload += data;
+
+  // The index of the chunk, sorted by topic id. The offset of the chunk is
+  // prepended when it's written.
+  for (const auto &entry : _chunk.index)
+    _chunk.topics.push_back(entry.first);
+  std::sort(_chunk.topics.begin(), _chunk.topics.end());
+
+  std::string &index = _chunk.indexRecord;
+  Put(_chunk.topics.size(), 4, index);
+  for (const uint32_t id : _chunk.topics)
+  {
+    const auto &entries = _chunk.index[id];
+    Put(id, 4, index);
+    Put(entries.size(), 4, index);
+    for (const auto &[time, msgOffset] : entries)
+    {
+      Put(static_cast<uint64_t>(time), 8, index);
+      Put(msgOffset, 8, index);
+    }
+  }
+
+  // Only the records are needed from now on.
+  std::string().swap(_chunk.messages);
+  _chunk.index.clear();
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::WriteChunk(PendingChunk &_chunk)
+{
+  ChunkInfo info;
+  info.offset = this->offset;
+  info.start = _chunk.start;
+  info.end = _chunk.end;
+  bool ok = this->WriteRecord(kChunkRecord, _chunk.record);
+
+  std::string payload;
+  payload.reserve(8 + _chunk.indexRecord.size());
+  Put(info.offset, 8, payload);
+  payload += _chunk.indexRecord;
+  info.indexOffset = this->offset;
+  ok = ok && this->WriteRecord(kChunkIndexRecord, payload);
+  info.topics = std::move(_chunk.topics);
+
+  this->summary->chunks.push_back(std::move(info));
+  this->summaryChanged = true;
+  return ok;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::Seal()
+{
+  if (this->chunk.empty())
+    return true;
+
+  // References and deltas don't cross chunks, which are read on their own.
+  this->chunkHashes.clear();
+  this->chunkBases.clear();
+
+  auto pending = std::make_shared<PendingChunk>();
+  pending->messages.swap(this->chunk);
+  pending->index.swap(this->chunkIndex);
+  pending->start = this->chunkStart;
+  pending->end = this->chunkEnd;
+
+  if (this->workers.empty())
+  {
+    Encode(*pending, this->codec, this->level);
+    const bool ok = this->WriteChunk(*pending);
+    return this->out->Commit() && ok;
+  }
+
+  this->inFlight.push_back(pending);
+  {
+    std::lock_guard<std::mutex> lock(this->workMutex);
+    this->work.push_back(std::move(pending));
+  }
+  this->workCondVar.notify_one();
+  return this->WriteEncoded(false);
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::WriteEncoded(const bool _all)
+{
+  // Keep the workers busy, but bound the memory used by the chunks.
+  const std::size_t maxInFlight = 2 * this->workers.size();
+
+  bool ok = true;
+  bool wrote = false;
+  while (!this->inFlight.empty())
+  {
+    const bool wait = _all || this->inFlight.size() > maxInFlight;
+    {
+      std::unique_lock<std::mutex> lock(this->workMutex);
+      if (wait)
+      {
+        this->doneCondVar.wait(lock, [this]
+            {
+              return this->inFlight.front()->done;
+            });
+      }
+      else if (!this->inFlight.front()->done)
+      {
+        break;
+      }
+    }
+
+    ok = this->WriteChunk(*this->inFlight.front()) && ok;
+    this->inFlight.pop_front();
+    wrote = true;
+  }
+
+  if (wrote)
+    ok = this->out->Commit() && ok;
+  return ok;
+}
+
+//////////////////////////////////////////////////
+void ChunkedLog::CompressThread()
+{
+  std::unique_lock<std::mutex> lock(this->workMutex);
+  while (true)
+  {
+    this->workCondVar.wait(lock, [this]
+        {
+          return !this->work.empty() || this->stopWorkers;
+        });
+    if (this->work.empty())
+      return;
+
+    std::shared_ptr<PendingChunk> pending = std::move(this->work.front());
+    this->work.pop_front();
+    lock.unlock();
+
+    Encode(*pending, this->codec, this->level);
+
+    lock.lock();
+    pending->done = true;
+    this->doneCondVar.notify_one();
+  }
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::Flush()
+{
+  if (!this->writable)
+    return false;
+
+  bool ok = this->Seal();
+  ok = this->WriteEncoded(true) && ok;
+  // The chunks can be read once they are in the file.
+  return this->out->Flush() && ok;
+}
+
+//////////////////////////////////////////////////
+bool ChunkedLog::Close()
+{
+  if (!this->writable)
+    return false;
+
+  bool ok = this->Flush();
+
+  const uint64_t summaryOffset = this->offset;
+  std::string payload;
+  Put(this->summary->topics.size(), 4, payload);
+  for (std::size_t i = 0; i < this->summary->topics.size(); ++i)
+  {
+    Put(i + 1, 4, payload);
+    PutString(this->summary->topics[i].topic, payload);
+    PutString(this->summary->topics[i].type, payload);
+  }
+  Put(this->summary->chunks.size(), 8, payload);
+  for (const ChunkInfo &info : this->summary->chunks)
+  {
+    Put(info.offset, 8, payload);
+    Put(info.indexOffset, 8, payload);
+    Put(static_cast<uint64_t>(info.start), 8, payload);
+    Put(static_cast<uint64_t>(info.end), 8, payload);
+    Put(info.topics.size(), 4, payload);
+    for (const uint32_t id : info.topics)
+      Put(id, 4, payload);
+  }
+  ok = this->WriteRecord(kSummaryRecord, payload) && ok;
+
+  std::string footer;
+  Put(summaryOffset, 8, footer);
+  footer.append(kMagic, sizeof(kMagic));
+  ok = ok && this->out->Write(footer.data(), footer.size());
+
+  ok = this->out->Close() && ok;
+  this->writable = false;
+  return ok;
+}
+
+//////////////////////////////////////////////////
+TopicKeyMap ChunkedLog::Topics() const
+{
+  return this->topicIds;
+}
+
+//////////////////////////////////////////////////
+std::size_t ChunkedLog::NumTopics() const
+{
+  return this->summary->topics.size();
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds ChunkedLog::StartTime() const
+{
+  bool first = true;
+  int64_t start = 0;
+  for (const ChunkInfo &info : this->summary->chunks)
+  {
+    start = first ? info.start : std::min(start, info.start);
+    first = false;
+  }
+  for (const auto &pending : this->inFlight)
+  {
+    start = first ? pending->start : std::min(start, pending->start);
+    first = false;
+  }
+  if (!this->chunk.empty())
+    start = first ? this->chunkStart : std::min(start, this->chunkStart);
+  return std::chrono::nanoseconds(start);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds ChunkedLog::EndTime() const
+{
+  bool first = true;
+  int64_t end = 0;
+  for (const ChunkInfo &info : this->summary->chunks)
+  {
+    end = first ? info.end : std::max(end, info.end);
+    first = false;
+  }
+  for (const auto &pending : this->inFlight)
+  {
+    end = first ? pending->end : std::max(end, pending->end);
+    first = false;
+  }
+  if (!this->chunk.empty())
+    end = first ? this->chunkEnd : std::max(end, this->chunkEnd);
+  return std::chrono::nanoseconds(end);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const ChunkedLogSummary> ChunkedLog::Snapshot()
+{
+  if (this->writable)
+    this->Flush();
+
+  if (this->summaryChanged || !this->snapshot)
+  {
+    // Readers never see later changes to the summary of a writable log.
+    if (this->writable)
+      this->snapshot = std::make_shared<ChunkedLogSummary>(*this->summary);
+    else
+      this->snapshot = this->summary;
+    this->summaryChanged = false;
+  }
+  return this->snapshot;
+}
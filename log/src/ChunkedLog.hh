@@ -0,0 +1,546 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_LOG_CHUNKEDLOG_HH_
+#define GZ_TRANSPORT_LOG_CHUNKEDLOG_HH_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/log/QualifiedTime.hh"
+#include "gz/transport/log/RecordOptions.hh"
+#include "AsyncFile.hh"
+#include "Descriptor.hh"
+
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  /// \brief Location and contents of a chunk of a chunked log.
+  /// \internal
+  struct ChunkInfo
+  {
+    /// \brief File offset of the chunk record.
+    uint64_t offset = 0;
+
+    /// \brief File offset of the index record of the chunk, or 0 if the
+    /// chunk has no index (the recording was interrupted).
+    uint64_t indexOffset = 0;
+
+    /// \brief Time of the first message of the chunk (ns).
+    int64_t start = 0;
+
+    /// \brief Time of the last message of the chunk (ns).
+    int64_t end = 0;
+
+    /// \brief Ids of the topics with messages in the chunk.
+    std::vector<uint32_t> topics;
+  };
+
+  /// \brief Topics and chunks of a chunked log. A summary handed to a query
+  /// is never modified, so batches and iterators can share it.
+  /// \internal
+  struct ChunkedLogSummary
+  {
+    /// \brief Path of the log file.
+    std::string path;
+
+    /// \brief Topics, the id of a topic is its index plus one.
+    std::vector<TopicKey> topics;
+
+    /// \brief Chunks, in file order.
+    std::vector<ChunkInfo> chunks;
+  };
+
+  /// \brief Messages selected by a query on a chunked log.
+  /// \internal
+  struct ChunkedQuery
+  {
+    /// \brief Ids of the topics to get.
+    std::unordered_set<uint32_t> topics;
+
+    /// \brief Time range of the messages to get.
+    QualifiedTimeRange range = QualifiedTimeRange::AllTime();
+  };
+
+  /// \brief Read-only memory mapping of a whole file. Mapping is only
+  /// available on POSIX systems, elsewhere Open() fails and the callers read
+  /// the file instead.
+  /// \internal
+  class MappedFile
+  {
+    /// \brief Constructor.
+    public: MappedFile() = default;
+
+    /// \brief No copy constructor.
+    public: MappedFile(const MappedFile &) = delete;
+
+    /// \brief No assignment operator.
+    public: MappedFile &operator=(const MappedFile &) = delete;
+
+    /// \brief Destructor. Unmaps the file.
+    public: ~MappedFile();
+
+    /// \brief Map a file.
+    /// \param[in] _path Path of the file.
+    /// \return False if the file could not be mapped.
+    public: bool Open(const std::string &_path);
+
+    /// \brief Get a range of the file.
+    /// \param[in] _offset Offset of the range.
+    /// \param[in] _size Size of the range.
+    /// \return Pointer to the range, or nullptr if the file isn't mapped or
+    /// the range is outside of the mapping.
+    public: const char *Range(uint64_t _offset, uint64_t _size) const;
+
+    /// \brief Start of the mapping.
+    private: const char *data = nullptr;
+
+    /// \brief Size of the mapping.
+    private: std::size_t size = 0;
+  };
+
+  /// \brief Iterates over the messages of a query on a chunked log, in the
+  /// order they were received. Only the chunks that may contain messages of
+  /// the query are read, and they are read lazily: a chunk is loaded when
+  /// its first message could be the next one.
+  /// \internal
+  class ChunkedLogCursor
+  {
+    /// \brief Constructor.
+    /// \param[in] _summary Topics and chunks of the log.
+    /// \param[in] _query The messages to get.
+    public: ChunkedLogCursor(
+        const std::shared_ptr<const ChunkedLogSummary> &_summary,
+        const ChunkedQuery &_query);
+
+    /// \brief Move to the next message.
+    /// \return False if there are no more messages.
+    public: bool Next();
+
+    /// \brief Time the current message was received.
+    /// \return The time.
+    public: std::chrono::nanoseconds Time() const;
+
+    /// \brief Topic and type of the current message.
+    /// \return The topic.
+    public: const TopicKey &Topic() const;
+
+    /// \brief Data of the current message, valid until the next call to
+    /// Next(). Uncompressed chunks are not copied: the data points to the
+    /// memory-mapped file.
+    /// \return Pointer to the serialized message.
+    public: const char *Data() const;
+
+    /// \brief Size of the current message.
+    /// \return Size (bytes).
+    public: std::size_t Size() const;
+
+    /// \brief A message of a loaded chunk.
+    private: struct Entry
+    {
+      /// \brief Time the message was received (ns).
+      int64_t time;
+
+      /// \brief Index of the chunk in the candidates.
+      std::size_t chunk;
+
+      /// \brief Offset of the message in the uncompressed chunk.
+      uint64_t offset;
+
+      /// \brief Order of the heap: oldest message first, then file order.
+      /// \param[in] _other Another entry.
+      /// \return True if this entry goes after the other.
+      bool operator>(const Entry &_other) const;
+    };
+
+    /// \brief Uncompressed messages of a loaded chunk.
+    private: struct Chunk
+    {
+      /// \brief Owns the messages, unless they are in the mapped file.
+      std::shared_ptr<std::string> buffer;
+
+      /// \brief The messages.
+      const char *data = nullptr;
+
+      /// \brief Size of the messages.
+      std::size_t size = 0;
+    };
+
+    /// \brief Get the contents of a record, from the mapped file if
+    /// possible.
+    /// \param[in] _offset Offset of the record.
+    /// \param[out] _opcode Type of the record.
+    /// \param[out] _storage Receives the contents if the file isn't mapped.
+    /// \param[out] _payload Contents of the record.
+    /// \param[out] _len Size of the contents.
+    /// \return False if the record is truncated.
+    private: bool Record(uint64_t _offset, uint8_t &_opcode,
+                         std::string &_storage, const char *&_payload,
+                         std::size_t &_len);
+
+    /// \brief Point to the data of the current message, rebuilding it if
+    /// it is a reference or a delta.
+    /// \param[in] _flags Encoding flags of the message.
+    /// \param[in] _offset Offset of the message in the current chunk.
+    /// \return False if the message is malformed.
+    private: bool Decode(uint32_t _flags, uint64_t _offset);
+
+    /// \brief Read a chunk and queue its messages that match the query.
+    /// \param[in] _candidate Index of the chunk in the candidates.
+    /// \return False if the chunk could not be read.
+    private: bool Load(std::size_t _candidate);
+
+    /// \brief Topics and chunks of the log.
+    private: std::shared_ptr<const ChunkedLogSummary> summary;
+
+    /// \brief The messages to get.
+    private: ChunkedQuery query;
+
+    /// \brief The log file, when it can't be mapped.
+    private: std::ifstream in;
+
+    /// \brief The mapped log file.
+    private: MappedFile mapped;
+
+    /// \brief Chunks that may contain messages of the query, sorted by the
+    /// time of their first message.
+    private: std::vector<const ChunkInfo *> candidates;
+
+    /// \brief Next candidate to load.
+    private: std::size_t nextCandidate = 0;
+
+    /// \brief Messages of the loaded chunks.
+    private: std::priority_queue<Entry, std::vector<Entry>,
+                                 std::greater<Entry>> pending;
+
+    /// \brief Uncompressed data of the loaded chunks, by candidate.
+    private: std::unordered_map<std::size_t, Chunk> loaded;
+
+    /// \brief Messages of every loaded chunk that are still pending.
+    private: std::unordered_map<std::size_t, std::size_t> remaining;
+
+    /// \brief Chunk of the current message, kept alive until Next().
+    private: Chunk current;
+
+    /// \brief Time of the current message (ns).
+    private: int64_t currentTime = 0;
+
+    /// \brief Topic of the current message.
+    private: const TopicKey *currentTopic = nullptr;
+
+    /// \brief Data of the current message.
+    private: const char *currentData = nullptr;
+
+    /// \brief Size of the current message.
+    private: std::size_t currentSize = 0;
+
+    /// \brief Current message, when it was rebuilt from a delta.
+    private: std::string delta;
+  };
+
+  /// \brief Append-only log file made of chunks of messages.
+  ///
+  /// Messages are appended to an in-memory chunk. When the chunk is full, or
+  /// the transaction period ends, it is written as a single (optionally
+  /// compressed) record, followed by an index of the time and offset of its
+  /// messages by topic. Topics are written as records before the first chunk
+  /// that uses them. Closing the log writes a summary with the topics and
+  /// chunks, and a footer pointing to it, so readers don't have to scan the
+  /// file. A file without summary (interrupted recording) is recovered by
+  /// scanning its records.
+  ///
+  /// With compression threads, full chunks are compressed by a pool of
+  /// workers while new messages are appended, and the thread calling Write()
+  /// writes the compressed chunks in order.
+  /// \internal
+  class ChunkedLog
+  {
+    /// \brief Whether a file is a chunked log.
+    /// \param[in] _path Path of the file.
+    /// \return True if the file starts with the chunked log magic.
+    public: static bool IsChunkedLog(const std::string &_path);
+
+    /// \brief Create a log file for writing.
+    /// \param[in] _path Path of the file, which must not exist.
+    /// \param[in] _options Chunk size, compression and period.
+    /// \return The log or nullptr on error.
+    public: static std::unique_ptr<ChunkedLog> Create(
+        const std::string &_path, const RecordOptions &_options);
+
+    /// \brief Open a log file for reading.
+    /// \param[in] _path Path of the file.
+    /// \return The log or nullptr on error.
+    public: static std::unique_ptr<ChunkedLog> Open(const std::string &_path);
+
+    /// \brief Destructor. Closes a log opened for writing.
+    public: ~ChunkedLog();
+
+    /// \brief Version of the format.
+    /// \return The version.
+    public: static std::string Version();
+
+    /// \brief Version of the format of this log, which is newer than
+    /// Version() if its messages are deduplicated or delta encoded.
+    /// \return The version.
+    public: std::string FileVersion() const;
+
+    /// \brief Append a message.
+    /// \param[in] _time Time the message was received.
+    /// \param[in] _topic Name of the topic.
+    /// \param[in] _type Name of the message type.
+    /// \param[in] _data Serialized message.
+    /// \param[in] _len Size of the message (bytes).
+    /// \return False if the log isn't writable or the write failed.
+    public: bool Write(const std::chrono::nanoseconds &_time,
+                       const std::string &_topic, const std::string &_type,
+                       const void *_data, std::size_t _len);
+
+    /// \brief Write the current chunk, if any, and wait for the chunks
+    /// being compressed to be written.
+    /// \return False if the write failed.
+    public: bool Flush();
+
+    /// \brief Write the last chunk, the summary and the footer.
+    /// \return False if the write failed.
+    public: bool Close();
+
+    /// \brief Topics of the log.
+    /// \return Ids of the topics by name and type.
+    public: TopicKeyMap Topics() const;
+
+    /// \brief Number of topics of the log.
+    /// \return The number of topics.
+    public: std::size_t NumTopics() const;
+
+    /// \brief Time of the first message.
+    /// \return The time, or zero if the log is empty.
+    public: std::chrono::nanoseconds StartTime() const;
+
+    /// \brief Time of the last message.
+    /// \return The time, or zero if the log is empty.
+    public: std::chrono::nanoseconds EndTime() const;
+
+    /// \brief Get the topics and chunks to run a query. The current chunk
+    /// of a log opened for writing is written first.
+    /// \return The summary.
+    public: std::shared_ptr<const ChunkedLogSummary> Snapshot();
+
+    /// \brief A chunk handed to the compression workers.
+    private: struct PendingChunk
+    {
+      /// \brief Uncompressed messages.
+      std::string messages;
+
+      /// \brief Time and offset of the messages by topic id.
+      std::unordered_map<uint32_t,
+          std::vector<std::pair<int64_t, uint64_t>>> index;
+
+      /// \brief Time of the first message (ns).
+      int64_t start = 0;
+
+      /// \brief Time of the last message (ns).
+      int64_t end = 0;
+
+      /// \brief Contents of the chunk record.
+      std::string record;
+
+      /// \brief Contents of the index record, without the chunk offset.
+      std::string indexRecord;
+
+      /// \brief Ids of the topics of the chunk.
+      std::vector<uint32_t> topics;
+
+      /// \brief Whether the records are encoded, guarded by workMutex.
+      bool done = false;
+    };
+
+    /// \brief Constructor.
+    private: ChunkedLog();
+
+    /// \brief Append a message to the current chunk after its time, as a
+    /// reference to an identical message or as a delta when enabled.
+    /// \param[in] _id Id of the topic.
+    /// \param[in] _data Serialized message.
+    /// \param[in] _len Size of the message (bytes).
+    /// \param[in] _msgOffset Offset of the message in the chunk.
+    private: void Append(uint32_t _id, const char *_data, std::size_t _len,
+                         uint64_t _msgOffset);
+
+    /// \brief Encode the records of a chunk, compressing its messages.
+    /// \param[in,out] _chunk The chunk.
+    /// \param[in] _codec Codec of the messages.
+    /// \param[in] _level Compression level.
+    private: static void Encode(PendingChunk &_chunk, Compression_t _codec,
+                                int _level);
+
+    /// \brief Hand the current chunk to the workers, or encode and write it
+    /// if there are none.
+    /// \return False if a write failed.
+    private: bool Seal();
+
+    /// \brief Write the encoded chunks at the front of the chunks in flight.
+    /// \param[in] _all Wait for every chunk in flight to be written. If
+    /// false, only wait when there are too many chunks in flight.
+    /// \return False if a write failed.
+    private: bool WriteEncoded(bool _all);
+
+    /// \brief Write the records of an encoded chunk.
+    /// \param[in,out] _chunk The chunk.
+    /// \return False if a write failed.
+    private: bool WriteChunk(PendingChunk &_chunk);
+
+    /// \brief Compression worker thread.
+    private: void CompressThread();
+
+    /// \brief Get the id of a topic, adding it if it's new.
+    /// \param[in] _topic Name of the topic.
+    /// \param[in] _type Name of the message type.
+    /// \return The id or 0 on error.
+    private: uint32_t TopicId(const std::string &_topic,
+                              const std::string &_type);
+
+    /// \brief Append a record to the file.
+    /// \param[in] _opcode Type of the record.
+    /// \param[in] _payload Contents of the record.
+    /// \return False if the write failed.
+    private: bool WriteRecord(uint8_t _opcode, const std::string &_payload);
+
+    /// \brief Read the summary at the end of the file, or scan the records
+    /// if there is none.
+    /// \return False if the file is not a valid log.
+    private: bool ReadSummary();
+
+    /// \brief Topics and chunks.
+    private: std::shared_ptr<ChunkedLogSummary> summary;
+
+    /// \brief Whether the summary has changed since the last snapshot.
+    private: bool summaryChanged = true;
+
+    /// \brief Last snapshot, shared with the queries.
+    private: std::shared_ptr<const ChunkedLogSummary> snapshot;
+
+    /// \brief Ids of the topics.
+    private: TopicKeyMap topicIds;
+
+    /// \brief The file, if opened for writing. It is written by its own
+    /// thread, so the writer only waits for the disk when it falls behind.
+    private: std::unique_ptr<AsyncFile> out;
+
+    /// \brief Whether the log is opened for writing.
+    private: bool writable = false;
+
+    /// \brief Size of the file written so far.
+    private: uint64_t offset = 0;
+
+    /// \brief Uncompressed size of a chunk.
+    private: uint64_t chunkSize = 0;
+
+    /// \brief Codec of the chunks.
+    private: Compression_t codec = Compression_t::NONE;
+
+    /// \brief Compression level of the chunks.
+    private: int level = 0;
+
+    /// \brief Maximum time a chunk is kept in memory.
+    private: std::chrono::milliseconds period{0};
+
+    /// \brief Version of the format of the file.
+    private: uint32_t version = 0;
+
+    /// \brief Whether identical messages of a chunk are stored once.
+    private: bool deduplicate = false;
+
+    /// \brief Whether messages are delta encoded against their topic.
+    private: bool deltaEncode = false;
+
+    /// \brief Offsets of the messages stored whole in the current chunk,
+    /// by hash of their contents, when deduplicating.
+    private: std::unordered_multimap<std::size_t, uint64_t> chunkHashes;
+
+    /// \brief Offset of the last message of each topic stored whole in
+    /// the current chunk, by topic id, when delta encoding.
+    private: std::unordered_map<uint32_t, uint64_t> chunkBases;
+
+    /// \brief Messages of the current chunk.
+    private: std::string chunk;
+
+    /// \brief Index of the current chunk: time and offset of the messages
+    /// by topic id.
+    private: std::unordered_map<uint32_t,
+        std::vector<std::pair<int64_t, uint64_t>>> chunkIndex;
+
+    /// \brief Time of the first message of the current chunk.
+    private: int64_t chunkStart = 0;
+
+    /// \brief Time of the last message of the current chunk.
+    private: int64_t chunkEnd = 0;
+
+    /// \brief When the current chunk was started.
+    private: std::chrono::steady_clock::time_point chunkBegan;
+
+    /// \brief Last topic written.
+    private: TopicKey lastTopic;
+
+    /// \brief Id of the last topic written, or 0.
+    private: uint32_t lastTopicId = 0;
+
+    /// \brief Chunks handed to the workers and not written yet, in file
+    /// order.
+    private: std::deque<std::shared_ptr<PendingChunk>> inFlight;
+
+    /// \brief Chunks waiting for a worker.
+    private: std::deque<std::shared_ptr<PendingChunk>> work;
+
+    /// \brief Protects work, stopWorkers and the done flag of the chunks.
+    private: std::mutex workMutex;
+
+    /// \brief Signals the workers that there is work or they must stop.
+    private: std::condition_variable workCondVar;
+
+    /// \brief Signals the writer that a chunk is encoded.
+    private: std::condition_variable doneCondVar;
+
+    /// \brief Whether the workers must stop.
+    private: bool stopWorkers = false;
+
+    /// \brief Compression workers.
+    private: std::vector<std::thread> workers;
+  };
+}
+}
+}
+}
+#endif
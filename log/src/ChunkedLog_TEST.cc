@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <filesystem>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/log/Log.hh"
+#include "gz/transport/log/QueryOptions.hh"
+#include "gz/transport/log/RecordOptions.hh"
+#include "ChunkedLog.hh"
+#include "gtest/gtest.h"
+
+#include "test_utils.hh"
+
+using namespace gz;
+using namespace gz::transport;
+using namespace std::chrono_literals;
+
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Path of a temporary log file, removed on destruction.
+  class TempLog
+  {
+    public: TempLog()
+      : path((std::filesystem::temp_directory_path() /
+          ("gz_chunked_" + testing::getRandomNumber() + ".tlog")).string())
+    {
+    }
+
+    public: ~TempLog()
+    {
+      std::filesystem::remove(this->path);
+    }
+
+    public: const std::string path;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Chunked log options for the tests.
+  log::RecordOptions ChunkedOptions(uint64_t _chunkSize)
+  {
+    log::RecordOptions opts;
+    opts.SetFormat(log::LogFormat::CHUNKED);
+    opts.SetChunkSize(_chunkSize);
+    opts.SetTransactionPeriod(1h);
+    return opts;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Write 100 messages, alternating two topics, one per second.
+  void WriteMessages(log::Log &_log)
+  {
+    for (int i = 0; i < 100; ++i)
+    {
+      const std::string data = "data" + std::to_string(i);
+      EXPECT_TRUE(_log.InsertMessage(std::chrono::seconds(i),
+          i % 2 ? "/odd" : "/even", "msg.type", data.c_str(), data.size()));
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the data of the messages of a query.
+  std::vector<std::string> Query(log::Log &_log,
+                                 const log::QueryOptions &_options)
+  {
+    std::vector<std::string> result;
+    for (const log::Message &msg : _log.QueryMessages(_options))
+    {
+      result.push_back(msg.Data());
+      EXPECT_EQ(result.back(), msg.DataView());
+    }
+    return result;
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, WriteAndRead)
+{
+  TempLog file;
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out,
+        ChunkedOptions(256)));
+    EXPECT_EQ(log::ChunkedLog::Version(), logFile.Version());
+    WriteMessages(logFile);
+
+    // The log can be queried while it's being written.
+    EXPECT_EQ(100u, Query(logFile, log::AllTopics()).size());
+    EXPECT_TRUE(logFile.InsertMessage(100s, "/even", "msg.type", "x", 1u));
+  }
+
+  EXPECT_TRUE(log::ChunkedLog::IsChunkedLog(file.path));
+
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(file.path));
+  EXPECT_EQ(0s, logFile.StartTime());
+  EXPECT_EQ(100s, logFile.EndTime());
+
+  const log::Descriptor *desc = logFile.Descriptor();
+  ASSERT_NE(nullptr, desc);
+  EXPECT_EQ(2u, desc->TopicsToMsgTypesToId().size());
+  EXPECT_LT(0, desc->TopicId("/odd", "msg.type"));
+
+  // All the messages, in order.
+  std::vector<std::string> all = Query(logFile, log::AllTopics());
+  ASSERT_EQ(101u, all.size());
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ("data" + std::to_string(i), all[i]);
+
+  int count = 0;
+  std::chrono::nanoseconds last(-1);
+  for (const log::Message &msg : logFile.QueryMessages())
+  {
+    EXPECT_EQ("msg.type", msg.Type());
+    EXPECT_EQ(count % 2 ? "/odd" : "/even", msg.Topic());
+    EXPECT_LT(last, msg.TimeReceived());
+    last = msg.TimeReceived();
+    ++count;
+  }
+  EXPECT_EQ(101, count);
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, QueryTopicsAndTimes)
+{
+  TempLog file;
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out,
+        ChunkedOptions(128)));
+    WriteMessages(logFile);
+  }
+
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(file.path));
+
+  std::vector<std::string> odd = Query(logFile, log::TopicList("/odd"));
+  ASSERT_EQ(50u, odd.size());
+  EXPECT_EQ("data1", odd.front());
+  EXPECT_EQ("data99", odd.back());
+
+  EXPECT_EQ(100u, Query(logFile, log::TopicPattern(std::regex("/.*"))).size());
+  EXPECT_TRUE(Query(logFile, log::TopicList("/unknown")).empty());
+
+  // Inclusive and exclusive bounds.
+  const log::QualifiedTime begin(10s);
+  const log::QualifiedTime end(20s,
+      log::QualifiedTime::Qualifier::EXCLUSIVE);
+  std::vector<std::string> range = Query(logFile,
+      log::AllTopics(log::QualifiedTimeRange(begin, end)));
+  ASSERT_EQ(10u, range.size());
+  EXPECT_EQ("data10", range.front());
+  EXPECT_EQ("data19", range.back());
+
+  std::vector<std::string> evenUntil = Query(logFile, log::TopicList("/even",
+      log::QualifiedTimeRange::Until(log::QualifiedTime(4s))));
+  EXPECT_EQ((std::vector<std::string>{"data0", "data2", "data4"}),
+      evenUntil);
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, InterruptedRecording)
+{
+  TempLog file;
+  TempLog copy;
+  {
+    auto chunked = log::ChunkedLog::Create(file.path, ChunkedOptions(64));
+    ASSERT_NE(nullptr, chunked);
+    for (int i = 0; i < 20; ++i)
+    {
+      const std::string data = "data" + std::to_string(i);
+      EXPECT_TRUE(chunked->Write(std::chrono::seconds(i), "/topic",
+          "msg.type", data.c_str(), data.size()));
+    }
+    ASSERT_TRUE(chunked->Flush());
+
+    // A copy without summary, as left by a crash.
+    std::filesystem::copy_file(file.path, copy.path);
+  }
+
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(copy.path));
+  std::vector<std::string> all = Query(logFile, log::AllTopics());
+  ASSERT_EQ(20u, all.size());
+  EXPECT_EQ("data19", all.back());
+
+  // Truncated in the middle of a record: the complete chunks are kept.
+  const auto size = std::filesystem::file_size(copy.path);
+  std::filesystem::resize_file(copy.path, size / 2);
+  log::Log truncated;
+  ASSERT_TRUE(truncated.Open(copy.path));
+  all = Query(truncated, log::AllTopics());
+  EXPECT_LT(0u, all.size());
+  EXPECT_GT(20u, all.size());
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, DirectWrites)
+{
+  TempLog file;
+  TempLog copy;
+  log::RecordOptions opts = ChunkedOptions(256);
+  opts.SetDirectWrites(true);
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out, opts));
+    WriteMessages(logFile);
+
+    // The query flushes the last partial block, padded.
+    EXPECT_EQ(100u, Query(logFile, log::AllTopics()).size());
+    std::filesystem::copy_file(file.path, copy.path);
+    EXPECT_TRUE(logFile.InsertMessage(100s, "/even", "msg.type", "x", 1u));
+  }
+
+  // The padding is removed when the log is closed.
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(file.path));
+  EXPECT_EQ(101u, Query(logFile, log::AllTopics()).size());
+
+  // A log left with its padding by a crash is recovered.
+  log::Log interrupted;
+  ASSERT_TRUE(interrupted.Open(copy.path));
+  EXPECT_EQ(100u, Query(interrupted, log::AllTopics()).size());
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, DeduplicateAndDeltaEncode)
+{
+  // A static topic, a topic of which only the header changes, and a topic
+  // that always changes.
+  std::vector<std::pair<std::string, std::string>> messages;
+  const std::string config(100, 'c');
+  for (int i = 0; i < 300; ++i)
+  {
+    std::string state(200, 's');
+    state.replace(0, 8, std::to_string(10000000 + i));
+    std::string noise(64, ' ');
+    for (std::size_t j = 0; j < noise.size(); ++j)
+      noise[j] = static_cast<char>((i * 131 + j * 31) % 251);
+
+    messages.emplace_back("/config", config);
+    messages.emplace_back("/state", state);
+    messages.emplace_back("/noise", noise);
+    messages.emplace_back("/small", "x");
+  }
+
+  std::vector<std::uintmax_t> sizes;
+  for (const auto &[deduplicate, delta] :
+       std::vector<std::pair<bool, bool>>{
+         {false, false}, {true, false}, {false, true}, {true, true}})
+  {
+    TempLog file;
+    log::RecordOptions opts = ChunkedOptions(16 * 1024);
+    opts.SetDeduplicate(deduplicate);
+    opts.SetDeltaEncode(delta);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out, opts));
+      for (std::size_t i = 0; i < messages.size(); ++i)
+      {
+        EXPECT_TRUE(logFile.InsertMessage(std::chrono::milliseconds(i),
+            messages[i].first, "msg.type", messages[i].second.data(),
+            messages[i].second.size()));
+      }
+    }
+    sizes.push_back(std::filesystem::file_size(file.path));
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path));
+    EXPECT_EQ(deduplicate || delta ? "chunked-2" : "chunked-1",
+              logFile.Version());
+
+    std::size_t i = 0;
+    for (const log::Message &msg : logFile.QueryMessages())
+    {
+      ASSERT_LT(i, messages.size());
+      EXPECT_EQ(messages[i].first, msg.Topic());
+      EXPECT_EQ(messages[i].second, msg.Data());
+      ++i;
+    }
+    EXPECT_EQ(messages.size(), i);
+
+    // The messages are rebuilt even when the message they are based on
+    // isn't selected.
+    const log::TopicList state("/state", log::QualifiedTimeRange(
+        log::QualifiedTime(std::chrono::milliseconds(501)),
+        log::QualifiedTime(std::chrono::milliseconds(897))));
+    const std::vector<std::string> data = Query(logFile, state);
+    ASSERT_EQ(100u, data.size());
+    for (std::size_t j = 0; j < data.size(); ++j)
+      EXPECT_EQ(messages[501 + 4 * j].second, data[j]);
+  }
+
+  ASSERT_EQ(4u, sizes.size());
+  EXPECT_LT(sizes[1], sizes[0]);
+  EXPECT_LT(sizes[2], sizes[0]);
+  EXPECT_LT(sizes[3], sizes[1]);
+  EXPECT_LT(sizes[3], sizes[2]);
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, Compression)
+{
+  for (auto codec : {Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    log::RecordOptions opts = ChunkedOptions(1024);
+    if (!opts.SetChunkCompression(codec))
+      continue;
+
+    TempLog file;
+    const std::string data(100, 'a');
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out, opts));
+      for (int i = 0; i < 100; ++i)
+      {
+        EXPECT_TRUE(logFile.InsertMessage(std::chrono::seconds(i), "/topic",
+            "msg.type", data.c_str(), data.size()));
+      }
+    }
+
+    // Compressed chunks take much less space than the messages.
+    EXPECT_GT(100u * data.size() / 2, std::filesystem::file_size(file.path));
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path));
+    std::vector<std::string> all = Query(logFile, log::AllTopics());
+    ASSERT_EQ(100u, all.size());
+    EXPECT_EQ(data, all.back());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, CompressionThreads)
+{
+  for (auto codec : {Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    log::RecordOptions opts = ChunkedOptions(256);
+    if (!opts.SetChunkCompression(codec))
+      continue;
+    opts.SetCompressionThreads(4u);
+
+    TempLog file;
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out, opts));
+      WriteMessages(logFile);
+
+      // The chunks being compressed are written before a query.
+      EXPECT_EQ(99s, logFile.EndTime());
+      EXPECT_EQ(100u, Query(logFile, log::AllTopics()).size());
+      WriteMessages(logFile);
+    }
+
+    // The chunks are written in order.
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path));
+    std::vector<std::string> all = Query(logFile, log::AllTopics());
+    ASSERT_EQ(200u, all.size());
+    for (int i = 0; i < 100; ++i)
+      EXPECT_EQ("data" + std::to_string(i), all[2 * i]);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ChunkedLog, Errors)
+{
+  TempLog file;
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(file.path, std::ios_base::out,
+        ChunkedOptions(1024)));
+  }
+
+  // An existing file is not overwritten.
+  log::Log existing;
+  EXPECT_FALSE(existing.Open(file.path, std::ios_base::out,
+      ChunkedOptions(1024)));
+
+  // An empty log.
+  log::Log empty;
+  ASSERT_TRUE(empty.Open(file.path));
+  EXPECT_TRUE(Query(empty, log::AllTopics()).empty());
+  EXPECT_FALSE(empty.InsertMessage(1s, "/topic", "msg.type", "x", 1u));
+
+  EXPECT_FALSE(log::ChunkedLog::IsChunkedLog("/nonexistent/file"));
+  EXPECT_EQ(nullptr, log::ChunkedLog::Open("/nonexistent/file"));
+}
@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gz/msgs/Factory.hh>
+
+#include "gz/transport/log/ColumnExporter.hh"
+#include "gz/transport/log/QueryOptions.hh"
+#include "Console.hh"
+
+using namespace gz::transport;
+using namespace gz::transport::log;
+
+namespace
+{
+  /// \brief Number of messages decoded by a thread at once.
+  const std::size_t kBlockMessages = 1024;
+
+  /// \brief A field of a path from a message to a scalar field
+  struct FieldStep
+  {
+    /// \brief The field
+    const google::protobuf::FieldDescriptor *field;
+
+    /// \brief Index of the element of a repeated field, or -1 for a
+    /// singular field or every element
+    int index;
+  };
+
+  /// \brief Path from a message to a scalar field
+  using FieldPath = std::vector<FieldStep>;
+
+  /// \brief Messages decoded together by a thread
+  struct Block
+  {
+    /// \brief Time each message was received
+    std::vector<std::chrono::nanoseconds> times;
+
+    /// \brief Serialized messages. The strings are reused from one block to
+    /// the next.
+    std::vector<std::string> data;
+
+    /// \brief Number of messages in the block
+    std::size_t size = 0;
+
+    /// \brief Rows of the messages
+    std::string csv;
+
+    /// \brief Number of messages that failed to parse
+    std::size_t failed = 0;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Resolve the path of a column in a message type.
+  /// \param[in] _type The message type
+  /// \param[in] _path The path, e.g. "pose[2].position.x"
+  /// \param[out] _fields The fields of the path
+  /// \return True if the path leads to a scalar field
+  bool ResolvePath(const google::protobuf::Descriptor *_type,
+                   const std::string &_path, FieldPath &_fields)
+  {
+    _fields.clear();
+    std::size_t begin = 0;
+    while (true)
+    {
+      const std::size_t end = std::min(_path.find('.', begin), _path.size());
+      std::string name = _path.substr(begin, end - begin);
+
+      int index = -1;
+      const std::size_t bracket = name.find('[');
+      if (bracket != std::string::npos)
+      {
+        const char *first = name.data() + bracket + 1;
+        const char *last = name.data() + name.size() - 1;
+        const auto result = std::from_chars(first, last, index);
+        if (name.back() != ']' || result.ec != std::errc() ||
+            result.ptr != last || index < 0)
+        {
+          LERR("Invalid index in [" << _path << "]\n");
+          return false;
+        }
+        name.resize(bracket);
+      }
+
+      const google::protobuf::FieldDescriptor *field =
+          _type ? _type->FindFieldByName(name) : nullptr;
+      if (!field)
+      {
+        LERR("No field [" << name << "] in [" << _path << "]\n");
+        return false;
+      }
+      if (index >= 0 && !field->is_repeated())
+      {
+        LERR("Field [" << name << "] of [" << _path << "] is not "
+             "repeated\n");
+        return false;
+      }
+      _fields.push_back({field, index});
+
+      const bool message =
+        field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE;
+      if (end == _path.size())
+      {
+        if (message)
+        {
+          LERR("[" << _path << "] is a message, not a scalar field\n");
+          return false;
+        }
+        return true;
+      }
+
+      if (!message || (field->is_repeated() && index < 0))
+      {
+        LERR("Field [" << name << "] of [" << _path << "] must be a message"
+             << (message ? " with an index" : "") << "\n");
+        return false;
+      }
+      _type = field->message_type();
+      begin = end + 1;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append a cell of text, quoted if needed.
+  /// \param[in] _text The text
+  /// \param[in,out] _csv The row to append to
+  void AppendText(std::string_view _text, std::string &_csv)
+  {
+    if (_text.find_first_of(",\"\r\n") == std::string_view::npos)
+    {
+      _csv.append(_text);
+      return;
+    }
+
+    _csv += '"';
+    for (const char c : _text)
+    {
+      if (c == '"')
+        _csv += '"';
+      _csv += c;
+    }
+    _csv += '"';
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append a number in its shortest form that reads back the same.
+  /// \param[in] _value The number
+  /// \param[in,out] _csv The row to append to
+  template <typename T>
+  void AppendNumber(const T _value, std::string &_csv)
+  {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), _value);
+    _csv.append(buffer, result.ptr);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append the value of a scalar field.
+  /// \param[in] _msg The message with the field
+  /// \param[in] _field The field
+  /// \param[in] _index Index of the element of a repeated field, or -1 for a
+  /// singular field
+  /// \param[in,out] _csv The row to append to
+  void AppendValue(const google::protobuf::Message &_msg,
+                   const google::protobuf::FieldDescriptor *_field,
+                   const int _index, std::string &_csv)
+  {
+    using google::protobuf::FieldDescriptor;
+    const google::protobuf::Reflection *reflection = _msg.GetReflection();
+    const bool repeated = _index >= 0;
+    switch (_field->cpp_type())
+    {
+      case FieldDescriptor::CPPTYPE_INT32:
+        AppendNumber(repeated ?
+            reflection->GetRepeatedInt32(_msg, _field, _index) :
+            reflection->GetInt32(_msg, _field), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        AppendNumber(repeated ?
+            reflection->GetRepeatedInt64(_msg, _field, _index) :
+            reflection->GetInt64(_msg, _field), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        AppendNumber(repeated ?
+            reflection->GetRepeatedUInt32(_msg, _field, _index) :
+            reflection->GetUInt32(_msg, _field), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        AppendNumber(repeated ?
+            reflection->GetRepeatedUInt64(_msg, _field, _index) :
+            reflection->GetUInt64(_msg, _field), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        AppendNumber(repeated ?
+            reflection->GetRepeatedDouble(_msg, _field, _index) :
+            reflection->GetDouble(_msg, _field), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        AppendNumber(repeated ?
+            reflection->GetRepeatedFloat(_msg, _field, _index) :
+            reflection->GetFloat(_msg, _field), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        _csv += (repeated ?
+            reflection->GetRepeatedBool(_msg, _field, _index) :
+            reflection->GetBool(_msg, _field)) ? "true" : "false";
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        AppendText((repeated ?
+            reflection->GetRepeatedEnum(_msg, _field, _index) :
+            reflection->GetEnum(_msg, _field))->name(), _csv);
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+      {
+        std::string scratch;
+        const std::string &text = repeated ?
+            reflection->GetRepeatedStringReference(
+              _msg, _field, _index, &scratch) :
+            reflection->GetStringReference(_msg, _field, &scratch);
+        if (_field->type() != FieldDescriptor::TYPE_BYTES)
+        {
+          AppendText(text, _csv);
+          break;
+        }
+
+        static const char kHex[] = "0123456789abcdef";
+        for (const char c : text)
+        {
+          const auto byte = static_cast<unsigned char>(c);
+          _csv += kHex[byte >> 4];
+          _csv += kHex[byte & 0xf];
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append the cell of a column.
+  /// \param[in] _msg The message of the row
+  /// \param[in] _path The path of the column
+  /// \param[in,out] _csv The row to append to
+  void AppendCell(const google::protobuf::Message &_msg,
+                  const FieldPath &_path, std::string &_csv)
+  {
+    const google::protobuf::Message *msg = &_msg;
+    for (std::size_t i = 0; i + 1 < _path.size(); ++i)
+    {
+      const FieldStep &step = _path[i];
+      const google::protobuf::Reflection *reflection = msg->GetReflection();
+      if (step.index < 0)
+      {
+        msg = &reflection->GetMessage(*msg, step.field);
+        continue;
+      }
+      if (step.index >= reflection->FieldSize(*msg, step.field))
+        return;
+      msg = &reflection->GetRepeatedMessage(*msg, step.field, step.index);
+    }
+
+    const FieldStep &last = _path.back();
+    if (!last.field->is_repeated())
+    {
+      AppendValue(*msg, last.field, -1, _csv);
+      return;
+    }
+
+    const int size = msg->GetReflection()->FieldSize(*msg, last.field);
+    if (last.index >= 0)
+    {
+      if (last.index < size)
+        AppendValue(*msg, last.field, last.index, _csv);
+      return;
+    }
+
+    for (int i = 0; i < size; ++i)
+    {
+      if (i > 0)
+        _csv += ' ';
+      AppendValue(*msg, last.field, i, _csv);
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Decode the messages of a block into rows.
+  /// \param[in] _type The message type
+  /// \param[in] _columns The path of each column
+  /// \param[in,out] _block The block
+  void DecodeBlock(const std::string &_type,
+                   const std::vector<FieldPath> &_columns, Block &_block)
+  {
+    _block.csv.clear();
+    _block.failed = 0;
+    const auto msg = gz::msgs::Factory::New(_type);
+    for (std::size_t i = 0; i < _block.size; ++i)
+    {
+      if (!msg->ParseFromString(_block.data[i]))
+      {
+        ++_block.failed;
+        continue;
+      }
+
+      AppendNumber(_block.times[i].count(), _block.csv);
+      for (const FieldPath &column : _columns)
+      {
+        _block.csv += ',';
+        AppendCell(*msg, column, _block.csv);
+      }
+      _block.csv += '\n';
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Private implementation
+class gz::transport::log::ColumnExporter::Implementation
+{
+  /// \brief Path of each column
+  public: std::vector<std::string> columns;
+
+  /// \brief Number of threads decoding the messages, or 0 for the number of
+  /// cores
+  public: std::size_t threads = 0;
+};
+
+//////////////////////////////////////////////////
+ColumnExporter::ColumnExporter()
+  : dataPtr(new Implementation)
+{
+}
+
+//////////////////////////////////////////////////
+ColumnExporter::~ColumnExporter()
+{
+}
+
+//////////////////////////////////////////////////
+void ColumnExporter::AddColumn(const std::string &_path)
+{
+  this->dataPtr->columns.push_back(_path);
+}
+
+//////////////////////////////////////////////////
+const std::vector<std::string> &ColumnExporter::Columns() const
+{
+  return this->dataPtr->columns;
+}
+
+//////////////////////////////////////////////////
+void ColumnExporter::SetThreads(const std::size_t _threads)
+{
+  this->dataPtr->threads = _threads;
+}
+
+//////////////////////////////////////////////////
+int64_t ColumnExporter::ExportCsv(Log &_log, const std::string &_topic,
+    std::ostream &_output, const QualifiedTimeRange &_range) const
+{
+  const log::Descriptor *desc = _log.Descriptor();
+  if (!desc)
+  {
+    LERR("Cannot export the messages of an invalid log\n");
+    return -1;
+  }
+
+  const auto topic = desc->TopicsToMsgTypesToId().find(_topic);
+  if (topic == desc->TopicsToMsgTypesToId().end())
+  {
+    LERR("No topic [" << _topic << "] in the log\n");
+    return -1;
+  }
+  if (topic->second.size() != 1)
+  {
+    LERR("The messages of [" << _topic << "] are of several types\n");
+    return -1;
+  }
+
+  const std::string &type = topic->second.begin()->first;
+  const auto prototype = gz::msgs::Factory::New(type);
+  if (!prototype)
+  {
+    LERR("Unknown message type [" << type << "]\n");
+    return -1;
+  }
+
+  std::vector<FieldPath> columns(this->dataPtr->columns.size());
+  std::string header = "time";
+  for (std::size_t i = 0; i < columns.size(); ++i)
+  {
+    if (!ResolvePath(prototype->GetDescriptor(), this->dataPtr->columns[i],
+          columns[i]))
+    {
+      return -1;
+    }
+    header += ',';
+    AppendText(this->dataPtr->columns[i], header);
+  }
+  _output << header << '\n';
+
+  std::size_t threads = this->dataPtr->threads;
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  // The messages are read on this thread, a block per decoding thread, then
+  // the blocks are decoded in parallel and written in order
+  std::vector<Block> blocks(threads);
+  Batch batch = _log.QueryMessages(TopicList(_topic, _range));
+  Batch::iterator iter = batch.begin();
+  int64_t rows = 0;
+  std::size_t failed = 0;
+  while (iter != batch.end())
+  {
+    std::size_t used = 0;
+    for (; used < blocks.size() && iter != batch.end(); ++used)
+    {
+      Block &block = blocks[used];
+      block.size = 0;
+      for (; block.size < kBlockMessages && iter != batch.end(); ++iter)
+      {
+        if (block.data.size() == block.size)
+        {
+          block.data.emplace_back();
+          block.times.emplace_back();
+        }
+        const std::string_view data = iter->DataView();
+        block.data[block.size].assign(data.data(), data.size());
+        block.times[block.size] = iter->TimeReceived();
+        ++block.size;
+      }
+    }
+
+    std::vector<std::thread> decoders;
+    for (std::size_t i = 1; i < used; ++i)
+      decoders.emplace_back(DecodeBlock, type, std::cref(columns),
+          std::ref(blocks[i]));
+    DecodeBlock(type, columns, blocks[0]);
+    for (std::thread &decoder : decoders)
+      decoder.join();
+
+    for (std::size_t i = 0; i < used; ++i)
+    {
+      _output.write(blocks[i].csv.data(),
+          static_cast<std::streamsize>(blocks[i].csv.size()));
+      rows += static_cast<int64_t>(blocks[i].size - blocks[i].failed);
+      failed += blocks[i].failed;
+    }
+
+    if (!_output)
+    {
+      LERR("Failed to write the messages of [" << _topic << "]\n");
+      return -1;
+    }
+  }
+
+  if (failed > 0)
+  {
+    LWRN("Skipped " << failed << " messages of [" << _topic
+         << "] which failed to parse as [" << type << "]\n");
+  }
+  return rows;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include "gtest/gtest.h"
+
+#include <gz/msgs/int32_v.pb.h>
+#include <gz/msgs/pose_v.pb.h>
+
+#include <chrono>
+#include <ios>
+#include <sstream>
+#include <string>
+
+#include "gz/transport/log/ColumnExporter.hh"
+#include "gz/transport/log/Log.hh"
+
+using namespace gz;
+using namespace gz::transport;
+using namespace std::chrono_literals;
+
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Insert a message in a log.
+  /// \param[in] _log The log
+  /// \param[in] _time Time the message was received
+  /// \param[in] _topic Topic of the message
+  /// \param[in] _msg The message
+  void Insert(log::Log &_log, const std::chrono::nanoseconds _time,
+              const std::string &_topic, const google::protobuf::Message &_msg)
+  {
+    const std::string data = _msg.SerializeAsString();
+    ASSERT_TRUE(_log.InsertMessage(_time, _topic, _msg.GetTypeName(),
+      reinterpret_cast<const void *>(data.data()), data.size()));
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ColumnExporter, ExportCsv)
+{
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
+
+  for (int i = 0; i < 3000; ++i)
+  {
+    msgs::Pose_V poses;
+    msgs::Pose *pose = poses.add_pose();
+    pose->set_name(i % 2 ? "a,b" : "c");
+    pose->set_id(i);
+    pose->mutable_position()->set_x(i * 0.5);
+    if (i % 3 == 0)
+      poses.add_pose()->set_name("second");
+    Insert(logFile, std::chrono::nanoseconds(i), "/poses", poses);
+  }
+
+  log::ColumnExporter exporter;
+  exporter.AddColumn("pose[0].name");
+  exporter.AddColumn("pose[0].id");
+  exporter.AddColumn("pose[0].position.x");
+  exporter.AddColumn("pose[1].name");
+  exporter.SetThreads(3);
+  EXPECT_EQ(4u, exporter.Columns().size());
+
+  std::stringstream csv;
+  EXPECT_EQ(3000, exporter.ExportCsv(logFile, "/poses", csv));
+
+  std::string line;
+  ASSERT_TRUE(std::getline(csv, line));
+  EXPECT_EQ("time,pose[0].name,pose[0].id,pose[0].position.x,pose[1].name",
+            line);
+  ASSERT_TRUE(std::getline(csv, line));
+  EXPECT_EQ("0,c,0,0,second", line);
+  ASSERT_TRUE(std::getline(csv, line));
+  EXPECT_EQ("1,\"a,b\",1,0.5,", line);
+
+  int rows = 2;
+  while (std::getline(csv, line))
+  {
+    ++rows;
+    if (rows == 2049)
+    {
+      EXPECT_EQ("2048,c,2048,1024,", line);
+    }
+  }
+  EXPECT_EQ(3000, rows);
+
+  // Only the messages of the time range are exported
+  std::stringstream range;
+  EXPECT_EQ(10, exporter.ExportCsv(logFile, "/poses", range,
+    log::QualifiedTimeRange(100ns, 109ns)));
+}
+
+//////////////////////////////////////////////////
+TEST(ColumnExporter, RepeatedScalar)
+{
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
+
+  msgs::Int32_V values;
+  values.add_data(1);
+  values.add_data(-2);
+  values.add_data(3);
+  Insert(logFile, 5ns, "/values", values);
+
+  log::ColumnExporter exporter;
+  exporter.AddColumn("data");
+  exporter.AddColumn("data[1]");
+  exporter.AddColumn("data[7]");
+
+  std::stringstream csv;
+  EXPECT_EQ(1, exporter.ExportCsv(logFile, "/values", csv));
+  EXPECT_EQ("time,data,data[1],data[7]\n5,1 -2 3,-2,\n", csv.str());
+}
+
+//////////////////////////////////////////////////
+TEST(ColumnExporter, InvalidColumns)
+{
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
+  msgs::Pose_V poses;
+  poses.add_pose()->set_name("a");
+  Insert(logFile, 0ns, "/poses", poses);
+
+  std::stringstream csv;
+  for (const std::string path : {"foo", "pose", "pose.name", "pose[x].name",
+       "pose[0]", "pose[0].name.foo", "pose[0].id[0]"})
+  {
+    log::ColumnExporter exporter;
+    exporter.AddColumn(path);
+    EXPECT_EQ(-1, exporter.ExportCsv(logFile, "/poses", csv)) << path;
+  }
+
+  log::ColumnExporter exporter;
+  EXPECT_EQ(-1, exporter.ExportCsv(logFile, "/missing", csv));
+
+  log::Log unopened;
+  EXPECT_EQ(-1, exporter.ExportCsv(unopened, "/poses", csv));
+}
@@ -23,49 +23,91 @@
 using namespace gz::transport::log;
 
 //////////////////////////////////////////////////
-void Descriptor::Implementation::Reset(const TopicKeyMap &_columns)
+void Descriptor::Implementation::Reset(const TopicKeyMap &_topics)
 {
-  topicsToMsgTypesToId.clear();
-  msgTypesToTopicsToId.clear();
+  this->Reset(TopicKeyMap(_topics));
+}
+
+//////////////////////////////////////////////////
+void Descriptor::Implementation::Reset(TopicKeyMap &&_topics)  // NOLINT
+{
+  std::lock_guard<std::mutex> lock(this->mapsMutex);
+  this->topics = std::move(_topics);
+  this->topicsToMsgTypesToId.clear();
+  this->msgTypesToTopicsToId.clear();
+  this->topicsMapBuilt = false;
+  this->msgTypesMapBuilt = false;
+}
 
-  for (const auto &entry : _columns)
+//////////////////////////////////////////////////
+void Descriptor::Implementation::Insert(const TopicKey &_key,
+    const int64_t _id)
+{
+  std::lock_guard<std::mutex> lock(this->mapsMutex);
+  this->topics[_key] = _id;
+  if (this->topicsMapBuilt)
+    this->topicsToMsgTypesToId[_key.topic][_key.type] = _id;
+  if (this->msgTypesMapBuilt)
+    this->msgTypesToTopicsToId[_key.type][_key.topic] = _id;
+}
+
+//////////////////////////////////////////////////
+auto Descriptor::Implementation::TopicsMap() const -> const NameToMap &
+{
+  std::lock_guard<std::mutex> lock(this->mapsMutex);
+  if (!this->topicsMapBuilt)
   {
-    const TopicKey &key = entry.first;
-    int64_t id = entry.second;
+    for (const auto &[key, id] : this->topics)
+      this->topicsToMsgTypesToId[key.topic][key.type] = id;
+    this->topicsMapBuilt = true;
+  }
+  return this->topicsToMsgTypesToId;
+}
 
-    this->topicsToMsgTypesToId[key.topic][key.type] = id;
-    this->msgTypesToTopicsToId[key.type][key.topic] = id;
+//////////////////////////////////////////////////
+auto Descriptor::Implementation::MsgTypesMap() const -> const NameToMap &
+{
+  std::lock_guard<std::mutex> lock(this->mapsMutex);
+  if (!this->msgTypesMapBuilt)
+  {
+    for (const auto &[key, id] : this->topics)
+      this->msgTypesToTopicsToId[key.type][key.topic] = id;
+    this->msgTypesMapBuilt = true;
   }
+  return this->msgTypesToTopicsToId;
 }
 
 //////////////////////////////////////////////////
 auto Descriptor::TopicsToMsgTypesToId() const -> const NameToMap &
 {
-  return this->dataPtr->topicsToMsgTypesToId;
+  return this->dataPtr->TopicsMap();
 }
 
 //////////////////////////////////////////////////
 auto Descriptor::MsgTypesToTopicsToId() const -> const NameToMap &
 {
-  return this->dataPtr->msgTypesToTopicsToId;
+  return this->dataPtr->MsgTypesMap();
 }
 
 //////////////////////////////////////////////////
 int64_t Descriptor::TopicId(const std::string &_topicName,
     const std::string &_msgType) const
 {
-  auto iter = this->dataPtr->topicsToMsgTypesToId.find(_topicName);
-  if (iter == this->dataPtr->topicsToMsgTypesToId.end())
+  TopicKey key;
+  key.topic = _topicName;
+  key.type = _msgType;
+  auto iter = this->dataPtr->topics.find(key);
+  if (iter == this->dataPtr->topics.end())
   {
     return -1;
   }
+  return iter->second;
+}
 
-  auto typeIter = iter->second.find(_msgType);
-  if (typeIter == iter->second.end())
-  {
-    return -1;
-  }
-  return typeIter->second;
+//////////////////////////////////////////////////
+bool Descriptor::TopicTimeIndexed() const
+{
+  return this->dataPtr->topicTimeIndexed;
 }
 
 //////////////////////////////////////////////////
@@ -18,7 +18,9 @@
 #ifndef GZ_TRANSPORT_LOG_SRC_DESCRIPTOR_HH_
 #define GZ_TRANSPORT_LOG_SRC_DESCRIPTOR_HH_
 
+#include <cstdint>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -62,7 +64,35 @@ namespace gz
                   this->type == _other.type);
         }
       };
+      }
+    }
+  }
+}
 
+//////////////////////////////////////////////////
+/// \brief Allow a TopicKey to be used as a key in a std::unordered_map
+namespace std {
+  template <> struct hash<gz::transport::log::TopicKey>
+  {
+    size_t operator()(
+        const gz::transport::log::TopicKey &_key) const
+    {
+      // Terrible, but it gets the job done
+      return (std::hash<std::string>()(_key.topic) << 16)
+        + std::hash<std::string>()(_key.type);
+    }
+  };
+}
+
+namespace gz
+{
+  namespace transport
+  {
+    namespace log
+    {
+      // Inline bracket to help doxygen filtering.
+      inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+      //
       /// \brief A map from the (topic, message type) of a topic to its integer
       /// key in the database.
       using TopicKeyMap = std::unordered_map<TopicKey, int64_t>;
@@ -78,17 +108,52 @@ namespace gz
         /// \param[in] _topics The map of topics that the log contains.
         public: void Reset(const TopicKeyMap &_topics);
 
+        /// \internal Reset this descriptor, taking the map of topics.
+        /// \param[in] _topics The map of topics that the log contains.
+        public: void Reset(TopicKeyMap &&_topics);  // NOLINT
+
+        /// \internal Add a topic, e.g. when it is inserted in the log, so
+        /// that the descriptor doesn't need to be reset.
+        /// \param[in] _key The topic name and message type.
+        /// \param[in] _id The id of the topic.
+        public: void Insert(const TopicKey &_key, int64_t _id);
+
+        /// \internal Get the map of topic names, built on first use.
+        /// \return The map of topic names to message types to ids.
+        public: const NameToMap &TopicsMap() const;
+
+        /// \internal Get the map of message types, built on first use.
+        /// \return The map of message types to topic names to ids.
+        public: const NameToMap &MsgTypesMap() const;
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
 #pragma warning(push)
 #pragma warning(disable: 4251)
 #endif
+        /// \internal The topics of the log, which answer TopicId(). The
+        /// maps by name are only built when they are used, since a log may
+        /// hold thousands of topics and most users need a few of them.
+        public: TopicKeyMap topics;
+
         /// \internal \sa Descriptor::TopicsToMsgTypesToId()
-        public: NameToMap topicsToMsgTypesToId;
+        public: mutable NameToMap topicsToMsgTypesToId;
 
         /// \internal \sa Descriptor::MsgTypesToTopicsToId()
-        public: NameToMap msgTypesToTopicsToId;
+        public: mutable NameToMap msgTypesToTopicsToId;
+
+        /// \internal True once topicsToMsgTypesToId holds the topics
+        public: mutable bool topicsMapBuilt = false;
+
+        /// \internal True once msgTypesToTopicsToId holds the topics
+        public: mutable bool msgTypesMapBuilt = false;
+
+        /// \internal Protects the maps built on first use
+        public: mutable std::mutex mapsMutex;
+
+        /// \internal \sa Descriptor::TopicTimeIndexed()
+        public: bool topicTimeIndexed = false;
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
@@ -98,19 +163,4 @@ namespace gz
   }
 }
 
-//////////////////////////////////////////////////
-/// \brief Allow a TopicKey to be used as a key in a std::unordered_map
-namespace std {
-  template <> struct hash<gz::transport::log::TopicKey>
-  {
-    size_t operator()(
-        const gz::transport::log::TopicKey &_key) const
-    {
-      // Terrible, but it gets the job done
-      return (std::hash<std::string>()(_key.topic) << 16)
-        + std::hash<std::string>()(_key.type);
-    }
-  };
-}
-
 #endif
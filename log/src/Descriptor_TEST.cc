@@ -39,6 +39,14 @@ class gz::transport::log::Log
   {
     descriptor.dataPtr->Reset(_topics);
   }
+
+  /// \brief call descriptor api Insert()
+  /// \sa Descriptor::Implementation::Insert(const TopicKey &, int64_t)
+  public: static void Insert(
+      Descriptor &descriptor, const TopicKey &_key, int64_t _id)
+  {
+    descriptor.dataPtr->Insert(_key, _id);
+  }
 };
 
 //////////////////////////////////////////////////
@@ -143,6 +151,36 @@ TEST(Descriptor, MsgTypesMapOneTopic)
   EXPECT_EQ(5, topicsMap.begin()->second);
 }
 
+//////////////////////////////////////////////////
+TEST(Descriptor, InsertTopics)
+{
+  Descriptor desc = Log::Construct();
+  TopicKeyMap topics;
+  topics[{"/foo/bar", "gz.msgs.DNE"}] = 5;
+  Log::Reset(desc, topics);
+
+  // A topic inserted before the maps are used
+  Log::Insert(desc, {"/fiz/buz", "gz.msgs.DNE"}, 6);
+  EXPECT_EQ(6, desc.TopicId("/fiz/buz", "gz.msgs.DNE"));
+  ASSERT_EQ(2u, desc.TopicsToMsgTypesToId().size());
+  EXPECT_EQ(6, desc.TopicsToMsgTypesToId().at("/fiz/buz").at("gz.msgs.DNE"));
+
+  // And after
+  Log::Insert(desc, {"/foo/bar", "gz.msgs.DNE2"}, 7);
+  EXPECT_EQ(7, desc.TopicId("/foo/bar", "gz.msgs.DNE2"));
+  EXPECT_EQ(2u, desc.TopicsToMsgTypesToId().at("/foo/bar").size());
+  const auto &msgsMap = desc.MsgTypesToTopicsToId();
+  ASSERT_EQ(2u, msgsMap.size());
+  EXPECT_EQ(2u, msgsMap.at("gz.msgs.DNE").size());
+  EXPECT_EQ(7, msgsMap.at("gz.msgs.DNE2").at("/foo/bar"));
+
+  // A reset forgets them
+  Log::Reset(desc, topics);
+  EXPECT_GT(0, desc.TopicId("/fiz/buz", "gz.msgs.DNE"));
+  EXPECT_EQ(1u, desc.TopicsToMsgTypesToId().size());
+  EXPECT_EQ(1u, desc.MsgTypesToTopicsToId().size());
+}
+
 //////////////////////////////////////////////////
 TEST(Descriptor, TopicKeyEquality)
 {
@@ -17,27 +17,443 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <functional>
+#include <limits>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "gz/transport/log/Descriptor.hh"
 #include "gz/transport/log/Log.hh"
+#include "gz/transport/log/RecordOptions.hh"
 #include "gz/transport/log/SqlStatement.hh"
 #include "BatchPrivate.hh"
 #include "build_config.hh"
+#include "ChunkedLog.hh"
 #include "Console.hh"
 #include "Descriptor.hh"
+#include "MessageDictionary.hh"
+#include "MsgIterPrivate.hh"
 #include "raii-sqlite3.hh"
 
 using namespace gz::transport;
 using namespace gz::transport::log;
 
+namespace
+{
+  /// \brief Size of the memory mapping of a log opened for reading (bytes).
+  const int64_t kReadMmapSize = int64_t(1) << 40;
+
+  /// \brief How long a log opened for reading waits for a commit of a
+  /// recorder which isn't in WAL mode to finish, instead of failing (ms).
+  const int kReadBusyTimeout = 1000;
+
+  /// \brief Number of messages of each partition of a merged query read
+  /// ahead of the iterators.
+  const std::size_t kMergedReadAheadMessages = 256;
+
+  /// \brief Size of the messages of each partition of a merged query read
+  /// ahead of the iterators (bytes).
+  const std::size_t kMergedReadAheadBytes = 16 * 1024 * 1024;
+
+  /// \brief Versions of the schema, oldest first. The schema file of the
+  /// first version creates a database, and the file of each next version
+  /// migrates a database from the version before it.
+  const std::vector<std::string> kSchemaVersions =
+    {"0.1.0", "0.2.0", "0.3.0", "0.4.0"};
+
+  /// \brief Reset a cached statement when it goes out of scope, so it can be
+  /// executed again and doesn't keep the transaction busy.
+  class StatementReset
+  {
+    /// \brief Constructor
+    /// \param[in] _statement The statement to reset
+    public: explicit StatementReset(raii_sqlite3::Statement &_statement)
+      : handle(_statement.Handle())
+    {
+    }
+
+    /// \brief Destructor
+    public: ~StatementReset()
+    {
+      sqlite3_reset(this->handle);
+    }
+
+    /// \brief The statement to reset
+    private: sqlite3_stmt *handle;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Run a PRAGMA statement and get its result.
+  /// \param[in] _db The database
+  /// \param[in] _pragma The PRAGMA statement
+  /// \param[out] _result The first column of the first row, if any
+  /// \return True if the statement succeeded
+  bool RunPragma(raii_sqlite3::Database &_db, const std::string &_pragma,
+                 std::string &_result)
+  {
+    raii_sqlite3::Statement statement(_db, _pragma);
+    if (!statement)
+    {
+      LERR("Failed to compile [" << _pragma << "]\n");
+      return false;
+    }
+
+    int returnCode = sqlite3_step(statement.Handle());
+    if (returnCode == SQLITE_ROW)
+    {
+      const unsigned char *text = sqlite3_column_text(statement.Handle(), 0);
+      if (text)
+        _result = reinterpret_cast<const char *>(text);
+      returnCode = sqlite3_step(statement.Handle());
+    }
+    if (returnCode != SQLITE_DONE)
+    {
+      LERR("Failed to run [" << _pragma << "]: "
+          << sqlite3_errmsg(_db.Handle()) << "\n");
+      return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Run a statement which returns no row.
+  /// \param[in] _db The database
+  /// \param[in] _sql The statement with its parameters
+  /// \return True if the statement succeeded
+  bool RunStatement(raii_sqlite3::Database &_db, const SqlStatement &_sql)
+  {
+    raii_sqlite3::Statement statement(_db, _sql.statement);
+    if (!statement || !MsgIterPrivate::BindParameters(statement, _sql))
+    {
+      LERR("Failed to compile [" << _sql.statement << "]: "
+          << sqlite3_errmsg(_db.Handle()) << "\n");
+      return false;
+    }
+
+    if (sqlite3_step(statement.Handle()) != SQLITE_DONE)
+    {
+      LERR("Failed to run [" << _sql.statement << "]: "
+          << sqlite3_errmsg(_db.Handle()) << "\n");
+      return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Apply the options of a log file opened for writing. The page
+  /// size must be set before the schema is created.
+  /// \param[in] _db The database
+  /// \param[in] _options The options
+  /// \return True if the options were applied
+  bool ApplyRecordOptions(raii_sqlite3::Database &_db,
+                          const RecordOptions &_options)
+  {
+    std::string result;
+    if (_options.PageSize() > 0 && !RunPragma(_db,
+          "PRAGMA page_size=" + std::to_string(_options.PageSize()) + ";",
+          result))
+    {
+      return false;
+    }
+
+    if (_options.CacheSize() > 0 && !RunPragma(_db,
+          "PRAGMA cache_size=-" + std::to_string(_options.CacheSize()) + ";",
+          result))
+    {
+      return false;
+    }
+
+    // Like the page size, the auto-vacuum mode is set before the schema.
+    const char *autoVacuum = nullptr;
+    switch (_options.AutoVacuum())
+    {
+      case log::AutoVacuum::FULL:
+        autoVacuum = "FULL";
+        break;
+      case log::AutoVacuum::INCREMENTAL:
+        autoVacuum = "INCREMENTAL";
+        break;
+      case log::AutoVacuum::NONE:
+      default:
+        break;
+    }
+    if (autoVacuum && !RunPragma(_db,
+          std::string("PRAGMA auto_vacuum=") + autoVacuum + ";", result))
+    {
+      return false;
+    }
+
+    // The file grows in steps of the chunk size instead of page by page.
+    // In-memory databases have no file, so they ignore it.
+    if (_options.PreallocateSize() > 0)
+    {
+      int chunkSize = static_cast<int>(std::min<uint64_t>(
+        _options.PreallocateSize(), std::numeric_limits<int>::max()));
+      sqlite3_file_control(_db.Handle(), "main", SQLITE_FCNTL_CHUNK_SIZE,
+          &chunkSize);
+    }
+
+    const char *journal = nullptr;
+    switch (_options.Journal())
+    {
+      case JournalMode::WAL:
+        journal = "wal";
+        break;
+      case JournalMode::MEMORY:
+        journal = "memory";
+        break;
+      case JournalMode::OFF:
+        journal = "off";
+        break;
+      case JournalMode::ROLLBACK:
+      default:
+        break;
+    }
+    if (journal)
+    {
+      result.clear();
+      if (!RunPragma(_db, std::string("PRAGMA journal_mode=") + journal + ";",
+            result))
+      {
+        return false;
+      }
+      // SQLite keeps the current mode if the requested one isn't available,
+      // e.g. WAL for in-memory databases.
+      if (result != journal)
+      {
+        LWRN("Journal mode [" << journal << "] is not available, using ["
+            << result << "]\n");
+      }
+    }
+
+    const char *synchronous = nullptr;
+    switch (_options.Synchronous())
+    {
+      case log::Synchronous::OFF:
+        synchronous = "OFF";
+        break;
+      case log::Synchronous::NORMAL:
+        synchronous = "NORMAL";
+        break;
+      case log::Synchronous::FULL:
+      default:
+        break;
+    }
+    if (synchronous && !RunPragma(_db,
+          std::string("PRAGMA synchronous=") + synchronous + ";", result))
+    {
+      return false;
+    }
+
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the schema version of a database
+  /// \param[in] _db The database
+  /// \return The version, or an empty string if the database has none
+  std::string SchemaVersion(raii_sqlite3::Database &_db)
+  {
+    // Compile the statement
+    const char *get_version =
+      "SELECT to_version FROM migrations ORDER BY id DESC LIMIT 1;";
+    raii_sqlite3::Statement statement(_db, get_version);
+    if (!statement)
+    {
+      LERR("Failed to compile version query statement\n");
+      return "";
+    }
+
+    // Try to run it
+    int result_code = sqlite3_step(statement.Handle());
+    if (result_code != SQLITE_ROW)
+    {
+      LERR("Database has no version\n");
+      return "";
+    }
+
+    // Version is free'd automatically when statement is destructed
+    const unsigned char *version = sqlite3_column_text(statement.Handle(), 0);
+    return std::string(reinterpret_cast<const char *>(version));
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Run the schema file of a version on a database
+  /// \param[in] _db The database
+  /// \param[in] _version The version of the schema file
+  /// \return True if the schema was applied
+  bool ApplySchema(raii_sqlite3::Database &_db, const std::string &_version)
+  {
+    // Test hook so tests can be run before `make install`
+    std::string schemaFile;
+    const char *envPath = std::getenv(SchemaLocationEnvVar.c_str());
+
+    if (envPath)
+    {
+      schemaFile = envPath;
+    }
+    else
+    {
+      schemaFile = SCHEMA_INSTALL_PATH;
+    }
+    schemaFile += "/" + _version + ".sql";
+
+    LDBG("Schema file: " << schemaFile << "\n");
+    std::ifstream fin(schemaFile, std::ifstream::in);
+    if (!fin)
+    {
+      LERR("Failed to open schema [" << schemaFile << "].\n"
+          << " Set " << SchemaLocationEnvVar << " to the schema location.\n");
+      return false;
+    }
+
+    // Read the schema file
+    std::string schema;
+    char buffer[4096];
+    while (fin)
+    {
+      fin.read(buffer, sizeof(buffer));
+      schema.insert(schema.size(), buffer, fin.gcount());
+    }
+    if (schema.empty())
+    {
+      LERR("Failed to read schema file [" << schemaFile << "]\n");
+      return false;
+    }
+
+    // Apply the schema to the database
+    int returnCode = sqlite3_exec(_db.Handle(), schema.c_str(), NULL, 0, NULL);
+    if (returnCode != SQLITE_OK)
+    {
+      LERR("Failed to apply schema " << _version << ": "
+          << sqlite3_errmsg(_db.Handle()) << "\n");
+      return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Bring the schema of a database up to date, in one transaction.
+  /// \param[in] _db The database
+  /// \param[in] _version The current version of its schema, or an empty
+  /// string to create the schema
+  /// \return True if the database has the latest schema
+  bool UpdateSchema(raii_sqlite3::Database &_db, const std::string &_version)
+  {
+    auto next = kSchemaVersions.begin();
+    if (!_version.empty())
+    {
+      next = std::find(kSchemaVersions.begin(), kSchemaVersions.end(),
+                       _version);
+      if (next == kSchemaVersions.end())
+      {
+        LERR("Log file Version '" << _version
+            << "' is unsupported by this tool\n");
+        return false;
+      }
+      ++next;
+    }
+
+    if (next == kSchemaVersions.end())
+      return true;
+
+    if (sqlite3_exec(_db.Handle(), "BEGIN;", NULL, 0, NULL) != SQLITE_OK)
+    {
+      LERR("Failed to begin the schema update: "
+          << sqlite3_errmsg(_db.Handle()) << "\n");
+      return false;
+    }
+
+    for (; next != kSchemaVersions.end(); ++next)
+    {
+      if (!ApplySchema(_db, *next))
+      {
+        sqlite3_exec(_db.Handle(), "ROLLBACK;", NULL, 0, NULL);
+        return false;
+      }
+    }
+
+    if (sqlite3_exec(_db.Handle(), "COMMIT;", NULL, 0, NULL) != SQLITE_OK)
+    {
+      LERR("Failed to commit the schema update: "
+          << sqlite3_errmsg(_db.Handle()) << "\n");
+      return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Check if the messages of a database are indexed by topic and
+  /// time received
+  /// \param[in] _db The database
+  /// \return True if the index exists
+  bool HasTopicTimeIndex(raii_sqlite3::Database &_db)
+  {
+    raii_sqlite3::Statement statement(_db,
+        "SELECT 1 FROM sqlite_master"
+        " WHERE type = 'index' AND name = 'idx_topic_time_recv';");
+    return statement && sqlite3_step(statement.Handle()) == SQLITE_ROW;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Check if a database keeps a summary of the messages of each topic
+  /// \param[in] _db The database
+  /// \return True if the topic_stats table exists
+  bool HasTopicStats(raii_sqlite3::Database &_db)
+  {
+    raii_sqlite3::Statement statement(_db,
+        "SELECT 1 FROM sqlite_master"
+        " WHERE type = 'table' AND name = 'topic_stats';");
+    return statement && sqlite3_step(statement.Handle()) == SQLITE_ROW;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Check if a database can have topics compressed with dictionaries
+  /// \param[in] _db The database
+  /// \return True if the dictionaries table exists
+  bool HasDictionaries(raii_sqlite3::Database &_db)
+  {
+    raii_sqlite3::Statement statement(_db,
+        "SELECT 1 FROM sqlite_master"
+        " WHERE type = 'table' AND name = 'dictionaries';");
+    return statement && sqlite3_step(statement.Handle()) == SQLITE_ROW;
+  }
+
+  /// \brief Compression of the messages of a topic with a dictionary, see
+  /// RecordOptions::SetDictionaryCompression()
+  struct TopicCompression
+  {
+    /// \brief First messages of the topic, one after the other, until the
+    /// dictionary is trained from them
+    std::string samples;
+
+    /// \brief Size of each message of samples
+    std::vector<std::size_t> sizes;
+
+    /// \brief The dictionary, or nullptr until it is trained
+    std::unique_ptr<MessageDictionary> dictionary;
+
+    /// \brief True if no dictionary could be trained, so the messages of the
+    /// topic are stored as they are
+    bool failed = false;
+  };
+}
+
 /// \brief Private implementation
 class gz::transport::log::Log::Implementation
 {
@@ -69,13 +485,224 @@ class gz::transport::log::Log::Implementation
   public: bool InsertMessage(const std::chrono::nanoseconds &_time,
       int64_t _topic, const void *_data, std::size_t _len);
 
+  /// \brief Keep a message inserted into the database to train the
+  /// dictionary of its topic, and train it once the topic has enough
+  /// messages. The next messages of the topic are compressed with it.
+  /// \param[in,out] _compression Compression of the topic
+  /// \param[in] _topic topic_id of the message
+  /// \param[in] _data Serialized message
+  /// \param[in] _len Size of the message
+  public: void AddTrainingMessage(TopicCompression &_compression,
+      int64_t _topic, const void *_data, std::size_t _len);
+
+  /// \brief Get the dictionaries of the compressed topics of the database,
+  /// reading them the first time.
+  /// \return The dictionaries, or nullptr if no topic is compressed
+  public: std::shared_ptr<const MessageDictionaries> Dictionaries() const;
+
+  /// \brief Read the summaries of the topics of the database, from the
+  /// topic_stats table if it has one, or else from the messages.
+  /// \return True if the summaries were read
+  public: bool LoadSummaries() const;
+
+  /// \brief Count a message inserted into the database in the summary of its
+  /// topic. The summary is written when the transaction ends.
+  /// \param[in] _topic topic_id of the message
+  /// \param[in] _name Name of the topic
+  /// \param[in] _type Name of the message type
+  /// \param[in] _time Time the message was received
+  /// \param[in] _len Size of the message
+  public: void UpdateSummary(int64_t _topic, const std::string &_name,
+      const std::string &_type, const std::chrono::nanoseconds &_time,
+      std::size_t _len);
+
+  /// \brief Write the summaries changed since the last transaction ended to
+  /// the topic_stats table
+  /// \return one of the SQLite error codes
+  public: int WriteSummaries();
+
+  /// \brief Append a message to a chunked log
+  /// \param[in] _time Time the message was received
+  /// \param[in] _topic Name of the topic
+  /// \param[in] _type Name of the message type
+  /// \param[in] _data Serialized message
+  /// \param[in] _len Size of the message
+  /// \return True if the message was appended
+  public: bool InsertChunked(const std::chrono::nanoseconds &_time,
+      const std::string &_topic, const std::string &_type,
+      const void *_data, std::size_t _len);
+
   /// \brief Return true if enough time has passed since the last transaction
   /// \return true if the transaction has lasted long enough
   public: bool TimeForNewTransaction() const;
 
+  /// \brief Get a statement of the insert path, compiling it the first time
+  /// \param[in,out] _statement The cached statement
+  /// \param[in] _sql The SQL statement to compile
+  /// \return The statement or nullptr if it could not be compiled
+  public: raii_sqlite3::Statement *CachedStatement(
+      std::unique_ptr<raii_sqlite3::Statement> &_statement,
+      const char *_sql);
+
+  /// \brief Open the file(s) of this log again for reading, e.g. to read
+  /// them on another thread with another connection.
+  /// \return The log, or nullptr if it failed to open
+  public: std::unique_ptr<Log> Reopen() const;
+
+  /// \brief Split a query in partitions which get every message of the
+  /// query once.
+  /// \param[in] _log The log to query
+  /// \param[in] _options The query
+  /// \param[in] _count Maximum number of partitions
+  /// \param[in] _partitioning How to split the query
+  /// \return The query of each partition, or an empty list if the query
+  /// isn't split
+  public: std::vector<std::unique_ptr<QueryOptions>> PartitionQuery(
+      const Log &_log, const QueryOptions &_options, std::size_t _count,
+      QueryPartitioning _partitioning) const;
+
+  /// \brief Copy the messages of some topics of this SQLite log into
+  /// another one inside SQLite, without reading them into memory.
+  /// \param[in] _output The log to copy to, which has the latest schema and
+  /// no topic
+  /// \param[in] _topicIds The topics to copy
+  /// \param[in] _timeCondition The time range clause, or an empty statement
+  /// \return True if the messages were copied
+  public: bool CopyMessages(raii_sqlite3::Database &_output,
+      const std::vector<int64_t> &_topicIds,
+      const SqlStatement &_timeCondition) const;
+
+  /// \brief Get the topics of the log selected by built-in query options.
+  /// \param[in] _options The query options
+  /// \param[out] _topicIds The topic_id of each topic selected
+  /// \return False if the options aren't built-in options
+  public: bool TopicIdsFromOptions(const QueryOptions &_options,
+                                   std::vector<int64_t> &_topicIds) const;
+
+  /// \brief Append the conditions of built-in query options to a query of
+  /// the messages table.
+  /// \param[in] _options The query options
+  /// \param[in,out] _sql The query, to which a WHERE clause is appended if
+  /// the options select some of the messages
+  /// \param[out] _empty True if the options select no topic
+  /// \return False if the options aren't built-in options
+  public: bool AppendBuiltInConditions(const QueryOptions &_options,
+                                       SqlStatement &_sql,
+                                       bool &_empty) const;
+
+  /// \brief Get the topic name and message type of each topic_id.
+  /// \return Map of topic_id to topic name and message type
+  public: std::map<int64_t, std::pair<std::string, std::string>>
+      TopicNames() const;
+
+  /// \brief Open the files of a split recording or of merged logs.
+  /// \param[in] _files Paths of the files
+  /// \param[in] _merge True to merge the messages of the files in time
+  /// order
+  /// \return True if every file was opened
+  public: bool OpenParts(const std::vector<std::string> &_files,
+                         bool _merge);
+
+  /// \brief Forget what was read from a log opened for reading if another
+  /// connection, e.g. of a recorder, committed to it since it was read.
+  public: void Refresh();
+
+  /// \brief Build the query of a chunked log.
+  /// \param[in] _options The query options
+  /// \param[out] _query The topics and time range to get
+  /// \return False if the options aren't supported by chunked logs
+  public: bool ChunkedQueryFromOptions(const QueryOptions &_options,
+                                       ChunkedQuery &_query) const;
+
   /// \brief SQLite3 database pointer wrapper
   public: std::shared_ptr<raii_sqlite3::Database> db;
 
+  /// \brief Chunked log, used instead of db for the CHUNKED format
+  public: std::unique_ptr<ChunkedLog> chunked;
+
+  /// \brief Files of a split recording or of merged logs, used instead of
+  /// db and chunked
+  public: std::vector<std::unique_ptr<Log>> parts;
+
+  /// \brief True to merge the messages of the parts in time order, false to
+  /// give the messages of each part after the previous one
+  public: bool mergeParts = false;
+
+  /// \brief Compiled statement to insert a message. Declared after db so it
+  /// is finalized before the database is closed.
+  public: std::unique_ptr<raii_sqlite3::Statement> insertMessageStatement;
+
+  /// \brief Compiled statement to insert a message type
+  public: std::unique_ptr<raii_sqlite3::Statement> insertMessageTypeStatement;
+
+  /// \brief Compiled statement to insert a topic
+  public: std::unique_ptr<raii_sqlite3::Statement> insertTopicStatement;
+
+  /// \brief Compiled statement to write the summary of a topic
+  public: std::unique_ptr<raii_sqlite3::Statement> writeSummaryStatement;
+
+  /// \brief Compiled statement to insert the dictionary of a topic
+  public: std::unique_ptr<raii_sqlite3::Statement> insertDictionaryStatement;
+
+  /// \brief Compiled statement to get the version of the data of a log
+  /// opened for reading
+  public: std::unique_ptr<raii_sqlite3::Statement> dataVersionStatement;
+
+  /// \brief True if the SQLite log was opened for reading
+  public: bool readOnly = false;
+
+  /// \brief True if the free pages of the log are truncated when it's
+  /// closed, see AutoVacuum::INCREMENTAL
+  public: bool incrementalVacuum = false;
+
+  /// \brief Version of the data of a log opened for reading when it was
+  /// last read, or -1
+  public: int64_t dataVersion = -1;
+
+  /// \brief Id of the last message given by Log::QueryNewMessages()
+  public: int64_t lastNewMessageId = 0;
+
+  /// \brief True if the database has a topic_stats table to keep up to date
+  public: bool hasTopicStats = false;
+
+  /// \brief Number of messages of a topic from which its dictionary is
+  /// trained, or 0 to store the messages as they are
+  public: uint32_t dictionaryMessages = 0;
+
+  /// \brief Compression level of the messages compressed with dictionaries
+  public: int dictionaryLevel = 0;
+
+  /// \brief Compression of the messages of each topic, by topic_id
+  public: std::unordered_map<int64_t, TopicCompression> compression;
+
+  /// \brief Buffer of the last compressed message
+  public: std::string compressed;
+
+  /// \brief True if the database has a dictionaries table
+  public: bool hasDictionaries = false;
+
+  /// \brief True once the dictionaries have been read from the database
+  public: mutable bool dictionariesLoaded = false;
+
+  /// \brief Dictionaries of the compressed topics, shared with the batches
+  /// of the queries, or nullptr if no topic is compressed
+  public: mutable std::shared_ptr<const MessageDictionaries> dictionaries;
+
+  /// \brief True once the summaries have been read from the database
+  public: mutable bool summariesLoaded = false;
+
+  /// \brief Summary of the messages of each topic, by topic_id
+  public: mutable std::map<int64_t, TopicSummary> summaries;
+
+  /// \brief Topics whose summary changed during the current transaction
+  public: std::set<int64_t> changedSummaries;
+
+  /// \brief Topic name and message type of the last topic_id looked up
+  public: TopicKey lastTopic;
+
+  /// \brief The last topic_id looked up, or -1 if none
+  public: int64_t lastTopicId = -1;
+
   /// \brief True if a transaction is in progress
   public: bool inTransaction = false;
 
@@ -107,6 +734,46 @@ class gz::transport::log::Log::Implementation
 //////////////////////////////////////////////////
 const log::Descriptor *Log::Implementation::Descriptor() const
 {
+  if (!this->parts.empty())
+  {
+    if (this->needNewDescriptor)
+    {
+      // The topics of every file. The ids are only meaningful to the file
+      // they come from, the queries use the descriptor of each file.
+      TopicKeyMap topicsInLog;
+      for (const auto &part : this->parts)
+      {
+        const log::Descriptor *desc = part->Descriptor();
+        if (!desc)
+          continue;
+        for (const auto &[topic, types] : desc->TopicsToMsgTypesToId())
+        {
+          for (const auto &entry : types)
+          {
+            TopicKey key;
+            key.topic = topic;
+            key.type = entry.first;
+            topicsInLog.emplace(key,
+                static_cast<int64_t>(topicsInLog.size() + 1));
+          }
+        }
+      }
+      this->needNewDescriptor = false;
+      descriptor.dataPtr->Reset(std::move(topicsInLog));
+    }
+    return &this->descriptor;
+  }
+
+  if (this->chunked)
+  {
+    if (this->needNewDescriptor)
+    {
+      this->needNewDescriptor = false;
+      descriptor.dataPtr->Reset(this->chunked->Topics());
+    }
+    return &this->descriptor;
+  }
+
   if (!this->db)
     return nullptr;
 
@@ -165,7 +832,8 @@ const log::Descriptor *Log::Implementation::Descriptor() const
 
     // Save the result into the descriptor
     this->needNewDescriptor = false;
-    descriptor.dataPtr->Reset(topicsInLog);
+    descriptor.dataPtr->Reset(std::move(topicsInLog));
+    descriptor.dataPtr->topicTimeIndexed = HasTopicTimeIndex(*(this->db));
   }
 
   return &this->descriptor;
@@ -186,8 +854,16 @@ int Log::Implementation::EndTransactionIfEnoughTimeHasPassed()
 //////////////////////////////////////////////////
 int Log::Implementation::EndTransaction()
 {
+  // The summaries are committed with the messages they count
+  int returnCode = this->WriteSummaries();
+  if (returnCode != SQLITE_OK)
+  {
+    LERR("Failed to write topic summaries" << returnCode << "\n");
+    return returnCode;
+  }
+
   // End the transaction
-  int returnCode = sqlite3_exec(
+  returnCode = sqlite3_exec(
       this->db->Handle(), "END;", NULL, 0, nullptr);
   if (returnCode != SQLITE_OK)
   {
@@ -226,51 +902,496 @@ bool Log::Implementation::TimeForNewTransaction() const
 }
 
 //////////////////////////////////////////////////
-int64_t Log::Implementation::InsertOrGetTopicId(
-    const std::string &_name,
-    const std::string &_type)
+bool Log::Implementation::InsertChunked(
+    const std::chrono::nanoseconds &_time,
+    const std::string &_topic, const std::string &_type,
+    const void *_data, const std::size_t _len)
 {
-  // If the name and type is known, return a cached ID
-  // Call method to get side effect of updating descriptor
-  const log::Descriptor *desc = this->Descriptor();
-  if (nullptr == desc)
+  const std::size_t prevTopicCount = this->chunked->NumTopics();
+  if (!this->chunked->Write(_time, _topic, _type, _data, _len))
+    return false;
+
+  // The descriptor gets the new topic, whose id is its number
+  if (this->chunked->NumTopics() != prevTopicCount &&
+      !this->needNewDescriptor)
   {
-    return -1;
+    TopicKey key;
+    key.topic = _topic;
+    key.type = _type;
+    this->descriptor.dataPtr->Insert(
+        key, static_cast<int64_t>(this->chunked->NumTopics()));
   }
 
-  int64_t topicId = desc->TopicId(_name, _type);
-  if (topicId >= 0)
+  // Reset startTime and endTime
+  this->startTime = std::chrono::nanoseconds(-1);
+  this->endTime = std::chrono::nanoseconds(-1);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Log::Implementation::ChunkedQueryFromOptions(
+    const QueryOptions &_options, ChunkedQuery &_query) const
+{
+  const log::Descriptor *desc = this->Descriptor();
+  if (!desc)
+    return false;
+
+  // Chunked logs can't run SQL, so only the built-in options are supported.
+  const auto *timeRange = dynamic_cast<const TimeRangeOption *>(&_options);
+  if (timeRange)
+    _query.range = timeRange->TimeRange();
+
+  std::vector<int64_t> topicIds;
+  if (!this->TopicIdsFromOptions(_options, topicIds))
   {
-    return topicId;
+    LERR("Custom query options are not supported by chunked logs\n");
+    return false;
   }
 
-  // Inserting a new topic invalidates the descriptor
-  this->needNewDescriptor = true;
-
-  // Otherwise insert it into the database and return the new topic_id
-  const std::string sqlMessageType =
-    "INSERT OR IGNORE INTO message_types (name) VALUES (?001);";
-  const std::string sqlTopic =
-    "INSERT INTO topics (name, message_type_id)"
-    " SELECT ?002, id FROM message_types WHERE name = ?001 LIMIT 1;";
+  for (const int64_t id : topicIds)
+    _query.topics.insert(static_cast<uint32_t>(id));
+  return true;
+}
 
-  raii_sqlite3::Statement messageTypeStatement(
-      *(this->db), sqlMessageType);
-  if (!messageTypeStatement)
+//////////////////////////////////////////////////
+bool Log::Implementation::TopicIdsFromOptions(const QueryOptions &_options,
+    std::vector<int64_t> &_topicIds) const
+{
+  _topicIds.clear();
+  const log::Descriptor *desc = this->Descriptor();
+  const auto *topicList = dynamic_cast<const TopicList *>(&_options);
+  const auto *topicPattern = dynamic_cast<const TopicPattern *>(&_options);
+  if (!desc || (!topicList && !topicPattern &&
+      !dynamic_cast<const AllTopics *>(&_options)))
   {
-    LERR("Failed to compile statement to insert message type\n");
-    return -1;
+    return false;
   }
-  raii_sqlite3::Statement topicStatement(
-      *(this->db), sqlTopic);
-  if (!topicStatement)
+
+  for (const auto &[topic, types] : desc->TopicsToMsgTypesToId())
   {
-    LERR("Failed to compile statement to insert topic\n");
-    return -1;
+    if ((topicList && topicList->Topics().count(topic) == 0) ||
+        (topicPattern && !topicPattern->Match(topic)))
+    {
+      continue;
+    }
+    for (const auto &[type, id] : types)
+      _topicIds.push_back(id);
   }
+  return true;
+}
 
-  // Reset startTime and endTime
-  this->startTime = std::chrono::nanoseconds(-1);
+//////////////////////////////////////////////////
+bool Log::Implementation::AppendBuiltInConditions(
+    const QueryOptions &_options, SqlStatement &_sql, bool &_empty) const
+{
+  std::vector<int64_t> topicIds;
+  if (!this->TopicIdsFromOptions(_options, topicIds))
+    return false;
+
+  _empty = topicIds.empty();
+  std::string separator = " WHERE ";
+  if (!dynamic_cast<const AllTopics *>(&_options))
+  {
+    // As for the messages, the unary + keeps SQLite from selecting several
+    // topics from their index and sorting them afterwards.
+    _sql.statement += topicIds.size() > 1 ?
+      " WHERE +messages.topic_id IN (" : " WHERE messages.topic_id IN (";
+    for (std::size_t i = 0; i < topicIds.size(); ++i)
+    {
+      _sql.statement += i == 0 ? "?" : ", ?";
+      _sql.parameters.emplace_back(topicIds[i]);
+    }
+    _sql.statement += ")";
+    separator = " AND ";
+  }
+
+  const SqlStatement timeCondition =
+      dynamic_cast<const TimeRangeOption &>(_options).GenerateTimeConditions();
+  if (!timeCondition.statement.empty())
+  {
+    _sql.statement += separator + "(";
+    _sql.Append(timeCondition);
+    _sql.statement += ")";
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::map<int64_t, std::pair<std::string, std::string>>
+Log::Implementation::TopicNames() const
+{
+  std::map<int64_t, std::pair<std::string, std::string>> names;
+  const log::Descriptor *desc = this->Descriptor();
+  if (!desc)
+    return names;
+
+  for (const auto &[topic, types] : desc->TopicsToMsgTypesToId())
+  {
+    for (const auto &[type, id] : types)
+      names[id] = std::make_pair(topic, type);
+  }
+  return names;
+}
+
+//////////////////////////////////////////////////
+bool Log::Implementation::OpenParts(const std::vector<std::string> &_files,
+                                    const bool _merge)
+{
+  if (_files.empty())
+  {
+    LERR("No file to open\n");
+    return false;
+  }
+
+  std::vector<std::unique_ptr<Log>> openParts;
+  for (const std::string &file : _files)
+  {
+    std::unique_ptr<Log> part(new Log());
+    if (!part->Open(file, std::ios_base::in))
+    {
+      LERR("Failed to open [" << file << "]"
+          << (_merge ? "" : " of a split recording") << "\n");
+      return false;
+    }
+    openParts.push_back(std::move(part));
+  }
+
+  this->parts = std::move(openParts);
+  this->mergeParts = _merge;
+  this->filename = _files.front();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Log::Implementation::Refresh()
+{
+  if (!this->db || !this->readOnly)
+    return;
+
+  // The data version changes when another connection commits
+  if (!this->dataVersionStatement)
+  {
+    this->dataVersionStatement.reset(
+        new raii_sqlite3::Statement(*(this->db), "PRAGMA data_version;"));
+  }
+  if (!*this->dataVersionStatement)
+  {
+    this->dataVersionStatement.reset();
+    return;
+  }
+
+  sqlite3_stmt *handle = this->dataVersionStatement->Handle();
+  int64_t version = -1;
+  if (sqlite3_step(handle) == SQLITE_ROW)
+    version = sqlite3_column_int64(handle, 0);
+  sqlite3_reset(handle);
+
+  if (version == this->dataVersion)
+    return;
+
+  // New topics, messages and dictionaries may have been committed
+  this->dataVersion = version;
+  this->needNewDescriptor = true;
+  this->summariesLoaded = false;
+  this->dictionariesLoaded = false;
+  this->startTime = std::chrono::nanoseconds(-1);
+  this->endTime = std::chrono::nanoseconds(-1);
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Log> Log::Implementation::Reopen() const
+{
+  auto log = std::make_unique<Log>();
+  bool opened;
+  if (!this->parts.empty())
+  {
+    std::vector<std::string> files;
+    for (const auto &part : this->parts)
+      files.push_back(part->Filename());
+    opened = this->mergeParts ? log->OpenMerged(files) :
+      log->OpenSplit(files);
+  }
+  else
+  {
+    opened = log->Open(this->filename);
+  }
+
+  if (!opened)
+  {
+    LERR("Failed to open [" << this->filename << "] again for reading\n");
+    return nullptr;
+  }
+  return log;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::unique_ptr<QueryOptions>> Log::Implementation::PartitionQuery(
+    const Log &_log, const QueryOptions &_options, const std::size_t _count,
+    const QueryPartitioning _partitioning) const
+{
+  std::vector<std::unique_ptr<QueryOptions>> partitions;
+
+  const log::Descriptor *desc = this->Descriptor();
+  if (!desc || _count < 2)
+    return partitions;
+
+  // Only the built-in options are known to be split without changing the
+  // messages they select.
+  const auto *topicList = dynamic_cast<const TopicList *>(&_options);
+  const auto *topicPattern = dynamic_cast<const TopicPattern *>(&_options);
+  const auto *allTopics = dynamic_cast<const AllTopics *>(&_options);
+  if (!topicList && !topicPattern && !allTopics)
+  {
+    LWRN("Custom query options can't be split, the query runs on one "
+         "thread\n");
+    return partitions;
+  }
+  const QualifiedTimeRange &range =
+      dynamic_cast<const TimeRangeOption &>(_options).TimeRange();
+
+  if (_partitioning == QueryPartitioning::TIME)
+  {
+    const QualifiedTime &beginning = range.Beginning();
+    const QualifiedTime &ending = range.Ending();
+    const std::chrono::nanoseconds first = beginning.IsIndeterminate() ?
+        _log.StartTime() : *beginning.GetTime();
+    const std::chrono::nanoseconds last = ending.IsIndeterminate() ?
+        _log.EndTime() : *ending.GetTime();
+    const std::chrono::nanoseconds slice = (last - first) / _count;
+    if (slice <= std::chrono::nanoseconds::zero())
+      return partitions;
+
+    // Each slice ends where the next one begins, and the first and last
+    // ones keep the bounds of the query
+    for (std::size_t i = 0; i < _count; ++i)
+    {
+      const QualifiedTimeRange sliceRange(
+          i == 0 ? beginning :
+            QualifiedTime(first + slice * i,
+                          QualifiedTime::Qualifier::INCLUSIVE),
+          i + 1 == _count ? ending :
+            QualifiedTime(first + slice * (i + 1),
+                          QualifiedTime::Qualifier::EXCLUSIVE));
+      if (topicList)
+      {
+        partitions.push_back(
+            std::make_unique<TopicList>(topicList->Topics(), sliceRange));
+      }
+      else if (topicPattern)
+      {
+        partitions.push_back(std::make_unique<TopicPattern>(
+              topicPattern->Pattern(), sliceRange));
+      }
+      else
+      {
+        partitions.push_back(std::make_unique<AllTopics>(sliceRange));
+      }
+    }
+    return partitions;
+  }
+
+  // Size of the topics of the query. The topics are assumed to be of the
+  // same size unless the log keeps their summaries.
+  std::map<std::string, uint64_t> weights;
+  for (const auto &[topic, types] : desc->TopicsToMsgTypesToId())
+  {
+    if ((topicList && topicList->Topics().count(topic) == 0) ||
+        (topicPattern && !topicPattern->Match(topic)))
+    {
+      continue;
+    }
+    weights[topic] = 1;
+  }
+  if (weights.size() < 2)
+    return partitions;
+
+  if (this->db && this->hasTopicStats)
+  {
+    for (const TopicSummary &summary : _log.TopicSummaries())
+    {
+      auto weight = weights.find(summary.topic);
+      if (weight != weights.end())
+        weight->second += summary.bytes;
+    }
+  }
+
+  // Give the largest topics first to the smallest partition
+  std::vector<std::pair<uint64_t, std::string>> topicRows;
+  for (const auto &[topic, weight] : weights)
+    topicRows.emplace_back(weight, topic);
+  std::stable_sort(topicRows.begin(), topicRows.end(),
+      [](const auto &_a, const auto &_b) { return _a.first > _b.first; });
+
+  std::vector<std::set<std::string>> partitionTopics(
+      std::min(_count, topicRows.size()));
+  std::vector<uint64_t> partitionWeights(partitionTopics.size(), 0);
+  for (const auto &[weight, topic] : topicRows)
+  {
+    const std::size_t smallest = static_cast<std::size_t>(
+        std::min_element(partitionWeights.begin(), partitionWeights.end()) -
+        partitionWeights.begin());
+    partitionTopics[smallest].insert(topic);
+    partitionWeights[smallest] += weight;
+  }
+
+  for (const std::set<std::string> &subset : partitionTopics)
+    partitions.push_back(std::make_unique<TopicList>(subset, range));
+  return partitions;
+}
+
+//////////////////////////////////////////////////
+bool Log::Implementation::CopyMessages(raii_sqlite3::Database &_output,
+    const std::vector<int64_t> &_topicIds,
+    const SqlStatement &_timeCondition) const
+{
+  SqlStatement attach;
+  attach.statement = "ATTACH DATABASE ? AS source;";
+  attach.parameters.emplace_back(this->filename);
+  if (!RunStatement(_output, attach))
+    return false;
+
+  SqlStatement idList;
+  idList.statement = "(";
+  for (std::size_t i = 0; i < _topicIds.size(); ++i)
+  {
+    idList.statement += i == 0 ? "?" : ", ?";
+    idList.parameters.emplace_back(_topicIds[i]);
+  }
+  idList.statement += ")";
+
+  // The topics keep their id, so the messages are copied as they are
+  SqlStatement types;
+  types.statement =
+      "INSERT INTO main.message_types (id, name, proto_descriptor)"
+      " SELECT id, name, proto_descriptor FROM source.message_types"
+      " WHERE id IN (SELECT message_type_id FROM source.topics WHERE id IN ";
+  types.Append(idList);
+  types.statement += ");";
+
+  SqlStatement topicQuery;
+  topicQuery.statement =
+      "INSERT INTO main.topics (id, name, message_type_id)"
+      " SELECT id, name, message_type_id FROM source.topics WHERE id IN ";
+  topicQuery.Append(idList);
+  topicQuery.statement += ";";
+
+  // As for queries, the messages of several topics are read in order of
+  // time from idx_time_recv instead of being sorted
+  SqlStatement messages;
+  messages.statement =
+      "INSERT INTO main.messages (time_recv, topic_id, message)"
+      " SELECT time_recv, topic_id, message FROM source.messages WHERE ";
+  messages.statement += _topicIds.size() == 1 ? "topic_id IN " :
+    "+topic_id IN ";
+  messages.Append(idList);
+  if (!_timeCondition.statement.empty())
+  {
+    messages.statement += " AND (";
+    messages.Append(_timeCondition);
+    messages.statement += ")";
+  }
+  messages.statement += " ORDER BY time_recv;";
+
+  // The sizes are read from the headers of the records, not the messages
+  SqlStatement stats;
+  stats.statement =
+      "INSERT INTO main.topic_stats SELECT topic_id, COUNT(*),"
+      " SUM(LENGTH(message)), MIN(time_recv), MAX(time_recv)"
+      " FROM main.messages GROUP BY topic_id;";
+
+  SqlStatement begin;
+  begin.statement = "BEGIN;";
+  SqlStatement commit;
+  commit.statement = "COMMIT;";
+  bool copied = RunStatement(_output, begin);
+  if (copied)
+  {
+    copied = RunStatement(_output, types) &&
+      RunStatement(_output, topicQuery) &&
+      RunStatement(_output, messages) && RunStatement(_output, stats) &&
+      RunStatement(_output, commit);
+    if (!copied)
+      sqlite3_exec(_output.Handle(), "ROLLBACK;", nullptr, nullptr, nullptr);
+  }
+
+  SqlStatement detach;
+  detach.statement = "DETACH DATABASE source;";
+  return RunStatement(_output, detach) && copied;
+}
+
+//////////////////////////////////////////////////
+raii_sqlite3::Statement *Log::Implementation::CachedStatement(
+    std::unique_ptr<raii_sqlite3::Statement> &_statement,
+    const char *_sql)
+{
+  if (!_statement)
+  {
+    auto statement = std::make_unique<raii_sqlite3::Statement>(
+        *(this->db), _sql);
+    if (!*statement)
+      return nullptr;
+    _statement = std::move(statement);
+  }
+  return _statement.get();
+}
+
+//////////////////////////////////////////////////
+int64_t Log::Implementation::InsertOrGetTopicId(
+    const std::string &_name,
+    const std::string &_type)
+{
+  // Messages usually arrive in runs of the same topic
+  if (this->lastTopicId >= 0 && _name == this->lastTopic.topic &&
+      _type == this->lastTopic.type)
+  {
+    return this->lastTopicId;
+  }
+
+  // If the name and type is known, return a cached ID
+  // Call method to get side effect of updating descriptor
+  const log::Descriptor *desc = this->Descriptor();
+  if (nullptr == desc)
+  {
+    return -1;
+  }
+
+  int64_t topicId = desc->TopicId(_name, _type);
+  if (topicId >= 0)
+  {
+    this->lastTopic.topic = _name;
+    this->lastTopic.type = _type;
+    this->lastTopicId = topicId;
+    return topicId;
+  }
+
+  // Otherwise insert it into the database and return the new topic_id
+  const char *const sqlMessageType =
+    "INSERT OR IGNORE INTO message_types (name) VALUES (?001);";
+  const char *const sqlTopic =
+    "INSERT INTO topics (name, message_type_id)"
+    " SELECT ?002, id FROM message_types WHERE name = ?001 LIMIT 1;";
+
+  raii_sqlite3::Statement *messageTypeCached = this->CachedStatement(
+      this->insertMessageTypeStatement, sqlMessageType);
+  if (!messageTypeCached)
+  {
+    LERR("Failed to compile statement to insert message type\n");
+    return -1;
+  }
+  raii_sqlite3::Statement *topicCached = this->CachedStatement(
+      this->insertTopicStatement, sqlTopic);
+  if (!topicCached)
+  {
+    LERR("Failed to compile statement to insert topic\n");
+    return -1;
+  }
+  raii_sqlite3::Statement &messageTypeStatement = *messageTypeCached;
+  raii_sqlite3::Statement &topicStatement = *topicCached;
+  StatementReset messageTypeReset(messageTypeStatement);
+  StatementReset topicReset(topicStatement);
+
+  // Reset startTime and endTime
+  this->startTime = std::chrono::nanoseconds(-1);
   this->endTime = std::chrono::nanoseconds(-1);
 
   int returnCode;
@@ -313,6 +1434,12 @@ int64_t Log::Implementation::InsertOrGetTopicId(
 
   // topics.id is an alias for rowid
   int64_t id = sqlite3_last_insert_rowid(this->db->Handle());
+  this->lastTopic.topic = _name;
+  this->lastTopic.type = _type;
+  this->lastTopicId = id;
+
+  // The descriptor gets the new topic instead of reading every topic again
+  this->descriptor.dataPtr->Insert(this->lastTopic, id);
   LDBG("Inserted '" << _name << "'[" << _type << "]\n");
   return id;
 }
@@ -332,18 +1459,41 @@ bool Log::Implementation::InsertMessage(
   if (_len == 0)
     return false;
 
+  // The messages of a topic with a dictionary are stored compressed
+  const void *stored = _data;
+  std::size_t storedLen = _len;
+  TopicCompression *topicCompression = nullptr;
+  if (this->dictionaryMessages > 0)
+  {
+    topicCompression = &this->compression[_topic];
+    if (topicCompression->dictionary)
+    {
+      if (!topicCompression->dictionary->Compress(_data, _len,
+            this->compressed))
+      {
+        LERR("Failed to compress message data\n");
+        return false;
+      }
+      stored = this->compressed.data();
+      storedLen = this->compressed.size();
+    }
+  }
+
   int returnCode;
-  const std::string sql =
+  const char *const sql =
     "INSERT INTO messages (time_recv, message, topic_id)"
     "VALUES (?001, ?002, ?003);";
 
-  // Compile the statement
-  raii_sqlite3::Statement statement(*(this->db), sql);
-  if (!statement)
+  // Compile the statement the first time
+  raii_sqlite3::Statement *cached =
+    this->CachedStatement(this->insertMessageStatement, sql);
+  if (!cached)
   {
     LERR("Failed to compile insert message statement\n");
     return false;
   }
+  raii_sqlite3::Statement &statement = *cached;
+  StatementReset reset(statement);
 
   // Bind parameters
   returnCode = sqlite3_bind_int64(statement.Handle(), 1, _time.count());
@@ -352,7 +1502,8 @@ bool Log::Implementation::InsertMessage(
     LERR("Failed to bind time received: " << returnCode << "\n");
     return false;
   }
-  returnCode = sqlite3_bind_blob(statement.Handle(), 2, _data, _len, nullptr);
+  returnCode = sqlite3_bind_blob(statement.Handle(), 2, stored, storedLen,
+      nullptr);
   if (returnCode != SQLITE_OK)
   {
     LERR("Failed to bind message data: " << returnCode << "\n");
@@ -361,212 +1512,1089 @@ bool Log::Implementation::InsertMessage(
   returnCode = sqlite3_bind_int(statement.Handle(), 3, _topic);
   if (returnCode != SQLITE_OK)
   {
-    LERR("Failed to bind topic_id: " << returnCode << "\n");
-    return false;
+    LERR("Failed to bind topic_id: " << returnCode << "\n");
+    return false;
+  }
+
+  // Reset startTime and endTime
+  this->startTime = std::chrono::nanoseconds(-1);
+  this->endTime = std::chrono::nanoseconds(-1);
+
+
+  // Execute the statement
+  returnCode = sqlite3_step(statement.Handle());
+  if (returnCode != SQLITE_DONE)
+  {
+    LERR("Failed to insert message. sqlite3 return code[" << returnCode
+        << "] data[" << _data << "] len[" << _len << "]\n");
+    return false;
+  }
+
+  if (topicCompression && !topicCompression->dictionary &&
+      !topicCompression->failed)
+  {
+    this->AddTrainingMessage(*topicCompression, _topic, _data, _len);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Log::Implementation::AddTrainingMessage(TopicCompression &_compression,
+    const int64_t _topic, const void *_data, const std::size_t _len)
+{
+  _compression.samples.append(static_cast<const char *>(_data), _len);
+  _compression.sizes.push_back(_len);
+  if (_compression.sizes.size() < this->dictionaryMessages)
+    return;
+
+  _compression.dictionary = MessageDictionary::Train(
+      _compression.samples, _compression.sizes, this->dictionaryLevel);
+  std::string().swap(_compression.samples);
+  std::vector<std::size_t>().swap(_compression.sizes);
+  if (!_compression.dictionary)
+  {
+    LWRN("Failed to train a dictionary for [" << this->lastTopic.topic
+        << "], its messages are stored uncompressed\n");
+    _compression.failed = true;
+    return;
+  }
+
+  // Message ids only grow, so the messages inserted from now on are the
+  // compressed ones
+  _compression.dictionary->SetFirstMessageId(
+      sqlite3_last_insert_rowid(this->db->Handle()) + 1);
+
+  const char *const sql =
+    "INSERT INTO dictionaries (topic_id, first_message_id, dictionary)"
+    " VALUES (?001, ?002, ?003);";
+  raii_sqlite3::Statement *cached =
+    this->CachedStatement(this->insertDictionaryStatement, sql);
+  bool inserted = cached != nullptr;
+  if (cached)
+  {
+    StatementReset reset(*cached);
+    const std::string &data = _compression.dictionary->Data();
+    inserted =
+      sqlite3_bind_int64(cached->Handle(), 1, _topic) == SQLITE_OK &&
+      sqlite3_bind_int64(cached->Handle(), 2,
+        _compression.dictionary->FirstMessageId()) == SQLITE_OK &&
+      sqlite3_bind_blob(cached->Handle(), 3, data.data(),
+        static_cast<int>(data.size()), nullptr) == SQLITE_OK &&
+      sqlite3_step(cached->Handle()) == SQLITE_DONE;
+  }
+  if (!inserted)
+  {
+    LERR("Failed to insert the dictionary of [" << this->lastTopic.topic
+        << "]: " << sqlite3_errmsg(this->db->Handle()) << "\n");
+    _compression.dictionary.reset();
+    _compression.failed = true;
+    return;
+  }
+
+  LDBG("Compressing [" << this->lastTopic.topic << "] with a dictionary of "
+      << _compression.dictionary->Data().size() << " bytes\n");
+  this->dictionariesLoaded = false;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const MessageDictionaries>
+Log::Implementation::Dictionaries() const
+{
+  if (!this->db || !this->hasDictionaries)
+    return nullptr;
+
+  if (this->dictionariesLoaded)
+    return this->dictionaries;
+
+  const char *const sql =
+    "SELECT topics.name, message_types.name,"
+    " dictionaries.first_message_id, dictionaries.dictionary"
+    " FROM dictionaries JOIN topics ON topics.id = dictionaries.topic_id"
+    " JOIN message_types ON message_types.id = topics.message_type_id;";
+  raii_sqlite3::Statement statement(*(this->db), sql);
+  if (!statement)
+  {
+    LERR("Failed to compile statement to get the dictionaries\n");
+    return nullptr;
+  }
+
+  auto result = std::make_shared<MessageDictionaries>();
+  int returnCode;
+  while ((returnCode = sqlite3_step(statement.Handle())) == SQLITE_ROW)
+  {
+    TopicKey key;
+    key.topic = std::string(reinterpret_cast<const char *>(
+          sqlite3_column_text(statement.Handle(), 0)),
+        sqlite3_column_bytes(statement.Handle(), 0));
+    key.type = std::string(reinterpret_cast<const char *>(
+          sqlite3_column_text(statement.Handle(), 1)),
+        sqlite3_column_bytes(statement.Handle(), 1));
+    (*result)[key] = MessageDictionary::Load(
+        sqlite3_column_blob(statement.Handle(), 3),
+        sqlite3_column_bytes(statement.Handle(), 3),
+        sqlite3_column_int64(statement.Handle(), 2));
+  }
+  if (returnCode != SQLITE_DONE)
+  {
+    LERR("Failed to get the dictionaries: "
+        << sqlite3_errmsg(this->db->Handle()) << "\n");
+    return nullptr;
+  }
+
+  this->dictionariesLoaded = true;
+  this->dictionaries.reset();
+  if (!result->empty())
+    this->dictionaries = std::move(result);
+  return this->dictionaries;
+}
+
+//////////////////////////////////////////////////
+bool Log::Implementation::LoadSummaries() const
+{
+  if (this->summariesLoaded)
+    return true;
+
+  // Without a topic_stats table, the messages have to be counted
+  const char *const sql = this->hasTopicStats ?
+    "SELECT topic_stats.topic_id, topics.name, message_types.name,"
+    " message_count, total_bytes, first_time_recv, last_time_recv"
+    " FROM topic_stats JOIN topics ON topics.id = topic_stats.topic_id"
+    " JOIN message_types ON message_types.id = topics.message_type_id;" :
+    "SELECT messages.topic_id, topics.name, message_types.name, COUNT(*),"
+    " SUM(LENGTH(messages.message)), MIN(messages.time_recv),"
+    " MAX(messages.time_recv) FROM messages"
+    " JOIN topics ON topics.id = messages.topic_id"
+    " JOIN message_types ON message_types.id = topics.message_type_id"
+    " GROUP BY messages.topic_id;";
+
+  raii_sqlite3::Statement statement(*(this->db), sql);
+  if (!statement)
+  {
+    LERR("Failed to compile statement to get topic summaries\n");
+    return false;
+  }
+
+  std::map<int64_t, TopicSummary> loaded;
+  int returnCode;
+  while ((returnCode = sqlite3_step(statement.Handle())) == SQLITE_ROW)
+  {
+    sqlite3_stmt *handle = statement.Handle();
+    TopicSummary &summary = loaded[sqlite3_column_int64(handle, 0)];
+    summary.topic = std::string(
+        reinterpret_cast<const char *>(sqlite3_column_text(handle, 1)),
+        sqlite3_column_bytes(handle, 1));
+    summary.type = std::string(
+        reinterpret_cast<const char *>(sqlite3_column_text(handle, 2)),
+        sqlite3_column_bytes(handle, 2));
+    summary.messages = sqlite3_column_int64(handle, 3);
+    summary.bytes = sqlite3_column_int64(handle, 4);
+    summary.startTime = std::chrono::nanoseconds(
+        sqlite3_column_int64(handle, 5));
+    summary.endTime = std::chrono::nanoseconds(
+        sqlite3_column_int64(handle, 6));
+  }
+  if (returnCode != SQLITE_DONE)
+  {
+    LERR("Failed to query topic summaries: " << sqlite3_errmsg(
+        this->db->Handle()) << "\n");
+    return false;
+  }
+
+  this->summaries = std::move(loaded);
+  this->summariesLoaded = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Log::Implementation::UpdateSummary(const int64_t _topic,
+    const std::string &_name, const std::string &_type,
+    const std::chrono::nanoseconds &_time, const std::size_t _len)
+{
+  if (!this->hasTopicStats)
+    return;
+
+  auto inserted = this->summaries.try_emplace(_topic);
+  TopicSummary &summary = inserted.first->second;
+  if (inserted.second)
+  {
+    summary.topic = _name;
+    summary.type = _type;
+    summary.startTime = _time;
+    summary.endTime = _time;
+  }
+  else
+  {
+    summary.startTime = std::min(summary.startTime, _time);
+    summary.endTime = std::max(summary.endTime, _time);
+  }
+  ++summary.messages;
+  summary.bytes += _len;
+  this->changedSummaries.insert(_topic);
+}
+
+//////////////////////////////////////////////////
+int Log::Implementation::WriteSummaries()
+{
+  if (this->changedSummaries.empty())
+    return SQLITE_OK;
+
+  const char *const sql =
+    "INSERT OR REPLACE INTO topic_stats (topic_id, message_count,"
+    " total_bytes, first_time_recv, last_time_recv)"
+    " VALUES (?001, ?002, ?003, ?004, ?005);";
+  raii_sqlite3::Statement *cached =
+    this->CachedStatement(this->writeSummaryStatement, sql);
+  if (!cached)
+  {
+    LERR("Failed to compile statement to write topic summaries\n");
+    return SQLITE_ERROR;
+  }
+
+  for (const int64_t topic : this->changedSummaries)
+  {
+    const TopicSummary &summary = this->summaries.at(topic);
+    StatementReset reset(*cached);
+    sqlite3_stmt *handle = cached->Handle();
+    sqlite3_bind_int64(handle, 1, topic);
+    sqlite3_bind_int64(handle, 2, static_cast<int64_t>(summary.messages));
+    sqlite3_bind_int64(handle, 3, static_cast<int64_t>(summary.bytes));
+    sqlite3_bind_int64(handle, 4, summary.startTime.count());
+    sqlite3_bind_int64(handle, 5, summary.endTime.count());
+    const int returnCode = sqlite3_step(handle);
+    if (returnCode != SQLITE_DONE)
+      return returnCode;
+  }
+  this->changedSummaries.clear();
+  return SQLITE_OK;
+}
+
+//////////////////////////////////////////////////
+Log::Log()
+  : dataPtr(new Implementation)
+{
+  // Default to 2 transactions per second
+  this->dataPtr->transactionPeriod = RecordOptions().TransactionPeriod();
+}
+
+//////////////////////////////////////////////////
+Log::Log(Log &&_other)  // NOLINT
+  : dataPtr(std::move(_other.dataPtr))
+{
+}
+
+//////////////////////////////////////////////////
+Log::~Log()
+{
+  if (this->dataPtr && this->dataPtr->inTransaction)
+  {
+    this->dataPtr->EndTransaction();
+  }
+
+  // Recording is over, the free pages can be returned to the file system.
+  if (this->dataPtr && this->dataPtr->incrementalVacuum)
+  {
+    std::string result;
+    RunPragma(*this->dataPtr->db, "PRAGMA incremental_vacuum;", result);
+  }
+}
+
+//////////////////////////////////////////////////
+bool Log::Valid() const
+{
+  return this->dataPtr &&
+    ((this->dataPtr->db && *(this->dataPtr->db)) || this->dataPtr->chunked ||
+     !this->dataPtr->parts.empty());
+}
+
+//////////////////////////////////////////////////
+bool Log::Open(const std::string &_file, const std::ios_base::openmode _mode)
+{
+  return this->Open(_file, _mode, RecordOptions());
+}
+
+//////////////////////////////////////////////////
+bool Log::Open(const std::string &_file, const std::ios_base::openmode _mode,
+               const RecordOptions &_options)
+{
+  if (this->Valid())
+  {
+    LERR("A database is already open\n");
+    return false;
+  }
+
+  // Open a chunked log
+  const bool write = (std::ios_base::out & _mode) != 0;
+  if ((write && _options.Format() == LogFormat::CHUNKED) ||
+      (!write && ChunkedLog::IsChunkedLog(_file)))
+  {
+    this->dataPtr->chunked = write ? ChunkedLog::Create(_file, _options) :
+      ChunkedLog::Open(_file);
+    if (!this->dataPtr->chunked)
+      return false;
+
+    this->dataPtr->filename = _file;
+    return true;
+  }
+
+  // Open the SQLite3 database
+  int64_t modeSQL = SQLITE_OPEN_URI;
+  if (std::ios_base::out & _mode)
+  {
+    modeSQL = modeSQL | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+  }
+  else if (std::ios_base::in & _mode)
+  {
+    modeSQL = modeSQL | SQLITE_OPEN_READONLY;
+  }
+
+  std::unique_ptr<raii_sqlite3::Database> db(
+      new raii_sqlite3::Database(_file, modeSQL));
+  if (!*(db))
+  {
+    // The constructor of raii_sqlite3::Database will print out the reason that
+    // the database failed to open.
+    return false;
+  }
+
+  // Don't need to create a schema if this is read only
+  if (std::ios_base::out & _mode)
+  {
+    if (!ApplyRecordOptions(*db, _options))
+    {
+      LERR("Failed to apply the options to [" << _file << "]\n");
+      return false;
+    }
+
+    // Assume the database is uninitialized; use the schema to initialize it
+    if (!UpdateSchema(*db, ""))
+    {
+      LERR("Failed to open log [" << _file << "]\n");
+      return false;
+    }
+  }
+
+  else
+  {
+    // Let SQLite read the pages of the log from a memory mapping instead of
+    // copying them into its cache. SQLite clamps the size to the maximum it
+    // was built with, and ignores the request if mmap is unavailable.
+    std::string result;
+    RunPragma(*db, "PRAGMA mmap_size=" + std::to_string(kReadMmapSize) + ";",
+        result);
+
+    // A log which is being recorded can be read while it is written. A
+    // reader of a log in WAL mode never waits, otherwise it waits for the
+    // commits of the recorder to finish.
+    sqlite3_busy_timeout(db->Handle(), kReadBusyTimeout);
+  }
+
+  this->dataPtr->db = std::move(db);
+  this->dataPtr->readOnly = (std::ios_base::out & _mode) == 0;
+
+  // Check the schema version
+  std::string version = this->Version();
+  if (std::find(kSchemaVersions.begin(), kSchemaVersions.end(), version) ==
+      kSchemaVersions.end())
+  {
+    LERR("Log file Version '" << version << "' is unsupported by this tool\n");
+    this->dataPtr->db.reset();
+    return false;
+  }
+
+  // A new log has no messages to summarize
+  this->dataPtr->hasTopicStats = HasTopicStats(*(this->dataPtr->db));
+  this->dataPtr->summariesLoaded = (std::ios_base::out & _mode) != 0;
+  this->dataPtr->hasDictionaries = HasDictionaries(*(this->dataPtr->db));
+  if (std::ios_base::out & _mode)
+  {
+    this->dataPtr->dictionaryMessages = _options.DictionaryMessages();
+    this->dataPtr->dictionaryLevel = _options.DictionaryCompressionLevel();
+    this->dataPtr->incrementalVacuum =
+      _options.AutoVacuum() == log::AutoVacuum::INCREMENTAL;
+  }
+
+  this->dataPtr->filename = _file;
+  this->dataPtr->transactionPeriod = _options.TransactionPeriod();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Log::OpenSplit(const std::vector<std::string> &_files)
+{
+  if (this->Valid())
+  {
+    LERR("A database is already open\n");
+    return false;
+  }
+  return this->dataPtr->OpenParts(_files, false);
+}
+
+//////////////////////////////////////////////////
+bool Log::OpenMerged(const std::vector<std::string> &_files)
+{
+  if (this->Valid())
+  {
+    LERR("A database is already open\n");
+    return false;
+  }
+  return this->dataPtr->OpenParts(_files, true);
+}
+
+//////////////////////////////////////////////////
+std::string Log::SplitFileName(const std::string &_file,
+                               const std::size_t _index)
+{
+  if (_index == 0)
+    return _file;
+
+  const std::filesystem::path path(_file);
+  std::filesystem::path name = path.stem();
+  name += "_" + std::to_string(_index);
+  name += path.extension();
+  return (path.parent_path() / name).string();
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> Log::SplitFiles(const std::string &_file)
+{
+  std::vector<std::string> files;
+  std::error_code ec;
+  for (std::size_t i = 0; ; ++i)
+  {
+    std::string file = SplitFileName(_file, i);
+    if (!std::filesystem::exists(file, ec))
+      break;
+    files.push_back(std::move(file));
+  }
+  return files;
+}
+
+//////////////////////////////////////////////////
+bool Log::Migrate(const std::string &_file)
+{
+  if (ChunkedLog::IsChunkedLog(_file))
+    return true;
+
+  raii_sqlite3::Database db(_file, SQLITE_OPEN_URI | SQLITE_OPEN_READWRITE);
+  if (!db)
+    return false;
+
+  const std::string version = SchemaVersion(db);
+  if (version.empty() || !UpdateSchema(db, version))
+  {
+    LERR("Failed to migrate [" << _file << "]\n");
+    return false;
+  }
+
+  LDBG("Migrated [" << _file << "] from schema " << version << "\n");
+  return true;
+}
+
+//////////////////////////////////////////////////
+const log::Descriptor *Log::Descriptor() const
+{
+  return this->dataPtr->Descriptor();
+}
+
+//////////////////////////////////////////////////
+bool Log::InsertMessage(
+    const std::chrono::nanoseconds &_time,
+    const std::string &_topic, const std::string &_type,
+    const void *_data, const std::size_t _len)
+{
+  if (!this->Valid())
+  {
+    return false;
+  }
+
+  if (!this->dataPtr->parts.empty())
+  {
+    LERR("A split recording is read only\n");
+    return false;
+  }
+
+  if (this->dataPtr->chunked)
+  {
+    return this->dataPtr->InsertChunked(_time, _topic, _type, _data, _len);
+  }
+
+  // Need to insert multiple messages pertransaction for best performance
+  if (SQLITE_OK != this->dataPtr->BeginTransactionIfNotInOne())
+  {
+    return false;
+  }
+
+  // Get the topics.id for this name and message type
+  int64_t topicId = this->dataPtr->InsertOrGetTopicId(_topic, _type);
+  if (topicId < 0)
+  {
+    return false;
+  }
+
+  // Insert the message into the database
+  if (!this->dataPtr->InsertMessage(_time, topicId, _data, _len))
+  {
+    return false;
+  }
+  this->dataPtr->UpdateSummary(topicId, _topic, _type, _time, _len);
+
+  // Finish the transaction if enough time has passed
+  if (SQLITE_OK != this->dataPtr->EndTransactionIfEnoughTimeHasPassed())
+  {
+    // Something is really busted if this happens
+    LERR("Failed to end transcation: "<< sqlite3_errmsg(
+        this->dataPtr->db->Handle()) << "\n");
+    return false;
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t Log::InsertMessages(
+    const PendingMessage *_messages, const std::size_t _count)
+{
+  if (!this->Valid() || _count == 0)
+  {
+    return 0;
+  }
+
+  if (!this->dataPtr->parts.empty())
+  {
+    LERR("A split recording is read only\n");
+    return 0;
+  }
+
+  if (this->dataPtr->chunked)
+  {
+    std::size_t inserted = 0;
+    for (std::size_t i = 0; i < _count; ++i)
+    {
+      const PendingMessage &msg = _messages[i];
+      if (this->dataPtr->InsertChunked(
+            msg.time, msg.topic, msg.type, msg.data, msg.len))
+      {
+        ++inserted;
+      }
+    }
+    return inserted;
+  }
+
+  // All the messages go in the current transaction
+  if (SQLITE_OK != this->dataPtr->BeginTransactionIfNotInOne())
+  {
+    return 0;
+  }
+
+  std::size_t inserted = 0;
+  for (std::size_t i = 0; i < _count; ++i)
+  {
+    const PendingMessage &msg = _messages[i];
+    int64_t topicId = this->dataPtr->InsertOrGetTopicId(msg.topic, msg.type);
+    if (topicId >= 0 &&
+        this->dataPtr->InsertMessage(msg.time, topicId, msg.data, msg.len))
+    {
+      this->dataPtr->UpdateSummary(
+          topicId, msg.topic, msg.type, msg.time, msg.len);
+      ++inserted;
+    }
+  }
+
+  // Finish the transaction if enough time has passed
+  if (SQLITE_OK != this->dataPtr->EndTransactionIfEnoughTimeHasPassed())
+  {
+    // Something is really busted if this happens
+    LERR("Failed to end transcation: "<< sqlite3_errmsg(
+        this->dataPtr->db->Handle()) << "\n");
+    return 0;
+  }
+
+  return inserted;
+}
+
+//////////////////////////////////////////////////
+Batch Log::QueryMessages(const QueryOptions &_options)
+{
+  const log::Descriptor *desc = this->Descriptor();
+
+  // Make sure the log has been initialized.
+  // TODO(anyone): Should we print a warning here?
+  if (!desc)
+    return Batch();
+
+  if (!this->dataPtr->parts.empty())
+  {
+    // Each file runs the query with its own descriptor.
+    std::vector<std::unique_ptr<BatchPrivate>> batches;
+    for (const auto &part : this->dataPtr->parts)
+    {
+      Batch batch = part->QueryMessages(_options);
+      if (batch.dataPtr)
+        batches.push_back(std::move(batch.dataPtr));
+    }
+    std::unique_ptr<BatchPrivate> batchPriv(
+        new BatchPrivate(std::move(batches), this->dataPtr->mergeParts));
+    return Batch(std::move(batchPriv));
+  }
+
+  if (this->dataPtr->chunked)
+  {
+    ChunkedQuery query;
+    if (!this->dataPtr->ChunkedQueryFromOptions(_options, query))
+      return Batch();
+
+    std::unique_ptr<BatchPrivate> batchPriv(
+          new BatchPrivate(this->dataPtr->chunked->Snapshot(), query));
+    return Batch(std::move(batchPriv));
+  }
+
+  std::unique_ptr<BatchPrivate> batchPriv(
+        new BatchPrivate(this->dataPtr->db,
+                         _options.GenerateStatements(*desc),
+                         this->dataPtr->Dictionaries()));
+
+  return Batch(std::move(batchPriv));
+}
+
+//////////////////////////////////////////////////
+Batch Log::QueryNewMessages(const QueryOptions &_options)
+{
+  if (!this->dataPtr->db)
+  {
+    LERR("Only a SQLite log can be followed while it is recorded\n");
+    return Batch();
+  }
+
+  // Messages are committed in order of their id, so the messages up to the
+  // last one committed now are given once, even if more are committed while
+  // they are read
+  raii_sqlite3::Statement lastStatement(*(this->dataPtr->db),
+      "SELECT MAX(id) FROM messages;");
+  if (!lastStatement || sqlite3_step(lastStatement.Handle()) != SQLITE_ROW)
+  {
+    LERR("Failed to get the last message: " << sqlite3_errmsg(
+        this->dataPtr->db->Handle()) << "\n");
+    return Batch();
+  }
+  const int64_t last = sqlite3_column_int64(lastStatement.Handle(), 0);
+  const int64_t first = this->dataPtr->lastNewMessageId;
+
+  // The topics, times and summaries of the log are read again if messages
+  // were committed since they were read. They are read after the last
+  // message, so they know the topics of the new messages.
+  this->dataPtr->Refresh();
+
+  std::vector<int64_t> topicIds;
+  if (!this->dataPtr->TopicIdsFromOptions(_options, topicIds))
+  {
+    LERR("Custom query options are not supported to follow a log\n");
+    return Batch();
+  }
+
+  if (last <= first || topicIds.empty())
+  {
+    this->dataPtr->lastNewMessageId = std::max(first, last);
+    return Batch();
   }
+  this->dataPtr->lastNewMessageId = last;
 
-  // Reset startTime and endTime
-  this->startTime = std::chrono::nanoseconds(-1);
-  this->endTime = std::chrono::nanoseconds(-1);
+  // The new messages are read from the primary key, without an index on
+  // their topic or time
+  SqlStatement sql = QueryOptions::StandardMessageQueryPreamble();
+  sql.statement += " WHERE messages.id > ? AND messages.id <= ?";
+  sql.parameters.emplace_back(first);
+  sql.parameters.emplace_back(last);
 
+  if (!dynamic_cast<const AllTopics *>(&_options))
+  {
+    sql.statement += " AND +messages.topic_id IN (";
+    for (std::size_t i = 0; i < topicIds.size(); ++i)
+    {
+      sql.statement += i == 0 ? "?" : ", ?";
+      sql.parameters.emplace_back(topicIds[i]);
+    }
+    sql.statement += ")";
+  }
 
-  // Execute the statement
-  returnCode = sqlite3_step(statement.Handle());
-  if (returnCode != SQLITE_DONE)
+  const SqlStatement timeCondition =
+      dynamic_cast<const TimeRangeOption &>(_options).GenerateTimeConditions();
+  if (!timeCondition.statement.empty())
   {
-    LERR("Failed to insert message. sqlite3 return code[" << returnCode
-        << "] data[" << _data << "] len[" << _len << "]\n");
-    return false;
+    sql.statement += " AND (";
+    sql.Append(timeCondition);
+    sql.statement += ")";
   }
-  return true;
-}
+  sql.statement += " ORDER BY messages.id;";
 
-//////////////////////////////////////////////////
-Log::Log()
-  : dataPtr(new Implementation)
-{
-  // Default to 2 transactions per second
-  this->dataPtr->transactionPeriod = std::chrono::milliseconds(500);
+  std::vector<SqlStatement> statements;
+  statements.push_back(std::move(sql));
+  std::unique_ptr<BatchPrivate> batchPriv(
+        new BatchPrivate(this->dataPtr->db, std::move(statements),
+                         this->dataPtr->Dictionaries()));
+  return Batch(std::move(batchPriv));
 }
 
 //////////////////////////////////////////////////
-Log::Log(Log &&_other)  // NOLINT
-  : dataPtr(std::move(_other.dataPtr))
+std::size_t Log::QueryMessagesParallel(const QueryOptions &_options,
+    const std::size_t _threads, const PartitionCallback &_callback,
+    const QueryPartitioning _partitioning)
 {
-}
+  if (!this->Valid() || !_callback)
+    return 0;
+
+  std::vector<std::unique_ptr<QueryOptions>> partitions =
+      this->dataPtr->PartitionQuery(*this, _options, _threads, _partitioning);
+  const std::size_t count = std::max<std::size_t>(partitions.size(), 1);
+
+  // Each partition is read from its own connection, which needs a
+  // threadsafe sqlite3 to be used on another thread. The log is reopened
+  // before starting the threads, so that a failure doesn't leave some
+  // partitions read.
+  std::vector<std::unique_ptr<Log>> logs;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::unique_ptr<Log> log = this->dataPtr->Reopen();
+    if (!log)
+      return 0;
+    logs.push_back(std::move(log));
+  }
 
-//////////////////////////////////////////////////
-Log::~Log()
-{
-  if (this->dataPtr && this->dataPtr->inTransaction)
+  auto readPartition = [&](const std::size_t _partition)
   {
-    this->dataPtr->EndTransaction();
+    const QueryOptions &options =
+        partitions.empty() ? _options : *partitions[_partition];
+    for (const Message &msg : logs[_partition]->QueryMessages(options))
+      _callback(_partition, msg);
+  };
+
+  if (count == 1 || (!this->dataPtr->chunked && sqlite3_threadsafe() == 0))
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      readPartition(i);
+    return count;
   }
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < count; ++i)
+    threads.emplace_back(readPartition, i);
+  for (std::thread &thread : threads)
+    thread.join();
+
+  return count;
 }
 
 //////////////////////////////////////////////////
-bool Log::Valid() const
+Batch Log::QueryMessagesMerged(const QueryOptions &_options,
+    const std::size_t _threads, const QueryPartitioning _partitioning)
 {
-  return this->dataPtr && this->dataPtr->db && *(this->dataPtr->db);
+  if (!this->Valid())
+    return Batch();
+
+  std::vector<std::unique_ptr<QueryOptions>> partitions =
+      this->dataPtr->PartitionQuery(*this, _options, _threads, _partitioning);
+  if (partitions.empty())
+    return this->QueryMessages(_options);
+
+  // The batches keep their connection or file open once the log that
+  // created them is closed
+  const bool readAhead =
+      this->dataPtr->chunked || sqlite3_threadsafe() != 0;
+  std::vector<std::unique_ptr<BatchPrivate>> batches;
+  for (const std::unique_ptr<QueryOptions> &options : partitions)
+  {
+    std::unique_ptr<Log> log = this->dataPtr->Reopen();
+    if (!log)
+      return Batch();
+
+    Batch batch = log->QueryMessages(*options);
+    if (!batch.dataPtr)
+      return Batch();
+    if (readAhead)
+      batch.SetReadAhead(kMergedReadAheadMessages, kMergedReadAheadBytes);
+    batches.push_back(std::move(batch.dataPtr));
+  }
+
+  std::unique_ptr<BatchPrivate> batchPriv(
+      new BatchPrivate(std::move(batches), true));
+  return Batch(std::move(batchPriv));
 }
 
 //////////////////////////////////////////////////
-bool Log::Open(const std::string &_file, const std::ios_base::openmode _mode)
+bool Log::Extract(const std::string &_file, const QueryOptions &_options,
+                  const RecordOptions &_recordOptions)
 {
-  // Open the SQLite3 database
-  if (this->dataPtr->db)
+  const log::Descriptor *desc = this->Descriptor();
+  if (!desc)
   {
-    LERR("A database is already open\n");
+    LERR("Cannot extract the messages of an invalid log\n");
     return false;
   }
-  int64_t modeSQL = SQLITE_OPEN_URI;
-  if (std::ios_base::out & _mode)
-  {
-    modeSQL = modeSQL | SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
-  }
-  else if (std::ios_base::in & _mode)
+
+  std::error_code ec;
+  if (std::filesystem::exists(_file, ec))
   {
-    modeSQL = modeSQL | SQLITE_OPEN_READONLY;
+    LERR("[" << _file << "] already exists\n");
+    return false;
   }
 
-  std::unique_ptr<raii_sqlite3::Database> db(
-      new raii_sqlite3::Database(_file, modeSQL));
-  if (!*(db))
+  // Copy the messages this instance inserted as well
+  if (this->dataPtr->inTransaction &&
+      this->dataPtr->EndTransaction() != SQLITE_OK)
   {
-    // The constructor of raii_sqlite3::Database will print out the reason that
-    // the database failed to open.
     return false;
   }
 
-  // Don't need to create a schema if this is read only
-  if (std::ios_base::out & _mode)
+  bool extracted = true;
   {
-    // Test hook so tests can be run before `make install`
-    std::string schemaFile;
-    const char *envPath = std::getenv(SchemaLocationEnvVar.c_str());
+    Log output;
+    if (!output.Open(_file, std::ios_base::out, _recordOptions))
+    {
+      LERR("Failed to create [" << _file << "]\n");
+      return false;
+    }
 
-    if (envPath)
+    // The built-in options of a SQLite log are copied to a SQLite log by
+    // SQLite, unless the log is a private in-memory database that can't be
+    // attached, or it has compressed messages, which get new ids. Anything
+    // else is copied message by message, without copying the data out of
+    // the batch.
+    std::vector<int64_t> topicIds;
+    if (this->dataPtr->db && output.dataPtr->db &&
+        !this->dataPtr->filename.empty() &&
+        this->dataPtr->filename != ":memory:" &&
+        !this->dataPtr->Dictionaries() &&
+        this->dataPtr->TopicIdsFromOptions(_options, topicIds))
     {
-      schemaFile = envPath;
+      if (!topicIds.empty())
+      {
+        extracted = this->dataPtr->CopyMessages(*(output.dataPtr->db),
+            topicIds,
+            dynamic_cast<const TimeRangeOption &>(_options)
+              .GenerateTimeConditions());
+      }
     }
     else
     {
-      schemaFile = SCHEMA_INSTALL_PATH;
+      for (const Message &msg : this->QueryMessages(_options))
+      {
+        const std::string_view data = msg.DataView();
+        if (!output.InsertMessage(msg.TimeReceived(), msg.Topic(),
+              msg.Type(), data.data(), data.size()))
+        {
+          extracted = false;
+          break;
+        }
+      }
     }
-    schemaFile += "/0.1.0.sql";
+  }
 
-    // Assume the database is uninitialized; use the schema to initialize it
-    LDBG("Schema file: " << schemaFile << "\n");
-    std::ifstream fin(schemaFile, std::ifstream::in);
-    if (!fin)
-    {
-      LERR("Failed to open schema [" << schemaFile << "].\n"
-          << " Set " << SchemaLocationEnvVar << " to the schema location.\n");
-      return false;
-    }
+  if (!extracted)
+  {
+    LERR("Failed to extract messages to [" << _file << "]\n");
+    std::filesystem::remove(_file, ec);
+  }
+  return extracted;
+}
 
-    // Read the schema file
-    std::string schema;
-    char buffer[4096];
-    while (fin)
-    {
-      fin.read(buffer, sizeof(buffer));
-      schema.insert(schema.size(), buffer, fin.gcount());
-    }
-    if (schema.empty())
+//////////////////////////////////////////////////
+bool Log::QueryMetadata(const QueryOptions &_options,
+                        const MetadataCallback &_callback)
+{
+  if (!this->Descriptor())
+    return false;
+
+  if (!this->dataPtr->parts.empty() && !this->dataPtr->mergeParts)
+  {
+    // The files of a split recording follow each other in time.
+    for (const auto &part : this->dataPtr->parts)
     {
-      LERR("Failed to read schema file [" << schemaFile << "]\n");
-      return false;
+      if (!part->QueryMetadata(_options, _callback))
+        return false;
     }
+    return true;
+  }
 
-    // Apply the schema to the database
-    int returnCode = sqlite3_exec(db->Handle(), schema.c_str(), NULL, 0, NULL);
-    if (returnCode != SQLITE_OK)
+  // The sizes are read from the headers of the records, without reading the
+  // messages, which are only read by chunked logs, merged logs and custom
+  // options.
+  SqlStatement sql;
+  sql.statement = "SELECT messages.time_recv, messages.topic_id,"
+                  " LENGTH(messages.message) FROM messages";
+  bool empty = false;
+  MessageMetadata metadata;
+  if (!this->dataPtr->db ||
+      !this->dataPtr->AppendBuiltInConditions(_options, sql, empty))
+  {
+    for (const Message &msg : this->QueryMessages(_options))
     {
-      LERR("Failed to open log: " << sqlite3_errmsg(db->Handle()) << "\n");
-      return false;
+      metadata.timeReceived = msg.TimeReceived();
+      metadata.topic = msg.Topic();
+      metadata.type = msg.Type();
+      metadata.size = msg.DataView().size();
+      _callback(metadata);
     }
+    return true;
   }
 
-  this->dataPtr->db = std::move(db);
+  if (empty)
+    return true;
+  sql.Append(QueryOptions::StandardMessageQueryClose());
 
-  // Check the schema version
-  // TODO(sloretz) handle multiple versions
-  std::string version = this->Version();
-  if ("0.1.0" != this->Version())
+  raii_sqlite3::Statement statement(*(this->dataPtr->db), sql.statement);
+  if (!statement || !MsgIterPrivate::BindParameters(statement, sql))
   {
-    LERR("Log file Version '" << version << "' is unsupported by this tool\n");
-    this->dataPtr->db.reset();
+    LERR("Failed to compile [" << sql.statement << "]: "
+        << sqlite3_errmsg(this->dataPtr->db->Handle()) << "\n");
     return false;
   }
 
-  this->dataPtr->filename = _file;
+  const auto names = this->dataPtr->TopicNames();
+  int64_t lastId = -1;
+  int returnCode;
+  while ((returnCode = sqlite3_step(statement.Handle())) == SQLITE_ROW)
+  {
+    const int64_t id = sqlite3_column_int64(statement.Handle(), 1);
+    if (id != lastId)
+    {
+      auto name = names.find(id);
+      if (name == names.end())
+        continue;
+      metadata.topic = name->second.first;
+      metadata.type = name->second.second;
+      lastId = id;
+    }
+    metadata.timeReceived = std::chrono::nanoseconds(
+        sqlite3_column_int64(statement.Handle(), 0));
+    metadata.size = static_cast<uint64_t>(
+        sqlite3_column_int64(statement.Handle(), 2));
+    _callback(metadata);
+  }
+
+  if (returnCode != SQLITE_DONE)
+  {
+    LERR("Failed to query the metadata of the messages: "
+        << sqlite3_errmsg(this->dataPtr->db->Handle()) << "\n");
+    return false;
+  }
   return true;
 }
 
 //////////////////////////////////////////////////
-const log::Descriptor *Log::Descriptor() const
+std::vector<TopicBucket> Log::QueryHistogram(
+    const std::chrono::nanoseconds &_bucket, const QueryOptions &_options)
 {
-  return this->dataPtr->Descriptor();
-}
+  std::vector<TopicBucket> result;
+  if (!this->Descriptor())
+    return result;
 
-//////////////////////////////////////////////////
-bool Log::InsertMessage(
-    const std::chrono::nanoseconds &_time,
-    const std::string &_topic, const std::string &_type,
-    const void *_data, const std::size_t _len)
-{
-  if (!this->Valid())
+  if (_bucket.count() <= 0)
   {
-    return false;
+    LERR("The buckets of a histogram must have a positive duration\n");
+    return result;
   }
 
-  // Need to insert multiple messages pertransaction for best performance
-  if (SQLITE_OK != this->dataPtr->BeginTransactionIfNotInOne())
+  using Key = std::tuple<int64_t, std::string, std::string>;
+  std::map<Key, TopicBucket> buckets;
+  const auto add = [&buckets](const int64_t _start, const std::string &_topic,
+      const std::string &_type, const uint64_t _messages,
+      const uint64_t _bytes)
   {
-    return false;
-  }
+    TopicBucket &bucket = buckets[Key(_start, _topic, _type)];
+    if (bucket.messages == 0)
+    {
+      bucket.topic = _topic;
+      bucket.type = _type;
+      bucket.start = std::chrono::nanoseconds(_start);
+    }
+    bucket.messages += _messages;
+    bucket.bytes += _bytes;
+  };
 
-  // Get the topics.id for this name and message type
-  int64_t topicId = this->dataPtr->InsertOrGetTopicId(_topic, _type);
-  if (topicId < 0)
+  SqlStatement sql;
+  sql.statement = "SELECT messages.topic_id, messages.time_recv / ? AS bucket,"
+                  " COUNT(*), SUM(LENGTH(messages.message)) FROM messages";
+  sql.parameters.emplace_back(static_cast<int64_t>(_bucket.count()));
+  bool empty = false;
+
+  if (!this->dataPtr->parts.empty())
   {
-    return false;
+    for (const auto &part : this->dataPtr->parts)
+    {
+      for (const TopicBucket &bucket : part->QueryHistogram(_bucket, _options))
+      {
+        add(bucket.start.count(), bucket.topic, bucket.type, bucket.messages,
+            bucket.bytes);
+      }
+    }
   }
-
-  // Insert the message into the database
-  if (!this->dataPtr->InsertMessage(_time, topicId, _data, _len))
+  else if (!this->dataPtr->db ||
+           !this->dataPtr->AppendBuiltInConditions(_options, sql, empty))
   {
-    return false;
+    // Chunked logs and custom options count the messages one by one
+    for (const Message &msg : this->QueryMessages(_options))
+    {
+      add(msg.TimeReceived().count() / _bucket.count() * _bucket.count(),
+          msg.Topic(), msg.Type(), 1, msg.DataView().size());
+    }
   }
-
-  // Finish the transaction if enough time has passed
-  if (SQLITE_OK != this->dataPtr->EndTransactionIfEnoughTimeHasPassed())
+  else if (!empty)
   {
-    // Something is really busted if this happens
-    LERR("Failed to end transcation: "<< sqlite3_errmsg(
-        this->dataPtr->db->Handle()) << "\n");
-    return false;
+    // SQLite aggregates the messages, reading their sizes from the headers
+    // of the records.
+    sql.statement += " GROUP BY bucket, messages.topic_id;";
+    raii_sqlite3::Statement statement(*(this->dataPtr->db), sql.statement);
+    if (!statement || !MsgIterPrivate::BindParameters(statement, sql))
+    {
+      LERR("Failed to compile [" << sql.statement << "]: "
+          << sqlite3_errmsg(this->dataPtr->db->Handle()) << "\n");
+      return result;
+    }
+
+    const auto names = this->dataPtr->TopicNames();
+    int returnCode;
+    while ((returnCode = sqlite3_step(statement.Handle())) == SQLITE_ROW)
+    {
+      auto name = names.find(sqlite3_column_int64(statement.Handle(), 0));
+      if (name == names.end())
+        continue;
+      add(sqlite3_column_int64(statement.Handle(), 1) * _bucket.count(),
+          name->second.first, name->second.second,
+          static_cast<uint64_t>(sqlite3_column_int64(statement.Handle(), 2)),
+          static_cast<uint64_t>(sqlite3_column_int64(statement.Handle(), 3)));
+    }
+
+    if (returnCode != SQLITE_DONE)
+    {
+      LERR("Failed to query the histogram of the messages: "
+          << sqlite3_errmsg(this->dataPtr->db->Handle()) << "\n");
+      return result;
+    }
   }
 
-  return true;
+  result.reserve(buckets.size());
+  for (auto &entry : buckets)
+    result.push_back(std::move(entry.second));
+  return result;
 }
 
 //////////////////////////////////////////////////
-Batch Log::QueryMessages(const QueryOptions &_options)
+std::vector<std::string> Log::QueryPlan(const QueryOptions &_options)
 {
-  const log::Descriptor *desc = this->Descriptor();
-
-  // Make sure the log has been initialized.
-  // TODO(anyone): Should we print a warning here?
-  if (!desc)
-    return Batch();
+  std::vector<std::string> plan;
 
-  std::unique_ptr<BatchPrivate> batchPriv(
-        new BatchPrivate(this->dataPtr->db,
-                         _options.GenerateStatements(*desc)));
+  const log::Descriptor *desc = this->Descriptor();
+  if (!desc || !this->dataPtr->db)
+    return plan;
 
-  return Batch(std::move(batchPriv));
+  for (const SqlStatement &statement : _options.GenerateStatements(*desc))
+  {
+    for (std::string &step :
+         MsgIterPrivate::QueryPlan(*(this->dataPtr->db), statement))
+    {
+      plan.push_back(std::move(step));
+    }
+  }
+  return plan;
 }
 
 //////////////////////////////////////////////////
@@ -584,6 +2612,44 @@ std::chrono::nanoseconds Log::StartTime() const
     return this->dataPtr->startTime;
   }
 
+  if (this->dataPtr->chunked)
+  {
+    this->dataPtr->startTime = this->dataPtr->chunked->StartTime();
+    return this->dataPtr->startTime;
+  }
+
+  if (!this->dataPtr->parts.empty())
+  {
+    // Files without messages (zero) don't count.
+    bool first = true;
+    for (const auto &part : this->dataPtr->parts)
+    {
+      const std::chrono::nanoseconds start = part->StartTime();
+      if (start == std::chrono::nanoseconds::zero() &&
+          part->EndTime() == std::chrono::nanoseconds::zero())
+      {
+        continue;
+      }
+      this->dataPtr->startTime =
+        first ? start : std::min(this->dataPtr->startTime, start);
+      first = false;
+    }
+    return this->dataPtr->startTime;
+  }
+
+  // The summaries give the time range without reading the messages
+  if (this->dataPtr->hasTopicStats && this->dataPtr->LoadSummaries())
+  {
+    bool first = true;
+    for (const auto &entry : this->dataPtr->summaries)
+    {
+      this->dataPtr->startTime = first ? entry.second.startTime :
+        std::min(this->dataPtr->startTime, entry.second.startTime);
+      first = false;
+    }
+    return this->dataPtr->startTime;
+  }
+
   // Compile the statement
   const char* const getStartTimeStatement =
       "SELECT MIN(time_recv) AS start_time FROM messages;";
@@ -628,6 +2694,33 @@ std::chrono::nanoseconds Log::EndTime() const
     return this->dataPtr->endTime;
   }
 
+  if (this->dataPtr->chunked)
+  {
+    this->dataPtr->endTime = this->dataPtr->chunked->EndTime();
+    return this->dataPtr->endTime;
+  }
+
+  if (!this->dataPtr->parts.empty())
+  {
+    for (const auto &part : this->dataPtr->parts)
+    {
+      this->dataPtr->endTime =
+        std::max(this->dataPtr->endTime, part->EndTime());
+    }
+    return this->dataPtr->endTime;
+  }
+
+  // The summaries give the time range without reading the messages
+  if (this->dataPtr->hasTopicStats && this->dataPtr->LoadSummaries())
+  {
+    for (const auto &entry : this->dataPtr->summaries)
+    {
+      this->dataPtr->endTime =
+        std::max(this->dataPtr->endTime, entry.second.endTime);
+    }
+    return this->dataPtr->endTime;
+  }
+
   // Compile the statement
   const char* const getEndTimeStatement =
       "SELECT MAX(time_recv) AS end_time FROM messages;";
@@ -681,6 +2774,73 @@ std::chrono::nanoseconds Log::EndTime() const
   return this->dataPtr->endTime;
 }
 
+//////////////////////////////////////////////////
+std::vector<TopicSummary> Log::TopicSummaries() const
+{
+  std::vector<TopicSummary> result;
+  if (!this->Valid())
+    return result;
+
+  std::map<std::pair<std::string, std::string>, TopicSummary> byTopic;
+  const auto add = [&byTopic](const TopicSummary &_summary)
+  {
+    auto inserted = byTopic.emplace(
+        std::make_pair(_summary.topic, _summary.type), _summary);
+    if (inserted.second)
+      return;
+
+    TopicSummary &summary = inserted.first->second;
+    summary.messages += _summary.messages;
+    summary.bytes += _summary.bytes;
+    summary.startTime = std::min(summary.startTime, _summary.startTime);
+    summary.endTime = std::max(summary.endTime, _summary.endTime);
+  };
+
+  if (!this->dataPtr->parts.empty())
+  {
+    for (const auto &part : this->dataPtr->parts)
+    {
+      for (const TopicSummary &summary : part->TopicSummaries())
+        add(summary);
+    }
+  }
+  else if (this->dataPtr->chunked)
+  {
+    // Chunked logs don't keep summaries, so the messages are counted
+    const log::Descriptor *desc = this->Descriptor();
+    ChunkedQuery query;
+    for (const auto &[topic, types] : desc->TopicsToMsgTypesToId())
+    {
+      for (const auto &[type, id] : types)
+        query.topics.insert(static_cast<uint32_t>(id));
+    }
+
+    std::unique_ptr<BatchPrivate> batchPriv(
+        new BatchPrivate(this->dataPtr->chunked->Snapshot(), query));
+    for (const Message &msg : Batch(std::move(batchPriv)))
+    {
+      TopicSummary summary;
+      summary.topic = msg.Topic();
+      summary.type = msg.Type();
+      summary.messages = 1;
+      summary.bytes = msg.DataView().size();
+      summary.startTime = msg.TimeReceived();
+      summary.endTime = msg.TimeReceived();
+      add(summary);
+    }
+  }
+  else if (this->dataPtr->LoadSummaries())
+  {
+    for (const auto &entry : this->dataPtr->summaries)
+      add(entry.second);
+  }
+
+  result.reserve(byTopic.size());
+  for (auto &entry : byTopic)
+    result.push_back(std::move(entry.second));
+  return result;
+}
+
 //////////////////////////////////////////////////
 std::string Log::Version() const
 {
@@ -689,27 +2849,17 @@ std::string Log::Version() const
     return "";
   }
 
-  // Compile the statement
-  const char *get_version =
-    "SELECT to_version FROM migrations ORDER BY id DESC LIMIT 1;";
-  raii_sqlite3::Statement statement(*(this->dataPtr->db), get_version);
-  if (!statement)
+  if (this->dataPtr->chunked)
   {
-    LERR("Failed to compile version query statement\n");
-    return "";
+    return this->dataPtr->chunked->FileVersion();
   }
 
-  // Try to run it
-  int result_code = sqlite3_step(statement.Handle());
-  if (result_code != SQLITE_ROW)
+  if (!this->dataPtr->parts.empty())
   {
-    LERR("Database has no version\n");
-    return "";
+    return this->dataPtr->parts.front()->Version();
   }
 
-  // Version is free'd automatically when statement is destructed
-  const unsigned char *version = sqlite3_column_text(statement.Handle(), 0);
-  return std::string(reinterpret_cast<const char *>(version));
+  return SchemaVersion(*(this->dataPtr->db));
 }
 
 //////////////////////////////////////////////////
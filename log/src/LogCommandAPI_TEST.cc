@@ -35,21 +35,30 @@ TEST(LogCommandAPI, RecordBadRegex)
 //////////////////////////////////////////////////
 TEST(LogCommandAPI, PlaybackBadRegex)
 {
-  EXPECT_EQ(BAD_REGEX, playbackTopics(":memory:", "*", 0, "", true));
+  EXPECT_EQ(BAD_REGEX, playbackTopics(":memory:", "*", 0, "", true, 1.0));
 }
 
 //////////////////////////////////////////////////
 TEST(LogCommandAPI, PlaybackBadRemap)
 {
-  EXPECT_EQ(INVALID_REMAP, playbackTopics(":memory:", ".*", 0, "/foo", true));
+  EXPECT_EQ(INVALID_REMAP, playbackTopics(":memory:", ".*", 0, "/foo", true,
+        1.0));
   EXPECT_EQ(INVALID_REMAP, playbackTopics(":memory:", ".*", 0, "/foo:=",
-        false));
+        false, 1.0));
   EXPECT_EQ(INVALID_REMAP, playbackTopics(":memory:", ".*", 0, "/foo:= ",
-        true));
+        true, 1.0));
   EXPECT_EQ(INVALID_REMAP, playbackTopics(":memory:", ".*", 0, ":=/bar",
-        false));
+        false, 1.0));
   EXPECT_EQ(INVALID_REMAP, playbackTopics(":memory:", ".*", 0, " :=/bar",
-        true));
+        true, 1.0));
+}
+
+//////////////////////////////////////////////////
+TEST(LogCommandAPI, PlaybackBadRate)
+{
+  EXPECT_EQ(INVALID_RATE, playbackTopics(":memory:", ".*", 0, "", false, 0.0));
+  EXPECT_EQ(INVALID_RATE, playbackTopics(":memory:", ".*", 0, "", false,
+        1000.0));
 }
 
 //////////////////////////////////////////////////
@@ -58,9 +67,28 @@ TEST(LogCommandAPI, RecordFailedToOpen)
   EXPECT_EQ(FAILED_TO_OPEN, recordTopics("!@#$%^&*(:;[{]})?/.'|", ".*"));
 }
 
+//////////////////////////////////////////////////
+TEST(LogCommandAPI, InfoFailedToOpen)
+{
+  EXPECT_EQ(FAILED_TO_OPEN, logInfo("!@#$%^&*(:;[{]})?/.'|"));
+}
+
+//////////////////////////////////////////////////
+TEST(LogCommandAPI, FilterBadRegex)
+{
+  EXPECT_EQ(BAD_REGEX, filterLog(":memory:", ":memory:", "*", -1, -1));
+}
+
+//////////////////////////////////////////////////
+TEST(LogCommandAPI, FilterFailedToOpen)
+{
+  EXPECT_EQ(FAILED_TO_OPEN,
+    filterLog("!@#$%^&*(:;[{]})?/.'|", ":memory:", ".*", -1, -1));
+}
+
 //////////////////////////////////////////////////
 TEST(LogCommandAPI, PlaybackFailedToOpen)
 {
   EXPECT_EQ(FAILED_TO_OPEN,
-    playbackTopics("!@#$%^&*(:;[{]})?/.'|", ".*", 0, "", false));
+    playbackTopics("!@#$%^&*(:;[{]})?/.'|", ".*", 0, "", false, 1.0));
 }
@@ -16,10 +16,20 @@
 */
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <filesystem>
 #include <ios>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <set>
 #include <string>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "gz/transport/log/Log.hh"
 
@@ -104,6 +114,146 @@ TEST(Log, InsertMessage)
       data.size()));
 }
 
+//////////////////////////////////////////////////
+TEST(Log, InsertMessages)
+{
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
+
+  const std::string topic1("/some/topic/name");
+  const std::string topic2("/another/topic/name");
+  const std::string type("some.message.type");
+  const std::string data1("first_data");
+  const std::string data2("second_data");
+  const std::string data3("third_data");
+
+  // The empty message can't be inserted.
+  std::vector<log::Log::PendingMessage> messages;
+  messages.push_back({1s, topic1, type, data1.c_str(), data1.size()});
+  messages.push_back({2s, topic2, type, data2.c_str(), data2.size()});
+  messages.push_back({3s, topic2, type, data2.c_str(), 0u});
+  messages.push_back({4s, topic1, type, data3.c_str(), data3.size()});
+
+  EXPECT_EQ(0u, logFile.InsertMessages(messages.data(), 0u));
+  EXPECT_EQ(3u, logFile.InsertMessages(messages.data(), messages.size()));
+
+  const log::Descriptor *desc = logFile.Descriptor();
+  ASSERT_NE(nullptr, desc);
+  EXPECT_EQ(2u, desc->TopicsToMsgTypesToId().size());
+
+  auto batch = logFile.QueryMessages();
+  auto iter = batch.begin();
+  ASSERT_NE(batch.end(), iter);
+  EXPECT_EQ(data1, iter->Data());
+  EXPECT_EQ(data1, iter->DataView());
+  EXPECT_EQ(topic1, iter->Topic());
+  ++iter;
+  ASSERT_NE(batch.end(), iter);
+  EXPECT_EQ(data2, iter->Data());
+  EXPECT_EQ(data2, iter->DataView());
+  EXPECT_EQ(topic2, iter->Topic());
+  ++iter;
+  ASSERT_NE(batch.end(), iter);
+  EXPECT_EQ(data3, iter->Data());
+  EXPECT_EQ(topic1, iter->Topic());
+  ++iter;
+  EXPECT_EQ(log::MsgIter(), iter);
+
+  // The cached statements keep working after the batch.
+  EXPECT_TRUE(logFile.InsertMessage(5s, topic2, type, data1.c_str(),
+      data1.size()));
+}
+
+//////////////////////////////////////////////////
+TEST(Log, OpenWithRecordOptions)
+{
+  const std::filesystem::path path =
+    std::filesystem::temp_directory_path() /
+    ("gz_log_options_" + testing::getRandomNumber() + ".tlog");
+
+  log::RecordOptions opts;
+  opts.SetJournal(log::JournalMode::WAL);
+  opts.SetSynchronous(log::Synchronous::NORMAL);
+  EXPECT_TRUE(opts.SetPageSize(16384));
+  opts.SetCacheSize(1024);
+  opts.SetTransactionPeriod(0ms);
+
+  const std::string data("Hello World");
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path.string(), std::ios_base::out, opts));
+
+    // With a zero period every insert is committed, to the write-ahead log.
+    EXPECT_TRUE(logFile.InsertMessage(1s, "/some/topic/name",
+        "some.message.type", data.c_str(), data.size()));
+    EXPECT_TRUE(std::filesystem::exists(path.string() + "-wal"));
+  }
+
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path.string()));
+    auto batch = logFile.QueryMessages();
+    auto iter = batch.begin();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(data, iter->Data());
+  }
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(path.string() + "-wal");
+  std::filesystem::remove(path.string() + "-shm");
+
+  // WAL isn't available for in-memory databases, the default mode is kept.
+  log::Log memoryLog;
+  EXPECT_TRUE(memoryLog.Open(":memory:", std::ios_base::out, opts));
+  EXPECT_TRUE(memoryLog.InsertMessage(1s, "/some/topic/name",
+      "some.message.type", data.c_str(), data.size()));
+}
+
+//////////////////////////////////////////////////
+TEST(Log, Preallocate)
+{
+  const std::filesystem::path path =
+    std::filesystem::temp_directory_path() /
+    ("gz_log_preallocate_" + testing::getRandomNumber() + ".tlog");
+  const uint64_t kChunk = 1u << 20;
+
+  log::RecordOptions opts;
+  opts.SetPreallocateSize(kChunk);
+  opts.SetAutoVacuum(log::AutoVacuum::INCREMENTAL);
+
+  const std::string data("Hello World");
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path.string(), std::ios_base::out, opts));
+    for (int i = 0; i < 100; ++i)
+    {
+      EXPECT_TRUE(logFile.InsertMessage(std::chrono::seconds(i),
+          "/some/topic/name", "some.message.type", data.c_str(),
+          data.size()));
+    }
+  }
+
+  // The file grows by whole chunks, and the incremental vacuum at close
+  // keeps them.
+  const uint64_t size = std::filesystem::file_size(path);
+  EXPECT_GT(size, 0u);
+  EXPECT_EQ(0u, size % kChunk);
+
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path.string()));
+    std::size_t count = 0;
+    for (const log::Message &msg : logFile.QueryMessages())
+    {
+      EXPECT_EQ(data, msg.Data());
+      ++count;
+    }
+    EXPECT_EQ(100u, count);
+  }
+
+  std::filesystem::remove(path);
+}
+
 //////////////////////////////////////////////////
 TEST(Log, AllMessagesNone)
 {
@@ -236,12 +386,914 @@ TEST(Log, CheckLogTimes)
 }
 
 
+//////////////////////////////////////////////////
+TEST(Log, SplitFileName)
+{
+  EXPECT_EQ("rec.tlog", log::Log::SplitFileName("rec.tlog", 0));
+  EXPECT_EQ("rec_1.tlog", log::Log::SplitFileName("rec.tlog", 1));
+  EXPECT_EQ("/tmp/rec_12.tlog", log::Log::SplitFileName("/tmp/rec.tlog", 12));
+  EXPECT_EQ("rec_2", log::Log::SplitFileName("rec", 2));
+}
+
+//////////////////////////////////////////////////
+TEST(Log, OpenSplit)
+{
+  const std::string base = (std::filesystem::temp_directory_path() /
+      ("gz_split_" + testing::getRandomNumber() + ".tlog")).string();
+  const std::vector<std::chrono::nanoseconds> times = {1s, 2s, 3s, 4s};
+  for (std::size_t i = 0; i < 2; ++i)
+  {
+    log::Log part;
+    ASSERT_TRUE(part.Open(log::Log::SplitFileName(base, i),
+                          std::ios_base::out));
+    for (std::size_t j = 0; j < 2; ++j)
+    {
+      const std::string data = std::to_string(2*i + j);
+      EXPECT_TRUE(part.InsertMessage(times[2*i + j],
+          i == 0 ? "/first" : "/second", "a.message.type",
+          data.c_str(), data.size()));
+    }
+  }
+
+  const std::vector<std::string> files = log::Log::SplitFiles(base);
+  ASSERT_EQ(2u, files.size());
+  EXPECT_EQ(log::Log::SplitFileName(base, 1), files[1]);
+
+  log::Log logFile;
+  ASSERT_TRUE(logFile.OpenSplit(files));
+  EXPECT_TRUE(logFile.Valid());
+  EXPECT_EQ(1s, logFile.StartTime());
+  EXPECT_EQ(4s, logFile.EndTime());
+  EXPECT_FALSE(logFile.InsertMessage(5s, "/first", "a.message.type", "x", 1));
+
+  const log::Descriptor *desc = logFile.Descriptor();
+  ASSERT_NE(nullptr, desc);
+  EXPECT_EQ(2u, desc->TopicsToMsgTypesToId().size());
+
+  std::vector<std::string> data;
+  for (const log::Message &msg : logFile.QueryMessages())
+    data.push_back(msg.Data());
+  EXPECT_EQ((std::vector<std::string>{"0", "1", "2", "3"}), data);
+
+  data.clear();
+  for (const log::Message &msg :
+       logFile.QueryMessages(log::TopicList("/second")))
+  {
+    data.push_back(msg.Data());
+  }
+  EXPECT_EQ((std::vector<std::string>{"2", "3"}), data);
+
+  for (const std::string &file : files)
+    std::filesystem::remove(file);
+}
+
+//////////////////////////////////////////////////
+TEST(Log, OpenMerged)
+{
+  const std::string base = (std::filesystem::temp_directory_path() /
+      ("gz_merged_" + testing::getRandomNumber())).string();
+
+  // Three logs recorded at the same time, in both formats
+  std::vector<std::string> files;
+  for (int i = 0; i < 3; ++i)
+  {
+    files.push_back(base + "_" + std::to_string(i) + ".tlog");
+    log::RecordOptions options;
+    options.SetFormat(i == 1 ? log::LogFormat::CHUNKED :
+                               log::LogFormat::SQLITE);
+    log::Log part;
+    ASSERT_TRUE(part.Open(files.back(), std::ios_base::out, options));
+    for (int t = i; t < 30; t += 3)
+    {
+      const std::string data = std::to_string(t);
+      EXPECT_TRUE(part.InsertMessage(std::chrono::nanoseconds(t),
+          "/topic" + std::to_string(i), "a.message.type",
+          data.c_str(), data.size()));
+    }
+    // The same time as a message of the first log
+    if (i == 2)
+    {
+      EXPECT_TRUE(part.InsertMessage(0ns, "/topic2", "a.message.type", "x",
+          1));
+    }
+  }
+
+  log::Log logFile;
+  ASSERT_TRUE(logFile.OpenMerged(files));
+  EXPECT_FALSE(logFile.OpenMerged(files));
+  EXPECT_EQ(0s, logFile.StartTime());
+  EXPECT_EQ(29ns, logFile.EndTime());
+  ASSERT_NE(nullptr, logFile.Descriptor());
+  EXPECT_EQ(3u, logFile.Descriptor()->TopicsToMsgTypesToId().size());
+
+  std::vector<std::string> data;
+  for (const log::Message &msg : logFile.QueryMessages())
+    data.push_back(msg.Data());
+  ASSERT_EQ(31u, data.size());
+  EXPECT_EQ("0", data[0]);
+  EXPECT_EQ("x", data[1]);
+  for (std::size_t t = 1; t < 30; ++t)
+    EXPECT_EQ(std::to_string(t), data[t + 1]);
+
+  data.clear();
+  const log::TopicList topics(std::set<std::string>{"/topic0", "/topic1"},
+      log::QualifiedTimeRange(log::QualifiedTime(10ns),
+                              log::QualifiedTime(20ns)));
+  for (const log::Message &msg : logFile.QueryMessages(topics))
+    data.push_back(msg.Data());
+  EXPECT_EQ((std::vector<std::string>{"10", "12", "13", "15", "16", "18",
+      "19"}), data);
+
+  int count = 0;
+  EXPECT_TRUE(logFile.QueryMetadata(log::AllTopics(),
+    [&count](const log::MessageMetadata &_metadata)
+    {
+      EXPECT_LE(std::chrono::nanoseconds(count - 1), _metadata.timeReceived);
+      ++count;
+    }));
+  EXPECT_EQ(31, count);
+
+  log::Log missing;
+  EXPECT_FALSE(missing.OpenMerged({files[0], base + "_missing.tlog"}));
+  EXPECT_FALSE(missing.OpenMerged({}));
+
+  for (const std::string &file : files)
+    std::filesystem::remove(file);
+}
+
 //////////////////////////////////////////////////
 TEST(Log, CheckVersion)
 {
   log::Log logFile;
   ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
-  EXPECT_EQ("0.1.0", logFile.Version());
+  EXPECT_EQ("0.4.0", logFile.Version());
+}
+
+//////////////////////////////////////////////////
+TEST(Log, TopicSummaries)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_summary_" + testing::getRandomNumber() + ".tlog")).string();
+
+  for (const log::LogFormat format :
+       {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+  {
+    log::RecordOptions options;
+    options.SetFormat(format);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+      EXPECT_TRUE(logFile.TopicSummaries().empty());
+
+      EXPECT_TRUE(logFile.InsertMessage(
+          5s, "/b", "b.type", "12345", 5));
+      const std::string a = "/a";
+      const std::string aType = "a.type";
+      const std::string b = "/b";
+      const std::string bType = "b.type";
+      const std::vector<log::Log::PendingMessage> messages = {
+        {2s, a, aType, "123", 3},
+        {9s, b, bType, "1", 1},
+        {3s, a, aType, "12", 2},
+      };
+      EXPECT_EQ(3u, logFile.InsertMessages(messages.data(), messages.size()));
+
+      // The summaries include the messages of the current transaction
+      EXPECT_EQ(2s, logFile.StartTime());
+      EXPECT_EQ(9s, logFile.EndTime());
+      EXPECT_EQ(2u, logFile.TopicSummaries().size());
+    }
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path));
+    EXPECT_EQ(2s, logFile.StartTime());
+    EXPECT_EQ(9s, logFile.EndTime());
+
+    const std::vector<log::TopicSummary> summaries = logFile.TopicSummaries();
+    ASSERT_EQ(2u, summaries.size());
+    EXPECT_EQ("/a", summaries[0].topic);
+    EXPECT_EQ("a.type", summaries[0].type);
+    EXPECT_EQ(2u, summaries[0].messages);
+    EXPECT_EQ(5u, summaries[0].bytes);
+    EXPECT_EQ(2s, summaries[0].startTime);
+    EXPECT_EQ(3s, summaries[0].endTime);
+    EXPECT_EQ("/b", summaries[1].topic);
+    EXPECT_EQ(2u, summaries[1].messages);
+    EXPECT_EQ(6u, summaries[1].bytes);
+    EXPECT_EQ(5s, summaries[1].startTime);
+    EXPECT_EQ(9s, summaries[1].endTime);
+
+    std::filesystem::remove(path);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Messages compressed with a dictionary per topic are read back
+/// whole, from any time.
+TEST(Log, DictionaryCompression)
+{
+  log::RecordOptions options;
+  if (!options.SetDictionaryCompression(50u))
+    return;
+
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_dictionary_" + testing::getRandomNumber() + ".tlog")).string();
+
+  // Small messages which share most of their contents, e.g. a pose with a
+  // header, and a topic with too few messages to train a dictionary
+  std::vector<std::string> data;
+  for (int i = 0; i < 2000; ++i)
+  {
+    data.push_back("header { stamp { sec: " + std::to_string(i / 100) +
+        " nsec: " + std::to_string(i % 100) + " } frame_id: \"base_link\" }"
+        " position { x: " + std::to_string(i % 7) + " y: 0.5 z: 1.25 }");
+  }
+  const std::size_t fewMessages = 10;
+
+  std::size_t bytes = 0;
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+      const std::chrono::nanoseconds time = 1ms * i;
+      ASSERT_TRUE(logFile.InsertMessage(time, "/pose", "gz.msgs.Pose",
+          data[i].data(), data[i].size()));
+      if (i < fewMessages)
+      {
+        ASSERT_TRUE(logFile.InsertMessage(time, "/few", "gz.msgs.Pose",
+            data[i].data(), data[i].size()));
+      }
+      bytes += data[i].size();
+    }
+
+    // The messages of the current transaction are read back as well
+    std::size_t count = 0;
+    for (const log::Message &msg : logFile.QueryMessages(
+           log::TopicList("/pose")))
+    {
+      EXPECT_EQ(data[count++], msg.Data());
+    }
+    EXPECT_EQ(data.size(), count);
+  }
+
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(path));
+
+  // The metadata gives the size of the stored messages
+  std::size_t stored = 0;
+  EXPECT_TRUE(logFile.QueryMetadata(log::TopicList("/pose"),
+    [&stored](const log::MessageMetadata &_metadata)
+    {
+      stored += _metadata.size;
+    }));
+  EXPECT_LT(stored * 2, bytes);
+
+  // Every message, uncompressed or not
+  std::size_t count = 0;
+  std::size_t fewCount = 0;
+  for (const log::Message &msg : logFile.QueryMessages())
+  {
+    if (msg.Topic() == "/few")
+    {
+      EXPECT_EQ(data[fewCount++], msg.Data());
+      continue;
+    }
+    EXPECT_EQ(std::chrono::nanoseconds(1ms * count), msg.TimeReceived());
+    EXPECT_EQ(data[count++], msg.Data());
+  }
+  EXPECT_EQ(data.size(), count);
+  EXPECT_EQ(fewMessages, fewCount);
+
+  // A message in the middle is read without the ones before it
+  for (const std::size_t i : {std::size_t(10), std::size_t(1234)})
+  {
+    log::Batch batch = logFile.QueryMessages(log::TopicList(
+        "/pose", log::QualifiedTimeRange::From(
+          log::QualifiedTime(std::chrono::nanoseconds(1ms * i)))));
+    auto iter = batch.begin();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(data[i], iter->Data());
+
+    // Read ahead and preloaded, the data is shared with the message
+    batch.SetReadAhead(16u);
+    iter = batch.begin();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(data[i], std::string(iter->SharedData().get(),
+        iter->DataView().size()));
+    ASSERT_TRUE(batch.Preload());
+    iter = batch.begin();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(data[i], iter->Data());
+  }
+
+  // The summaries count the uncompressed size
+  const std::vector<log::TopicSummary> summaries = logFile.TopicSummaries();
+  ASSERT_EQ(2u, summaries.size());
+  EXPECT_EQ("/pose", summaries[1].topic);
+  EXPECT_EQ(bytes, summaries[1].bytes);
+
+  // The extracted messages are decompressed
+  const std::string extractPath = path + ".extract";
+  ASSERT_TRUE(logFile.Extract(extractPath, log::TopicList("/pose")));
+  {
+    log::Log extracted;
+    ASSERT_TRUE(extracted.Open(extractPath));
+    count = 0;
+    for (const log::Message &msg : extracted.QueryMessages())
+      EXPECT_EQ(data[count++], msg.Data());
+    EXPECT_EQ(data.size(), count);
+  }
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(extractPath);
+}
+
+//////////////////////////////////////////////////
+TEST(Log, Extract)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_extract_" + testing::getRandomNumber() + ".tlog")).string();
+  const std::string extractPath = path + ".extract";
+
+  const log::TopicPattern query(std::regex("/(a|b)"),
+      log::QualifiedTimeRange(log::QualifiedTime(10ns),
+                              log::QualifiedTime(49ns)));
+
+  for (const log::LogFormat format :
+       {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+  {
+    log::RecordOptions options;
+    options.SetFormat(format);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+      for (int i = 0; i < 60; ++i)
+      {
+        const std::string data(static_cast<std::size_t>(i + 1), 'x');
+        const std::string topic = i % 3 == 0 ? "/a" : i % 3 == 1 ? "/b" : "/c";
+        EXPECT_TRUE(logFile.InsertMessage(std::chrono::nanoseconds(i), topic,
+            topic + ".type", data.c_str(), data.size()));
+      }
+    }
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path));
+
+    // To either format, from either format
+    for (const log::LogFormat extractFormat :
+         {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+    {
+      log::RecordOptions extractOptions;
+      extractOptions.SetFormat(extractFormat);
+      ASSERT_TRUE(logFile.Extract(extractPath, query, extractOptions));
+
+      // The file must not exist already
+      EXPECT_FALSE(logFile.Extract(extractPath, query, extractOptions));
+
+      log::Log extracted;
+      ASSERT_TRUE(extracted.Open(extractPath));
+      int count = 0;
+      int i = 10;
+      for (const log::Message &msg : extracted.QueryMessages())
+      {
+        if (i % 3 == 2)
+          ++i;
+        EXPECT_EQ(std::chrono::nanoseconds(i), msg.TimeReceived());
+        EXPECT_EQ(i % 3 == 0 ? "/a" : "/b", msg.Topic());
+        EXPECT_EQ(msg.Topic() + ".type", msg.Type());
+        EXPECT_EQ(std::string(static_cast<std::size_t>(i + 1), 'x'),
+                  msg.Data());
+        ++count;
+        ++i;
+      }
+      EXPECT_EQ(27, count);
+
+      const std::vector<log::TopicSummary> summaries =
+          extracted.TopicSummaries();
+      ASSERT_EQ(2u, summaries.size());
+      EXPECT_EQ("/a", summaries[0].topic);
+      EXPECT_EQ(13u, summaries[0].messages);
+      EXPECT_EQ(12ns, summaries[0].startTime);
+      EXPECT_EQ(48ns, summaries[0].endTime);
+      EXPECT_EQ("/b", summaries[1].topic);
+      EXPECT_EQ(14u, summaries[1].messages);
+
+      std::filesystem::remove(extractPath);
+    }
+
+    std::filesystem::remove(path);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Log, QueryMetadataAndHistogram)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_metadata_" + testing::getRandomNumber() + ".tlog")).string();
+
+  const log::TopicPattern query(std::regex("/(a|b)"),
+      log::QualifiedTimeRange(log::QualifiedTime(10ns),
+                              log::QualifiedTime(49ns)));
+
+  for (const log::LogFormat format :
+       {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+  {
+    log::RecordOptions options;
+    options.SetFormat(format);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+      for (int i = 0; i < 60; ++i)
+      {
+        const std::string data(static_cast<std::size_t>(i + 1), 'x');
+        const std::string topic = i % 3 == 0 ? "/a" : i % 3 == 1 ? "/b" : "/c";
+        EXPECT_TRUE(logFile.InsertMessage(std::chrono::nanoseconds(i), topic,
+            topic + ".type", data.c_str(), data.size()));
+      }
+    }
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path));
+
+    int count = 0;
+    int i = 10;
+    EXPECT_TRUE(logFile.QueryMetadata(query,
+      [&count, &i](const log::MessageMetadata &_metadata)
+      {
+        if (i % 3 == 2)
+          ++i;
+        EXPECT_EQ(std::chrono::nanoseconds(i), _metadata.timeReceived);
+        EXPECT_EQ(i % 3 == 0 ? "/a" : "/b", _metadata.topic);
+        EXPECT_EQ(_metadata.topic + ".type", _metadata.type);
+        EXPECT_EQ(static_cast<uint64_t>(i + 1), _metadata.size);
+        ++count;
+        ++i;
+      }));
+    EXPECT_EQ(27, count);
+
+    // No topic matches
+    count = 0;
+    EXPECT_TRUE(logFile.QueryMetadata(log::TopicList("/none"),
+      [&count](const log::MessageMetadata &) { ++count; }));
+    EXPECT_EQ(0, count);
+
+    EXPECT_TRUE(logFile.QueryHistogram(0ns, query).empty());
+
+    const std::vector<log::TopicBucket> buckets =
+        logFile.QueryHistogram(20ns, query);
+    ASSERT_EQ(6u, buckets.size());
+    const std::vector<std::pair<int, std::string>> expected = {
+      {0, "/a"}, {0, "/b"}, {20, "/a"}, {20, "/b"}, {40, "/a"}, {40, "/b"}};
+    for (std::size_t b = 0; b < buckets.size(); ++b)
+    {
+      const int start = expected[b].first;
+      const std::string &topic = expected[b].second;
+      EXPECT_EQ(std::chrono::nanoseconds(start), buckets[b].start);
+      EXPECT_EQ(topic, buckets[b].topic);
+      EXPECT_EQ(topic + ".type", buckets[b].type);
+
+      uint64_t messages = 0;
+      uint64_t bytes = 0;
+      for (int t = std::max(start, 10); t < std::min(start + 20, 50); ++t)
+      {
+        if ((topic == "/a" && t % 3 == 0) || (topic == "/b" && t % 3 == 1))
+        {
+          ++messages;
+          bytes += static_cast<uint64_t>(t + 1);
+        }
+      }
+      EXPECT_EQ(messages, buckets[b].messages);
+      EXPECT_EQ(bytes, buckets[b].bytes);
+    }
+
+    // Every topic in a single bucket
+    const std::vector<log::TopicBucket> all = logFile.QueryHistogram(1s);
+    ASSERT_EQ(3u, all.size());
+    EXPECT_EQ("/c", all[2].topic);
+    EXPECT_EQ(20u, all[2].messages);
+
+    std::filesystem::remove(path);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Log, QueryNewMessages)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_follow_" + testing::getRandomNumber() + ".tlog")).string();
+
+  log::RecordOptions options;
+  options.SetJournal(log::JournalMode::WAL);
+  options.SetTransactionPeriod(0ms);
+
+  log::Log recording;
+  ASSERT_TRUE(recording.Open(path, std::ios_base::out, options));
+  const std::string data("data");
+  ASSERT_TRUE(recording.InsertMessage(1ns, "/a", "type.a",
+      data.c_str(), data.size()));
+
+  log::Log follower;
+  ASSERT_TRUE(follower.Open(path));
+  const log::TopicPattern query(std::regex("/a|/c"));
+
+  const auto topics = [](log::Batch &&_batch)
+  {
+    std::string result;
+    for (const log::Message &msg : _batch)
+      result += msg.Topic();
+    return result;
+  };
+
+  EXPECT_EQ("/a", topics(follower.QueryNewMessages(query)));
+  EXPECT_EQ(1ns, follower.EndTime());
+
+  // Nothing was committed since
+  EXPECT_EQ("", topics(follower.QueryNewMessages(query)));
+
+  // A new topic is followed once its messages are committed
+  ASSERT_TRUE(recording.InsertMessage(2ns, "/b", "type.b",
+      data.c_str(), data.size()));
+  ASSERT_TRUE(recording.InsertMessage(3ns, "/c", "type.c",
+      data.c_str(), data.size()));
+  ASSERT_TRUE(recording.InsertMessage(4ns, "/a", "type.a",
+      data.c_str(), data.size()));
+  EXPECT_EQ("/c/a", topics(follower.QueryNewMessages(query)));
+  EXPECT_EQ(4ns, follower.EndTime());
+  EXPECT_EQ(3u, follower.TopicSummaries().size());
+  EXPECT_EQ(3u, follower.Descriptor()->TopicsToMsgTypesToId().size());
+
+  // Messages committed while a batch is read are given by the next call
+  ASSERT_TRUE(recording.InsertMessage(5ns, "/b", "type.b",
+      data.c_str(), data.size()));
+  log::Batch batch = follower.QueryNewMessages();
+  ASSERT_TRUE(recording.InsertMessage(6ns, "/a", "type.a",
+      data.c_str(), data.size()));
+  EXPECT_EQ("/b", topics(std::move(batch)));
+  EXPECT_EQ("/a", topics(follower.QueryNewMessages()));
+
+  // Chunked logs can't be followed
+  log::Log chunked;
+  log::RecordOptions chunkedOptions;
+  chunkedOptions.SetFormat(log::LogFormat::CHUNKED);
+  ASSERT_TRUE(chunked.Open(path + ".chunked", std::ios_base::out,
+      chunkedOptions));
+  EXPECT_EQ("", topics(chunked.QueryNewMessages()));
+
+  std::filesystem::remove(path + ".chunked");
+  std::filesystem::remove(path);
+  std::filesystem::remove(path + "-wal");
+  std::filesystem::remove(path + "-shm");
+}
+
+//////////////////////////////////////////////////
+TEST(Log, ReadAhead)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_read_ahead_" + testing::getRandomNumber() + ".tlog")).string();
+
+  for (const log::LogFormat format :
+       {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+  {
+    log::RecordOptions options;
+    options.SetFormat(format);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+      for (int i = 0; i < 100; ++i)
+      {
+        const std::string data(static_cast<std::size_t>(i + 1), 'x');
+        EXPECT_TRUE(logFile.InsertMessage(
+            std::chrono::nanoseconds(i), i % 2 ? "/odd" : "/even",
+            "a.message.type", data.c_str(), data.size()));
+      }
+    }
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path));
+
+    // Queues bounded by the number of messages, by their size, and by a
+    // size smaller than some of the messages
+    for (const auto &limits : std::vector<std::pair<std::size_t, std::size_t>>{
+           {1, 0}, {8, 0}, {1000, 64}, {1000, 10}})
+    {
+      log::Batch batch = logFile.QueryMessages();
+      batch.SetReadAhead(limits.first, limits.second);
+
+      // The shared data of the messages outlives the iteration, and their
+      // buffers are not reused while they are held
+      std::vector<std::shared_ptr<const char[]>> shared;
+      int count = 0;
+      for (const log::Message &msg : batch)
+      {
+        EXPECT_EQ(std::chrono::nanoseconds(count), msg.TimeReceived());
+        EXPECT_EQ(count % 2 ? "/odd" : "/even", msg.Topic());
+        EXPECT_EQ(std::string(static_cast<std::size_t>(count + 1), 'x'),
+                  msg.Data());
+        shared.push_back(msg.SharedData());
+        EXPECT_EQ(msg.DataView().data(), shared.back().get());
+        ++count;
+      }
+      EXPECT_EQ(100, count);
+      for (std::size_t i = 0; i < shared.size(); ++i)
+      {
+        EXPECT_EQ(std::string(i + 1, 'x'),
+                  std::string(shared[i].get(), i + 1));
+      }
+
+      // Stopping before the end of the batch
+      log::Batch::iterator iter = batch.begin();
+      ASSERT_NE(batch.end(), iter);
+      ++iter;
+      EXPECT_EQ(std::chrono::nanoseconds(1), iter->TimeReceived());
+    }
+
+    std::filesystem::remove(path);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Log, Preload)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_preload_" + testing::getRandomNumber() + ".tlog")).string();
+
+  for (const log::LogFormat format :
+       {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+  {
+    log::RecordOptions options;
+    options.SetFormat(format);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+      for (int i = 0; i < 100; ++i)
+      {
+        const std::string data(static_cast<std::size_t>(i + 1), 'x');
+        EXPECT_TRUE(logFile.InsertMessage(
+            std::chrono::nanoseconds(10 * i), i % 2 ? "/odd" : "/even",
+            "a.message.type", data.c_str(), data.size()));
+      }
+    }
+
+    auto logFile = std::make_unique<log::Log>();
+    ASSERT_TRUE(logFile->Open(path));
+
+    // The messages take 5050 bytes
+    log::Batch batch = logFile->QueryMessages();
+    EXPECT_FALSE(batch.Preload(5049));
+    EXPECT_FALSE(batch.Preloaded());
+    EXPECT_TRUE(batch.Preload(5050));
+    EXPECT_TRUE(batch.Preloaded());
+    EXPECT_TRUE(batch.Preload());
+
+    // The messages are the same in every pass, even once the log is closed
+    logFile.reset();
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      int count = 0;
+      for (const log::Message &msg : batch)
+      {
+        EXPECT_EQ(std::chrono::nanoseconds(10 * count), msg.TimeReceived());
+        EXPECT_EQ(count % 2 ? "/odd" : "/even", msg.Topic());
+        EXPECT_EQ("a.message.type", msg.Type());
+        EXPECT_EQ(std::string(static_cast<std::size_t>(count + 1), 'x'),
+                  msg.Data());
+
+        // Shared with the batch, without a copy
+        EXPECT_EQ(msg.DataView().data(), msg.SharedData().get());
+        ++count;
+      }
+      EXPECT_EQ(100, count);
+    }
+
+    log::Batch::iterator iter = batch.Find(std::chrono::nanoseconds(255));
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(std::chrono::nanoseconds(260), iter->TimeReceived());
+    ++iter;
+    EXPECT_EQ(std::chrono::nanoseconds(270), iter->TimeReceived());
+    EXPECT_EQ(batch.end(), batch.Find(std::chrono::nanoseconds(991)));
+
+    // Without preloading, the earlier messages are skipped
+    logFile = std::make_unique<log::Log>();
+    ASSERT_TRUE(logFile->Open(path));
+    log::Batch unloaded = logFile->QueryMessages();
+    iter = unloaded.Find(std::chrono::nanoseconds(255));
+    ASSERT_NE(unloaded.end(), iter);
+    EXPECT_EQ(std::chrono::nanoseconds(260), iter->TimeReceived());
+    EXPECT_EQ("/even", iter->Topic());
+
+    std::filesystem::remove(path);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Log, ParallelQuery)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_parallel_query_" + testing::getRandomNumber() + ".tlog")).string();
+
+  const std::vector<std::string> topics = {"/a", "/b", "/c", "/d", "/e"};
+  for (const log::LogFormat format :
+       {log::LogFormat::SQLITE, log::LogFormat::CHUNKED})
+  {
+    log::RecordOptions options;
+    options.SetFormat(format);
+    {
+      log::Log logFile;
+      ASSERT_TRUE(logFile.Open(path, std::ios_base::out, options));
+      for (int i = 0; i < 200; ++i)
+      {
+        // The first topic is much larger than the others
+        const std::size_t topic = static_cast<std::size_t>(i) % topics.size();
+        const std::string data(topic == 0 ? 1000 : 10, 'x');
+        EXPECT_TRUE(logFile.InsertMessage(
+            std::chrono::nanoseconds(i), topics[topic],
+            "a.message.type", data.c_str(), data.size()));
+      }
+    }
+
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path));
+
+    const log::TopicPattern query(std::regex("/[a-d]"),
+        log::QualifiedTimeRange(
+          log::QualifiedTime(std::chrono::nanoseconds(10)),
+          log::QualifiedTime(std::chrono::nanoseconds(189))));
+
+    for (const log::QueryPartitioning partitioning :
+         {log::QueryPartitioning::TOPIC, log::QueryPartitioning::TIME})
+    {
+      // Every message once, in time order within each partition
+      std::mutex mutex;
+      std::map<std::size_t, std::vector<int64_t>> times;
+      const std::size_t count = logFile.QueryMessagesParallel(query, 3,
+          [&](std::size_t _partition, const log::Message &_msg)
+          {
+            EXPECT_NE("/e", _msg.Topic());
+            std::lock_guard<std::mutex> lock(mutex);
+            times[_partition].push_back(_msg.TimeReceived().count());
+          });
+      EXPECT_EQ(3u, count);
+
+      std::vector<int64_t> all;
+      for (const auto &[partition, partitionTimes] : times)
+      {
+        EXPECT_LT(partition, count);
+        EXPECT_TRUE(std::is_sorted(
+              partitionTimes.begin(), partitionTimes.end()));
+        all.insert(all.end(), partitionTimes.begin(), partitionTimes.end());
+      }
+      std::sort(all.begin(), all.end());
+
+      std::vector<int64_t> expected;
+      for (const log::Message &msg : logFile.QueryMessages(query))
+        expected.push_back(msg.TimeReceived().count());
+      EXPECT_EQ(144u, expected.size());
+      EXPECT_EQ(expected, all);
+
+      // The same messages, merged in time order
+      std::vector<int64_t> merged;
+      for (const log::Message &msg :
+           logFile.QueryMessagesMerged(query, 3, partitioning))
+      {
+        merged.push_back(msg.TimeReceived().count());
+      }
+      EXPECT_EQ(expected, merged);
+    }
+
+    // The large topic gets a partition of its own when the log keeps the
+    // size of the topics
+    if (format == log::LogFormat::SQLITE)
+    {
+      std::map<std::size_t, std::set<std::string>> partitionTopics;
+      std::mutex mutex;
+      logFile.QueryMessagesParallel(log::AllTopics(), 2,
+          [&](std::size_t _partition, const log::Message &_msg)
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            partitionTopics[_partition].insert(_msg.Topic());
+          });
+      ASSERT_EQ(2u, partitionTopics.size());
+      EXPECT_EQ(std::set<std::string>{"/a"}, partitionTopics[0]);
+      EXPECT_EQ(4u, partitionTopics[1].size());
+    }
+
+    std::filesystem::remove(path);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Log, QueryPlanUsesTopicTimeIndex)
+{
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
+
+  const std::string data("data");
+  for (const std::string topic : {"/a", "/b", "/c"})
+  {
+    EXPECT_TRUE(logFile.InsertMessage(
+        1s, topic, "a.message.type", data.c_str(), data.size()));
+  }
+
+  const log::Descriptor *desc = logFile.Descriptor();
+  ASSERT_NE(nullptr, desc);
+  EXPECT_TRUE(desc->TopicTimeIndexed());
+
+  const log::QualifiedTimeRange range(
+      log::QualifiedTime(1s), log::QualifiedTime(2s));
+  const auto usesIndex = [](const std::vector<std::string> &_plan)
+  {
+    bool found = false;
+    for (const std::string &step : _plan)
+    {
+      found = found ||
+        step.find("idx_topic_time_recv") != std::string::npos;
+      // The messages must not be sorted after they are read
+      EXPECT_EQ(std::string::npos, step.find("TEMP B-TREE")) << step;
+    }
+    return found;
+  };
+
+  EXPECT_TRUE(usesIndex(logFile.QueryPlan(log::TopicList("/b", range))));
+  EXPECT_TRUE(usesIndex(logFile.QueryPlan(
+      log::TopicList(std::set<std::string>{"/a", "/c"}, range))));
+  EXPECT_TRUE(usesIndex(logFile.QueryPlan(
+      log::TopicPattern(std::regex("/[ab]")))));
+
+  // The messages of several topics are still ordered by time
+  std::vector<std::string> topics;
+  for (const log::Message &msg : logFile.QueryMessages(
+         log::TopicList(std::set<std::string>{"/a", "/c"}, range)))
+  {
+    topics.push_back(msg.Topic());
+  }
+  EXPECT_EQ(2u, topics.size());
+}
+
+//////////////////////////////////////////////////
+TEST(Log, QueryPlanManyTopicsUsesTimeIndex)
+{
+  log::Log logFile;
+  ASSERT_TRUE(logFile.Open(":memory:", std::ios_base::out));
+
+  // More topics than the queries merged from one SELECT per topic
+  const std::string data("data");
+  std::set<std::string> topics;
+  for (int i = 0; i < 100; ++i)
+  {
+    const std::string topic = "/topic" + std::to_string(i);
+    topics.insert(topic);
+    EXPECT_TRUE(logFile.InsertMessage(
+        std::chrono::seconds(i), topic, "a.message.type", data.c_str(),
+        data.size()));
+  }
+
+  // A query from a given time, as in a seek of the playback, starts reading
+  // at that time and doesn't sort the rest of the log
+  const log::QualifiedTimeRange range(
+      log::QualifiedTime(50s),
+      log::QualifiedTime(std::chrono::nanoseconds::max()));
+  bool usesIndex = false;
+  for (const std::string &step :
+       logFile.QueryPlan(log::TopicList(topics, range)))
+  {
+    usesIndex = usesIndex || step.find("idx_time_recv") != std::string::npos;
+    EXPECT_EQ(std::string::npos, step.find("TEMP B-TREE")) << step;
+  }
+  EXPECT_TRUE(usesIndex);
+
+  std::chrono::nanoseconds last(0);
+  int count = 0;
+  for (const log::Message &msg :
+       logFile.QueryMessages(log::TopicList(topics, range)))
+  {
+    EXPECT_LE(last, msg.TimeReceived());
+    last = msg.TimeReceived();
+    ++count;
+  }
+  EXPECT_EQ(50, count);
+}
+
+//////////////////////////////////////////////////
+TEST(Log, Migrate)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_migrate_" + testing::getRandomNumber() + ".tlog")).string();
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path, std::ios_base::out));
+  }
+
+  // A log with the latest schema is left as it is
+  EXPECT_TRUE(log::Log::Migrate(path));
+  {
+    log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path));
+    EXPECT_EQ("0.4.0", logFile.Version());
+  }
+  std::filesystem::remove(path);
+
+  EXPECT_FALSE(log::Log::Migrate(path));
 }
 
 //////////////////////////////////////////////////
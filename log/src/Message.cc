@@ -16,7 +16,10 @@
 */
 
 #include <chrono>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include "gz/transport/log/Message.hh"
 
@@ -35,6 +38,9 @@ class gz::transport::log::MessagePrivate
   /// \brief Length of data
   public: std::size_t dataLen = 0;
 
+  /// \brief Keeps data alive, if it can be shared
+  public: std::shared_ptr<const void> owner;
+
   /// \brief pointer to topic string
   public: const char *topic = nullptr;
 
@@ -70,6 +76,17 @@ Message::Message(const std::chrono::nanoseconds &_timeRecv,
   this->dataPtr->topicLen = _topicLen;
 }
 
+//////////////////////////////////////////////////
+Message::Message(const std::chrono::nanoseconds &_timeRecv,
+            const std::shared_ptr<const void> &_owner,
+            const void *_data, std::size_t _dataLen,
+            const char *_type, std::size_t _typeLen,
+            const char *_topic, std::size_t _topicLen)
+  : Message(_timeRecv, _data, _dataLen, _type, _typeLen, _topic, _topicLen)
+{
+  this->dataPtr->owner = _owner;
+}
+
 //////////////////////////////////////////////////
 Message::~Message()
 {
@@ -82,6 +99,26 @@ std::string Message::Data() const
       this->dataPtr->dataLen);
 }
 
+//////////////////////////////////////////////////
+std::string_view Message::DataView() const
+{
+  return std::string_view(reinterpret_cast<const char *>(this->dataPtr->data),
+      this->dataPtr->dataLen);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const char[]> Message::SharedData() const
+{
+  const char *data = reinterpret_cast<const char *>(this->dataPtr->data);
+  if (this->dataPtr->owner)
+    return std::shared_ptr<const char[]>(this->dataPtr->owner, data);
+
+  std::shared_ptr<char[]> copy(new char[this->dataPtr->dataLen]);
+  if (this->dataPtr->dataLen > 0)
+    std::memcpy(copy.get(), data, this->dataPtr->dataLen);
+  return copy;
+}
+
 //////////////////////////////////////////////////
 std::string Message::Type() const
 {
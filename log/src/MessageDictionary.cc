@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/config.hh"
+
+#ifdef HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+#include "Console.hh"
+#include "MessageDictionary.hh"
+
+using namespace gz::transport;
+using namespace gz::transport::log;
+
+namespace
+{
+  /// \brief Maximum size of a dictionary (bytes), the default of zstd.
+  const std::size_t kMaxDictionarySize = 112640;
+
+  /// \brief Minimum size of a dictionary (bytes).
+  const std::size_t kMinDictionarySize = 1024;
+
+  /// \brief Share of the size of the training messages used for the
+  /// dictionary. zstd recommends about a hundred times more training data
+  /// than the dictionary, this leaves room for topics of few messages.
+  const std::size_t kSamplesPerDictionaryByte = 10;
+
+#ifdef HAVE_ZSTD
+  /// \brief Frees a zstd context.
+  struct ContextDeleter
+  {
+    void operator()(ZSTD_CCtx *_context) const
+    {
+      ZSTD_freeCCtx(_context);
+    }
+
+    void operator()(ZSTD_DCtx *_context) const
+    {
+      ZSTD_freeDCtx(_context);
+    }
+
+    void operator()(ZSTD_CDict *_dictionary) const
+    {
+      ZSTD_freeCDict(_dictionary);
+    }
+
+    void operator()(ZSTD_DDict *_dictionary) const
+    {
+      ZSTD_freeDDict(_dictionary);
+    }
+  };
+#endif
+}
+
+/// \brief Private implementation
+class gz::transport::log::MessageDictionary::Implementation
+{
+  /// \brief The dictionary as it is stored
+  public: std::string data;
+
+  /// \brief Id of the first message compressed with the dictionary
+  public: int64_t firstMessageId = 0;
+
+  /// \brief Compression level of the messages
+  public: int level = 0;
+
+#ifdef HAVE_ZSTD
+  /// \brief Digested dictionary to compress, created the first time a
+  /// message is compressed
+  public: std::unique_ptr<ZSTD_CDict, ContextDeleter> compression;
+
+  /// \brief Context to compress the messages
+  public: std::unique_ptr<ZSTD_CCtx, ContextDeleter> compressionContext;
+
+  /// \brief Digested dictionary to decompress, which the decompression
+  /// contexts of every thread only read
+  public: std::unique_ptr<ZSTD_DDict, ContextDeleter> decompression;
+#endif
+};
+
+//////////////////////////////////////////////////
+MessageDictionary::MessageDictionary()
+  : dataPtr(new Implementation)
+{
+}
+
+//////////////////////////////////////////////////
+MessageDictionary::~MessageDictionary() = default;
+
+//////////////////////////////////////////////////
+bool MessageDictionary::Supported()
+{
+#ifdef HAVE_ZSTD
+  return true;
+#else
+  return false;
+#endif
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<MessageDictionary> MessageDictionary::Train(
+    const std::string &_samples, const std::vector<std::size_t> &_sizes,
+    const int _level)
+{
+#ifdef HAVE_ZSTD
+  const std::size_t capacity = std::clamp(
+      _samples.size() / kSamplesPerDictionaryByte, kMinDictionarySize,
+      kMaxDictionarySize);
+
+  std::string data(capacity, '\0');
+  const std::size_t size = ZDICT_trainFromBuffer(&data[0], data.size(),
+      _samples.data(), _sizes.data(), static_cast<unsigned>(_sizes.size()));
+  if (ZDICT_isError(size))
+  {
+    LDBG("Failed to train a dictionary: " << ZDICT_getErrorName(size)
+        << "\n");
+    return nullptr;
+  }
+  data.resize(size);
+
+  std::unique_ptr<MessageDictionary> dictionary = Load(data.data(),
+      data.size(), 0);
+  if (!dictionary->dataPtr->decompression)
+    return nullptr;
+  dictionary->dataPtr->level = _level;
+  return dictionary;
+#else
+  (void)_samples;
+  (void)_sizes;
+  (void)_level;
+  return nullptr;
+#endif
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<MessageDictionary> MessageDictionary::Load(
+    const void *_data, const std::size_t _size, const int64_t _firstMessageId)
+{
+  std::unique_ptr<MessageDictionary> dictionary(new MessageDictionary);
+  dictionary->dataPtr->data.assign(static_cast<const char *>(_data), _size);
+  dictionary->dataPtr->firstMessageId = _firstMessageId;
+#ifdef HAVE_ZSTD
+  dictionary->dataPtr->decompression.reset(ZSTD_createDDict(
+      dictionary->dataPtr->data.data(), dictionary->dataPtr->data.size()));
+  if (!dictionary->dataPtr->decompression)
+    LERR("Failed to load a message dictionary\n");
+#else
+  LERR("Messages compressed with a dictionary need zstd, which this build "
+       "doesn't have\n");
+#endif
+  return dictionary;
+}
+
+//////////////////////////////////////////////////
+const std::string &MessageDictionary::Data() const
+{
+  return this->dataPtr->data;
+}
+
+//////////////////////////////////////////////////
+int64_t MessageDictionary::FirstMessageId() const
+{
+  return this->dataPtr->firstMessageId;
+}
+
+//////////////////////////////////////////////////
+void MessageDictionary::SetFirstMessageId(const int64_t _id)
+{
+  this->dataPtr->firstMessageId = _id;
+}
+
+//////////////////////////////////////////////////
+bool MessageDictionary::Compress(const void *_data, const std::size_t _size,
+                                 std::string &_out)
+{
+#ifdef HAVE_ZSTD
+  if (!this->dataPtr->compression)
+  {
+    this->dataPtr->compression.reset(ZSTD_createCDict(
+        this->dataPtr->data.data(), this->dataPtr->data.size(),
+        this->dataPtr->level));
+    this->dataPtr->compressionContext.reset(ZSTD_createCCtx());
+    if (!this->dataPtr->compression || !this->dataPtr->compressionContext)
+      return false;
+  }
+
+  // The frames keep the size of the message, see Decompress()
+  _out.resize(ZSTD_compressBound(_size));
+  const std::size_t written = ZSTD_compress_usingCDict(
+      this->dataPtr->compressionContext.get(), &_out[0], _out.size(),
+      _data, _size, this->dataPtr->compression.get());
+  if (ZSTD_isError(written))
+    return false;
+  _out.resize(written);
+  return true;
+#else
+  (void)_data;
+  (void)_size;
+  (void)_out;
+  return false;
+#endif
+}
+
+//////////////////////////////////////////////////
+bool MessageDictionary::Decompress(const void *_data, const std::size_t _size,
+                                   std::shared_ptr<char[]> &_out,
+                                   std::size_t &_outSize) const
+{
+#ifdef HAVE_ZSTD
+  // Iterators read the messages on several threads, each with its context
+  thread_local std::unique_ptr<ZSTD_DCtx, ContextDeleter> context(
+      ZSTD_createDCtx());
+  if (!context || !this->dataPtr->decompression)
+    return false;
+
+  const unsigned long long size = ZSTD_getFrameContentSize(_data, _size);
+  if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN)
+    return false;
+
+  _out.reset(new char[std::max<std::size_t>(size, 1)]);
+  const std::size_t read = ZSTD_decompress_usingDDict(context.get(),
+      _out.get(), size, _data, _size, this->dataPtr->decompression.get());
+  if (ZSTD_isError(read) || read != size)
+    return false;
+  _outSize = read;
+  return true;
+#else
+  (void)_data;
+  (void)_size;
+  (void)_out;
+  (void)_outSize;
+  return false;
+#endif
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_LOG_MESSAGEDICTIONARY_HH_
+#define GZ_TRANSPORT_LOG_MESSAGEDICTIONARY_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "Descriptor.hh"
+
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  /// \brief Zstd dictionary of a topic of a SQLite log. Each message of the
+  /// topic is compressed on its own with the dictionary, so that it can be
+  /// read without the messages before it, and small messages, which share
+  /// most of their structure, still compress well.
+  /// \internal
+  class MessageDictionary
+  {
+    /// \brief Destructor.
+    public: ~MessageDictionary();
+
+    /// \brief Whether dictionaries are available in this build.
+    /// \return True if the build has zstd.
+    public: static bool Supported();
+
+    /// \brief Train a dictionary from the first messages of a topic.
+    /// \param[in] _samples The messages, one after the other.
+    /// \param[in] _sizes Size of each message.
+    /// \param[in] _level Compression level, or 0 for the default.
+    /// \return The dictionary, or nullptr if the messages are too few or
+    /// too small to train one.
+    public: static std::unique_ptr<MessageDictionary> Train(
+        const std::string &_samples, const std::vector<std::size_t> &_sizes,
+        int _level);
+
+    /// \brief Load a dictionary stored in a log. The messages of an invalid
+    /// dictionary, or of any dictionary in a build without zstd, fail to
+    /// decompress.
+    /// \param[in] _data The dictionary.
+    /// \param[in] _size Size of the dictionary.
+    /// \param[in] _firstMessageId Id of the first message compressed with
+    /// it.
+    /// \return The dictionary.
+    public: static std::unique_ptr<MessageDictionary> Load(
+        const void *_data, std::size_t _size, int64_t _firstMessageId);
+
+    /// \brief Get the dictionary as it is stored in a log.
+    /// \return The dictionary.
+    public: const std::string &Data() const;
+
+    /// \brief Get the id of the first message compressed with the
+    /// dictionary. The messages of the topic before it are stored as they
+    /// are.
+    /// \return The id.
+    public: int64_t FirstMessageId() const;
+
+    /// \brief Set the id of the first message compressed with the
+    /// dictionary.
+    /// \param[in] _id The id.
+    public: void SetFirstMessageId(int64_t _id);
+
+    /// \brief Compress a message. Not thread safe.
+    /// \param[in] _data The serialized message.
+    /// \param[in] _size Size of the message.
+    /// \param[out] _out The compressed message.
+    /// \return False if the message could not be compressed.
+    public: bool Compress(const void *_data, std::size_t _size,
+                          std::string &_out);
+
+    /// \brief Decompress a message. Can be called by several threads.
+    /// \param[in] _data The compressed message.
+    /// \param[in] _size Size of the compressed message.
+    /// \param[out] _out The serialized message.
+    /// \param[out] _outSize Size of the serialized message.
+    /// \return False if the message is corrupt.
+    public: bool Decompress(const void *_data, std::size_t _size,
+                            std::shared_ptr<char[]> &_out,
+                            std::size_t &_outSize) const;
+
+    /// \brief Constructor, see Train() and Load().
+    private: MessageDictionary();
+
+    /// \internal Implementation of this class
+    private: class Implementation;
+
+    /// \internal Pointer to the implementation of this class
+    private: std::unique_ptr<Implementation> dataPtr;
+  };
+
+  /// \brief Dictionaries of the topics of a SQLite log. The map handed to
+  /// the iterators of a query is never modified, so they can share it.
+  /// \internal
+  using MessageDictionaries =
+    std::unordered_map<TopicKey, std::unique_ptr<MessageDictionary>>;
+}
+}
+}
+}
+
+#endif
@@ -16,6 +16,7 @@
 */
 
 #include <chrono>
+#include <memory>
 #include <string>
 
 #include "gz/transport/log/Log.hh"
@@ -29,6 +30,7 @@ TEST(Message, DefaultConstructor)
 {
   transport::log::Message msg;
   EXPECT_EQ(std::string(""), msg.Data());
+  EXPECT_TRUE(msg.DataView().empty());
   EXPECT_EQ(std::string(""), msg.Topic());
   EXPECT_EQ(std::string(""), msg.Type());
   EXPECT_EQ(0ns, msg.TimeReceived());
@@ -48,7 +50,39 @@ TEST(Message, DataConstructor)
       topic.c_str(), topic.size());
 
   EXPECT_EQ(data, msg.Data());
+  EXPECT_EQ(data, msg.DataView());
+  EXPECT_EQ(data.c_str(), msg.DataView().data());
   EXPECT_EQ(msgType, msg.Type());
   EXPECT_EQ(topic, msg.Topic());
   EXPECT_EQ(goldenTime, msg.TimeReceived());
+
+  // Borrowed data is copied to be shared
+  std::shared_ptr<const char[]> shared = msg.SharedData();
+  ASSERT_NE(nullptr, shared);
+  EXPECT_NE(data.c_str(), shared.get());
+  EXPECT_EQ(data, std::string(shared.get(), data.size()));
+}
+
+//////////////////////////////////////////////////
+TEST(Message, OwnedDataConstructor)
+{
+  auto data = std::make_shared<std::string>("SomeData");
+  std::string topic("/a/topic");
+  std::string msgType("msg.type");
+
+  std::shared_ptr<const char[]> shared;
+  {
+    transport::log::Message msg(1ns, data,
+        data->c_str(), data->size(),
+        msgType.c_str(), msgType.size(),
+        topic.c_str(), topic.size());
+    EXPECT_EQ(*data, msg.Data());
+    EXPECT_EQ(topic, msg.Topic());
+
+    // The data is shared with its owner, and kept alive
+    shared = msg.SharedData();
+    EXPECT_EQ(data->c_str(), shared.get());
+  }
+  EXPECT_EQ(2, data.use_count());
+  EXPECT_EQ("SomeData", std::string(shared.get(), 8));
 }
@@ -17,7 +17,13 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "Console.hh"
@@ -36,12 +42,44 @@ MsgIterPrivate::MsgIterPrivate()
 //////////////////////////////////////////////////
 MsgIterPrivate::MsgIterPrivate(
     const std::shared_ptr<raii_sqlite3::Database> &_db,
-    const std::shared_ptr<std::vector<SqlStatement>> &_statements)
-  : db(_db), statements(_statements)
+    const std::shared_ptr<std::vector<SqlStatement>> &_statements,
+    const std::shared_ptr<const MessageDictionaries> &_dictionaries)
+  : db(_db), statements(_statements), dictionaries(_dictionaries)
 {
   PrepareNextStatement();
 }
 
+//////////////////////////////////////////////////
+MsgIterPrivate::MsgIterPrivate(
+    std::unique_ptr<ChunkedLogCursor> &&_cursor)  // NOLINT(build/c++11)
+  : cursor(std::move(_cursor))
+{
+}
+
+//////////////////////////////////////////////////
+MsgIterPrivate::MsgIterPrivate(const std::shared_ptr<
+    const std::vector<std::unique_ptr<BatchPrivate>>> &_parts,
+    const bool _merge)
+  : parts(_parts), merge(_merge)
+{
+}
+
+//////////////////////////////////////////////////
+MsgIterPrivate::MsgIterPrivate(
+    std::unique_ptr<MsgIterPrivate> &&_source,  // NOLINT(build/c++11)
+    const std::size_t _messages, const std::size_t _bytes)
+  : readAhead(new ReadAhead(std::move(_source), _messages, _bytes))
+{
+}
+
+//////////////////////////////////////////////////
+MsgIterPrivate::MsgIterPrivate(
+    const std::shared_ptr<const PreloadedBatch> &_preloaded,
+    const std::size_t _index)
+  : preloaded(_preloaded), preloadedIndex(_index)
+{
+}
+
 //////////////////////////////////////////////////
 MsgIterPrivate::~MsgIterPrivate()
 {
@@ -70,23 +108,41 @@ bool MsgIterPrivate::PrepareNextStatement()
   }
 
   // Bind the parameters supplied with the statment
+  if (!BindParameters(*nextStatement, query))
+    return false;
+
+  // Show which indexes are used by the query
+  if (__verbosity >= 4)
+  {
+    for (const std::string &step : QueryPlan(*(this->db), query))
+      LDBG("Query plan: " << step << "\n");
+  }
+
+  this->statement = std::move(nextStatement);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool MsgIterPrivate::BindParameters(raii_sqlite3::Statement &_statement,
+    const SqlStatement &_query)
+{
   int i = 1;
   int returnCode;
-  for (const SqlParameter &param : query.parameters)
+  for (const SqlParameter &param : _query.parameters)
   {
     switch (param.Type())
     {
       case SqlParameter::ParamType::TEXT:
-        returnCode = sqlite3_bind_text(nextStatement->Handle(), i,
+        returnCode = sqlite3_bind_text(_statement.Handle(), i,
           param.QueryText()->c_str(), param.QueryText()->size(),
           SQLITE_STATIC);
         break;
       case SqlParameter::ParamType::INTEGER:
-        returnCode = sqlite3_bind_int64(nextStatement->Handle(), i,
+        returnCode = sqlite3_bind_int64(_statement.Handle(), i,
           *param.QueryInteger());
         break;
       case SqlParameter::ParamType::REAL:
-        returnCode = sqlite3_bind_double(nextStatement->Handle(), i,
+        returnCode = sqlite3_bind_double(_statement.Handle(), i,
           *param.QueryReal());
         break;
       default:
@@ -95,19 +151,134 @@ bool MsgIterPrivate::PrepareNextStatement()
     if (returnCode != SQLITE_OK)
     {
       LERR("Failed to query messages: "<< sqlite3_errmsg(
-        this->db->Handle()) << "\n");
+        sqlite3_db_handle(_statement.Handle())) << "\n");
       return false;
     }
     ++i;
   }
-
-  this->statement = std::move(nextStatement);
   return true;
 }
 
+//////////////////////////////////////////////////
+std::vector<std::string> MsgIterPrivate::QueryPlan(
+    raii_sqlite3::Database &_db, const SqlStatement &_query)
+{
+  std::vector<std::string> plan;
+
+  raii_sqlite3::Statement statement(_db,
+      "EXPLAIN QUERY PLAN " + _query.statement);
+  if (!statement || !BindParameters(statement, _query))
+  {
+    LERR("Failed to explain query: " << sqlite3_errmsg(_db.Handle()) << "\n");
+    return plan;
+  }
+
+  // The fourth column describes the step
+  while (sqlite3_step(statement.Handle()) == SQLITE_ROW)
+  {
+    const unsigned char *detail = sqlite3_column_text(statement.Handle(), 3);
+    if (detail)
+      plan.emplace_back(reinterpret_cast<const char *>(detail));
+  }
+  return plan;
+}
+
 //////////////////////////////////////////////////
 void MsgIterPrivate::StepStatement()
 {
+  if (this->readAhead)
+  {
+    // The message shares the data of the entry, which can only be reused
+    // once nobody else holds it
+    this->message.reset();
+    if (this->readAhead->Next(this->readAheadEntry))
+    {
+      const ReadAheadEntry &entry = *this->readAheadEntry;
+      this->message.reset(new Message(
+            entry.time, entry.data, entry.data.get(), entry.size,
+            entry.type.c_str(), entry.type.size(),
+            entry.topic.c_str(), entry.topic.size()));
+    }
+    else
+    {
+      // Out of data
+      this->readAhead.reset();
+    }
+    return;
+  }
+
+  if (this->preloaded)
+  {
+    if (this->preloadedIndex < this->preloaded->entries.size())
+    {
+      // The message borrows from the batch, which the iterator shares
+      const PreloadedBatch::Entry &entry =
+        this->preloaded->entries[this->preloadedIndex++];
+      const TopicKey &key = this->preloaded->topics[entry.topic];
+      this->message.reset(new Message(
+            entry.time, this->preloaded,
+            this->preloaded->data.data() + entry.offset, entry.size,
+            key.type.c_str(), key.type.size(),
+            key.topic.c_str(), key.topic.size()));
+    }
+    else
+    {
+      // Out of data
+      this->preloaded.reset();
+    }
+    return;
+  }
+
+  if (this->parts && this->merge)
+  {
+    this->StepMerged();
+    return;
+  }
+
+  while (this->parts)
+  {
+    if (!this->part)
+    {
+      if (this->partIndex >= this->parts->size())
+      {
+        // Out of data
+        this->parts.reset();
+        return;
+      }
+      this->part = (*this->parts)[this->partIndex++]->CreateIterator();
+    }
+
+    // The message borrows from the iterator of the file, which stays on it
+    // until the next step.
+    this->part->StepStatement();
+    if (this->part->message)
+    {
+      this->message = std::move(this->part->message);
+      return;
+    }
+    if (!this->part->statement && !this->part->cursor)
+      this->part.reset();
+  }
+
+  if (this->cursor)
+  {
+    if (this->cursor->Next())
+    {
+      const TopicKey &key = this->cursor->Topic();
+      this->message.reset(new Message(
+            this->cursor->Time(),
+            this->cursor->Data(), this->cursor->Size(),
+            key.type.c_str(), key.type.size(),
+            key.topic.c_str(), key.topic.size()));
+    }
+    else
+    {
+      // Out of data
+      this->cursor.reset();
+    }
+    return;
+  }
+
   if (this->statement)
   {
     // Get the results from the statement
@@ -141,11 +312,61 @@ void MsgIterPrivate::StepStatement()
       const void *data = sqlite3_column_blob(this->statement->Handle(), 4);
       std::size_t numData = sqlite3_column_bytes(this->statement->Handle(), 4);
 
-      this->message.reset(new Message(
-            timeRecv,
-            data, numData,
-            reinterpret_cast<const char*>(type), numType,
-            reinterpret_cast<const char*>(topic), numTopic));
+      // The messages of a topic with a dictionary are compressed from the
+      // first message id of the dictionary on
+      const MessageDictionary *dictionary = nullptr;
+      if (this->dictionaries && !this->dictionaries->empty())
+      {
+        const std::string_view topicView(
+            reinterpret_cast<const char*>(topic), numTopic);
+        const std::string_view typeView(
+            reinterpret_cast<const char*>(type), numType);
+        if (topicView != this->lastTopic.topic ||
+            typeView != this->lastTopic.type)
+        {
+          this->lastTopic.topic = topicView;
+          this->lastTopic.type = typeView;
+          const auto found = this->dictionaries->find(this->lastTopic);
+          this->lastDictionary = found == this->dictionaries->end() ?
+            nullptr : found->second.get();
+        }
+        const sqlite_int64 id = sqlite3_column_int64(
+            this->statement->Handle(), 0);
+        if (this->lastDictionary &&
+            id >= this->lastDictionary->FirstMessageId())
+        {
+          dictionary = this->lastDictionary;
+        }
+      }
+
+      if (!dictionary)
+      {
+        this->message.reset(new Message(
+              timeRecv,
+              data, numData,
+              reinterpret_cast<const char*>(type), numType,
+              reinterpret_cast<const char*>(topic), numTopic));
+      }
+      else
+      {
+        // The message owns its decompressed data
+        std::shared_ptr<char[]> decompressed;
+        std::size_t numDecompressed = 0;
+        if (dictionary->Decompress(data, numData, decompressed,
+              numDecompressed))
+        {
+          this->message.reset(new Message(
+                timeRecv, decompressed,
+                decompressed.get(), numDecompressed,
+                reinterpret_cast<const char*>(type), numType,
+                reinterpret_cast<const char*>(topic), numTopic));
+        }
+        else
+        {
+          LERR("Failed to decompress a message of ["
+              << this->lastTopic.topic << "], skipping it\n");
+        }
+      }
     }
     else
     {
@@ -161,6 +382,185 @@ void MsgIterPrivate::StepStatement()
   }
 }
 
+//////////////////////////////////////////////////
+void MsgIterPrivate::StepMerged()
+{
+  // The heap is ordered by time, then by index, so that messages received
+  // at the same time are given in partition order. std::push_heap and
+  // std::pop_heap keep the largest element first, so the comparison is
+  // reversed.
+  const auto later = [this](const std::size_t _a, const std::size_t _b)
+  {
+    const auto timeA = this->merged[_a]->message->TimeReceived();
+    const auto timeB = this->merged[_b]->message->TimeReceived();
+    return timeA > timeB || (timeA == timeB && _a > _b);
+  };
+
+  if (this->merged.empty())
+  {
+    // Get the first message of every part
+    for (const auto &batch : *this->parts)
+    {
+      this->merged.push_back(batch->CreateIterator());
+      if (NextMessage(*this->merged.back()))
+        this->mergedHeap.push_back(this->merged.size() - 1);
+    }
+    std::make_heap(this->mergedHeap.begin(), this->mergedHeap.end(), later);
+  }
+  else if (NextMessage(*this->merged[this->mergedIndex]))
+  {
+    // The message taken last borrows from its iterator, which is stepped
+    // only now
+    this->mergedHeap.push_back(this->mergedIndex);
+    std::push_heap(this->mergedHeap.begin(), this->mergedHeap.end(), later);
+  }
+
+  // The other iterators hold the message they are at until it's taken
+  if (this->mergedHeap.empty())
+  {
+    // Out of data
+    this->merged.clear();
+    this->parts.reset();
+    return;
+  }
+
+  std::pop_heap(this->mergedHeap.begin(), this->mergedHeap.end(), later);
+  this->mergedIndex = this->mergedHeap.back();
+  this->mergedHeap.pop_back();
+  this->message = std::move(this->merged[this->mergedIndex]->message);
+}
+
+//////////////////////////////////////////////////
+bool MsgIterPrivate::NextMessage(MsgIterPrivate &_iter)
+{
+  // A step may only move to the next statement, without a message
+  _iter.message.reset();
+  while (!_iter.message && !Done(_iter))
+    _iter.StepStatement();
+  return _iter.message != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool MsgIterPrivate::Done(const MsgIterPrivate &_iter)
+{
+  return !_iter.statement && !_iter.cursor && !_iter.parts &&
+    !_iter.readAhead && !_iter.preloaded;
+}
+
+//////////////////////////////////////////////////
+ReadAhead::ReadAhead(
+    std::unique_ptr<MsgIterPrivate> &&_source,  // NOLINT(build/c++11)
+    const std::size_t _messages, const std::size_t _bytes)
+  : source(std::move(_source)),
+    maxMessages(std::max<std::size_t>(_messages, 1)),
+    maxBytes(_bytes)
+{
+  this->thread = std::thread(&ReadAhead::Run, this);
+}
+
+//////////////////////////////////////////////////
+ReadAhead::~ReadAhead()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->takeCondVar.notify_one();
+  this->thread.join();
+}
+
+//////////////////////////////////////////////////
+bool ReadAhead::Next(std::unique_ptr<ReadAheadEntry> &_entry)
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  if (_entry)
+    this->recycled.push_back(std::move(_entry));
+
+  this->readCondVar.wait(lock, [this]
+      {
+        return !this->queue.empty() || this->done;
+      });
+  if (this->queue.empty())
+    return false;
+
+  _entry = std::move(this->queue.front());
+  this->queue.pop_front();
+  this->queueBytes -= _entry->size;
+  lock.unlock();
+
+  this->takeCondVar.notify_one();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void ReadAhead::Run()
+{
+  while (true)
+  {
+    std::unique_ptr<ReadAheadEntry> entry;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->takeCondVar.wait(lock, [this]
+          {
+            return this->stop || (this->queue.size() < this->maxMessages &&
+              (this->maxBytes == 0 || this->queue.empty() ||
+               this->queueBytes < this->maxBytes));
+          });
+      if (this->stop)
+        return;
+
+      if (!this->recycled.empty())
+      {
+        entry = std::move(this->recycled.back());
+        this->recycled.pop_back();
+      }
+    }
+
+    // Read the next message without holding the lock
+    const bool end = !MsgIterPrivate::NextMessage(*this->source);
+
+    if (!end)
+    {
+      if (!entry)
+        entry.reset(new ReadAheadEntry);
+
+      // The buffers of a recycled entry are reused, unless the data is
+      // still shared with someone else, e.g. the transport
+      const Message &msg = *this->source->message;
+      const std::string_view data = msg.DataView();
+      if (!entry->data || entry->data.use_count() > 1 ||
+          entry->capacity < data.size())
+      {
+        entry->capacity = std::max(data.size(), entry->capacity);
+        entry->data.reset(new char[entry->capacity]);
+      }
+      if (!data.empty())
+        std::memcpy(entry->data.get(), data.data(), data.size());
+      entry->size = data.size();
+      entry->time = msg.TimeReceived();
+      entry->type = msg.Type();
+      entry->topic = msg.Topic();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (end)
+      {
+        this->done = true;
+      }
+      else
+      {
+        this->queueBytes += entry->size;
+        this->queue.push_back(std::move(entry));
+      }
+    }
+    this->readCondVar.notify_one();
+
+    if (end)
+      return;
+  }
+}
+
 //////////////////////////////////////////////////
 MsgIter::MsgIter()
   : dataPtr(new MsgIterPrivate)
@@ -225,7 +625,11 @@ bool MsgIter::operator==(const MsgIter &_other) const
 {
   // TODO(anyone) this won't work once this class has a proper copy constructor
   // It's only good enough to compare this with an empty iterator
-  return this->dataPtr->statement.get() == _other.dataPtr->statement.get();
+  return this->dataPtr->statement.get() == _other.dataPtr->statement.get() &&
+    this->dataPtr->cursor.get() == _other.dataPtr->cursor.get() &&
+    this->dataPtr->parts.get() == _other.dataPtr->parts.get() &&
+    this->dataPtr->readAhead.get() == _other.dataPtr->readAhead.get() &&
+    this->dataPtr->preloaded.get() == _other.dataPtr->preloaded.get();
 }
 
 //////////////////////////////////////////////////
@@ -18,11 +18,21 @@
 #ifndef GZ_TRANSPORT_LOG_MSGITERPRIVATE_HH_
 #define GZ_TRANSPORT_LOG_MSGITERPRIVATE_HH_
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "gz/transport/log/Message.hh"
 #include "gz/transport/log/SqlStatement.hh"
+#include "BatchPrivate.hh"
+#include "ChunkedLog.hh"
+#include "MessageDictionary.hh"
 #include "raii-sqlite3.hh"
 
 using namespace gz::transport;
@@ -37,6 +47,31 @@ namespace log
 // Inline bracket to help doxygen filtering.
 inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
 {
+  class ReadAhead;
+
+  /// \brief A message read ahead of an iterator, which owns its data.
+  struct ReadAheadEntry
+  {
+    /// \brief Time the message was received
+    std::chrono::nanoseconds time;
+
+    /// \brief Serialized message. It is shared with the users of
+    /// Message::SharedData(), and only reused once they released it.
+    std::shared_ptr<char[]> data;
+
+    /// \brief Size of the serialized message
+    std::size_t size = 0;
+
+    /// \brief Capacity of data
+    std::size_t capacity = 0;
+
+    /// \brief Name of the message type
+    std::string type;
+
+    /// \brief Name of the topic
+    std::string topic;
+  };
+
   class MsgIterPrivate
   {
     /// \brief constructor
@@ -46,8 +81,42 @@ inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
     /// \param[in] _db Shared reference to a database
     /// \param[in] _statements A set of SQL statements that this message will
     /// iterate through
+    /// \param[in] _dictionaries Dictionaries of the compressed topics of the
+    /// database, or nullptr if it has none
     public: MsgIterPrivate(const std::shared_ptr<raii_sqlite3::Database> &_db,
-        const std::shared_ptr<std::vector<SqlStatement>> &_statements);
+        const std::shared_ptr<std::vector<SqlStatement>> &_statements,
+        const std::shared_ptr<const MessageDictionaries> &_dictionaries =
+          nullptr);
+
+    /// \brief constructor
+    /// \param[in] _cursor Cursor over the messages of a chunked log
+    public: explicit MsgIterPrivate(
+        std::unique_ptr<ChunkedLogCursor> &&_cursor);  // NOLINT
+
+    /// \brief constructor
+    /// \param[in] _parts Batches of the files of a split recording, or of
+    /// the partitions of a query
+    /// \param[in] _merge True to merge the messages of the parts in time
+    /// order
+    public: MsgIterPrivate(const std::shared_ptr<
+        const std::vector<std::unique_ptr<BatchPrivate>>> &_parts,
+        bool _merge = false);
+
+    /// \brief constructor
+    /// \param[in] _source Iterator stepped on a background thread to read
+    /// the messages ahead of this one
+    /// \param[in] _messages Maximum number of messages read ahead
+    /// \param[in] _bytes Maximum size of the messages read ahead, or 0 for
+    /// no limit
+    public: MsgIterPrivate(std::unique_ptr<MsgIterPrivate> &&_source,  // NOLINT
+        std::size_t _messages, std::size_t _bytes);
+
+    /// \brief constructor
+    /// \param[in] _preloaded Messages read into memory
+    /// \param[in] _index Index of the first message to give
+    public: MsgIterPrivate(
+        const std::shared_ptr<const PreloadedBatch> &_preloaded,
+        std::size_t _index);
 
     /// \brief destructor
     public: ~MsgIterPrivate();
@@ -55,10 +124,38 @@ inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
     /// \brief Executes the statement once
     public: void StepStatement();
 
+    /// \brief Step the iterator of each part merged in time order, and
+    /// take the earliest of their messages
+    public: void StepMerged();
+
+    /// \brief Step an iterator until it has a new message or is done
+    /// \param[in,out] _iter The iterator
+    /// \return True if the iterator has a new message
+    public: static bool NextMessage(MsgIterPrivate &_iter);
+
+    /// \brief Tell whether an iterator has no message left
+    /// \param[in] _iter The iterator
+    /// \return True if the iterator is done
+    public: static bool Done(const MsgIterPrivate &_iter);
+
     /// \brief Prepares the next statement to be executed
     /// \return true if the statement was sucessfully prepared
     public: bool PrepareNextStatement();
 
+    /// \brief Bind the parameters of a query to its compiled statement
+    /// \param[in] _statement The compiled statement
+    /// \param[in] _query The query with its parameters
+    /// \return true if every parameter was bound
+    public: static bool BindParameters(raii_sqlite3::Statement &_statement,
+        const SqlStatement &_query);
+
+    /// \brief Get the plan SQLite uses to run a query
+    /// \param[in] _db The database
+    /// \param[in] _query The query
+    /// \return One line per step of the plan, e.g. which index is searched
+    public: static std::vector<std::string> QueryPlan(
+        raii_sqlite3::Database &_db, const SqlStatement &_query);
+
     /// \brief a statement that is being stepped
     public: std::unique_ptr<raii_sqlite3::Statement> statement;
 
@@ -71,9 +168,123 @@ inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
     /// \brief statements used to get messages from the database
     public: std::shared_ptr<std::vector<SqlStatement>> statements;
 
+    /// \brief dictionaries of the compressed topics of the database, or
+    /// nullptr
+    public: std::shared_ptr<const MessageDictionaries> dictionaries;
+
+    /// \brief topic of the last compressed message read from the database.
+    /// Messages usually come in runs of the same topic.
+    public: TopicKey lastTopic;
+
+    /// \brief dictionary of lastTopic, or nullptr if it isn't compressed
+    public: const MessageDictionary *lastDictionary = nullptr;
+
+    /// \brief cursor over the messages of a chunked log, if any
+    public: std::unique_ptr<ChunkedLogCursor> cursor;
+
+    /// \brief batches of the files of a split recording, until the last
+    /// one is done
+    public: std::shared_ptr<const std::vector<std::unique_ptr<BatchPrivate>>>
+      parts;
+
+    /// \brief index of the next file of a split recording
+    public: std::size_t partIndex = 0;
+
+    /// \brief iterator over the current file of a split recording
+    public: std::unique_ptr<MsgIterPrivate> part;
+
+    /// \brief true to merge the parts in time order instead
+    public: bool merge = false;
+
+    /// \brief iterators over every part merged in time order, which hold
+    /// their next message, once the first message was taken
+    public: std::vector<std::unique_ptr<MsgIterPrivate>> merged;
+
+    /// \brief index of the merged iterator the current message comes from
+    public: std::size_t mergedIndex = 0;
+
+    /// \brief indexes of the merged iterators which hold a message, as a
+    /// heap ordered by the time of their message, earliest first
+    public: std::vector<std::size_t> mergedHeap;
+
+    /// \brief messages read into memory, until the last one was given
+    public: std::shared_ptr<const PreloadedBatch> preloaded;
+
+    /// \brief index of the next message read into memory
+    public: std::size_t preloadedIndex = 0;
+
+    /// \brief messages read ahead by a background thread, if any
+    public: std::unique_ptr<ReadAhead> readAhead;
+
+    /// \brief the message read ahead this iterator is at
+    public: std::unique_ptr<ReadAheadEntry> readAheadEntry;
+
     /// \brief the message this iterator is at
     public: std::unique_ptr<Message> message;
   };
+
+  /// \brief Reads the messages of an iterator on a background thread into a
+  /// bounded queue, so that reading the log overlaps with the processing of
+  /// the messages by the consumer.
+  class ReadAhead
+  {
+    /// \brief Constructor. Starts the thread.
+    /// \param[in] _source Iterator to read from
+    /// \param[in] _messages Maximum number of messages in the queue
+    /// \param[in] _bytes Maximum size of the messages in the queue, or 0 for
+    /// no limit. A larger message is still read when the queue is empty.
+    public: ReadAhead(std::unique_ptr<MsgIterPrivate> &&_source,  // NOLINT
+        std::size_t _messages, std::size_t _bytes);
+
+    /// \brief Destructor. Stops the thread.
+    public: ~ReadAhead();
+
+    /// \brief Take the next message, waiting for the thread to read it.
+    /// \param[in,out] _entry The previous message, which is recycled, and
+    /// then the next message
+    /// \return False if there is no message left
+    public: bool Next(std::unique_ptr<ReadAheadEntry> &_entry);
+
+    /// \brief Body of the thread
+    private: void Run();
+
+    /// \brief Iterator stepped by the thread
+    private: std::unique_ptr<MsgIterPrivate> source;
+
+    /// \brief Maximum number of messages in the queue
+    private: const std::size_t maxMessages;
+
+    /// \brief Maximum size of the messages in the queue (bytes)
+    private: const std::size_t maxBytes;
+
+    /// \brief Messages read and not taken yet, guarded by mutex
+    private: std::deque<std::unique_ptr<ReadAheadEntry>> queue;
+
+    /// \brief Size of the messages in queue (bytes), guarded by mutex
+    private: std::size_t queueBytes = 0;
+
+    /// \brief Messages taken by the consumer, whose buffers are reused,
+    /// guarded by mutex
+    private: std::vector<std::unique_ptr<ReadAheadEntry>> recycled;
+
+    /// \brief True once the source has no message left, guarded by mutex
+    private: bool done = false;
+
+    /// \brief True to stop the thread, guarded by mutex
+    private: bool stop = false;
+
+    /// \brief Protects the state shared with the thread
+    private: std::mutex mutex;
+
+    /// \brief Signaled when a message is queued or the source is done
+    private: std::condition_variable readCondVar;
+
+    /// \brief Signaled when a message is taken or the thread must stop
+    private: std::condition_variable takeCondVar;
+
+    /// \brief Thread reading the messages
+    private: std::thread thread;
+  };
 }
 }
 }
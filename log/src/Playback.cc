@@ -17,16 +17,32 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
+#include <cstddef>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <gz/msgs/clock.pb.h>
+
+#include <gz/transport/Clock.hh>
 #include <gz/transport/Node.hh>
 #include <gz/transport/log/Log.hh>
 #include <gz/transport/log/Playback.hh>
@@ -43,6 +59,102 @@ using namespace gz::transport::log;
 // See: https://www.sqlite.org/threadsafe.html
 static const bool kSqlite3Threadsafe = (sqlite3_threadsafe() != 0);
 
+/// \brief Lowest playback rate
+static const double kMinRate = 0.1;
+
+/// \brief Highest playback rate
+static const double kMaxRate = 100.0;
+
+//////////////////////////////////////////////////
+/// \brief Check a playback rate
+/// \param[in] _rate The rate
+/// \return True if the rate is valid
+static bool ValidRate(const double _rate)
+{
+  if (!(_rate >= kMinRate && _rate <= kMaxRate))
+  {
+    LERR("Invalid playback rate [" << _rate << "]: it must be between "
+         << kMinRate << " and " << kMaxRate << "\n");
+    return false;
+  }
+  return true;
+}
+
+/// \brief The playback thread stops sleeping this long before the time to
+/// publish a message, and polls the clock until then, because the sleep may
+/// last longer than requested.
+static const std::chrono::microseconds kSpinTime(200);
+
+/// \brief Period at which an external clock is polled
+static const std::chrono::milliseconds kClockPollPeriod(1);
+
+/// \brief Period at which the subscribers of the topics are checked
+static const std::chrono::milliseconds kSubscribersPollPeriod(10);
+
+/// \brief A message published later than this after its time is late
+static const std::chrono::milliseconds kLateThreshold(1);
+
+/// \brief Longest delay of a publication the following messages make up for
+static const std::chrono::milliseconds kMaxCatchUp(100);
+
+//////////////////////////////////////////////////
+/// \brief Give the calling thread a real-time scheduling priority
+/// \return True if the priority was changed
+static bool SetRealTimePriority()
+{
+#ifdef __linux__
+  sched_param param{};
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+  return false;
+#endif
+}
+
+/// \brief Number of messages read ahead of the playback
+static const std::size_t kReadAheadMessages = 256;
+
+/// \brief Size of the messages read ahead of the playback (bytes)
+static const std::size_t kReadAheadBytes = 64 * 1024 * 1024;
+
+//////////////////////////////////////////////////
+/// \brief Read the messages of a batch ahead of the playback, so that the
+/// log is read while waiting to publish the next message. This needs a
+/// threadsafe sqlite3.
+/// \param[in] _batch The batch to play
+/// \return The batch
+static Batch WithReadAhead(Batch &&_batch)  // NOLINT(build/c++11)
+{
+  if (kSqlite3Threadsafe)
+    _batch.SetReadAhead(kReadAheadMessages, kReadAheadBytes);
+  return std::move(_batch);
+}
+
+//////////////////////////////////////////////////
+/// \brief Query the messages of a playback
+/// \param[in] _log The log to play
+/// \param[in] _topics The topics to play
+/// \param[in] _range The time range to play
+/// \param[in] _preloadBytes Maximum size of the messages read into memory
+/// before the playback, or 0 to read them during the playback
+/// \return The batch
+static Batch PlaybackBatch(Log &_log,
+    const std::unordered_set<std::string> &_topics,
+    const QualifiedTimeRange &_range,
+    const std::size_t _preloadBytes)
+{
+  Batch batch = _log.QueryMessages(TopicList::Create(_topics, _range));
+  if (_preloadBytes > 0)
+  {
+    if (batch.Preload(_preloadBytes))
+      return batch;
+
+    LWRN("The messages to play exceed the preload size of ["
+         << _preloadBytes << "] bytes, they are read during the playback\n");
+  }
+  return WithReadAhead(std::move(batch));
+}
+
 //////////////////////////////////////////////////
 /// \brief Private implementation of Playback
 class gz::transport::log::Playback::Implementation
@@ -55,13 +167,41 @@ class gz::transport::log::Playback::Implementation
       addTopicWasUsed(false),
       nodeOptions(_nodeOptions)
   {
-    if (!this->logFile->Open(_file, std::ios_base::in))
+    // Play the following files of a split recording too.
+    const std::vector<std::string> files = Log::SplitFiles(_file);
+    const bool opened = files.size() > 1 ?
+      this->logFile->OpenSplit(files) :
+      this->logFile->Open(_file, std::ios_base::in);
+    if (!opened)
     {
       LERR("Could not open file [" << _file << "]\n");
     }
     else
     {
-      LDBG("Playback opened file [" << _file << "]\n");
+      LDBG("Playback opened file [" << _file << "] (" << files.size()
+          << " file(s))\n");
+    }
+  }
+
+  /// \brief Constructor. Opens the log files, merged in time order
+  /// \param[in] _files The full paths of the files to open
+  public: Implementation(
+    const std::vector<std::string> &_files, const NodeOptions &_nodeOptions)
+    : logFile(std::make_shared<Log>()),
+      addTopicWasUsed(false),
+      nodeOptions(_nodeOptions)
+  {
+    const bool opened = _files.size() > 1 ?
+      this->logFile->OpenMerged(_files) :
+      !_files.empty() && this->logFile->Open(_files.front(),
+                                             std::ios_base::in);
+    if (!opened)
+    {
+      LERR("Could not open the " << _files.size() << " log file(s)\n");
+    }
+    else
+    {
+      LDBG("Playback opened " << _files.size() << " merged file(s)\n");
     }
   }
 
@@ -97,8 +237,154 @@ class gz::transport::log::Playback::Implementation
 
   /// \brief The node options.
   public: NodeOptions nodeOptions;
+
+  /// \brief Rate of the playbacks
+  public: double rate = 1.0;
+
+  /// \brief Maximum number of unacknowledged messages of the playbacks, or 0
+  public: std::size_t ackWindow = 0;
+
+  /// \brief True to run the playback threads with a real-time priority
+  public: bool realTime = false;
+
+  /// \brief Number of threads publishing the messages of the playbacks, or 0
+  public: std::size_t publishThreads = 0;
+
+  /// \brief Clock the playbacks are paced against, or nullptr
+  public: const Clock *clock = nullptr;
+
+  /// \brief Topic where the playbacks publish their time, or empty
+  public: std::string clockTopic;
+
+  /// \brief Time range of the messages of the playbacks
+  public: QualifiedTimeRange range = QualifiedTimeRange::AllTime();
+
+  /// \brief Maximum size of the messages preloaded by the playbacks, or 0
+  public: std::size_t preloadBytes = 0;
+
+  /// \brief True to loop the playbacks
+  public: bool loop = false;
+
+  /// \brief True to start the playbacks once the topics have subscribers
+  public: bool waitForSubscribers = false;
 };
 
+namespace
+{
+  /// \brief Publishes the messages of some topics of a playback on its own
+  /// thread, in the order they are handed over, so that a long publication
+  /// doesn't delay the messages of the topics of the other threads.
+  class PublishThread
+  {
+    /// \brief Constructor. Starts the thread.
+    public: PublishThread()
+    {
+      this->thread = std::thread(&PublishThread::Run, this);
+    }
+
+    /// \brief Destructor. Stops the thread, the messages not published yet
+    /// are dropped.
+    public: ~PublishThread()
+    {
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        this->stop = true;
+      }
+      this->condition.notify_all();
+      this->thread.join();
+    }
+
+    /// \brief Hand over a message to publish.
+    /// \param[in] _publisher Publisher of the topic and type of the message.
+    /// It must outlive this thread.
+    /// \param[in] _data Serialized message
+    /// \param[in] _size Size of the serialized message
+    /// \param[in] _type Message type
+    public: void Publish(Node::Publisher &_publisher,
+                         std::shared_ptr<const char[]> &&_data,
+                         const std::size_t _size, std::string &&_type)
+    {
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        this->queue.push_back(
+            {&_publisher, std::move(_data), _size, std::move(_type)});
+      }
+      this->condition.notify_all();
+    }
+
+    /// \brief Wait until the messages handed over are published.
+    public: void Flush()
+    {
+      std::unique_lock<std::mutex> lk(this->mutex);
+      this->condition.wait(lk, [this]
+          {
+            return this->stop || (this->queue.empty() && !this->publishing);
+          });
+    }
+
+    /// \brief Body of the thread
+    private: void Run()
+    {
+      std::unique_lock<std::mutex> lk(this->mutex);
+      while (true)
+      {
+        this->condition.wait(lk, [this]
+            {
+              return this->stop || !this->queue.empty();
+            });
+        if (this->stop)
+          return;
+
+        Pending msg = std::move(this->queue.front());
+        this->queue.pop_front();
+        this->publishing = true;
+        lk.unlock();
+
+        msg.publisher->PublishRaw(msg.data, msg.size, msg.type);
+
+        lk.lock();
+        this->publishing = false;
+        this->condition.notify_all();
+      }
+    }
+
+    /// \brief A message to publish
+    private: struct Pending
+    {
+      /// \brief Publisher of the message
+      Node::Publisher *publisher;
+
+      /// \brief Serialized message, shared with the log
+      std::shared_ptr<const char[]> data;
+
+      /// \brief Size of the serialized message
+      std::size_t size;
+
+      /// \brief Message type
+      std::string type;
+    };
+
+    /// \brief Messages to publish, guarded by mutex
+    private: std::deque<Pending> queue;
+
+    /// \brief True while a message is being published, guarded by mutex
+    private: bool publishing = false;
+
+    /// \brief True to stop the thread, guarded by mutex
+    private: bool stop = false;
+
+    /// \brief Protects the queue
+    private: std::mutex mutex;
+
+    /// \brief Signaled when a message is queued or published, or the thread
+    /// must stop
+    private: std::condition_variable condition;
+
+    /// \brief The thread
+    private: std::thread thread;
+  };
+}
+
 //////////////////////////////////////////////////
 /// \brief Private implementation of PlaybackHandle
 class PlaybackHandle::Implementation
@@ -111,12 +397,38 @@ class PlaybackHandle::Implementation
   /// \param[in] _msgWaiting True to wait between publication of
   /// messages based on the message timestamps. False to playback
   /// messages as fast as possible. Default value is true.
+  /// \param[in] _rate Playback rate
+  /// \param[in] _ackWindow Maximum number of unacknowledged messages, or 0
+  /// \param[in] _realTime True to run the playback thread with a real-time
+  /// priority
+  /// \param[in] _publishThreads Number of threads publishing the messages,
+  /// or 0 to publish them from the playback thread
+  /// \param[in] _clock Clock to pace the playback against, or nullptr for
+  /// the steady clock
+  /// \param[in] _clockTopic Topic where the playback publishes its time, or
+  /// empty
+  /// \param[in] _range Time range of the messages to play
+  /// \param[in] _preloadBytes Maximum size of the messages read into memory
+  /// before the playback, or 0 to read them during the playback
+  /// \param[in] _loop True to play the messages over and over
+  /// \param[in] _waitForSubscribers True to wait until the topics have
+  /// subscribers, for at most _waitAfterAdvertising
   public: Implementation(
       const std::shared_ptr<Log> &_logFile,
       const std::unordered_set<std::string> &_topics,
       const std::chrono::nanoseconds &_waitAfterAdvertising,
       const NodeOptions &_nodeOptions,
-      bool _msgWaiting);
+      bool _msgWaiting,
+      double _rate,
+      std::size_t _ackWindow,
+      bool _realTime,
+      std::size_t _publishThreads,
+      const Clock *_clock,
+      const std::string &_clockTopic,
+      const QualifiedTimeRange &_range,
+      std::size_t _preloadBytes,
+      bool _loop,
+      bool _waitForSubscribers);
 
   /// \brief Look through the types of data that _topic can publish and create
   /// a publisher for each type.
@@ -147,11 +459,29 @@ class PlaybackHandle::Implementation
 
   /// \brief Puts the calling thread to sleep until a given time is achieved.
   /// \param[in] _targetTime Time at which the wait must finish. Measured in
-  /// POSIX time (time since epoch) in nanoseconds
-  /// \return True if the wait ends successfully or false if a pause or
-  /// stop event interrupt it
+  /// time of the playback clock, see Now()
+  /// \return True if the wait ends successfully or false if a pause, stop
+  /// or rate change event interrupt it
   public: bool WaitUntil(const std::chrono::nanoseconds &_targetTime);
 
+  /// \brief Get the time of the clock the playback is paced against: the
+  /// external clock if there is one, otherwise the steady clock. This is the
+  /// realtime frame.
+  /// \return The time
+  public: std::chrono::nanoseconds Now() const;
+
+  /// \brief Wait until the external clock is ready, if there is one.
+  /// \return False if the playback is stopped while waiting
+  public: bool WaitForClock();
+
+  /// \brief Wait until every topic played has a subscriber connected.
+  /// \param[in] _timeout Longest wait
+  /// \return False if some topics have no subscriber after the timeout
+  public: bool WaitForSubscribers(const std::chrono::nanoseconds &_timeout);
+
+  /// \brief Publish the time of the playback on the clock topic, if any.
+  public: void PublishClock();
+
   /// \brief Pauses the playback
   public: void Pause();
 
@@ -161,6 +491,50 @@ class PlaybackHandle::Implementation
   /// \brief Check pause status
   public: bool IsPaused() const;
 
+  /// \brief Change the playback rate
+  /// \param[in] _rate Playback rate
+  /// \return True if the rate is valid
+  public: bool SetRate(double _rate);
+
+  /// \brief Convert a duration in the playback frame to the realtime frame
+  /// \param[in] _duration Duration in the playback frame
+  /// \return Duration in the realtime frame
+  public: std::chrono::nanoseconds ToRealTime(
+      const std::chrono::nanoseconds &_duration) const;
+
+  /// \brief Convert a duration in the realtime frame to the playback frame
+  /// \param[in] _duration Duration in the realtime frame
+  /// \return Duration in the playback frame
+  public: std::chrono::nanoseconds ToPlaybackTime(
+      const std::chrono::nanoseconds &_duration) const;
+
+  /// \brief Set the maximum number of unacknowledged messages
+  /// \param[in] _messages Maximum number of messages, or 0 to not wait
+  public: void SetAcknowledgeWindow(std::size_t _messages);
+
+  /// \brief Acknowledge published messages
+  /// \param[in] _messages Number of messages
+  public: void Acknowledge(std::size_t _messages);
+
+  /// \brief Wait until one more message can be published without exceeding
+  /// the acknowledge window, and count it as unacknowledged.
+  /// \return True if the message can be published or false if a pause or
+  /// stop event interrupt the wait
+  public: bool WaitForAcknowledgements();
+
+  /// \brief Wake up the playback thread if it's waiting for
+  /// acknowledgements
+  public: void NotifyAcknowledgements();
+
+  /// \brief Publish the message the iterator is at, or hand it over to the
+  /// publishing thread of its topic.
+  public: void PublishMessage();
+
+  /// \brief Account the scheduling error of a published message
+  /// \param[in] _error Time the message was published minus the time it
+  /// was due
+  public: void UpdateStatistics(const std::chrono::nanoseconds &_error);
+
   /// \brief Wait until playback has finished playing
   public: void WaitUntilFinished();
 
@@ -230,6 +604,9 @@ class PlaybackHandle::Implementation
   /// \brief List of topics currently tracked
   public: const std::unordered_set<std::string> trackedTopics;
 
+  /// \brief Time range of the messages played
+  public: const QualifiedTimeRange range;
+
   /// \brief mutex for thread safety with log file
   public: std::mutex logFileMutex;
 
@@ -249,6 +626,61 @@ class PlaybackHandle::Implementation
   /// messages based on the message timestamps. False to playback
   /// messages as fast as possible.
   public: bool msgWaiting = true;
+
+  /// \brief Playback rate, relative to the time the messages were recorded
+  public: std::atomic<double> rate;
+
+  /// \brief Protects the acknowledgement state
+  public: std::mutex ackMutex;
+
+  /// \brief Condition variable to wake up the playback thread if it's waiting
+  /// for acknowledgements
+  public: std::condition_variable ackConditionVariable;
+
+  /// \brief Maximum number of unacknowledged messages, or 0
+  public: std::size_t ackWindow;
+
+  /// \brief Number of messages published and not acknowledged yet
+  public: std::size_t unacknowledged = 0;
+
+  /// \brief True to run the playback thread with a real-time priority
+  public: bool realTime;
+
+  /// \brief True to play the messages over and over
+  public: bool loop;
+
+  /// \brief Time the playback goes back by when it loops, or 0 if it
+  /// doesn't loop
+  public: std::chrono::nanoseconds loopPeriod{0};
+
+  /// \brief Protects the statistics
+  public: mutable std::mutex statsMutex;
+
+  /// \brief Statistics of the playback
+  public: PlaybackStatistics stats;
+
+  /// \brief Sum of the squared differences from the mean scheduling error
+  /// (ns^2), to compute the jitter incrementally
+  public: double errorM2 = 0;
+
+  /// \brief Threads publishing the messages, or empty to publish from the
+  /// playback thread
+  /// \note This member needs to come after the publishers member so that the
+  /// threads stop before the publishers are destructed
+  public: std::vector<std::unique_ptr<PublishThread>> publishThreads;
+
+  /// \brief Index of the publishing thread of each topic
+  public: std::unordered_map<std::string, std::size_t> topicThreads;
+
+  /// \brief Clock the playback is paced against, or nullptr for the steady
+  /// clock
+  public: const Clock *clock;
+
+  /// \brief Publisher of the time of the playback, if it has a clock topic
+  public: std::optional<Node::Publisher> clockPublisher;
+
+  /// \brief Last time published on the clock topic
+  public: std::chrono::nanoseconds lastClockTime{-1};
 };
 
 //////////////////////////////////////////////////
@@ -258,6 +690,14 @@ Playback::Playback(const std::string &_file, const NodeOptions &_nodeOptions)
   // Do nothing
 }
 
+//////////////////////////////////////////////////
+Playback::Playback(const std::vector<std::string> &_files,
+                   const NodeOptions &_nodeOptions)
+  : dataPtr(new Implementation(_files, _nodeOptions))
+{
+  // Do nothing
+}
+
 //////////////////////////////////////////////////
 Playback::Playback(Playback &&_other)  // NOLINT
   : dataPtr(std::move(_other.dataPtr))
@@ -313,7 +753,12 @@ PlaybackHandlePtr Playback::Start(
         new PlaybackHandle(
           std::make_unique<PlaybackHandle::Implementation>(
             this->dataPtr->logFile, topics, _waitAfterAdvertising,
-            this->dataPtr->nodeOptions, _msgWaiting)));
+            this->dataPtr->nodeOptions, _msgWaiting, this->dataPtr->rate,
+            this->dataPtr->ackWindow, this->dataPtr->realTime,
+            this->dataPtr->publishThreads, this->dataPtr->clock,
+            this->dataPtr->clockTopic, this->dataPtr->range,
+            this->dataPtr->preloadBytes, this->dataPtr->loop,
+            this->dataPtr->waitForSubscribers)));
 
   // We only need to store this if sqlite3 was not compiled in threadsafe mode.
   if (!kSqlite3Threadsafe)
@@ -322,6 +767,70 @@ PlaybackHandlePtr Playback::Start(
   return newHandle;
 }
 
+//////////////////////////////////////////////////
+bool Playback::SetRate(const double _rate)
+{
+  if (!ValidRate(_rate))
+    return false;
+
+  this->dataPtr->rate = _rate;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetAcknowledgeWindow(const std::size_t _messages)
+{
+  this->dataPtr->ackWindow = _messages;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetRealTimePriority(const bool _realTime)
+{
+  this->dataPtr->realTime = _realTime;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetPublishThreads(const std::size_t _threads)
+{
+  this->dataPtr->publishThreads = _threads;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetClock(const Clock *_clock)
+{
+  this->dataPtr->clock = _clock;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetClockTopic(const std::string &_topic)
+{
+  this->dataPtr->clockTopic = _topic;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetTimeRange(const QualifiedTimeRange &_range)
+{
+  this->dataPtr->range = _range;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetPreload(const std::size_t _maxBytes)
+{
+  this->dataPtr->preloadBytes = _maxBytes;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetWaitForSubscribers(const bool _wait)
+{
+  this->dataPtr->waitForSubscribers = _wait;
+}
+
+//////////////////////////////////////////////////
+void Playback::SetLoop(const bool _loop)
+{
+  this->dataPtr->loop = _loop;
+}
+
 //////////////////////////////////////////////////
 bool Playback::Valid() const
 {
@@ -426,16 +935,32 @@ PlaybackHandle::Implementation::Implementation(
     const std::unordered_set<std::string> &_topics,
     const std::chrono::nanoseconds &_waitAfterAdvertising,
     const NodeOptions &_nodeOptions,
-    bool _msgWaiting)
+    bool _msgWaiting,
+    const double _rate,
+    const std::size_t _ackWindow,
+    const bool _realTime,
+    const std::size_t _publishThreads,
+    const Clock *_clock,
+    const std::string &_clockTopic,
+    const QualifiedTimeRange &_range,
+    const std::size_t _preloadBytes,
+    const bool _loop,
+    const bool _waitForSubscribers)
   : stop(true),
     finished(false),
     paused(false),
     logFile(_logFile),
     trackedTopics(_topics),
-    batch(logFile->QueryMessages(TopicList::Create(_topics))),
+    range(_range),
+    batch(PlaybackBatch(*logFile, _topics, _range, _preloadBytes)),
     messageIter(batch.begin()),
     firstMessageTime(messageIter->TimeReceived()),
-    msgWaiting(_msgWaiting)
+    msgWaiting(_msgWaiting),
+    rate(_rate),
+    ackWindow(_ackWindow),
+    realTime(_realTime),
+    loop(_loop),
+    clock(_clock)
 {
   this->node.reset(new transport::Node(_nodeOptions));
 
@@ -444,9 +969,36 @@ PlaybackHandle::Implementation::Implementation(
     this->AddTopic(topic);
   }
 
-  std::this_thread::sleep_for(_waitAfterAdvertising);
+  if (!_clockTopic.empty())
+  {
+    this->clockPublisher = this->node->Advertise<msgs::Clock>(_clockTopic);
+    if (!*this->clockPublisher)
+    {
+      LERR("Failed to advertise the clock topic [" << _clockTopic << "]\n");
+      this->clockPublisher.reset();
+    }
+  }
+
+  // Spread the topics over the publishing threads, in name order so that
+  // the same topics share a thread from one playback to the next
+  const std::size_t threads = std::min(_publishThreads, _topics.size());
+  if (threads > 0)
+  {
+    std::vector<std::string> names(_topics.begin(), _topics.end());
+    std::sort(names.begin(), names.end());
+    for (std::size_t i = 0; i < names.size(); ++i)
+      this->topicThreads[names[i]] = i % threads;
+
+    for (std::size_t i = 0; i < threads; ++i)
+      this->publishThreads.push_back(std::make_unique<PublishThread>());
+  }
+
+  if (_waitForSubscribers)
+    this->WaitForSubscribers(_waitAfterAdvertising);
+  else
+    std::this_thread::sleep_for(_waitAfterAdvertising);
 
-  if (this->batch.begin() == this->batch.end())
+  if (this->messageIter == this->batch.end())
   {
     LWRN("There are no messages to play\n");
   }
@@ -521,13 +1073,39 @@ void PlaybackHandle::Implementation::StartPlayback()
   this->playbackStartTime = this->logFile->StartTime();
   this->playbackTime = this->playbackStartTime;
   this->playbackEndTime = this->logFile->EndTime();
+  const QualifiedTime::Time *begin = this->range.Beginning().GetTime();
+  if (begin)
+    this->playbackStartTime = std::max(this->playbackStartTime, *begin);
+  const QualifiedTime::Time *end = this->range.Ending().GetTime();
+  if (end)
+    this->playbackEndTime = std::min(this->playbackEndTime, *end);
+
+  if (this->loop)
+  {
+    this->loopPeriod = this->playbackEndTime - this->playbackStartTime;
+    if (this->loopPeriod.count() <= 0)
+    {
+      LWRN("The time range of the playback lasts no time, it isn't looped\n");
+      this->loopPeriod = std::chrono::nanoseconds(0);
+    }
+  }
 
   this->nextMessageTime = this->messageIter->TimeReceived();
 
-  this->lastEventTime = std::chrono::steady_clock::now().time_since_epoch();
+  this->lastEventTime = this->Now();
 
   this->playbackThread = std::thread([this] () mutable
     {
+      if (this->realTime && !SetRealTimePriority())
+      {
+        LWRN("Failed to give a real-time priority to the playback thread, "
+             "it may lack the permission\n");
+      }
+
+      // The playback starts once the clock it's paced against has a time
+      if (this->WaitForClock())
+        this->lastEventTime = this->Now();
+
       while (!this->stop && (this->messageIter != this->batch.end())) {
         // Lock if paused
         if (this->paused)
@@ -536,8 +1114,7 @@ void PlaybackHandle::Implementation::StartPlayback()
           // If paused, the thread will be blocked here
           this->pauseConditionVariable.wait(lk,
             [this]{return !this->paused.load();});
-          this->lastEventTime =
-              std::chrono::steady_clock::now().time_since_epoch();
+          this->lastEventTime = this->Now();
           // Abort current iteration after coming back from pause
           continue;
         }
@@ -548,28 +1125,64 @@ void PlaybackHandle::Implementation::StartPlayback()
           const std::chrono::nanoseconds timeDelta(
               this->nextMessageTime - this->playbackTime);
           const std::chrono::nanoseconds timeToWaitUntil(
-              this->lastEventTime + timeDelta);
+              this->lastEventTime + this->ToRealTime(timeDelta));
           // Wait until target time is reached or playback is stopped/paused
           // In the latter case, break the iteration step
           if (this->msgWaiting && !this->WaitUntil(timeToWaitUntil))
           {
             continue;
           }
+          // Wait until the subscribers catch up, if they acknowledge messages
+          if (!this->WaitForAcknowledgements())
+          {
+            continue;
+          }
+          // Time the message is published, in the realtime frame
+          const std::chrono::nanoseconds publishTime(this->Now());
+          const std::chrono::nanoseconds error(
+              publishTime - timeToWaitUntil);
+          if (this->msgWaiting)
+            this->UpdateStatistics(error);
+
           // Publish the message
           {
           std::unique_lock<std::mutex> lk(this->batchMutex);
           LDBG("publishing\n");
-          this->publishers[
-            this->messageIter->Topic()][
-              this->messageIter->Type()].PublishRaw(
-                this->messageIter->Data(), this->messageIter->Type());
+          this->PublishMessage();
           // Advance iterator to next message
           ++this->messageIter;
           this->playbackTime = this->nextMessageTime;
+          // The next message is due relative to when this one was due, so
+          // that the time spent publishing doesn't delay the following
+          // messages. After a longer delay (e.g. waiting for
+          // acknowledgements), the playback restarts from now instead of
+          // publishing the late messages at once, unless it follows an
+          // external clock, which may advance in large steps.
           this->lastEventTime =
-              std::chrono::steady_clock::now().time_since_epoch();
+              this->msgWaiting && (this->clock || error < kMaxCatchUp) ?
+              timeToWaitUntil : publishTime;
+          // A looping playback starts over from the first message, in
+          // memory if the messages were preloaded, or from the whole range
+          // of the log otherwise, since a seek may have narrowed the batch.
+          // The playback time goes back by the duration of the range, so the
+          // first message is due as long after the last one as the ends of
+          // the range allow.
+          if (this->loopPeriod.count() > 0 &&
+              this->messageIter == this->batch.end())
+          {
+            if (!this->batch.Preloaded())
+            {
+              this->batch = WithReadAhead(this->logFile->QueryMessages(
+                  TopicList::Create(this->trackedTopics, this->range)));
+            }
+            this->messageIter = this->batch.begin();
+            this->playbackTime -= this->loopPeriod;
+            if (this->boundaryTime != std::chrono::nanoseconds::max())
+              this->boundaryTime -= this->loopPeriod;
+          }
           this->nextMessageTime = messageIter->TimeReceived();
           }
+          this->PublishClock();
         }
         // If a custom step has been requested, always from a paused state,
         // playback gets resumed until the step requested is completed,
@@ -581,7 +1194,7 @@ void PlaybackHandle::Implementation::StartPlayback()
               this->boundaryTime - this->playbackTime);
           // Target time in the realtime frame
           const std::chrono::nanoseconds timeToWaitUntil(
-              this->lastEventTime + timeDelta);
+              this->lastEventTime + this->ToRealTime(timeDelta));
           // Wait until target time is reached or playback is stopped/paused
           // In the latter case, break the iteration step
           if (!this->WaitUntil(timeToWaitUntil))
@@ -591,51 +1204,293 @@ void PlaybackHandle::Implementation::StartPlayback()
           this->Pause();
         }
       }
+      // The playback finishes when the last messages are published
+      for (const auto &thread : this->publishThreads)
+        thread->Flush();
+
       this->finished = true;
       this->waitConditionVariable.notify_all();
   });
 }
 
+//////////////////////////////////////////////////
+void PlaybackHandle::Implementation::PublishMessage()
+{
+  std::string topic = this->messageIter->Topic();
+  std::string type = this->messageIter->Type();
+  Node::Publisher &publisher = this->publishers[topic][type];
+
+  // The data read ahead or preloaded is lent to the transport, which
+  // releases it once the message is sent
+  const std::size_t size = this->messageIter->DataView().size();
+  if (this->publishThreads.empty())
+  {
+    publisher.PublishRaw(this->messageIter->SharedData(), size, type);
+    return;
+  }
+
+  this->publishThreads[this->topicThreads[topic]]->Publish(
+      publisher, this->messageIter->SharedData(), size, std::move(type));
+}
+
 //////////////////////////////////////////////////
 bool PlaybackHandle::Implementation::WaitUntil(
     const std::chrono::nanoseconds &_targetTime)
 {
-  const auto waitStartTime =
-    std::chrono::steady_clock::now().time_since_epoch();
+  // The wait is interrupted if the rate changes
+  const double waitRate = this->rate;
 
   // Lambda used as predicate below to check for spurious wake-ups
-  auto FinishedWaiting = [this, &_targetTime]() -> bool
+  auto Interrupted = [this, waitRate]() -> bool
   {
-    const auto now =
-      std::chrono::steady_clock::now().time_since_epoch();
-    return _targetTime <= now || this->stop || this->paused;
+    return this->stop || this->paused || this->rate != waitRate;
   };
 
-  // Passing a lock to wait_for is just a formality (we don't actually
+  // Passing a lock to wait_until is just a formality (we don't actually
   // want to unlock any mutex while waiting), so we create a temporary
   // mutex and lock to satisfy the function.
   //
   // According to the C++11 standard, it is undefined behavior to pass
-  // different mutexes into the condition_variable::wait_for()
+  // different mutexes into the condition_variable::wait_until()
   // function of the same condition_variable instance from different
   // threads. However, this current thread should be the only thread
   // that is ever waiting on stopConditionVariable because we are
   // keeping playbackLock locked this whole time. Therefore, it's okay
   // for it lock its own local, unique mutex.
   //
-  // This is really a substitute for the sleep_for function. This
+  // This is really a substitute for the sleep_until function. This
   // alternative allows us to interrupt the sleep in case the user
   // calls Playback::Stop() while we are waiting between messages.
   std::mutex tempMutex;
   std::unique_lock<std::mutex> tempLock(tempMutex);
 
-  // Wait until reaching _targetTime or until a stop signal is received.
-  // The function will return true if the wait finished with a timeout state,
-  // (having successfully achieved the time to wait) or false if the predicate
-  // evaluates to true, which means that a pause or stop order was received,
-  // interrupting the wait.
-  return this->stopConditionVariable.wait_for(
-      tempLock, _targetTime - waitStartTime, FinishedWaiting);
+  if (this->clock)
+  {
+    // An external clock can't be waited for, so it is polled
+    while (!Interrupted() && this->Now() < _targetTime)
+    {
+      this->stopConditionVariable.wait_for(
+          tempLock, kClockPollPeriod, Interrupted);
+    }
+  }
+  else
+  {
+    // The deadline is absolute, so that the time spent since the target time
+    // was computed is not waited again.
+    const std::chrono::steady_clock::time_point deadline(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          _targetTime));
+
+    // Sleep until shortly before the deadline, or until a stop, pause or
+    // rate change interrupts the wait. The thread may wake up late, so the
+    // rest of the wait is spent polling the clock.
+    this->stopConditionVariable.wait_until(
+        tempLock, deadline - kSpinTime, Interrupted);
+    while (!Interrupted() && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+  }
+
+  if (this->stop || this->paused)
+    return false;
+
+  if (this->rate != waitRate)
+  {
+    // Advance time in the playback frame to now at the previous rate, so
+    // that the caller waits for the rest of the time at the new rate
+    const std::chrono::nanoseconds now(this->Now());
+    this->playbackTime = this->playbackTime +
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          (now - this->lastEventTime) * waitRate);
+    this->lastEventTime = now;
+    return false;
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PlaybackHandle::Implementation::Now() const
+{
+  if (this->clock)
+    return this->clock->Time();
+  return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+//////////////////////////////////////////////////
+bool PlaybackHandle::Implementation::WaitForClock()
+{
+  if (!this->clock || this->clock->IsReady())
+    return true;
+
+  LDBG("Waiting for the clock of the playback to be ready\n");
+  std::mutex tempMutex;
+  std::unique_lock<std::mutex> tempLock(tempMutex);
+  while (!this->stop && !this->clock->IsReady())
+  {
+    this->stopConditionVariable.wait_for(
+        tempLock, kClockPollPeriod, [this]{return this->stop.load();});
+  }
+  return !this->stop;
+}
+
+//////////////////////////////////////////////////
+bool PlaybackHandle::Implementation::WaitForSubscribers(
+    const std::chrono::nanoseconds &_timeout)
+{
+  const auto deadline = std::chrono::steady_clock::now() + _timeout;
+  std::size_t missing = 0;
+  while (true)
+  {
+    // A topic is served once any of its publishers has a subscriber
+    missing = 0;
+    for (const auto &topic : this->publishers)
+    {
+      const bool connected = std::any_of(topic.second.begin(),
+          topic.second.end(), [](const auto &_entry)
+          {
+            return _entry.second.HasConnections();
+          });
+      if (!connected)
+        ++missing;
+    }
+
+    if (missing == 0)
+      return true;
+
+    if (std::chrono::steady_clock::now() >= deadline)
+      break;
+    std::this_thread::sleep_for(kSubscribersPollPeriod);
+  }
+
+  LWRN("Starting the playback although [" << missing << "] of its topics "
+       "have no subscriber\n");
+  return false;
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::Implementation::PublishClock()
+{
+  if (!this->clockPublisher || this->playbackTime <= this->lastClockTime)
+    return;
+
+  // The time of the log, as the simulation time of the recording
+  const auto sec =
+      std::chrono::duration_cast<std::chrono::seconds>(this->playbackTime);
+  msgs::Clock msg;
+  msg.mutable_sim()->set_sec(sec.count());
+  msg.mutable_sim()->set_nsec(
+      static_cast<int32_t>((this->playbackTime - sec).count()));
+  this->clockPublisher->Publish(msg);
+  this->lastClockTime = this->playbackTime;
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::Implementation::UpdateStatistics(
+    const std::chrono::nanoseconds &_error)
+{
+  std::lock_guard<std::mutex> lk(this->statsMutex);
+  PlaybackStatistics &s = this->stats;
+  ++s.scheduledMessages;
+  s.lastError = _error;
+  s.maxError = s.scheduledMessages == 1 ? _error :
+    std::max(s.maxError, _error);
+  if (_error > kLateThreshold)
+    ++s.lateMessages;
+
+  // Welford's algorithm
+  const double error = static_cast<double>(_error.count());
+  const double delta = error - s.meanError;
+  s.meanError += delta / static_cast<double>(s.scheduledMessages);
+  this->errorM2 += delta * (error - s.meanError);
+  s.jitter = std::sqrt(
+      this->errorM2 / static_cast<double>(s.scheduledMessages));
+
+  LDBG("Scheduling error: " << _error.count() << " ns\n");
+}
+
+//////////////////////////////////////////////////
+bool PlaybackHandle::Implementation::SetRate(const double _rate)
+{
+  if (!ValidRate(_rate))
+    return false;
+
+  this->rate = _rate;
+
+  // Wake up the playback thread to wait for the next message at the new rate
+  this->stopConditionVariable.notify_all();
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PlaybackHandle::Implementation::ToRealTime(
+    const std::chrono::nanoseconds &_duration) const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _duration / this->rate.load());
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PlaybackHandle::Implementation::ToPlaybackTime(
+    const std::chrono::nanoseconds &_duration) const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _duration * this->rate.load());
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::Implementation::SetAcknowledgeWindow(
+    const std::size_t _messages)
+{
+  {
+    std::lock_guard<std::mutex> lk(this->ackMutex);
+    this->ackWindow = _messages;
+    if (this->ackWindow == 0)
+      this->unacknowledged = 0;
+  }
+  this->ackConditionVariable.notify_all();
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::Implementation::Acknowledge(const std::size_t _messages)
+{
+  {
+    std::lock_guard<std::mutex> lk(this->ackMutex);
+    this->unacknowledged -= std::min(_messages, this->unacknowledged);
+  }
+  this->ackConditionVariable.notify_all();
+}
+
+//////////////////////////////////////////////////
+bool PlaybackHandle::Implementation::WaitForAcknowledgements()
+{
+  std::unique_lock<std::mutex> lk(this->ackMutex);
+  if (this->ackWindow == 0)
+    return true;
+
+  this->ackConditionVariable.wait(lk, [this]
+      {
+        return this->ackWindow == 0 ||
+          this->unacknowledged < this->ackWindow ||
+          this->stop || this->paused;
+      });
+  if (this->ackWindow == 0)
+    return true;
+  if (this->unacknowledged >= this->ackWindow)
+    return false;
+
+  ++this->unacknowledged;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::Implementation::NotifyAcknowledgements()
+{
+  // Lock the mutex so that the playback thread can't miss the notification
+  // between checking its condition and waiting
+  {
+    std::lock_guard<std::mutex> lk(this->ackMutex);
+  }
+  this->ackConditionVariable.notify_all();
 }
 
 //////////////////////////////////////////////////
@@ -656,19 +1511,32 @@ void PlaybackHandle::Implementation::Seek(
     LERR("Seek can't be called from a stopped playback.\n");
     return;
   }
-  const QualifiedTime beginTime(this->firstMessageTime + _newElapsedTime);
-  const QualifiedTime endTime(std::chrono::nanoseconds::max());
-  const QualifiedTimeRange timeRange(beginTime, endTime);
+  const std::chrono::nanoseconds seekTime(
+      this->firstMessageTime + _newElapsedTime);
   {
     std::unique_lock<std::mutex> lk(this->batchMutex);
-    this->batch = this->logFile->QueryMessages(
-        TopicList::Create(this->trackedTopics, timeRange));
-    this->messageIter = this->batch.begin();
+    if (this->batch.Preloaded())
+    {
+      // The messages stay in memory, so that a looping playback can still
+      // start over from the first one
+      this->messageIter = this->batch.Find(seekTime);
+    }
+    else
+    {
+      const QualifiedTime beginTime(seekTime);
+      const QualifiedTime endTime = this->range.Ending().IsIndeterminate() ?
+        QualifiedTime(std::chrono::nanoseconds::max()) :
+        this->range.Ending();
+      const QualifiedTimeRange timeRange(beginTime, endTime);
+      this->batch = WithReadAhead(this->logFile->QueryMessages(
+          TopicList::Create(this->trackedTopics, timeRange)));
+      this->messageIter = this->batch.begin();
+    }
   }
   this->playbackTime = this->messageIter->TimeReceived();
   this->nextMessageTime = this->messageIter->TimeReceived();
   this->boundaryTime = std::chrono::nanoseconds::max();
-  this->lastEventTime = std::chrono::steady_clock::now().time_since_epoch();
+  this->lastEventTime = this->Now();
 }
 
 //////////////////////////////////////////////////
@@ -681,6 +1549,7 @@ void PlaybackHandle::Implementation::Stop()
 
   this->stop = true;
   this->stopConditionVariable.notify_all();
+  this->NotifyAcknowledgements();
 
   if (this->paused)
   {
@@ -691,6 +1560,9 @@ void PlaybackHandle::Implementation::Stop()
 
   if (this->playbackThread.joinable())
     this->playbackThread.join();
+
+  // Drop the messages that are not published yet
+  this->publishThreads.clear();
 }
 
 //////////////////////////////////////////////////
@@ -700,15 +1572,15 @@ void PlaybackHandle::Implementation::Pause()
   if (!this->paused)
   {
     this->paused = true;
-    std::chrono::nanoseconds now(
-        std::chrono::steady_clock::now().time_since_epoch());
+    std::chrono::nanoseconds now(this->Now());
     // Advance time in the playback frame to the moment when pause started
     this->playbackTime = this->playbackTime +
-        now - this->lastEventTime;
+        this->ToPlaybackTime(now - this->lastEventTime);
     // Update last event time in the realtime frame.
     this->lastEventTime = now;
     this->boundaryTime = std::chrono::nanoseconds::max();
   }
+  this->NotifyAcknowledgements();
 }
 
 //////////////////////////////////////////////////
@@ -773,6 +1645,37 @@ bool PlaybackHandle::IsPaused() const
   return this->dataPtr->IsPaused();
 }
 
+//////////////////////////////////////////////////
+bool PlaybackHandle::SetRate(const double _rate)
+{
+  return this->dataPtr->SetRate(_rate);
+}
+
+//////////////////////////////////////////////////
+double PlaybackHandle::Rate() const
+{
+  return this->dataPtr->rate;
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::SetAcknowledgeWindow(const std::size_t _messages)
+{
+  this->dataPtr->SetAcknowledgeWindow(_messages);
+}
+
+//////////////////////////////////////////////////
+void PlaybackHandle::Acknowledge(const std::size_t _messages)
+{
+  this->dataPtr->Acknowledge(_messages);
+}
+
+//////////////////////////////////////////////////
+PlaybackStatistics PlaybackHandle::Statistics() const
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->statsMutex);
+  return this->dataPtr->stats;
+}
+
 //////////////////////////////////////////////////
 void PlaybackHandle::WaitUntilFinished()
 {
@@ -16,6 +16,8 @@
 */
 
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <string>
@@ -23,9 +25,15 @@
 
 #include <gz/transport/log/QueryOptions.hh>
 
+#include "TopicMatcher.hh"
+
 using namespace gz::transport;
 using namespace gz::transport::log;
 
+/// \brief Maximum number of topics whose messages are merged from one SELECT
+/// per topic. SQLite limits the number of SELECTs of a compound statement.
+static const std::size_t kMaxMergedTopics = 64;
+
 //////////////////////////////////////////////////
 /// \brief Append a topic ID condition clause that specifies a list of Topic IDs
 /// \param[in,out] _sql The SqlStatement to append the clause to
@@ -53,6 +61,70 @@ static void AppendTopicListClause(
   _sql.statement += ")";
 }
 
+//////////////////////////////////////////////////
+/// \brief Generate a query for the messages of a list of topics
+/// \param[in] _descriptor The descriptor of the log
+/// \param[in] _ids The vector of Topic IDs to query
+/// \param[in] _timeCondition The time range clause, or an empty statement
+/// \return The complete query, ordered by time received
+static SqlStatement GenerateTopicQuery(
+    const Descriptor &_descriptor, const std::vector<int64_t> &_ids,
+    const SqlStatement &_timeCondition)
+{
+  SqlStatement sql;
+
+  // With an index on (topic_id, time_recv), the messages of each topic are
+  // read in order from the index and merged by SQLite, which skips the
+  // messages of the other topics without sorting the result.
+  if (_ids.size() > 1 && _ids.size() <= kMaxMergedTopics &&
+      _descriptor.TopicTimeIndexed())
+  {
+    for (const int64_t id : _ids)
+    {
+      if (!sql.statement.empty())
+        sql.statement += " UNION ALL ";
+
+      sql.Append(QueryOptions::StandardMessageQueryPreamble());
+      sql.statement += " WHERE (messages.topic_id = ?)";
+      sql.parameters.emplace_back(id);
+
+      if (!_timeCondition.statement.empty())
+      {
+        sql.statement += " AND (";
+        sql.Append(_timeCondition);
+        sql.statement += ")";
+      }
+    }
+
+    sql.statement += " ORDER BY time_recv;";
+    return sql;
+  }
+
+  // A single topic is read in order from the index as well. More topics, or
+  // a log without the index, are scanned in order of time received from
+  // idx_time_recv, starting at the beginning of the time range. Otherwise
+  // SQLite may select the messages by topic and sort all of them before
+  // returning the first one, which makes a query from a given time (e.g. a
+  // seek of the playback) as slow as reading the rest of the log. The unary
+  // + keeps the topic condition from using an index.
+  sql = QueryOptions::StandardMessageQueryPreamble();
+  sql.statement += " WHERE (";
+  if (_ids.size() > 1)
+    sql.statement += "+";
+  AppendTopicListClause(sql, _ids);
+  sql.statement += ")";
+
+  if (!_timeCondition.statement.empty())
+  {
+    sql.statement += " AND (";
+    sql.Append(_timeCondition);
+    sql.statement += ")";
+  }
+
+  sql.Append(QueryOptions::StandardMessageQueryClose());
+  return sql;
+}
+
 //////////////////////////////////////////////////
 SqlStatement QueryOptions::StandardMessageQueryPreamble()
 {
@@ -181,10 +253,10 @@ TimeRangeOption::~TimeRangeOption()
 //////////////////////////////////////////////////
 class TopicList::Implementation
 {
-  /// \brief Generate a WHERE clause for topics that exist in the requested list
+  /// \brief Get the IDs of the topics that exist in the requested list
   /// \param[in] _descriptor The descriptor forwarded by the interface class
-  /// \return The desired WHERE clause
-  public: SqlStatement GenerateStatement(
+  /// \return The IDs of the topics
+  public: std::vector<int64_t> TopicIds(
     const Descriptor &_descriptor)
   {
     const Descriptor::NameToMap &map = _descriptor.TopicsToMsgTypesToId();
@@ -203,12 +275,7 @@ class TopicList::Implementation
       }
     }
 
-    SqlStatement sql = QueryOptions::StandardMessageQueryPreamble();
-    sql.statement += " WHERE (";
-    AppendTopicListClause(sql, rowIDs);
-    sql.statement += ")";
-
-    return sql;
+    return rowIDs;
   }
 
   /// \brief Topics for this option
@@ -266,20 +333,8 @@ const std::set<std::string> &TopicList::Topics() const
 std::vector<SqlStatement> TopicList::GenerateStatements(
     const Descriptor &_descriptor) const
 {
-  SqlStatement sql = this->dataPtr->GenerateStatement(_descriptor);
-
-  // Add the time range condition
-  const SqlStatement &timeCondition = this->GenerateTimeConditions();
-  if (!timeCondition.statement.empty())
-  {
-    sql.statement += " AND (";
-    sql.Append(timeCondition);
-    sql.statement += ")";
-  }
-
-  sql.Append(QueryOptions::StandardMessageQueryClose());
-
-  return {sql};
+  return {GenerateTopicQuery(_descriptor,
+      this->dataPtr->TopicIds(_descriptor), this->GenerateTimeConditions())};
 }
 
 //////////////////////////////////////////////////
@@ -291,21 +346,23 @@ TopicList::~TopicList()
 //////////////////////////////////////////////////
 class TopicPattern::Implementation
 {
-  /// \brief Generate a WHERE clause for topics that match the requested pattern
+  /// \brief Get the IDs of the topics that match the requested pattern
   /// \param[in] _descriptor The descriptor forwarded by the interface class
-  /// \return The desired WHERE clause
-  public: SqlStatement GenerateStatement(
+  /// \return The IDs of the topics
+  public: std::vector<int64_t> TopicIds(
       const Descriptor &_descriptor)
   {
     const Descriptor::NameToMap &map = _descriptor.TopicsToMsgTypesToId();
     std::vector<int64_t> rowIDs;
     rowIDs.reserve(map.size());
 
+    std::shared_ptr<const TopicMatcher> topicMatcher = this->Matcher();
+
     // Look through all the topics
     for (const auto &topicEntry : map)
     {
       // Find which topics match the pattern
-      if (std::regex_match(topicEntry.first, this->pattern))
+      if (topicMatcher->Match(topicEntry.first))
       {
         // Add all the rows of that topic to the list of IDs.
         for (const auto &msgEntry : topicEntry.second)
@@ -315,17 +372,30 @@ class TopicPattern::Implementation
       }
     }
 
-    SqlStatement sql = QueryOptions::StandardMessageQueryPreamble();
-    sql.statement += " WHERE (";
-    AppendTopicListClause(sql, rowIDs);
-    sql.statement += ")";
+    return rowIDs;
+  }
 
-    return sql;
+  /// \brief Get the matcher of the pattern, creating it if needed.
+  /// \return The matcher.
+  public: std::shared_ptr<const TopicMatcher> Matcher()
+  {
+    std::lock_guard<std::mutex> lk(this->matcherMutex);
+    if (!this->matcher)
+      this->matcher = std::make_shared<TopicMatcher>(this->pattern);
+    return this->matcher;
   }
 
   /// \brief Pattern for this option
   /// TODO(anyone): Consider making this a vector of patterns?
   public: std::regex pattern;
+
+  /// \brief Matcher of the pattern, which keeps the result of each topic.
+  /// It is shared with the copies of the option, and dropped when the
+  /// pattern may be modified.
+  public: std::shared_ptr<const TopicMatcher> matcher;
+
+  /// \brief Protects matcher.
+  public: std::mutex matcherMutex;
 };
 
 //////////////////////////////////////////////////
@@ -333,17 +403,19 @@ TopicPattern::TopicPattern(
     const std::regex &_pattern,
     const QualifiedTimeRange &_timeRange)
   : TimeRangeOption(_timeRange),
-    dataPtr(new Implementation{_pattern})
+    dataPtr(new Implementation)
 {
-  // Do nothing
+  this->dataPtr->pattern = _pattern;
 }
 
 //////////////////////////////////////////////////
 TopicPattern::TopicPattern(const TopicPattern &_other)
   : TimeRangeOption(_other),
-    dataPtr(new Implementation{*_other.dataPtr})
+    dataPtr(new Implementation)
 {
-  // Do nothing
+  this->dataPtr->pattern = _other.dataPtr->pattern;
+  std::lock_guard<std::mutex> lk(_other.dataPtr->matcherMutex);
+  this->dataPtr->matcher = _other.dataPtr->matcher;
 }
 
 //////////////////////////////////////////////////
@@ -357,6 +429,10 @@ TopicPattern::TopicPattern(TopicPattern &&_other)  // NOLINT(build/c++11)
 //////////////////////////////////////////////////
 std::regex &TopicPattern::Pattern()
 {
+  // The caller may modify the pattern, so the results kept so far may be
+  // wrong.
+  std::lock_guard<std::mutex> lk(this->dataPtr->matcherMutex);
+  this->dataPtr->matcher.reset();
   return this->dataPtr->pattern;
 }
 
@@ -366,24 +442,18 @@ const std::regex &TopicPattern::Pattern() const
   return this->dataPtr->pattern;
 }
 
+//////////////////////////////////////////////////
+bool TopicPattern::Match(const std::string &_topic) const
+{
+  return this->dataPtr->Matcher()->Match(_topic);
+}
+
 //////////////////////////////////////////////////
 std::vector<SqlStatement> TopicPattern::GenerateStatements(
     const Descriptor &_descriptor) const
 {
-  SqlStatement sql = this->dataPtr->GenerateStatement(_descriptor);
-
-  // Add the time range condition
-  const SqlStatement &timeCondition = this->GenerateTimeConditions();
-  if (!timeCondition.statement.empty())
-  {
-    sql.statement += " AND (";
-    sql.Append(timeCondition);
-    sql.statement += ")";
-  }
-
-  sql.Append(QueryOptions::StandardMessageQueryClose());
-
-  return {sql};
+  return {GenerateTopicQuery(_descriptor,
+      this->dataPtr->TopicIds(_descriptor), this->GenerateTimeConditions())};
 }
 
 //////////////////////////////////////////////////
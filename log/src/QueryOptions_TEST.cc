@@ -141,6 +141,25 @@ TEST(QueryOptionsTopicPattern, PatternConst)
   EXPECT_FALSE(std::regex_match("bar", uutPattern));
 }
 
+//////////////////////////////////////////////////
+TEST(QueryOptionsTopicPattern, Match)
+{
+  log::TopicPattern topicOption(std::regex("/foo/.*"));
+  EXPECT_TRUE(topicOption.Match("/foo/bar"));
+  EXPECT_FALSE(topicOption.Match("/bar"));
+
+  // The copies share the results.
+  const log::TopicPattern copy(topicOption);
+  EXPECT_TRUE(copy.Match("/foo/bar"));
+  EXPECT_FALSE(copy.Match("/bar"));
+
+  // Modifying the pattern forgets the results.
+  topicOption.Pattern() = std::regex("/bar");
+  EXPECT_FALSE(topicOption.Match("/foo/bar"));
+  EXPECT_TRUE(topicOption.Match("/bar"));
+  EXPECT_TRUE(copy.Match("/foo/bar"));
+}
+
 //////////////////////////////////////////////////
 TEST(QueryOptionsTopicPattern, Copy)
 {
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "RecordArena.hh"
+
+using namespace gz::transport::log;
+
+namespace
+{
+  /// \brief Size of the holes below which the arena is never compacted.
+  const std::size_t kMinCompactBytes = 64 << 10;
+}
+
+//////////////////////////////////////////////////
+void RecordArena::Append(const std::chrono::nanoseconds _stamp,
+    const std::shared_ptr<const RecordedTopic> &_recorded,
+    const char *_data, const std::size_t _len)
+{
+  if (this->end + _len > this->data.size())
+  {
+    this->data.resize(std::max(this->end + _len, 2 * this->data.size()));
+  }
+  if (_len > 0)
+    std::memcpy(this->data.data() + this->end, _data, _len);
+
+  this->records.push_back({_stamp, _recorded, this->end, _len, false});
+  this->end += _len;
+}
+
+//////////////////////////////////////////////////
+std::size_t RecordArena::Front()
+{
+  while (this->head < this->records.size() &&
+         this->records[this->head].dropped)
+  {
+    ++this->head;
+  }
+  return this->head;
+}
+
+//////////////////////////////////////////////////
+void RecordArena::Drop(const std::size_t _index)
+{
+  Record &record = this->records[_index];
+  if (record.dropped)
+    return;
+
+  record.dropped = true;
+  // The topic of the message may not be recorded anymore.
+  record.recorded.reset();
+  ++this->droppedCount;
+  this->droppedBytes += record.len;
+
+  if (this->droppedBytes > kMinCompactBytes &&
+      this->droppedBytes > this->Bytes())
+  {
+    this->Compact();
+  }
+}
+
+//////////////////////////////////////////////////
+const std::vector<RecordArena::Record> &RecordArena::Records() const
+{
+  return this->records;
+}
+
+//////////////////////////////////////////////////
+const char *RecordArena::Data(const Record &_record) const
+{
+  return this->data.data() + _record.offset;
+}
+
+//////////////////////////////////////////////////
+std::size_t RecordArena::Size() const
+{
+  return this->records.size() - this->droppedCount;
+}
+
+//////////////////////////////////////////////////
+bool RecordArena::Empty() const
+{
+  return this->Size() == 0;
+}
+
+//////////////////////////////////////////////////
+std::size_t RecordArena::Bytes() const
+{
+  return this->end - this->droppedBytes;
+}
+
+//////////////////////////////////////////////////
+std::size_t RecordArena::Capacity() const
+{
+  return this->data.size();
+}
+
+//////////////////////////////////////////////////
+void RecordArena::Clear(const std::size_t _maxCapacity)
+{
+  this->records.clear();
+  this->end = 0;
+  this->head = 0;
+  this->droppedCount = 0;
+  this->droppedBytes = 0;
+
+  if (_maxCapacity > 0 && this->data.size() > _maxCapacity)
+  {
+    this->data.clear();
+    this->data.shrink_to_fit();
+  }
+}
+
+//////////////////////////////////////////////////
+void RecordArena::Compact()
+{
+  // The messages keep their order, so their data only moves backwards.
+  std::size_t offset = 0;
+  for (Record &record : this->records)
+  {
+    if (record.dropped)
+      continue;
+    if (record.offset != offset && record.len > 0)
+    {
+      std::memmove(this->data.data() + offset,
+                   this->data.data() + record.offset, record.len);
+    }
+    record.offset = offset;
+    offset += record.len;
+  }
+
+  this->records.erase(std::remove_if(this->records.begin(),
+      this->records.end(), [](const Record &_record)
+      {
+        return _record.dropped;
+      }), this->records.end());
+
+  this->end = offset;
+  this->head = 0;
+  this->droppedCount = 0;
+  this->droppedBytes = 0;
+}
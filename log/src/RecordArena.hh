@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_LOG_RECORDARENA_HH_
+#define GZ_TRANSPORT_LOG_RECORDARENA_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/log/Export.hh"
+
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  /// \brief Topic and message type of the messages of a subscription,
+  /// shared by its messages instead of being copied with each one.
+  /// \internal
+  struct RecordedTopic
+  {
+    /// \brief Name of the topic
+    std::string topic;
+
+    /// \brief Name of the message type
+    std::string type;
+  };
+
+  /// \brief Messages waiting to be written to a log file. Their data is
+  /// appended to a single byte buffer, and the buffers are kept when the
+  /// arena is cleared, so queuing a message doesn't allocate memory once
+  /// the arena has grown to its working size.
+  ///
+  /// A dropped message leaves a hole in the buffer, which is reclaimed when
+  /// the holes hold more bytes than the messages.
+  /// \internal
+  class GZ_TRANSPORT_LOG_VISIBLE RecordArena
+  {
+    /// \brief A message of the arena.
+    public: struct Record
+    {
+      /// \brief Time stamp of when the message was received
+      std::chrono::nanoseconds stamp;
+
+      /// \brief Topic and type of the message
+      std::shared_ptr<const RecordedTopic> recorded;
+
+      /// \brief Offset of the data in the buffer
+      std::size_t offset;
+
+      /// \brief Size of the data
+      std::size_t len;
+
+      /// \brief Whether the message was dropped
+      bool dropped;
+    };
+
+    /// \brief Add a message.
+    /// \param[in] _stamp Time stamp of the message.
+    /// \param[in] _recorded Topic and type of the message.
+    /// \param[in] _data Data of the message.
+    /// \param[in] _len Size of the data.
+    public: void Append(std::chrono::nanoseconds _stamp,
+                        const std::shared_ptr<const RecordedTopic> &_recorded,
+                        const char *_data, std::size_t _len);
+
+    /// \brief Get the index of the oldest message.
+    /// \return The index, or Records().size() if there is no message.
+    public: std::size_t Front();
+
+    /// \brief Drop a message.
+    /// \param[in] _index Index of the message, in Records(). The indices
+    /// of the other messages may change.
+    public: void Drop(std::size_t _index);
+
+    /// \brief Get the messages, including the dropped ones, oldest first.
+    /// \return The messages.
+    public: const std::vector<Record> &Records() const;
+
+    /// \brief Get the data of a message.
+    /// \param[in] _record The message.
+    /// \return Pointer to its data, valid until the arena is modified.
+    public: const char *Data(const Record &_record) const;
+
+    /// \brief Get the number of messages, not counting the dropped ones.
+    /// \return The number of messages.
+    public: std::size_t Size() const;
+
+    /// \brief Check whether there is no message.
+    /// \return True if there is no message.
+    public: bool Empty() const;
+
+    /// \brief Get the size of the messages, not counting the dropped ones.
+    /// \return The number of bytes.
+    public: std::size_t Bytes() const;
+
+    /// \brief Get the size of the byte buffer.
+    /// \return The number of bytes.
+    public: std::size_t Capacity() const;
+
+    /// \brief Remove every message. The buffers are kept unless they are
+    /// larger than a limit.
+    /// \param[in] _maxCapacity Largest byte buffer kept, or 0 to keep it
+    /// whatever its size.
+    public: void Clear(std::size_t _maxCapacity = 0);
+
+    /// \brief Remove the holes left by the dropped messages.
+    private: void Compact();
+
+    /// \brief Data of the messages.
+    private: std::vector<char> data;
+
+    /// \brief Bytes of data used, including the holes.
+    private: std::size_t end = 0;
+
+    /// \brief The messages.
+    private: std::vector<Record> records;
+
+    /// \brief Index of the first message that may not be dropped.
+    private: std::size_t head = 0;
+
+    /// \brief Number of dropped messages.
+    private: std::size_t droppedCount = 0;
+
+    /// \brief Size of the dropped messages.
+    private: std::size_t droppedBytes = 0;
+  };
+}
+}
+}
+}
+#endif
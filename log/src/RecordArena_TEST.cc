@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RecordArena.hh"
+#include "gtest/gtest.h"
+
+using namespace gz::transport::log;
+
+/// \brief Get the data of the messages that weren't dropped.
+/// \param[in] _arena The arena.
+/// \return The data of the messages, oldest first.
+std::vector<std::string> contents(const RecordArena &_arena)
+{
+  std::vector<std::string> result;
+  for (const RecordArena::Record &record : _arena.Records())
+  {
+    if (!record.dropped)
+      result.emplace_back(_arena.Data(record), record.len);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+/// \brief Append, drop and clear messages.
+TEST(RecordArenaTest, Queue)
+{
+  auto recorded = std::make_shared<const RecordedTopic>(
+      RecordedTopic{"/foo", "gz.msgs.StringMsg"});
+
+  RecordArena arena;
+  EXPECT_TRUE(arena.Empty());
+  EXPECT_EQ(0u, arena.Front());
+
+  for (const std::string text : {"a", "bc", "", "def"})
+  {
+    arena.Append(std::chrono::nanoseconds(text.size()), recorded,
+                 text.data(), text.size());
+  }
+  EXPECT_EQ(4u, arena.Size());
+  EXPECT_EQ(6u, arena.Bytes());
+  EXPECT_EQ(std::vector<std::string>({"a", "bc", "", "def"}),
+            contents(arena));
+  EXPECT_EQ("/foo", arena.Records()[1].recorded->topic);
+  EXPECT_EQ(std::chrono::nanoseconds(3), arena.Records()[3].stamp);
+
+  // Drop the oldest message, then one in the middle.
+  arena.Drop(arena.Front());
+  EXPECT_EQ(1u, arena.Front());
+  arena.Drop(2);
+  arena.Drop(2);
+  EXPECT_EQ(2u, arena.Size());
+  EXPECT_EQ(5u, arena.Bytes());
+  EXPECT_EQ(std::vector<std::string>({"bc", "def"}), contents(arena));
+  arena.Drop(arena.Front());
+  EXPECT_EQ(3u, arena.Front());
+
+  // The buffer is kept.
+  const std::size_t capacity = arena.Capacity();
+  EXPECT_LE(6u, capacity);
+  arena.Clear();
+  EXPECT_TRUE(arena.Empty());
+  EXPECT_EQ(0u, arena.Bytes());
+  EXPECT_EQ(capacity, arena.Capacity());
+  arena.Clear(1);
+  EXPECT_EQ(0u, arena.Capacity());
+}
+
+//////////////////////////////////////////////////
+/// \brief The holes of the dropped messages are reclaimed.
+TEST(RecordArenaTest, Compact)
+{
+  auto recorded = std::make_shared<const RecordedTopic>();
+  const std::string big(100 << 10, 'x');
+  RecordArena arena;
+  for (char c = 'a'; c < 'e'; ++c)
+  {
+    const std::string text = c + big;
+    arena.Append(std::chrono::nanoseconds(0), recorded,
+                 text.data(), text.size());
+  }
+
+  arena.Drop(0);
+  arena.Drop(1);
+  EXPECT_EQ(4u, arena.Records().size());
+  arena.Drop(3);
+  EXPECT_EQ(1u, arena.Records().size());
+  EXPECT_EQ(1u, arena.Size());
+  EXPECT_EQ(big.size() + 1, arena.Bytes());
+  EXPECT_EQ(0u, arena.Front());
+  EXPECT_EQ('c' + big, contents(arena).front());
+
+  // The next messages follow the remaining one.
+  arena.Append(std::chrono::nanoseconds(0), recorded, "z", 1);
+  EXPECT_EQ(std::vector<std::string>({'c' + big, "z"}), contents(arena));
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <string_view>
+
+#include "RecordFilter.hh"
+
+using namespace gz::transport::log;
+
+//////////////////////////////////////////////////
+RecordFilter::RecordFilter(const RecordPolicy &_policy)
+  : policy(_policy)
+{
+  if (_policy.maxRate > 0)
+  {
+    this->period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(1.0 / _policy.maxRate));
+  }
+}
+
+//////////////////////////////////////////////////
+const RecordPolicy &RecordFilter::Policy() const
+{
+  return this->policy;
+}
+
+//////////////////////////////////////////////////
+bool RecordFilter::Keep(const char *_data, const std::size_t _len,
+    const std::chrono::nanoseconds _now,
+    const std::optional<std::chrono::nanoseconds> &_trigger)
+{
+  if (!this->policy.triggerTopic.empty() &&
+      (!_trigger || _now < *_trigger ||
+       _now - *_trigger > this->policy.triggerWindow))
+  {
+    return false;
+  }
+
+  if (this->policy.onChange && this->recorded &&
+      std::string_view(_data, _len) == this->lastData)
+  {
+    return false;
+  }
+
+  // A clock that goes back, such as a simulation clock after a reset,
+  // doesn't block the recording.
+  if (this->recorded && this->period.count() > 0 &&
+      _now >= this->lastTime && _now - this->lastTime < this->period)
+  {
+    return false;
+  }
+
+  const uint64_t n = this->policy.keepEveryNth;
+  if (n > 1 && this->count++ % n != 0)
+    return false;
+
+  this->recorded = true;
+  this->lastTime = _now;
+  if (this->policy.onChange)
+    this->lastData.assign(_data, _len);
+  return true;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_LOG_RECORDFILTER_HH_
+#define GZ_TRANSPORT_LOG_RECORDFILTER_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/log/Export.hh"
+#include "gz/transport/log/Recorder.hh"
+
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  /// \brief Applies the policy of a topic to its messages.
+  /// \internal
+  class GZ_TRANSPORT_LOG_VISIBLE RecordFilter
+  {
+    /// \brief Constructor.
+    /// \param[in] _policy The policy.
+    public: explicit RecordFilter(const RecordPolicy &_policy);
+
+    /// \brief Get the policy.
+    /// \return The policy.
+    public: const RecordPolicy &Policy() const;
+
+    /// \brief Check whether a message must be recorded, and remember it if
+    /// so.
+    /// \param[in] _data Data of the message.
+    /// \param[in] _len Size of the data.
+    /// \param[in] _now Time of reception of the message.
+    /// \param[in] _trigger Time of the last message of the trigger topic,
+    /// if one was received.
+    /// \return True if the message must be recorded.
+    public: bool Keep(const char *_data, std::size_t _len,
+                      std::chrono::nanoseconds _now,
+                      const std::optional<std::chrono::nanoseconds> &_trigger);
+
+    /// \brief The policy.
+    private: RecordPolicy policy;
+
+    /// \brief Minimum time between two recorded messages.
+    private: std::chrono::nanoseconds period{0};
+
+    /// \brief Whether a message was recorded.
+    private: bool recorded = false;
+
+    /// \brief Time of the last recorded message.
+    private: std::chrono::nanoseconds lastTime{0};
+
+    /// \brief Data of the last recorded message, if onChange is set.
+    private: std::string lastData;
+
+    /// \brief Messages that met the conditions other than keepEveryNth.
+    private: uint64_t count = 0;
+  };
+}
+}
+}
+}
+#endif
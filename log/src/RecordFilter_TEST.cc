@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "RecordFilter.hh"
+#include "gtest/gtest.h"
+
+using namespace gz::transport::log;
+using namespace std::chrono_literals;
+
+/// \brief Check whether a message must be recorded.
+/// \param[in] _filter The filter.
+/// \param[in] _data Data of the message.
+/// \param[in] _now Time of reception.
+/// \param[in] _trigger Time of the last trigger message.
+/// \return True if the message must be recorded.
+bool keep(RecordFilter &_filter, const std::string &_data,
+          std::chrono::nanoseconds _now,
+          std::optional<std::chrono::nanoseconds> _trigger = std::nullopt)
+{
+  return _filter.Keep(_data.data(), _data.size(), _now, _trigger);
+}
+
+//////////////////////////////////////////////////
+/// \brief The default policy records every message.
+TEST(RecordFilterTest, Default)
+{
+  RecordFilter filter{RecordPolicy()};
+  EXPECT_EQ(RecordPolicy(), filter.Policy());
+  EXPECT_TRUE(keep(filter, "a", 0s));
+  EXPECT_TRUE(keep(filter, "a", 0s));
+  EXPECT_TRUE(keep(filter, "b", 1ms));
+}
+
+//////////////////////////////////////////////////
+/// \brief Limit the rate.
+TEST(RecordFilterTest, MaxRate)
+{
+  RecordPolicy policy;
+  policy.maxRate = 10;
+  RecordFilter filter(policy);
+  EXPECT_TRUE(keep(filter, "a", 1s));
+  EXPECT_FALSE(keep(filter, "a", 1s + 50ms));
+  EXPECT_FALSE(keep(filter, "a", 1s + 99ms));
+  EXPECT_TRUE(keep(filter, "a", 1s + 100ms));
+  EXPECT_FALSE(keep(filter, "a", 1s + 150ms));
+
+  // A clock that goes back doesn't block the recording.
+  EXPECT_TRUE(keep(filter, "a", 0s));
+}
+
+//////////////////////////////////////////////////
+/// \brief Keep one message out of N.
+TEST(RecordFilterTest, KeepEveryNth)
+{
+  RecordPolicy policy;
+  policy.keepEveryNth = 3;
+  RecordFilter filter(policy);
+  int kept = 0;
+  for (int i = 0; i < 9; ++i)
+    kept += keep(filter, "a", 0s);
+  EXPECT_EQ(3, kept);
+}
+
+//////////////////////////////////////////////////
+/// \brief Skip the messages that didn't change.
+TEST(RecordFilterTest, OnChange)
+{
+  RecordPolicy policy;
+  policy.onChange = true;
+  RecordFilter filter(policy);
+  EXPECT_TRUE(keep(filter, "a", 0s));
+  EXPECT_FALSE(keep(filter, "a", 1s));
+  EXPECT_TRUE(keep(filter, "ab", 2s));
+  EXPECT_TRUE(keep(filter, "a", 3s));
+  EXPECT_TRUE(keep(filter, "", 4s));
+  EXPECT_FALSE(keep(filter, "", 5s));
+}
+
+//////////////////////////////////////////////////
+/// \brief Record in the windows opened by a trigger topic.
+TEST(RecordFilterTest, Trigger)
+{
+  RecordPolicy policy;
+  policy.triggerTopic = "/trigger";
+  policy.triggerWindow = 1s;
+  RecordFilter filter(policy);
+  EXPECT_FALSE(keep(filter, "a", 0s));
+  EXPECT_TRUE(keep(filter, "a", 10s, 9500ms));
+  EXPECT_TRUE(keep(filter, "a", 10s, 9s));
+  EXPECT_FALSE(keep(filter, "a", 10s + 1ms, 9s));
+  EXPECT_FALSE(keep(filter, "a", 10s, 11s));
+}
+
+//////////////////////////////////////////////////
+/// \brief The conditions are combined.
+TEST(RecordFilterTest, Combined)
+{
+  RecordPolicy policy;
+  policy.onChange = true;
+  policy.keepEveryNth = 2;
+  RecordFilter filter(policy);
+
+  // The duplicates aren't counted by keepEveryNth.
+  EXPECT_TRUE(keep(filter, "a", 0s));
+  EXPECT_FALSE(keep(filter, "a", 0s));
+  EXPECT_FALSE(keep(filter, "b", 0s));
+  EXPECT_TRUE(keep(filter, "c", 0s));
+  EXPECT_FALSE(keep(filter, "c", 0s));
+  EXPECT_FALSE(keep(filter, "d", 0s));
+
+  // Equivalent policies are equal.
+  RecordPolicy other = policy;
+  EXPECT_EQ(policy, other);
+  other.keepEveryNth = 0;
+  policy.keepEveryNth = 1;
+  EXPECT_EQ(policy, other);
+  other.maxRate = 1;
+  EXPECT_NE(policy, other);
+}
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <cstdint>
+
+#include "gz/transport/log/RecordOptions.hh"
+#include "Compression.hh"
+
+using namespace gz::transport;
+using namespace gz::transport::log;
+
+/// \brief Private implementation
+class gz::transport::log::RecordOptions::Implementation
+{
+  /// \brief Journal mode.
+  public: JournalMode journal = JournalMode::ROLLBACK;
+
+  /// \brief Synchronous mode.
+  public: log::Synchronous synchronous = log::Synchronous::FULL;
+
+  /// \brief Page size (bytes), 0 for the SQLite default.
+  public: uint32_t pageSize = 0;
+
+  /// \brief Cache size (KiB), 0 for the SQLite default.
+  public: uint64_t cacheSize = 0;
+
+  /// \brief Preallocation size (bytes), 0 for the default of the format.
+  public: uint64_t preallocateSize = 0;
+
+  /// \brief Auto-vacuum mode of new log files.
+  public: log::AutoVacuum autoVacuum = log::AutoVacuum::NONE;
+
+  /// \brief Maximum duration of a transaction.
+  public: std::chrono::milliseconds transactionPeriod{500};
+
+  /// \brief Format of new log files.
+  public: LogFormat format = LogFormat::SQLITE;
+
+  /// \brief Uncompressed size of a chunk (bytes).
+  public: uint64_t chunkSize = 4u << 20;
+
+  /// \brief Codec of the chunks.
+  public: Compression_t chunkCompression = Compression_t::NONE;
+
+  /// \brief Compression level of the chunks.
+  public: int chunkCompressionLevel = 0;
+
+  /// \brief Number of threads compressing the chunks.
+  public: uint32_t compressionThreads = 0;
+
+  /// \brief Size of the messages of a file of a split recording (bytes).
+  public: uint64_t splitSize = 0;
+
+  /// \brief Duration of a file of a split recording.
+  public: std::chrono::milliseconds splitDuration{0};
+
+  /// \brief Whether the chunked log files bypass the page cache.
+  public: bool directWrites = false;
+
+  /// \brief Whether identical messages of a chunk are stored once.
+  public: bool deduplicate = false;
+
+  /// \brief Whether messages are delta encoded against their topic.
+  public: bool deltaEncode = false;
+
+  /// \brief Number of messages a dictionary is trained from, 0 to not
+  /// compress the messages with dictionaries.
+  public: uint32_t dictionaryMessages = 0;
+
+  /// \brief Compression level of the messages compressed with dictionaries.
+  public: int dictionaryCompressionLevel = 0;
+};
+
+//////////////////////////////////////////////////
+RecordOptions::RecordOptions()
+  : dataPtr(new Implementation)
+{
+}
+
+//////////////////////////////////////////////////
+RecordOptions::RecordOptions(const RecordOptions &_other)
+  : dataPtr(new Implementation(*_other.dataPtr))
+{
+}
+
+//////////////////////////////////////////////////
+RecordOptions::~RecordOptions()
+{
+}
+
+//////////////////////////////////////////////////
+RecordOptions &RecordOptions::operator=(const RecordOptions &_other)
+{
+  *this->dataPtr = *_other.dataPtr;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::operator==(const RecordOptions &_other) const
+{
+  return this->Journal() == _other.Journal() &&
+    this->Synchronous() == _other.Synchronous() &&
+    this->PageSize() == _other.PageSize() &&
+    this->CacheSize() == _other.CacheSize() &&
+    this->PreallocateSize() == _other.PreallocateSize() &&
+    this->AutoVacuum() == _other.AutoVacuum() &&
+    this->TransactionPeriod() == _other.TransactionPeriod() &&
+    this->Format() == _other.Format() &&
+    this->ChunkSize() == _other.ChunkSize() &&
+    this->ChunkCompression() == _other.ChunkCompression() &&
+    this->ChunkCompressionLevel() == _other.ChunkCompressionLevel() &&
+    this->CompressionThreads() == _other.CompressionThreads() &&
+    this->SplitSize() == _other.SplitSize() &&
+    this->SplitDuration() == _other.SplitDuration() &&
+    this->DirectWrites() == _other.DirectWrites() &&
+    this->Deduplicate() == _other.Deduplicate() &&
+    this->DeltaEncode() == _other.DeltaEncode() &&
+    this->DictionaryMessages() == _other.DictionaryMessages() &&
+    this->DictionaryCompressionLevel() ==
+      _other.DictionaryCompressionLevel();
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::operator!=(const RecordOptions &_other) const
+{
+  return !(*this == _other);
+}
+
+//////////////////////////////////////////////////
+JournalMode RecordOptions::Journal() const
+{
+  return this->dataPtr->journal;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetJournal(const JournalMode _mode)
+{
+  this->dataPtr->journal = _mode;
+}
+
+//////////////////////////////////////////////////
+log::Synchronous RecordOptions::Synchronous() const
+{
+  return this->dataPtr->synchronous;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetSynchronous(const log::Synchronous _mode)
+{
+  this->dataPtr->synchronous = _mode;
+}
+
+//////////////////////////////////////////////////
+uint32_t RecordOptions::PageSize() const
+{
+  return this->dataPtr->pageSize;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::SetPageSize(const uint32_t _size)
+{
+  const bool powerOfTwo = (_size & (_size - 1)) == 0;
+  if (_size != 0 && (_size < 512 || _size > 65536 || !powerOfTwo))
+    return false;
+
+  this->dataPtr->pageSize = _size;
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t RecordOptions::CacheSize() const
+{
+  return this->dataPtr->cacheSize;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetCacheSize(const uint64_t _size)
+{
+  this->dataPtr->cacheSize = _size;
+}
+
+//////////////////////////////////////////////////
+uint64_t RecordOptions::PreallocateSize() const
+{
+  return this->dataPtr->preallocateSize;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetPreallocateSize(const uint64_t _size)
+{
+  this->dataPtr->preallocateSize = _size;
+}
+
+//////////////////////////////////////////////////
+log::AutoVacuum RecordOptions::AutoVacuum() const
+{
+  return this->dataPtr->autoVacuum;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetAutoVacuum(const log::AutoVacuum _mode)
+{
+  this->dataPtr->autoVacuum = _mode;
+}
+
+//////////////////////////////////////////////////
+std::chrono::milliseconds RecordOptions::TransactionPeriod() const
+{
+  return this->dataPtr->transactionPeriod;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetTransactionPeriod(
+    const std::chrono::milliseconds &_period)
+{
+  this->dataPtr->transactionPeriod = _period;
+}
+
+//////////////////////////////////////////////////
+LogFormat RecordOptions::Format() const
+{
+  return this->dataPtr->format;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetFormat(const LogFormat _format)
+{
+  this->dataPtr->format = _format;
+}
+
+//////////////////////////////////////////////////
+uint64_t RecordOptions::ChunkSize() const
+{
+  return this->dataPtr->chunkSize;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetChunkSize(const uint64_t _size)
+{
+  this->dataPtr->chunkSize = _size;
+}
+
+//////////////////////////////////////////////////
+Compression_t RecordOptions::ChunkCompression() const
+{
+  return this->dataPtr->chunkCompression;
+}
+
+//////////////////////////////////////////////////
+int RecordOptions::ChunkCompressionLevel() const
+{
+  return this->dataPtr->chunkCompressionLevel;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::SetChunkCompression(const Compression_t _codec,
+    const int _level)
+{
+  if (!Compression::Supported(_codec))
+    return false;
+
+  this->dataPtr->chunkCompression = _codec;
+  this->dataPtr->chunkCompressionLevel = _level;
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint32_t RecordOptions::CompressionThreads() const
+{
+  return this->dataPtr->compressionThreads;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetCompressionThreads(const uint32_t _threads)
+{
+  this->dataPtr->compressionThreads = _threads;
+}
+
+//////////////////////////////////////////////////
+uint64_t RecordOptions::SplitSize() const
+{
+  return this->dataPtr->splitSize;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetSplitSize(const uint64_t _size)
+{
+  this->dataPtr->splitSize = _size;
+}
+
+//////////////////////////////////////////////////
+std::chrono::milliseconds RecordOptions::SplitDuration() const
+{
+  return this->dataPtr->splitDuration;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetSplitDuration(
+    const std::chrono::milliseconds &_duration)
+{
+  this->dataPtr->splitDuration = _duration;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::DirectWrites() const
+{
+  return this->dataPtr->directWrites;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetDirectWrites(const bool _direct)
+{
+  this->dataPtr->directWrites = _direct;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::Deduplicate() const
+{
+  return this->dataPtr->deduplicate;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetDeduplicate(const bool _deduplicate)
+{
+  this->dataPtr->deduplicate = _deduplicate;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::DeltaEncode() const
+{
+  return this->dataPtr->deltaEncode;
+}
+
+//////////////////////////////////////////////////
+void RecordOptions::SetDeltaEncode(const bool _delta)
+{
+  this->dataPtr->deltaEncode = _delta;
+}
+
+//////////////////////////////////////////////////
+uint32_t RecordOptions::DictionaryMessages() const
+{
+  return this->dataPtr->dictionaryMessages;
+}
+
+//////////////////////////////////////////////////
+int RecordOptions::DictionaryCompressionLevel() const
+{
+  return this->dataPtr->dictionaryCompressionLevel;
+}
+
+//////////////////////////////////////////////////
+bool RecordOptions::SetDictionaryCompression(const uint32_t _messages,
+    const int _level)
+{
+  if (_messages > 0 && !Compression::Supported(Compression_t::ZSTD))
+    return false;
+
+  this->dataPtr->dictionaryMessages = _messages;
+  this->dataPtr->dictionaryCompressionLevel = _level;
+  return true;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+
+#include "gz/transport/log/RecordOptions.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+using namespace log;
+
+//////////////////////////////////////////////////
+/// \brief Check the default values and the accessors.
+TEST(RecordOptionsTest, Accessors)
+{
+  RecordOptions opts;
+  EXPECT_EQ(JournalMode::ROLLBACK, opts.Journal());
+  EXPECT_EQ(Synchronous::FULL, opts.Synchronous());
+  EXPECT_EQ(0u, opts.PageSize());
+  EXPECT_EQ(0u, opts.CacheSize());
+  EXPECT_EQ(std::chrono::milliseconds(500), opts.TransactionPeriod());
+
+  opts.SetJournal(JournalMode::WAL);
+  EXPECT_EQ(JournalMode::WAL, opts.Journal());
+  opts.SetSynchronous(Synchronous::NORMAL);
+  EXPECT_EQ(Synchronous::NORMAL, opts.Synchronous());
+  EXPECT_TRUE(opts.SetPageSize(65536));
+  EXPECT_EQ(65536u, opts.PageSize());
+  opts.SetCacheSize(64 * 1024);
+  EXPECT_EQ(64u * 1024u, opts.CacheSize());
+  opts.SetTransactionPeriod(std::chrono::seconds(2));
+  EXPECT_EQ(std::chrono::milliseconds(2000), opts.TransactionPeriod());
+
+  // Invalid page sizes are rejected.
+  EXPECT_FALSE(opts.SetPageSize(256));
+  EXPECT_FALSE(opts.SetPageSize(3000));
+  EXPECT_FALSE(opts.SetPageSize(131072));
+  EXPECT_EQ(65536u, opts.PageSize());
+  EXPECT_TRUE(opts.SetPageSize(0));
+  EXPECT_EQ(0u, opts.PageSize());
+
+  EXPECT_EQ(0u, opts.PreallocateSize());
+  EXPECT_EQ(AutoVacuum::NONE, opts.AutoVacuum());
+  opts.SetPreallocateSize(16u << 20);
+  EXPECT_EQ(16u << 20, opts.PreallocateSize());
+  opts.SetAutoVacuum(AutoVacuum::INCREMENTAL);
+  EXPECT_EQ(AutoVacuum::INCREMENTAL, opts.AutoVacuum());
+
+  EXPECT_EQ(LogFormat::SQLITE, opts.Format());
+  EXPECT_EQ(4u * 1024u * 1024u, opts.ChunkSize());
+  EXPECT_EQ(Compression_t::NONE, opts.ChunkCompression());
+  opts.SetFormat(LogFormat::CHUNKED);
+  EXPECT_EQ(LogFormat::CHUNKED, opts.Format());
+  opts.SetChunkSize(1024u);
+  EXPECT_EQ(1024u, opts.ChunkSize());
+  EXPECT_TRUE(opts.SetChunkCompression(Compression_t::NONE));
+  EXPECT_EQ(Compression_t::NONE, opts.ChunkCompression());
+  EXPECT_EQ(0u, opts.CompressionThreads());
+  opts.SetCompressionThreads(4u);
+  EXPECT_EQ(4u, opts.CompressionThreads());
+
+  EXPECT_EQ(0u, opts.SplitSize());
+  EXPECT_EQ(std::chrono::milliseconds(0), opts.SplitDuration());
+  opts.SetSplitSize(1u << 30);
+  EXPECT_EQ(1u << 30, opts.SplitSize());
+  opts.SetSplitDuration(std::chrono::minutes(10));
+  EXPECT_EQ(std::chrono::minutes(10), opts.SplitDuration());
+
+  EXPECT_FALSE(opts.DirectWrites());
+  opts.SetDirectWrites(true);
+  EXPECT_TRUE(opts.DirectWrites());
+
+  EXPECT_FALSE(opts.Deduplicate());
+  EXPECT_FALSE(opts.DeltaEncode());
+  opts.SetDeduplicate(true);
+  opts.SetDeltaEncode(true);
+  EXPECT_TRUE(opts.Deduplicate());
+  EXPECT_TRUE(opts.DeltaEncode());
+
+  EXPECT_EQ(0u, opts.DictionaryMessages());
+  EXPECT_TRUE(opts.SetDictionaryCompression(0u));
+  if (opts.SetDictionaryCompression(100u, 5))
+  {
+    EXPECT_EQ(100u, opts.DictionaryMessages());
+    EXPECT_EQ(5, opts.DictionaryCompressionLevel());
+  }
+  else
+  {
+    EXPECT_EQ(0u, opts.DictionaryMessages());
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the copy constructor, assignment and comparison.
+TEST(RecordOptionsTest, CopyAssignCompare)
+{
+  RecordOptions opts;
+  opts.SetJournal(JournalMode::OFF);
+  opts.SetSynchronous(Synchronous::OFF);
+
+  RecordOptions copy(opts);
+  EXPECT_EQ(opts, copy);
+  EXPECT_EQ(JournalMode::OFF, copy.Journal());
+
+  RecordOptions other;
+  EXPECT_NE(opts, other);
+  other = opts;
+  EXPECT_EQ(opts, other);
+
+  other.SetTransactionPeriod(std::chrono::milliseconds(0));
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetFormat(LogFormat::CHUNKED);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetCompressionThreads(2u);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetSplitSize(1024u);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetDirectWrites(true);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetPreallocateSize(1u << 20);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetAutoVacuum(AutoVacuum::FULL);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetDeduplicate(true);
+  EXPECT_NE(opts, other);
+
+  other = opts;
+  other.SetDeltaEncode(true);
+  EXPECT_NE(opts, other);
+}
@@ -15,15 +15,21 @@
  *
 */
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
-#include <deque>
+#include <filesystem>
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <regex>
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 #include <thread>
@@ -38,6 +44,9 @@
 
 #include "Console.hh"
 #include "raii-sqlite3.hh"
+#include "RecordArena.hh"
+#include "RecordFilter.hh"
+#include "TopicMatcher.hh"
 #include "build_config.hh"
 
 using namespace gz::transport;
@@ -46,21 +55,12 @@ using namespace gz::transport::log;
 /// \brief Private implementation
 class gz::transport::log::Recorder::Implementation
 {
-  /// \brief Data type stored in dataQueue
-  public: struct LogData
+  /// \brief State of the subscription to a topic
+  public: struct Subscription
   {
-    /// \brief Constructor
-    LogData(std::chrono::nanoseconds _stamp, std::vector<char> &&_msgData, // NOLINT
-            const transport::MessageInfo &_msgInfo)
-        : stamp(_stamp), msgData(std::move(_msgData)), msgInfo(_msgInfo)
-    {
-    }
-    /// \brief Time stamp of when the message was received by the log recorder
-    std::chrono::nanoseconds stamp;
-    /// Serialized message data
-    std::vector<char> msgData;
-    /// Extra information about the message, such as its topic.
-    transport::MessageInfo msgInfo;
+    /// \brief Topic and type of the last message received, protected by
+    /// dataQueueMutex
+    std::shared_ptr<const RecordedTopic> recorded;
   };
 
   /// \brief constructor
@@ -70,10 +70,12 @@ class gz::transport::log::Recorder::Implementation
   public: ~Implementation();
 
   /// \brief Subscriber callback
+  /// \param[in] _subscription The subscription of the topic
   /// \param[in] _data Data of the message
   /// \param[in] _len The size of the message data
   /// \param[in] _info The meta-info of the message
   public: void OnMessageReceived(
+          Subscription &_subscription,
           const char *_data,
           std::size_t _len,
           const transport::MessageInfo &_info);
@@ -98,22 +100,80 @@ class gz::transport::log::Recorder::Implementation
   /// \brief Stop the data writer thread
   public: void StopDataWriter();
 
-  /// \brief Decrement buffer size by given amount
-  /// \param[in] _len The amount to decrement
-  public: void DecrementBufferSize(std::size_t _len);
+  /// \brief Make room in the buffer for a message, as set by the overflow
+  /// policy. Must be called with dataQueueMutex locked.
+  /// \param[in,out] _lock Lock of dataQueueMutex.
+  /// \param[in] _len The size of the message data
+  /// \param[in] _topic The topic of the message
+  /// \return False if the message must be dropped.
+  public: bool MakeRoom(std::unique_lock<std::mutex> &_lock,
+                        std::size_t _len, const std::string &_topic);
+
+  /// \brief Whether a message doesn't fit in the buffer. Must be called
+  /// with dataQueueMutex locked.
+  /// \param[in] _len The size of the message data
+  /// \return True if the message doesn't fit.
+  public: bool BufferFull(std::size_t _len) const;
+
+  /// \brief Count a dropped message. Must be called with dataQueueMutex
+  /// locked.
+  /// \param[in] _topic The topic of the message
+  /// \param[in] _len The size of the message data
+  public: void CountDrop(const std::string &_topic, std::size_t _len);
+
+  /// \brief Check whether a message must be recorded, as set by the policy
+  /// of its topic.
+  /// \param[in] _topic The topic of the message
+  /// \param[in] _data Data of the message
+  /// \param[in] _len The size of the message data
+  /// \return False if the message must be skipped.
+  public: bool KeepMessage(const std::string &_topic, const char *_data,
+                           std::size_t _len);
 
   /// \brief Write any data left in the queue to the log file
   public: void FlushDataQueue();
 
-  /// \brief Write data to log file
+  /// \brief Write data to log file in one batch
   /// \param[in] _logData data to be written
-  public: void WriteToLogFile(const LogData &_logData);
+  public: void WriteToLogFile(const RecordArena &_logData);
+
+  /// \brief Start opening the next file of a split recording in the
+  /// background.
+  public: void PrepareNextFile();
+
+  /// \brief Continue the recording in the next file. Must be called with
+  /// logFileMutex locked.
+  public: void NextFile();
+
+  /// \brief Whether the current file of a split recording is complete.
+  /// \return True if the recording must continue in the next file.
+  public: bool FileComplete() const;
 
   /// \brief log file or nullptr if not recording
   public: std::unique_ptr<Log> logFile;
 
-  /// \brief A set of topic patterns that we want to subscribe to
-  public: std::vector<std::regex> patterns;
+  /// \brief Options of the log files
+  public: RecordOptions options;
+
+  /// \brief Path given to Start(), which is the path of the first file
+  public: std::string baseFile;
+
+  /// \brief Index of the current file of a split recording
+  public: std::size_t fileIndex = 0;
+
+  /// \brief Size of the messages written to the current file (bytes)
+  public: uint64_t fileBytes = 0;
+
+  /// \brief When the recording started in the current file
+  public: std::chrono::steady_clock::time_point fileStart;
+
+  /// \brief Next file of a split recording, opened in the background so the
+  /// writer doesn't wait for it when the current file is complete
+  public: std::future<std::unique_ptr<Log>> nextLogFile;
+
+  /// \brief A set of topic patterns that we want to subscribe to. Each
+  /// discovered topic is matched once.
+  public: TopicMatcher patterns;
 
   /// \brief A set of topic names that we have already subscribed to. When new
   /// publishers advertise topics that we are already subscribed to, our
@@ -132,9 +192,6 @@ class gz::transport::log::Recorder::Implementation
   /// \brief Clock to synchronize and stamp messages with.
   public: const Clock *clock;
 
-  /// \brief callback used on every subscriber
-  public: RawCallback rawCallback;
-
   /// \brief Object for discovering new publishers as they advertise themselves
   public: std::unique_ptr<MsgDiscovery> discovery;
 
@@ -142,21 +199,20 @@ class gz::transport::log::Recorder::Implementation
   /// from topic callbacks.
   public: std::atomic<std::size_t> maxBufferSize{1000<<20};
 
-  /// \brief Current size of the buffer (in bytes). This is computed everytime
-  /// data is added or removed from the queue. Because of that, we'll use
-  /// `dataQueueMutex` to protect it.
-  public: std::size_t bufferSize{0};
-
   /// \brief This is a temporary FIFO queue that is used to store data from
   /// callbacks until they are written to disk. If the queue fills up before
   /// the dataWriter thread has a chance to process it, old data will be
   /// overwritten. Thus, it is important to set the queue size appropriately for
   /// your application. The maximum size of this queue is determined by
-  /// `maxBufferSize`. The current size of the buffer is calculated from
-  /// `msgData`.
-  public: std::deque<LogData> dataQueue;
+  /// `maxBufferSize`. The messages are copied into a single buffer, which is
+  /// swapped with writtenQueue by the dataWriter thread.
+  public: RecordArena dataQueue;
+
+  /// \brief Messages being written by the dataWriter thread. Once written,
+  /// the arena is cleared and its buffers are reused for the next batch.
+  public: RecordArena writtenQueue;
 
-  /// \brief Mutex to synchronize access to dataQueue and bufferSize
+  /// \brief Mutex to synchronize access to dataQueue
   public: std::mutex dataQueueMutex;
 
   /// \brief Condition variable to synchronize access to dataQueue
@@ -174,19 +230,64 @@ class gz::transport::log::Recorder::Implementation
   /// \brief Whether the OnMessageReceived should stop queuing received
   /// messages. This will be set to true when `Recorder::Stop` is called
   public: std::atomic<bool> stopQueue{false};
+
+  /// \brief What to do with a message that doesn't fit in the buffer.
+  public: std::atomic<log::OverflowPolicy> overflowPolicy{
+    log::OverflowPolicy::DROP_OLDEST};
+
+  /// \brief Topics kept by the PRIORITIZE policy, protected by
+  /// dataQueueMutex.
+  public: std::set<std::string> priorityTopics;
+
+  /// \brief Signals the callbacks blocked by the BLOCK policy that the
+  /// buffer has room.
+  public: std::condition_variable roomCondVar;
+
+  /// \brief Received and dropped counters of the recording, protected by
+  /// dataQueueMutex.
+  public: RecorderStatistics queueStats;
+
+  /// \brief Write counters of the recording, protected by statsMutex.
+  public: RecorderStatistics writeStats;
+
+  /// \brief Mutex to protect writeStats and the write rate window.
+  public: mutable std::mutex statsMutex;
+
+  /// \brief Start of the current write rate window.
+  public: std::chrono::steady_clock::time_point rateStart;
+
+  /// \brief Bytes written in the current write rate window.
+  public: uint64_t rateBytes = 0;
+
+  /// \brief Whether a topic has a policy, to skip policyMutex otherwise.
+  public: std::atomic<bool> hasPolicies{false};
+
+  /// \brief Policies of the topics, protected by policyMutex.
+  public: std::map<std::string, RecordFilter> policies;
+
+  /// \brief Time of the last message of each trigger topic of the
+  /// policies, protected by policyMutex.
+  public: std::map<std::string, std::optional<std::chrono::nanoseconds>>
+    triggers;
+
+  /// \brief Messages skipped by the policies, protected by policyMutex.
+  public: uint64_t skippedMessages = 0;
+
+  /// \brief Mutex to protect policies, triggers and skippedMessages.
+  public: mutable std::mutex policyMutex;
 };
 
+namespace
+{
+  /// \brief Duration of the window of the write rate.
+  const std::chrono::seconds kRateWindow(1);
+}
+
 //////////////////////////////////////////////////
 Recorder::Implementation::Implementation()
 {
   // Use wall clock for synchronization by default.
   this->clock = WallClock::Instance();
-  // Make a lambda to wrap a member function callback
-  this->rawCallback = [this](
-      const char *_data, std::size_t _len, const transport::MessageInfo &_info)
-  {
-    this->OnMessageReceived(_data, _len, _info);
-  };
 
   auto shared = NodeShared::Instance();
 
@@ -210,6 +311,7 @@ Recorder::Implementation::~Implementation()
 
 //////////////////////////////////////////////////
 void Recorder::Implementation::OnMessageReceived(
+          Subscription &_subscription,
           const char *_data,
           std::size_t _len,
           const MessageInfo &_info)
@@ -224,30 +326,137 @@ void Recorder::Implementation::OnMessageReceived(
   // happens when Recorder::Start is called.
   if (this->dataWriterState)
   {
-    std::vector<char> tmp(_data, _data+_len);
+    if (!this->KeepMessage(_info.Topic(), _data, _len))
+      return;
 
-    std::lock_guard<std::mutex> lock(this->dataQueueMutex);
-    // If the maxBufferSize is zero, we have an infinite queue
-    if (this->maxBufferSize > 0)
+    std::unique_lock<std::mutex> lock(this->dataQueueMutex);
+    ++this->queueStats.receivedMessages;
+    if (!this->MakeRoom(lock, _len, _info.Topic()))
     {
-      // Only pop if we have a message in the queue.
-      if ((this->bufferSize + _len > this->maxBufferSize) &&
-          !this->dataQueue.empty())
-      {
-        this->DecrementBufferSize(this->dataQueue.front().msgData.size());
-        this->dataQueue.pop_front();
-      }
+      this->CountDrop(_info.Topic(), _len);
+      return;
+    }
+
+    // The topic and type are shared by the messages of the subscription
+    if (!_subscription.recorded ||
+        _subscription.recorded->type != _info.Type())
+    {
+      _subscription.recorded = std::make_shared<const RecordedTopic>(
+          RecordedTopic{_info.Topic(), _info.Type()});
     }
 
-    this->bufferSize += _len;
     // If the message being added here is larger than maxBufferSize, it should
     // still be recorded. It just means that the buffer cannot hold another
-    // message until it is recorded.
-    this->dataQueue.emplace_back(this->clock->Time(), std::move(tmp), _info);
+    // message until it is recorded. The arena usually has room for the
+    // message, left by the messages already written.
+    this->dataQueue.Append(this->clock->Time(), _subscription.recorded,
+        _data, _len);
     this->dataQueueCondVar.notify_one();
   }
 }
 
+//////////////////////////////////////////////////
+bool Recorder::Implementation::KeepMessage(const std::string &_topic,
+    const char *_data, const std::size_t _len)
+{
+  if (!this->hasPolicies)
+    return true;
+
+  const std::chrono::nanoseconds now = this->clock->Time();
+  std::lock_guard<std::mutex> lock(this->policyMutex);
+  auto trigger = this->triggers.find(_topic);
+  if (trigger != this->triggers.end())
+    trigger->second = now;
+
+  auto it = this->policies.find(_topic);
+  if (it == this->policies.end())
+    return true;
+
+  std::optional<std::chrono::nanoseconds> triggerTime;
+  trigger = this->triggers.find(it->second.Policy().triggerTopic);
+  if (trigger != this->triggers.end())
+    triggerTime = trigger->second;
+
+  if (it->second.Keep(_data, _len, now, triggerTime))
+    return true;
+
+  ++this->skippedMessages;
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool Recorder::Implementation::BufferFull(const std::size_t _len) const
+{
+  // If the maxBufferSize is zero, we have an infinite queue. A message larger
+  // than maxBufferSize is still recorded when the queue is empty.
+  return this->maxBufferSize > 0 && !this->dataQueue.Empty() &&
+    this->dataQueue.Bytes() + _len > this->maxBufferSize;
+}
+
+//////////////////////////////////////////////////
+bool Recorder::Implementation::MakeRoom(std::unique_lock<std::mutex> &_lock,
+    const std::size_t _len, const std::string &_topic)
+{
+  if (!this->BufferFull(_len))
+    return true;
+
+  auto drop = [this](const std::size_t _index)
+  {
+    const RecordArena::Record &record = this->dataQueue.Records()[_index];
+    this->CountDrop(record.recorded->topic, record.len);
+    this->dataQueue.Drop(_index);
+  };
+
+  switch (this->overflowPolicy)
+  {
+    case log::OverflowPolicy::DROP_NEWEST:
+      return false;
+    case log::OverflowPolicy::BLOCK:
+      this->roomCondVar.wait(_lock, [this, _len]
+          {
+            return !this->BufferFull(_len) || !this->dataWriterState ||
+              this->overflowPolicy != log::OverflowPolicy::BLOCK;
+          });
+      // The recording stopped while waiting.
+      if (!this->dataWriterState)
+        return false;
+      // The policy may have changed while waiting.
+      return this->MakeRoom(_lock, _len, _topic);
+    case log::OverflowPolicy::PRIORITIZE:
+    {
+      const auto &records = this->dataQueue.Records();
+      for (std::size_t i = this->dataQueue.Front(); i < records.size(); ++i)
+      {
+        if (!records[i].dropped &&
+            this->priorityTopics.count(records[i].recorded->topic) == 0)
+        {
+          drop(i);
+          return true;
+        }
+      }
+      if (this->priorityTopics.count(_topic) == 0)
+        return false;
+      drop(this->dataQueue.Front());
+      return true;
+    }
+    case log::OverflowPolicy::DROP_OLDEST:
+    default:
+      // Only pop one message, as before: the message is recorded even if the
+      // buffer is still over its size.
+      drop(this->dataQueue.Front());
+      return true;
+  }
+}
+
+//////////////////////////////////////////////////
+void Recorder::Implementation::CountDrop(const std::string &_topic,
+                                         const std::size_t _len)
+{
+  ++this->queueStats.droppedMessages;
+  this->queueStats.droppedBytes += _len;
+  ++this->queueStats.droppedByTopic[_topic];
+}
+
 //////////////////////////////////////////////////
 void Recorder::Implementation::OnAdvertisement(const Publisher &_publisher)
 {
@@ -273,13 +482,8 @@ void Recorder::Implementation::OnAdvertisement(const Publisher &_publisher)
   if (this->alreadySubscribed.find(topic) != this->alreadySubscribed.end())
     return;
 
-  for (const std::regex &pattern : this->patterns)
-  {
-    if (std::regex_match(topic, pattern))
-    {
-      this->AddTopic(topic);
-    }
-  }
+  if (this->patterns.Match(topic))
+    this->AddTopic(topic);
 }
 
 //////////////////////////////////////////////////
@@ -289,8 +493,16 @@ RecorderError Recorder::Implementation::AddTopic(const std::string &_topic)
   if (this->alreadySubscribed.find(_topic) == this->alreadySubscribed.end())
   {
     LDBG("Recording [" << _topic << "]\n");
-    // Subscribe to the topic whether it exists or not
-    if (!this->node.SubscribeRaw(_topic, this->rawCallback))
+    // Subscribe to the topic whether it exists or not. The callback of each
+    // topic shares the topic name with the messages it queues.
+    auto subscription = std::make_shared<Subscription>();
+    RawCallback callback = [this, subscription](
+        const char *_data, std::size_t _len,
+        const transport::MessageInfo &_info)
+    {
+      this->OnMessageReceived(*subscription, _data, _len, _info);
+    };
+    if (!this->node.SubscribeRaw(_topic, callback))
     {
       LERR("Failed to subscribe to [" << _topic << "]\n");
       return RecorderError::FAILED_TO_SUBSCRIBE;
@@ -325,7 +537,7 @@ int64_t Recorder::Implementation::AddTopic(const std::regex &_pattern)
     }
   }
 
-  this->patterns.push_back(_pattern);
+  this->patterns.Add(_pattern);
 
   return numSubscriptions;
 }
@@ -336,26 +548,31 @@ void Recorder::Implementation::DataWriterThread()
   while (this->dataWriterState)
   {
     std::unique_lock<std::mutex> lock(this->dataQueueMutex);
-    if (this->dataQueue.empty())
+    if (this->dataQueue.Empty())
     {
       this->dataQueueCondVar.wait(lock,
         [this]
         {
-          return !this->dataQueue.empty() || !this->dataWriterState;
+          return !this->dataQueue.Empty() || !this->dataWriterState;
         });
 
-      if (this->dataQueue.empty())
+      if (this->dataQueue.Empty())
       {
         continue;
       }
     }
 
-    const auto logData = std::move(this->dataQueue.front());
-    this->dataQueue.pop_front();
+    // Take everything that is queued and write it in one batch. The
+    // callbacks continue in the buffers of the last batch.
+    std::swap(this->dataQueue, this->writtenQueue);
     // Unlock before locking another mutex.
     lock.unlock();
+    this->roomCondVar.notify_all();
 
-    this->WriteToLogFile(logData);
+    this->WriteToLogFile(this->writtenQueue);
+    // Keep the buffers, unless a burst made them larger than the buffer of
+    // the recorder.
+    this->writtenQueue.Clear(2 * this->maxBufferSize);
   }
 }
 
@@ -371,8 +588,13 @@ void Recorder::Implementation::StartDataWriter()
 //////////////////////////////////////////////////
 void Recorder::Implementation::StopDataWriter()
 {
-  this->dataWriterState = false;
+  {
+    // Don't notify a callback between its check and its wait.
+    std::lock_guard<std::mutex> lock(this->dataQueueMutex);
+    this->dataWriterState = false;
+  }
   this->dataQueueCondVar.notify_one();
+  this->roomCondVar.notify_all();
   if (this->dataWriter.joinable())
   {
     this->dataWriter.join();
@@ -380,53 +602,91 @@ void Recorder::Implementation::StopDataWriter()
 }
 
 //////////////////////////////////////////////////
-void Recorder::Implementation::DecrementBufferSize(std::size_t _len)
+void Recorder::Implementation::FlushDataQueue()
 {
-  if (this->bufferSize >= _len)
-  {
-    this->bufferSize -= _len;
-  }
-  else
   {
-    // This shouldn't happen
-    LERR("Buffer size was decremented to a value less than zero. "
-        "This should not happen\n");
-    this->bufferSize = 0;
+    std::lock_guard<std::mutex> lock(this->dataQueueMutex);
+    std::swap(this->dataQueue, this->writtenQueue);
   }
+
+  this->WriteToLogFile(this->writtenQueue);
+  this->writtenQueue.Clear(2 * this->maxBufferSize);
 }
 
 //////////////////////////////////////////////////
-void Recorder::Implementation::FlushDataQueue()
+void Recorder::Implementation::WriteToLogFile(
+    const RecordArena &_logData)
 {
-  while (true)
-  {
-    std::unique_lock<std::mutex> lock(this->dataQueueMutex);
-    if (this->dataQueue.empty())
-      return;
-
-    const auto logData = std::move(this->dataQueue.front());
-    this->dataQueue.pop_front();
-    // Unlock before locking another mutex.
-    lock.unlock();
+  if (_logData.Empty())
+    return;
 
-    this->WriteToLogFile(logData);
+  std::vector<Log::PendingMessage> messages;
+  messages.reserve(_logData.Size());
+  uint64_t bytes = 0;
+  for (const RecordArena::Record &data : _logData.Records())
+  {
+    if (data.dropped)
+      continue;
+    messages.push_back({data.stamp, data.recorded->topic, data.recorded->type,
+        reinterpret_cast<const void *>(_logData.Data(data)), data.len});
+    bytes += data.len;
   }
-}
 
-//////////////////////////////////////////////////
-void Recorder::Implementation::WriteToLogFile(const LogData &_logData)
-{
   std::lock_guard<std::mutex> logLock(this->logFileMutex);
   // Note: this->logFile will only be a nullptr before Start() has been
   // called or after Stop() has been called. If it is a nullptr, then we are
-  // not recording anything yet, so we can just skip inserting the message.
-  if (this->logFile &&
-      !this->logFile->InsertMessage(
-        _logData.stamp, _logData.msgInfo.Topic(), _logData.msgInfo.Type(),
-        reinterpret_cast<const void *>(_logData.msgData.data()),
-        _logData.msgData.size()))
+  // not recording anything yet, so we can just skip inserting the messages.
+  if (!this->logFile)
+    return;
+
+  const uint64_t splitSize = this->options.SplitSize();
+  const auto writeStart = std::chrono::steady_clock::now();
+  std::size_t inserted = 0;
+  std::size_t begin = 0;
+  while (begin < messages.size())
   {
-    LWRN("Failed to insert message into log file\n");
+    // Switch files only when there are messages for the next one, so that a
+    // split recording doesn't end with an empty file.
+    if (this->FileComplete())
+      this->NextFile();
+
+    // Stop at the message that completes the file.
+    std::size_t end = messages.size();
+    if (splitSize > 0)
+    {
+      end = begin;
+      while (end < messages.size() && this->fileBytes < splitSize)
+        this->fileBytes += messages[end++].len;
+    }
+
+    inserted += this->logFile->InsertMessages(&messages[begin], end - begin);
+    begin = end;
+  }
+  const auto writeEnd = std::chrono::steady_clock::now();
+  if (inserted < messages.size())
+  {
+    LWRN("Failed to insert " << messages.size() - inserted
+        << " message(s) into log file\n");
+  }
+
+  {
+    std::lock_guard<std::mutex> statsLock(this->statsMutex);
+    this->writeStats.writtenMessages += inserted;
+    this->writeStats.failedMessages += messages.size() - inserted;
+    this->writeStats.writtenBytes += bytes;
+    this->writeStats.writeLatency.Record(static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        writeEnd - writeStart).count()));
+
+    const auto now = std::chrono::steady_clock::now();
+    this->rateBytes += bytes;
+    const std::chrono::duration<double> elapsed = now - this->rateStart;
+    if (elapsed >= kRateWindow)
+    {
+      this->writeStats.writeRate = this->rateBytes / elapsed.count();
+      this->rateStart = now;
+      this->rateBytes = 0;
+    }
   }
   // TODO(anyone) It would be nice for testing to simulate long delays
   // associated with disk writes. In the mean time, a sleep can be added here
@@ -434,6 +694,60 @@ void Recorder::Implementation::WriteToLogFile(const LogData &_logData)
   // std::this_thread::sleep_for(std::chrono::milliseconds(30));
 }
 
+//////////////////////////////////////////////////
+bool Recorder::Implementation::FileComplete() const
+{
+  const uint64_t splitSize = this->options.SplitSize();
+  const std::chrono::milliseconds splitDuration =
+    this->options.SplitDuration();
+  return (splitSize > 0 && this->fileBytes >= splitSize) ||
+    (splitDuration > std::chrono::milliseconds::zero() &&
+     std::chrono::steady_clock::now() - this->fileStart >= splitDuration);
+}
+
+//////////////////////////////////////////////////
+void Recorder::Implementation::PrepareNextFile()
+{
+  const std::string file =
+    Log::SplitFileName(this->baseFile, this->fileIndex + 1);
+  this->nextLogFile = std::async(std::launch::async,
+      [file, opts = this->options]() -> std::unique_ptr<Log>
+      {
+        std::unique_ptr<Log> log(new Log());
+        if (!log->Open(file, std::ios_base::out, opts))
+        {
+          LERR("Failed to open or create file [" << file << "]\n");
+          return nullptr;
+        }
+        return log;
+      });
+}
+
+//////////////////////////////////////////////////
+void Recorder::Implementation::NextFile()
+{
+  // Count the file as complete even if the next one is missing, to try again
+  // when it's complete again instead of on every batch.
+  this->fileBytes = 0;
+  this->fileStart = std::chrono::steady_clock::now();
+
+  if (!this->nextLogFile.valid())
+    this->PrepareNextFile();
+  std::unique_ptr<Log> next = this->nextLogFile.get();
+  if (!next)
+  {
+    LERR("Failed to split the recording, it continues in ["
+        << this->logFile->Filename() << "]\n");
+    this->PrepareNextFile();
+    return;
+  }
+
+  this->logFile = std::move(next);
+  ++this->fileIndex;
+  LMSG("Recording continues in [" << this->logFile->Filename() << "]\n");
+  this->PrepareNextFile();
+}
+
 //////////////////////////////////////////////////
 Recorder::Recorder()
   : dataPtr(new Implementation)
@@ -468,6 +782,13 @@ RecorderError Recorder::Sync(const Clock *_clockIn) {
 
 //////////////////////////////////////////////////
 RecorderError Recorder::Start(const std::string &_file)
+{
+  return this->Start(_file, RecordOptions());
+}
+
+//////////////////////////////////////////////////
+RecorderError Recorder::Start(const std::string &_file,
+                              const RecordOptions &_options)
 {
   std::lock_guard<std::mutex> lock(this->dataPtr->logFileMutex);
   if (this->dataPtr->logFile)
@@ -477,13 +798,37 @@ RecorderError Recorder::Start(const std::string &_file)
   }
 
   this->dataPtr->logFile.reset(new Log());
-  if (!this->dataPtr->logFile->Open(_file, std::ios_base::out))
+  if (!this->dataPtr->logFile->Open(_file, std::ios_base::out, _options))
   {
     LERR("Failed to open or create file [" << _file << "]\n");
     this->dataPtr->logFile.reset(nullptr);
     return RecorderError::FAILED_TO_OPEN;
   }
 
+  this->dataPtr->options = _options;
+  this->dataPtr->baseFile = _file;
+  this->dataPtr->fileIndex = 0;
+  this->dataPtr->fileBytes = 0;
+  this->dataPtr->fileStart = std::chrono::steady_clock::now();
+  if (_options.SplitSize() > 0 ||
+      _options.SplitDuration() > std::chrono::milliseconds::zero())
+  {
+    this->dataPtr->PrepareNextFile();
+  }
+
+  {
+    std::scoped_lock statsLock(this->dataPtr->dataQueueMutex,
+                               this->dataPtr->statsMutex);
+    this->dataPtr->queueStats = RecorderStatistics();
+    this->dataPtr->writeStats = RecorderStatistics();
+    this->dataPtr->rateStart = std::chrono::steady_clock::now();
+    this->dataPtr->rateBytes = 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->policyMutex);
+    this->dataPtr->skippedMessages = 0;
+  }
+
   this->dataPtr->StartDataWriter();
   LMSG("Started recording to [" << _file << "]\n");
 
@@ -506,8 +851,35 @@ void Recorder::Stop()
   this->dataPtr->FlushDataQueue();
   LMSG("Done\n");
 
+  // Release the buffers of the queue.
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->dataQueueMutex);
+    this->dataPtr->dataQueue = RecordArena();
+  }
+  this->dataPtr->writtenQueue = RecordArena();
+
+  const RecorderStatistics stats = this->Statistics();
+  if (stats.droppedMessages > 0)
+  {
+    LWRN("Dropped " << stats.droppedMessages << " message(s) ("
+        << stats.droppedBytes << " bytes) because the buffer was full\n");
+  }
+
   std::lock_guard<std::mutex> lock(this->dataPtr->logFileMutex);
   this->dataPtr->logFile.reset(nullptr);
+
+  // Remove the next file of a split recording, which wasn't used.
+  if (this->dataPtr->nextLogFile.valid())
+  {
+    std::unique_ptr<Log> next = this->dataPtr->nextLogFile.get();
+    if (next)
+    {
+      const std::string file = next->Filename();
+      next.reset();
+      std::error_code ec;
+      std::filesystem::remove(file, ec);
+    }
+  }
 }
 
 //////////////////////////////////////////////////
@@ -548,3 +920,97 @@ void Recorder::SetBufferSize(std::size_t _size)
   // Shift by 20 to convert to bytes
   this->dataPtr->maxBufferSize = _size << 20;
 }
+
+//////////////////////////////////////////////////
+log::OverflowPolicy Recorder::OverflowPolicy() const
+{
+  return this->dataPtr->overflowPolicy;
+}
+
+//////////////////////////////////////////////////
+void Recorder::SetOverflowPolicy(const log::OverflowPolicy _policy)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->dataQueueMutex);
+    this->dataPtr->overflowPolicy = _policy;
+  }
+  // Blocked callbacks must not keep waiting under another policy.
+  this->dataPtr->roomCondVar.notify_all();
+}
+
+//////////////////////////////////////////////////
+std::set<std::string> Recorder::PriorityTopics() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->dataQueueMutex);
+  return this->dataPtr->priorityTopics;
+}
+
+//////////////////////////////////////////////////
+void Recorder::SetPriorityTopics(const std::set<std::string> &_topics)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->dataQueueMutex);
+  this->dataPtr->priorityTopics = _topics;
+}
+
+//////////////////////////////////////////////////
+RecordPolicy Recorder::TopicPolicy(const std::string &_topic) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->policyMutex);
+  auto it = this->dataPtr->policies.find(_topic);
+  if (it == this->dataPtr->policies.end())
+    return RecordPolicy();
+  return it->second.Policy();
+}
+
+//////////////////////////////////////////////////
+void Recorder::SetTopicPolicy(const std::string &_topic,
+                              const RecordPolicy &_policy)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->policyMutex);
+  auto &policies = this->dataPtr->policies;
+  policies.erase(_topic);
+  if (_policy != RecordPolicy())
+    policies.emplace(_topic, RecordFilter(_policy));
+
+  // Keep the last message time of the trigger topics still in use.
+  std::map<std::string, std::optional<std::chrono::nanoseconds>> triggers;
+  for (const auto &[topic, filter] : policies)
+  {
+    const std::string &trigger = filter.Policy().triggerTopic;
+    if (trigger.empty())
+      continue;
+    auto it = this->dataPtr->triggers.find(trigger);
+    triggers[trigger] =
+      it != this->dataPtr->triggers.end() ? it->second : std::nullopt;
+  }
+  this->dataPtr->triggers = std::move(triggers);
+  this->dataPtr->hasPolicies = !policies.empty();
+}
+
+//////////////////////////////////////////////////
+RecorderStatistics Recorder::Statistics() const
+{
+  RecorderStatistics result;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->dataQueueMutex);
+    result = this->dataPtr->queueStats;
+    result.queuedMessages = this->dataPtr->dataQueue.Size();
+    result.queuedBytes = this->dataPtr->dataQueue.Bytes();
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->policyMutex);
+    result.skippedMessages = this->dataPtr->skippedMessages;
+    result.receivedMessages += this->dataPtr->skippedMessages;
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->statsMutex);
+  const RecorderStatistics &written = this->dataPtr->writeStats;
+  result.writtenMessages = written.writtenMessages;
+  result.writtenBytes = written.writtenBytes;
+  result.failedMessages = written.failedMessages;
+  result.writeLatency = written.writeLatency;
+  // The rate drops to zero when nothing is written.
+  const auto idle = std::chrono::steady_clock::now() - this->dataPtr->rateStart;
+  result.writeRate = idle > 2 * kRateWindow ? 0 : written.writeRate;
+  return result;
+}
@@ -15,7 +15,9 @@
  *
 */
 
+#include <chrono>
 #include <regex>
+#include <set>
 #include <string>
 
 #include "gz/transport/log/Recorder.hh"
@@ -102,3 +104,61 @@ TEST(Record, SetBufferSize)
   recorder.SetBufferSize(40);
   EXPECT_EQ(40u, recorder.BufferSize());
 }
+
+//////////////////////////////////////////////////
+TEST(Record, OverflowPolicy)
+{
+  transport::log::Recorder recorder;
+  EXPECT_EQ(transport::log::OverflowPolicy::DROP_OLDEST,
+      recorder.OverflowPolicy());
+
+  recorder.SetOverflowPolicy(transport::log::OverflowPolicy::PRIORITIZE);
+  EXPECT_EQ(transport::log::OverflowPolicy::PRIORITIZE,
+      recorder.OverflowPolicy());
+
+  EXPECT_TRUE(recorder.PriorityTopics().empty());
+  recorder.SetPriorityTopics({"/foo", "/bar"});
+  EXPECT_EQ(std::set<std::string>({"/bar", "/foo"}),
+      recorder.PriorityTopics());
+}
+
+//////////////////////////////////////////////////
+TEST(Record, TopicPolicy)
+{
+  transport::log::Recorder recorder;
+  EXPECT_EQ(transport::log::RecordPolicy(), recorder.TopicPolicy("/foo"));
+
+  transport::log::RecordPolicy policy;
+  policy.maxRate = 10;
+  policy.onChange = true;
+  policy.triggerTopic = "/trigger";
+  policy.triggerWindow = std::chrono::seconds(1);
+  recorder.SetTopicPolicy("/foo", policy);
+  EXPECT_EQ(policy, recorder.TopicPolicy("/foo"));
+  EXPECT_EQ(transport::log::RecordPolicy(), recorder.TopicPolicy("/bar"));
+
+  // The default policy removes the policy.
+  recorder.SetTopicPolicy("/foo", transport::log::RecordPolicy());
+  EXPECT_EQ(transport::log::RecordPolicy(), recorder.TopicPolicy("/foo"));
+}
+
+//////////////////////////////////////////////////
+TEST(Record, Statistics)
+{
+  transport::log::Recorder recorder;
+  transport::log::RecorderStatistics stats = recorder.Statistics();
+  EXPECT_EQ(0u, stats.queuedMessages);
+  EXPECT_EQ(0u, stats.receivedMessages);
+  EXPECT_EQ(0u, stats.writtenMessages);
+  EXPECT_EQ(0u, stats.droppedMessages);
+  EXPECT_TRUE(stats.droppedByTopic.empty());
+  EXPECT_EQ(0u, stats.skippedMessages);
+  EXPECT_EQ(0u, stats.writeLatency.Count());
+
+  EXPECT_EQ(
+      transport::log::RecorderError::SUCCESS, recorder.Start(":memory:"));
+  recorder.Stop();
+  stats = recorder.Statistics();
+  EXPECT_EQ(0u, stats.droppedMessages);
+  EXPECT_DOUBLE_EQ(0.0, stats.writeRate);
+}
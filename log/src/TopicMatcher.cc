@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <string>
+
+#include "TopicMatcher.hh"
+
+using namespace gz::transport::log;
+
+//////////////////////////////////////////////////
+TopicMatcher::TopicMatcher(const std::regex &_pattern)
+  : patterns{_pattern}
+{
+}
+
+//////////////////////////////////////////////////
+void TopicMatcher::Add(const std::regex &_pattern)
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->patterns.push_back(_pattern);
+
+  // The topics that matched still match; the others only need to be
+  // checked against the new pattern.
+  for (auto &[topic, match] : this->results)
+  {
+    if (!match)
+      match = std::regex_match(topic, _pattern);
+  }
+}
+
+//////////////////////////////////////////////////
+bool TopicMatcher::Match(const std::string &_topic) const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  auto it = this->results.find(_topic);
+  if (it != this->results.end())
+    return it->second;
+
+  bool match = false;
+  for (const std::regex &pattern : this->patterns)
+  {
+    if (std::regex_match(_topic, pattern))
+    {
+      match = true;
+      break;
+    }
+  }
+
+  if (this->results.size() >= kMaxCached)
+    this->results.clear();
+  this->results.emplace(_topic, match);
+  return match;
+}
+
+//////////////////////////////////////////////////
+std::size_t TopicMatcher::Size() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->patterns.size();
+}
+
+//////////////////////////////////////////////////
+std::size_t TopicMatcher::Cached() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->results.size();
+}
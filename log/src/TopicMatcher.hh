@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_LOG_TOPICMATCHER_HH_
+#define GZ_TRANSPORT_LOG_TOPICMATCHER_HH_
+
+#include <cstddef>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/log/Export.hh"
+
+namespace gz
+{
+namespace transport
+{
+namespace log
+{
+// Inline bracket to help doxygen filtering.
+inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+{
+  /// \brief A list of topic patterns, matched against topic names. The
+  /// result of each topic is kept, so the regular expressions are evaluated
+  /// once per topic instead of once per lookup. A new pattern is only
+  /// evaluated against the topics that didn't match so far.
+  /// \internal
+  class GZ_TRANSPORT_LOG_VISIBLE TopicMatcher
+  {
+    /// \brief Constructor of an empty matcher, which matches nothing.
+    public: TopicMatcher() = default;
+
+    /// \brief Constructor of a matcher with a single pattern.
+    /// \param[in] _pattern The pattern.
+    public: explicit TopicMatcher(const std::regex &_pattern);
+
+    /// \brief Add a pattern.
+    /// \param[in] _pattern The pattern.
+    public: void Add(const std::regex &_pattern);
+
+    /// \brief Check whether a topic matches any of the patterns.
+    /// \param[in] _topic The topic name.
+    /// \return True if a pattern matches the whole topic name.
+    public: bool Match(const std::string &_topic) const;
+
+    /// \brief Get the number of patterns.
+    /// \return The number of patterns.
+    public: std::size_t Size() const;
+
+    /// \brief Get the number of topics whose result is kept.
+    /// \return The number of topics.
+    public: std::size_t Cached() const;
+
+    /// \brief Maximum number of topics whose result is kept. The results
+    /// are forgotten when it is reached, which bounds the memory used for
+    /// topic names that are never seen again.
+    public: static constexpr std::size_t kMaxCached = 4096;
+
+    /// \brief Protects patterns and results.
+    private: mutable std::mutex mutex;
+
+    /// \brief The patterns.
+    private: std::vector<std::regex> patterns;
+
+    /// \brief Whether each topic matches one of the patterns.
+    private: mutable std::unordered_map<std::string, bool> results;
+  };
+}
+}
+}
+}
+#endif
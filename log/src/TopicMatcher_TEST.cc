@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <regex>
+#include <string>
+
+#include "TopicMatcher.hh"
+#include "gtest/gtest.h"
+
+using namespace gz::transport::log;
+
+//////////////////////////////////////////////////
+/// \brief Match topics against several patterns.
+TEST(TopicMatcherTest, Match)
+{
+  TopicMatcher empty;
+  EXPECT_EQ(0u, empty.Size());
+  EXPECT_FALSE(empty.Match("/foo"));
+
+  TopicMatcher matcher(std::regex("/foo/.*"));
+  EXPECT_EQ(1u, matcher.Size());
+  EXPECT_TRUE(matcher.Match("/foo/bar"));
+  EXPECT_FALSE(matcher.Match("/bar/foo"));
+  EXPECT_FALSE(matcher.Match("/foo"));
+  EXPECT_EQ(3u, matcher.Cached());
+
+  // The results are kept.
+  EXPECT_TRUE(matcher.Match("/foo/bar"));
+  EXPECT_FALSE(matcher.Match("/bar/foo"));
+  EXPECT_EQ(3u, matcher.Cached());
+
+  // A new pattern updates the topics that didn't match.
+  matcher.Add(std::regex("/bar/.*"));
+  EXPECT_EQ(2u, matcher.Size());
+  EXPECT_TRUE(matcher.Match("/foo/bar"));
+  EXPECT_TRUE(matcher.Match("/bar/foo"));
+  EXPECT_FALSE(matcher.Match("/foo"));
+  EXPECT_TRUE(matcher.Match("/bar/baz"));
+}
+
+//////////////////////////////////////////////////
+/// \brief The results are forgotten when there are too many topics.
+TEST(TopicMatcherTest, Bounded)
+{
+  TopicMatcher matcher(std::regex(".*"));
+  for (std::size_t i = 0; i < TopicMatcher::kMaxCached; ++i)
+    EXPECT_TRUE(matcher.Match("/topic" + std::to_string(i)));
+  EXPECT_EQ(TopicMatcher::kMaxCached, matcher.Cached());
+
+  EXPECT_TRUE(matcher.Match("/another"));
+  EXPECT_EQ(1u, matcher.Cached());
+}
@@ -17,12 +17,16 @@
 
 #include "LogCommandAPI.hh"
 
+#include <chrono>
 #include <csignal>
+#include <iomanip>
 #include <iostream>
 #include <regex>
 #include <string>
+#include <vector>
 
 #include <gz/transport/log/Export.hh>
+#include <gz/transport/log/Log.hh>
 #include <gz/transport/log/Playback.hh>
 #include <gz/transport/log/Recorder.hh>
 #include <gz/transport/Node.hh>
@@ -82,7 +86,7 @@ void playbackSignHandler(int) // NOLINT
 
 //////////////////////////////////////////////////
 int playbackTopics(const char *_file, const char *_pattern, const int _wait_ms,
-  const char *_remap, int _fast)
+  const char *_remap, int _fast, double _rate)
 {
   std::regex regexPattern;
   try
@@ -113,6 +117,9 @@ int playbackTopics(const char *_file, const char *_pattern, const int _wait_ms,
   }
 
   transport::log::Playback player(_file, nodeOptions);
+  if (!player.SetRate(_rate))
+    return INVALID_RATE;
+
   if (!player.Valid())
     return FAILED_TO_OPEN;
 
@@ -137,3 +144,101 @@ int playbackTopics(const char *_file, const char *_pattern, const int _wait_ms,
   LDBG("Shutting down\n");
   return SUCCESS;
 }
+
+//////////////////////////////////////////////////
+int logInfo(const char *_file)
+{
+  transport::log::Log log;
+  if (!log.Open(_file))
+    return FAILED_TO_OPEN;
+
+  const auto seconds = [](const std::chrono::nanoseconds &_time)
+  {
+    return std::chrono::duration<double>(_time).count();
+  };
+
+  const std::vector<transport::log::TopicSummary> summaries =
+    log.TopicSummaries();
+  uint64_t messages = 0;
+  uint64_t bytes = 0;
+  for (const transport::log::TopicSummary &summary : summaries)
+  {
+    messages += summary.messages;
+    bytes += summary.bytes;
+  }
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "File:      " << _file << "\n"
+            << "Version:   " << log.Version() << "\n"
+            << "Start:     " << seconds(log.StartTime()) << " s\n"
+            << "End:       " << seconds(log.EndTime()) << " s\n"
+            << "Duration:  " << seconds(log.EndTime() - log.StartTime())
+            << " s\n"
+            << "Messages:  " << messages << " (" << bytes << " bytes)\n\n";
+
+  std::cout << std::left << std::setw(40) << "Topic" << " "
+            << std::setw(30) << "Type" << " " << std::right
+            << std::setw(10) << "Messages" << " "
+            << std::setw(14) << "Bytes" << " "
+            << std::setw(10) << "Rate (Hz)" << "\n";
+  for (const transport::log::TopicSummary &summary : summaries)
+  {
+    const double duration = seconds(summary.endTime - summary.startTime);
+    const double rate = duration > 0 ? (summary.messages - 1) / duration : 0;
+    std::cout << std::left << std::setw(40) << summary.topic << " "
+              << std::setw(30) << summary.type << " " << std::right
+              << std::setw(10) << summary.messages << " "
+              << std::setw(14) << summary.bytes << " "
+              << std::setw(10) << std::setprecision(1) << rate
+              << std::setprecision(3) << "\n";
+  }
+
+  return SUCCESS;
+}
+
+//////////////////////////////////////////////////
+int filterLog(const char *_file, const char *_output, const char *_pattern,
+              double _start, double _end)
+{
+  std::regex regexPattern;
+  try
+  {
+    regexPattern = _pattern;
+  }
+  catch (const std::regex_error &e)
+  {
+    LERR("Regex pattern is invalid\n");
+    return BAD_REGEX;
+  }
+
+  transport::log::Log log;
+  if (!log.Open(_file))
+    return FAILED_TO_OPEN;
+
+  const auto offset = [&log](double _seconds)
+  {
+    return log.StartTime() +
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::duration<double>(_seconds));
+  };
+
+  transport::log::QualifiedTimeRange range =
+    transport::log::QualifiedTimeRange::AllTime();
+  if (_start >= 0)
+    range.SetBeginning(transport::log::QualifiedTime(offset(_start)));
+  if (_end >= 0)
+    range.SetEnding(transport::log::QualifiedTime(offset(_end)));
+  if (!range.Valid())
+  {
+    LERR("The end of the time window is before its start\n");
+    return FAILED_TO_EXTRACT;
+  }
+
+  if (!log.Extract(_output,
+        transport::log::TopicPattern(regexPattern, range)))
+  {
+    return FAILED_TO_EXTRACT;
+  }
+
+  return SUCCESS;
+}
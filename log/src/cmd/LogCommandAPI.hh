@@ -27,6 +27,8 @@ extern "C"
     FAILED_TO_SUBSCRIBE = 4,
     INVALID_VERSION     = 5,
     INVALID_REMAP       = 6,
+    INVALID_RATE        = 7,
+    FAILED_TO_EXTRACT   = 8,
   };
 
   /// \brief Sets verbosity of library
@@ -46,10 +48,32 @@ extern "C"
   /// \param[in] _wait_ms How long to wait before the publications begin after
   /// advertising the topics that will be played back (milliseconds)
   /// \param[in] _fast Set to > 0 to disable wait between messages.
+  /// \param[in] _rate Playback rate, relative to the recording time
   int GZ_TRANSPORT_LOG_VISIBLE playbackTopics(
     const char *_file,
     const char *_pattern,
     const int _wait_ms,
     const char *_remap,
-    int _fast);
+    int _fast,
+    double _rate);
+
+  /// \brief Print the summary of each topic of a log file
+  /// \param[in] _file Path to the log file
+  int GZ_TRANSPORT_LOG_VISIBLE logInfo(const char *_file);
+
+  /// \brief Copy the messages of the topics whose name matches the given
+  /// pattern, within a time window, to a new log file
+  /// \param[in] _file Path to the log file to read
+  /// \param[in] _output Path to the log file to create
+  /// \param[in] _pattern ECMAScript regular expression to match against topics
+  /// \param[in] _start Beginning of the window, relative to the start of the
+  /// log (seconds), or a negative value for the start of the log
+  /// \param[in] _end End of the window, relative to the start of the log
+  /// (seconds), or a negative value for the end of the log
+  int GZ_TRANSPORT_LOG_VISIBLE filterLog(
+    const char *_file,
+    const char *_output,
+    const char *_pattern,
+    double _start,
+    double _end);
 }
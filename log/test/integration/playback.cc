@@ -17,6 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <gz/msgs/clock.pb.h>
+
+#include <gz/transport/Clock.hh>
 #include <gz/transport/log/Log.hh>
 #include <gz/transport/log/Playback.hh>
 #include <gz/transport/log/Recorder.hh>
@@ -798,6 +801,521 @@ TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplaySeek))
   std::this_thread::sleep_for(std::chrono::milliseconds(100));
 }
 
+//////////////////////////////////////////////////
+/// \brief Record a log and then play it back at half speed. Verify that the
+/// playback takes twice as long as the recording.
+TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplayRate))
+{
+  std::vector<std::string> topics = {"/foo", "/bar", "/baz"};
+
+  std::vector<MessageInformation> incomingData;
+
+  auto callback = [&incomingData](
+      const char *_data,
+      std::size_t _len,
+      const gz::transport::MessageInfo &_msgInfo)
+  {
+    TrackMessages(incomingData, _data, _len, _msgInfo);
+  };
+
+  gz::transport::Node node;
+  gz::transport::log::Recorder recorder;
+
+  for (const std::string &topic : topics)
+  {
+    node.SubscribeRaw(topic, callback);
+    recorder.AddTopic(topic);
+  }
+
+  const std::string logName =
+      "file:playbackReplayRate?mode=memory&cache=shared";
+  EXPECT_EQ(gz::transport::log::RecorderError::SUCCESS,
+    recorder.Start(logName));
+
+  const int numChirps = 100;
+  auto chirper =
+    gz::transport::log::test::BeginChirps(topics, numChirps, partition);
+
+  // Wait for the chirping to finish
+  chirper.Join();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  // Create playback before stopping so sqlite memory database is shared
+  gz::transport::log::Playback playback(logName);
+  recorder.Stop();
+
+  std::vector<MessageInformation> originalData = incomingData;
+  incomingData.clear();
+
+  for (const std::string &topic : topics)
+  {
+    playback.AddTopic(topic);
+  }
+
+  EXPECT_FALSE(playback.SetRate(0.0));
+  EXPECT_FALSE(playback.SetRate(1000.0));
+  EXPECT_TRUE(playback.SetRate(0.5));
+
+  const auto handle = playback.Start(std::chrono::milliseconds(100));
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_DOUBLE_EQ(0.5, handle->Rate());
+  handle->WaitUntilFinished();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  handle->Stop();
+
+  const std::chrono::nanoseconds logDuration =
+      handle->EndTime() - handle->StartTime();
+#ifdef _WIN32
+  EXPECT_GE(elapsed, logDuration);
+#else
+  EXPECT_GE(elapsed, logDuration * 2 * 0.9);
+#endif
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  EXPECT_TRUE(ExpectSameMessages(originalData, incomingData));
+}
+
+//////////////////////////////////////////////////
+/// \brief Play a log as fast as possible with an acknowledge window. Verify
+/// that the playback waits for the acknowledgements.
+TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplayAcknowledged))
+{
+  std::vector<std::string> topics = {"/foo", "/bar", "/baz"};
+
+  std::vector<MessageInformation> incomingData;
+
+  auto callback = [&incomingData](
+      const char *_data,
+      std::size_t _len,
+      const gz::transport::MessageInfo &_msgInfo)
+  {
+    TrackMessages(incomingData, _data, _len, _msgInfo);
+  };
+
+  gz::transport::Node node;
+  gz::transport::log::Recorder recorder;
+
+  for (const std::string &topic : topics)
+  {
+    node.SubscribeRaw(topic, callback);
+    recorder.AddTopic(topic);
+  }
+
+  const std::string logName =
+      "file:playbackReplayAcknowledged?mode=memory&cache=shared";
+  EXPECT_EQ(gz::transport::log::RecorderError::SUCCESS,
+    recorder.Start(logName));
+
+  const int numChirps = 100;
+  auto chirper =
+    gz::transport::log::test::BeginChirps(topics, numChirps, partition);
+
+  // Wait for the chirping to finish
+  chirper.Join();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  // Create playback before stopping so sqlite memory database is shared
+  gz::transport::log::Playback playback(logName);
+  recorder.Stop();
+
+  std::vector<MessageInformation> originalData = incomingData;
+  incomingData.clear();
+
+  for (const std::string &topic : topics)
+  {
+    playback.AddTopic(topic);
+  }
+
+  const std::size_t window = 5;
+  playback.SetAcknowledgeWindow(window);
+
+  const auto handle = playback.Start(std::chrono::milliseconds(100), false);
+
+  // Only the messages of the window are published until they are
+  // acknowledged
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  {
+    std::unique_lock<std::mutex> lock(dataMutex);
+    EXPECT_EQ(window, incomingData.size());
+  }
+  EXPECT_FALSE(handle->Finished());
+
+  handle->Acknowledge(2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  {
+    std::unique_lock<std::mutex> lock(dataMutex);
+    EXPECT_EQ(window + 2, incomingData.size());
+  }
+
+  // Publish the rest without waiting for acknowledgements
+  handle->SetAcknowledgeWindow(0);
+  handle->WaitUntilFinished();
+  handle->Stop();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  EXPECT_TRUE(ExpectSameMessages(originalData, incomingData));
+}
+
+//////////////////////////////////////////////////
+/// \brief Record a log and then play it back from a publishing thread per
+/// topic. Verify that the messages of each topic are played in order.
+TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplayPublishThreads))
+{
+  std::vector<std::string> topics = {"/foo", "/bar", "/baz"};
+
+  std::vector<MessageInformation> incomingData;
+
+  auto callback = [&incomingData](
+      const char *_data,
+      std::size_t _len,
+      const gz::transport::MessageInfo &_msgInfo)
+  {
+    TrackMessages(incomingData, _data, _len, _msgInfo);
+  };
+
+  gz::transport::Node node;
+  gz::transport::log::Recorder recorder;
+
+  for (const std::string &topic : topics)
+  {
+    node.SubscribeRaw(topic, callback);
+    recorder.AddTopic(topic);
+  }
+
+  const std::string logName =
+      "file:playbackReplayPublishThreads?mode=memory&cache=shared";
+  EXPECT_EQ(gz::transport::log::RecorderError::SUCCESS,
+    recorder.Start(logName));
+
+  const int numChirps = 100;
+  auto chirper =
+    gz::transport::log::test::BeginChirps(topics, numChirps, partition);
+
+  // Wait for the chirping to finish
+  chirper.Join();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  // Create playback before stopping so sqlite memory database is shared
+  gz::transport::log::Playback playback(logName);
+  recorder.Stop();
+
+  std::vector<MessageInformation> originalData = incomingData;
+  incomingData.clear();
+
+  for (const std::string &topic : topics)
+  {
+    playback.AddTopic(topic);
+  }
+
+  playback.SetPublishThreads(topics.size());
+  const auto handle = playback.Start();
+  handle->WaitUntilFinished();
+  handle->Stop();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // The topics are published by different threads, so only the order of the
+  // messages of each topic is preserved
+  for (const std::string &topic : topics)
+  {
+    std::vector<MessageInformation> original;
+    std::vector<MessageInformation> played;
+    for (const MessageInformation &info : originalData)
+    {
+      if (info.topic == topic)
+        original.push_back(info);
+    }
+    for (const MessageInformation &info : incomingData)
+    {
+      if (info.topic == topic)
+        played.push_back(info);
+    }
+    EXPECT_TRUE(ExpectSameMessages(original, played)) << topic;
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Play a log back from memory in a loop. Verify that every loop
+/// publishes the messages of the log in order.
+TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplayPreloadedLoop))
+{
+  std::vector<std::string> topics = {"/foo", "/bar"};
+
+  std::vector<MessageInformation> incomingData;
+
+  auto callback = [&incomingData](
+      const char *_data,
+      std::size_t _len,
+      const gz::transport::MessageInfo &_msgInfo)
+  {
+    TrackMessages(incomingData, _data, _len, _msgInfo);
+  };
+
+  gz::transport::Node node;
+  gz::transport::log::Recorder recorder;
+
+  for (const std::string &topic : topics)
+  {
+    node.SubscribeRaw(topic, callback);
+    recorder.AddTopic(topic);
+  }
+
+  const std::string logName =
+      "file:playbackReplayPreloadedLoop?mode=memory&cache=shared";
+  EXPECT_EQ(gz::transport::log::RecorderError::SUCCESS,
+    recorder.Start(logName));
+
+  const int numChirps = 20;
+  auto chirper =
+    gz::transport::log::test::BeginChirps(topics, numChirps, partition);
+
+  // Wait for the chirping to finish
+  chirper.Join();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  // Create playback before stopping so sqlite memory database is shared
+  gz::transport::log::Playback playback(logName);
+  recorder.Stop();
+
+  std::vector<MessageInformation> originalData;
+  {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    originalData = incomingData;
+    incomingData.clear();
+  }
+  ASSERT_FALSE(originalData.empty());
+
+  playback.SetPreload(64 * 1024 * 1024);
+  playback.SetLoop(true);
+  playback.SetRate(10);
+  const auto handle = playback.Start(std::chrono::milliseconds(100));
+
+  // The playback goes on until it is stopped
+  const std::size_t loops = 3;
+  for (int i = 0; i < 100; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::lock_guard<std::mutex> lock(dataMutex);
+    if (incomingData.size() >= loops * originalData.size())
+      break;
+  }
+  EXPECT_FALSE(handle->Finished());
+  handle->Stop();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::lock_guard<std::mutex> lock(dataMutex);
+  ASSERT_GE(incomingData.size(), loops * originalData.size());
+  for (std::size_t loop = 0; loop < loops; ++loop)
+  {
+    const auto first = incomingData.begin() + static_cast<std::ptrdiff_t>(
+        loop * originalData.size());
+    const std::vector<MessageInformation> played(
+        first, first + static_cast<std::ptrdiff_t>(originalData.size()));
+    EXPECT_TRUE(ExpectSameMessages(originalData, played)) << loop;
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Record a log and then play it back once the topics have
+/// subscribers. Verify that the playback doesn't wait for the whole timeout
+/// and matches the original.
+TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplayWaitForSubscribers))
+{
+  std::vector<std::string> topics = {"/foo", "/bar"};
+
+  std::vector<MessageInformation> incomingData;
+
+  auto callback = [&incomingData](
+      const char *_data,
+      std::size_t _len,
+      const gz::transport::MessageInfo &_msgInfo)
+  {
+    TrackMessages(incomingData, _data, _len, _msgInfo);
+  };
+
+  gz::transport::Node node;
+  gz::transport::log::Recorder recorder;
+
+  for (const std::string &topic : topics)
+  {
+    node.SubscribeRaw(topic, callback);
+    recorder.AddTopic(topic);
+  }
+
+  const std::string logName =
+      "file:playbackReplayWaitForSubscribers?mode=memory&cache=shared";
+  EXPECT_EQ(gz::transport::log::RecorderError::SUCCESS,
+    recorder.Start(logName));
+
+  const int numChirps = 20;
+  auto chirper =
+    gz::transport::log::test::BeginChirps(topics, numChirps, partition);
+
+  // Wait for the chirping to finish
+  chirper.Join();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  // Create playback before stopping so sqlite memory database is shared
+  gz::transport::log::Playback playback(logName);
+  recorder.Stop();
+
+  std::vector<MessageInformation> originalData;
+  {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    originalData = incomingData;
+    incomingData.clear();
+  }
+  ASSERT_FALSE(originalData.empty());
+
+  // The subscribers of this process are known right away
+  playback.SetWaitForSubscribers(true);
+  const auto start = std::chrono::steady_clock::now();
+  const auto handle = playback.Start(std::chrono::seconds(10));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+    std::chrono::seconds(5));
+
+  handle->WaitUntilFinished();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::lock_guard<std::mutex> lock(dataMutex);
+  EXPECT_TRUE(ExpectSameMessages(originalData, incomingData));
+}
+
+//////////////////////////////////////////////////
+/// \brief Clock whose time is set by the test.
+class TestClock : public gz::transport::Clock
+{
+  public: std::chrono::nanoseconds Time() const override
+  {
+    return this->time;
+  }
+
+  public: bool IsReady() const override
+  {
+    return this->ready;
+  }
+
+  public: std::atomic<std::chrono::nanoseconds> time{
+      std::chrono::nanoseconds::zero()};
+
+  public: std::atomic<bool> ready{false};
+};
+
+//////////////////////////////////////////////////
+/// \brief Play a log back paced against a clock set by the test. Verify that
+/// the playback follows the clock and publishes its time.
+TEST(playback, GZ_UTILS_TEST_DISABLED_ON_MAC(ReplayWithClock))
+{
+  std::vector<std::string> topics = {"/foo", "/bar", "/baz"};
+
+  std::vector<MessageInformation> incomingData;
+
+  auto callback = [&incomingData](
+      const char *_data,
+      std::size_t _len,
+      const gz::transport::MessageInfo &_msgInfo)
+  {
+    TrackMessages(incomingData, _data, _len, _msgInfo);
+  };
+
+  gz::transport::Node node;
+  gz::transport::log::Recorder recorder;
+
+  for (const std::string &topic : topics)
+  {
+    node.SubscribeRaw(topic, callback);
+    recorder.AddTopic(topic);
+  }
+
+  const std::string logName =
+      "file:playbackReplayWithClock?mode=memory&cache=shared";
+  EXPECT_EQ(gz::transport::log::RecorderError::SUCCESS,
+    recorder.Start(logName));
+
+  const int numChirps = 100;
+  auto chirper =
+    gz::transport::log::test::BeginChirps(topics, numChirps, partition);
+
+  // Wait for the chirping to finish
+  chirper.Join();
+
+  // Wait to make sure our callbacks are done processing the incoming messages
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+
+  // Create playback before stopping so sqlite memory database is shared
+  gz::transport::log::Playback playback(logName);
+  recorder.Stop();
+
+  std::vector<MessageInformation> originalData = incomingData;
+  incomingData.clear();
+
+  for (const std::string &topic : topics)
+  {
+    playback.AddTopic(topic);
+  }
+
+  std::mutex clockMutex;
+  std::chrono::nanoseconds lastClockTime(-1);
+  std::function<void(const gz::msgs::Clock &)> clockCb =
+    [&](const gz::msgs::Clock &_msg)
+    {
+      std::lock_guard<std::mutex> lock(clockMutex);
+      lastClockTime = std::chrono::seconds(_msg.sim().sec()) +
+          std::chrono::nanoseconds(_msg.sim().nsec());
+    };
+  EXPECT_TRUE(node.Subscribe("/playback_clock", clockCb));
+
+  TestClock clock;
+  playback.SetClock(&clock);
+  playback.SetClockTopic("/playback_clock");
+
+  const auto handle = playback.Start(std::chrono::milliseconds(100));
+
+  // Nothing is published until the clock is ready
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    EXPECT_TRUE(incomingData.empty());
+  }
+
+  // Nor while its time stands still
+  clock.time = std::chrono::seconds(10);
+  clock.ready = true;
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    EXPECT_LE(incomingData.size(), 1u);
+  }
+
+  // The whole log is published once the clock has advanced past its end
+  clock.time = std::chrono::seconds(10) +
+      (handle->EndTime() - handle->StartTime()) + std::chrono::seconds(1);
+  handle->WaitUntilFinished();
+  handle->Stop();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  EXPECT_TRUE(ExpectSameMessages(originalData, incomingData));
+
+  std::lock_guard<std::mutex> lock(clockMutex);
+  EXPECT_EQ(handle->EndTime(), lastClockTime);
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <ios>
+#include <string>
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "gz/transport/log/Log.hh"
+#include "gz/transport/log/Playback.hh"
+#include "bench_utils.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+/// \brief Number of messages of the log.
+static const std::size_t kMessages = 1000;
+
+/// \brief Time between two messages of the log.
+static const std::chrono::nanoseconds kPeriod = std::chrono::milliseconds(2);
+
+//////////////////////////////////////////////////
+/// \brief Play a log back at the time of its messages, to a subscriber of
+/// the same process. Records the scheduling error of the playback, see
+/// PlaybackHandle::Statistics(), and the rate at which the messages arrive.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _size Payload size (bytes).
+/// \param[in] _preload True to read the messages into memory first.
+void runPlayback(const std::string &_name, std::size_t _size,
+                 bool _preload)
+{
+  const std::string topic = "/bench_playback";
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_bench_playback_" + testing::getRandomNumber() + ".tlog")).string();
+  {
+    msgs::Bytes msg;
+    msg.set_data(std::string(_size, 'x'));
+    const std::string data = msg.SerializeAsString();
+
+    transport::log::Log logFile;
+    ASSERT_TRUE(logFile.Open(path, std::ios_base::out));
+    for (std::size_t i = 0; i < kMessages; ++i)
+    {
+      ASSERT_TRUE(logFile.InsertMessage(kPeriod * i, topic,
+        msg.GetTypeName(), data.data(), data.size()));
+    }
+  }
+
+  bench::Counter counter;
+  transport::RawCallback cb =
+    [&counter](const char *, const std::size_t, const transport::MessageInfo &)
+    {
+      counter.Add();
+    };
+  transport::Node node;
+  ASSERT_TRUE(node.SubscribeRaw(topic, cb));
+
+  {
+    transport::log::Playback playback(path);
+    ASSERT_TRUE(playback.Valid());
+    if (_preload)
+      playback.SetPreload(1024u * 1024u * 1024u);
+
+    const auto handle = playback.Start(std::chrono::milliseconds(100));
+    ASSERT_NE(nullptr, handle);
+    const auto start = bench::Clock::now();
+    handle->WaitUntilFinished();
+    counter.Wait(kMessages, std::chrono::seconds(5));
+
+    const transport::log::PlaybackStatistics stats = handle->Statistics();
+    bench::Record(_name + ".error.mean_us", stats.meanError / 1e3);
+    bench::Record(_name + ".error.max_us",
+      std::chrono::duration<double, std::micro>(stats.maxError).count());
+    bench::Record(_name + ".jitter_us", stats.jitter / 1e3);
+    bench::Record(_name + ".late_percent", stats.scheduledMessages == 0 ? 0 :
+      100.0 * static_cast<double>(stats.lateMessages) /
+      static_cast<double>(stats.scheduledMessages));
+    bench::RecordThroughput(_name + ".received", counter.Count(), _size,
+      bench::Us(start, counter.Last()));
+    handle->Stop();
+  }
+
+  std::filesystem::remove(path);
+}
+
+//////////////////////////////////////////////////
+/// \brief Playback read from the log, for small and large messages.
+TEST(LogPlayback, Timing)
+{
+  for (const std::size_t size : {64u, 4096u, 262144u})
+    runPlayback("log." + bench::SizeName(size), size, false);
+}
+
+//////////////////////////////////////////////////
+/// \brief Playback preloaded in memory, see Playback::SetPreload().
+TEST(LogPlayback, PreloadedTiming)
+{
+  for (const std::size_t size : {64u, 4096u, 262144u})
+    runPlayback("preloaded." + bench::SizeName(size), size, true);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Don't interfere with other benchmarks running on the network.
+  gz::utils::setenv("GZ_PARTITION", testing::getRandomNumber());
+  gz::utils::setenv(gz::transport::log::SchemaLocationEnvVar,
+                    GZ_TRANSPORT_LOG_SQL_PATH);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <ios>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/log/Log.hh"
+#include "bench_utils.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+/// \brief Number of messages of the logs.
+static const std::size_t kMessages = 20000;
+
+/// \brief Number of topics of the logs.
+static const std::size_t kTopics = 8;
+
+/// \brief Time between two messages of the logs.
+static const std::chrono::nanoseconds kPeriod = std::chrono::milliseconds(1);
+
+/// \brief Number of seeks measured.
+static const std::size_t kSeeks = 200;
+
+//////////////////////////////////////////////////
+/// \brief Write a log whose messages are spread over several topics.
+/// \param[in] _path Path of the log.
+/// \param[in] _format Format of the log.
+/// \param[in] _size Payload size (bytes).
+/// \return The topics of the log.
+std::set<std::string> writeLog(const std::string &_path,
+    transport::log::LogFormat _format, std::size_t _size)
+{
+  transport::log::RecordOptions options;
+  options.SetFormat(_format);
+
+  std::set<std::string> topics;
+  transport::log::Log logFile;
+  EXPECT_TRUE(logFile.Open(_path, std::ios_base::out, options));
+  const std::string data(_size, 'x');
+  for (std::size_t i = 0; i < kMessages; ++i)
+  {
+    const std::string topic = "/bench_query_" + std::to_string(i % kTopics);
+    topics.insert(topic);
+    EXPECT_TRUE(logFile.InsertMessage(kPeriod * i, topic, "gz.msgs.Bytes",
+      data.data(), data.size()));
+  }
+  return topics;
+}
+
+//////////////////////////////////////////////////
+/// \brief Scan a log with QueryMessages() and measure how long the first
+/// message takes to come after a seek, i.e. a query from a random time.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _format Format of the log.
+/// \param[in] _size Payload size (bytes).
+void runQuery(const std::string &_name, transport::log::LogFormat _format,
+              std::size_t _size)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_bench_query_" + testing::getRandomNumber() + ".tlog")).string();
+  const std::set<std::string> topics = writeLog(path, _format, _size);
+
+  transport::log::Log logFile;
+  ASSERT_TRUE(logFile.Open(path));
+
+  // Every message
+  {
+    std::size_t count = 0;
+    const auto start = bench::Clock::now();
+    for (const transport::log::Message &msg : logFile.QueryMessages())
+    {
+      count += msg.DataView().empty() ? 0 : 1;
+    }
+    const auto end = bench::Clock::now();
+    EXPECT_EQ(kMessages, count);
+    bench::RecordThroughput(_name + ".scan", count, _size,
+      bench::Us(start, end));
+  }
+
+  // One topic out of kTopics
+  {
+    std::size_t count = 0;
+    const auto start = bench::Clock::now();
+    for (const transport::log::Message &msg : logFile.QueryMessages(
+           transport::log::TopicList(*topics.begin())))
+    {
+      count += msg.DataView().empty() ? 0 : 1;
+    }
+    const auto end = bench::Clock::now();
+    EXPECT_EQ(kMessages / kTopics, count);
+    bench::RecordThroughput(_name + ".scan_topic", count, _size,
+      bench::Us(start, end));
+  }
+
+  // Seeks to random times, as PlaybackHandle::Seek() does
+  std::mt19937 random(0);
+  std::uniform_int_distribution<std::size_t> index(0, kMessages - 1);
+  std::vector<double> latency;
+  for (std::size_t i = 0; i < kSeeks; ++i)
+  {
+    const std::chrono::nanoseconds time = kPeriod * index(random);
+    const auto start = bench::Clock::now();
+    transport::log::Batch batch = logFile.QueryMessages(
+      transport::log::TopicList::Create(topics,
+        transport::log::QualifiedTimeRange::From(
+          transport::log::QualifiedTime(time))));
+    auto iter = batch.begin();
+    const auto end = bench::Clock::now();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(time, iter->TimeReceived());
+    latency.push_back(bench::Us(start, end));
+  }
+  bench::RecordLatency(_name + ".seek", latency);
+
+  std::filesystem::remove(path);
+}
+
+//////////////////////////////////////////////////
+/// \brief Both log formats, for small and large messages.
+TEST(LogQuery, Formats)
+{
+  for (const std::size_t size : {64u, 4096u, 65536u})
+  {
+    runQuery("sqlite." + bench::SizeName(size),
+      transport::log::LogFormat::SQLITE, size);
+    runQuery("chunked." + bench::SizeName(size),
+      transport::log::LogFormat::CHUNKED, size);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Seeks in a batch read into memory, see Batch::Preload().
+TEST(LogQuery, PreloadedSeek)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_bench_query_" + testing::getRandomNumber() + ".tlog")).string();
+  writeLog(path, transport::log::LogFormat::CHUNKED, 4096u);
+
+  transport::log::Log logFile;
+  ASSERT_TRUE(logFile.Open(path));
+  transport::log::Batch batch = logFile.QueryMessages();
+
+  const auto start = bench::Clock::now();
+  ASSERT_TRUE(batch.Preload());
+  bench::Record("preloaded.4KiB.preload_us",
+    bench::Us(start, bench::Clock::now()));
+
+  std::mt19937 random(0);
+  std::uniform_int_distribution<std::size_t> index(0, kMessages - 1);
+  std::vector<double> latency;
+  for (std::size_t i = 0; i < kSeeks; ++i)
+  {
+    const std::chrono::nanoseconds time = kPeriod * index(random);
+    const auto seekStart = bench::Clock::now();
+    auto iter = batch.Find(time);
+    const auto seekEnd = bench::Clock::now();
+    ASSERT_NE(batch.end(), iter);
+    EXPECT_EQ(time, iter->TimeReceived());
+    latency.push_back(bench::Us(seekStart, seekEnd));
+  }
+  bench::RecordLatency("preloaded.4KiB.seek", latency);
+
+  std::filesystem::remove(path);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  gz::utils::setenv(gz::transport::log::SchemaLocationEnvVar,
+                    GZ_TRANSPORT_LOG_SQL_PATH);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
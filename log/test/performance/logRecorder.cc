@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "gz/transport/log/Recorder.hh"
+#include "bench_utils.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static const auto kTimeout = std::chrono::seconds(30);
+
+/// \brief Data published per measurement (bytes), smaller than the budget
+/// of the pub/sub benchmarks since it is written to disk.
+static const std::size_t kBytes = 64u * 1024u * 1024u;
+
+//////////////////////////////////////////////////
+/// \brief Number of messages to publish for a payload size.
+/// \param[in] _size Payload size (bytes).
+/// \return Number of messages.
+static std::size_t Messages(std::size_t _size)
+{
+  return std::clamp<std::size_t>(kBytes / std::max<std::size_t>(_size, 1u),
+    16u, 4000u);
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish a burst of messages on topics recorded by a recorder of
+/// the same process. Records the rate at which the messages are written to
+/// the log, from the first publication until the buffer of the recorder is
+/// empty, and the share of the messages dropped.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _topics Number of topics.
+/// \param[in] _size Payload size (bytes).
+/// \param[in] _options Options of the log file.
+/// \param[in] _bufferSize Size of the buffer of the recorder (bytes), or 0
+/// for the default.
+void runRecorder(const std::string &_name, std::size_t _topics,
+                 std::size_t _size,
+                 const transport::log::RecordOptions &_options,
+                 std::size_t _bufferSize = 0)
+{
+  const std::string path = (std::filesystem::temp_directory_path() /
+      ("gz_bench_recorder_" + testing::getRandomNumber() + ".tlog")).string();
+
+  transport::log::Recorder recorder;
+  if (_bufferSize > 0)
+  {
+    recorder.SetBufferSize(_bufferSize);
+    recorder.SetOverflowPolicy(transport::log::OverflowPolicy::DROP_NEWEST);
+  }
+
+  std::vector<std::string> topics;
+  for (std::size_t i = 0; i < _topics; ++i)
+  {
+    topics.push_back("/bench_record_" + std::to_string(i));
+    ASSERT_EQ(transport::log::RecorderError::SUCCESS,
+      recorder.AddTopic(topics.back()));
+  }
+  ASSERT_EQ(transport::log::RecorderError::SUCCESS,
+    recorder.Start(path, _options));
+
+  transport::Node node;
+  std::vector<transport::Node::Publisher> pubs;
+  for (const std::string &topic : topics)
+  {
+    pubs.push_back(node.Advertise<msgs::Bytes>(topic));
+    ASSERT_TRUE(pubs.back());
+  }
+
+  msgs::Bytes msg;
+  msg.set_data(std::string(_size, 'x'));
+  const std::size_t messages = Messages(_size);
+
+  const auto start = bench::Clock::now();
+  for (std::size_t i = 0; i < messages; ++i)
+    EXPECT_TRUE(pubs[i % pubs.size()].Publish(msg));
+
+  // The publication queue may drop messages, only the received ones count.
+  transport::log::RecorderStatistics stats;
+  auto end = bench::Clock::now();
+  while (end - start < kTimeout)
+  {
+    stats = recorder.Statistics();
+    if (stats.receivedMessages >= messages && stats.queuedMessages == 0)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    end = bench::Clock::now();
+  }
+  recorder.Stop();
+
+  bench::RecordThroughput(_name + ".written",
+    static_cast<std::size_t>(stats.writtenMessages), _size,
+    bench::Us(start, end));
+  bench::Record(_name + ".dropped_percent", stats.receivedMessages == 0 ? 0 :
+    100.0 * static_cast<double>(stats.droppedMessages) /
+    static_cast<double>(stats.receivedMessages));
+
+  // Stalls of the writer thread, e.g. while the file grows.
+  const transport::LatencyHistogram latency =
+    recorder.Statistics().writeLatency;
+  bench::Record(_name + ".write_p50_us",
+    static_cast<double>(latency.Percentile(50)));
+  bench::Record(_name + ".write_p99_us",
+    static_cast<double>(latency.Percentile(99)));
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(path + "-wal");
+  std::filesystem::remove(path + "-shm");
+}
+
+//////////////////////////////////////////////////
+/// \brief Write rate of both log formats, for payload sizes up to 2 MiB.
+TEST(LogRecorder, MessageSize)
+{
+  for (const auto &[format, formatName] :
+       {std::make_pair(transport::log::LogFormat::SQLITE, "sqlite"),
+        std::make_pair(transport::log::LogFormat::CHUNKED, "chunked")})
+  {
+    transport::log::RecordOptions options;
+    options.SetFormat(format);
+    for (const std::size_t size : bench::PayloadSizes())
+    {
+      if (size > 2097152u)
+        break;
+      runRecorder(std::string(formatName) + "." + bench::SizeName(size), 1,
+        size, options);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Write rate of 1, 8 and 64 topics.
+TEST(LogRecorder, Topics)
+{
+  for (const std::size_t topics : {1u, 8u, 64u})
+  {
+    runRecorder("topics" + std::to_string(topics) + ".4KiB", topics, 4096u,
+      transport::log::RecordOptions());
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Share of the messages dropped when they are published faster than
+/// they are written, with a 1 MiB buffer.
+TEST(LogRecorder, Overload)
+{
+  transport::log::RecordOptions options;
+  options.SetSynchronous(transport::log::Synchronous::FULL);
+  runRecorder("overload.32KiB", 1, 32768u, options, 1024u * 1024u);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Don't interfere with other benchmarks running on the network.
+  gz::utils::setenv("GZ_PARTITION", testing::getRandomNumber());
+  gz::utils::setenv(gz::transport::log::SchemaLocationEnvVar,
+                    GZ_TRANSPORT_LOG_SQL_PATH);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/message.h"
 
@@ -54,6 +55,8 @@ namespace gz
         ///   * /${_serverNamespace}/list_parameters
         ///   * /${_serverNamespace}/set_parameter
         ///   * /${_serverNamespace}/declare_parameter
+        ///   * /${_serverNamespace}/get_parameters
+        ///   * /${_serverNamespace}/set_parameters
         /// \param[in] _timeoutMs Time to wait for the server to respond.
         public: ParametersClient(
           const std::string & _serverNamespace = "",
@@ -101,6 +104,64 @@ namespace gz
         public: gz::msgs::ParameterDeclarations
           ListParameters() const final;
 
+        /// \brief Request the value of many parameters in a single
+        ///   service request.
+        /// \param[in] _parameterNames Names of the parameters.
+        /// \param[out] _parameters The value of each parameter, indexed by
+        ///   name.
+        /// \return A ParameterResult return code, can return error types:
+        /// - ParameterResultType::NotDeclared with the name of the first
+        ///   parameter that was not declared. _parameters is left empty.
+        /// - ParameterResultType::ClientTimeout if the registry didn't
+        ///   respond.
+        public: ParameterResult Parameters(
+          const std::vector<std::string> & _parameterNames,
+          ParametersMap & _parameters) const;
+
+        /// \brief Request the value of all the declared parameters in a
+        ///   single service request.
+        /// \param[out] _parameters The value of each parameter, indexed by
+        ///   name.
+        /// \return A ParameterResult return code, can return error types:
+        /// - ParameterResultType::ClientTimeout if the registry didn't
+        ///   respond.
+        public: ParameterResult ListParametersWithValues(
+          ParametersMap & _parameters) const;
+
+        /// \brief Set the value of many parameters atomically in a single
+        ///   service request. Either all the values are set, or none of
+        ///   them if any fails.
+        /// \param[in] _values New values, indexed by parameter name.
+        /// \return A ParameterResult return code, can return error types:
+        /// - ParameterResultType::NotDeclared if a parameter was not
+        ///   declared.
+        /// - ParameterResultType::InvalidType if the type of a value doesn't
+        ///   match the type of the parameter.
+        /// - ParameterResultType::ClientTimeout if the registry didn't
+        ///   respond.
+        /// \throw std::invalid_argument if a value is `nullptr`.
+        public: ParameterResult SetParameters(const ParametersMap & _values);
+
+        /// \brief Enable or disable the local parameter cache.
+        /// While enabled, the client subscribes to
+        /// /${_serverNamespace}/parameter_updates and keeps the values it
+        /// has read or set in a local cache, so repeated calls to
+        /// Parameter() don't need a service request. The cache is only
+        /// used once the first update has been received from the
+        /// registry, which confirms the subscription is connected; until
+        /// then every read is still sent to the registry.
+        /// Values set in the registry by other processes are seen once
+        /// their update arrives, not immediately after they were set.
+        /// The cache is disabled by default.
+        /// \param[in] _enable True to enable the cache.
+        /// \return False if the update topic couldn't be subscribed to.
+        public: bool SetCacheEnabled(bool _enable);
+
+        /// \brief Whether the local parameter cache is enabled.
+        /// \return True if the cache is enabled.
+        /// \sa SetCacheEnabled
+        public: bool CacheEnabled() const;
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
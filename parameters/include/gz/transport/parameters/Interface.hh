@@ -19,6 +19,7 @@
 #define GZ_TRANSPORT_PARAMETERS_INTERFACE_HH_
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <variant>
@@ -40,6 +41,11 @@ namespace gz
       // Inline bracket to help doxygen filtering.
       inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
 
+      /// \brief Parameter values indexed by parameter name, used by the
+      ///   batch operations of ParametersRegistry and ParametersClient.
+      using ParametersMap =
+        std::map<std::string, std::unique_ptr<google::protobuf::Message>>;
+
       /// \brief Common interface, implemented by ParametersRegistry
       ///   (local updates) and by ParametersClients (remote requests).
       class GZ_TRANSPORT_PARAMETERS_VISIBLE ParametersInterface
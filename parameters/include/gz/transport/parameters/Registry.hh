@@ -21,6 +21,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <google/protobuf/message.h>
 
@@ -52,6 +53,17 @@ namespace gz
       /// * /${_parametersServicesNamespace}/list_parameters
       /// * /${_parametersServicesNamespace}/set_parameter
       /// * /${_parametersServicesNamespace}/declare_parameter
+      /// * /${_parametersServicesNamespace}/get_parameters
+      /// * /${_parametersServicesNamespace}/set_parameters
+      ///
+      /// get_parameters and set_parameters get or set many parameters in
+      /// a single request, see ParametersClient::Parameters() and
+      /// ParametersClient::SetParameters().
+      ///
+      /// Every time the value of a parameter is set, its name and new value
+      /// are published as a gz::msgs::Parameter on
+      /// /${_parametersServicesNamespace}/parameter_updates, which
+      /// ParametersClient uses to keep its cache coherent.
       class GZ_TRANSPORT_PARAMETERS_VISIBLE ParametersRegistry
       : public ParametersInterface
       {
@@ -125,6 +137,44 @@ namespace gz
           const std::string & _parameterName,
           std::unique_ptr<google::protobuf::Message> _value);
 
+        /// \brief Get the current value of a parameter without copying it.
+        ///   Stored values are never modified: setting a parameter stores
+        ///   a new value, so the returned message stays valid and constant
+        ///   while the caller holds it.
+        /// \param[in] _parameterName Name of the parameter.
+        /// \return The value, or nullptr if the parameter was not declared.
+        public: std::shared_ptr<const google::protobuf::Message>
+          SharedParameter(const std::string & _parameterName) const;
+
+        /// \brief Get the value of many parameters at once.
+        /// \param[in] _parameterNames Names of the parameters.
+        /// \param[out] _parameters The value of each parameter, indexed by
+        ///   name.
+        /// \return A ParameterResult return code, can return error types:
+        /// - ParameterResultType::NotDeclared with the name of the first
+        ///   parameter that was not declared. _parameters is left empty.
+        public: ParameterResult Parameters(
+          const std::vector<std::string> & _parameterNames,
+          ParametersMap & _parameters) const;
+
+        /// \brief Get the value of all the declared parameters.
+        /// \param[out] _parameters The value of each parameter, indexed by
+        ///   name.
+        /// \return A ParameterResult return code.
+        public: ParameterResult ListParametersWithValues(
+          ParametersMap & _parameters) const;
+
+        /// \brief Set the value of many parameters atomically. Either all
+        ///   the values are set, or none of them if any fails.
+        /// \param[in] _values New values, indexed by parameter name.
+        /// \return A ParameterResult return code, can return error types:
+        /// - ParameterResultType::NotDeclared if a parameter was not
+        ///   declared.
+        /// - ParameterResultType::InvalidType if the type of a value doesn't
+        ///   match the type of the parameter.
+        /// \throw std::invalid_argument if a value is `nullptr`.
+        public: ParameterResult SetParameters(const ParametersMap & _values);
+
 #ifdef _WIN32
 // Disable warning C4251 which is triggered by
 // std::unique_ptr
@@ -17,15 +17,23 @@
 
 #include "gz/transport/parameters/Client.hh"
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <gz/msgs/boolean.pb.h>
+#include <gz/msgs/bytes.pb.h>
 #include <gz/msgs/parameter.pb.h>
 #include <gz/msgs/parameter_error.pb.h>
 #include <gz/msgs/parameter_name.pb.h>
 #include <gz/msgs/parameter_value.pb.h>
+#include <gz/msgs/stringmsg_v.pb.h>
 
 #include "gz/transport/parameters/result.hh"
 
@@ -43,11 +51,89 @@ struct transport::parameters::ParametersClientPrivate
   : serverNamespace{_serverNamespace},
     timeoutMs{_timeoutMs}
   {}
+
+  /// \brief Callback of the registry parameter updates topic.
+  /// \param[in] _msg Name and new value of the parameter.
+  void OnUpdate(const msgs::Parameter &_msg);
+
+  /// \brief A packed parameter value. Cached values are immutable, so
+  /// readers unpack them after releasing the lock.
+  using PackedT = std::shared_ptr<const google::protobuf::Any>;
+
+  /// \brief Store a value received in a service response in the cache.
+  /// \param[in] _name Name of the parameter.
+  /// \param[in] _value Value of the parameter.
+  /// \param[in] _updateCount Value of updateCount when the request was
+  ///   sent. If an update arrived in the meantime the response may be older
+  ///   than the cache, so it is discarded.
+  void Store(const std::string &_name, PackedT _value,
+    uint64_t _updateCount);
+
   std::string serverNamespace;
-  mutable transport::Node node;
   unsigned int timeoutMs;
+
+  /// \brief Protects all the cache members.
+  std::mutex cacheMutex;
+
+  /// \brief Whether the cache is enabled.
+  bool cacheEnabled{false};
+
+  /// \brief Whether an update has been received since the cache was
+  /// enabled. Until then the subscription may not be connected to the
+  /// registry yet and updates could be missed, so the cache is not used.
+  bool cacheLive{false};
+
+  /// \brief Number of updates received, used to detect responses that
+  /// raced with an update.
+  uint64_t updateCount{0};
+
+  /// \brief Cached parameter values, packed as the registry sends them.
+  std::unordered_map<std::string, PackedT> cache;
+
+  /// \brief Declared last, so it is destroyed (and the update subscription
+  /// removed) before the cache.
+  mutable transport::Node node;
 };
 
+//////////////////////////////////////////////////
+void ParametersClientPrivate::OnUpdate(const msgs::Parameter &_msg)
+{
+  std::lock_guard<std::mutex> lock(this->cacheMutex);
+  if (!this->cacheEnabled)
+    return;
+  ++this->updateCount;
+  if (!this->cacheLive)
+  {
+    // Values cached before the subscription was known to be connected
+    // could have missed an update.
+    this->cache.clear();
+    this->cacheLive = true;
+  }
+  this->cache[_msg.name()] =
+    std::make_shared<google::protobuf::Any>(_msg.value());
+}
+
+//////////////////////////////////////////////////
+void ParametersClientPrivate::Store(const std::string &_name,
+  PackedT _value, uint64_t _updateCount)
+{
+  std::lock_guard<std::mutex> lock(this->cacheMutex);
+  if (this->cacheEnabled && this->updateCount == _updateCount)
+    this->cache[_name] = std::move(_value);
+}
+
+//////////////////////////////////////////////////
+/// \brief Take the value out of a message, without copying it.
+/// \param[in] _value The value, left empty.
+/// \return The value.
+static ParametersClientPrivate::PackedT
+takePacked(google::protobuf::Any &_value)
+{
+  auto packed = std::make_shared<google::protobuf::Any>();
+  packed->Swap(&_value);
+  return packed;
+}
+
 //////////////////////////////////////////////////
 ParametersClient::~ParametersClient() = default;
 
@@ -66,22 +152,72 @@ ParametersClient::ParametersClient(
     _timeoutMs)}
 {}
 
+//////////////////////////////////////////////////
+bool ParametersClient::CacheEnabled() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->cacheMutex);
+  return this->dataPtr->cacheEnabled;
+}
+
+//////////////////////////////////////////////////
+bool ParametersClient::SetCacheEnabled(bool _enable)
+{
+  const std::string topic{
+    this->dataPtr->serverNamespace + "/parameter_updates"};
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->cacheMutex);
+    if (this->dataPtr->cacheEnabled == _enable)
+      return true;
+    this->dataPtr->cacheEnabled = _enable;
+    this->dataPtr->cacheLive = false;
+    this->dataPtr->cache.clear();
+  }
+
+  if (!_enable)
+    return this->dataPtr->node.Unsubscribe(topic);
+
+  if (!this->dataPtr->node.Subscribe(topic,
+        &ParametersClientPrivate::OnUpdate, this->dataPtr.get()))
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->cacheMutex);
+    this->dataPtr->cacheEnabled = false;
+    return false;
+  }
+  return true;
+}
+
 //////////////////////////////////////////////////
 static ParameterResult
 getParameterCommon(
-  const ParametersClientPrivate & _dataPtr,
+  ParametersClientPrivate & _dataPtr,
   const std::string & _parameterName,
-  msgs::ParameterValue & _parameterValue)
+  ParametersClientPrivate::PackedT & _parameterValue)
 {
+  uint64_t updateCount{0};
+  {
+    std::lock_guard<std::mutex> lock(_dataPtr.cacheMutex);
+    if (_dataPtr.cacheLive)
+    {
+      auto it = _dataPtr.cache.find(_parameterName);
+      if (it != _dataPtr.cache.end())
+      {
+        _parameterValue = it->second;
+        return ParameterResult{ParameterResultType::Success};
+      }
+    }
+    updateCount = _dataPtr.updateCount;
+  }
+
   bool result{false};
   const std::string service{_dataPtr.serverNamespace + "/get_parameter"};
 
   msgs::ParameterName req;
+  msgs::ParameterValue res;
 
   req.set_name(_parameterName);
 
   if (!_dataPtr.node.Request(
-    service, req, _dataPtr.timeoutMs, _parameterValue, result))
+    service, req, _dataPtr.timeoutMs, res, result))
   {
     return ParameterResult{ParameterResultType::ClientTimeout, _parameterName};
   }
@@ -89,29 +225,31 @@ getParameterCommon(
   {
     return ParameterResult{ParameterResultType::NotDeclared, _parameterName};
   }
+  _parameterValue = takePacked(*res.mutable_data());
+  _dataPtr.Store(_parameterName, _parameterValue, updateCount);
   return ParameterResult{ParameterResultType::Success};
 }
 
 //////////////////////////////////////////////////
-ParameterResult
-ParametersClient::Parameter(
+static ParameterResult
+unpackParameter(
   const std::string & _parameterName,
-  google::protobuf::Message & _parameter) const
+  const google::protobuf::Any & _value,
+  std::unique_ptr<google::protobuf::Message> & _parameter)
 {
-  msgs::ParameterValue res;
-  auto ret = getParameterCommon(*this->dataPtr, _parameterName, res);
-  auto gzTypeOpt = getGzTypeFromAnyProto(res.data());
+  auto gzTypeOpt = getGzTypeFromAnyProto(_value);
   if (!gzTypeOpt) {
     return ParameterResult{
       ParameterResultType::Unexpected,
       _parameterName};
   }
   auto gzType = *gzTypeOpt;
-  if (gzType != _parameter.GetDescriptor()->name()) {
+  _parameter = gz::msgs::Factory::New(gzType);
+  if (!_parameter) {
     return ParameterResult{
-      ParameterResultType::InvalidType, _parameterName, gzType};
+      ParameterResultType::Unexpected, _parameterName, gzType};
   }
-  if (!res.data().UnpackTo(&_parameter)) {
+  if (!_value.UnpackTo(_parameter.get())) {
     return ParameterResult{
       ParameterResultType::Unexpected, _parameterName, gzType};
   }
@@ -122,29 +260,45 @@ ParametersClient::Parameter(
 ParameterResult
 ParametersClient::Parameter(
   const std::string & _parameterName,
-  std::unique_ptr<google::protobuf::Message> & _parameter) const
+  google::protobuf::Message & _parameter) const
 {
-  msgs::ParameterValue res;
-  auto ret = getParameterCommon(*this->dataPtr, _parameterName, res);
-  auto gzTypeOpt = getGzTypeFromAnyProto(res.data());
+  ParametersClientPrivate::PackedT value;
+  auto ret = getParameterCommon(*this->dataPtr, _parameterName, value);
+  if (!ret) {
+    return ret;
+  }
+  auto gzTypeOpt = getGzTypeFromAnyProto(*value);
   if (!gzTypeOpt) {
     return ParameterResult{
       ParameterResultType::Unexpected,
       _parameterName};
   }
   auto gzType = *gzTypeOpt;
-  _parameter = gz::msgs::Factory::New(gzType);
-  if (!_parameter) {
+  if (gzType != _parameter.GetDescriptor()->name()) {
     return ParameterResult{
-      ParameterResultType::Unexpected, _parameterName, gzType};
+      ParameterResultType::InvalidType, _parameterName, gzType};
   }
-  if (!res.data().UnpackTo(_parameter.get())) {
+  if (!value->UnpackTo(&_parameter)) {
     return ParameterResult{
       ParameterResultType::Unexpected, _parameterName, gzType};
   }
   return ParameterResult{ParameterResultType::Success};
 }
 
+//////////////////////////////////////////////////
+ParameterResult
+ParametersClient::Parameter(
+  const std::string & _parameterName,
+  std::unique_ptr<google::protobuf::Message> & _parameter) const
+{
+  ParametersClientPrivate::PackedT value;
+  auto ret = getParameterCommon(*this->dataPtr, _parameterName, value);
+  if (!ret) {
+    return ret;
+  }
+  return unpackParameter(_parameterName, *value, _parameter);
+}
+
 //////////////////////////////////////////////////
 ParameterResult
 ParametersClient::SetParameter(
@@ -160,6 +314,12 @@ ParametersClient::SetParameter(
   req.set_name(_parameterName);
   req.mutable_value()->PackFrom(_msg);
 
+  uint64_t updateCount{0};
+  {
+    std::lock_guard<std::mutex> lock(dataPtr->cacheMutex);
+    updateCount = dataPtr->updateCount;
+  }
+
   if (!dataPtr->node.Request(service, req, dataPtr->timeoutMs, res, result))
   {
     return ParameterResult{ParameterResultType::ClientTimeout, _parameterName};
@@ -169,6 +329,8 @@ ParametersClient::SetParameter(
     return ParameterResult{ParameterResultType::Unexpected, _parameterName};
   }
   if (res.data() == msgs::ParameterError::SUCCESS) {
+    dataPtr->Store(_parameterName, takePacked(*req.mutable_value()),
+      updateCount);
     return ParameterResult{ParameterResultType::Success};
   }
   if (res.data() == msgs::ParameterError::NOT_DECLARED) {
@@ -221,6 +383,172 @@ ParametersClient::DeclareParameter(
   return ParameterResult{ParameterResultType::Unexpected, _parameterName};
 }
 
+//////////////////////////////////////////////////
+/// \brief Request a batch of parameters from the registry.
+/// \param[in] _dataPtr Client data.
+/// \param[in] _parameterNames Names of the parameters, or none to request
+///   all of them.
+/// \param[out] _parameters The parameters received.
+/// \return The result of the request.
+static ParameterResult
+getParametersCommon(
+  ParametersClientPrivate & _dataPtr,
+  const std::vector<std::string> & _parameterNames,
+  ParametersMap & _parameters)
+{
+  bool result{false};
+  const std::string service{_dataPtr.serverNamespace + "/get_parameters"};
+
+  msgs::StringMsg_V req;
+  msgs::Bytes res;
+  for (const auto & name : _parameterNames) {
+    req.add_data(name);
+  }
+
+  uint64_t updateCount{0};
+  {
+    std::lock_guard<std::mutex> lock(_dataPtr.cacheMutex);
+    updateCount = _dataPtr.updateCount;
+  }
+
+  if (!_dataPtr.node.Request(service, req, _dataPtr.timeoutMs, res, result))
+  {
+    return ParameterResult{ParameterResultType::ClientTimeout};
+  }
+  std::vector<msgs::Parameter> params;
+  if (!result || !parseParameterBatch(res.data(), params))
+  {
+    return ParameterResult{ParameterResultType::Unexpected};
+  }
+  for (auto & param : params) {
+    auto ret = unpackParameter(
+      param.name(), param.value(), _parameters[param.name()]);
+    if (!ret) {
+      _parameters.clear();
+      return ret;
+    }
+    _dataPtr.Store(param.name(), takePacked(*param.mutable_value()),
+      updateCount);
+  }
+  return ParameterResult{ParameterResultType::Success};
+}
+
+//////////////////////////////////////////////////
+ParameterResult
+ParametersClient::Parameters(
+  const std::vector<std::string> & _parameterNames,
+  ParametersMap & _parameters) const
+{
+  _parameters.clear();
+  if (_parameterNames.empty()) {
+    return ParameterResult{ParameterResultType::Success};
+  }
+
+  std::vector<ParametersClientPrivate::PackedT> cached;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->cacheMutex);
+    if (this->dataPtr->cacheLive)
+    {
+      cached.reserve(_parameterNames.size());
+      for (const auto & name : _parameterNames) {
+        auto it = this->dataPtr->cache.find(name);
+        if (it == this->dataPtr->cache.end()) {
+          cached.clear();
+          break;
+        }
+        cached.push_back(it->second);
+      }
+    }
+  }
+  if (!cached.empty()) {
+    for (std::size_t i = 0; i < cached.size(); ++i) {
+      const auto & name = _parameterNames[i];
+      if (!unpackParameter(name, *cached[i], _parameters[name])) {
+        _parameters.clear();
+        break;
+      }
+    }
+    if (!_parameters.empty()) {
+      return ParameterResult{ParameterResultType::Success};
+    }
+  }
+
+  auto ret = getParametersCommon(*this->dataPtr, _parameterNames, _parameters);
+  if (!ret) {
+    return ParameterResult{ret.ResultType(), _parameterNames.front()};
+  }
+  for (const auto & name : _parameterNames) {
+    if (_parameters.find(name) == _parameters.end()) {
+      _parameters.clear();
+      return ParameterResult{ParameterResultType::NotDeclared, name};
+    }
+  }
+  return ParameterResult{ParameterResultType::Success};
+}
+
+//////////////////////////////////////////////////
+ParameterResult
+ParametersClient::ListParametersWithValues(ParametersMap & _parameters) const
+{
+  _parameters.clear();
+  return getParametersCommon(*this->dataPtr, {}, _parameters);
+}
+
+//////////////////////////////////////////////////
+ParameterResult
+ParametersClient::SetParameters(const ParametersMap & _values)
+{
+  bool result{false};
+  const std::string service{dataPtr->serverNamespace + "/set_parameters"};
+
+  std::vector<msgs::Parameter> params;
+  params.reserve(_values.size());
+  for (const auto & valuePair : _values) {
+    if (!valuePair.second) {
+      throw std::invalid_argument{
+        "ParametersClient::SetParameters(): value of `" +
+        valuePair.first + "` is nullptr"};
+    }
+    params.emplace_back();
+    params.back().set_name(valuePair.first);
+    params.back().mutable_value()->PackFrom(*valuePair.second);
+  }
+
+  msgs::Bytes req;
+  msgs::Parameter res;
+  req.set_data(serializeParameterBatch(params));
+
+  uint64_t updateCount{0};
+  {
+    std::lock_guard<std::mutex> lock(dataPtr->cacheMutex);
+    updateCount = dataPtr->updateCount;
+  }
+
+  if (!dataPtr->node.Request(service, req, dataPtr->timeoutMs, res, result))
+  {
+    return ParameterResult{ParameterResultType::ClientTimeout};
+  }
+  msgs::ParameterError error;
+  if (!result || !res.value().UnpackTo(&error))
+  {
+    return ParameterResult{ParameterResultType::Unexpected, res.name()};
+  }
+  if (error.data() == msgs::ParameterError::SUCCESS) {
+    for (auto & param : params) {
+      dataPtr->Store(param.name(), takePacked(*param.mutable_value()),
+        updateCount);
+    }
+    return ParameterResult{ParameterResultType::Success};
+  }
+  if (error.data() == msgs::ParameterError::NOT_DECLARED) {
+    return ParameterResult{ParameterResultType::NotDeclared, res.name()};
+  }
+  if (error.data() == msgs::ParameterError::INVALID_TYPE) {
+    return ParameterResult{ParameterResultType::InvalidType, res.name()};
+  }
+  return ParameterResult{ParameterResultType::Unexpected, res.name()};
+}
+
 //////////////////////////////////////////////////
 msgs::ParameterDeclarations
 ParametersClient::ListParameters() const
@@ -18,6 +18,10 @@
 #include "gz/transport/parameters/Client.hh"
 #include "gz/transport/parameters/Registry.hh"
 
+#include <chrono>
+#include <string>
+#include <thread>
+
 #include <gz/msgs/boolean.pb.h>
 #include <gz/msgs/stringmsg.pb.h>
 
@@ -212,3 +216,112 @@ TEST_F(ParametersClientTest, ListParameters)
       << "expected to find declaration for another_param2";
   }
 }
+
+//////////////////////////////////////////////////
+TEST_F(ParametersClientTest, Batch)
+{
+  ParametersClient client;
+
+  ParametersMap values;
+  auto boolMsg = std::make_unique<msgs::Boolean>();
+  boolMsg->set_data(true);
+  values["parameter1"] = std::move(boolMsg);
+  auto strMsg = std::make_unique<msgs::StringMsg>();
+  strMsg->set_data("batch");
+  values["parameter2"] = std::move(strMsg);
+  EXPECT_TRUE(client.SetParameters(values));
+
+  msgs::StringMsg msg;
+  EXPECT_TRUE(registry_.Parameter("parameter2", msg));
+  EXPECT_EQ("batch", msg.data());
+
+  ParametersMap got;
+  EXPECT_TRUE(client.Parameters({"parameter1", "parameter3"}, got));
+  ASSERT_EQ(2u, got.size());
+  EXPECT_TRUE(dynamic_cast<msgs::Boolean &>(*got["parameter1"]).data());
+  EXPECT_EQ("asd", dynamic_cast<msgs::StringMsg &>(*got["parameter3"]).data());
+
+  auto ret = client.Parameters({"parameter1", "missing"}, got);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::NotDeclared);
+  EXPECT_EQ(ret.ParamName(), "missing");
+  EXPECT_TRUE(got.empty());
+
+  EXPECT_TRUE(client.ListParametersWithValues(got));
+  EXPECT_EQ(3u, got.size());
+  EXPECT_EQ("batch",
+    dynamic_cast<msgs::StringMsg &>(*got["parameter2"]).data());
+
+  // A failing batch doesn't change any parameter.
+  values["parameter1"] = std::make_unique<msgs::Boolean>();
+  values["parameter2"] = std::make_unique<msgs::Boolean>();
+  ret = client.SetParameters(values);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::InvalidType);
+  EXPECT_EQ(ret.ParamName(), "parameter2");
+  msgs::Boolean param1;
+  EXPECT_TRUE(registry_.Parameter("parameter1", param1));
+  EXPECT_TRUE(param1.data());
+
+  ParametersClient otherNs{"/ns"};
+  EXPECT_TRUE(otherNs.ListParametersWithValues(got));
+  EXPECT_EQ(2u, got.size());
+}
+
+//////////////////////////////////////////////////
+TEST_F(ParametersClientTest, Cache)
+{
+  ParametersClient client;
+  EXPECT_FALSE(client.CacheEnabled());
+  EXPECT_TRUE(client.SetCacheEnabled(true));
+  EXPECT_TRUE(client.CacheEnabled());
+
+  // Values set in the registry are eventually seen by the client.
+  auto waitFor = [&client](const std::string &_expected)
+  {
+    msgs::StringMsg msg;
+    for (int i = 0; i < 100; ++i)
+    {
+      EXPECT_TRUE(client.Parameter("parameter2", msg));
+      if (msg.data() == _expected)
+        return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  };
+
+  msgs::StringMsg value;
+  value.set_data("first");
+  EXPECT_TRUE(registry_.SetParameter("parameter2", value));
+  EXPECT_TRUE(waitFor("first"));
+
+  value.set_data("second");
+  EXPECT_TRUE(registry_.SetParameter("parameter2", value));
+  EXPECT_TRUE(waitFor("second"));
+
+  // Values set by another client too.
+  ParametersClient other;
+  value.set_data("third");
+  EXPECT_TRUE(other.SetParameter("parameter2", value));
+  EXPECT_TRUE(waitFor("third"));
+
+  // The client's own writes are read back immediately.
+  value.set_data("fourth");
+  EXPECT_TRUE(client.SetParameter("parameter2", value));
+  msgs::StringMsg msg;
+  EXPECT_TRUE(client.Parameter("parameter2", msg));
+  EXPECT_EQ("fourth", msg.data());
+
+  // Cached values are still type checked.
+  msgs::Boolean wrongType;
+  auto ret = client.Parameter("parameter2", wrongType);
+  EXPECT_FALSE(ret);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::InvalidType);
+
+  // Undeclared parameters are never cached.
+  ret = client.Parameter("missing", msg);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::NotDeclared);
+
+  EXPECT_TRUE(client.SetCacheEnabled(false));
+  EXPECT_FALSE(client.CacheEnabled());
+  EXPECT_TRUE(client.Parameter("parameter2", msg));
+  EXPECT_EQ("fourth", msg.data());
+}
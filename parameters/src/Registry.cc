@@ -19,8 +19,12 @@
 
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "google/protobuf/message.h"
 #include "google/protobuf/any.h"
@@ -28,11 +32,13 @@
 #include "gz/transport/Node.hh"
 
 #include <gz/msgs/boolean.pb.h>
+#include <gz/msgs/bytes.pb.h>
 #include <gz/msgs/parameter.pb.h>
 #include <gz/msgs/parameter_declarations.pb.h>
 #include <gz/msgs/parameter_error.pb.h>
 #include <gz/msgs/parameter_name.pb.h>
 #include <gz/msgs/parameter_value.pb.h>
+#include <gz/msgs/stringmsg_v.pb.h>
 
 #include <gz/transport/parameters/result.hh>
 
@@ -42,10 +48,60 @@ using namespace gz;
 using namespace transport;
 using namespace parameters;
 
+//////////////////////////////////////////////////
+/// \brief Pack a parameter value as the registry sends it.
+/// \param[in] _value The value.
+/// \return The packed value.
+static std::shared_ptr<const google::protobuf::Any> packValue(
+  const google::protobuf::Message &_value)
+{
+  auto packed = std::make_shared<google::protobuf::Any>();
+  packed->PackFrom(_value, "gz_msgs");
+  return packed;
+}
+
+//////////////////////////////////////////////////
+/// \brief Pack a parameter value received from a client as the registry
+/// sends it, reusing the serialized value of the client.
+/// \param[in] _received The value packed by the client.
+/// \param[in] _value The value unpacked from _received.
+/// \return The packed value.
+static std::shared_ptr<const google::protobuf::Any> repackValue(
+  const google::protobuf::Any &_received,
+  const google::protobuf::Message &_value)
+{
+  auto packed = std::make_shared<google::protobuf::Any>();
+  packed->set_type_url("gz_msgs/" + _value.GetDescriptor()->full_name());
+  packed->set_value(_received.value());
+  return packed;
+}
+
 struct transport::parameters::ParametersRegistryPrivate
 {
-  using ParametersMapT = std::unordered_map<
-    std::string, std::unique_ptr<google::protobuf::Message>>;
+  /// \brief Parameter values are immutable once stored. Setting a
+  /// parameter replaces its pointer, so readers can keep using a value
+  /// after releasing the lock.
+  using ValueT = std::shared_ptr<const google::protobuf::Message>;
+
+  /// \brief A parameter value, and the value packed as the services and
+  /// the updates send it. The value is serialized once when it is set,
+  /// instead of on every get.
+  struct Entry
+  {
+    /// \brief The value.
+    ValueT value;
+
+    /// \brief The packed value.
+    std::shared_ptr<const google::protobuf::Any> packed;
+  };
+
+  using ParametersMapT = std::unordered_map<std::string, Entry>;
+
+  /// \brief Get the current value of a parameter.
+  /// \param[in] _name Name of the parameter.
+  /// \return The value, or an empty entry if the parameter was not
+  ///   declared.
+  Entry Find(const std::string &_name) const;
 
   /// \brief Get parameter service callback.
   /// \param[in] _req Request specifying the parameter name.
@@ -74,9 +130,51 @@ struct transport::parameters::ParametersRegistryPrivate
   bool DeclareParameter(
     const msgs::Parameter &_req, msgs::ParameterError &_res);
 
-  transport::Node node;
-  std::mutex parametersMapMutex;
+  /// \brief Get parameters service callback.
+  /// \param[in] _req Names of the parameters, or no names to get all of
+  ///   them.
+  /// \param[out] _res Batch with the declared parameters among the
+  ///   requested ones. See serializeParameterBatch().
+  /// \return True if successful.
+  bool GetParameters(const msgs::StringMsg_V &_req, msgs::Bytes &_res);
+
+  /// \brief Set parameters service callback.
+  /// \param[in] _req Batch with the parameters to set.
+  /// \param[out] _res Name of the first parameter that couldn't be set,
+  ///   and the error packed as a msgs::ParameterError.
+  /// \return True if successful.
+  bool SetParameters(const msgs::Bytes &_req, msgs::Parameter &_res);
+
+  /// \brief New values for a batch of parameters, validated before any
+  /// of them is applied.
+  using UpdatesT = std::vector<std::pair<std::string, Entry>>;
+
+  /// \brief Apply a batch of new values and notify clients. The values
+  /// must be of the type of their parameter, which can't change once
+  /// declared.
+  /// Must be called with parametersMapMutex held exclusively.
+  /// \param[in] _updates The new values.
+  /// \return The name of a parameter that is not declared, in which case
+  ///   no value is applied, or an empty string.
+  std::string ApplyUpdates(const UpdatesT &_updates);
+
+  /// \brief Notify clients that the value of a parameter changed.
+  /// Must be called with parametersMapMutex held exclusively, so
+  /// notifications are
+  /// published in the same order the values were set.
+  /// \param[in] _name Name of the parameter.
+  /// \param[in] _packed New value of the parameter, packed.
+  void PublishUpdate(const std::string &_name,
+    const google::protobuf::Any &_packed);
+
+  /// \brief Protects parametersMap. Readers only hold it while looking up
+  /// values, and writers while swapping them.
+  mutable std::shared_mutex parametersMapMutex;
   ParametersMapT parametersMap;
+
+  /// \brief Declared last, so services stop before the map is destroyed.
+  transport::Node node;
+  transport::Node::Publisher updatesPub;
 };
 
 //////////////////////////////////////////////////
@@ -103,6 +201,19 @@ ParametersRegistry::ParametersRegistry(
     _parametersServicesNamespace + "/declare_parameter"};
   this->dataPtr->node.Advertise(declareParameterSrvName,
     &ParametersRegistryPrivate::DeclareParameter, this->dataPtr.get());
+
+  std::string getParametersSrvName{
+    _parametersServicesNamespace + "/get_parameters"};
+  this->dataPtr->node.Advertise(getParametersSrvName,
+    &ParametersRegistryPrivate::GetParameters, this->dataPtr.get());
+
+  std::string setParametersSrvName{
+    _parametersServicesNamespace + "/set_parameters"};
+  this->dataPtr->node.Advertise(setParametersSrvName,
+    &ParametersRegistryPrivate::SetParameters, this->dataPtr.get());
+
+  this->dataPtr->updatesPub = this->dataPtr->node.Advertise<msgs::Parameter>(
+    _parametersServicesNamespace + "/parameter_updates");
 }
 
 //////////////////////////////////////////////////
@@ -119,17 +230,26 @@ ParametersRegistry & ParametersRegistry::operator=(
 bool ParametersRegistryPrivate::GetParameter(const msgs::ParameterName &_req,
   msgs::ParameterValue &_res)
 {
-  {
-    std::lock_guard guard{this->parametersMapMutex};
-    auto it = this->parametersMap.find(_req.name());
-    if (it == this->parametersMap.end()) {
-      return false;
-    }
-    _res.mutable_data()->PackFrom(*it->second, "gz_msgs");
+  auto entry = this->Find(_req.name());
+  if (!entry.value) {
+    return false;
   }
+  *_res.mutable_data() = *entry.packed;
   return true;
 }
 
+//////////////////////////////////////////////////
+ParametersRegistryPrivate::Entry ParametersRegistryPrivate::Find(
+  const std::string &_name) const
+{
+  std::shared_lock guard{this->parametersMapMutex};
+  auto it = this->parametersMap.find(_name);
+  if (it == this->parametersMap.end()) {
+    return Entry{};
+  }
+  return it->second;
+}
+
 //////////////////////////////////////////////////
 bool ParametersRegistryPrivate::ListParameters(const msgs::Empty &,
   msgs::ParameterDeclarations &_res)
@@ -139,12 +259,12 @@ bool ParametersRegistryPrivate::ListParameters(const msgs::Empty &,
   // Including the component key doesn't seem to matter much,
   // though it's also not wrong.
   {
-    std::lock_guard guard{this->parametersMapMutex};
+    std::shared_lock guard{this->parametersMapMutex};
     for (const auto & paramPair : this->parametersMap) {
       auto * decl = _res.add_parameter_declarations();
       decl->set_name(paramPair.first);
       decl->set_type(addGzMsgsPrefix(
-        paramPair.second->GetDescriptor()->name()));
+        paramPair.second.value->GetDescriptor()->name()));
     }
   }
   return true;
@@ -156,30 +276,132 @@ bool ParametersRegistryPrivate::SetParameter(
 {
   (void)_res;
   const auto & paramName = _req.name();
+  auto current = this->Find(paramName).value;
+  if (!current) {
+    _res.set_data(msgs::ParameterError::NOT_DECLARED);
+    return true;
+  }
+  auto requestedGzTypeOpt = getGzTypeFromAnyProto(
+    _req.value());
+  if (!requestedGzTypeOpt) {
+    _res.set_data(msgs::ParameterError::INVALID_TYPE);
+    return true;
+  }
+  auto requestedGzType = *requestedGzTypeOpt;
+  if (current->GetDescriptor()->name() != requestedGzType) {
+    _res.set_data(msgs::ParameterError::INVALID_TYPE);
+    return true;
+  }
+  std::unique_ptr<google::protobuf::Message> value{current->New()};
+  if (!_req.value().UnpackTo(value.get())) {
+    // unexpected error
+    return false;
+  }
+  auto packed = repackValue(_req.value(), *value);
+  std::lock_guard guard{this->parametersMapMutex};
+  this->ApplyUpdates({{paramName, Entry{std::move(value), packed}}});
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ParametersRegistryPrivate::GetParameters(const msgs::StringMsg_V &_req,
+  msgs::Bytes &_res)
+{
+  UpdatesT values;
   {
-    std::lock_guard guard{this->parametersMapMutex};
-    auto it = this->parametersMap.find(paramName);
-    if (it == this->parametersMap.end()) {
-      _res.set_data(msgs::ParameterError::NOT_DECLARED);
-      return true;
+    std::shared_lock guard{this->parametersMapMutex};
+    if (_req.data_size() == 0) {
+      values.assign(this->parametersMap.begin(), this->parametersMap.end());
     }
-    auto requestedGzTypeOpt = getGzTypeFromAnyProto(
-      _req.value());
-    if (!requestedGzTypeOpt) {
-      _res.set_data(msgs::ParameterError::INVALID_TYPE);
-      return true;
+    for (const auto & name : _req.data()) {
+      auto it = this->parametersMap.find(name);
+      if (it != this->parametersMap.end()) {
+        values.emplace_back(*it);
+      }
+    }
+  }
+
+  std::vector<msgs::Parameter> params(values.size());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    params[i].set_name(values[i].first);
+    *params[i].mutable_value() = *values[i].second.packed;
+  }
+  _res.set_data(serializeParameterBatch(params));
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ParametersRegistryPrivate::SetParameters(const msgs::Bytes &_req,
+  msgs::Parameter &_res)
+{
+  std::vector<msgs::Parameter> params;
+  if (!parseParameterBatch(_req.data(), params)) {
+    return false;
+  }
+
+  auto fail = [&_res](const std::string & _name,
+                      msgs::ParameterError::Type _error)
+  {
+    msgs::ParameterError error;
+    error.set_data(_error);
+    _res.set_name(_name);
+    _res.mutable_value()->PackFrom(error, "gz_msgs");
+    return true;
+  };
+
+  UpdatesT updates;
+  updates.reserve(params.size());
+  for (const auto & param : params) {
+    auto current = this->Find(param.name()).value;
+    if (!current) {
+      return fail(param.name(), msgs::ParameterError::NOT_DECLARED);
     }
-    auto requestedGzType = *requestedGzTypeOpt;
-    if (it->second->GetDescriptor()->name() != requestedGzType) {
-      _res.set_data(msgs::ParameterError::INVALID_TYPE);
-      return true;
+    auto requestedGzTypeOpt = getGzTypeFromAnyProto(param.value());
+    if (!requestedGzTypeOpt ||
+        current->GetDescriptor()->name() != *requestedGzTypeOpt)
+    {
+      return fail(param.name(), msgs::ParameterError::INVALID_TYPE);
     }
-    if (!_req.value().UnpackTo(it->second.get())) {
+    std::unique_ptr<google::protobuf::Message> value{current->New()};
+    if (!param.value().UnpackTo(value.get())) {
       // unexpected error
       return false;
     }
+    auto packed = repackValue(param.value(), *value);
+    updates.emplace_back(param.name(), Entry{std::move(value), packed});
   }
-  return true;
+  std::lock_guard guard{this->parametersMapMutex};
+  this->ApplyUpdates(updates);
+  return fail("", msgs::ParameterError::SUCCESS);
+}
+
+//////////////////////////////////////////////////
+std::string ParametersRegistryPrivate::ApplyUpdates(const UpdatesT &_updates)
+{
+  std::vector<ParametersMapT::iterator> its;
+  its.reserve(_updates.size());
+  for (const auto & update : _updates) {
+    auto it = this->parametersMap.find(update.first);
+    if (it == this->parametersMap.end()) {
+      return update.first;
+    }
+    its.push_back(it);
+  }
+  for (std::size_t i = 0; i < _updates.size(); ++i) {
+    its[i]->second = _updates[i].second;
+    this->PublishUpdate(its[i]->first, *its[i]->second.packed);
+  }
+  return "";
+}
+
+//////////////////////////////////////////////////
+void ParametersRegistryPrivate::PublishUpdate(const std::string &_name,
+  const google::protobuf::Any &_packed)
+{
+  msgs::Parameter update;
+  update.set_name(_name);
+  *update.mutable_value() = _packed;
+  this->updatesPub.Publish(update);
 }
 
 //////////////////////////////////////////////////
@@ -202,9 +424,10 @@ bool ParametersRegistryPrivate::DeclareParameter(
     // unexpected error
     return false;
   }
+  auto packed = repackValue(_req.value(), *paramValue);
   std::lock_guard guard{this->parametersMapMutex};
-  auto it_emplaced_pair = this->parametersMap.emplace(
-    std::make_pair(_req.name(), std::move(paramValue)));
+  auto it_emplaced_pair = this->parametersMap.emplace(_req.name(),
+    Entry{std::move(paramValue), packed});
   if (!it_emplaced_pair.second) {
     _res.set_data(msgs::ParameterError::ALREADY_DECLARED);
   }
@@ -221,9 +444,11 @@ ParametersRegistry::DeclareParameter(
     throw std::invalid_argument{
       "ParametersRegistry::DeclareParameter(): `_parameterName` is nullptr"};
   }
+  auto packed = packValue(*_initialValue);
   std::lock_guard guard{this->dataPtr->parametersMapMutex};
   auto it_emplaced_pair = this->dataPtr->parametersMap.emplace(
-    std::make_pair(_parameterName, std::move(_initialValue)));
+    _parameterName, ParametersRegistryPrivate::Entry{
+      std::move(_initialValue), packed});
   if (!it_emplaced_pair.second) {
     return ParameterResult{
       ParameterResultType::AlreadyDeclared,
@@ -257,22 +482,21 @@ ParametersRegistry::Parameter(
   const std::string & _parameterName,
   google::protobuf::Message & _parameter) const
 {
-  std::lock_guard guard{this->dataPtr->parametersMapMutex};
-  auto it = dataPtr->parametersMap.find(_parameterName);
-  if (it == dataPtr->parametersMap.end()) {
+  auto value = this->dataPtr->Find(_parameterName).value;
+  if (!value) {
     return ParameterResult{
       ParameterResultType::NotDeclared,
       _parameterName};
   }
   const auto & newProtoType = _parameter.GetDescriptor()->name();
-  const auto & protoType = it->second->GetDescriptor()->name();
+  const auto & protoType = value->GetDescriptor()->name();
   if (newProtoType != protoType) {
     return ParameterResult{
       ParameterResultType::InvalidType,
       _parameterName,
       addGzMsgsPrefix(protoType)};
   }
-  _parameter.CopyFrom(*it->second);
+  _parameter.CopyFrom(*value);
   return ParameterResult{ParameterResultType::Success};
 }
 
@@ -282,47 +506,47 @@ ParametersRegistry::Parameter(
   const std::string & _parameterName,
   std::unique_ptr<google::protobuf::Message> & _parameter) const
 {
-  std::lock_guard guard{this->dataPtr->parametersMapMutex};
-  auto it = dataPtr->parametersMap.find(_parameterName);
-  if (it == dataPtr->parametersMap.end()) {
+  auto value = this->dataPtr->Find(_parameterName).value;
+  if (!value) {
     return ParameterResult{
       ParameterResultType::NotDeclared,
       _parameterName};
   }
-  const auto & protoType = it->second->GetDescriptor()->name();
-  _parameter = gz::msgs::Factory::New(protoType);
-  if (!_parameter) {
-    return ParameterResult{
-      ParameterResultType::InvalidType,
-      _parameterName,
-      addGzMsgsPrefix(protoType)};
-
-  }
-  _parameter->CopyFrom(*it->second);
+  _parameter.reset(value->New());
+  _parameter->CopyFrom(*value);
   return ParameterResult{ParameterResultType::Success};
 }
 
+//////////////////////////////////////////////////
+std::shared_ptr<const google::protobuf::Message>
+ParametersRegistry::SharedParameter(const std::string & _parameterName) const
+{
+  return this->dataPtr->Find(_parameterName).value;
+}
+
 //////////////////////////////////////////////////
 ParameterResult
 ParametersRegistry::SetParameter(
   const std::string & _parameterName,
   std::unique_ptr<google::protobuf::Message> _value)
 {
-  std::lock_guard guard{this->dataPtr->parametersMapMutex};
-  auto it = this->dataPtr->parametersMap.find(_parameterName);
-  if (it == this->dataPtr->parametersMap.end()) {
+  auto current = this->dataPtr->Find(_parameterName).value;
+  if (!current) {
     return ParameterResult{
       ParameterResultType::NotDeclared,
       _parameterName};
   }
-  // Validate the type matches before copying.
-  if (it->second->GetDescriptor() != _value->GetDescriptor()) {
+  // Validate the type matches before storing.
+  if (current->GetDescriptor() != _value->GetDescriptor()) {
     return ParameterResult{
       ParameterResultType::InvalidType,
       _parameterName,
-      addGzMsgsPrefix(it->second->GetDescriptor()->name())};
+      addGzMsgsPrefix(current->GetDescriptor()->name())};
   }
-  it->second = std::move(_value);
+  auto packed = packValue(*_value);
+  std::lock_guard guard{this->dataPtr->parametersMapMutex};
+  this->dataPtr->ApplyUpdates({{_parameterName,
+    ParametersRegistryPrivate::Entry{std::move(_value), packed}}});
   return ParameterResult{ParameterResultType::Success};
 }
 
@@ -332,20 +556,107 @@ ParametersRegistry::SetParameter(
   const std::string & _parameterName,
   const google::protobuf::Message & _value)
 {
-  std::lock_guard guard{this->dataPtr->parametersMapMutex};
-  auto it = this->dataPtr->parametersMap.find(_parameterName);
-  if (it == this->dataPtr->parametersMap.end()) {
+  auto current = this->dataPtr->Find(_parameterName).value;
+  if (!current) {
     return ParameterResult{
       ParameterResultType::NotDeclared,
       _parameterName};
   }
   // Validate the type matches before copying.
-  if (it->second->GetDescriptor() != _value.GetDescriptor()) {
+  if (current->GetDescriptor() != _value.GetDescriptor()) {
     return ParameterResult{
       ParameterResultType::InvalidType,
       _parameterName};
   }
-  it->second->CopyFrom(_value);
+  std::unique_ptr<google::protobuf::Message> value{_value.New()};
+  value->CopyFrom(_value);
+  auto packed = packValue(*value);
+  std::lock_guard guard{this->dataPtr->parametersMapMutex};
+  this->dataPtr->ApplyUpdates({{_parameterName,
+    ParametersRegistryPrivate::Entry{std::move(value), packed}}});
+  return ParameterResult{ParameterResultType::Success};
+}
+
+//////////////////////////////////////////////////
+ParameterResult
+ParametersRegistry::Parameters(
+  const std::vector<std::string> & _parameterNames,
+  ParametersMap & _parameters) const
+{
+  _parameters.clear();
+  std::vector<ParametersRegistryPrivate::ValueT> values;
+  values.reserve(_parameterNames.size());
+  {
+    std::shared_lock guard{this->dataPtr->parametersMapMutex};
+    for (const auto & name : _parameterNames) {
+      auto it = this->dataPtr->parametersMap.find(name);
+      if (it == this->dataPtr->parametersMap.end()) {
+        return ParameterResult{ParameterResultType::NotDeclared, name};
+      }
+      values.push_back(it->second.value);
+    }
+  }
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    std::unique_ptr<google::protobuf::Message> value{values[i]->New()};
+    value->CopyFrom(*values[i]);
+    _parameters[_parameterNames[i]] = std::move(value);
+  }
+  return ParameterResult{ParameterResultType::Success};
+}
+
+//////////////////////////////////////////////////
+ParameterResult
+ParametersRegistry::ListParametersWithValues(
+  ParametersMap & _parameters) const
+{
+  _parameters.clear();
+  ParametersRegistryPrivate::UpdatesT values;
+  {
+    std::shared_lock guard{this->dataPtr->parametersMapMutex};
+    values.assign(this->dataPtr->parametersMap.begin(),
+      this->dataPtr->parametersMap.end());
+  }
+  for (const auto & valuePair : values) {
+    std::unique_ptr<google::protobuf::Message> value{
+      valuePair.second.value->New()};
+    value->CopyFrom(*valuePair.second.value);
+    _parameters[valuePair.first] = std::move(value);
+  }
+  return ParameterResult{ParameterResultType::Success};
+}
+
+//////////////////////////////////////////////////
+ParameterResult
+ParametersRegistry::SetParameters(const ParametersMap & _values)
+{
+  ParametersRegistryPrivate::UpdatesT updates;
+  updates.reserve(_values.size());
+  for (const auto & valuePair : _values) {
+    if (!valuePair.second) {
+      throw std::invalid_argument{
+        "ParametersRegistry::SetParameters(): value of `" +
+        valuePair.first + "` is nullptr"};
+    }
+    auto current = this->dataPtr->Find(valuePair.first).value;
+    if (!current) {
+      return ParameterResult{
+        ParameterResultType::NotDeclared,
+        valuePair.first};
+    }
+    if (current->GetDescriptor() != valuePair.second->GetDescriptor()) {
+      return ParameterResult{
+        ParameterResultType::InvalidType,
+        valuePair.first,
+        addGzMsgsPrefix(current->GetDescriptor()->name())};
+    }
+    std::unique_ptr<google::protobuf::Message> value{current->New()};
+    value->CopyFrom(*valuePair.second);
+    auto packed = packValue(*value);
+    updates.emplace_back(valuePair.first,
+      ParametersRegistryPrivate::Entry{std::move(value), packed});
+  }
+  std::lock_guard guard{this->dataPtr->parametersMapMutex};
+  this->dataPtr->ApplyUpdates(updates);
   return ParameterResult{ParameterResultType::Success};
 }
 
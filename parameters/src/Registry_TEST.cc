@@ -120,6 +120,83 @@ TEST(ParametersRegistry, ListParameters)
   EXPECT_TRUE(foundParam2) << "expected to find declaration for parameter2";
 }
 
+//////////////////////////////////////////////////
+TEST(ParametersRegistry, Batch)
+{
+  ParametersRegistry registry{""};
+  registry.DeclareParameter(
+    "parameter1", std::make_unique<gz::msgs::Boolean>());
+  registry.DeclareParameter(
+    "parameter2", std::make_unique<gz::msgs::StringMsg>());
+
+  ParametersMap values;
+  auto boolMsg = std::make_unique<gz::msgs::Boolean>();
+  boolMsg->set_data(true);
+  values["parameter1"] = std::move(boolMsg);
+  auto strMsg = std::make_unique<gz::msgs::StringMsg>();
+  strMsg->set_data("value");
+  values["parameter2"] = std::move(strMsg);
+  EXPECT_TRUE(registry.SetParameters(values));
+
+  ParametersMap got;
+  EXPECT_TRUE(registry.Parameters({"parameter1", "parameter2"}, got));
+  ASSERT_EQ(2u, got.size());
+  EXPECT_TRUE(
+    dynamic_cast<gz::msgs::Boolean &>(*got["parameter1"]).data());
+  EXPECT_EQ("value",
+    dynamic_cast<gz::msgs::StringMsg &>(*got["parameter2"]).data());
+
+  auto ret = registry.Parameters({"parameter1", "missing"}, got);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::NotDeclared);
+  EXPECT_EQ(ret.ParamName(), "missing");
+  EXPECT_TRUE(got.empty());
+
+  EXPECT_TRUE(registry.ListParametersWithValues(got));
+  EXPECT_EQ(2u, got.size());
+
+  // A failing batch doesn't change any parameter.
+  values["parameter1"] = std::make_unique<gz::msgs::Boolean>();
+  values["parameter2"] = std::make_unique<gz::msgs::Boolean>();
+  ret = registry.SetParameters(values);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::InvalidType);
+  EXPECT_EQ(ret.ParamName(), "parameter2");
+  gz::msgs::Boolean param1;
+  EXPECT_TRUE(registry.Parameter("parameter1", param1));
+  EXPECT_TRUE(param1.data());
+
+  values.clear();
+  values["missing"] = std::make_unique<gz::msgs::Boolean>();
+  ret = registry.SetParameters(values);
+  EXPECT_EQ(ret.ResultType(), ParameterResultType::NotDeclared);
+
+  values["missing"] = nullptr;
+  EXPECT_THROW(registry.SetParameters(values), std::invalid_argument);
+}
+
+//////////////////////////////////////////////////
+TEST(ParametersRegistry, SharedParameter)
+{
+  ParametersRegistry registry{""};
+  EXPECT_EQ(nullptr, registry.SharedParameter("parameter1"));
+  auto strMsg = std::make_unique<gz::msgs::StringMsg>();
+  strMsg->set_data("first");
+  registry.DeclareParameter("parameter1", std::move(strMsg));
+
+  auto first = registry.SharedParameter("parameter1");
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ("first",
+    dynamic_cast<const gz::msgs::StringMsg &>(*first).data());
+
+  // Setting the parameter doesn't modify values held by readers.
+  gz::msgs::StringMsg second;
+  second.set_data("second");
+  EXPECT_TRUE(registry.SetParameter("parameter1", second));
+  EXPECT_EQ("first",
+    dynamic_cast<const gz::msgs::StringMsg &>(*first).data());
+  EXPECT_EQ("second", dynamic_cast<const gz::msgs::StringMsg &>(
+    *registry.SharedParameter("parameter1")).data());
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
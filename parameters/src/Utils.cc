@@ -18,8 +18,14 @@
 #include "Utils.hh"
 
 #include <ios>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
 using namespace gz;
 //////////////////////////////////////////////////
 std::string
@@ -48,3 +54,53 @@ transport::parameters::getGzTypeFromAnyProto(
   }
   return ret.substr(sizeof(prefix) - 1);
 }
+
+//////////////////////////////////////////////////
+std::string
+transport::parameters::serializeParameterBatch(
+  const std::vector<msgs::Parameter> &_parameters)
+{
+  std::string data;
+  {
+    google::protobuf::io::StringOutputStream stream{&data};
+    google::protobuf::io::CodedOutputStream output{&stream};
+    for (const auto & param : _parameters) {
+      output.WriteVarint32(static_cast<uint32_t>(param.ByteSizeLong()));
+      param.SerializeWithCachedSizes(&output);
+    }
+  }
+  return data;
+}
+
+//////////////////////////////////////////////////
+bool
+transport::parameters::parseParameterBatch(
+  const std::string &_data,
+  std::vector<msgs::Parameter> &_parameters)
+{
+  if (_data.size() >
+      static_cast<std::size_t>(std::numeric_limits<int>::max()))
+  {
+    return false;
+  }
+  google::protobuf::io::CodedInputStream input{
+    reinterpret_cast<const uint8_t *>(_data.data()),
+    static_cast<int>(_data.size())};
+  input.PushLimit(static_cast<int>(_data.size()));
+  _parameters.clear();
+  while (input.BytesUntilLimit() != 0) {
+    uint32_t size{0};
+    if (!input.ReadVarint32(&size)) {
+      return false;
+    }
+    auto limit = input.PushLimit(static_cast<int>(size));
+    _parameters.emplace_back();
+    if (!_parameters.back().ParseFromCodedStream(&input) ||
+        !input.ConsumedEntireMessage())
+    {
+      return false;
+    }
+    input.PopLimit(limit);
+  }
+  return true;
+}
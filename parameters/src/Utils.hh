@@ -20,6 +20,9 @@
 
 #include <optional>
 #include <string>
+#include <vector>
+
+#include <gz/msgs/parameter.pb.h>
 
 #include "gz/transport/config.hh"
 #include "gz/transport/parameters/Export.hh"
@@ -55,6 +58,23 @@ namespace gz
       GZ_TRANSPORT_PARAMETERS_VISIBLE
       std::optional<std::string> getGzTypeFromAnyProto(
         const google::protobuf::Any &_any);
+
+      /// \brief Serialize a batch of parameters as consecutive length
+      /// delimited gz::msgs::Parameter records. Batches are sent as the data
+      /// of a gz::msgs::Bytes message.
+      /// \param[in] _parameters Parameters to serialize.
+      /// \return The serialized batch.
+      GZ_TRANSPORT_PARAMETERS_VISIBLE
+      std::string serializeParameterBatch(
+        const std::vector<msgs::Parameter> &_parameters);
+
+      /// \brief Parse a batch serialized with serializeParameterBatch().
+      /// \param[in] _data The serialized batch.
+      /// \param[out] _parameters The parameters of the batch.
+      /// \return False if the data is not a valid batch.
+      GZ_TRANSPORT_PARAMETERS_VISIBLE
+      bool parseParameterBatch(const std::string &_data,
+        std::vector<msgs::Parameter> &_parameters);
       }
     }
   }
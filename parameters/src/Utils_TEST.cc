@@ -17,6 +17,9 @@
 
 #include "Utils.hh"
 
+#include <string>
+#include <vector>
+
 #include <gz/msgs/boolean.pb.h>
 #include <gz/msgs/stringmsg.pb.h>
 
@@ -44,3 +47,31 @@ TEST(ParametersUtils, getGzTypeFromAnyProto)
   any.PackFrom(strMsg);
   EXPECT_EQ(*getGzTypeFromAnyProto(any), "StringMsg");
 }
+
+//////////////////////////////////////////////////
+TEST(ParametersUtils, ParameterBatch)
+{
+  std::vector<msgs::Parameter> params(3);
+  params[0].set_name("a");
+  gz::msgs::Boolean boolMsg;
+  boolMsg.set_data(true);
+  params[0].mutable_value()->PackFrom(boolMsg);
+  params[1].set_name("b");
+  params[2].set_name("c");
+  gz::msgs::StringMsg strMsg;
+  strMsg.set_data("value");
+  params[2].mutable_value()->PackFrom(strMsg);
+
+  std::vector<msgs::Parameter> parsed;
+  ASSERT_TRUE(parseParameterBatch(serializeParameterBatch(params), parsed));
+  ASSERT_EQ(3u, parsed.size());
+  for (std::size_t i = 0; i < params.size(); ++i)
+    EXPECT_EQ(params[i].SerializeAsString(), parsed[i].SerializeAsString());
+
+  EXPECT_TRUE(parseParameterBatch("", parsed));
+  EXPECT_TRUE(parsed.empty());
+
+  std::string truncated = serializeParameterBatch(params);
+  truncated.pop_back();
+  EXPECT_FALSE(parseParameterBatch(truncated, parsed));
+}
@@ -15,6 +15,7 @@
 
 from ._transport import Node as _Node
 from ._transport import *
+import asyncio
 import sys
 from typing import TypeVar, Callable
 import traceback
@@ -40,7 +41,9 @@ class Publisher(_Node.Publisher):
 
     def publish(self, proto_msg: ProtoMsg):
         """
-        Publishes a serialized protocol buffer message.
+        Publishes a serialized protocol buffer message. The message is
+        serialized while holding the GIL, which is released while the
+        serialized message is sent, so other threads keep running.
 
         Args:
             proto_msg (ProtoMsg): The protocol buffer message to be published.
@@ -54,6 +57,66 @@ class Publisher(_Node.Publisher):
         return self.publish_raw(msg_string, msg_type)
 
 
+class MessageBatches:
+    """
+    Batches of serialized messages received by Node.subscribe_batches.
+    The messages are queued in C++ without taking the GIL, and delivered
+    as lists of (bytes, MessageInfo) tuples, oldest first. It can be used
+    as an asynchronous iterator:
+
+        async for batch in node.subscribe_batches("/foo", StringMsg):
+            for data, info in batch:
+                ...
+    """
+
+    def __init__(self, node, topic: str, queue, max_batch: int,
+                 linger: float):
+        self._node = node
+        self._topic = topic
+        self._queue = queue
+        self.max_batch = max_batch
+        self.linger = linger
+
+    def get(self, timeout: float = 1.0):
+        """
+        Waits for a batch of messages. The GIL is released while waiting.
+
+        Args:
+            timeout (float): Maximum time (s) to wait for the first message.
+
+        Returns:
+            list: Up to max_batch (bytes, MessageInfo) tuples. Empty if no
+              message arrived in time or the subscription is closed.
+
+        """
+        return self._queue.pop_batch(self.max_batch, timeout, self.linger)
+
+    @property
+    def dropped(self):
+        """Number of messages dropped because the queue was full."""
+        return self._queue.dropped
+
+    def close(self):
+        """
+        Unsubscribes from the topic and wakes up the waiting consumers.
+        """
+        if not self._queue.closed:
+            self._node.unsubscribe(self._topic)
+            self._queue.close()
+
+    def __aiter__(self):
+        return self
+
+    async def __anext__(self):
+        loop = asyncio.get_running_loop()
+        while True:
+            batch = await loop.run_in_executor(None, self.get, 0.1)
+            if batch:
+                return batch
+            if self._queue.closed:
+                raise StopAsyncIteration
+
+
 class Node(_Node):
     """
     A wrapper class that extends the _Node class for managing
@@ -120,6 +183,41 @@ class Node(_Node):
             topic, cb_deserialize, msg_type.DESCRIPTOR.full_name, options
         )
 
+    def subscribe_batches(
+        self,
+        topic: str,
+        msg_type: ProtoMsgType,
+        max_batch: int = 64,
+        linger: float = 0.0,
+        capacity: int = 1024,
+        options=_transport.SubscribeOptions(),
+    ):
+        """
+        Subscribes to a topic and receives the serialized messages in
+        batches, taking the GIL once per batch instead of once per message.
+
+        Args:
+            topic (str): The name of the topic to subscribe to.
+            msg_type (ProtoMsgType): The type of the messages.
+            max_batch (int): Maximum number of messages per batch.
+            linger (float): Time (s) to wait for a batch to fill after its
+              first message, which bounds the rate of the batches.
+            capacity (int): Maximum number of queued messages. The oldest
+              messages are dropped when the consumer falls behind.
+            options (SubscribeOptions): Options for subscribing to
+              the topic. Defaults to SubscribeOptions().
+
+        Returns:
+            MessageBatches: The batches, or None if the subscription failed.
+
+        """
+        queue = MessageBatchQueue(capacity)
+        if not self.subscribe_raw_queue(
+            topic, queue, msg_type.DESCRIPTOR.full_name, options
+        ):
+            return None
+        return MessageBatches(self, topic, queue, max_batch, linger)
+
     def request(
         self,
         service: str,
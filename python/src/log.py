@@ -0,0 +1,45 @@
+# Copyright (C) 2024 Open Source Robotics Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Reading of log files. The messages are read in chunks, which store the
+# times, the topics and the data of many messages in a few buffers, so
+# that large logs can be processed without a Python object per message:
+#
+#   log = Log()
+#   log.open("state.tlog")
+#   for chunk in log.query_chunks(topics=["/foo"]):
+#       times = numpy.frombuffer(chunk.time_received, dtype=numpy.int64)
+#       for data in message_views(chunk):
+#           msg = StringMsg()
+#           msg.ParseFromString(data)
+
+from ._log import *
+
+
+def message_views(chunk: MessageChunk):
+    """
+    Splits the data of a chunk into the serialized messages, without
+    copying them.
+
+    Args:
+        chunk (MessageChunk): The chunk.
+
+    Returns:
+        list: A memoryview of the serialized data of every message. The
+          views keep the chunk alive.
+
+    """
+    data = memoryview(chunk)
+    offsets = memoryview(chunk.offsets).tolist()
+    return [data[begin:end] for begin, end in zip(offsets, offsets[1:])]
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/transport/log/Batch.hh>
+#include <gz/transport/log/Log.hh>
+#include <gz/transport/log/QueryOptions.hh>
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <regex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace gz
+{
+namespace transport
+{
+namespace python
+{
+
+/// \brief A column of integers that Python reads through the buffer
+/// protocol, e.g. with memoryview or numpy.frombuffer, without a copy.
+struct Column
+{
+  /// \brief The values.
+  std::vector<int64_t> values;
+};
+
+/// \brief Consecutive messages of a log, stored as columns. The data of
+/// every message is packed in a single buffer, exported through the buffer
+/// protocol, and delimited by the offsets column.
+struct MessageChunk
+{
+  /// \brief Time when every message was received (ns.).
+  std::shared_ptr<Column> timeReceived = std::make_shared<Column>();
+
+  /// \brief Index of the topic of every message in topics.
+  std::shared_ptr<Column> topicIndex = std::make_shared<Column>();
+
+  /// \brief Offset of the data of every message in data, followed by the
+  /// size of data.
+  std::shared_ptr<Column> offsets = std::make_shared<Column>();
+
+  /// \brief Topics of the messages of the chunk.
+  std::vector<std::string> topics;
+
+  /// \brief Message type of every topic in topics.
+  std::vector<std::string> types;
+
+  /// \brief Serialized messages.
+  std::string data;
+};
+
+/// \brief Iterates over the messages of a query in chunks. The log must
+/// stay open while iterating.
+class MessageChunks
+{
+  /// \brief Constructor.
+  /// \param[in] _batch The messages of the query.
+  /// \param[in] _chunkSize Maximum number of messages per chunk.
+  public: MessageChunks(log::Batch &&_batch, const std::size_t _chunkSize)
+    : batch(std::move(_batch)),
+      chunkSize(_chunkSize > 0 ? _chunkSize : 1)
+  {
+  }
+
+  /// \brief Read the next chunk.
+  /// \return The chunk, or nothing when all the messages were read.
+  public: std::optional<MessageChunk> Next()
+  {
+    if (!this->it)
+      this->it = this->batch.begin();
+    auto &next = *this->it;
+    if (next == this->batch.end())
+      return std::nullopt;
+
+    MessageChunk chunk;
+    std::unordered_map<std::string, int64_t> indexes;
+    chunk.timeReceived->values.reserve(this->chunkSize);
+    chunk.topicIndex->values.reserve(this->chunkSize);
+    chunk.offsets->values.reserve(this->chunkSize + 1);
+
+    for (std::size_t i = 0; i < this->chunkSize && next != this->batch.end();
+         ++i, ++next)
+    {
+      const log::Message &msg = *next;
+      auto inserted = indexes.emplace(msg.Topic(),
+        static_cast<int64_t>(chunk.topics.size()));
+      if (inserted.second)
+      {
+        chunk.topics.push_back(msg.Topic());
+        chunk.types.push_back(msg.Type());
+      }
+
+      const std::string_view data = msg.DataView();
+      chunk.timeReceived->values.push_back(msg.TimeReceived().count());
+      chunk.topicIndex->values.push_back(inserted.first->second);
+      chunk.offsets->values.push_back(
+        static_cast<int64_t>(chunk.data.size()));
+      chunk.data.append(data.data(), data.size());
+    }
+    chunk.offsets->values.push_back(static_cast<int64_t>(chunk.data.size()));
+    return chunk;
+  }
+
+  /// \brief The messages of the query.
+  private: log::Batch batch;
+
+  /// \brief The next message, created by the first call to Next().
+  private: std::optional<log::Batch::iterator> it;
+
+  /// \brief Maximum number of messages per chunk.
+  private: const std::size_t chunkSize;
+};
+
+/// \brief Build the query options of a query.
+/// \param[in] _topics Topics to query. Empty for all the topics.
+/// \param[in] _pattern Regular expression of the topics to query, used
+/// when _topics is empty. Empty for all the topics.
+/// \param[in] _begin Start of the time range (ns.), if any.
+/// \param[in] _end End of the time range (ns.), if any.
+/// \return The query options.
+std::unique_ptr<log::QueryOptions> queryOptions(
+  const std::vector<std::string> &_topics, const std::string &_pattern,
+  const std::optional<int64_t> &_begin, const std::optional<int64_t> &_end)
+{
+  const log::QualifiedTime begin = _begin ?
+    log::QualifiedTime(std::chrono::nanoseconds(*_begin)) :
+    log::QualifiedTime();
+  const log::QualifiedTime end = _end ?
+    log::QualifiedTime(std::chrono::nanoseconds(*_end)) :
+    log::QualifiedTime();
+  const log::QualifiedTimeRange range(begin, end);
+
+  if (!_topics.empty())
+  {
+    return std::make_unique<log::TopicList>(
+      std::set<std::string>(_topics.begin(), _topics.end()), range);
+  }
+  if (!_pattern.empty())
+    return std::make_unique<log::TopicPattern>(std::regex(_pattern), range);
+  return std::make_unique<log::AllTopics>(range);
+}
+
+PYBIND11_MODULE(LOG_BINDINGS_MODULE_NAME, m) {
+    py::class_<Column, std::shared_ptr<Column>>(
+      m, "Column", py::buffer_protocol(),
+      "A column of 64-bit integers, readable through the buffer protocol"
+      " without a copy, e.g. with memoryview or numpy.frombuffer.")
+      .def_buffer([](Column &_column) -> py::buffer_info
+      {
+        return py::buffer_info(
+          _column.values.data(), static_cast<py::ssize_t>(sizeof(int64_t)),
+          py::format_descriptor<int64_t>::format(), 1,
+          {static_cast<py::ssize_t>(_column.values.size())},
+          {static_cast<py::ssize_t>(sizeof(int64_t))}, true);
+      })
+      .def("__len__", [](const Column &_column)
+      {
+        return _column.values.size();
+      })
+      .def("__getitem__", [](const Column &_column, py::ssize_t _i)
+      {
+        const auto size = static_cast<py::ssize_t>(_column.values.size());
+        if (_i < 0)
+          _i += size;
+        if (_i < 0 || _i >= size)
+          throw py::index_error();
+        return _column.values[static_cast<std::size_t>(_i)];
+      });
+
+    py::class_<MessageChunk>(
+      m, "MessageChunk", py::buffer_protocol(),
+      "Consecutive messages of a log, stored as columns. The chunk exports"
+      " the serialized messages, packed one after the other, through the"
+      " buffer protocol.")
+      .def_buffer([](MessageChunk &_chunk) -> py::buffer_info
+      {
+        return py::buffer_info(
+          _chunk.data.data(), 1, py::format_descriptor<uint8_t>::format(),
+          1, {static_cast<py::ssize_t>(_chunk.data.size())}, {1}, true);
+      })
+      .def("__len__", [](const MessageChunk &_chunk)
+      {
+        return _chunk.timeReceived->values.size();
+      })
+      .def_property_readonly("time_received",
+          [](const MessageChunk &_chunk) { return _chunk.timeReceived; },
+          "Time when every message was received (ns.)")
+      .def_property_readonly("topic_index",
+          [](const MessageChunk &_chunk) { return _chunk.topicIndex; },
+          "Index of the topic of every message in topics")
+      .def_property_readonly("offsets",
+          [](const MessageChunk &_chunk) { return _chunk.offsets; },
+          "Offset of every message in the chunk, followed by the size of"
+          " the data")
+      .def_readonly("topics", &MessageChunk::topics,
+          "Topics of the messages of the chunk")
+      .def_readonly("types", &MessageChunk::types,
+          "Message type of every topic of the chunk");
+
+    py::class_<MessageChunks>(
+      m, "MessageChunks",
+      "Iterates over the messages of a query in chunks")
+      .def("__iter__", [](MessageChunks &_chunks) -> MessageChunks &
+      {
+        return _chunks;
+      })
+      .def("__next__", [](MessageChunks &_chunks)
+      {
+        std::optional<MessageChunk> chunk;
+        {
+          py::gil_scoped_release release;
+          chunk = _chunks.Next();
+        }
+        if (!chunk)
+          throw py::stop_iteration();
+        return std::move(*chunk);
+      });
+
+    py::class_<log::Log>(
+      m, "Log",
+      "Reads the messages of a log file")
+      .def(py::init<>())
+      .def("open", [](log::Log &_log, const std::string &_file,
+                      bool _write)
+      {
+        return _log.Open(_file, _write ?
+          std::ios_base::out : std::ios_base::in);
+      },
+          py::arg("file"),
+          py::arg("write") = false,
+          "Open a log file for reading, or for writing when write is true")
+      .def("insert_message", [](log::Log &_log, int64_t _time,
+                                const std::string &_topic,
+                                const std::string &_type,
+                                const py::buffer &_data)
+      {
+        const py::buffer_info info = _data.request();
+        return _log.InsertMessage(std::chrono::nanoseconds(_time), _topic,
+          _type, info.ptr, static_cast<std::size_t>(info.size *
+          info.itemsize));
+      },
+          py::arg("time"),
+          py::arg("topic"),
+          py::arg("msg_type"),
+          py::arg("data"),
+          "Insert a serialized message received at a time (ns.)")
+      .def("valid", &log::Log::Valid,
+          "Return true if a log file is open")
+      .def("version", &log::Log::Version,
+          "Get the version of the log file")
+      .def_property_readonly("start_time", [](const log::Log &_log)
+      {
+        return _log.StartTime().count();
+      }, "Time of the first message of the log (ns.)")
+      .def_property_readonly("end_time", [](const log::Log &_log)
+      {
+        return _log.EndTime().count();
+      }, "Time of the last message of the log (ns.)")
+      .def("query_chunks", [](log::Log &_log,
+                              const std::vector<std::string> &_topics,
+                              const std::string &_pattern,
+                              const std::optional<int64_t> &_begin,
+                              const std::optional<int64_t> &_end,
+                              std::size_t _chunkSize,
+                              std::size_t _readAhead)
+      {
+        const auto options = queryOptions(_topics, _pattern, _begin, _end);
+        py::gil_scoped_release release;
+        log::Batch batch = _log.QueryMessages(*options);
+        if (_readAhead > 0)
+          batch.SetReadAhead(_readAhead);
+        return std::make_unique<MessageChunks>(std::move(batch), _chunkSize);
+      },
+          py::arg("topics") = std::vector<std::string>(),
+          py::arg("pattern") = "",
+          py::arg("begin") = py::none(),
+          py::arg("end") = py::none(),
+          py::arg("chunk_size") = 4096,
+          py::arg("read_ahead") = 0,
+          py::keep_alive<0, 1>(),
+          "Query the messages of the log in chunks of up to chunk_size"
+          " messages. Messages can be filtered by a list of topics or a"
+          " regular expression, and a time range (ns.). When read_ahead is"
+          " positive, up to that many messages are read by a background"
+          " thread.");
+}  // gz-transport14 log module
+
+}  // python
+}  // transport
+}  // gz
@@ -23,9 +23,18 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 namespace py = pybind11;
 
@@ -36,6 +45,176 @@ namespace transport
 namespace python
 {
 
+/// \brief Messages received by a subscription and waiting for Python.
+/// The transport threads push the messages without taking the GIL, and
+/// Python pops them in batches, taking the GIL once per batch.
+class MessageBatchQueue
+{
+  /// \brief Constructor.
+  /// \param[in] _capacity Maximum number of queued messages. The oldest
+  /// message is dropped when a new one arrives to a full queue.
+  public: explicit MessageBatchQueue(const std::size_t _capacity)
+    : capacity(std::max<std::size_t>(_capacity, 1))
+  {
+  }
+
+  /// \brief Queue a message. Called from the transport threads.
+  /// \param[in] _data Serialized message.
+  /// \param[in] _size Size of the serialized message.
+  /// \param[in] _info Information about the message.
+  public: void Push(const char *_data, const std::size_t _size,
+                    const MessageInfo &_info)
+  {
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      if (this->closed)
+        return;
+      if (this->messages.size() >= this->capacity)
+      {
+        this->messages.pop_front();
+        ++this->dropped;
+      }
+      this->messages.emplace_back(std::string(_data, _size), _info);
+    }
+    this->cv.notify_one();
+  }
+
+  /// \brief Wait for messages and take a batch of them. Must be called
+  /// without the GIL.
+  /// \param[in] _maxBatch Maximum number of messages.
+  /// \param[in] _timeout Maximum time to wait for the first message.
+  /// \param[in] _linger Time to wait for more messages after the first
+  /// one, unless the batch is full.
+  /// \param[out] _batch The messages, oldest first.
+  public: void Pop(const std::size_t _maxBatch,
+                   const std::chrono::milliseconds _timeout,
+                   const std::chrono::milliseconds _linger,
+                   std::vector<std::pair<std::string, MessageInfo>> &_batch)
+  {
+    _batch.clear();
+    const std::size_t maxBatch = std::max<std::size_t>(_maxBatch, 1);
+
+    std::unique_lock<std::mutex> lk(this->mutex);
+    if (!this->cv.wait_for(lk, _timeout,
+          [this]{return this->closed || !this->messages.empty();}))
+    {
+      return;
+    }
+
+    if (_linger.count() > 0)
+    {
+      this->cv.wait_for(lk, _linger, [this, maxBatch]
+        {return this->closed || this->messages.size() >= maxBatch;});
+    }
+
+    while (!this->messages.empty() && _batch.size() < maxBatch)
+    {
+      _batch.push_back(std::move(this->messages.front()));
+      this->messages.pop_front();
+    }
+  }
+
+  /// \brief Stop queueing messages and wake up the waiting consumers.
+  public: void Close()
+  {
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      this->closed = true;
+    }
+    this->cv.notify_all();
+  }
+
+  /// \brief Whether Close() was called.
+  /// \return True if the queue is closed.
+  public: bool Closed() const
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    return this->closed;
+  }
+
+  /// \brief Number of queued messages.
+  /// \return The number of messages.
+  public: std::size_t Size() const
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    return this->messages.size();
+  }
+
+  /// \brief Number of messages dropped because the queue was full.
+  /// \return The number of messages.
+  public: uint64_t Dropped() const
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    return this->dropped;
+  }
+
+  /// \brief Maximum number of queued messages.
+  private: const std::size_t capacity;
+
+  /// \brief Protects the members below.
+  private: mutable std::mutex mutex;
+
+  /// \brief Signals new messages and the closing.
+  private: std::condition_variable cv;
+
+  /// \brief Queued messages.
+  private: std::deque<std::pair<std::string, MessageInfo>> messages;
+
+  /// \brief Number of messages dropped.
+  private: uint64_t dropped = 0;
+
+  /// \brief Whether the queue is closed.
+  private: bool closed = false;
+};
+
+/// \brief Release a memoryview over a transport buffer. A buffer exported
+/// from the view that is still alive, e.g. a NumPy array created with
+/// numpy.frombuffer, would outlive the transport buffer, so it is
+/// reported.
+/// \param[in] _view The view.
+void releaseView(py::memoryview &_view)
+{
+  try
+  {
+    _view.attr("release")();
+  }
+  catch (py::error_already_set &_e)
+  {
+    if (!_e.matches(PyExc_BufferError))
+      throw;
+    PyErr_WarnEx(PyExc_RuntimeWarning,
+      "A buffer exported from a message view is still in use after the "
+      "callback. Copy the data instead of keeping a reference to it.", 1);
+  }
+}
+
+/// \brief Publish a serialized message held by any object supporting the
+/// buffer protocol. The buffer is pinned while the GIL is released, so the
+/// bytes are handed to the transport without an intermediate Python copy
+/// and other Python threads keep running during the send.
+/// \param[in] _pub The publisher.
+/// \param[in] _data The serialized message. It must be contiguous.
+/// \param[in] _msgType The type of the message.
+/// \return True if the message was published.
+bool publishBuffer(Node::Publisher &_pub, const py::buffer &_data,
+                   const std::string &_msgType)
+{
+  const py::buffer_info info = _data.request();
+  py::ssize_t stride = info.itemsize;
+  for (auto i = info.ndim; i > 0; --i)
+  {
+    if (info.strides[i - 1] != stride)
+      throw py::buffer_error("The message buffer must be contiguous");
+    stride *= info.shape[i - 1];
+  }
+
+  const auto *bytes = static_cast<const char *>(info.ptr);
+  const auto size = static_cast<std::size_t>(info.size * info.itemsize);
+
+  py::gil_scoped_release release;
+  return _pub.PublishRaw(std::string(bytes, size), _msgType);
+}
+
 PYBIND11_MODULE(BINDINGS_MODULE_NAME, m) {
     py::class_<AdvertiseOptions>(
       m, "AdvertiseOptions",
@@ -153,6 +332,52 @@ PYBIND11_MODULE(BINDINGS_MODULE_NAME, m) {
       "A class that provides information about the message received.")
       .def(py::init<>());
 
+    py::class_<MessageBatchQueue, std::shared_ptr<MessageBatchQueue>>(
+      m, "MessageBatchQueue",
+      "A queue of serialized messages filled by a subscription without "
+      "taking the GIL and emptied by Python in batches.")
+      .def(py::init<std::size_t>(),
+          py::arg("capacity") = 1024)
+      .def("pop_batch", [](
+          MessageBatchQueue &_queue,
+          std::size_t _maxBatch,
+          double _timeout,
+          double _linger)
+          {
+            std::vector<std::pair<std::string, MessageInfo>> batch;
+            {
+              py::gil_scoped_release release;
+              _queue.Pop(_maxBatch,
+                std::chrono::milliseconds(static_cast<int64_t>(
+                  _timeout * 1000)),
+                std::chrono::milliseconds(static_cast<int64_t>(
+                  _linger * 1000)),
+                batch);
+            }
+
+            py::list result;
+            for (auto &msg : batch)
+            {
+              result.append(py::make_tuple(
+                py::bytes(msg.first.data(), msg.first.size()), msg.second));
+            }
+            return result;
+          },
+          py::arg("max_batch") = 64,
+          py::arg("timeout") = 1.0,
+          py::arg("linger") = 0.0,
+          "Wait up to 'timeout' seconds for a message, then up to 'linger' "
+          "seconds for the batch to fill, and return a list of at most "
+          "'max_batch' (bytes, MessageInfo) tuples. The GIL is released "
+          "while waiting.")
+      .def("close", &MessageBatchQueue::Close,
+          "Stop queueing messages and wake up the waiting consumers.")
+      .def_property_readonly("closed", &MessageBatchQueue::Closed,
+          "Whether the queue is closed.")
+      .def_property_readonly("dropped", &MessageBatchQueue::Dropped,
+          "Number of messages dropped because the queue was full.")
+      .def("__len__", &MessageBatchQueue::Size);
+
     py::class_<MessagePublisher>(
       m, "MessagePublisher",
       "This class stores all the information about a message publisher.")
@@ -291,6 +516,65 @@ PYBIND11_MODULE(BINDINGS_MODULE_NAME, m) {
           py::arg("callback"),
           py::arg("msg_type"),
           py::arg("options"))
+      .def("subscribe_raw_view", [](
+          Node &_node,
+          const std::string &_topic,
+          std::function<void(py::memoryview _msgData,
+                           const MessageInfo &_info)> &_callback,
+          const std::string &_msgType,
+          const SubscribeOptions &_opts)
+          {
+            auto _cb = [_callback](const char *_msgData, const size_t _size,
+                           const MessageInfo &_info){
+                pybind11::gil_scoped_acquire acq;
+                // The view borrows the transport buffer, which is only
+                // valid during the callback.
+                py::memoryview view = py::memoryview::from_memory(
+                  static_cast<const void *>(_msgData),
+                  static_cast<py::ssize_t>(_size));
+                try
+                {
+                  _callback(view, _info);
+                }
+                catch (...)
+                {
+                  releaseView(view);
+                  throw;
+                }
+                releaseView(view);
+            };
+            return _node.SubscribeRaw(_topic, _cb, _msgType, _opts);
+          },
+          py::arg("topic"),
+          py::arg("callback"),
+          py::arg("msg_type"),
+          py::arg("options"),
+          "Subscribe to a topic and receive the serialized messages as "
+          "read-only memoryviews over the transport buffers, without "
+          "copies. The views are released when the callback returns, so "
+          "the data must be consumed or copied during the callback, e.g. "
+          "numpy.frombuffer(view, dtype).copy().")
+      .def("subscribe_raw_queue", [](
+          Node &_node,
+          const std::string &_topic,
+          std::shared_ptr<MessageBatchQueue> _queue,
+          const std::string &_msgType,
+          const SubscribeOptions &_opts)
+          {
+            // The transport threads never take the GIL.
+            auto _cb = [_queue](const char *_msgData, const size_t _size,
+                           const MessageInfo &_info){
+                _queue->Push(_msgData, _size, _info);
+            };
+            py::gil_scoped_release release;
+            return _node.SubscribeRaw(_topic, _cb, _msgType, _opts);
+          },
+          py::arg("topic"),
+          py::arg("queue"),
+          py::arg("msg_type"),
+          py::arg("options"),
+          "Subscribe to a topic and queue the serialized messages in a "
+          "MessageBatchQueue, which Python empties in batches.")
       .def_property_readonly("options", &Node::Options,
           "Get the reference to the current node options.")
       .def("enable_stats", &Node::EnableStats,
@@ -314,9 +598,17 @@ PYBIND11_MODULE(BINDINGS_MODULE_NAME, m) {
       .def("valid", &gz::transport::Node::Publisher::Valid,
           "Return true if valid information, such as a non-empty"
           " topic name, is present.")
+      .def("publish_raw", &publishBuffer,
+          py::arg("msg_data"),
+          py::arg("msg_type"),
+          "Publish a serialized message from a bytes-like object. The GIL"
+          " is released while the message is sent.")
       .def("publish_raw", &gz::transport::Node::Publisher::PublishRaw,
           py::arg("msg_data"),
-          py::arg("msg_type"))
+          py::arg("msg_type"),
+          py::call_guard<py::gil_scoped_release>(),
+          "Publish a serialized message. The GIL is released while the"
+          " message is sent.")
       .def("throttled_update_ready",
           &gz::transport::Node::Publisher::ThrottledUpdateReady,
           "")
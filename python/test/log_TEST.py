@@ -0,0 +1,86 @@
+# Copyright (C) 2024 Open Source Robotics Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from gz.msgs11.stringmsg_pb2 import StringMsg
+from gz.transport14.log import Log, message_views
+
+import os
+import tempfile
+import unittest
+
+
+class LogTEST(unittest.TestCase):
+
+    def setUp(self):
+        self.tmp_dir = tempfile.TemporaryDirectory()
+        self.file = os.path.join(self.tmp_dir.name, "test.tlog")
+
+        log = Log()
+        self.assertTrue(log.open(self.file, write=True))
+        for i in range(10):
+            msg = StringMsg()
+            msg.data = str(i)
+            topic = "/foo" if i % 2 == 0 else "/bar"
+            self.assertTrue(log.insert_message(
+                i * 1000, topic, "gz.msgs.StringMsg",
+                msg.SerializeToString()))
+        del log
+
+        self.log = Log()
+        self.assertTrue(self.log.open(self.file))
+
+    def tearDown(self):
+        del self.log
+        self.tmp_dir.cleanup()
+
+    # Check that all the messages are read in chunks.
+    def test_query_chunks(self):
+        self.assertTrue(self.log.valid())
+        self.assertEqual(self.log.start_time, 0)
+        self.assertEqual(self.log.end_time, 9000)
+
+        chunks = list(self.log.query_chunks(chunk_size=4))
+        self.assertEqual([len(chunk) for chunk in chunks], [4, 4, 2])
+
+        times = []
+        data = []
+        for chunk in chunks:
+            times += memoryview(chunk.time_received).tolist()
+            for i, view in enumerate(message_views(chunk)):
+                msg = StringMsg()
+                msg.ParseFromString(view)
+                data.append(msg.data)
+                topic = chunk.topics[chunk.topic_index[i]]
+                self.assertEqual(topic,
+                                 "/foo" if int(msg.data) % 2 == 0 else "/bar")
+            self.assertEqual(chunk.types, ["gz.msgs.StringMsg"] * 2)
+
+        self.assertEqual(times, [i * 1000 for i in range(10)])
+        self.assertEqual(data, [str(i) for i in range(10)])
+
+    # Check that the messages are filtered by topic and time.
+    def test_query_filters(self):
+        chunks = list(self.log.query_chunks(topics=["/foo"], begin=2000,
+                                            end=6000, read_ahead=8))
+        self.assertEqual(len(chunks), 1)
+        self.assertEqual(memoryview(chunks[0].time_received).tolist(),
+                         [2000, 4000, 6000])
+        self.assertEqual(chunks[0].topics, ["/foo"])
+
+        chunks = list(self.log.query_chunks(pattern="/b.*"))
+        self.assertEqual(sum(len(chunk) for chunk in chunks), 5)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -19,6 +19,7 @@ from gz.transport14 import Node, AdvertiseMessageOptions, SubscribeOptions, Topi
 
 from threading import Lock
 
+import asyncio
 import time
 import unittest
 
@@ -57,6 +58,18 @@ class PubSubTEST(unittest.TestCase):
         self.assertTrue(self.pub.publish(self.vector3d_msg))
         self.assertFalse(self.pub.publish(string_msg))
 
+    # Check that serialized messages are published from bytes-like objects.
+    def test_publish_raw_buffer(self):
+        data = self.vector3d_msg.SerializeToString()
+        self.assertTrue(self.pub.publish_raw(data, "gz.msgs.Vector3d"))
+        self.assertTrue(self.pub.publish_raw(bytearray(data),
+                                             "gz.msgs.Vector3d"))
+        self.assertTrue(self.pub.publish_raw(memoryview(data),
+                                             "gz.msgs.Vector3d"))
+        self.assertFalse(self.pub.publish_raw(data, "gz.msgs.StringMsg"))
+        with self.assertRaises(BufferError):
+            self.pub.publish_raw(memoryview(data)[::2], "gz.msgs.Vector3d")
+
     # Checks the `advertised_topic` method.
     def test_advertised_topics(self):
         advertised_topics = self.pub_node.advertised_topics()
@@ -96,6 +109,61 @@ class PubSubTEST(unittest.TestCase):
         self.assertTrue(sub_node.unsubscribe(self.vector3d_topic))
         self.assertFalse(self.pub.has_connections())
 
+    # Check that the serialized message is received as a read-only view.
+    def test_raw_view_callback(self):
+        def view_cb(view, msg_info):
+            with mutex:
+                self.assertTrue(view.readonly)
+                msg = Vector3d()
+                msg.ParseFromString(bytes(view))
+                self.received_msg = msg.x
+
+        # Subscriber set up
+        sub_node = Node()
+        self.assertTrue(
+            sub_node.subscribe_raw_view(self.vector3d_topic, view_cb,
+                                        Vector3d.DESCRIPTOR.full_name,
+                                        SubscribeOptions())
+        )
+
+        # Publish and expect callback
+        self.received_msg = 0
+        self.assertTrue(self.pub.publish(self.vector3d_msg))
+        time.sleep(0.5)
+        with mutex:
+            self.assertEqual(self.received_msg, self.vector3d_msg.x)
+        self.assertTrue(sub_node.unsubscribe(self.vector3d_topic))
+
+    # Check that the messages are received in batches.
+    def test_batches(self):
+        sub_node = Node()
+        batches = sub_node.subscribe_batches(self.vector3d_topic, Vector3d,
+                                             max_batch=4, linger=0.2)
+        self.assertIsNotNone(batches)
+
+        for _ in range(6):
+            self.assertTrue(self.pub.publish(self.vector3d_msg))
+
+        batch = batches.get(timeout=1.0)
+        self.assertEqual(len(batch), 4)
+        msg = Vector3d()
+        msg.ParseFromString(batch[0][0])
+        self.assertEqual(msg.x, self.vector3d_msg.x)
+        self.assertEqual(len(batches.get(timeout=1.0)), 2)
+        self.assertEqual(batches.dropped, 0)
+
+        # The asynchronous iterator stops once the batches are closed.
+        async def consume():
+            received = 0
+            async for batch in batches:
+                received += len(batch)
+                batches.close()
+            return received
+
+        self.assertTrue(self.pub.publish(self.vector3d_msg))
+        self.assertEqual(asyncio.run(consume()), 1)
+        self.assertFalse(self.pub.has_connections())
+
     # Check that a message is not received if the callback does not use
     # the advertised types.
     def test_wrong_msg_type_callback(self):
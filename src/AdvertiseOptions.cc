@@ -15,11 +15,16 @@
  *
 */
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <utility>
 
 #include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/Clock.hh"
 #include "gz/transport/Helpers.hh"
 
 using namespace gz;
@@ -57,6 +62,79 @@ namespace gz
 
       /// \brief Default message publication rate.
       public: uint64_t msgsPerSec = kUnthrottled;
+
+      /// \brief Clock of the throttling, or nullptr for the steady clock.
+      public: std::shared_ptr<const Clock> throttleClock;
+
+      /// \brief Average rate allowed by the rate limit, or 0.
+      public: uint64_t rateLimit = 0;
+
+      /// \brief Burst allowed by the rate limit (messages).
+      public: uint64_t rateLimitBurst = 1;
+
+      /// \brief Average bandwidth allowed by the bandwidth limit, or 0.
+      public: uint64_t bandwidthLimit = 0;
+
+      /// \brief Burst allowed by the bandwidth limit (bytes).
+      public: uint64_t bandwidthBurst = 0;
+
+      /// \brief Whether the limits only apply to the remote subscribers.
+      public: bool rateLimitRemoteOnly = false;
+
+      /// \brief Maximum number of messages per batch.
+      public: uint64_t batchSize = 1;
+
+      /// \brief Maximum time that a message waits in a batch.
+      public: std::chrono::microseconds batchPeriod{1000};
+
+      /// \brief Compression codec.
+      public: Compression_t compression = Compression_t::NONE;
+
+      /// \brief Compression level.
+      public: int compressionLevel = 0;
+
+      /// \brief Number of messages kept for late subscribers.
+      public: uint64_t latchDepth = 0;
+
+      /// \brief Maximum number of messages waiting for the local
+      /// subscribers, or 0 if they are not bounded.
+      public: uint64_t queueDepth = 0;
+
+      /// \brief What happens when the queue is full.
+      public: QueuePolicy_t queuePolicy = QueuePolicy_t::DROP_OLDEST;
+
+      /// \brief Whether the topic uses the high priority lane.
+      public: bool highPriority = false;
+
+      /// \brief IPv4 address of the interface used to send the topic.
+      public: std::string interface;
+
+      /// \brief Whether the topic is sent through UDP multicast.
+      public: bool multicast = false;
+
+      /// \brief Topic of the publisher statistics.
+      public: std::string statisticsTopic;
+
+      /// \brief Publication rate of the publisher statistics.
+      public: uint64_t statisticsRate = 1;
+
+      /// \brief Number of real-time slots, or 0.
+      public: uint64_t realTimeSlots = 0;
+
+      /// \brief Size of a real-time slot (bytes).
+      public: uint64_t realTimeSlotSize = 4096;
+
+      /// \brief Whether the publisher passes file descriptors.
+      public: bool fdPassing = false;
+
+      /// \brief Number of messages kept for retransmission.
+      public: uint64_t reliableDepth = 0;
+
+      /// \brief Whether the latest message is kept in shared memory.
+      public: bool blackboard = false;
+
+      /// \brief Latency target of the adaptive rate, or 0.
+      public: std::chrono::milliseconds latencyTarget{0};
     };
 
     /// \internal
@@ -68,6 +146,22 @@ namespace gz
 
       /// \brief Destructor.
       public: virtual ~AdvertiseServiceOptionsPrivate() = default;
+
+      /// \brief Maximum number of requests executed at the same time.
+      public: unsigned int concurrency = 0;
+
+      /// \brief Maximum number of requests waiting for a worker, or 0 if
+      /// they are not bounded.
+      public: uint64_t maxPending = 0;
+
+      /// \brief Whether the service is idempotent.
+      public: bool idempotent = false;
+
+      /// \brief Time to live of the cached responses.
+      public: std::chrono::milliseconds cacheTtl{1000};
+
+      /// \brief Name of the callback group, or empty.
+      public: std::string callbackGroup;
     };
     }
   }
@@ -148,6 +242,24 @@ AdvertiseMessageOptions &AdvertiseMessageOptions::operator=(
 {
   AdvertiseOptions::operator=(_other);
   this->SetMsgsPerSec(_other.MsgsPerSec());
+  this->SetThrottleClock(_other.ThrottleClock());
+  this->SetRateLimit(_other.RateLimit(), _other.RateLimitBurst());
+  this->SetBandwidthLimit(_other.BandwidthLimit(), _other.BandwidthBurst());
+  this->SetRateLimitRemoteOnly(_other.RateLimitRemoteOnly());
+  this->SetBatchSize(_other.BatchSize());
+  this->SetBatchPeriod(_other.BatchPeriod());
+  this->SetCompression(_other.Compression(), _other.CompressionLevel());
+  this->SetLatchDepth(_other.LatchDepth());
+  this->SetQueue(_other.QueueDepth(), _other.QueuePolicy());
+  this->SetHighPriority(_other.HighPriority());
+  this->SetInterface(_other.Interface());
+  this->SetMulticast(_other.Multicast());
+  this->SetStatisticsTopic(_other.StatisticsTopic(), _other.StatisticsRate());
+  this->SetRealTime(_other.RealTimeSlots(), _other.RealTimeSlotSize());
+  this->SetFdPassing(_other.FdPassing());
+  this->SetReliableDepth(_other.ReliableDepth());
+  this->SetBlackboard(_other.Blackboard());
+  this->SetLatencyTarget(_other.LatencyTarget());
   return *this;
 }
 
@@ -156,7 +268,31 @@ bool AdvertiseMessageOptions::operator==(
   const AdvertiseMessageOptions &_other) const
 {
   return AdvertiseOptions::operator==(_other) &&
-         this->MsgsPerSec() == _other.MsgsPerSec();
+         this->MsgsPerSec() == _other.MsgsPerSec() &&
+         this->ThrottleClock() == _other.ThrottleClock() &&
+         this->RateLimit() == _other.RateLimit() &&
+         this->RateLimitBurst() == _other.RateLimitBurst() &&
+         this->BandwidthLimit() == _other.BandwidthLimit() &&
+         this->BandwidthBurst() == _other.BandwidthBurst() &&
+         this->RateLimitRemoteOnly() == _other.RateLimitRemoteOnly() &&
+         this->BatchSize() == _other.BatchSize() &&
+         this->BatchPeriod() == _other.BatchPeriod() &&
+         this->Compression() == _other.Compression() &&
+         this->CompressionLevel() == _other.CompressionLevel() &&
+         this->LatchDepth() == _other.LatchDepth() &&
+         this->QueueDepth() == _other.QueueDepth() &&
+         this->QueuePolicy() == _other.QueuePolicy() &&
+         this->HighPriority() == _other.HighPriority() &&
+         this->Interface() == _other.Interface() &&
+         this->Multicast() == _other.Multicast() &&
+         this->StatisticsTopic() == _other.StatisticsTopic() &&
+         this->StatisticsRate() == _other.StatisticsRate() &&
+         this->RealTimeSlots() == _other.RealTimeSlots() &&
+         this->RealTimeSlotSize() == _other.RealTimeSlotSize() &&
+         this->FdPassing() == _other.FdPassing() &&
+         this->ReliableDepth() == _other.ReliableDepth() &&
+         this->Blackboard() == _other.Blackboard() &&
+         this->LatencyTarget() == _other.LatencyTarget();
 }
 
 //////////////////////////////////////////////////
@@ -184,6 +320,311 @@ void AdvertiseMessageOptions::SetMsgsPerSec(const uint64_t _newMsgsPerSec)
   this->dataPtr->msgsPerSec = _newMsgsPerSec;
 }
 
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetThrottleClock(
+  std::shared_ptr<const Clock> _clock)
+{
+  this->dataPtr->throttleClock = std::move(_clock);
+}
+
+//////////////////////////////////////////////////
+const std::shared_ptr<const Clock> &
+AdvertiseMessageOptions::ThrottleClock() const
+{
+  return this->dataPtr->throttleClock;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::RateLimit() const
+{
+  return this->dataPtr->rateLimit;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::RateLimitBurst() const
+{
+  return this->dataPtr->rateLimitBurst;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetRateLimit(const uint64_t _msgsPerSec,
+  const uint64_t _burst)
+{
+  this->dataPtr->rateLimit = _msgsPerSec;
+  this->dataPtr->rateLimitBurst = std::max<uint64_t>(_burst, 1u);
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::BandwidthLimit() const
+{
+  return this->dataPtr->bandwidthLimit;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::BandwidthBurst() const
+{
+  return this->dataPtr->bandwidthBurst;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetBandwidthLimit(const uint64_t _bytesPerSec,
+  const uint64_t _burst)
+{
+  this->dataPtr->bandwidthLimit = _bytesPerSec;
+  this->dataPtr->bandwidthBurst = _burst > 0 ? _burst : _bytesPerSec;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::RateLimitRemoteOnly() const
+{
+  return this->dataPtr->rateLimitRemoteOnly;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetRateLimitRemoteOnly(const bool _remoteOnly)
+{
+  this->dataPtr->rateLimitRemoteOnly = _remoteOnly;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Batched() const
+{
+  return this->BatchSize() > 1;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::BatchSize() const
+{
+  return this->dataPtr->batchSize;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetBatchSize(const uint64_t _batchSize)
+{
+  this->dataPtr->batchSize = _batchSize;
+}
+
+//////////////////////////////////////////////////
+std::chrono::microseconds AdvertiseMessageOptions::BatchPeriod() const
+{
+  return this->dataPtr->batchPeriod;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetBatchPeriod(
+  const std::chrono::microseconds &_period)
+{
+  this->dataPtr->batchPeriod = _period;
+}
+
+//////////////////////////////////////////////////
+Compression_t AdvertiseMessageOptions::Compression() const
+{
+  return this->dataPtr->compression;
+}
+
+//////////////////////////////////////////////////
+int AdvertiseMessageOptions::CompressionLevel() const
+{
+  return this->dataPtr->compressionLevel;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetCompression(const Compression_t _codec,
+  const int _level)
+{
+  this->dataPtr->compression = _codec;
+  this->dataPtr->compressionLevel = _level;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Latched() const
+{
+  return this->LatchDepth() > 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::LatchDepth() const
+{
+  return this->dataPtr->latchDepth;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetLatchDepth(const uint64_t _depth)
+{
+  this->dataPtr->latchDepth = _depth;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Queued() const
+{
+  return this->QueueDepth() > 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::QueueDepth() const
+{
+  return this->dataPtr->queueDepth;
+}
+
+//////////////////////////////////////////////////
+QueuePolicy_t AdvertiseMessageOptions::QueuePolicy() const
+{
+  return this->dataPtr->queuePolicy;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetQueue(const uint64_t _depth,
+  const QueuePolicy_t _policy)
+{
+  this->dataPtr->queueDepth = _depth;
+  this->dataPtr->queuePolicy = _policy;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::HighPriority() const
+{
+  return this->dataPtr->highPriority;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetHighPriority(const bool _highPriority)
+{
+  this->dataPtr->highPriority = _highPriority;
+}
+
+//////////////////////////////////////////////////
+std::string AdvertiseMessageOptions::Interface() const
+{
+  return this->dataPtr->interface;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetInterface(const std::string &_ip)
+{
+  this->dataPtr->interface = _ip;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Multicast() const
+{
+  return this->dataPtr->multicast;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetMulticast(const bool _multicast)
+{
+  this->dataPtr->multicast = _multicast;
+}
+
+//////////////////////////////////////////////////
+std::string AdvertiseMessageOptions::StatisticsTopic() const
+{
+  return this->dataPtr->statisticsTopic;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::StatisticsRate() const
+{
+  return this->dataPtr->statisticsRate;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetStatisticsTopic(const std::string &_topic,
+  const uint64_t _msgsPerSec)
+{
+  this->dataPtr->statisticsTopic = _topic;
+  this->dataPtr->statisticsRate = _msgsPerSec;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::RealTime() const
+{
+  return this->RealTimeSlots() > 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::RealTimeSlots() const
+{
+  return this->dataPtr->realTimeSlots;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::RealTimeSlotSize() const
+{
+  return this->dataPtr->realTimeSlotSize;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetRealTime(const uint64_t _slots,
+  const uint64_t _slotSize)
+{
+  this->dataPtr->realTimeSlots = _slots;
+  this->dataPtr->realTimeSlotSize = _slotSize;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::FdPassing() const
+{
+  return this->dataPtr->fdPassing;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetFdPassing(const bool _fdPassing)
+{
+  this->dataPtr->fdPassing = _fdPassing;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Reliable() const
+{
+  return this->ReliableDepth() > 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseMessageOptions::ReliableDepth() const
+{
+  return this->dataPtr->reliableDepth;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetReliableDepth(const uint64_t _depth)
+{
+  this->dataPtr->reliableDepth = _depth;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Blackboard() const
+{
+  return this->dataPtr->blackboard;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetBlackboard(const bool _blackboard)
+{
+  this->dataPtr->blackboard = _blackboard;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseMessageOptions::Adaptive() const
+{
+  return this->dataPtr->latencyTarget.count() > 0;
+}
+
+//////////////////////////////////////////////////
+std::chrono::milliseconds AdvertiseMessageOptions::LatencyTarget() const
+{
+  return this->dataPtr->latencyTarget;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseMessageOptions::SetLatencyTarget(
+  const std::chrono::milliseconds &_target)
+{
+  this->dataPtr->latencyTarget =
+    std::max(_target, std::chrono::milliseconds::zero());
+}
+
 //////////////////////////////////////////////////
 AdvertiseServiceOptions::AdvertiseServiceOptions()
   : AdvertiseOptions(),
@@ -209,6 +650,10 @@ AdvertiseServiceOptions &AdvertiseServiceOptions::operator=(
   const AdvertiseServiceOptions &_other)
 {
   AdvertiseOptions::operator=(_other);
+  this->SetConcurrency(_other.Concurrency());
+  this->SetMaxPending(_other.MaxPending());
+  this->SetIdempotent(_other.Idempotent(), _other.CacheTtl());
+  this->SetCallbackGroup(_other.CallbackGroup());
   return *this;
 }
 
@@ -216,7 +661,12 @@ AdvertiseServiceOptions &AdvertiseServiceOptions::operator=(
 bool AdvertiseServiceOptions::operator==(
   const AdvertiseServiceOptions &_other) const
 {
-  return AdvertiseOptions::operator==(_other);
+  return AdvertiseOptions::operator==(_other) &&
+         this->Concurrency() == _other.Concurrency() &&
+         this->MaxPending() == _other.MaxPending() &&
+         this->Idempotent() == _other.Idempotent() &&
+         this->CacheTtl() == _other.CacheTtl() &&
+         this->CallbackGroup() == _other.CallbackGroup();
 }
 
 //////////////////////////////////////////////////
@@ -225,3 +675,59 @@ bool AdvertiseServiceOptions::operator!=(
 {
   return !(*this == _other);
 }
+
+//////////////////////////////////////////////////
+unsigned int AdvertiseServiceOptions::Concurrency() const
+{
+  return this->dataPtr->concurrency;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseServiceOptions::SetConcurrency(const unsigned int _concurrency)
+{
+  this->dataPtr->concurrency = _concurrency;
+}
+
+//////////////////////////////////////////////////
+uint64_t AdvertiseServiceOptions::MaxPending() const
+{
+  return this->dataPtr->maxPending;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseServiceOptions::SetMaxPending(const uint64_t _maxPending)
+{
+  this->dataPtr->maxPending = _maxPending;
+}
+
+//////////////////////////////////////////////////
+bool AdvertiseServiceOptions::Idempotent() const
+{
+  return this->dataPtr->idempotent;
+}
+
+//////////////////////////////////////////////////
+std::chrono::milliseconds AdvertiseServiceOptions::CacheTtl() const
+{
+  return this->dataPtr->cacheTtl;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseServiceOptions::SetIdempotent(const bool _idempotent,
+  const std::chrono::milliseconds &_ttl)
+{
+  this->dataPtr->idempotent = _idempotent;
+  this->dataPtr->cacheTtl = _ttl;
+}
+
+//////////////////////////////////////////////////
+std::string AdvertiseServiceOptions::CallbackGroup() const
+{
+  return this->dataPtr->callbackGroup;
+}
+
+//////////////////////////////////////////////////
+void AdvertiseServiceOptions::SetCallbackGroup(const std::string &_group)
+{
+  this->dataPtr->callbackGroup = _group;
+}
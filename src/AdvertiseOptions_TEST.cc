@@ -15,11 +15,14 @@
  *
 */
 
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/Clock.hh"
 #include "gz/transport/Helpers.hh"
 #include "gtest/gtest.h"
 
@@ -166,6 +169,72 @@ TEST(AdvertiseOptionsTest, msgStreamInsertion)
     "\tThrottled? Yes\n"
     "\tRate: 10 msgs/sec\n";
   EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetBatchSize(5u);
+  opts.SetBatchPeriod(std::chrono::microseconds(200));
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tBatch size: 5 msgs\n"
+    "\tBatch period: 200 us\n";
+  EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetBatchSize(1u);
+  opts.SetCompression(Compression_t::LZ4, 2);
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tCompression: LZ4 (level 2)\n";
+  EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetCompression(Compression_t::NONE);
+  opts.SetLatchDepth(3u);
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tLatched: 3 msgs\n";
+  EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetLatchDepth(0u);
+  opts.SetQueue(4u, QueuePolicy_t::DROP_NEWEST);
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tQueue: 4 msgs (drop newest)\n";
+  EXPECT_EQ(output.str(), expectedOutput);
+
+  output.clear();
+  output.str("");
+  opts.SetQueue(0u);
+  opts.SetHighPriority(true);
+  output << opts;
+  expectedOutput =
+    "Advertise options:\n"
+    "\tScope: All\n"
+    "\tThrottled? Yes\n"
+    "\tRate: 10 msgs/sec\n"
+    "\tPriority: high\n";
+  EXPECT_EQ(output.str(), expectedOutput);
 }
 
 //////////////////////////////////////////////////
@@ -184,6 +253,199 @@ TEST(AdvertiseOptionsTest, msgAccessors)
   opts.SetMsgsPerSec(10u);
   EXPECT_EQ(opts.MsgsPerSec(), 10u);
   EXPECT_TRUE(opts.Throttled());
+
+  // Throttle clock.
+  EXPECT_EQ(opts.ThrottleClock(), nullptr);
+  std::shared_ptr<const Clock> clock(WallClock::Instance(),
+    [](const Clock *){});
+  {
+    AdvertiseMessageOptions clockOpts(opts);
+    clockOpts.SetThrottleClock(clock);
+    EXPECT_EQ(clockOpts.ThrottleClock(), clock);
+    EXPECT_NE(opts, clockOpts);
+    AdvertiseMessageOptions clockOpts2(clockOpts);
+    EXPECT_EQ(clockOpts, clockOpts2);
+  }
+
+  // Batching.
+  EXPECT_FALSE(opts.Batched());
+  EXPECT_EQ(opts.BatchSize(), 1u);
+  EXPECT_EQ(opts.BatchPeriod(), std::chrono::microseconds(1000));
+  opts.SetBatchSize(20u);
+  opts.SetBatchPeriod(std::chrono::microseconds(500));
+  EXPECT_TRUE(opts.Batched());
+  EXPECT_EQ(opts.BatchSize(), 20u);
+  EXPECT_EQ(opts.BatchPeriod(), std::chrono::microseconds(500));
+
+  AdvertiseMessageOptions opts2(opts);
+  EXPECT_EQ(opts, opts2);
+  opts2.SetBatchSize(1u);
+  EXPECT_FALSE(opts2.Batched());
+  EXPECT_NE(opts, opts2);
+
+  // Compression.
+  EXPECT_EQ(opts.Compression(), Compression_t::NONE);
+  EXPECT_EQ(opts.CompressionLevel(), 0);
+  opts.SetCompression(Compression_t::ZSTD, 5);
+  EXPECT_EQ(opts.Compression(), Compression_t::ZSTD);
+  EXPECT_EQ(opts.CompressionLevel(), 5);
+
+  AdvertiseMessageOptions opts3;
+  opts3 = opts;
+  EXPECT_EQ(opts, opts3);
+  opts3.SetCompression(Compression_t::LZ4);
+  EXPECT_EQ(opts3.CompressionLevel(), 0);
+  EXPECT_NE(opts, opts3);
+
+  // Latching.
+  EXPECT_FALSE(opts.Latched());
+  EXPECT_EQ(opts.LatchDepth(), 0u);
+  opts.SetLatchDepth(1u);
+  EXPECT_TRUE(opts.Latched());
+  EXPECT_EQ(opts.LatchDepth(), 1u);
+
+  AdvertiseMessageOptions opts4(opts);
+  EXPECT_EQ(opts, opts4);
+  opts4.SetLatchDepth(0u);
+  EXPECT_FALSE(opts4.Latched());
+  EXPECT_NE(opts, opts4);
+
+  // Queue.
+  EXPECT_FALSE(opts.Queued());
+  EXPECT_EQ(opts.QueueDepth(), 0u);
+  EXPECT_EQ(opts.QueuePolicy(), QueuePolicy_t::DROP_OLDEST);
+  opts.SetQueue(8u, QueuePolicy_t::KEEP_ALL);
+  EXPECT_TRUE(opts.Queued());
+  EXPECT_EQ(opts.QueueDepth(), 8u);
+  EXPECT_EQ(opts.QueuePolicy(), QueuePolicy_t::KEEP_ALL);
+
+  AdvertiseMessageOptions opts5(opts);
+  EXPECT_EQ(opts, opts5);
+  opts5.SetQueue(8u, QueuePolicy_t::DROP_NEWEST);
+  EXPECT_NE(opts, opts5);
+
+  // Priority.
+  EXPECT_FALSE(opts.HighPriority());
+  opts.SetHighPriority(true);
+  EXPECT_TRUE(opts.HighPriority());
+
+  AdvertiseMessageOptions opts6(opts);
+  EXPECT_EQ(opts, opts6);
+  opts6.SetHighPriority(false);
+  EXPECT_NE(opts, opts6);
+
+  // Network interface.
+  EXPECT_TRUE(opts.Interface().empty());
+  opts.SetInterface("127.0.0.1");
+  EXPECT_EQ(opts.Interface(), "127.0.0.1");
+
+  AdvertiseMessageOptions opts8(opts);
+  EXPECT_EQ(opts, opts8);
+  opts8.SetInterface("");
+  EXPECT_NE(opts, opts8);
+
+  // Multicast.
+  EXPECT_FALSE(opts.Multicast());
+  opts.SetMulticast(true);
+  EXPECT_TRUE(opts.Multicast());
+
+  AdvertiseMessageOptions opts9(opts);
+  EXPECT_EQ(opts, opts9);
+  opts9.SetMulticast(false);
+  EXPECT_NE(opts, opts9);
+
+  // Publisher statistics.
+  EXPECT_TRUE(opts.StatisticsTopic().empty());
+  EXPECT_EQ(opts.StatisticsRate(), 1u);
+  opts.SetStatisticsTopic("/pub_stats", 10u);
+  EXPECT_EQ(opts.StatisticsTopic(), "/pub_stats");
+  EXPECT_EQ(opts.StatisticsRate(), 10u);
+
+  AdvertiseMessageOptions opts7(opts);
+  EXPECT_EQ(opts, opts7);
+  opts7.SetStatisticsTopic("");
+  EXPECT_NE(opts, opts7);
+
+  // Real-time.
+  EXPECT_FALSE(opts.RealTime());
+  EXPECT_EQ(opts.RealTimeSlots(), 0u);
+  opts.SetRealTime(8u, 256u);
+  EXPECT_TRUE(opts.RealTime());
+  EXPECT_EQ(opts.RealTimeSlots(), 8u);
+  EXPECT_EQ(opts.RealTimeSlotSize(), 256u);
+
+  AdvertiseMessageOptions opts10(opts);
+  EXPECT_EQ(opts, opts10);
+  opts10.SetRealTime(0u);
+  EXPECT_NE(opts, opts10);
+
+  // Token buckets.
+  EXPECT_EQ(opts.RateLimit(), 0u);
+  EXPECT_EQ(opts.RateLimitBurst(), 1u);
+  EXPECT_EQ(opts.BandwidthLimit(), 0u);
+  EXPECT_FALSE(opts.RateLimitRemoteOnly());
+  opts.SetRateLimit(10u, 5u);
+  opts.SetBandwidthLimit(1000u);
+  opts.SetRateLimitRemoteOnly(true);
+  EXPECT_EQ(opts.RateLimit(), 10u);
+  EXPECT_EQ(opts.RateLimitBurst(), 5u);
+  EXPECT_EQ(opts.BandwidthLimit(), 1000u);
+  EXPECT_EQ(opts.BandwidthBurst(), 1000u);
+  EXPECT_TRUE(opts.RateLimitRemoteOnly());
+  opts.SetBandwidthLimit(1000u, 200u);
+  EXPECT_EQ(opts.BandwidthBurst(), 200u);
+
+  AdvertiseMessageOptions opts11(opts);
+  EXPECT_EQ(opts, opts11);
+  opts11.SetRateLimit(10u, 0u);
+  EXPECT_EQ(opts11.RateLimitBurst(), 1u);
+  EXPECT_NE(opts, opts11);
+
+  // File descriptor passing.
+  EXPECT_FALSE(opts.FdPassing());
+  opts.SetFdPassing(true);
+  EXPECT_TRUE(opts.FdPassing());
+
+  AdvertiseMessageOptions opts12(opts);
+  EXPECT_EQ(opts, opts12);
+  opts12.SetFdPassing(false);
+  EXPECT_NE(opts, opts12);
+
+  // Retransmission.
+  EXPECT_FALSE(opts.Reliable());
+  EXPECT_EQ(0u, opts.ReliableDepth());
+  opts.SetReliableDepth(64u);
+  EXPECT_TRUE(opts.Reliable());
+  EXPECT_EQ(64u, opts.ReliableDepth());
+
+  AdvertiseMessageOptions opts13(opts);
+  EXPECT_EQ(opts, opts13);
+  opts13.SetReliableDepth(0u);
+  EXPECT_FALSE(opts13.Reliable());
+  EXPECT_NE(opts, opts13);
+
+  // Blackboard.
+  EXPECT_FALSE(opts.Blackboard());
+  opts.SetBlackboard(true);
+  EXPECT_TRUE(opts.Blackboard());
+
+  AdvertiseMessageOptions opts14(opts);
+  EXPECT_EQ(opts, opts14);
+  opts14.SetBlackboard(false);
+  EXPECT_NE(opts, opts14);
+
+  // Adaptive rate.
+  EXPECT_FALSE(opts.Adaptive());
+  EXPECT_EQ(std::chrono::milliseconds(0), opts.LatencyTarget());
+  opts.SetLatencyTarget(std::chrono::milliseconds(200));
+  EXPECT_TRUE(opts.Adaptive());
+  EXPECT_EQ(std::chrono::milliseconds(200), opts.LatencyTarget());
+
+  AdvertiseMessageOptions opts15(opts);
+  EXPECT_EQ(opts, opts15);
+  opts15.SetLatencyTarget(std::chrono::milliseconds(-5));
+  EXPECT_FALSE(opts15.Adaptive());
+  EXPECT_NE(opts, opts15);
 }
 
 //////////////////////////////////////////////////
@@ -251,4 +513,32 @@ TEST(AdvertiseOptionsTest, srvAccessors)
   EXPECT_EQ(opts.Scope(), Scope_t::ALL);
   opts.SetScope(Scope_t::HOST);
   EXPECT_EQ(opts.Scope(), Scope_t::HOST);
+
+  // Concurrency.
+  EXPECT_EQ(0u, opts.Concurrency());
+  EXPECT_EQ(0u, opts.MaxPending());
+  opts.SetConcurrency(4);
+  opts.SetMaxPending(16);
+  EXPECT_EQ(4u, opts.Concurrency());
+  EXPECT_EQ(16u, opts.MaxPending());
+
+  // Idempotent service.
+  EXPECT_FALSE(opts.Idempotent());
+  EXPECT_EQ(std::chrono::milliseconds(1000), opts.CacheTtl());
+  opts.SetIdempotent(true, std::chrono::milliseconds(250));
+  EXPECT_TRUE(opts.Idempotent());
+  EXPECT_EQ(std::chrono::milliseconds(250), opts.CacheTtl());
+
+  // Callback group.
+  EXPECT_TRUE(opts.CallbackGroup().empty());
+  opts.SetCallbackGroup("control");
+  EXPECT_EQ("control", opts.CallbackGroup());
+
+  AdvertiseServiceOptions opts2;
+  EXPECT_NE(opts, opts2);
+  opts2 = opts;
+  EXPECT_EQ(opts, opts2);
+  EXPECT_TRUE(opts2.Idempotent());
+  EXPECT_EQ(std::chrono::milliseconds(250), opts2.CacheTtl());
+  EXPECT_EQ("control", opts2.CallbackGroup());
 }
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/ArenaPool.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace gz
+{
+  namespace transport
+  {
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+    {
+    /// \brief An arena and the initial block that it uses.
+    class PooledArena
+    {
+      /// \brief Constructor.
+      /// \param[in] _blockSize Size of the initial block.
+      public: explicit PooledArena(std::size_t _blockSize)
+        : block(new char[_blockSize]),
+          arena(Options(block.get(), _blockSize))
+      {
+      }
+
+      /// \brief Options of an arena that starts with a user provided block.
+      /// \param[in] _block The initial block.
+      /// \param[in] _blockSize Size of the initial block.
+      /// \return The arena options.
+      private: static google::protobuf::ArenaOptions Options(char *_block,
+                                                             std::size_t _size)
+      {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = _block;
+        options.initial_block_size = _size;
+        return options;
+      }
+
+      /// \brief Initial block, kept across resets.
+      public: std::unique_ptr<char[]> block;
+
+      /// \brief The arena.
+      public: google::protobuf::Arena arena;
+    };
+
+    /// \brief Private data for the ArenaPool class.
+    class ArenaPoolPrivate
+    {
+      /// \brief Return an arena to the pool.
+      /// \param[in] _arena The arena, already reset.
+      public: void Release(std::unique_ptr<PooledArena> _arena)
+      {
+        std::lock_guard<std::mutex> lk(this->mutex);
+        if (this->idle.size() < this->maxIdle)
+          this->idle.push_back(std::move(_arena));
+      }
+
+      /// \brief Size of the initial block of every arena.
+      public: std::size_t blockSize;
+
+      /// \brief Maximum number of idle arenas.
+      public: std::size_t maxIdle;
+
+      /// \brief Protects the idle arenas.
+      public: mutable std::mutex mutex;
+
+      /// \brief Arenas ready to be reused.
+      public: std::vector<std::unique_ptr<PooledArena>> idle;
+    };
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+ArenaPool::ArenaPool(std::size_t _blockSize, std::size_t _maxIdle)
+  : dataPtr(std::make_shared<ArenaPoolPrivate>())
+{
+  // Protobuf ignores initial blocks that can't hold its own block header.
+  this->dataPtr->blockSize = std::max<std::size_t>(_blockSize, 256u);
+  this->dataPtr->maxIdle = _maxIdle;
+}
+
+//////////////////////////////////////////////////
+ArenaPool::~ArenaPool() = default;
+
+//////////////////////////////////////////////////
+std::shared_ptr<google::protobuf::Arena> ArenaPool::Acquire()
+{
+  std::unique_ptr<PooledArena> pooled;
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+    if (!this->dataPtr->idle.empty())
+    {
+      pooled = std::move(this->dataPtr->idle.back());
+      this->dataPtr->idle.pop_back();
+    }
+  }
+
+  if (!pooled)
+    pooled.reset(new PooledArena(this->dataPtr->blockSize));
+
+  PooledArena *raw = pooled.release();
+  std::weak_ptr<ArenaPoolPrivate> pool = this->dataPtr;
+  return std::shared_ptr<google::protobuf::Arena>(&raw->arena,
+    [pool, raw](google::protobuf::Arena *)
+    {
+      std::unique_ptr<PooledArena> released(raw);
+
+      // Destroy the messages and free the extra blocks, keep the initial one.
+      released->arena.Reset();
+
+      if (auto dataPtr = pool.lock())
+        dataPtr->Release(std::move(released));
+    });
+}
+
+//////////////////////////////////////////////////
+std::size_t ArenaPool::IdleCount() const
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  return this->dataPtr->idle.size();
+}
+
+//////////////////////////////////////////////////
+std::size_t ArenaPool::BlockSize() const
+{
+  return this->dataPtr->blockSize;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/pose_v.pb.h>
+
+#include <memory>
+#include <string>
+
+#include "gz/transport/ArenaPool.hh"
+#include "gz/transport/SubscribeOptions.hh"
+#include "gz/transport/SubscriptionHandler.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Check that released arenas are recycled.
+TEST(ArenaPoolTest, Recycle)
+{
+  ArenaPool pool(1024u, 2u);
+  EXPECT_EQ(1024u, pool.BlockSize());
+  EXPECT_EQ(0u, pool.IdleCount());
+
+  auto arena1 = pool.Acquire();
+  ASSERT_NE(nullptr, arena1);
+  google::protobuf::Arena *first = arena1.get();
+  arena1.reset();
+  EXPECT_EQ(1u, pool.IdleCount());
+
+  // The idle arena is reused.
+  auto arena2 = pool.Acquire();
+  EXPECT_EQ(first, arena2.get());
+  EXPECT_EQ(0u, pool.IdleCount());
+
+  // No more than the maximum number of idle arenas is kept.
+  auto arena3 = pool.Acquire();
+  auto arena4 = pool.Acquire();
+  arena2.reset();
+  arena3.reset();
+  arena4.reset();
+  EXPECT_EQ(2u, pool.IdleCount());
+}
+
+//////////////////////////////////////////////////
+/// \brief An arena can outlive its pool.
+TEST(ArenaPoolTest, OutlivePool)
+{
+  std::shared_ptr<google::protobuf::Arena> arena;
+  {
+    ArenaPool pool;
+    arena = pool.Acquire();
+  }
+  ASSERT_NE(nullptr, arena);
+#if GOOGLE_PROTOBUF_VERSION >= 4022000
+  auto *msg = google::protobuf::Arena::Create<msgs::Int32>(arena.get());
+#else
+  auto *msg = google::protobuf::Arena::CreateMessage<msgs::Int32>(arena.get());
+#endif
+  msg->set_data(3);
+  EXPECT_EQ(3, msg->data());
+  arena.reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Messages created by a subscription that uses arenas are allocated
+/// in a pooled arena.
+TEST(ArenaPoolTest, SubscriptionHandler)
+{
+  msgs::Pose_V poses;
+  for (int i = 0; i < 10; ++i)
+  {
+    auto *pose = poses.add_pose();
+    pose->set_name("pose_" + std::to_string(i));
+    pose->mutable_position()->set_x(i);
+  }
+  std::string data;
+  ASSERT_TRUE(poses.SerializeToString(&data));
+
+  SubscribeOptions opts;
+  opts.SetUseArena(true);
+
+  SubscriptionHandler<msgs::Pose_V> typedHandler("nUuid", opts);
+  SubscriptionHandler<ProtoMsg> genericHandler("nUuid", opts);
+  SubscriptionHandler<msgs::Pose_V> heapHandler("nUuid");
+
+  for (ISubscriptionHandler *handler :
+         {static_cast<ISubscriptionHandler *>(&typedHandler),
+          static_cast<ISubscriptionHandler *>(&genericHandler)})
+  {
+    auto msg = handler->CreateMsg(data, poses.GetTypeName());
+    ASSERT_NE(nullptr, msg);
+    EXPECT_NE(nullptr, msg->GetArena());
+    EXPECT_EQ(poses.DebugString(), msg->DebugString());
+    auto *arena = msg->GetArena();
+    msg.reset();
+
+    // The next message reuses the same arena.
+    msg = handler->CreateMsg(data, poses.GetTypeName());
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(arena, msg->GetArena());
+  }
+
+  auto msg = heapHandler.CreateMsg(data, poses.GetTypeName());
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ(nullptr, msg->GetArena());
+}
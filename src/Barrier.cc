@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/uint64.pb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gz/transport/Barrier.hh"
+#include "gz/transport/Node.hh"
+#include "gz/transport/TopicUtils.hh"
+#include "gz/transport/Uuid.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Key of the header entry with the participant of an arrival.
+  const char kParticipantKey[] = "participant";
+
+  /// \brief Time between the repetitions of the arrival of a waiting
+  /// participant, for the participants that missed it.
+  const std::chrono::milliseconds kRepeatInterval{100};
+}
+
+namespace gz
+{
+  namespace transport
+  {
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+    {
+    /// \internal
+    /// \brief Private data for Barrier.
+    class BarrierPrivate
+    {
+      /// \brief Announce the arrival of this participant.
+      /// \param[in] _step Step that this participant completed, from 1.
+      public: void Announce(uint64_t _step);
+
+      /// \brief Callback of the arrivals of the participants.
+      /// \param[in] _msg The step completed by the participant.
+      public: void OnArrival(const msgs::UInt64 &_msg);
+
+      /// \brief Callback of the changes of the topic graph.
+      /// \param[in] _pub Publisher that appeared or disappeared.
+      /// \param[in] _added Whether it appeared.
+      public: void OnGraphChange(const MessagePublisher &_pub, bool _added);
+
+      /// \brief Whether all the participants completed a step. Must be
+      /// called with the mutex locked.
+      /// \param[in] _step The step.
+      /// \return True if the participants can be released.
+      public: bool Complete(uint64_t _step) const;
+
+      /// \brief Number of participants, or 0 to count the discovered ones.
+      public: unsigned int participants = 0;
+
+      /// \brief Identifier of this participant in the arrivals.
+      public: std::string id;
+
+      /// \brief Fully qualified topic of the barrier.
+      public: std::string fullyQualifiedTopic;
+
+      /// \brief Whether the barrier advertised and subscribed to its topic.
+      public: bool valid = false;
+
+      /// \brief Protects the members below.
+      public: mutable std::mutex mutex;
+
+      /// \brief Signaled on every arrival and change of the participants.
+      public: std::condition_variable cv;
+
+      /// \brief Number of steps completed.
+      public: uint64_t step = 0;
+
+      /// \brief Last step completed by each participant, by identifier.
+      public: std::map<std::string, uint64_t> arrivals;
+
+      /// \brief Publishers of the topic discovered, by process and node
+      /// UUIDs.
+      public: std::set<std::string> discovered;
+
+      /// \brief Node of the barrier. Declared after the state used by its
+      /// callbacks, so it's destroyed first.
+      public: std::unique_ptr<Node> node;
+
+      /// \brief Publisher of the arrivals.
+      public: Node::Publisher pub;
+    };
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void BarrierPrivate::Announce(const uint64_t _step)
+{
+  msgs::UInt64 msg;
+  msg.set_data(_step);
+  auto *data = msg.mutable_header()->add_data();
+  data->set_key(kParticipantKey);
+  data->add_value(this->id);
+  this->pub.Publish(msg);
+}
+
+//////////////////////////////////////////////////
+void BarrierPrivate::OnArrival(const msgs::UInt64 &_msg)
+{
+  for (const auto &data : _msg.header().data())
+  {
+    if (data.key() != kParticipantKey || data.value_size() == 0)
+      continue;
+
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      uint64_t &last = this->arrivals[data.value(0)];
+      if (_msg.data() <= last)
+        return;
+      last = _msg.data();
+    }
+    this->cv.notify_all();
+    return;
+  }
+}
+
+//////////////////////////////////////////////////
+void BarrierPrivate::OnGraphChange(const MessagePublisher &_pub,
+    const bool _added)
+{
+  if (_pub.Topic() != this->fullyQualifiedTopic)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    const std::string key = _pub.PUuid() + "/" + _pub.NUuid();
+    if (_added)
+      this->discovered.insert(key);
+    else
+      this->discovered.erase(key);
+  }
+  this->cv.notify_all();
+}
+
+//////////////////////////////////////////////////
+bool BarrierPrivate::Complete(const uint64_t _step) const
+{
+  const std::size_t expected = this->participants > 0 ?
+    this->participants : std::max<std::size_t>(this->discovered.size(), 1u);
+
+  std::size_t arrived = 0;
+  for (const auto &arrival : this->arrivals)
+  {
+    // A participant ahead completed this step too.
+    if (arrival.second >= _step)
+      ++arrived;
+  }
+  return arrived >= expected;
+}
+
+//////////////////////////////////////////////////
+Barrier::Barrier(const std::string &_name, const unsigned int _participants,
+    const NodeOptions &_options)
+  : dataPtr(new BarrierPrivate)
+{
+  this->dataPtr->participants = _participants;
+  this->dataPtr->id = Uuid().ToString();
+  this->dataPtr->node.reset(new Node(_options));
+
+  if (!TopicUtils::FullyQualifiedName(_options.Partition(),
+        _options.NameSpace(), _name, this->dataPtr->fullyQualifiedTopic))
+  {
+    std::cerr << "Barrier: Topic [" << _name << "] is not valid."
+              << std::endl;
+    return;
+  }
+
+  // The node stops watching the graph before the rest of the private data
+  // is destroyed.
+  if (_participants == 0)
+  {
+    BarrierPrivate *priv = this->dataPtr.get();
+    std::vector<MessagePublisher> pubs;
+    this->dataPtr->node->WatchTopicGraph(pubs,
+      [priv](const MessagePublisher &_pub, bool _added)
+      {
+        priv->OnGraphChange(_pub, _added);
+      });
+    for (const MessagePublisher &pub : pubs)
+      this->dataPtr->OnGraphChange(pub, true);
+  }
+
+  this->dataPtr->pub = this->dataPtr->node->Advertise<msgs::UInt64>(_name);
+  this->dataPtr->valid = this->dataPtr->pub &&
+    this->dataPtr->node->Subscribe(_name, &BarrierPrivate::OnArrival,
+      this->dataPtr.get());
+}
+
+//////////////////////////////////////////////////
+Barrier::~Barrier()
+{
+  // Destroys the pimpl
+}
+
+//////////////////////////////////////////////////
+bool Barrier::Valid() const
+{
+  return this->dataPtr->valid;
+}
+
+//////////////////////////////////////////////////
+bool Barrier::Wait(const std::chrono::milliseconds &_timeout)
+{
+  if (!this->dataPtr->valid)
+    return false;
+
+  const auto deadline = std::chrono::steady_clock::now() + _timeout;
+  std::unique_lock<std::mutex> lk(this->dataPtr->mutex);
+  const uint64_t target = this->dataPtr->step + 1;
+  this->dataPtr->arrivals[this->dataPtr->id] = target;
+
+  // The local subscribers may be called from Publish().
+  lk.unlock();
+  this->dataPtr->Announce(target);
+  lk.lock();
+
+  while (!this->dataPtr->Complete(target))
+  {
+    const auto repeat = std::min(deadline,
+      std::chrono::steady_clock::now() + kRepeatInterval);
+    if (this->dataPtr->cv.wait_until(lk, repeat, [this, target]
+        {
+          return this->dataPtr->Complete(target);
+        }))
+    {
+      break;
+    }
+
+    if (std::chrono::steady_clock::now() >= deadline)
+      return false;
+
+    lk.unlock();
+    this->dataPtr->Announce(target);
+    lk.lock();
+  }
+
+  this->dataPtr->step = target;
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t Barrier::Step() const
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  return this->dataPtr->step;
+}
+
+//////////////////////////////////////////////////
+unsigned int Barrier::Participants() const
+{
+  if (this->dataPtr->participants > 0)
+    return this->dataPtr->participants;
+
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  return static_cast<unsigned int>(this->dataPtr->discovered.size());
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Barrier.hh"
+
+#include "test_utils.hh"
+#include "gtest/gtest.h"
+#include "gz/utils/Environment.hh"
+
+using namespace gz;
+using namespace transport;
+
+static const std::chrono::milliseconds kTimeout{5000};
+
+//////////////////////////////////////////////////
+/// \brief Wait until a condition is true or 5 seconds elapsed.
+template<typename F>
+bool waitFor(F _cond)
+{
+  for (int i = 0; i < 500 && !_cond(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return _cond();
+}
+
+//////////////////////////////////////////////////
+/// \brief Step the participants in lockstep: none of them starts a step
+/// before all of them completed the previous one.
+TEST(BarrierTest, Lockstep)
+{
+  const unsigned int kParticipants = 3;
+  const int kSteps = 50;
+  std::vector<std::unique_ptr<Barrier>> barriers;
+  for (unsigned int i = 0; i < kParticipants; ++i)
+  {
+    barriers.emplace_back(new Barrier("/barrier_lockstep", kParticipants));
+    ASSERT_TRUE(barriers.back()->Valid());
+    EXPECT_EQ(kParticipants, barriers.back()->Participants());
+  }
+
+  std::atomic<int> done{0};
+  std::atomic<bool> ahead{false};
+  std::vector<std::thread> threads;
+  for (auto &barrier : barriers)
+  {
+    threads.emplace_back([&barrier, &done, &ahead]()
+    {
+      for (int step = 1; step <= kSteps; ++step)
+      {
+        ++done;
+        if (!barrier->Wait(kTimeout))
+          return;
+        if (done < step * static_cast<int>(kParticipants))
+          ahead = true;
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_FALSE(ahead);
+  for (const auto &barrier : barriers)
+    EXPECT_EQ(static_cast<uint64_t>(kSteps), barrier->Step());
+}
+
+//////////////////////////////////////////////////
+/// \brief A participant waiting alone times out, and completes the step
+/// when the others arrive.
+TEST(BarrierTest, Timeout)
+{
+  Barrier first("/barrier_timeout", 2);
+  ASSERT_TRUE(first.Valid());
+  EXPECT_FALSE(first.Wait(std::chrono::milliseconds(100)));
+  EXPECT_EQ(0u, first.Step());
+
+  Barrier second("/barrier_timeout", 2);
+  ASSERT_TRUE(second.Valid());
+  std::thread thread([&first]()
+  {
+    EXPECT_TRUE(first.Wait(kTimeout));
+  });
+  EXPECT_TRUE(second.Wait(kTimeout));
+  thread.join();
+
+  EXPECT_EQ(1u, first.Step());
+  EXPECT_EQ(1u, second.Step());
+}
+
+//////////////////////////////////////////////////
+/// \brief The participants are the barriers discovered.
+TEST(BarrierTest, DiscoveredParticipants)
+{
+  Barrier first("/barrier_discovered");
+  Barrier second("/barrier_discovered");
+  ASSERT_TRUE(first.Valid());
+  ASSERT_TRUE(second.Valid());
+  EXPECT_TRUE(waitFor([&]()
+  {
+    return first.Participants() == 2u && second.Participants() == 2u;
+  }));
+
+  for (int step = 0; step < 10; ++step)
+  {
+    std::thread thread([&first]()
+    {
+      EXPECT_TRUE(first.Wait(kTimeout));
+    });
+    EXPECT_TRUE(second.Wait(kTimeout));
+    thread.join();
+  }
+  EXPECT_EQ(10u, first.Step());
+  EXPECT_EQ(10u, second.Step());
+}
+
+//////////////////////////////////////////////////
+/// \brief A barrier with an invalid name never releases.
+TEST(BarrierTest, InvalidName)
+{
+  Barrier barrier("invalid name", 1);
+  EXPECT_FALSE(barrier.Valid());
+  EXPECT_FALSE(barrier.Wait(std::chrono::milliseconds(10)));
+  EXPECT_EQ(0u, barrier.Step());
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  gz::utils::setenv("GZ_PARTITION", testing::getRandomNumber());
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/Bridge.hh"
+#include "gz/transport/MessageInfo.hh"
+#include "gz/transport/Node.hh"
+#include "gz/transport/TopicUtils.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace gz
+{
+  namespace transport
+  {
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+    {
+    /// \internal
+    /// \brief Private data for Bridge.
+    class BridgePrivate
+    {
+      /// \brief Topics to forward and their options.
+      public: struct Rule
+      {
+        /// \brief Pattern matching the topic names.
+        std::regex pattern;
+
+        /// \brief Options of the topics in the destination partition.
+        AdvertiseMessageOptions opts;
+      };
+
+      /// \brief Forward the topics discovered until the exit flag is set.
+      /// Subscribing and advertising can't happen in the discovery thread.
+      public: void Run();
+
+      /// \brief Start forwarding a topic if it matches a rule.
+      /// \param[in] _topic Topic name, without the partition.
+      /// \param[in] _type Message type of the topic.
+      public: void Forward(const std::string &_topic,
+                           const std::string &_type);
+
+      /// \brief Options of the source node.
+      public: NodeOptions fromOpts;
+
+      /// \brief Options of the destination node.
+      public: NodeOptions toOpts;
+
+      /// \brief Topics to forward.
+      public: std::vector<Rule> rules;
+
+      /// \brief Node subscribing in the source partition.
+      public: std::unique_ptr<Node> fromNode;
+
+      /// \brief Node publishing in the destination partition.
+      public: std::unique_ptr<Node> toNode;
+
+      /// \brief Protects pending, topics and exit.
+      public: mutable std::mutex mutex;
+
+      /// \brief Wakes up the thread.
+      public: std::condition_variable cv;
+
+      /// \brief Topics discovered and their types, not checked yet.
+      public: std::deque<std::pair<std::string, std::string>> pending;
+
+      /// \brief Topics checked, and whether they are forwarded.
+      public: std::map<std::string, bool> topics;
+
+      /// \brief Thread forwarding the topics discovered.
+      public: std::thread thread;
+
+      /// \brief Flag to stop the thread.
+      public: bool exit = false;
+
+      /// \brief Number of messages forwarded.
+      public: std::atomic<uint64_t> forwarded{0};
+    };
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void BridgePrivate::Run()
+{
+  std::unique_lock<std::mutex> lk(this->mutex);
+  while (true)
+  {
+    this->cv.wait(lk, [this] {return this->exit || !this->pending.empty();});
+    if (this->exit)
+      return;
+
+    auto [topic, type] = std::move(this->pending.front());
+    this->pending.pop_front();
+    if (this->topics.count(topic))
+      continue;
+
+    lk.unlock();
+    this->Forward(topic, type);
+    lk.lock();
+  }
+}
+
+//////////////////////////////////////////////////
+void BridgePrivate::Forward(const std::string &_topic,
+  const std::string &_type)
+{
+  const Rule *rule = nullptr;
+  for (const auto &candidate : this->rules)
+  {
+    if (std::regex_match(_topic, candidate.pattern))
+    {
+      rule = &candidate;
+      break;
+    }
+  }
+
+  bool forwarded = false;
+  if (rule)
+  {
+    Node::Publisher pub = this->toNode->Advertise(_topic, _type, rule->opts);
+
+    // The bytes are copied once into a buffer lent by the publisher.
+    auto cb = [this, pub](const char *_data, const size_t _size,
+                          const MessageInfo &) mutable
+    {
+      if (!pub.ThrottledUpdateReady())
+        return;
+
+      Node::Publisher::Loan loan = pub.LoanBuffer(_size);
+      if (!loan.Valid())
+        return;
+
+      std::memcpy(loan.Data(), _data, _size);
+      if (pub.Publish(loan))
+        this->forwarded.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    forwarded = pub && this->fromNode->SubscribeRaw(_topic, cb, _type);
+    if (!forwarded)
+    {
+      std::cerr << "Bridge: unable to forward topic [" << _topic << "] of "
+                << "type [" << _type << "]" << std::endl;
+    }
+  }
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->topics[_topic] = forwarded;
+}
+
+//////////////////////////////////////////////////
+Bridge::Bridge(const NodeOptions &_from, const NodeOptions &_to)
+  : dataPtr(new BridgePrivate)
+{
+  this->dataPtr->fromOpts = _from;
+  this->dataPtr->toOpts = _to;
+}
+
+//////////////////////////////////////////////////
+Bridge::~Bridge()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+bool Bridge::AddTopics(const std::string &_pattern,
+  const AdvertiseMessageOptions &_opts)
+{
+  if (this->dataPtr->thread.joinable())
+    return false;
+
+  try
+  {
+    this->dataPtr->rules.push_back({std::regex(_pattern), _opts});
+  }
+  catch (const std::regex_error &_error)
+  {
+    std::cerr << "Bridge: invalid pattern [" << _pattern << "]: "
+              << _error.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Bridge::Start()
+{
+  if (this->dataPtr->thread.joinable() || this->dataPtr->rules.empty())
+    return false;
+
+  if (this->dataPtr->fromOpts.Partition() ==
+      this->dataPtr->toOpts.Partition())
+  {
+    std::cerr << "Bridge: the source and destination partitions are the "
+              << "same [" << this->dataPtr->fromOpts.Partition() << "]"
+              << std::endl;
+    return false;
+  }
+
+  this->dataPtr->toNode.reset(new Node(this->dataPtr->toOpts));
+  this->dataPtr->fromNode.reset(new Node(this->dataPtr->fromOpts));
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+    this->dataPtr->exit = false;
+    this->dataPtr->topics.clear();
+    this->dataPtr->pending.clear();
+  }
+
+  // Queue the topics discovered, including the ones already known.
+  BridgePrivate *priv = this->dataPtr.get();
+  auto onPublisher = [priv](const MessagePublisher &_pub, bool _added)
+  {
+    std::string partition, topic;
+    if (!_added || !TopicUtils::DecomposeFullyQualifiedTopic(
+          _pub.Topic(), partition, topic))
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lk(priv->mutex);
+    if (priv->topics.count(topic))
+      return;
+    priv->pending.emplace_back(topic, _pub.MsgTypeName());
+    priv->cv.notify_one();
+  };
+
+  std::vector<MessagePublisher> known;
+  if (!this->dataPtr->fromNode->WatchTopicGraph(known, onPublisher))
+  {
+    this->dataPtr->fromNode.reset();
+    this->dataPtr->toNode.reset();
+    return false;
+  }
+
+  for (const auto &pub : known)
+    onPublisher(pub, true);
+
+  this->dataPtr->thread = std::thread(&BridgePrivate::Run,
+    this->dataPtr.get());
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Bridge::Stop()
+{
+  if (!this->dataPtr->thread.joinable())
+    return;
+
+  this->dataPtr->fromNode->UnwatchTopicGraph();
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+    this->dataPtr->exit = true;
+  }
+  this->dataPtr->cv.notify_one();
+  this->dataPtr->thread.join();
+
+  // Stop receiving before the publishers go away.
+  this->dataPtr->fromNode.reset();
+  this->dataPtr->toNode.reset();
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> Bridge::Topics() const
+{
+  std::vector<std::string> res;
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  for (const auto &[topic, forwarded] : this->dataPtr->topics)
+  {
+    if (forwarded)
+      res.push_back(topic);
+  }
+  return res;
+}
+
+//////////////////////////////////////////////////
+uint64_t Bridge::ForwardedMessages() const
+{
+  return this->dataPtr->forwarded.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Bridge.hh"
+#include "gz/transport/Node.hh"
+#include "gz/transport/NodeOptions.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_utils.hh"
+
+using namespace gz;
+using namespace transport;
+
+static std::string partition; // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Invalid configurations are rejected.
+TEST(BridgeTest, InvalidConfig)
+{
+  NodeOptions from;
+  NodeOptions to;
+  ASSERT_TRUE(to.SetPartition(partition + "_to"));
+
+  Bridge noRules(from, to);
+  EXPECT_FALSE(noRules.Start());
+  EXPECT_FALSE(noRules.AddTopics("["));
+
+  Bridge same(from, from);
+  EXPECT_TRUE(same.AddTopics(".*"));
+  EXPECT_FALSE(same.Start());
+}
+
+//////////////////////////////////////////////////
+/// \brief The matching topics are forwarded to the other partition.
+TEST(BridgeTest, Forward)
+{
+  NodeOptions from;
+  NodeOptions to;
+  ASSERT_TRUE(to.SetPartition(partition + "_to"));
+
+  Node pubNode(from);
+  auto bridged = pubNode.Advertise<msgs::Int32>("/bridged");
+  auto ignored = pubNode.Advertise<msgs::Int32>("/ignored");
+  ASSERT_TRUE(bridged);
+  ASSERT_TRUE(ignored);
+
+  std::atomic<int> bridgedCount{0};
+  std::atomic<int> ignoredCount{0};
+  std::atomic<int> lastData{0};
+  Node subNode(to);
+  EXPECT_TRUE(subNode.Subscribe("/bridged",
+    std::function<void(const msgs::Int32 &)>(
+      [&](const msgs::Int32 &_msg)
+      {
+        lastData = _msg.data();
+        ++bridgedCount;
+      })));
+  EXPECT_TRUE(subNode.Subscribe("/ignored",
+    std::function<void(const msgs::Int32 &)>(
+      [&](const msgs::Int32 &) {++ignoredCount;})));
+
+  Bridge bridge(from, to);
+  EXPECT_TRUE(bridge.AddTopics("/bridged"));
+  ASSERT_TRUE(bridge.Start());
+  EXPECT_FALSE(bridge.Start());
+  EXPECT_FALSE(bridge.AddTopics(".*"));
+
+  // Publish until the bridge has discovered the topic.
+  msgs::Int32 msg;
+  msg.set_data(42);
+  for (int i = 0; i < 100 && bridgedCount == 0; ++i)
+  {
+    EXPECT_TRUE(bridged.Publish(msg));
+    EXPECT_TRUE(ignored.Publish(msg));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  EXPECT_GT(bridgedCount, 0);
+  EXPECT_EQ(42, lastData);
+  EXPECT_EQ(0, ignoredCount);
+  EXPECT_GT(bridge.ForwardedMessages(), 0u);
+  EXPECT_EQ(std::vector<std::string>{"/bridged"}, bridge.Topics());
+
+  // Nothing is forwarded after stopping.
+  bridge.Stop();
+  const int count = bridgedCount;
+  EXPECT_TRUE(bridged.Publish(msg));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(count, bridgedCount);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+
+#include "BufferPool.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Round a size up to the capacity of a pooled buffer.
+  /// \param[in] _size Number of bytes needed.
+  /// \return The smallest power of two not below _size and kMinCapacity.
+  std::size_t roundCapacity(const std::size_t _size)
+  {
+    std::size_t capacity = BufferPool::kMinCapacity;
+    while (capacity < _size)
+      capacity <<= 1;
+    return capacity;
+  }
+}
+
+//////////////////////////////////////////////////
+BufferPool::BufferPool(const std::size_t _maxBuffers,
+  const std::size_t _maxCapacity)
+  : maxBuffers(_maxBuffers),
+    maxCapacity(_maxCapacity)
+{
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<char[]> BufferPool::Acquire(const std::size_t _size)
+{
+  if (this->maxBuffers > 0 && _size <= this->maxCapacity)
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+
+    // Prefer a free buffer that is large enough, then grow a free buffer
+    // that is too small, then add a buffer.
+    std::shared_ptr<Buffer> *chosen = nullptr;
+    for (auto &buffer : this->buffers)
+    {
+      if (buffer.use_count() != 1)
+        continue;
+      if (buffer->capacity >= _size)
+      {
+        chosen = &buffer;
+        break;
+      }
+      if (!chosen)
+        chosen = &buffer;
+    }
+
+    if (!chosen && this->buffers.size() < this->maxBuffers)
+    {
+      this->buffers.push_back(std::make_shared<Buffer>());
+      chosen = &this->buffers.back();
+    }
+
+    if (chosen)
+    {
+      // The last reader released its reference before the use count
+      // dropped to 1.
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      Buffer &buffer = **chosen;
+      if (buffer.capacity < _size)
+      {
+        buffer.capacity = roundCapacity(_size);
+        buffer.data.reset(new char[buffer.capacity]);
+        this->allocations.fetch_add(1, std::memory_order_relaxed);
+      }
+      return std::shared_ptr<char[]>(*chosen, buffer.data.get());
+    }
+  }
+
+  // Every buffer is in use, or the message is too large to be kept.
+  this->allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::shared_ptr<char[]>(new char[std::max<std::size_t>(_size, 1)]);
+}
+
+//////////////////////////////////////////////////
+uint64_t BufferPool::Allocations() const
+{
+  return this->allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_BUFFERPOOL_HH_
+#define GZ_TRANSPORT_BUFFERPOOL_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief A small pool of serialization buffers of a publisher.
+    ///
+    /// A buffer is free again once the transport and the subscribers have
+    /// released every reference to it, which is detected from its use
+    /// count, so acquiring a free buffer allocates neither the buffer nor
+    /// the control block of the shared pointer. The capacities are rounded
+    /// up to powers of two, so messages of a nearly constant size reuse the
+    /// same buffers.
+    class GZ_TRANSPORT_VISIBLE BufferPool
+    {
+      /// \brief Default maximum number of buffers kept.
+      public: static constexpr std::size_t kDefaultMaxBuffers = 4;
+
+      /// \brief Default capacity above which the buffers aren't kept.
+      public: static constexpr std::size_t kDefaultMaxCapacity = 4u << 20;
+
+      /// \brief Smallest capacity of a buffer.
+      public: static constexpr std::size_t kMinCapacity = 64;
+
+      /// \brief Constructor.
+      /// \param[in] _maxBuffers Maximum number of buffers kept. 0 disables
+      /// the pool.
+      /// \param[in] _maxCapacity Capacity above which the buffers are
+      /// allocated for a single use.
+      public: explicit BufferPool(
+                std::size_t _maxBuffers = kDefaultMaxBuffers,
+                std::size_t _maxCapacity = kDefaultMaxCapacity);
+
+      /// \brief No copy.
+      public: BufferPool(const BufferPool &) = delete;
+
+      /// \brief No assignment.
+      public: BufferPool &operator=(const BufferPool &) = delete;
+
+      /// \brief Acquire a buffer. This function is thread safe.
+      /// \param[in] _size Number of bytes needed.
+      /// \return A buffer of at least _size bytes, returned to the pool when
+      /// its last reference is released. Its content is undefined.
+      public: std::shared_ptr<char[]> Acquire(std::size_t _size);
+
+      /// \brief Get the number of buffers allocated so far, kept or not.
+      /// \return The number of allocations.
+      public: uint64_t Allocations() const;
+
+      /// \brief A buffer kept by the pool.
+      private: struct Buffer
+      {
+        /// \brief Storage.
+        std::unique_ptr<char[]> data;
+
+        /// \brief Size of data.
+        std::size_t capacity = 0;
+      };
+
+      /// \brief Maximum number of buffers kept.
+      private: const std::size_t maxBuffers;
+
+      /// \brief Capacity above which the buffers aren't kept.
+      private: const std::size_t maxCapacity;
+
+      /// \brief Protects buffers.
+      private: std::mutex mutex;
+
+      /// \brief Buffers kept. A buffer is free when the pool holds its only
+      /// reference.
+      private: std::vector<std::shared_ptr<Buffer>> buffers;
+
+      /// \brief Number of buffers allocated.
+      private: std::atomic<uint64_t> allocations{0};
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BufferPool.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Released buffers are reused without allocating.
+TEST(BufferPoolTest, Reuse)
+{
+  BufferPool pool(2);
+
+  char *first = nullptr;
+  {
+    auto buffer = pool.Acquire(100);
+    ASSERT_NE(nullptr, buffer);
+    first = buffer.get();
+    memset(buffer.get(), 1, 100);
+  }
+  EXPECT_EQ(1u, pool.Allocations());
+
+  // Nearly the same size fits in the same buffer.
+  for (int i = 0; i < 10; ++i)
+  {
+    auto buffer = pool.Acquire(90 + i);
+    EXPECT_EQ(first, buffer.get());
+  }
+  EXPECT_EQ(1u, pool.Allocations());
+
+  // A buffer still referenced isn't handed out again.
+  auto held = pool.Acquire(100);
+  auto other = pool.Acquire(100);
+  EXPECT_NE(held.get(), other.get());
+  EXPECT_EQ(2u, pool.Allocations());
+
+  // Every buffer is in use: the next one isn't kept.
+  {
+    auto extra = pool.Acquire(100);
+    EXPECT_NE(nullptr, extra);
+  }
+  EXPECT_EQ(3u, pool.Allocations());
+  other.reset();
+  auto again = pool.Acquire(100);
+  EXPECT_EQ(3u, pool.Allocations());
+
+  // A free buffer too small grows.
+  again.reset();
+  auto large = pool.Acquire(1000);
+  EXPECT_EQ(4u, pool.Allocations());
+  large.reset();
+  large = pool.Acquire(1000);
+  EXPECT_EQ(4u, pool.Allocations());
+}
+
+//////////////////////////////////////////////////
+/// \brief Large or disabled buffers are never kept.
+TEST(BufferPoolTest, Unpooled)
+{
+  BufferPool disabled(0);
+  disabled.Acquire(10);
+  disabled.Acquire(10);
+  EXPECT_EQ(2u, disabled.Allocations());
+
+  BufferPool small(4, 256);
+  small.Acquire(1000);
+  small.Acquire(1000);
+  EXPECT_EQ(2u, small.Allocations());
+
+  // A buffer outlives its pool.
+  std::shared_ptr<char[]> buffer;
+  {
+    BufferPool pool;
+    buffer = pool.Acquire(10);
+  }
+  buffer[0] = 'a';
+  EXPECT_EQ('a', buffer[0]);
+}
+
+//////////////////////////////////////////////////
+/// \brief Buffers released by other threads are reused safely.
+TEST(BufferPoolTest, Threads)
+{
+  BufferPool pool(4);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 100; ++i)
+  {
+    auto buffer = pool.Acquire(sizeof(int));
+    memcpy(buffer.get(), &i, sizeof(i));
+    readers.emplace_back([buffer, i]
+    {
+      int value = -1;
+      memcpy(&value, buffer.get(), sizeof(value));
+      EXPECT_EQ(i, value);
+    });
+    if (readers.size() == 4)
+    {
+      for (auto &reader : readers)
+        reader.join();
+      readers.clear();
+    }
+  }
+  for (auto &reader : readers)
+    reader.join();
+  EXPECT_LE(pool.Allocations(), 100u);
+}
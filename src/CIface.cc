@@ -15,8 +15,11 @@
  *
 */
 
+#include <cstring>
 #include <map>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "gz/transport/Node.hh"
 #include "gz/transport/SubscribeOptions.hh"
@@ -32,6 +35,23 @@ struct GzTransportNode
   std::map<std::string, gz::transport::Node::Publisher> publishers;
 };
 
+/// \brief A publisher handle.
+struct GzTransportPublisher
+{
+  /// \brief The publisher, shared with the node.
+  gz::transport::Node::Publisher publisher;
+};
+
+/// \brief A buffer lent by a publisher.
+struct GzTransportLoan
+{
+  /// \brief Publisher that lent the buffer.
+  gz::transport::Node::Publisher publisher;
+
+  /// \brief The loan.
+  gz::transport::Node::Publisher::Loan loan;
+};
+
 /////////////////////////////////////////////////
 GzTransportNode *gzTransportNodeCreate(const char *_partition)
 {
@@ -85,6 +105,145 @@ int gzTransportPublish(GzTransportNode *_node, const char *_topic,
   return 1;
 }
 
+/////////////////////////////////////////////////
+GzTransportPublisher *gzTransportAdvertisePublisher(GzTransportNode *_node,
+    const char *_topic, const char *_msgType)
+{
+  if (!_node || !_topic || !_msgType ||
+      gzTransportAdvertise(_node, _topic, _msgType) != 0)
+  {
+    return nullptr;
+  }
+
+  const gz::transport::Node::Publisher &publisher =
+    _node->publishers[_topic];
+  if (!publisher)
+    return nullptr;
+
+  return new GzTransportPublisher{publisher};
+}
+
+/////////////////////////////////////////////////
+void gzTransportPublisherDestroy(GzTransportPublisher **_pub)
+{
+  if (_pub && *_pub)
+  {
+    delete *_pub;
+    *_pub = nullptr;
+  }
+}
+
+/////////////////////////////////////////////////
+int gzTransportPublisherPublish(GzTransportPublisher *_pub,
+    const void *_data, size_t _size)
+{
+  if (!_pub || (!_data && _size > 0))
+    return 1;
+
+  // A single copy into a buffer shared with the transport.
+  gz::transport::Node::Publisher::Loan loan =
+    _pub->publisher.LoanBuffer(_size);
+  if (!loan.Valid())
+    return 1;
+
+  if (_size > 0)
+    memcpy(loan.Data(), _data, _size);
+  return _pub->publisher.Publish(loan) ? 0 : 1;
+}
+
+/////////////////////////////////////////////////
+int gzTransportPublisherPublishBatch(GzTransportPublisher *_pub,
+    const void *const *_data, const size_t *_sizes, size_t _count)
+{
+  if (!_pub || (_count > 0 && (!_data || !_sizes)))
+    return -1;
+
+  int published = 0;
+  for (size_t i = 0; i < _count; ++i)
+  {
+    if (gzTransportPublisherPublish(_pub, _data[i], _sizes[i]) != 0)
+      break;
+    ++published;
+  }
+  return published;
+}
+
+/////////////////////////////////////////////////
+GzTransportLoan *gzTransportLoanAcquire(GzTransportNode *_node,
+    const char *_topic, const char *_msgType, size_t _size)
+{
+  if (!_node || gzTransportAdvertise(_node, _topic, _msgType) != 0)
+    return nullptr;
+
+  gz::transport::Node::Publisher &publisher = _node->publishers[_topic];
+  gz::transport::Node::Publisher::Loan loan = publisher.LoanBuffer(_size);
+  if (!loan.Valid())
+    return nullptr;
+
+  return new GzTransportLoan{publisher, std::move(loan)};
+}
+
+/////////////////////////////////////////////////
+void *gzTransportLoanData(GzTransportLoan *_loan)
+{
+  if (!_loan)
+    return nullptr;
+
+  return _loan->loan.Data();
+}
+
+/////////////////////////////////////////////////
+size_t gzTransportLoanSize(const GzTransportLoan *_loan)
+{
+  if (!_loan)
+    return 0;
+
+  return _loan->loan.Size();
+}
+
+/////////////////////////////////////////////////
+int gzTransportLoanCommit(GzTransportLoan **_loan)
+{
+  if (!_loan || !*_loan)
+    return 1;
+
+  const bool result = (*_loan)->publisher.Publish((*_loan)->loan);
+  gzTransportLoanRelease(_loan);
+  return result ? 0 : 1;
+}
+
+/////////////////////////////////////////////////
+void gzTransportLoanRelease(GzTransportLoan **_loan)
+{
+  if (_loan && *_loan)
+  {
+    delete *_loan;
+    *_loan = nullptr;
+  }
+}
+
+/////////////////////////////////////////////////
+int gzTransportSubscribeView(GzTransportNode *_node, const char *_topic,
+    void (*_callback)(const GzTransportMsgView *, void *), void *_userData)
+{
+  if (!_node)
+    return 1;
+
+  return _node->nodePtr->SubscribeRaw(_topic,
+      [_callback, _userData](const char *_msg,
+                  const size_t _size,
+                  const gz::transport::MessageInfo &_info) -> void
+                  {
+                    GzTransportMsgView view;
+                    view.data = _msg;
+                    view.size = _size;
+                    view.msgType = _info.Type().c_str();
+                    view.topic = _info.Topic().c_str();
+                    view.intraProcess = _info.IntraProcess() ? 1 : 0;
+                    _callback(&view, _userData);
+                  }) ? 0 : 1;
+}
+
 /////////////////////////////////////////////////
 int gzTransportSubscribe(GzTransportNode *_node, const char *_topic,
     void (*_callback)(const char *, size_t, const char *, void *),
@@ -18,12 +18,18 @@
 
 #include <gz/msgs/stringmsg.pb.h>
 
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
 #include "gz/transport/CIface.h"
 
 #include "test_utils.hh"
 #include <gz/utils/Environment.hh>
 
 static int count;
+static std::atomic<int> viewCount{0};
 
 //////////////////////////////////////////////////
 /// \brief Function called each time a topic update is received.
@@ -57,6 +63,26 @@ void cbNonConst(char *_data, size_t _size, char *_msgType, void *_userData)
   ++count;
 }
 
+//////////////////////////////////////////////////
+/// \brief Function called each time a borrowed message is received.
+void cbView(const GzTransportMsgView *_view, void *_userData)
+{
+  int *userData = static_cast<int*>(_userData);
+
+  ASSERT_NE(nullptr, userData);
+  EXPECT_EQ(42, *userData);
+  ASSERT_NE(nullptr, _view);
+
+  gz::msgs::StringMsg msg;
+  EXPECT_TRUE(msg.ParseFromArray(_view->data,
+    static_cast<int>(_view->size)));
+  EXPECT_STREQ("gz.msgs.StringMsg", _view->msgType);
+  EXPECT_STREQ("/view", _view->topic);
+  EXPECT_EQ(1, _view->intraProcess);
+  EXPECT_EQ(msg.data(), "HELLO");
+  ++viewCount;
+}
+
 //////////////////////////////////////////////////
 TEST(CIfaceTest, PubSub)
 {
@@ -176,6 +202,92 @@ TEST(CIfaceTest, PubSubPartitions)
   EXPECT_EQ(nullptr, nodeBar);
 }
 
+//////////////////////////////////////////////////
+TEST(CIfaceTest, LoanView)
+{
+  viewCount = 0;
+  GzTransportNode *node = gzTransportNodeCreate(nullptr);
+  ASSERT_NE(nullptr, node);
+
+  const char *topic = "/view";
+  const char *msgType = "gz.msgs.StringMsg";
+  int userData = 42;
+
+  ASSERT_EQ(0, gzTransportSubscribeView(node, topic, cbView, &userData));
+
+  gz::msgs::StringMsg msg;
+  msg.set_data("HELLO");
+  const size_t size = msg.ByteSizeLong();
+
+  // Serialize the message in place and publish it.
+  GzTransportLoan *loan = gzTransportLoanAcquire(node, topic, msgType, size);
+  ASSERT_NE(nullptr, loan);
+  EXPECT_EQ(size, gzTransportLoanSize(loan));
+  ASSERT_TRUE(msg.SerializeToArray(gzTransportLoanData(loan),
+    static_cast<int>(size)));
+  EXPECT_EQ(0, gzTransportLoanCommit(&loan));
+  EXPECT_EQ(nullptr, loan);
+
+  for (int i = 0; i < 100 && viewCount < 1; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(1, viewCount);
+
+  // A released loan isn't published.
+  loan = gzTransportLoanAcquire(node, topic, msgType, size);
+  ASSERT_NE(nullptr, loan);
+  gzTransportLoanRelease(&loan);
+  EXPECT_EQ(nullptr, loan);
+  EXPECT_NE(0, gzTransportLoanCommit(&loan));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(1, viewCount);
+
+  EXPECT_EQ(nullptr, gzTransportLoanAcquire(nullptr, topic, msgType, size));
+  EXPECT_EQ(nullptr, gzTransportLoanData(nullptr));
+  EXPECT_EQ(0u, gzTransportLoanSize(nullptr));
+
+  gzTransportNodeDestroy(&node);
+}
+
+//////////////////////////////////////////////////
+TEST(CIfaceTest, PublisherHandle)
+{
+  viewCount = 0;
+  GzTransportNode *node = gzTransportNodeCreate(nullptr);
+  ASSERT_NE(nullptr, node);
+
+  const char *topic = "/view";
+  int userData = 42;
+  ASSERT_EQ(0, gzTransportSubscribeView(node, topic, cbView, &userData));
+
+  EXPECT_EQ(nullptr,
+    gzTransportAdvertisePublisher(nullptr, topic, "gz.msgs.StringMsg"));
+  GzTransportPublisher *pub =
+    gzTransportAdvertisePublisher(node, topic, "gz.msgs.StringMsg");
+  ASSERT_NE(nullptr, pub);
+
+  gz::msgs::StringMsg msg;
+  msg.set_data("HELLO");
+  const std::string data = msg.SerializeAsString();
+
+  EXPECT_EQ(0, gzTransportPublisherPublish(pub, data.data(), data.size()));
+
+  const void *batch[] = {data.data(), data.data(), data.data()};
+  const size_t sizes[] = {data.size(), data.size(), data.size()};
+  EXPECT_EQ(3, gzTransportPublisherPublishBatch(pub, batch, sizes, 3));
+  EXPECT_EQ(-1, gzTransportPublisherPublishBatch(pub, nullptr, sizes, 3));
+  EXPECT_EQ(1, gzTransportPublisherPublish(nullptr, data.data(),
+    data.size()));
+
+  for (int i = 0; i < 100 && viewCount < 4; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(4, viewCount);
+
+  gzTransportPublisherDestroy(&pub);
+  EXPECT_EQ(nullptr, pub);
+  gzTransportNodeDestroy(&node);
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
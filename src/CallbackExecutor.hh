@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_CALLBACKEXECUTOR_HH_
+#define GZ_TRANSPORT_CALLBACKEXECUTOR_HH_
+
+#include <functional>
+#include <string>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Runs the callbacks of the handlers that don't use the threads
+    /// shared by all the nodes: the nodes in spin mode and the callback
+    /// groups.
+    class CallbackExecutor
+    {
+      /// \brief Destructor.
+      public: virtual ~CallbackExecutor() = default;
+
+      /// \brief Post a callback.
+      /// \param[in] _key Ordering key, e.g. the handler UUID. The callbacks
+      /// with the same key run one at a time, in order.
+      /// \param[in] _task The callback.
+      public: virtual void Post(const std::string &_key,
+                                std::function<void()> _task) = 0;
+    };
+    }
+  }
+}
+#endif
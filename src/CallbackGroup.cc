@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/Helpers.hh"
+
+#include "CallbackGroup.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+CallbackGroupExecutor::CallbackGroupExecutor(const std::string &_name,
+    const CallbackGroupOptions &_opts)
+  : name(_name),
+    type(_opts.Type()),
+    executor(_opts.Threads(), [_opts]() { SetupThread(_opts); })
+{
+}
+
+//////////////////////////////////////////////////
+void CallbackGroupExecutor::Post(const std::string &_key,
+    std::function<void()> _task)
+{
+  // A single strand runs the callbacks of a mutually exclusive group one
+  // at a time.
+  if (this->type == CallbackGroup_t::MUTUALLY_EXCLUSIVE)
+    this->executor.Post(this->name, std::move(_task));
+  else
+    this->executor.Post(_key, std::move(_task));
+}
+
+//////////////////////////////////////////////////
+bool CallbackGroupExecutor::SetupThread(const CallbackGroupOptions &_opts)
+{
+  bool result = true;
+  std::vector<int> cpus = _opts.Cpus();
+  if (_opts.NumaNode() >= 0)
+  {
+    if (cpus.empty() && !numaNodeCpus(_opts.NumaNode(), cpus))
+    {
+      std::cerr << "Invalid NUMA node [" << _opts.NumaNode() << "] for a "
+                << "callback group" << std::endl;
+      result = false;
+    }
+    else
+    {
+      result = setThreadMemoryNode("callback group", _opts.NumaNode());
+    }
+  }
+
+  return setThreadScheduling("callback group", cpus, _opts.Priority()) &&
+    result;
+}
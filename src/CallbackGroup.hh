@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_CALLBACKGROUP_HH_
+#define GZ_TRANSPORT_CALLBACKGROUP_HH_
+
+#include <functional>
+#include <string>
+
+#include "gz/transport/CallbackGroupOptions.hh"
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+#include "CallbackExecutor.hh"
+#include "DispatchExecutor.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Threads running the callbacks of a callback group of a node.
+    /// \sa Node::CreateCallbackGroup
+    class GZ_TRANSPORT_VISIBLE CallbackGroupExecutor : public CallbackExecutor
+    {
+      /// \brief Constructor. Starts the threads of the group.
+      /// \param[in] _name Name of the group.
+      /// \param[in] _opts Options of the group.
+      public: CallbackGroupExecutor(const std::string &_name,
+                                    const CallbackGroupOptions &_opts);
+
+      /// \brief Destructor. Discards the pending callbacks and joins the
+      /// threads.
+      public: ~CallbackGroupExecutor() override = default;
+
+      // Documentation inherited.
+      public: void Post(const std::string &_key,
+                        std::function<void()> _task) override;
+
+      /// \brief Apply the priority and the CPU affinity of a group to the
+      /// calling thread.
+      /// \param[in] _opts Options of the group.
+      /// \return False if they could not be applied.
+      public: static bool SetupThread(const CallbackGroupOptions &_opts);
+
+      /// \brief Name of the group, the ordering key of the callbacks of a
+      /// mutually exclusive group.
+      private: const std::string name;
+
+      /// \brief Whether the callbacks may run at the same time.
+      private: const CallbackGroup_t type;
+
+      /// \brief Threads of the group.
+      private: DispatchExecutor executor;
+    };
+    }
+  }
+}
+#endif
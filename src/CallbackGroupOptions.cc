@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <vector>
+
+#include "gz/transport/CallbackGroupOptions.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+    {
+    /// \internal
+    /// \brief Private data for CallbackGroupOptions class.
+    class CallbackGroupOptionsPrivate
+    {
+      /// \brief Whether the callbacks may run at the same time.
+      public: CallbackGroup_t type = CallbackGroup_t::MUTUALLY_EXCLUSIVE;
+
+      /// \brief Number of threads.
+      public: unsigned int threads = 1;
+
+      /// \brief Real-time priority, or 0 for the default scheduling.
+      public: int priority = 0;
+
+      /// \brief CPUs of the threads, or empty for any CPU.
+      public: std::vector<int> cpus;
+
+      /// \brief NUMA node of the threads, or -1 for none.
+      public: int numaNode = -1;
+    };
+    }
+  }
+}
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+CallbackGroupOptions::CallbackGroupOptions()
+  : dataPtr(new CallbackGroupOptionsPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+CallbackGroupOptions::CallbackGroupOptions(
+  const CallbackGroupOptions &_other)
+  : dataPtr(new CallbackGroupOptionsPrivate(*_other.dataPtr))
+{
+}
+
+//////////////////////////////////////////////////
+CallbackGroupOptions::~CallbackGroupOptions()
+{
+}
+
+//////////////////////////////////////////////////
+CallbackGroupOptions &CallbackGroupOptions::operator=(
+  const CallbackGroupOptions &_other)
+{
+  *this->dataPtr = *_other.dataPtr;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+CallbackGroup_t CallbackGroupOptions::Type() const
+{
+  return this->dataPtr->type;
+}
+
+//////////////////////////////////////////////////
+void CallbackGroupOptions::SetType(const CallbackGroup_t _type)
+{
+  this->dataPtr->type = _type;
+}
+
+//////////////////////////////////////////////////
+unsigned int CallbackGroupOptions::Threads() const
+{
+  return this->dataPtr->threads;
+}
+
+//////////////////////////////////////////////////
+void CallbackGroupOptions::SetThreads(const unsigned int _threads)
+{
+  this->dataPtr->threads = _threads == 0 ? 1u : _threads;
+}
+
+//////////////////////////////////////////////////
+int CallbackGroupOptions::Priority() const
+{
+  return this->dataPtr->priority;
+}
+
+//////////////////////////////////////////////////
+void CallbackGroupOptions::SetPriority(const int _priority)
+{
+  this->dataPtr->priority = _priority;
+}
+
+//////////////////////////////////////////////////
+const std::vector<int> &CallbackGroupOptions::Cpus() const
+{
+  return this->dataPtr->cpus;
+}
+
+//////////////////////////////////////////////////
+void CallbackGroupOptions::SetCpus(const std::vector<int> &_cpus)
+{
+  this->dataPtr->cpus = _cpus;
+}
+
+//////////////////////////////////////////////////
+int CallbackGroupOptions::NumaNode() const
+{
+  return this->dataPtr->numaNode;
+}
+
+//////////////////////////////////////////////////
+void CallbackGroupOptions::SetNumaNode(const int _node)
+{
+  this->dataPtr->numaNode = _node < 0 ? -1 : _node;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "CallbackGroup.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Check the options of a callback group.
+TEST(CallbackGroupTest, Options)
+{
+  CallbackGroupOptions opts;
+  EXPECT_EQ(CallbackGroup_t::MUTUALLY_EXCLUSIVE, opts.Type());
+  EXPECT_EQ(1u, opts.Threads());
+  EXPECT_EQ(0, opts.Priority());
+  EXPECT_TRUE(opts.Cpus().empty());
+  EXPECT_EQ(-1, opts.NumaNode());
+
+  opts.SetType(CallbackGroup_t::REENTRANT);
+  opts.SetThreads(0);
+  EXPECT_EQ(1u, opts.Threads());
+  opts.SetThreads(4);
+  opts.SetPriority(80);
+  opts.SetCpus({2, 3});
+  opts.SetNumaNode(-5);
+  EXPECT_EQ(-1, opts.NumaNode());
+  opts.SetNumaNode(1);
+
+  CallbackGroupOptions other(opts);
+  EXPECT_EQ(CallbackGroup_t::REENTRANT, other.Type());
+  EXPECT_EQ(4u, other.Threads());
+  EXPECT_EQ(80, other.Priority());
+  EXPECT_EQ((std::vector<int>{2, 3}), other.Cpus());
+  EXPECT_EQ(1, other.NumaNode());
+
+  CallbackGroupOptions assigned;
+  assigned = opts;
+  EXPECT_EQ(4u, assigned.Threads());
+
+  // The default options leave the threads untouched.
+  EXPECT_TRUE(CallbackGroupExecutor::SetupThread(CallbackGroupOptions()));
+}
+
+//////////////////////////////////////////////////
+/// \brief The callbacks of a mutually exclusive group never overlap.
+TEST(CallbackGroupTest, MutuallyExclusive)
+{
+  CallbackGroupOptions opts;
+  opts.SetThreads(4);
+
+  std::atomic<int> running{0};
+  std::atomic<int> maxRunning{0};
+  std::atomic<int> done{0};
+  {
+    CallbackGroupExecutor group("exclusive", opts);
+    for (int i = 0; i < 20; ++i)
+    {
+      group.Post("handler" + std::to_string(i % 4),
+        [&running, &maxRunning, &done]()
+      {
+        const int now = ++running;
+        int max = maxRunning;
+        while (now > max && !maxRunning.compare_exchange_weak(max, now))
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --running;
+        ++done;
+      });
+    }
+
+    const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (done < 20 && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  EXPECT_EQ(20, done);
+  EXPECT_EQ(1, maxRunning);
+}
+
+//////////////////////////////////////////////////
+/// \brief The callbacks of different handlers of a reentrant group run in
+/// parallel.
+TEST(CallbackGroupTest, Reentrant)
+{
+  CallbackGroupOptions opts;
+  opts.SetType(CallbackGroup_t::REENTRANT);
+  opts.SetThreads(2);
+  CallbackGroupExecutor group("reentrant", opts);
+
+  // Each callback waits for the other one.
+  std::mutex mutex;
+  std::condition_variable condition;
+  int arrived = 0;
+  std::atomic<int> met{0};
+  auto meet = [&]()
+  {
+    std::unique_lock<std::mutex> lk(mutex);
+    ++arrived;
+    condition.notify_all();
+    if (condition.wait_for(lk, std::chrono::seconds(5),
+          [&arrived]() { return arrived == 2; }))
+    {
+      ++met;
+    }
+  };
+  group.Post("a", meet);
+  group.Post("b", meet);
+
+  const auto deadline =
+    std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (met < 2 && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(2, met);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <mutex>
+#include <string>
+
+#include "gz/transport/Helpers.hh"
+
+#include "CallbackProfiler.hh"
+
+using namespace gz;
+using namespace transport;
+
+/// \brief Counters of a handler.
+class gz::transport::CallbackProfiler::Entry
+{
+  /// \brief Topic of the subscription.
+  public: std::string topic;
+
+  /// \brief UUID of the node that subscribed.
+  public: std::string nodeUuid;
+
+  /// \brief UUID of the handler.
+  public: std::string handlerUuid;
+
+  /// \brief The handler, to detect that it was destroyed.
+  public: std::weak_ptr<SubscriptionHandlerBase> handler;
+
+  /// \brief Number of callbacks.
+  public: std::atomic<uint64_t> calls{0};
+
+  /// \brief Number of overruns.
+  public: std::atomic<uint64_t> overruns{0};
+
+  /// \brief Total callback time (ns).
+  public: std::atomic<uint64_t> totalNs{0};
+
+  /// \brief Maximum callback time (ns).
+  public: std::atomic<uint64_t> maxNs{0};
+
+  /// \brief Arrival of the last message (ns since the clock epoch).
+  public: std::atomic<int64_t> lastArrivalNs{0};
+
+  /// \brief Callback durations (us).
+  public: LatencyHistogram durations;
+};
+
+//////////////////////////////////////////////////
+CallbackProfiler &CallbackProfiler::Instance()
+{
+  static CallbackProfiler profiler;
+  return profiler;
+}
+
+//////////////////////////////////////////////////
+CallbackProfiler::CallbackProfiler()
+{
+  std::string value;
+  if (env("GZ_TRANSPORT_CALLBACK_PROFILE", value) && !value.empty())
+    this->enabled = (value == "1");
+}
+
+//////////////////////////////////////////////////
+void CallbackProfiler::SetEnabled(const bool _enabled)
+{
+  this->enabled = _enabled;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<CallbackProfiler::Entry> CallbackProfiler::Find(
+    const std::shared_ptr<SubscriptionHandlerBase> &_handler,
+    const std::string &_topic)
+{
+  const std::string hUuid = _handler->HandlerUuid();
+  {
+    std::shared_lock<std::shared_mutex> lk(this->mutex);
+    auto it = this->entries.find(hUuid);
+    if (it != this->entries.end())
+      return it->second;
+  }
+
+  auto entry = std::make_shared<Entry>();
+  entry->topic = _topic;
+  entry->nodeUuid = _handler->NodeUuid();
+  entry->handlerUuid = hUuid;
+  entry->handler = _handler;
+
+  std::lock_guard<std::shared_mutex> lk(this->mutex);
+  return this->entries.emplace(hUuid, entry).first->second;
+}
+
+//////////////////////////////////////////////////
+void CallbackProfiler::Record(Entry &_entry, Clock::time_point _arrival,
+    Clock::time_point _start, Clock::time_point _end)
+{
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+
+  const uint64_t elapsed = _end > _start ?
+    static_cast<uint64_t>(duration_cast<nanoseconds>(_end - _start).count()) :
+    0u;
+  const int64_t arrivalNs =
+    duration_cast<nanoseconds>(_arrival.time_since_epoch()).count();
+
+  _entry.calls.fetch_add(1u, std::memory_order_relaxed);
+  _entry.totalNs.fetch_add(elapsed, std::memory_order_relaxed);
+  _entry.durations.Record(elapsed / 1000u);
+
+  uint64_t max = _entry.maxNs.load(std::memory_order_relaxed);
+  while (elapsed > max && !_entry.maxNs.compare_exchange_weak(max, elapsed,
+           std::memory_order_relaxed))
+  {
+  }
+
+  // The handler didn't keep up if the callback lasted longer than the
+  // interval between this message and the previous one.
+  const int64_t previous =
+    _entry.lastArrivalNs.exchange(arrivalNs, std::memory_order_relaxed);
+  if (previous != 0 && arrivalNs > previous &&
+      elapsed > static_cast<uint64_t>(arrivalNs - previous))
+  {
+    _entry.overruns.fetch_add(1u, std::memory_order_relaxed);
+  }
+}
+
+//////////////////////////////////////////////////
+std::vector<CallbackProfile> CallbackProfiler::Profiles()
+{
+  std::vector<CallbackProfile> profiles;
+
+  std::lock_guard<std::shared_mutex> lk(this->mutex);
+  for (auto it = this->entries.begin(); it != this->entries.end();)
+  {
+    const Entry &entry = *it->second;
+    if (entry.handler.expired())
+    {
+      it = this->entries.erase(it);
+      continue;
+    }
+
+    CallbackProfile profile;
+    profile.topic = entry.topic;
+    profile.nodeUuid = entry.nodeUuid;
+    profile.handlerUuid = entry.handlerUuid;
+    profile.calls = entry.calls.load(std::memory_order_relaxed);
+    profile.overruns = entry.overruns.load(std::memory_order_relaxed);
+    profile.totalNs = entry.totalNs.load(std::memory_order_relaxed);
+    profile.maxNs = entry.maxNs.load(std::memory_order_relaxed);
+    profile.durations = entry.durations;
+    profiles.push_back(std::move(profile));
+    ++it;
+  }
+  return profiles;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_CALLBACKPROFILER_HH_
+#define GZ_TRANSPORT_CALLBACKPROFILER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>  //NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+#include "gz/transport/SubscriptionHandler.hh"
+#include "gz/transport/TopicStatistics.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Measures the execution time of the subscription callbacks of
+    /// this process, per handler.
+    ///
+    /// Profiling is enabled by setting GZ_TRANSPORT_CALLBACK_PROFILE to 1.
+    /// The callbacks are wrapped in a Scope, which only reads the clock when
+    /// profiling is enabled. The counters of a handler are relaxed atomics,
+    /// so concurrent callbacks of the same handler never wait for each other.
+    /// The profiles of the destroyed handlers are removed by Profiles().
+    class GZ_TRANSPORT_VISIBLE CallbackProfiler
+    {
+      /// \brief Type of the clock used by the profiles.
+      public: using Clock = std::chrono::steady_clock;
+
+      /// \brief Counters of a handler, defined in the source file.
+      public: class Entry;
+
+      /// \brief Get the profiler of this process.
+      /// \return The profiler.
+      public: static CallbackProfiler &Instance();
+
+      /// \brief No copy.
+      public: CallbackProfiler(const CallbackProfiler &) = delete;
+
+      /// \brief No assignment.
+      public: CallbackProfiler &operator=(const CallbackProfiler &) = delete;
+
+      /// \brief Whether the callbacks are profiled.
+      /// \return True if enabled.
+      public: bool Enabled() const
+      {
+        return this->enabled.load(std::memory_order_relaxed);
+      }
+
+      /// \brief Turn profiling on or off. The collected profiles are kept.
+      /// \param[in] _enabled True to profile the callbacks.
+      public: void SetEnabled(const bool _enabled);
+
+      /// \brief Get the counters of a handler, creating them if needed.
+      /// \param[in] _handler Subscription handler.
+      /// \param[in] _topic Topic name, without the partition.
+      /// \return The counters.
+      public: std::shared_ptr<Entry> Find(
+        const std::shared_ptr<SubscriptionHandlerBase> &_handler,
+        const std::string &_topic);
+
+      /// \brief Count the execution of a callback.
+      /// \param[in] _entry Counters of the handler.
+      /// \param[in] _arrival Time at which the message arrived.
+      /// \param[in] _start Time at which the callback started.
+      /// \param[in] _end Time at which the callback returned.
+      public: static void Record(Entry &_entry, Clock::time_point _arrival,
+                                 Clock::time_point _start,
+                                 Clock::time_point _end);
+
+      /// \brief Get the profiles of the live handlers.
+      /// \return One profile per handler that ran a callback.
+      public: std::vector<CallbackProfile> Profiles();
+
+      /// \brief Profiles the callback executed during its lifetime.
+      public: class Scope
+      {
+        /// \brief Constructor.
+        /// \param[in] _handler Handler running the callback.
+        /// \param[in] _topic Topic name, without the partition.
+        /// \param[in] _arrival Time at which the message arrived or a
+        /// default time point if unknown, in which case the start of the
+        /// callback is used.
+        public: template<typename T>
+        Scope(const std::shared_ptr<T> &_handler, const std::string &_topic,
+              Clock::time_point _arrival = Clock::time_point())
+        {
+          CallbackProfiler &profiler = Instance();
+          if (!profiler.Enabled())
+            return;
+
+          this->entry = profiler.Find(_handler, _topic);
+          this->start = Clock::now();
+          this->arrival = _arrival == Clock::time_point() ?
+            this->start : _arrival;
+        }
+
+        /// \brief Destructor. Counts the callback.
+        public: ~Scope()
+        {
+          if (this->entry)
+            Record(*this->entry, this->arrival, this->start, Clock::now());
+        }
+
+        /// \brief No copy.
+        public: Scope(const Scope &) = delete;
+
+        /// \brief No assignment.
+        public: Scope &operator=(const Scope &) = delete;
+
+        /// \brief Counters of the handler, or nullptr if not profiled.
+        private: std::shared_ptr<Entry> entry;
+
+        /// \brief Arrival of the message.
+        private: Clock::time_point arrival;
+
+        /// \brief Start of the callback.
+        private: Clock::time_point start;
+      };
+
+      /// \brief Constructor. Reads GZ_TRANSPORT_CALLBACK_PROFILE.
+      private: CallbackProfiler();
+
+      /// \brief Whether the callbacks are profiled.
+      private: std::atomic<bool> enabled{false};
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::unordered_map
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Protects the entries.
+      private: mutable std::shared_mutex mutex;
+
+      /// \brief Counters of every handler, indexed by handler UUID.
+      private: std::unordered_map<std::string, std::shared_ptr<Entry>>
+        entries;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "gz/transport/SubscriptionHandler.hh"
+#include "CallbackProfiler.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+using Clock = CallbackProfiler::Clock;
+
+//////////////////////////////////////////////////
+/// \brief Find the profile of a handler.
+/// \param[in] _hUuid Handler UUID.
+/// \param[out] _profile The profile.
+/// \return True if the handler has a profile.
+static bool FindProfile(const std::string &_hUuid, CallbackProfile &_profile)
+{
+  for (const CallbackProfile &profile : CallbackProfiler::Instance().Profiles())
+  {
+    if (profile.HandlerUuid() == _hUuid)
+    {
+      _profile = profile;
+      return true;
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+TEST(CallbackProfilerTest, Disabled)
+{
+  CallbackProfiler &profiler = CallbackProfiler::Instance();
+  profiler.SetEnabled(false);
+
+  auto handler =
+    std::make_shared<SubscriptionHandler<msgs::Int32>>("node-uuid");
+  {
+    CallbackProfiler::Scope scope(handler, "/foo");
+  }
+
+  CallbackProfile profile;
+  EXPECT_FALSE(FindProfile(handler->HandlerUuid(), profile));
+}
+
+//////////////////////////////////////////////////
+TEST(CallbackProfilerTest, Record)
+{
+  CallbackProfiler &profiler = CallbackProfiler::Instance();
+  profiler.SetEnabled(true);
+
+  auto handler =
+    std::make_shared<SubscriptionHandler<msgs::Int32>>("node-uuid");
+  auto entry = profiler.Find(handler, "/foo");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(entry, profiler.Find(handler, "/foo"));
+
+  // Messages every 10 ms. The second callback takes 2 ms, the third one
+  // 15 ms, longer than the interval.
+  const Clock::time_point t0 = Clock::now();
+  const auto ms = [t0](int _ms)
+  {
+    return t0 + std::chrono::milliseconds(_ms);
+  };
+  CallbackProfiler::Record(*entry, ms(0), ms(0), ms(1));
+  CallbackProfiler::Record(*entry, ms(10), ms(10), ms(12));
+  CallbackProfiler::Record(*entry, ms(20), ms(20), ms(35));
+
+  CallbackProfile profile;
+  ASSERT_TRUE(FindProfile(handler->HandlerUuid(), profile));
+  EXPECT_EQ("/foo", profile.Topic());
+  EXPECT_EQ("node-uuid", profile.NodeUuid());
+  EXPECT_EQ(3u, profile.CallCount());
+  EXPECT_EQ(1u, profile.OverrunCount());
+  EXPECT_EQ(std::chrono::milliseconds(18), profile.TotalTime());
+  EXPECT_EQ(std::chrono::milliseconds(15), profile.MaxTime());
+  EXPECT_EQ(3u, profile.Durations().Count());
+
+  msgs::StatisticsGroup group;
+  profile.FillMessage(group);
+  EXPECT_EQ("callback_statistics", group.name());
+  ASSERT_EQ(3, group.header().data_size());
+  EXPECT_EQ("topic", group.header().data(0).key());
+  EXPECT_EQ("/foo", group.header().data(0).value(0));
+  ASSERT_LE(4, group.statistics_size());
+  EXPECT_EQ("call_count", group.statistics(0).name());
+  EXPECT_DOUBLE_EQ(3.0, group.statistics(0).value());
+  EXPECT_EQ("overrun_count", group.statistics(1).name());
+  EXPECT_DOUBLE_EQ(1.0, group.statistics(1).value());
+  EXPECT_EQ("avg_time", group.statistics(2).name());
+  EXPECT_DOUBLE_EQ(6.0, group.statistics(2).value());
+  EXPECT_EQ("max_time", group.statistics(3).name());
+  EXPECT_DOUBLE_EQ(15.0, group.statistics(3).value());
+
+  // The profile goes away with the handler.
+  const std::string hUuid = handler->HandlerUuid();
+  entry.reset();
+  handler.reset();
+  EXPECT_FALSE(FindProfile(hUuid, profile));
+
+  profiler.SetEnabled(false);
+}
+
+//////////////////////////////////////////////////
+TEST(CallbackProfilerTest, Scope)
+{
+  CallbackProfiler &profiler = CallbackProfiler::Instance();
+  profiler.SetEnabled(true);
+
+  auto handler =
+    std::make_shared<SubscriptionHandler<msgs::Int32>>("node-uuid");
+  const Clock::time_point arrival = Clock::now();
+  {
+    CallbackProfiler::Scope scope(handler, "/bar", arrival);
+  }
+  {
+    // The message arrived 1 ms after the previous one, but the callback
+    // only started now.
+    CallbackProfiler::Scope scope(handler, "/bar",
+      arrival + std::chrono::milliseconds(1));
+  }
+
+  CallbackProfile profile;
+  ASSERT_TRUE(FindProfile(handler->HandlerUuid(), profile));
+  EXPECT_EQ("/bar", profile.Topic());
+  EXPECT_EQ(2u, profile.CallCount());
+  EXPECT_EQ(0u, profile.OverrunCount());
+
+  profiler.SetEnabled(false);
+}
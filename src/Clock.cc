@@ -17,7 +17,10 @@
 #include <gz/msgs/clock.pb.h>
 #include <gz/msgs/time.pb.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <iostream>
 #include <mutex>
@@ -27,6 +30,21 @@
 
 using namespace gz::transport;
 
+namespace
+{
+  /// \brief Weight of the latest rate measured in the estimated rate of a
+  /// network clock.
+  const double kRateSmoothing = 0.25;
+
+  /// \brief Current time of the steady clock.
+  /// \return Nanoseconds since the epoch of the steady clock.
+  int64_t steadyNow()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+}
+
 //////////////////////////////////////////////////
 class gz::transport::NetworkClock::Implementation
 {
@@ -40,8 +58,22 @@ class gz::transport::NetworkClock::Implementation
 
   /// \brief Gets clock time
   /// \return Current clock time, in nanoseconds
-  /// \remarks Reads are synchronized
-  public: std::chrono::nanoseconds Time();
+  /// \remarks Reads are lock-free
+  public: std::chrono::nanoseconds Time() const;
+
+  /// \brief Set whether the time is extrapolated.
+  /// \param[in] _interpolate True to extrapolate the time.
+  public: void SetInterpolation(bool _interpolate);
+
+  /// \brief Publish a new state of the clock to the readers. Must be
+  /// called with the clock mutex locked.
+  /// \param[in] _time Clock time at _steady (ns).
+  /// \param[in] _steady Steady time of the state (ns).
+  /// \param[in] _rate Rate of the clock relative to the steady clock, or 0
+  /// to hold the time.
+  /// \param[in] _horizon Maximum extrapolation after _steady (ns).
+  public: void Store(int64_t _time, int64_t _steady, double _rate,
+                     int64_t _horizon);
 
   /// \brief Sets and distributes the given clock time
   /// \param[in] _time The clock time to be set
@@ -57,13 +89,46 @@ class gz::transport::NetworkClock::Implementation
   /// \param[in] _msg Received clock message
   public: void OnClockMessageReceived(const gz::msgs::Clock &_msg);
 
-  /// \brief Current clock time, in nanoseconds.
-  public: std::chrono::nanoseconds clockTimeNS;
+  /// \brief Clock time of the current state, in nanoseconds.
+  public: std::atomic<int64_t> clockTimeNS{0};
+
+  /// \brief Steady time of the current state, in nanoseconds.
+  public: std::atomic<int64_t> steadyTimeNS{0};
+
+  /// \brief Rate at which the clock time is extrapolated, or 0.
+  public: std::atomic<double> rate{0.0};
+
+  /// \brief Maximum extrapolation after the steady time of the state, in
+  /// nanoseconds.
+  public: std::atomic<int64_t> horizonNS{0};
+
+  /// \brief Version of the state, odd while it is being written. The
+  /// readers retry when it changes under them (sequence lock).
+  public: std::atomic<uint64_t> version{0};
+
+  /// \brief Whether the time is extrapolated.
+  public: std::atomic<bool> interpolate{false};
+
+  /// \brief Clock time of the last message, in nanoseconds.
+  public: int64_t lastMsgNS = 0;
+
+  /// \brief Steady time of the last message, in nanoseconds.
+  public: int64_t lastMsgSteadyNS = 0;
+
+  /// \brief Whether a message was received since the interpolation was
+  /// set or the clock went back.
+  public: bool haveLastMsg = false;
+
+  /// \brief Estimated rate of the clock relative to the steady clock.
+  public: double estimatedRate = 0.0;
+
+  /// \brief Whether the rate was estimated.
+  public: bool rateEstimated = false;
 
   /// \brief Time base to use for the clock.
   public: NetworkClock::TimeBase clockTimeBase;
 
-  /// \brief Lock to synchronize clock accesses.
+  /// \brief Lock to synchronize clock updates.
   public: std::mutex clockMutex;
 
   /// \brief Node to publish/subscribe clock messages.
@@ -76,8 +141,7 @@ class gz::transport::NetworkClock::Implementation
 //////////////////////////////////////////////////
 NetworkClock::Implementation::Implementation(const std::string& _topicName,
                                              NetworkClock::TimeBase _timeBase)
-    : clockTimeNS(std::chrono::nanoseconds::zero()),
-      clockTimeBase(_timeBase)
+    : clockTimeBase(_timeBase)
 {
   if (!node.Subscribe(
           _topicName, &Implementation::OnClockMessageReceived, this))
@@ -88,10 +152,61 @@ NetworkClock::Implementation::Implementation(const std::string& _topicName,
 }
 
 //////////////////////////////////////////////////
-std::chrono::nanoseconds NetworkClock::Implementation::Time()
+std::chrono::nanoseconds NetworkClock::Implementation::Time() const
+{
+  int64_t time = 0;
+  int64_t steady = 0;
+  double currentRate = 0.0;
+  int64_t horizon = 0;
+  uint64_t before = 0;
+  do
+  {
+    before = this->version.load(std::memory_order_acquire);
+    time = this->clockTimeNS.load(std::memory_order_relaxed);
+    steady = this->steadyTimeNS.load(std::memory_order_relaxed);
+    currentRate = this->rate.load(std::memory_order_relaxed);
+    horizon = this->horizonNS.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  while ((before & 1u) != 0 ||
+         before != this->version.load(std::memory_order_relaxed));
+
+  if (currentRate <= 0.0)
+    return std::chrono::nanoseconds(time);
+
+  const int64_t elapsed = std::clamp<int64_t>(steadyNow() - steady, 0,
+    horizon);
+  return std::chrono::nanoseconds(time +
+    static_cast<int64_t>(currentRate * static_cast<double>(elapsed)));
+}
+
+//////////////////////////////////////////////////
+void NetworkClock::Implementation::Store(const int64_t _time,
+    const int64_t _steady, const double _rate, const int64_t _horizon)
+{
+  const uint64_t current = this->version.load(std::memory_order_relaxed);
+  this->version.store(current + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  this->clockTimeNS.store(_time, std::memory_order_relaxed);
+  this->steadyTimeNS.store(_steady, std::memory_order_relaxed);
+  this->rate.store(_rate, std::memory_order_relaxed);
+  this->horizonNS.store(_horizon, std::memory_order_relaxed);
+  this->version.store(current + 2, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+void NetworkClock::Implementation::SetInterpolation(const bool _interpolate)
 {
   std::lock_guard<std::mutex> lock(this->clockMutex);
-  return this->clockTimeNS;
+  if (this->interpolate == _interpolate)
+    return;
+
+  this->interpolate = _interpolate;
+  this->haveLastMsg = false;
+  this->rateEstimated = false;
+
+  // Hold the time shown until the next message.
+  this->Store(this->Time().count(), steadyNow(), 0.0, 0);
 }
 
 //////////////////////////////////////////////////
@@ -131,9 +246,53 @@ void NetworkClock::Implementation::SetTime(std::chrono::nanoseconds _time)
 void NetworkClock::Implementation::UpdateTimeFromMessage(
     const gz::msgs::Time& msg)
 {
+  const int64_t time = (std::chrono::seconds(msg.sec()) +
+    std::chrono::nanoseconds(msg.nsec())).count();
+  const int64_t now = steadyNow();
+
   std::lock_guard<std::mutex> lock(this->clockMutex);
-  this->clockTimeNS = std::chrono::seconds(msg.sec()) +
-                      std::chrono::nanoseconds(msg.nsec());
+  if (!this->interpolate)
+  {
+    this->Store(time, now, 0.0, 0);
+    return;
+  }
+
+  int64_t shownTime = time;
+  double shownRate = 0.0;
+  int64_t horizon = 0;
+
+  // A clock that goes back, e.g. on a reset, starts a new estimation.
+  if (this->haveLastMsg && time >= this->lastMsgNS &&
+      now > this->lastMsgSteadyNS)
+  {
+    const double measured = static_cast<double>(time - this->lastMsgNS) /
+      static_cast<double>(now - this->lastMsgSteadyNS);
+    this->estimatedRate = this->rateEstimated ?
+      kRateSmoothing * measured + (1.0 - kRateSmoothing) * this->estimatedRate :
+      measured;
+    this->rateEstimated = true;
+
+    // Extrapolate until the next message is expected.
+    shownRate = this->estimatedRate;
+    horizon = now - this->lastMsgSteadyNS;
+
+    // The time never goes back: it holds until the messages catch up.
+    const int64_t extrapolated = this->Time().count();
+    if (time < extrapolated)
+    {
+      shownTime = extrapolated;
+      shownRate = 0.0;
+    }
+  }
+  else
+  {
+    this->rateEstimated = false;
+  }
+
+  this->lastMsgNS = time;
+  this->lastMsgSteadyNS = now;
+  this->haveLastMsg = true;
+  this->Store(shownTime, now, shownRate, horizon);
 }
 
 //////////////////////////////////////////////////
@@ -206,6 +365,18 @@ bool NetworkClock::IsReady() const {
   return (this->dataPtr->Time().count() != 0);
 }
 
+//////////////////////////////////////////////////
+void NetworkClock::SetInterpolation(const bool _interpolate)
+{
+  this->dataPtr->SetInterpolation(_interpolate);
+}
+
+//////////////////////////////////////////////////
+bool NetworkClock::Interpolation() const
+{
+  return this->dataPtr->interpolate;
+}
+
 //////////////////////////////////////////////////
 class gz::transport::WallClock::Implementation
 {
@@ -126,6 +126,60 @@ TEST_P(NetworkClockTest, Functionality)
   EXPECT_EQ(clock.Time(), expectedSecs + expectedNsecs * 2);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check the interpolation of the NetworkClock time between its
+/// messages.
+TEST(ClockTest, NetworkClockInterpolation)
+{
+  const std::string clockTopicName{"/clock_interpolation"};
+  transport::NetworkClock clock(clockTopicName, TimeBase::SIM);
+  EXPECT_FALSE(clock.Interpolation());
+  clock.SetInterpolation(true);
+  EXPECT_TRUE(clock.Interpolation());
+
+  transport::Node node;
+  transport::Node::Publisher clockPub =
+      node.Advertise<msgs::Clock>(clockTopicName);
+  const std::chrono::milliseconds period{50};
+  auto publish = [&clockPub](const std::chrono::milliseconds &_time)
+  {
+    msgs::Clock msg;
+    msg.mutable_sim()->set_sec(_time.count() / 1000);
+    msg.mutable_sim()->set_nsec((_time.count() % 1000) * 1000000);
+    clockPub.Publish(msg);
+  };
+
+  // The simulation runs in real time.
+  const std::chrono::milliseconds start{100000};
+  for (int i = 0; i < 3; ++i)
+  {
+    publish(start + period * i);
+    std::this_thread::sleep_for(period);
+  }
+  const std::chrono::nanoseconds last = start + period * 2;
+  const std::chrono::nanoseconds t0 = clock.Time();
+  EXPECT_GT(t0, last);
+  EXPECT_LE(t0, last + std::chrono::milliseconds(200));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_GE(clock.Time(), t0);
+
+  // The simulation is paused: the time holds, and doesn't go back.
+  publish(start + period * 2);
+  std::this_thread::sleep_for(period);
+  publish(start + period * 2);
+  std::this_thread::sleep_for(period);
+  const std::chrono::nanoseconds t1 = clock.Time();
+  EXPECT_GE(t1, t0);
+  std::this_thread::sleep_for(period);
+  EXPECT_EQ(t1, clock.Time());
+
+  // Without interpolation the time is the one of the last message.
+  clock.SetInterpolation(false);
+  publish(start + period * 3);
+  std::this_thread::sleep_for(period);
+  EXPECT_EQ(clock.Time(), start + period * 3);
+}
+
 INSTANTIATE_TEST_SUITE_P(TestAllTimeBases, NetworkClockTest,
                         ::testing::Values(TimeBase::SIM,
                                           TimeBase::REAL,
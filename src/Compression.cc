@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "gz/transport/config.hh"
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "Compression.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Size of the header of a compressed payload.
+  const std::size_t kSizeHeader = 8;
+
+  /// \brief Largest payload that can be compressed or decompressed. It's
+  /// constrained by the LZ4 API and guards against malformed headers.
+  const std::size_t kMaxSize =
+    static_cast<std::size_t>(std::numeric_limits<int>::max());
+
+  /// \brief Prefixes of the compressed message types.
+  const char kLz4Prefix[] = "gz.transport.LZ4:";
+  const char kZstdPrefix[] = "gz.transport.Zstd:";
+
+  //////////////////////////////////////////////////
+  /// \brief Write the original size at the beginning of a payload.
+  void WriteSize(uint64_t _size, char *_dst)
+  {
+    for (std::size_t i = 0; i < kSizeHeader; ++i)
+      _dst[i] = static_cast<char>((_size >> (8 * i)) & 0xFF);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Read the original size from the beginning of a payload.
+  uint64_t ReadSize(const char *_src)
+  {
+    uint64_t size = 0;
+    for (std::size_t i = 0; i < kSizeHeader; ++i)
+    {
+      size |= static_cast<uint64_t>(static_cast<unsigned char>(_src[i]))
+        << (8 * i);
+    }
+    return size;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Whether a message type starts with a prefix. The prefix is
+  /// removed on success.
+  bool StripPrefix(const char *_prefix, std::string &_msgType)
+  {
+    const std::size_t len = std::strlen(_prefix);
+    if (_msgType.compare(0, len, _prefix) != 0)
+      return false;
+    _msgType.erase(0, len);
+    return true;
+  }
+}
+
+const char Compression::kDiscoveryKey[] = "gz.transport.compression";
+
+//////////////////////////////////////////////////
+bool Compression::Supported(const Compression_t _codec)
+{
+  switch (_codec)
+  {
+    case Compression_t::NONE:
+      return true;
+    case Compression_t::LZ4:
+#ifdef HAVE_LZ4
+      return true;
+#else
+      return false;
+#endif
+    case Compression_t::ZSTD:
+#ifdef HAVE_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+}
+
+//////////////////////////////////////////////////
+std::string Compression::Name(const Compression_t _codec)
+{
+  switch (_codec)
+  {
+    case Compression_t::LZ4:
+      return "LZ4";
+    case Compression_t::ZSTD:
+      return "Zstd";
+    default:
+      return "None";
+  }
+}
+
+//////////////////////////////////////////////////
+bool Compression::FromName(const std::string &_name, Compression_t &_codec)
+{
+  for (auto codec :
+    {Compression_t::NONE, Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    if (_name == Name(codec))
+    {
+      _codec = codec;
+      return true;
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+std::string Compression::TypePrefix(const Compression_t _codec)
+{
+  switch (_codec)
+  {
+    case Compression_t::LZ4:
+      return kLz4Prefix;
+    case Compression_t::ZSTD:
+      return kZstdPrefix;
+    default:
+      return "";
+  }
+}
+
+//////////////////////////////////////////////////
+Compression_t Compression::StripTypePrefix(std::string &_msgType)
+{
+  if (StripPrefix(kLz4Prefix, _msgType))
+    return Compression_t::LZ4;
+  if (StripPrefix(kZstdPrefix, _msgType))
+    return Compression_t::ZSTD;
+  return Compression_t::NONE;
+}
+
+//////////////////////////////////////////////////
+bool Compression::Compress(const Compression_t _codec, const int _level,
+  const char *_data, const std::size_t _size, std::string &_out)
+{
+#if !defined(HAVE_LZ4) && !defined(HAVE_ZSTD)
+  static_cast<void>(_level);
+  static_cast<void>(_data);
+#endif
+
+  if (_size > kMaxSize || !Supported(_codec) || _codec == Compression_t::NONE)
+    return false;
+
+  switch (_codec)
+  {
+#ifdef HAVE_LZ4
+    case Compression_t::LZ4:
+    {
+      const int srcSize = static_cast<int>(_size);
+      const int bound = LZ4_compressBound(srcSize);
+      if (bound <= 0)
+        return false;
+      _out.resize(kSizeHeader + static_cast<std::size_t>(bound));
+      const int written = LZ4_compress_fast(_data, &_out[kSizeHeader],
+        srcSize, bound, _level < 1 ? 1 : _level);
+      if (written <= 0)
+        return false;
+      _out.resize(kSizeHeader + static_cast<std::size_t>(written));
+      break;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    case Compression_t::ZSTD:
+    {
+      const std::size_t bound = ZSTD_compressBound(_size);
+      _out.resize(kSizeHeader + bound);
+      const std::size_t written = ZSTD_compress(&_out[kSizeHeader], bound,
+        _data, _size, _level);
+      if (ZSTD_isError(written))
+        return false;
+      _out.resize(kSizeHeader + written);
+      break;
+    }
+#endif
+    default:
+      return false;
+  }
+
+  WriteSize(_size, &_out[0]);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Compression::Decompress(const Compression_t _codec, const char *_data,
+  const std::size_t _size, std::string &_out)
+{
+  if (_size < kSizeHeader || !Supported(_codec) ||
+      _codec == Compression_t::NONE)
+  {
+    return false;
+  }
+
+  const uint64_t origSize = ReadSize(_data);
+  if (origSize > kMaxSize)
+    return false;
+
+  _out.resize(static_cast<std::size_t>(origSize));
+  [[maybe_unused]] const char *src = _data + kSizeHeader;
+  [[maybe_unused]] const std::size_t srcSize = _size - kSizeHeader;
+
+  switch (_codec)
+  {
+#ifdef HAVE_LZ4
+    case Compression_t::LZ4:
+    {
+      if (srcSize > kMaxSize)
+        return false;
+      const int read = LZ4_decompress_safe(src, &_out[0],
+        static_cast<int>(srcSize), static_cast<int>(origSize));
+      return read >= 0 && static_cast<uint64_t>(read) == origSize;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    case Compression_t::ZSTD:
+    {
+      const std::size_t read = ZSTD_decompress(&_out[0], _out.size(),
+        src, srcSize);
+      return !ZSTD_isError(read) && read == origSize;
+    }
+#endif
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_COMPRESSION_HH_
+#define GZ_TRANSPORT_COMPRESSION_HH_
+
+#include <cstddef>
+#include <string>
+
+#include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Codecs used to compress the payload of the publications sent to
+    /// other processes.
+    ///
+    /// A compressed payload starts with the size of the original data
+    /// (8 bytes, little endian) followed by the output of the codec. The
+    /// message type frame of a compressed publication is prefixed with
+    /// TypePrefix(), so subscribers know how to decode it.
+    ///
+    /// The codecs are optional build dependencies. Supported() tells whether
+    /// this build can use one of them.
+    class GZ_TRANSPORT_VISIBLE Compression
+    {
+      /// \brief Key of the discovery header data used to advertise the codec
+      /// of a publisher.
+      public: static const char kDiscoveryKey[];
+
+      /// \brief Whether a codec is available in this build.
+      /// \param[in] _codec The codec.
+      /// \return True if messages can be compressed and decompressed with
+      /// the codec. NONE is always supported.
+      public: static bool Supported(const Compression_t _codec);
+
+      /// \brief Name of a codec.
+      /// \param[in] _codec The codec.
+      /// \return "None", "LZ4" or "Zstd".
+      public: static std::string Name(const Compression_t _codec);
+
+      /// \brief Get a codec from its name.
+      /// \param[in] _name Name returned by Name().
+      /// \param[out] _codec The codec.
+      /// \return False if the name is unknown.
+      public: static bool FromName(const std::string &_name,
+                                   Compression_t &_codec);
+
+      /// \brief Prefix added to the message type of a compressed publication.
+      /// \param[in] _codec The codec.
+      /// \return The prefix or an empty string for NONE.
+      public: static std::string TypePrefix(const Compression_t _codec);
+
+      /// \brief Remove the compression prefix from a message type.
+      /// \param[in, out] _msgType Message type of a publication.
+      /// \return The codec used to compress the publication or NONE if the
+      /// message type has no compression prefix.
+      public: static Compression_t StripTypePrefix(std::string &_msgType);
+
+      /// \brief Compress a payload.
+      /// \param[in] _codec The codec.
+      /// \param[in] _level Compression level (see
+      /// AdvertiseMessageOptions::SetCompression).
+      /// \param[in] _data Data to compress.
+      /// \param[in] _size Size of the data (bytes).
+      /// \param[out] _out Compressed payload.
+      /// \return False if the codec isn't supported or the data can't be
+      /// compressed.
+      public: static bool Compress(const Compression_t _codec,
+                                   const int _level,
+                                   const char *_data,
+                                   const std::size_t _size,
+                                   std::string &_out);
+
+      /// \brief Decompress a payload created with Compress().
+      /// \param[in] _codec The codec.
+      /// \param[in] _data Compressed payload.
+      /// \param[in] _size Size of the compressed payload (bytes).
+      /// \param[out] _out Original data.
+      /// \return False if the codec isn't supported or the payload is
+      /// malformed.
+      public: static bool Decompress(const Compression_t _codec,
+                                     const char *_data,
+                                     const std::size_t _size,
+                                     std::string &_out);
+    };
+    }
+  }
+}
+#endif
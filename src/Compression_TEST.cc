@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <string>
+
+#include "Compression.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+TEST(CompressionTest, Names)
+{
+  for (auto codec :
+    {Compression_t::NONE, Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    Compression_t parsed = Compression_t::NONE;
+    EXPECT_TRUE(Compression::FromName(Compression::Name(codec), parsed));
+    EXPECT_EQ(codec, parsed);
+  }
+
+  Compression_t parsed = Compression_t::LZ4;
+  EXPECT_FALSE(Compression::FromName("bzip2", parsed));
+  EXPECT_EQ(Compression_t::LZ4, parsed);
+  EXPECT_TRUE(Compression::Supported(Compression_t::NONE));
+}
+
+//////////////////////////////////////////////////
+TEST(CompressionTest, TypePrefix)
+{
+  EXPECT_TRUE(Compression::TypePrefix(Compression_t::NONE).empty());
+
+  for (auto codec : {Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    std::string msgType = Compression::TypePrefix(codec) + "gz.msgs.Int32";
+    EXPECT_EQ(codec, Compression::StripTypePrefix(msgType));
+    EXPECT_EQ("gz.msgs.Int32", msgType);
+  }
+
+  std::string msgType = "gz.msgs.Int32";
+  EXPECT_EQ(Compression_t::NONE, Compression::StripTypePrefix(msgType));
+  EXPECT_EQ("gz.msgs.Int32", msgType);
+}
+
+//////////////////////////////////////////////////
+TEST(CompressionTest, RoundTrip)
+{
+  std::string data;
+  for (int i = 0; i < 1000; ++i)
+    data += "gz-transport " + std::to_string(i % 10);
+
+  std::string out;
+  EXPECT_FALSE(Compression::Compress(Compression_t::NONE, 0, data.data(),
+    data.size(), out));
+
+  for (auto codec : {Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    std::string compressed;
+    if (!Compression::Supported(codec))
+    {
+      EXPECT_FALSE(Compression::Compress(codec, 0, data.data(), data.size(),
+        compressed));
+      continue;
+    }
+
+    ASSERT_TRUE(Compression::Compress(codec, 0, data.data(), data.size(),
+      compressed));
+    EXPECT_LT(compressed.size(), data.size());
+
+    std::string decompressed;
+    ASSERT_TRUE(Compression::Decompress(codec, compressed.data(),
+      compressed.size(), decompressed));
+    EXPECT_EQ(data, decompressed);
+
+    // Empty payloads.
+    ASSERT_TRUE(Compression::Compress(codec, 0, data.data(), 0, compressed));
+    ASSERT_TRUE(Compression::Decompress(codec, compressed.data(),
+      compressed.size(), decompressed));
+    EXPECT_TRUE(decompressed.empty());
+
+    // Malformed payloads.
+    EXPECT_FALSE(Compression::Decompress(codec, compressed.data(), 4,
+      decompressed));
+    std::string garbage(64, '\x7f');
+    EXPECT_FALSE(Compression::Decompress(codec, garbage.data(),
+      garbage.size(), decompressed));
+  }
+}
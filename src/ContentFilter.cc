@@ -0,0 +1,516 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <google/protobuf/descriptor.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ContentFilter.hh"
+
+using namespace gz;
+using namespace transport;
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+using google::protobuf::Reflection;
+
+//////////////////////////////////////////////////
+struct ContentFilter::Node
+{
+  /// \brief Kinds of nodes.
+  enum class Kind {AND, OR, NOT, COMPARE};
+
+  /// \brief Comparison operators.
+  enum class Op {EQ, NE, LT, LE, GT, GE};
+
+  /// \brief Kinds of constants.
+  enum class Value {NUMBER, STRING, BOOL, NAME};
+
+  /// \brief Kind of node.
+  Kind kind = Kind::COMPARE;
+
+  /// \brief Operands of AND, OR and NOT.
+  std::vector<std::unique_ptr<Node>> children;
+
+  /// \brief Field names of a comparison.
+  std::vector<std::string> path;
+
+  /// \brief Operator of a comparison.
+  Op op = Op::EQ;
+
+  /// \brief Kind of the constant of a comparison.
+  Value value = Value::NUMBER;
+
+  /// \brief Number or boolean constant.
+  double number = 0;
+
+  /// \brief String constant or enum value name.
+  std::string text;
+};
+
+namespace
+{
+  using Node = std::unique_ptr<ContentFilter::Node>;
+
+  //////////////////////////////////////////////////
+  /// \brief Recursive descent parser of the expressions.
+  class Parser
+  {
+    /// \brief Constructor.
+    /// \param[in] _text The expression.
+    public: explicit Parser(const std::string &_text)
+      : text(_text)
+    {
+    }
+
+    /// \brief Parse the whole expression.
+    /// \return The syntax tree, or nullptr on a syntax error.
+    public: Node Parse()
+    {
+      Node node = this->Or();
+      this->SkipSpaces();
+      if (!node || this->pos != this->text.size())
+        return nullptr;
+      return node;
+    }
+
+    /// \brief Skip the white space.
+    private: void SkipSpaces()
+    {
+      while (this->pos < this->text.size() &&
+             std::isspace(static_cast<unsigned char>(this->text[this->pos])))
+      {
+        ++this->pos;
+      }
+    }
+
+    /// \brief Consume a token if it comes next.
+    /// \param[in] _token The token.
+    /// \return True if it was consumed.
+    private: bool Accept(const char *_token)
+    {
+      this->SkipSpaces();
+      const std::string token(_token);
+      if (this->text.compare(this->pos, token.size(), token) != 0)
+        return false;
+      this->pos += token.size();
+      return true;
+    }
+
+    /// \brief Parse a chain of operands.
+    /// \param[in] _kind AND or OR.
+    /// \param[in] _token Token between the operands.
+    /// \param[in] _operand Parser of the operands.
+    /// \return The syntax tree, or nullptr on a syntax error.
+    private: template<typename F>
+    Node Chain(ContentFilter::Node::Kind _kind, const char *_token,
+               F _operand)
+    {
+      Node first = (this->*_operand)();
+      if (!first || !this->Accept(_token))
+        return first;
+
+      Node node(new ContentFilter::Node);
+      node->kind = _kind;
+      node->children.push_back(std::move(first));
+      do
+      {
+        Node next = (this->*_operand)();
+        if (!next)
+          return nullptr;
+        node->children.push_back(std::move(next));
+      }
+      while (this->Accept(_token));
+      return node;
+    }
+
+    /// \brief or := and ('||' and)*
+    /// \return The syntax tree, or nullptr on a syntax error.
+    private: Node Or()
+    {
+      return this->Chain(ContentFilter::Node::Kind::OR, "||", &Parser::And);
+    }
+
+    /// \brief and := unary ('&&' unary)*
+    /// \return The syntax tree, or nullptr on a syntax error.
+    private: Node And()
+    {
+      return this->Chain(ContentFilter::Node::Kind::AND, "&&",
+        &Parser::Unary);
+    }
+
+    /// \brief unary := '!' unary | '(' or ')' | comparison
+    /// \return The syntax tree, or nullptr on a syntax error.
+    private: Node Unary()
+    {
+      // Don't take the '!' of '!='.
+      this->SkipSpaces();
+      if (this->text.compare(this->pos, 1, "!") == 0 &&
+          this->text.compare(this->pos, 2, "!=") != 0)
+      {
+        ++this->pos;
+        Node operand = this->Unary();
+        if (!operand)
+          return nullptr;
+        Node node(new ContentFilter::Node);
+        node->kind = ContentFilter::Node::Kind::NOT;
+        node->children.push_back(std::move(operand));
+        return node;
+      }
+
+      if (this->Accept("("))
+      {
+        Node node = this->Or();
+        if (!node || !this->Accept(")"))
+          return nullptr;
+        return node;
+      }
+
+      return this->Compare();
+    }
+
+    /// \brief Parse a field name or a bare word.
+    /// \param[out] _name The name.
+    /// \return False if there is no name.
+    private: bool Name(std::string &_name)
+    {
+      this->SkipSpaces();
+      const std::size_t start = this->pos;
+      while (this->pos < this->text.size() &&
+             (std::isalnum(static_cast<unsigned char>(this->text[this->pos]))
+              || this->text[this->pos] == '_'))
+      {
+        ++this->pos;
+      }
+      _name = this->text.substr(start, this->pos - start);
+      return !_name.empty() &&
+        !std::isdigit(static_cast<unsigned char>(_name[0]));
+    }
+
+    /// \brief comparison := path op constant
+    /// \return The syntax tree, or nullptr on a syntax error.
+    private: Node Compare()
+    {
+      Node node(new ContentFilter::Node);
+      do
+      {
+        std::string name;
+        if (!this->Name(name))
+          return nullptr;
+        node->path.push_back(name);
+      }
+      while (this->Accept("."));
+
+      using Op = ContentFilter::Node::Op;
+      if (this->Accept("=="))
+        node->op = Op::EQ;
+      else if (this->Accept("!="))
+        node->op = Op::NE;
+      else if (this->Accept("<="))
+        node->op = Op::LE;
+      else if (this->Accept(">="))
+        node->op = Op::GE;
+      else if (this->Accept("<"))
+        node->op = Op::LT;
+      else if (this->Accept(">"))
+        node->op = Op::GT;
+      else
+        return nullptr;
+
+      return this->Constant(node) ? std::move(node) : nullptr;
+    }
+
+    /// \brief Parse the constant of a comparison.
+    /// \param[in, out] _node The comparison.
+    /// \return False on a syntax error.
+    private: bool Constant(Node &_node)
+    {
+      using Value = ContentFilter::Node::Value;
+      this->SkipSpaces();
+      if (this->pos >= this->text.size())
+        return false;
+
+      const char c = this->text[this->pos];
+      if (c == '\'' || c == '"')
+      {
+        const std::size_t end = this->text.find(c, this->pos + 1);
+        if (end == std::string::npos)
+          return false;
+        _node->value = Value::STRING;
+        _node->text = this->text.substr(this->pos + 1, end - this->pos - 1);
+        this->pos = end + 1;
+        return true;
+      }
+
+      const char *start = this->text.c_str() + this->pos;
+      char *end = nullptr;
+      const double number = std::strtod(start, &end);
+      if (end != start)
+      {
+        _node->value = Value::NUMBER;
+        _node->number = number;
+        this->pos += static_cast<std::size_t>(end - start);
+        return true;
+      }
+
+      std::string name;
+      if (!this->Name(name))
+        return false;
+      if (name == "true" || name == "false")
+      {
+        _node->value = Value::BOOL;
+        _node->number = name == "true" ? 1 : 0;
+      }
+      else
+      {
+        _node->value = Value::NAME;
+        _node->text = name;
+      }
+      return true;
+    }
+
+    /// \brief The expression.
+    private: const std::string &text;
+
+    /// \brief Position of the next character.
+    private: std::size_t pos = 0;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Apply a comparison operator.
+  /// \param[in] _op The operator.
+  /// \param[in] _a Left operand.
+  /// \param[in] _b Right operand.
+  /// \return The result.
+  template<typename T>
+  bool apply(ContentFilter::Node::Op _op, const T &_a, const T &_b)
+  {
+    using Op = ContentFilter::Node::Op;
+    switch (_op)
+    {
+      // The function objects keep -Wfloat-equal quiet; comparing doubles
+      // exactly is what the filter asks for.
+      case Op::EQ: return std::equal_to<>{}(_a, _b);
+      case Op::NE: return std::not_equal_to<>{}(_a, _b);
+      case Op::LT: return _a < _b;
+      case Op::LE: return _a <= _b;
+      case Op::GT: return _a > _b;
+      case Op::GE: return _a >= _b;
+      default: return false;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Compare an element of a scalar field with the constant.
+  /// \param[in] _msg Message holding the field.
+  /// \param[in] _field The field.
+  /// \param[in] _index Index of the element, or -1 if it isn't repeated.
+  /// \param[in] _node The comparison.
+  /// \return The result.
+  bool compareScalar(const Message &_msg, const FieldDescriptor *_field,
+                     int _index, const ContentFilter::Node &_node)
+  {
+    using Value = ContentFilter::Node::Value;
+    const Reflection *ref = _msg.GetReflection();
+    const bool repeated = _index >= 0;
+    double number = 0;
+
+    switch (_field->cpp_type())
+    {
+      case FieldDescriptor::CPPTYPE_STRING:
+      {
+        if (_node.value != Value::STRING)
+          return false;
+        const std::string value = repeated ?
+          ref->GetRepeatedString(_msg, _field, _index) :
+          ref->GetString(_msg, _field);
+        return apply(_node.op, value, _node.text);
+      }
+      case FieldDescriptor::CPPTYPE_ENUM:
+      {
+        const auto *value = repeated ?
+          ref->GetRepeatedEnum(_msg, _field, _index) :
+          ref->GetEnum(_msg, _field);
+        if (_node.value == Value::NAME)
+          return apply(_node.op, value->name(), _node.text);
+        number = value->number();
+        break;
+      }
+      case FieldDescriptor::CPPTYPE_BOOL:
+        number = (repeated ? ref->GetRepeatedBool(_msg, _field, _index) :
+                             ref->GetBool(_msg, _field)) ? 1 : 0;
+        break;
+      case FieldDescriptor::CPPTYPE_INT32:
+        number = repeated ? ref->GetRepeatedInt32(_msg, _field, _index) :
+                            ref->GetInt32(_msg, _field);
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        number = static_cast<double>(repeated ?
+          ref->GetRepeatedInt64(_msg, _field, _index) :
+          ref->GetInt64(_msg, _field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        number = repeated ? ref->GetRepeatedUInt32(_msg, _field, _index) :
+                            ref->GetUInt32(_msg, _field);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        number = static_cast<double>(repeated ?
+          ref->GetRepeatedUInt64(_msg, _field, _index) :
+          ref->GetUInt64(_msg, _field));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        number = repeated ? ref->GetRepeatedFloat(_msg, _field, _index) :
+                            ref->GetFloat(_msg, _field);
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        number = repeated ? ref->GetRepeatedDouble(_msg, _field, _index) :
+                            ref->GetDouble(_msg, _field);
+        break;
+      default:
+        return false;
+    }
+
+    if (_node.value != Value::NUMBER && _node.value != Value::BOOL)
+      return false;
+    return apply(_node.op, number, _node.number);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Evaluate a comparison from a field of its path.
+  /// \param[in] _msg Message holding the field.
+  /// \param[in] _node The comparison.
+  /// \param[in] _depth Index of the field in the path.
+  /// \return True if the comparison holds for any element.
+  bool compare(const Message &_msg, const ContentFilter::Node &_node,
+               std::size_t _depth)
+  {
+    const Descriptor *desc = _msg.GetDescriptor();
+    const FieldDescriptor *field =
+      desc->FindFieldByName(_node.path[_depth]);
+    if (!field)
+      return false;
+
+    const Reflection *ref = _msg.GetReflection();
+    const bool last = _depth + 1 == _node.path.size();
+    const bool nested =
+      field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE;
+    if (last == nested)
+      return false;
+
+    if (!field->is_repeated())
+    {
+      if (nested)
+        return compare(ref->GetMessage(_msg, field), _node, _depth + 1);
+      return compareScalar(_msg, field, -1, _node);
+    }
+
+    const int size = ref->FieldSize(_msg, field);
+    for (int i = 0; i < size; ++i)
+    {
+      const bool match = nested ?
+        compare(ref->GetRepeatedMessage(_msg, field, i), _node, _depth + 1) :
+        compareScalar(_msg, field, i, _node);
+      if (match)
+        return true;
+    }
+    return false;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Evaluate a syntax tree.
+  /// \param[in] _msg The message.
+  /// \param[in] _node Root of the tree.
+  /// \return The result.
+  bool evaluate(const Message &_msg, const ContentFilter::Node &_node)
+  {
+    using Kind = ContentFilter::Node::Kind;
+    switch (_node.kind)
+    {
+      case Kind::AND:
+        for (const auto &child : _node.children)
+        {
+          if (!evaluate(_msg, *child))
+            return false;
+        }
+        return true;
+      case Kind::OR:
+        for (const auto &child : _node.children)
+        {
+          if (evaluate(_msg, *child))
+            return true;
+        }
+        return false;
+      case Kind::NOT:
+        return !evaluate(_msg, *_node.children.front());
+      case Kind::COMPARE:
+        return compare(_msg, _node, 0);
+      default:
+        return false;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+ContentFilter::ContentFilter(const std::string &_expression)
+  : expression(_expression),
+    root(Parser(this->expression).Parse())
+{
+}
+
+//////////////////////////////////////////////////
+ContentFilter::~ContentFilter() = default;
+
+//////////////////////////////////////////////////
+bool ContentFilter::Valid() const
+{
+  return this->root != nullptr;
+}
+
+//////////////////////////////////////////////////
+const std::string &ContentFilter::Expression() const
+{
+  return this->expression;
+}
+
+//////////////////////////////////////////////////
+bool ContentFilter::Matches(const Message &_msg) const
+{
+  return this->root && evaluate(_msg, *this->root);
+}
+
+//////////////////////////////////////////////////
+std::string ContentFilter::Any(const std::vector<std::string> &_expressions)
+{
+  if (_expressions.size() == 1)
+    return _expressions.front();
+
+  std::string res;
+  for (const auto &expression : _expressions)
+  {
+    if (!res.empty())
+      res += " || ";
+    res += "(" + expression + ")";
+  }
+  return res;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_CONTENTFILTER_HH_
+#define GZ_TRANSPORT_CONTENTFILTER_HH_
+
+#include <google/protobuf/message.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief A predicate over the fields of a message, see
+    /// SubscribeOptions::SetFilter.
+    ///
+    /// The expression compares fields with constants, e.g.
+    /// "confidence > 0.8 && header.frame_id == 'camera'". A field is a list
+    /// of field names separated by dots. The operators are ==, !=, <, <=, >
+    /// and >=, and the comparisons are combined with &&, || and ! and
+    /// grouped with parentheses. The constants are numbers, strings between
+    /// single or double quotes, true, false and the names of enum values.
+    /// A comparison through a repeated field holds if it holds for any
+    /// element. Unknown fields and comparisons between different kinds of
+    /// values never hold.
+    class GZ_TRANSPORT_VISIBLE ContentFilter
+    {
+      /// \brief Constructor.
+      /// \param[in] _expression The expression.
+      public: explicit ContentFilter(const std::string &_expression);
+
+      /// \brief Destructor.
+      public: ~ContentFilter();
+
+      /// \brief Whether the expression was parsed.
+      /// \return False if the expression has a syntax error.
+      public: bool Valid() const;
+
+      /// \brief Get the expression.
+      /// \return The expression passed to the constructor.
+      public: const std::string &Expression() const;
+
+      /// \brief Evaluate the predicate.
+      /// \param[in] _msg The message.
+      /// \return True if the message matches, or false if it doesn't or
+      /// the expression isn't valid.
+      public: bool Matches(const google::protobuf::Message &_msg) const;
+
+      /// \brief Combine expressions into one that matches the messages
+      /// matching any of them.
+      /// \param[in] _expressions The expressions.
+      /// \return The combined expression.
+      public: static std::string Any(
+                const std::vector<std::string> &_expressions);
+
+      /// \brief A node of the syntax tree, defined in the source file.
+      public: struct Node;
+
+      /// \brief The expression.
+      private: std::string expression;
+
+      /// \brief Root of the syntax tree, or nullptr if the expression isn't
+      /// valid.
+      private: std::unique_ptr<Node> root;
+    };
+    }
+  }
+}
+#endif
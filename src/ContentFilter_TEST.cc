@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/entity.pb.h>
+#include <gz/msgs/vector3d.pb.h>
+
+#include <string>
+
+#include "ContentFilter.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Compare scalar fields with constants.
+TEST(ContentFilterTest, Compare)
+{
+  msgs::Vector3d msg;
+  msg.set_x(1.5);
+  msg.set_y(-2);
+
+  EXPECT_TRUE(ContentFilter("x > 1").Matches(msg));
+  EXPECT_TRUE(ContentFilter("x == 1.5").Matches(msg));
+  EXPECT_FALSE(ContentFilter("x < 1.5").Matches(msg));
+  EXPECT_TRUE(ContentFilter("x <= 1.5").Matches(msg));
+  EXPECT_TRUE(ContentFilter("y != 0 && y >= -2").Matches(msg));
+  EXPECT_TRUE(ContentFilter("x > 5 || y < 0").Matches(msg));
+  EXPECT_FALSE(ContentFilter("!(x > 1)").Matches(msg));
+  EXPECT_TRUE(ContentFilter("!x != 1.5").Matches(msg));
+  EXPECT_TRUE(ContentFilter("(x > 5 || y < 0) && z == 0").Matches(msg));
+
+  // Unknown fields and mismatched constants never match.
+  EXPECT_FALSE(ContentFilter("w == 0").Matches(msg));
+  EXPECT_FALSE(ContentFilter("x == 'a'").Matches(msg));
+  EXPECT_FALSE(ContentFilter("header == 0").Matches(msg));
+
+  msgs::Entity entity;
+  entity.set_name("box");
+  entity.set_id(7);
+  entity.set_type(msgs::Entity::MODEL);
+  EXPECT_TRUE(ContentFilter("name == 'box'").Matches(entity));
+  EXPECT_TRUE(ContentFilter("name == \"box\"").Matches(entity));
+  EXPECT_TRUE(ContentFilter("name < 'c'").Matches(entity));
+  EXPECT_FALSE(ContentFilter("name == 7").Matches(entity));
+  EXPECT_TRUE(ContentFilter("type == MODEL").Matches(entity));
+  EXPECT_TRUE(ContentFilter("type == 2").Matches(entity));
+  EXPECT_TRUE(ContentFilter("type != LIGHT && id >= 7").Matches(entity));
+}
+
+//////////////////////////////////////////////////
+/// \brief Nested and repeated fields.
+TEST(ContentFilterTest, Nested)
+{
+  msgs::Vector3d msg;
+  msg.mutable_header()->mutable_stamp()->set_sec(10);
+  auto *data = msg.mutable_header()->add_data();
+  data->set_key("frame_id");
+  data->add_value("camera");
+  data->add_value("base");
+
+  EXPECT_TRUE(ContentFilter("header.stamp.sec == 10").Matches(msg));
+  EXPECT_FALSE(ContentFilter("header.stamp.nsec > 0").Matches(msg));
+  EXPECT_TRUE(ContentFilter("header.data.value == 'base'").Matches(msg));
+  EXPECT_TRUE(ContentFilter(
+    "header.data.key == 'frame_id' && header.data.value == 'camera'")
+    .Matches(msg));
+  EXPECT_FALSE(ContentFilter("header.data.value == 'world'").Matches(msg));
+  EXPECT_FALSE(ContentFilter("header.stamp == 10").Matches(msg));
+}
+
+//////////////////////////////////////////////////
+/// \brief Syntax errors and combined expressions.
+TEST(ContentFilterTest, Syntax)
+{
+  for (const std::string expression :
+       {"", "x", "x >", "x > 1 &&", "(x > 1", "x > 'a", "1 > x", "x = 1",
+        "x > 1 y"})
+  {
+    ContentFilter filter(expression);
+    EXPECT_FALSE(filter.Valid()) << expression;
+    EXPECT_FALSE(filter.Matches(msgs::Vector3d())) << expression;
+  }
+
+  ContentFilter valid(" x>1&&y<2 ");
+  EXPECT_TRUE(valid.Valid());
+  EXPECT_EQ(" x>1&&y<2 ", valid.Expression());
+
+  EXPECT_EQ("x > 1", ContentFilter::Any({"x > 1"}));
+  const std::string any = ContentFilter::Any({"x > 1", "y > 1 || z > 1"});
+  EXPECT_EQ("(x > 1) || (y > 1 || z > 1)", any);
+
+  msgs::Vector3d msg;
+  msg.set_z(2);
+  EXPECT_TRUE(ContentFilter(any).Matches(msg));
+}
@@ -65,6 +65,35 @@ inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
     // Return if we got a reply.
     return items[0].revents & ZMQ_POLLIN;
   }
+
+  /////////////////////////////////////////////////
+  bool pollSockets(const std::vector<int> &_sockets, const int _timeout,
+                   std::vector<bool> &_readable)
+  {
+    std::vector<zmq::pollitem_t> items;
+    for (const auto &sock : _sockets)
+      items.push_back({0, static_cast<ZMQ_FD_T>(sock), ZMQ_POLLIN, 0});
+
+    _readable.assign(_sockets.size(), false);
+
+    try
+    {
+      zmq::poll(items.data(), items.size(),
+          std::chrono::milliseconds(_timeout));
+    }
+    catch(...)
+    {
+      return false;
+    }
+
+    bool any = false;
+    for (std::size_t i = 0; i < items.size(); ++i)
+    {
+      _readable[i] = items[i].revents & ZMQ_POLLIN;
+      any = any || _readable[i];
+    }
+    return any;
+  }
 }
 }
 }
@@ -0,0 +1,657 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/msgs/discovery.pb.h>
+
+#include "gz/transport/Discovery.hh"
+#include "gz/transport/DiscoveryServer.hh"
+#include "gz/transport/Publisher.hh"
+#include "gz/transport/TopicStorage.hh"
+#include "gz/transport/Uuid.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace gz
+{
+  namespace transport
+  {
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+    {
+    /// \internal
+    /// \brief Serves the discovery of one kind of publisher (messages or
+    /// services) on one port.
+    template<typename Pub>
+    class DiscoveryServerChannel
+    {
+      /// \brief Clock used to track the processes.
+      private: using Timestamp = std::chrono::steady_clock::time_point;
+
+      /// \brief A process connected to the server.
+      private: struct Client
+      {
+        /// \brief Address where the process receives the discovery messages.
+        sockaddr_in addr;
+
+        /// \brief IP address of the process.
+        std::string ip;
+
+        /// \brief Wire protocol version used by the process.
+        uint32_t version = 0;
+
+        /// \brief Last time that we heard from the process.
+        Timestamp lastSeen;
+      };
+
+      /// \brief Constructor.
+      /// \param[in] _sUuid UUID of the server.
+      /// \param[in] _port UDP port to serve.
+      /// \param[in] _verbose Whether to print the discovery activity.
+      public: DiscoveryServerChannel(const std::string &_sUuid,
+                                     const int _port, const bool _verbose)
+        : sUuid(_sUuid),
+          port(_port),
+          verbose(_verbose)
+      {
+      }
+
+      /// \brief Destructor.
+      public: ~DiscoveryServerChannel()
+      {
+        this->Close();
+      }
+
+      /// \brief Bind the socket.
+      /// \return True on success.
+      public: bool Open()
+      {
+        this->sock = static_cast<int>(socket(AF_INET, SOCK_DGRAM, 0));
+        if (this->sock < 0)
+        {
+          std::cerr << "DiscoveryServer: Socket creation failed." << std::endl;
+          return false;
+        }
+
+        sockaddr_in localAddr;
+        memset(&localAddr, 0, sizeof(localAddr));
+        localAddr.sin_family = AF_INET;
+        localAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+        localAddr.sin_port = htons(static_cast<u_short>(this->port));
+
+        if (bind(this->sock, reinterpret_cast<sockaddr *>(&localAddr),
+              sizeof(localAddr)) < 0)
+        {
+          std::cerr << "DiscoveryServer: Binding to port [" << this->port
+                    << "] failed." << std::endl;
+          this->Close();
+          return false;
+        }
+
+        return true;
+      }
+
+      /// \brief Close the socket and forget the processes.
+      public: void Close()
+      {
+        if (this->sock >= 0)
+        {
+#ifdef _WIN32
+          closesocket(this->sock);
+#else
+          close(this->sock);
+#endif
+          this->sock = -1;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->clients.clear();
+        this->info.Clear();
+      }
+
+      /// \brief Serve until _exit becomes true.
+      /// \param[in] _exit Flag checked between the iterations.
+      public: void Run(const std::atomic<bool> &_exit)
+      {
+        this->timeNextHeartbeat = std::chrono::steady_clock::now();
+        const std::vector<int> sockets = {this->sock};
+        while (!_exit)
+        {
+          if (pollSockets(sockets, kPollTimeout))
+            this->Recv();
+
+          this->Update();
+        }
+      }
+
+      /// \brief Number of processes connected.
+      /// \return The number of processes.
+      public: std::size_t ClientCount() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->clients.size();
+      }
+
+      /// \brief Receive and handle one datagram.
+      private: void Recv()
+      {
+        char rcvStr[kMaxRcvStr];
+        sockaddr_in clntAddr;
+        socklen_t addrLen = sizeof(clntAddr);
+
+        int64_t received = recvfrom(this->sock,
+          reinterpret_cast<raw_type *>(rcvStr), kMaxRcvStr, 0,
+          reinterpret_cast<sockaddr *>(&clntAddr), &addrLen);
+        if (received <= 0)
+          return;
+
+        // Same framing as Discovery::RecvDiscoveryUpdate(), the datagram may
+        // contain a batch of messages.
+        std::vector<msgs::Discovery> batch;
+        int64_t offset = 0;
+        while (offset + static_cast<int64_t>(sizeof(uint16_t)) <= received)
+        {
+          uint16_t len = 0;
+          memcpy(&len, &rcvStr[offset], sizeof(len));
+          offset += sizeof(len);
+          if (offset + len > received)
+            break;
+
+          batch.emplace_back();
+          if (!batch.back().ParseFromArray(rcvStr + offset, len))
+            return;
+          offset += len;
+        }
+
+        if (offset != received)
+          return;
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto &msg : batch)
+          this->Handle(msg, clntAddr);
+      }
+
+      /// \brief Handle a discovery message. Must be called with the mutex
+      /// locked.
+      /// \param[in, out] _msg The message. It may be updated before being
+      /// forwarded.
+      /// \param[in] _clntAddr Address of the sender.
+      private: void Handle(msgs::Discovery &_msg, const sockaddr_in &_clntAddr)
+      {
+        msgs::Discovery &msg = _msg;
+        const std::string pUuid = msg.process_uuid();
+        if (pUuid.empty() || pUuid == this->sUuid)
+          return;
+
+        auto it = this->clients.find(pUuid);
+        const bool isNew = it == this->clients.end();
+        if (isNew)
+        {
+          if (msg.type() == msgs::Discovery::BYE)
+            return;
+          it = this->clients.emplace(pUuid, Client()).first;
+        }
+
+        Client &client = it->second;
+        client.addr = _clntAddr;
+        client.ip = inet_ntoa(_clntAddr.sin_addr);
+        client.version = msg.version();
+        client.lastSeen = std::chrono::steady_clock::now();
+
+        if (this->verbose)
+        {
+          std::cout << "DiscoveryServer: Received "
+                    << msgs::ToString(msg.type()) << " from [" << pUuid
+                    << "] at " << client.ip << std::endl;
+        }
+
+        if (isNew)
+        {
+          // Send everything we know to the new process and ask it for its
+          // publishers, in case the server restarted.
+          this->SendSnapshot(pUuid, "");
+          this->SendSyncRequest(pUuid);
+        }
+
+        // Tell the other processes where the message comes from.
+        std::string origin;
+        if (!HeaderValue(msg, Discovery<Pub>::kOriginKey, origin))
+          SetHeaderValue(msg, Discovery<Pub>::kOriginKey, client.ip);
+        msg.clear_flags();
+
+        switch (msg.type())
+        {
+          case msgs::Discovery::ADVERTISE:
+          {
+            Pub publisher;
+            publisher.SetFromDiscovery(msg);
+            if (publisher.Options().Scope() == Scope_t::PROCESS)
+              break;
+
+            // The periodic re-advertisements stop here.
+            if (this->info.AddPublisher(publisher))
+              this->SendToOthers(pUuid, msg);
+            break;
+          }
+          case msgs::Discovery::UNADVERTISE:
+          {
+            Pub publisher;
+            publisher.SetFromDiscovery(msg);
+            if (this->info.DelPublisherByNode(publisher.Topic(),
+                  publisher.PUuid(), publisher.NUuid()))
+            {
+              this->SendToOthers(pUuid, msg);
+            }
+            break;
+          }
+          case msgs::Discovery::SUBSCRIBE:
+          {
+            // We answer on behalf of the publishers.
+            if (msg.has_sub())
+              this->SendSnapshot(pUuid, msg.sub().topic());
+            break;
+          }
+          case msgs::Discovery::HEARTBEAT:
+          {
+            std::string target;
+            if (!HeaderValue(msg, Discovery<Pub>::kSyncKey, target))
+              break;
+
+            if (target == Discovery<Pub>::kSyncAll)
+            {
+              this->SendSnapshot(pUuid, "");
+            }
+            else
+            {
+              auto targetIt = this->clients.find(target);
+              if (targetIt != this->clients.end())
+                this->Send(msg, targetIt->second.addr);
+            }
+            break;
+          }
+          case msgs::Discovery::BYE:
+          {
+            this->info.DelPublishersByProc(pUuid);
+            this->clients.erase(pUuid);
+            this->SendToOthers(pUuid, msg);
+            break;
+          }
+          default:
+          {
+            // Connections and remote subscribers.
+            this->SendToOthers(pUuid, msg);
+            break;
+          }
+        }
+      }
+
+      /// \brief Send the heartbeats and drop the silent processes.
+      private: void Update()
+      {
+        const auto now = std::chrono::steady_clock::now();
+        if (now < this->timeNextHeartbeat)
+          return;
+
+        this->timeNextHeartbeat =
+          now + std::chrono::milliseconds(this->heartbeatInterval);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        for (auto it = this->clients.begin(); it != this->clients.end();)
+        {
+          if (now - it->second.lastSeen <
+                std::chrono::milliseconds(this->silenceInterval))
+          {
+            ++it;
+            continue;
+          }
+
+          if (this->verbose)
+          {
+            std::cout << "DiscoveryServer: [" << it->first << "] is gone"
+                      << std::endl;
+          }
+
+          msgs::Discovery bye;
+          bye.set_version(it->second.version);
+          bye.set_type(msgs::Discovery::BYE);
+          bye.set_process_uuid(it->first);
+          SetHeaderValue(bye, Discovery<Pub>::kOriginKey, it->second.ip);
+
+          const std::string pUuid = it->first;
+          this->info.DelPublishersByProc(pUuid);
+          it = this->clients.erase(it);
+          this->SendToOthers(pUuid, bye);
+        }
+
+        for (const auto &client : this->clients)
+        {
+          msgs::Discovery heartbeat;
+          heartbeat.set_version(client.second.version);
+          heartbeat.set_type(msgs::Discovery::HEARTBEAT);
+          heartbeat.set_process_uuid(this->sUuid);
+          SetHeaderValue(heartbeat, Discovery<Pub>::kServerKey, "1");
+          this->Send(heartbeat, client.second.addr);
+        }
+      }
+
+      /// \brief Advertise the publishers of the other processes to a
+      /// process. Must be called with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the destination.
+      /// \param[in] _topic Topic to advertise, or empty for all the topics.
+      private: void SendSnapshot(const std::string &_pUuid,
+                                 const std::string &_topic)
+      {
+        const Client &dest = this->clients.at(_pUuid);
+
+        std::vector<std::string> topics;
+        if (_topic.empty())
+          this->info.TopicList(topics);
+        else
+          topics.push_back(_topic);
+
+        for (const auto &topic : topics)
+        {
+          std::map<std::string, std::vector<Pub>> addresses;
+          if (!this->info.Publishers(topic, addresses))
+            continue;
+
+          for (const auto &proc : addresses)
+          {
+            auto owner = this->clients.find(proc.first);
+            if (proc.first == _pUuid || owner == this->clients.end())
+              continue;
+
+            for (const auto &publisher : proc.second)
+            {
+              msgs::Discovery msg;
+              msg.set_version(dest.version);
+              msg.set_type(msgs::Discovery::ADVERTISE);
+              msg.set_process_uuid(proc.first);
+              publisher.FillDiscovery(msg);
+              SetHeaderValue(msg, Discovery<Pub>::kOriginKey,
+                owner->second.ip);
+              this->Send(msg, dest.addr);
+            }
+          }
+        }
+      }
+
+      /// \brief Ask a process to re-advertise its publishers. Must be called
+      /// with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the destination.
+      private: void SendSyncRequest(const std::string &_pUuid)
+      {
+        const Client &dest = this->clients.at(_pUuid);
+
+        msgs::Discovery msg;
+        msg.set_version(dest.version);
+        msg.set_type(msgs::Discovery::HEARTBEAT);
+        msg.set_process_uuid(this->sUuid);
+        SetHeaderValue(msg, Discovery<Pub>::kSyncKey, _pUuid);
+        this->Send(msg, dest.addr);
+      }
+
+      /// \brief Forward a message to all the processes but its sender. Must
+      /// be called with the mutex locked.
+      /// \param[in] _pUuid Process UUID of the sender.
+      /// \param[in] _msg Message to forward.
+      private: void SendToOthers(const std::string &_pUuid,
+                                 const msgs::Discovery &_msg)
+      {
+        for (const auto &client : this->clients)
+        {
+          if (client.first != _pUuid)
+            this->Send(_msg, client.second.addr);
+        }
+      }
+
+      /// \brief Send a discovery message to a process.
+      /// \param[in] _msg Message to send.
+      /// \param[in] _addr Address of the process.
+      private: void Send(const msgs::Discovery &_msg,
+                         const sockaddr_in &_addr) const
+      {
+        const std::size_t msgSize = _msg.ByteSizeLong();
+        const uint16_t size = static_cast<uint16_t>(msgSize);
+        if (msgSize + sizeof(size) > kMaxRcvStr)
+        {
+          std::cerr << "DiscoveryServer: Discovery message too large to send."
+                    << std::endl;
+          return;
+        }
+
+        std::vector<char> buffer(sizeof(size) + msgSize);
+        memcpy(buffer.data(), &size, sizeof(size));
+        if (!_msg.SerializeToArray(buffer.data() + sizeof(size), size))
+        {
+          std::cerr << "DiscoveryServer: Error serializing data."
+                    << std::endl;
+          return;
+        }
+
+        auto sent = sendto(this->sock,
+          reinterpret_cast<const raw_type *>(buffer.data()),
+          static_cast<int>(buffer.size()), 0,
+          reinterpret_cast<const sockaddr *>(&_addr), sizeof(_addr));
+        if (sent != static_cast<decltype(sent)>(buffer.size()))
+        {
+          std::cerr << "DiscoveryServer: Error sending a message: "
+                    << strerror(errno) << std::endl;
+        }
+      }
+
+      /// \brief Get a value of the header data of a discovery message.
+      /// \param[in] _msg Discovery message.
+      /// \param[in] _key Key of the header data.
+      /// \param[out] _value First value of the key.
+      /// \return True if the key was found.
+      private: static bool HeaderValue(const msgs::Discovery &_msg,
+                                       const std::string &_key,
+                                       std::string &_value)
+      {
+        for (const auto &data : _msg.header().data())
+        {
+          if (data.key() == _key && data.value_size() > 0)
+          {
+            _value = data.value(0);
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /// \brief Set a value of the header data of a discovery message.
+      /// \param[in, out] _msg Discovery message.
+      /// \param[in] _key Key of the header data.
+      /// \param[in] _value The value.
+      private: static void SetHeaderValue(msgs::Discovery &_msg,
+                                          const std::string &_key,
+                                          const std::string &_value)
+      {
+        auto *data = _msg.mutable_header()->add_data();
+        data->set_key(_key);
+        data->add_value(_value);
+      }
+
+      /// \brief Maximum time blocked in the socket (ms.).
+      private: static const int kPollTimeout = 250;
+
+      /// \brief Size of the reception buffer, as in Discovery.
+      private: static const std::size_t kMaxRcvStr = 65536;
+
+      /// \brief UUID of the server.
+      private: std::string sUuid;
+
+      /// \brief UDP port served.
+      private: int port;
+
+      /// \brief Whether to print the discovery activity.
+      private: bool verbose;
+
+      /// \brief Socket, or -1 when closed.
+      private: int sock = -1;
+
+      /// \brief Interval between heartbeats (ms.).
+      public: unsigned int heartbeatInterval = 1000;
+
+      /// \brief Time after which a silent process is gone (ms.).
+      public: unsigned int silenceInterval = 3000;
+
+      /// \brief Time of the next heartbeat.
+      private: Timestamp timeNextHeartbeat;
+
+      /// \brief Connected processes, indexed by process UUID.
+      private: std::map<std::string, Client> clients;
+
+      /// \brief Publishers of all the connected processes.
+      private: TopicStorage<Pub> info;
+
+      /// \brief Protect the clients and the publishers.
+      private: mutable std::mutex mutex;
+    };
+
+    /// \internal
+    /// \brief Private data for DiscoveryServer class.
+    class DiscoveryServerPrivate
+    {
+      /// \brief Constructor.
+      /// \param[in] _msgPort UDP port used for message discovery.
+      /// \param[in] _srvPort UDP port used for service discovery.
+      /// \param[in] _verbose Whether to print the discovery activity.
+      public: DiscoveryServerPrivate(const int _msgPort, const int _srvPort,
+                                     const bool _verbose)
+        : sUuid(Uuid().ToString()),
+          msgChannel(sUuid, _msgPort, _verbose),
+          srvChannel(sUuid, _srvPort, _verbose)
+      {
+      }
+
+      /// \brief UUID of the server.
+      public: std::string sUuid;
+
+      /// \brief Message discovery.
+      public: DiscoveryServerChannel<MessagePublisher> msgChannel;
+
+      /// \brief Service discovery.
+      public: DiscoveryServerChannel<ServicePublisher> srvChannel;
+
+      /// \brief Thread serving the message discovery.
+      public: std::thread msgThread;
+
+      /// \brief Thread serving the service discovery.
+      public: std::thread srvThread;
+
+      /// \brief Tell the threads to exit.
+      public: std::atomic<bool> exit{false};
+
+      /// \brief Whether the server is running.
+      public: bool running = false;
+    };
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+DiscoveryServer::DiscoveryServer(const int _msgPort, const int _srvPort,
+  const bool _verbose)
+  : dataPtr(new DiscoveryServerPrivate(_msgPort, _srvPort, _verbose))
+{
+}
+
+//////////////////////////////////////////////////
+DiscoveryServer::~DiscoveryServer()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+bool DiscoveryServer::Start()
+{
+  if (this->dataPtr->running)
+    return false;
+
+  if (!this->dataPtr->msgChannel.Open())
+    return false;
+
+  if (!this->dataPtr->srvChannel.Open())
+  {
+    this->dataPtr->msgChannel.Close();
+    return false;
+  }
+
+  this->dataPtr->exit = false;
+  this->dataPtr->msgThread = std::thread(
+    &DiscoveryServerChannel<MessagePublisher>::Run,
+    &this->dataPtr->msgChannel, std::cref(this->dataPtr->exit));
+  this->dataPtr->srvThread = std::thread(
+    &DiscoveryServerChannel<ServicePublisher>::Run,
+    &this->dataPtr->srvChannel, std::cref(this->dataPtr->exit));
+  this->dataPtr->running = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void DiscoveryServer::Stop()
+{
+  if (!this->dataPtr->running)
+    return;
+
+  this->dataPtr->exit = true;
+  if (this->dataPtr->msgThread.joinable())
+    this->dataPtr->msgThread.join();
+  if (this->dataPtr->srvThread.joinable())
+    this->dataPtr->srvThread.join();
+
+  this->dataPtr->msgChannel.Close();
+  this->dataPtr->srvChannel.Close();
+  this->dataPtr->running = false;
+}
+
+//////////////////////////////////////////////////
+void DiscoveryServer::SetHeartbeatInterval(const unsigned int _ms)
+{
+  this->dataPtr->msgChannel.heartbeatInterval = _ms;
+  this->dataPtr->srvChannel.heartbeatInterval = _ms;
+}
+
+//////////////////////////////////////////////////
+void DiscoveryServer::SetSilenceInterval(const unsigned int _ms)
+{
+  this->dataPtr->msgChannel.silenceInterval = _ms;
+  this->dataPtr->srvChannel.silenceInterval = _ms;
+}
+
+//////////////////////////////////////////////////
+std::size_t DiscoveryServer::MsgClientCount() const
+{
+  return this->dataPtr->msgChannel.ClientCount();
+}
+
+//////////////////////////////////////////////////
+std::size_t DiscoveryServer::SrvClientCount() const
+{
+  return this->dataPtr->srvChannel.ClientCount();
+}
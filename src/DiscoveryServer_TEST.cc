@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/Discovery.hh"
+#include "gz/transport/DiscoveryServer.hh"
+#include "gz/transport/Publisher.hh"
+#include "gz/transport/TransportTypes.hh"
+#include "gz/transport/Uuid.hh"
+
+#include "test_utils.hh"
+#include "gtest/gtest.h"
+#include "gz/utils/Environment.hh"
+
+using namespace gz;
+using namespace transport;
+
+// Global variables used for multiple tests.
+static const int g_msgPort    = 11421;
+static const int g_srvPort    = 11422;
+static const std::string g_ip = "224.0.0.7"; // NOLINT(*)
+static std::string g_topic = testing::getRandomNumber(); // NOLINT(*)
+static std::string addr1   = "tcp://127.0.0.1:12345"; // NOLINT(*)
+static std::string ctrl1   = "tcp://127.0.0.1:12346"; // NOLINT(*)
+static std::string pUuid1  = Uuid().ToString(); // NOLINT(*)
+static std::string nUuid1  = Uuid().ToString(); // NOLINT(*)
+static std::string pUuid2  = Uuid().ToString(); // NOLINT(*)
+static std::string pUuid3  = Uuid().ToString(); // NOLINT(*)
+static std::atomic<int> g_connections{0};
+static std::atomic<int> g_disconnections{0};
+
+//////////////////////////////////////////////////
+/// \brief Wait until a condition is true or 2 seconds elapsed.
+template<typename F>
+bool waitFor(F _cond)
+{
+  for (int i = 0; i < 200 && !_cond(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return _cond();
+}
+
+//////////////////////////////////////////////////
+/// \brief Count the connections to the publisher of pUuid1.
+void onConnection(const MessagePublisher &_publisher)
+{
+  if (_publisher.PUuid() == pUuid1 && _publisher.Addr() == addr1)
+    ++g_connections;
+}
+
+//////////////////////////////////////////////////
+/// \brief Count the disconnections of pUuid1.
+void onDisconnection(const MessagePublisher &_publisher)
+{
+  if (_publisher.PUuid() == pUuid1)
+    ++g_disconnections;
+}
+
+//////////////////////////////////////////////////
+/// \brief Fixture that points the discovery to a local server.
+class DiscoveryServerTest : public ::testing::Test
+{
+  // Documentation inherited.
+  protected: void SetUp() override
+  {
+    ASSERT_TRUE(gz::utils::setenv("GZ_DISCOVERY_SERVER", "127.0.0.1"));
+    g_connections = 0;
+    g_disconnections = 0;
+  }
+
+  // Documentation inherited.
+  protected: void TearDown() override
+  {
+    ASSERT_TRUE(gz::utils::unsetenv("GZ_DISCOVERY_SERVER"));
+  }
+};
+
+//////////////////////////////////////////////////
+/// \brief Check starting and stopping the server.
+TEST_F(DiscoveryServerTest, StartStop)
+{
+  DiscoveryServer server(g_msgPort, g_srvPort);
+  EXPECT_TRUE(server.Start());
+  EXPECT_FALSE(server.Start());
+  EXPECT_EQ(0u, server.MsgClientCount());
+  EXPECT_EQ(0u, server.SrvClientCount());
+
+  // The ports are taken.
+  DiscoveryServer other(g_msgPort, g_srvPort);
+  EXPECT_FALSE(other.Start());
+
+  server.Stop();
+  EXPECT_TRUE(other.Start());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the server forwards the advertisements, answers the
+/// late processes and says goodbye on behalf of the processes.
+TEST_F(DiscoveryServerTest, PubSub)
+{
+  DiscoveryServer server(g_msgPort, g_srvPort);
+  ASSERT_TRUE(server.Start());
+
+  auto discovery1 = std::make_unique<Discovery<MessagePublisher>>(
+    pUuid1, g_ip, g_msgPort);
+  EXPECT_TRUE(discovery1->ServerMode());
+  discovery1->Start();
+
+  Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  EXPECT_TRUE(discovery2.ServerMode());
+  discovery2.ConnectionsCb(onConnection);
+  discovery2.DisconnectionsCb(onDisconnection);
+  discovery2.Start();
+
+  EXPECT_TRUE(waitFor([&]{return server.MsgClientCount() == 2u;}));
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "type",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1->Advertise(publisher));
+  EXPECT_TRUE(waitFor([]{return g_connections == 1;}));
+
+  // A late process learns the publisher from the server.
+  Discovery<MessagePublisher> discovery3(pUuid3, g_ip, g_msgPort);
+  discovery3.ConnectionsCb(onConnection);
+  discovery3.Start();
+  EXPECT_TRUE(waitFor([]{return g_connections == 2;}));
+
+  // The known publishers are reported right away by Discover().
+  g_connections = 0;
+  EXPECT_TRUE(discovery3.Discover(g_topic));
+  EXPECT_EQ(1, g_connections);
+
+  // The server says goodbye for the processes that leave.
+  discovery1.reset();
+  EXPECT_TRUE(waitFor([]{return g_disconnections == 1;}));
+  Addresses_M<MessagePublisher> addresses;
+  EXPECT_FALSE(discovery2.Publishers(g_topic, addresses));
+  EXPECT_TRUE(waitFor([&]{return server.MsgClientCount() == 2u;}));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the server drops the silent processes.
+TEST_F(DiscoveryServerTest, Silence)
+{
+  DiscoveryServer server(g_msgPort, g_srvPort);
+  server.SetHeartbeatInterval(100);
+  server.SetSilenceInterval(500);
+  ASSERT_TRUE(server.Start());
+
+  Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  discovery1.SetHeartbeatInterval(5000);
+  discovery1.Start();
+
+  Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  discovery2.SetHeartbeatInterval(100);
+  discovery2.DisconnectionsCb(onDisconnection);
+  discovery2.Start();
+
+  EXPECT_TRUE(waitFor([&]{return server.MsgClientCount() == 2u;}));
+  EXPECT_TRUE(waitFor([]{return g_disconnections == 1;}));
+  EXPECT_EQ(1u, server.MsgClientCount());
+}
@@ -16,11 +16,15 @@
 */
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "gz/transport/AdvertiseOptions.hh"
 #include "gz/transport/Discovery.hh"
@@ -183,6 +187,33 @@ TEST(DiscoveryTest, WithoutCallingStart)
   EXPECT_FALSE(discovery.Unadvertise(service, nUuid1));
 }
 
+//////////////////////////////////////////////////
+/// \brief Register the publishers of the process before opening the sockets.
+TEST(DiscoveryTest, OpenLater)
+{
+  MsgDiscovery discovery(pUuid1, g_ip, g_msgPort, false, false);
+
+  AdvertiseMessageOptions processOpts;
+  processOpts.SetScope(Scope_t::PROCESS);
+  MessagePublisher local(g_topic, addr1, ctrl1, pUuid1, nUuid1, "t",
+    processOpts);
+  MessagePublisher remote("/topic2", addr1, ctrl1, pUuid1, nUuid1, "t",
+    AdvertiseMessageOptions());
+
+  EXPECT_TRUE(discovery.Advertise(local));
+  EXPECT_FALSE(discovery.Advertise(remote));
+  EXPECT_FALSE(discovery.Discover(g_topic));
+
+  MsgAddresses_M publishers;
+  EXPECT_TRUE(discovery.Publishers(g_topic, publishers));
+
+  // Start() opens the sockets.
+  discovery.Start();
+  EXPECT_TRUE(discovery.Advertise(remote));
+  EXPECT_TRUE(discovery.Unadvertise(g_topic, nUuid1));
+  EXPECT_TRUE(discovery.Unadvertise("/topic2", nUuid1));
+}
+
 //////////////////////////////////////////////////
 /// \brief Advertise a topic without registering callbacks.
 TEST(DiscoveryTest, TestAdvertiseNoResponse)
@@ -530,6 +561,336 @@ TEST(DiscoveryTest, TestActivity)
   discovery1.TestActivity(proc2Uuid, false);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that in delta mode a late peer gets the publishers of a
+/// process through a sync request, long before the next full refresh, and
+/// that the changes are still delivered.
+TEST(DiscoveryTest, TestDeltaMode)
+{
+  reset();
+
+  const unsigned int heartbeatInterval = 200;
+
+  transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  EXPECT_FALSE(discovery1.DeltaMode());
+  discovery1.SetDeltaMode(true);
+  EXPECT_TRUE(discovery1.DeltaMode());
+  discovery1.SetHeartbeatInterval(heartbeatInterval);
+  discovery1.Start();
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "type",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+
+  // Let the advertisement go before the second peer exists.
+  std::this_thread::sleep_for(std::chrono::milliseconds(heartbeatInterval));
+
+  transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  discovery2.SetDeltaMode(true);
+  discovery2.SetHeartbeatInterval(heartbeatInterval);
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+  discovery2.DisconnectionsCb(onDisconnection);
+  discovery2.Start();
+
+  // The next heartbeat of discovery1 triggers a sync. A full refresh would
+  // take 10 heartbeats.
+  waitForCallback(MaxIters, Nap, connectionExecuted);
+  EXPECT_TRUE(connectionExecuted);
+
+  // Changes are sent right away.
+  EXPECT_TRUE(discovery1.Unadvertise(g_topic, nUuid1));
+  waitForCallback(MaxIters, Nap, disconnectionExecuted);
+  EXPECT_TRUE(disconnectionExecuted);
+
+  Addresses_M<MessagePublisher> addresses;
+  EXPECT_FALSE(discovery2.Publishers(g_topic, addresses));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the adaptive heartbeats back off while the graph is
+/// stable without letting the peers expire, and that the changes are still
+/// delivered.
+TEST(DiscoveryTest, TestAdaptive)
+{
+  reset();
+
+  const unsigned int heartbeatInterval = 100;
+  const unsigned int silenceInterval = 300;
+
+  transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  EXPECT_FALSE(discovery1.Adaptive());
+  discovery1.SetAdaptive(true);
+  EXPECT_TRUE(discovery1.Adaptive());
+  discovery1.SetHeartbeatInterval(heartbeatInterval);
+  discovery1.SetSilenceInterval(silenceInterval);
+  discovery1.Start();
+
+  transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  discovery2.SetAdaptive(true);
+  discovery2.SetHeartbeatInterval(heartbeatInterval);
+  discovery2.SetSilenceInterval(silenceInterval);
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+  discovery2.DisconnectionsCb(onDisconnection);
+  discovery2.Start();
+
+  // The heartbeats end up much further apart than the silence interval,
+  // which is scaled for the peer.
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+    heartbeatInterval * 30));
+  EXPECT_FALSE(disconnectionExecuted);
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "type",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+  waitForCallback(MaxIters, Nap, connectionExecuted);
+  EXPECT_TRUE(connectionExecuted);
+  EXPECT_FALSE(disconnectionExecuted);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the fast start initializes the discovery and learns the
+/// existing publishers before the first heartbeats of the peers.
+TEST(DiscoveryTest, TestFastStart)
+{
+  reset();
+
+  // A slow peer that would take 3 seconds to re-advertise on its own.
+  transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  discovery1.SetHeartbeatInterval(3000);
+  discovery1.Start();
+
+  MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "type",
+    AdvertiseMessageOptions());
+  EXPECT_TRUE(discovery1.Advertise(publisher));
+
+  // Let the advertisement go before the second peer exists.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  EXPECT_FALSE(discovery2.FastStart());
+  discovery2.SetFastStart(true);
+  EXPECT_TRUE(discovery2.FastStart());
+  discovery2.ConnectionsCb(onDiscoveryResponse);
+
+  auto start = std::chrono::steady_clock::now();
+  discovery2.Start();
+  discovery2.WaitForInit();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // Without the fast start it takes two heartbeats (2 seconds).
+  EXPECT_LT(elapsed, std::chrono::milliseconds(1500));
+  EXPECT_TRUE(connectionExecuted);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the heartbeats of the processes on the same host
+/// don't produce a clock offset: they share the system clock.
+TEST(DiscoveryTest, TestClockOffset)
+{
+  reset();
+
+  transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  discovery1.SetHeartbeatInterval(100);
+  discovery2.SetHeartbeatInterval(100);
+  discovery1.Start();
+  discovery2.Start();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  std::chrono::microseconds offset{0};
+  EXPECT_FALSE(discovery1.ClockOffset(pUuid2, offset));
+  EXPECT_FALSE(discovery2.ClockOffset(pUuid1, offset));
+  EXPECT_FALSE(discovery1.ClockOffset("unknown", offset));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the publishers of the other processes survive a
+/// restart through the cache file.
+TEST(DiscoveryTest, TestCache)
+{
+  reset();
+
+  const std::string cacheFile =
+    ::testing::TempDir() + "gz_discovery_" + pUuid2 + ".cache";
+  const unsigned int heartbeatInterval = 100;
+
+  {
+    // Declared first so it says goodbye after discovery2 is gone.
+    transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip,
+      g_msgPort);
+    discovery1.SetHeartbeatInterval(heartbeatInterval);
+    discovery1.Start();
+
+    transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip,
+      g_msgPort);
+    discovery2.SetCacheFile(cacheFile);
+    EXPECT_EQ(cacheFile, discovery2.CacheFile());
+    discovery2.SetHeartbeatInterval(heartbeatInterval);
+    discovery2.ConnectionsCb(onDiscoveryResponse);
+    discovery2.Start();
+
+    MessagePublisher publisher(g_topic, addr1, ctrl1, pUuid1, nUuid1, "type",
+      AdvertiseMessageOptions());
+    EXPECT_TRUE(discovery1.Advertise(publisher));
+
+    waitForCallback(MaxIters, Nap, connectionExecuted);
+    ASSERT_TRUE(connectionExecuted);
+  }
+
+  reset();
+
+  // The restarted process knows the publisher before any network exchange.
+  transport::Discovery<MessagePublisher> discovery3(pUuid2, g_ip, g_msgPort);
+  discovery3.SetCacheFile(cacheFile);
+  discovery3.ConnectionsCb(onDiscoveryResponse);
+  discovery3.Start();
+  EXPECT_TRUE(connectionExecuted);
+
+  Addresses_M<MessagePublisher> addresses;
+  ASSERT_TRUE(discovery3.Publishers(g_topic, addresses));
+  ASSERT_EQ(1u, addresses.count(pUuid1));
+  EXPECT_EQ(addr1, addresses[pUuid1].front().Addr());
+
+  std::remove(cacheFile.c_str());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a batch of re-advertisements is received.
+TEST(DiscoveryTest, TestBatching)
+{
+  const unsigned int heartbeatInterval = 100;
+  const int kNumTopics = 500;
+
+  transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  EXPECT_FALSE(discovery1.Batching());
+  discovery1.SetBatching(true);
+  EXPECT_TRUE(discovery1.Batching());
+  discovery1.SetHeartbeatInterval(heartbeatInterval);
+  discovery1.Start();
+
+  for (int i = 0; i < kNumTopics; ++i)
+  {
+    MessagePublisher publisher(g_topic + std::to_string(i), addr1, ctrl1,
+      pUuid1, nUuid1, "type", AdvertiseMessageOptions());
+    EXPECT_TRUE(discovery1.Advertise(publisher));
+  }
+
+  // A late peer only gets the batched re-advertisements.
+  transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  discovery2.Start();
+
+  std::vector<std::string> topics;
+  for (int i = 0; i < MaxIters; ++i)
+  {
+    topics.clear();
+    discovery2.TopicList(topics);
+    if (topics.size() == static_cast<std::size_t>(kNumTopics))
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(Nap));
+  }
+  EXPECT_EQ(static_cast<std::size_t>(kNumTopics), topics.size());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the remote subscribers are requested once, and then
+/// kept up to date by their announcements.
+TEST(DiscoveryTest, TestRemoteSubscribers)
+{
+  std::atomic<int> requests{0};
+  transport::Discovery<MessagePublisher> discovery1(pUuid1, g_ip, g_msgPort);
+  discovery1.SubscribersCb([&requests]{++requests;});
+  discovery1.Start();
+
+  transport::Discovery<MessagePublisher> discovery2(pUuid2, g_ip, g_msgPort);
+  discovery2.Start();
+
+  const std::string topic = g_topic + "_sub";
+  MessagePublisher subscriber(topic, addr1, "", pUuid1, nUuid1, "type",
+    AdvertiseMessageOptions());
+
+  // The first call asks the peers for their subscribers.
+  std::vector<std::string> topics;
+  discovery2.TopicList(topics);
+  for (int i = 0; i < MaxIters && requests == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(Nap));
+  EXPECT_EQ(1, requests);
+
+  // A new subscriber is announced.
+  discovery1.SendSubscribersReps({subscriber});
+  MsgAddresses_M subscribers;
+  for (int i = 0; i < MaxIters &&
+       !discovery2.RemoteSubscribers(topic, subscribers); ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(Nap));
+  }
+  ASSERT_EQ(1u, subscribers.size());
+  EXPECT_EQ(nUuid1, subscribers.at(pUuid1).front().NUuid());
+
+  topics.clear();
+  discovery2.TopicList(topics);
+  EXPECT_NE(topics.end(), std::find(topics.begin(), topics.end(), topic));
+
+  // And so is its end.
+  discovery1.Unregister(subscriber);
+  for (int i = 0; i < MaxIters &&
+       discovery2.RemoteSubscribers(topic, subscribers); ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(Nap));
+  }
+  EXPECT_FALSE(discovery2.RemoteSubscribers(topic, subscribers));
+
+  // The following calls don't ask again.
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_EQ(1, requests);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the periodic re-advertisements respect the scope of the
+/// topics.
+TEST(DiscoveryTest, TestScopedReadvertise)
+{
+  const unsigned int heartbeatInterval = 100;
+
+  for (const bool batching : {false, true})
+  {
+    transport::Discovery<MessagePublisher> discovery1(
+      pUuid1, g_ip, g_msgPort);
+    discovery1.SetBatching(batching);
+    discovery1.SetHeartbeatInterval(heartbeatInterval);
+    discovery1.Start();
+
+    AdvertiseMessageOptions processOpts;
+    processOpts.SetScope(Scope_t::PROCESS);
+    AdvertiseMessageOptions hostOpts;
+    hostOpts.SetScope(Scope_t::HOST);
+    EXPECT_TRUE(discovery1.Advertise(MessagePublisher("/process", addr1,
+      ctrl1, pUuid1, nUuid1, "type", processOpts)));
+    EXPECT_TRUE(discovery1.Advertise(MessagePublisher("/host", addr1,
+      ctrl1, pUuid1, nUuid1, "type", hostOpts)));
+
+    // A late peer only gets the re-advertisements.
+    transport::Discovery<MessagePublisher> discovery2(
+      pUuid2, g_ip, g_msgPort);
+    discovery2.Start();
+
+    std::vector<std::string> topics;
+    for (int i = 0; i < MaxIters && topics.empty(); ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(Nap));
+      discovery2.TopicList(topics);
+    }
+
+    // Give a chance to the process scoped topic to show up.
+    std::this_thread::sleep_for(std::chrono::milliseconds(
+      2 * heartbeatInterval));
+    topics.clear();
+    discovery2.TopicList(topics);
+    ASSERT_EQ(1u, topics.size());
+    EXPECT_EQ("/host", topics.front());
+  }
+}
+
 //////////////////////////////////////////////////
 /// \brief Check that a wrong GZ_IP value makes HostAddr() to return 127.0.0.1
 TEST(DiscoveryTest, GZ_UTILS_TEST_DISABLED_ON_LINUX(WrongGzIp))
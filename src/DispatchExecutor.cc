@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <iostream>
+#include <utility>
+
+#include "DispatchExecutor.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+DispatchExecutor::DispatchExecutor(unsigned int _numThreads,
+    std::function<void()> _setup)
+{
+  if (_numThreads == 0)
+    _numThreads = 1;
+
+  for (unsigned int i = 0; i < _numThreads; ++i)
+  {
+    this->workers.emplace_back([this, _setup]()
+    {
+      if (_setup)
+        _setup();
+      this->Worker();
+    });
+  }
+}
+
+//////////////////////////////////////////////////
+DispatchExecutor::~DispatchExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    this->exit = true;
+  }
+  this->cv.notify_all();
+
+  for (auto &worker : this->workers)
+  {
+    if (worker.joinable())
+      worker.join();
+  }
+}
+
+//////////////////////////////////////////////////
+void DispatchExecutor::Post(const std::string &_key,
+    std::function<void()> _task)
+{
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    if (this->exit)
+      return;
+
+    auto &strand = this->strands[_key];
+    if (!strand)
+      strand = std::make_shared<Strand>();
+
+    strand->tasks.push_back(std::move(_task));
+
+    // The strand is already queued or being executed by a worker, which
+    // will pick up the new task when done.
+    if (strand->scheduled)
+      return;
+
+    strand->scheduled = true;
+    this->ready.push_back(strand);
+  }
+  this->cv.notify_one();
+}
+
+//////////////////////////////////////////////////
+std::size_t DispatchExecutor::NumThreads() const
+{
+  return this->workers.size();
+}
+
+//////////////////////////////////////////////////
+void DispatchExecutor::Worker()
+{
+  std::unique_lock<std::mutex> lk(this->mutex);
+  while (true)
+  {
+    this->cv.wait(lk, [this]{return this->exit || !this->ready.empty();});
+    if (this->exit)
+      return;
+
+    std::shared_ptr<Strand> strand = std::move(this->ready.front());
+    this->ready.pop_front();
+
+    std::function<void()> task = std::move(strand->tasks.front());
+    strand->tasks.pop_front();
+
+    lk.unlock();
+    try
+    {
+      task();
+    }
+    catch (...)
+    {
+      std::cerr << "DispatchExecutor: exception occurred in a task"
+                << std::endl;
+    }
+    task = nullptr;
+    lk.lock();
+
+    // Run one task per turn so the other strands get a chance to run.
+    if (!strand->tasks.empty())
+    {
+      this->ready.push_back(std::move(strand));
+      this->cv.notify_one();
+    }
+    else
+    {
+      strand->scheduled = false;
+    }
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_DISPATCHEXECUTOR_HH_
+#define GZ_TRANSPORT_DISPATCHEXECUTOR_HH_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Thread pool used to run local (intra-process) callbacks.
+    ///
+    /// Tasks are posted with an ordering key (e.g. the topic name). Tasks
+    /// sharing a key run one at a time and in the order posted, while tasks
+    /// with different keys run in parallel on any idle worker. Each key has
+    /// its own FIFO (a strand). Idle workers take the next runnable strand,
+    /// so a slow callback only delays its own key.
+    class DispatchExecutor
+    {
+      /// \brief Constructor.
+      /// \param[in] _numThreads Number of worker threads. At least one
+      /// worker is always created.
+      /// \param[in] _setup Function run by each worker when it starts, e.g.
+      /// to set its priority, or nullptr.
+      public: explicit DispatchExecutor(unsigned int _numThreads,
+                std::function<void()> _setup = nullptr);
+
+      /// \brief Destructor. Pending tasks are discarded and the workers are
+      /// joined.
+      public: ~DispatchExecutor();
+
+      /// \brief No copy.
+      public: DispatchExecutor(const DispatchExecutor &) = delete;
+
+      /// \brief No assignment.
+      public: DispatchExecutor &operator=(const DispatchExecutor &) = delete;
+
+      /// \brief Post a new task.
+      /// \param[in] _key Ordering key. Tasks with the same key are executed
+      /// sequentially in the order posted.
+      /// \param[in] _task Task to execute.
+      public: void Post(const std::string &_key, std::function<void()> _task);
+
+      /// \brief Get the number of worker threads.
+      /// \return Number of worker threads.
+      public: std::size_t NumThreads() const;
+
+      /// \brief Pending tasks for one ordering key.
+      private: struct Strand
+      {
+        /// \brief Tasks waiting to be executed.
+        std::deque<std::function<void()>> tasks;
+
+        /// \brief True if the strand is in the ready queue or running.
+        bool scheduled = false;
+      };
+
+      /// \brief Worker thread loop.
+      private: void Worker();
+
+      /// \brief Strands indexed by key.
+      private: std::unordered_map<std::string, std::shared_ptr<Strand>>
+                 strands;
+
+      /// \brief Strands with pending work, not being executed.
+      private: std::deque<std::shared_ptr<Strand>> ready;
+
+      /// \brief Protects strands and ready.
+      private: std::mutex mutex;
+
+      /// \brief Signals new ready strands or exit.
+      private: std::condition_variable cv;
+
+      /// \brief True when the workers should finish.
+      private: bool exit = false;
+
+      /// \brief Worker threads.
+      private: std::vector<std::thread> workers;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "FdChannel.hh"
+
+using namespace gz;
+using namespace transport;
+
+#ifndef _WIN32
+namespace
+{
+  /// \brief Fill the address of a channel. On Linux the socket lives in
+  /// the abstract namespace, so it disappears with the process; elsewhere
+  /// it is a file in the temporary directory.
+  /// \param[in] _name Name of the channel.
+  /// \param[out] _addr The address.
+  /// \param[out] _len Length of the address.
+  /// \param[out] _path Path of the socket file, or empty.
+  /// \return False if the name is too long.
+  bool address(const std::string &_name, sockaddr_un &_addr,
+    socklen_t &_len, std::string &_path)
+  {
+    memset(&_addr, 0, sizeof(_addr));
+    _addr.sun_family = AF_UNIX;
+#ifdef __linux__
+    if (_name.size() + 1 > sizeof(_addr.sun_path))
+      return false;
+    memcpy(_addr.sun_path + 1, _name.data(), _name.size());
+    _len = static_cast<socklen_t>(
+      offsetof(sockaddr_un, sun_path) + 1 + _name.size());
+    _path.clear();
+#else
+    _path = "/tmp/" + _name + ".sock";
+    if (_path.size() >= sizeof(_addr.sun_path))
+      return false;
+    memcpy(_addr.sun_path, _path.data(), _path.size());
+    _len = static_cast<socklen_t>(sizeof(_addr));
+#endif
+    return true;
+  }
+
+  /// \brief Create a local packet socket.
+  /// \return The socket or -1 on error.
+  int packetSocket()
+  {
+    const int sock = ::socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (sock >= 0)
+      fcntl(sock, F_SETFD, FD_CLOEXEC);
+    return sock;
+  }
+
+  /// \brief Make a socket non blocking.
+  /// \param[in] _sock The socket.
+  void nonBlocking(const int _sock)
+  {
+    fcntl(_sock, F_SETFL, fcntl(_sock, F_GETFL, 0) | O_NONBLOCK);
+  }
+
+  /// \brief First byte of every packet.
+  const char kPacketMarker = 'G';
+
+  /// \brief Flags of the packets sent, which never raise SIGPIPE.
+#ifdef MSG_NOSIGNAL
+  const int kSendFlags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+  const int kSendFlags = MSG_DONTWAIT;
+#endif
+}
+#endif
+
+//////////////////////////////////////////////////
+std::string FdChannel::Name(const std::string &_pUuid,
+    const std::string &_topic)
+{
+  std::ostringstream name;
+  name << "gz_fd_" << std::hex << std::setw(16) << std::setfill('0')
+       << static_cast<uint64_t>(std::hash<std::string>()(_pUuid + _topic));
+  return name.str();
+}
+
+//////////////////////////////////////////////////
+FdChannel::FdChannel(const int _socket, const std::string &_path)
+  : socket(_socket),
+    path(_path)
+{
+}
+
+//////////////////////////////////////////////////
+int FdChannel::Socket() const
+{
+  return this->socket;
+}
+
+//////////////////////////////////////////////////
+bool FdChannel::Closed() const
+{
+  return this->closed;
+}
+
+//////////////////////////////////////////////////
+std::size_t FdChannel::Subscribers() const
+{
+  return this->subscribers.size();
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+std::unique_ptr<FdChannel> FdChannel::Listen(const std::string &_name)
+{
+  sockaddr_un addr;
+  socklen_t len = 0;
+  std::string path;
+  if (!address(_name, addr, len, path))
+    return nullptr;
+
+  const int sock = packetSocket();
+  if (sock < 0)
+    return nullptr;
+
+  if (!path.empty())
+    unlink(path.c_str());
+
+  if (bind(sock, reinterpret_cast<sockaddr *>(&addr), len) != 0 ||
+      listen(sock, 16) != 0)
+  {
+    close(sock);
+    return nullptr;
+  }
+  nonBlocking(sock);
+
+  return std::unique_ptr<FdChannel>(new FdChannel(sock, path));
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<FdChannel> FdChannel::Connect(const std::string &_name)
+{
+  sockaddr_un addr;
+  socklen_t len = 0;
+  std::string path;
+  if (!address(_name, addr, len, path))
+    return nullptr;
+
+  const int sock = packetSocket();
+  if (sock < 0)
+    return nullptr;
+
+  if (connect(sock, reinterpret_cast<sockaddr *>(&addr), len) != 0)
+  {
+    close(sock);
+    return nullptr;
+  }
+  nonBlocking(sock);
+
+  return std::unique_ptr<FdChannel>(new FdChannel(sock, ""));
+}
+
+//////////////////////////////////////////////////
+FdChannel::~FdChannel()
+{
+  for (const int sub : this->subscribers)
+    close(sub);
+  if (this->socket >= 0)
+    close(this->socket);
+  if (!this->path.empty())
+    unlink(this->path.c_str());
+}
+
+//////////////////////////////////////////////////
+void FdChannel::Accept()
+{
+  while (true)
+  {
+    const int sub = accept(this->socket, nullptr, nullptr);
+    if (sub < 0)
+      return;
+    fcntl(sub, F_SETFD, FD_CLOEXEC);
+    nonBlocking(sub);
+    this->subscribers.push_back(sub);
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t FdChannel::Send(const std::string &_data, const int _fd)
+{
+  if (_data.size() > kMaxData)
+    return 0;
+
+  this->Accept();
+
+  // A packet can't be empty, so the metadata follows a marker byte.
+  char marker = kPacketMarker;
+  iovec iov[2];
+  iov[0].iov_base = &marker;
+  iov[0].iov_len = 1;
+  iov[1].iov_base = const_cast<char *>(_data.data());
+  iov[1].iov_len = _data.size();
+
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+  if (_fd >= 0)
+  {
+    memset(control, 0, sizeof(control));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &_fd, sizeof(int));
+  }
+
+  std::size_t sent = 0;
+  auto it = this->subscribers.begin();
+  while (it != this->subscribers.end())
+  {
+    if (sendmsg(*it, &msg, kSendFlags) >= 0)
+    {
+      ++sent;
+      ++it;
+      continue;
+    }
+
+    // A full socket only loses this packet.
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+    {
+      ++it;
+      continue;
+    }
+
+    close(*it);
+    it = this->subscribers.erase(it);
+  }
+  return sent;
+}
+
+//////////////////////////////////////////////////
+bool FdChannel::Receive(std::string &_data, int &_fd)
+{
+  _fd = -1;
+  if (this->closed)
+    return false;
+
+  _data.resize(kMaxData + 1);
+  iovec iov;
+  iov.iov_base = &_data[0];
+  iov.iov_len = _data.size();
+
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  int flags = MSG_DONTWAIT;
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+  const ssize_t size = recvmsg(this->socket, &msg, flags);
+  if (size <= 0)
+  {
+    if (size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+      this->closed = true;
+    _data.clear();
+    return false;
+  }
+
+  for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg))
+  {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len >= CMSG_LEN(sizeof(int)))
+    {
+      memcpy(&_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+  }
+
+  // Truncated and foreign packets are not delivered.
+  if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) ||
+      _data[0] != kPacketMarker)
+  {
+    if (_fd >= 0)
+      close(_fd);
+    _fd = -1;
+    _data.clear();
+    return false;
+  }
+
+  _data.resize(static_cast<std::size_t>(size));
+  _data.erase(0, 1);
+  return true;
+}
+#else
+//////////////////////////////////////////////////
+std::unique_ptr<FdChannel> FdChannel::Listen(const std::string &)
+{
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<FdChannel> FdChannel::Connect(const std::string &)
+{
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+FdChannel::~FdChannel()
+{
+}
+
+//////////////////////////////////////////////////
+void FdChannel::Accept()
+{
+}
+
+//////////////////////////////////////////////////
+std::size_t FdChannel::Send(const std::string &, const int)
+{
+  return 0;
+}
+
+//////////////////////////////////////////////////
+bool FdChannel::Receive(std::string &_data, int &_fd)
+{
+  _data.clear();
+  _fd = -1;
+  return false;
+}
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_FDCHANNEL_HH_
+#define GZ_TRANSPORT_FDCHANNEL_HH_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Local socket passing file descriptors, along with a few
+    /// bytes of metadata, between the processes of a host (SCM_RIGHTS), see
+    /// Node::Publisher::PublishFd.
+    ///
+    /// The publisher process listens on a socket named after its process
+    /// UUID and the topic, and every subscriber process connects to it.
+    /// Each packet carries the serialized metadata message and one
+    /// descriptor, which the receiver owns. All the operations are non
+    /// blocking. Channels are only available on POSIX systems; on other
+    /// platforms Listen() and Connect() always fail.
+    class GZ_TRANSPORT_VISIBLE FdChannel
+    {
+      /// \brief Maximum size of the metadata of a packet (bytes).
+      public: static constexpr std::size_t kMaxData = 64 * 1024;
+
+      /// \brief Listen for the subscribers of a topic.
+      /// \param[in] _name Name of the channel, see Name().
+      /// \return The channel or nullptr on error, e.g. if another channel
+      /// has the same name.
+      public: static std::unique_ptr<FdChannel> Listen(
+        const std::string &_name);
+
+      /// \brief Connect to the channel of a publisher.
+      /// \param[in] _name Name of the channel, see Name().
+      /// \return The channel or nullptr if nobody listens on this host.
+      public: static std::unique_ptr<FdChannel> Connect(
+        const std::string &_name);
+
+      /// \brief Name of the channel of a topic.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The name of the channel.
+      public: static std::string Name(const std::string &_pUuid,
+                                      const std::string &_topic);
+
+      /// \brief Destructor. Closes the sockets.
+      public: ~FdChannel();
+
+      /// \brief No copy.
+      public: FdChannel(const FdChannel &) = delete;
+
+      /// \brief No assignment.
+      public: FdChannel &operator=(const FdChannel &) = delete;
+
+      /// \brief Accept the pending subscribers and send a packet to all
+      /// of them. The subscribers that can't receive it (e.g. they exited
+      /// or their socket buffer is full) are dropped. Only valid on a
+      /// listening channel.
+      /// \param[in] _data The metadata, at most kMaxData bytes.
+      /// \param[in] _fd Descriptor duplicated into the subscribers. The
+      /// caller keeps ownership of it.
+      /// \return The number of subscribers that received the packet.
+      public: std::size_t Send(const std::string &_data, const int _fd);
+
+      /// \brief Receive the next packet. Only valid on a connected channel.
+      /// \param[out] _data The metadata.
+      /// \param[out] _fd The descriptor, owned by the caller, or -1 if the
+      /// packet doesn't carry one.
+      /// \return False if there is no packet, or the publisher closed the
+      /// channel, see Closed().
+      public: bool Receive(std::string &_data, int &_fd);
+
+      /// \brief Whether the publisher closed a connected channel.
+      /// \return True once the publisher is gone.
+      public: bool Closed() const;
+
+      /// \brief Get the socket, to wait for packets with poll().
+      /// \return The socket descriptor.
+      public: int Socket() const;
+
+      /// \brief Get the number of subscribers of a listening channel.
+      /// \return The number of subscribers.
+      public: std::size_t Subscribers() const;
+
+      /// \brief Constructor.
+      /// \param[in] _socket The socket.
+      /// \param[in] _path Path of the socket to remove when the listening
+      /// channel is destroyed, if any.
+      private: FdChannel(const int _socket, const std::string &_path);
+
+      /// \brief Accept the pending subscribers.
+      private: void Accept();
+
+      /// \brief Listening or connected socket.
+      private: int socket = -1;
+
+      /// \brief Path of the socket file, or empty.
+      private: std::string path;
+
+      /// \brief Sockets of the subscribers of a listening channel.
+      private: std::vector<int> subscribers;
+
+      /// \brief Whether the publisher closed the channel.
+      private: bool closed = false;
+    };
+    }
+  }
+}
+#endif
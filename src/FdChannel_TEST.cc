@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <string>
+
+#include "FdChannel.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief Pass the write end of a pipe to a subscriber.
+TEST(FdChannelTest, PassPipe)
+{
+  const std::string name = FdChannel::Name("pUuid", "@/partition@/fd");
+  EXPECT_EQ(name, FdChannel::Name("pUuid", "@/partition@/fd"));
+  EXPECT_NE(name, FdChannel::Name("other", "@/partition@/fd"));
+
+  EXPECT_EQ(nullptr, FdChannel::Connect(name));
+  auto pub = FdChannel::Listen(name);
+  ASSERT_NE(nullptr, pub);
+  EXPECT_EQ(nullptr, FdChannel::Listen(name));
+
+  auto sub = FdChannel::Connect(name);
+  ASSERT_NE(nullptr, sub);
+
+  std::string data;
+  int fd = -1;
+  EXPECT_FALSE(sub->Receive(data, fd));
+  EXPECT_FALSE(sub->Closed());
+
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  EXPECT_EQ(1u, pub->Send("frame 1", pipeFds[1]));
+  EXPECT_EQ(1u, pub->Subscribers());
+  EXPECT_EQ(1u, pub->Send("", -1));
+  close(pipeFds[1]);
+
+  ASSERT_TRUE(sub->Receive(data, fd));
+  EXPECT_EQ("frame 1", data);
+  ASSERT_GE(fd, 0);
+
+  // The descriptor received writes into the same pipe.
+  ASSERT_EQ(2, write(fd, "ok", 2));
+  close(fd);
+  char buffer[2];
+  ASSERT_EQ(2, read(pipeFds[0], buffer, 2));
+  EXPECT_EQ("ok", std::string(buffer, 2));
+  close(pipeFds[0]);
+
+  ASSERT_TRUE(sub->Receive(data, fd));
+  EXPECT_TRUE(data.empty());
+  EXPECT_EQ(-1, fd);
+
+  // Oversized metadata is refused.
+  EXPECT_EQ(0u, pub->Send(std::string(FdChannel::kMaxData + 1, 'x'), -1));
+
+  pub.reset();
+  EXPECT_FALSE(sub->Receive(data, fd));
+  EXPECT_TRUE(sub->Closed());
+}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "FieldFilter.hh"
+
+using namespace gz;
+using namespace transport;
+
+using google::protobuf::internal::WireFormatLite;
+
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Append a varint to a buffer.
+  /// \param[in] _value The value.
+  /// \param[out] _out The buffer.
+  void appendVarint(uint32_t _value, std::string &_out)
+  {
+    while (_value >= 0x80)
+    {
+      _out.push_back(static_cast<char>((_value & 0x7F) | 0x80));
+      _value >>= 7;
+    }
+    _out.push_back(static_cast<char>(_value));
+  }
+}
+
+//////////////////////////////////////////////////
+FieldFilter::FieldFilter(const std::vector<std::string> &_paths)
+  : paths(_paths)
+{
+}
+
+//////////////////////////////////////////////////
+bool FieldFilter::Filter(const std::string &_data,
+  const google::protobuf::Descriptor *_desc, std::string &_out) const
+{
+  if (!_desc ||
+      _data.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+  {
+    return false;
+  }
+
+  _out.clear();
+  return Filter(reinterpret_cast<const uint8_t *>(_data.data()),
+    static_cast<int>(_data.size()), this->Resolve(_desc), _out);
+}
+
+//////////////////////////////////////////////////
+const FieldFilter::Mask &FieldFilter::Resolve(
+  const google::protobuf::Descriptor *_desc) const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  auto it = this->masks.find(_desc);
+  if (it != this->masks.end())
+    return it->second;
+
+  Mask &mask = this->masks[_desc];
+  for (const auto &path : this->paths)
+  {
+    const google::protobuf::Descriptor *desc = _desc;
+    Mask *current = &mask;
+    std::istringstream names(path);
+    std::string name;
+    while (std::getline(names, name, '.'))
+    {
+      const google::protobuf::FieldDescriptor *field =
+        desc ? desc->FindFieldByName(name) : nullptr;
+      if (!field)
+      {
+        std::cerr << "FieldFilter: Unknown field [" << path << "] in ["
+                  << _desc->full_name() << "]" << std::endl;
+        break;
+      }
+
+      current = &current->fields[field->number()];
+      desc = field->message_type();
+    }
+
+    // The last field of the path is kept as a whole.
+    if (current != &mask)
+      current->all = true;
+  }
+
+  return mask;
+}
+
+//////////////////////////////////////////////////
+bool FieldFilter::Filter(const uint8_t *_data, int _size,
+  const Mask &_mask, std::string &_out)
+{
+  google::protobuf::io::CodedInputStream input(_data, _size);
+  while (true)
+  {
+    const int start = input.CurrentPosition();
+    const uint32_t tag = input.ReadTag();
+    if (tag == 0)
+      return input.CurrentPosition() == _size;
+
+    const auto it = _mask.fields.find(WireFormatLite::GetTagFieldNumber(tag));
+    const bool nested = it != _mask.fields.end() && !it->second.all &&
+      WireFormatLite::GetTagWireType(tag) ==
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+
+    // Only the fields of the mask are kept, as a whole when possible.
+    if (!nested)
+    {
+      if (!WireFormatLite::SkipField(&input, tag))
+        return false;
+      if (it != _mask.fields.end())
+      {
+        _out.append(reinterpret_cast<const char *>(_data) + start,
+          static_cast<std::size_t>(input.CurrentPosition() - start));
+      }
+      continue;
+    }
+
+    // Keep some fields of a nested message.
+    uint32_t length;
+    if (!input.ReadVarint32(&length) ||
+        length > static_cast<uint32_t>(_size - input.CurrentPosition()))
+    {
+      return false;
+    }
+
+    std::string nestedOut;
+    if (!Filter(_data + input.CurrentPosition(), static_cast<int>(length),
+          it->second, nestedOut))
+    {
+      return false;
+    }
+    input.Skip(static_cast<int>(length));
+
+    appendVarint(tag, _out);
+    appendVarint(static_cast<uint32_t>(nestedOut.size()), _out);
+    _out += nestedOut;
+  }
+}
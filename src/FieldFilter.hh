@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_FIELDFILTER_HH_
+#define GZ_TRANSPORT_FIELDFILTER_HH_
+
+#include <google/protobuf/descriptor.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Keeps the fields of a field mask in serialized messages.
+    ///
+    /// The serialized message is scanned without parsing it: the fields out
+    /// of the mask are skipped, so large bytes fields are never copied, and
+    /// the fields of the mask are copied to a smaller message that is
+    /// parsed instead. The paths of the mask are field names separated by
+    /// dots, e.g. "header.stamp". Unknown names are ignored.
+    class GZ_TRANSPORT_VISIBLE FieldFilter
+    {
+      /// \brief Constructor.
+      /// \param[in] _paths Paths of the fields to keep.
+      public: explicit FieldFilter(const std::vector<std::string> &_paths);
+
+      /// \brief Keep the fields of the mask in a serialized message.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _desc Descriptor of the message type.
+      /// \param[out] _out Serialized message with the fields of the mask.
+      /// \return False if the message couldn't be scanned, in which case
+      /// the whole message should be parsed.
+      public: bool Filter(const std::string &_data,
+                          const google::protobuf::Descriptor *_desc,
+                          std::string &_out) const;
+
+      /// \brief Fields of a message to keep, by number.
+      private: struct Mask
+      {
+        /// \brief Keep the whole field.
+        bool all = false;
+
+        /// \brief Fields to keep of a nested message.
+        std::map<int, Mask> fields;
+      };
+
+      /// \brief Get the mask of a message type, resolved once.
+      /// \param[in] _desc Descriptor of the message type.
+      /// \return The mask.
+      private: const Mask &Resolve(
+                   const google::protobuf::Descriptor *_desc) const;
+
+      /// \brief Keep the fields of a mask in a serialized message.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the serialized message.
+      /// \param[in] _mask Fields to keep.
+      /// \param[out] _out The kept fields are appended here.
+      /// \return False if the message couldn't be scanned.
+      private: static bool Filter(const uint8_t *_data, int _size,
+                                  const Mask &_mask, std::string &_out);
+
+      /// \brief Paths of the fields to keep.
+      private: std::vector<std::string> paths;
+
+      /// \brief Protects the masks.
+      private: mutable std::mutex mutex;
+
+      /// \brief Mask of every message type seen.
+      private: mutable std::unordered_map<const google::protobuf::Descriptor *,
+                                          Mask> masks;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/image.pb.h>
+
+#include <string>
+
+#include "gz/transport/SubscribeOptions.hh"
+#include "gz/transport/SubscriptionHandler.hh"
+#include "FieldFilter.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Create a serialized image.
+/// \param[out] _image The image.
+/// \return The serialized image.
+std::string image(msgs::Image &_image)
+{
+  _image.mutable_header()->mutable_stamp()->set_sec(5);
+  _image.mutable_header()->mutable_stamp()->set_nsec(6);
+  auto *data = _image.mutable_header()->add_data();
+  data->set_key("frame_id");
+  data->add_value("camera");
+  _image.set_width(640);
+  _image.set_height(480);
+  _image.set_data(std::string(640 * 480 * 3, 'x'));
+
+  std::string serialized;
+  _image.SerializeToString(&serialized);
+  return serialized;
+}
+
+//////////////////////////////////////////////////
+/// \brief Only the fields of the mask are kept.
+TEST(FieldFilterTest, Filter)
+{
+  msgs::Image msg;
+  const std::string data = image(msg);
+
+  FieldFilter filter({"header.stamp", "width", "unknown", "width.nested"});
+  std::string out;
+  ASSERT_TRUE(filter.Filter(data, msg.GetDescriptor(), out));
+  EXPECT_LT(out.size(), 64u);
+
+  msgs::Image filtered;
+  ASSERT_TRUE(filtered.ParseFromString(out));
+  EXPECT_EQ(5, filtered.header().stamp().sec());
+  EXPECT_EQ(6, filtered.header().stamp().nsec());
+  EXPECT_EQ(0, filtered.header().data_size());
+  EXPECT_EQ(640u, filtered.width());
+  EXPECT_EQ(0u, filtered.height());
+  EXPECT_TRUE(filtered.data().empty());
+
+  // Truncated messages can't be scanned.
+  EXPECT_FALSE(filter.Filter(data.substr(0, data.size() / 2),
+    msg.GetDescriptor(), out));
+}
+
+//////////////////////////////////////////////////
+/// \brief A subscription with a field mask parses only some fields.
+TEST(FieldFilterTest, SubscriptionHandler)
+{
+  msgs::Image msg;
+  const std::string data = image(msg);
+
+  SubscribeOptions opts;
+  opts.SetFieldMask({"header"});
+  SubscriptionHandler<msgs::Image> typedHandler("nUuid", opts);
+  SubscriptionHandler<ProtoMsg> genericHandler("nUuid", opts);
+
+  for (ISubscriptionHandler *handler :
+         {static_cast<ISubscriptionHandler *>(&typedHandler),
+          static_cast<ISubscriptionHandler *>(&genericHandler)})
+  {
+    auto created = handler->CreateMsg(data, msg.GetTypeName());
+    ASSERT_NE(nullptr, created);
+    msgs::Image image;
+    image.CopyFrom(*created);
+    EXPECT_EQ(msg.header().DebugString(), image.header().DebugString());
+    EXPECT_EQ(0u, image.width());
+    EXPECT_TRUE(image.data().empty());
+  }
+
+  // Without a mask the whole message is parsed.
+  SubscriptionHandler<msgs::Image> fullHandler("nUuid");
+  auto created = fullHandler.CreateMsg(data, msg.GetTypeName());
+  ASSERT_NE(nullptr, created);
+  EXPECT_EQ(msg.DebugString(), created->DebugString());
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "Fragments.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Parse a number followed by a colon.
+  /// \param[in] _frame The text.
+  /// \param[in, out] _pos Position of the number, then of the next field.
+  /// \param[out] _value The number.
+  /// \return False if there isn't a number followed by a colon.
+  template <typename T>
+  bool parseField(const std::string &_frame, std::size_t &_pos, T &_value)
+  {
+    const char *end = _frame.data() + _frame.size();
+    const auto result = std::from_chars(_frame.data() + _pos, end, _value);
+    if (result.ec != std::errc() || result.ptr == end || *result.ptr != ':')
+      return false;
+
+    _pos = static_cast<std::size_t>(result.ptr - _frame.data()) + 1;
+    return true;
+  }
+}
+
+//////////////////////////////////////////////////
+std::string FragmentReassembler::TypeFrame(const FragmentHeader &_header,
+  const std::string &_msgType)
+{
+  return kTypePrefix + std::to_string(_header.id) + ":" +
+    std::to_string(_header.index) + ":" + std::to_string(_header.count) +
+    ":" + std::to_string(_header.size) + ":" + _msgType;
+}
+
+//////////////////////////////////////////////////
+bool FragmentReassembler::ParseTypeFrame(const std::string &_frame,
+  FragmentHeader &_header, std::string &_msgType)
+{
+  if (_frame.compare(0, kTypePrefix.size(), kTypePrefix) != 0)
+    return false;
+
+  std::size_t pos = kTypePrefix.size();
+  if (!parseField(_frame, pos, _header.id) ||
+      !parseField(_frame, pos, _header.index) ||
+      !parseField(_frame, pos, _header.count) ||
+      !parseField(_frame, pos, _header.size) ||
+      _header.index >= _header.count)
+  {
+    return false;
+  }
+
+  _msgType = _frame.substr(pos);
+  return true;
+}
+
+//////////////////////////////////////////////////
+FragmentReassembler::FragmentReassembler(const std::size_t _budget)
+  : budget(_budget)
+{
+}
+
+//////////////////////////////////////////////////
+bool FragmentReassembler::Add(const std::string &_sender,
+  std::string &_msgType, std::string &_data)
+{
+  if (_msgType.compare(0, kTypePrefix.size(), kTypePrefix) != 0)
+    return true;
+
+  FragmentHeader header;
+  std::string msgType;
+  if (!ParseTypeFrame(_msgType, header, msgType))
+  {
+    std::cerr << "Malformed fragment received from [" << _sender << "]"
+              << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  const auto key = std::make_pair(_sender, header.id);
+  auto it = this->partials.find(key);
+  if (header.index == 0)
+  {
+    if (it != this->partials.end())
+      this->Drop(it);
+
+    if (header.size > this->budget)
+    {
+      ++this->dropped;
+      std::cerr << "Dropping a publication of " << header.size
+                << " bytes, larger than the reassembly budget. Consider "
+                << "increasing GZ_TRANSPORT_REASSEMBLY_BUDGET" << std::endl;
+      return false;
+    }
+
+    // Make room by dropping the oldest partial publications.
+    while (this->reserved + header.size > this->budget)
+    {
+      auto oldest = this->partials.begin();
+      for (auto p = this->partials.begin(); p != this->partials.end(); ++p)
+      {
+        if (p->second.order < oldest->second.order)
+          oldest = p;
+      }
+      this->Drop(oldest);
+    }
+
+    Partial partial;
+    partial.header = header;
+    partial.msgType = std::move(msgType);
+    partial.data.reserve(header.size);
+    partial.order = this->nextOrder++;
+    it = this->partials.emplace(key, std::move(partial)).first;
+    this->reserved += header.size;
+  }
+  else if (it == this->partials.end())
+  {
+    // The first fragment was sent before we connected, or it was dropped.
+    return false;
+  }
+  else if (it->second.next != header.index ||
+           it->second.header.count != header.count ||
+           it->second.header.size != header.size)
+  {
+    // A fragment was lost, e.g. dropped by the high water mark.
+    this->Drop(it);
+    return false;
+  }
+
+  Partial &partial = it->second;
+  if (_data.size() > partial.header.size - partial.data.size())
+  {
+    this->Drop(it);
+    return false;
+  }
+  partial.data.append(_data);
+  ++partial.next;
+
+  if (partial.next < partial.header.count)
+    return false;
+
+  if (partial.data.size() != partial.header.size)
+  {
+    this->Drop(it);
+    return false;
+  }
+
+  _msgType = std::move(partial.msgType);
+  _data = std::move(partial.data);
+  this->reserved -= partial.header.size;
+  this->partials.erase(it);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void FragmentReassembler::Drop(
+  std::map<std::pair<std::string, uint64_t>, Partial>::iterator _it)
+{
+  this->reserved -= _it->second.header.size;
+  this->partials.erase(_it);
+  ++this->dropped;
+}
+
+//////////////////////////////////////////////////
+std::size_t FragmentReassembler::Reserved() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->reserved;
+}
+
+//////////////////////////////////////////////////
+uint64_t FragmentReassembler::Dropped() const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  return this->dropped;
+}
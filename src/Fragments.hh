@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_FRAGMENTS_HH_
+#define GZ_TRANSPORT_FRAGMENTS_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Position of a fragment in a large publication. It travels in
+    /// the type frame of the fragment.
+    struct FragmentHeader
+    {
+      /// \brief ID of the publication, unique for its sender.
+      uint64_t id = 0;
+
+      /// \brief Index of the fragment.
+      uint32_t index = 0;
+
+      /// \brief Number of fragments of the publication.
+      uint32_t count = 0;
+
+      /// \brief Size of the payload of the publication (bytes).
+      uint64_t size = 0;
+    };
+
+    /// \brief Reassembles the publications split in fragments by their
+    /// publisher.
+    ///
+    /// The fragments of a publication arrive in order, since they follow
+    /// the same connection, but they may be interleaved with other
+    /// publications. The partial publications are bounded by a budget:
+    /// the oldest ones are dropped to make room for new ones, and the
+    /// publications larger than the budget are never reassembled.
+    class GZ_TRANSPORT_VISIBLE FragmentReassembler
+    {
+      /// \brief Prefix of the type frame of a fragment. It is followed by
+      /// the fragment header and the type of the publication. Processes
+      /// that don't know about fragments discard them as a type mismatch.
+      public: inline static const std::string kTypePrefix =
+        "gz.transport.Fragment:";
+
+      /// \brief Build the type frame of a fragment.
+      /// \param[in] _header Position of the fragment.
+      /// \param[in] _msgType Type frame of the publication.
+      /// \return The type frame.
+      public: static std::string TypeFrame(const FragmentHeader &_header,
+                                           const std::string &_msgType);
+
+      /// \brief Parse the type frame of a fragment.
+      /// \param[in] _frame The type frame.
+      /// \param[out] _header Position of the fragment.
+      /// \param[out] _msgType Type frame of the publication.
+      /// \return False if _frame isn't the type frame of a fragment.
+      public: static bool ParseTypeFrame(const std::string &_frame,
+                                         FragmentHeader &_header,
+                                         std::string &_msgType);
+
+      /// \brief Constructor.
+      /// \param[in] _budget Maximum size of the partial publications
+      /// (bytes).
+      public: explicit FragmentReassembler(const std::size_t _budget);
+
+      /// \brief Add a publication received from a publisher. This function
+      /// is thread safe.
+      /// \param[in] _sender Address of the publisher.
+      /// \param[in, out] _msgType Type frame received, replaced by the type
+      /// frame of the publication when it is complete.
+      /// \param[in, out] _data Payload received, replaced by the payload of
+      /// the publication when it is complete.
+      /// \return True if _msgType and _data hold a whole publication: one
+      /// that isn't fragmented or whose last fragment was just received.
+      public: bool Add(const std::string &_sender, std::string &_msgType,
+                       std::string &_data);
+
+      /// \brief Size reserved by the partial publications.
+      /// \return The size (bytes).
+      public: std::size_t Reserved() const;
+
+      /// \brief Number of publications dropped, because a fragment was
+      /// lost or they didn't fit in the budget.
+      /// \return The number of publications.
+      public: uint64_t Dropped() const;
+
+      /// \brief A publication whose fragments are being received.
+      private: struct Partial
+      {
+        /// \brief Header of its first fragment.
+        FragmentHeader header;
+
+        /// \brief Index of the next fragment.
+        uint32_t next = 0;
+
+        /// \brief Type frame of the publication.
+        std::string msgType;
+
+        /// \brief Payload received so far.
+        std::string data;
+
+        /// \brief Arrival order of the first fragment.
+        uint64_t order = 0;
+      };
+
+      /// \brief Forget a partial publication. The mutex must be locked.
+      /// \param[in] _it The publication.
+      private: void Drop(
+        std::map<std::pair<std::string, uint64_t>, Partial>::iterator _it);
+
+      /// \brief Maximum size of the partial publications.
+      private: const std::size_t budget;
+
+      /// \brief Protects the members below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Partial publications, by sender and ID.
+      private: std::map<std::pair<std::string, uint64_t>, Partial> partials;
+
+      /// \brief Size reserved by the partial publications.
+      private: std::size_t reserved = 0;
+
+      /// \brief Number of publications dropped.
+      private: uint64_t dropped = 0;
+
+      /// \brief Arrival order of the next partial publication.
+      private: uint64_t nextOrder = 0;
+    };
+    }
+  }
+}
+#endif
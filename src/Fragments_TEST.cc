@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <string>
+
+#include "Fragments.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Create the type frame of a fragment of a publication.
+/// \param[in] _id ID of the publication.
+/// \param[in] _index Index of the fragment.
+/// \param[in] _count Number of fragments.
+/// \param[in] _size Size of the publication.
+/// \return The type frame.
+std::string fragment(uint64_t _id, uint32_t _index, uint32_t _count,
+  uint64_t _size)
+{
+  FragmentHeader header;
+  header.id = _id;
+  header.index = _index;
+  header.count = _count;
+  header.size = _size;
+  return FragmentReassembler::TypeFrame(header, "gz.msgs.Bytes");
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the type frame of the fragments.
+TEST(FragmentsTest, TypeFrame)
+{
+  FragmentHeader header;
+  std::string msgType;
+  EXPECT_TRUE(FragmentReassembler::ParseTypeFrame(fragment(7, 1, 3, 10),
+    header, msgType));
+  EXPECT_EQ(7u, header.id);
+  EXPECT_EQ(1u, header.index);
+  EXPECT_EQ(3u, header.count);
+  EXPECT_EQ(10u, header.size);
+  EXPECT_EQ("gz.msgs.Bytes", msgType);
+
+  EXPECT_FALSE(FragmentReassembler::ParseTypeFrame("gz.msgs.Bytes", header,
+    msgType));
+  EXPECT_FALSE(FragmentReassembler::ParseTypeFrame(
+    FragmentReassembler::kTypePrefix + "7:1:3", header, msgType));
+  EXPECT_FALSE(FragmentReassembler::ParseTypeFrame(fragment(7, 3, 3, 10),
+    header, msgType));
+}
+
+//////////////////////////////////////////////////
+/// \brief Reassemble interleaved publications.
+TEST(FragmentsTest, Reassemble)
+{
+  FragmentReassembler reassembler(100);
+
+  // Publications that aren't fragmented are left as they are.
+  std::string msgType = "gz.msgs.Int32";
+  std::string data = "abc";
+  EXPECT_TRUE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ("gz.msgs.Int32", msgType);
+  EXPECT_EQ("abc", data);
+
+  msgType = fragment(1, 0, 2, 6);
+  data = "012";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ(6u, reassembler.Reserved());
+
+  // The same ID from another sender is another publication.
+  msgType = fragment(1, 0, 2, 4);
+  data = "ab";
+  EXPECT_FALSE(reassembler.Add("tcp://b", msgType, data));
+  EXPECT_EQ(10u, reassembler.Reserved());
+
+  msgType = fragment(1, 1, 2, 6);
+  data = "345";
+  EXPECT_TRUE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ("gz.msgs.Bytes", msgType);
+  EXPECT_EQ("012345", data);
+
+  msgType = fragment(1, 1, 2, 4);
+  data = "cd";
+  EXPECT_TRUE(reassembler.Add("tcp://b", msgType, data));
+  EXPECT_EQ("abcd", data);
+  EXPECT_EQ(0u, reassembler.Reserved());
+  EXPECT_EQ(0u, reassembler.Dropped());
+}
+
+//////////////////////////////////////////////////
+/// \brief Drop the publications with lost fragments.
+TEST(FragmentsTest, LostFragment)
+{
+  FragmentReassembler reassembler(100);
+
+  // Joined after the first fragment.
+  std::string msgType = fragment(1, 1, 3, 9);
+  std::string data = "345";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ(0u, reassembler.Dropped());
+
+  msgType = fragment(2, 0, 3, 9);
+  data = "012";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+  msgType = fragment(2, 2, 3, 9);
+  data = "678";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ(1u, reassembler.Dropped());
+  EXPECT_EQ(0u, reassembler.Reserved());
+}
+
+//////////////////////////////////////////////////
+/// \brief Bound the memory of the partial publications.
+TEST(FragmentsTest, Budget)
+{
+  FragmentReassembler reassembler(10);
+
+  // Larger than the budget.
+  std::string msgType = fragment(1, 0, 4, 12);
+  std::string data = "012";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ(1u, reassembler.Dropped());
+  EXPECT_EQ(0u, reassembler.Reserved());
+
+  msgType = fragment(2, 0, 2, 6);
+  data = "012";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+
+  // The oldest partial publication makes room for this one.
+  msgType = fragment(3, 0, 2, 6);
+  data = "abc";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ(2u, reassembler.Dropped());
+  EXPECT_EQ(6u, reassembler.Reserved());
+
+  msgType = fragment(2, 1, 2, 6);
+  data = "345";
+  EXPECT_FALSE(reassembler.Add("tcp://a", msgType, data));
+
+  msgType = fragment(3, 1, 2, 6);
+  data = "def";
+  EXPECT_TRUE(reassembler.Add("tcp://a", msgType, data));
+  EXPECT_EQ("abcdef", data);
+}
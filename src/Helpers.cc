@@ -15,17 +15,65 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <pthread.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
 #include "gz/transport/Helpers.hh"
 
+#ifdef __linux__
+namespace
+{
+  /// \brief Memory policy preferring a node, see set_mempolicy(2). The
+  /// constants of the kernel are repeated here so that libnuma isn't
+  /// needed.
+  const int kMpolPreferred = 1;
+
+  /// \brief Flag of mbind(2) moving the pages already allocated.
+  const unsigned int kMpolMfMove = 1u << 1;
+
+  /// \brief Build the node mask of a single NUMA node.
+  /// \param[in] _node The node.
+  /// \param[out] _maxNode Number of bits of the mask, as expected by the
+  /// system calls.
+  /// \return The mask.
+  std::vector<unsigned long> nodeMask(const int _node,  // NOLINT
+                                      unsigned long &_maxNode)  // NOLINT
+  {
+    const std::size_t bits = 8 * sizeof(unsigned long);  // NOLINT
+    const std::size_t node = static_cast<std::size_t>(_node);
+    std::vector<unsigned long> mask(node / bits + 1, 0);  // NOLINT
+    mask[node / bits] = 1ul << (node % bits);
+    _maxNode = mask.size() * bits + 1;
+    return mask;
+  }
+}
+#endif
+
 namespace gz
 {
   namespace transport
@@ -75,6 +123,357 @@ namespace gz
       return ::getpid();
 #endif
     }
+
+    //////////////////////////////////////////////////
+    bool appendSizePrefixed(std::string &_buffer, const std::string &_data)
+    {
+      if (_data.size() > std::numeric_limits<uint32_t>::max())
+        return false;
+
+      const auto size = static_cast<uint32_t>(_data.size());
+      for (int i = 0; i < 4; ++i)
+        _buffer.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+      _buffer.append(_data);
+      return true;
+    }
+
+    //////////////////////////////////////////////////
+    bool splitSizePrefixed(const std::string &_buffer,
+                           std::vector<std::string> &_items)
+    {
+      _items.clear();
+      std::size_t pos = 0;
+      while (pos < _buffer.size())
+      {
+        if (pos + 4 > _buffer.size())
+          return false;
+
+        uint32_t size = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+          size |= static_cast<uint32_t>(
+            static_cast<unsigned char>(_buffer[pos + i])) << (8 * i);
+        }
+        pos += 4;
+
+        if (size > _buffer.size() - pos)
+          return false;
+
+        _items.emplace_back(_buffer, pos, size);
+        pos += size;
+      }
+      return true;
+    }
+
+    //////////////////////////////////////////////////
+    uint64_t nextRequestId()
+    {
+      static std::atomic<uint64_t> next{1};
+      return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////
+    bool parseCpuList(const std::string &_list, std::vector<int> &_cpus)
+    {
+      _cpus.clear();
+      for (const std::string &range : split(_list, ','))
+      {
+        const std::size_t dash = range.find('-');
+        try
+        {
+          std::size_t end = 0;
+          const int first = std::stoi(range.substr(0, dash), &end);
+          if (end != std::min(dash, range.size()))
+            return false;
+
+          int last = first;
+          if (dash != std::string::npos)
+          {
+            const std::string tail = range.substr(dash + 1);
+            last = std::stoi(tail, &end);
+            if (end != tail.size())
+              return false;
+          }
+
+          if (first < 0 || last < first)
+            return false;
+
+          for (int cpu = first; cpu <= last; ++cpu)
+            _cpus.push_back(cpu);
+        }
+        catch (...)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    //////////////////////////////////////////////////
+    bool setThreadScheduling(const std::string &_thread,
+                             const std::vector<int> &_cpus,
+                             const int _priority)
+    {
+      bool result = true;
+#ifdef __linux__
+      if (!_cpus.empty())
+      {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu : _cpus)
+        {
+          if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &cpus);
+        }
+
+        const int error =
+          pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0)
+        {
+          std::cerr << "Unable to set the CPU affinity of a " << _thread
+                    << " thread: " << strerror(error) << std::endl;
+          result = false;
+        }
+      }
+
+      if (_priority > 0)
+      {
+        sched_param param{};
+        param.sched_priority = _priority;
+        const int error =
+          pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error != 0)
+        {
+          std::cerr << "Unable to set the priority of a " << _thread
+                    << " thread: " << strerror(error) << std::endl;
+          result = false;
+        }
+      }
+#else
+      if (!_cpus.empty() || _priority > 0)
+      {
+        std::cerr << "The priority and the CPU affinity of a " << _thread
+                  << " thread are only supported on Linux" << std::endl;
+        result = false;
+      }
+#endif
+      return result;
+    }
+
+    //////////////////////////////////////////////////
+    bool numaNodeCpus(const int _node, std::vector<int> &_cpus)
+    {
+      _cpus.clear();
+#ifdef __linux__
+      if (_node < 0)
+        return false;
+
+      std::ifstream file("/sys/devices/system/node/node" +
+        std::to_string(_node) + "/cpulist");
+      std::string list;
+      if (!std::getline(file, list))
+        return false;
+
+      // A node may have memory and no CPU.
+      return !list.empty() && parseCpuList(list, _cpus);
+#else
+      (void)_node;
+      return false;
+#endif
+    }
+
+    //////////////////////////////////////////////////
+    bool setThreadMemoryNode(const std::string &_thread, const int _node)
+    {
+#ifdef __linux__
+      if (_node < 0)
+        return false;
+
+      unsigned long maxNode = 0;  // NOLINT
+      const auto mask = nodeMask(_node, maxNode);
+      if (syscall(SYS_set_mempolicy, kMpolPreferred, mask.data(),
+            maxNode) != 0)
+      {
+        std::cerr << "Unable to allocate the memory of a " << _thread
+                  << " thread on NUMA node " << _node << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+      }
+      return true;
+#else
+      std::cerr << "The NUMA node of a " << _thread << " thread is only "
+                << "supported on Linux" << std::endl;
+      (void)_node;
+      return false;
+#endif
+    }
+
+    //////////////////////////////////////////////////
+    bool bindMemoryNode(void *_addr, const std::size_t _size, const int _node)
+    {
+#ifdef __linux__
+      if (_node < 0)
+        return false;
+
+      unsigned long maxNode = 0;  // NOLINT
+      const auto mask = nodeMask(_node, maxNode);
+      if (syscall(SYS_mbind, _addr, _size, kMpolPreferred, mask.data(),
+            maxNode, kMpolMfMove) != 0)
+      {
+        std::cerr << "Unable to place memory on NUMA node " << _node << ": "
+                  << strerror(errno) << std::endl;
+        return false;
+      }
+      return true;
+#else
+      (void)_addr;
+      (void)_size;
+      (void)_node;
+      return false;
+#endif
+    }
+
+    //////////////////////////////////////////////////
+    bool setupThread(const std::string &_kind, const std::string &_name)
+    {
+      // Names longer than 15 characters are rejected by Linux.
+      const std::string name = _name.substr(0, 15);
+#if defined(__linux__)
+      pthread_setname_np(pthread_self(), name.c_str());
+#elif defined(__APPLE__)
+      pthread_setname_np(name.c_str());
+#endif
+
+      // The settings of the kind of thread take precedence.
+      std::string cpuList;
+      std::string priorityStr;
+      if (!env("GZ_TRANSPORT_" + _kind + "_THREAD_CPUS", cpuList))
+        env("GZ_TRANSPORT_THREAD_CPUS", cpuList);
+      if (!env("GZ_TRANSPORT_" + _kind + "_THREAD_PRIORITY", priorityStr))
+        env("GZ_TRANSPORT_THREAD_PRIORITY", priorityStr);
+      std::string numaStr;
+      if (!env("GZ_TRANSPORT_" + _kind + "_THREAD_NUMA_NODE", numaStr))
+        env("GZ_TRANSPORT_THREAD_NUMA_NODE", numaStr);
+
+      bool result = true;
+      std::vector<int> cpus;
+      if (!cpuList.empty() && !parseCpuList(cpuList, cpus))
+      {
+        std::cerr << "Invalid CPU list [" << cpuList << "] for the "
+                  << name << " thread" << std::endl;
+        result = false;
+      }
+
+      int priority = 0;
+      if (!priorityStr.empty())
+      {
+        try
+        {
+          priority = std::stoi(priorityStr);
+        }
+        catch (...)
+        {
+          std::cerr << "Invalid priority [" << priorityStr << "] for the "
+                    << name << " thread" << std::endl;
+          result = false;
+        }
+      }
+
+      // The thread runs and allocates its buffers close to the devices and
+      // the threads it serves, e.g. the NIC.
+      if (!numaStr.empty())
+      {
+        int node = -1;
+        try
+        {
+          node = std::stoi(numaStr);
+        }
+        catch (...)
+        {
+        }
+
+        if (node < 0 || (cpuList.empty() && !numaNodeCpus(node, cpus)))
+        {
+          std::cerr << "Invalid NUMA node [" << numaStr << "] for the "
+                    << name << " thread" << std::endl;
+          result = false;
+        }
+        else
+        {
+          result = setThreadMemoryNode(name, node) && result;
+        }
+      }
+
+      return setThreadScheduling(name, cpus, priority) && result;
+    }
+
+    //////////////////////////////////////////////////
+    bool enableReceiveTimestamps(const int _socket)
+    {
+#ifdef __linux__
+      // The software stamps of SO_TIMESTAMPING are taken by the network
+      // stack, in the system clock. The hardware stamps would be in the
+      // clock of the network interface.
+      const int flags = SOF_TIMESTAMPING_RX_SOFTWARE |
+        SOF_TIMESTAMPING_SOFTWARE;
+      if (setsockopt(_socket, SOL_SOCKET, SO_TIMESTAMPING, &flags,
+            sizeof(flags)) == 0)
+      {
+        return true;
+      }
+
+      const int enable = 1;
+      return setsockopt(_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable,
+        sizeof(enable)) == 0;
+#else
+      (void)_socket;
+      return false;
+#endif
+    }
+
+#ifndef _WIN32
+    //////////////////////////////////////////////////
+    bool receiveTimestamp(const msghdr &_msg, int64_t &_stampUs)
+    {
+#ifdef __linux__
+      for (cmsghdr *cmsg = CMSG_FIRSTHDR(&_msg); cmsg;
+           cmsg = CMSG_NXTHDR(const_cast<msghdr *>(&_msg), cmsg))
+      {
+        if (cmsg->cmsg_level != SOL_SOCKET)
+          continue;
+
+        timespec stamp;
+        if (cmsg->cmsg_type == SO_TIMESTAMPING &&
+            cmsg->cmsg_len >= CMSG_LEN(sizeof(scm_timestamping)))
+        {
+          scm_timestamping stamps;
+          memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+          stamp = stamps.ts[0];
+        }
+        else if (cmsg->cmsg_type == SO_TIMESTAMPNS &&
+                 cmsg->cmsg_len >= CMSG_LEN(sizeof(timespec)))
+        {
+          memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+        }
+        else
+        {
+          continue;
+        }
+
+        if (stamp.tv_sec == 0 && stamp.tv_nsec == 0)
+          continue;
+
+        _stampUs = static_cast<int64_t>(stamp.tv_sec) * 1000000 +
+          static_cast<int64_t>(stamp.tv_nsec) / 1000;
+        return true;
+      }
+#else
+      (void)_msg;
+      (void)_stampUs;
+#endif
+      return false;
+    }
+#endif
     }
   }
 }
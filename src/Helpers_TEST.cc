@@ -21,6 +21,15 @@
 
 #include <gz/utils/Environment.hh>
 
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#endif
+
 using namespace gz;
 
 //////////////////////////////////////////////////
@@ -88,3 +97,133 @@ TEST(HelpersTest, SplitOneDelimiterAtEnd)
   EXPECT_EQ("Hello World", pieces[0]);
   EXPECT_EQ("", pieces[1]);
 }
+
+/////////////////////////////////////////////////
+TEST(HelpersTest, SizePrefixed)
+{
+  std::string buffer;
+  EXPECT_TRUE(transport::appendSizePrefixed(buffer, "Hello"));
+  EXPECT_TRUE(transport::appendSizePrefixed(buffer, ""));
+  EXPECT_TRUE(transport::appendSizePrefixed(buffer, std::string(300, 'x')));
+  EXPECT_EQ(4u + 5u + 4u + 4u + 300u, buffer.size());
+
+  std::vector<std::string> items;
+  ASSERT_TRUE(transport::splitSizePrefixed(buffer, items));
+  ASSERT_EQ(3u, items.size());
+  EXPECT_EQ("Hello", items[0]);
+  EXPECT_EQ("", items[1]);
+  EXPECT_EQ(std::string(300, 'x'), items[2]);
+
+  // An empty buffer has no messages.
+  EXPECT_TRUE(transport::splitSizePrefixed("", items));
+  EXPECT_TRUE(items.empty());
+
+  // Truncated buffers.
+  EXPECT_FALSE(transport::splitSizePrefixed(buffer.substr(0, 2), items));
+  EXPECT_FALSE(transport::splitSizePrefixed(buffer.substr(0, 7), items));
+}
+
+/////////////////////////////////////////////////
+TEST(HelpersTest, ParseCpuList)
+{
+  std::vector<int> cpus;
+  EXPECT_TRUE(transport::parseCpuList("3", cpus));
+  EXPECT_EQ(std::vector<int>({3}), cpus);
+  EXPECT_TRUE(transport::parseCpuList("0,2-4", cpus));
+  EXPECT_EQ(std::vector<int>({0, 2, 3, 4}), cpus);
+
+  EXPECT_FALSE(transport::parseCpuList("", cpus));
+  EXPECT_FALSE(transport::parseCpuList("a", cpus));
+  EXPECT_FALSE(transport::parseCpuList("1,", cpus));
+  EXPECT_FALSE(transport::parseCpuList("4-2", cpus));
+  EXPECT_FALSE(transport::parseCpuList("1-2x", cpus));
+  EXPECT_FALSE(transport::parseCpuList("-1", cpus));
+}
+
+/////////////////////////////////////////////////
+TEST(HelpersTest, SetupThread)
+{
+  // Nothing to configure.
+  EXPECT_TRUE(transport::setupThread("TEST", "gz-test"));
+
+  ASSERT_TRUE(gz::utils::setenv("GZ_TRANSPORT_TEST_THREAD_CPUS", "x"));
+  EXPECT_FALSE(transport::setupThread("TEST", "gz-test"));
+  ASSERT_TRUE(gz::utils::unsetenv("GZ_TRANSPORT_TEST_THREAD_CPUS"));
+
+  ASSERT_TRUE(gz::utils::setenv("GZ_TRANSPORT_TEST_THREAD_NUMA_NODE", "x"));
+  EXPECT_FALSE(transport::setupThread("TEST", "gz-test"));
+  ASSERT_TRUE(gz::utils::unsetenv("GZ_TRANSPORT_TEST_THREAD_NUMA_NODE"));
+}
+
+/////////////////////////////////////////////////
+TEST(HelpersTest, NumaNode)
+{
+  std::vector<int> cpus;
+  EXPECT_FALSE(transport::numaNodeCpus(-1, cpus));
+  EXPECT_TRUE(cpus.empty());
+  EXPECT_FALSE(transport::setThreadMemoryNode("test", -1));
+
+  // The first node has CPUs on the Linux hosts with NUMA support.
+  if (transport::numaNodeCpus(0, cpus))
+  {
+    EXPECT_FALSE(cpus.empty());
+    EXPECT_TRUE(transport::setThreadMemoryNode("test", 0));
+
+    std::vector<char> buffer(1 << 16);
+    EXPECT_FALSE(transport::bindMemoryNode(buffer.data(), buffer.size(), -1));
+  }
+}
+
+#ifdef __linux__
+/////////////////////////////////////////////////
+/// \brief The datagrams received on a socket with receive timestamps carry
+/// the time at which the kernel received them.
+TEST(HelpersTest, ReceiveTimestamps)
+{
+  const int receiver = socket(AF_INET, SOCK_DGRAM, 0);
+  const int sender = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(receiver, 0);
+  ASSERT_GE(sender, 0);
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrLen = sizeof(addr);
+  ASSERT_EQ(0, bind(receiver, reinterpret_cast<sockaddr *>(&addr),
+    sizeof(addr)));
+  ASSERT_EQ(0, getsockname(receiver, reinterpret_cast<sockaddr *>(&addr),
+    &addrLen));
+  EXPECT_TRUE(transport::enableReceiveTimestamps(receiver));
+
+  const int64_t before = std::chrono::duration_cast<
+    std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  ASSERT_EQ(4, sendto(sender, "ping", 4, 0,
+    reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+
+  char data[16];
+  iovec iov;
+  iov.iov_base = data;
+  iov.iov_len = sizeof(data);
+  alignas(cmsghdr) char control[transport::kReceiveTimestampControlSize];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ASSERT_EQ(4, recvmsg(receiver, &msg, 0));
+  const int64_t after = std::chrono::duration_cast<
+    std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  int64_t stampUs = 0;
+  EXPECT_TRUE(transport::receiveTimestamp(msg, stampUs));
+  EXPECT_LE(before, stampUs);
+  EXPECT_GE(after, stampUs);
+
+  close(sender);
+  close(receiver);
+}
+#endif
@@ -0,0 +1,501 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/discovery.pb.h>
+
+#include <zmq.hpp>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/IntrospectionDaemon.hh"
+#include "gz/transport/Node.hh"
+#include "gz/transport/NodeOptions.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Prefix of the IPC endpoints.
+  const char kIpcPrefix[] = "ipc://";
+
+  /// \brief Time between the checks of the exit flag of the daemon (ms.).
+  const std::chrono::milliseconds kPollTimeout{100};
+
+  /// \brief Requests understood by the daemon. The name of the topic or
+  /// service, if any, travels in a second frame.
+  const char kPingReq[] = "ping";
+  const char kTopicListReq[] = "topic_list";
+  const char kTopicInfoReq[] = "topic_info";
+  const char kServiceListReq[] = "service_list";
+  const char kServiceInfoReq[] = "service_info";
+
+  /// \brief First frame of the replies.
+  const char kOkRep[] = "ok";
+  const char kErrorRep[] = "error";
+
+  //////////////////////////////////////////////////
+  /// \brief Get the socket file of an IPC endpoint.
+  /// \param[in] _endpoint ZeroMQ endpoint.
+  /// \return The path or an empty string if it's not an IPC endpoint.
+  std::string ipcPath(const std::string &_endpoint)
+  {
+    const std::string prefix = kIpcPrefix;
+    if (_endpoint.compare(0, prefix.size(), prefix) != 0)
+      return "";
+    return _endpoint.substr(prefix.size());
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Send all the frames of a message.
+  /// \param[in] _socket ZeroMQ socket.
+  /// \param[in] _frames Frames to send.
+  /// \return True on success.
+  bool sendFrames(zmq::socket_t &_socket,
+                  const std::vector<std::string> &_frames)
+  {
+    for (std::size_t i = 0; i < _frames.size(); ++i)
+    {
+      zmq::message_t msg(_frames[i].data(), _frames[i].size());
+      const bool more = i + 1 < _frames.size();
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!_socket.send(msg, more ? zmq::send_flags::sndmore :
+                                    zmq::send_flags::none))
+#else
+      if (!_socket.send(msg, more ? ZMQ_SNDMORE : 0))
+#endif
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Receive all the frames of a message.
+  /// \param[in] _socket ZeroMQ socket.
+  /// \param[out] _frames Frames received.
+  /// \return True on success.
+  bool recvFrames(zmq::socket_t &_socket, std::vector<std::string> &_frames)
+  {
+    _frames.clear();
+    do
+    {
+      zmq::message_t msg;
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!_socket.recv(msg))
+#else
+      if (!_socket.recv(&msg, 0))
+#endif
+      {
+        return false;
+      }
+      _frames.emplace_back(static_cast<const char *>(msg.data()), msg.size());
+    }
+    while (_socket.get(zmq::sockopt::rcvmore));
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append the discovery message of a publisher to a reply.
+  /// \param[in] _pub The publisher.
+  /// \param[in] _type ADVERTISE for publishers or SUBSCRIBE for
+  /// subscribers.
+  /// \param[in, out] _frames Frames of the reply.
+  template<typename Pub>
+  void appendPublisher(const Pub &_pub, msgs::Discovery::Type _type,
+                       std::vector<std::string> &_frames)
+  {
+    msgs::Discovery msg;
+    _pub.FillDiscovery(msg);
+    msg.set_type(_type);
+    _frames.push_back(msg.SerializeAsString());
+  }
+}
+
+namespace gz
+{
+  namespace transport
+  {
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
+    {
+    /// \internal
+    /// \brief Private data for IntrospectionDaemon.
+    class IntrospectionDaemonPrivate
+    {
+      /// \brief Serve until the exit flag is set.
+      public: void Run();
+
+      /// \brief Answer one request.
+      /// \param[in] _req Frames of the request.
+      /// \return Frames of the reply.
+      public: std::vector<std::string> Handle(
+        const std::vector<std::string> &_req) const;
+
+      /// \brief Endpoint where the daemon listens.
+      public: std::string endpoint;
+
+      /// \brief Node that keeps the discovery running.
+      public: std::unique_ptr<Node> node;
+
+      /// \brief 0MQ context. Always declare this object before any ZMQ socket
+      /// to make sure that the context is destroyed after all sockets.
+      public: std::unique_ptr<zmq::context_t> context;
+
+      /// \brief Socket answering the requests.
+      public: std::unique_ptr<zmq::socket_t> replier;
+
+      /// \brief Thread serving the requests.
+      public: std::thread thread;
+
+      /// \brief Flag to stop the thread.
+      public: std::atomic<bool> exit{false};
+    };
+
+    /// \internal
+    /// \brief Private data for IntrospectionClient.
+    class IntrospectionClientPrivate
+    {
+      /// \brief Send a request and wait for the reply.
+      /// \param[in] _req Frames of the request.
+      /// \param[out] _rep Frames of the reply, without the status.
+      /// \return True if the daemon replied with success.
+      public: bool Query(const std::vector<std::string> &_req,
+                         std::vector<std::string> &_rep) const;
+
+      /// \brief Endpoint of the daemon.
+      public: std::string endpoint;
+
+      /// \brief Maximum time to wait for a reply (ms.).
+      public: unsigned int timeout;
+
+      /// \brief 0MQ context, created on the first query.
+      public: mutable std::unique_ptr<zmq::context_t> context;
+    };
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void IntrospectionDaemonPrivate::Run()
+{
+  while (!this->exit)
+  {
+    zmq::pollitem_t items[] =
+    {
+      {static_cast<void*>(*this->replier), 0, ZMQ_POLLIN, 0}
+    };
+
+    try
+    {
+      zmq::poll(&items[0], 1, kPollTimeout);
+      if (!(items[0].revents & ZMQ_POLLIN))
+        continue;
+
+      std::vector<std::string> req;
+      if (!recvFrames(*this->replier, req))
+        continue;
+
+      sendFrames(*this->replier, this->Handle(req));
+    }
+    catch(const zmq::error_t &_error)
+    {
+      std::cerr << "IntrospectionDaemon: " << _error.what() << std::endl;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> IntrospectionDaemonPrivate::Handle(
+  const std::vector<std::string> &_req) const
+{
+  std::vector<std::string> rep = {kOkRep};
+  const std::string cmd = _req.empty() ? "" : _req[0];
+  const std::string name = _req.size() > 1 ? _req[1] : "";
+
+  if (cmd == kPingReq)
+    return rep;
+
+  if (cmd == kTopicListReq || cmd == kServiceListReq)
+  {
+    std::vector<std::string> names;
+    if (cmd == kTopicListReq)
+      this->node->TopicList(names);
+    else
+      this->node->ServiceList(names);
+    rep.insert(rep.end(), names.begin(), names.end());
+    return rep;
+  }
+
+  if (cmd == kTopicInfoReq)
+  {
+    std::vector<MessagePublisher> pubs;
+    std::vector<MessagePublisher> subs;
+    this->node->TopicInfo(name, pubs, subs);
+    for (const auto &pub : pubs)
+      appendPublisher(pub, msgs::Discovery::ADVERTISE, rep);
+    for (const auto &sub : subs)
+      appendPublisher(sub, msgs::Discovery::SUBSCRIBE, rep);
+    return rep;
+  }
+
+  if (cmd == kServiceInfoReq)
+  {
+    std::vector<ServicePublisher> pubs;
+    this->node->ServiceInfo(name, pubs);
+    for (const auto &pub : pubs)
+      appendPublisher(pub, msgs::Discovery::ADVERTISE, rep);
+    return rep;
+  }
+
+  return {kErrorRep, "Unknown request [" + cmd + "]"};
+}
+
+//////////////////////////////////////////////////
+IntrospectionDaemon::IntrospectionDaemon(const std::string &_endpoint)
+  : dataPtr(new IntrospectionDaemonPrivate)
+{
+  this->dataPtr->endpoint =
+    _endpoint.empty() ? DefaultEndpoint() : _endpoint;
+}
+
+//////////////////////////////////////////////////
+IntrospectionDaemon::~IntrospectionDaemon()
+{
+  this->Stop();
+}
+
+//////////////////////////////////////////////////
+bool IntrospectionDaemon::Start()
+{
+  if (this->dataPtr->thread.joinable())
+    return false;
+
+  // Binding an IPC endpoint replaces the socket file, so make sure that we
+  // don't steal it from a live daemon.
+  if (IntrospectionClient(this->dataPtr->endpoint).Available())
+  {
+    std::cerr << "IntrospectionDaemon: Another daemon is listening on ["
+              << this->dataPtr->endpoint << "]" << std::endl;
+    return false;
+  }
+
+  try
+  {
+    this->dataPtr->context.reset(new zmq::context_t(1));
+    this->dataPtr->replier.reset(
+      new zmq::socket_t(*this->dataPtr->context, ZMQ_REP));
+    this->dataPtr->replier->set(zmq::sockopt::linger, 0);
+    this->dataPtr->replier->bind(this->dataPtr->endpoint);
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "IntrospectionDaemon: Unable to bind ["
+              << this->dataPtr->endpoint << "]: " << _error.what()
+              << std::endl;
+    this->dataPtr->replier.reset();
+    this->dataPtr->context.reset();
+    return false;
+  }
+
+  this->dataPtr->node.reset(new Node());
+  this->dataPtr->exit = false;
+  this->dataPtr->thread = std::thread(&IntrospectionDaemonPrivate::Run,
+    this->dataPtr.get());
+  return true;
+}
+
+//////////////////////////////////////////////////
+void IntrospectionDaemon::Stop()
+{
+  if (!this->dataPtr->thread.joinable())
+    return;
+
+  this->dataPtr->exit = true;
+  this->dataPtr->thread.join();
+  this->dataPtr->replier.reset();
+  this->dataPtr->context.reset();
+  this->dataPtr->node.reset();
+
+  const std::string path = ipcPath(this->dataPtr->endpoint);
+  if (!path.empty())
+  {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+  }
+}
+
+//////////////////////////////////////////////////
+std::string IntrospectionDaemon::Endpoint() const
+{
+  return this->dataPtr->endpoint;
+}
+
+//////////////////////////////////////////////////
+std::string IntrospectionDaemon::DefaultEndpoint()
+{
+  // The partition may contain characters that aren't valid in a file name.
+  std::string name = NodeOptions().Partition();
+  for (auto &c : name)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+      c = '_';
+  }
+
+  std::error_code ec;
+  std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+  if (ec)
+    dir = ".";
+
+  return kIpcPrefix + (dir / ("gz-transport-" + name + ".ipc")).string();
+}
+
+//////////////////////////////////////////////////
+bool IntrospectionClientPrivate::Query(const std::vector<std::string> &_req,
+  std::vector<std::string> &_rep) const
+{
+  _rep.clear();
+
+  // Without a socket file there's no daemon, don't wait for the timeout.
+  const std::string path = ipcPath(this->endpoint);
+  std::error_code ec;
+  if (!path.empty() && !std::filesystem::exists(path, ec))
+    return false;
+
+  try
+  {
+    if (!this->context)
+      this->context.reset(new zmq::context_t(1));
+
+    // A request socket that timed out can't be used again, so every query
+    // uses a new one.
+    zmq::socket_t requester(*this->context, ZMQ_REQ);
+    requester.set(zmq::sockopt::linger, 0);
+    requester.connect(this->endpoint);
+    if (!sendFrames(requester, _req))
+      return false;
+
+    zmq::pollitem_t items[] =
+    {
+      {static_cast<void*>(requester), 0, ZMQ_POLLIN, 0}
+    };
+    zmq::poll(&items[0], 1, std::chrono::milliseconds(this->timeout));
+    if (!(items[0].revents & ZMQ_POLLIN))
+      return false;
+
+    if (!recvFrames(requester, _rep) || _rep.empty() || _rep[0] != kOkRep)
+      return false;
+  }
+  catch(const zmq::error_t &)
+  {
+    return false;
+  }
+
+  _rep.erase(_rep.begin());
+  return true;
+}
+
+//////////////////////////////////////////////////
+IntrospectionClient::IntrospectionClient(const std::string &_endpoint,
+  const unsigned int _timeout)
+  : dataPtr(new IntrospectionClientPrivate)
+{
+  this->dataPtr->endpoint =
+    _endpoint.empty() ? IntrospectionDaemon::DefaultEndpoint() : _endpoint;
+  this->dataPtr->timeout = _timeout;
+}
+
+//////////////////////////////////////////////////
+IntrospectionClient::~IntrospectionClient() = default;
+
+//////////////////////////////////////////////////
+bool IntrospectionClient::Available() const
+{
+  std::vector<std::string> rep;
+  return this->dataPtr->Query({kPingReq}, rep);
+}
+
+//////////////////////////////////////////////////
+bool IntrospectionClient::TopicList(std::vector<std::string> &_topics) const
+{
+  return this->dataPtr->Query({kTopicListReq}, _topics);
+}
+
+//////////////////////////////////////////////////
+bool IntrospectionClient::TopicInfo(const std::string &_topic,
+  std::vector<MessagePublisher> &_publishers,
+  std::vector<MessagePublisher> &_subscribers) const
+{
+  std::vector<std::string> rep;
+  if (!this->dataPtr->Query({kTopicInfoReq, _topic}, rep))
+    return false;
+
+  _publishers.clear();
+  _subscribers.clear();
+  for (const auto &frame : rep)
+  {
+    msgs::Discovery msg;
+    if (!msg.ParseFromString(frame))
+      return false;
+
+    MessagePublisher pub;
+    pub.SetFromDiscovery(msg);
+    if (msg.type() == msgs::Discovery::SUBSCRIBE)
+      _subscribers.push_back(pub);
+    else
+      _publishers.push_back(pub);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool IntrospectionClient::ServiceList(std::vector<std::string> &_services)
+  const
+{
+  return this->dataPtr->Query({kServiceListReq}, _services);
+}
+
+//////////////////////////////////////////////////
+bool IntrospectionClient::ServiceInfo(const std::string &_service,
+  std::vector<ServicePublisher> &_publishers) const
+{
+  std::vector<std::string> rep;
+  if (!this->dataPtr->Query({kServiceInfoReq, _service}, rep))
+    return false;
+
+  _publishers.clear();
+  for (const auto &frame : rep)
+  {
+    msgs::Discovery msg;
+    if (!msg.ParseFromString(frame))
+      return false;
+
+    ServicePublisher pub;
+    pub.SetFromDiscovery(msg);
+    _publishers.push_back(pub);
+  }
+  return true;
+}
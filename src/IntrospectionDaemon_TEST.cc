@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/IntrospectionDaemon.hh"
+#include "gz/transport/Node.hh"
+
+#include "test_utils.hh"
+#include "gtest/gtest.h"
+#include "gz/utils/Environment.hh"
+
+using namespace gz;
+using namespace transport;
+
+static std::string g_topic = "/foo"; // NOLINT(*)
+static std::string g_service = "/echo"; // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Wait until a condition is true or 5 seconds elapsed.
+template<typename F>
+bool waitFor(F _cond)
+{
+  for (int i = 0; i < 500 && !_cond(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return _cond();
+}
+
+//////////////////////////////////////////////////
+/// \brief Provide a service.
+bool srvEcho(const msgs::Int32 &_req, msgs::Int32 &_rep)
+{
+  _rep.set_data(_req.data());
+  return true;
+}
+
+//////////////////////////////////////////////////
+TEST(IntrospectionDaemonTest, NoDaemon)
+{
+  IntrospectionClient client;
+
+  // Without a daemon the client gives up right away.
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::string> topics;
+  EXPECT_FALSE(client.Available());
+  EXPECT_FALSE(client.TopicList(topics));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(100));
+}
+
+//////////////////////////////////////////////////
+TEST(IntrospectionDaemonTest, Queries)
+{
+  IntrospectionDaemon daemon;
+  EXPECT_EQ(IntrospectionDaemon::DefaultEndpoint(), daemon.Endpoint());
+  ASSERT_TRUE(daemon.Start());
+  EXPECT_FALSE(daemon.Start());
+
+  // Only one daemon per endpoint.
+  IntrospectionDaemon other;
+  EXPECT_FALSE(other.Start());
+
+  IntrospectionClient client;
+  EXPECT_TRUE(client.Available());
+
+  Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  ASSERT_TRUE(pub);
+  ASSERT_TRUE(node.Advertise(g_service, srvEcho));
+
+  std::vector<std::string> topics;
+  EXPECT_TRUE(waitFor([&]
+  {
+    return client.TopicList(topics) &&
+      std::find(topics.begin(), topics.end(), g_topic) != topics.end();
+  }));
+
+  std::vector<MessagePublisher> publishers;
+  std::vector<MessagePublisher> subscribers;
+  ASSERT_TRUE(client.TopicInfo(g_topic, publishers, subscribers));
+  ASSERT_EQ(1u, publishers.size());
+  EXPECT_EQ("gz.msgs.Int32", publishers[0].MsgTypeName());
+
+  std::vector<std::string> services;
+  EXPECT_TRUE(waitFor([&]
+  {
+    return client.ServiceList(services) &&
+      std::find(services.begin(), services.end(), g_service) !=
+        services.end();
+  }));
+
+  std::vector<ServicePublisher> providers;
+  ASSERT_TRUE(client.ServiceInfo(g_service, providers));
+  ASSERT_EQ(1u, providers.size());
+  EXPECT_EQ("gz.msgs.Int32", providers[0].ReqTypeName());
+  EXPECT_EQ("gz.msgs.Int32", providers[0].RepTypeName());
+
+  ASSERT_TRUE(client.TopicInfo("/unknown", publishers, subscribers));
+  EXPECT_TRUE(publishers.empty());
+
+  // The socket is removed when the daemon stops.
+  daemon.Stop();
+  EXPECT_FALSE(client.Available());
+  EXPECT_FALSE(client.TopicList(topics));
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name, which is part of the default endpoint.
+  gz::utils::setenv("GZ_PARTITION", testing::getRandomNumber());
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
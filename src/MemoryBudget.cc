@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <utility>
+
+#include "MemoryBudget.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+MemoryBudget::Charge::Charge(Account *_account, const std::size_t _bytes)
+  : account(_account),
+    bytes(_bytes)
+{
+}
+
+//////////////////////////////////////////////////
+MemoryBudget::Charge::Charge(Charge &&_other) noexcept
+  : account(_other.account),
+    bytes(_other.bytes),
+    reserved(_other.reserved)
+{
+  _other.reserved = false;
+}
+
+//////////////////////////////////////////////////
+MemoryBudget::Charge &MemoryBudget::Charge::operator=(
+  Charge &&_other) noexcept
+{
+  if (this != &_other)
+  {
+    this->Release();
+    this->account = _other.account;
+    this->bytes = _other.bytes;
+    this->reserved = _other.reserved;
+    _other.reserved = false;
+  }
+  return *this;
+}
+
+//////////////////////////////////////////////////
+MemoryBudget::Charge::~Charge()
+{
+  this->Release();
+}
+
+//////////////////////////////////////////////////
+bool MemoryBudget::Charge::Reserve()
+{
+  if (!this->account || this->reserved)
+    return true;
+
+  this->reserved =
+    this->account->budget->Add(*this->account, this->bytes, false);
+  return this->reserved;
+}
+
+//////////////////////////////////////////////////
+bool MemoryBudget::Charge::Reserve(const std::atomic<bool> &_stop)
+{
+  if (!this->account || this->reserved)
+    return true;
+
+  this->reserved =
+    this->account->budget->AddWait(*this->account, this->bytes, _stop);
+  return this->reserved;
+}
+
+//////////////////////////////////////////////////
+void MemoryBudget::Charge::Force()
+{
+  if (!this->account || this->reserved)
+    return;
+
+  this->account->budget->Add(*this->account, this->bytes, true);
+  this->reserved = true;
+}
+
+//////////////////////////////////////////////////
+void MemoryBudget::Charge::Release()
+{
+  if (!this->reserved)
+    return;
+
+  this->account->budget->Sub(*this->account, this->bytes);
+  this->reserved = false;
+}
+
+//////////////////////////////////////////////////
+std::size_t MemoryBudget::Charge::Bytes() const
+{
+  return this->reserved ? this->bytes : 0u;
+}
+
+//////////////////////////////////////////////////
+MemoryBudget::MemoryBudget(const uint64_t _limit)
+  : limit(_limit)
+{
+}
+
+//////////////////////////////////////////////////
+MemoryBudget::Account *MemoryBudget::Topic(const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  auto &account = this->accounts[_topic];
+  if (!account)
+  {
+    account.reset(new Account());
+    account->topic = _topic;
+    account->budget = this;
+  }
+  return account.get();
+}
+
+//////////////////////////////////////////////////
+uint64_t MemoryBudget::Limit() const
+{
+  return this->limit;
+}
+
+//////////////////////////////////////////////////
+uint64_t MemoryBudget::Used() const
+{
+  return this->used.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t MemoryBudget::Used(const std::string &_topic) const
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  auto it = this->accounts.find(_topic);
+  if (it == this->accounts.end())
+    return 0u;
+  return it->second->used.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t MemoryBudget::Peak() const
+{
+  return this->peak.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+std::map<std::string, uint64_t> MemoryBudget::Usage() const
+{
+  std::map<std::string, uint64_t> usage;
+  std::lock_guard<std::mutex> lk(this->mutex);
+  for (const auto &[topic, account] : this->accounts)
+    usage[topic] = account->used.load(std::memory_order_relaxed);
+  return usage;
+}
+
+//////////////////////////////////////////////////
+void MemoryBudget::Interrupt()
+{
+  std::lock_guard<std::mutex> lk(this->waitMutex);
+  this->released.notify_all();
+}
+
+//////////////////////////////////////////////////
+void MemoryBudget::CountRejected()
+{
+  this->rejected.fetch_add(1, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t MemoryBudget::Rejected() const
+{
+  return this->rejected.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+bool MemoryBudget::Add(Account &_account, const std::size_t _bytes,
+  const bool _force)
+{
+  uint64_t current = this->used.load(std::memory_order_seq_cst);
+  uint64_t next;
+  do
+  {
+    next = current + _bytes;
+    if (!_force && this->limit > 0 && next > this->limit)
+      return false;
+  }
+  while (!this->used.compare_exchange_weak(current, next,
+           std::memory_order_relaxed));
+
+  _account.used.fetch_add(_bytes, std::memory_order_relaxed);
+
+  uint64_t peakValue = this->peak.load(std::memory_order_relaxed);
+  while (next > peakValue &&
+         !this->peak.compare_exchange_weak(peakValue, next,
+           std::memory_order_relaxed))
+  {
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool MemoryBudget::AddWait(Account &_account, const std::size_t _bytes,
+  const std::atomic<bool> &_stop)
+{
+  if (this->Add(_account, _bytes, false))
+    return true;
+
+  bool added = false;
+  std::unique_lock<std::mutex> lk(this->waitMutex);
+  // Announce the wait before checking the room again, so a concurrent Sub()
+  // either frees the room seen here or notifies under the lock.
+  this->waiters.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  this->released.wait(lk, [&]()
+  {
+    added = this->Add(_account, _bytes, false);
+    return added || _stop;
+  });
+  this->waiters.fetch_sub(1, std::memory_order_relaxed);
+  return added;
+}
+
+//////////////////////////////////////////////////
+void MemoryBudget::Sub(Account &_account, const std::size_t _bytes)
+{
+  _account.used.fetch_sub(_bytes, std::memory_order_relaxed);
+  this->used.fetch_sub(_bytes, std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (this->waiters.load(std::memory_order_relaxed) > 0)
+  {
+    std::lock_guard<std::mutex> lk(this->waitMutex);
+    this->released.notify_all();
+  }
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_MEMORYBUDGET_HH_
+#define GZ_TRANSPORT_MEMORYBUDGET_HH_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Memory held by the transport buffers of the process, per
+    /// topic, with an optional limit, see GZ_TRANSPORT_MEMORY_BUDGET.
+    ///
+    /// Every buffer is charged to the account of its topic when it is kept
+    /// and released when it is freed. The charges only use atomic
+    /// operations; the accounts are created once per topic and never
+    /// removed, so they can be kept by the publishers.
+    class GZ_TRANSPORT_VISIBLE MemoryBudget
+    {
+      /// \brief Bytes held for a topic.
+      public: class Account
+      {
+        /// \brief Fully qualified topic name.
+        public: std::string topic;
+
+        /// \brief Budget of the account.
+        public: MemoryBudget *budget = nullptr;
+
+        /// \brief Bytes held.
+        public: std::atomic<uint64_t> used{0};
+      };
+
+      /// \brief Bytes charged to an account, released by the destructor.
+      public: class GZ_TRANSPORT_VISIBLE Charge
+      {
+        /// \brief Constructor of an empty charge.
+        public: Charge() = default;
+
+        /// \brief Constructor. The bytes are not charged until Reserve()
+        /// or Force() is called.
+        /// \param[in] _account Account to charge, or nullptr to charge
+        /// nothing.
+        /// \param[in] _bytes Number of bytes.
+        public: Charge(Account *_account, const std::size_t _bytes);
+
+        /// \brief Move constructor.
+        /// \param[in] _other Charge moved, left empty.
+        public: Charge(Charge &&_other) noexcept;
+
+        /// \brief Move assignment.
+        /// \param[in] _other Charge moved, left empty.
+        /// \return This charge.
+        public: Charge &operator=(Charge &&_other) noexcept;
+
+        /// \brief Destructor. Releases the bytes.
+        public: ~Charge();
+
+        /// \brief Charge the bytes, unless they would exceed the limit of
+        /// the budget.
+        /// \return False if the limit would be exceeded.
+        public: bool Reserve();
+
+        /// \brief Charge the bytes, waiting for other charges to be
+        /// released while they would exceed the limit.
+        /// \param[in] _stop Flag that ends the wait when set. Interrupt()
+        /// must be called after setting it.
+        /// \return False if the wait was stopped before the bytes could be
+        /// charged.
+        public: bool Reserve(const std::atomic<bool> &_stop);
+
+        /// \brief Charge the bytes even if they exceed the limit.
+        public: void Force();
+
+        /// \brief Release the bytes, if they were charged.
+        public: void Release();
+
+        /// \brief Get the number of bytes charged.
+        /// \return The number of bytes, 0 until they are charged.
+        public: std::size_t Bytes() const;
+
+        /// \brief Account charged.
+        private: Account *account = nullptr;
+
+        /// \brief Number of bytes.
+        private: std::size_t bytes = 0;
+
+        /// \brief Whether the bytes are charged.
+        private: bool reserved = false;
+      };
+
+      /// \brief Constructor.
+      /// \param[in] _limit Maximum number of bytes, or 0 for no limit.
+      public: explicit MemoryBudget(const uint64_t _limit = 0);
+
+      /// \brief No copy.
+      public: MemoryBudget(const MemoryBudget &) = delete;
+
+      /// \brief No assignment.
+      public: MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+      /// \brief Get the account of a topic, creating it if needed.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The account. It remains valid for the lifetime of the
+      /// budget.
+      public: Account *Topic(const std::string &_topic);
+
+      /// \brief Get the limit.
+      /// \return Maximum number of bytes, or 0 for no limit.
+      public: uint64_t Limit() const;
+
+      /// \brief Get the number of bytes held.
+      /// \return The number of bytes.
+      public: uint64_t Used() const;
+
+      /// \brief Get the number of bytes held for a topic.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The number of bytes.
+      public: uint64_t Used(const std::string &_topic) const;
+
+      /// \brief Get the largest number of bytes held so far.
+      /// \return The number of bytes.
+      public: uint64_t Peak() const;
+
+      /// \brief Get the number of bytes held for every topic.
+      /// \return Map of topic names to numbers of bytes.
+      public: std::map<std::string, uint64_t> Usage() const;
+
+      /// \brief Wake up the charges waiting for room, so they check their
+      /// stop flag.
+      public: void Interrupt();
+
+      /// \brief Count a buffer dropped because the budget was exhausted.
+      public: void CountRejected();
+
+      /// \brief Get the number of buffers dropped because the budget was
+      /// exhausted.
+      /// \return The number of buffers.
+      public: uint64_t Rejected() const;
+
+      /// \brief Charge bytes.
+      /// \param[in] _account Account to charge.
+      /// \param[in] _bytes Number of bytes.
+      /// \param[in] _force Whether to charge them even above the limit.
+      /// \return False if the limit would be exceeded.
+      private: bool Add(Account &_account, const std::size_t _bytes,
+                        const bool _force);
+
+      /// \brief Charge bytes, waiting for room while they would exceed the
+      /// limit.
+      /// \param[in] _account Account to charge.
+      /// \param[in] _bytes Number of bytes.
+      /// \param[in] _stop Flag that ends the wait.
+      /// \return False if the wait was stopped.
+      private: bool AddWait(Account &_account, const std::size_t _bytes,
+                            const std::atomic<bool> &_stop);
+
+      /// \brief Release bytes.
+      /// \param[in] _account Account charged.
+      /// \param[in] _bytes Number of bytes.
+      private: void Sub(Account &_account, const std::size_t _bytes);
+
+      /// \brief Maximum number of bytes, or 0.
+      private: const uint64_t limit;
+
+      /// \brief Bytes held.
+      private: std::atomic<uint64_t> used{0};
+
+      /// \brief Largest number of bytes held.
+      private: std::atomic<uint64_t> peak{0};
+
+      /// \brief Number of buffers dropped.
+      private: std::atomic<uint64_t> rejected{0};
+
+      /// \brief Number of charges waiting for room. Sub() only takes
+      /// waitMutex when there are some.
+      private: std::atomic<uint32_t> waiters{0};
+
+      /// \brief Protects the waits for room.
+      private: std::mutex waitMutex;
+
+      /// \brief Signaled when bytes are released or on Interrupt().
+      private: std::condition_variable released;
+
+      /// \brief Protects accounts.
+      private: mutable std::mutex mutex;
+
+      /// \brief Accounts by topic.
+      private: std::map<std::string, std::unique_ptr<Account>> accounts;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MemoryBudget.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Charge and release bytes on several topics.
+TEST(MemoryBudgetTest, Accounting)
+{
+  MemoryBudget budget;
+  EXPECT_EQ(0u, budget.Limit());
+
+  MemoryBudget::Account *foo = budget.Topic("/foo");
+  EXPECT_EQ(foo, budget.Topic("/foo"));
+  MemoryBudget::Account *bar = budget.Topic("/bar");
+
+  {
+    MemoryBudget::Charge charge1(foo, 100);
+    EXPECT_EQ(0u, charge1.Bytes());
+    EXPECT_TRUE(charge1.Reserve());
+    EXPECT_EQ(100u, charge1.Bytes());
+
+    MemoryBudget::Charge charge2(bar, 30);
+    EXPECT_TRUE(charge2.Reserve());
+    EXPECT_EQ(130u, budget.Used());
+    EXPECT_EQ(100u, budget.Used("/foo"));
+    EXPECT_EQ(30u, budget.Used("/bar"));
+    EXPECT_EQ(0u, budget.Used("/unknown"));
+
+    // Moving a charge doesn't release it.
+    MemoryBudget::Charge moved(std::move(charge1));
+    EXPECT_EQ(130u, budget.Used());
+
+    auto usage = budget.Usage();
+    ASSERT_EQ(2u, usage.size());
+    EXPECT_EQ(100u, usage["/foo"]);
+    EXPECT_EQ(30u, usage["/bar"]);
+  }
+
+  EXPECT_EQ(0u, budget.Used());
+  EXPECT_EQ(0u, budget.Used("/foo"));
+  EXPECT_EQ(130u, budget.Peak());
+
+  // A charge without account is free.
+  MemoryBudget::Charge none(nullptr, 10);
+  EXPECT_TRUE(none.Reserve());
+  EXPECT_EQ(0u, budget.Used());
+}
+
+//////////////////////////////////////////////////
+/// \brief The limit rejects the charges that don't fit, unless forced.
+TEST(MemoryBudgetTest, Limit)
+{
+  MemoryBudget budget(100);
+  MemoryBudget::Account *foo = budget.Topic("/foo");
+
+  std::vector<MemoryBudget::Charge> charges;
+  charges.emplace_back(foo, 60);
+  EXPECT_TRUE(charges.back().Reserve());
+  charges.emplace_back(foo, 60);
+  EXPECT_FALSE(charges.back().Reserve());
+  EXPECT_EQ(60u, budget.Used());
+
+  charges.emplace_back(foo, 40);
+  EXPECT_TRUE(charges.back().Reserve());
+  EXPECT_EQ(100u, budget.Used());
+
+  charges.emplace_back(foo, 10);
+  charges.back().Force();
+  EXPECT_EQ(110u, budget.Used());
+
+  // Releasing makes room again.
+  charges.front().Release();
+  EXPECT_EQ(50u, budget.Used());
+  EXPECT_FALSE(charges[1].Reserve());
+  charges[2].Release();
+  EXPECT_TRUE(charges[1].Reserve());
+  EXPECT_EQ(70u, budget.Used());
+
+  EXPECT_EQ(0u, budget.Rejected());
+  budget.CountRejected();
+  EXPECT_EQ(1u, budget.Rejected());
+
+  charges.clear();
+  EXPECT_EQ(0u, budget.Used());
+}
+
+//////////////////////////////////////////////////
+/// \brief A blocking reservation waits until other charges are released.
+TEST(MemoryBudgetTest, WaitForRoom)
+{
+  MemoryBudget budget(100);
+  MemoryBudget::Account *foo = budget.Topic("/foo");
+  std::atomic<bool> stop{false};
+
+  MemoryBudget::Charge first(foo, 80);
+  EXPECT_TRUE(first.Reserve());
+
+  std::atomic<bool> done{false};
+  MemoryBudget::Charge second(foo, 50);
+  std::thread waiter([&]()
+  {
+    EXPECT_TRUE(second.Reserve(stop));
+    done = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(done);
+  first.Release();
+  waiter.join();
+  EXPECT_TRUE(done);
+  EXPECT_EQ(50u, budget.Used());
+}
+
+//////////////////////////////////////////////////
+/// \brief A blocking reservation gives up when its stop flag is set.
+TEST(MemoryBudgetTest, WaitInterrupted)
+{
+  MemoryBudget budget(100);
+  MemoryBudget::Account *foo = budget.Topic("/foo");
+  std::atomic<bool> stop{false};
+
+  MemoryBudget::Charge first(foo, 80);
+  EXPECT_TRUE(first.Reserve());
+
+  MemoryBudget::Charge second(foo, 50);
+  std::thread waiter([&]()
+  {
+    EXPECT_FALSE(second.Reserve(stop));
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  stop = true;
+  budget.Interrupt();
+  waiter.join();
+  EXPECT_EQ(80u, budget.Used());
+}
@@ -15,6 +15,13 @@
  *
 */
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 #include "gz/transport/MessageInfo.hh"
@@ -50,6 +57,21 @@ namespace gz
 
       /// \brief Was the message sent via intra-process?
       public: bool isIntraProcess = false;
+
+      /// \brief File descriptor shared by the copies, or nullptr.
+      public: std::shared_ptr<const int> fd;
+
+      /// \brief Publication time, or the epoch.
+      public: std::chrono::system_clock::time_point publicationTime;
+
+      /// \brief Reception time, or the epoch.
+      public: std::chrono::system_clock::time_point receptionTime;
+
+      /// \brief Sequence number of the publication.
+      public: uint64_t seq = 0;
+
+      /// \brief Process UUID of the publisher.
+      public: std::string publisherUuid = "";
     };
     }
   }
@@ -74,6 +96,19 @@ MessageInfo::MessageInfo(MessageInfo &&_other)  // NOLINT
 {
 }
 
+//////////////////////////////////////////////////
+MessageInfo &MessageInfo::operator=(const MessageInfo &_other)
+{
+  if (this == &_other)
+    return *this;
+
+  // This instance may have been moved from.
+  if (!this->dataPtr)
+    this->dataPtr.reset(new MessageInfoPrivate());
+  *this->dataPtr = *_other.dataPtr;
+  return *this;
+}
+
 //////////////////////////////////////////////////
 MessageInfo::~MessageInfo()
 {
@@ -135,3 +170,84 @@ void MessageInfo::SetIntraProcess(bool _value)
 {
   this->dataPtr->isIntraProcess = _value;
 }
+
+//////////////////////////////////////////////////
+int MessageInfo::Fd() const
+{
+  return this->dataPtr->fd ? *this->dataPtr->fd : -1;
+}
+
+//////////////////////////////////////////////////
+void MessageInfo::SetFd(int _fd)
+{
+  if (_fd < 0)
+  {
+    this->dataPtr->fd.reset();
+    return;
+  }
+
+  this->dataPtr->fd.reset(new int(_fd), [](const int *_ptr)
+  {
+#ifndef _WIN32
+    close(*_ptr);
+#endif
+    delete _ptr;
+  });
+}
+
+//////////////////////////////////////////////////
+bool MessageInfo::HasMetadata() const
+{
+  return this->dataPtr->publicationTime !=
+    std::chrono::system_clock::time_point();
+}
+
+//////////////////////////////////////////////////
+std::chrono::system_clock::time_point MessageInfo::PublicationTime() const
+{
+  return this->dataPtr->publicationTime;
+}
+
+//////////////////////////////////////////////////
+void MessageInfo::SetPublicationTime(
+  const std::chrono::system_clock::time_point &_time)
+{
+  this->dataPtr->publicationTime = _time;
+}
+
+//////////////////////////////////////////////////
+std::chrono::system_clock::time_point MessageInfo::ReceptionTime() const
+{
+  return this->dataPtr->receptionTime;
+}
+
+//////////////////////////////////////////////////
+void MessageInfo::SetReceptionTime(
+  const std::chrono::system_clock::time_point &_time)
+{
+  this->dataPtr->receptionTime = _time;
+}
+
+//////////////////////////////////////////////////
+uint64_t MessageInfo::SequenceNumber() const
+{
+  return this->dataPtr->seq;
+}
+
+//////////////////////////////////////////////////
+void MessageInfo::SetSequenceNumber(uint64_t _seq)
+{
+  this->dataPtr->seq = _seq;
+}
+
+//////////////////////////////////////////////////
+const std::string &MessageInfo::PublisherUuid() const
+{
+  return this->dataPtr->publisherUuid;
+}
+
+//////////////////////////////////////////////////
+void MessageInfo::SetPublisherUuid(const std::string &_pUuid)
+{
+  this->dataPtr->publisherUuid = _pUuid;
+}
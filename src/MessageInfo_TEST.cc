@@ -15,7 +15,13 @@
  *
 */
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <chrono>
 #include <string>
+#include <utility>
 
 #include "gz/transport/MessageInfo.hh"
 #include "gtest/gtest.h"
@@ -111,6 +117,62 @@ TEST(MessageInfoTest, InterProcess)
   EXPECT_FALSE(info.IntraProcess());
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that the copies share the file descriptor, which is closed
+/// with the last one.
+TEST(MessageInfoTest, Fd)
+{
+  transport::MessageInfo info;
+  EXPECT_EQ(-1, info.Fd());
+
+#ifndef _WIN32
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  info.SetFd(pipeFds[1]);
+  EXPECT_EQ(pipeFds[1], info.Fd());
+
+  {
+    transport::MessageInfo infoCopy(info);
+    info = transport::MessageInfo();
+    EXPECT_EQ(-1, info.Fd());
+    EXPECT_EQ(pipeFds[1], infoCopy.Fd());
+    EXPECT_EQ(1, write(infoCopy.Fd(), "x", 1));
+  }
+
+  // The write end is closed, so the reader sees the data then the end.
+  char buffer[2];
+  EXPECT_EQ(1, read(pipeFds[0], buffer, 2));
+  EXPECT_EQ(0, read(pipeFds[0], buffer, 2));
+  close(pipeFds[0]);
+#endif
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the publication metadata.
+TEST(MessageInfoTest, Metadata)
+{
+  transport::MessageInfo info;
+  EXPECT_FALSE(info.HasMetadata());
+  EXPECT_EQ(0u, info.SequenceNumber());
+  EXPECT_TRUE(info.PublisherUuid().empty());
+
+  const auto published = std::chrono::system_clock::now();
+  const auto received = published + std::chrono::microseconds(250);
+  info.SetPublicationTime(published);
+  info.SetReceptionTime(received);
+  info.SetSequenceNumber(42);
+  info.SetPublisherUuid("publisher");
+  EXPECT_TRUE(info.HasMetadata());
+
+  transport::MessageInfo infoCopy(info);
+  EXPECT_EQ(published, infoCopy.PublicationTime());
+  EXPECT_EQ(received, infoCopy.ReceptionTime());
+  EXPECT_EQ(std::chrono::microseconds(250),
+    infoCopy.ReceptionTime() - infoCopy.PublicationTime());
+  EXPECT_EQ(42u, infoCopy.SequenceNumber());
+  EXPECT_EQ("publisher", infoCopy.PublisherUuid());
+}
+
 //////////////////////////////////////////////////
 /// \brief Check Copy constructor.
 TEST(MessageInfoTest, CopyConstructor)
@@ -126,3 +188,23 @@ TEST(MessageInfoTest, CopyConstructor)
   EXPECT_EQ("/b_topic", infoCopy.Topic());
   EXPECT_TRUE(infoCopy.IntraProcess());
 }
+
+//////////////////////////////////////////////////
+/// \brief Check the copy assignment operator.
+TEST(MessageInfoTest, CopyAssignment)
+{
+  transport::MessageInfo info;
+  info.SetTopicAndPartition("@/a_partition@/b_topic");
+  info.SetType("gz.msgs.Int32");
+
+  transport::MessageInfo infoCopy;
+  infoCopy = info;
+  EXPECT_EQ("/a_partition", infoCopy.Partition());
+  EXPECT_EQ("/b_topic", infoCopy.Topic());
+  EXPECT_EQ("gz.msgs.Int32", infoCopy.Type());
+
+  // Assign to a moved-from instance.
+  transport::MessageInfo moved(std::move(infoCopy));
+  infoCopy = info;
+  EXPECT_EQ("/b_topic", infoCopy.Topic());
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/pose_v.pb.h>
+
+#include <memory>
+#include <string>
+
+#include "gz/transport/MessagePool.hh"
+#include "gz/transport/SubscribeOptions.hh"
+#include "gz/transport/SubscriptionHandler.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Check that released messages are recycled.
+TEST(MessagePoolTest, Recycle)
+{
+  MessagePool<msgs::Int32> pool(2u);
+  EXPECT_EQ(0u, pool.IdleCount());
+
+  auto msg1 = pool.Acquire();
+  ASSERT_NE(nullptr, msg1);
+  msgs::Int32 *first = msg1.get();
+  msg1.reset();
+  EXPECT_EQ(1u, pool.IdleCount());
+
+  // The idle message is reused.
+  auto msg2 = pool.Acquire();
+  EXPECT_EQ(first, msg2.get());
+  EXPECT_EQ(0u, pool.IdleCount());
+
+  // No more than the maximum number of idle messages is kept.
+  auto msg3 = pool.Acquire();
+  auto msg4 = pool.Acquire();
+  msg2.reset();
+  msg3.reset();
+  msg4.reset();
+  EXPECT_EQ(2u, pool.IdleCount());
+}
+
+//////////////////////////////////////////////////
+/// \brief A message can outlive its pool.
+TEST(MessagePoolTest, OutlivePool)
+{
+  std::shared_ptr<msgs::Int32> msg;
+  {
+    MessagePool<msgs::Int32> pool;
+    msg = pool.Acquire();
+  }
+  ASSERT_NE(nullptr, msg);
+  msg->set_data(3);
+  EXPECT_EQ(3, msg->data());
+  msg.reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief A subscription that reuses messages parses every message into a
+/// recycled object, without leftovers of the previous message.
+TEST(MessagePoolTest, SubscriptionHandler)
+{
+  msgs::Pose_V poses;
+  for (int i = 0; i < 10; ++i)
+  {
+    auto *pose = poses.add_pose();
+    pose->set_name("pose_" + std::to_string(i));
+    pose->mutable_position()->set_x(i);
+  }
+  std::string data;
+  ASSERT_TRUE(poses.SerializeToString(&data));
+
+  msgs::Pose_V fewer;
+  fewer.add_pose()->set_name("single");
+  std::string fewerData;
+  ASSERT_TRUE(fewer.SerializeToString(&fewerData));
+
+  SubscribeOptions opts;
+  opts.SetReuseMessages(true);
+  SubscriptionHandler<msgs::Pose_V> handler("nUuid", opts);
+
+  auto msg = handler.CreateMsg(data, poses.GetTypeName());
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ(poses.DebugString(), msg->DebugString());
+  const ProtoMsg *first = msg.get();
+  msg.reset();
+
+  // The next message reuses the same object.
+  msg = handler.CreateMsg(fewerData, fewer.GetTypeName());
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ(first, msg.get());
+  EXPECT_EQ(fewer.DebugString(), msg->DebugString());
+
+  // Messages still in use are not shared.
+  auto other = handler.CreateMsg(data, poses.GetTypeName());
+  ASSERT_NE(nullptr, other);
+  EXPECT_NE(msg.get(), other.get());
+
+  // Arenas take precedence.
+  opts.SetUseArena(true);
+  SubscriptionHandler<msgs::Pose_V> arenaHandler("nUuid", opts);
+  msg = arenaHandler.CreateMsg(data, poses.GetTypeName());
+  ASSERT_NE(nullptr, msg);
+  EXPECT_NE(nullptr, msg->GetArena());
+}
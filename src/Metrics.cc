@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "gz/transport/Helpers.hh"
+#include "gz/transport/Metrics.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Number of stripes of every counter.
+  constexpr std::size_t kStripes = 8;
+
+  /// \brief Description of a counter in the OpenMetrics output.
+  struct CounterDesc
+  {
+    /// \brief Metric name, without the "_total" suffix.
+    const char *name;
+
+    /// \brief Description.
+    const char *help;
+
+    /// \brief Whether the counter holds nanoseconds, rendered as seconds.
+    bool nanoseconds;
+  };
+
+  /// \brief Descriptions, in the order of Metrics::Counter.
+  const std::array<CounterDesc, Metrics::kCounterCount> kCounterDescs =
+  {{
+    {"gz_transport_topic_messages_sent", "Messages published.", false},
+    {"gz_transport_topic_bytes_sent", "Bytes sent to remote subscribers.",
+      false},
+    {"gz_transport_topic_serialization_seconds",
+      "Time spent serializing the published messages.", true},
+    {"gz_transport_topic_messages_received",
+      "Messages received from remote publishers.", false},
+    {"gz_transport_topic_bytes_received",
+      "Bytes received from remote publishers.", false},
+    {"gz_transport_topic_messages_dropped",
+      "Messages dropped by the subscription queues.", false},
+    {"gz_transport_topic_messages_recovered",
+      "Messages of a reliable topic lost, then received again.", false},
+    {"gz_transport_topic_messages_lost",
+      "Messages of a reliable topic lost for good.", false},
+    {"gz_transport_service_requests_sent", "Requests sent.", false},
+    {"gz_transport_service_responses_received",
+      "Successful responses received.", false},
+    {"gz_transport_service_requests_failed",
+      "Requests that failed or expired.", false},
+    {"gz_transport_service_request_latency_seconds",
+      "Total latency of the completed requests.", true},
+    {"gz_transport_service_requests_served",
+      "Requests served by the responders.", false},
+    {"gz_transport_service_serve_seconds",
+      "Time spent in the responder callbacks.", true}
+  }};
+
+  /// \brief Get the stripe of the current thread.
+  /// \return Stripe index.
+  std::size_t ThreadStripe()
+  {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t stripe = next++ % kStripes;
+    return stripe;
+  }
+
+  /// \brief Escape a label value.
+  /// \param[in] _value Label value.
+  /// \return The escaped value.
+  std::string EscapeLabel(const std::string &_value)
+  {
+    std::string escaped;
+    escaped.reserve(_value.size());
+    for (const char c : _value)
+    {
+      if (c == '\\' || c == '"')
+      {
+        escaped += '\\';
+        escaped += c;
+      }
+      else if (c == '\n')
+      {
+        escaped += "\\n";
+      }
+      else
+      {
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
+}
+
+/// \brief Counters of a topic or a service.
+class gz::transport::Metrics::Entry
+{
+  /// \brief Counters written by a subset of the threads. Every stripe uses
+  /// its own cache lines.
+  public: struct alignas(64) Stripe
+  {
+    /// \brief Counters, indexed by Metrics::Counter.
+    public: std::array<std::atomic<uint64_t>, kCounterCount> counters{};
+  };
+
+  /// \brief Get the value of a counter.
+  /// \param[in] _counter Counter.
+  /// \return The sum of the stripes.
+  public: uint64_t Total(const Counter _counter) const
+  {
+    uint64_t total = 0;
+    for (const auto &stripe : this->stripes)
+    {
+      total += stripe.counters[static_cast<std::size_t>(_counter)].load(
+        std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /// \brief Stripes.
+  public: std::array<Stripe, kStripes> stripes{};
+
+  /// \brief Latency of the completed requests (microseconds). Only
+  /// services have one.
+  public: std::unique_ptr<LatencyHistogram> latency;
+};
+
+/// \brief Private data of the Metrics class.
+class gz::transport::MetricsPrivate
+{
+  /// \brief A gauge.
+  public: struct Gauge
+  {
+    /// \brief Description.
+    public: std::string help;
+
+    /// \brief Function returning the value, unless it is a family.
+    public: std::function<double()> value;
+
+    /// \brief Name of the label of a family.
+    public: std::string label;
+
+    /// \brief Function returning the values of a family, by label value.
+    public: std::function<std::map<std::string, double>()> values;
+  };
+
+  /// \brief Map of entries, sorted to keep the output stable.
+  public: using Entries = std::map<std::string,
+                                   std::unique_ptr<Metrics::Entry>>;
+
+  /// \brief Find or create the entry of a topic or a service. The entries
+  /// found by a thread are cached without locking.
+  /// \param[in] _entries Entries of the topics or of the services.
+  /// \param[in, out] _cache Cache of the current thread.
+  /// \param[in] _name Fully qualified name.
+  /// \param[in] _service Whether the entry belongs to a service.
+  /// \return The entry.
+  public: Metrics::Entry *Find(Entries &_entries,
+    std::unordered_map<std::string, Metrics::Entry *> &_cache,
+    const std::string &_name, const bool _service)
+  {
+    auto cached = _cache.find(_name);
+    if (cached != _cache.end())
+      return cached->second;
+
+    Metrics::Entry *entry = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      auto &slot = _entries[_name];
+      if (!slot)
+      {
+        slot.reset(new Metrics::Entry);
+        if (_service)
+          slot->latency.reset(new LatencyHistogram);
+      }
+      entry = slot.get();
+    }
+
+    _cache.emplace(_name, entry);
+    return entry;
+  }
+
+  /// \brief Find an existing entry.
+  /// \param[in] _entries Entries of the topics or of the services.
+  /// \param[in] _name Fully qualified name.
+  /// \return The entry or nullptr.
+  public: const Metrics::Entry *Get(const Entries &_entries,
+    const std::string &_name) const
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    auto it = _entries.find(_name);
+    return it == _entries.end() ? nullptr : it->second.get();
+  }
+
+  /// \brief Whether the metrics are collected.
+  public: std::atomic<bool> enabled{true};
+
+  /// \brief Protects the maps. The counters themselves are atomic.
+  public: mutable std::mutex mutex;
+
+  /// \brief Counters of the topics.
+  public: Entries topics;
+
+  /// \brief Counters of the services.
+  public: Entries services;
+
+  /// \brief Gauges.
+  public: std::map<std::string, Gauge> gauges;
+};
+
+namespace
+{
+  /// \brief Topic entries cached by the current thread.
+  thread_local std::unordered_map<std::string, Metrics::Entry *> tTopics;
+
+  /// \brief Service entries cached by the current thread.
+  thread_local std::unordered_map<std::string, Metrics::Entry *> tServices;
+}
+
+//////////////////////////////////////////////////
+Metrics &Metrics::Instance()
+{
+  // Never destroyed: the counters may be updated by threads that outlive
+  // the static objects.
+  static Metrics *instance = new Metrics();
+  return *instance;
+}
+
+//////////////////////////////////////////////////
+Metrics::Metrics()
+  : dataPtr(new MetricsPrivate)
+{
+  std::string value;
+  if (env("GZ_TRANSPORT_METRICS", value) && value == "0")
+    this->dataPtr->enabled = false;
+}
+
+//////////////////////////////////////////////////
+Metrics::~Metrics() = default;
+
+//////////////////////////////////////////////////
+bool Metrics::Enabled() const
+{
+  return this->dataPtr->enabled;
+}
+
+//////////////////////////////////////////////////
+void Metrics::SetEnabled(const bool _enabled)
+{
+  this->dataPtr->enabled = _enabled;
+}
+
+//////////////////////////////////////////////////
+Metrics::Entry *Metrics::Topic(const std::string &_topic)
+{
+  if (!this->dataPtr->enabled)
+    return nullptr;
+
+  return this->dataPtr->Find(this->dataPtr->topics, tTopics, _topic, false);
+}
+
+//////////////////////////////////////////////////
+Metrics::Entry *Metrics::Service(const std::string &_service)
+{
+  if (!this->dataPtr->enabled)
+    return nullptr;
+
+  return this->dataPtr->Find(this->dataPtr->services, tServices, _service,
+    true);
+}
+
+//////////////////////////////////////////////////
+void Metrics::Add(Entry *_entry, const Counter _counter,
+  const uint64_t _value)
+{
+  if (!_entry)
+    return;
+
+  _entry->stripes[ThreadStripe()].counters[
+    static_cast<std::size_t>(_counter)].fetch_add(_value,
+      std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+void Metrics::RecordRequest(const std::string &_service,
+  const std::chrono::nanoseconds &_latency, const bool _result)
+{
+  Entry *entry = this->Service(_service);
+  if (!entry)
+    return;
+
+  const uint64_t latency =
+    static_cast<uint64_t>(std::max<int64_t>(_latency.count(), 0));
+  Add(entry, _result ? Counter::RESPONSES_RECEIVED : Counter::FAILED_REQUESTS);
+  Add(entry, Counter::REQUEST_LATENCY_NS, latency);
+  entry->latency->Record(latency / 1000u);
+}
+
+//////////////////////////////////////////////////
+void Metrics::RecordLocalRequest(const std::string &_service,
+  const std::chrono::nanoseconds &_latency, const bool _result)
+{
+  Entry *entry = this->Service(_service);
+  if (!entry)
+    return;
+
+  Add(entry, Counter::REQUESTS_SENT);
+  Add(entry, Counter::REQUESTS_SERVED);
+  Add(entry, Counter::SERVE_NS,
+    static_cast<uint64_t>(std::max<int64_t>(_latency.count(), 0)));
+  this->RecordRequest(_service, _latency, _result);
+}
+
+//////////////////////////////////////////////////
+uint64_t Metrics::Value(const std::string &_name,
+  const Counter _counter) const
+{
+  const bool topic = static_cast<std::size_t>(_counter) < kTopicCounterCount;
+  const Entry *entry = this->dataPtr->Get(
+    topic ? this->dataPtr->topics : this->dataPtr->services, _name);
+  return entry ? entry->Total(_counter) : 0u;
+}
+
+//////////////////////////////////////////////////
+std::map<std::string, uint64_t> Metrics::Values(
+  const Counter _counter) const
+{
+  const bool topic = static_cast<std::size_t>(_counter) < kTopicCounterCount;
+  std::map<std::string, uint64_t> values;
+
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  for (const auto &[name, entry] :
+       topic ? this->dataPtr->topics : this->dataPtr->services)
+  {
+    values[name] = entry->Total(_counter);
+  }
+  return values;
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram Metrics::RequestLatency(const std::string &_service) const
+{
+  const Entry *entry = this->dataPtr->Get(this->dataPtr->services, _service);
+  return entry ? *entry->latency : LatencyHistogram();
+}
+
+//////////////////////////////////////////////////
+void Metrics::SetGauge(const std::string &_name, const std::string &_help,
+  std::function<double()> _value)
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  this->dataPtr->gauges[_name] = {_help, std::move(_value), "", nullptr};
+}
+
+//////////////////////////////////////////////////
+void Metrics::SetGaugeFamily(const std::string &_name,
+  const std::string &_help, const std::string &_label,
+  std::function<std::map<std::string, double>()> _values)
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  this->dataPtr->gauges[_name] = {_help, nullptr, _label, std::move(_values)};
+}
+
+//////////////////////////////////////////////////
+void Metrics::RemoveGauge(const std::string &_name)
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  this->dataPtr->gauges.erase(_name);
+}
+
+//////////////////////////////////////////////////
+std::string Metrics::OpenMetrics() const
+{
+  std::ostringstream out;
+  out << std::setprecision(12);
+
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+
+  for (std::size_t i = 0; i < kCounterCount; ++i)
+  {
+    // The total latency is the sum of the latency summary below.
+    if (static_cast<Counter>(i) == Counter::REQUEST_LATENCY_NS)
+      continue;
+
+    const bool topic = i < kTopicCounterCount;
+    const auto &entries = topic ? this->dataPtr->topics :
+      this->dataPtr->services;
+    const CounterDesc &desc = kCounterDescs[i];
+
+    out << "# TYPE " << desc.name << " counter\n"
+        << "# HELP " << desc.name << " " << desc.help << "\n";
+    for (const auto &[name, entry] : entries)
+    {
+      const uint64_t value = entry->Total(static_cast<Counter>(i));
+      out << desc.name << "_total{" << (topic ? "topic" : "service")
+          << "=\"" << EscapeLabel(name) << "\"} ";
+      if (desc.nanoseconds)
+        out << static_cast<double>(value) / 1e9 << "\n";
+      else
+        out << value << "\n";
+    }
+  }
+
+  // Percentiles of the request latencies.
+  const char *kLatency = "gz_transport_service_request_latency_seconds";
+  out << "# TYPE " << kLatency << " summary\n"
+      << "# UNIT " << kLatency << " seconds\n"
+      << "# HELP " << kLatency << " Latency of the completed requests.\n";
+  for (const auto &[name, entry] : this->dataPtr->services)
+  {
+    const std::string label = "service=\"" + EscapeLabel(name) + "\"";
+    for (const auto &[quantile, percentile] :
+         {std::make_pair("0.5", 50.0), std::make_pair("0.99", 99.0),
+          std::make_pair("0.999", 99.9)})
+    {
+      out << kLatency << "{" << label << ",quantile=\"" << quantile
+          << "\"} "
+          << static_cast<double>(entry->latency->Percentile(percentile)) / 1e6
+          << "\n";
+    }
+    out << kLatency << "_count{" << label << "} "
+        << entry->latency->Count() << "\n";
+    out << kLatency << "_sum{" << label << "} "
+        << static_cast<double>(entry->Total(Counter::REQUEST_LATENCY_NS)) /
+           1e9 << "\n";
+  }
+
+  for (const auto &[name, gauge] : this->dataPtr->gauges)
+  {
+    out << "# TYPE " << name << " gauge\n"
+        << "# HELP " << name << " " << gauge.help << "\n";
+    if (!gauge.values)
+    {
+      out << name << " " << gauge.value() << "\n";
+      continue;
+    }
+
+    for (const auto &[labelValue, value] : gauge.values())
+    {
+      out << name << "{" << gauge.label << "=\"" << EscapeLabel(labelValue)
+          << "\"} " << value << "\n";
+    }
+  }
+
+  out << "# EOF\n";
+  return out.str();
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Metrics.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+TEST(MetricsTest, Counters)
+{
+  Metrics &metrics = Metrics::Instance();
+  ASSERT_TRUE(metrics.Enabled());
+
+  Metrics::Entry *entry = metrics.Topic("@/counters");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(entry, metrics.Topic("@/counters"));
+  EXPECT_NE(entry, metrics.Service("@/counters"));
+
+  // Every thread writes its own stripe, the reader sums them.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&metrics]()
+    {
+      Metrics::Entry *mine = metrics.Topic("@/counters");
+      for (int j = 0; j < 1000; ++j)
+      {
+        Metrics::Add(mine, Metrics::Counter::MSGS_SENT);
+        Metrics::Add(mine, Metrics::Counter::BYTES_SENT, 10u);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_EQ(4000u,
+    metrics.Value("@/counters", Metrics::Counter::MSGS_SENT));
+  EXPECT_EQ(40000u,
+    metrics.Value("@/counters", Metrics::Counter::BYTES_SENT));
+  EXPECT_EQ(0u,
+    metrics.Value("@/counters", Metrics::Counter::MSGS_RECEIVED));
+  EXPECT_EQ(0u, metrics.Value("@/unknown", Metrics::Counter::MSGS_SENT));
+
+  // All the topics at once.
+  const std::map<std::string, uint64_t> values =
+    metrics.Values(Metrics::Counter::BYTES_SENT);
+  ASSERT_NE(values.end(), values.find("@/counters"));
+  EXPECT_EQ(40000u, values.at("@/counters"));
+  EXPECT_EQ(values.end(), values.find("@/unknown"));
+
+  // The topics have no service counters.
+  const std::map<std::string, uint64_t> requests =
+    metrics.Values(Metrics::Counter::REQUESTS_SENT);
+  EXPECT_EQ(requests.end(), requests.find("@/counters"));
+
+  // Nothing is counted without an entry.
+  Metrics::Add(nullptr, Metrics::Counter::MSGS_SENT);
+}
+
+//////////////////////////////////////////////////
+TEST(MetricsTest, Requests)
+{
+  Metrics &metrics = Metrics::Instance();
+  metrics.RecordRequest("@/srv", std::chrono::milliseconds(2), true);
+  metrics.RecordRequest("@/srv", std::chrono::milliseconds(4), false);
+  metrics.RecordLocalRequest("@/srv", std::chrono::milliseconds(3), true);
+
+  EXPECT_EQ(1u, metrics.Value("@/srv", Metrics::Counter::REQUESTS_SENT));
+  EXPECT_EQ(2u,
+    metrics.Value("@/srv", Metrics::Counter::RESPONSES_RECEIVED));
+  EXPECT_EQ(1u, metrics.Value("@/srv", Metrics::Counter::FAILED_REQUESTS));
+  EXPECT_EQ(1u, metrics.Value("@/srv", Metrics::Counter::REQUESTS_SERVED));
+  EXPECT_EQ(9000000u,
+    metrics.Value("@/srv", Metrics::Counter::REQUEST_LATENCY_NS));
+  EXPECT_EQ(3000000u, metrics.Value("@/srv", Metrics::Counter::SERVE_NS));
+
+  const LatencyHistogram latency = metrics.RequestLatency("@/srv");
+  EXPECT_EQ(3u, latency.Count());
+  EXPECT_NEAR(3000.0, static_cast<double>(latency.Percentile(50)), 100.0);
+  EXPECT_EQ(0u, metrics.RequestLatency("@/unknown").Count());
+}
+
+//////////////////////////////////////////////////
+TEST(MetricsTest, OpenMetrics)
+{
+  Metrics &metrics = Metrics::Instance();
+  Metrics::Add(metrics.Topic("@/open\"metrics"),
+    Metrics::Counter::MSGS_RECEIVED, 3u);
+  metrics.RecordRequest("@/open_srv", std::chrono::seconds(1), true);
+  metrics.SetGauge("test_gauge", "A gauge.", []() {return 4.5;});
+  metrics.SetGaugeFamily("test_family", "Gauges.", "topic", []()
+  {
+    return std::map<std::string, double>{{"/a", 1.0}, {"/b", 2.0}};
+  });
+
+  std::string text = metrics.OpenMetrics();
+  EXPECT_NE(std::string::npos, text.find(
+    "# TYPE gz_transport_topic_messages_received counter\n"));
+  EXPECT_NE(std::string::npos, text.find(
+    "gz_transport_topic_messages_received_total"
+    "{topic=\"@/open\\\"metrics\"} 3\n"));
+  EXPECT_NE(std::string::npos, text.find(
+    "gz_transport_service_request_latency_seconds_count"
+    "{service=\"@/open_srv\"} 1\n"));
+  EXPECT_NE(std::string::npos, text.find(
+    "gz_transport_service_request_latency_seconds_sum"
+    "{service=\"@/open_srv\"} 1\n"));
+  EXPECT_NE(std::string::npos, text.find("test_gauge 4.5\n"));
+  EXPECT_NE(std::string::npos, text.find(
+    "# TYPE test_family gauge\n# HELP test_family Gauges.\n"
+    "test_family{topic=\"/a\"} 1\ntest_family{topic=\"/b\"} 2\n"));
+  EXPECT_EQ(text.size() - 6, text.rfind("# EOF\n"));
+
+  metrics.RemoveGauge("test_gauge");
+  metrics.RemoveGauge("test_family");
+  text = metrics.OpenMetrics();
+  EXPECT_EQ(std::string::npos, text.find("test_gauge"));
+  EXPECT_EQ(std::string::npos, text.find("test_family"));
+}
+
+//////////////////////////////////////////////////
+TEST(MetricsTest, Disabled)
+{
+  Metrics &metrics = Metrics::Instance();
+  metrics.SetEnabled(false);
+  EXPECT_FALSE(metrics.Enabled());
+  EXPECT_EQ(nullptr, metrics.Topic("@/disabled"));
+  EXPECT_EQ(nullptr, metrics.Service("@/disabled"));
+  metrics.RecordRequest("@/disabled", std::chrono::seconds(1), true);
+  EXPECT_EQ(0u,
+    metrics.Value("@/disabled", Metrics::Counter::RESPONSES_RECEIVED));
+  metrics.SetEnabled(true);
+}
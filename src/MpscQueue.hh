@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_MPSCQUEUE_HH_
+#define GZ_TRANSPORT_MPSCQUEUE_HH_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Bounded lock-free multi-producer/single-consumer queue.
+    ///
+    /// The queue is a ring of cells, each one tagged with a sequence number
+    /// (D. Vyukov's bounded queue). Producers claim a slot with a single
+    /// compare-and-swap and never take a lock in the common case. The
+    /// consumer only blocks when the queue is empty: it flags itself as
+    /// sleeping and producers wake it up only when that flag is set, so an
+    /// idle consumer costs nothing and a busy one is never polled. Producers
+    /// waiting for space in a full queue are parked the same way, and woken
+    /// up by the consumer when it frees a slot.
+    ///
+    /// Depth and high-water mark counters are kept to expose backpressure.
+    template<typename T>
+    class MpscQueue
+    {
+      /// \brief Constructor.
+      /// \param[in] _capacity Maximum number of queued elements. It is
+      /// rounded up to the next power of two.
+      public: explicit MpscQueue(std::size_t _capacity)
+      {
+        std::size_t capacity = 2;
+        while (capacity < _capacity)
+          capacity <<= 1;
+
+        this->mask = capacity - 1;
+        this->cells.reset(new Cell[capacity]);
+        for (std::size_t i = 0; i < capacity; ++i)
+          this->cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      /// \brief No copy.
+      public: MpscQueue(const MpscQueue &) = delete;
+
+      /// \brief No assignment.
+      public: MpscQueue &operator=(const MpscQueue &) = delete;
+
+      /// \brief Try to push a new element. This function is thread safe and
+      /// lock-free.
+      /// \param[in, out] _value Element to push. It is moved only on success.
+      /// \return True if the element was queued or false if the queue is
+      /// full.
+      public: bool TryPush(T &_value)
+      {
+        Cell *cell = nullptr;
+        std::size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+          cell = &this->cells[pos & this->mask];
+          const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+          const auto diff =
+            static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+          if (diff == 0)
+          {
+            if (this->enqueuePos.compare_exchange_weak(pos, pos + 1,
+                  std::memory_order_relaxed))
+            {
+              break;
+            }
+          }
+          else if (diff < 0)
+          {
+            // The queue is full.
+            return false;
+          }
+          else
+          {
+            pos = this->enqueuePos.load(std::memory_order_relaxed);
+          }
+        }
+
+        cell->value = std::move(_value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        // Track the maximum depth observed.
+        const std::size_t depth = this->Depth();
+        std::size_t hwm = this->highWaterMark.load(std::memory_order_relaxed);
+        while (depth > hwm &&
+               !this->highWaterMark.compare_exchange_weak(hwm, depth,
+                 std::memory_order_relaxed))
+        {
+        }
+
+        // Wake up the consumer only if it is waiting for work.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->sleeping.load(std::memory_order_relaxed))
+        {
+          std::lock_guard<std::mutex> lk(this->wakeMutex);
+          this->wakeCv.notify_one();
+        }
+
+        return true;
+      }
+
+      /// \brief Push a new element, waiting for space if the queue is full.
+      /// \param[in, out] _value Element to push.
+      /// \param[in] _abort Flag checked while waiting. The function gives up
+      /// if it becomes true.
+      /// \return True if the element was queued or false if _abort was set
+      /// before space became available.
+      public: bool Push(T &_value, const std::atomic<bool> &_abort)
+      {
+        while (!this->TryPush(_value))
+        {
+          if (_abort)
+            return false;
+
+          std::unique_lock<std::mutex> lk(this->fullMutex);
+          this->blockedProducers.fetch_add(1, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          this->fullCv.wait(lk, [&]
+          {
+            return _abort || !this->Full();
+          });
+          this->blockedProducers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+      }
+
+      /// \brief Try to pop the oldest element. Only one thread may call this
+      /// function (or Pop()) at a time.
+      /// \param[out] _value Popped element.
+      /// \return True if an element was popped or false if the queue is
+      /// empty.
+      public: bool TryPop(T &_value)
+      {
+        const std::size_t pos =
+          this->dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = this->cells[pos & this->mask];
+        const std::size_t seq = cell.seq.load(std::memory_order_acquire);
+        if (seq != pos + 1)
+          return false;
+
+        _value = std::move(cell.value);
+        cell.value = T();
+        cell.seq.store(pos + this->mask + 1, std::memory_order_release);
+        this->dequeuePos.store(pos + 1, std::memory_order_release);
+
+        // Wake up the producers only if they are waiting for space.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->blockedProducers.load(std::memory_order_relaxed) > 0)
+        {
+          std::lock_guard<std::mutex> lk(this->fullMutex);
+          this->fullCv.notify_all();
+        }
+        return true;
+      }
+
+      /// \brief Pop the oldest element, blocking while the queue is empty.
+      /// Only one thread may call this function (or TryPop()) at a time.
+      /// \param[out] _value Popped element.
+      /// \param[in] _abort Flag checked while waiting. Call Wake() after
+      /// setting it to unblock the consumer.
+      /// \return True if an element was popped or false if _abort was set.
+      public: bool Pop(T &_value, const std::atomic<bool> &_abort)
+      {
+        while (!_abort)
+        {
+          if (this->TryPop(_value))
+            return true;
+
+          std::unique_lock<std::mutex> lk(this->wakeMutex);
+          this->sleeping.store(true, std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          this->wakeCv.wait(lk, [&]
+          {
+            return _abort || !this->Empty();
+          });
+          this->sleeping.store(false, std::memory_order_relaxed);
+        }
+        return false;
+      }
+
+      /// \brief Wake up the consumer if it is blocked in Pop() and the
+      /// producers blocked in Push().
+      public: void Wake()
+      {
+        {
+          std::lock_guard<std::mutex> lk(this->wakeMutex);
+          this->wakeCv.notify_all();
+        }
+        std::lock_guard<std::mutex> lk(this->fullMutex);
+        this->fullCv.notify_all();
+      }
+
+      /// \brief Whether the next position to push is still taken.
+      /// \return True if TryPush() would fail.
+      public: bool Full() const
+      {
+        const std::size_t pos =
+          this->enqueuePos.load(std::memory_order_acquire);
+        const std::size_t seq =
+          this->cells[pos & this->mask].seq.load(std::memory_order_acquire);
+        return static_cast<std::intptr_t>(seq) -
+          static_cast<std::intptr_t>(pos) < 0;
+      }
+
+      /// \brief Whether the next element is ready to be popped.
+      /// \return True if there is nothing to pop.
+      public: bool Empty() const
+      {
+        const std::size_t pos =
+          this->dequeuePos.load(std::memory_order_acquire);
+        return this->cells[pos & this->mask].seq.load(
+          std::memory_order_acquire) != pos + 1;
+      }
+
+      /// \brief Number of elements queued (claimed and not yet popped).
+      /// \return The current queue depth.
+      public: std::size_t Depth() const
+      {
+        const std::size_t head =
+          this->dequeuePos.load(std::memory_order_acquire);
+        const std::size_t tail =
+          this->enqueuePos.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+      }
+
+      /// \brief Position that the next pushed element will take. Positions
+      /// grow monotonically and are popped in order.
+      /// \return The next enqueue position.
+      public: std::size_t EnqueuePosition() const
+      {
+        return this->enqueuePos.load(std::memory_order_acquire);
+      }
+
+      /// \brief Position of the next element to be popped.
+      /// \return The next dequeue position.
+      public: std::size_t DequeuePosition() const
+      {
+        return this->dequeuePos.load(std::memory_order_acquire);
+      }
+
+      /// \brief Maximum depth observed since construction.
+      /// \return The high-water mark.
+      public: std::size_t HighWaterMark() const
+      {
+        return this->highWaterMark.load(std::memory_order_relaxed);
+      }
+
+      /// \brief Maximum number of elements that can be queued.
+      /// \return The queue capacity.
+      public: std::size_t Capacity() const
+      {
+        return this->mask + 1;
+      }
+
+      /// \brief A slot of the ring.
+      private: struct Cell
+      {
+        /// \brief Sequence number used to synchronize producers and consumer.
+        std::atomic<std::size_t> seq{0};
+
+        /// \brief Stored element.
+        T value;
+      };
+
+      /// \brief The ring.
+      private: std::unique_ptr<Cell[]> cells;
+
+      /// \brief Capacity minus one, used to index the ring.
+      private: std::size_t mask = 0;
+
+      /// \brief Next position to be claimed by a producer.
+      private: alignas(64) std::atomic<std::size_t> enqueuePos{0};
+
+      /// \brief Next position to be popped by the consumer.
+      private: alignas(64) std::atomic<std::size_t> dequeuePos{0};
+
+      /// \brief Highest depth observed.
+      private: std::atomic<std::size_t> highWaterMark{0};
+
+      /// \brief True while the consumer is blocked waiting for work.
+      private: std::atomic<bool> sleeping{false};
+
+      /// \brief Mutex used only to park and wake up the consumer.
+      private: std::mutex wakeMutex;
+
+      /// \brief Used to wake up the consumer.
+      private: std::condition_variable wakeCv;
+
+      /// \brief Number of producers blocked in Push().
+      private: std::atomic<std::size_t> blockedProducers{0};
+
+      /// \brief Mutex used only to park and wake up the producers.
+      private: std::mutex fullMutex;
+
+      /// \brief Used to wake up the producers.
+      private: std::condition_variable fullCv;
+    };
+    }
+  }
+}
+#endif
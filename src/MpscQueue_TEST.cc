@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "MpscQueue.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+TEST(MpscQueueTest, PushPop)
+{
+  transport::MpscQueue<std::unique_ptr<int>> queue(3);
+  EXPECT_EQ(4u, queue.Capacity());
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(0u, queue.Depth());
+
+  std::unique_ptr<int> value;
+  EXPECT_FALSE(queue.TryPop(value));
+
+  for (int i = 0; i < 4; ++i)
+  {
+    auto v = std::make_unique<int>(i);
+    EXPECT_TRUE(queue.TryPush(v));
+    EXPECT_EQ(nullptr, v);
+  }
+
+  // The queue is full, the value should not be moved.
+  auto extra = std::make_unique<int>(4);
+  EXPECT_FALSE(queue.TryPush(extra));
+  ASSERT_NE(nullptr, extra);
+
+  EXPECT_EQ(4u, queue.Depth());
+  EXPECT_EQ(4u, queue.HighWaterMark());
+
+  for (int i = 0; i < 4; ++i)
+  {
+    ASSERT_TRUE(queue.TryPop(value));
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ(i, *value);
+  }
+
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(0u, queue.Depth());
+  EXPECT_EQ(4u, queue.HighWaterMark());
+  EXPECT_EQ(4u, queue.EnqueuePosition());
+  EXPECT_EQ(4u, queue.DequeuePosition());
+}
+
+//////////////////////////////////////////////////
+/// \brief Several producers and one blocking consumer. Elements pushed by
+/// the same producer must be popped in order.
+TEST(MpscQueueTest, MultipleProducers)
+{
+  const int kProducers = 4;
+  const int kElements = 10000;
+
+  transport::MpscQueue<std::pair<int, int>> queue(64);
+  std::atomic<bool> abort{false};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p)
+  {
+    producers.emplace_back([&queue, &abort, p]()
+    {
+      for (int i = 0; i < kElements; ++i)
+      {
+        auto v = std::make_pair(p, i);
+        EXPECT_TRUE(queue.Push(v, abort));
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  for (int n = 0; n < kProducers * kElements; ++n)
+  {
+    std::pair<int, int> v;
+    ASSERT_TRUE(queue.Pop(v, abort));
+    EXPECT_EQ(next[v.first], v.second);
+    next[v.first] = v.second + 1;
+  }
+
+  for (auto &t : producers)
+    t.join();
+
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_LE(queue.HighWaterMark(), queue.Capacity());
+}
+
+//////////////////////////////////////////////////
+/// \brief A consumer blocked in Pop() should return when aborted.
+TEST(MpscQueueTest, Abort)
+{
+  transport::MpscQueue<int> queue(8);
+  std::atomic<bool> abort{false};
+
+  std::thread consumer([&]()
+  {
+    int v;
+    EXPECT_FALSE(queue.Pop(v, abort));
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  abort = true;
+  queue.Wake();
+  consumer.join();
+}
+
+//////////////////////////////////////////////////
+/// \brief A producer blocked in Push() on a full queue should return when
+/// an element is popped, or when aborted.
+TEST(MpscQueueTest, BlockedProducer)
+{
+  transport::MpscQueue<int> queue(2);
+  std::atomic<bool> abort{false};
+  for (int i = 0; i < 2; ++i)
+    EXPECT_TRUE(queue.TryPush(i));
+  EXPECT_TRUE(queue.Full());
+
+  std::atomic<bool> pushed{false};
+  std::thread producer([&]()
+  {
+    int v = 2;
+    EXPECT_TRUE(queue.Push(v, abort));
+    pushed = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(pushed);
+  int v;
+  EXPECT_TRUE(queue.TryPop(v));
+  producer.join();
+  EXPECT_TRUE(pushed);
+  EXPECT_TRUE(queue.Full());
+
+  std::thread aborted([&]()
+  {
+    int w = 3;
+    EXPECT_FALSE(queue.Push(w, abort));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  abort = true;
+  queue.Wake();
+  aborted.join();
+}
@@ -30,6 +30,7 @@
 #endif
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -403,6 +404,24 @@ inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
     return result;
 #endif
   }
+
+  //////////////////////////////////////////////////
+  void partitionDiscoveryChannel(const std::string &_partition,
+    std::string &_ip, int &_msgPort, int &_srvPort)
+  {
+    // FNV-1a, stable across platforms and standard libraries.
+    uint32_t hash = 2166136261u;
+    for (const char c : _partition)
+    {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 16777619u;
+    }
+
+    _ip = "239.255." + std::to_string((hash >> 8) & 0xff) + "." +
+      std::to_string(hash & 0xff);
+    _msgPort = 20000 + 2 * static_cast<int>((hash >> 16) % 5000);
+    _srvPort = _msgPort + 1;
+  }
 }
 }
 }
@@ -33,3 +33,29 @@ TEST(NetUtilsTest, username)
 {
   EXPECT_TRUE(!transport::username().empty());
 }
+
+//////////////////////////////////////////////////
+/// \brief Check the partitionDiscoveryChannel() function.
+TEST(NetUtilsTest, partitionDiscoveryChannel)
+{
+  std::string ip1;
+  int msgPort1 = 0;
+  int srvPort1 = 0;
+  transport::partitionDiscoveryChannel("ci_job_1", ip1, msgPort1, srvPort1);
+  EXPECT_EQ(0u, ip1.find("239.255."));
+  EXPECT_GE(msgPort1, 20000);
+  EXPECT_LE(msgPort1, 29998);
+  EXPECT_EQ(0, msgPort1 % 2);
+  EXPECT_EQ(msgPort1 + 1, srvPort1);
+
+  // The same partition always gets the same channel.
+  std::string ip2;
+  int msgPort2 = 0;
+  int srvPort2 = 0;
+  transport::partitionDiscoveryChannel("ci_job_1", ip2, msgPort2, srvPort2);
+  EXPECT_EQ(ip1, ip2);
+  EXPECT_EQ(msgPort1, msgPort2);
+
+  transport::partitionDiscoveryChannel("ci_job_2", ip2, msgPort2, srvPort2);
+  EXPECT_TRUE(ip1 != ip2 || msgPort1 != msgPort2);
+}
@@ -14,23 +14,36 @@
  * limitations under the License.
  *
 */
+#include <gz/msgs/Factory.hh>
 #include <gz/msgs/discovery.pb.h>
 #include <gz/msgs/statistic.pb.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <csignal>
 #include <condition_variable>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <shared_mutex>  //NOLINT
 #include <string>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "gz/transport/Clock.hh"
 #include "gz/transport/Helpers.hh"
 #include "gz/transport/MessageInfo.hh"
+#include "gz/transport/Metrics.hh"
 #include "gz/transport/Node.hh"
 #include "gz/transport/NodeOptions.hh"
 #include "gz/transport/NodeShared.hh"
@@ -38,8 +51,17 @@
 #include "gz/transport/TransportTypes.hh"
 #include "gz/transport/Uuid.hh"
 
+#include "BufferPool.hh"
+#include "CallbackProfiler.hh"
+#include "ContentFilter.hh"
+#include "FdChannel.hh"
 #include "NodePrivate.hh"
 #include "NodeSharedPrivate.hh"
+#include "Probes.hh"
+#include "RealTimeSlots.hh"
+#include "SpinQueue.hh"
+#include "TokenBucket.hh"
+#include "Tracer.hh"
 
 using namespace gz;
 using namespace transport;
@@ -97,6 +119,23 @@ namespace gz
       g_shutdown_cv.wait(lk, []{return g_shutdown;});
     }
 
+    //////////////////////////////////////////////////
+    /// \brief Check the content filter of a subscription.
+    /// \param[in] _handler The subscription handler.
+    /// \return False if the filter has a syntax error.
+    static bool validFilter(const ISubscriptionHandlerPtr &_handler)
+    {
+      if (!_handler || _handler->Filter().empty() ||
+          ContentFilter(_handler->Filter()).Valid())
+      {
+        return true;
+      }
+
+      std::cerr << "Filter [" << _handler->Filter() << "] is not valid."
+                << std::endl;
+      return false;
+    }
+
     //////////////////////////////////////////////////
     /// \internal
     /// \brief Private data for Node::Publisher class.
@@ -112,8 +151,134 @@ namespace gz
       /// \param[in] _publisher The message publisher.
       public: explicit PublisherPrivate(const MessagePublisher &_publisher)
         : shared(NodeShared::Instance()),
-          publisher(_publisher)
+          publisher(_publisher),
+          latched(_publisher.Options().Latched() &&
+                  _publisher.Options().Scope() != Scope_t::PROCESS),
+          metrics(Metrics::Instance().Topic(_publisher.Topic()))
+      {
+        if (this->metrics)
+        {
+          this->counters =
+            std::make_shared<NodeSharedPrivate::PublisherCounters>();
+        }
+
+        if (this->publisher.Options().Queued())
+        {
+          this->queueBound = std::make_shared<PublicationBound>();
+          this->queueBound->depth = static_cast<std::size_t>(
+            this->publisher.Options().QueueDepth());
+          this->queueBound->policy = this->publisher.Options().QueuePolicy();
+        }
+
+        // High priority topics have their own local publication lane.
+        NodeSharedPrivate *sharedPrivate = this->shared->dataPtr.get();
+        this->lane = this->publisher.Options().HighPriority() ?
+          &sharedPrivate->PriorityLane() : sharedPrivate->pubLane.get();
+        this->memoryAccount =
+          sharedPrivate->memoryBudget.Topic(this->publisher.Topic());
+
+        // Token buckets of the rate and bandwidth limits.
+        const AdvertiseMessageOptions &opts = this->publisher.Options();
+        if (opts.RateLimit() > 0)
+        {
+          this->msgBucket = std::make_unique<TokenBucket>(
+            static_cast<double>(opts.RateLimit()),
+            static_cast<double>(opts.RateLimitBurst()));
+        }
+        if (opts.BandwidthLimit() > 0)
+        {
+          this->byteBucket = std::make_unique<TokenBucket>(
+            static_cast<double>(opts.BandwidthLimit()),
+            static_cast<double>(opts.BandwidthBurst()));
+        }
+        this->rateLimitRemoteOnly = opts.RateLimitRemoteOnly();
+        this->adaptive = opts.Adaptive() && opts.Scope() != Scope_t::PROCESS;
+
+        // The latest message may be kept for the readers of this host.
+        if (opts.Blackboard() && opts.Scope() != Scope_t::PROCESS)
+        {
+          this->blackboard = sharedPrivate->CreateBlackboard(
+            this->publisher.Topic(), this->publisher.MsgTypeName());
+        }
+
+        if (this->publisher.Options().RealTime())
+          this->EnableRealTime();
+      }
+
+      /// \brief Allocate the real-time slots and register their sender,
+      /// see AdvertiseMessageOptions::SetRealTime().
+      public: void EnableRealTime()
+      {
+        // The real-time thread checks the type of the messages with their
+        // descriptor, which doesn't allocate.
+        const std::string &msgType = this->publisher.MsgTypeName();
+        std::unique_ptr<ProtoMsg> msg = gz::msgs::Factory::New(msgType);
+        if (!msg)
+        {
+          std::cerr << "Node::Advertise(): Real-time publishers only support "
+                    << "protobuf messages, [" << msgType << "] is not one"
+                    << std::endl;
+          return;
+        }
+
+        const AdvertiseMessageOptions &opts = this->publisher.Options();
+        this->realTimeDescriptor = msg->GetDescriptor();
+        this->realTime = std::make_unique<RealTimeSlots>(
+          static_cast<std::size_t>(opts.RealTimeSlots()),
+          static_cast<std::size_t>(opts.RealTimeSlotSize()));
+        this->shared->dataPtr->AddRealTimePublisher(this, [this]
+        {
+          this->SendRealTime();
+        });
+      }
+
+      /// \brief Publish a message from a real-time thread: serialize it
+      /// into the next real-time slot, without allocating, locking or
+      /// printing anything. The sender thread takes care of the rest.
+      /// \param[in] _msg The message.
+      /// \return False if the type doesn't match or the message was
+      /// dropped.
+      public: bool PublishRealTime(const ProtoMsg &_msg)
+      {
+        if (_msg.GetDescriptor() != this->realTimeDescriptor)
+        {
+          this->realTime->CountDrop();
+          return false;
+        }
+
+#if GOOGLE_PROTOBUF_VERSION >= 3004000
+        const std::size_t msgSize =
+          static_cast<std::size_t>(_msg.ByteSizeLong());
+#else
+        const std::size_t msgSize = static_cast<std::size_t>(_msg.ByteSize());
+#endif
+
+        char *slot = this->realTime->Reserve();
+        if (!slot || msgSize > this->realTime->SlotSize() ||
+            !_msg.SerializeToArray(slot, static_cast<int>(msgSize)))
+        {
+          this->realTime->CountDrop();
+          return false;
+        }
+
+        this->realTime->Commit(msgSize);
+        return true;
+      }
+
+      /// \brief Publish the messages committed by the real-time thread.
+      /// It runs in the real-time thread of NodeShared, or in the
+      /// destructor.
+      public: void SendRealTime()
       {
+        const char *data = nullptr;
+        std::size_t size = 0;
+        while (this->realTime->Front(data, size))
+        {
+          std::shared_ptr<char[]> buffer = this->buffers.Acquire(size);
+          memcpy(buffer.get(), data, size);
+          this->realTime->Pop();
+          this->PublishSerialized(buffer, size);
+        }
       }
 
       /// \brief Check if this Publisher is ready to send an update based on
@@ -125,6 +290,19 @@ namespace gz
         if (!this->publisher.Options().Throttled())
           return true;
 
+        const std::shared_ptr<const Clock> &clock =
+          this->publisher.Options().ThrottleClock();
+        if (clock && clock->IsReady())
+        {
+          const std::chrono::nanoseconds time = clock->Time();
+
+          // The clock goes back when a simulation is reset.
+          std::lock_guard<std::mutex> lk(this->mutex);
+          return this->lastClockTime.count() < 0 ||
+                 time < this->lastClockTime ||
+                 (time - this->lastClockTime).count() >= this->periodNs;
+        }
+
         Timestamp now = std::chrono::steady_clock::now();
 
         std::lock_guard<std::mutex> lk(this->mutex);
@@ -148,11 +326,203 @@ namespace gz
           return false;
 
         // Update the last callback execution.
+        const std::shared_ptr<const Clock> &clock =
+          this->publisher.Options().ThrottleClock();
+        std::lock_guard<std::mutex> lk(this->mutex);
+        if (clock && clock->IsReady())
+          this->lastClockTime = clock->Time();
+        else
+          this->lastCbTimestamp = std::chrono::steady_clock::now();
+        return true;
+      }
+
+      /// \brief Check if any remote subscriber would consume a new message.
+      /// Remote subscribers advertise their throttling rate, and messages
+      /// are sent at twice the highest rate so that arrival jitter doesn't
+      /// make the subscribers discard them.
+      /// \return True if the message has to be sent to the remote
+      /// subscribers, false if all of them would discard it.
+      public: bool RemoteSubscribersReady()
+      {
+        NodeSharedPrivate *sharedPrivate = this->shared->dataPtr.get();
+        const uint64_t version = sharedPrivate->remoteSubscribersVersion;
+
+        std::lock_guard<std::mutex> lk(this->mutex);
+        if (version != this->remoteVersion)
+        {
+          this->remoteVersion = version;
+          const uint64_t rate = sharedPrivate->RemoteSubscribersMsgsPerSec(
+            this->shared, this->publisher.Topic());
+          this->remotePeriodNs =
+            rate == kUnthrottled ? 0.0 : 1e9 / (2.0 * rate);
+        }
+
+        if (this->remotePeriodNs <= 0.0)
+          return true;
+
+        Timestamp now = std::chrono::steady_clock::now();
+        auto elapsed = now - this->lastRemoteTimestamp;
+        if (std::chrono::duration_cast<std::chrono::nanoseconds>(
+              elapsed).count() < this->remotePeriodNs)
+        {
+          return false;
+        }
+
+        this->lastRemoteTimestamp = now;
+        return true;
+      }
+
+      /// \brief Take a message out of the token buckets of the rate and
+      /// bandwidth limits.
+      /// \param[in] _bytes Size of the serialized message.
+      /// \return False if a limit is exceeded and the message is dropped.
+      public: bool TakeTokens(const std::size_t _bytes)
+      {
+        if (!this->msgBucket && !this->byteBucket)
+          return true;
+
+        const double bytes = static_cast<double>(_bytes);
+        const TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+
         std::lock_guard<std::mutex> lk(this->mutex);
-        this->lastCbTimestamp = std::chrono::steady_clock::now();
+        if ((this->msgBucket && !this->msgBucket->Ready(1.0, now)) ||
+            (this->byteBucket && !this->byteBucket->Ready(bytes, now)))
+        {
+          this->rateLimited.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+
+        if (this->msgBucket)
+          this->msgBucket->Take(1.0);
+        if (this->byteBucket)
+          this->byteBucket->Take(bytes);
+        return true;
+      }
+
+      /// \brief Apply the rate and bandwidth limits to a publication, see
+      /// AdvertiseMessageOptions::SetRateLimit.
+      /// \param[in, out] _subscribers The subscribers of the topic. The
+      /// remote subscribers are skipped when a remote only limit is
+      /// exceeded.
+      /// \param[in] _bytes Size of the serialized message.
+      /// \return False if the message is dropped for every subscriber.
+      public: bool RateLimit(NodeShared::SubscriberInfo &_subscribers,
+                             const std::size_t _bytes)
+      {
+        if (!this->rateLimitRemoteOnly)
+          return this->TakeTokens(_bytes);
+
+        if (_subscribers.haveRemote && !this->TakeTokens(_bytes))
+          _subscribers.haveRemote = false;
         return true;
       }
 
+      /// \brief Apply the flow control of the remote subscribers, see
+      /// SubscribeOptions::SetCredits, and the adaptive rate, see
+      /// AdvertiseMessageOptions::SetLatencyTarget.
+      /// \param[in, out] _subscribers The subscribers of the topic. The
+      /// remote subscribers are skipped when they have no credits left or
+      /// the rate is exceeded.
+      /// \return True if the message has to be serialized and kept with
+      /// NodeSharedPrivate::KeepLatest for the conflated remote subscribers.
+      public: bool TakeCredit(NodeShared::SubscriberInfo &_subscribers)
+      {
+        if (!_subscribers.haveRemote)
+          return false;
+
+        using CreditDecision = NodeSharedPrivate::CreditDecision;
+        CreditDecision decision = this->shared->dataPtr->TakeCredit(
+          this->shared, this->publisher.Topic());
+        if (decision == CreditDecision::SEND && this->adaptive)
+        {
+          decision = this->shared->dataPtr->AdaptRate(
+            this->publisher.Topic());
+        }
+        if (decision == CreditDecision::SEND)
+          return false;
+
+        _subscribers.haveRemote = false;
+        return decision == CreditDecision::KEEP;
+      }
+
+      /// \brief Check if any remote subscriber wants a message according to
+      /// the content filters that the remote subscribers advertise.
+      /// \param[in] _msg The message.
+      /// \return True if the message has to be sent to the remote
+      /// subscribers, false if none of their filters matches it.
+      public: bool RemoteSubscribersWant(const ProtoMsg &_msg)
+      {
+        NodeSharedPrivate *sharedPrivate = this->shared->dataPtr.get();
+        const uint64_t version = sharedPrivate->remoteSubscribersVersion;
+
+        std::shared_ptr<ContentFilter> filter;
+        {
+          std::lock_guard<std::mutex> lk(this->mutex);
+          if (version != this->filterVersion)
+          {
+            this->filterVersion = version;
+            this->remoteFilter = sharedPrivate->RemoteSubscribersFilter(
+              this->shared, this->publisher.Topic());
+          }
+          filter = this->remoteFilter;
+        }
+
+        return !filter || filter->Matches(_msg);
+      }
+
+      /// \brief Get whether the topic has local and remote subscribers of
+      /// the advertised type. The answer is cached until the subscribers of
+      /// the process change, so it usually costs two atomic loads and no
+      /// lock.
+      /// \return A combination of kHasLocal and kHasRemote.
+      public: uint64_t Connections()
+      {
+        NodeSharedPrivate *sharedPrivate = this->shared->dataPtr.get();
+        const uint64_t version =
+          sharedPrivate->subscribersVersion.load(std::memory_order_acquire);
+        const uint64_t cached =
+          this->connections.load(std::memory_order_relaxed);
+        if ((cached >> 2) == version)
+          return cached & (kHasLocal | kHasRemote);
+
+        const std::string &topic = this->publisher.Topic();
+        const std::string &msgType = this->publisher.MsgTypeName();
+        uint64_t state = 0;
+        if (this->shared->localSubscribers.HasSubscriber(topic, msgType))
+          state |= kHasLocal;
+
+        {
+          std::shared_lock<std::shared_mutex> lk(
+            sharedPrivate->remoteSubscribersMutex);
+
+          /// \todo(anyone): Checking "remoteSubscribers.HasTopic()" will
+          /// return true even if the subscriber has not successfully
+          /// authenticated with the publisher.
+          /// See Issue #73
+          if (this->shared->remoteSubscribers.HasTopic(topic, msgType))
+            state |= kHasRemote;
+        }
+
+        // A change while computing bumps the version again, so the stale
+        // answer is never returned.
+        this->connections.store((version << 2) | state,
+          std::memory_order_relaxed);
+        return state;
+      }
+
+      /// \brief Get the subscribers of a publication of the advertised
+      /// type. The remote subscribers come from Connections().
+      /// \return The local handlers and whether there are remote
+      /// subscribers.
+      public: NodeShared::SubscriberInfo Subscribers()
+      {
+        NodeShared::SubscriberInfo info;
+        static_cast<NodeShared::HandlerInfo &>(info) =
+          this->shared->CheckHandlerInfo(this->publisher.Topic());
+        info.haveRemote = (this->Connections() & kHasRemote) != 0;
+        return info;
+      }
+
       /// \brief Check if this Publisher is valid
       /// \return True if we have a topic to publish to, otherwise false.
       public: bool Valid()
@@ -163,7 +533,54 @@ namespace gz
       /// \brief Destructor.
       public: virtual ~PublisherPrivate()
       {
+        // Send the messages left in the real-time slots.
+        if (this->realTime)
+        {
+          this->shared->dataPtr->RemoveRealTimePublisher(this);
+          this->SendRealTime();
+        }
+
         std::lock_guard<std::recursive_mutex> lk(this->shared->mutex);
+
+        // Send the messages waiting in the batch of the topic.
+        if (this->publisher.Options().Batched())
+        {
+          this->shared->dataPtr->ReleaseBatch(this->shared,
+            this->publisher.Topic());
+        }
+
+        const Compression_t codec = this->publisher.Options().Compression();
+        if (codec != Compression_t::NONE && Compression::Supported(codec) &&
+            this->publisher.Options().Scope() != Scope_t::PROCESS)
+        {
+          this->shared->dataPtr->ReleaseCompression(this->publisher.Topic());
+        }
+
+        if (this->latched)
+          this->shared->dataPtr->ReleaseLatch(this->publisher.Topic());
+
+        if (this->publisher.Options().Reliable() &&
+            this->publisher.Options().Scope() != Scope_t::PROCESS)
+        {
+          this->shared->dataPtr->ReleaseReliable(this->publisher.Topic());
+        }
+
+        if (this->adaptive)
+          this->shared->dataPtr->ReleaseAdaptive(this->publisher.Topic());
+
+        if (this->publisher.Options().HighPriority() &&
+            this->publisher.Options().Scope() != Scope_t::PROCESS)
+        {
+          this->shared->dataPtr->ReleasePriority(this->publisher.Topic());
+        }
+        else if ((!this->publisher.Options().Interface().empty() ||
+                  !this->publisher.MulticastGroup().empty()) &&
+                 this->publisher.Options().Scope() != Scope_t::PROCESS)
+        {
+          this->shared->dataPtr->ReleaseInterfaceTopic(
+            this->publisher.Topic());
+        }
+
         // Notify the discovery service to unregister and unadvertise my topic.
         if (!this->shared->dataPtr->msgDiscovery->Unadvertise(
                this->publisher.Topic(), this->publisher.NUuid()))
@@ -171,6 +588,11 @@ namespace gz
           std::cerr << "~PublisherPrivate() Error unadvertising topic ["
                     << this->publisher.Topic() << "]" << std::endl;
         }
+
+        // The discovery only notifies the publishers that it adds, so we
+        // remove ours from the topic graph ourselves.
+        if (this->Valid())
+          this->shared->dataPtr->RemoveFromGraph(this->publisher);
       }
 
       /// \brief Create a MessageInfo object for this Publisher
@@ -187,250 +609,711 @@ namespace gz
         return info;
       }
 
-      /// \brief Pointer to the object shared between all the nodes within the
-      /// same process.
-      public: NodeShared *shared = nullptr;
-
-      /// \brief The message publisher.
-      public: MessagePublisher publisher;
-
-      /// \brief Timestamp of the last callback executed.
-      public: Timestamp lastCbTimestamp;
-
-      /// \brief If throttling is enabled, the minimum period for receiving a
-      /// message in nanoseconds.
-      public: double periodNs = 0.0;
-
-      /// \brief Mutex to protect the node::publisher from race conditions.
-      public: mutable std::mutex mutex;
-    };
-    }
-  }
-}
-
-//////////////////////////////////////////////////
-Node::Publisher::Publisher()
-  : dataPtr(std::make_shared<PublisherPrivate>())
-{
-}
+      /// \brief Update the metrics and the statistics of a publication.
+      /// \param[in] _subscribers Subscribers of the topic.
+      /// \param[in] _msgSize Size of the serialized message.
+      public: void CountPublication(
+        const NodeShared::SubscriberInfo &_subscribers, std::size_t _msgSize)
+      {
+        Metrics::Add(this->metrics, Metrics::Counter::MSGS_SENT);
+        if (_subscribers.haveRemote)
+          Metrics::Add(this->metrics, Metrics::Counter::BYTES_SENT, _msgSize);
 
-//////////////////////////////////////////////////
-Node::Publisher::Publisher(const MessagePublisher &_publisher)
-  : dataPtr(std::make_shared<PublisherPrivate>(_publisher))
-{
-  if (this->dataPtr->publisher.Options().Throttled())
-  {
-    this->dataPtr->periodNs =
-      1e9 / this->dataPtr->publisher.Options().MsgsPerSec();
-  }
-}
+        if (!this->counters)
+          return;
 
-//////////////////////////////////////////////////
-Node::Publisher::~Publisher()
-{
-}
+        ++this->counters->publications;
+        this->counters->bytes += _msgSize;
+        if (!_subscribers.haveLocal && !_subscribers.haveRaw &&
+            !_subscribers.haveRemote)
+        {
+          ++this->counters->unsubscribed;
+        }
+      }
 
-//////////////////////////////////////////////////
-Node::Publisher::operator bool()
-{
-  return this->Valid();
-}
+      /// \brief Count a publication that couldn't be sent to the remote
+      /// subscribers.
+      public: void CountSendFailure()
+      {
+        if (this->counters)
+          ++this->counters->sendFailures;
+      }
 
-//////////////////////////////////////////////////
-Node::Publisher::operator bool() const
-{
-  return this->Valid();
-}
+      /// \brief Get a snapshot of the statistics of the publisher.
+      /// \return The statistics.
+      public: PublisherStatistics Statistics() const
+      {
+        PublisherStatistics stats;
+        if (this->realTime)
+          stats.realTimeDropped = this->realTime->Dropped();
+        stats.rateLimited = this->rateLimited.load(std::memory_order_relaxed);
+        if (!this->counters)
+          return stats;
+
+        const NodeSharedPrivate::PublisherCounters &c = *this->counters;
+        stats.publications = c.publications;
+        stats.unsubscribed = c.unsubscribed;
+        stats.serializations = c.serializations;
+        stats.serializationNs = c.serializationNs;
+        stats.maxSerializationNs = c.maxSerializationNs;
+        stats.bytes = c.bytes;
+        stats.sendFailures = c.sendFailures;
+        stats.queued = c.queued;
+        stats.queueWaitNs = c.queueWaitNs;
+        stats.maxQueueWaitNs = c.maxQueueWaitNs;
+        return stats;
+      }
 
-//////////////////////////////////////////////////
-bool Node::Publisher::Valid() const
-{
-  return this->dataPtr->Valid();
-}
+      /// \brief Publish the statistics of the publisher on its statistics
+      /// topic, if any, when its throttling allows it.
+      public: void PublishStatistics()
+      {
+        if (!this->statPub.Valid() || !this->statPub.ThrottledUpdateReady())
+          return;
 
-//////////////////////////////////////////////////
-bool Node::Publisher::HasConnections() const
-{
-  auto &publisher = this->dataPtr->publisher;
-  const std::string &topic = publisher.Topic();
-  const std::string &msgType = publisher.MsgTypeName();
+        msgs::Metric msg;
+        this->Statistics().FillMessage(msg);
+        this->statPub.Publish(msg);
+      }
 
-  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+      /// \brief Write a publication to the blackboard of the topic, if it
+      /// has one.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the message.
+      public: void WriteBlackboard(const char *_data, const std::size_t _size)
+      {
+        if (!this->blackboard)
+          return;
 
-  /// \todo(anyone): Checking "remoteSubscribers.HasTopic()" will return
-  /// true even
-  /// if the subscriber has not successfully authenticated with the
-  /// publisher.
-  /// See Issue #73
-  return this->Valid() &&
-    (this->dataPtr->shared->localSubscribers.HasSubscriber(topic, msgType) ||
-     this->dataPtr->shared->remoteSubscribers.HasTopic(topic, msgType));
-}
+        std::lock_guard<std::mutex> lk(this->blackboard->mutex);
+        this->blackboard->segment->Write(_data, _size);
+      }
 
-//////////////////////////////////////////////////
-bool Node::Publisher::Publish(const ProtoMsg &_msg)
-{
-  if (!this->Valid())
-    return false;
+      /// \brief Deliver a publication to the local, raw and remote
+      /// subscribers.
+      /// \param[in] _subscribers Subscribers of the topic.
+      /// \param[in] _msg Message for the local subscribers. It may be
+      /// nullptr if there are no local subscribers.
+      /// \param[in] _msgBuffer Serialized message, shared with the raw
+      /// subscribers and ZeroMQ. It may be nullptr if there are no raw or
+      /// remote subscribers and the topic isn't latched nor on a
+      /// blackboard.
+      /// \param[in] _msgSize Size of the serialized message.
+      /// \return True when success.
+      public: bool Deliver(const NodeShared::SubscriberInfo &_subscribers,
+                           std::shared_ptr<const ProtoMsg> _msg,
+                           const std::shared_ptr<char[]> &_msgBuffer,
+                           std::size_t _msgSize)
+      {
+        const std::string &msgType = this->publisher.MsgTypeName();
 
-  const std::string &publisherMsgType = this->dataPtr->publisher.MsgTypeName();
+        this->CountPublication(_subscribers, _msgSize);
 
-  // Check that the msg type matches the topic type previously advertised.
-  if (publisherMsgType != _msg.GetTypeName())
-  {
-    std::cerr << "Node::Publisher::Publish() Type mismatch.\n"
-              << "\t* Type advertised: "
-              << this->dataPtr->publisher.MsgTypeName()
-              << "\n\t* Type published: " << _msg.GetTypeName() << std::endl;
-    return false;
-  }
+        // Start the trace of the publication unless Publish() did already.
+        TraceMetadata trace = Tracer::Current();
+        if (trace.traceId == 0 && Tracer::Instance().Enabled())
+        {
+          trace.traceId = Tracer::Instance().NewTraceId();
+          trace.publishStamp = Tracer::Now();
+        }
+        Tracer::Scope traceScope(trace);
 
-  // Check the publication throttling option.
-  if (!this->UpdateThrottling())
-    return true;
+        // Keep the message for late subscribers.
+        if (this->latched && _msgBuffer)
+        {
+          this->shared->dataPtr->StoreLatched(this->publisher.Topic(),
+            _msgBuffer, _msgSize);
+        }
 
-  const std::string &publisherTopic = this->dataPtr->publisher.Topic();
+        if (_msgBuffer)
+          this->WriteBlackboard(_msgBuffer.get(), _msgSize);
 
-  const NodeShared::SubscriberInfo &subscribers =
-      this->dataPtr->shared->CheckSubscriberInfo(
-        publisherTopic, publisherMsgType);
+        // Local and raw subscribers.
+        if (_subscribers.haveLocal || _subscribers.haveRaw)
+        {
+          std::unique_ptr<NodeSharedPrivate::PublishMsgDetails> pubMsgDetails(
+            new NodeSharedPrivate::PublishMsgDetails);
 
-  // The serialized message size and buffer.
-#if GOOGLE_PROTOBUF_VERSION >= 3004000
-  const std::size_t msgSize = static_cast<std::size_t>(_msg.ByteSizeLong());
-#else
-  const std::size_t msgSize = static_cast<std::size_t>(_msg.ByteSize());
-#endif
-  char *msgBuffer = nullptr;
+          // Create and populate the message information object.
+          // This must be a shared pointer so that we can pass it to
+          // multiple threads below, and then allow this function to go
+          // out of scope.
+          pubMsgDetails->info.SetTopicAndPartition(this->publisher.Topic());
+          pubMsgDetails->info.SetType(this->publisher.MsgTypeName());
+          pubMsgDetails->info.SetIntraProcess(true);
 
-  // Only serialize the message if we have a raw subscriber or a remote
-  // subscriber.
-  if (subscribers.haveRaw || subscribers.haveRemote)
-  {
-    // Allocate the buffer to store the serialized data.
-    msgBuffer = static_cast<char *>(new char[msgSize]);
+          pubMsgDetails->msgCopy = std::move(_msg);
 
-    // Fail out early if we are unable to serialize the message. We do not
-    // want to send a corrupt/bad message to some subscribers and not others.
-    if (!_msg.SerializeToArray(msgBuffer, msgSize))
-    {
-      delete[] msgBuffer;
-      std::cerr << "Node::Publisher::Publish(): Error serializing data"
-                << std::endl;
-      return false;
-    }
-  }
+          pubMsgDetails->publisherNodeUUID = this->publisher.NUuid();
+          pubMsgDetails->bound = this->queueBound;
+          pubMsgDetails->memory = MemoryBudget::Charge(this->memoryAccount,
+            sizeof(NodeSharedPrivate::PublishMsgDetails) + _msgSize);
 
-  // Local and raw subscribers.
-  if (subscribers.haveLocal || subscribers.haveRaw)
-  {
-    std::unique_ptr<NodeSharedPrivate::PublishMsgDetails> pubMsgDetails(
-      new NodeSharedPrivate::PublishMsgDetails);
+          if (trace.traceId != 0)
+          {
+            pubMsgDetails->trace = trace;
+            pubMsgDetails->queuedStamp = Tracer::Now();
+          }
 
-    // Create and populate the message information object.
-    // This must be a shared pointer so that we can pass it to
-    // multiple threads below, and then allow this function to go
-    // out of scope.
-    pubMsgDetails->info.SetTopicAndPartition(this->dataPtr->publisher.Topic());
-    pubMsgDetails->info.SetType(this->dataPtr->publisher.MsgTypeName());
-    pubMsgDetails->info.SetIntraProcess(true);
+          if (this->counters)
+            pubMsgDetails->counters = this->counters;
+          if (this->counters || CallbackProfiler::Instance().Enabled())
+            pubMsgDetails->queued = std::chrono::steady_clock::now();
+
+          // The handlers are not copied: the publication shares the
+          // snapshot of the topic, and the handlers of another type are
+          // skipped when it is delivered.
+          pubMsgDetails->handlers = _subscribers.handlers;
+          pubMsgDetails->runLocal = _subscribers.haveLocal;
+          pubMsgDetails->runRaw = _subscribers.haveRaw;
+          if (_subscribers.haveRaw)
+          {
+            // Share the serialized buffer instead of copying it.
+            pubMsgDetails->msgSize = _msgSize;
+            pubMsgDetails->sharedBuffer = _msgBuffer;
+          }
 
-    pubMsgDetails->msgCopy.reset(_msg.New());
-    pubMsgDetails->msgCopy->CopyFrom(_msg);
+          // The nodes in spin mode and the callback groups run their own
+          // callbacks.
+          const bool posted =
+            this->shared->dataPtr->PostExecutorHandlers(*pubMsgDetails);
 
-    pubMsgDetails->publisherNodeUUID = this->dataPtr->publisher.NUuid();
+          // Add the publish message details to the publish queue. The message
+          // will be published asynchronously to the local and raw callbacks.
+          if (!posted || pubMsgDetails->handlers)
+          {
+            this->shared->dataPtr->QueuePublication(*this->lane,
+              pubMsgDetails);
+          }
+        }
 
-    if (subscribers.haveLocal)
-    {
-      for (const auto &node : subscribers.localHandlers)
-      {
-        for (const auto &handler : node.second)
+        // Handle remote subscribers.
+        if (_subscribers.haveRemote)
         {
-          if (!handler.second)
+          // ZeroMQ holds its own reference to the serialized buffer. The hint
+          // owns that reference and zmq will call this lambda to release it when
+          // the message is published. The buffer itself is freed once the last
+          // raw local handler is also done with it.
+          auto *ref = new std::shared_ptr<char[]>(_msgBuffer);
+          auto myDeallocator = [](void *, void *_hint)
           {
-            std::cerr << "Node::Publisher::Publish(): "
-                      << "NULL local subscription handler" << std::endl;
-            continue;
-          }
+            delete reinterpret_cast<std::shared_ptr<char[]>*>(_hint);
+          };
 
-          if (handler.second->TypeName() != kGenericMessageType &&
-              handler.second->TypeName() != _msg.GetTypeName())
+          if (!this->shared->Publish(this->publisher.Topic(),
+                _msgBuffer.get(), _msgSize, myDeallocator, ref, msgType))
           {
-            continue;
+            this->CountSendFailure();
+            return false;
           }
-
-          pubMsgDetails->localHandlers.push_back(handler.second);
         }
-      }
-    }
 
-    if (subscribers.haveRaw)
-    {
-      for (auto &node : subscribers.rawHandlers)
+        this->PublishStatistics();
+        return true;
+      }
+
+      /// \brief Publish a message.
+      /// \param[in] _msg The message.
+      /// \param[in] _owned The same message, shared with the caller, or
+      /// nullptr. The local subscribers receive it instead of a copy.
+      /// \param[in] _typed True if the type of the message is known at
+      /// compile time to be the advertised one, see TypedPublisher.
+      /// \return True when success.
+      public: bool Publish(const ProtoMsg &_msg,
+                           std::shared_ptr<const ProtoMsg> _owned,
+                           const bool _typed = false)
       {
-        for (auto &handler : node.second)
+        if (this->realTime)
+          return this->PublishRealTime(_msg);
+
+        const std::string &publisherMsgType = this->publisher.MsgTypeName();
+
+        // Check that the msg type matches the topic type previously
+        // advertised.
+        if (!_typed && publisherMsgType != _msg.GetTypeName())
         {
-          const RawSubscriptionHandlerPtr &rawHandler = handler.second;
+          std::cerr << "Node::Publisher::Publish() Type mismatch.\n"
+                    << "\t* Type advertised: " << publisherMsgType
+                    << "\n\t* Type published: " << _msg.GetTypeName()
+                    << std::endl;
+          return false;
+        }
+
+        // Check the publication throttling option.
+        if (!this->UpdateThrottling())
+          return true;
+
+        NodeShared::SubscriberInfo subscribers = this->Subscribers();
+
+        // Skip the remote subscribers if all of them would discard the
+        // message, which may save its serialization.
+        if (subscribers.haveRemote &&
+            (!this->RemoteSubscribersWant(_msg) ||
+             !this->RemoteSubscribersReady()))
+        {
+          subscribers.haveRemote = false;
+        }
+
+        // The serialized message size and buffer.
+#if GOOGLE_PROTOBUF_VERSION >= 3004000
+        const std::size_t msgSize =
+          static_cast<std::size_t>(_msg.ByteSizeLong());
+#else
+        const std::size_t msgSize = static_cast<std::size_t>(_msg.ByteSize());
+#endif
+
+        if (!this->RateLimit(subscribers, msgSize))
+          return true;
+
+        const bool keep = this->TakeCredit(subscribers);
+
+        // The serialized message is shared between the raw local handlers
+        // and ZeroMQ, so the message is serialized exactly once and never
+        // copied.
+        std::shared_ptr<char[]> msgBuffer;
 
-          if (!rawHandler)
+        // The trace of the publication starts before its serialization.
+        Tracer &tracer = Tracer::Instance();
+        TraceMetadata trace;
+        if (tracer.Enabled())
+        {
+          trace.traceId = tracer.NewTraceId();
+          trace.publishStamp = Tracer::Now();
+        }
+        Tracer::Scope traceScope(trace);
+
+        // Only serialize the message if we have a raw subscriber or a remote
+        // subscriber, or if it is kept for late subscribers or readers.
+        if (subscribers.haveRaw || subscribers.haveRemote || this->latched ||
+            this->blackboard || keep)
+        {
+          // Take a buffer to store the serialized data.
+          msgBuffer = this->buffers.Acquire(msgSize);
+
+          // Fail out early if we are unable to serialize the message. We do
+          // not want to send a corrupt/bad message to some subscribers and
+          // not others.
+          const auto start = this->metrics ?
+            std::chrono::steady_clock::now() :
+            std::chrono::steady_clock::time_point();
+          if (!_msg.SerializeToArray(msgBuffer.get(),
+                static_cast<int>(msgSize)))
+          {
+            std::cerr << "Node::Publisher::Publish(): Error serializing data"
+                      << std::endl;
+            return false;
+          }
+          if (this->metrics)
           {
-            std::cerr << "Node::Publisher::Publish(): "
-                      << "NULL raw subscription handler" << std::endl;
-            continue;
+            const uint64_t elapsed = static_cast<uint64_t>(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            Metrics::Add(this->metrics, Metrics::Counter::SERIALIZATION_NS,
+              elapsed);
+            ++this->counters->serializations;
+            this->counters->serializationNs += elapsed;
+            NodeSharedPrivate::PublisherCounters::UpdateMax(
+              this->counters->maxSerializationNs, elapsed);
           }
+          if (trace.traceId != 0)
+          {
+            tracer.Span("serialize", this->publisher.Topic(), trace.traceId,
+              trace.publishStamp, Tracer::Now());
+          }
+        }
 
-          if (rawHandler->TypeName() != kGenericMessageType &&
-              rawHandler->TypeName() != _msg.GetTypeName())
+        // The local subscribers share the message handed over by the caller
+        // or a copy of it.
+        std::shared_ptr<const ProtoMsg> msgCopy;
+        if (subscribers.haveLocal || subscribers.haveRaw)
+        {
+          if (_owned)
+          {
+            msgCopy = std::move(_owned);
+          }
+          else
           {
-            continue;
+            std::unique_ptr<ProtoMsg> copy(_msg.New());
+            copy->CopyFrom(_msg);
+            msgCopy = std::move(copy);
           }
+        }
+
+        if (keep)
+        {
+          this->shared->dataPtr->KeepLatest(this->publisher.Topic(),
+            msgBuffer, msgSize, publisherMsgType);
+        }
+
+        return this->Deliver(subscribers, std::move(msgCopy), msgBuffer,
+          msgSize);
+      }
+
+      /// \brief Publish a serialized message of the advertised type.
+      /// \param[in] _buffer The serialized message, shared with the
+      /// transport.
+      /// \param[in] _size Size of the serialized message.
+      /// \return True when success.
+      public: bool PublishSerialized(const std::shared_ptr<char[]> &_buffer,
+                                     std::size_t _size)
+      {
+        // Check the publication throttling option.
+        if (!this->UpdateThrottling())
+          return true;
+
+        const std::string &msgType = this->publisher.MsgTypeName();
+        NodeShared::SubscriberInfo subscribers = this->Subscribers();
 
-          if (!pubMsgDetails->sharedBuffer)
+        // Skip the remote subscribers if all of them would discard the
+        // message.
+        if (subscribers.haveRemote && !this->RemoteSubscribersReady())
+          subscribers.haveRemote = false;
+
+        if (!this->RateLimit(subscribers, _size))
+          return true;
+
+        if (this->TakeCredit(subscribers))
+        {
+          this->shared->dataPtr->KeepLatest(this->publisher.Topic(), _buffer,
+            _size, msgType);
+        }
+
+        // Local subscribers need a message, which is parsed from the buffer.
+        std::unique_ptr<ProtoMsg> msg;
+        if (subscribers.haveLocal)
+        {
+          msg = gz::msgs::Factory::New(msgType);
+          if (!msg || !msg->ParseFromArray(_buffer.get(),
+                static_cast<int>(_size)))
           {
-            pubMsgDetails->msgSize = msgSize;
-            // If the sharedBuffer has not been created, do so now.
-            pubMsgDetails->sharedBuffer.reset(new char[msgSize]);
-            memcpy(pubMsgDetails->sharedBuffer.get(), msgBuffer, msgSize);
+            std::cerr << "Node::Publisher::Publish(): Error parsing the "
+                      << "serialized message as [" << msgType << "]"
+                      << std::endl;
+            return false;
           }
-          pubMsgDetails->rawHandlers.push_back(rawHandler);
         }
+
+        return this->Deliver(subscribers, std::move(msg), _buffer, _size);
       }
-    }
 
-    // Add the publish message details to the publish queue. The message
-    // will be published asynchronously to the local and raw callbacks.
-    {
-      std::unique_lock<std::mutex> queueLock(
-          this->dataPtr->shared->dataPtr->pubThreadMutex);
-      this->dataPtr->shared->dataPtr->pubQueue.push_back(
-          std::move(pubMsgDetails));
-    }
+      /// \brief Pointer to the object shared between all the nodes within the
+      /// same process.
+      public: NodeShared *shared = nullptr;
 
-    this->dataPtr->shared->dataPtr->signalNewPub.notify_one();
-  }
+      /// \brief The message publisher.
+      public: MessagePublisher publisher;
 
-  // Handle remote subscribers.
-  if (subscribers.haveRemote)
-  {
-    // Zmq will call this lambda when the message is published.
-    // We use it to deallocate the buffer.
-    auto myDeallocator = [](void *_buffer, void *)
-    {
-      delete[] reinterpret_cast<char*>(_buffer);
+      /// \brief Whether the last messages published are kept for late
+      /// remote subscribers.
+      public: bool latched = false;
+
+      /// \brief Blackboard of the topic, or nullptr.
+      public: std::shared_ptr<ShmWriter> blackboard;
+
+      /// \brief Metrics of the topic, or nullptr if they are disabled.
+      public: Metrics::Entry *metrics = nullptr;
+
+      /// \brief Counters of the publisher, or nullptr if the metrics are
+      /// disabled.
+      public: std::shared_ptr<NodeSharedPrivate::PublisherCounters> counters;
+
+      /// \brief Publisher of the statistics, if they are published.
+      public: Node::Publisher statPub;
+
+      /// \brief Bound of the local publications waiting in the queue, or
+      /// nullptr.
+      public: std::shared_ptr<PublicationBound> queueBound;
+
+      /// \brief Lane delivering the local publications.
+      public: NodeSharedPrivate::PublicationLane *lane = nullptr;
+
+      /// \brief Memory account of the topic, or nullptr.
+      public: MemoryBudget::Account *memoryAccount = nullptr;
+
+      /// \brief Timestamp of the last callback executed.
+      public: Timestamp lastCbTimestamp;
+
+      /// \brief Time of the throttling clock at the last publication, or a
+      /// negative value before the first one.
+      public: std::chrono::nanoseconds lastClockTime{-1};
+
+      /// \brief If throttling is enabled, the minimum period for receiving a
+      /// message in nanoseconds.
+      public: double periodNs = 0.0;
+
+      /// \brief Buffer lent by the last LoanBuffer() call. It is recycled
+      /// when nobody else holds it anymore.
+      public: std::shared_ptr<char[]> loanBuffer;
+
+      /// \brief Serialization buffers reused once the transport and the
+      /// subscribers release them.
+      public: BufferPool buffers;
+
+      /// \brief Capacity of loanBuffer.
+      public: std::size_t loanCapacity = 0;
+
+      /// \brief Version of the remote subscribers used to compute
+      /// remotePeriodNs.
+      public: uint64_t remoteVersion = std::numeric_limits<uint64_t>::max();
+
+      /// \brief Minimum period between two messages sent to the remote
+      /// subscribers in nanoseconds, or 0 if they are not throttled.
+      public: double remotePeriodNs = 0.0;
+
+      /// \brief Timestamp of the last message sent to the remote
+      /// subscribers when they are throttled.
+      public: Timestamp lastRemoteTimestamp;
+
+      /// \brief Version of the remote subscribers used to compute
+      /// remoteFilter.
+      public: uint64_t filterVersion = std::numeric_limits<uint64_t>::max();
+
+      /// \brief Filter matching the messages wanted by the remote
+      /// subscribers, or nullptr if they want every message.
+      public: std::shared_ptr<ContentFilter> remoteFilter;
+
+      /// \brief Bit of Connections() set when there are local subscribers.
+      public: static constexpr uint64_t kHasLocal = 1;
+
+      /// \brief Bit of Connections() set when there are remote subscribers.
+      public: static constexpr uint64_t kHasRemote = 2;
+
+      /// \brief Cached answer of Connections(), shifted left by two bits
+      /// and combined with the version of the subscribers it was computed
+      /// for, NodeSharedPrivate::subscribersVersion.
+      public: std::atomic<uint64_t> connections{
+        std::numeric_limits<uint64_t>::max()};
+
+      /// \brief Channel passing file descriptors to the subscribers of
+      /// this host, or nullptr.
+      public: std::unique_ptr<FdChannel> fdChannel;
+
+      /// \brief Token bucket of the rate limit, or nullptr.
+      public: std::unique_ptr<TokenBucket> msgBucket;
+
+      /// \brief Token bucket of the bandwidth limit, or nullptr.
+      public: std::unique_ptr<TokenBucket> byteBucket;
+
+      /// \brief Whether the limits only apply to the remote subscribers.
+      public: bool rateLimitRemoteOnly = false;
+
+      /// \brief Whether the rate of the remote publications is adaptive.
+      public: bool adaptive = false;
+
+      /// \brief Number of messages dropped by the limits.
+      public: std::atomic<uint64_t> rateLimited{0};
+
+      /// \brief Slots of the real-time publications, or nullptr if the
+      /// publisher isn't real-time.
+      public: std::unique_ptr<RealTimeSlots> realTime;
+
+      /// \brief Descriptor of the advertised type, if real-time.
+      public: const google::protobuf::Descriptor *realTimeDescriptor =
+        nullptr;
+
+      /// \brief Mutex to protect the node::publisher from race conditions.
+      public: mutable std::mutex mutex;
     };
 
-    if (!this->dataPtr->shared->Publish(this->dataPtr->publisher.Topic(),
-          msgBuffer, msgSize, myDeallocator, _msg.GetTypeName()))
+    //////////////////////////////////////////////////
+    /// \internal
+    /// \brief Private data for Node::BlackboardReader class.
+    class Node::BlackboardReaderPrivate
     {
-      return false;
+      /// \brief Open the blackboard, unless it is open already. The caller
+      /// holds the mutex.
+      /// \return False if the topic has no blackboard on this host yet.
+      public: bool Open()
+      {
+        if (this->segment)
+          return true;
+
+        this->segment = ShmSegment::Open(NodeSharedPrivate::kBlackboardUuid,
+          this->topic);
+        if (!this->segment)
+          return false;
+
+        this->msgType = this->segment->MsgType();
+        return true;
+      }
+
+      /// \brief Fully qualified topic name.
+      public: std::string topic;
+
+      /// \brief The blackboard, or nullptr until it is opened.
+      public: std::unique_ptr<ShmSegment> segment;
+
+      /// \brief Message type of the blackboard.
+      public: std::string msgType;
+
+      /// \brief Sequence number of the last message read.
+      public: uint64_t seq = 0;
+
+      /// \brief Last message read, whose capacity is reused.
+      public: std::string data;
+
+      /// \brief Protects the reader.
+      public: std::mutex mutex;
+    };
     }
   }
-  else
+}
+
+//////////////////////////////////////////////////
+Node::Publisher::Publisher()
+  : dataPtr(std::make_shared<PublisherPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+Node::Publisher::Publisher(const MessagePublisher &_publisher)
+  : dataPtr(std::make_shared<PublisherPrivate>(_publisher))
+{
+  if (this->dataPtr->publisher.Options().Throttled())
   {
-    delete[] msgBuffer;
+    this->dataPtr->periodNs =
+      1e9 / this->dataPtr->publisher.Options().MsgsPerSec();
   }
+}
 
-  return true;
+//////////////////////////////////////////////////
+Node::Publisher::~Publisher()
+{
+}
+
+//////////////////////////////////////////////////
+Node::Publisher::operator bool()
+{
+  return this->Valid();
+}
+
+//////////////////////////////////////////////////
+Node::Publisher::operator bool() const
+{
+  return this->Valid();
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::Valid() const
+{
+  return this->dataPtr->Valid();
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::HasConnections() const
+{
+  if (!this->Valid())
+    return false;
+
+  return this->dataPtr->Connections() != 0;
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::Publish(const ProtoMsg &_msg)
+{
+  if (!this->Valid())
+    return false;
+
+  GZ_TRANSPORT_PROBE1(publish__entry,
+    this->dataPtr->publisher.Topic().c_str());
+  const bool result = this->dataPtr->Publish(_msg, nullptr);
+  GZ_TRANSPORT_PROBE2(publish__return,
+    this->dataPtr->publisher.Topic().c_str(), result);
+  return result;
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::Publish(std::shared_ptr<const ProtoMsg> _msg)
+{
+  if (!this->Valid() || !_msg)
+    return false;
+
+  GZ_TRANSPORT_PROBE1(publish__entry,
+    this->dataPtr->publisher.Topic().c_str());
+  const ProtoMsg &msg = *_msg;
+  const bool result = this->dataPtr->Publish(msg, std::move(_msg));
+  GZ_TRANSPORT_PROBE2(publish__return,
+    this->dataPtr->publisher.Topic().c_str(), result);
+  return result;
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::PublishTyped(const ProtoMsg &_msg,
+  std::shared_ptr<const ProtoMsg> _owned)
+{
+  if (!this->Valid())
+    return false;
+
+  GZ_TRANSPORT_PROBE1(publish__entry,
+    this->dataPtr->publisher.Topic().c_str());
+  const bool result = this->dataPtr->Publish(_msg, std::move(_owned), true);
+  GZ_TRANSPORT_PROBE2(publish__return,
+    this->dataPtr->publisher.Topic().c_str(), result);
+  return result;
+}
+
+//////////////////////////////////////////////////
+Node::Publisher::Loan Node::Publisher::LoanBuffer(std::size_t _size)
+{
+  Loan loan;
+  if (!this->Valid())
+    return loan;
+
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+
+  // Reuse the last buffer once the transport and the local subscribers are
+  // done with it.
+  auto &spare = this->dataPtr->loanBuffer;
+  if (!spare || spare.use_count() > 1 ||
+      this->dataPtr->loanCapacity < _size)
+  {
+    spare.reset(new char[std::max<std::size_t>(_size, 1)]);
+    this->dataPtr->loanCapacity = _size;
+  }
+
+  loan.buffer = spare;
+  loan.size = _size;
+  return loan;
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::Publish(Loan &_loan)
+{
+  // The loan is consumed whatever the result.
+  Loan loan = std::move(_loan);
+  _loan = Loan();
+
+  if (!this->Valid() || !loan.Valid())
+    return false;
+
+  GZ_TRANSPORT_PROBE1(publish__entry,
+    this->dataPtr->publisher.Topic().c_str());
+  const bool result =
+    this->dataPtr->PublishSerialized(loan.buffer, loan.size);
+  GZ_TRANSPORT_PROBE2(publish__return,
+    this->dataPtr->publisher.Topic().c_str(), result);
+  return result;
+}
+
+//////////////////////////////////////////////////
+Node::Publisher::Loan::Loan() = default;
+
+//////////////////////////////////////////////////
+bool Node::Publisher::Loan::Valid() const
+{
+  return this->buffer != nullptr;
+}
+
+//////////////////////////////////////////////////
+char *Node::Publisher::Loan::Data()
+{
+  return this->buffer.get();
+}
+
+//////////////////////////////////////////////////
+std::size_t Node::Publisher::Loan::Size() const
+{
+  return this->size;
 }
 
 //////////////////////////////////////////////////
@@ -457,9 +1340,26 @@ bool Node::Publisher::PublishRaw(
 
   const std::string &topic = this->dataPtr->publisher.Topic();
 
-  const NodeShared::SubscriberInfo &subscribers =
+  NodeShared::SubscriberInfo subscribers =
       this->dataPtr->shared->CheckSubscriberInfo(topic, _msgType);
 
+  // Skip the remote subscribers if all of them would discard the message.
+  if (subscribers.haveRemote && !this->dataPtr->RemoteSubscribersReady())
+    subscribers.haveRemote = false;
+
+  if (!this->dataPtr->RateLimit(subscribers, _msgData.size()))
+    return true;
+
+  if (this->dataPtr->TakeCredit(subscribers))
+  {
+    std::shared_ptr<char[]> keptBuffer(new char[_msgData.size()]);
+    memcpy(keptBuffer.get(), _msgData.data(), _msgData.size());
+    this->dataPtr->shared->dataPtr->KeepLatest(topic, keptBuffer,
+      _msgData.size(), _msgType);
+  }
+
+  this->dataPtr->CountPublication(subscribers, _msgData.size());
+
   MessageInfo info;
   info.SetTopicAndPartition(topic);
   info.SetType(_msgType);
@@ -468,28 +1368,151 @@ bool Node::Publisher::PublishRaw(
   // Trigger local subscribers.
   this->dataPtr->shared->TriggerCallbacks(info, _msgData, subscribers);
 
+  // Keep a copy of the message for late subscribers.
+  if (this->dataPtr->latched)
+  {
+    std::shared_ptr<char[]> latchedBuffer(new char[_msgData.size()]);
+    memcpy(latchedBuffer.get(), _msgData.data(), _msgData.size());
+    this->dataPtr->shared->dataPtr->StoreLatched(topic, latchedBuffer,
+      _msgData.size());
+  }
+
+  this->dataPtr->WriteBlackboard(_msgData.data(), _msgData.size());
+
   // Remote subscribers. Note that the data is already presumed to be
   // serialized, so we just pass it along for publication.
   if (subscribers.haveRemote)
   {
     const std::size_t msgSize = _msgData.size();
-    char *msgBuffer = static_cast<char *>(new char[msgSize]);
-    memcpy(msgBuffer, _msgData.c_str(), msgSize);
-    auto myDeallocator = [](void *_buffer, void * /*_hint*/)
+    std::shared_ptr<char[]> msgBuffer =
+      this->dataPtr->buffers.Acquire(msgSize);
+    memcpy(msgBuffer.get(), _msgData.c_str(), msgSize);
+
+    // ZeroMQ holds a reference to the buffer until the message is sent,
+    // then the buffer returns to the pool.
+    auto *ref = new std::shared_ptr<char[]>(std::move(msgBuffer));
+    auto myDeallocator = [](void *, void *_hint)
     {
-      delete[] reinterpret_cast<char*>(_buffer);
+      delete reinterpret_cast<std::shared_ptr<char[]>*>(_hint);
     };
 
     // Note: This will copy _msgData (i.e. not zero copy)
     if (!this->dataPtr->shared->Publish(
           this->dataPtr->publisher.Topic(),
-          msgBuffer, msgSize, myDeallocator, _msgType))
+          ref->get(), msgSize, myDeallocator, ref, _msgType))
     {
+      this->dataPtr->CountSendFailure();
       return false;
     }
   }
 
+  this->dataPtr->PublishStatistics();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::PublishRaw(
+    const std::shared_ptr<const char[]> &_msgData,
+    const std::size_t _size,
+    const std::string &_msgType)
+{
+  if (!this->dataPtr->Valid() || !_msgData)
+    return false;
+
+  const std::string &publisherMsgType = this->dataPtr->publisher.MsgTypeName();
+
+  // A generic publisher can't parse the message for the local subscribers,
+  // it takes the copy path.
+  if (publisherMsgType == kGenericMessageType &&
+      publisherMsgType != _msgType)
+  {
+    return this->PublishRaw(std::string(_msgData.get(), _size), _msgType);
+  }
+
+  if (publisherMsgType != _msgType)
+  {
+    std::cerr << "Node::Publisher::PublishRaw() type mismatch.\n"
+              << "\t* Type advertised: " << publisherMsgType
+              << "\n\t* Type published: " << _msgType << std::endl;
+    return false;
+  }
+
+  // The transport only reads the buffer.
+  return this->dataPtr->PublishSerialized(
+    std::const_pointer_cast<char[]>(_msgData), _size);
+}
+
+//////////////////////////////////////////////////
+bool Node::Publisher::PublishFd(const ProtoMsg &_msg, int _fd)
+{
+  if (!this->dataPtr->Valid())
+    return false;
+
+  const std::string &topic = this->dataPtr->publisher.Topic();
+  const std::string &msgType = this->dataPtr->publisher.MsgTypeName();
+  if (!this->dataPtr->publisher.Options().FdPassing())
+  {
+    std::cerr << "Node::Publisher::PublishFd(): Topic [" << topic
+              << "] isn't advertised with file descriptor passing"
+              << std::endl;
+    return false;
+  }
+
+  if (msgType != _msg.GetTypeName())
+  {
+    std::cerr << "Node::Publisher::PublishFd() Type mismatch.\n"
+              << "\t* Type advertised: " << msgType
+              << "\n\t* Type published: " << _msg.GetTypeName()
+              << std::endl;
+    return false;
+  }
+
+#ifdef _WIN32
+  (void)_fd;
+  std::cerr << "Node::Publisher::PublishFd(): File descriptors can't be "
+            << "passed on this platform" << std::endl;
+  return false;
+#else
+  std::string data;
+  if (!_msg.SerializeToString(&data) || data.size() > FdChannel::kMaxData)
+  {
+    std::cerr << "Node::Publisher::PublishFd(): Error serializing data, "
+              << "the metadata must fit in " << FdChannel::kMaxData
+              << " bytes" << std::endl;
+    return false;
+  }
+
+  // Subscriber processes of this host.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+    if (this->dataPtr->fdChannel)
+      this->dataPtr->fdChannel->Send(data, _fd);
+  }
+
+  // Subscribers of this process receive their own duplicate.
+  NodeShared::SubscriberInfo subscribers =
+    this->dataPtr->shared->CheckSubscriberInfo(topic, msgType);
+  subscribers.haveRemote = false;
+  this->dataPtr->CountPublication(subscribers, data.size());
+  if (subscribers.haveLocal || subscribers.haveRaw)
+  {
+    MessageInfo info;
+    info.SetTopicAndPartition(topic);
+    info.SetType(msgType);
+    info.SetIntraProcess(true);
+    info.SetFd(fcntl(_fd, F_DUPFD_CLOEXEC, 0));
+    this->dataPtr->shared->TriggerCallbacks(info, data, subscribers);
+  }
+
+  this->dataPtr->PublishStatistics();
   return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+PublisherStatistics Node::Publisher::Statistics() const
+{
+  return this->dataPtr->Statistics();
 }
 
 //////////////////////////////////////////////////
@@ -504,6 +1527,70 @@ bool Node::Publisher::UpdateThrottling()
   return this->dataPtr->UpdateThrottling();
 }
 
+//////////////////////////////////////////////////
+Node::BlackboardReader::BlackboardReader()
+  : dataPtr(std::make_shared<BlackboardReaderPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+Node::BlackboardReader::~BlackboardReader() = default;
+
+//////////////////////////////////////////////////
+bool Node::BlackboardReader::Valid() const
+{
+  return !this->dataPtr->topic.empty();
+}
+
+//////////////////////////////////////////////////
+bool Node::BlackboardReader::Updated()
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  if (!this->Valid() || !this->dataPtr->Open())
+    return false;
+
+  return this->dataPtr->segment->WriteSeq() != this->dataPtr->seq;
+}
+
+//////////////////////////////////////////////////
+bool Node::BlackboardReader::Read(ProtoMsg &_msg)
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  if (!this->Valid() || !this->dataPtr->Open())
+    return false;
+
+  if (this->dataPtr->msgType != _msg.GetTypeName())
+  {
+    std::cerr << "Node::BlackboardReader::Read() Type mismatch.\n"
+              << "\t* Type of the blackboard: " << this->dataPtr->msgType
+              << "\n\t* Type read: " << _msg.GetTypeName() << std::endl;
+    return false;
+  }
+
+  if (!this->dataPtr->segment->ReadLatest(this->dataPtr->data,
+        this->dataPtr->seq))
+  {
+    return false;
+  }
+
+  return _msg.ParseFromString(this->dataPtr->data);
+}
+
+//////////////////////////////////////////////////
+bool Node::BlackboardReader::ReadRaw(std::string &_data,
+    std::string &_msgType)
+{
+  std::lock_guard<std::mutex> lk(this->dataPtr->mutex);
+  if (!this->Valid() || !this->dataPtr->Open())
+    return false;
+
+  if (!this->dataPtr->segment->ReadLatest(_data, this->dataPtr->seq))
+    return false;
+
+  _msgType = this->dataPtr->msgType;
+  return true;
+}
+
 //////////////////////////////////////////////////
 Node::Node(const NodeOptions &_options)
   : dataPtr(new NodePrivate())
@@ -514,6 +1601,13 @@ Node::Node(const NodeOptions &_options)
 
   // Save the options.
   this->dataPtr->options = _options;
+
+  if (_options.SpinMode())
+  {
+    this->dataPtr->spinQueue = std::make_shared<SpinQueue>();
+    this->dataPtr->shared->dataPtr->RegisterSpinQueue(this->dataPtr->nUuid,
+      this->dataPtr->spinQueue);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -525,6 +1619,8 @@ Node::Node():
 //////////////////////////////////////////////////
 Node::~Node()
 {
+  this->UnwatchTopicGraph();
+
   // Unsubscribe from all the topics.
   auto subsTopics = this->SubscribedTopics();
   for (auto const &topic : subsTopics)
@@ -544,8 +1640,65 @@ Node::~Node()
     }
   }
 
-  // The list of advertised services should be empty.
-  assert(this->AdvertisedServices().empty());
+  // The list of advertised services should be empty.
+  assert(this->AdvertisedServices().empty());
+
+  this->dataPtr->shared->dataPtr->RemoveCallbackGroups(this->dataPtr->nUuid);
+
+  // Drop the callbacks that were never spun.
+  if (this->dataPtr->spinQueue)
+  {
+    this->dataPtr->shared->dataPtr->UnregisterSpinQueue(this->dataPtr->nUuid);
+    this->dataPtr->spinQueue->Close();
+  }
+}
+
+//////////////////////////////////////////////////
+bool Node::SpinOnce(const std::chrono::milliseconds &_timeout)
+{
+  if (!this->dataPtr->spinQueue)
+    return false;
+
+  return this->dataPtr->spinQueue->RunOne(_timeout);
+}
+
+//////////////////////////////////////////////////
+std::size_t Node::SpinSome()
+{
+  if (!this->dataPtr->spinQueue)
+    return 0;
+
+  return this->dataPtr->spinQueue->RunSome();
+}
+
+//////////////////////////////////////////////////
+bool Node::CreateCallbackGroup(const std::string &_name,
+  const CallbackGroupOptions &_opts)
+{
+  if (_name.empty())
+  {
+    std::cerr << "Node::CreateCallbackGroup(): Empty group name"
+              << std::endl;
+    return false;
+  }
+
+  if (!this->dataPtr->shared->dataPtr->AddCallbackGroup(this->dataPtr->nUuid,
+        _name, _opts))
+  {
+    std::cerr << "Node::CreateCallbackGroup(): Group [" << _name
+              << "] already exists" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+int Node::SpinFd()
+{
+  if (!this->dataPtr->spinQueue)
+    return -1;
+
+  return this->dataPtr->spinQueue->Fd();
 }
 
 //////////////////////////////////////////////////
@@ -577,6 +1730,28 @@ std::vector<std::string> Node::AdvertisedTopics() const
   return v;
 }
 
+//////////////////////////////////////////////////
+Node::BlackboardReader Node::OpenBlackboard(const std::string &_topic) const
+{
+  // Topic remapping.
+  std::string topic = _topic;
+  this->Options().TopicRemap(_topic, topic);
+
+  BlackboardReader reader;
+  std::string fullyQualifiedTopic;
+  if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+    this->Options().NameSpace(), topic, fullyQualifiedTopic))
+  {
+    std::cerr << "Topic [" << topic << "] is not valid." << std::endl;
+    return reader;
+  }
+
+  reader.dataPtr->topic = fullyQualifiedTopic;
+  std::lock_guard<std::mutex> lk(reader.dataPtr->mutex);
+  reader.dataPtr->Open();
+  return reader;
+}
+
 //////////////////////////////////////////////////
 std::vector<std::string> Node::SubscribedTopics() const
 {
@@ -610,20 +1785,14 @@ bool Node::Unsubscribe(const std::string &_topic)
     return false;
   }
 
-  // Remove handlers from shared pubQueue to avoid invoking callbacks after
-  // unsuscribing to the topic
-  if (!this->dataPtr->RemoveHandlersFromPubQueue(topic))
-  {
-    std::cerr << "Error removing subscription handlers from publish queue "
-              << "when unsubscribing from Topic [" << _topic << "]"
-              <<  std::endl;
-  }
-
   std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
 
   // Remove the subscribers for the given topic that belong to this node.
+  // They are detached, so the queued publications don't invoke them.
   this->dataPtr->shared->localSubscribers.RemoveHandlersForNode(
         fullyQualifiedTopic, this->dataPtr->nUuid);
+  this->dataPtr->shared->dataPtr->subscribersVersion.fetch_add(
+    1, std::memory_order_release);
 
   // Remove the topic from the list of subscribed topics in this node.
   this->dataPtr->topicsSubscribed.erase(fullyQualifiedTopic);
@@ -632,26 +1801,32 @@ bool Node::Unsubscribe(const std::string &_topic)
   if (!this->dataPtr->shared->localSubscribers
       .HasSubscriber(fullyQualifiedTopic))
   {
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->dataPtr->shared->dataPtr->subscriber->set(
-      zmq::sockopt::unsubscribe, fullyQualifiedTopic);
-#else
-    this->dataPtr->shared->dataPtr->subscriber->setsockopt(
-      ZMQ_UNSUBSCRIBE, fullyQualifiedTopic.data(), fullyQualifiedTopic.size());
-#endif
+    this->dataPtr->shared->dataPtr->UnsubscribeTopicFilter(
+      fullyQualifiedTopic);
+    this->dataPtr->shared->dataPtr->ReleaseTopicConnections(
+      this->dataPtr->shared->connections, fullyQualifiedTopic);
+    this->dataPtr->shared->dataPtr->DetachShmReaders(
+      fullyQualifiedTopic, "", this->dataPtr->shared->pUuid);
   }
 
   // Notify to the publishers that I am no longer interested in the topic.
-  MsgAddresses_M addresses;
-  if (!this->dataPtr->shared->dataPtr->msgDiscovery->Publishers(
-        fullyQualifiedTopic, addresses))
+  std::set<std::string> procs;
+  if (!this->dataPtr->shared->dataPtr->msgDiscovery->VisitPublishers(
+        fullyQualifiedTopic, [&procs](const MessagePublisher &_pub)
+        {
+          procs.insert(_pub.PUuid());
+        }))
   {
+    // Without publishers, only the lists of subscribers need the update.
+    MessagePublisher pub(fullyQualifiedTopic, this->dataPtr->shared->myAddress,
+      "", this->dataPtr->shared->pUuid, this->dataPtr->nUuid,
+      kGenericMessageType, AdvertiseMessageOptions());
+    this->Shared()->dataPtr->msgDiscovery->Unregister(pub);
     return false;
   }
 
-  for (auto &proc : addresses)
+  for (const auto &dstPUuid : procs)
   {
-    std::string dstPUuid = proc.first;
     MessagePublisher pub(fullyQualifiedTopic, this->dataPtr->shared->myAddress,
       dstPUuid, this->dataPtr->shared->pUuid, this->dataPtr->nUuid,
       kGenericMessageType, AdvertiseMessageOptions());
@@ -702,6 +1877,12 @@ bool Node::UnadvertiseSrv(const std::string &_topic)
   // Remove all the REP handlers for this node.
   this->dataPtr->shared->repliers.RemoveHandlersForNode(
     fullyQualifiedTopic, this->dataPtr->nUuid);
+  if (!this->dataPtr->shared->repliers.HasHandlersForTopic(
+        fullyQualifiedTopic))
+  {
+    this->dataPtr->shared->dataPtr->RemoveServiceExecution(
+      fullyQualifiedTopic);
+  }
 
   // Notify the discovery service to unregister and unadvertise my services.
   if (!this->dataPtr->shared->dataPtr->srvDiscovery->Unadvertise(
@@ -713,12 +1894,118 @@ bool Node::UnadvertiseSrv(const std::string &_topic)
   return true;
 }
 
+//////////////////////////////////////////////////
+bool Node::InvalidateServiceCache(const std::string &_topic)
+{
+  // Topic remapping.
+  std::string topic = _topic;
+  this->Options().TopicRemap(_topic, topic);
+
+  std::string fullyQualifiedTopic;
+  if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+    this->Options().NameSpace(), topic, fullyQualifiedTopic))
+  {
+    std::cerr << "Service [" << topic << "] is not valid." << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+
+  // Find the advertisement of this node.
+  auto &discovery = this->dataPtr->shared->dataPtr->srvDiscovery;
+  SrvAddresses_M addresses;
+  if (!discovery->Publishers(fullyQualifiedTopic, addresses))
+    return false;
+
+  auto procIt = addresses.find(this->dataPtr->shared->pUuid);
+  if (procIt == addresses.end())
+    return false;
+
+  auto pubIt = std::find_if(procIt->second.begin(), procIt->second.end(),
+    [this](const ServicePublisher &_pub)
+    {
+      return _pub.NUuid() == this->dataPtr->nUuid;
+    });
+  if (pubIt == procIt->second.end())
+  {
+    std::cerr << "Node::InvalidateServiceCache(): Service [" << topic
+              << "] is not advertised by this node" << std::endl;
+    return false;
+  }
+
+  // The requesters drop the cached responses when the service goes away.
+  const ServicePublisher publisher = *pubIt;
+  return discovery->Unadvertise(fullyQualifiedTopic, this->dataPtr->nUuid) &&
+         discovery->Advertise(publisher);
+}
+
+//////////////////////////////////////////////////
+bool Node::WatchTopicGraph(std::vector<MessagePublisher> &_publishers,
+  const TopicGraphCallback &_cb)
+{
+  _publishers.clear();
+
+  if (!_cb)
+  {
+    std::cerr << "Node::WatchTopicGraph(): Invalid callback" << std::endl;
+    return false;
+  }
+
+  // The graph is made of the publishers of all the processes.
+  this->dataPtr->shared->EnsureNetwork();
+
+  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+  auto &graph = this->dataPtr->shared->dataPtr->graph;
+
+  std::vector<std::string> allTopics;
+  graph.TopicList(allTopics);
+
+  for (const auto &fullyQualifiedTopic : allTopics)
+  {
+    std::string partition;
+    std::string topic;
+    TopicUtils::DecomposeFullyQualifiedTopic(
+          fullyQualifiedTopic, partition, topic);
+
+    // Remove the front '/'
+    if (!partition.empty())
+      partition.erase(partition.begin());
+
+    // Discard if the partition name does not match this node's partition.
+    if (partition != this->Options().Partition())
+      continue;
+
+    MsgAddresses_M pubs;
+    graph.Publishers(fullyQualifiedTopic, pubs);
+    for (const auto &proc : pubs)
+    {
+      _publishers.insert(_publishers.end(), proc.second.begin(),
+        proc.second.end());
+    }
+  }
+
+  TopicGraphWatcher &watcher =
+    this->dataPtr->shared->dataPtr->graphWatchers[this->NodeUuid()];
+  watcher.partition = this->Options().Partition();
+  watcher.cb = _cb;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Node::UnwatchTopicGraph()
+{
+  std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
+  return this->dataPtr->shared->dataPtr->graphWatchers.erase(
+    this->NodeUuid()) > 0;
+}
+
 //////////////////////////////////////////////////
 void Node::TopicList(std::vector<std::string> &_topics) const
 {
   std::vector<std::string> allTopics;
   _topics.clear();
 
+  this->dataPtr->shared->EnsureNetwork();
   this->dataPtr->shared->dataPtr->msgDiscovery->TopicList(allTopics);
 
   for (const auto &fullyQualifiedTopic : allTopics)
@@ -746,6 +2033,7 @@ void Node::ServiceList(std::vector<std::string> &_services) const
   std::vector<std::string> allServices;
   _services.clear();
 
+  this->dataPtr->shared->EnsureNetwork();
   this->dataPtr->shared->dataPtr->srvDiscovery->TopicList(allServices);
 
   for (auto &service : allServices)
@@ -795,8 +2083,10 @@ bool Node::SubscribeRaw(
 
   std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
 
-  this->dataPtr->shared->localSubscribers.raw.AddHandler(
+  this->dataPtr->shared->localSubscribers.AddHandler(
         fullyQualifiedTopic, this->dataPtr->nUuid, handlerPtr);
+  this->dataPtr->shared->dataPtr->subscribersVersion.fetch_add(
+    1, std::memory_order_release);
 
   return this->dataPtr->SubscribeHelper(fullyQualifiedTopic);
 }
@@ -875,6 +2165,35 @@ const std::string &Node::NodeUuid() const
   return this->dataPtr->nUuid;
 }
 
+//////////////////////////////////////////////////
+const std::string *Node::FullyQualifiedName(const std::string &_topic) const
+{
+  {
+    std::shared_lock<std::shared_mutex> lk(
+      this->dataPtr->fullyQualifiedNamesMutex);
+    auto it = this->dataPtr->fullyQualifiedNames.find(_topic);
+    if (it != this->dataPtr->fullyQualifiedNames.end())
+      return &it->second;
+  }
+
+  // Topic remapping.
+  std::string topic = _topic;
+  this->Options().TopicRemap(_topic, topic);
+
+  std::string fullyQualifiedTopic;
+  if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+    this->Options().NameSpace(), topic, fullyQualifiedTopic))
+  {
+    return nullptr;
+  }
+
+  // The elements of an unordered_map don't move, so the name stays valid.
+  std::unique_lock<std::shared_mutex> lk(
+    this->dataPtr->fullyQualifiedNamesMutex);
+  return &this->dataPtr->fullyQualifiedNames.emplace(
+    _topic, std::move(fullyQualifiedTopic)).first->second;
+}
+
 //////////////////////////////////////////////////
 std::unordered_set<std::string> &Node::TopicsSubscribed() const
 {
@@ -902,6 +2221,7 @@ bool Node::TopicInfo(const std::string &_topic,
 {
   // We trigger a topic list to update the list of remote subscribers.
   std::vector<std::string> allTopics;
+  this->dataPtr->shared->EnsureNetwork();
   this->dataPtr->shared->dataPtr->msgDiscovery->TopicList(allTopics);
 
   // Construct a topic name with the partition and namespace
@@ -960,6 +2280,7 @@ bool Node::TopicInfo(const std::string &_topic,
 bool Node::ServiceInfo(const std::string &_service,
                        std::vector<ServicePublisher> &_publishers) const
 {
+  this->dataPtr->shared->EnsureNetwork();
   this->dataPtr->shared->dataPtr->srvDiscovery->WaitForInit();
 
   // Construct a topic name with the partition and namespace
@@ -972,37 +2293,59 @@ bool Node::ServiceInfo(const std::string &_service,
 
   std::lock_guard<std::recursive_mutex> lk(this->dataPtr->shared->mutex);
 
-  // Get all the publishers on the given service.
-  SrvAddresses_M pubs;
-  if (!this->dataPtr->shared->dataPtr->srvDiscovery->Publishers(
-        fullyQualifiedTopic, pubs))
-  {
-    return false;
-  }
-
+  // Copy the publishers on the given service.
   _publishers.clear();
-
-  // Copy the publishers.
-  for (SrvAddresses_M::iterator iter = pubs.begin(); iter != pubs.end(); ++iter)
-  {
-    for (std::vector<ServicePublisher>::iterator pubIter = iter->second.begin();
-         pubIter != iter->second.end(); ++pubIter)
+  return this->dataPtr->shared->dataPtr->srvDiscovery->VisitPublishers(
+    fullyQualifiedTopic, [&_publishers](const ServicePublisher &_pub)
     {
       // Add the publisher if it doesn't already exist.
-      if (std::find(_publishers.begin(), _publishers.end(), *pubIter) ==
+      if (std::find(_publishers.begin(), _publishers.end(), _pub) ==
           _publishers.end())
       {
-        _publishers.push_back(*pubIter);
+        _publishers.push_back(_pub);
       }
-    }
-  }
-
-  return true;
+    });
 }
 
 /////////////////////////////////////////////////
 Node::Publisher Node::Advertise(const std::string &_topic,
     const std::string &_msgTypeName, const AdvertiseMessageOptions &_options)
+{
+  return this->AdvertiseHelper(_topic, _msgTypeName, _options, true);
+}
+
+//////////////////////////////////////////////////
+std::vector<Node::Publisher> Node::AdvertiseMany(
+    const std::vector<std::string> &_topics,
+    const std::string &_msgTypeName, const AdvertiseMessageOptions &_options)
+{
+  std::vector<Publisher> pubs;
+  pubs.reserve(_topics.size());
+  std::vector<MessagePublisher> announced;
+  announced.reserve(_topics.size());
+
+  {
+    std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+    for (const auto &topic : _topics)
+    {
+      pubs.push_back(
+        this->AdvertiseHelper(topic, _msgTypeName, _options, false));
+      if (pubs.back() && _options.Scope() != Scope_t::PROCESS)
+        announced.push_back(pubs.back().dataPtr->publisher);
+    }
+  }
+
+  // All the topics are announced together.
+  this->Shared()->dataPtr->msgDiscovery->Announce(announced);
+
+  return pubs;
+}
+
+//////////////////////////////////////////////////
+Node::Publisher Node::AdvertiseHelper(const std::string &_topic,
+    const std::string &_msgTypeName, const AdvertiseMessageOptions &_options,
+    const bool _announce)
 {
   // Topic remapping.
   std::string topic = _topic;
@@ -1028,16 +2371,90 @@ Node::Publisher Node::Advertise(const std::string &_topic,
     return Publisher();
   }
 
+  // Only the topics leaving the process need the sockets.
+  if (_options.Scope() != Scope_t::PROCESS)
+    this->Shared()->EnsureNetwork();
+
   std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
 
+  // High priority topics are sent through their own socket.
+  std::string address = this->Shared()->myAddress;
+  const bool highPriority =
+    _options.HighPriority() && _options.Scope() != Scope_t::PROCESS;
+  if (highPriority)
+  {
+    address = this->Shared()->dataPtr->PriorityAddress();
+    if (address.empty())
+    {
+      std::cerr << "Node::Advertise(): Error advertising topic ["
+                << topic << "] with high priority" << std::endl;
+      return Publisher();
+    }
+  }
+
+  // Topics may be sent through a specific network interface.
+  const bool onInterface = !highPriority && !_options.Interface().empty() &&
+    _options.Scope() != Scope_t::PROCESS;
+  if (onInterface)
+  {
+    address = this->Shared()->dataPtr->InterfaceAddress(_options.Interface());
+    if (address.empty())
+    {
+      std::cerr << "Node::Advertise(): Error advertising topic ["
+                << topic << "] on interface [" << _options.Interface()
+                << "]" << std::endl;
+      return Publisher();
+    }
+  }
+
+  // Topics may be sent once to all the remote subscribers through
+  // multicast, or through TCP if multicast isn't available.
+  bool onMulticast = !highPriority && !onInterface && _options.Multicast() &&
+    _options.Scope() == Scope_t::ALL;
+  if (onMulticast)
+  {
+    const std::string multicastAddress =
+      this->Shared()->dataPtr->MulticastAddress();
+    if (multicastAddress.empty())
+    {
+      std::cerr << "Node::Advertise(): Topic [" << topic << "] can't be sent "
+                << "through multicast, using TCP" << std::endl;
+      onMulticast = false;
+    }
+    else
+    {
+      address = multicastAddress;
+    }
+  }
+
+  // Same-host subscribers connect to the descriptor channel as soon as
+  // they discover the topic, so it exists before the topic is advertised.
+  std::unique_ptr<FdChannel> fdChannel;
+  if (_options.FdPassing() && _options.Scope() != Scope_t::PROCESS)
+  {
+    fdChannel = FdChannel::Listen(
+      FdChannel::Name(this->Shared()->pUuid, fullyQualifiedTopic));
+    if (!fdChannel)
+    {
+      std::cerr << "Node::Advertise(): Error opening the file descriptor "
+                << "channel of topic [" << topic << "]" << std::endl;
+      return Publisher();
+    }
+  }
+
   // Notify the discovery service to register and advertise my topic.
   MessagePublisher publisher(fullyQualifiedTopic,
-      this->Shared()->myAddress,
+      address,
       // this->Shared()->myControlAddress,
       "unused",
       this->Shared()->pUuid, this->NodeUuid(), _msgTypeName, _options);
+  if (onMulticast)
+  {
+    std::lock_guard<std::mutex> lk(this->Shared()->dataPtr->priorityMutex);
+    publisher.SetMulticastGroup(this->Shared()->dataPtr->multicastGroup);
+  }
 
-  if (!this->Shared()->dataPtr->msgDiscovery->Advertise(publisher))
+  if (!this->Shared()->dataPtr->msgDiscovery->Advertise(publisher, _announce))
   {
     std::cerr << "Node::Advertise(): Error advertising topic ["
       << topic
@@ -1046,7 +2463,82 @@ Node::Publisher Node::Advertise(const std::string &_topic,
     return Publisher();
   }
 
-  return Publisher(publisher);
+  if (highPriority)
+    this->Shared()->dataPtr->CreatePriority(fullyQualifiedTopic);
+  else if (onInterface)
+  {
+    this->Shared()->dataPtr->CreateInterfaceTopic(fullyQualifiedTopic,
+      _options.Interface());
+  }
+  else if (onMulticast)
+    this->Shared()->dataPtr->CreateMulticastTopic(fullyQualifiedTopic);
+
+  // Same-host subscribers may read the topic from shared memory. The
+  // segments are read by a single thread, so high priority topics don't
+  // use them, and they don't carry the sequence numbers of the reliable
+  // topics.
+  if (_options.Scope() != Scope_t::PROCESS && !highPriority &&
+      !_options.Reliable())
+  {
+    this->Shared()->dataPtr->CreateShmWriter(fullyQualifiedTopic,
+      _msgTypeName, this->Shared()->pUuid, this->Options().NumaNode());
+  }
+
+  // Remote publications may be coalesced, unless they are numbered.
+  if (_options.Batched() && !_options.Reliable() &&
+      _options.Scope() != Scope_t::PROCESS)
+  {
+    this->Shared()->dataPtr->CreateBatch(this->Shared(), fullyQualifiedTopic,
+      _msgTypeName, _options);
+  }
+
+  // Remote publications may be compressed.
+  if (_options.Compression() != Compression_t::NONE &&
+      _options.Scope() != Scope_t::PROCESS)
+  {
+    this->Shared()->dataPtr->CreateCompression(fullyQualifiedTopic,
+      _options);
+  }
+
+  // The last messages may be kept for late subscribers.
+  if (_options.Latched() && _options.Scope() != Scope_t::PROCESS)
+  {
+    this->Shared()->dataPtr->CreateLatch(this->Shared(), fullyQualifiedTopic,
+      _msgTypeName, _options);
+  }
+
+  // The last messages may be kept for the subscribers that lose them.
+  if (_options.Reliable() && _options.Scope() != Scope_t::PROCESS)
+  {
+    this->Shared()->dataPtr->CreateReliable(this->Shared(),
+      fullyQualifiedTopic, _msgTypeName, _options);
+  }
+
+  // The rate of the remote publications may adapt to the links.
+  if (_options.Adaptive() && _options.Scope() != Scope_t::PROCESS)
+  {
+    this->Shared()->dataPtr->CreateAdaptive(this->Shared(),
+      fullyQualifiedTopic, _options);
+  }
+
+  // The traffic of the topics leaving the process is reported to
+  // gz topic --top.
+  if (_options.Scope() != Scope_t::PROCESS)
+    this->Shared()->dataPtr->StartTopicReport(this->Shared()->pUuid);
+
+  Publisher pub(publisher);
+  pub.dataPtr->fdChannel = std::move(fdChannel);
+
+  // The statistics of the publisher may be published by the same node.
+  if (!_options.StatisticsTopic().empty())
+  {
+    AdvertiseMessageOptions statOpts;
+    statOpts.SetMsgsPerSec(_options.StatisticsRate());
+    pub.dataPtr->statPub = this->Advertise(_options.StatisticsTopic(),
+      "gz.msgs.Metric", statOpts);
+  }
+
+  return pub;
 }
 
 //////////////////////////////////////////////////
@@ -1056,6 +2548,7 @@ bool NodePrivate::SubscribeHelper(const std::string &_fullyQualifiedTopic)
   this->topicsSubscribed.insert(_fullyQualifiedTopic);
 
   // Discover the list of nodes that publish on the topic.
+  this->shared->EnsureNetwork();
   if (!this->shared->dataPtr->msgDiscovery->Discover(_fullyQualifiedTopic))
   {
     std::cerr << "Node::Subscribe(): Error discovering topic ["
@@ -1065,6 +2558,10 @@ bool NodePrivate::SubscribeHelper(const std::string &_fullyQualifiedTopic)
     return false;
   }
 
+  // The other processes list the subscribed topics without asking.
+  this->shared->dataPtr->AnnounceSubscribers(this->shared, this->nUuid,
+    {_fullyQualifiedTopic});
+
   return true;
 }
 
@@ -1075,46 +2572,6 @@ bool Node::SubscribeHelper(const std::string &_fullyQualifiedTopic)
 }
 
 //////////////////////////////////////////////////
-bool NodePrivate::RemoveHandlersFromPubQueue(const std::string &_topic)
-{
-  // Remove from pubQueue
-  std::unique_lock<std::mutex> queueLock(
-      this->shared->dataPtr->pubThreadMutex);
-  for (auto &msgDetails : this->shared->dataPtr->pubQueue)
-  {
-    // check if there is a pub queue with message details that has topic
-    // which the node unsubscribes to
-    if (msgDetails->info.Topic() != _topic)
-      continue;
-
-    // remove local handler if it is a handler for this node
-    for (auto handlerIt = msgDetails->localHandlers.begin();
-         handlerIt != msgDetails->localHandlers.end();)
-    {
-      if ((*handlerIt)->NodeUuid() == this->nUuid)
-      {
-        msgDetails->localHandlers.erase(handlerIt);
-      }
-      else
-        ++handlerIt;
-    }
-
-    // remove raw handler if it is a handler for this node
-    for (auto handlerIt = msgDetails->rawHandlers.begin();
-         handlerIt != msgDetails->rawHandlers.end();)
-    {
-      if ((*handlerIt)->NodeUuid() == this->nUuid)
-      {
-        msgDetails->rawHandlers.erase(handlerIt);
-      }
-      else
-        ++handlerIt;
-    }
-  }
-  return true;
-}
-
-/////////////////////////////////////////////////
 bool Node::RequestRaw(const std::string &_topic,
     const std::string &_request, const std::string &_requestType,
     const std::string &_responseType, unsigned int _timeout,
@@ -1151,3 +2608,92 @@ void Node::AddGlobalRelay(const std::string& _relayAddress) {
 std::vector<std::string> Node::GlobalRelays() const {
   return Shared()->GlobalRelays();
 }
+
+/////////////////////////////////////////////////
+bool Node::SubscribeHandler(const std::string &_topic,
+  const ISubscriptionHandlerPtr &_handler)
+{
+  if (!validFilter(_handler))
+    return false;
+
+  // Topic remapping.
+  std::string topic = _topic;
+  this->Options().TopicRemap(_topic, topic);
+
+  std::string fullyQualifiedTopic;
+  if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+    this->Options().NameSpace(), topic, fullyQualifiedTopic))
+  {
+    std::cerr << "Topic [" << topic << "] is not valid." << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+  // Store the subscription handler. Each subscription handler is
+  // associated with a topic. When the receiving thread gets new data,
+  // it will recover the subscription handler associated to the topic and
+  // will invoke the callback.
+  this->Shared()->localSubscribers.AddHandler(
+    fullyQualifiedTopic, this->NodeUuid(), _handler);
+  this->Shared()->dataPtr->subscribersVersion.fetch_add(
+    1, std::memory_order_release);
+
+  return this->SubscribeHelper(fullyQualifiedTopic);
+}
+
+/////////////////////////////////////////////////
+bool Node::SubscribeHandlers(const std::vector<std::string> &_topics,
+  const std::vector<ISubscriptionHandlerPtr> &_handlers)
+{
+  // Nothing is subscribed unless all the topics and filters are valid.
+  for (const auto &handler : _handlers)
+  {
+    if (!validFilter(handler))
+      return false;
+  }
+
+  std::vector<std::string> fullyQualifiedTopics;
+  fullyQualifiedTopics.reserve(_topics.size());
+  for (const auto &t : _topics)
+  {
+    // Topic remapping.
+    std::string topic = t;
+    this->Options().TopicRemap(t, topic);
+
+    std::string fullyQualifiedTopic;
+    if (!TopicUtils::FullyQualifiedName(this->Options().Partition(),
+      this->Options().NameSpace(), topic, fullyQualifiedTopic))
+    {
+      std::cerr << "Topic [" << topic << "] is not valid." << std::endl;
+      return false;
+    }
+    fullyQualifiedTopics.push_back(std::move(fullyQualifiedTopic));
+  }
+
+  std::lock_guard<std::recursive_mutex> lk(this->Shared()->mutex);
+
+  for (std::size_t i = 0; i < fullyQualifiedTopics.size(); ++i)
+  {
+    this->Shared()->localSubscribers.AddHandler(
+      fullyQualifiedTopics[i], this->NodeUuid(), _handlers[i]);
+    this->dataPtr->topicsSubscribed.insert(fullyQualifiedTopics[i]);
+  }
+  this->Shared()->dataPtr->subscribersVersion.fetch_add(
+    1, std::memory_order_release);
+
+  // The discovery requests of all the topics are sent together.
+  this->Shared()->EnsureNetwork();
+  if (!this->Shared()->dataPtr->msgDiscovery->Discover(fullyQualifiedTopics))
+  {
+    std::cerr << "Node::SubscribeMany(): Error discovering topics. Did you"
+              << " forget to start the discovery service?" << std::endl;
+    return false;
+  }
+
+  this->Shared()->dataPtr->AnnounceSubscribers(this->Shared(),
+    this->NodeUuid(), std::set<std::string>(fullyQualifiedTopics.begin(),
+    fullyQualifiedTopics.end()));
+
+  return true;
+}
@@ -57,6 +57,9 @@ NodeOptions &NodeOptions::operator=(const NodeOptions &_other)
   this->SetNameSpace(_other.NameSpace());
   this->SetPartition(_other.Partition());
   this->dataPtr->topicsRemap = _other.dataPtr->topicsRemap;
+  this->dataPtr->servicesBalancing = _other.dataPtr->servicesBalancing;
+  this->dataPtr->spinMode = _other.dataPtr->spinMode;
+  this->dataPtr->numaNode = _other.dataPtr->numaNode;
   return *this;
 }
 
@@ -136,3 +139,52 @@ bool NodeOptions::TopicRemap(const std::string &_fromTopic,
 
   return topicIt != this->dataPtr->topicsRemap.end();
 }
+
+//////////////////////////////////////////////////
+bool NodeOptions::SetServiceBalancing(const std::string &_service,
+  const ServiceBalancing_t _policy)
+{
+  if (!TopicUtils::IsValidTopic(_service))
+  {
+    std::cerr << "Invalid service name [" << _service << "]" << std::endl;
+    return false;
+  }
+
+  this->dataPtr->servicesBalancing[_service] = _policy;
+  return true;
+}
+
+//////////////////////////////////////////////////
+ServiceBalancing_t NodeOptions::ServiceBalancing(
+  const std::string &_service) const
+{
+  auto it = this->dataPtr->servicesBalancing.find(_service);
+  if (it == this->dataPtr->servicesBalancing.end())
+    return ServiceBalancing_t::FIRST;
+
+  return it->second;
+}
+
+//////////////////////////////////////////////////
+void NodeOptions::SetSpinMode(const bool _spin)
+{
+  this->dataPtr->spinMode = _spin;
+}
+
+//////////////////////////////////////////////////
+bool NodeOptions::SpinMode() const
+{
+  return this->dataPtr->spinMode;
+}
+
+//////////////////////////////////////////////////
+void NodeOptions::SetNumaNode(const int _node)
+{
+  this->dataPtr->numaNode = _node < 0 ? -1 : _node;
+}
+
+//////////////////////////////////////////////////
+int NodeOptions::NumaNode() const
+{
+  return this->dataPtr->numaNode;
+}
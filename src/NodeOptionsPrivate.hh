@@ -23,6 +23,7 @@
 
 #include "gz/transport/config.hh"
 #include "gz/transport/NetUtils.hh"
+#include "gz/transport/ServiceBalancing.hh"
 
 namespace gz
 {
@@ -50,6 +51,16 @@ namespace gz
       /// \brief Table of remappings. The key is the original topic name and
       /// its value is the new topic name to be used instead.
       public: std::map<std::string, std::string> topicsRemap;
+
+      /// \brief Balancing policy of the services. The key is the service
+      /// name passed to Request().
+      public: std::map<std::string, ServiceBalancing_t> servicesBalancing;
+
+      /// \brief True if the application runs the callbacks of the node.
+      public: bool spinMode = false;
+
+      /// \brief NUMA node of the shared memory segments, or -1 for none.
+      public: int numaNode = -1;
     };
     }
   }
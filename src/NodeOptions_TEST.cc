@@ -74,4 +74,31 @@ TEST(NodeOptionsTest, accessors)
   EXPECT_EQ(opts.Partition(), defaultPartition);
   EXPECT_TRUE(opts.SetPartition(aPartition));
   EXPECT_EQ(opts.Partition(), aPartition);
+
+  // Service balancing.
+  EXPECT_EQ(transport::ServiceBalancing_t::FIRST,
+    opts.ServiceBalancing("/srv"));
+  EXPECT_FALSE(opts.SetServiceBalancing("invalid service",
+    transport::ServiceBalancing_t::ROUND_ROBIN));
+  EXPECT_TRUE(opts.SetServiceBalancing("/srv",
+    transport::ServiceBalancing_t::HEDGED));
+  EXPECT_EQ(transport::ServiceBalancing_t::HEDGED,
+    opts.ServiceBalancing("/srv"));
+  EXPECT_EQ(transport::ServiceBalancing_t::FIRST,
+    opts.ServiceBalancing("/other"));
+  EXPECT_FALSE(opts.SpinMode());
+  opts.SetSpinMode(true);
+  EXPECT_TRUE(opts.SpinMode());
+  EXPECT_EQ(-1, opts.NumaNode());
+  opts.SetNumaNode(-3);
+  EXPECT_EQ(-1, opts.NumaNode());
+  opts.SetNumaNode(1);
+  EXPECT_EQ(1, opts.NumaNode());
+
+  // Copy.
+  transport::NodeOptions otherOpts(opts);
+  EXPECT_EQ(transport::ServiceBalancing_t::HEDGED,
+    otherOpts.ServiceBalancing("/srv"));
+  EXPECT_TRUE(otherOpts.SpinMode());
+  EXPECT_EQ(1, otherOpts.NumaNode());
 }
@@ -18,7 +18,10 @@
 #ifndef GZ_TRANSPORT_NODEPRIVATE_HH_
 #define GZ_TRANSPORT_NODEPRIVATE_HH_
 
+#include <memory>
+#include <shared_mutex>  //NOLINT
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "gz/transport/NetUtils.hh"
@@ -26,6 +29,8 @@
 #include "gz/transport/Node.hh"
 #include "gz/transport/NodeShared.hh"
 
+#include "SpinQueue.hh"
+
 namespace gz
 {
   namespace transport
@@ -50,12 +55,6 @@ namespace gz
       /// \sa TopicUtils::FullyQualifiedName
       public: bool SubscribeHelper(const std::string &_fullyQualifiedTopic);
 
-      /// \brief Helper function to remove handlers from the shared publish
-      /// queue. This is called when the node unsubscribes to a topic
-      /// \param[in] _topic Topic that the node unsubcribed to.
-      /// \return True on success.
-      public: bool RemoveHandlersFromPubQueue(const std::string &_topic);
-
       /// \brief The list of topics subscribed by this node.
       public: std::unordered_set<std::string> topicsSubscribed;
 
@@ -80,6 +79,18 @@ namespace gz
 
       /// \brief Statistics publisher.
       public: Node::Publisher statPub;
+
+      /// \brief Fully qualified names of the topics and services used by
+      /// this node, indexed by name before remapping.
+      /// \sa Node::FullyQualifiedName
+      public: std::unordered_map<std::string, std::string> fullyQualifiedNames;
+
+      /// \brief Protects fullyQualifiedNames.
+      public: std::shared_mutex fullyQualifiedNamesMutex;
+
+      /// \brief Callbacks waiting for Node::SpinOnce() or Node::SpinSome(),
+      /// or nullptr if the node isn't in spin mode.
+      public: std::shared_ptr<SpinQueue> spinQueue;
     };
     }
   }
@@ -15,32 +15,63 @@
  *
 */
 #include <gz/msgs/empty.pb.h>
+#include <gz/msgs/uint64_v.pb.h>
 
 #include <zmq.hpp>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
 #include <chrono>
 #include <cstring>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <shared_mutex>  //NOLINT
 #include <string>
 #include <thread>
+#include <tuple>
 #include <vector>
 #include <unordered_map>
 
 #include "gz/transport/AdvertiseOptions.hh"
 #include "gz/transport/Discovery.hh"
 #include "gz/transport/Helpers.hh"
+#include "gz/transport/Metrics.hh"
+#include "gz/transport/NetUtils.hh"
+#include "gz/transport/Node.hh"
 #include "gz/transport/NodeShared.hh"
 #include "gz/transport/RepHandler.hh"
 #include "gz/transport/ReqHandler.hh"
+#include "gz/transport/ServiceContext.hh"
 #include "gz/transport/SubscriptionHandler.hh"
+#include "gz/transport/TopicUtils.hh"
 #include "gz/transport/TransportTypes.hh"
 #include "gz/transport/Uuid.hh"
 
+#include "CallbackProfiler.hh"
 #include "NodeSharedPrivate.hh"
+#include "Probes.hh"
 
 using namespace std::chrono_literals;
 using namespace gz;
@@ -76,6 +107,34 @@ bool userPass(std::string &_user, std::string &_pass)
   return true;
 }
 
+//////////////////////////////////////////////////
+// Helper to get the CURVE key pair shared by the trusted processes, in Z85
+// text form.
+bool curveKeys(std::string &_public, std::string &_secret)
+{
+  const char *publicKey = std::getenv("GZ_TRANSPORT_CURVE_PUBLIC_KEY");
+  const char *secretKey = std::getenv("GZ_TRANSPORT_CURVE_SECRET_KEY");
+
+  // A Z85 encoded key has 40 characters.
+  if (!publicKey || !secretKey ||
+      std::strlen(publicKey) != 40 || std::strlen(secretKey) != 40)
+  {
+    return false;
+  }
+
+  _public = publicKey;
+  _secret = secretKey;
+  return true;
+}
+
+//////////////////////////////////////////////////
+// Whether the sockets authenticate their peers.
+bool secured()
+{
+  std::string a, b;
+  return curveKeys(a, b) || userPass(a, b);
+}
+
 //////////////////////////////////////////////////
 // Helper to send messages
 #ifdef GZ_ZMQ_POST_4_3_1
@@ -224,6 +283,26 @@ NodeShared::NodeShared()
   this->srvDiscPort = this->dataPtr->NonNegativeEnvVar(
     "GZ_DISCOVERY_SRV_PORT", this->kDefaultSrvDiscPort);
 
+  // Optionally give each partition its own discovery channel, so the
+  // kernel drops the discovery traffic of the other partitions. The values
+  // set explicitly are kept.
+  if (this->dataPtr->NonNegativeEnvVar("GZ_DISCOVERY_PARTITION_CHANNEL", 0) > 0)
+  {
+    std::string ip;
+    int msgPort;
+    int srvPort;
+    partitionDiscoveryChannel(NodeOptions().Partition(), ip, msgPort,
+      srvPort);
+
+    std::string value;
+    if (!env("GZ_DISCOVERY_MULTICAST_IP", value) || value.empty())
+      this->discoveryIP = ip;
+    if (!env("GZ_DISCOVERY_MSG_PORT", value))
+      this->msgDiscPort = msgPort;
+    if (!env("GZ_DISCOVERY_SRV_PORT", value))
+      this->srvDiscPort = srvPort;
+  }
+
   // Sanity check: the discovery ports should be unique.
   if (this->msgDiscPort == this->srvDiscPort)
   {
@@ -244,39 +323,114 @@ NodeShared::NodeShared()
     this->dataPtr->topicStatsEnabled = (gzStats == "1");
   }
 
+  // The publications carry their metadata for the statistics, or for the
+  // message information of the subscribers.
+  this->dataPtr->metadataEnabled = this->dataPtr->topicStatsEnabled ||
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_MESSAGE_METADATA", 0) > 0;
+
+  // Optionally carry the trace of the publications, see GZ_TRANSPORT_TRACE.
+  this->dataPtr->traceEnabled = Tracer::Instance().Enabled();
+
+  // Optionally replace the topic, address and type frames of the remote
+  // publications with a numeric topic ID.
+  this->dataPtr->compactHeader =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_COMPACT_HEADER", 0) > 0;
+
+  // Optionally terminate the topic frame, so the subscriptions don't match
+  // the topics sharing their prefix.
+  this->dataPtr->exactTopics =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_EXACT_TOPICS", 0) > 0;
+
+  // Optionally keep sending the service requests with one frame per field,
+  // even to the responders that accept a single frame.
+  this->dataPtr->srvEnvelope =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SERVICE_ENVELOPE", 1) > 0;
+
+  // Optionally split the large remote publications in fragments, so they
+  // don't hold back the other topics. The fragments received are always
+  // reassembled.
+  this->dataPtr->fragmentSize = static_cast<std::size_t>(
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_FRAGMENT_SIZE", 0));
+  this->dataPtr->fragmentRate = this->dataPtr->NonNegativeEnvVar(
+    "GZ_TRANSPORT_FRAGMENT_RATE", this->dataPtr->fragmentRate);
+  const int reassemblyBudget = this->dataPtr->NonNegativeEnvVar(
+    "GZ_TRANSPORT_REASSEMBLY_BUDGET", 256);
+  this->dataPtr->reassembler = std::make_unique<FragmentReassembler>(
+    static_cast<std::size_t>(reassemblyBudget) * 1024u * 1024u);
+
+  // Optionally run the discovery, the reception and the local deliveries
+  // on a single thread, to reduce the footprint of small processes.
+  this->dataPtr->singleThread =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SINGLE_THREAD", 0) > 0;
+
+  // Optional multicast group and rate of the multicast topics.
+  std::string multicastGroup;
+  if (env("GZ_TRANSPORT_MULTICAST_GROUP", multicastGroup) &&
+      !multicastGroup.empty())
+  {
+    this->dataPtr->multicastGroup = multicastGroup;
+  }
+  this->dataPtr->multicastRate = this->dataPtr->NonNegativeEnvVar(
+    "GZ_TRANSPORT_MULTICAST_RATE", this->dataPtr->multicastRate);
+
   // My process UUID.
   Uuid uuid;
   this->pUuid = uuid.ToString();
 
-  // Initialize my discovery services.
-  this->dataPtr->msgDiscovery.reset(
-      new MsgDiscovery(this->pUuid, this->discoveryIP, this->msgDiscPort));
-  this->dataPtr->srvDiscovery.reset(
-      new SrvDiscovery(this->pUuid, this->discoveryIP, this->srvDiscPort));
+  // Optionally wait for the first operation involving other processes
+  // before creating the sockets and the threads, see EnsureNetwork(). In
+  // single thread mode, the reception thread is needed by the local
+  // publications too.
+  this->dataPtr->lazyInit = !this->dataPtr->singleThread &&
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_LAZY_INIT", 0) > 0;
 
-  // Initialize the 0MQ objects.
-  if (!this->InitializeSockets())
-    return;
+  // Optionally report the traffic of the topics to gz topic --top. The
+  // report needs its own thread, so single thread processes don't.
+  this->dataPtr->topicReportEnabled = !this->dataPtr->singleThread &&
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_TOPIC_REPORT", 0) > 0;
 
-  if (this->verbose)
+  // Initialize my discovery services.
+  const bool openDiscovery = !this->dataPtr->lazyInit;
+  this->dataPtr->msgDiscovery.reset(new MsgDiscovery(this->pUuid,
+    this->discoveryIP, this->msgDiscPort, false, openDiscovery));
+  this->dataPtr->srvDiscovery.reset(new SrvDiscovery(this->pUuid,
+    this->discoveryIP, this->srvDiscPort, false, openDiscovery));
+
+  // Optionally replace the periodic re-advertisements with versioned
+  // heartbeats.
+  const bool deltaDiscovery =
+    this->dataPtr->NonNegativeEnvVar("GZ_DISCOVERY_DELTA", 0) > 0;
+  this->dataPtr->msgDiscovery->SetDeltaMode(deltaDiscovery);
+  this->dataPtr->srvDiscovery->SetDeltaMode(deltaDiscovery);
+
+  // Optionally back off the heartbeats while the graph is stable.
+  const bool adaptiveDiscovery =
+    this->dataPtr->NonNegativeEnvVar("GZ_DISCOVERY_ADAPTIVE", 0) > 0;
+  this->dataPtr->msgDiscovery->SetAdaptive(adaptiveDiscovery);
+  this->dataPtr->srvDiscovery->SetAdaptive(adaptiveDiscovery);
+
+  // Optionally shorten the startup with bursts of discovery requests.
+  const bool fastStart =
+    this->dataPtr->NonNegativeEnvVar("GZ_DISCOVERY_FAST_START", 0) > 0;
+  this->dataPtr->msgDiscovery->SetFastStart(fastStart);
+  this->dataPtr->srvDiscovery->SetFastStart(fastStart);
+
+  // Optionally pack the bulk discovery messages in fewer datagrams.
+  const bool batchDiscovery =
+    this->dataPtr->NonNegativeEnvVar("GZ_DISCOVERY_BATCH", 0) > 0;
+  this->dataPtr->msgDiscovery->SetBatching(batchDiscovery);
+  this->dataPtr->srvDiscovery->SetBatching(batchDiscovery);
+
+  // Optionally remember the remote publishers across restarts.
+  std::string cacheDir;
+  if (env("GZ_DISCOVERY_CACHE", cacheDir) && !cacheDir.empty())
   {
-    std::cout << "Current host address: " << this->hostAddr << std::endl;
-    std::cout << "Process UUID: " << this->pUuid << std::endl;
-    std::cout << "Bind at: [udp://" << this->discoveryIP << ":"
-              << this->msgDiscPort << "] for msg discovery\n";
-    std::cout << "Bind at: [udp://" << this->discoveryIP << ":"
-              << this->srvDiscPort << "] for srv discovery\n";
-    std::cout << "Bind at: [" << this->myAddress << "] for pub/sub\n";
-    std::cout << "Bind at: [" << this->myReplierAddress << "] for srv. calls\n";
-    std::cout << "Identity for receiving srv. requests: ["
-              << this->replierId.ToString() << "]" << std::endl;
-    std::cout << "Identity for receiving srv. responses: ["
-              << this->responseReceiverId.ToString() << "]" << std::endl;
+    this->dataPtr->msgDiscovery->SetCacheFile(cacheDir + "/gz_discovery_" +
+      std::to_string(this->msgDiscPort) + ".cache");
+    this->dataPtr->srvDiscovery->SetCacheFile(cacheDir + "/gz_discovery_" +
+      std::to_string(this->srvDiscPort) + ".cache");
   }
 
-  // Start the service thread.
-  this->threadReception = std::thread(&NodeShared::RunReceptionTask, this);
-
   // Set the callback to notify discovery updates (new topics).
   this->dataPtr->msgDiscovery->ConnectionsCb(
       std::bind(&NodeShared::OnNewConnection, this, std::placeholders::_1));
@@ -303,13 +457,146 @@ NodeShared::NodeShared()
       std::bind(&NodeShared::OnNewSrvDisconnection,
         this, std::placeholders::_1));
 
+  // Optionally run the local callbacks on a thread pool.
+  const int dispatchThreads = this->dataPtr->NonNegativeEnvVar(
+    "GZ_TRANSPORT_DISPATCH_THREADS", 0);
+  if (dispatchThreads > 0)
+  {
+    std::string dispatchOrder;
+    if (env("GZ_TRANSPORT_DISPATCH_ORDER", dispatchOrder) &&
+        !dispatchOrder.empty())
+    {
+      if (dispatchOrder == "handler")
+      {
+        this->dataPtr->dispatchOrder =
+          NodeSharedPrivate::DispatchOrder::HANDLER;
+      }
+      else if (dispatchOrder != "topic")
+      {
+        std::cerr << "Unknown GZ_TRANSPORT_DISPATCH_ORDER value ["
+                  << dispatchOrder << "]. Using [topic] instead."
+                  << std::endl;
+      }
+    }
+
+    this->dataPtr->dispatcher.reset(new DispatchExecutor(
+      static_cast<unsigned int>(dispatchThreads),
+      []() { setupThread("PUBLISH", "gz-dispatch"); }));
+  }
+
+  // Workers shared by the services advertised with a concurrency.
+  this->dataPtr->serviceThreads = static_cast<unsigned int>(std::max(1,
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SERVICE_THREADS",
+      NodeSharedPrivate::kDefaultServiceThreads)));
+
+  // Optionally exchange messages with processes on the same host through
+  // shared memory.
+  this->dataPtr->shmEnabled =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SHM", 0) > 0;
+  if (this->dataPtr->shmEnabled && this->dataPtr->metadataEnabled)
+  {
+    std::cerr << "GZ_TRANSPORT_SHM is not compatible with topic statistics "
+              << "and GZ_TRANSPORT_MESSAGE_METADATA. "
+              << "Disabling the shared memory transport." << std::endl;
+    this->dataPtr->shmEnabled = false;
+  }
+  // The blackboards use the slot size too.
+  this->dataPtr->shmSlotSize = static_cast<std::size_t>(std::max(1,
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SHM_SLOT_SIZE",
+      NodeSharedPrivate::kDefaultShmSlotSize)));
+  this->dataPtr->shmNumaNode =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SHM_NUMA_NODE", -1);
+  this->dataPtr->shmHugePages =
+    this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SHM_HUGE_PAGES", 0) > 0;
+  if (this->dataPtr->shmEnabled)
+  {
+    this->dataPtr->shmSlots = static_cast<std::size_t>(std::max(1,
+      this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_SHM_SLOTS",
+        NodeSharedPrivate::kDefaultShmSlots)));
+    this->dataPtr->shmDoorbell = ShmDoorbell::Create(this->pUuid);
+    this->dataPtr->shmThread = std::thread(
+      &NodeSharedPrivate::RunShmReceptionTask, this->dataPtr.get(), this);
+  }
+
+  // Create the local publish thread, unless the reception thread delivers
+  // the local publications.
+  if (!this->dataPtr->singleThread)
+  {
+    this->dataPtr->pubLane->thread = std::thread(
+      &NodeSharedPrivate::PublishThread, this->dataPtr.get(),
+      this->dataPtr->pubLane.get());
+  }
+
+  if (!this->dataPtr->lazyInit)
+    this->EnsureNetwork();
+
+  this->dataPtr->StartMetrics();
+
+  // Optionally profile the callbacks, see GZ_TRANSPORT_CALLBACK_PROFILE.
+  // The profiles are published by a node, which waits for this constructor.
+  if (CallbackProfiler::Instance().Enabled())
+    this->EnableCallbackProfile(true);
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::EnsureNetwork()
+{
+  std::call_once(this->dataPtr->networkFlag, [this]
+  {
+    this->dataPtr->networkReady = this->StartNetwork();
+  });
+  return this->dataPtr->networkReady;
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::StartNetwork()
+{
+  // The discovery sockets give the host address.
+  this->dataPtr->msgDiscovery->Open();
+  this->dataPtr->srvDiscovery->Open();
+
+  // Initialize the 0MQ objects.
+  if (!this->InitializeSockets())
+    return false;
+
+  if (this->verbose)
+  {
+    std::cout << "Current host address: " << this->hostAddr << std::endl;
+    std::cout << "Process UUID: " << this->pUuid << std::endl;
+    std::cout << "Bind at: [udp://" << this->discoveryIP << ":"
+              << this->msgDiscPort << "] for msg discovery\n";
+    std::cout << "Bind at: [udp://" << this->discoveryIP << ":"
+              << this->srvDiscPort << "] for srv discovery\n";
+    std::cout << "Bind at: [" << this->myAddress << "] for pub/sub\n";
+    std::cout << "Bind at: [" << this->myReplierAddress << "] for srv. calls\n";
+    std::cout << "Identity for receiving srv. requests: ["
+              << this->replierId.ToString() << "]" << std::endl;
+    std::cout << "Identity for receiving srv. responses: ["
+              << this->responseReceiverId.ToString() << "]" << std::endl;
+  }
+
+  // Start the service thread. In single thread mode it also runs the
+  // discovery, so it starts once the discovery is ready.
+  if (!this->dataPtr->singleThread)
+    this->threadReception = std::thread(&NodeShared::RunReceptionTask, this);
+
+  // Start the reception threads of the additional subscriber shards.
+  for (auto &shard : this->dataPtr->subscriberShards)
+  {
+    shard->thread = std::thread(&NodeSharedPrivate::RunShardReceptionTask,
+        this->dataPtr.get(), this, shard.get());
+  }
+
   // Start the discovery services.
-  this->dataPtr->msgDiscovery->Start();
-  this->dataPtr->srvDiscovery->Start();
+  this->dataPtr->msgDiscovery->Start(!this->dataPtr->singleThread);
+  this->dataPtr->srvDiscovery->Start(!this->dataPtr->singleThread);
+  if (this->dataPtr->singleThread)
+  {
+    this->threadReception = std::thread(&NodeShared::RunReceptionTask, this);
+    this->dataPtr->receptionThreadId = this->threadReception.get_id();
+  }
 
-  // Create the local publish thread.
-  this->dataPtr->pubThread = std::thread(&NodeSharedPrivate::PublishThread,
-      this->dataPtr.get());
+  return true;
 }
 
 //////////////////////////////////////////////////
@@ -318,41 +605,254 @@ NodeShared::~NodeShared()
   // Tell the service thread to terminate.
   this->dataPtr->exit = true;
 
-  // Notify the local pubthread and join.
-  this->dataPtr->signalNewPub.notify_all();
-  this->dataPtr->pubThread.join();
+  // Release the publishers waiting for memory.
+  this->dataPtr->memoryBudget.Interrupt();
+
+  // The gauges read the publication queue.
+  this->dataPtr->StopMetrics();
+
+  // Stop the statistics thread.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->statsThreadMutex);
+    this->dataPtr->statsCondition.notify_all();
+  }
+  if (this->dataPtr->statsThread.joinable())
+    this->dataPtr->statsThread.join();
+  if (this->dataPtr->profileThread.joinable())
+    this->dataPtr->profileThread.join();
+  if (this->dataPtr->reportThread.joinable())
+    this->dataPtr->reportThread.join();
+
+  // Stop the batch thread, it sends the pending batches first.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->batchMutex);
+    this->dataPtr->batchCondition.notify_all();
+  }
+  if (this->dataPtr->batchThread.joinable())
+    this->dataPtr->batchThread.join();
+
+  // Stop the real-time thread.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->realTimeMutex);
+    this->dataPtr->realTimeCondition.notify_all();
+  }
+  if (this->dataPtr->realTimeThread.joinable())
+    this->dataPtr->realTimeThread.join();
+
+  // Stop the latch thread.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->latchedMutex);
+    this->dataPtr->latchedCondition.notify_all();
+  }
+  if (this->dataPtr->latchedThread.joinable())
+    this->dataPtr->latchedThread.join();
+
+  // Stop the reliability thread.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->reliableMutex);
+    this->dataPtr->reliableCondition.notify_all();
+  }
+  if (this->dataPtr->reliableThread.joinable())
+    this->dataPtr->reliableThread.join();
+
+  // Stop the fragment thread. The pending fragments are not sent.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->fragmentMutex);
+    this->dataPtr->fragmentCondition.notify_all();
+  }
+  if (this->dataPtr->fragmentThread.joinable())
+    this->dataPtr->fragmentThread.join();
+
+  // Notify the local pubthread and join. In single thread mode it is the
+  // reception thread.
+  this->dataPtr->pubLane->queue.Wake();
+  if (this->dataPtr->pubLane->thread.joinable())
+    this->dataPtr->pubLane->thread.join();
+  if (this->dataPtr->singleThread && this->threadReception.joinable())
+  {
+    this->dataPtr->WakeReception();
+    this->threadReception.join();
+  }
+
+  // Same for the high priority lane, if any.
+  NodeSharedPrivate::PublicationLane *priorityLane = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->priorityMutex);
+    priorityLane = this->dataPtr->priorityLane.get();
+  }
+  if (priorityLane)
+  {
+    priorityLane->queue.Wake();
+    if (priorityLane->thread.joinable())
+      priorityLane->thread.join();
+  }
+
+  // Stop the local callback workers.
+  this->dataPtr->dispatcher.reset();
+
+  // Stop the service workers. Their pending responses are not sent.
+  {
+    std::unique_ptr<DispatchExecutor> serviceExecutor;
+    {
+      std::lock_guard<std::mutex> lk(this->dataPtr->serviceMutex);
+      serviceExecutor = std::move(this->dataPtr->serviceExecutor);
+    }
+    serviceExecutor.reset();
+  }
 
   // Wait for the service thread before exit.
   if (this->threadReception.joinable())
+  {
+    this->dataPtr->WakeReception();
     this->threadReception.join();
+  }
+
+  for (auto &shard : this->dataPtr->subscriberShards)
+  {
+    if (shard->thread.joinable())
+    {
+      NodeSharedPrivate::WakeShard(*shard);
+      shard->thread.join();
+    }
+  }
+
+  SubscriberShard *priorityShard = nullptr;
+  {
+    std::lock_guard<std::recursive_mutex> lk(this->mutex);
+    priorityShard = this->dataPtr->priorityShard.get();
+  }
+  if (priorityShard && priorityShard->thread.joinable())
+  {
+    NodeSharedPrivate::WakeShard(*priorityShard);
+    priorityShard->thread.join();
+  }
+
+  // Stop reading the shared memory segments of other processes. Our own
+  // segments are removed with dataPtr.
+  if (this->dataPtr->shmThread.joinable())
+  {
+    if (this->dataPtr->shmDoorbell)
+      this->dataPtr->shmDoorbell->Ring();
+    this->dataPtr->shmThread.join();
+  }
+  this->dataPtr->DetachShmReaders("", "", this->pUuid);
+
+  // Stop receiving file descriptors.
+  std::thread fdThread;
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->fdMutex);
+    fdThread = std::move(this->dataPtr->fdThread);
+  }
+  if (fdThread.joinable())
+  {
+    this->dataPtr->WakeFdThread();
+    fdThread.join();
+  }
+  this->dataPtr->DetachFdReaders("", "");
+  this->dataPtr->CloseFdWake();
+
+  // No more queued messages can be posted.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->queueMutex);
+    this->dataPtr->queueExecutor.reset();
+  }
 
   // Wait for the authentication thread before exit.
   if (this->dataPtr->accessControlThread.joinable())
+  {
+    NodeSharedPrivate::Wake(*this->dataPtr->accessControlWakeSender);
     this->dataPtr->accessControlThread.join();
+  }
 }
 
 //////////////////////////////////////////////////
 void NodeShared::RunReceptionTask()
 {
-  while (!this->dataPtr->exit)
+  setupThread("RECEPTION", "gz-reception");
+
+  NodeSharedPrivate *d = this->dataPtr.get();
+  const bool single = d->singleThread;
+  using PollFd = decltype(zmq::pollitem_t::fd);
+  const PollFd msgDiscFd =
+    single ? static_cast<PollFd>(d->msgDiscovery->Socket()) : PollFd();
+  const PollFd srvDiscFd =
+    single ? static_cast<PollFd>(d->srvDiscovery->Socket()) : PollFd();
+  bool pendingPublications = false;
+  while (!d->exit)
   {
-    // Poll socket for a reply, with timeout.
+    // Poll socket for a reply. There is no timeout, the destructor wakes us
+    // up. In single thread mode the discovery sockets are polled too.
     zmq::pollitem_t items[] =
     {
-      {static_cast<void*>(*this->dataPtr->subscriber), 0, ZMQ_POLLIN, 0},
-      {static_cast<void*>(*this->dataPtr->replier), 0, ZMQ_POLLIN, 0},
-      {static_cast<void*>(*this->dataPtr->responseReceiver), 0, ZMQ_POLLIN, 0}
+      {static_cast<void*>(*d->subscriber), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*d->replier), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*d->responseReceiver), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*d->receptionWakeReceiver), 0, ZMQ_POLLIN, 0},
+      {nullptr, msgDiscFd, ZMQ_POLLIN, 0},
+      {nullptr, srvDiscFd, ZMQ_POLLIN, 0}
     };
+    const std::size_t numItems = single ? 6u : 4u;
+
+    // Without hedged requests there's no timeout: the destructor and the
+    // service workers wake us up.
+    int64_t timeout;
+    {
+      std::lock_guard<std::recursive_mutex> lk(this->mutex);
+      timeout = d->NextHedgeTimeout();
+    }
+
+    int64_t pollTimeout = timeout;
+    if (single)
+    {
+      for (const int t : {d->msgDiscovery->Timeout(),
+                          d->srvDiscovery->Timeout()})
+      {
+        if (pollTimeout < 0 || t < pollTimeout)
+          pollTimeout = t;
+      }
+
+      // Don't wait while local publications are left.
+      if (pendingPublications)
+        pollTimeout = 0;
+    }
+
     try
     {
-      zmq::poll(&items[0], sizeof(items) / sizeof(items[0]),
-          std::chrono::milliseconds(NodeSharedPrivate::Timeout));
+      zmq::poll(&items[0], numItems, std::chrono::milliseconds(pollTimeout));
     }
     catch(...)
     {
       continue;
     }
 
+    // The publications wait from now on for this thread.
+    if (items[0].revents & ZMQ_POLLIN)
+      d->receptionWake = std::chrono::steady_clock::now();
+
+    if (single)
+    {
+      d->msgDiscovery->Process((items[4].revents & ZMQ_POLLIN) != 0);
+      d->srvDiscovery->Process((items[5].revents & ZMQ_POLLIN) != 0);
+
+      // Deliver a bounded number of local publications, so the remote
+      // ones are not delayed by a burst.
+      std::unique_ptr<NodeSharedPrivate::PublishMsgDetails> details;
+      int count = 0;
+      while (count < NodeSharedPrivate::kSingleThreadBatch &&
+             d->pubLane->queue.TryPop(details))
+      {
+        d->ProcessPublication(*d->pubLane, details);
+        ++count;
+      }
+      pendingPublications = !d->pubLane->queue.Empty();
+    }
+
+    if (items[3].revents & ZMQ_POLLIN)
+    {
+      NodeSharedPrivate::DrainWake(*this->dataPtr->receptionWakeReceiver);
+      this->SendPendingSrvReplies();
+    }
+
     //  If we got a reply, process it.
     if (items[0].revents & ZMQ_POLLIN)
       this->RecvMsgUpdate();
@@ -360,6 +860,9 @@ void NodeShared::RunReceptionTask()
       this->RecvSrvRequest();
     if (items[2].revents & ZMQ_POLLIN)
       this->RecvSrvResponse();
+
+    if (timeout >= 0)
+      this->SendHedgedReqs();
   }
 }
 
@@ -370,1548 +873,7346 @@ bool NodeShared::Publish(
     const size_t _dataSize, DeallocFunc *_ffn,
     const std::string &_msgType)
 {
-  try
-  {
-    // Create the messages.
-    // Note that we use zero copy for passing the message data (msg2).
-    zmq::message_t msg0(_topic.data(), _topic.size()),
-                   msg1(this->myAddress.data(), this->myAddress.size()),
-                   msg2(_data, _dataSize, _ffn, nullptr),
-                   msg3(_msgType.data(), _msgType.size());
+  return this->Publish(_topic, _data, _dataSize, _ffn, nullptr, _msgType);
+}
 
-    // Send the messages
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+//////////////////////////////////////////////////
+bool NodeShared::Publish(
+    const std::string &_topic,
+    char *_data,
+    const size_t _dataSize, DeallocFunc *_ffn,
+    void *_hint,
+    const std::string &_msgType)
+{
+  GZ_TRANSPORT_PROBE2(send, _topic.c_str(), _dataSize);
 
-#ifdef GZ_ZMQ_POST_4_3_1
-    this->dataPtr->publisher->send(msg0, zmq::send_flags::sndmore);
-    this->dataPtr->publisher->send(msg1, zmq::send_flags::sndmore);
-    this->dataPtr->publisher->send(msg2, zmq::send_flags::sndmore);
-#else
-    this->dataPtr->publisher->send(msg0, ZMQ_SNDMORE);
-    this->dataPtr->publisher->send(msg1, ZMQ_SNDMORE);
-    this->dataPtr->publisher->send(msg2, ZMQ_SNDMORE);
-#endif
-
-    if (this->dataPtr->topicStatsEnabled)
-    {
-      // Create publication metadata.
-      PublicationMetadata meta;
-      // Send the sequence number, which can be used to detect dropped
-      // messages.
-      meta.seq = this->dataPtr->topicPubSeq[_topic]++;
-      // Send the publication time.
-      meta.stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-          std::chrono::steady_clock::now().time_since_epoch()).count();
-      zmq::message_t msg4(&meta, sizeof(meta));
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->publisher->send(msg3, zmq::send_flags::sndmore);
-      this->dataPtr->publisher->send(msg4, zmq::send_flags::none);
-#else
-      this->dataPtr->publisher->send(msg3, ZMQ_SNDMORE);
-      this->dataPtr->publisher->send(msg4, 0);
-#endif
-    }
-    else
-    {
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->publisher->send(msg3, zmq::send_flags::none);
-#else
-      this->dataPtr->publisher->send(msg3, 0);
-#endif
-    }
+  // Reliable topics number their publications and keep them.
+  if (this->dataPtr->ReliablePublish(this, _topic, _data, _dataSize))
+  {
+    _ffn(_data, _hint);
+    return true;
   }
-  catch(const zmq::error_t& ze)
+
+  // Batched topics coalesce several messages in a single publication.
+  if (this->dataPtr->BatchPublish(this, _topic, _data, _dataSize))
   {
-     std::cerr << "NodeShared::Publish() Error: " << ze.what() << std::endl;
-     return false;
+    _ffn(_data, _hint);
+    return true;
   }
 
-  return true;
+  // Same-host subscribers may read the message from shared memory.
+  if (this->dataPtr->shmEnabled &&
+      this->dataPtr->ShmPublish(this, _topic, _data, _dataSize))
+  {
+    _ffn(_data, _hint);
+    return true;
+  }
+
+  // Note that we use zero copy for passing the message data.
+  zmq::message_t data(_data, _dataSize, _ffn, _hint);
+  return this->dataPtr->SendPublication(this, _topic, _msgType, data);
 }
 
 //////////////////////////////////////////////////
 void NodeShared::RecvMsgUpdate()
 {
-  zmq::message_t msg(0);
   std::string topic;
   std::string sender;
   std::string data;
   std::string msgType;
-  HandlerInfo handlerInfo;
+  PublicationMetadata meta;
+  TraceMetadata trace;
 
   {
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    // Only the socket is locked while receiving. The global mutex is not
+    // needed in the reception path.
+    std::lock_guard<std::mutex> lock(this->dataPtr->subscriberMutex);
 
-    try
+    if (!this->dataPtr->RecvMsgFrames(*this->dataPtr->subscriber, topic,
+          sender, data, msgType, meta, trace))
     {
+      return;
+    }
+  }
+
+  // Wait for the last fragment of a large publication.
+  if (!this->dataPtr->reassembler->Add(sender, msgType, data))
+    return;
+
+  GZ_TRANSPORT_PROBE3(receive, topic.c_str(), sender.c_str(), data.size());
+
+  if (this->dataPtr->topicStatsEnabled)
+  {
+    this->dataPtr->UpdateTopicStats(topic, sender, meta,
+      this->dataPtr->receptionWake);
+  }
+
+  NodeSharedPrivate::TraceReception(topic, trace);
+  Tracer::Scope traceScope(trace);
+  this->dataPtr->DispatchRemoteMsg(this, topic, msgType, data, sender, meta);
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::RecvMsgFrames(zmq::socket_t &_socket,
+    std::string &_topic, std::string &_sender, std::string &_data,
+    std::string &_msgType, PublicationMetadata &_meta, TraceMetadata &_trace)
+{
+  zmq::message_t msg(0);
+
+  try
+  {
 #ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
+    if (!_socket.recv(msg))
 #else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
+    if (!_socket.recv(&msg, 0))
 #endif
-        return;
-      topic = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+      return false;
+
+    // Compact header: the topic ID identifies the topic, type and sender.
+    if (this->compactHeader)
+    {
+      if (msg.size() < kCompactHeaderSize)
+        return false;
+
+      const auto *header = static_cast<const unsigned char *>(msg.data());
+      uint64_t id = 0;
+      for (std::size_t i = 0; i < sizeof(id); ++i)
+        id |= static_cast<uint64_t>(header[i]) << (8 * i);
+      memcpy(&_meta, header + sizeof(id), sizeof(_meta));
+      if (this->traceEnabled &&
+          msg.size() >= kCompactHeaderSize + sizeof(_trace))
+      {
+        memcpy(&_trace, header + kCompactHeaderSize, sizeof(_trace));
+      }
 
-      // TODO(caguero): Use this as extra metadata for the subscriber.
 #ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
+      if (!_socket.recv(msg))
 #else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
+      if (!_socket.recv(&msg, 0))
 #endif
-        return;
-      sender = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+        return false;
+      _data.assign(static_cast<const char *>(msg.data()), msg.size());
+
+      std::shared_lock<std::shared_mutex> lk(this->compactTopicsMutex);
+      auto it = this->compactTopics.find(id);
+      if (it == this->compactTopics.end())
+        return false;
+      _topic = it->second.topic;
+      _msgType = it->second.msgType;
+      _sender = it->second.sender;
+      return true;
+    }
+
+    std::size_t topicSize = msg.size();
+    if (this->exactTopics && topicSize > 0 &&
+        static_cast<const char *>(msg.data())[topicSize - 1] == '\0')
+    {
+      --topicSize;
+    }
+    _topic = std::string(reinterpret_cast<char *>(msg.data()), topicSize);
 
+    // TODO(caguero): Use this as extra metadata for the subscriber.
 #ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
+    if (!_socket.recv(msg))
 #else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
+    if (!_socket.recv(&msg, 0))
 #endif
-        return;
-      data = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+      return false;
+    _sender = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
 
 #ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->subscriber->recv(msg))
+    if (!_socket.recv(msg))
 #else
-      if (!this->dataPtr->subscriber->recv(&msg, 0))
+    if (!_socket.recv(&msg, 0))
 #endif
-        return;
-      msgType = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+      return false;
+    _data = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
 
-      if (this->dataPtr->topicStatsEnabled)
-      {
 #ifdef GZ_ZMQ_POST_4_3_1
-        if (!this->dataPtr->subscriber->recv(msg))
+    if (!_socket.recv(msg))
 #else
-        if (!this->dataPtr->subscriber->recv(&msg, 0))
+    if (!_socket.recv(&msg, 0))
 #endif
-          return;
-        PublicationMetadata *meta =
-          reinterpret_cast<PublicationMetadata *>(msg.data());
-
-        // Update topic statistics.
-        if (this->dataPtr->enabledTopicStatistics.find(topic) !=
-            this->dataPtr->enabledTopicStatistics.end())
-        {
-          this->dataPtr->topicStats[topic].Update(sender,
-              meta->stamp, meta->seq);
-          this->dataPtr->enabledTopicStatistics[topic](
-              this->dataPtr->topicStats[topic]);
-        }
-      }
-    }
-    catch(const zmq::error_t &_error)
+      return false;
+    _msgType = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+
+    // The metadata frame depends on the settings of the publisher, not on
+    // ours, so it is only read when the publisher sent it. Any other frame
+    // is drained, so it isn't taken for the topic of the next message.
+    bool metaFrame = true;
+    while (msg.more())
     {
-      std::cerr << "Error: " << _error.what() << std::endl;
-      return;
-    }
-
-    handlerInfo = this->CheckHandlerInfo(topic);
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!_socket.recv(msg))
+#else
+      if (!_socket.recv(&msg, 0))
+#endif
+        return false;
+      if (!metaFrame)
+        continue;
+      metaFrame = false;
+      if (msg.size() >= sizeof(_meta))
+        memcpy(&_meta, msg.data(), sizeof(_meta));
+      if (this->traceEnabled && msg.size() >= sizeof(_meta) + sizeof(_trace))
+      {
+        memcpy(&_trace, static_cast<const char *>(msg.data()) + sizeof(_meta),
+          sizeof(_trace));
+      }
+    }
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Error: " << _error.what() << std::endl;
+    return false;
   }
 
-  MessageInfo info;
-  info.SetTopicAndPartition(topic);
-  info.SetType(msgType);
-  this->TriggerCallbacks(info, data, handlerInfo);
+  return true;
 }
 
 //////////////////////////////////////////////////
-NodeShared::HandlerInfo NodeShared::CheckHandlerInfo(
-    const std::string &_topic) const
+void NodeSharedPrivate::TraceReception(const std::string &_topic,
+    const TraceMetadata &_trace)
 {
-  HandlerInfo info;
+  Tracer &tracer = Tracer::Instance();
+  if (_trace.traceId == 0 || !tracer.Enabled())
+    return;
 
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
+  // From the ZeroMQ send of the publisher, including the network.
+  const uint64_t now = Tracer::Now();
+  tracer.Span("transit", _topic, _trace.traceId, _trace.sendStamp, now);
+  tracer.Flow(false, _trace.traceId, now);
+}
 
-  info.haveLocal = this->localSubscribers.normal.Handlers(
-        _topic, info.localHandlers);
+//////////////////////////////////////////////////
+void NodeSharedPrivate::UpdateTopicStats(const std::string &_topic,
+    const std::string &_sender, const PublicationMetadata &_meta,
+    const std::chrono::steady_clock::time_point &_arrived)
+{
+  // The publisher doesn't send its metadata.
+  if (_meta.stamp == 0)
+    return;
 
-  info.haveRaw = this->localSubscribers.raw.Handlers(
-        _topic, info.rawHandlers);
+  // The accumulators are never removed, so the pointer remains valid.
+  StatsAccumulator *acc = nullptr;
+  {
+    std::shared_lock<std::shared_mutex> lk(this->statsMutex);
+    auto it = this->topicStats.find(_topic);
+    if (it == this->topicStats.end() || !it->second->enabled)
+      return;
+    acc = it->second.get();
+  }
 
-  return info;
+  StatsSample sample;
+  sample.sender = _sender;
+  sample.meta = _meta;
+  sample.arrived = _arrived;
+  sample.received = std::chrono::steady_clock::now();
+  while (!acc->samples.TryPush(sample))
+  {
+    // The statistics thread is behind, aggregate the samples here.
+    std::lock_guard<std::mutex> lk(acc->mutex);
+    DrainStats(*acc);
+  }
 }
 
 //////////////////////////////////////////////////
-NodeShared::SubscriberInfo NodeShared::CheckSubscriberInfo(
-    const std::string &_topic,
-    const std::string &_msgType) const
+void NodeSharedPrivate::DrainStats(StatsAccumulator &_acc)
 {
-  SubscriberInfo info;
-
-  std::lock_guard<std::recursive_mutex> lk(this->mutex);
-
-  info.haveLocal = this->localSubscribers.normal.Handlers(
-        _topic, info.localHandlers);
+  // The publication stamps come from the system clock of the publishers.
+  // They are moved to our steady clock, correcting the offset of the clocks
+  // of the other hosts estimated by the discovery.
+  const int64_t wallToSteady =
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch() -
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  std::unordered_map<std::string, int64_t> offsets;
+  auto clockOffset = [&](const std::string &_sender) -> int64_t
+  {
+    auto it = offsets.find(_sender);
+    if (it != offsets.end())
+      return it->second;
 
-  info.haveRaw = this->localSubscribers.raw.Handlers(
-        _topic, info.rawHandlers);
+    std::chrono::microseconds offset{0};
+    {
+      std::lock_guard<std::mutex> lk(this->senderProcessesMutex);
+      auto proc = this->senderProcesses.find(_sender);
+      if (proc != this->senderProcesses.end())
+        this->msgDiscovery->ClockOffset(proc->second, offset);
+    }
+    return offsets[_sender] = offset.count();
+  };
 
-  info.haveRemote = this->remoteSubscribers.HasTopic(
-        _topic, _msgType);
+  StatsSample sample;
+  while (_acc.samples.TryPop(sample))
+  {
+    // Older publishers stamp with their steady clock, in milliseconds.
+    const std::chrono::steady_clock::time_point published =
+      sample.meta.LegacyStamp() ?
+      std::chrono::steady_clock::time_point(
+        std::chrono::milliseconds(sample.meta.stamp)) :
+      std::chrono::steady_clock::time_point(
+        std::chrono::microseconds(static_cast<int64_t>(sample.meta.stamp) +
+          clockOffset(sample.sender) + wallToSteady));
+    _acc.stats.Update(sample.sender, published, sample.meta.seq,
+      sample.arrived, sample.received);
+    _acc.available = true;
+    _acc.changed = true;
+  }
 
-  return info;
+  const uint64_t dropped = _acc.droppedMsgs.exchange(0);
+  if (dropped > 0)
+  {
+    _acc.stats.AddDroppedMsgs(dropped);
+    _acc.available = true;
+    _acc.changed = true;
+  }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::TriggerCallbacks(
-    const MessageInfo &_info,
-    const std::string &_msgData,
-    const HandlerInfo &_handlerInfo)
+void NodeSharedPrivate::RunStatsTask()
 {
-  if (!_handlerInfo.haveLocal && !_handlerInfo.haveRaw)
-    return;
+#ifdef __linux__
+  // The statistics must not compete with the reception and the callbacks.
+  sched_param param{};
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+  setupThread("BACKGROUND", "gz-stats");
 
-  if (_handlerInfo.haveRaw)
+  std::vector<StatsAccumulator *> accs;
+  while (true)
   {
-    for (const auto &node : _handlerInfo.rawHandlers)
     {
-      for (const auto &handler : node.second)
+      std::unique_lock<std::mutex> lk(this->statsThreadMutex);
+      if (this->statsCondition.wait_for(lk, kStatsPeriod,
+            [this]{return this->exit.load();}))
       {
-        const RawSubscriptionHandlerPtr &rawHandler = handler.second;
-        if (rawHandler)
-        {
-          if (rawHandler->TypeName() == _info.Type() ||
-              rawHandler->TypeName() == kGenericMessageType)
-          {
-            rawHandler->RunRawCallback(_msgData.c_str(), _msgData.size(),
-                _info);
-          }
-        }
-        else
-          std::cerr << "Raw subscription handler is NULL" << std::endl;
+        return;
       }
     }
-  }
 
-  if (_handlerInfo.haveLocal)
-  {
-    // This will be instantiated by the first suitable handler that we
-    // encounter. If there is no suitable handler, then we can avoid
-    // deserializing the message altogether.
-    std::shared_ptr<ProtoMsg> msg;
+    accs.clear();
+    {
+      std::shared_lock<std::shared_mutex> lk(this->statsMutex);
+      for (const auto &[topic, acc] : this->topicStats)
+        accs.push_back(acc.get());
+    }
 
-    for (const auto &node : _handlerInfo.localHandlers)
+    for (StatsAccumulator *acc : accs)
     {
-      for (const auto &handler : node.second)
+      std::function<void(const TopicStatistics &_stats)> cb;
+      std::optional<TopicStatistics> stats;
       {
-        const ISubscriptionHandlerPtr &localHandler = handler.second;
-        if (localHandler)
-        {
-          if (localHandler->TypeName() == _info.Type() ||
-              localHandler->TypeName() == kGenericMessageType)
-          {
-            if (!msg)
-            {
-              // If the message has not been deserialized yet, do it now since
-              // we have allegedly found a subscriber which should be able to
-              // do it.
-              msg = localHandler->CreateMsg(_msgData, _info.Type());
-
-              if (!msg)
-              {
-                // If the message could not be created, then none of the
-                // handlers in this process will be able to create it, because
-                // protobuf has access to all message types that the current
-                // process is linked to. If CreateMsg(~,~) fails, then we may
-                // as well quit.
-                return;
-              }
-            }
-
-            localHandler->RunLocalCallback(*msg, _info);
-          }
-        }
-        else
-          std::cerr << "Local subscription handler is NULL" << std::endl;
+        std::lock_guard<std::mutex> lk(acc->mutex);
+        DrainStats(*acc);
+        if (!acc->changed || !acc->enabled || !acc->cb)
+          continue;
+        acc->changed = false;
+        cb = acc->cb;
+        stats.emplace(acc->stats);
       }
+
+      // Run the callback without holding the lock, it usually publishes.
+      cb(*stats);
     }
   }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::RecvSrvRequest()
+void NodeSharedPrivate::CreateSubscriberShards(std::size_t _numShards,
+    int _rcvHwm)
 {
-  if (verbose)
-    std::cout << "Message received requesting a service call" << std::endl;
-
-  zmq::message_t msg(0);
-  std::string topic;
-  std::string sender;
-  std::string nodeUuid;
-  std::string reqUuid;
-  std::string req;
-  std::string rep;
-  std::string resultStr;
-  std::string dstId;
-  std::string reqType;
-  std::string repType;
-
-  IRepHandlerPtr repHandler;
-  bool hasHandler;
-
+  for (std::size_t i = 1; i < _numShards; ++i)
   {
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    this->subscriberShards.push_back(
+      this->CreateShard(std::to_string(i), _rcvHwm, this->regularAffinity));
+  }
+}
 
-    try
-    {
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
-#else
-      if (!this->dataPtr->replier->recv(&msg, 0))
-#endif
-        return;
+//////////////////////////////////////////////////
+std::unique_ptr<SubscriberShard> NodeSharedPrivate::CreateShard(
+    const std::string &_name, int _rcvHwm, uint64_t _affinity)
+{
+  std::unique_ptr<SubscriberShard> shard(new SubscriberShard);
+  shard->socket.reset(new zmq::socket_t(*this->context, ZMQ_SUB));
+  this->CreateWakePair("subscriber_shard_" + _name, shard->wakeSender,
+    shard->wakeReceiver);
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
-#else
-      if (!this->dataPtr->replier->recv(&msg, 0))
-#endif
-        return;
-      topic = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  this->TuneSocket(*shard->socket);
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
+  int lingerVal = 0;
+#ifdef GZ_CPPZMQ_POST_4_7_0
+  shard->socket->set(zmq::sockopt::rcvhwm, _rcvHwm);
+  shard->socket->set(zmq::sockopt::linger, lingerVal);
+  shard->socket->set(zmq::sockopt::affinity, _affinity);
 #else
-      if (!this->dataPtr->replier->recv(&msg, 0))
+  shard->socket->setsockopt(ZMQ_RCVHWM, &_rcvHwm, sizeof(_rcvHwm));
+  shard->socket->setsockopt(ZMQ_LINGER, &lingerVal, sizeof(lingerVal));
+  shard->socket->setsockopt(ZMQ_AFFINITY, &_affinity, sizeof(_affinity));
 #endif
-        return;
-      sender = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  this->SecureClient(*shard->socket);
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
-#else
-      if (!this->dataPtr->replier->recv(&msg, 0))
-#endif
-        return;
-      dstId = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  return shard;
+}
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
+//////////////////////////////////////////////////
+void NodeSharedPrivate::TuneSocket(zmq::socket_t &_socket) const
+{
+  const int keepAlive = 1;
+#ifdef GZ_CPPZMQ_POST_4_7_0
+  if (this->sndBuf > 0)
+    _socket.set(zmq::sockopt::sndbuf, this->sndBuf);
+  if (this->rcvBuf > 0)
+    _socket.set(zmq::sockopt::rcvbuf, this->rcvBuf);
+  if (this->tcpKeepAliveIdle > 0)
+  {
+    _socket.set(zmq::sockopt::tcp_keepalive, keepAlive);
+    _socket.set(zmq::sockopt::tcp_keepalive_idle, this->tcpKeepAliveIdle);
+  }
 #else
-      if (!this->dataPtr->replier->recv(&msg, 0))
+  if (this->sndBuf > 0)
+    _socket.setsockopt(ZMQ_SNDBUF, &this->sndBuf, sizeof(this->sndBuf));
+  if (this->rcvBuf > 0)
+    _socket.setsockopt(ZMQ_RCVBUF, &this->rcvBuf, sizeof(this->rcvBuf));
+  if (this->tcpKeepAliveIdle > 0)
+  {
+    _socket.setsockopt(ZMQ_TCP_KEEPALIVE, &keepAlive, sizeof(keepAlive));
+    _socket.setsockopt(ZMQ_TCP_KEEPALIVE_IDLE, &this->tcpKeepAliveIdle,
+      sizeof(this->tcpKeepAliveIdle));
+  }
 #endif
-        return;
-      nodeUuid = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+}
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
-#else
-      if (!this->dataPtr->replier->recv(&msg, 0))
-#endif
-        return;
-      reqUuid = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateWakePair(const std::string &_name,
+    std::unique_ptr<zmq::socket_t> &_sender,
+    std::unique_ptr<zmq::socket_t> &_receiver)
+{
+  _sender.reset(new zmq::socket_t(*this->context, ZMQ_PAIR));
+  _receiver.reset(new zmq::socket_t(*this->context, ZMQ_PAIR));
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
+  const std::string wakeEp = "inproc://gz_transport_" + _name;
+  int lingerVal = 0;
+#ifdef GZ_CPPZMQ_POST_4_7_0
+  _sender->set(zmq::sockopt::linger, lingerVal);
+  _receiver->set(zmq::sockopt::linger, lingerVal);
 #else
-      if (!this->dataPtr->replier->recv(&msg, 0))
+  _sender->setsockopt(ZMQ_LINGER, &lingerVal, sizeof(lingerVal));
+  _receiver->setsockopt(ZMQ_LINGER, &lingerVal, sizeof(lingerVal));
 #endif
-        return;
-      req = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  _receiver->bind(wakeEp.c_str());
+  _sender->connect(wakeEp.c_str());
+}
 
+//////////////////////////////////////////////////
+void NodeSharedPrivate::Wake(zmq::socket_t &_sender)
+{
+  try
+  {
+    zmq::message_t signal(0);
 #ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
+    _sender.send(signal, zmq::send_flags::dontwait);
 #else
-      if (!this->dataPtr->replier->recv(&msg, 0))
+    _sender.send(signal, ZMQ_DONTWAIT);
 #endif
-        return;
-      reqType = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "NodeSharedPrivate::Wake() Error: "
+              << _error.what() << std::endl;
+  }
+}
 
+//////////////////////////////////////////////////
+void NodeSharedPrivate::DrainWake(zmq::socket_t &_receiver)
+{
+  zmq::message_t signal;
 #ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->replier->recv(msg))
+  while (_receiver.recv(signal, zmq::recv_flags::dontwait))
 #else
-      if (!this->dataPtr->replier->recv(&msg, 0))
+  while (_receiver.recv(&signal, ZMQ_DONTWAIT))
 #endif
-        return;
-      repType = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
-    }
-    catch(const zmq::error_t &_error)
-    {
-      std::cerr << "NodeShared::RecvSrvRequest() error parsing request: "
-                << _error.what() << std::endl;
-      return;
-    }
-
-    hasHandler =
-      this->repliers.FirstHandler(topic, reqType, repType, repHandler);
+  {
   }
+}
 
-  // Get the REP handler.
-  if (hasHandler)
-  {
-    // Run the service call and get the results.
-    bool result = repHandler->RunCallback(req, rep);
+//////////////////////////////////////////////////
+void NodeSharedPrivate::WakeShard(SubscriberShard &_shard)
+{
+  std::lock_guard<std::mutex> lk(_shard.mutex);
+  Wake(*_shard.wakeSender);
+}
 
-    // If 'reptype' is msgs::Empty", this is a oneway request
-    // and we don't send response
-    if (repType == msgs::Empty().GetTypeName())
-    {
-      return;
-    }
+//////////////////////////////////////////////////
+SubscriberShard *NodeSharedPrivate::PriorityShard(NodeShared *_shared)
+{
+  if (this->priorityShard)
+    return this->priorityShard.get();
 
-    if (result)
-      resultStr = "1";
-    else
-      resultStr = "0";
+  try
+  {
+    this->priorityShard = this->CreateShard("priority",
+      this->NonNegativeEnvVar("GZ_TRANSPORT_RCVHWM", kDefaultRcvHwm),
+      kPriorityAffinity);
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Error creating the high priority subscriber: "
+              << _error.what() << std::endl;
+    return nullptr;
+  }
 
-    {
-      std::lock_guard<std::recursive_mutex> lock(this->mutex);
-      // I am still not connected to this address.
-      if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
-            sender) == this->srvConnections.end())
-      {
-        this->dataPtr->replier->connect(sender.c_str());
-        this->srvConnections.push_back(sender);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  this->priorityShard->thread = std::thread(
+    &NodeSharedPrivate::RunShardReceptionTask, this, _shared,
+    this->priorityShard.get());
+  return this->priorityShard.get();
+}
 
-        if (this->verbose)
-        {
-          std::cout << "\t* Connected to [" << sender
-                    << "] for sending a response" << std::endl;
-        }
-      }
-    }
+//////////////////////////////////////////////////
+std::size_t NodeSharedPrivate::ShardIndex(const std::string &_topic) const
+{
+  if (this->subscriberShards.empty())
+    return 0;
 
-    // Send the reply.
-    try
-    {
-      std::lock_guard<std::recursive_mutex> lock(this->mutex);
-      zmq::message_t response;
+  return std::hash<std::string>{}(_topic) %
+    (this->subscriberShards.size() + 1);
+}
 
-      response.rebuild(dstId.size());
-      memcpy(response.data(), dstId.data(), dstId.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ConnectRouter(zmq::socket_t &_socket,
+    const std::string &_addr, const std::string &_peerId)
+{
+#ifdef ZMQ_CONNECT_ROUTING_ID
+  // Name the peer before connecting. The pipe is routable right away and
+  // the messages queue up until the connection is established. A routing
+  // ID can't be given twice, so we only do it the first time that we
+  // connect to an address. ZMQ reconnects by itself afterwards.
+  if (!this->routerEndpoints.insert({&_socket, _addr}).second)
+  {
+    _socket.connect(_addr.c_str());
+    return;
+  }
 
-      response.rebuild(topic.size());
-      memcpy(response.data(), topic.data(), topic.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+#ifdef GZ_CPPZMQ_POST_4_7_0
+  _socket.set(zmq::sockopt::connect_routing_id, _peerId);
 #else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+  _socket.setsockopt(ZMQ_CONNECT_ROUTING_ID, _peerId.data(), _peerId.size());
 #endif
-
-      response.rebuild(nodeUuid.size());
-      memcpy(response.data(), nodeUuid.data(), nodeUuid.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+  _socket.connect(_addr.c_str());
 #else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+  // The peer is unknown until the handshake completes and ROUTER_MANDATORY
+  // rejects the messages sent before that.
+  (void)_peerId;
+  _socket.connect(_addr.c_str());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
 #endif
+}
 
-      response.rebuild(reqUuid.size());
-      memcpy(response.data(), reqUuid.data(), reqUuid.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RequestShardOp(SubscriberShard &_shard,
+    SubscriberShard::Op _op, const std::string &_arg)
+{
+  std::lock_guard<std::mutex> lk(_shard.mutex);
+  const bool wasEmpty = _shard.pending.empty();
+  _shard.pending.emplace_back(_op, _arg);
 
-      response.rebuild(rep.size());
-      memcpy(response.data(), rep.data(), rep.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
-#else
-      this->dataPtr->replier->send(response, ZMQ_SNDMORE);
-#endif
+  // Only one signal is needed until the reception thread drains the list.
+  if (!wasEmpty)
+    return;
 
-      response.rebuild(resultStr.size());
-      memcpy(response.data(), resultStr.data(), resultStr.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-      this->dataPtr->replier->send(response, zmq::send_flags::none);
-#else
-      this->dataPtr->replier->send(response, 0);
-#endif
-    }
-    catch(const zmq::error_t &_error)
-    {
-      std::cerr << "NodeShared::RecvSrvRequest() error sending response: "
-                << _error.what() << std::endl;
-      return;
-    }
-  }
-  // else
-  //   std::cerr << "I do not have a service call registered for topic ["
-  //             << topic << "]\n";
+  Wake(*_shard.wakeSender);
 }
 
 //////////////////////////////////////////////////
-void NodeShared::RecvSrvResponse()
+SubscriberShard *NodeSharedPrivate::ShardOf(
+    const MessagePublisher &_pub) const
 {
-  if (verbose)
-    std::cout << "Message received containing a service call REP" << std::endl;
+  if (_pub.Options().HighPriority())
+    return this->priorityShard.get();
 
-  zmq::message_t msg(0);
-  std::string topic;
-  std::string nodeUuid;
-  std::string reqUuid;
-  std::string rep;
-  std::string resultStr;
-  bool result;
+  const std::size_t index = this->ShardIndex(_pub.Topic());
+  if (index == 0)
+    return nullptr;
 
-  IReqHandlerPtr reqHandlerPtr;
-  bool hasHandler;
+  return this->subscriberShards[index - 1].get();
+}
 
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::IpcEndpoint(const std::string &_tcpAddr)
+{
+  const std::string prefix = "tcp://";
+  if (_tcpAddr.compare(0, prefix.size(), prefix) != 0)
+    return "";
+
+  // The address and port may contain characters that aren't valid in a
+  // file name.
+  std::string name = _tcpAddr.substr(prefix.size());
+  for (auto &c : name)
   {
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+      c = '_';
+  }
 
-    try
-    {
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->responseReceiver->recv(msg))
-#else
-      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
-#endif
-        return;
+  std::error_code ec;
+  std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+  if (ec)
+    dir = ".";
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->responseReceiver->recv(msg))
-#else
-      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
-#endif
-        return;
-      topic = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  return "ipc://" + (dir / ("gz-transport-" + name + ".ipc")).string();
+}
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->responseReceiver->recv(msg))
-#else
-      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
-#endif
-        return;
-      nodeUuid = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+//////////////////////////////////////////////////
+void NodeSharedPrivate::BindIpc(zmq::socket_t &_socket,
+    const std::string &_tcpAddr)
+{
+  if (!this->ipcEnabled)
+    return;
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->responseReceiver->recv(msg))
-#else
-      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
-#endif
-        return;
-      reqUuid = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  const std::string endpoint = IpcEndpoint(_tcpAddr);
+  if (endpoint.empty())
+    return;
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->responseReceiver->recv(msg))
-#else
-      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
-#endif
-        return;
-      rep = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
+  try
+  {
+    _socket.bind(endpoint.c_str());
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Unable to bind [" << endpoint << "]: " << _error.what()
+              << ". Local subscribers will connect through TCP."
+              << std::endl;
+  }
+}
 
-#ifdef GZ_ZMQ_POST_4_3_1
-      if (!this->dataPtr->responseReceiver->recv(msg))
-#else
-      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
-#endif
-        return;
-      resultStr = std::string(reinterpret_cast<char *>(msg.data()), msg.size());
-      result = resultStr == "1";
-    }
-    catch(const zmq::error_t &_error)
-    {
-      std::cerr << "NodeShared::RecvSrvResponse() error: "
-                << _error.what() << std::endl;
-      return;
-    }
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::ConnectEndpoint(
+    const std::string &_addr) const
+{
+  if (!this->ipcEnabled)
+    return _addr;
+
+  // Only the publishers of this host can be reached through IPC.
+  const std::string host = "tcp://" + this->msgDiscovery->HostAddr() + ":";
+  if (_addr.compare(0, host.size(), host) != 0)
+    return _addr;
+
+  // The publisher binds its IPC endpoint before advertising, so a missing
+  // file means that it doesn't use the IPC transport.
+  const std::string endpoint = IpcEndpoint(_addr);
+  std::error_code ec;
+  if (!std::filesystem::exists(endpoint.substr(std::strlen("ipc://")), ec))
+    return _addr;
+
+  return endpoint;
+}
 
-    hasHandler =
-      this->requests.Handler(topic, nodeUuid, reqUuid, reqHandlerPtr);
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::PgmSupported()
+{
+  return zmq_has("pgm") != 0;
+}
+
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::MulticastEndpoint(const std::string &_addr,
+    const std::string &_group) const
+{
+  if (_group.empty() || !PgmSupported())
+    return "";
+
+  // The publishers of this host are reached through TCP or IPC, multicast
+  // loopback isn't reliable.
+  const std::string host = "tcp://" + this->msgDiscovery->HostAddr() + ":";
+  if (_addr.compare(0, host.size(), host) == 0)
+    return "";
+
+  // PGM doesn't authenticate the publishers.
+  if (secured())
+    return "";
+
+  return "epgm://" + this->msgDiscovery->HostAddr() + ";" + _group;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AcquireAddress(SubscriberShard *_shard,
+    const std::string &_addr, const std::string &_multicastGroup)
+{
+  if (this->addressUsers[{_shard, _addr}]++ > 0)
+    return;
+
+  // Remember the endpoint, the IPC file could be gone when disconnecting.
+  std::string endpoint = this->MulticastEndpoint(_addr, _multicastGroup);
+  if (endpoint.empty())
+    endpoint = this->ConnectEndpoint(_addr);
+  if (endpoint != _addr)
+    this->connectedEndpoints[{_shard, _addr}] = endpoint;
+
+  // The publishers of a multicast group share its endpoint.
+  if (this->endpointUsers[{_shard, endpoint}]++ > 0)
+    return;
+
+  if (_shard)
+  {
+    // The shard's reception thread connects.
+    RequestShardOp(*_shard, SubscriberShard::Op::CONNECT, endpoint);
+    return;
   }
 
-  if (hasHandler)
+  std::lock_guard<std::mutex> lk(this->subscriberMutex);
+
+  // Handle security
+  this->SecurityOnNewConnection();
+
+  this->subscriber->connect(endpoint.c_str());
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseConnection(const MessagePublisher &_pub)
+{
+  SubscriberShard *shard = this->ShardOf(_pub);
+  auto it = this->addressUsers.find({shard, _pub.Addr()});
+  if (it == this->addressUsers.end() || --it->second > 0)
+    return;
+
+  this->addressUsers.erase(it);
+
+  std::string endpoint = _pub.Addr();
+  auto endpointIt = this->connectedEndpoints.find({shard, _pub.Addr()});
+  if (endpointIt != this->connectedEndpoints.end())
   {
-    // Notify the result.
-    reqHandlerPtr->NotifyResult(rep, result);
+    endpoint = endpointIt->second;
+    this->connectedEndpoints.erase(endpointIt);
+  }
 
-    // Remove the handler.
-    std::lock_guard<std::recursive_mutex> lock(this->mutex);
-    {
-      if (!this->requests.RemoveHandler(topic, nodeUuid, reqUuid))
-      {
-        std::cerr << "NodeShare::RecvSrvResponse(): "
-                  << "Error removing request handler" << std::endl;
-      }
-    }
+  // Other publishers of a multicast group may still use its endpoint.
+  auto usersIt = this->endpointUsers.find({shard, endpoint});
+  if (usersIt != this->endpointUsers.end())
+  {
+    if (--usersIt->second > 0)
+      return;
+    this->endpointUsers.erase(usersIt);
   }
-  else
+
+  // Nothing else reads from this publisher through this socket, so there is
+  // no reason to keep the TCP connection (or reconnecting to it).
+  if (shard)
   {
-    std::cerr << "Received a service call response but I don't have a handler"
-              << " for it" << std::endl;
+    RequestShardOp(*shard, SubscriberShard::Op::DISCONNECT, endpoint);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(this->subscriberMutex);
+  try
+  {
+    this->subscriber->disconnect(endpoint.c_str());
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Unable to disconnect from [" << endpoint << "]: "
+              << _error.what() << std::endl;
   }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::SendPendingRemoteReqs(const std::string &_topic,
-  const std::string &_reqType, const std::string &_repType)
+void NodeSharedPrivate::ReleaseTopicConnections(
+    TopicStorage<MessagePublisher> &_connections, const std::string &_topic)
 {
-  std::string responserAddr;
-  std::string responserId;
-  SrvAddresses_M addresses;
-  this->dataPtr->srvDiscovery->Publishers(_topic, addresses);
-  if (addresses.empty())
+  MsgAddresses_M info;
+  if (!_connections.Publishers(_topic, info))
     return;
 
-  // Find a publisher that offers this service with a particular pair of REQ/REP
-  // types.
-  bool found = false;
-  for (auto &proc : addresses)
+  for (const auto &proc : info)
   {
-    auto &v = proc.second;
-    for (auto &pub : v)
+    for (const MessagePublisher &connection : proc.second)
     {
-      if (pub.ReqTypeName() == _reqType && pub.RepTypeName() == _repType)
-      {
-        found = true;
-        responserAddr = pub.Addr();
-        responserId = pub.SocketId();
-        break;
-      }
+      _connections.DelPublisherByNode(_topic, connection.PUuid(),
+        connection.NUuid());
+      this->ReleaseConnection(connection);
     }
-    if (found)
-      break;
   }
+}
 
-  if (!found)
-    return;
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AddToGraph(const MessagePublisher &_pub)
+{
+  if (this->graph.AddPublisher(_pub))
+    this->NotifyGraph(_pub, true);
+}
 
-  if (verbose)
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RemoveFromGraph(const MessagePublisher &_pub)
+{
+  if (!_pub.Topic().empty())
   {
-    std::cout << "Found a service call responser at ["
-              << responserAddr << "]" << std::endl;
-  }
+    MessagePublisher pub;
+    if (!this->graph.Publisher(_pub.Topic(), _pub.PUuid(), _pub.NUuid(), pub))
+      return;
 
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    this->graph.DelPublisherByNode(_pub.Topic(), _pub.PUuid(), _pub.NUuid());
+    this->NotifyGraph(pub, false);
+    return;
+  }
 
-  // I am still not connected to this address.
-  if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
-        responserAddr) == this->srvConnections.end())
+  // The process is gone.
+  std::map<std::string, std::vector<MessagePublisher>> pubs;
+  this->graph.PublishersByProc(_pub.PUuid(), pubs);
+  this->graph.DelPublishersByProc(_pub.PUuid());
+  for (const auto &node : pubs)
   {
-    this->dataPtr->requester->connect(responserAddr.c_str());
-    this->srvConnections.push_back(responserAddr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    if (this->verbose)
-    {
-      std::cout << "\t* Connected to [" << responserAddr
-                << "] for service requests" << std::endl;
-    }
+    for (const MessagePublisher &pub : node.second)
+      this->NotifyGraph(pub, false);
   }
+}
 
-  // Send all the pending REQs.
-  IReqHandler_M reqs;
-  if (!this->requests.Handlers(_topic, reqs))
+//////////////////////////////////////////////////
+void NodeSharedPrivate::NotifyGraph(const MessagePublisher &_pub,
+    const bool _added)
+{
+  if (this->graphWatchers.empty())
     return;
 
-  for (auto &node : reqs)
+  std::string partition;
+  std::string topic;
+  if (!TopicUtils::DecomposeFullyQualifiedTopic(
+        _pub.Topic(), partition, topic))
   {
-    for (auto &req : node.second)
-    {
-      // Check if this service call has been already requested.
-      if (req.second->Requested())
-        continue;
+    return;
+  }
 
-      // Check that the pending service call has types that match the responser.
-      if (req.second->ReqTypeName() != _reqType ||
-          req.second->RepTypeName() != _repType)
-      {
-        continue;
-      }
+  // Remove the front '/'
+  if (!partition.empty())
+    partition.erase(partition.begin());
 
-      // Mark the handler as requested.
-      req.second->Requested(true);
+  for (const auto &watcher : this->graphWatchers)
+  {
+    if (watcher.second.partition == partition && watcher.second.cb)
+      watcher.second.cb(_pub, _added);
+  }
+}
 
-      std::string data;
-      if (!req.second->Serialize(data))
-        continue;
+//////////////////////////////////////////////////
+void NodeSharedPrivate::UnsubscribeTopicFilter(const std::string &_topic)
+{
+  std::vector<std::string> filters;
+  if (this->compactHeader)
+    filters = this->UnregisterCompactTopic(_topic);
+  else
+    filters.push_back(this->TopicFilter(_topic));
 
-      auto nodeUuid = req.second->NodeUuid();
-      auto reqUuid = req.second->HandlerUuid();
+  // The topic may have high priority publishers too.
+  if (this->priorityShard)
+  {
+    for (const std::string &filter : filters)
+    {
+      RequestShardOp(*this->priorityShard, SubscriberShard::Op::UNSUBSCRIBE,
+        filter);
+    }
+  }
 
-      try
-      {
-        zmq::message_t msg;
+  const std::size_t shard = this->ShardIndex(_topic);
+  if (shard != 0)
+  {
+    for (const std::string &filter : filters)
+    {
+      RequestShardOp(*this->subscriberShards[shard - 1],
+        SubscriberShard::Op::UNSUBSCRIBE, filter);
+    }
+    return;
+  }
 
-        msg.rebuild(responserId.size());
-        memcpy(msg.data(), responserId.data(), responserId.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+  std::lock_guard<std::mutex> lk(this->subscriberMutex);
+  for (const std::string &filter : filters)
+  {
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    this->subscriber->set(zmq::sockopt::unsubscribe, filter);
 #else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+    this->subscriber->setsockopt(ZMQ_UNSUBSCRIBE,
+      filter.data(), filter.size());
 #endif
+  }
+}
 
-        msg.rebuild(_topic.size());
-        memcpy(msg.data(), _topic.data(), _topic.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunShardReceptionTask(NodeShared *_shared,
+    SubscriberShard *_shard)
+{
+  if (_shard == this->priorityShard.get())
+    setupThread("PRIORITY", "gz-priority-rx");
+  else
+    setupThread("RECEPTION", "gz-reception");
 
-        msg.rebuild(this->myRequesterAddress.size());
-        memcpy(msg.data(), this->myRequesterAddress.data(),
-          this->myRequesterAddress.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+  std::vector<std::pair<SubscriberShard::Op, std::string>> ops;
+  std::chrono::steady_clock::time_point wake;
 
-        std::string myId = this->responseReceiverId.ToString();
-        msg.rebuild(myId.size());
-        memcpy(msg.data(), myId.data(), myId.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+  while (!this->exit)
+  {
+    zmq::pollitem_t items[] =
+    {
+      {static_cast<void*>(*_shard->socket), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*_shard->wakeReceiver), 0, ZMQ_POLLIN, 0}
+    };
 
-        msg.rebuild(nodeUuid.size());
-        memcpy(msg.data(), nodeUuid.data(), nodeUuid.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+    try
+    {
+      // Block until there is something to do, the destructor wakes us up.
+      zmq::poll(&items[0], sizeof(items) / sizeof(items[0]),
+          std::chrono::milliseconds(-1));
+      wake = std::chrono::steady_clock::now();
 
-        msg.rebuild(reqUuid.size());
-        memcpy(msg.data(), reqUuid.data(), reqUuid.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+      // Apply the pending connections and filters.
+      if (items[1].revents & ZMQ_POLLIN)
+      {
+        DrainWake(*_shard->wakeReceiver);
 
-        msg.rebuild(data.size());
-        memcpy(msg.data(), data.data(), data.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
-#else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
-#endif
+        {
+          std::lock_guard<std::mutex> lk(_shard->mutex);
+          ops.swap(_shard->pending);
+        }
 
-        msg.rebuild(_reqType.size());
-        memcpy(msg.data(), _reqType.data(), _reqType.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+        for (const auto &[op, arg] : ops)
+        {
+          switch (op)
+          {
+            case SubscriberShard::Op::CONNECT:
+              if (_shard->addresses.insert(arg).second)
+                _shard->socket->connect(arg.c_str());
+              break;
+            case SubscriberShard::Op::DISCONNECT:
+              if (_shard->addresses.erase(arg) > 0)
+                _shard->socket->disconnect(arg.c_str());
+              break;
+            case SubscriberShard::Op::SUBSCRIBE:
+#ifdef GZ_CPPZMQ_POST_4_7_0
+              _shard->socket->set(zmq::sockopt::subscribe, arg);
 #else
-        this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+              _shard->socket->setsockopt(ZMQ_SUBSCRIBE,
+                  arg.data(), arg.size());
 #endif
-
-        msg.rebuild(_repType.size());
-        memcpy(msg.data(), _repType.data(), _repType.size());
-#ifdef GZ_ZMQ_POST_4_3_1
-        this->dataPtr->requester->send(msg, zmq::send_flags::none);
+              break;
+            case SubscriberShard::Op::UNSUBSCRIBE:
+#ifdef GZ_CPPZMQ_POST_4_7_0
+              _shard->socket->set(zmq::sockopt::unsubscribe, arg);
 #else
-        this->dataPtr->requester->send(msg, 0);
+              _shard->socket->setsockopt(ZMQ_UNSUBSCRIBE,
+                  arg.data(), arg.size());
 #endif
+              break;
+            default:
+              break;
+          }
+        }
+        ops.clear();
       }
-      catch(const zmq::error_t& /*ze*/)
-      {
-        // Debug output.
-        // std::cerr << "Error connecting [" << ze.what() << "]\n";
-      }
+    }
+    catch(const zmq::error_t &_error)
+    {
+      std::cerr << "Subscriber shard error: " << _error.what() << std::endl;
+      continue;
+    }
 
-      // Remove the handler associated to this service request. We won't
-      // receive a response because this is a oneway request.
-      if (_repType == msgs::Empty().GetTypeName())
-      {
-        this->requests.RemoveHandler(_topic, nodeUuid, reqUuid);
-      }
+    if (!(items[0].revents & ZMQ_POLLIN))
+      continue;
+
+    std::string topic;
+    std::string sender;
+    std::string data;
+    std::string msgType;
+    PublicationMetadata meta;
+    TraceMetadata trace;
+
+    // This thread is the only user of the shard socket, so the frames are
+    // received without holding the global mutex.
+    if (!this->RecvMsgFrames(*_shard->socket, topic, sender, data, msgType,
+          meta, trace))
+    {
+      continue;
     }
+
+    // Wait for the last fragment of a large publication.
+    if (!this->reassembler->Add(sender, msgType, data))
+      continue;
+
+    if (this->topicStatsEnabled)
+      this->UpdateTopicStats(topic, sender, meta, wake);
+
+    TraceReception(topic, trace);
+    Tracer::Scope traceScope(trace);
+    this->DispatchRemoteMsg(_shared, topic, msgType, data, sender, meta);
   }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnNewConnection(const MessagePublisher &_pub)
+NodeShared::HandlerInfo NodeShared::CheckHandlerInfo(
+    const std::string &_topic) const
 {
-  std::string topic = _pub.Topic();
-  std::string addr = _pub.Addr();
-  std::string procUuid = _pub.PUuid();
-
-  if (this->verbose)
-  {
-    std::cout << "Connection callback" << std::endl;
-    std::cout << _pub;
-  }
+  HandlerInfo info;
 
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  info.handlers = this->localSubscribers.Snapshot(_topic);
+  info.haveLocal = info.handlers && !info.handlers->normal.empty();
+  info.haveRaw = info.handlers && !info.handlers->raw.empty();
+
+  return info;
+}
+
+//////////////////////////////////////////////////
+NodeShared::SubscriberInfo NodeShared::CheckSubscriberInfo(
+    const std::string &_topic,
+    const std::string &_msgType) const
+{
+  SubscriberInfo info;
+
+  info.handlers = this->localSubscribers.Snapshot(_topic);
+  info.haveLocal = info.handlers && !info.handlers->normal.empty();
+  info.haveRaw = info.handlers && !info.handlers->raw.empty();
+
+  std::shared_lock<std::shared_mutex> lk(
+    this->dataPtr->remoteSubscribersMutex);
+  info.haveRemote = this->remoteSubscribers.HasTopic(
+        _topic, _msgType);
+
+  return info;
+}
+
+//////////////////////////////////////////////////
+void NodeShared::TriggerCallbacks(
+    const MessageInfo &_info,
+    const std::string &_msgData,
+    const HandlerInfo &_handlerInfo)
+{
+  if (!_handlerInfo.haveLocal && !_handlerInfo.haveRaw)
+    return;
+
+  GZ_TRANSPORT_PROBE1(callbacks__start, _info.Topic().c_str());
+  ProbeScope callbacksDone([&]()
+  {
+    GZ_TRANSPORT_PROBE1(callbacks__done, _info.Topic().c_str());
+  });
+
+  // Trace of the publication being dispatched, see Tracer::Scope.
+  Tracer &tracer = Tracer::Instance();
+  const uint64_t traceId =
+    tracer.Enabled() ? Tracer::Current().traceId : 0;
+  uint64_t traceStart = 0;
+
+  // All the handlers receive the message now, see CallbackProfiler.
+  const CallbackProfiler::Clock::time_point arrival =
+    CallbackProfiler::Instance().Enabled() ?
+    CallbackProfiler::Clock::now() : CallbackProfiler::Clock::time_point();
+
+  // Payload shared by the raw callbacks that don't run on this thread.
+  std::shared_ptr<const std::string> sharedData;
+
+  if (_handlerInfo.haveRaw)
+  {
+    for (const RawSubscriptionHandlerPtr &rawHandler :
+         _handlerInfo.handlers->raw)
+    {
+      if (rawHandler)
+      {
+        if (rawHandler->TypeName() == _info.Type() ||
+            rawHandler->TypeName() == kGenericMessageType)
+        {
+          if (rawHandler->Queued())
+          {
+            this->dataPtr->PostQueued(rawHandler, _msgData, _info);
+            continue;
+          }
+
+          // The node in spin mode or the callback group of the handler
+          // runs this callback.
+          auto executor = this->dataPtr->ExecutorOf(rawHandler->NodeUuid(),
+            rawHandler->CallbackGroup());
+          if (executor)
+          {
+            if (!sharedData)
+              sharedData = std::make_shared<const std::string>(_msgData);
+            executor->Post(rawHandler->HandlerUuid(),
+              [rawHandler, data = sharedData, info = _info, arrival]()
+            {
+              if (!rawHandler->Alive())
+                return;
+              CallbackProfiler::Scope profile(rawHandler, info.Topic(),
+                arrival);
+              rawHandler->RunRawCallback(data->c_str(), data->size(), info);
+            });
+            continue;
+          }
+
+          if (traceId)
+            traceStart = Tracer::Now();
+          {
+            CallbackProfiler::Scope profile(rawHandler, _info.Topic(),
+              arrival);
+            rawHandler->RunRawCallback(_msgData.c_str(), _msgData.size(),
+                _info);
+          }
+          if (traceId)
+          {
+            tracer.Span("callback", _info.Topic(), traceId, traceStart,
+              Tracer::Now());
+          }
+        }
+      }
+      else
+        std::cerr << "Raw subscription handler is NULL" << std::endl;
+    }
+  }
+
+  if (_handlerInfo.haveLocal)
+  {
+    // The payload is parsed at most once and the resulting message is shared
+    // by all the handlers. A typed handler is preferred to create it: its
+    // message is a generated class that generic handlers can also consume,
+    // while a generic handler may produce a dynamic message that a typed
+    // handler can't be cast to. If there is no suitable handler, then we can
+    // avoid deserializing the message altogether. Queued handlers only
+    // keep the payload, which is parsed when their callback is ready.
+    const ISubscriptionHandlerPtr *creator = nullptr;
+    bool typedCreator = false;
+    for (const ISubscriptionHandlerPtr &localHandler :
+         _handlerInfo.handlers->normal)
+    {
+      if (!localHandler)
+        continue;
+
+      const std::string typeName = localHandler->TypeName();
+      if (typeName != _info.Type() && typeName != kGenericMessageType)
+        continue;
+
+      if (localHandler->Queued())
+      {
+        this->dataPtr->PostQueued(localHandler, _msgData, _info);
+        continue;
+      }
+
+      if (typedCreator)
+        continue;
+
+      if (typeName == _info.Type())
+      {
+        creator = &localHandler;
+        typedCreator = true;
+      }
+      else if (!creator)
+      {
+        creator = &localHandler;
+      }
+    }
+
+    if (!creator)
+      return;
+
+    if (traceId)
+      traceStart = Tracer::Now();
+    const std::shared_ptr<const ProtoMsg> msg =
+      (*creator)->CreateMsg(_msgData, _info.Type());
+    if (traceId)
+    {
+      tracer.Span("parse", _info.Topic(), traceId, traceStart,
+        Tracer::Now());
+    }
+    if (!msg)
+    {
+      // If the message could not be created, then none of the handlers in
+      // this process will be able to create it, because protobuf has access
+      // to all message types that the current process is linked to.
+      return;
+    }
+
+    for (const ISubscriptionHandlerPtr &localHandler :
+         _handlerInfo.handlers->normal)
+    {
+      if (localHandler)
+      {
+        if ((localHandler->TypeName() == _info.Type() ||
+             localHandler->TypeName() == kGenericMessageType) &&
+            !localHandler->Queued())
+        {
+          // The node in spin mode or the callback group of the handler
+          // runs this callback.
+          auto executor = this->dataPtr->ExecutorOf(
+            localHandler->NodeUuid(), localHandler->CallbackGroup());
+          if (executor)
+          {
+            executor->Post(localHandler->HandlerUuid(),
+              [localHandler, msg, info = _info, arrival]()
+            {
+              if (!localHandler->Alive())
+                return;
+              CallbackProfiler::Scope profile(localHandler, info.Topic(),
+                arrival);
+              localHandler->RunLocalCallback(*msg, info);
+            });
+            continue;
+          }
+
+          if (traceId)
+            traceStart = Tracer::Now();
+          {
+            CallbackProfiler::Scope profile(localHandler, _info.Topic(),
+              arrival);
+            localHandler->RunLocalCallback(*msg, _info);
+          }
+          if (traceId)
+          {
+            tracer.Span("callback", _info.Topic(), traceId, traceStart,
+              Tracer::Now());
+          }
+        }
+      }
+      else
+        std::cerr << "Local subscription handler is NULL" << std::endl;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::RecvSrvRequest()
+{
+  if (verbose)
+    std::cout << "Message received requesting a service call" << std::endl;
+
+  zmq::message_t msg(0);
+  std::string topic;
+  std::string sender;
+  std::string nodeUuid;
+  std::string reqUuid;
+  std::string req;
+  std::string rep;
+  std::string dstId;
+  std::string reqType;
+  std::string repType;
+
+  IRepHandlerPtr repHandler;
+  bool hasHandler;
+  ServiceCallKind kind = ServiceCallKind::SINGLE;
+  bool envelope = false;
+  auto deadline = std::chrono::steady_clock::time_point::max();
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+    try
+    {
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!this->dataPtr->replier->recv(msg))
+#else
+      if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+        return;
+
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!this->dataPtr->replier->recv(msg))
+#else
+      if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+        return;
+
+      // A request sent in a single frame.
+      if (!msg.more())
+      {
+        ServiceRequestEnvelope envelopeReq;
+        if (!envelopeReq.Decode(static_cast<const char *>(msg.data()),
+              msg.size(), req))
+        {
+          std::cerr << "NodeShared::RecvSrvRequest() error parsing request"
+                    << std::endl;
+          return;
+        }
+
+        auto it = this->dataPtr->envelopeServices.find(
+          envelopeReq.serviceId);
+        if (it == this->dataPtr->envelopeServices.end())
+          return;
+
+        topic = it->second.topic;
+        reqType = it->second.reqType;
+        repType = it->second.repType;
+        sender = std::move(envelopeReq.sender);
+        dstId = std::move(envelopeReq.dstId);
+        nodeUuid = std::move(envelopeReq.nodeUuid);
+        reqUuid = std::to_string(envelopeReq.requestId);
+        envelope = true;
+
+        // The deadline of the requester, on our clock.
+        if (envelopeReq.timeout)
+        {
+          deadline = std::chrono::steady_clock::now() +
+            *envelopeReq.timeout;
+        }
+      }
+      else
+      {
+        topic.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        sender.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        dstId.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        nodeUuid.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        reqUuid.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        req.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        reqType.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->replier->recv(msg))
+#else
+        if (!this->dataPtr->replier->recv(&msg, 0))
+#endif
+          return;
+        repType.assign(static_cast<char *>(msg.data()), msg.size());
+      }
+    }
+    catch(const zmq::error_t &_error)
+    {
+      std::cerr << "NodeShared::RecvSrvRequest() error parsing request: "
+                << _error.what() << std::endl;
+      return;
+    }
+
+    // A batch of requests or a streamed response.
+    kind = NodeSharedPrivate::StripReqTypePrefix(reqType);
+
+    hasHandler =
+      this->repliers.FirstHandler(topic, reqType, repType, repHandler);
+  }
+
+  GZ_TRANSPORT_PROBE3(request__receive, topic.c_str(), reqUuid.c_str(),
+    req.size());
+
+  // Get the REP handler.
+  if (hasHandler)
+  {
+    // If 'reptype' is msgs::Empty", this is a oneway request
+    // and we don't send response
+    const bool oneway = repType == msgs::Empty().GetTypeName();
+
+    // Services advertised with a concurrency run in the service workers.
+    ServiceReply reply{sender, dstId, topic, nodeUuid, reqUuid, "", false};
+    reply.envelope = envelope;
+    auto call = [this, repHandler, req, reply, oneway, kind,
+                 deadline]() mutable
+    {
+      // The requester gave up while the request was waiting: skip it.
+      if (deadline <= std::chrono::steady_clock::now())
+        return;
+
+      // The chunks are queued in order, before the final reply.
+      auto emit = [this, &reply](const std::string &_chunk)
+      {
+        ServiceReply chunk = reply;
+        chunk.rep = _chunk;
+        chunk.more = true;
+        this->dataPtr->QueueServiceReply(std::move(chunk));
+        return true;
+      };
+      {
+        ServiceContext context(deadline);
+        reply.result = NodeSharedPrivate::RunServiceCall(reply.topic,
+          *repHandler, kind, req, reply.rep, emit);
+      }
+      if (!oneway)
+        this->dataPtr->QueueServiceReply(std::move(reply));
+    };
+
+    bool accepted = true;
+    if (this->dataPtr->PostServiceCall(topic, std::move(call), accepted))
+    {
+      // Too many waiting requests: fail this one right away.
+      if (!accepted && !oneway)
+      {
+        this->SendSrvReply(sender, dstId, topic, nodeUuid, reqUuid, "",
+          false, false, envelope);
+      }
+      return;
+    }
+
+    // Run the service call and get the results.
+    auto emit = [&](const std::string &_chunk)
+    {
+      this->SendSrvReply(sender, dstId, topic, nodeUuid, reqUuid, _chunk,
+        true, true, envelope);
+      return true;
+    };
+    bool result;
+    {
+      ServiceContext context(deadline);
+      result = NodeSharedPrivate::RunServiceCall(topic, *repHandler, kind,
+        req, rep, emit);
+    }
+
+    if (oneway)
+      return;
+
+    this->SendSrvReply(sender, dstId, topic, nodeUuid, reqUuid, rep, result,
+      false, envelope);
+  }
+  // else
+  //   std::cerr << "I do not have a service call registered for topic ["
+  //             << topic << "]\n";
+}
+
+//////////////////////////////////////////////////
+void NodeShared::SendSrvReply(const std::string &_sender,
+  const std::string &_dstId, const std::string &_topic,
+  const std::string &_nodeUuid, const std::string &_reqUuid,
+  const std::string &_rep, const bool _result, const bool _more,
+  const bool _envelope)
+{
+  const std::string resultStr = _more ?
+    NodeSharedPrivate::kStreamChunkResult : (_result ? "1" : "0");
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    // I am still not connected to this address.
+    if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
+          _sender) == this->srvConnections.end())
+    {
+      this->dataPtr->ConnectRouter(*this->dataPtr->replier, _sender,
+        _dstId);
+      this->srvConnections.push_back(_sender);
+
+      if (this->verbose)
+      {
+        std::cout << "\t* Connected to [" << _sender
+                  << "] for sending a response" << std::endl;
+      }
+    }
+  }
+
+  // Send the reply.
+  try
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    zmq::message_t response;
+
+    response.rebuild(_dstId.size());
+    memcpy(response.data(), _dstId.data(), _dstId.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+#endif
+
+    // The requester identifies the request by its ID only.
+    ServiceResponseEnvelope envelopeRep;
+    if (_envelope &&
+        ReqHandlerStorage::ParseId(_reqUuid, envelopeRep.requestId))
+    {
+      envelopeRep.result = _result;
+      envelopeRep.more = _more;
+      response.rebuild(ServiceResponseEnvelope::Size(_rep.size()));
+      envelopeRep.Encode(_rep, static_cast<char *>(response.data()));
+#ifdef GZ_ZMQ_POST_4_3_1
+      this->dataPtr->replier->send(response, zmq::send_flags::none);
+#else
+      this->dataPtr->replier->send(response, 0);
+#endif
+      return;
+    }
+
+    response.rebuild(_topic.size());
+    memcpy(response.data(), _topic.data(), _topic.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+#endif
+
+    response.rebuild(_nodeUuid.size());
+    memcpy(response.data(), _nodeUuid.data(), _nodeUuid.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+#endif
+
+    response.rebuild(_reqUuid.size());
+    memcpy(response.data(), _reqUuid.data(), _reqUuid.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+#endif
+
+    response.rebuild(_rep.size());
+    memcpy(response.data(), _rep.data(), _rep.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->replier->send(response, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->replier->send(response, ZMQ_SNDMORE);
+#endif
+
+    response.rebuild(resultStr.size());
+    memcpy(response.data(), resultStr.data(), resultStr.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->replier->send(response, zmq::send_flags::none);
+#else
+    this->dataPtr->replier->send(response, 0);
+#endif
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "NodeShared::SendSrvReply() error sending response: "
+              << _error.what() << std::endl;
+    return;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::SendPendingSrvReplies()
+{
+  std::vector<ServiceReply> replies;
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->replyMutex);
+    replies.swap(this->dataPtr->pendingReplies);
+  }
+
+  for (const auto &reply : replies)
+  {
+    this->SendSrvReply(reply.sender, reply.dstId, reply.topic,
+      reply.nodeUuid, reply.reqUuid, reply.rep, reply.result, reply.more,
+      reply.envelope);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::RecvSrvResponse()
+{
+  if (verbose)
+    std::cout << "Message received containing a service call REP" << std::endl;
+
+  zmq::message_t msg(0);
+  std::string topic;
+  std::string nodeUuid;
+  std::string reqUuid;
+  std::string rep;
+  std::string resultStr;
+  bool result;
+  bool more;
+
+  IReqHandlerPtr reqHandlerPtr;
+  bool hasHandler;
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+    try
+    {
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!this->dataPtr->responseReceiver->recv(msg))
+#else
+      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
+#endif
+        return;
+
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!this->dataPtr->responseReceiver->recv(msg))
+#else
+      if (!this->dataPtr->responseReceiver->recv(&msg, 0))
+#endif
+        return;
+
+      // A response sent in a single frame.
+      if (!msg.more())
+      {
+        ServiceResponseEnvelope envelopeRep;
+        if (!envelopeRep.Decode(static_cast<const char *>(msg.data()),
+              msg.size(), rep))
+        {
+          std::cerr << "NodeShared::RecvSrvResponse() error parsing response"
+                    << std::endl;
+          return;
+        }
+
+        result = envelopeRep.result;
+        more = envelopeRep.more;
+        reqUuid = std::to_string(envelopeRep.requestId);
+        hasHandler = this->requests.Handler(envelopeRep.requestId, topic,
+          nodeUuid, reqHandlerPtr);
+      }
+      else
+      {
+        topic.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->responseReceiver->recv(msg))
+#else
+        if (!this->dataPtr->responseReceiver->recv(&msg, 0))
+#endif
+          return;
+        nodeUuid.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->responseReceiver->recv(msg))
+#else
+        if (!this->dataPtr->responseReceiver->recv(&msg, 0))
+#endif
+          return;
+        reqUuid.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->responseReceiver->recv(msg))
+#else
+        if (!this->dataPtr->responseReceiver->recv(&msg, 0))
+#endif
+          return;
+        rep.assign(static_cast<char *>(msg.data()), msg.size());
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        if (!this->dataPtr->responseReceiver->recv(msg))
+#else
+        if (!this->dataPtr->responseReceiver->recv(&msg, 0))
+#endif
+          return;
+        resultStr.assign(static_cast<char *>(msg.data()), msg.size());
+        result = resultStr == "1";
+        more = resultStr == NodeSharedPrivate::kStreamChunkResult;
+
+        hasHandler =
+          this->requests.Handler(topic, nodeUuid, reqUuid, reqHandlerPtr);
+      }
+    }
+    catch(const zmq::error_t &_error)
+    {
+      std::cerr << "NodeShared::RecvSrvResponse() error: "
+                << _error.what() << std::endl;
+      return;
+    }
+
+    // The first response of a hedged request wins, ignore the others.
+    if (!more && this->dataPtr->TrackResponse(reqUuid) && !hasHandler)
+      return;
+  }
+
+  // A chunk of a streamed response: the handler waits for the last one.
+  if (more)
+  {
+    if (hasHandler)
+      reqHandlerPtr->NotifyChunk(rep);
+    return;
+  }
+
+  GZ_TRANSPORT_PROBE3(response__receive, topic.c_str(), reqUuid.c_str(),
+    result);
+
+  if (hasHandler)
+  {
+    Metrics::Instance().RecordRequest(topic,
+      std::chrono::steady_clock::now() - reqHandlerPtr->Created(), result);
+
+    // Notify the result.
+    reqHandlerPtr->NotifyResult(rep, result);
+
+    // Remove the handler.
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    {
+      // The next requests of an idempotent service are answered locally.
+      if (result && reqHandlerPtr->CacheTtl().count() > 0)
+        this->dataPtr->CacheResponse(topic, *reqHandlerPtr, rep);
+
+      if (!this->requests.RemoveHandler(topic, nodeUuid, reqUuid))
+      {
+        std::cerr << "NodeShare::RecvSrvResponse(): "
+                  << "Error removing request handler" << std::endl;
+      }
+    }
+  }
+  // The requester may have given up after the deadline of the request.
+  else if (this->verbose)
+  {
+    std::cerr << "Received a service call response but I don't have a handler"
+              << " for it" << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::SendPendingRemoteReqs(const std::string &_topic,
+  const std::string &_reqType, const std::string &_repType)
+{
+  // Find the publishers that offer this service with a particular pair of
+  // REQ/REP types.
+  std::vector<ServicePublisher> responders;
+  this->dataPtr->srvDiscovery->VisitPublishers(_topic,
+    [&](const ServicePublisher &_pub)
+    {
+      if (_pub.ReqTypeName() == _reqType && _pub.RepTypeName() == _repType)
+        responders.push_back(_pub);
+    });
+
+  if (responders.empty())
+    return;
+
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  // Send all the pending REQs with types that match the responser.
+  std::vector<IReqHandlerPtr> reqs;
+  if (!this->requests.TakeUnsent(_topic, _reqType, _repType, reqs))
+    return;
+
+  bool hedged = false;
+  const auto now = std::chrono::steady_clock::now();
+  for (auto &req : reqs)
+  {
+    // Nobody waits for the response of a request whose deadline passed.
+    if (req->Deadline() <= now)
+    {
+      if (verbose)
+      {
+        std::cout << "Dropping service call request [" << req->HandlerUuid()
+                  << "]: its deadline passed" << std::endl;
+      }
+      this->requests.RemoveHandler(_topic, req->NodeUuid(),
+        req->HandlerUuid());
+      Metrics::Add(Metrics::Instance().Service(_topic),
+        Metrics::Counter::FAILED_REQUESTS);
+      continue;
+    }
+
+    // Mark the handler as requested.
+    req->Requested(true);
+
+    std::string data;
+    if (!req->Serialize(data))
+      continue;
+
+    auto nodeUuid = req->NodeUuid();
+    auto reqUuid = req->HandlerUuid();
+
+    // Each request picks its responder.
+    const ServiceBalancing_t policy = req->Balancing();
+    const auto &responder = responders[
+      this->dataPtr->PickResponder(_topic, responders, policy)];
+
+    if (verbose)
+    {
+      std::cout << "Found a service call responser at ["
+                << responder.Addr() << "]" << std::endl;
+    }
+
+    // Keep the response of an idempotent responder.
+    if (responder.Options().Idempotent() && !req->Batched() &&
+        !req->Streamed())
+    {
+      req->SetCacheTtl(responder.Options().CacheTtl());
+    }
+
+    const std::string wireReqType =
+      NodeSharedPrivate::WireReqType(*req, _reqType);
+    this->SendRemoteReq(responder.Addr(), responder.SocketId(), _topic,
+      nodeUuid, reqUuid, data, wireReqType, _repType,
+      this->dataPtr->srvEnvelope && responder.Envelope(), req->Deadline());
+    Metrics::Add(Metrics::Instance().Service(_topic),
+      Metrics::Counter::REQUESTS_SENT);
+
+    // Remove the handler associated to this service request. We won't
+    // receive a response because this is a oneway request.
+    if (_repType == msgs::Empty().GetTypeName())
+    {
+      this->requests.RemoveHandler(_topic, nodeUuid, reqUuid);
+      continue;
+    }
+
+    if (policy == ServiceBalancing_t::LEAST_OUTSTANDING ||
+        policy == ServiceBalancing_t::HEDGED)
+    {
+      this->dataPtr->TrackRequest(_topic, reqUuid, responder.Addr());
+    }
+
+    // Send a copy to another responder if this one is too slow. The
+    // chunks of two streams can't be told apart, so streams aren't hedged.
+    if (policy == ServiceBalancing_t::HEDGED && responders.size() > 1 &&
+        !req->Streamed())
+    {
+      HedgedRequest hedge;
+      hedge.deadline = std::chrono::steady_clock::now() +
+        this->dataPtr->HedgeDelay(_topic);
+      hedge.topic = _topic;
+      hedge.nodeUuid = nodeUuid;
+      hedge.reqUuid = reqUuid;
+      hedge.data = data;
+      hedge.reqType = _reqType;
+      hedge.repType = _repType;
+      hedge.wireReqType = wireReqType;
+      this->dataPtr->hedgedRequests.push_back(std::move(hedge));
+      hedged = true;
+    }
+  }
+
+  // The reception thread sends the copies when they are due.
+  if (hedged)
+    this->dataPtr->WakeReception();
+}
+
+//////////////////////////////////////////////////
+void NodeShared::SendRemoteReq(const std::string &_responderAddr,
+  const std::string &_responderId, const std::string &_topic,
+  const std::string &_nodeUuid, const std::string &_reqUuid,
+  const std::string &_data, const std::string &_reqType,
+  const std::string &_repType, const bool _envelope,
+  const std::chrono::steady_clock::time_point &_deadline)
+{
+  GZ_TRANSPORT_PROBE3(request__send, _topic.c_str(), _reqUuid.c_str(),
+    _data.size());
+
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  // I am still not connected to this address.
+  if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
+        _responderAddr) == this->srvConnections.end())
+  {
+    this->dataPtr->ConnectRouter(*this->dataPtr->requester,
+      _responderAddr, _responderId);
+    this->srvConnections.push_back(_responderAddr);
+    if (this->verbose)
+    {
+      std::cout << "\t* Connected to [" << _responderAddr
+                << "] for service requests" << std::endl;
+    }
+  }
+
+  try
+  {
+    zmq::message_t msg;
+
+    msg.rebuild(_responderId.size());
+    memcpy(msg.data(), _responderId.data(), _responderId.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    // Header and fields in a single frame. The strings that don't fit in
+    // the envelope use the legacy frames.
+    ServiceRequestEnvelope envelopeReq;
+    envelopeReq.serviceId =
+      NodeSharedPrivate::ServiceId(_topic, _reqType, _repType);
+    envelopeReq.sender = this->myRequesterAddress;
+    envelopeReq.dstId = this->dataPtr->responseReceiverIdStr;
+    envelopeReq.nodeUuid = _nodeUuid;
+    if (_deadline != std::chrono::steady_clock::time_point::max())
+    {
+      // Round up, so the responder doesn't see an expired request.
+      const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+        _deadline - std::chrono::steady_clock::now());
+      envelopeReq.timeout = std::max(left, std::chrono::milliseconds(1));
+    }
+    const std::size_t envelopeSize = _envelope ?
+      envelopeReq.Size(_data.size()) : 0;
+    if (envelopeSize > 0 &&
+        ReqHandlerStorage::ParseId(_reqUuid, envelopeReq.requestId))
+    {
+      msg.rebuild(envelopeSize);
+      envelopeReq.Encode(_data, static_cast<char *>(msg.data()));
+#ifdef GZ_ZMQ_POST_4_3_1
+      this->dataPtr->requester->send(msg, zmq::send_flags::none);
+#else
+      this->dataPtr->requester->send(msg, 0);
+#endif
+      return;
+    }
+
+    msg.rebuild(_topic.size());
+    memcpy(msg.data(), _topic.data(), _topic.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    msg.rebuild(this->myRequesterAddress.size());
+    memcpy(msg.data(), this->myRequesterAddress.data(),
+      this->myRequesterAddress.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    const std::string &myId = this->dataPtr->responseReceiverIdStr;
+    msg.rebuild(myId.size());
+    memcpy(msg.data(), myId.data(), myId.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    msg.rebuild(_nodeUuid.size());
+    memcpy(msg.data(), _nodeUuid.data(), _nodeUuid.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    msg.rebuild(_reqUuid.size());
+    memcpy(msg.data(), _reqUuid.data(), _reqUuid.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    msg.rebuild(_data.size());
+    memcpy(msg.data(), _data.data(), _data.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    msg.rebuild(_reqType.size());
+    memcpy(msg.data(), _reqType.data(), _reqType.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::sndmore);
+#else
+    this->dataPtr->requester->send(msg, ZMQ_SNDMORE);
+#endif
+
+    msg.rebuild(_repType.size());
+    memcpy(msg.data(), _repType.data(), _repType.size());
+#ifdef GZ_ZMQ_POST_4_3_1
+    this->dataPtr->requester->send(msg, zmq::send_flags::none);
+#else
+    this->dataPtr->requester->send(msg, 0);
+#endif
+  }
+  catch(const zmq::error_t& /*ze*/)
+  {
+    // Debug output.
+    // std::cerr << "Error connecting [" << ze.what() << "]\n";
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::SendHedgedReqs()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<HedgedRequest> due;
+  auto &hedges = this->dataPtr->hedgedRequests;
+  for (auto it = hedges.begin(); it != hedges.end();)
+  {
+    if (it->deadline <= now)
+    {
+      due.push_back(std::move(*it));
+      it = hedges.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  for (const auto &hedge : due)
+  {
+    // Nothing to do if the request was answered or abandoned.
+    auto trackIt = this->dataPtr->requestTracks.find(hedge.reqUuid);
+    if (trackIt == this->dataPtr->requestTracks.end() ||
+        trackIt->second.answered)
+    {
+      continue;
+    }
+
+    IReqHandlerPtr handler;
+    if (!this->requests.Handler(hedge.topic, hedge.nodeUuid, hedge.reqUuid,
+          handler) || handler->Deadline() <= now)
+    {
+      continue;
+    }
+
+    std::vector<ServicePublisher> responders;
+    this->dataPtr->srvDiscovery->VisitPublishers(hedge.topic,
+      [&](const ServicePublisher &_pub)
+      {
+        if (_pub.ReqTypeName() == hedge.reqType &&
+            _pub.RepTypeName() == hedge.repType)
+        {
+          responders.push_back(_pub);
+        }
+      });
+
+    // Only send the copy to a responder that doesn't have the request.
+    const std::vector<std::string> used = trackIt->second.addresses;
+    if (responders.size() <= used.size())
+      continue;
+
+    const auto &responder = responders[this->dataPtr->PickResponder(
+      hedge.topic, responders, ServiceBalancing_t::LEAST_OUTSTANDING, used)];
+    if (std::find(used.begin(), used.end(), responder.Addr()) != used.end())
+      continue;
+
+    if (this->verbose)
+    {
+      std::cout << "Hedging service call request [" << hedge.reqUuid
+                << "] to [" << responder.Addr() << "]" << std::endl;
+    }
+
+    this->SendRemoteReq(responder.Addr(), responder.SocketId(), hedge.topic,
+      hedge.nodeUuid, hedge.reqUuid, hedge.data, hedge.wireReqType,
+      hedge.repType, this->dataPtr->srvEnvelope && responder.Envelope(),
+      handler->Deadline());
+    this->dataPtr->TrackRequest(hedge.topic, hedge.reqUuid, responder.Addr());
+  }
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::CachedResponse(const std::string &_topic,
+  const ProtoMsg &_req, const std::string &_repType, std::string &_rep)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  // Most services are not cached: don't serialize their requests.
+  auto topicIt = this->dataPtr->serviceCache.find(_topic);
+  if (topicIt == this->dataPtr->serviceCache.end())
+    return false;
+
+  std::string data;
+  if (!_req.SerializeToString(&data))
+    return false;
+
+  auto &entries = topicIt->second;
+  auto range = entries.equal_range(std::hash<std::string>{}(data));
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    const ServiceCacheEntry &entry = it->second;
+    if (entry.req != data || entry.reqType != _req.GetTypeName() ||
+        entry.repType != _repType)
+    {
+      continue;
+    }
+
+    if (std::chrono::steady_clock::now() >= entry.expiration)
+    {
+      entries.erase(it);
+      if (entries.empty())
+        this->dataPtr->serviceCache.erase(topicIt);
+      return false;
+    }
+
+    _rep = entry.rep;
+    return true;
+  }
+
+  return false;
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnNewConnection(const MessagePublisher &_pub)
+{
+  GZ_TRANSPORT_PROBE3(discovery__connect, _pub.Topic().c_str(),
+    _pub.Addr().c_str(), _pub.PUuid().c_str());
+
+  std::string topic = _pub.Topic();
+  std::string addr = _pub.Addr();
+  std::string procUuid = _pub.PUuid();
+
+  if (this->verbose)
+  {
+    std::cout << "Connection callback" << std::endl;
+    std::cout << _pub;
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  this->dataPtr->AddToGraph(_pub);
+
+  // The metadata needs the process of each address, for its clock, and the
+  // reliable topics the process answering the retransmission requests. The
+  // publishers may send their metadata even if we don't, so it is always
+  // recorded.
+  {
+    std::lock_guard<std::mutex> lk(this->dataPtr->senderProcessesMutex);
+    this->dataPtr->senderProcesses[addr] = procUuid;
+  }
 
   // Check if we are interested in this topic.
   if (this->localSubscribers.HasSubscriber(topic) &&
       this->pUuid.compare(procUuid) != 0)
   {
-    // Handle security
-    this->dataPtr->SecurityOnNewConnection();
+    // With the compact header, the publications are filtered by topic ID.
+    std::vector<std::string> filters;
+    if (this->dataPtr->compactHeader)
+      filters = this->dataPtr->RegisterCompactTopic(_pub);
+    else
+      filters.push_back(this->dataPtr->TopicFilter(topic));
+
+    // High priority topics are received by their own shard, so they are
+    // never queued behind the regular topics.
+    SubscriberShard *shard = nullptr;
+    if (_pub.Options().HighPriority())
+    {
+      shard = this->dataPtr->PriorityShard(this);
+    }
+    else if (const std::size_t index = this->dataPtr->ShardIndex(topic);
+             index != 0)
+    {
+      shard = this->dataPtr->subscriberShards[index - 1].get();
+    }
+
+    // Register the new connection with the publisher. We only connect to
+    // its address once, no matter how many of its topics we subscribe to.
+    if (this->connections.AddPublisher(_pub))
+      this->dataPtr->AcquireAddress(shard, addr, _pub.MulticastGroup());
+
+    if (shard)
+    {
+      // The shard's reception thread adds the filters.
+      for (const std::string &filter : filters)
+      {
+        NodeSharedPrivate::RequestShardOp(
+          *shard, SubscriberShard::Op::SUBSCRIBE, filter);
+      }
+    }
+    else
+    {
+      std::lock_guard<std::mutex> socketLk(this->dataPtr->subscriberMutex);
+
+      // Add the new filters for the topic.
+      for (const std::string &filter : filters)
+      {
+#ifdef GZ_CPPZMQ_POST_4_7_0
+        this->dataPtr->subscriber->set(zmq::sockopt::subscribe, filter);
+#else
+        this->dataPtr->subscriber->setsockopt(ZMQ_SUBSCRIBE,
+            filter.data(), filter.size());
+#endif
+      }
+    }
+
+    if (this->verbose)
+      std::cout << "\t* Connected to [" << addr << "] for data\n";
+
+    MessagePublisher pub(_pub);
+    pub.SetPUuid(this->pUuid);
+
+    // Hack: We use this field to store the PUuid of the topic publisher.
+    pub.SetCtrl(_pub.PUuid());
+
+    // Tell the publisher whether we can decompress its messages.
+    if (!Compression::Supported(pub.Options().Compression()))
+    {
+      AdvertiseMessageOptions opts = pub.Options();
+      opts.SetCompression(Compression_t::NONE);
+      pub.SetOptions(opts);
+    }
+
+    // Read the topic from shared memory if the publisher runs on this host.
+    // This must happen before registering, so the publisher finds us in
+    // the segment.
+    if (this->dataPtr->shmEnabled)
+      this->dataPtr->AttachShmReader(topic, procUuid, this->pUuid);
+
+    // Receive the file descriptors if the publisher runs on this host.
+    if (_pub.Options().FdPassing())
+    {
+      this->dataPtr->AttachFdReader(this, topic, _pub.MsgTypeName(),
+        procUuid);
+    }
+
+    std::vector<std::string> handlerNodeUuids =
+        this->localSubscribers.NodeUuids(topic, _pub.MsgTypeName());
+    for (const std::string &nodeUuid : handlerNodeUuids)
+    {
+      pub.SetNUuid(nodeUuid);
+
+      // The publisher may skip the messages that this node would discard.
+      pub.SetSubscriberMsgsPerSec(this->dataPtr->NodeMsgsPerSec(
+        this, topic, _pub.MsgTypeName(), nodeUuid));
+      pub.SetSubscriberFilter(this->dataPtr->NodeFilter(
+        this, topic, _pub.MsgTypeName(), nodeUuid));
+
+      // The publisher may hold the messages that this node can't take yet.
+      bool conflated = false;
+      const uint64_t credits = NodeSharedPrivate::NodeCredits(this, topic,
+        _pub.MsgTypeName(), nodeUuid, conflated);
+      pub.SetSubscriberCredits(credits, conflated);
+      if (credits > 0)
+        this->dataPtr->AttachCredits(this, topic, addr, procUuid, credits);
+
+      // Send a message to the publisher notify it
+      // about all my remoteSubscribers.
+      this->dataPtr->msgDiscovery->Register(pub);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnNewDisconnection(const MessagePublisher &_pub)
+{
+  GZ_TRANSPORT_PROBE2(discovery__disconnect, _pub.Topic().c_str(),
+    _pub.PUuid().c_str());
+
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  std::string topic = _pub.Topic();
+  std::string procUuid = _pub.PUuid();
+  std::string nUuid = _pub.NUuid();
+
+  if (this->verbose)
+  {
+    std::cout << "New disconnection detected " << std::endl;
+    std::cout << "\tProcess UUID: " << procUuid << std::endl;
+  }
+
+  this->dataPtr->RemoveFromGraph(_pub);
+
+  // A remote subscriber[s] has been disconnected.
+  if (topic != "" && nUuid != "")
+  {
+    {
+      std::unique_lock<std::shared_mutex> remoteLk(
+        this->dataPtr->remoteSubscribersMutex);
+      this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nUuid);
+    }
+    this->dataPtr->InvalidateRemoteSubscribers();
+
+    MessagePublisher connection;
+    if (!this->connections.Publisher(topic, procUuid, nUuid, connection))
+      return;
+
+    // I am no longer connected.
+    this->connections.DelPublisherByNode(topic, procUuid, nUuid);
+    this->dataPtr->ReleaseConnection(connection);
+  }
+  else
+  {
+    // Note: We deliberately don't remove the list of remote subscribers
+    // for this process. Remote nodes might suffer package delays (due to WiFi
+    // or traffic load) and if we remove them, they won't be able to receive
+    // data anymore.
+
+    // The process is gone, so are its shared memory segments.
+    if (this->dataPtr->shmEnabled)
+      this->dataPtr->DetachShmReaders("", procUuid, this->pUuid);
+    this->dataPtr->DetachFdReaders("", procUuid);
+    this->dataPtr->ForgetReliable(procUuid);
+    this->dataPtr->ForgetCredits(procUuid);
+
+    std::map<std::string, std::vector<MessagePublisher>> info;
+    this->connections.PublishersByProc(procUuid, info);
+    if (info.empty())
+      return;
+
+    // Remove all the connections from the process disonnected, so we stop
+    // trying to reconnect to its address.
+    this->connections.DelPublishersByProc(procUuid);
+    for (const auto &node : info)
+    {
+      for (const MessagePublisher &connection : node.second)
+        this->dataPtr->ReleaseConnection(connection);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnNewSrvConnection(const ServicePublisher &_pub)
+{
+  GZ_TRANSPORT_PROBE2(discovery__srv_connect, _pub.Topic().c_str(),
+    _pub.Addr().c_str());
+
+  std::string topic = _pub.Topic();
+  std::string addr = _pub.Addr();
+  std::string reqType = _pub.ReqTypeName();
+  std::string repType = _pub.RepTypeName();
+
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  if (this->verbose)
+  {
+    std::cout << "Service call connection callback" << std::endl;
+    std::cout << _pub;
+  }
+
+  // I am still not connected to this address.
+  if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
+        addr) == this->srvConnections.end())
+  {
+    this->dataPtr->ConnectRouter(*this->dataPtr->requester, addr,
+      _pub.SocketId());
+    this->srvConnections.push_back(addr);
+    if (this->verbose)
+    {
+      std::cout << "\t* Connected to [" << addr
+                << "] for service requests" << std::endl;
+    }
+  }
+
+  // Check if there's a pending service request with this specific combination
+  // of request and response types.
+  IReqHandlerPtr handler;
+  if (this->requests.FirstHandler(topic, reqType, repType, handler))
+  {
+    // Request all pending service calls for this topic and req/rep types.
+    this->SendPendingRemoteReqs(topic, reqType, repType);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnNewSrvDisconnection(const ServicePublisher &_pub)
+{
+  GZ_TRANSPORT_PROBE2(discovery__srv_disconnect, _pub.Topic().c_str(),
+    _pub.Addr().c_str());
+
+  std::string addr = _pub.Addr();
+
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  // Remove the address from the list of connected addresses.
+  this->srvConnections.erase(std::remove(std::begin(this->srvConnections),
+    std::end(this->srvConnections), addr.c_str()),
+    std::end(this->srvConnections));
+
+  // The responses of the responder can't be trusted anymore.
+  this->dataPtr->InvalidateCache(_pub.Topic());
+
+  if (this->verbose)
+  {
+    std::cout << "Service call disconnection callback" << std::endl;
+    std::cout << _pub;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnNewRegistration(const MessagePublisher &_pub)
+{
+  // Discard the message if the destination PUUID is not me.
+  if (_pub.Ctrl() != this->pUuid)
+    return;
+
+  GZ_TRANSPORT_PROBE2(discovery__register, _pub.Topic().c_str(),
+    _pub.PUuid().c_str());
+
+  std::string procUuid = _pub.PUuid();
+  std::string nodeUuid = _pub.NUuid();
+
+  if (this->verbose)
+  {
+    std::cout << "Registering a new remote connection" << std::endl;
+    std::cout << "\tProc UUID: [" << procUuid << "]" << std::endl;
+    std::cout << "\tNode UUID: [" << nodeUuid << "]" << std::endl;
+  }
+
+  // Add a remote subscriber. A node registers again when its subscriptions
+  // change, so an existing entry is replaced.
+  bool added = false;
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    std::unique_lock<std::shared_mutex> remoteLk(
+      this->dataPtr->remoteSubscribersMutex);
+    added = this->remoteSubscribers.AddPublisher(_pub);
+    if (!added)
+    {
+      this->remoteSubscribers.DelPublisherByNode(_pub.Topic(), procUuid,
+        nodeUuid);
+      this->remoteSubscribers.AddPublisher(_pub);
+    }
+    this->dataPtr->InvalidateRemoteSubscribers();
+  }
+
+  // The reliability thread receives the credits of the subscriber.
+  if (_pub.SubscriberCredits() > 0)
+  {
+    this->dataPtr->remoteCredits = true;
+    std::lock_guard<std::mutex> lk(this->dataPtr->reliableMutex);
+    this->dataPtr->StartReliable(this);
+  }
+
+  // Send the latched messages of the topic to the new subscriber node.
+  if (added && this->dataPtr->latchedCount > 0)
+    this->dataPtr->QueueLatchedReplay(_pub.Topic(), nodeUuid);
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnEndRegistration(const MessagePublisher &_pub)
+{
+  // Discard the message if the destination PUUID is not me.
+  if (_pub.Ctrl() != this->pUuid)
+    return;
+
+  GZ_TRANSPORT_PROBE2(discovery__unregister, _pub.Topic().c_str(),
+    _pub.PUuid().c_str());
+
+  std::string topic = _pub.Topic();
+  std::string procUuid = _pub.PUuid();
+  std::string nodeUuid = _pub.NUuid();
+
+  if (this->verbose)
+  {
+    std::cout << "Registering the end of a remote connection" << std::endl;
+    std::cout << "\tProc UUID: " << procUuid << std::endl;
+    std::cout << "\tNode UUID: [" << nodeUuid << "]" << std::endl;
+  }
+
+  // Delete a remote subscriber.
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  std::unique_lock<std::shared_mutex> remoteLk(
+    this->dataPtr->remoteSubscribersMutex);
+  this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nodeUuid);
+  this->dataPtr->InvalidateRemoteSubscribers();
+}
+
+//////////////////////////////////////////////////
+void NodeShared::OnSubscribers()
+{
+  // Get the list of local subscribers.
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  auto pubs = this->localSubscribers.Convert(this->myAddress, this->pUuid);
+
+  // Reply to the SUBSCRIBERS_REQ with multiple SUBSCRIBERS_REP.
+  this->dataPtr->msgDiscovery->SendSubscribersReps(pubs);
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::InitializeSockets()
+{
+  try
+  {
+    // Set the hostname's ip address.
+    this->hostAddr = this->dataPtr->msgDiscovery->HostAddr();
+    this->dataPtr->responseReceiverIdStr =
+      this->responseReceiverId.ToString();
+
+    // Publisher socket listening in a random port.
+    std::string anyTcpEp = "tcp://" + this->hostAddr + ":*";
+
+    // Initialize security
+    this->dataPtr->SecurityInit();
+
+    // Optionally exchange the publications with the processes of this host
+    // through IPC (Unix domain sockets) instead of the TCP/IP stack.
+#ifndef _WIN32
+    this->dataPtr->ipcEnabled =
+      this->dataPtr->NonNegativeEnvVar("GZ_TRANSPORT_IPC", 0) > 0;
+#endif
+
+    // Kernel buffers and keepalive of the TCP sockets.
+    this->dataPtr->TuneSocket(*this->dataPtr->publisher);
+    this->dataPtr->TuneSocket(*this->dataPtr->subscriber);
+    this->dataPtr->TuneSocket(*this->dataPtr->requester);
+    this->dataPtr->TuneSocket(*this->dataPtr->responseReceiver);
+    this->dataPtr->TuneSocket(*this->dataPtr->replier);
+
+    int lingerVal = 0;
+
+    // The regular publications don't use the I/O thread of the high
+    // priority topics.
+    uint64_t affinity = this->dataPtr->regularAffinity;
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    this->dataPtr->publisher->set(zmq::sockopt::linger, lingerVal);
+    this->dataPtr->publisher->set(zmq::sockopt::affinity, affinity);
+    this->dataPtr->subscriber->set(zmq::sockopt::linger, lingerVal);
+    this->dataPtr->subscriber->set(zmq::sockopt::affinity, affinity);
+#else
+    this->dataPtr->publisher->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+    this->dataPtr->subscriber->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+    this->dataPtr->publisher->setsockopt(ZMQ_AFFINITY,
+        &affinity, sizeof(affinity));
+    this->dataPtr->subscriber->setsockopt(ZMQ_AFFINITY,
+        &affinity, sizeof(affinity));
+#endif
+
+    // Set the capacity of the buffer for receiving messages.
+    int rcvQueueVal = this->dataPtr->NonNegativeEnvVar(
+      "GZ_TRANSPORT_RCVHWM", kDefaultRcvHwm);
+
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    this->dataPtr->subscriber->set(zmq::sockopt::rcvhwm, rcvQueueVal);
+#else
+    this->dataPtr->subscriber->setsockopt(ZMQ_RCVHWM,
+          &rcvQueueVal, sizeof(rcvQueueVal));
+#endif
+
+    // The reception thread blocks until a socket is readable or we wake it
+    // up.
+    this->dataPtr->CreateWakePair("reception",
+      this->dataPtr->receptionWakeSender,
+      this->dataPtr->receptionWakeReceiver);
+
+    // Optionally shard the reception of remote topics across several
+    // subscriber sockets, each one serviced by its own thread.
+    const int receptionThreads = this->dataPtr->NonNegativeEnvVar(
+      "GZ_TRANSPORT_RECEPTION_THREADS", 1);
+    this->dataPtr->CreateSubscriberShards(
+      static_cast<std::size_t>(std::max(1, receptionThreads)), rcvQueueVal);
+
+    // Set the capacity of the buffer for sending messages.
+    int sndQueueVal = this->dataPtr->NonNegativeEnvVar(
+      "GZ_TRANSPORT_SNDHWM", kDefaultSndHwm);
+
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    this->dataPtr->publisher->set(zmq::sockopt::sndhwm, sndQueueVal);
+
+    this->dataPtr->publisher->bind(anyTcpEp.c_str());
+    this->myAddress =
+        this->dataPtr->publisher->get(zmq::sockopt::last_endpoint);
+    this->dataPtr->BindIpc(*this->dataPtr->publisher, this->myAddress);
+
+    // ResponseReceiver socket listening in a random port.
+    std::string id = this->dataPtr->responseReceiverIdStr;
+    this->dataPtr->responseReceiver->set(zmq::sockopt::routing_id, id);
+    this->dataPtr->responseReceiver->set(zmq::sockopt::linger, lingerVal);
+    this->dataPtr->responseReceiver->bind(anyTcpEp.c_str());
+    this->myRequesterAddress = this->dataPtr->responseReceiver->get(
+        zmq::sockopt::last_endpoint);
+
+    // Replier socket listening in a random port.
+    id = this->replierId.ToString();
+    this->dataPtr->replier->set(zmq::sockopt::routing_id, id);
+    int routeOn = 1;
+    this->dataPtr->replier->set(zmq::sockopt::linger, lingerVal);
+    this->dataPtr->replier->set(zmq::sockopt::router_mandatory, routeOn);
+    this->dataPtr->replier->bind(anyTcpEp.c_str());
+    this->myReplierAddress =
+        this->dataPtr->replier->get(zmq::sockopt::last_endpoint);
+
+    this->dataPtr->requester->set(zmq::sockopt::linger, lingerVal);
+    this->dataPtr->requester->set(zmq::sockopt::router_mandatory, routeOn);
+#else
+    char bindEndPoint[1024];
+    this->dataPtr->publisher->setsockopt(ZMQ_SNDHWM,
+        &sndQueueVal, sizeof(sndQueueVal));
+
+    this->dataPtr->publisher->bind(anyTcpEp.c_str());
+    size_t size = sizeof(bindEndPoint);
+    this->dataPtr->publisher->getsockopt(ZMQ_LAST_ENDPOINT,
+        &bindEndPoint, &size);
+    this->myAddress = bindEndPoint;
+    this->dataPtr->BindIpc(*this->dataPtr->publisher, this->myAddress);
+
+    // ResponseReceiver socket listening in a random port.
+    std::string id = this->dataPtr->responseReceiverIdStr;
+    this->dataPtr->responseReceiver->setsockopt(ZMQ_IDENTITY,
+        id.c_str(), id.size());
+    this->dataPtr->responseReceiver->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+    this->dataPtr->responseReceiver->bind(anyTcpEp.c_str());
+    this->dataPtr->responseReceiver->getsockopt(ZMQ_LAST_ENDPOINT,
+        &bindEndPoint, &size);
+    this->myRequesterAddress = bindEndPoint;
+
+    // Replier socket listening in a random port.
+    id = this->replierId.ToString();
+    this->dataPtr->replier->setsockopt(ZMQ_IDENTITY, id.c_str(), id.size());
+    int RouteOn = 1;
+    this->dataPtr->replier->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+    this->dataPtr->replier->setsockopt(ZMQ_ROUTER_MANDATORY,
+        &RouteOn, sizeof(RouteOn));
+    this->dataPtr->replier->bind(anyTcpEp.c_str());
+    this->dataPtr->replier->getsockopt(ZMQ_LAST_ENDPOINT, &bindEndPoint, &size);
+    this->myReplierAddress = bindEndPoint;
+
+    this->dataPtr->requester->setsockopt(ZMQ_LINGER,
+        &lingerVal, sizeof(lingerVal));
+    this->dataPtr->requester->setsockopt(ZMQ_ROUTER_MANDATORY, &RouteOn,
+      sizeof(RouteOn));
+#endif
+  }
+  catch(const zmq::error_t& ze)
+  {
+    std::cerr << "InitializeSockets() Error: " << ze.what() << std::endl;
+    std::cerr << "Gazebo Transport has not been correctly initialized"
+              << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool NodeShared::TopicPublishers(const std::string &_topic,
+                                 SrvAddresses_M &_publishers) const
+{
+  return this->dataPtr->srvDiscovery->Publishers(_topic, _publishers);
+}
+
+/////////////////////////////////////////////////
+bool NodeShared::DiscoverService(const std::string &_topic) const
+{
+  return this->dataPtr->srvDiscovery->Discover(_topic);
+}
+
+/////////////////////////////////////////////////
+bool NodeShared::AdvertisePublisher(const ServicePublisher &_publisher)
+{
+  {
+    std::lock_guard<std::recursive_mutex> lk(this->mutex);
+    this->dataPtr->RegisterEnvelopeService(_publisher);
+  }
+  this->dataPtr->SetServiceExecution(_publisher.Topic(), _publisher.Options(),
+    _publisher.NUuid());
+  return this->dataPtr->srvDiscovery->Advertise(_publisher);
+}
+
+/////////////////////////////////////////////////
+int NodeShared::RcvHwm()
+{
+  int rcvHwm;
+  std::lock_guard<std::mutex> lk(this->dataPtr->subscriberMutex);
+  try
+  {
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    rcvHwm = this->dataPtr->subscriber->get(zmq::sockopt::rcvhwm);
+#else
+    size_t rcvHwmSize = sizeof(rcvHwm);
+    this->dataPtr->subscriber->getsockopt(ZMQ_RCVHWM, &rcvHwm, &rcvHwmSize);
+#endif
+  }
+  catch (zmq::error_t &_e)
+  {
+    return -1;
+  }
+
+  return rcvHwm;
+}
+
+/////////////////////////////////////////////////
+int NodeShared::SndHwm()
+{
+  int sndHwm;
+  std::lock_guard<std::mutex> lk(this->dataPtr->publisherMutex);
+  try
+  {
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    sndHwm = this->dataPtr->publisher->get(zmq::sockopt::sndhwm);
+#else
+    size_t sndHwmSize = sizeof(sndHwm);
+    this->dataPtr->publisher->getsockopt(ZMQ_SNDHWM, &sndHwm, &sndHwmSize);
+#endif
+  }
+  catch (zmq::error_t &_e)
+  {
+    return -1;
+  }
+
+  return sndHwm;
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::HandlerWrapper::HasSubscriber(
+    const std::string &_fullyQualifiedTopic,
+    const std::string &_msgType) const
+{
+  std::shared_ptr<ISubscriptionHandler> normalSubscriberPtr;
+  std::shared_ptr<RawSubscriptionHandler> rawSubscriberPtr;
+
+  std::shared_lock<std::shared_mutex> lk(this->mutex);
+  return this->normal.FirstHandler(
+            _fullyQualifiedTopic, _msgType, normalSubscriberPtr)
+         || this->raw.FirstHandler(
+            _fullyQualifiedTopic, _msgType, rawSubscriberPtr);
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::HandlerWrapper::HasSubscriber(
+    const std::string &_fullyQualifiedTopic) const
+{
+  std::shared_lock<std::shared_mutex> lk(this->mutex);
+  return this->normal.HasHandlersForTopic(_fullyQualifiedTopic)
+      || this->raw.HasHandlersForTopic(_fullyQualifiedTopic);
+}
+
+//////////////////////////////////////////////////
+template <typename HandlerT>
+static void AppendNodeUuids(const HandlerStorage<HandlerT> &_handlerStorage,
+                            const std::string &_fullyQualifiedTopic,
+                            const std::string &_msgTypeName,
+                            std::vector<std::string> &_uuids)
+{
+  using HandlerTPtr = std::shared_ptr<HandlerT>;
+  std::map<std::string, std::map<std::string, HandlerTPtr>> handlers;
+
+  _handlerStorage.Handlers(_fullyQualifiedTopic, handlers);
+  for (const auto &collection : handlers)
+  {
+    for (const auto &collectionEntry : collection.second)
+    {
+      const HandlerTPtr &handler = collectionEntry.second;
+      const std::string &handlerMsgType = handler->TypeName();
+      if (handlerMsgType == _msgTypeName
+          || handlerMsgType == kGenericMessageType)
+      {
+        _uuids.push_back(handler->NodeUuid());
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> NodeShared::HandlerWrapper::NodeUuids(
+    const std::string &_fullyQualifiedTopic,
+    const std::string &_msgTypeName) const
+{
+  std::vector<std::string> uuids;
+  std::shared_lock<std::shared_mutex> lk(this->mutex);
+  AppendNodeUuids(this->normal, _fullyQualifiedTopic, _msgTypeName, uuids);
+  AppendNodeUuids(this->raw, _fullyQualifiedTopic, _msgTypeName, uuids);
+
+  return uuids;
+}
+
+//////////////////////////////////////////////////
+void NodeShared::HandlerWrapper::AddHandler(
+    const std::string &_fullyQualifiedTopic,
+    const std::string &_nUuid,
+    const ISubscriptionHandlerPtr &_handler)
+{
+  std::unique_lock<std::shared_mutex> lk(this->mutex);
+  this->normal.AddHandler(_fullyQualifiedTopic, _nUuid, _handler);
+  this->RefreshSnapshot(_fullyQualifiedTopic);
+}
+
+//////////////////////////////////////////////////
+void NodeShared::HandlerWrapper::AddHandler(
+    const std::string &_fullyQualifiedTopic,
+    const std::string &_nUuid,
+    const RawSubscriptionHandlerPtr &_handler)
+{
+  std::unique_lock<std::shared_mutex> lk(this->mutex);
+  this->raw.AddHandler(_fullyQualifiedTopic, _nUuid, _handler);
+  this->RefreshSnapshot(_fullyQualifiedTopic);
+}
+
+//////////////////////////////////////////////////
+NodeShared::TopicHandlersPtr NodeShared::HandlerWrapper::Snapshot(
+    const std::string &_fullyQualifiedTopic) const
+{
+  std::shared_lock<std::shared_mutex> lk(this->mutex);
+  auto it = this->snapshots.find(_fullyQualifiedTopic);
+  if (it == this->snapshots.end())
+    return nullptr;
+  return it->second;
+}
+
+//////////////////////////////////////////////////
+template <typename HandlerT>
+static void FlattenHandlers(const HandlerStorage<HandlerT> &_handlerStorage,
+                            const std::string &_fullyQualifiedTopic,
+                            std::vector<std::shared_ptr<HandlerT>> &_handlers)
+{
+  const auto &all = _handlerStorage.AllHandlers();
+  auto it = all.find(_fullyQualifiedTopic);
+  if (it == all.end())
+    return;
+
+  for (const auto &node : it->second)
+  {
+    for (const auto &handler : node.second)
+      _handlers.push_back(handler.second);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::HandlerWrapper::RefreshSnapshot(
+    const std::string &_fullyQualifiedTopic)
+{
+  auto snapshot = std::make_shared<TopicHandlers>();
+  snapshot->version = ++this->snapshotVersion;
+  FlattenHandlers(this->normal, _fullyQualifiedTopic, snapshot->normal);
+  FlattenHandlers(this->raw, _fullyQualifiedTopic, snapshot->raw);
+
+  if (snapshot->normal.empty() && snapshot->raw.empty())
+    this->snapshots.erase(_fullyQualifiedTopic);
+  else
+    this->snapshots[_fullyQualifiedTopic] = std::move(snapshot);
+}
+
+//////////////////////////////////////////////////
+template <typename HandlerT>
+static void DetachHandlers(const HandlerStorage<HandlerT> &_handlerStorage,
+                           const std::string &_fullyQualifiedTopic,
+                           const std::string &_nUuid)
+{
+  const auto &all = _handlerStorage.AllHandlers();
+  auto it = all.find(_fullyQualifiedTopic);
+  if (it == all.end())
+    return;
+
+  auto node = it->second.find(_nUuid);
+  if (node == it->second.end())
+    return;
+
+  for (const auto &handler : node->second)
+    handler.second->Detach();
+}
+
+//////////////////////////////////////////////////
+bool NodeShared::HandlerWrapper::RemoveHandlersForNode(
+    const std::string &_fullyQualifiedTopic,
+    const std::string &_nUuid)
+{
+  bool removed = false;
+  std::unique_lock<std::shared_mutex> lk(this->mutex);
+
+  // The publications already queued or dispatched for these handlers
+  // check the flag, so they don't need to be searched.
+  DetachHandlers(this->normal, _fullyQualifiedTopic, _nUuid);
+  DetachHandlers(this->raw, _fullyQualifiedTopic, _nUuid);
+
+  removed |= this->normal.RemoveHandlersForNode(_fullyQualifiedTopic, _nUuid);
+  removed |= this->raw.RemoveHandlersForNode(_fullyQualifiedTopic, _nUuid);
+  if (removed)
+    this->RefreshSnapshot(_fullyQualifiedTopic);
+
+  return removed;
+}
+
+//////////////////////////////////////////////////
+std::vector<MessagePublisher> NodeShared::HandlerWrapper::Convert(
+    const std::string &_addr, const std::string &_pUuid)
+{
+  std::vector<MessagePublisher> res;
+  std::shared_lock<std::shared_mutex> lk(this->mutex);
+
+  for (const auto &[topic, handlerCollection] : this->normal.AllHandlers())
+  {
+    for (const auto &[nUuid, handlerNode] : handlerCollection)
+    {
+      for (const auto &[hUuid, handler] : handlerNode)
+      {
+        res.push_back(MessagePublisher(topic, _addr, "", _pUuid, nUuid,
+          handler->TypeName(), AdvertiseMessageOptions()));
+      }
+    }
+  }
+
+  for (const auto &[topic, handlerCollection] : this->raw.AllHandlers())
+  {
+    for (const auto &[nUuid, handlerNode] : handlerCollection)
+    {
+      for (const auto &[hUuid, handler] : handlerNode)
+      {
+        res.push_back(MessagePublisher(topic, _addr, "", _pUuid, nUuid,
+          handler->TypeName(), AdvertiseMessageOptions()));
+      }
+    }
+  }
+
+  return res;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::SecurityOnNewConnection()
+{
+  // The credentials are options of the socket, used by every connection
+  // made after they are set, so they are set once.
+  // \todo(anyone): This will cause the subscriber to connect only to secure
+  // connections. Would be nice if the subscriber could still connect to
+  // unsecure connections. This might require an unsecure and secure
+  // subscriber.
+  // See issue #74
+  if (this->subscriberSecured)
+    return;
+
+  this->SecureClient(*this->subscriber);
+  this->subscriberSecured = true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::SecureServer(zmq::socket_t &_socket)
+{
+  std::string first, second;
+
+  // CURVE: a peer holding the shared key pair completes the handshake and
+  // is trusted, without a ZAP request.
+  if (curveKeys(first, second))
+  {
+    const int asCurveServer = 1;
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    _socket.set(zmq::sockopt::curve_server, asCurveServer);
+    _socket.set(zmq::sockopt::curve_secretkey, second);
+#else
+    _socket.setsockopt(ZMQ_CURVE_SERVER, &asCurveServer,
+        sizeof(asCurveServer));
+    _socket.setsockopt(ZMQ_CURVE_SECRETKEY, second.c_str(),
+        second.size() + 1);
+#endif
+    return;
+  }
+
+  // PLAIN: the access control thread checks the credentials.
+  if (userPass(first, second))
+  {
+    int asPlainSecurityServer = static_cast<int>(
+        ZmqPlainSecurityServerOptions::ZMQ_PLAIN_SECURITY_SERVER_ENABLED);
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    _socket.set(zmq::sockopt::plain_server, asPlainSecurityServer);
+    _socket.set(zmq::sockopt::zap_domain, kGzAuthDomain);
+#else
+    _socket.setsockopt(ZMQ_PLAIN_SERVER,
+        &asPlainSecurityServer, sizeof(asPlainSecurityServer));
+    _socket.setsockopt(ZMQ_ZAP_DOMAIN, kGzAuthDomain,
+        std::strlen(kGzAuthDomain));
+#endif
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::SecureClient(zmq::socket_t &_socket)
+{
+  std::string first, second;
+  if (curveKeys(first, second))
+  {
+    // The publishers use the same key pair, so their public key is ours.
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    _socket.set(zmq::sockopt::curve_serverkey, first);
+    _socket.set(zmq::sockopt::curve_publickey, first);
+    _socket.set(zmq::sockopt::curve_secretkey, second);
+#else
+    _socket.setsockopt(ZMQ_CURVE_SERVERKEY, first.c_str(), first.size() + 1);
+    _socket.setsockopt(ZMQ_CURVE_PUBLICKEY, first.c_str(), first.size() + 1);
+    _socket.setsockopt(ZMQ_CURVE_SECRETKEY, second.c_str(),
+        second.size() + 1);
+#endif
+    return;
+  }
+
+  if (userPass(first, second))
+  {
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    _socket.set(zmq::sockopt::plain_username, first);
+    _socket.set(zmq::sockopt::plain_password, second);
+#else
+    _socket.setsockopt(ZMQ_PLAIN_USERNAME, first.c_str(), first.size());
+    _socket.setsockopt(ZMQ_PLAIN_PASSWORD, second.c_str(), second.size());
+#endif
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::SecurityInit()
+{
+  std::string publicKey, secretKey;
+  const bool curve = curveKeys(publicKey, secretKey);
+  if (!curve && (std::getenv("GZ_TRANSPORT_CURVE_PUBLIC_KEY") ||
+                 std::getenv("GZ_TRANSPORT_CURVE_SECRET_KEY")))
+  {
+    std::cerr << "GZ_TRANSPORT_CURVE_PUBLIC_KEY and "
+              << "GZ_TRANSPORT_CURVE_SECRET_KEY must both be set to Z85 "
+              << "encoded keys of 40 characters. CURVE security is disabled"
+              << std::endl;
+  }
+
+  // Check if a username and password has been set. If so, then
+  // setup a PLAIN authentication server. CURVE doesn't need one.
+  std::string user, pass;
+  if (!curve && userPass(user, pass))
+  {
+    // Create the access control thread. It blocks until a request comes or
+    // the destructor wakes it up.
+    this->CreateWakePair("access_control", this->accessControlWakeSender,
+      this->accessControlWakeReceiver);
+    this->accessControlThread = std::thread(
+        &NodeSharedPrivate::AccessControlHandler, this);
+  }
+
+  this->SecureServer(*this->publisher);
+}
+
+//////////////////////////////////////////////////
+// Access control handler for plain security.
+// This function is designed to be run in a thread.
+void NodeSharedPrivate::AccessControlHandler()
+{
+  setupThread("ACCESS_CONTROL", "gz-access");
+
+  zmq::socket_t *sock = new zmq::socket_t(*this->context, ZMQ_REP);
+
+  try
+  {
+    // Bind to the zap address
+    sock->bind("inproc://zeromq.zap.01");
+
+    // Get the username and password
+    std::string user, pass;
+    if (!userPass(user, pass))
+    {
+      std::cerr << "Username and password not set. "
+                << "Authentication is disabled\n";
+      sock->close();
+      delete sock;
+      return;
+    }
+
+    std::string sequence;
+    std::string domain;
+    std::string address;
+    std::string routingId;
+    std::string mechanism;
+    std::string givenUsername;
+    std::string givenPassword;
+    std::string version;
+
+    zmq::pollitem_t items[] =
+    {
+      {static_cast<void*>(*sock), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*this->accessControlWakeReceiver), 0, ZMQ_POLLIN,
+        0},
+    };
+
+    // Process. There is no timeout, the destructor wakes us up.
+    while (!this->exit)
+    {
+      try
+      {
+        zmq::poll(&items[0], sizeof(items) / sizeof(items[0]),
+            std::chrono::milliseconds(-1));
+      }
+      catch(...)
+      {
+        continue;
+      }
+
+      if (items[0].revents & ZMQ_POLLIN)
+      {
+        // Get the version.
+        version = receiveHelper(*sock);
+        if (version.empty())
+          break;
+
+        // Get remaining data
+        sequence = receiveHelper(*sock);
+        domain = receiveHelper(*sock);
+        address = receiveHelper(*sock);
+        routingId = receiveHelper(*sock);
+        mechanism = receiveHelper(*sock);
+        givenUsername = receiveHelper(*sock);
+        givenPassword = receiveHelper(*sock);
+
+        // eliminate unused variable warning when debug statements are commented
+        (void)routingId;
+
+        // Debug statements
+        // std::cout << "Version[" << version << "]\n";
+        // std::cout << "Sequence[" << sequence << "]\n";
+        // std::cout << "Domain[" << domain << "]\n";
+        // std::cout << "Address[" << address << "]\n";
+        // std::cout << "Routing Id[" << routingId << "]\n";
+        // std::cout << "Mechanism[" << mechanism << "]\n";
+        // std::cout << "Username[" << givenUsername << "] [" << user << "]\n";
+        // std::cout << "Pass[" << givenPassword << "] [" << pass << "]\n";
+
+        // Check that we received some kind of address. This could be used
+        // in the future to only accept connections from specific addresses.
+        if (address.empty())
+        {
+          sendAuthErrorHelper(*sock, "Invalid address");
+          continue;
+        }
+
+        // Check the version
+        if (version != "1.0")
+        {
+          sendAuthErrorHelper(*sock, "Invalid version");
+          continue;
+        }
+
+        // Check the mechanism
+        if (mechanism != "PLAIN")
+        {
+          sendAuthErrorHelper(*sock, "Invalid mechanism");
+          continue;
+        }
+
+        // Check the domain
+        if (std::strcmp(domain.c_str(), kGzAuthDomain) != 0)
+        {
+          sendAuthErrorHelper(*sock, "Invalid domain");
+          continue;
+        }
+
+#ifdef GZ_ZMQ_POST_4_3_1
+        sendHelper(*sock, version, zmq::send_flags::sndmore);
+        sendHelper(*sock, sequence, zmq::send_flags::sndmore);
+#else
+        sendHelper(*sock, version, ZMQ_SNDMORE);
+        sendHelper(*sock, sequence, ZMQ_SNDMORE);
+#endif
+
+        // Check the username and password
+        if (givenUsername == user && givenPassword == pass)
+        {
+#ifdef GZ_ZMQ_POST_4_3_1
+          sendHelper(*sock, "200", zmq::send_flags::sndmore);
+          sendHelper(*sock, "OK", zmq::send_flags::sndmore);
+          sendHelper(*sock, "anonymous", zmq::send_flags::sndmore);
+          sendHelper(*sock, "", zmq::send_flags::none);
+#else
+          sendHelper(*sock, "200", ZMQ_SNDMORE);
+          sendHelper(*sock, "OK", ZMQ_SNDMORE);
+          sendHelper(*sock, "anonymous", ZMQ_SNDMORE);
+          sendHelper(*sock, "", 0);
+#endif
+        }
+        else
+        {
+          sendAuthErrorHelper(*sock, "Invalid username or password");
+        }
+      }
+    }
+  }
+  catch (...)
+  {
+    // This catch can be triggered when ctrl-c is pressed and the context is
+    // deleted. Capture this case, and quit gracefully.
+  }
+
+  sock->close();
+  delete sock;
+}
+
+/////////////////////////////////////////////////
+void NodeSharedPrivate::PublishThread(PublicationLane *_lane)
+{
+  if (_lane == this->pubLane.get())
+    setupThread("PUBLISH", "gz-publish");
+  else
+    setupThread("PRIORITY", "gz-priority-tx");
+
+  // Loop until exits
+  while (!this->exit)
+  {
+    std::unique_ptr<PublishMsgDetails> msgDetails = nullptr;
+
+    // Acquire the next message to be published. This blocks while the
+    // queue is empty and returns false on exit.
+    if (!_lane->queue.Pop(msgDetails, this->exit))
+      break;
+
+    this->ProcessPublication(*_lane, msgDetails);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ProcessPublication(const PublicationLane &_lane,
+    std::unique_ptr<PublishMsgDetails> &_details)
+{
+  std::unique_ptr<PublishMsgDetails> msgDetails = std::move(_details);
+  if (ReleaseBound(*msgDetails))
+    return;
+
+  // Time spent in the queue, seen by the publisher.
+  if (msgDetails->counters)
+  {
+    const uint64_t wait = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - msgDetails->queued).count());
+    PublisherCounters &counters = *msgDetails->counters;
+    ++counters.queued;
+    counters.queueWaitNs += wait;
+    PublisherCounters::UpdateMax(counters.maxQueueWaitNs, wait);
+  }
+
+  // The high priority topics don't wait behind the regular callbacks
+  // queued in the dispatcher.
+  if (!this->dispatcher || _lane.priority)
+  {
+    DispatchPublication(*msgDetails);
+    return;
+  }
+
+  std::shared_ptr<PublishMsgDetails> details = std::move(msgDetails);
+  if (this->dispatchOrder == DispatchOrder::TOPIC)
+  {
+    this->dispatcher->Post(details->info.Topic(), [details]()
+    {
+      DispatchPublication(*details);
+    });
+    return;
+  }
+
+  // One task per handler, ordered per handler.
+  if (!details->handlers)
+    return;
+
+  if (details->runLocal)
+  {
+    for (const auto &handler : details->handlers->normal)
+    {
+      if (!details->Receives(handler))
+        continue;
+      this->dispatcher->Post(handler->HandlerUuid(), [details, handler]()
+      {
+        RunLocalHandler(*details, handler);
+      });
+    }
+  }
+
+  if (details->runRaw)
+  {
+    for (const auto &handler : details->handlers->raw)
+    {
+      if (!details->Receives(handler))
+        continue;
+      this->dispatcher->Post(handler->HandlerUuid(), [details, handler]()
+      {
+        RunRawHandler(*details, handler);
+      });
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::PostQueued(const ISubscriptionHandlerPtr &_handler,
+    const std::string &_data, const MessageInfo &_info)
+{
+  bool dropped = false;
+  const bool schedule = _handler->Enqueue(_data, _info, this->exit, dropped);
+  if (dropped)
+    this->CountDroppedMsgs(_info, 1u);
+
+  // A delivery is already scheduled if the queue was not empty.
+  if (!schedule)
+    return;
+
+  this->PostQueuedTask(*_handler, [_handler]()
+  {
+    std::string data;
+    MessageInfo info;
+    while (_handler->Alive() && _handler->Dequeue(data, info))
+    {
+      const std::shared_ptr<const ProtoMsg> msg =
+        _handler->CreateMsg(data, info.Type());
+      if (msg)
+      {
+        CallbackProfiler::Scope profile(_handler, info.Topic());
+        _handler->RunLocalCallback(*msg, info);
+      }
+    }
+  });
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::PostQueued(
+    const RawSubscriptionHandlerPtr &_handler, const std::string &_data,
+    const MessageInfo &_info)
+{
+  bool dropped = false;
+  const bool schedule = _handler->Enqueue(_data, _info, this->exit, dropped);
+  if (dropped)
+    this->CountDroppedMsgs(_info, 1u);
+
+  // A delivery is already scheduled if the queue was not empty.
+  if (!schedule)
+    return;
+
+  this->PostQueuedTask(*_handler, [_handler]()
+  {
+    std::string data;
+    MessageInfo info;
+    while (_handler->Alive() && _handler->Dequeue(data, info))
+    {
+      CallbackProfiler::Scope profile(_handler, info.Topic());
+      _handler->RunRawCallback(data.c_str(), data.size(), info);
+    }
+  });
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::PostQueuedTask(
+    const SubscriptionHandlerBase &_handler, std::function<void()> _task)
+{
+  auto executor = this->ExecutorOf(_handler.NodeUuid(),
+    _handler.CallbackGroup());
+  if (executor)
+  {
+    executor->Post(_handler.HandlerUuid(), std::move(_task));
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(this->queueMutex);
+  if (this->exit)
+    return;
+
+  // The callbacks of conflated and queued subscriptions run in their own
+  // workers, so the reception threads never wait for them.
+  if (!this->queueExecutor)
+  {
+    const std::size_t workers =
+      this->dispatcher ? this->dispatcher->NumThreads() : 1u;
+    this->queueExecutor.reset(
+      new DispatchExecutor(static_cast<unsigned int>(workers),
+        []() { setupThread("PUBLISH", "gz-queue"); }));
+  }
+
+  this->queueExecutor->Post(_handler.HandlerUuid(), std::move(_task));
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RegisterSpinQueue(const std::string &_nUuid,
+    std::shared_ptr<SpinQueue> _queue)
+{
+  std::unique_lock<std::shared_mutex> lk(this->executorsMutex);
+  if (this->spinQueues.emplace(_nUuid, std::move(_queue)).second)
+    ++this->spinQueueCount;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::UnregisterSpinQueue(const std::string &_nUuid)
+{
+  std::unique_lock<std::shared_mutex> lk(this->executorsMutex);
+  if (this->spinQueues.erase(_nUuid) > 0)
+    --this->spinQueueCount;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::AddCallbackGroup(const std::string &_nUuid,
+    const std::string &_name, const CallbackGroupOptions &_opts)
+{
+  const std::string key = _nUuid + "/" + _name;
+  {
+    std::shared_lock<std::shared_mutex> lk(this->executorsMutex);
+    if (this->callbackGroups.find(key) != this->callbackGroups.end())
+      return false;
+  }
+
+  // Start the threads without blocking the callbacks of the other nodes.
+  auto group = std::make_shared<CallbackGroupExecutor>(_name, _opts);
+
+  std::unique_lock<std::shared_mutex> lk(this->executorsMutex);
+  if (!this->callbackGroups.emplace(key, std::move(group)).second)
+    return false;
+  ++this->callbackGroupCount;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RemoveCallbackGroups(const std::string &_nUuid)
+{
+  // The threads are joined once the lock is released.
+  std::vector<std::shared_ptr<CallbackGroupExecutor>> removed;
+  {
+    const std::string prefix = _nUuid + "/";
+    std::unique_lock<std::shared_mutex> lk(this->executorsMutex);
+    for (auto it = this->callbackGroups.begin();
+         it != this->callbackGroups.end();)
+    {
+      if (it->first.compare(0, prefix.size(), prefix) != 0)
+      {
+        ++it;
+        continue;
+      }
+
+      removed.push_back(std::move(it->second));
+      it = this->callbackGroups.erase(it);
+      --this->callbackGroupCount;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<CallbackExecutor> NodeSharedPrivate::ExecutorOf(
+    const std::string &_nUuid, const std::string &_group) const
+{
+  if (this->spinQueueCount.load(std::memory_order_relaxed) == 0 &&
+      (_group.empty() ||
+       this->callbackGroupCount.load(std::memory_order_relaxed) == 0))
+  {
+    return nullptr;
+  }
+
+  std::shared_lock<std::shared_mutex> lk(this->executorsMutex);
+
+  // The nodes in spin mode run all their callbacks.
+  auto spin = this->spinQueues.find(_nUuid);
+  if (spin != this->spinQueues.end())
+    return spin->second;
+
+  if (_group.empty())
+    return nullptr;
+
+  auto group = this->callbackGroups.find(_nUuid + "/" + _group);
+  if (group == this->callbackGroups.end())
+    return nullptr;
+  return group->second;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::PostExecutorHandlers(PublishMsgDetails &_details)
+{
+  if (this->spinQueueCount.load(std::memory_order_relaxed) == 0 &&
+      this->callbackGroupCount.load(std::memory_order_relaxed) == 0)
+  {
+    return false;
+  }
+
+  // The callbacks share a copy of the publication, without the bound of
+  // the publisher: they don't go through the publication queue.
+  std::shared_ptr<PublishMsgDetails> details;
+  auto share = [&_details, &details]()
+  {
+    if (!details)
+    {
+      details = std::make_shared<PublishMsgDetails>();
+      details->sharedBuffer = _details.sharedBuffer;
+      details->msgCopy = _details.msgCopy;
+      details->msgSize = _details.msgSize;
+      details->info = _details.info;
+      details->publisherNodeUUID = _details.publisherNodeUUID;
+      details->queued = _details.queued;
+    }
+    return details;
+  };
+
+  if (!_details.handlers)
+    return false;
+
+  // The handlers left to the shared threads.
+  bool posted = false;
+  auto remaining = std::make_shared<NodeShared::TopicHandlers>();
+  remaining->version = _details.handlers->version;
+
+  if (_details.runLocal)
+  {
+    for (const ISubscriptionHandlerPtr &handler : _details.handlers->normal)
+    {
+      if (!_details.Receives(handler))
+        continue;
+
+      auto executor = this->ExecutorOf(handler->NodeUuid(),
+        handler->CallbackGroup());
+      if (!executor)
+      {
+        remaining->normal.push_back(handler);
+        continue;
+      }
+
+      executor->Post(handler->HandlerUuid(), [details = share(), handler]()
+      {
+        RunLocalHandler(*details, handler);
+      });
+      posted = true;
+    }
+  }
+
+  if (_details.runRaw)
+  {
+    for (const RawSubscriptionHandlerPtr &handler : _details.handlers->raw)
+    {
+      if (!_details.Receives(handler))
+        continue;
+
+      auto executor = this->ExecutorOf(handler->NodeUuid(),
+        handler->CallbackGroup());
+      if (!executor)
+      {
+        remaining->raw.push_back(handler);
+        continue;
+      }
+
+      executor->Post(handler->HandlerUuid(), [details = share(), handler]()
+      {
+        RunRawHandler(*details, handler);
+      });
+      posted = true;
+    }
+  }
+
+  if (!posted)
+    return false;
+
+  if (remaining->normal.empty() && remaining->raw.empty())
+    _details.handlers = nullptr;
+  else
+    _details.handlers = std::move(remaining);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::SetServiceExecution(const std::string &_topic,
+    const AdvertiseServiceOptions &_opts, const std::string &_nUuid)
+{
+  std::shared_ptr<CallbackExecutor> executor =
+    this->ExecutorOf(_nUuid, _opts.CallbackGroup());
+
+  std::lock_guard<std::mutex> lk(this->serviceMutex);
+  if (_opts.Concurrency() == 0 && !executor)
+  {
+    this->serviceExecutions.erase(_topic);
+    return;
+  }
+
+  auto &execution = this->serviceExecutions[_topic];
+  execution.concurrency = _opts.Concurrency();
+  execution.maxPending = _opts.MaxPending();
+  execution.executor = std::move(executor);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RemoveServiceExecution(const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lk(this->serviceMutex);
+  this->serviceExecutions.erase(_topic);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CacheResponse(const std::string &_topic,
+    const IReqHandler &_handler, const std::string &_rep)
+{
+  ServiceCacheEntry entry;
+  if (!_handler.Serialize(entry.req))
+    return;
+
+  entry.reqType = _handler.ReqTypeName();
+  entry.repType = _handler.RepTypeName();
+  entry.rep = _rep;
+  const auto now = std::chrono::steady_clock::now();
+  entry.expiration = now + _handler.CacheTtl();
+
+  const std::size_t hash = std::hash<std::string>{}(entry.req);
+  auto &entries = this->serviceCache[_topic];
+
+  // Replace the previous response of the same request.
+  auto range = entries.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (it->second.req == entry.req && it->second.reqType == entry.reqType &&
+        it->second.repType == entry.repType)
+    {
+      entries.erase(it);
+      break;
+    }
+  }
+
+  // Make room, first dropping the expired responses.
+  if (entries.size() >= kMaxCachedResponses)
+  {
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+      if (now >= it->second.expiration)
+        it = entries.erase(it);
+      else
+        ++it;
+    }
+    if (entries.size() >= kMaxCachedResponses)
+      entries.erase(entries.begin());
+  }
+
+  entries.emplace(hash, std::move(entry));
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::InvalidateCache(const std::string &_topic)
+{
+  this->serviceCache.erase(_topic);
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::PostServiceCall(const std::string &_topic,
+    std::function<void()> _call, bool &_accepted)
+{
+  _accepted = true;
+
+  std::lock_guard<std::mutex> lk(this->serviceMutex);
+  auto it = this->serviceExecutions.find(_topic);
+  if (it == this->serviceExecutions.end())
+    return false;
+
+  if (this->exit)
+  {
+    _accepted = false;
+    return true;
+  }
+
+  auto &execution = it->second;
+  if (execution.executor)
+  {
+    execution.executor->Post(_topic, std::move(_call));
+    return true;
+  }
+
+  if (execution.maxPending > 0 &&
+      execution.pending.size() >= execution.maxPending)
+  {
+    _accepted = false;
+    return true;
+  }
+
+  execution.pending.push_back(std::move(_call));
+
+  // Start another worker if the service is below its concurrency. Each
+  // worker keeps executing requests until none are left.
+  if (execution.running < execution.concurrency)
+  {
+    if (!this->serviceExecutor)
+    {
+      this->serviceExecutor.reset(
+        new DispatchExecutor(this->serviceThreads,
+          []() { setupThread("SERVICE", "gz-service"); }));
+    }
+
+    const std::string strand =
+      _topic + "#" + std::to_string(execution.running);
+    ++execution.running;
+    this->serviceExecutor->Post(strand, [this, _topic]()
+    {
+      this->RunServiceCalls(_topic);
+    });
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunServiceCalls(const std::string &_topic)
+{
+  for (;;)
+  {
+    std::function<void()> call;
+    {
+      std::lock_guard<std::mutex> lk(this->serviceMutex);
+      auto it = this->serviceExecutions.find(_topic);
+      if (it == this->serviceExecutions.end())
+        return;
+
+      auto &execution = it->second;
+      if (this->exit || execution.pending.empty())
+      {
+        --execution.running;
+        return;
+      }
+
+      call = std::move(execution.pending.front());
+      execution.pending.pop_front();
+    }
+
+    call();
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::QueueServiceReply(ServiceReply &&_reply)
+{
+  std::lock_guard<std::mutex> lk(this->replyMutex);
+  const bool wasEmpty = this->pendingReplies.empty();
+  this->pendingReplies.push_back(std::move(_reply));
+
+  // The reception thread is already going to send the previous ones.
+  if (wasEmpty)
+    Wake(*this->receptionWakeSender);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::WakeReception()
+{
+  std::lock_guard<std::mutex> lk(this->replyMutex);
+  Wake(*this->receptionWakeSender);
+}
+
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::WireReqType(const IReqHandler &_handler,
+    const std::string &_reqType)
+{
+  if (_handler.Batched())
+    return kBatchReqTypePrefix + _reqType;
+  if (_handler.Streamed())
+    return kStreamReqTypePrefix + _reqType;
+  return _reqType;
+}
+
+//////////////////////////////////////////////////
+ServiceCallKind NodeSharedPrivate::StripReqTypePrefix(std::string &_reqType)
+{
+  if (_reqType.compare(0, kBatchReqTypePrefix.size(),
+        kBatchReqTypePrefix) == 0)
+  {
+    _reqType.erase(0, kBatchReqTypePrefix.size());
+    return ServiceCallKind::BATCH;
+  }
+
+  if (_reqType.compare(0, kStreamReqTypePrefix.size(),
+        kStreamReqTypePrefix) == 0)
+  {
+    _reqType.erase(0, kStreamReqTypePrefix.size());
+    return ServiceCallKind::STREAM;
+  }
+
+  return ServiceCallKind::SINGLE;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::RunServiceCall(const std::string &_topic,
+    IRepHandler &_handler, const ServiceCallKind _kind,
+    const std::string &_req, std::string &_rep,
+    const std::function<bool(const std::string &)> &_emit)
+{
+  Metrics::Entry *metrics = Metrics::Instance().Service(_topic);
+  const auto start = metrics ? std::chrono::steady_clock::now() :
+    std::chrono::steady_clock::time_point();
+
+  bool result;
+  switch (_kind)
+  {
+    case ServiceCallKind::BATCH:
+      result = RunBatch(_handler, _req, _rep);
+      break;
+    case ServiceCallKind::STREAM:
+      _rep.clear();
+      result = _handler.RunStreamCallback(_req, _emit);
+      break;
+    case ServiceCallKind::SINGLE:
+    default:
+      result = _handler.RunCallback(_req, _rep);
+      break;
+  }
+
+  if (metrics)
+  {
+    Metrics::Add(metrics, Metrics::Counter::REQUESTS_SERVED);
+    Metrics::Add(metrics, Metrics::Counter::SERVE_NS,
+      static_cast<uint64_t>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start).count()));
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::RunBatch(IRepHandler &_handler,
+    const std::string &_reqs, std::string &_reps)
+{
+  std::vector<std::string> reqs;
+  if (!splitSizePrefixed(_reqs, reqs))
+  {
+    std::cerr << "Malformed batch of service requests received" << std::endl;
+    return false;
+  }
+
+  std::vector<std::string> reps;
+  std::vector<bool> results;
+  _handler.RunBatchCallback(reqs, reps, results);
+
+  // Each response is preceded by the result of its request.
+  _reps.clear();
+  std::string item;
+  for (std::size_t i = 0; i < reqs.size(); ++i)
+  {
+    item.assign(1, results[i] ? '1' : '0');
+    item.append(reps[i]);
+    if (!appendSizePrefixed(_reps, item))
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t NodeSharedPrivate::PickResponder(const std::string &_topic,
+    const std::vector<ServicePublisher> &_responders,
+    const ServiceBalancing_t _policy,
+    const std::vector<std::string> &_exclude)
+{
+  const std::size_t n = _responders.size();
+  if (_policy == ServiceBalancing_t::FIRST || n == 1)
+    return 0;
+
+  const std::size_t start = this->balanceCursors[_topic]++;
+  if (_policy == ServiceBalancing_t::ROUND_ROBIN)
+    return start % n;
+
+  // The responder with the fewest outstanding requests. Ties are broken in
+  // turn, so idle responders share the load too.
+  std::size_t best = start % n;
+  bool bestExcluded = true;
+  uint64_t bestCount = std::numeric_limits<uint64_t>::max();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const std::size_t index = (start + i) % n;
+    const std::string &addr = _responders[index].Addr();
+    const bool excluded =
+      std::find(_exclude.begin(), _exclude.end(), addr) != _exclude.end();
+
+    uint64_t count = 0;
+    auto it = this->outstandingRequests.find(addr);
+    if (it != this->outstandingRequests.end())
+      count = it->second;
+
+    if ((bestExcluded && !excluded) ||
+        (bestExcluded == excluded && count < bestCount))
+    {
+      best = index;
+      bestCount = count;
+      bestExcluded = excluded;
+    }
+  }
+  return best;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::TrackRequest(const std::string &_topic,
+    const std::string &_reqUuid, const std::string &_addr)
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  // Forget the requests that never got a response (e.g. timed out). The
+  // ones that got it are already gone.
+  std::vector<std::string> expired;
+  this->requestTrackTimers.Expire(now, expired);
+  for (const auto &reqUuid : expired)
+  {
+    auto it = this->requestTracks.find(reqUuid);
+    if (it == this->requestTracks.end())
+      continue;
+
+    if (!it->second.answered)
+      this->ReleaseRequest(it->second);
+    this->requestTracks.erase(it);
+  }
+
+  auto &track = this->requestTracks[_reqUuid];
+  if (track.addresses.empty())
+  {
+    track.topic = _topic;
+    track.sent = now;
+    this->requestTrackTimers.Schedule(_reqUuid, now + kRequestTrackTtl);
+  }
+  track.addresses.push_back(_addr);
+  ++this->outstandingRequests[_addr];
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::TrackResponse(const std::string &_reqUuid)
+{
+  auto it = this->requestTracks.find(_reqUuid);
+  if (it == this->requestTracks.end())
+    return false;
+
+  auto &track = it->second;
+  if (track.answered)
+  {
+    if (++track.lateResponses + 1 >= track.addresses.size())
+      this->requestTracks.erase(it);
+    return true;
+  }
+
+  // Keep the response time for the hedge delay.
+  auto &latencies = this->serviceLatencies[track.topic];
+  latencies.push_back(std::chrono::steady_clock::now() - track.sent);
+  if (latencies.size() > kLatencySamples)
+    latencies.pop_front();
+
+  this->ReleaseRequest(track);
+  track.answered = true;
+
+  // Wait for the responses of the copies, if any.
+  if (track.addresses.size() == 1)
+    this->requestTracks.erase(it);
+  return false;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseRequest(const ServiceRequestTrack &_track)
+{
+  for (const auto &addr : _track.addresses)
+  {
+    auto it = this->outstandingRequests.find(addr);
+    if (it == this->outstandingRequests.end())
+      continue;
+
+    if (--it->second == 0)
+      this->outstandingRequests.erase(it);
+  }
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration NodeSharedPrivate::HedgeDelay(
+    const std::string &_topic) const
+{
+  auto it = this->serviceLatencies.find(_topic);
+  if (it == this->serviceLatencies.end() ||
+      it->second.size() < kMinLatencySamples)
+  {
+    return kDefaultHedgeDelay;
+  }
+
+  std::vector<std::chrono::steady_clock::duration> latencies(
+    it->second.begin(), it->second.end());
+  auto p95 = latencies.begin() + (latencies.size() * 95) / 100;
+  std::nth_element(latencies.begin(), p95, latencies.end());
+  return *p95;
+}
+
+//////////////////////////////////////////////////
+int64_t NodeSharedPrivate::NextHedgeTimeout() const
+{
+  if (this->hedgedRequests.empty())
+    return -1;
+
+  auto deadline = this->hedgedRequests.front().deadline;
+  for (const auto &hedge : this->hedgedRequests)
+    deadline = std::min(deadline, hedge.deadline);
+
+  const auto now = std::chrono::steady_clock::now();
+  if (deadline <= now)
+    return 0;
+
+  // Round up, so we don't wake up right before the deadline.
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    deadline - now + std::chrono::microseconds(999)).count();
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CountDroppedMsgs(const MessageInfo &_info,
+    uint64_t _count)
+{
+  std::string topic;
+  if (!TopicUtils::FullyQualifiedName(_info.Partition(), "", _info.Topic(),
+        topic))
+  {
+    return;
+  }
+
+  Metrics::Add(Metrics::Instance().Topic(topic),
+    Metrics::Counter::DROPPED_MSGS, _count);
+
+  std::shared_lock<std::shared_mutex> lk(this->statsMutex);
+  auto it = this->topicStats.find(topic);
+  if (it == this->topicStats.end() || !it->second->enabled)
+    return;
+
+  it->second->droppedMsgs += _count;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::DispatchPublication(const PublishMsgDetails &_details)
+{
+  GZ_TRANSPORT_PROBE1(dispatch__start, _details.info.Topic().c_str());
+  ProbeScope dispatchDone([&]()
+  {
+    GZ_TRANSPORT_PROBE1(dispatch__done, _details.info.Topic().c_str());
+  });
+
+  Tracer &tracer = Tracer::Instance();
+  const uint64_t traceId = tracer.Enabled() ? _details.trace.traceId : 0;
+  uint64_t traceStart = 0;
+  if (traceId)
+  {
+    // Time spent waiting for the publication thread.
+    traceStart = Tracer::Now();
+    tracer.Span("pub_queue", _details.info.Topic(), traceId,
+      _details.queuedStamp, traceStart);
+  }
+
+  if (!_details.handlers)
+    return;
+
+  // Send the message to all the local handlers.
+  for (const auto &handler : _details.handlers->normal)
+  {
+    if (!_details.runLocal || !_details.Receives(handler))
+      continue;
+    RunLocalHandler(_details, handler);
+    if (traceId)
+    {
+      const uint64_t now = Tracer::Now();
+      tracer.Span("callback", _details.info.Topic(), traceId, traceStart,
+        now);
+      traceStart = now;
+    }
+  }
+
+  // Send the message to all the raw handlers.
+  for (const auto &handler : _details.handlers->raw)
+  {
+    if (!_details.runRaw || !_details.Receives(handler))
+      continue;
+    RunRawHandler(_details, handler);
+    if (traceId)
+    {
+      const uint64_t now = Tracer::Now();
+      tracer.Span("callback", _details.info.Topic(), traceId, traceStart,
+        now);
+      traceStart = now;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunLocalHandler(const PublishMsgDetails &_details,
+    const ISubscriptionHandlerPtr &_handler)
+{
+  // The node may have unsubscribed since the publication was queued.
+  if (!_handler->Alive())
+    return;
+
+  // Check here if we want to ignore local publications.
+  if (_handler->IgnoreLocalMessages() &&
+      _details.publisherNodeUUID == _handler->NodeUuid())
+  {
+    return;
+  }
+
+  try
+  {
+    CallbackProfiler::Scope profile(_handler, _details.info.Topic(),
+      _details.queued);
+    _handler->RunLocalCallback(*(_details.msgCopy.get()), _details.info);
+  }
+  catch (...)
+  {
+    std::cerr << "Exception occurred in a local callback "
+      << "on topic [" << _details.info.Topic() << "] with message ["
+      << _details.msgCopy->DebugString() << "]" << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunRawHandler(const PublishMsgDetails &_details,
+    const RawSubscriptionHandlerPtr &_handler)
+{
+  if (!_handler->Alive())
+    return;
+
+  try
+  {
+    CallbackProfiler::Scope profile(_handler, _details.info.Topic(),
+      _details.queued);
+    _handler->RunRawCallback(_details.sharedBuffer.get(),
+        _details.msgSize, _details.info);
+  }
+  catch (...)
+  {
+    std::cerr << "Exception occured in a local raw callback "
+      << "on topic [" << _details.info.Topic() << "]";
+    if (_details.msgCopy)
+      std::cerr << " with message [" << _details.msgCopy->DebugString() << "]";
+    std::cerr << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::QueuePublication(PublicationLane &_lane,
+    std::unique_ptr<PublishMsgDetails> &_details)
+{
+  // In single thread mode the reception thread consumes the regular lane.
+  const bool fromPubThread =
+    std::this_thread::get_id() == _lane.thread.get_id() ||
+    (this->singleThread && &_lane == this->pubLane.get() &&
+     std::this_thread::get_id() == this->receptionThreadId);
+
+  // Keep the waiting publications within the memory budget. A local
+  // callback publishing from the pubThread cannot wait for room.
+  bool reserved = _details->memory.Reserve();
+  if (!reserved && this->memoryBlock && !fromPubThread)
+    reserved = _details->memory.Reserve(this->exit);
+  if (!reserved)
+  {
+    this->memoryBudget.CountRejected();
+    this->CountDroppedMsgs(_details->info, 1u);
+    if (!this->memoryWarned.exchange(true))
+    {
+      std::cerr << "The memory budget of the local publications is "
+                << "exhausted (" << this->memoryBudget.Limit() << " bytes). "
+                << "Dropping messages, starting on topic ["
+                << _details->info.Topic() << "]. Consider increasing "
+                << "GZ_TRANSPORT_MEMORY_BUDGET" << std::endl;
+    }
+    return false;
+  }
+
+  // Bound the publications of the publisher waiting in the queue.
+  const std::shared_ptr<PublicationBound> bound = _details->bound;
+  if (bound)
+  {
+    bool dropOldest = false;
+    bool dropNewest = false;
+    {
+      // The room is checked and taken under the same lock, so concurrent
+      // publishers can't exceed the depth.
+      std::unique_lock<std::mutex> lk(bound->mutex);
+      auto waiting = [&bound]()
+      {
+        return bound->pending > bound->skip ?
+          bound->pending - bound->skip : 0u;
+      };
+
+      if (waiting() >= bound->depth)
+      {
+        QueuePolicy_t policy = bound->policy;
+
+        // A local callback publishing from the pubThread cannot wait for
+        // room.
+        if (policy == QueuePolicy_t::KEEP_ALL && fromPubThread)
+          policy = QueuePolicy_t::DROP_NEWEST;
+
+        if (policy == QueuePolicy_t::KEEP_ALL)
+        {
+          // The exit is checked regularly, like the subscription queues.
+          while (waiting() >= bound->depth)
+          {
+            if (this->exit)
+              return false;
+            bound->room.wait_for(lk, std::chrono::milliseconds(100));
+          }
+        }
+        else if (policy == QueuePolicy_t::DROP_NEWEST)
+        {
+          dropNewest = true;
+        }
+        else
+        {
+          // The oldest publication is dropped when it is popped.
+          ++bound->skip;
+          dropOldest = true;
+        }
+      }
+
+      if (!dropNewest)
+        ++bound->pending;
+    }
+
+    if (dropOldest || dropNewest)
+      this->CountDroppedMsgs(_details->info, 1u);
+    if (dropNewest)
+      return false;
+  }
+
+  // A local callback publishing from the pubThread cannot wait for space,
+  // since it is the only consumer of the queue.
+  if (fromPubThread)
+  {
+    if (_lane.queue.TryPush(_details))
+      return true;
+
+    if (bound)
+      ReleasePending(*bound);
+
+    ++this->pubQueueDropped;
+    std::cerr << "Local publication queue is full (capacity "
+              << _lane.queue.Capacity() << "). Dropping message on topic ["
+              << _details->info.Topic() << "]. Consider increasing "
+              << "GZ_TRANSPORT_PUB_QUEUE_SIZE" << std::endl;
+    return false;
+  }
+
+  if (_lane.queue.Push(_details, this->exit))
+  {
+    if (this->singleThread && &_lane == this->pubLane.get())
+      this->WakeReception();
+    return true;
+  }
+
+  if (bound)
+    ReleasePending(*bound);
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::ReleaseBound(const PublishMsgDetails &_details)
+{
+  if (!_details.bound)
+    return false;
+
+  PublicationBound &bound = *_details.bound;
+  bool skipped;
+  {
+    std::lock_guard<std::mutex> lk(bound.mutex);
+    skipped = bound.skip > 0;
+    if (skipped)
+      --bound.skip;
+    --bound.pending;
+  }
+  bound.room.notify_one();
+  return skipped;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleasePending(PublicationBound &_bound)
+{
+  {
+    std::lock_guard<std::mutex> lk(_bound.mutex);
+    --_bound.pending;
+  }
+  _bound.room.notify_one();
+}
+
+//////////////////////////////////////////////////
+NodeSharedPrivate::PublicationLane &NodeSharedPrivate::PriorityLane()
+{
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  if (!this->priorityLane)
+  {
+    this->priorityLane.reset(
+      new PublicationLane(this->pubLane->queue.Capacity(), true));
+    this->priorityLane->thread = std::thread(
+      &NodeSharedPrivate::PublishThread, this, this->priorityLane.get());
+  }
+  return *this->priorityLane;
+}
+
+//////////////////////////////////////////////////
+std::size_t NodeShared::PubQueueDepth() const
+{
+  return this->dataPtr->pubLane->queue.Depth();
+}
+
+//////////////////////////////////////////////////
+std::size_t NodeShared::PubQueueHighWaterMark() const
+{
+  return this->dataPtr->pubLane->queue.HighWaterMark();
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeShared::PubQueueDropped() const
+{
+  return this->dataPtr->pubQueueDropped;
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeShared::MemoryUsage() const
+{
+  return this->dataPtr->memoryBudget.Used();
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeShared::MemoryUsage(const std::string &_topic) const
+{
+  return this->dataPtr->memoryBudget.Used(_topic);
+}
+
+//////////////////////////////////////////////////
+std::optional<transport::TopicStatistics> NodeShared::TopicStats(
+    const std::string &_topic) const
+{
+  NodeSharedPrivate::StatsAccumulator *acc = nullptr;
+  {
+    std::shared_lock<std::shared_mutex> lk(this->dataPtr->statsMutex);
+    auto it = this->dataPtr->topicStats.find(_topic);
+    if (it == this->dataPtr->topicStats.end())
+      return std::nullopt;
+    acc = it->second.get();
+  }
+
+  // Include the samples that the statistics thread didn't aggregate yet.
+  std::lock_guard<std::mutex> lk(acc->mutex);
+  this->dataPtr->DrainStats(*acc);
+  if (!acc->available)
+    return std::nullopt;
+  return acc->stats;
+}
+
+//////////////////////////////////////////////////
+void NodeShared::EnableStats(const std::string &_topic, bool _enable,
+    std::function<void(const TopicStatistics &_stats)> _statCb)
+{
+  std::unique_lock<std::shared_mutex> lk(this->dataPtr->statsMutex);
+  auto it = this->dataPtr->topicStats.find(_topic);
+  if (!_enable)
+  {
+    // \todo Also cleanup topicStats.
+    if (it != this->dataPtr->topicStats.end())
+      it->second->enabled = false;
+    return;
+  }
+
+  if (it == this->dataPtr->topicStats.end())
+  {
+    it = this->dataPtr->topicStats.emplace(_topic,
+      std::make_shared<NodeSharedPrivate::StatsAccumulator>()).first;
+  }
+
+  {
+    std::lock_guard<std::mutex> accLk(it->second->mutex);
+    it->second->cb = _statCb;
+  }
+  it->second->enabled = true;
+
+  if (!this->dataPtr->statsThread.joinable())
+  {
+    this->dataPtr->statsThread = std::thread(
+      &NodeSharedPrivate::RunStatsTask, this->dataPtr.get());
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeShared::EnableCallbackProfile(bool _enable)
+{
+  CallbackProfiler::Instance().SetEnabled(_enable);
+  if (!_enable)
+    return;
+
+  std::unique_lock<std::shared_mutex> lk(this->dataPtr->statsMutex);
+  if (!this->dataPtr->profileThread.joinable())
+  {
+    this->dataPtr->profileThread = std::thread(
+      &NodeSharedPrivate::RunProfileTask, this->dataPtr.get(), this->pUuid);
+  }
+}
+
+//////////////////////////////////////////////////
+std::vector<CallbackProfile> NodeShared::CallbackProfiles() const
+{
+  return CallbackProfiler::Instance().Profiles();
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunProfileTask(const std::string &_pUuid)
+{
+  setupThread("BACKGROUND", "gz-profile");
+
+  Node node;
+  Node::Publisher pub =
+    node.Advertise<msgs::Metric>(NodeShared::kCallbackProfileTopic);
+  if (!pub)
+    return;
+
+  CallbackProfiler &profiler = CallbackProfiler::Instance();
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lk(this->statsThreadMutex);
+      if (this->statsCondition.wait_for(lk, kProfilePeriod,
+            [this]{return this->exit.load();}))
+      {
+        return;
+      }
+    }
+
+    if (!profiler.Enabled() || !pub.HasConnections())
+      continue;
+
+    msgs::Metric msg;
+    msg.set_unit("milliseconds");
+    msgs::Header::Map *data = msg.mutable_header()->add_data();
+    data->set_key("process_uuid");
+    data->add_value(_pUuid);
+    for (const CallbackProfile &profile : profiler.Profiles())
+      profile.FillMessage(*msg.add_statistics_groups());
+    pub.Publish(msg);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::StartTopicReport(const std::string &_pUuid)
+{
+  // The report is only useful once the process talks to others.
+  if (!this->topicReportEnabled || !this->networkReady ||
+      !Metrics::Instance().Enabled())
+  {
+    return;
+  }
+
+  std::unique_lock<std::shared_mutex> lk(this->statsMutex);
+  if (!this->reportThread.joinable())
+  {
+    this->reportThread = std::thread(&NodeSharedPrivate::RunReportTask, this,
+      _pUuid);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunReportTask(const std::string &_pUuid)
+{
+  setupThread("BACKGROUND", "gz-report");
+
+  NodeOptions opts;
+  opts.SetPartition(NodeShared::kTopicReportPartition);
+  Node node(opts);
+  Node::Publisher pub =
+    node.Advertise<msgs::Metric>(NodeShared::kTopicReportTopic);
+  if (!pub)
+    return;
+
+  // The reports don't report themselves.
+  std::string reportTopic;
+  TopicUtils::FullyQualifiedName(NodeShared::kTopicReportPartition, "",
+    NodeShared::kTopicReportTopic, reportTopic);
+
+  Metrics &metrics = Metrics::Instance();
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lk(this->statsThreadMutex);
+      if (this->statsCondition.wait_for(lk, kReportPeriod,
+            [this]{return this->exit.load();}))
+      {
+        return;
+      }
+    }
+
+    if (!metrics.Enabled() || !pub.HasConnections())
+      continue;
+
+    const auto msgsSent = metrics.Values(Metrics::Counter::MSGS_SENT);
+    const auto bytesSent = metrics.Values(Metrics::Counter::BYTES_SENT);
+
+    msgs::Metric msg;
+    msg.set_unit("bytes");
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    const auto sec = std::chrono::duration_cast<std::chrono::seconds>(now);
+    msg.mutable_header()->mutable_stamp()->set_sec(sec.count());
+    msg.mutable_header()->mutable_stamp()->set_nsec(static_cast<int32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - sec).count()));
+    msgs::Header::Map *data = msg.mutable_header()->add_data();
+    data->set_key("process_uuid");
+    data->add_value(_pUuid);
+
+    // Only the topics published by this process.
+    for (const auto &[topic, count] : msgsSent)
+    {
+      if (count == 0 || topic == reportTopic)
+        continue;
+
+      msgs::StatisticsGroup *group = msg.add_statistics_groups();
+      group->set_name("topic_report");
+      msgs::Header::Map *topicData = group->mutable_header()->add_data();
+      topicData->set_key("topic");
+      topicData->add_value(topic);
+
+      msgs::Statistic *stat = group->add_statistics();
+      stat->set_type(msgs::Statistic::SAMPLE_COUNT);
+      stat->set_name("msgs_sent");
+      stat->set_value(static_cast<double>(count));
+
+      auto bytes = bytesSent.find(topic);
+      stat = group->add_statistics();
+      stat->set_type(msgs::Statistic::SAMPLE_COUNT);
+      stat->set_name("bytes_sent");
+      stat->set_value(bytes == bytesSent.end() ? 0.0 :
+        static_cast<double>(bytes->second));
+    }
+    pub.Publish(msg);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateShmWriter(const std::string &_topic,
+    const std::string &_msgType, const std::string &_pUuid,
+    const int _numaNode)
+{
+  if (!this->shmEnabled)
+    return;
+
+  std::lock_guard<std::mutex> lk(this->shmMutex);
+
+  // Several nodes of this process may advertise the same topic.
+  if (this->shmWriters.find(_topic) != this->shmWriters.end())
+    return;
+
+  auto writer = std::make_shared<ShmWriter>();
+  writer->segment = ShmSegment::Create(_pUuid, _topic, _msgType,
+    this->shmSlots, this->shmSlotSize,
+    _numaNode >= 0 ? _numaNode : this->shmNumaNode, this->shmHugePages);
+  if (!writer->segment)
+    return;
+
+  this->shmWriters[_topic] = writer;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<ShmWriter> NodeSharedPrivate::CreateBlackboard(
+    const std::string &_topic, const std::string &_msgType)
+{
+  std::lock_guard<std::mutex> lk(this->shmMutex);
+
+  // Several nodes of this process may advertise the same topic.
+  auto it = this->blackboards.find(_topic);
+  if (it != this->blackboards.end())
+    return it->second;
+
+  // Two slots, so that the readers can copy the last message while the
+  // next one is written.
+  auto writer = std::make_shared<ShmWriter>();
+  writer->segment = ShmSegment::Create(kBlackboardUuid, _topic, _msgType, 2,
+    this->shmSlotSize, this->shmNumaNode, this->shmHugePages);
+  if (!writer->segment)
+    return nullptr;
+
+  this->blackboards[_topic] = writer;
+  return writer;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::ShmPublish(const NodeShared *_shared,
+    const std::string &_topic, const char *_data, std::size_t _size)
+{
+  std::shared_ptr<ShmWriter> writer;
+  {
+    std::lock_guard<std::mutex> lk(this->shmMutex);
+    auto it = this->shmWriters.find(_topic);
+    if (it == this->shmWriters.end())
+      return false;
+    writer = it->second;
+  }
+
+  // Large messages fall back to ZeroMQ.
+  if (_size > writer->segment->SlotSize())
+    return false;
+
+  std::lock_guard<std::mutex> lk(writer->mutex);
+
+  if (writer->remoteProcsDirty.exchange(false))
+  {
+    writer->remoteProcs.clear();
+    MsgAddresses_M subscribers;
+    {
+      std::shared_lock<std::shared_mutex> remoteLk(
+        this->remoteSubscribersMutex);
+      _shared->remoteSubscribers.Publishers(_topic, subscribers);
+    }
+    for (const auto &proc : subscribers)
+      writer->remoteProcs.insert(proc.first);
+
+    for (auto it = writer->doorbells.begin(); it != writer->doorbells.end();)
+    {
+      if (writer->remoteProcs.count(it->first) == 0)
+        it = writer->doorbells.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  // All the remote subscribers must read the segment, otherwise ZeroMQ is
+  // used for everybody. This way a message is never delivered twice.
+  if (writer->remoteProcs.empty())
+    return false;
+
+  for (const std::string &proc : writer->remoteProcs)
+  {
+    if (!writer->segment->HasReader(proc))
+      return false;
+  }
+
+  if (!writer->segment->Write(_data, _size))
+    return false;
+
+  // Wake up the readers. A doorbell missing now is opened again with the
+  // next message.
+  for (const std::string &proc : writer->remoteProcs)
+  {
+    std::unique_ptr<ShmDoorbell> &doorbell = writer->doorbells[proc];
+    if (!doorbell)
+      doorbell = ShmDoorbell::Open(proc);
+    if (doorbell)
+      doorbell->Ring();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AttachShmReader(const std::string &_topic,
+    const std::string &_pubPUuid, const std::string &_pUuid)
+{
+  // The writers can't wake up this process without its doorbell.
+  if (!this->shmDoorbell)
+    return;
+
+  std::lock_guard<std::mutex> lk(this->shmMutex);
+  for (const auto &reader : this->shmReaders)
+  {
+    if (reader->topic == _topic && reader->pUuid == _pubPUuid)
+      return;
+  }
+
+  // The segment only exists if the publisher runs on this host and has
+  // the shared memory transport enabled.
+  auto reader = std::make_shared<ShmReader>();
+  reader->segment = ShmSegment::Open(_pubPUuid, _topic);
+  if (!reader->segment)
+    return;
+
+  if (!reader->segment->AddReader(_pUuid))
+  {
+    std::cerr << "Too many readers of the shared memory segment of topic ["
+              << _topic << "]. Using ZeroMQ instead." << std::endl;
+    return;
+  }
+
+  reader->topic = _topic;
+  reader->msgType = reader->segment->MsgType();
+  reader->pUuid = _pubPUuid;
+  this->shmReaders.push_back(reader);
+  ++this->shmReadersVersion;
+  this->shmDoorbell->Ring();
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::DetachShmReaders(const std::string &_topic,
+    const std::string &_pubPUuid, const std::string &_pUuid)
+{
+  std::lock_guard<std::mutex> lk(this->shmMutex);
+  auto it = this->shmReaders.begin();
+  while (it != this->shmReaders.end())
+  {
+    const auto &reader = *it;
+    if ((_topic.empty() || reader->topic == _topic) &&
+        (_pubPUuid.empty() || reader->pUuid == _pubPUuid))
+    {
+      reader->segment->RemoveReader(_pUuid);
+      it = this->shmReaders.erase(it);
+      ++this->shmReadersVersion;
+    }
+    else
+      ++it;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AttachFdReader(NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_pubPUuid)
+{
+  std::lock_guard<std::mutex> lk(this->fdMutex);
+  if (this->exit)
+    return;
+
+  for (const auto &reader : this->fdReaders)
+  {
+    if (reader->topic == _topic && reader->pUuid == _pubPUuid)
+      return;
+  }
+
+  // The channel only exists if the publisher runs on this host.
+  auto reader = std::make_shared<FdReader>();
+  reader->channel = FdChannel::Connect(FdChannel::Name(_pubPUuid, _topic));
+  if (!reader->channel)
+    return;
+
+  reader->topic = _topic;
+  reader->msgType = _msgType;
+  reader->pUuid = _pubPUuid;
+  this->fdReaders.push_back(reader);
+  ++this->fdReadersVersion;
+
+  if (this->fdThread.joinable())
+  {
+    this->WakeFdThread();
+    return;
+  }
+
+  // Nothing would read the channel: close it.
+  if (!this->OpenFdWake())
+  {
+    this->fdReaders.pop_back();
+    ++this->fdReadersVersion;
+    return;
+  }
+  this->fdThread = std::thread(
+    &NodeSharedPrivate::RunFdReceptionTask, this, _shared);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::DetachFdReaders(const std::string &_topic,
+    const std::string &_pubPUuid)
+{
+  std::lock_guard<std::mutex> lk(this->fdMutex);
+  bool detached = false;
+  auto it = this->fdReaders.begin();
+  while (it != this->fdReaders.end())
+  {
+    const auto &reader = *it;
+    if ((_topic.empty() || reader->topic == _topic) &&
+        (_pubPUuid.empty() || reader->pUuid == _pubPUuid))
+    {
+      it = this->fdReaders.erase(it);
+      ++this->fdReadersVersion;
+      detached = true;
+    }
+    else
+      ++it;
+  }
+
+  // The reception thread stops polling the closed channels.
+  if (detached)
+    this->WakeFdThread();
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::OpenFdWake()
+{
+#if defined(__linux__)
+  this->fdWakeRead = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->fdWakeRead < 0)
+  {
+    std::cerr << "Unable to create an eventfd: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  this->fdWakeWrite = this->fdWakeRead;
+  return true;
+#elif !defined(_WIN32)
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    std::cerr << "Unable to create a pipe: " << strerror(errno)
+              << std::endl;
+    return false;
+  }
+  for (int fd : fds)
+  {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  this->fdWakeRead = fds[0];
+  this->fdWakeWrite = fds[1];
+  return true;
+#else
+  return false;
+#endif
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::WakeFdThread()
+{
+#ifndef _WIN32
+  if (this->fdWakeWrite < 0)
+    return;
+
+  const uint64_t one = 1;
+  if (write(this->fdWakeWrite, &one,
+        this->fdWakeWrite == this->fdWakeRead ? sizeof(one) : 1u) < 0 &&
+      errno != EAGAIN)
+  {
+    std::cerr << "Unable to wake up the descriptor reception thread: "
+              << strerror(errno) << std::endl;
+  }
+#endif
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CloseFdWake()
+{
+#ifndef _WIN32
+  if (this->fdWakeWrite >= 0 && this->fdWakeWrite != this->fdWakeRead)
+    close(this->fdWakeWrite);
+  if (this->fdWakeRead >= 0)
+    close(this->fdWakeRead);
+#endif
+  this->fdWakeRead = -1;
+  this->fdWakeWrite = -1;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunFdReceptionTask(NodeShared *_shared)
+{
+#ifndef _WIN32
+  setupThread("RECEPTION", "gz-fd-rx");
+
+  std::vector<std::shared_ptr<FdReader>> readers;
+  std::vector<pollfd> items;
+  uint64_t readersVersion = std::numeric_limits<uint64_t>::max();
+  std::string data;
+
+  while (!this->exit)
+  {
+    if (readersVersion != this->fdReadersVersion)
+    {
+      std::lock_guard<std::mutex> lk(this->fdMutex);
+      readers = this->fdReaders;
+      readersVersion = this->fdReadersVersion;
+
+      // The first item is woken up by the new channels and the exit.
+      items.clear();
+      items.push_back({this->fdWakeRead, POLLIN, 0});
+      for (const auto &reader : readers)
+        items.push_back({reader->channel->Socket(), POLLIN, 0});
+    }
+
+    if (poll(items.data(), items.size(), -1) <= 0)
+      continue;
+
+    if (items[0].revents != 0)
+    {
+      uint64_t value;
+      while (read(this->fdWakeRead, &value, sizeof(value)) > 0)
+      {
+      }
+    }
+
+    for (std::size_t i = 1; i < items.size() && !this->exit; ++i)
+    {
+      if (items[i].revents == 0)
+        continue;
+
+      const auto &reader = readers[i - 1];
+      int fd = -1;
+      while (!this->exit && reader->channel->Receive(data, fd))
+      {
+        MessageInfo info;
+        info.SetTopicAndPartition(reader->topic);
+        info.SetType(reader->msgType);
+        info.SetFd(fd);
+        _shared->TriggerCallbacks(info, data,
+          _shared->CheckHandlerInfo(reader->topic));
+      }
+
+      // The publisher is gone.
+      if (reader->channel->Closed())
+        this->DetachFdReaders(reader->topic, reader->pUuid);
+    }
+  }
+#else
+  (void)_shared;
+#endif
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::InvalidateRemoteSubscribers()
+{
+  ++this->remoteSubscribersVersion;
+  this->subscribersVersion.fetch_add(1, std::memory_order_release);
+
+  if (this->compressionCount > 0)
+  {
+    std::lock_guard<std::mutex> lk(this->compressionMutex);
+    for (auto &compression : this->compressions)
+      compression.second->subscribersDirty = true;
+  }
+
+  if (!this->shmEnabled)
+    return;
+
+  std::lock_guard<std::mutex> lk(this->shmMutex);
+  for (auto &writer : this->shmWriters)
+    writer.second->remoteProcsDirty = true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AnnounceSubscribers(NodeShared *_shared,
+  const std::string &_nUuid, const std::set<std::string> &_topics)
+{
+  std::vector<MessagePublisher> pubs =
+    _shared->localSubscribers.Convert(_shared->myAddress, _shared->pUuid);
+  pubs.erase(std::remove_if(pubs.begin(), pubs.end(),
+    [&](const MessagePublisher &_pub)
+    {
+      return _pub.NUuid() != _nUuid || _topics.count(_pub.Topic()) == 0;
+    }), pubs.end());
+
+  this->msgDiscovery->SendSubscribersReps(pubs);
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeSharedPrivate::RemoteSubscribersMsgsPerSec(
+    const NodeShared *_shared, const std::string &_topic)
+{
+  MsgAddresses_M subscribers;
+  {
+    std::shared_lock<std::shared_mutex> remoteLk(
+      this->remoteSubscribersMutex);
+    _shared->remoteSubscribers.Publishers(_topic, subscribers);
+  }
+
+  uint64_t maxRate = 0;
+  for (const auto &proc : subscribers)
+  {
+    for (const MessagePublisher &sub : proc.second)
+    {
+      const uint64_t rate = sub.SubscriberMsgsPerSec();
+      if (rate == kUnthrottled || rate == 0)
+        return kUnthrottled;
+      maxRate = std::max(maxRate, rate);
+    }
+  }
+
+  return maxRate == 0 ? kUnthrottled : maxRate;
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeSharedPrivate::NodeMsgsPerSec(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_nUuid)
+{
+  const NodeShared::TopicHandlersPtr handlers =
+    _shared->localSubscribers.Snapshot(_topic);
+  if (!handlers)
+    return kUnthrottled;
+
+  uint64_t maxRate = 0;
+  auto update = [&](const auto &_handler)
+  {
+    if (!_handler || _handler->NodeUuid() != _nUuid)
+      return;
+
+    const std::string typeName = _handler->TypeName();
+    if (typeName != _msgType && typeName != kGenericMessageType)
+      return;
+
+    const uint64_t rate = _handler->MsgsPerSec();
+    maxRate = (rate == kUnthrottled || maxRate == kUnthrottled) ?
+      kUnthrottled : std::max(maxRate, rate);
+  };
+
+  for (const ISubscriptionHandlerPtr &handler : handlers->normal)
+    update(handler);
+  for (const RawSubscriptionHandlerPtr &handler : handlers->raw)
+    update(handler);
+
+  return maxRate == 0 ? kUnthrottled : maxRate;
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeSharedPrivate::NodeCredits(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_nUuid, bool &_conflated)
+{
+  _conflated = false;
+  const NodeShared::TopicHandlersPtr handlers =
+    _shared->localSubscribers.Snapshot(_topic);
+  if (!handlers)
+    return 0;
+
+  uint64_t maxCredits = 0;
+  bool uncontrolled = false;
+  auto update = [&](const auto &_handler)
+  {
+    if (!_handler || _handler->NodeUuid() != _nUuid)
+      return;
+
+    const std::string typeName = _handler->TypeName();
+    if (typeName != _msgType && typeName != kGenericMessageType)
+      return;
+
+    const uint64_t credits = _handler->Credits();
+    if (credits == 0)
+    {
+      uncontrolled = true;
+      return;
+    }
+    maxCredits = std::max(maxCredits, credits);
+    _conflated = _conflated || _handler->Conflated();
+  };
+
+  for (const ISubscriptionHandlerPtr &handler : handlers->normal)
+    update(handler);
+  for (const RawSubscriptionHandlerPtr &handler : handlers->raw)
+    update(handler);
+
+  if (uncontrolled)
+  {
+    _conflated = false;
+    return 0;
+  }
+  return maxCredits;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<ContentFilter> NodeSharedPrivate::RemoteSubscribersFilter(
+    const NodeShared *_shared, const std::string &_topic)
+{
+  MsgAddresses_M subscribers;
+  {
+    std::shared_lock<std::shared_mutex> remoteLk(
+      this->remoteSubscribersMutex);
+    _shared->remoteSubscribers.Publishers(_topic, subscribers);
+  }
+
+  std::set<std::string> expressions;
+  for (const auto &proc : subscribers)
+  {
+    for (const MessagePublisher &sub : proc.second)
+    {
+      if (sub.SubscriberFilter().empty())
+        return nullptr;
+      expressions.insert(sub.SubscriberFilter());
+    }
+  }
+
+  if (expressions.empty())
+    return nullptr;
+
+  auto filter = std::make_shared<ContentFilter>(ContentFilter::Any(
+    {expressions.begin(), expressions.end()}));
+  // A filter from a newer version may not parse here: send everything.
+  if (!filter->Valid())
+    return nullptr;
+  return filter;
+}
+
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::NodeFilter(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_nUuid)
+{
+  const NodeShared::TopicHandlersPtr handlers =
+    _shared->localSubscribers.Snapshot(_topic);
+  if (!handlers)
+    return "";
+
+  std::set<std::string> expressions;
+  for (const ISubscriptionHandlerPtr &handler : handlers->normal)
+  {
+    if (!handler || handler->NodeUuid() != _nUuid)
+      continue;
+
+    const std::string typeName = handler->TypeName();
+    if (typeName != _msgType && typeName != kGenericMessageType)
+      continue;
+
+    if (handler->Filter().empty())
+      return "";
+    expressions.insert(handler->Filter());
+  }
+
+  // Raw subscriptions receive every message.
+  for (const RawSubscriptionHandlerPtr &handler : handlers->raw)
+  {
+    if (handler && handler->NodeUuid() == _nUuid)
+      return "";
+  }
+
+  if (expressions.empty())
+    return "";
+  return ContentFilter::Any({expressions.begin(), expressions.end()});
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunShmReceptionTask(NodeShared *_shared)
+{
+  setupThread("RECEPTION", "gz-shm-rx");
+
+  std::vector<std::shared_ptr<ShmReader>> readers;
+  uint64_t readersVersion = 0;
+  unsigned int idlePasses = 0;
+  std::string data;
+
+  // The messages are copied out of the segments: the writer may reuse a
+  // slot at any time, so the callbacks can't be given a view of it.
+  while (!this->exit)
+  {
+    if (readersVersion != this->shmReadersVersion)
+    {
+      std::lock_guard<std::mutex> lk(this->shmMutex);
+      readers = this->shmReaders;
+      readersVersion = this->shmReadersVersion;
+    }
+
+    bool received = false;
+    for (const auto &reader : readers)
+    {
+      while (!this->exit && reader->segment->Read(data))
+      {
+        received = true;
+        if (Metrics::Entry *metrics = Metrics::Instance().Topic(reader->topic))
+        {
+          Metrics::Add(metrics, Metrics::Counter::MSGS_RECEIVED);
+          Metrics::Add(metrics, Metrics::Counter::BYTES_RECEIVED, data.size());
+        }
+        MessageInfo info;
+        info.SetTopicAndPartition(reader->topic);
+        info.SetType(reader->msgType);
+        _shared->TriggerCallbacks(info, data,
+          _shared->CheckHandlerInfo(reader->topic));
+      }
+    }
+
+    if (received)
+    {
+      idlePasses = 0;
+      continue;
+    }
+
+    // Spin for a short time to keep the latency low, then block until a
+    // writer rings. Without a doorbell there are no readers.
+    if (!readers.empty() && ++idlePasses < kShmSpinPasses)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    if (!this->shmDoorbell)
+      return;
+
+    // Check again once the writers know that this thread waits, so that a
+    // message or a change written in the meantime isn't missed.
+    const uint32_t key = this->shmDoorbell->PrepareWait();
+    bool ready = this->exit || readersVersion != this->shmReadersVersion;
+    for (std::size_t i = 0; i < readers.size() && !ready; ++i)
+      ready = readers[i]->segment->Unread();
+
+    if (ready)
+      this->shmDoorbell->CancelWait();
+    else
+      this->shmDoorbell->Wait(key);
+    idlePasses = 0;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateBatch(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const AdvertiseMessageOptions &_opts)
+{
+  // Batches don't carry the metadata of every message.
+  if (!_opts.Batched() || this->metadataEnabled)
+    return;
+
+  std::lock_guard<std::mutex> lk(this->batchMutex);
+
+  // Several nodes of this process may advertise the same topic. The options
+  // of the first publisher are used.
+  auto [it, inserted] = this->batches.try_emplace(_topic);
+  PublicationBatch &batch = it->second;
+  if (inserted)
+  {
+    batch.batchMsgType = kBatchMsgTypePrefix + _msgType;
+    batch.maxMsgs = _opts.BatchSize();
+    batch.period = _opts.BatchPeriod();
+    ++this->batchCount;
+  }
+  ++batch.publishers;
+
+  if (!this->batchThread.joinable())
+  {
+    this->batchThread = std::thread(&NodeSharedPrivate::RunBatchTask, this,
+      _shared);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseBatch(const NodeShared *_shared,
+    const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lk(this->batchMutex);
+  auto it = this->batches.find(_topic);
+  if (it == this->batches.end())
+    return;
+
+  this->FlushBatch(_shared, _topic, it->second);
+  if (--it->second.publishers == 0)
+  {
+    this->batches.erase(it);
+    --this->batchCount;
+  }
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::BatchPublish(const NodeShared *_shared,
+    const std::string &_topic, const char *_data, std::size_t _size)
+{
+  if (this->batchCount == 0)
+    return false;
+
+  std::lock_guard<std::mutex> lk(this->batchMutex);
+  auto it = this->batches.find(_topic);
+  if (it == this->batches.end())
+    return false;
+
+  PublicationBatch &batch = it->second;
+
+  // The size of a message is encoded in 32 bits. Larger messages are sent
+  // alone, after the pending ones.
+  if (_size > std::numeric_limits<uint32_t>::max())
+  {
+    this->FlushBatch(_shared, _topic, batch);
+    return false;
+  }
+
+  const bool wasEmpty = batch.count == 0;
+
+  // Each message is preceded by its size (little endian).
+  const auto size = static_cast<uint32_t>(_size);
+  for (int i = 0; i < 4; ++i)
+    batch.buffer.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+  batch.buffer.append(_data, _size);
+  ++batch.count;
+
+  if (batch.count >= batch.maxMsgs)
+  {
+    this->FlushBatch(_shared, _topic, batch);
+  }
+  else if (wasEmpty)
+  {
+    // The period starts with the first message of the batch.
+    batch.deadline = std::chrono::steady_clock::now() + batch.period;
+    this->batchCondition.notify_one();
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::FlushBatch(const NodeShared *_shared,
+    const std::string &_topic, PublicationBatch &_batch)
+{
+  if (_batch.count == 0)
+    return;
+
+  // The buffer is handed over to ZeroMQ, which releases it once sent.
+  auto *buffer = new std::string(std::move(_batch.buffer));
+  _batch.buffer.clear();
+  _batch.buffer.reserve(buffer->size());
+  _batch.count = 0;
+
+  zmq::message_t data(buffer->data(), buffer->size(),
+    [](void *, void *_hint)
+    {
+      delete static_cast<std::string *>(_hint);
+    }, buffer);
+  this->SendPublication(_shared, _topic, _batch.batchMsgType, data);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunBatchTask(const NodeShared *_shared)
+{
+  setupThread("BACKGROUND", "gz-batch");
+
+  std::unique_lock<std::mutex> lk(this->batchMutex);
+  while (!this->exit)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    std::optional<std::chrono::steady_clock::time_point> next;
+    for (auto &[topic, batch] : this->batches)
+    {
+      if (batch.count == 0)
+        continue;
+
+      if (batch.deadline <= now)
+        this->FlushBatch(_shared, topic, batch);
+      else if (!next || batch.deadline < *next)
+        next = batch.deadline;
+    }
+
+    if (next)
+    {
+      this->batchCondition.wait_until(lk, *next);
+    }
+    else
+    {
+      this->batchCondition.wait_for(lk,
+        std::chrono::milliseconds(NodeSharedPrivate::Timeout));
+    }
+  }
+
+  // Send the pending messages before exiting.
+  for (auto &[topic, batch] : this->batches)
+    this->FlushBatch(_shared, topic, batch);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AddRealTimePublisher(const void *_publisher,
+    std::function<void()> _send)
+{
+  std::lock_guard<std::mutex> lk(this->realTimeMutex);
+  this->realTimeSenders[_publisher] = std::move(_send);
+
+  if (!this->realTimeThread.joinable())
+    this->realTimeThread = std::thread(&NodeSharedPrivate::RunRealTimeTask,
+      this);
+  this->realTimeCondition.notify_all();
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RemoveRealTimePublisher(const void *_publisher)
+{
+  std::lock_guard<std::mutex> lk(this->realTimeMutex);
+  this->realTimeSenders.erase(_publisher);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunRealTimeTask()
+{
+  setupThread("PUBLISH", "gz-realtime");
+
+  std::unique_lock<std::mutex> lk(this->realTimeMutex);
+  while (!this->exit)
+  {
+    for (auto &sender : this->realTimeSenders)
+      sender.second();
+
+    if (this->realTimeSenders.empty())
+    {
+      this->realTimeCondition.wait_for(lk,
+        std::chrono::milliseconds(NodeSharedPrivate::Timeout));
+    }
+    else
+    {
+      this->realTimeCondition.wait_for(lk, kRealTimePeriod);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::DispatchRemoteMsg(NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_data, const std::string &_sender,
+    const PublicationMetadata &_meta)
+{
+  // The probes of an adaptive rate go back to their publisher, possibly
+  // compressed with the messages of the topic.
+  if (_msgType.find(kProbeMsgTypePrefix) != std::string::npos)
+  {
+    this->EchoProbe(_shared, _topic, _msgType, _data);
+    return;
+  }
+
+  if (Metrics::Entry *metrics = Metrics::Instance().Topic(_topic))
+  {
+    Metrics::Add(metrics, Metrics::Counter::MSGS_RECEIVED);
+    Metrics::Add(metrics, Metrics::Counter::BYTES_RECEIVED, _data.size());
+  }
+
+  // The message is out of the reception queue, the publisher can send
+  // another one.
+  this->ConsumeCredit(_shared, _topic, _sender);
+
+  const NodeShared::HandlerInfo handlerInfo =
+    _shared->CheckHandlerInfo(_topic);
+
+  MessageInfo info;
+  info.SetTopicAndPartition(_topic);
+  this->FillMetadata(info, _sender, _meta);
+
+  // Decompress the payload once, before dispatching it to every handler.
+  std::string msgType = _msgType;
+  const std::string *data = &_data;
+  std::string decompressed;
+  const Compression_t codec = Compression::StripTypePrefix(msgType);
+  if (codec != Compression_t::NONE)
+  {
+    if (!Compression::Decompress(codec, _data.data(), _data.size(),
+          decompressed))
+    {
+      std::cerr << "Unable to decompress [" << Compression::Name(codec)
+                << "] message received on topic [" << _topic << "]"
+                << std::endl;
+      return;
+    }
+    data = &decompressed;
+  }
+
+  // Reliable publications start with their sequence number.
+  std::string payload;
+  if (msgType.compare(0, kReliableMsgTypePrefix.size(),
+        kReliableMsgTypePrefix) == 0)
+  {
+    if (data->size() < sizeof(uint64_t))
+    {
+      std::cerr << "Malformed reliable message received on topic ["
+                << _topic << "]" << std::endl;
+      return;
+    }
+
+    uint64_t seq = 0;
+    for (std::size_t i = 0; i < sizeof(seq); ++i)
+    {
+      seq |= static_cast<uint64_t>(
+        static_cast<unsigned char>((*data)[i])) << (8 * i);
+    }
+    if (!this->ReceiveReliable(_shared, _topic, _sender, seq))
+      return;
+
+    info.SetSequenceNumber(seq);
+    msgType.erase(0, kReliableMsgTypePrefix.size());
+    payload.assign(*data, sizeof(seq), std::string::npos);
+    data = &payload;
+  }
+
+  // Latched messages are only delivered to the handlers of the node that
+  // requested them.
+  if (msgType.compare(0, kLatchedMsgTypePrefix.size(),
+        kLatchedMsgTypePrefix) == 0)
+  {
+    uint32_t size = 0;
+    for (int i = 0; i < 4 && i < static_cast<int>(data->size()); ++i)
+    {
+      size |= static_cast<uint32_t>(
+        static_cast<unsigned char>((*data)[i])) << (8 * i);
+    }
+    if (data->size() < 4 || size > data->size() - 4)
+    {
+      std::cerr << "Malformed latched message received on topic ["
+                << _topic << "]" << std::endl;
+      return;
+    }
+
+    if (!handlerInfo.handlers)
+      return;
+
+    const std::string nUuid = data->substr(4, size);
+    auto nodeHandlers = std::make_shared<NodeShared::TopicHandlers>();
+    nodeHandlers->version = handlerInfo.handlers->version;
+    for (const ISubscriptionHandlerPtr &handler :
+         handlerInfo.handlers->normal)
+    {
+      if (handler && handler->NodeUuid() == nUuid)
+        nodeHandlers->normal.push_back(handler);
+    }
+    for (const RawSubscriptionHandlerPtr &handler :
+         handlerInfo.handlers->raw)
+    {
+      if (handler && handler->NodeUuid() == nUuid)
+        nodeHandlers->raw.push_back(handler);
+    }
+
+    NodeShared::HandlerInfo nodeInfo = handlerInfo;
+    nodeInfo.haveLocal = !nodeHandlers->normal.empty();
+    nodeInfo.haveRaw = !nodeHandlers->raw.empty();
+    if (!nodeInfo.haveLocal && !nodeInfo.haveRaw)
+      return;
+    nodeInfo.handlers = nodeHandlers;
+
+    info.SetType(msgType.substr(kLatchedMsgTypePrefix.size()));
+    _shared->TriggerCallbacks(info, data->substr(4 + size), nodeInfo);
+    return;
+  }
+
+  if (msgType.compare(0, kBatchMsgTypePrefix.size(),
+        kBatchMsgTypePrefix) != 0)
+  {
+    info.SetType(msgType);
+    _shared->TriggerCallbacks(info, *data, handlerInfo);
+    return;
+  }
+
+  // Unpack the batch and dispatch its messages in order.
+  info.SetType(msgType.substr(kBatchMsgTypePrefix.size()));
+  std::string msg;
+  std::size_t pos = 0;
+  while (pos + 4 <= data->size())
+  {
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      size |= static_cast<uint32_t>(
+        static_cast<unsigned char>((*data)[pos + i])) << (8 * i);
+    }
+    pos += 4;
+
+    if (size > data->size() - pos)
+    {
+      std::cerr << "Malformed batch received on topic [" << _topic << "]"
+                << std::endl;
+      return;
+    }
+
+    msg.assign(*data, pos, size);
+    pos += size;
+    _shared->TriggerCallbacks(info, msg, handlerInfo);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::FillMetadata(MessageInfo &_info,
+    const std::string &_sender, const PublicationMetadata &_meta)
+{
+  // The publisher doesn't send its metadata.
+  if (_meta.stamp == 0)
+    return;
+
+  const auto now = std::chrono::system_clock::now();
+  _info.SetReceptionTime(now);
+  _info.SetSequenceNumber(_meta.seq);
+
+  // Older publishers stamp with their steady clock, in milliseconds.
+  if (_meta.LegacyStamp())
+  {
+    const auto age = std::chrono::steady_clock::now().time_since_epoch() -
+      std::chrono::milliseconds(_meta.stamp);
+    _info.SetPublicationTime(now -
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(age));
+    return;
+  }
+
+  // Correct the offset of the clock of the publisher, see DrainStats().
+  std::chrono::microseconds offset{0};
+  {
+    std::lock_guard<std::mutex> lk(this->senderProcessesMutex);
+    auto proc = this->senderProcesses.find(_sender);
+    if (proc != this->senderProcesses.end())
+    {
+      _info.SetPublisherUuid(proc->second);
+      this->msgDiscovery->ClockOffset(proc->second, offset);
+    }
+  }
+  _info.SetPublicationTime(std::chrono::system_clock::time_point(
+    std::chrono::duration_cast<std::chrono::system_clock::duration>(
+      std::chrono::microseconds(static_cast<int64_t>(_meta.stamp)) +
+      offset)));
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateLatch(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const AdvertiseMessageOptions &_opts)
+{
+  if (!_opts.Latched())
+    return;
+
+  std::lock_guard<std::mutex> lk(this->latchedMutex);
+
+  // Several nodes of this process may advertise the same topic. The options
+  // of the first publisher are used.
+  auto [it, inserted] = this->latched.try_emplace(_topic);
+  LatchedTopic &cache = it->second;
+  if (inserted)
+  {
+    cache.msgType = _msgType;
+    cache.depth = _opts.LatchDepth();
+    cache.account = this->memoryBudget.Topic(_topic);
+    ++this->latchedCount;
+  }
+  ++cache.publishers;
+
+  if (!this->latchedThread.joinable())
+  {
+    this->latchedThread = std::thread(&NodeSharedPrivate::RunLatchTask, this,
+      _shared);
+  }
+}
 
-    // I am not connected to the process.
-    if (!this->connections.HasPublisher(addr))
-      this->dataPtr->subscriber->connect(addr.c_str());
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseLatch(const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lk(this->latchedMutex);
+  auto it = this->latched.find(_topic);
+  if (it == this->latched.end())
+    return;
 
-    // Add a new filter for the topic.
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->dataPtr->subscriber->set(zmq::sockopt::subscribe, topic);
-#else
-    this->dataPtr->subscriber->setsockopt(ZMQ_SUBSCRIBE,
-        topic.data(), topic.size());
-#endif
+  if (--it->second.publishers == 0)
+  {
+    this->latched.erase(it);
+    --this->latchedCount;
+  }
+}
 
-    // Register the new connection with the publisher.
-    this->connections.AddPublisher(_pub);
+//////////////////////////////////////////////////
+void NodeSharedPrivate::StoreLatched(const std::string &_topic,
+    const std::shared_ptr<char[]> &_data, std::size_t _size)
+{
+  std::lock_guard<std::mutex> lk(this->latchedMutex);
+  auto it = this->latched.find(_topic);
+  if (it == this->latched.end())
+    return;
 
-    if (this->verbose)
-      std::cout << "\t* Connected to [" << addr << "] for data\n";
+  LatchedTopic &cache = it->second;
+  cache.msgs.emplace_back(_data, _size);
+  cache.charges.emplace_back(cache.account, _size);
+  cache.charges.back().Force();
+  while (cache.msgs.size() > cache.depth)
+  {
+    cache.msgs.pop_front();
+    cache.charges.pop_front();
+  }
+  ++cache.stored;
+}
 
-    MessagePublisher pub(_pub);
-    pub.SetPUuid(this->pUuid);
+//////////////////////////////////////////////////
+void NodeSharedPrivate::QueueLatchedReplay(const std::string &_topic,
+    const std::string &_nUuid)
+{
+  std::lock_guard<std::mutex> lk(this->latchedMutex);
+  auto it = this->latched.find(_topic);
+  if (it == this->latched.end() || it->second.msgs.empty())
+    return;
 
-    // Hack: We use this field to store the PUuid of the topic publisher.
-    pub.SetCtrl(_pub.PUuid());
+  LatchedReplay replay;
+  replay.topic = _topic;
+  replay.nUuid = _nUuid;
+  replay.stored = it->second.stored;
+  replay.deadline = std::chrono::steady_clock::now() + kLatchedReplayDelay;
+  this->latchedReplays.push_back(std::move(replay));
+  this->latchedCondition.notify_one();
+}
 
-    std::vector<std::string> handlerNodeUuids =
-        this->localSubscribers.NodeUuids(topic, _pub.MsgTypeName());
-    for (const std::string &nodeUuid : handlerNodeUuids)
+//////////////////////////////////////////////////
+void NodeSharedPrivate::SendLatched(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_nUuid, const std::deque<LatchedTopic::Msg> &_msgs)
+{
+  const std::string msgType = kLatchedMsgTypePrefix + _msgType;
+  const auto nUuidSize = static_cast<uint32_t>(_nUuid.size());
+
+  for (const LatchedTopic::Msg &msg : _msgs)
+  {
+    // The UUID of the destination node, preceded by its size, then the
+    // message.
+    auto *buffer = new std::string();
+    buffer->reserve(4 + _nUuid.size() + msg.second);
+    for (int i = 0; i < 4; ++i)
+      buffer->push_back(static_cast<char>((nUuidSize >> (8 * i)) & 0xFF));
+    buffer->append(_nUuid);
+    buffer->append(msg.first.get(), msg.second);
+
+    zmq::message_t data(buffer->data(), buffer->size(),
+      [](void *, void *_hint)
+      {
+        delete static_cast<std::string *>(_hint);
+      }, buffer);
+    this->SendPublication(_shared, _topic, msgType, data);
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunLatchTask(const NodeShared *_shared)
+{
+  setupThread("BACKGROUND", "gz-latch");
+
+  std::unique_lock<std::mutex> lk(this->latchedMutex);
+  while (!this->exit)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    std::optional<std::chrono::steady_clock::time_point> next;
+    std::vector<LatchedReplay> due;
+    for (auto it = this->latchedReplays.begin();
+         it != this->latchedReplays.end();)
     {
-      pub.SetNUuid(nodeUuid);
+      if (it->deadline <= now)
+      {
+        due.push_back(std::move(*it));
+        it = this->latchedReplays.erase(it);
+      }
+      else
+      {
+        if (!next || it->deadline < *next)
+          next = it->deadline;
+        ++it;
+      }
+    }
 
-      // Send a message to the publisher notify it
-      // about all my remoteSubscribers.
-      this->dataPtr->msgDiscovery->Register(pub);
+    for (const LatchedReplay &replay : due)
+    {
+      auto cacheIt = this->latched.find(replay.topic);
+      if (cacheIt == this->latched.end())
+        continue;
+
+      // The node receives the messages published after its registration,
+      // which are newer than the cached ones. Replaying them would deliver
+      // old messages after the new ones.
+      const LatchedTopic &cache = cacheIt->second;
+      if (cache.stored != replay.stored)
+        continue;
+
+      const std::string msgType = cache.msgType;
+      const std::deque<LatchedTopic::Msg> msgs = cache.msgs;
+      lk.unlock();
+      this->SendLatched(_shared, replay.topic, msgType, replay.nUuid, msgs);
+      lk.lock();
+    }
+
+    if (!due.empty())
+      continue;
+
+    if (next)
+    {
+      this->latchedCondition.wait_until(lk, *next);
+    }
+    else
+    {
+      this->latchedCondition.wait_for(lk,
+        std::chrono::milliseconds(NodeSharedPrivate::Timeout));
     }
   }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnNewDisconnection(const MessagePublisher &_pub)
+// Helper to send a shared buffer without copying it.
+static zmq::message_t sharedMessage(
+  const std::shared_ptr<const std::string> &_buffer)
 {
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  auto *ref = new std::shared_ptr<const std::string>(_buffer);
+  return zmq::message_t(const_cast<char *>(_buffer->data()), _buffer->size(),
+    [](void *, void *_hint)
+    {
+      delete static_cast<std::shared_ptr<const std::string> *>(_hint);
+    }, ref);
+}
 
-  std::string topic = _pub.Topic();
-  std::string procUuid = _pub.PUuid();
-  std::string nUuid = _pub.NUuid();
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateReliable(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const AdvertiseMessageOptions &_opts)
+{
+  if (!_opts.Reliable())
+    return;
 
-  if (this->verbose)
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+
+  // Several nodes of this process may advertise the same topic. The options
+  // of the first publisher are used.
+  auto [it, inserted] = this->reliableTopics.try_emplace(_topic);
+  ReliableTopic &reliable = it->second;
+  if (inserted)
   {
-    std::cout << "New disconnection detected " << std::endl;
-    std::cout << "\tProcess UUID: " << procUuid << std::endl;
+    reliable.reliableMsgType = kReliableMsgTypePrefix + _msgType;
+    reliable.depth = _opts.ReliableDepth();
+    reliable.first = this->reliableSeqs[_topic];
+    reliable.account = this->memoryBudget.Topic(_topic);
+    ++this->reliableCount;
   }
+  ++reliable.publishers;
 
-  // A remote subscriber[s] has been disconnected.
-  if (topic != "" && nUuid != "")
+  // The thread answers the retransmission requests.
+  this->StartReliable(_shared);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseReliable(const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto it = this->reliableTopics.find(_topic);
+  if (it == this->reliableTopics.end())
+    return;
+
+  if (--it->second.publishers == 0)
   {
-    this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nUuid);
+    this->reliableTopics.erase(it);
+    --this->reliableCount;
+  }
+}
 
-    MessagePublisher connection;
-    if (!this->connections.Publisher(topic, procUuid, nUuid, connection))
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::ReliablePublish(const NodeShared *_shared,
+    const std::string &_topic, const char *_data, std::size_t _size)
+{
+  if (this->reliableCount == 0)
+    return false;
+
+  std::shared_ptr<const std::string> payload;
+  std::string msgType;
+  {
+    std::lock_guard<std::mutex> lk(this->reliableMutex);
+    auto it = this->reliableTopics.find(_topic);
+    if (it == this->reliableTopics.end())
+      return false;
+
+    // The sequence number, then the message.
+    const uint64_t seq = this->reliableSeqs[_topic]++;
+    auto buffer = std::make_shared<std::string>();
+    buffer->reserve(sizeof(seq) + _size);
+    for (std::size_t i = 0; i < sizeof(seq); ++i)
+      buffer->push_back(static_cast<char>((seq >> (8 * i)) & 0xFF));
+    buffer->append(_data, _size);
+    payload = std::move(buffer);
+
+    ReliableTopic &reliable = it->second;
+    reliable.msgs.push_back(payload);
+    reliable.charges.emplace_back(reliable.account, payload->size());
+    reliable.charges.back().Force();
+    while (reliable.msgs.size() > reliable.depth)
+    {
+      reliable.msgs.pop_front();
+      reliable.charges.pop_front();
+      ++reliable.first;
+    }
+    reliable.lastPublication = std::chrono::steady_clock::now();
+    reliable.tailSent = false;
+    msgType = reliable.reliableMsgType;
+  }
+
+  // A publication that can't be queued is recovered like a lost one.
+  zmq::message_t data = sharedMessage(payload);
+  this->SendPublication(_shared, _topic, msgType, data);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::Retransmit(const NodeShared *_shared,
+    const std::string &_topic, const std::vector<uint64_t> &_seqs)
+{
+  std::vector<std::shared_ptr<const std::string>> payloads;
+  std::string msgType;
+  {
+    std::lock_guard<std::mutex> lk(this->reliableMutex);
+    auto it = this->reliableTopics.find(_topic);
+    if (it == this->reliableTopics.end())
       return;
 
-    // I am no longer connected.
-    this->connections.DelPublisherByNode(topic, procUuid, nUuid);
+    const ReliableTopic &reliable = it->second;
+    for (const uint64_t seq : _seqs)
+    {
+      if (seq >= reliable.first && seq - reliable.first < reliable.msgs.size())
+        payloads.push_back(reliable.msgs[seq - reliable.first]);
+    }
+    msgType = reliable.reliableMsgType;
   }
-  else
+
+  // Every subscriber receives the messages again, those that already have
+  // them discard them.
+  for (const auto &payload : payloads)
   {
-    // Note: We deliberately don't remove the list of remote subscribers
-    // for this process. Remote nodes might suffer package delays (due to WiFi
-    // or traffic load) and if we remove them, they won't be able to receive
-    // data anymore.
+    zmq::message_t data = sharedMessage(payload);
+    this->SendPublication(_shared, _topic, msgType, data);
+  }
+}
 
-    MsgAddresses_M info;
-    if (!this->connections.Publishers(topic, info))
-      return;
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::ReceiveReliable(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_sender,
+    const uint64_t _seq)
+{
+  ReliableReceiver::Delivery delivery;
+  uint64_t lost = 0;
+  {
+    std::lock_guard<std::mutex> lk(this->reliableMutex);
+    auto [it, inserted] = this->reliableStreams.try_emplace(
+      std::make_pair(_topic, _sender));
+    ReliableStream &stream = it->second;
+    if (inserted || stream.pUuid.empty())
+    {
+      std::lock_guard<std::mutex> senderLk(this->senderProcessesMutex);
+      auto proc = this->senderProcesses.find(_sender);
+      if (proc != this->senderProcesses.end())
+        stream.pUuid = proc->second;
+    }
 
-    // Remove all the connections from the process disonnected.
-    this->connections.DelPublishersByProc(procUuid);
+    delivery = stream.receiver.Receive(_seq, ReliableReceiver::Clock::now());
+    lost = stream.receiver.TakeLost();
+    if (stream.receiver.Missing() > 0)
+    {
+      this->StartReliable(_shared);
+      this->reliableCondition.notify_one();
+    }
+  }
+
+  if (Metrics::Entry *metrics = Metrics::Instance().Topic(_topic))
+  {
+    if (delivery == ReliableReceiver::Delivery::RECOVERED)
+      Metrics::Add(metrics, Metrics::Counter::RECOVERED_MSGS);
+    if (lost > 0)
+      Metrics::Add(metrics, Metrics::Counter::LOST_MSGS, lost);
   }
+
+  return delivery != ReliableReceiver::Delivery::DUPLICATE;
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnNewSrvConnection(const ServicePublisher &_pub)
+void NodeSharedPrivate::ForgetReliable(const std::string &_pUuid)
 {
-  std::string topic = _pub.Topic();
-  std::string addr = _pub.Addr();
-  std::string reqType = _pub.ReqTypeName();
-  std::string repType = _pub.RepTypeName();
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  for (auto it = this->reliableStreams.begin();
+       it != this->reliableStreams.end();)
+  {
+    if (it->second.pUuid == _pUuid)
+      it = this->reliableStreams.erase(it);
+    else
+      ++it;
+  }
+}
 
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+//////////////////////////////////////////////////
+void NodeSharedPrivate::AttachCredits(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_addr,
+    const std::string &_pUuid, const uint64_t _credits)
+{
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto [it, inserted] = this->creditStreams.try_emplace(
+    std::make_pair(_topic, _addr));
+  it->second.pUuid = _pUuid;
+  it->second.window = std::max(it->second.window, _credits);
+  if (inserted)
+    ++this->creditStreamCount;
+  this->StartReliable(_shared);
+}
 
-  if (this->verbose)
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ConsumeCredit(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_sender)
+{
+  if (this->creditStreamCount == 0)
+    return;
+
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto it = this->creditStreams.find(std::make_pair(_topic, _sender));
+  if (it == this->creditStreams.end())
+    return;
+
+  // Grant the credits in batches of half the window, so that the publisher
+  // doesn't stall while the grant is on its way.
+  CreditStream &stream = it->second;
+  if (++stream.consumed < std::max<uint64_t>(1, stream.window / 2))
+    return;
+
+  stream.pending += stream.consumed;
+  stream.consumed = 0;
+  this->StartReliable(_shared);
+  this->reliableCondition.notify_one();
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ForgetCredits(const std::string &_pUuid)
+{
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  for (auto it = this->creditStreams.begin();
+       it != this->creditStreams.end();)
   {
-    std::cout << "Service call connection callback" << std::endl;
-    std::cout << _pub;
+    if (it->second.pUuid == _pUuid)
+    {
+      it = this->creditStreams.erase(it);
+      --this->creditStreamCount;
+    }
+    else
+    {
+      ++it;
+    }
   }
 
-  // I am still not connected to this address.
-  if (std::find(this->srvConnections.begin(), this->srvConnections.end(),
-        addr) == this->srvConnections.end())
+  for (auto &[topic, credit] : this->creditTopics)
+    credit.peers.erase(_pUuid);
+}
+
+//////////////////////////////////////////////////
+// Helper to take a credit of every remote subscriber process that has one.
+static void takeCredits(CreditTopic &_credit,
+  const std::chrono::steady_clock::time_point &_now)
+{
+  for (auto &[pUuid, peer] : _credit.peers)
   {
-    this->dataPtr->requester->connect(addr.c_str());
-    this->srvConnections.push_back(addr);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    if (this->verbose)
+    if (peer.credits > 0 && --peer.credits == 0)
+      peer.exhausted = _now;
+  }
+}
+
+//////////////////////////////////////////////////
+NodeSharedPrivate::CreditDecision NodeSharedPrivate::TakeCredit(
+    const NodeShared *_shared, const std::string &_topic)
+{
+  if (!this->remoteCredits)
+    return CreditDecision::SEND;
+
+  const uint64_t version = this->remoteSubscribersVersion;
+  std::unique_lock<std::mutex> lk(this->reliableMutex);
+  auto it = this->creditTopics.find(_topic);
+  if (it == this->creditTopics.end() || it->second.version != version)
+  {
+    lk.unlock();
+    MsgAddresses_M subscribers;
     {
-      std::cout << "\t* Connected to [" << addr
-                << "] for service requests" << std::endl;
+      std::shared_lock<std::shared_mutex> remoteLk(
+        this->remoteSubscribersMutex);
+      _shared->remoteSubscribers.Publishers(_topic, subscribers);
+    }
+
+    // The credits of a process are those of its most generous node, since
+    // they all receive the same publications.
+    bool controlled = !subscribers.empty();
+    std::map<std::string, CreditPeer> peers;
+    for (const auto &proc : subscribers)
+    {
+      for (const MessagePublisher &sub : proc.second)
+      {
+        if (sub.SubscriberCredits() == 0)
+        {
+          controlled = false;
+          continue;
+        }
+        CreditPeer &peer = peers[proc.first];
+        peer.window = std::max(peer.window, sub.SubscriberCredits());
+        peer.conflated = peer.conflated || sub.SubscriberConflated();
+      }
+    }
+
+    lk.lock();
+    it = this->creditTopics.try_emplace(_topic).first;
+    CreditTopic &credit = it->second;
+    for (auto &[pUuid, peer] : peers)
+    {
+      auto old = credit.peers.find(pUuid);
+      if (old == credit.peers.end())
+      {
+        peer.credits = peer.window;
+      }
+      else
+      {
+        peer.credits = std::min(old->second.credits, peer.window);
+        peer.exhausted = old->second.exhausted;
+      }
     }
+    credit.peers = std::move(peers);
+    credit.controlled = controlled;
+    credit.version = version;
   }
 
-  // Check if there's a pending service request with this specific combination
-  // of request and response types.
-  IReqHandlerPtr handler;
-  if (this->requests.FirstHandler(topic, reqType, repType, handler))
+  CreditTopic &credit = it->second;
+  if (!credit.controlled)
+    return CreditDecision::SEND;
+
+  // A process whose grants were lost gets its credits back after a while.
+  const auto now = std::chrono::steady_clock::now();
+  bool ready = false;
+  bool conflated = false;
+  for (auto &[pUuid, peer] : credit.peers)
+  {
+    if (peer.credits == 0 && now - peer.exhausted >= kCreditTimeout)
+      peer.credits = peer.window;
+    ready = ready || peer.credits > 0;
+    conflated = conflated || peer.conflated;
+  }
+
+  // The publications reach every subscriber process, so the message is sent
+  // as long as one of them can take it.
+  if (ready)
+  {
+    takeCredits(credit, now);
+    credit.latest.reset();
+    credit.latestSize = 0;
+    return CreditDecision::SEND;
+  }
+
+  return conflated ? CreditDecision::KEEP : CreditDecision::SKIP;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::KeepLatest(const std::string &_topic,
+    const std::shared_ptr<char[]> &_data, const std::size_t _size,
+    const std::string &_msgType)
+{
+  if (!_data)
+    return;
+
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto it = this->creditTopics.find(_topic);
+  if (it != this->creditTopics.end())
+  {
+    it->second.latest = _data;
+    it->second.latestSize = _size;
+    it->second.latestType = _msgType;
+  }
+
+  auto adaptive = this->adaptiveTopics.find(_topic);
+  if (adaptive != this->adaptiveTopics.end())
+  {
+    adaptive->second.latest = _data;
+    adaptive->second.latestSize = _size;
+    adaptive->second.latestType = _msgType;
+  }
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::GrantCredits(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_pUuid,
+    const uint64_t _credits)
+{
+  std::shared_ptr<char[]> latest;
+  std::size_t latestSize = 0;
+  std::string latestType;
+  {
+    std::lock_guard<std::mutex> lk(this->reliableMutex);
+    auto it = this->creditTopics.find(_topic);
+    if (it == this->creditTopics.end())
+      return;
+
+    CreditTopic &credit = it->second;
+    auto peer = credit.peers.find(_pUuid);
+    if (peer == credit.peers.end())
+      return;
+
+    // Never more credits than announced, a grant may come after a timeout
+    // already gave them back.
+    CreditPeer &granted = peer->second;
+    granted.credits = _credits >= granted.window - granted.credits ?
+      granted.window : granted.credits + _credits;
+
+    // The conflated subscribers receive the latest message they missed.
+    if (granted.conflated && granted.credits > 0 && credit.latest)
+    {
+      takeCredits(credit, std::chrono::steady_clock::now());
+      latest = std::move(credit.latest);
+      latestSize = credit.latestSize;
+      latestType = credit.latestType;
+      credit.latestSize = 0;
+    }
+  }
+
+  if (!latest)
+    return;
+
+  auto *ref = new std::shared_ptr<char[]>(latest);
+  zmq::message_t data(latest.get(), latestSize,
+    [](void *, void *_hint)
+    {
+      delete static_cast<std::shared_ptr<char[]> *>(_hint);
+    }, ref);
+  this->SendPublication(_shared, _topic, latestType, data);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateAdaptive(const NodeShared *_shared,
+    const std::string &_topic, const AdvertiseMessageOptions &_opts)
+{
+  if (!_opts.Adaptive())
+    return;
+
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+
+  // Several nodes of this process may advertise the same topic. The options
+  // of the first publisher are used.
+  auto [it, inserted] = this->adaptiveTopics.try_emplace(_topic);
+  if (inserted)
+  {
+    it->second.target = _opts.LatencyTarget();
+    ++this->adaptiveCount;
+  }
+  ++it->second.publishers;
+
+  // The thread probes the round trip times.
+  this->StartReliable(_shared);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseAdaptive(const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto it = this->adaptiveTopics.find(_topic);
+  if (it == this->adaptiveTopics.end())
+    return;
+
+  if (--it->second.publishers == 0)
   {
-    // Request all pending service calls for this topic and req/rep types.
-    this->SendPendingRemoteReqs(topic, reqType, repType);
+    this->adaptiveTopics.erase(it);
+    --this->adaptiveCount;
   }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnNewSrvDisconnection(const ServicePublisher &_pub)
+// Helper to convert a duration to seconds.
+static double toSeconds(const std::chrono::steady_clock::duration &_duration)
 {
-  std::string addr = _pub.Addr();
-
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return std::chrono::duration<double>(_duration).count();
+}
 
-  // Remove the address from the list of connected addresses.
-  this->srvConnections.erase(std::remove(std::begin(this->srvConnections),
-    std::end(this->srvConnections), addr.c_str()),
-    std::end(this->srvConnections));
+//////////////////////////////////////////////////
+NodeSharedPrivate::CreditDecision NodeSharedPrivate::AdaptRate(
+    const std::string &_topic)
+{
+  if (this->adaptiveCount == 0)
+    return CreditDecision::SEND;
+
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto it = this->adaptiveTopics.find(_topic);
+  if (it == this->adaptiveTopics.end())
+    return CreditDecision::SEND;
+
+  // The rate of the publisher, to which the rate is restored.
+  AdaptiveTopic &adaptive = it->second;
+  if (adaptive.lastPublication != std::chrono::steady_clock::time_point())
+  {
+    const double elapsed =
+      std::min(toSeconds(now - adaptive.lastPublication), 1.0);
+    adaptive.interval = adaptive.interval > 0 ?
+      0.9 * adaptive.interval + 0.1 * elapsed : elapsed;
+  }
+  adaptive.lastPublication = now;
+  adaptive.published = true;
 
-  if (this->verbose)
+  if (adaptive.rate > 0 &&
+      toSeconds(now - adaptive.lastSend) < 1.0 / adaptive.rate)
   {
-    std::cout << "Service call disconnection callback" << std::endl;
-    std::cout << _pub;
+    return CreditDecision::KEEP;
   }
+
+  adaptive.lastSend = now;
+  adaptive.latest.reset();
+  adaptive.latestSize = 0;
+  return CreditDecision::SEND;
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnNewRegistration(const MessagePublisher &_pub)
+void NodeSharedPrivate::DecreaseRate(AdaptiveTopic &_adaptive,
+    const std::chrono::steady_clock::time_point &_now)
 {
-  // Discard the message if the destination PUUID is not me.
-  if (_pub.Ctrl() != this->pUuid)
+  // Halve the rate actually sent, which may be below the limit.
+  double rate = _adaptive.interval > 0 ? 1.0 / _adaptive.interval :
+    1.0 / toSeconds(kProbeInterval);
+  if (_adaptive.rate > 0)
+    rate = std::min(rate, _adaptive.rate);
+  _adaptive.rate = std::max(kMinAdaptiveRate, rate / 2);
+  _adaptive.lastDecrease = _now;
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReceiveEcho(const std::string &_topic,
+    const std::string &_pUuid, const uint64_t _probe)
+{
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  auto it = this->adaptiveTopics.find(_topic);
+  if (it == this->adaptiveTopics.end())
     return;
 
-  std::string procUuid = _pub.PUuid();
-  std::string nodeUuid = _pub.NUuid();
+  AdaptiveTopic &adaptive = it->second;
+  auto probe = adaptive.probes.find(_probe);
+  if (probe == adaptive.probes.end())
+    return;
 
-  if (this->verbose)
+  probe->second.answered = true;
+  AdaptivePeer &peer = adaptive.peers[_pUuid];
+  peer.rtt = now - probe->second.sent;
+  peer.measured = now;
+
+  // The publications reach every subscriber process, so the slowest one
+  // sets the rate.
+  std::chrono::steady_clock::duration worst{0};
+  for (auto p = adaptive.peers.begin(); p != adaptive.peers.end();)
   {
-    std::cout << "Registering a new remote connection" << std::endl;
-    std::cout << "\tProc UUID: [" << procUuid << "]" << std::endl;
-    std::cout << "\tNode UUID: [" << nodeUuid << "]" << std::endl;
+    if (now - p->second.measured > kProbeExpiry)
+    {
+      p = adaptive.peers.erase(p);
+      continue;
+    }
+    worst = std::max(worst, p->second.rtt);
+    ++p;
   }
 
-  // Add a remote subscriber.
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
-  this->remoteSubscribers.AddPublisher(_pub);
+  if (worst > adaptive.target)
+  {
+    // At most once per target, so that the queues have time to drain.
+    if (now - adaptive.lastDecrease >= adaptive.target)
+      DecreaseRate(adaptive, now);
+  }
+  else if (worst < adaptive.target / 2 && adaptive.rate > 0 &&
+           _probe > adaptive.lastIncrease)
+  {
+    // Once per probe, whatever the number of subscriber processes.
+    adaptive.lastIncrease = _probe;
+    adaptive.rate *= 1.25;
+
+    // The link keeps up with twice the rate of the publisher: the
+    // publications aren't limited any more.
+    if (adaptive.interval > 0 && adaptive.rate * adaptive.interval >= 2.0)
+      adaptive.rate = 0;
+  }
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnEndRegistration(const MessagePublisher &_pub)
+std::optional<std::chrono::steady_clock::time_point>
+NodeSharedPrivate::ProbeAdaptive(const NodeShared *_shared,
+    std::unique_lock<std::mutex> &_lk)
 {
-  // Discard the message if the destination PUUID is not me.
-  if (_pub.Ctrl() != this->pUuid)
-    return;
+  if (this->adaptiveCount == 0)
+    return std::nullopt;
+
+  const auto now = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point next = now + kProbeInterval;
+  std::vector<std::pair<std::string, uint64_t>> probes;
+  std::vector<std::tuple<std::string, std::shared_ptr<char[]>, std::size_t,
+    std::string>> latest;
+  for (auto &[topic, adaptive] : this->adaptiveTopics)
+  {
+    // A probe that doesn't come back within twice the target is stuck in
+    // the queues, or lost with the messages.
+    for (auto probe = adaptive.probes.begin();
+         probe != adaptive.probes.end();)
+    {
+      const auto age = now - probe->second.sent;
+      if (!probe->second.answered && age > 2 * adaptive.target &&
+          now - adaptive.lastDecrease >= adaptive.target)
+      {
+        DecreaseRate(adaptive, now);
+        probe->second.answered = true;
+      }
 
-  std::string topic = _pub.Topic();
-  std::string procUuid = _pub.PUuid();
-  std::string nodeUuid = _pub.NUuid();
+      if (age > kProbeExpiry)
+        probe = adaptive.probes.erase(probe);
+      else
+        ++probe;
+    }
 
-  if (this->verbose)
+    // The topics are only probed while they are published to remote
+    // subscribers.
+    if (adaptive.published && now - adaptive.lastProbe >= kProbeInterval)
+    {
+      adaptive.published = false;
+      adaptive.lastProbe = now;
+      adaptive.probes[++adaptive.nextProbe].sent = now;
+      probes.emplace_back(topic, adaptive.nextProbe);
+    }
+
+    // The latest message over the rate is sent once the rate allows it.
+    if (adaptive.latest)
+    {
+      const auto due = adaptive.lastSend +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / std::max(adaptive.rate,
+            kMinAdaptiveRate)));
+      if (adaptive.rate <= 0 || due <= now)
+      {
+        adaptive.lastSend = now;
+        latest.emplace_back(topic, std::move(adaptive.latest),
+          adaptive.latestSize, adaptive.latestType);
+        adaptive.latestSize = 0;
+      }
+      else
+      {
+        next = std::min(next, due);
+      }
+    }
+  }
+
+  _lk.unlock();
+  for (const auto &[topic, id] : probes)
   {
-    std::cout << "Registering the end of a remote connection" << std::endl;
-    std::cout << "\tProc UUID: " << procUuid << std::endl;
-    std::cout << "\tNode UUID: [" << nodeUuid << "]" << std::endl;
+    msgs::UInt64_V probe;
+    msgs::Header::Map *process = probe.mutable_header()->add_data();
+    process->set_key("process");
+    process->add_value(_shared->pUuid);
+    probe.add_data(id);
+
+    auto *buffer = new std::string(probe.SerializeAsString());
+    zmq::message_t data(buffer->data(), buffer->size(),
+      [](void *, void *_hint)
+      {
+        delete static_cast<std::string *>(_hint);
+      }, buffer);
+    this->SendPublication(_shared, topic, kProbeMsgTypePrefix, data);
   }
 
-  // Delete a remote subscriber.
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
-  this->remoteSubscribers.DelPublisherByNode(topic, procUuid, nodeUuid);
+  for (const auto &[topic, buffer, size, msgType] : latest)
+  {
+    auto *ref = new std::shared_ptr<char[]>(buffer);
+    zmq::message_t data(buffer.get(), size,
+      [](void *, void *_hint)
+      {
+        delete static_cast<std::shared_ptr<char[]> *>(_hint);
+      }, ref);
+    this->SendPublication(_shared, topic, msgType, data);
+  }
+  _lk.lock();
+
+  return next;
 }
 
 //////////////////////////////////////////////////
-void NodeShared::OnSubscribers()
+void NodeSharedPrivate::EchoProbe(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    const std::string &_data)
 {
-  // Get the list of local subscribers.
-  std::lock_guard<std::recursive_mutex> lock(this->mutex);
-  auto pubs = this->localSubscribers.Convert(this->myAddress, this->pUuid);
+  std::string msgType = _msgType;
+  const std::string *data = &_data;
+  std::string decompressed;
+  const Compression_t codec = Compression::StripTypePrefix(msgType);
+  if (codec != Compression_t::NONE)
+  {
+    if (!Compression::Decompress(codec, _data.data(), _data.size(),
+          decompressed))
+    {
+      return;
+    }
+    data = &decompressed;
+  }
 
-  // Reply to the SUBSCRIBERS_REQ with multiple SUBSCRIBERS_REP.
-  for (auto const &publisher : pubs)
-    this->dataPtr->msgDiscovery->SendSubscribersRep(publisher);
+  msgs::UInt64_V probe;
+  if (!probe.ParseFromString(*data) || probe.data_size() == 0)
+    return;
+
+  std::string pUuid;
+  for (const auto &entry : probe.header().data())
+  {
+    if (entry.key() == "process" && entry.value_size() > 0)
+      pUuid = entry.value(0);
+  }
+  if (pUuid.empty())
+    return;
+
+  msgs::UInt64_V req;
+  msgs::Header::Map *topic = req.mutable_header()->add_data();
+  topic->set_key("topic");
+  topic->add_value(_topic);
+  msgs::Header::Map *process = req.mutable_header()->add_data();
+  process->set_key("process");
+  process->add_value(_shared->pUuid);
+  req.add_data(probe.data(0));
+
+  std::lock_guard<std::mutex> lk(this->reliableMutex);
+  this->probeEchoes.emplace_back(kProbeServicePrefix + pUuid, std::move(req));
+  this->StartReliable(_shared);
+  this->reliableCondition.notify_one();
 }
 
 //////////////////////////////////////////////////
-bool NodeShared::InitializeSockets()
+void NodeSharedPrivate::StartReliable(const NodeShared *_shared)
 {
-  try
+  if (!this->reliableThread.joinable())
   {
-    // Set the hostname's ip address.
-    this->hostAddr = this->dataPtr->msgDiscovery->HostAddr();
+    this->reliableThread = std::thread(&NodeSharedPrivate::RunReliableTask,
+      this, _shared);
+  }
+}
 
-    // Publisher socket listening in a random port.
-    std::string anyTcpEp = "tcp://" + this->hostAddr + ":*";
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunReliableTask(const NodeShared *_shared)
+{
+  setupThread("BACKGROUND", "gz-reliable");
+
+  // The retransmission services live in a partition shared by all the
+  // processes, whatever the partitions of their topics.
+  NodeOptions opts;
+  opts.SetPartition(kRetransmitPartition);
+  Node node(opts);
+  std::function<void(const msgs::UInt64_V &)> cb =
+    [this, _shared](const msgs::UInt64_V &_req)
+    {
+      if (_req.header().data_size() == 0 ||
+          _req.header().data(0).value_size() == 0)
+      {
+        return;
+      }
+      const std::vector<uint64_t> seqs(_req.data().begin(),
+        _req.data().end());
+      this->Retransmit(_shared, _req.header().data(0).value(0), seqs);
+    };
+  node.Advertise(kRetransmitServicePrefix + _shared->pUuid, cb);
 
-    // Initialize security
-    this->dataPtr->SecurityInit();
+  // The credits granted by the subscribers of the topics with flow control.
+  std::function<void(const msgs::UInt64_V &)> creditCb =
+    [this, _shared](const msgs::UInt64_V &_req)
+    {
+      std::string topic;
+      std::string pUuid;
+      for (const auto &data : _req.header().data())
+      {
+        if (data.value_size() == 0)
+          continue;
+        if (data.key() == "topic")
+          topic = data.value(0);
+        else if (data.key() == "process")
+          pUuid = data.value(0);
+      }
+      if (topic.empty() || pUuid.empty() || _req.data_size() == 0)
+        return;
+      this->GrantCredits(_shared, topic, pUuid, _req.data(0));
+    };
+  node.Advertise(kCreditServicePrefix + _shared->pUuid, creditCb);
 
-    int lingerVal = 0;
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->dataPtr->publisher->set(zmq::sockopt::linger, lingerVal);
-#else
-    this->dataPtr->publisher->setsockopt(ZMQ_LINGER,
-        &lingerVal, sizeof(lingerVal));
-#endif
+  // The probes of the topics with an adaptive rate, sent back by their
+  // subscribers.
+  std::function<void(const msgs::UInt64_V &)> probeCb =
+    [this](const msgs::UInt64_V &_req)
+    {
+      std::string topic;
+      std::string pUuid;
+      for (const auto &data : _req.header().data())
+      {
+        if (data.value_size() == 0)
+          continue;
+        if (data.key() == "topic")
+          topic = data.value(0);
+        else if (data.key() == "process")
+          pUuid = data.value(0);
+      }
+      if (topic.empty() || pUuid.empty() || _req.data_size() == 0)
+        return;
+      this->ReceiveEcho(topic, pUuid, _req.data(0));
+    };
+  node.Advertise(kProbeServicePrefix + _shared->pUuid, probeCb);
 
-    // Set the capacity of the buffer for receiving messages.
-    int rcvQueueVal = this->dataPtr->NonNegativeEnvVar(
-      "GZ_TRANSPORT_RCVHWM", kDefaultRcvHwm);
+  std::unique_lock<std::mutex> lk(this->reliableMutex);
+  while (!this->exit)
+  {
+    // Gather the requests of the missing messages, by publisher process.
+    const auto now = ReliableReceiver::Clock::now();
+    std::optional<ReliableReceiver::Clock::time_point> next;
+    std::vector<std::pair<std::string, msgs::UInt64_V>> requests;
+    std::vector<std::pair<std::string, uint64_t>> losses;
+    std::vector<std::pair<std::string, uint64_t>> tails;
+    for (auto &[topic, reliable] : this->reliableTopics)
+    {
+      if (reliable.tailSent || reliable.msgs.empty())
+        continue;
 
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->dataPtr->subscriber->set(zmq::sockopt::rcvhwm, rcvQueueVal);
-#else
-    this->dataPtr->subscriber->setsockopt(ZMQ_RCVHWM,
-          &rcvQueueVal, sizeof(rcvQueueVal));
-#endif
+      const auto deadline = reliable.lastPublication + kReliableTailDelay;
+      if (deadline <= now)
+      {
+        reliable.tailSent = true;
+        tails.emplace_back(topic, reliable.first + reliable.msgs.size() - 1);
+      }
+      else if (!next || deadline < *next)
+      {
+        next = deadline;
+      }
+    }
 
-    // Set the capacity of the buffer for sending messages.
-    int sndQueueVal = this->dataPtr->NonNegativeEnvVar(
-      "GZ_TRANSPORT_SNDHWM", kDefaultSndHwm);
+    for (auto &[key, stream] : this->reliableStreams)
+    {
+      std::vector<uint64_t> seqs;
+      auto due = stream.receiver.Due(now, seqs);
+      if (due && (!next || *due < *next))
+        next = due;
+      if (const uint64_t lost = stream.receiver.TakeLost())
+        losses.emplace_back(key.first, lost);
+      if (seqs.empty() || stream.pUuid.empty())
+        continue;
 
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->dataPtr->publisher->set(zmq::sockopt::sndhwm, sndQueueVal);
+      msgs::UInt64_V req;
+      msgs::Header::Map *data = req.mutable_header()->add_data();
+      data->set_key("topic");
+      data->add_value(key.first);
+      for (const uint64_t seq : seqs)
+        req.add_data(seq);
+      requests.emplace_back(kRetransmitServicePrefix + stream.pUuid,
+        std::move(req));
+    }
 
-    this->dataPtr->publisher->bind(anyTcpEp.c_str());
-    this->myAddress =
-        this->dataPtr->publisher->get(zmq::sockopt::last_endpoint);
+    // Grant the credits consumed to the publishers.
+    for (auto &[key, stream] : this->creditStreams)
+    {
+      if (stream.pending == 0)
+        continue;
 
-    // ResponseReceiver socket listening in a random port.
-    std::string id = this->responseReceiverId.ToString();
-    this->dataPtr->responseReceiver->set(zmq::sockopt::routing_id, id);
-    this->dataPtr->responseReceiver->bind(anyTcpEp.c_str());
-    this->myRequesterAddress = this->dataPtr->responseReceiver->get(
-        zmq::sockopt::last_endpoint);
+      msgs::UInt64_V req;
+      msgs::Header::Map *topic = req.mutable_header()->add_data();
+      topic->set_key("topic");
+      topic->add_value(key.first);
+      msgs::Header::Map *process = req.mutable_header()->add_data();
+      process->set_key("process");
+      process->add_value(_shared->pUuid);
+      req.add_data(stream.pending);
+      stream.pending = 0;
+      requests.emplace_back(kCreditServicePrefix + stream.pUuid,
+        std::move(req));
+    }
 
-    // Replier socket listening in a random port.
-    id = this->replierId.ToString();
-    this->dataPtr->replier->set(zmq::sockopt::routing_id, id);
-    int routeOn = 1;
-    this->dataPtr->replier->set(zmq::sockopt::linger, lingerVal);
-    this->dataPtr->replier->set(zmq::sockopt::router_mandatory, routeOn);
-    this->dataPtr->replier->bind(anyTcpEp.c_str());
-    this->myReplierAddress =
-        this->dataPtr->replier->get(zmq::sockopt::last_endpoint);
+    // Send the probes of the adaptive rates back to their publishers.
+    for (auto &echo : this->probeEchoes)
+      requests.push_back(std::move(echo));
+    this->probeEchoes.clear();
 
-    this->dataPtr->requester->set(zmq::sockopt::linger, lingerVal);
-    this->dataPtr->requester->set(zmq::sockopt::router_mandatory, routeOn);
-#else
-    char bindEndPoint[1024];
-    this->dataPtr->publisher->setsockopt(ZMQ_SNDHWM,
-        &sndQueueVal, sizeof(sndQueueVal));
+    lk.unlock();
+    for (const auto &[topic, last] : tails)
+      this->Retransmit(_shared, topic, {last});
+    for (const auto &[topic, lost] : losses)
+    {
+      if (Metrics::Entry *metrics = Metrics::Instance().Topic(topic))
+        Metrics::Add(metrics, Metrics::Counter::LOST_MSGS, lost);
+    }
+    for (const auto &[service, req] : requests)
+      node.Request(service, req);
+    lk.lock();
 
-    this->dataPtr->publisher->bind(anyTcpEp.c_str());
-    size_t size = sizeof(bindEndPoint);
-    this->dataPtr->publisher->getsockopt(ZMQ_LAST_ENDPOINT,
-        &bindEndPoint, &size);
-    this->myAddress = bindEndPoint;
+    if (this->exit)
+      break;
 
-    // ResponseReceiver socket listening in a random port.
-    std::string id = this->responseReceiverId.ToString();
-    this->dataPtr->responseReceiver->setsockopt(ZMQ_IDENTITY,
-        id.c_str(), id.size());
-    this->dataPtr->responseReceiver->bind(anyTcpEp.c_str());
-    this->dataPtr->responseReceiver->getsockopt(ZMQ_LAST_ENDPOINT,
-        &bindEndPoint, &size);
-    this->myRequesterAddress = bindEndPoint;
+    // Probe the topics with an adaptive rate.
+    const auto probeNext = this->ProbeAdaptive(_shared, lk);
+    if (probeNext && (!next || *probeNext < *next))
+      next = probeNext;
 
-    // Replier socket listening in a random port.
-    id = this->replierId.ToString();
-    this->dataPtr->replier->setsockopt(ZMQ_IDENTITY, id.c_str(), id.size());
-    int RouteOn = 1;
-    this->dataPtr->replier->setsockopt(ZMQ_LINGER,
-        &lingerVal, sizeof(lingerVal));
-    this->dataPtr->replier->setsockopt(ZMQ_ROUTER_MANDATORY,
-        &RouteOn, sizeof(RouteOn));
-    this->dataPtr->replier->bind(anyTcpEp.c_str());
-    this->dataPtr->replier->getsockopt(ZMQ_LAST_ENDPOINT, &bindEndPoint, &size);
-    this->myReplierAddress = bindEndPoint;
+    if (this->exit)
+      break;
 
-    this->dataPtr->requester->setsockopt(ZMQ_LINGER,
-        &lingerVal, sizeof(lingerVal));
-    this->dataPtr->requester->setsockopt(ZMQ_ROUTER_MANDATORY, &RouteOn,
-      sizeof(RouteOn));
-#endif
+    if (next)
+    {
+      this->reliableCondition.wait_until(lk, *next);
+    }
+    else
+    {
+      this->reliableCondition.wait_for(lk,
+        std::chrono::milliseconds(NodeSharedPrivate::Timeout));
+    }
   }
-  catch(const zmq::error_t& ze)
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::CreateCompression(const std::string &_topic,
+    const AdvertiseMessageOptions &_opts)
+{
+  if (_opts.Compression() == Compression_t::NONE)
+    return;
+
+  if (!Compression::Supported(_opts.Compression()))
   {
-    std::cerr << "InitializeSockets() Error: " << ze.what() << std::endl;
-    std::cerr << "Gazebo Transport has not been correctly initialized"
-              << std::endl;
-    return false;
+    std::cerr << "Compression codec [" << Compression::Name(
+      _opts.Compression()) << "] not available in this build. Topic ["
+      << _topic << "] will be sent uncompressed." << std::endl;
+    return;
   }
 
-  return true;
-}
+  std::lock_guard<std::mutex> lk(this->compressionMutex);
 
-/////////////////////////////////////////////////
-bool NodeShared::TopicPublishers(const std::string &_topic,
-                                 SrvAddresses_M &_publishers) const
-{
-  return this->dataPtr->srvDiscovery->Publishers(_topic, _publishers);
+  // Several nodes of this process may advertise the same topic. The options
+  // of the first publisher are used.
+  auto &compression = this->compressions[_topic];
+  if (!compression)
+  {
+    compression = std::make_shared<TopicCompression>();
+    compression->codec = _opts.Compression();
+    compression->level = _opts.CompressionLevel();
+    ++this->compressionCount;
+  }
+  ++compression->publishers;
 }
 
-/////////////////////////////////////////////////
-bool NodeShared::DiscoverService(const std::string &_topic) const
+//////////////////////////////////////////////////
+void NodeSharedPrivate::ReleaseCompression(const std::string &_topic)
 {
-  return this->dataPtr->srvDiscovery->Discover(_topic);
-}
+  std::lock_guard<std::mutex> lk(this->compressionMutex);
+  auto it = this->compressions.find(_topic);
+  if (it == this->compressions.end())
+    return;
 
-/////////////////////////////////////////////////
-bool NodeShared::AdvertisePublisher(const ServicePublisher &_publisher)
-{
-  return this->dataPtr->srvDiscovery->Advertise(_publisher);
+  if (--it->second->publishers == 0)
+  {
+    this->compressions.erase(it);
+    --this->compressionCount;
+  }
 }
 
-/////////////////////////////////////////////////
-int NodeShared::RcvHwm()
+//////////////////////////////////////////////////
+Compression_t NodeSharedPrivate::PublicationCodec(const NodeShared *_shared,
+    const std::string &_topic, int &_level)
 {
-  int rcvHwm;
-  try
+  if (this->compressionCount == 0)
+    return Compression_t::NONE;
+
+  std::shared_ptr<TopicCompression> entry;
   {
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    rcvHwm = this->dataPtr->subscriber->get(zmq::sockopt::rcvhwm);
-#else
-    size_t rcvHwmSize = sizeof(rcvHwm);
-    this->dataPtr->subscriber->getsockopt(ZMQ_RCVHWM, &rcvHwm, &rcvHwmSize);
-#endif
+    std::lock_guard<std::mutex> lk(this->compressionMutex);
+    auto it = this->compressions.find(_topic);
+    if (it == this->compressions.end())
+      return Compression_t::NONE;
+    entry = it->second;
   }
-  catch (zmq::error_t &_e)
+
+  TopicCompression &compression = *entry;
+  std::lock_guard<std::mutex> lk(compression.mutex);
+  if (compression.subscribersDirty.exchange(false))
   {
-    return -1;
+    MsgAddresses_M subscribers;
+    {
+      std::shared_lock<std::shared_mutex> remoteLk(
+        this->remoteSubscribersMutex);
+      _shared->remoteSubscribers.Publishers(_topic, subscribers);
+    }
+
+    // Every remote subscriber must be able to decompress the messages,
+    // otherwise they are sent uncompressed to everybody.
+    compression.accepted = !subscribers.empty();
+    for (const auto &proc : subscribers)
+    {
+      for (const MessagePublisher &sub : proc.second)
+      {
+        if (sub.Options().Compression() != compression.codec)
+          compression.accepted = false;
+      }
+    }
   }
 
-  return rcvHwm;
+  if (!compression.accepted)
+    return Compression_t::NONE;
+
+  _level = compression.level;
+  return compression.codec;
 }
 
-/////////////////////////////////////////////////
-int NodeShared::SndHwm()
+//////////////////////////////////////////////////
+std::unique_ptr<PriorityPublisher> NodeSharedPrivate::CreateLanePublisher(
+  const std::string &_ip, const uint64_t _affinity)
 {
-  int sndHwm;
+  std::unique_ptr<PriorityPublisher> lane(new PriorityPublisher);
   try
   {
+    lane->socket.reset(new zmq::socket_t(*this->context, ZMQ_PUB));
+    this->TuneSocket(*lane->socket);
+
+    const std::string anyTcpEp = "tcp://" + _ip + ":*";
+    int lingerVal = 0;
+    int sndQueueVal = this->NonNegativeEnvVar(
+      "GZ_TRANSPORT_SNDHWM", kDefaultSndHwm);
+    uint64_t affinity = _affinity;
+    this->SecureServer(*lane->socket);
+
 #ifdef GZ_CPPZMQ_POST_4_7_0
-    sndHwm = this->dataPtr->publisher->get(zmq::sockopt::sndhwm);
+    lane->socket->set(zmq::sockopt::linger, lingerVal);
+    lane->socket->set(zmq::sockopt::sndhwm, sndQueueVal);
+    if (affinity != 0)
+      lane->socket->set(zmq::sockopt::affinity, affinity);
+    lane->socket->bind(anyTcpEp.c_str());
+    lane->address = lane->socket->get(zmq::sockopt::last_endpoint);
+    this->BindIpc(*lane->socket, lane->address);
 #else
-    size_t sndHwmSize = sizeof(sndHwm);
-    this->dataPtr->publisher->getsockopt(ZMQ_SNDHWM, &sndHwm, &sndHwmSize);
+    lane->socket->setsockopt(ZMQ_LINGER, &lingerVal, sizeof(lingerVal));
+    lane->socket->setsockopt(ZMQ_SNDHWM,
+        &sndQueueVal, sizeof(sndQueueVal));
+    if (affinity != 0)
+      lane->socket->setsockopt(ZMQ_AFFINITY, &affinity, sizeof(affinity));
+    lane->socket->bind(anyTcpEp.c_str());
+    char bindEndPoint[1024];
+    size_t size = sizeof(bindEndPoint);
+    lane->socket->getsockopt(ZMQ_LAST_ENDPOINT, &bindEndPoint, &size);
+    lane->address = bindEndPoint;
+    this->BindIpc(*lane->socket, lane->address);
 #endif
   }
-  catch (zmq::error_t &_e)
+  catch(const zmq::error_t &_error)
   {
-    return -1;
+    std::cerr << "Error creating a publisher on [" << _ip << "]: "
+              << _error.what() << std::endl;
+    return nullptr;
   }
 
-  return sndHwm;
+  return lane;
 }
 
 //////////////////////////////////////////////////
-bool NodeShared::HandlerWrapper::HasSubscriber(
-    const std::string &_fullyQualifiedTopic,
-    const std::string &_msgType) const
+std::string NodeSharedPrivate::PriorityAddress()
 {
-  std::shared_ptr<ISubscriptionHandler> normalSubscriberPtr;
-  std::shared_ptr<RawSubscriptionHandler> rawSubscriberPtr;
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  if (this->priorityPublisher)
+    return this->priorityPublisher->address;
 
-  return this->normal.FirstHandler(
-            _fullyQualifiedTopic, _msgType, normalSubscriberPtr)
-         || this->raw.FirstHandler(
-            _fullyQualifiedTopic, _msgType, rawSubscriberPtr);
+  auto priority = this->CreateLanePublisher(
+    this->msgDiscovery->HostAddr(), kPriorityAffinity);
+  if (!priority)
+    return "";
+
+  this->priorityPublisher = std::move(priority);
+  return this->priorityPublisher->address;
 }
 
 //////////////////////////////////////////////////
-bool NodeShared::HandlerWrapper::HasSubscriber(
-    const std::string &_fullyQualifiedTopic) const
+std::string NodeSharedPrivate::InterfaceAddress(const std::string &_ip)
 {
-  return this->normal.HasHandlersForTopic(_fullyQualifiedTopic)
-      || this->raw.HasHandlersForTopic(_fullyQualifiedTopic);
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  auto it = this->interfacePublishers.find(_ip);
+  if (it != this->interfacePublishers.end())
+    return it->second->address;
+
+  // The loopback interface isn't listed but it's valid for local tests.
+  const auto interfaces = determineInterfaces();
+  if (_ip != "127.0.0.1" &&
+      std::find(interfaces.begin(), interfaces.end(), _ip) ==
+      interfaces.end())
+  {
+    std::cerr << "[" << _ip << "] is not the address of a network interface"
+              << std::endl;
+    return "";
+  }
+
+  auto lane = this->CreateLanePublisher(_ip, 0);
+  if (!lane)
+    return "";
+
+  return this->interfacePublishers.emplace(
+    _ip, std::move(lane)).first->second->address;
 }
 
 //////////////////////////////////////////////////
-template <typename HandlerT>
-static void AppendNodeUuids(const HandlerStorage<HandlerT> &_handlerStorage,
-                            const std::string &_fullyQualifiedTopic,
-                            const std::string &_msgTypeName,
-                            std::vector<std::string> &_uuids)
+std::string NodeSharedPrivate::MulticastAddress()
 {
-  using HandlerTPtr = std::shared_ptr<HandlerT>;
-  std::map<std::string, std::map<std::string, HandlerTPtr>> handlers;
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  if (this->multicastPublisher)
+    return this->multicastPublisher->address;
 
-  _handlerStorage.Handlers(_fullyQualifiedTopic, handlers);
-  for (const auto &collection : handlers)
+  // PGM doesn't authenticate the publishers.
+  if (this->multicastGroup.empty() || !PgmSupported() || secured())
   {
-    for (const auto &collectionEntry : collection.second)
-    {
-      const HandlerTPtr &handler = collectionEntry.second;
-      const std::string &handlerMsgType = handler->TypeName();
-      if (handlerMsgType == _msgTypeName
-          || handlerMsgType == kGenericMessageType)
-      {
-        _uuids.push_back(handler->NodeUuid());
-      }
-    }
+    return "";
+  }
+
+  // Local subscribers, and those without PGM, connect through TCP.
+  auto lane = this->CreateLanePublisher(this->msgDiscovery->HostAddr(), 0);
+  if (!lane)
+    return "";
+
+  const std::string endpoint =
+    "epgm://" + this->msgDiscovery->HostAddr() + ";" + this->multicastGroup;
+  try
+  {
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    lane->socket->set(zmq::sockopt::rate, this->multicastRate);
+#else
+    lane->socket->setsockopt(ZMQ_RATE, &this->multicastRate,
+      sizeof(this->multicastRate));
+#endif
+    lane->socket->connect(endpoint.c_str());
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Error connecting to multicast group [" << endpoint << "]: "
+              << _error.what() << std::endl;
+
+    // Don't try again for every topic.
+    this->multicastGroup.clear();
+    return "";
   }
+
+  this->multicastPublisher = std::move(lane);
+  return this->multicastPublisher->address;
 }
 
 //////////////////////////////////////////////////
-std::vector<std::string> NodeShared::HandlerWrapper::NodeUuids(
-    const std::string &_fullyQualifiedTopic,
-    const std::string &_msgTypeName) const
+void NodeSharedPrivate::CreateMulticastTopic(const std::string &_topic)
 {
-  std::vector<std::string> uuids;
-  AppendNodeUuids(this->normal, _fullyQualifiedTopic, _msgTypeName, uuids);
-  AppendNodeUuids(this->raw, _fullyQualifiedTopic, _msgTypeName, uuids);
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  if (!this->multicastPublisher)
+    return;
 
-  return uuids;
+  auto &entry = this->interfaceTopics[_topic];
+  entry.first = this->multicastPublisher.get();
+  ++entry.second;
+  this->interfaceCount = this->interfaceTopics.size();
 }
 
 //////////////////////////////////////////////////
-bool NodeShared::HandlerWrapper::RemoveHandlersForNode(
-    const std::string &_fullyQualifiedTopic,
-    const std::string &_nUuid)
+void NodeSharedPrivate::CreateInterfaceTopic(const std::string &_topic,
+  const std::string &_ip)
 {
-  bool removed = false;
-  removed |= this->normal.RemoveHandlersForNode(_fullyQualifiedTopic, _nUuid);
-  removed |= this->raw.RemoveHandlersForNode(_fullyQualifiedTopic, _nUuid);
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  auto it = this->interfacePublishers.find(_ip);
+  if (it == this->interfacePublishers.end())
+    return;
 
-  return removed;
+  auto &entry = this->interfaceTopics[_topic];
+  entry.first = it->second.get();
+  ++entry.second;
+  this->interfaceCount = this->interfaceTopics.size();
 }
 
 //////////////////////////////////////////////////
-std::vector<MessagePublisher> NodeShared::HandlerWrapper::Convert(
-    const std::string &_addr, const std::string &_pUuid)
+void NodeSharedPrivate::ReleaseInterfaceTopic(const std::string &_topic)
 {
-  std::vector<MessagePublisher> res;
-
-  for (const auto &[topic, handlerCollection] : this->normal.AllHandlers())
-  {
-    for (const auto &[nUuid, handlerNode] : handlerCollection)
-    {
-      for (const auto &[hUuid, handler] : handlerNode)
-      {
-        res.push_back(MessagePublisher(topic, _addr, "", _pUuid, nUuid,
-          handler->TypeName(), AdvertiseMessageOptions()));
-      }
-    }
-  }
-
-  for (const auto &[topic, handlerCollection] : this->raw.AllHandlers())
-  {
-    for (const auto &[nUuid, handlerNode] : handlerCollection)
-    {
-      for (const auto &[hUuid, handler] : handlerNode)
-      {
-        res.push_back(MessagePublisher(topic, _addr, "", _pUuid, nUuid,
-          handler->TypeName(), AdvertiseMessageOptions()));
-      }
-    }
-  }
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  auto it = this->interfaceTopics.find(_topic);
+  if (it == this->interfaceTopics.end())
+    return;
 
-  return res;
+  if (--it->second.second == 0)
+    this->interfaceTopics.erase(it);
+  this->interfaceCount = this->interfaceTopics.size();
 }
 
 //////////////////////////////////////////////////
-void NodeSharedPrivate::SecurityOnNewConnection()
+void NodeSharedPrivate::CreatePriority(const std::string &_topic)
 {
-  std::string user, pass;
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  if (!this->priorityPublisher)
+    return;
 
-  // Set username and pass if they exist
-  // \todo(anyone): This will cause the subscriber to connect only to secure
-  // connections. Would be nice if the subscriber could still connect to
-  // unsecure connections. This might require an unsecure and secure
-  // subscriber.
-  // See issue #74
-  if (userPass(user, pass))
-  {
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->subscriber->set(zmq::sockopt::plain_username, user);
-    this->subscriber->set(zmq::sockopt::plain_password, pass);
-#else
-    this->subscriber->setsockopt(ZMQ_PLAIN_USERNAME, user.c_str(), user.size());
-    this->subscriber->setsockopt(ZMQ_PLAIN_PASSWORD, pass.c_str(), pass.size());
-#endif
-  }
+  ++this->priorityTopics[_topic];
+  this->priorityCount = this->priorityTopics.size();
 }
 
 //////////////////////////////////////////////////
-void NodeSharedPrivate::SecurityInit()
+void NodeSharedPrivate::ReleasePriority(const std::string &_topic)
 {
-  // Check if a username and password has been set. If so, then
-  // setup a PLAIN authentication server.
-  std::string user, pass;
-  if (userPass(user, pass))
-  {
-    // Create the access control thread.
-    this->accessControlThread = std::thread(
-        &NodeSharedPrivate::AccessControlHandler, this);
-
-    int asPlainSecurityServer = static_cast<int>(
-        ZmqPlainSecurityServerOptions::ZMQ_PLAIN_SECURITY_SERVER_ENABLED);
+  std::lock_guard<std::mutex> lk(this->priorityMutex);
+  auto it = this->priorityTopics.find(_topic);
+  if (it == this->priorityTopics.end())
+    return;
 
-#ifdef GZ_CPPZMQ_POST_4_7_0
-    this->publisher->set(zmq::sockopt::plain_server, asPlainSecurityServer);
-    this->publisher->set(zmq::sockopt::zap_domain, kGzAuthDomain);
-#else
-    this->publisher->setsockopt(ZMQ_PLAIN_SERVER,
-        &asPlainSecurityServer, sizeof(asPlainSecurityServer));
-    this->publisher->setsockopt(ZMQ_ZAP_DOMAIN, kGzAuthDomain,
-        std::strlen(kGzAuthDomain));
-#endif
-  }
+  if (--it->second == 0)
+    this->priorityTopics.erase(it);
+  this->priorityCount = this->priorityTopics.size();
 }
 
 //////////////////////////////////////////////////
-// Access control handler for plain security.
-// This function is designed to be run in a thread.
-void NodeSharedPrivate::AccessControlHandler()
+bool NodeSharedPrivate::SendPublication(const NodeShared *_shared,
+    const std::string &_topic, const std::string &_msgType,
+    zmq::message_t &_data)
 {
-  zmq::socket_t *sock = new zmq::socket_t(*this->context, ZMQ_REP);
-
-  try
+  // Compress the payload (a message or a whole batch) once for all the
+  // remote subscribers. The codec is announced in the type frame.
+  const std::string *msgType = &_msgType;
+  std::string compressedMsgType;
+  int level = 0;
+  const Compression_t codec = this->PublicationCodec(_shared, _topic, level);
+  if (codec != Compression_t::NONE)
   {
-    // Bind to the zap address
-    sock->bind("inproc://zeromq.zap.01");
-
-    // Get the username and password
-    std::string user, pass;
-    if (!userPass(user, pass))
+    auto *buffer = new std::string();
+    if (Compression::Compress(codec, level,
+          static_cast<const char *>(_data.data()), _data.size(), *buffer))
     {
-      std::cerr << "Username and password not set. "
-                << "Authentication is disabled\n";
-      sock->close();
-      delete sock;
-      return;
+      _data = zmq::message_t(buffer->data(), buffer->size(),
+        [](void *, void *_hint)
+        {
+          delete static_cast<std::string *>(_hint);
+        }, buffer);
+      compressedMsgType = Compression::TypePrefix(codec) + _msgType;
+      msgType = &compressedMsgType;
     }
-
-    std::string sequence;
-    std::string domain;
-    std::string address;
-    std::string routingId;
-    std::string mechanism;
-    std::string givenUsername;
-    std::string givenPassword;
-    std::string version;
-
-    zmq::pollitem_t items[] =
+    else
     {
-      {static_cast<void*>(*sock), 0, ZMQ_POLLIN, 0},
-    };
+      delete buffer;
+    }
+  }
 
-    // Process
-    while (!this->exit)
+  // High priority topics and topics sent through a specific network
+  // interface have their own socket.
+  zmq::socket_t *socket = this->publisher.get();
+  std::mutex *socketMutex = &this->publisherMutex;
+  std::map<std::string, uint64_t> *pubSeq = &this->topicPubSeq;
+  const std::string *address = &_shared->myAddress;
+  bool highPriority = false;
+  if (this->priorityCount > 0 || this->interfaceCount > 0)
+  {
+    std::lock_guard<std::mutex> lk(this->priorityMutex);
+    PriorityPublisher *lane = nullptr;
+    if (this->priorityTopics.find(_topic) != this->priorityTopics.end())
     {
-      try
-      {
-        zmq::poll(&items[0], sizeof(items) / sizeof(items[0]),
-            std::chrono::milliseconds(NodeSharedPrivate::Timeout));
-      }
-      catch(...)
-      {
-        continue;
-      }
-
-      if (items[0].revents & ZMQ_POLLIN)
-      {
-        // Get the version.
-        version = receiveHelper(*sock);
-        if (version.empty())
-          break;
-
-        // Get remaining data
-        sequence = receiveHelper(*sock);
-        domain = receiveHelper(*sock);
-        address = receiveHelper(*sock);
-        routingId = receiveHelper(*sock);
-        mechanism = receiveHelper(*sock);
-        givenUsername = receiveHelper(*sock);
-        givenPassword = receiveHelper(*sock);
-
-        // eliminate unused variable warning when debug statements are commented
-        (void)routingId;
+      lane = this->priorityPublisher.get();
+      highPriority = true;
+    }
+    else
+    {
+      // Topics sent through the socket of a network interface.
+      auto it = this->interfaceTopics.find(_topic);
+      if (it != this->interfaceTopics.end())
+        lane = it->second.first;
+    }
 
-        // Debug statements
-        // std::cout << "Version[" << version << "]\n";
-        // std::cout << "Sequence[" << sequence << "]\n";
-        // std::cout << "Domain[" << domain << "]\n";
-        // std::cout << "Address[" << address << "]\n";
-        // std::cout << "Routing Id[" << routingId << "]\n";
-        // std::cout << "Mechanism[" << mechanism << "]\n";
-        // std::cout << "Username[" << givenUsername << "] [" << user << "]\n";
-        // std::cout << "Pass[" << givenPassword << "] [" << pass << "]\n";
+    if (lane)
+    {
+      socket = lane->socket.get();
+      socketMutex = &lane->mutex;
+      pubSeq = &lane->topicPubSeq;
+      address = &lane->address;
+    }
+  }
 
-        // Check that we received some kind of address. This could be used
-        // in the future to only accept connections from specific addresses.
-        if (address.empty())
-        {
-          sendAuthErrorHelper(*sock, "Invalid address");
-          continue;
-        }
+  // The trace of the publication, if any, travels right after the metadata.
+  // Publications without a trace (e.g. batches) start a new one.
+  TraceMetadata trace;
+  if (this->traceEnabled)
+  {
+    trace = Tracer::Current();
+    if (trace.traceId == 0)
+    {
+      trace.traceId = Tracer::Instance().NewTraceId();
+      trace.publishStamp = Tracer::Now();
+    }
+    trace.sendStamp = Tracer::Now();
+  }
 
-        // Check the version
-        if (version != "1.0")
-        {
-          sendAuthErrorHelper(*sock, "Invalid version");
-          continue;
-        }
+  auto traceSent = [&]()
+  {
+    if (trace.traceId == 0)
+      return;
+    Tracer &tracer = Tracer::Instance();
+    const uint64_t now = Tracer::Now();
+    tracer.Span("zmq_send", _topic, trace.traceId, trace.sendStamp, now);
+    tracer.Flow(true, trace.traceId, trace.sendStamp);
+  };
+
+  // Large publications are sent one fragment at a time by the fragment
+  // thread, so they don't hold back the other topics. The high priority
+  // topics have their own socket and are never delayed.
+  if (this->fragmentSize > 0 && !this->compactHeader && !highPriority &&
+      (_data.size() > this->fragmentSize || this->fragmentCount > 0) &&
+      this->QueueFragments(_topic, *msgType, *socket, *socketMutex, *pubSeq,
+        *address, _data, trace))
+  {
+    return true;
+  }
 
-        // Check the mechanism
-        if (mechanism != "PLAIN")
-        {
-          sendAuthErrorHelper(*sock, "Invalid mechanism");
-          continue;
-        }
+  try
+  {
+    std::lock_guard<std::mutex> lock(*socketMutex);
 
-        // Check the domain
-        if (std::strcmp(domain.c_str(), kGzAuthDomain) != 0)
-        {
-          sendAuthErrorHelper(*sock, "Invalid domain");
-          continue;
-        }
+    // Create publication metadata.
+    const PublicationMetadata meta = this->NextMetadata(_topic, *pubSeq);
 
+    if (this->compactHeader)
+    {
+      // Topic ID followed by the metadata, then the data.
+      const std::string filter = CompactFilter(
+        CompactTopicId(_topic, *msgType, *address));
+      const std::size_t traceSize = this->traceEnabled ? sizeof(trace) : 0;
+      zmq::message_t header(kCompactHeaderSize + traceSize);
+      char *headerData = static_cast<char *>(header.data());
+      memcpy(headerData, filter.data(), filter.size());
+      memcpy(headerData + filter.size(), &meta, sizeof(meta));
+      if (traceSize > 0)
+        memcpy(headerData + kCompactHeaderSize, &trace, traceSize);
+      // The send fails (EAGAIN) if the message can't be queued.
 #ifdef GZ_ZMQ_POST_4_3_1
-        sendHelper(*sock, version, zmq::send_flags::sndmore);
-        sendHelper(*sock, sequence, zmq::send_flags::sndmore);
+      if (!socket->send(header, zmq::send_flags::sndmore) ||
+          !socket->send(_data, zmq::send_flags::none))
 #else
-        sendHelper(*sock, version, ZMQ_SNDMORE);
-        sendHelper(*sock, sequence, ZMQ_SNDMORE);
+      if (!socket->send(header, ZMQ_SNDMORE) || !socket->send(_data, 0))
 #endif
+      {
+        return false;
+      }
+      traceSent();
+      return true;
+    }
 
-        // Check the username and password
-        if (givenUsername == user && givenPassword == pass)
-        {
+    if (!this->SendFrames(*socket, _topic, *address, _data, *msgType, meta,
+          trace))
+    {
+      return false;
+    }
+  }
+  catch(const zmq::error_t& ze)
+  {
+     std::cerr << "NodeShared::Publish() Error: " << ze.what() << std::endl;
+     return false;
+  }
+
+  traceSent();
+  return true;
+}
+
+//////////////////////////////////////////////////
+PublicationMetadata NodeSharedPrivate::NextMetadata(
+    const std::string &_topic, std::map<std::string, uint64_t> &_pubSeq) const
+{
+  PublicationMetadata meta;
+  if (this->metadataEnabled)
+  {
+    // Send the sequence number, which can be used to detect dropped
+    // messages.
+    meta.seq = _pubSeq[_topic]++;
+    // Send the publication time. The system clock is comparable across
+    // processes, see DrainStats().
+    meta.stamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+  return meta;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::SendFrames(zmq::socket_t &_socket,
+    const std::string &_topic, const std::string &_address,
+    zmq::message_t &_data, const std::string &_msgType,
+    const PublicationMetadata &_meta, const TraceMetadata &_trace)
+{
+  // The topic frame is null-terminated with exact topics.
+  zmq::message_t msg0(_topic.size() + (this->exactTopics ? 1 : 0)),
+                 msg1(_address.data(), _address.size()),
+                 msg3(_msgType.data(), _msgType.size());
+  memcpy(msg0.data(), _topic.data(), _topic.size());
+  if (this->exactTopics)
+    static_cast<char *>(msg0.data())[_topic.size()] = '\0';
+
+  // The remaining frames are accepted once the first one is.
 #ifdef GZ_ZMQ_POST_4_3_1
-          sendHelper(*sock, "200", zmq::send_flags::sndmore);
-          sendHelper(*sock, "OK", zmq::send_flags::sndmore);
-          sendHelper(*sock, "anonymous", zmq::send_flags::sndmore);
-          sendHelper(*sock, "", zmq::send_flags::none);
+  if (!_socket.send(msg0, zmq::send_flags::sndmore))
+    return false;
+  _socket.send(msg1, zmq::send_flags::sndmore);
+  _socket.send(_data, zmq::send_flags::sndmore);
 #else
-          sendHelper(*sock, "200", ZMQ_SNDMORE);
-          sendHelper(*sock, "OK", ZMQ_SNDMORE);
-          sendHelper(*sock, "anonymous", ZMQ_SNDMORE);
-          sendHelper(*sock, "", 0);
+  if (!_socket.send(msg0, ZMQ_SNDMORE))
+    return false;
+  _socket.send(msg1, ZMQ_SNDMORE);
+  _socket.send(_data, ZMQ_SNDMORE);
 #endif
-        }
-        else
-        {
-          sendAuthErrorHelper(*sock, "Invalid username or password");
-        }
-      }
+
+  if (this->metadataEnabled || this->traceEnabled)
+  {
+    const std::size_t traceSize = this->traceEnabled ? sizeof(_trace) : 0;
+    zmq::message_t msg4(sizeof(_meta) + traceSize);
+    memcpy(msg4.data(), &_meta, sizeof(_meta));
+    if (traceSize > 0)
+    {
+      memcpy(static_cast<char *>(msg4.data()) + sizeof(_meta), &_trace,
+        traceSize);
     }
+#ifdef GZ_ZMQ_POST_4_3_1
+    _socket.send(msg3, zmq::send_flags::sndmore);
+    _socket.send(msg4, zmq::send_flags::none);
+#else
+    _socket.send(msg3, ZMQ_SNDMORE);
+    _socket.send(msg4, 0);
+#endif
   }
-  catch (...)
+  else
   {
-    // This catch can be triggered when ctrl-c is pressed and the context is
-    // deleted. Capture this case, and quit gracefully.
+#ifdef GZ_ZMQ_POST_4_3_1
+    _socket.send(msg3, zmq::send_flags::none);
+#else
+    _socket.send(msg3, 0);
+#endif
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool NodeSharedPrivate::QueueFragments(const std::string &_topic,
+    const std::string &_msgType, zmq::socket_t &_socket,
+    std::mutex &_socketMutex, std::map<std::string, uint64_t> &_pubSeq,
+    const std::string &_address, zmq::message_t &_data,
+    const TraceMetadata &_trace)
+{
+  std::lock_guard<std::mutex> lk(this->fragmentMutex);
+  const bool large = _data.size() > this->fragmentSize;
+  auto it = this->fragmentTopics.find(_topic);
+  if (!large && it == this->fragmentTopics.end())
+    return false;
+
+  auto pub = std::make_shared<FragmentedPublication>();
+  pub->socket = &_socket;
+  pub->socketMutex = &_socketMutex;
+  pub->address = _address;
+  pub->msgType = _msgType;
+  pub->trace = _trace;
+  pub->header.id = this->nextFragmentId++;
+  pub->header.size = _data.size();
+  pub->header.count = large ? static_cast<uint32_t>(
+    (_data.size() + this->fragmentSize - 1) / this->fragmentSize) : 1u;
+  pub->data = std::make_shared<zmq::message_t>(std::move(_data));
+  {
+    std::lock_guard<std::mutex> socketLk(_socketMutex);
+    pub->meta = this->NextMetadata(_topic, _pubSeq);
   }
 
-  sock->close();
-  delete sock;
+  this->fragmentTopics[_topic].push_back(std::move(pub));
+  this->fragmentCount = this->fragmentTopics.size();
+
+  if (!this->fragmentThread.joinable())
+  {
+    this->fragmentThread = std::thread(&NodeSharedPrivate::RunFragmentTask,
+      this);
+  }
+  this->fragmentCondition.notify_one();
+  return true;
 }
 
-/////////////////////////////////////////////////
-void NodeSharedPrivate::PublishThread()
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunFragmentTask()
 {
-  // Loop until exits
+  setupThread("BACKGROUND", "gz-fragment");
+
+  std::unique_lock<std::mutex> lk(this->fragmentMutex);
+  std::string lastTopic;
+  auto next = std::chrono::steady_clock::now();
   while (!this->exit)
   {
-    std::unique_ptr<PublishMsgDetails> msgDetails = nullptr;
-    // Lock the mutex, and acquire the next message to be published.
+    if (this->fragmentTopics.empty())
     {
-      std::unique_lock<std::mutex> queueLock(this->pubThreadMutex);
-
-      // Wait for more messages if the queue is empty. Otherwise get the
-      // next message and continue.
-      if (this->pubQueue.empty())
-      {
-        auto now = std::chrono::system_clock::now();
-        this->signalNewPub.wait_until(queueLock, now + 500ms,
-          [&]{return !this->pubQueue.empty() || this->exit;});
-      }
-
-      if (this->pubQueue.empty())
-        continue;
+      this->fragmentCondition.wait_for(lk,
+        std::chrono::milliseconds(NodeSharedPrivate::Timeout));
+      continue;
+    }
 
-      // Stop early on exit.
-      if (this->exit)
-        break;
+    // The topics take turns, one fragment each.
+    auto it = this->fragmentTopics.upper_bound(lastTopic);
+    if (it == this->fragmentTopics.end())
+      it = this->fragmentTopics.begin();
+    lastTopic = it->first;
 
-      // Get the message
-      msgDetails = std::move(this->pubQueue.front());
-      this->pubQueue.pop_front();
+    std::shared_ptr<FragmentedPublication> pub = it->second.front();
+    const uint32_t index = pub->next++;
+    if (pub->next >= pub->header.count)
+    {
+      it->second.pop_front();
+      if (it->second.empty())
+        this->fragmentTopics.erase(it);
+      this->fragmentCount = this->fragmentTopics.size();
     }
 
-    // Send the message to all the local handlers.
-    for (auto &handler : msgDetails->localHandlers)
+    lk.unlock();
+    const std::size_t size = this->SendFragment(lastTopic, *pub, index);
+
+    // Pace the fragments, leaving room in the connections for the other
+    // publications.
+    if (this->fragmentRate > 0 && pub->header.count > 1)
     {
+      const auto now = std::chrono::steady_clock::now();
+      next = std::max(next, now) + std::chrono::microseconds(
+        size / static_cast<std::size_t>(this->fragmentRate));
+      std::this_thread::sleep_until(next);
+    }
+    lk.lock();
+  }
+}
 
-      // Check here if we want to ignore local publications.
-      if (handler->IgnoreLocalMessages() &&
-          msgDetails->publisherNodeUUID == handler->NodeUuid())
+//////////////////////////////////////////////////
+std::size_t NodeSharedPrivate::SendFragment(const std::string &_topic,
+    FragmentedPublication &_pub, const uint32_t _index)
+{
+  zmq::message_t data;
+  std::string fragmentType;
+  const std::string *msgType = &_pub.msgType;
+  if (_pub.header.count == 1)
+  {
+    data = std::move(*_pub.data);
+  }
+  else
+  {
+    // The fragments point to the payload, which is released with the last
+    // one.
+    const std::size_t offset = _index * this->fragmentSize;
+    const std::size_t size =
+      std::min(this->fragmentSize, _pub.data->size() - offset);
+    auto *owner = new std::shared_ptr<zmq::message_t>(_pub.data);
+    data.rebuild(static_cast<char *>(_pub.data->data()) + offset, size,
+      [](void *, void *_hint)
       {
-        continue;
-      }
+        delete static_cast<std::shared_ptr<zmq::message_t> *>(_hint);
+      }, owner);
 
-      try
-      {
-        handler->RunLocalCallback(*(msgDetails->msgCopy.get()),
-            msgDetails->info);
-      }
-      catch (...)
-      {
-        std::cerr << "Exception occurred in a local callback "
-          << "on topic [" << msgDetails->info.Topic() << "] with message ["
-          << msgDetails->msgCopy->DebugString() << "]" << std::endl;
-      }
+    FragmentHeader header = _pub.header;
+    header.index = _index;
+    fragmentType = FragmentReassembler::TypeFrame(header, _pub.msgType);
+    msgType = &fragmentType;
+  }
+
+  const std::size_t size = data.size();
+  try
+  {
+    std::lock_guard<std::mutex> lock(*_pub.socketMutex);
+    this->SendFrames(*_pub.socket, _topic, _pub.address, data, *msgType,
+      _pub.meta, _pub.trace);
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Error sending a fragment on topic [" << _topic << "]: "
+              << _error.what() << std::endl;
+  }
+  return size;
+}
+
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::TopicFilter(const std::string &_topic) const
+{
+  if (!this->exactTopics)
+    return _topic;
+
+  return _topic + '\0';
+}
+
+//////////////////////////////////////////////////
+uint64_t NodeSharedPrivate::CompactTopicId(const std::string &_topic,
+    const std::string &_msgType, const std::string &_addr)
+{
+  // 64-bit FNV-1a of the three strings, separated by a null character.
+  uint64_t hash = 14695981039346656037ull;
+  for (const std::string *str : {&_topic, &_msgType, &_addr})
+  {
+    for (const char c : *str)
+    {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
     }
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::CompactFilter(uint64_t _id)
+{
+  std::string filter(sizeof(_id), '\0');
+  for (std::size_t i = 0; i < sizeof(_id); ++i)
+    filter[i] = static_cast<char>((_id >> (8 * i)) & 0xFF);
+  return filter;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> NodeSharedPrivate::RegisterCompactTopic(
+    const MessagePublisher &_pub)
+{
+  std::vector<std::string> filters;
+  std::unique_lock<std::shared_mutex> lk(this->compactTopicsMutex);
+
+  // The publisher may batch, latch and compress its publications, which use
+  // their own IDs.
+  std::vector<std::string> msgTypes;
+  for (auto codec :
+    {Compression_t::NONE, Compression_t::LZ4, Compression_t::ZSTD})
+  {
+    if (!Compression::Supported(codec))
+      continue;
 
-    // Send the message to all the raw handlers.
-    for (auto &handler : msgDetails->rawHandlers)
+    const std::string prefix = Compression::TypePrefix(codec);
+    msgTypes.push_back(prefix + _pub.MsgTypeName());
+    msgTypes.push_back(prefix + kBatchMsgTypePrefix + _pub.MsgTypeName());
+    msgTypes.push_back(prefix + kLatchedMsgTypePrefix + _pub.MsgTypeName());
+  }
+
+  for (const std::string &msgType : msgTypes)
+  {
+    CompactTopic entry{_pub.Topic(), msgType, _pub.Addr()};
+    const uint64_t id = CompactTopicId(entry.topic, msgType, entry.sender);
+    auto [it, inserted] = this->compactTopics.try_emplace(id, entry);
+    if (inserted)
     {
-      try
-      {
-        handler->RunRawCallback(msgDetails->sharedBuffer.get(),
-            msgDetails->msgSize, msgDetails->info);
-      }
-      catch (...)
-      {
-        std::cerr << "Exception occured in a local raw callback "
-          << "on topic [" << msgDetails->info.Topic() << "] with "
-          << "message [" << msgDetails->msgCopy->DebugString() << "]"
-          << std::endl;
-      }
+      filters.push_back(CompactFilter(id));
+    }
+    else if (it->second.topic != entry.topic ||
+             it->second.msgType != entry.msgType ||
+             it->second.sender != entry.sender)
+    {
+      std::cerr << "Topic ID collision between [" << it->second.topic
+                << "] and [" << entry.topic << "]. Messages published on ["
+                << entry.topic << "] by [" << entry.sender << "] will be "
+                << "ignored" << std::endl;
     }
   }
+
+  return filters;
 }
 
 //////////////////////////////////////////////////
-std::optional<transport::TopicStatistics> NodeShared::TopicStats(
-    const std::string &_topic) const
+uint64_t NodeSharedPrivate::ServiceId(const std::string &_topic,
+    const std::string &_reqType, const std::string &_repType)
 {
-  if (this->dataPtr->topicStats.find(_topic) != this->dataPtr->topicStats.end())
-    return this->dataPtr->topicStats.at(_topic);
-  return std::nullopt;
+  return CompactTopicId(_topic, _reqType, _repType);
 }
 
 //////////////////////////////////////////////////
-void NodeShared::EnableStats(const std::string &_topic, bool _enable,
-    std::function<void(const TopicStatistics &_stats)> _statCb)
+void NodeSharedPrivate::RegisterEnvelopeService(const ServicePublisher &_pub)
 {
-  if (_enable)
+  // The same service receives regular, batched and streamed requests.
+  for (const std::string &prefix :
+    {std::string(), kBatchReqTypePrefix, kStreamReqTypePrefix})
   {
-    this->dataPtr->enabledTopicStatistics.insert({_topic, _statCb});
+    EnvelopeService entry{_pub.Topic(), prefix + _pub.ReqTypeName(),
+      _pub.RepTypeName()};
+    const uint64_t id = ServiceId(entry.topic, entry.reqType, entry.repType);
+    auto [it, inserted] = this->envelopeServices.try_emplace(id, entry);
+    if (!inserted && (it->second.topic != entry.topic ||
+        it->second.reqType != entry.reqType ||
+        it->second.repType != entry.repType))
+    {
+      std::cerr << "Service ID collision between [" << it->second.topic
+                << "] and [" << entry.topic << "]. Single frame requests of ["
+                << entry.topic << "] will be ignored" << std::endl;
+    }
   }
-  else
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> NodeSharedPrivate::UnregisterCompactTopic(
+    const std::string &_topic)
+{
+  std::vector<std::string> filters;
+  std::unique_lock<std::shared_mutex> lk(this->compactTopicsMutex);
+  for (auto it = this->compactTopics.begin();
+       it != this->compactTopics.end();)
   {
-    this->dataPtr->enabledTopicStatistics.extract(_topic);
-    // \todo Also cleanup topicStats.
+    if (it->second.topic == _topic)
+    {
+      filters.push_back(CompactFilter(it->first));
+      it = this->compactTopics.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
   }
+  return filters;
 }
 
 /////////////////////////////////////////////////
@@ -1969,3 +8270,195 @@ std::vector<std::string> NodeShared::GlobalRelays() const {
 
   return std::vector<std::string>(srvRelaySet.cbegin(), srvRelaySet.cend());
 }
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::StartMetrics()
+{
+  Metrics &metrics = Metrics::Instance();
+  const PubQueue *queue = &this->pubLane->queue;
+  metrics.SetGauge("gz_transport_pub_queue_depth",
+    "Local publications waiting to be delivered.",
+    [queue]() {return static_cast<double>(queue->Depth());});
+  metrics.SetGauge("gz_transport_pub_queue_high_water_mark",
+    "Largest number of local publications waiting to be delivered.",
+    [queue]() {return static_cast<double>(queue->HighWaterMark());});
+  metrics.SetGauge("gz_transport_pub_queue_dropped_messages",
+    "Local publications dropped because the queue was full.",
+    [this]() {return static_cast<double>(this->pubQueueDropped.load());});
+
+  MemoryBudget *budget = &this->memoryBudget;
+  metrics.SetGauge("gz_transport_memory_used_bytes",
+    "Memory held by the local publications and the latched messages.",
+    [budget]() {return static_cast<double>(budget->Used());});
+  metrics.SetGauge("gz_transport_memory_peak_bytes",
+    "Largest memory held by the local publications and the latched "
+    "messages.",
+    [budget]() {return static_cast<double>(budget->Peak());});
+  metrics.SetGauge("gz_transport_memory_budget_bytes",
+    "Memory budget of the local publications, 0 if unlimited.",
+    [budget]() {return static_cast<double>(budget->Limit());});
+  metrics.SetGauge("gz_transport_memory_rejected_messages",
+    "Local publications dropped because the memory budget was exhausted.",
+    [budget]() {return static_cast<double>(budget->Rejected());});
+  metrics.SetGaugeFamily("gz_transport_topic_memory_bytes",
+    "Memory held by the local publications and the latched messages of a "
+    "topic.", "topic", [budget]()
+    {
+      std::map<std::string, double> values;
+      for (const auto &[topic, used] : budget->Usage())
+        values[topic] = static_cast<double>(used);
+      return values;
+    });
+
+  const int port = this->NonNegativeEnvVar("GZ_TRANSPORT_METRICS_PORT", 0);
+  if (port <= 0)
+    return;
+
+  // A ZMQ_STREAM socket exchanges raw TCP data, enough for a minimal HTTP
+  // server.
+  try
+  {
+    this->metricsSocket.reset(new zmq::socket_t(*this->context, ZMQ_STREAM));
+    int lingerVal = 0;
+#ifdef GZ_CPPZMQ_POST_4_7_0
+    this->metricsSocket->set(zmq::sockopt::linger, lingerVal);
+#else
+    this->metricsSocket->setsockopt(ZMQ_LINGER, &lingerVal,
+      sizeof(lingerVal));
+#endif
+    this->metricsSocket->bind("tcp://*:" + std::to_string(port));
+  }
+  catch(const zmq::error_t &_error)
+  {
+    std::cerr << "Unable to serve the metrics on port [" << port << "]: "
+              << _error.what() << std::endl;
+    this->metricsSocket.reset();
+    return;
+  }
+
+  // The thread blocks until a request comes or StopMetrics() wakes it up.
+  this->CreateWakePair("metrics", this->metricsWakeSender,
+    this->metricsWakeReceiver);
+  this->metricsThread = std::thread(&NodeSharedPrivate::RunMetricsServer,
+    this);
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::StopMetrics()
+{
+  if (this->metricsThread.joinable())
+  {
+    Wake(*this->metricsWakeSender);
+    this->metricsThread.join();
+  }
+  this->metricsSocket.reset();
+
+  Metrics &metrics = Metrics::Instance();
+  metrics.RemoveGauge("gz_transport_pub_queue_depth");
+  metrics.RemoveGauge("gz_transport_pub_queue_high_water_mark");
+  metrics.RemoveGauge("gz_transport_pub_queue_dropped_messages");
+  metrics.RemoveGauge("gz_transport_memory_used_bytes");
+  metrics.RemoveGauge("gz_transport_memory_peak_bytes");
+  metrics.RemoveGauge("gz_transport_memory_budget_bytes");
+  metrics.RemoveGauge("gz_transport_memory_rejected_messages");
+  metrics.RemoveGauge("gz_transport_topic_memory_bytes");
+}
+
+//////////////////////////////////////////////////
+void NodeSharedPrivate::RunMetricsServer()
+{
+  setupThread("BACKGROUND", "gz-metrics");
+
+  while (!this->exit)
+  {
+    zmq::pollitem_t items[] =
+    {
+      {static_cast<void*>(*this->metricsSocket), 0, ZMQ_POLLIN, 0},
+      {static_cast<void*>(*this->metricsWakeReceiver), 0, ZMQ_POLLIN, 0}
+    };
+
+    // There is no timeout, StopMetrics() wakes us up.
+    try
+    {
+      zmq::poll(&items[0], 2, std::chrono::milliseconds(-1));
+    }
+    catch(...)
+    {
+      continue;
+    }
+
+    if (!(items[0].revents & ZMQ_POLLIN))
+      continue;
+
+    try
+    {
+      // Every message is the connection ID followed by the data.
+      zmq::message_t id;
+      zmq::message_t data;
+#ifdef GZ_ZMQ_POST_4_3_1
+      if (!this->metricsSocket->recv(id) || !id.more() ||
+          !this->metricsSocket->recv(data))
+#else
+      if (!this->metricsSocket->recv(&id, 0) || !id.more() ||
+          !this->metricsSocket->recv(&data, 0))
+#endif
+      {
+        continue;
+      }
+
+      // Empty data notifies a new or closed connection.
+      if (data.size() == 0)
+        continue;
+
+      const std::string response = MetricsResponse(
+        std::string(static_cast<char *>(data.data()), data.size()));
+
+      // Send the response, then close the connection with an empty frame.
+      zmq::message_t idCopy;
+      idCopy.copy(id);
+      zmq::message_t reply(response.data(), response.size());
+      zmq::message_t close(0);
+#ifdef GZ_ZMQ_POST_4_3_1
+      this->metricsSocket->send(id, zmq::send_flags::sndmore);
+      this->metricsSocket->send(reply, zmq::send_flags::none);
+      this->metricsSocket->send(idCopy, zmq::send_flags::sndmore);
+      this->metricsSocket->send(close, zmq::send_flags::none);
+#else
+      this->metricsSocket->send(id, ZMQ_SNDMORE);
+      this->metricsSocket->send(reply, 0);
+      this->metricsSocket->send(idCopy, ZMQ_SNDMORE);
+      this->metricsSocket->send(close, 0);
+#endif
+    }
+    catch(const zmq::error_t &_error)
+    {
+      std::cerr << "Metrics endpoint error: " << _error.what() << std::endl;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::string NodeSharedPrivate::MetricsResponse(const std::string &_request)
+{
+  const std::string requestLine = _request.substr(0, _request.find('\r'));
+
+  std::string status = "200 OK";
+  std::string contentType =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+  std::string body;
+  if (requestLine.rfind("GET /metrics ", 0) == 0)
+  {
+    body = Metrics::Instance().OpenMetrics();
+  }
+  else
+  {
+    status = "404 Not Found";
+    contentType = "text/plain; charset=utf-8";
+    body = "Not found. The metrics are available at /metrics\n";
+  }
+
+  return "HTTP/1.1 " + status + "\r\n" +
+    "Content-Type: " + contentType + "\r\n" +
+    "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+    "Connection: close\r\n\r\n" + body;
+}
@@ -18,18 +18,49 @@
 #ifndef GZ_TRANSPORT_NODESHAREDPRIVATE_HH_
 #define GZ_TRANSPORT_NODESHAREDPRIVATE_HH_
 
+#include <gz/msgs/uint64_v.pb.h>
+
 #include <zmq.hpp>
 
+#include <algorithm>
 #include <atomic>
-#include <list>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>  //NOLINT
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "gz/transport/Discovery.hh"
 #include "gz/transport/Node.hh"
 
+#include "CallbackExecutor.hh"
+#include "CallbackGroup.hh"
+#include "Compression.hh"
+#include "ContentFilter.hh"
+#include "DispatchExecutor.hh"
+#include "FdChannel.hh"
+#include "Fragments.hh"
+#include "MemoryBudget.hh"
+#include "MpscQueue.hh"
+#include "ReliableReceiver.hh"
+#include "ServiceEnvelope.hh"
+#include "ShmSegment.hh"
+#include "SpinQueue.hh"
+#include "TimerWheel.hh"
+#include "Tracer.hh"
+
 namespace gz
 {
   namespace transport
@@ -41,11 +72,657 @@ namespace gz
     /// message for topic statistics.
     class PublicationMetadata
     {
-      /// \brief Publication timestamp.
+      /// \brief Publication timestamp, from the system clock (microseconds
+      /// since the Unix epoch).
       public: uint64_t stamp = 0;
 
       /// \brief Sequence number, used to detect dropped messages.
       public: uint64_t seq = 0;
+
+      /// \brief Check whether the stamp comes from an older publisher, which
+      /// stamps with its steady clock, in milliseconds.
+      /// \return True if the stamp is below kLegacyStampLimit.
+      public: bool LegacyStamp() const
+      {
+        return this->stamp < kLegacyStampLimit;
+      }
+
+      /// \brief Stamps below this value are in milliseconds of the steady
+      /// clock. In microseconds of the system clock, it is a date in 1973;
+      /// in milliseconds of the steady clock, an uptime of 3000 years.
+      public: static constexpr uint64_t kLegacyStampLimit =
+        100000000000000u;
+    };
+
+    //
+    /// \brief Additional subscriber socket used to shard the reception of
+    /// remote topics. Each shard is serviced by its own reception thread,
+    /// which is the only thread using the shard's socket. Other threads
+    /// request connections and topic filters through the pending list and
+    /// wake up the reception thread with an inproc signal.
+    class SubscriberShard
+    {
+      /// \brief Operations that can be requested to a shard.
+      public: enum class Op
+              {
+                /// \brief Connect to a publisher address.
+                CONNECT,
+
+                /// \brief Disconnect from a publisher address.
+                DISCONNECT,
+
+                /// \brief Add a topic filter.
+                SUBSCRIBE,
+
+                /// \brief Remove a topic filter.
+                UNSUBSCRIBE
+              };
+
+      /// \brief ZMQ socket to receive topic updates.
+      public: std::unique_ptr<zmq::socket_t> socket;
+
+      /// \brief Socket used to wake up the reception thread.
+      public: std::unique_ptr<zmq::socket_t> wakeSender;
+
+      /// \brief Socket polled by the reception thread for wake ups.
+      public: std::unique_ptr<zmq::socket_t> wakeReceiver;
+
+      /// \brief Operations requested to the reception thread.
+      public: std::vector<std::pair<Op, std::string>> pending;
+
+      /// \brief Protects pending and wakeSender.
+      public: std::mutex mutex;
+
+      /// \brief Publisher addresses this shard is connected to. Only used by
+      /// the reception thread.
+      public: std::set<std::string> addresses;
+
+      /// \brief Reception thread.
+      public: std::thread thread;
+    };
+
+    /// \brief A node watching the topic graph.
+    class TopicGraphWatcher
+    {
+      /// \brief Partition of the node. Only the publishers of this partition
+      /// are notified.
+      public: std::string partition;
+
+      /// \brief Callback notified with the changes.
+      public: TopicGraphCallback cb;
+    };
+
+    /// \brief Shared memory segment written by this process for one of its
+    /// advertised topics.
+    class ShmWriter
+    {
+      /// \brief The segment.
+      public: std::unique_ptr<ShmSegment> segment;
+
+      /// \brief Serializes the writes of all the publishers of the topic.
+      public: std::mutex mutex;
+
+      /// \brief Process UUIDs of the remote subscribers of the topic.
+      public: std::set<std::string> remoteProcs;
+
+      /// \brief True when remoteProcs has to be rebuilt.
+      public: std::atomic<bool> remoteProcsDirty{true};
+
+      /// \brief Doorbells of the remote subscribers, rung after every
+      /// message. The key is the process UUID.
+      public: std::map<std::string, std::unique_ptr<ShmDoorbell>> doorbells;
+    };
+
+    /// \brief Shared memory segment of a remote publisher read by this
+    /// process.
+    class ShmReader
+    {
+      /// \brief The segment.
+      public: std::unique_ptr<ShmSegment> segment;
+
+      /// \brief Topic of the segment.
+      public: std::string topic;
+
+      /// \brief Message type of the topic.
+      public: std::string msgType;
+
+      /// \brief Process UUID of the writer.
+      public: std::string pUuid;
+    };
+
+    /// \brief Descriptor channel of a topic published by another process of
+    /// this host, see Node::Publisher::PublishFd.
+    class FdReader
+    {
+      /// \brief The channel.
+      public: std::unique_ptr<FdChannel> channel;
+
+      /// \brief Topic of the channel.
+      public: std::string topic;
+
+      /// \brief Message type of the topic.
+      public: std::string msgType;
+
+      /// \brief Process UUID of the publisher.
+      public: std::string pUuid;
+    };
+
+    /// \brief Remote publications of a topic waiting to be sent together.
+    class PublicationBatch
+    {
+      /// \brief Message type sent in the type frame of the batch.
+      public: std::string batchMsgType;
+
+      /// \brief Maximum number of messages per batch.
+      public: uint64_t maxMsgs = 1;
+
+      /// \brief Maximum time that a message waits in the batch.
+      public: std::chrono::microseconds period{0};
+
+      /// \brief Number of publishers of this process using the batch.
+      public: std::size_t publishers = 0;
+
+      /// \brief Messages in the batch, each one preceded by its size.
+      public: std::string buffer;
+
+      /// \brief Number of messages in the batch.
+      public: uint64_t count = 0;
+
+      /// \brief Time when the batch has to be sent.
+      public: std::chrono::steady_clock::time_point deadline;
+    };
+
+    /// \brief Compression settings of a topic advertised by this process.
+    class TopicCompression
+    {
+      /// \brief Codec requested by the publisher.
+      public: Compression_t codec = Compression_t::NONE;
+
+      /// \brief Compression level.
+      public: int level = 0;
+
+      /// \brief Number of publishers of this process using the settings.
+      public: std::size_t publishers = 0;
+
+      /// \brief Whether all the remote subscribers accept the codec.
+      public: bool accepted = false;
+
+      /// \brief True when accepted has to be recomputed.
+      public: std::atomic<bool> subscribersDirty{true};
+
+      /// \brief Protects accepted.
+      public: std::mutex mutex;
+    };
+
+    /// \brief Bound on the local publications of a publisher waiting in the
+    /// publication queue.
+    class PublicationBound
+    {
+      /// \brief Maximum number of waiting publications.
+      public: std::size_t depth = 0;
+
+      /// \brief What happens when the bound is reached.
+      public: QueuePolicy_t policy = QueuePolicy_t::DROP_OLDEST;
+
+      /// \brief Protects pending and skip.
+      public: std::mutex mutex;
+
+      /// \brief Signaled when a publication leaves the queue, for the
+      /// KEEP_ALL publishers waiting for room.
+      public: std::condition_variable room;
+
+      /// \brief Publications of the publisher in the queue.
+      public: std::size_t pending = 0;
+
+      /// \brief Number of the next publications popped that have to be
+      /// dropped, because newer ones replaced them.
+      public: std::size_t skip = 0;
+    };
+
+    /// \brief Last messages published on a topic advertised with latching.
+    class LatchedTopic
+    {
+      /// \brief A serialized message and its size.
+      public: using Msg = std::pair<std::shared_ptr<char[]>, std::size_t>;
+
+      /// \brief Message type of the topic.
+      public: std::string msgType;
+
+      /// \brief Maximum number of messages kept.
+      public: uint64_t depth = 0;
+
+      /// \brief Number of publishers of this process using the cache.
+      public: std::size_t publishers = 0;
+
+      /// \brief Messages kept, from the oldest to the newest.
+      public: std::deque<Msg> msgs;
+
+      /// \brief Memory charged for each message kept.
+      public: std::deque<MemoryBudget::Charge> charges;
+
+      /// \brief Memory account of the topic.
+      public: MemoryBudget::Account *account = nullptr;
+
+      /// \brief Number of messages stored since the cache was created.
+      public: uint64_t stored = 0;
+    };
+
+    /// \brief Latched messages waiting to be sent to a new remote
+    /// subscriber node.
+    class LatchedReplay
+    {
+      /// \brief Fully qualified topic name.
+      public: std::string topic;
+
+      /// \brief UUID of the subscriber node.
+      public: std::string nUuid;
+
+      /// \brief Value of LatchedTopic::stored when the node registered.
+      public: uint64_t stored = 0;
+
+      /// \brief Time when the messages have to be sent.
+      public: std::chrono::steady_clock::time_point deadline;
+    };
+
+    /// \brief Last messages published on a reliable topic, kept for the
+    /// subscribers that lose them.
+    class ReliableTopic
+    {
+      /// \brief Type frame of the publications.
+      public: std::string reliableMsgType;
+
+      /// \brief Maximum number of messages kept.
+      public: uint64_t depth = 0;
+
+      /// \brief Number of publishers of this process using the buffer.
+      public: std::size_t publishers = 0;
+
+      /// \brief Sequence number of the oldest message kept.
+      public: uint64_t first = 0;
+
+      /// \brief Payloads of the messages kept, each one starting with its
+      /// sequence number, from the oldest to the newest.
+      public: std::deque<std::shared_ptr<const std::string>> msgs;
+
+      /// \brief Memory charged for each message kept.
+      public: std::deque<MemoryBudget::Charge> charges;
+
+      /// \brief Memory account of the topic.
+      public: MemoryBudget::Account *account = nullptr;
+
+      /// \brief Time of the last publication.
+      public: std::chrono::steady_clock::time_point lastPublication;
+
+      /// \brief Whether the last message was sent again after the last
+      /// publication, see kReliableTailDelay.
+      public: bool tailSent = true;
+    };
+
+    /// \brief Messages received from the publisher process of a reliable
+    /// topic.
+    class ReliableStream
+    {
+      /// \brief Process UUID of the publisher, or empty if unknown.
+      public: std::string pUuid;
+
+      /// \brief Sequence numbers received.
+      public: ReliableReceiver receiver;
+    };
+
+    /// \brief Flow control of a remote subscriber process of a topic
+    /// published by this process.
+    class CreditPeer
+    {
+      /// \brief Maximum number of messages in flight.
+      public: uint64_t window = 0;
+
+      /// \brief Number of messages that can still be sent.
+      public: uint64_t credits = 0;
+
+      /// \brief Whether the subscribers want the latest message skipped
+      /// while they had no credits.
+      public: bool conflated = false;
+
+      /// \brief Time when the credits ran out.
+      public: std::chrono::steady_clock::time_point exhausted;
+    };
+
+    /// \brief Flow control of a topic published by this process.
+    class CreditTopic
+    {
+      /// \brief Value of remoteSubscribersVersion when the peers were
+      /// updated.
+      public: uint64_t version = std::numeric_limits<uint64_t>::max();
+
+      /// \brief Whether every remote subscriber uses the flow control.
+      public: bool controlled = false;
+
+      /// \brief Remote subscriber processes, by process UUID.
+      public: std::map<std::string, CreditPeer> peers;
+
+      /// \brief Latest publication skipped for the conflated peers, or
+      /// nullptr.
+      public: std::shared_ptr<char[]> latest;
+
+      /// \brief Size of latest.
+      public: std::size_t latestSize = 0;
+
+      /// \brief Type frame of latest.
+      public: std::string latestType;
+    };
+
+    /// \brief Messages received from the publisher process of a topic with
+    /// flow control.
+    class CreditStream
+    {
+      /// \brief Process UUID of the publisher.
+      public: std::string pUuid;
+
+      /// \brief Credits announced to the publisher.
+      public: uint64_t window = 0;
+
+      /// \brief Messages received and not yet acknowledged.
+      public: uint64_t consumed = 0;
+
+      /// \brief Credits waiting to be granted by the reliability thread.
+      public: uint64_t pending = 0;
+    };
+
+    /// \brief Probe of the round trip time to the remote subscribers of a
+    /// topic with an adaptive rate.
+    class AdaptiveProbe
+    {
+      /// \brief Time when the probe was sent.
+      public: std::chrono::steady_clock::time_point sent;
+
+      /// \brief Whether a subscriber process sent the probe back.
+      public: bool answered = false;
+    };
+
+    /// \brief Round trip time to a remote subscriber process of a topic with
+    /// an adaptive rate.
+    class AdaptivePeer
+    {
+      /// \brief Latest round trip time.
+      public: std::chrono::steady_clock::duration rtt{0};
+
+      /// \brief Time when it was measured.
+      public: std::chrono::steady_clock::time_point measured;
+    };
+
+    /// \brief Adaptive rate of the remote publications of a topic published
+    /// by this process, see AdvertiseMessageOptions::SetLatencyTarget.
+    class AdaptiveTopic
+    {
+      /// \brief Number of publishers of the topic in this process.
+      public: std::size_t publishers = 0;
+
+      /// \brief Latency target.
+      public: std::chrono::steady_clock::duration target{0};
+
+      /// \brief Rate of the remote publications (msgs/s), or 0 when they
+      /// aren't limited.
+      public: double rate = 0;
+
+      /// \brief Average interval between the publications (s), or 0.
+      public: double interval = 0;
+
+      /// \brief Time of the last publication.
+      public: std::chrono::steady_clock::time_point lastPublication;
+
+      /// \brief Time of the last message sent to the remote subscribers.
+      public: std::chrono::steady_clock::time_point lastSend;
+
+      /// \brief Time of the last decrease of the rate.
+      public: std::chrono::steady_clock::time_point lastDecrease;
+
+      /// \brief Time of the last probe.
+      public: std::chrono::steady_clock::time_point lastProbe;
+
+      /// \brief Whether a message was published to remote subscribers since
+      /// the last probe.
+      public: bool published = false;
+
+      /// \brief Number of the next probe.
+      public: uint64_t nextProbe = 0;
+
+      /// \brief Last probe that increased the rate.
+      public: uint64_t lastIncrease = 0;
+
+      /// \brief Probes sent recently, by number.
+      public: std::map<uint64_t, AdaptiveProbe> probes;
+
+      /// \brief Remote subscriber processes, by process UUID.
+      public: std::map<std::string, AdaptivePeer> peers;
+
+      /// \brief Latest publication over the rate, or nullptr.
+      public: std::shared_ptr<char[]> latest;
+
+      /// \brief Size of latest.
+      public: std::size_t latestSize = 0;
+
+      /// \brief Type frame of latest.
+      public: std::string latestType;
+    };
+
+    /// \brief Remote publication identified by a numeric topic ID when the
+    /// compact publication header is used.
+    class CompactTopic
+    {
+      /// \brief Fully qualified topic name.
+      public: std::string topic;
+
+      /// \brief Type sent in the type frame of the legacy header.
+      public: std::string msgType;
+
+      /// \brief Address of the publisher.
+      public: std::string sender;
+    };
+
+    /// \brief Socket sending the remote publications of the high priority
+    /// topics of this process. It is serviced by its own ZeroMQ I/O thread,
+    /// so large regular publications don't delay them.
+    class PriorityPublisher
+    {
+      /// \brief ZMQ socket to send topic updates.
+      public: std::unique_ptr<zmq::socket_t> socket;
+
+      /// \brief Address of the socket, advertised by the high priority
+      /// publishers.
+      public: std::string address;
+
+      /// \brief Topic publication sequence numbers.
+      public: std::map<std::string, uint64_t> topicPubSeq;
+
+      /// \brief Protects the socket and topicPubSeq.
+      public: std::mutex mutex;
+    };
+
+    /// \brief A remote publication sent by the fragment thread, in
+    /// fragments if it is large.
+    class FragmentedPublication
+    {
+      /// \brief Socket where the publication is sent.
+      public: zmq::socket_t *socket = nullptr;
+
+      /// \brief Protects the socket.
+      public: std::mutex *socketMutex = nullptr;
+
+      /// \brief Address of the socket.
+      public: std::string address;
+
+      /// \brief Type frame of the publication.
+      public: std::string msgType;
+
+      /// \brief Payload of the publication, shared by its fragments.
+      public: std::shared_ptr<zmq::message_t> data;
+
+      /// \brief Metadata, sent with every fragment.
+      public: PublicationMetadata meta;
+
+      /// \brief Trace, sent with every fragment.
+      public: TraceMetadata trace;
+
+      /// \brief ID, number of fragments and size of the publication. A
+      /// single fragment is sent as a regular publication.
+      public: FragmentHeader header;
+
+      /// \brief Index of the next fragment to send.
+      public: uint32_t next = 0;
+    };
+
+    /// \brief Requests of a service advertised with a concurrency greater
+    /// than zero. They are executed by the service workers.
+    class ServiceExecution
+    {
+      /// \brief Maximum number of requests executed at the same time.
+      public: unsigned int concurrency = 0;
+
+      /// \brief Maximum number of waiting requests, or 0 if they are not
+      /// bounded.
+      public: uint64_t maxPending = 0;
+
+      /// \brief Requests waiting for a worker.
+      public: std::deque<std::function<void()>> pending;
+
+      /// \brief Callbacks of the advertising node if it is in spin mode,
+      /// or callback group of the service, or nullptr. The requests run
+      /// there instead of in a worker.
+      public: std::shared_ptr<CallbackExecutor> executor;
+
+      /// \brief Number of workers executing requests of this service.
+      public: unsigned int running = 0;
+    };
+
+    /// \brief Response of a service request executed by a service worker.
+    /// It is sent by the reception thread, the only user of the replier.
+    class ServiceReply
+    {
+      /// \brief Address of the requester.
+      public: std::string sender;
+
+      /// \brief Socket identity of the requester.
+      public: std::string dstId;
+
+      /// \brief Service name.
+      public: std::string topic;
+
+      /// \brief UUID of the requester node.
+      public: std::string nodeUuid;
+
+      /// \brief UUID of the request.
+      public: std::string reqUuid;
+
+      /// \brief Serialized response.
+      public: std::string rep;
+
+      /// \brief Result of the service call.
+      public: bool result = false;
+
+      /// \brief Whether this is a chunk of a streamed response, followed by
+      /// more chunks.
+      public: bool more = false;
+
+      /// \brief Whether the request was received in a single frame, so the
+      /// response is sent in a single frame too.
+      public: bool envelope = false;
+    };
+
+    /// \brief Service of this process identified by a numeric service ID
+    /// in the single frame requests.
+    class EnvelopeService
+    {
+      /// \brief Service name.
+      public: std::string topic;
+
+      /// \brief Request type, with the prefix of its kind of call.
+      public: std::string reqType;
+
+      /// \brief Response type.
+      public: std::string repType;
+    };
+
+    /// \brief Response of an idempotent service kept by the requester.
+    class ServiceCacheEntry
+    {
+      /// \brief Serialized request.
+      public: std::string req;
+
+      /// \brief Request message type.
+      public: std::string reqType;
+
+      /// \brief Response message type.
+      public: std::string repType;
+
+      /// \brief Serialized response.
+      public: std::string rep;
+
+      /// \brief When the response expires.
+      public: std::chrono::steady_clock::time_point expiration;
+    };
+
+    /// \brief Remote service request sent with a balancing policy that
+    /// tracks the responses.
+    class ServiceRequestTrack
+    {
+      /// \brief Service name.
+      public: std::string topic;
+
+      /// \brief Addresses of the responders that received the request.
+      public: std::vector<std::string> addresses;
+
+      /// \brief When the request was first sent.
+      public: std::chrono::steady_clock::time_point sent;
+
+      /// \brief Whether a response was already received.
+      public: bool answered = false;
+
+      /// \brief Number of responses received after the first one.
+      public: std::size_t lateResponses = 0;
+    };
+
+    /// \brief Copy of a remote service request waiting to be sent to
+    /// another responder if the first one is too slow.
+    class HedgedRequest
+    {
+      /// \brief When the copy has to be sent.
+      public: std::chrono::steady_clock::time_point deadline;
+
+      /// \brief Service name.
+      public: std::string topic;
+
+      /// \brief UUID of the requester node.
+      public: std::string nodeUuid;
+
+      /// \brief UUID of the request.
+      public: std::string reqUuid;
+
+      /// \brief Serialized request.
+      public: std::string data;
+
+      /// \brief Request message type.
+      public: std::string reqType;
+
+      /// \brief Response message type.
+      public: std::string repType;
+
+      /// \brief Request type sent on the wire, see
+      /// NodeSharedPrivate::WireReqType().
+      public: std::string wireReqType;
+    };
+
+    /// \brief Kind of service call carried by a request.
+    enum class ServiceCallKind
+    {
+      /// \brief One request and one response.
+      SINGLE,
+
+      /// \brief A batch of requests, see Node::RequestBatch().
+      BATCH,
+
+      /// \brief One request and a response streamed in chunks, see
+      /// Node::RequestStream().
+      STREAM
     };
 
     //
@@ -54,21 +731,73 @@ namespace gz
     {
       // Constructor
       public: NodeSharedPrivate() :
-                context(new zmq::context_t(1)),
+                ioThreads(std::max(kIoThreads, this->NonNegativeEnvVar(
+                  "GZ_TRANSPORT_IO_THREADS", kIoThreads))),
+                regularAffinity(
+                  ((uint64_t{1} << std::min(ioThreads, 63)) - 1) &
+                  ~kPriorityAffinity),
+                memoryBudget(static_cast<uint64_t>(this->NonNegativeEnvVar(
+                  "GZ_TRANSPORT_MEMORY_BUDGET", 0)) * 1024u * 1024u),
+                context(new zmq::context_t(ioThreads)),
                 publisher(new zmq::socket_t(*context, ZMQ_PUB)),
                 subscriber(new zmq::socket_t(*context, ZMQ_SUB)),
                 requester(new zmq::socket_t(*context, ZMQ_ROUTER)),
                 responseReceiver(new zmq::socket_t(*context, ZMQ_ROUTER)),
                 replier(new zmq::socket_t(*context, ZMQ_ROUTER))
       {
+        // Set the capacity of the queue used for local publications.
+        this->pubLane.reset(new PublicationLane(static_cast<std::size_t>(
+          std::max(1, this->NonNegativeEnvVar(
+            "GZ_TRANSPORT_PUB_QUEUE_SIZE", kDefaultPubQueueSize))), false));
+
+        // Kernel buffers and keepalive of the TCP connections.
+        this->sndBuf = this->NonNegativeEnvVar("GZ_TRANSPORT_SNDBUF", 0);
+        this->rcvBuf = this->NonNegativeEnvVar("GZ_TRANSPORT_RCVBUF", 0);
+        this->tcpKeepAliveIdle =
+          this->NonNegativeEnvVar("GZ_TRANSPORT_TCP_KEEPALIVE_IDLE", 0);
+
+        // Publishers wait for room in the memory budget instead of dropping.
+        this->memoryBlock =
+          this->NonNegativeEnvVar("GZ_TRANSPORT_MEMORY_BLOCK", 0) > 0;
       }
 
+      /// \brief Apply the kernel buffer sizes and TCP keepalive settings to
+      /// a socket. It must be called before binding or connecting it.
+      /// \param[in] _socket The socket.
+      public: void TuneSocket(zmq::socket_t &_socket) const;
+
+      /// \brief Size of the kernel send buffer of the sockets (bytes), or 0
+      /// for the default of the operating system.
+      public: int sndBuf = 0;
+
+      /// \brief Size of the kernel receive buffer of the sockets (bytes),
+      /// or 0 for the default of the operating system.
+      public: int rcvBuf = 0;
+
+      /// \brief Idle time before sending TCP keepalive probes (s.), or 0 to
+      /// keep the default of the operating system.
+      public: int tcpKeepAliveIdle = 0;
+
       /// \brief Initialize security
       public: void SecurityInit();
 
       /// \brief Handle new secure connections
       public: void SecurityOnNewConnection();
 
+      /// \brief Make a socket authenticate the peers connecting to it, with
+      /// CURVE if GZ_TRANSPORT_CURVE_PUBLIC_KEY and
+      /// GZ_TRANSPORT_CURVE_SECRET_KEY are set, or else with PLAIN if
+      /// GZ_TRANSPORT_USERNAME and GZ_TRANSPORT_PASSWORD are set. It must be
+      /// called before the socket binds.
+      /// \param[in] _socket The socket.
+      public: void SecureServer(zmq::socket_t &_socket);
+
+      /// \brief Set the credentials presented by a socket to the peers it
+      /// connects to, see SecureServer(). It must be called before the
+      /// socket connects.
+      /// \param[in] _socket The socket.
+      public: void SecureClient(zmq::socket_t &_socket);
+
       /// \brief Access control handler for plain security.
       /// This function is designed to be run in a thread.
       public: void AccessControlHandler();
@@ -87,6 +816,34 @@ namespace gz
       ///////    Declare here the ZMQ Context    ///////
       //////////////////////////////////////////////////
 
+      /// \brief Default and minimum number of ZeroMQ I/O threads. The
+      /// second one only services the sockets of the high priority topics.
+      public: inline static const int kIoThreads = 2;
+
+      /// \brief I/O thread affinity of the high priority sockets.
+      public: static constexpr uint64_t kPriorityAffinity = 2;
+
+      /// \brief Number of ZeroMQ I/O threads, see GZ_TRANSPORT_IO_THREADS.
+      public: const int ioThreads;
+
+      /// \brief I/O thread affinity of the regular publisher and subscriber
+      /// sockets: every I/O thread but the high priority one. ZeroMQ spreads
+      /// their connections across them.
+      public: const uint64_t regularAffinity;
+
+      /// \brief Memory held by the local publications and the latched
+      /// messages, see GZ_TRANSPORT_MEMORY_BUDGET. Declared before the
+      /// buffers charged to it, so it is destroyed after them.
+      public: MemoryBudget memoryBudget;
+
+      /// \brief Whether the publishers wait for room in the memory budget
+      /// instead of dropping their local publications, see
+      /// GZ_TRANSPORT_MEMORY_BLOCK.
+      public: bool memoryBlock = false;
+
+      /// \brief Whether the exhaustion of the memory budget was reported.
+      public: std::atomic<bool> memoryWarned{false};
+
       /// \brief 0MQ context. Always declare this object before any ZMQ socket
       /// to make sure that the context is destroyed after all sockets.
       public: std::unique_ptr<zmq::context_t> context;
@@ -107,12 +864,39 @@ namespace gz
       /// \brief ZMQ socket for receiving service call responses.
       public: std::unique_ptr<zmq::socket_t> responseReceiver;
 
+      /// \brief String form of NodeShared::responseReceiverId, sent with
+      /// every service request.
+      public: std::string responseReceiverIdStr;
+
       /// \brief ZMQ socket to receive service call requests.
       public: std::unique_ptr<zmq::socket_t> replier;
 
+      /// \brief Socket used to wake up NodeShared::RunReceptionTask.
+      public: std::unique_ptr<zmq::socket_t> receptionWakeSender;
+
+      /// \brief Socket polled by NodeShared::RunReceptionTask for wake ups.
+      /// The reception threads block until there is something to do.
+      public: std::unique_ptr<zmq::socket_t> receptionWakeReceiver;
+
+      /// \brief Time at which NodeShared::RunReceptionTask was last woken
+      /// up by the subscriber socket, the arrival time of the publications
+      /// in the topic statistics.
+      public: std::chrono::steady_clock::time_point receptionWake;
+
       /// \brief Thread the handle access control
       public: std::thread accessControlThread;
 
+      /// \brief Whether the credentials of the subscriber socket are set.
+      /// Protected by subscriberMutex.
+      public: bool subscriberSecured = false;
+
+      /// \brief Socket used to stop the access control thread.
+      public: std::unique_ptr<zmq::socket_t> accessControlWakeSender;
+
+      /// \brief Socket polled by the access control thread, so it exits as
+      /// soon as it is stopped.
+      public: std::unique_ptr<zmq::socket_t> accessControlWakeReceiver;
+
       //////////////////////////////////////////////////
       /////// Declare here the discovery object  ///////
       //////////////////////////////////////////////////
@@ -138,28 +922,102 @@ namespace gz
       /////// messages to local subscribers.                    ///////
       ////////////////////////////////////////////////////////////////
 
-      /// \brief Encapsulates information needed to publish a message. An
-      /// instance of this class is pushed onto a publish queue, pubQueue, when
-      /// a message is published through Node::Publisher::Publish.
-      /// The pubThread processes the pubQueue in the
-      /// NodeSharedPrivate::PublishThread function.
-      ///
-      /// A producer-consumer mechanism is used to send messages so that
-      /// Node::Publisher::Publish function does not block while executing
-      /// local subscriber callbacks.
+      /// \brief Counters of a publisher, see PublisherStatistics. The
+      /// publisher and the publication threads update them concurrently.
+      public: class PublisherCounters
+      {
+        /// \brief Raise a maximum.
+        /// \param[in, out] _max The maximum.
+        /// \param[in] _value New value.
+        public: static void UpdateMax(std::atomic<uint64_t> &_max,
+                                      uint64_t _value)
+        {
+          uint64_t max = _max.load(std::memory_order_relaxed);
+          while (_value > max &&
+                 !_max.compare_exchange_weak(max, _value,
+                   std::memory_order_relaxed))
+          {
+          }
+        }
+
+        /// \brief Number of publications.
+        public: std::atomic<uint64_t> publications{0};
+
+        /// \brief Number of publications without subscribers.
+        public: std::atomic<uint64_t> unsubscribed{0};
+
+        /// \brief Number of serializations.
+        public: std::atomic<uint64_t> serializations{0};
+
+        /// \brief Total serialization time (ns).
+        public: std::atomic<uint64_t> serializationNs{0};
+
+        /// \brief Maximum serialization time (ns).
+        public: std::atomic<uint64_t> maxSerializationNs{0};
+
+        /// \brief Bytes published.
+        public: std::atomic<uint64_t> bytes{0};
+
+        /// \brief Number of send failures.
+        public: std::atomic<uint64_t> sendFailures{0};
+
+        /// \brief Number of queued publications.
+        public: std::atomic<uint64_t> queued{0};
+
+        /// \brief Total queue wait time (ns).
+        public: std::atomic<uint64_t> queueWaitNs{0};
+
+        /// \brief Maximum queue wait time (ns).
+        public: std::atomic<uint64_t> maxQueueWaitNs{0};
+      };
+
+      /// \brief Encapsulates information needed to publish a message. An
+      /// instance of this class is pushed onto a publish queue, pubQueue, when
+      /// a message is published through Node::Publisher::Publish.
+      /// The pubThread processes the pubQueue in the
+      /// NodeSharedPrivate::PublishThread function.
+      ///
+      /// A producer-consumer mechanism is used to send messages so that
+      /// Node::Publisher::Publish function does not block while executing
+      /// local subscriber callbacks.
       public: struct PublishMsgDetails
               {
-                /// \brief All the local subscription handlers.
-                public: std::vector<ISubscriptionHandlerPtr> localHandlers;
+                /// \brief Whether a handler of the snapshot receives the
+                /// publication.
+                /// \param[in] _handler Local or raw handler.
+                /// \return True if the handler takes the type of the
+                /// publication.
+                public: template<typename HandlerPtrT>
+                bool Receives(const HandlerPtrT &_handler) const
+                {
+                  if (!_handler)
+                    return false;
+                  const std::string typeName = _handler->TypeName();
+                  return typeName == kGenericMessageType ||
+                         typeName == this->info.Type();
+                }
 
-                /// \brief All the raw handlers.
-                public: std::vector<RawSubscriptionHandlerPtr> rawHandlers;
+                /// \brief Snapshot of the handlers of the topic, shared by
+                /// all the publications until the subscribers of the topic
+                /// change, so that a publication costs the same whatever
+                /// the number of handlers. See Receives().
+                public: NodeShared::TopicHandlersPtr handlers;
 
-                /// \brief Buffer for the raw handlers.
-                public: std::unique_ptr<char[]> sharedBuffer = nullptr;
+                /// \brief Whether the local handlers of the snapshot run.
+                public: bool runLocal = false;
 
-                /// \brief Msg copy for the local handlers.
-                public: std::unique_ptr<ProtoMsg> msgCopy = nullptr;
+                /// \brief Whether the raw handlers of the snapshot run.
+                public: bool runRaw = false;
+
+                /// \brief Serialized message for the raw handlers. This is
+                /// the same buffer handed to ZeroMQ for remote subscribers,
+                /// so the message is serialized only once per publication.
+                public: std::shared_ptr<char[]> sharedBuffer = nullptr;
+
+                /// \brief Message for the local handlers. It is either a
+                /// copy of the published message or the message handed over
+                /// by the publisher, which is never modified afterwards.
+                public: std::shared_ptr<const ProtoMsg> msgCopy = nullptr;
 
                 /// \brief Message size.
                 // cppcheck-suppress unusedStructMember
@@ -170,23 +1028,695 @@ namespace gz
 
                 /// \brief Publisher's node UUID.
                 public: std::string publisherNodeUUID;
+
+                /// \brief Bound of the publisher, or nullptr.
+                public: std::shared_ptr<PublicationBound> bound;
+
+                /// \brief Trace of the publication, if traced.
+                public: TraceMetadata trace;
+
+                /// \brief Time at which the publication was queued (us),
+                /// if traced.
+                public: uint64_t queuedStamp = 0;
+
+                /// \brief Counters of the publisher, or nullptr.
+                public: std::shared_ptr<PublisherCounters> counters;
+
+                /// \brief Time at which the publication was queued, if
+                /// counted or if the callbacks are profiled.
+                public: std::chrono::steady_clock::time_point queued;
+
+                /// \brief Memory charged to the topic while the publication
+                /// is kept.
+                public: MemoryBudget::Charge memory;
+              };
+
+      /// \brief Queue type used for local publications.
+      public: using PubQueue = MpscQueue<std::unique_ptr<PublishMsgDetails>>;
+
+      /// \brief Default capacity of the local publication queue. This value
+      /// can be overridden with the GZ_TRANSPORT_PUB_QUEUE_SIZE environment
+      /// variable.
+      public: inline static const int kDefaultPubQueueSize = 8192;
+
+      /// \brief Local publications waiting to be delivered and the thread
+      /// delivering them. The regular topics share a lane, the high
+      /// priority topics use another one.
+      public: struct PublicationLane
+              {
+                /// \brief Constructor.
+                /// \param[in] _capacity Capacity of the queue.
+                /// \param[in] _priority Whether the lane delivers the high
+                /// priority topics.
+                public: PublicationLane(std::size_t _capacity,
+                                        bool _priority)
+                  : queue(_capacity),
+                    priority(_priority)
+                {
+                }
+
+                /// \brief Lock-free queue onto which new messages are
+                /// pushed. The thread will pop off the messages and send
+                /// them to local subscribers.
+                public: PubQueue queue;
+
+                /// \brief Whether the lane delivers the high priority
+                /// topics. Their callbacks always run on the lane thread,
+                /// never on the dispatcher shared with the regular topics.
+                public: bool priority = false;
+
+                /// \brief Publish thread used to process the queue.
+                public: std::thread thread;
+
+              };
+
+      /// \brief Lane of the regular topics. Its thread is the pubThread.
+      public: std::unique_ptr<PublicationLane> pubLane;
+
+      /// \brief Lane of the high priority topics. Created with the first
+      /// high priority publisher, protected by priorityMutex.
+      public: std::unique_ptr<PublicationLane> priorityLane;
+
+      /// \brief Get the lane of the high priority topics, creating it and
+      /// starting its thread with the first call.
+      /// \return The lane.
+      public: PublicationLane &PriorityLane();
+
+      /// \brief Number of local publications dropped because the queue
+      /// was full when publishing from a local callback.
+      public: std::atomic<uint64_t> pubQueueDropped{0};
+
+      /// \brief Push a new publication onto the queue of a lane. If the
+      /// queue is full the caller waits until there is space, unless it is
+      /// the lane thread itself (a local callback publishing) in which case
+      /// the publication is dropped to avoid a deadlock. The bound of the
+      /// publisher, if any, is enforced first.
+      /// \param[in] _lane Lane of the publisher.
+      /// \param[in, out] _details Publication to queue.
+      /// \return True if the publication was queued.
+      public: bool QueuePublication(PublicationLane &_lane,
+                  std::unique_ptr<PublishMsgDetails> &_details);
+
+      /// \brief Release the bound of a popped publication.
+      /// \param[in] _details The publication.
+      /// \return True if the publication has to be dropped, because a newer
+      /// one of the same publisher replaced it.
+      private: static bool ReleaseBound(const PublishMsgDetails &_details);
+
+      /// \brief Release the room taken by a publication that couldn't be
+      /// queued.
+      /// \param[in] _bound Bound of its publisher.
+      private: static void ReleasePending(PublicationBound &_bound);
+
+
+      /// \brief Handles local publication of messages on the queue of a
+      /// lane.
+      /// \param[in] _lane The lane.
+      public: void PublishThread(PublicationLane *_lane);
+
+      /// \brief Deliver a publication popped from the queue of a lane, or
+      /// post it to the dispatcher.
+      /// \param[in] _lane The lane.
+      /// \param[in, out] _details The publication, moved.
+      public: void ProcessPublication(const PublicationLane &_lane,
+                  std::unique_ptr<PublishMsgDetails> &_details);
+
+      /// \brief Whether the reception thread also runs the discovery and
+      /// delivers the local publications of the regular lane, see
+      /// GZ_TRANSPORT_SINGLE_THREAD.
+      public: bool singleThread = false;
+
+      /// \brief Reception thread, which consumes the regular lane in single
+      /// thread mode.
+      public: std::thread::id receptionThreadId;
+
+      /// \brief Maximum number of local publications delivered by the
+      /// reception thread between two polls in single thread mode.
+      public: inline static const int kSingleThreadBatch = 64;
+
+      /// \brief Whether the sockets and the threads talking to other
+      /// processes wait for the first node needing them, see
+      /// GZ_TRANSPORT_LAZY_INIT and NodeShared::EnsureNetwork().
+      public: bool lazyInit = false;
+
+      /// \brief Runs NodeShared::StartNetwork() once.
+      public: std::once_flag networkFlag;
+
+      /// \brief Whether NodeShared::StartNetwork() succeeded.
+      public: bool networkReady = false;
+
+      ////////////////////////////////////////////////////////////////
+      /////// The following is for sharding the reception of   ///////
+      /////// remote topics across several subscriber sockets. ///////
+      ////////////////////////////////////////////////////////////////
+
+      /// \brief Receive all the frames of a topic update.
+      /// \param[in] _socket Subscriber socket.
+      /// \param[out] _topic Topic name.
+      /// \param[out] _sender Address of the publisher.
+      /// \param[out] _data Serialized message.
+      /// \param[out] _msgType Message type.
+      /// \param[out] _meta Publication metadata. Only filled when topic
+      /// statistics are enabled.
+      /// \param[out] _trace Trace of the publication. Only filled when
+      /// tracing is enabled.
+      /// \return True if all the frames were received.
+      public: bool RecvMsgFrames(zmq::socket_t &_socket,
+                                 std::string &_topic,
+                                 std::string &_sender,
+                                 std::string &_data,
+                                 std::string &_msgType,
+                                 PublicationMetadata &_meta,
+                                 TraceMetadata &_trace);
+
+      /// \brief Write the transit of a received publication to the trace.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _trace Trace of the publication.
+      public: static void TraceReception(const std::string &_topic,
+                                         const TraceMetadata &_trace);
+
+      /// \brief Update the statistics of a topic and notify the statistics
+      /// callback, if statistics are enabled for the topic.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _sender Address of the publisher.
+      /// \param[in] _meta Publication metadata.
+      /// \param[in] _arrived Time at which the reception thread was woken
+      /// up by the publication. ZeroMQ doesn't expose the kernel stamps of
+      /// its sockets.
+      public: void UpdateTopicStats(const std::string &_topic,
+                  const std::string &_sender,
+                  const PublicationMetadata &_meta,
+                  const std::chrono::steady_clock::time_point &_arrived);
+
+      /// \brief Create the additional subscriber shards.
+      /// \param[in] _numShards Total number of shards, including the main
+      /// subscriber socket.
+      /// \param[in] _rcvHwm Receive high water mark for the shard sockets.
+      public: void CreateSubscriberShards(std::size_t _numShards,
+                                          int _rcvHwm);
+
+      /// \brief Create the sockets of a subscriber shard.
+      /// \param[in] _name Name of the shard, unique in the process.
+      /// \param[in] _rcvHwm Receive high water mark for the shard socket.
+      /// \param[in] _affinity I/O thread affinity of the shard socket.
+      /// \return The shard, without reception thread.
+      public: std::unique_ptr<SubscriberShard> CreateShard(
+                  const std::string &_name, int _rcvHwm, uint64_t _affinity);
+
+      /// \brief Create an inproc pair of sockets used to wake up a thread
+      /// blocked in zmq::poll().
+      /// \param[in] _name Name of the pair, unique in the process.
+      /// \param[out] _sender Socket used to send the wake ups.
+      /// \param[out] _receiver Socket polled by the thread.
+      public: void CreateWakePair(const std::string &_name,
+                                  std::unique_ptr<zmq::socket_t> &_sender,
+                                  std::unique_ptr<zmq::socket_t> &_receiver);
+
+      /// \brief Send a wake up signal.
+      /// \param[in] _sender Sender socket of a wake pair.
+      public: static void Wake(zmq::socket_t &_sender);
+
+      /// \brief Discard the pending wake up signals.
+      /// \param[in] _receiver Receiver socket of a wake pair.
+      public: static void DrainWake(zmq::socket_t &_receiver);
+
+      /// \brief Wake up the reception thread of a shard, e.g. to let it see
+      /// the exit flag.
+      /// \param[in] _shard The shard.
+      public: static void WakeShard(SubscriberShard &_shard);
+
+      /// \brief Get the shard in charge of a topic.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The shard index. Index 0 is the main subscriber socket
+      /// serviced by NodeShared::RunReceptionTask.
+      public: std::size_t ShardIndex(const std::string &_topic) const;
+
+      /// \brief Connect a ROUTER socket to a peer, so messages can be routed
+      /// to the peer without waiting for the connection handshake.
+      /// \param[in] _socket ROUTER socket.
+      /// \param[in] _addr Address of the peer.
+      /// \param[in] _peerId Routing ID of the peer.
+      public: void ConnectRouter(zmq::socket_t &_socket,
+                                 const std::string &_addr,
+                                 const std::string &_peerId);
+
+      /// \brief ROUTER sockets and addresses connected with a routing ID.
+      /// Protected by NodeShared::mutex.
+      public: std::set<std::pair<const zmq::socket_t *, std::string>>
+                routerEndpoints;
+
+      /// \brief Request an operation to a shard and wake up its thread.
+      /// \param[in] _shard The shard.
+      /// \param[in] _op Operation.
+      /// \param[in] _arg Address or topic, depending on the operation.
+      public: static void RequestShardOp(SubscriberShard &_shard,
+                                         SubscriberShard::Op _op,
+                                         const std::string &_arg);
+
+      /// \brief Remove the subscriber filter of a topic, in whatever shard
+      /// the topic lives. The caller must hold NodeShared::mutex.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void UnsubscribeTopicFilter(const std::string &_topic);
+
+      /// \brief Reception loop of an additional shard.
+      /// \param[in] _shared NodeShared instance.
+      /// \param[in] _shard The shard.
+      public: void RunShardReceptionTask(NodeShared *_shared,
+                                         SubscriberShard *_shard);
+
+      /// \brief Additional subscriber shards. Shard i is stored at
+      /// position i - 1, shard 0 is the main subscriber socket. Empty unless
+      /// GZ_TRANSPORT_RECEPTION_THREADS is greater than 1.
+      public: std::vector<std::unique_ptr<SubscriberShard>> subscriberShards;
+
+      /// \brief Get the shard receiving the messages of a publisher.
+      /// \param[in] _pub The publisher.
+      /// \return The shard, or nullptr for the main subscriber socket.
+      public: SubscriberShard *ShardOf(const MessagePublisher &_pub) const;
+
+      /// \brief Count a new connection to a publisher and connect its
+      /// subscriber socket to the publisher address if this is the first
+      /// connection using that socket and address. The caller must hold
+      /// NodeShared::mutex.
+      /// \param[in] _shard Shard receiving the messages, or nullptr for the
+      /// main subscriber socket.
+      /// \param[in] _addr Publisher address.
+      /// \param[in] _multicastGroup Multicast group of the publisher, if it
+      /// sends its topics through multicast.
+      public: void AcquireAddress(SubscriberShard *_shard,
+                                  const std::string &_addr,
+                                  const std::string &_multicastGroup);
+
+      /// \brief Get the endpoint used to connect to a publisher address.
+      /// With the IPC transport enabled, the publishers running on this
+      /// host are reached through their IPC endpoint, if they bound it.
+      /// \param[in] _addr Publisher address.
+      /// \return The IPC endpoint of the publisher, or _addr.
+      public: std::string ConnectEndpoint(const std::string &_addr) const;
+
+      /// \brief Get the IPC endpoint bound next to a TCP endpoint. The name
+      /// derives from the TCP endpoint, which is unique in the host while
+      /// bound, so it doesn't need to be advertised.
+      /// \param[in] _tcpAddr TCP endpoint, e.g. "tcp://10.0.0.5:40123".
+      /// \return The IPC endpoint, or an empty string if _tcpAddr isn't a
+      /// TCP endpoint.
+      public: static std::string IpcEndpoint(const std::string &_tcpAddr);
+
+      /// \brief Bind a publisher socket to the IPC endpoint of its TCP
+      /// endpoint if the IPC transport is enabled. Errors are reported but
+      /// not fatal, the subscribers then connect through TCP.
+      /// \param[in] _socket The publisher socket.
+      /// \param[in] _tcpAddr TCP endpoint bound by the socket.
+      public: void BindIpc(zmq::socket_t &_socket,
+                           const std::string &_tcpAddr);
+
+      /// \brief Whether the publications are also sent and received through
+      /// IPC (Unix domain sockets) between processes of this host.
+      public: bool ipcEnabled = false;
+
+      /// \brief Forget a connection to a publisher, already removed from
+      /// NodeShared::connections. The subscriber socket disconnects from the
+      /// publisher address when nothing else uses it. The caller must hold
+      /// NodeShared::mutex.
+      /// \param[in] _pub The publisher.
+      public: void ReleaseConnection(const MessagePublisher &_pub);
+
+      /// \brief Remove all the connections of a topic, e.g. after the last
+      /// local subscriber is gone. The caller must hold NodeShared::mutex.
+      /// \param[in, out] _connections NodeShared::connections.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseTopicConnections(
+        TopicStorage<MessagePublisher> &_connections,
+        const std::string &_topic);
+
+      /// \brief Add a publisher to the topic graph and notify the watchers
+      /// if it is new. The caller must hold NodeShared::mutex.
+      /// \param[in] _pub The publisher.
+      public: void AddToGraph(const MessagePublisher &_pub);
+
+      /// \brief Remove publishers from the topic graph and notify the
+      /// watchers. The caller must hold NodeShared::mutex.
+      /// \param[in] _pub The publisher. If its topic is empty, all the
+      /// publishers of its process are removed.
+      public: void RemoveFromGraph(const MessagePublisher &_pub);
+
+      /// \brief Notify a change of the topic graph to the watchers of the
+      /// publisher's partition.
+      /// \param[in] _pub The publisher.
+      /// \param[in] _added True if added or false if removed.
+      public: void NotifyGraph(const MessagePublisher &_pub, bool _added);
+
+      /// \brief All the topic publishers known by the discovery, mirrored
+      /// from its callbacks. Protected by NodeShared::mutex.
+      public: TopicStorage<MessagePublisher> graph;
+
+      /// \brief Nodes watching the topic graph. The key is the node UUID.
+      /// Protected by NodeShared::mutex.
+      public: std::map<std::string, TopicGraphWatcher> graphWatchers;
+
+      /// \brief Number of connections using every subscriber socket and
+      /// publisher address. The key is the shard (nullptr for the main
+      /// subscriber socket) and the address. Protected by NodeShared::mutex.
+      public: std::map<std::pair<SubscriberShard *, std::string>,
+                       std::size_t> addressUsers;
+
+      /// \brief Endpoint connected for every entry of addressUsers when it
+      /// differs from the publisher address, i.e. its IPC endpoint or its
+      /// multicast group.
+      /// Protected by NodeShared::mutex.
+      public: std::map<std::pair<SubscriberShard *, std::string>,
+                       std::string> connectedEndpoints;
+
+      /// \brief Number of entries of addressUsers connected to every
+      /// endpoint through every subscriber socket. The publishers of a
+      /// multicast group share the endpoint of the group, which is joined
+      /// once so its messages aren't received twice. Protected by
+      /// NodeShared::mutex.
+      public: std::map<std::pair<SubscriberShard *, std::string>,
+                       std::size_t> endpointUsers;
+
+      /// \brief Get the shard receiving the high priority topics, creating
+      /// it and starting its reception thread with the first call. The
+      /// caller must hold NodeShared::mutex.
+      /// \param[in] _shared NodeShared instance.
+      /// \return The shard, or nullptr on error.
+      public: SubscriberShard *PriorityShard(NodeShared *_shared);
+
+      /// \brief Shard receiving the high priority topics, or nullptr.
+      /// Protected by NodeShared::mutex.
+      public: std::unique_ptr<SubscriberShard> priorityShard;
+
+      /// \brief Run the local and raw callbacks of a publication.
+      /// \param[in] _details The publication.
+      public: static void DispatchPublication(
+                  const PublishMsgDetails &_details);
+
+      /// \brief Run a local callback of a publication.
+      /// \param[in] _details The publication.
+      /// \param[in] _handler The local handler.
+      public: static void RunLocalHandler(const PublishMsgDetails &_details,
+                  const ISubscriptionHandlerPtr &_handler);
+
+      /// \brief Run a raw callback of a publication.
+      /// \param[in] _details The publication.
+      /// \param[in] _handler The raw handler.
+      public: static void RunRawHandler(const PublishMsgDetails &_details,
+                  const RawSubscriptionHandlerPtr &_handler);
+
+      /// \brief Ordering guarantees when local callbacks are executed by the
+      /// dispatcher.
+      public: enum class DispatchOrder
+              {
+                /// \brief Publications on the same topic are delivered in
+                /// order, one at a time.
+                TOPIC,
+
+                /// \brief Each handler receives its publications in order,
+                /// one at a time. Handlers on the same topic run in parallel.
+                HANDLER
               };
 
-      /// \brief Publish thread used to process the pubQueue.
-      public: std::thread pubThread;
+      /// \brief Thread pool running the local callbacks. When null (the
+      /// default), callbacks are executed by the pubThread itself. It is
+      /// enabled with the GZ_TRANSPORT_DISPATCH_THREADS environment
+      /// variable.
+      public: std::unique_ptr<DispatchExecutor> dispatcher;
+
+      /// \brief Ordering used by the dispatcher. It is set with the
+      /// GZ_TRANSPORT_DISPATCH_ORDER environment variable.
+      public: DispatchOrder dispatchOrder = DispatchOrder::TOPIC;
+
+      /// \brief Store a message received from another process in the
+      /// queue of a conflated or queued handler, and schedule its callback
+      /// if the queue was empty.
+      /// \param[in] _handler The handler.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _info Message information.
+      public: void PostQueued(const ISubscriptionHandlerPtr &_handler,
+                              const std::string &_data,
+                              const MessageInfo &_info);
+
+      /// \brief Store a message received from another process in the
+      /// queue of a conflated or queued raw handler, and schedule its
+      /// callback if the queue was empty.
+      /// \param[in] _handler The raw handler.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _info Message information.
+      public: void PostQueued(const RawSubscriptionHandlerPtr &_handler,
+                              const std::string &_data,
+                              const MessageInfo &_info);
+
+      /// \brief Schedule the delivery of the queue of a handler.
+      /// \param[in] _handler The handler.
+      /// \param[in] _task Task delivering the queue.
+      private: void PostQueuedTask(const SubscriptionHandlerBase &_handler,
+                                   std::function<void()> _task);
+
+      /// \brief Register the callbacks of a node in spin mode.
+      /// \param[in] _nUuid Node UUID.
+      /// \param[in] _queue Queue of the callbacks of the node.
+      /// \sa NodeOptions::SetSpinMode
+      public: void RegisterSpinQueue(const std::string &_nUuid,
+                                     std::shared_ptr<SpinQueue> _queue);
+
+      /// \brief Forget the callbacks of a node in spin mode.
+      /// \param[in] _nUuid Node UUID.
+      public: void UnregisterSpinQueue(const std::string &_nUuid);
+
+      /// \brief Create a callback group of a node.
+      /// \param[in] _nUuid Node UUID.
+      /// \param[in] _name Name of the group.
+      /// \param[in] _opts Options of the group.
+      /// \return False if the node already has a group with this name.
+      public: bool AddCallbackGroup(const std::string &_nUuid,
+                                    const std::string &_name,
+                                    const CallbackGroupOptions &_opts);
+
+      /// \brief Destroy the callback groups of a node, joining their
+      /// threads.
+      /// \param[in] _nUuid Node UUID.
+      public: void RemoveCallbackGroups(const std::string &_nUuid);
+
+      /// \brief Get the executor of the callbacks of a node that don't run
+      /// on the shared threads: the queue of the node if it is in spin
+      /// mode, or else its callback group.
+      /// \param[in] _nUuid Node UUID.
+      /// \param[in] _group Name of the callback group, or empty.
+      /// \return The executor, or nullptr if the callbacks run on the
+      /// shared threads.
+      public: std::shared_ptr<CallbackExecutor> ExecutorOf(
+                const std::string &_nUuid, const std::string &_group) const;
+
+      /// \brief Post the callbacks of the local publication handlers that
+      /// don't run on the shared threads, see ExecutorOf(), and remove
+      /// these handlers from the publication. Its snapshot of the handlers
+      /// is replaced by one without them, or nullptr if none is left.
+      /// \param[in, out] _details The publication.
+      /// \return True if a callback was posted.
+      public: bool PostExecutorHandlers(PublishMsgDetails &_details);
+
+      /// \brief Callbacks of the nodes in spin mode. The key is the node
+      /// UUID.
+      public: std::unordered_map<std::string, std::shared_ptr<SpinQueue>>
+        spinQueues;
+
+      /// \brief Callback groups of the nodes. The key is the node UUID and
+      /// the name of the group, separated by a slash.
+      public: std::unordered_map<std::string,
+        std::shared_ptr<CallbackGroupExecutor>> callbackGroups;
+
+      /// \brief Number of nodes in spin mode, read without locking
+      /// executorsMutex so the other nodes don't pay for the lookup.
+      public: std::atomic<std::size_t> spinQueueCount{0};
+
+      /// \brief Number of callback groups, see spinQueueCount.
+      public: std::atomic<std::size_t> callbackGroupCount{0};
+
+      /// \brief Protects spinQueues and callbackGroups.
+      public: mutable std::shared_mutex executorsMutex;
+
+      /// \brief Count messages of a topic dropped by this process in the
+      /// topic statistics, if they are enabled.
+      /// \param[in] _info Information of the dropped messages.
+      /// \param[in] _count Number of dropped messages.
+      public: void CountDroppedMsgs(const MessageInfo &_info,
+                                    uint64_t _count);
+
+      /// \brief Workers running the callbacks of the conflated and queued
+      /// handlers. Created with the first queued message.
+      public: std::unique_ptr<DispatchExecutor> queueExecutor;
+
+      /// \brief Protects queueExecutor.
+      public: std::mutex queueMutex;
+
+      /// \brief Remember the concurrency options of an advertised service.
+      /// The last advertisement of a service in this process wins.
+      /// \param[in] _topic Fully qualified service name.
+      /// \param[in] _opts Advertise options of the service.
+      /// \param[in] _nUuid UUID of the advertising node. The requests wait
+      /// for the node to spin if it is in spin mode, or run in its callback
+      /// group.
+      public: void SetServiceExecution(const std::string &_topic,
+                                       const AdvertiseServiceOptions &_opts,
+                                       const std::string &_nUuid);
+
+      /// \brief Forget a service and drop its waiting requests.
+      /// \param[in] _topic Fully qualified service name.
+      public: void RemoveServiceExecution(const std::string &_topic);
+
+      /// \brief Keep the response of a request to an idempotent service.
+      /// Must be called with NodeShared::mutex locked.
+      /// \param[in] _topic Fully qualified service name.
+      /// \param[in] _handler Handler of the request.
+      /// \param[in] _rep Serialized response.
+      public: void CacheResponse(const std::string &_topic,
+                                 const IReqHandler &_handler,
+                                 const std::string &_rep);
+
+      /// \brief Drop the cached responses of a service. Must be called with
+      /// NodeShared::mutex locked.
+      /// \param[in] _topic Fully qualified service name.
+      public: void InvalidateCache(const std::string &_topic);
+
+      /// \brief Cached responses of the idempotent services. The key is the
+      /// service name, then the hash of the serialized request.
+      public: std::unordered_map<std::string,
+        std::unordered_multimap<std::size_t, ServiceCacheEntry>> serviceCache;
+
+      /// \brief Maximum number of cached responses of a service.
+      public: static constexpr std::size_t kMaxCachedResponses = 1024;
+
+      /// \brief Queue a request of a service executed by the service
+      /// workers, or by the executor of the advertising node, see
+      /// ExecutorOf().
+      /// \param[in] _topic Fully qualified service name.
+      /// \param[in] _call Task executing the request.
+      /// \param[out] _accepted False if the request was rejected because
+      /// too many requests are waiting.
+      /// \return False if the service runs its requests inline.
+      public: bool PostServiceCall(const std::string &_topic,
+                                   std::function<void()> _call,
+                                   bool &_accepted);
+
+      /// \brief Execute the waiting requests of a service until there are
+      /// none left. Runs in a service worker.
+      /// \param[in] _topic Fully qualified service name.
+      private: void RunServiceCalls(const std::string &_topic);
+
+      /// \brief Store the response of a request executed by a service
+      /// worker and wake up the reception thread to send it.
+      /// \param[in] _reply The response.
+      public: void QueueServiceReply(ServiceReply &&_reply);
+
+      /// \brief Wake up the reception thread. It may be called from any
+      /// thread.
+      public: void WakeReception();
+
+      /// \brief Number of service workers (GZ_TRANSPORT_SERVICE_THREADS).
+      public: unsigned int serviceThreads = kDefaultServiceThreads;
+
+      /// \brief Default number of service workers.
+      public: inline static const int kDefaultServiceThreads = 4;
+
+      /// \brief Services executed by the service workers. The key is the
+      /// fully qualified service name.
+      public: std::map<std::string, ServiceExecution> serviceExecutions;
+
+      /// \brief Workers executing the service requests. Created with the
+      /// first request of a concurrent service.
+      public: std::unique_ptr<DispatchExecutor> serviceExecutor;
+
+      /// \brief Protects serviceExecutions and serviceExecutor.
+      public: std::mutex serviceMutex;
+
+      /// \brief Pick the responder of a remote service request.
+      /// \param[in] _topic Fully qualified service name.
+      /// \param[in] _responders Responders offering the service, never
+      /// empty.
+      /// \param[in] _policy Balancing policy of the request.
+      /// \param[in] _exclude Addresses that can't be picked unless there
+      /// is nothing else.
+      /// \return Index of the responder in _responders.
+      public: std::size_t PickResponder(const std::string &_topic,
+        const std::vector<ServicePublisher> &_responders,
+        const ServiceBalancing_t _policy,
+        const std::vector<std::string> &_exclude = {});
+
+      /// \brief Remember that a request was sent to a responder, to count
+      /// the outstanding requests and measure the response times. Must be
+      /// called with NodeShared::mutex locked, like the rest of the
+      /// balancing functions.
+      /// \param[in] _topic Fully qualified service name.
+      /// \param[in] _reqUuid UUID of the request.
+      /// \param[in] _addr Address of the responder.
+      public: void TrackRequest(const std::string &_topic,
+                                const std::string &_reqUuid,
+                                const std::string &_addr);
+
+      /// \brief Update the tracking of a request after a response.
+      /// \param[in] _reqUuid UUID of the request.
+      /// \return True if this is a late response to a hedged request that
+      /// was already answered.
+      public: bool TrackResponse(const std::string &_reqUuid);
+
+      /// \brief Stop counting a request as outstanding.
+      /// \param[in] _track The request.
+      private: void ReleaseRequest(const ServiceRequestTrack &_track);
+
+      /// \brief Time a hedged request waits for a response before a copy
+      /// is sent to another responder.
+      /// \param[in] _topic Fully qualified service name.
+      /// \return The 95th percentile of the recent response times, or
+      /// kDefaultHedgeDelay while there are too few of them.
+      public: std::chrono::steady_clock::duration HedgeDelay(
+        const std::string &_topic) const;
+
+      /// \brief Time until the next hedged request is due.
+      /// \return Milliseconds to wait, or -1 if there is none.
+      public: int64_t NextHedgeTimeout() const;
+
+      /// \brief Position of the next responder used by the round-robin
+      /// policy of each service.
+      public: std::map<std::string, std::size_t> balanceCursors;
+
+      /// \brief Requests of this process waiting for a response, by
+      /// responder address.
+      public: std::map<std::string, uint64_t> outstandingRequests;
+
+      /// \brief Tracked requests. The key is the request UUID.
+      public: std::unordered_map<std::string, ServiceRequestTrack>
+        requestTracks;
+
+      /// \brief Expiration of the tracked requests, see kRequestTrackTtl.
+      public: TimerWheel<std::string> requestTrackTimers{
+        std::chrono::milliseconds(100), 512};
+
+      /// \brief Recent response times of each service.
+      public: std::map<std::string,
+        std::deque<std::chrono::steady_clock::duration>> serviceLatencies;
+
+      /// \brief Hedged requests waiting for their deadline.
+      public: std::vector<HedgedRequest> hedgedRequests;
 
-      /// \brief Mutex to protect the pubThread and pubQueue.
-      public: std::mutex pubThreadMutex;
+      /// \brief Number of response times kept by service.
+      public: static constexpr std::size_t kLatencySamples = 64;
 
-      /// \brief List onto which new messages are pushed. The pubThread
-      /// will pop off the messages and send them to local subscribers.
-      public: std::list<std::unique_ptr<PublishMsgDetails>> pubQueue;
+      /// \brief Response times needed before using their percentile.
+      public: static constexpr std::size_t kMinLatencySamples = 8;
 
-      /// \brief used to signal when new work is available
-      public: std::condition_variable signalNewPub;
+      /// \brief Hedge delay used before there are enough response times.
+      public: static constexpr std::chrono::milliseconds kDefaultHedgeDelay{
+        20};
 
-      /// \brief Handles local publication of messages on the pubQueue.
-      public: void PublishThread();
+      /// \brief Time after which a tracked request without response is
+      /// forgotten.
+      public: static constexpr std::chrono::seconds kRequestTrackTtl{30};
+
+      /// \brief Responses waiting to be sent by the reception thread.
+      public: std::vector<ServiceReply> pendingReplies;
+
+      /// \brief Protects pendingReplies and receptionWakeSender.
+      public: std::mutex replyMutex;
 
       /// \brief Topic publication sequence numbers.
       public: std::map<std::string, uint64_t> topicPubSeq;
@@ -194,14 +1724,1344 @@ namespace gz
       /// \brief True if topic statistics have been enabled.
       public: bool topicStatsEnabled = false;
 
-      /// \brief Statistics for a topic. The key in the map is the topic
-      /// name and the value contains the topic statistics.
-      public: std::map<std::string, TopicStatistics> topicStats;
+      /// \brief True if the publications carry their metadata, for the
+      /// topic statistics or the MessageInfo of the subscribers, see
+      /// GZ_TRANSPORT_MESSAGE_METADATA. Set at startup, since it changes the
+      /// wire protocol.
+      public: bool metadataEnabled = false;
+
+      /// \brief True if the publications carry a trace, see Tracer. Set at
+      /// startup, since it changes the wire protocol.
+      public: bool traceEnabled = false;
+
+      /// \brief Publication received on a topic with statistics enabled,
+      /// waiting to be aggregated.
+      public: class StatsSample
+      {
+        /// \brief Address of the sender.
+        public: std::string sender;
+
+        /// \brief Publication metadata.
+        public: PublicationMetadata meta;
+
+        /// \brief Arrival time, when the reception thread was woken up.
+        public: std::chrono::steady_clock::time_point arrived;
+
+        /// \brief Reception time.
+        public: std::chrono::steady_clock::time_point received;
+      };
+
+      /// \brief Statistics of a topic. The reception threads only push
+      /// samples, without locking, and the statistics thread aggregates
+      /// them and runs the callback.
+      public: class StatsAccumulator
+      {
+        /// \brief Constructor.
+        public: StatsAccumulator()
+          : samples(kStatsQueueCapacity)
+        {
+        }
+
+        /// \brief Samples waiting for the statistics thread.
+        public: MpscQueue<StatsSample> samples;
+
+        /// \brief Messages dropped by the local queues since the last
+        /// aggregation.
+        public: std::atomic<uint64_t> droppedMsgs{0};
+
+        /// \brief Whether statistics are enabled for the topic.
+        public: std::atomic<bool> enabled{false};
+
+        /// \brief Aggregated statistics.
+        public: TopicStatistics stats;
+
+        /// \brief Whether stats contains any sample.
+        public: bool available = false;
+
+        /// \brief Whether stats changed since the last callback.
+        public: bool changed = false;
+
+        /// \brief Callback that is triggered whenever statistics are
+        /// updated.
+        public: std::function<void(const TopicStatistics &_stats)> cb;
+
+        /// \brief Protects stats and cb. The thread holding it is the
+        /// consumer of samples.
+        public: std::mutex mutex;
+      };
+
+      /// \brief Aggregate the pending samples of a topic.
+      /// \param[in, out] _acc Statistics of the topic, with its mutex
+      /// locked.
+      public: void DrainStats(StatsAccumulator &_acc);
+
+      /// \brief Aggregate the samples and run the statistics callbacks
+      /// periodically. This function is designed to be run in a low
+      /// priority thread.
+      public: void RunStatsTask();
+
+      /// \brief Capacity of the sample queue of a topic. A reception thread
+      /// that finds it full aggregates the samples itself.
+      public: static constexpr std::size_t kStatsQueueCapacity = 1024;
+
+      /// \brief Period of the statistics thread.
+      public: static constexpr std::chrono::milliseconds kStatsPeriod{10};
+
+      /// \brief Statistics of the topics where they have been enabled at
+      /// least once. The key in the map is the topic name. Entries are never
+      /// removed, so the last statistics remain available.
+      public: std::map<std::string, std::shared_ptr<StatsAccumulator>>
+                topicStats;
+
+      /// \brief Protects topicStats. The reception threads lock it shared.
+      public: mutable std::shared_mutex statsMutex;
+
+      /// \brief Process UUID of the remote publishers, by address.
+      public: std::unordered_map<std::string, std::string> senderProcesses;
+
+      /// \brief Protects senderProcesses.
+      public: std::mutex senderProcessesMutex;
+
+      /// \brief Wakes up the statistics thread to exit.
+      public: std::condition_variable statsCondition;
+
+      /// \brief Used with statsCondition.
+      public: std::mutex statsThreadMutex;
+
+      /// \brief Thread that aggregates the statistics, started when they
+      /// are enabled on a topic for the first time.
+      public: std::thread statsThread;
+
+      /// \brief Publish the callback profiles of this process periodically
+      /// on NodeShared::kCallbackProfileTopic, while profiling is enabled.
+      /// \param[in] _pUuid Process UUID, sent with the profiles.
+      public: void RunProfileTask(const std::string &_pUuid);
+
+      /// \brief Period of the publication of the callback profiles.
+      public: static constexpr std::chrono::seconds kProfilePeriod{1};
+
+      /// \brief Thread that publishes the callback profiles, started when
+      /// profiling is enabled for the first time. It shares the condition of
+      /// the statistics thread.
+      public: std::thread profileThread;
+
+      /// \brief Start the thread that publishes the traffic of the topics
+      /// of this process, unless it runs already, the report or the metrics
+      /// are disabled, or the network isn't up yet.
+      /// See GZ_TRANSPORT_TOPIC_REPORT.
+      /// \param[in] _pUuid Process UUID, sent with the reports.
+      public: void StartTopicReport(const std::string &_pUuid);
+
+      /// \brief Publish the counters of the topics published by this
+      /// process periodically on NodeShared::kTopicReportTopic, while it has
+      /// subscribers.
+      /// \param[in] _pUuid Process UUID, sent with the reports.
+      public: void RunReportTask(const std::string &_pUuid);
+
+      /// \brief Period of the topic reports.
+      public: static constexpr std::chrono::seconds kReportPeriod{1};
+
+      /// \brief Thread that publishes the topic reports, started when this
+      /// process advertises a topic outside the process for the first time.
+      /// It shares the condition of the statistics thread.
+      public: std::thread reportThread;
+
+      /// \brief Whether the topics are reported, see
+      /// GZ_TRANSPORT_TOPIC_REPORT. Never in single thread mode.
+      public: bool topicReportEnabled = false;
+
+      /// \brief Protects NodeShared::remoteSubscribers. Publishers read it
+      /// shared on every publication, discovery updates it exclusively.
+      /// When both are needed, NodeShared::mutex must be locked first.
+      public: mutable std::shared_mutex remoteSubscribersMutex;
+
+      /// \brief Protects the publisher socket and topicPubSeq.
+      public: std::mutex publisherMutex;
+
+      /// \brief Address of the socket of the high priority topics, which is
+      /// bound with the first call.
+      /// \return The address, or an empty string on error.
+      public: std::string PriorityAddress();
+
+      /// \brief Send the remote publications of a topic through the high
+      /// priority socket.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void CreatePriority(const std::string &_topic);
+
+      /// \brief Stop sending a topic through the high priority socket for a
+      /// publisher. The topic is removed with its last publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleasePriority(const std::string &_topic);
+
+      /// \brief Address of the socket bound to a network interface, which
+      /// is bound with the first call for the interface.
+      /// \param[in] _ip IPv4 address of the interface.
+      /// \return The address, or an empty string if _ip isn't the address
+      /// of a local interface or on error.
+      public: std::string InterfaceAddress(const std::string &_ip);
+
+      /// \brief Send the remote publications of a topic through the socket
+      /// of a network interface.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _ip IPv4 address of the interface, whose socket was
+      /// created by InterfaceAddress().
+      public: void CreateInterfaceTopic(const std::string &_topic,
+                                        const std::string &_ip);
+
+      /// \brief Stop sending a topic through the socket of a network
+      /// interface for a publisher. The topic is removed with its last
+      /// publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseInterfaceTopic(const std::string &_topic);
+
+      /// \brief Address of the socket of the multicast topics, which is
+      /// created with the first call. The socket is bound to a TCP port of
+      /// the host, for the subscribers of this host and those without PGM,
+      /// and connected to the multicast group.
+      /// \return The address, or an empty string if multicast isn't
+      /// available, e.g. without PGM support or with PLAIN security.
+      public: std::string MulticastAddress();
+
+      /// \brief Send the remote publications of a topic through the
+      /// multicast socket created by MulticastAddress().
+      /// \param[in] _topic Fully qualified topic name.
+      public: void CreateMulticastTopic(const std::string &_topic);
+
+      /// \brief Get the multicast endpoint used to reach a remote publisher
+      /// that sends its topics through multicast.
+      /// \param[in] _addr Publisher address.
+      /// \param[in] _group Multicast group advertised by the publisher.
+      /// \return The endpoint, or an empty string to connect to _addr.
+      public: std::string MulticastEndpoint(const std::string &_addr,
+                                            const std::string &_group) const;
 
-      /// \brief Set of topics that have statistics enabled.
+      /// \brief Whether this ZeroMQ library implements the PGM transport.
+      /// \return True if PGM is available.
+      public: static bool PgmSupported();
+
+      /// \brief Create a publisher socket bound to a random port.
+      /// \param[in] _ip IPv4 address where the socket is bound.
+      /// \param[in] _affinity I/O threads of the socket, or 0 for any.
+      /// \return The socket, or nullptr on error.
+      public: std::unique_ptr<PriorityPublisher> CreateLanePublisher(
+                  const std::string &_ip, const uint64_t _affinity);
+
+      /// \brief Socket of the high priority topics, or nullptr until
+      /// PriorityAddress() is called. It is never reset.
+      public: std::unique_ptr<PriorityPublisher> priorityPublisher;
+
+      /// \brief High priority topics advertised by this process and their
+      /// number of publishers in this process.
+      public: std::map<std::string, std::size_t> priorityTopics;
+
+      /// \brief Number of entries in priorityTopics, read without locking by
+      /// the publishers when there are no high priority topics.
+      public: std::atomic<std::size_t> priorityCount{0};
+
+      /// \brief Sockets bound to the network interfaces selected by
+      /// AdvertiseMessageOptions::SetInterface(), by IPv4 address. They are
+      /// never reset.
+      public: std::map<std::string, std::unique_ptr<PriorityPublisher>>
+        interfacePublishers;
+
+      /// \brief Topics sent through the socket of an interface, with the
+      /// socket and their number of publishers in this process.
+      public: std::map<std::string,
+        std::pair<PriorityPublisher *, std::size_t>> interfaceTopics;
+
+      /// \brief Number of entries in interfaceTopics, read without locking
+      /// by the publishers when no topic selects an interface.
+      public: std::atomic<std::size_t> interfaceCount{0};
+
+      /// \brief Socket of the multicast topics, or nullptr until
+      /// MulticastAddress() succeeds. It is never reset.
+      public: std::unique_ptr<PriorityPublisher> multicastPublisher;
+
+      /// \brief Multicast group and port of the multicast topics, see
+      /// GZ_TRANSPORT_MULTICAST_GROUP. Cleared if the group can't be used.
+      public: std::string multicastGroup = "239.255.0.8:11320";
+
+      /// \brief Maximum rate of the multicast socket (kbit/s), see
+      /// GZ_TRANSPORT_MULTICAST_RATE.
+      public: int multicastRate = 100000;
+
+      /// \brief Protects priorityTopics, priorityPublisher, priorityLane,
+      /// interfacePublishers, interfaceTopics, multicastPublisher and
+      /// multicastGroup.
+      public: std::mutex priorityMutex;
+
+      /// \brief Create the shared memory segment of an advertised topic, if
+      /// the shared memory transport is enabled.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type of the topic.
+      /// \param[in] _pUuid Process UUID of this process.
+      /// \param[in] _numaNode NUMA node of the segment, or -1 for
+      /// shmNumaNode.
+      public: void CreateShmWriter(const std::string &_topic,
+                                   const std::string &_msgType,
+                                   const std::string &_pUuid,
+                                   const int _numaNode);
+
+      /// \brief Publish through shared memory when every remote subscriber
+      /// of the topic reads its segment.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the message (bytes).
+      /// \return True if the message was written to the segment, false if
+      /// it has to be sent with ZeroMQ.
+      public: bool ShmPublish(const NodeShared *_shared,
+                              const std::string &_topic,
+                              const char *_data,
+                              std::size_t _size);
+
+      /// \brief Create the blackboard of an advertised topic, see
+      /// AdvertiseMessageOptions::SetBlackboard.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type of the topic.
+      /// \return The segment shared by the publishers of the topic in this
+      /// process, or nullptr on error.
+      public: std::shared_ptr<ShmWriter> CreateBlackboard(
+        const std::string &_topic, const std::string &_msgType);
+
+      /// \brief Start reading the segment of a remote publisher, if it
+      /// exists (i.e. the publisher runs on this host).
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _pubPUuid Process UUID of the publisher.
+      /// \param[in] _pUuid Process UUID of this process.
+      public: void AttachShmReader(const std::string &_topic,
+                                   const std::string &_pubPUuid,
+                                   const std::string &_pUuid);
+
+      /// \brief Stop reading segments.
+      /// \param[in] _topic Topic of the segments, or empty for any topic.
+      /// \param[in] _pubPUuid Process UUID of the publisher, or empty for
+      /// any publisher.
+      /// \param[in] _pUuid Process UUID of this process.
+      public: void DetachShmReaders(const std::string &_topic,
+                                    const std::string &_pubPUuid,
+                                    const std::string &_pUuid);
+
+      /// \brief Flag the list of remote subscribers of the shared memory
+      /// writers and compressed topics as outdated.
+      public: void InvalidateRemoteSubscribers();
+
+      /// \brief Announce the subscribers of a node to the other processes,
+      /// so that they know them without requesting them.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _nUuid UUID of the node.
+      /// \param[in] _topics Fully qualified topics subscribed by the node.
+      public: void AnnounceSubscribers(NodeShared *_shared,
+                                       const std::string &_nUuid,
+                                       const std::set<std::string> &_topics);
+
+      /// \brief Incremented every time the remote subscribers change.
+      public: std::atomic<uint64_t> remoteSubscribersVersion{0};
+
+      /// \brief Incremented every time the local or remote subscribers
+      /// change, after changing them. Publishers cache whether they have
+      /// subscribers until it changes.
+      public: std::atomic<uint64_t> subscribersVersion{0};
+
+      /// \brief Maximum rate at which the remote subscribers of a topic
+      /// consume messages.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The maximum number of messages per second, or kUnthrottled
+      /// if a remote subscriber is not throttled or there are no remote
+      /// subscribers.
+      public: uint64_t RemoteSubscribersMsgsPerSec(const NodeShared *_shared,
+                                                   const std::string &_topic);
+
+      /// \brief Maximum rate at which the subscribers of a node of this
+      /// process consume the messages of a topic.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type published on the topic.
+      /// \param[in] _nUuid Node UUID.
+      /// \return The maximum number of messages per second, or kUnthrottled
+      /// if a subscriber of the node is not throttled.
+      public: static uint64_t NodeMsgsPerSec(const NodeShared *_shared,
+                                             const std::string &_topic,
+                                             const std::string &_msgType,
+                                             const std::string &_nUuid);
+
+      /// \brief Content filter matching the messages wanted by any remote
+      /// subscriber of a topic.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The filter, or nullptr if a remote subscriber wants every
+      /// message or there are no remote subscribers.
+      public: std::shared_ptr<ContentFilter> RemoteSubscribersFilter(
+                const NodeShared *_shared, const std::string &_topic);
+
+      /// \brief Content filter matching the messages wanted by any
+      /// subscriber of a node of this process.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type published on the topic.
+      /// \param[in] _nUuid Node UUID.
+      /// \return The filter expression, or an empty string if a subscriber
+      /// of the node wants every message.
+      public: static std::string NodeFilter(const NodeShared *_shared,
+                                            const std::string &_topic,
+                                            const std::string &_msgType,
+                                            const std::string &_nUuid);
+
+      /// \brief Read the shared memory segments read by this process when
+      /// their writers ring shmDoorbell, and trigger the local callbacks.
+      /// This function is designed to be run in a thread.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      public: void RunShmReceptionTask(NodeShared *_shared);
+
+      /// \brief Whether the shared memory transport is enabled.
+      public: bool shmEnabled = false;
+
+      /// \brief Number of messages of each shared memory segment.
+      public: std::size_t shmSlots = kDefaultShmSlots;
+
+      /// \brief Maximum size of a message sent through shared memory.
+      public: std::size_t shmSlotSize = kDefaultShmSlotSize;
+
+      /// \brief NUMA node of the segments and the blackboards, unless
+      /// their node sets one, or -1. See GZ_TRANSPORT_SHM_NUMA_NODE.
+      public: int shmNumaNode = -1;
+
+      /// \brief Whether the segments and the blackboards use huge pages.
+      /// See GZ_TRANSPORT_SHM_HUGE_PAGES.
+      public: bool shmHugePages = false;
+
+      /// \brief Default number of messages of a segment.
+      public: inline static const int kDefaultShmSlots = 8;
+
+      /// \brief Default maximum message size of a segment (bytes).
+      public: inline static const int kDefaultShmSlotSize = 8 * 1024 * 1024;
+
+      /// \brief Segments written by this process. The key is the topic.
+      public: std::map<std::string, std::shared_ptr<ShmWriter>> shmWriters;
+
+      /// \brief Segments read by this process.
+      public: std::vector<std::shared_ptr<ShmReader>> shmReaders;
+
+      /// \brief Blackboards written by this process. The key is the topic.
+      public: std::map<std::string, std::shared_ptr<ShmWriter>> blackboards;
+
+      /// \brief Process UUID under which the blackboards are named, so that
+      /// their readers find them from the topic alone.
+      public: inline static const std::string kBlackboardUuid =
+        "gz.transport.blackboard";
+
+      /// \brief Protects shmWriters, shmReaders and blackboards.
+      public: std::mutex shmMutex;
+
+      /// \brief Incremented every time shmReaders changes.
+      public: std::atomic<uint64_t> shmReadersVersion{0};
+
+      /// \brief Shared memory reception thread.
+      public: std::thread shmThread;
+
+      /// \brief Doorbell of this process, rung by the writers of the
+      /// segments in shmReaders, or nullptr if it couldn't be created.
+      public: std::unique_ptr<ShmDoorbell> shmDoorbell;
+
+      /// \brief Number of passes over the segments without any message
+      /// after which the shared memory reception thread blocks on
+      /// shmDoorbell. Spinning for a while keeps the latency of the
+      /// messages published at a high rate low.
+      public: inline static const unsigned int kShmSpinPasses = 1000;
+
+      /// \brief Connect to the descriptor channel of a topic published by
+      /// another process, if it runs on this host.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type of the topic.
+      /// \param[in] _pubPUuid Process UUID of the publisher.
+      public: void AttachFdReader(NodeShared *_shared,
+                                  const std::string &_topic,
+                                  const std::string &_msgType,
+                                  const std::string &_pubPUuid);
+
+      /// \brief Close descriptor channels.
+      /// \param[in] _topic Topic of the channels, or empty for any topic.
+      /// \param[in] _pubPUuid Process UUID of the publisher, or empty for
+      /// any publisher.
+      public: void DetachFdReaders(const std::string &_topic,
+                                   const std::string &_pubPUuid);
+
+      /// \brief Receive the descriptors passed by the publishers of this
+      /// host and trigger the local callbacks. This function is designed to
+      /// be run in a thread.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      public: void RunFdReceptionTask(NodeShared *_shared);
+
+      /// \brief Descriptor channels read by this process.
+      public: std::vector<std::shared_ptr<FdReader>> fdReaders;
+
+      /// \brief Protects fdReaders and fdThread.
+      public: std::mutex fdMutex;
+
+      /// \brief Incremented every time fdReaders changes.
+      public: std::atomic<uint64_t> fdReadersVersion{0};
+
+      /// \brief Descriptor reception thread, started with the first
+      /// channel.
+      public: std::thread fdThread;
+
+      /// \brief Create the file descriptor that wakes up fdThread. The
+      /// fdMutex must be locked.
+      /// \return False if it couldn't be created.
+      public: bool OpenFdWake();
+
+      /// \brief Wake up fdThread, to notice the new channels or the exit.
+      public: void WakeFdThread();
+
+      /// \brief Close the file descriptor that wakes up fdThread, once the
+      /// thread is joined.
+      public: void CloseFdWake();
+
+      /// \brief Readable end of the file descriptor that wakes up fdThread,
+      /// or -1.
+      public: int fdWakeRead = -1;
+
+      /// \brief Writable end of the file descriptor that wakes up fdThread,
+      /// or -1. It is the same as fdWakeRead for an eventfd.
+      public: int fdWakeWrite = -1;
+
+      /// \brief Start batching the remote publications of a topic.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type of the topic.
+      /// \param[in] _opts Options of the publisher.
+      public: void CreateBatch(const NodeShared *_shared,
+                               const std::string &_topic,
+                               const std::string &_msgType,
+                               const AdvertiseMessageOptions &_opts);
+
+      /// \brief Stop batching for a publisher of a topic. Pending messages
+      /// are sent and the batch is removed with its last publisher.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseBatch(const NodeShared *_shared,
+                                const std::string &_topic);
+
+      /// \brief Append a message to the batch of its topic, and send the
+      /// batch if it is full.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the message (bytes).
+      /// \return False if the topic is not batched.
+      public: bool BatchPublish(const NodeShared *_shared,
+                                const std::string &_topic,
+                                const char *_data,
+                                std::size_t _size);
+
+      /// \brief Send the pending messages of a batch. batchMutex must be
+      /// locked.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in, out] _batch The batch, empty on return.
+      public: void FlushBatch(const NodeShared *_shared,
+                              const std::string &_topic,
+                              PublicationBatch &_batch);
+
+      /// \brief Send the batches whose period has elapsed. This function is
+      /// designed to be run in a thread.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      public: void RunBatchTask(const NodeShared *_shared);
+
+      /// \brief Trigger the callbacks of a message received from another
+      /// process, unpacking it first if it is a batch.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Type frame of the publication.
+      /// \param[in] _data Payload of the publication.
+      /// \param[in] _sender Address of the publisher.
+      /// \param[in] _meta Publication metadata.
+      public: void DispatchRemoteMsg(NodeShared *_shared,
+                                     const std::string &_topic,
+                                     const std::string &_msgType,
+                                     const std::string &_data,
+                                     const std::string &_sender,
+                                     const PublicationMetadata &_meta);
+
+      /// \brief Fill the publication metadata of a message received from
+      /// another process, see GZ_TRANSPORT_MESSAGE_METADATA.
+      /// \param[in,out] _info Information of the message.
+      /// \param[in] _sender Address of the publisher.
+      /// \param[in] _meta Publication metadata.
+      public: void FillMetadata(MessageInfo &_info,
+                                const std::string &_sender,
+                                const PublicationMetadata &_meta);
+
+      /// \brief Prefix of the type frame of a batch. It is followed by the
+      /// type of the messages in the batch. Processes that don't know about
+      /// batches discard them as a type mismatch.
+      public: inline static const std::string kBatchMsgTypePrefix =
+        "gz.transport.Batch:";
+
+      /// \brief Prefix of the request type frame of a batch of service
+      /// requests. It is followed by the type of the requests in the batch.
+      /// Processes that don't know about batches don't find a responder and
+      /// don't reply.
+      public: inline static const std::string kBatchReqTypePrefix =
+        "gz.transport.BatchRequest:";
+
+      /// \brief Prefix of the request type frame of a request whose response
+      /// is streamed. It is followed by the type of the request.
+      public: inline static const std::string kStreamReqTypePrefix =
+        "gz.transport.StreamRequest:";
+
+      /// \brief Result frame of a chunk of a streamed response. The last
+      /// response of the stream carries the usual "1" or "0" result.
+      public: inline static const std::string kStreamChunkResult = "c";
+
+      /// \brief Request type sent on the wire for a request.
+      /// \param[in] _handler Handler of the request.
+      /// \param[in] _reqType Type of the request.
+      /// \return The request type with the prefix of its kind of call.
+      public: static std::string WireReqType(const IReqHandler &_handler,
+                                             const std::string &_reqType);
+
+      /// \brief Remove the prefix of the kind of call from a request type
+      /// received on the wire.
+      /// \param[in, out] _reqType Request type.
+      /// \return The kind of service call.
+      public: static ServiceCallKind StripReqTypePrefix(std::string &_reqType);
+
+      /// \brief Execute a service request and update the metrics of the
+      /// service.
+      /// \param[in] _topic Service name.
+      /// \param[in] _handler Handler of the service.
+      /// \param[in] _kind Kind of service call.
+      /// \param[in] _req Serialized request.
+      /// \param[out] _rep Serialized response. Empty for a stream.
+      /// \param[in] _emit Function sending a chunk of a streamed response.
+      /// \return Result of the service call.
+      public: static bool RunServiceCall(const std::string &_topic,
+        IRepHandler &_handler,
+        const ServiceCallKind _kind, const std::string &_req,
+        std::string &_rep,
+        const std::function<bool(const std::string &)> &_emit);
+
+      /// \brief Execute a batch of service requests.
+      /// \param[in] _handler Handler of the service.
+      /// \param[in] _reqs Requests, each one preceded by its size.
+      /// \param[out] _reps Results and responses, each one preceded by its
+      /// size.
+      /// \return False if the batch is malformed.
+      public: static bool RunBatch(IRepHandler &_handler,
+                                   const std::string &_reqs,
+                                   std::string &_reps);
+
+      /// \brief Batches of the topics advertised with batching. The key is
+      /// the topic.
+      public: std::map<std::string, PublicationBatch> batches;
+
+      /// \brief Number of entries in batches, read without locking by the
+      /// publishers of topics that are not batched.
+      public: std::atomic<std::size_t> batchCount{0};
+
+      /// \brief Protects batches.
+      public: std::mutex batchMutex;
+
+      /// \brief Wakes up the batch thread.
+      public: std::condition_variable batchCondition;
+
+      /// \brief Thread that sends the batches whose period has elapsed.
+      public: std::thread batchThread;
+
+      /// \brief Register the sender of a real-time publisher, starting the
+      /// real-time thread with the first call.
+      /// \param[in] _publisher Key of the publisher.
+      /// \param[in] _send Function sending the messages committed by the
+      /// publisher.
+      public: void AddRealTimePublisher(const void *_publisher,
+                                        std::function<void()> _send);
+
+      /// \brief Unregister the sender of a real-time publisher. It isn't
+      /// running anymore when this function returns.
+      /// \param[in] _publisher Key of the publisher.
+      public: void RemoveRealTimePublisher(const void *_publisher);
+
+      /// \brief Send the messages committed by the real-time publishers.
+      /// The real-time threads can't wake up a thread without a system call
+      /// or a lock, so it polls their slots every kRealTimePeriod. This
+      /// function is designed to be run in a thread.
+      public: void RunRealTimeTask();
+
+      /// \brief Period of the real-time thread.
+      public: inline static const std::chrono::microseconds kRealTimePeriod{
+        100};
+
+      /// \brief Senders of the real-time publishers.
+      public: std::map<const void *, std::function<void()>> realTimeSenders;
+
+      /// \brief Protects realTimeSenders.
+      public: std::mutex realTimeMutex;
+
+      /// \brief Wakes up the real-time thread.
+      public: std::condition_variable realTimeCondition;
+
+      /// \brief Thread sending the messages of the real-time publishers.
+      public: std::thread realTimeThread;
+
+      /// \brief Compress the remote publications of a topic.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _opts Options of the publisher.
+      public: void CreateCompression(const std::string &_topic,
+                                     const AdvertiseMessageOptions &_opts);
+
+      /// \brief Stop compressing for a publisher of a topic. The settings
+      /// are removed with its last publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseCompression(const std::string &_topic);
+
+      /// \brief Codec to use for a remote publication.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[out] _level Compression level.
+      /// \return The codec, or NONE if the topic isn't compressed or a
+      /// remote subscriber can't decompress it.
+      public: Compression_t PublicationCodec(const NodeShared *_shared,
+                                             const std::string &_topic,
+                                             int &_level);
+
+      /// \brief Compression settings of the topics advertised with
+      /// compression. The key is the topic.
+      public: std::map<std::string, std::shared_ptr<TopicCompression>>
+        compressions;
+
+      /// \brief Number of entries in compressions, read without locking by
+      /// the publishers of topics that are not compressed.
+      public: std::atomic<std::size_t> compressionCount{0};
+
+      /// \brief Protects compressions.
+      public: std::mutex compressionMutex;
+
+      /// \brief Keep the last messages of a topic for late subscribers.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type.
+      /// \param[in] _opts Options of the publisher.
+      public: void CreateLatch(const NodeShared *_shared,
+                               const std::string &_topic,
+                               const std::string &_msgType,
+                               const AdvertiseMessageOptions &_opts);
+
+      /// \brief Stop latching for a publisher of a topic. The cache is
+      /// removed with its last publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseLatch(const std::string &_topic);
+
+      /// \brief Keep a message published on a latched topic. The oldest
+      /// message is dropped when the cache is full.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _data Serialized message. It is shared, not copied.
+      /// \param[in] _size Size of the message.
+      public: void StoreLatched(const std::string &_topic,
+                                const std::shared_ptr<char[]> &_data,
+                                std::size_t _size);
+
+      /// \brief Schedule the replay of a latched topic for a new remote
+      /// subscriber node.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _nUuid UUID of the subscriber node.
+      public: void QueueLatchedReplay(const std::string &_topic,
+                                      const std::string &_nUuid);
+
+      /// \brief Send latched messages to a remote subscriber node. This
+      /// function must be called without latchedMutex locked.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type.
+      /// \param[in] _nUuid UUID of the subscriber node.
+      /// \param[in] _msgs Messages to send, from the oldest to the newest.
+      public: void SendLatched(const NodeShared *_shared,
+                               const std::string &_topic,
+                               const std::string &_msgType,
+                               const std::string &_nUuid,
+                               const std::deque<LatchedTopic::Msg> &_msgs);
+
+      /// \brief Send the replays whose deadline has elapsed. This function
+      /// is designed to be run in a thread.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      public: void RunLatchTask(const NodeShared *_shared);
+
+      /// \brief Prefix of the type frame of a latched message. It is
+      /// followed by the type of the message. The payload starts with the
+      /// UUID of the destination node, preceded by its size.
+      public: inline static const std::string kLatchedMsgTypePrefix =
+        "gz.transport.Latched:";
+
+      /// \brief Delay between the registration of a subscriber node and the
+      /// replay, which gives its subscription time to reach our socket.
+      public: static constexpr std::chrono::milliseconds kLatchedReplayDelay{
+        100};
+
+      /// \brief Caches of the topics advertised with latching. The key is
+      /// the topic.
+      public: std::map<std::string, LatchedTopic> latched;
+
+      /// \brief Number of entries in latched, read without locking by the
+      /// publishers of topics that are not latched.
+      public: std::atomic<std::size_t> latchedCount{0};
+
+      /// \brief Replays waiting for their deadline.
+      public: std::vector<LatchedReplay> latchedReplays;
+
+      /// \brief Protects latched and latchedReplays.
+      public: std::mutex latchedMutex;
+
+      /// \brief Wakes up the latch thread.
+      public: std::condition_variable latchedCondition;
+
+      /// \brief Thread that sends the replays.
+      public: std::thread latchedThread;
+
+      /// \brief Number the remote publications of a topic and keep them for
+      /// retransmission, and start the reliability thread.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type.
+      /// \param[in] _opts Options of the publisher.
+      public: void CreateReliable(const NodeShared *_shared,
+                                  const std::string &_topic,
+                                  const std::string &_msgType,
+                                  const AdvertiseMessageOptions &_opts);
+
+      /// \brief Stop keeping the publications of a publisher of a topic.
+      /// The buffer is removed with its last publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseReliable(const std::string &_topic);
+
+      /// \brief Number a remote publication of a reliable topic, keep it and
+      /// send it.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the message.
+      /// \return False if the topic is not reliable.
+      public: bool ReliablePublish(const NodeShared *_shared,
+                                   const std::string &_topic,
+                                   const char *_data,
+                                   std::size_t _size);
+
+      /// \brief Send again the messages of a reliable topic requested by a
+      /// subscriber, if they are still kept.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _seqs Sequence numbers of the messages.
+      public: void Retransmit(const NodeShared *_shared,
+                              const std::string &_topic,
+                              const std::vector<uint64_t> &_seqs);
+
+      /// \brief Register a message received on a reliable topic, and
+      /// schedule the requests of the messages missing before it.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _sender Address of the publisher.
+      /// \param[in] _seq Sequence number of the message.
+      /// \return False if the message was already delivered.
+      public: bool ReceiveReliable(const NodeShared *_shared,
+                                   const std::string &_topic,
+                                   const std::string &_sender,
+                                   uint64_t _seq);
+
+      /// \brief Forget the messages received from a process that is gone.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      public: void ForgetReliable(const std::string &_pUuid);
+
+      /// \brief Start the reliability thread, if needed. reliableMutex must
+      /// be locked.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      public: void StartReliable(const NodeShared *_shared);
+
+      /// \brief Answer the retransmission requests of the subscribers,
+      /// send the last message of the reliable topics again after a burst
+      /// and request the missing messages from the publishers. This
+      /// function is designed to be run in a thread.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      public: void RunReliableTask(const NodeShared *_shared);
+
+      /// \brief Prefix of the type frame of a reliable publication. It is
+      /// followed by the type of the message. The payload starts with the
+      /// sequence number of the message (8 bytes, little endian).
+      public: inline static const std::string kReliableMsgTypePrefix =
+        "gz.transport.Reliable:";
+
+      /// \brief Prefix of the service answering the retransmission requests
+      /// of a process. It is followed by the process UUID.
+      public: inline static const std::string kRetransmitServicePrefix =
+        "/gz/transport/retransmit/";
+
+      /// \brief Delay after the last publication of a reliable topic before
+      /// its last message is sent again, so the subscribers that lost the
+      /// end of a burst find the gap.
+      public: static constexpr std::chrono::milliseconds kReliableTailDelay{
+        100};
+
+      /// \brief Partition of the retransmission services, shared by all the
+      /// processes.
+      public: inline static const std::string kRetransmitPartition =
+        "gz_transport";
+
+      /// \brief Buffers of the reliable topics advertised by this process.
+      /// The key is the topic.
+      public: std::map<std::string, ReliableTopic> reliableTopics;
+
+      /// \brief Next sequence number of each reliable topic. It outlives the
+      /// buffer, so a topic advertised again doesn't reuse the numbers.
+      public: std::map<std::string, uint64_t> reliableSeqs;
+
+      /// \brief Number of entries in reliableTopics, read without locking by
+      /// the publishers of topics that are not reliable.
+      public: std::atomic<std::size_t> reliableCount{0};
+
+      /// \brief Messages received on the reliable topics. The key is the
+      /// topic and the address of the publisher.
+      public: std::map<std::pair<std::string, std::string>, ReliableStream>
+                reliableStreams;
+
+      /// \brief Protects reliableTopics, reliableSeqs, reliableStreams,
+      /// creditTopics, creditStreams, adaptiveTopics and probeEchoes.
+      public: std::mutex reliableMutex;
+
+      /// \brief Wakes up the reliability thread.
+      public: std::condition_variable reliableCondition;
+
+      /// \brief Thread answering and sending the retransmission requests.
+      public: std::thread reliableThread;
+
+      /// \brief What a publisher does with a message of a topic with flow
+      /// control, see TakeCredit().
+      public: enum class CreditDecision
+      {
+        /// \brief Send the message to the remote subscribers.
+        SEND,
+
+        /// \brief Skip the remote subscribers.
+        SKIP,
+
+        /// \brief Skip the remote subscribers, but keep the message with
+        /// KeepLatest() for the conflated ones.
+        KEEP
+      };
+
+      /// \brief Credits and conflation of the flow control of the
+      /// subscribers of a node of this process.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type published on the topic.
+      /// \param[in] _nUuid Node UUID.
+      /// \param[out] _conflated Whether a subscriber of the node with flow
+      /// control is conflated.
+      /// \return The largest credits of the subscribers, or 0 if a
+      /// subscriber of the node doesn't use the flow control.
+      public: static uint64_t NodeCredits(const NodeShared *_shared,
+                                          const std::string &_topic,
+                                          const std::string &_msgType,
+                                          const std::string &_nUuid,
+                                          bool &_conflated);
+
+      /// \brief Count the messages received from a publisher of a topic
+      /// with flow control, to grant it new credits.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _addr Address of the publisher.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      /// \param[in] _credits Credits announced to the publisher.
+      public: void AttachCredits(const NodeShared *_shared,
+                                 const std::string &_topic,
+                                 const std::string &_addr,
+                                 const std::string &_pUuid,
+                                 uint64_t _credits);
+
+      /// \brief Acknowledge a message received on a topic. The credits are
+      /// granted back to the publisher by the reliability thread once half
+      /// of them are consumed.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _sender Address of the publisher.
+      public: void ConsumeCredit(const NodeShared *_shared,
+                                 const std::string &_topic,
+                                 const std::string &_sender);
+
+      /// \brief Forget the flow control of the messages received from a
+      /// process that is gone.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      public: void ForgetCredits(const std::string &_pUuid);
+
+      /// \brief Take a credit of the remote subscribers of a topic before
+      /// publishing a message.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return Whether the message is sent to the remote subscribers.
+      public: CreditDecision TakeCredit(const NodeShared *_shared,
+                                        const std::string &_topic);
+
+      /// \brief Keep the latest message skipped for the conflated remote
+      /// subscribers of a topic. It is sent when they grant new credits.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the message.
+      /// \param[in] _msgType Message type.
+      public: void KeepLatest(const std::string &_topic,
+                              const std::shared_ptr<char[]> &_data,
+                              std::size_t _size,
+                              const std::string &_msgType);
+
+      /// \brief Add the credits granted by a remote subscriber process of a
+      /// topic, and send it the latest message skipped if it is conflated.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _pUuid Process UUID of the subscribers.
+      /// \param[in] _credits Number of credits.
+      public: void GrantCredits(const NodeShared *_shared,
+                                const std::string &_topic,
+                                const std::string &_pUuid,
+                                uint64_t _credits);
+
+      /// \brief Prefix of the service receiving the credits granted to a
+      /// process. It is followed by the process UUID.
+      public: inline static const std::string kCreditServicePrefix =
+        "/gz/transport/credits/";
+
+      /// \brief Time after which a remote subscriber process without
+      /// credits gets them all back, in case its grants were lost.
+      public: static constexpr std::chrono::milliseconds kCreditTimeout{
+        1000};
+
+      /// \brief Flow control of the topics published by this process. The
+      /// key is the topic.
+      public: std::map<std::string, CreditTopic> creditTopics;
+
+      /// \brief Flow control of the messages received by this process. The
+      /// key is the topic and the address of the publisher.
+      public: std::map<std::pair<std::string, std::string>, CreditStream>
+                creditStreams;
+
+      /// \brief Number of entries in creditStreams, read without locking by
+      /// the reception threads.
+      public: std::atomic<std::size_t> creditStreamCount{0};
+
+      /// \brief Whether a remote subscriber has ever registered with flow
+      /// control, read without locking by the publishers.
+      public: std::atomic<bool> remoteCredits{false};
+
+      /// \brief Adapt the rate of the remote publications of a topic to its
+      /// latency target, and start the reliability thread, which probes the
+      /// round trip time to the subscribers.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _opts Options of the publisher.
+      public: void CreateAdaptive(const NodeShared *_shared,
+                                  const std::string &_topic,
+                                  const AdvertiseMessageOptions &_opts);
+
+      /// \brief Stop adapting the rate of a publisher of a topic. The state
+      /// is removed with the last publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      public: void ReleaseAdaptive(const std::string &_topic);
+
+      /// \brief Apply the adaptive rate of a topic to a publication to the
+      /// remote subscribers.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return SEND if the rate allows the message, KEEP otherwise: the
+      /// message is then kept with KeepLatest() and sent later if no newer
+      /// message replaces it.
+      public: CreditDecision AdaptRate(const std::string &_topic);
+
+      /// \brief Send the probes of the topics with an adaptive rate, detect
+      /// the probes lost and send the latest messages that the rate now
+      /// allows. reliableMutex must be locked, and is unlocked while the
+      /// messages are sent.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in, out] _lk Lock of reliableMutex.
+      /// \return When the function should run again, if ever.
+      public: std::optional<std::chrono::steady_clock::time_point>
+        ProbeAdaptive(const NodeShared *_shared,
+                      std::unique_lock<std::mutex> &_lk);
+
+      /// \brief Send a probe back to the publisher process that sent it.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Type frame of the probe.
+      /// \param[in] _data Payload of the probe.
+      public: void EchoProbe(const NodeShared *_shared,
+                             const std::string &_topic,
+                             const std::string &_msgType,
+                             const std::string &_data);
+
+      /// \brief Update the adaptive rate of a topic with a probe that a
+      /// remote subscriber process sent back.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _pUuid Process UUID of the subscribers.
+      /// \param[in] _probe Number of the probe.
+      public: void ReceiveEcho(const std::string &_topic,
+                               const std::string &_pUuid,
+                               uint64_t _probe);
+
+      /// \brief Halve the rate of a topic. reliableMutex must be locked.
+      /// \param[in, out] _adaptive The adaptive rate of the topic.
+      /// \param[in] _now Current time.
+      public: static void DecreaseRate(AdaptiveTopic &_adaptive,
+        const std::chrono::steady_clock::time_point &_now);
+
+      /// \brief Prefix of the type frame of a probe. The payload is a
+      /// msgs::UInt64_V with the number of the probe, and the process UUID
+      /// of the publisher in its header.
+      public: inline static const std::string kProbeMsgTypePrefix =
+        "gz.transport.Probe:";
+
+      /// \brief Prefix of the service receiving the probes sent back to a
+      /// process. It is followed by the process UUID.
+      public: inline static const std::string kProbeServicePrefix =
+        "/gz/transport/probes/";
+
+      /// \brief Time between the probes of a topic with an adaptive rate.
+      public: static constexpr std::chrono::milliseconds kProbeInterval{100};
+
+      /// \brief Time after which a probe, or the round trip time of a
+      /// subscriber process, is forgotten.
+      public: static constexpr std::chrono::milliseconds kProbeExpiry{2000};
+
+      /// \brief Lowest adaptive rate (msgs/s).
+      public: static constexpr double kMinAdaptiveRate = 1.0;
+
+      /// \brief Topics with an adaptive rate published by this process. The
+      /// key is the topic.
+      public: std::map<std::string, AdaptiveTopic> adaptiveTopics;
+
+      /// \brief Number of entries in adaptiveTopics, read without locking
+      /// by the publishers.
+      public: std::atomic<std::size_t> adaptiveCount{0};
+
+      /// \brief Probes waiting to be sent back by the reliability thread,
+      /// by service.
+      public: std::vector<std::pair<std::string, msgs::UInt64_V>> probeEchoes;
+
+      /// \brief Send the frames of a remote publication, with the legacy or
+      /// the compact header.
+      /// \param[in] _shared Pointer to the NodeShared instance.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type, or batch type.
+      /// \param[in, out] _data Payload of the publication.
+      /// \return True when success.
+      public: bool SendPublication(const NodeShared *_shared,
+                                   const std::string &_topic,
+                                   const std::string &_msgType,
+                                   zmq::message_t &_data);
+
+      /// \brief Send the frames of a remote publication with the legacy
+      /// header. The socket must be locked.
+      /// \param[in] _socket The socket.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _address Address of the socket.
+      /// \param[in, out] _data Payload of the publication.
+      /// \param[in] _msgType Type frame of the publication.
+      /// \param[in] _meta Metadata of the publication.
+      /// \param[in] _trace Trace of the publication.
+      /// \return False if the publication couldn't be queued.
+      public: bool SendFrames(zmq::socket_t &_socket,
+                              const std::string &_topic,
+                              const std::string &_address,
+                              zmq::message_t &_data,
+                              const std::string &_msgType,
+                              const PublicationMetadata &_meta,
+                              const TraceMetadata &_trace);
+
+      /// \brief Metadata of the next remote publication of a topic. The
+      /// socket of the sequence numbers must be locked.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in, out] _pubSeq Sequence numbers of the socket.
+      /// \return The metadata.
+      public: PublicationMetadata NextMetadata(const std::string &_topic,
+        std::map<std::string, uint64_t> &_pubSeq) const;
+
+      /// \brief Hand a remote publication over to the fragment thread if it
+      /// is larger than a fragment, or if earlier publications of its topic
+      /// are still being sent, which keeps the publications of a topic in
+      /// order.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Type frame of the publication.
+      /// \param[in] _socket Socket of the topic.
+      /// \param[in] _socketMutex Protects the socket.
+      /// \param[in, out] _pubSeq Sequence numbers of the socket.
+      /// \param[in] _address Address of the socket.
+      /// \param[in, out] _data Payload, moved if queued.
+      /// \param[in] _trace Trace of the publication.
+      /// \return False if the publication must be sent as usual.
+      public: bool QueueFragments(const std::string &_topic,
+                                  const std::string &_msgType,
+                                  zmq::socket_t &_socket,
+                                  std::mutex &_socketMutex,
+                                  std::map<std::string, uint64_t> &_pubSeq,
+                                  const std::string &_address,
+                                  zmq::message_t &_data,
+                                  const TraceMetadata &_trace);
+
+      /// \brief Send the queued publications one fragment at a time,
+      /// taking turns between the topics and pacing the fragments with
+      /// GZ_TRANSPORT_FRAGMENT_RATE. This function is designed to be run in
+      /// a thread.
+      public: void RunFragmentTask();
+
+      /// \brief Send a fragment of a queued publication.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _pub The publication.
+      /// \param[in] _index Index of the fragment.
+      /// \return Size of the fragment (bytes).
+      public: std::size_t SendFragment(const std::string &_topic,
+                                       FragmentedPublication &_pub,
+                                       const uint32_t _index);
+
+      /// \brief Remote publications larger than this size (bytes) are
+      /// split in fragments, see GZ_TRANSPORT_FRAGMENT_SIZE. 0 disables the
+      /// fragmentation.
+      public: std::size_t fragmentSize = 0;
+
+      /// \brief Maximum rate of the fragments (MB/s), or 0 if they are not
+      /// paced, see GZ_TRANSPORT_FRAGMENT_RATE.
+      public: int fragmentRate = 100;
+
+      /// \brief Publications waiting for the fragment thread, by topic.
       public: std::map<std::string,
-              std::function<void(const TopicStatistics &_stats)>>
-                enabledTopicStatistics;
+        std::deque<std::shared_ptr<FragmentedPublication>>> fragmentTopics;
+
+      /// \brief Number of entries in fragmentTopics, read without locking
+      /// by the publishers of small messages.
+      public: std::atomic<std::size_t> fragmentCount{0};
+
+      /// \brief ID of the next fragmented publication.
+      public: uint64_t nextFragmentId = 0;
+
+      /// \brief Protects fragmentTopics and nextFragmentId.
+      public: std::mutex fragmentMutex;
+
+      /// \brief Wakes up the fragment thread.
+      public: std::condition_variable fragmentCondition;
+
+      /// \brief Thread that sends the fragments.
+      public: std::thread fragmentThread;
+
+      /// \brief Reassembles the fragmented publications received, within
+      /// GZ_TRANSPORT_REASSEMBLY_BUDGET.
+      public: std::unique_ptr<FragmentReassembler> reassembler;
+
+      /// \brief Numeric ID of a publication in the compact header. Both
+      /// ends compute it from the publisher information exchanged during
+      /// discovery.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type, or batch type.
+      /// \param[in] _addr Address of the publisher.
+      /// \return The topic ID.
+      public: static uint64_t CompactTopicId(const std::string &_topic,
+                                             const std::string &_msgType,
+                                             const std::string &_addr);
+
+      /// \brief Subscription filter that matches a topic ID, i.e. its
+      /// little-endian encoding.
+      /// \param[in] _id The topic ID.
+      /// \return The filter.
+      public: static std::string CompactFilter(uint64_t _id);
+
+      /// \brief Learn the topic IDs of a remote publisher (regular and
+      /// batched publications).
+      /// \param[in] _pub The publisher.
+      /// \return The subscription filters of the new IDs.
+      public: std::vector<std::string> RegisterCompactTopic(
+        const MessagePublisher &_pub);
+
+      /// \brief Forget the topic IDs of a topic.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The subscription filters of the removed IDs.
+      public: std::vector<std::string> UnregisterCompactTopic(
+        const std::string &_topic);
+
+      /// \brief Numeric ID of a service in the single frame requests. Both
+      /// ends compute it from the service information exchanged during
+      /// discovery.
+      /// \param[in] _topic Service name.
+      /// \param[in] _reqType Request type, with the prefix of its kind of
+      /// call.
+      /// \param[in] _repType Response type.
+      /// \return The service ID.
+      public: static uint64_t ServiceId(const std::string &_topic,
+                                        const std::string &_reqType,
+                                        const std::string &_repType);
+
+      /// \brief Learn the service IDs of a service advertised by this
+      /// process (regular, batched and streamed requests).
+      /// \param[in] _pub The service publisher.
+      public: void RegisterEnvelopeService(const ServicePublisher &_pub);
+
+      /// \brief Whether the requests are sent in a single frame to the
+      /// responders that accept it.
+      public: bool srvEnvelope = true;
+
+      /// \brief Services of this process known by service ID. Protected by
+      /// NodeShared::mutex.
+      public: std::unordered_map<uint64_t, EnvelopeService> envelopeServices;
+
+      /// \brief Size of the compact header: topic ID and metadata.
+      public: static constexpr std::size_t kCompactHeaderSize =
+        sizeof(uint64_t) + sizeof(PublicationMetadata);
+
+      /// \brief Whether publications use the compact header.
+      public: bool compactHeader = false;
+
+      /// \brief Whether the topic frame of the publications is terminated
+      /// by a null character, so the prefix matching of the ZeroMQ filters
+      /// becomes an exact match. E.g. a subscriber of "/cam" doesn't
+      /// receive "/camera" anymore. The compact header is always exact.
+      public: bool exactTopics = false;
+
+      /// \brief Get the ZeroMQ subscription filter of a topic when the
+      /// compact header isn't used.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The filter.
+      public: std::string TopicFilter(const std::string &_topic) const;
+
+      /// \brief Remote publications known by topic ID.
+      public: std::unordered_map<uint64_t, CompactTopic> compactTopics;
+
+      /// \brief Protects compactTopics. It is read for every publication
+      /// received.
+      public: std::shared_mutex compactTopicsMutex;
+
+      /// \brief Protects the main subscriber socket. The reception thread
+      /// holds it while receiving the frames of a message.
+      public: std::mutex subscriberMutex;
+
+      /// \brief Register the gauges of this process in the metrics
+      /// registry and start the metrics endpoint if GZ_TRANSPORT_METRICS_PORT
+      /// is set.
+      public: void StartMetrics();
+
+      /// \brief Stop the metrics endpoint and remove the gauges.
+      public: void StopMetrics();
+
+      /// \brief Serve the metrics over HTTP until exit is set.
+      private: void RunMetricsServer();
+
+      /// \brief Answer an HTTP request received by the metrics endpoint.
+      /// \param[in] _request The start of the request.
+      /// \return The HTTP response.
+      public: static std::string MetricsResponse(const std::string &_request);
+
+      /// \brief Raw TCP (ZMQ_STREAM) socket of the metrics endpoint.
+      private: std::unique_ptr<zmq::socket_t> metricsSocket;
+
+      /// \brief Thread serving the metrics endpoint.
+      private: std::thread metricsThread;
+
+      /// \brief Socket used to stop the metrics thread.
+      private: std::unique_ptr<zmq::socket_t> metricsWakeSender;
+
+      /// \brief Socket polled by the metrics thread, so it exits as soon as
+      /// it is stopped.
+      private: std::unique_ptr<zmq::socket_t> metricsWakeReceiver;
     };
     }
   }
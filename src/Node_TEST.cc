@@ -20,16 +20,29 @@
 #include <gz/msgs/stringmsg.pb.h>
 #include <gz/msgs/vector3d.pb.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <csignal>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "gz/transport/MessageInfo.hh"
 #include "gz/transport/Node.hh"
+#include "gz/transport/NodeShared.hh"
+#include "gz/transport/TopicUtils.hh"
 #include "gz/transport/TransportTypes.hh"
 
 #include <gz/utils/Environment.hh>
@@ -57,6 +70,36 @@ static bool wrongResponseExecuted;
 static int counter = 0;
 static bool terminatePub = false;
 
+/// \brief Whether the allocations of the current thread are counted.
+static thread_local bool countAllocations = false;
+
+/// \brief Allocations counted in the current thread.
+static thread_local std::size_t allocations = 0;
+
+//////////////////////////////////////////////////
+/// \brief Count the allocations, see countAllocations.
+void *operator new(std::size_t _size)
+{
+  if (countAllocations)
+    ++allocations;
+
+  if (void *ptr = std::malloc(_size == 0 ? 1 : _size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
 //////////////////////////////////////////////////
 /// \brief Initialize some global variables.
 void reset()
@@ -596,6 +639,123 @@ TEST(NodeTest, PubWithoutAdvertise)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief HasConnections() follows the subscriptions of the process.
+TEST(NodeTest, PubHasConnections)
+{
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  ASSERT_TRUE(pub);
+  EXPECT_FALSE(pub.HasConnections());
+  EXPECT_FALSE(pub.HasConnections());
+
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+  EXPECT_TRUE(pub.HasConnections());
+
+  EXPECT_TRUE(node.Unsubscribe(g_topic));
+  EXPECT_FALSE(pub.HasConnections());
+}
+
+//////////////////////////////////////////////////
+/// \brief Advertise and subscribe to several topics at once.
+TEST(NodeTest, PubSubMany)
+{
+  const std::vector<std::string> topics = {"/many1", "/many2", "/many3"};
+
+  transport::Node node;
+  auto pubs = node.AdvertiseMany<msgs::Int32>(
+    {topics[0], topics[1], "invalid topic", topics[2], topics[0]});
+  ASSERT_EQ(5u, pubs.size());
+  EXPECT_TRUE(pubs[0]);
+  EXPECT_TRUE(pubs[1]);
+  EXPECT_FALSE(pubs[2]);
+  EXPECT_TRUE(pubs[3]);
+  EXPECT_FALSE(pubs[4]);
+  EXPECT_EQ(3u, node.AdvertisedTopics().size());
+
+  std::mutex mutex;
+  std::set<std::string> received;
+  std::function<void(const msgs::Int32 &, const transport::MessageInfo &)> f =
+    [&](const msgs::Int32 &, const transport::MessageInfo &_info)
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      received.insert(_info.Topic());
+    };
+
+  // Nothing is subscribed if a topic isn't valid.
+  EXPECT_FALSE(node.SubscribeMany<msgs::Int32>(
+    {topics[0], "invalid topic"}, f));
+  EXPECT_TRUE(node.SubscribedTopics().empty());
+
+  EXPECT_TRUE(node.SubscribeMany<msgs::Int32>(topics, f));
+  EXPECT_EQ(3u, node.SubscribedTopics().size());
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+  EXPECT_TRUE(pubs[0].Publish(msg));
+  EXPECT_TRUE(pubs[1].Publish(msg));
+  EXPECT_TRUE(pubs[3].Publish(msg));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::lock_guard<std::mutex> lk(mutex);
+  EXPECT_EQ(std::set<std::string>(topics.begin(), topics.end()), received);
+}
+
+/// \brief A message that isn't a protobuf message.
+struct ImuSample
+{
+  double acceleration[3];
+  int64_t stamp;
+};
+
+/// \brief Serialization of ImuSample.
+template<>
+struct gz::transport::SerializationTraits<ImuSample>
+  : gz::transport::PodSerializationTraits<ImuSample>
+{
+  static std::string TypeName()
+  {
+    return "test.ImuSample";
+  }
+};
+
+//////////////////////////////////////////////////
+/// \brief Publish and subscribe to messages with serialization traits.
+TEST(NodeTest, PubSubSerializationTraits)
+{
+  transport::Node node;
+  auto pub = node.Advertise<ImuSample>(g_topic);
+  ASSERT_TRUE(pub);
+
+  std::mutex mutex;
+  std::vector<int64_t> stamps;
+  std::string type;
+  EXPECT_TRUE(node.Subscribe<ImuSample>(g_topic,
+    [&](const ImuSample &_msg, const transport::MessageInfo &_info)
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      EXPECT_DOUBLE_EQ(2.0, _msg.acceleration[1]);
+      stamps.push_back(_msg.stamp);
+      type = _info.Type();
+    }));
+
+  ImuSample sample{{1.0, 2.0, 3.0}, 5};
+  EXPECT_TRUE(pub.Publish(sample));
+  sample.stamp = 6;
+  EXPECT_TRUE(pub.Publish(sample));
+
+  // A protobuf message can't be published on the topic.
+  msgs::Int32 msg;
+  EXPECT_FALSE(pub.Publish(msg));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::lock_guard<std::mutex> lk(mutex);
+  EXPECT_EQ(std::vector<int64_t>({5, 6}), stamps);
+  EXPECT_EQ("test.ImuSample", type);
+}
+
 //////////////////////////////////////////////////
 /// \brief A thread can create a node, and send and receive messages.
 TEST(NodeTest, PubSubSameThread)
@@ -849,6 +1009,460 @@ TEST(NodeTest, PubRawSubSameThreadMessageInfo)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that all the raw subscribers share the same serialized
+/// buffer when publishing a message.
+TEST(NodeTest, PubRawSubSharedBuffer)
+{
+  reset();
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+
+  std::mutex mutex;
+  std::vector<const char *> buffers;
+  auto rawCb = [&](const char *_msgData, const size_t _size,
+                   const transport::MessageInfo &)
+  {
+    msgs::Int32 rcvMsg;
+    EXPECT_TRUE(rcvMsg.ParseFromArray(_msgData, static_cast<int>(_size)));
+    EXPECT_EQ(data, rcvMsg.data());
+
+    std::lock_guard<std::mutex> lk(mutex);
+    buffers.push_back(_msgData);
+  };
+
+  transport::Node node1;
+  transport::Node node2;
+  auto pub = node1.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  EXPECT_TRUE(node1.SubscribeRaw(g_topic, rawCb));
+  EXPECT_TRUE(node2.SubscribeRaw(g_topic, rawCb));
+
+  // Wait some time before publishing.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  EXPECT_TRUE(pub.Publish(msg));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::lock_guard<std::mutex> lk(mutex);
+  ASSERT_EQ(2u, buffers.size());
+  EXPECT_EQ(buffers[0], buffers[1]);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief The handler snapshot of a topic is rebuilt only when its
+/// subscriptions change.
+TEST(NodeTest, HandlerSnapshot)
+{
+  reset();
+
+  transport::Node node1;
+  transport::Node node2;
+  std::string fullyQualifiedTopic;
+  ASSERT_TRUE(transport::TopicUtils::FullyQualifiedName(
+    node1.Options().Partition(), node1.Options().NameSpace(), g_topic,
+    fullyQualifiedTopic));
+
+  auto *shared = transport::NodeShared::Instance();
+  EXPECT_EQ(nullptr, shared->localSubscribers.Snapshot(fullyQualifiedTopic));
+
+  EXPECT_TRUE(node1.Subscribe(g_topic, cb));
+  auto first = shared->localSubscribers.Snapshot(fullyQualifiedTopic);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(1u, first->normal.size());
+  EXPECT_TRUE(first->raw.empty());
+
+  // No changes, the same snapshot is handed out.
+  EXPECT_EQ(first, shared->localSubscribers.Snapshot(fullyQualifiedTopic));
+
+  auto rawCb = [](const char *, const size_t, const transport::MessageInfo &)
+  {
+  };
+  EXPECT_TRUE(node2.SubscribeRaw(g_topic, rawCb));
+  auto second = shared->localSubscribers.Snapshot(fullyQualifiedTopic);
+  ASSERT_NE(nullptr, second);
+  EXPECT_GT(second->version, first->version);
+  EXPECT_EQ(1u, second->normal.size());
+  EXPECT_EQ(1u, second->raw.size());
+
+  // Old snapshots are immutable.
+  EXPECT_TRUE(first->raw.empty());
+
+  EXPECT_TRUE(second->normal[0]->Alive());
+  EXPECT_TRUE(node1.Unsubscribe(g_topic));
+  auto third = shared->localSubscribers.Snapshot(fullyQualifiedTopic);
+  ASSERT_NE(nullptr, third);
+  EXPECT_TRUE(third->normal.empty());
+  EXPECT_EQ(1u, third->raw.size());
+
+  // The handlers still referenced by old snapshots are detached, so the
+  // queued publications skip them.
+  EXPECT_FALSE(second->normal[0]->Alive());
+  EXPECT_TRUE(second->raw[0]->Alive());
+
+  EXPECT_TRUE(node2.Unsubscribe(g_topic));
+  EXPECT_EQ(nullptr, shared->localSubscribers.Snapshot(fullyQualifiedTopic));
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief A received payload is parsed once and the same message is shared
+/// by all the typed and generic handlers of the topic.
+TEST(NodeTest, TriggerCallbacksDeserializeOnce)
+{
+  reset();
+
+  transport::Node node1;
+  transport::Node node2;
+  std::string fullyQualifiedTopic;
+  ASSERT_TRUE(transport::TopicUtils::FullyQualifiedName(
+    node1.Options().Partition(), node1.Options().NameSpace(), g_topic,
+    fullyQualifiedTopic));
+
+  std::vector<const void *> received;
+  std::function<void(const msgs::Int32 &)> typedCb =
+    [&received](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(data, _msg.data());
+      received.push_back(&_msg);
+    };
+  std::function<void(const transport::ProtoMsg &)> anyCb =
+    [&received](const transport::ProtoMsg &_msg)
+    {
+      received.push_back(&_msg);
+    };
+
+  EXPECT_TRUE(node1.Subscribe(g_topic, anyCb));
+  EXPECT_TRUE(node1.Subscribe(g_topic, typedCb));
+  EXPECT_TRUE(node2.Subscribe(g_topic, typedCb));
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+  std::string payload;
+  ASSERT_TRUE(msg.SerializeToString(&payload));
+
+  transport::MessageInfo info;
+  info.SetTopicAndPartition(fullyQualifiedTopic);
+  info.SetType(msg.GetTypeName());
+
+  auto *shared = transport::NodeShared::Instance();
+  shared->TriggerCallbacks(info, payload,
+    shared->CheckHandlerInfo(fullyQualifiedTopic));
+
+  ASSERT_EQ(3u, received.size());
+  EXPECT_EQ(received[0], received[1]);
+  EXPECT_EQ(received[1], received[2]);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish a message serialized in place in a loaned buffer.
+TEST(NodeTest, PubLoanedBuffer)
+{
+  reset();
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  // A default publisher can't lend buffers.
+  transport::Node::Publisher emptyPub;
+  EXPECT_FALSE(emptyPub.LoanBuffer(4u).Valid());
+
+  std::atomic<int> typedCounter{0};
+  std::atomic<int> rawCounter{0};
+  std::function<void(const msgs::Int32 &)> typedCb =
+    [&typedCounter](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(data, _msg.data());
+      ++typedCounter;
+    };
+  auto rawCb = [&rawCounter](const char *_msgData, const size_t _size,
+                             const transport::MessageInfo &)
+    {
+      msgs::Int32 msg;
+      EXPECT_TRUE(msg.ParseFromArray(_msgData, static_cast<int>(_size)));
+      EXPECT_EQ(data, msg.data());
+      ++rawCounter;
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, typedCb));
+  EXPECT_TRUE(node.SubscribeRaw(g_topic, rawCb));
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    auto loan = pub.LoanBuffer(msg.ByteSizeLong());
+    ASSERT_TRUE(loan.Valid());
+    EXPECT_EQ(msg.ByteSizeLong(), loan.Size());
+    ASSERT_TRUE(msg.SerializeToArray(loan.Data(),
+      static_cast<int>(loan.Size())));
+    EXPECT_TRUE(pub.Publish(loan));
+
+    // The loan has been consumed.
+    EXPECT_FALSE(loan.Valid());
+    EXPECT_FALSE(pub.Publish(loan));
+  }
+
+  int retries = 0;
+  while ((typedCounter < 3 || rawCounter < 3) && retries++ < 100)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  EXPECT_EQ(3, typedCounter);
+  EXPECT_EQ(3, rawCounter);
+
+  // A buffer that doesn't hold a message of the advertised type when local
+  // subscribers need it is rejected.
+  auto badLoan = pub.LoanBuffer(3u);
+  ASSERT_TRUE(badLoan.Valid());
+  std::fill(badLoan.Data(), badLoan.Data() + badLoan.Size(), '\xff');
+  EXPECT_FALSE(pub.Publish(badLoan));
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish raw messages held in shared buffers, which are released
+/// once the subscribers got them.
+TEST(NodeTest, PubRawSharedBuffer)
+{
+  reset();
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  std::atomic<int> typedCounter{0};
+  std::atomic<int> rawCounter{0};
+  std::function<void(const msgs::Int32 &)> typedCb =
+    [&typedCounter](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(data, _msg.data());
+      ++typedCounter;
+    };
+  auto rawCb = [&rawCounter](const char *_msgData, const size_t _size,
+                             const transport::MessageInfo &)
+    {
+      msgs::Int32 msg;
+      EXPECT_TRUE(msg.ParseFromArray(_msgData, static_cast<int>(_size)));
+      EXPECT_EQ(data, msg.data());
+      ++rawCounter;
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, typedCb));
+  EXPECT_TRUE(node.SubscribeRaw(g_topic, rawCb));
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+  const std::string serialized = msg.SerializeAsString();
+
+  std::atomic<int> released{0};
+  for (int i = 0; i < 3; ++i)
+  {
+    std::shared_ptr<const char[]> buffer(serialized.data(),
+      [&released](const char *){++released;});
+    EXPECT_TRUE(pub.PublishRaw(buffer, serialized.size(),
+      msg.GetTypeName()));
+  }
+  EXPECT_FALSE(pub.PublishRaw(std::shared_ptr<const char[]>(), 0u,
+    msg.GetTypeName()));
+  EXPECT_FALSE(pub.PublishRaw(std::shared_ptr<const char[]>(new char[4]()),
+    4u, "gz.msgs.StringMsg"));
+
+  int retries = 0;
+  while ((typedCounter < 3 || rawCounter < 3 || released < 3) &&
+         retries++ < 100)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  EXPECT_EQ(3, typedCounter);
+  EXPECT_EQ(3, rawCounter);
+  EXPECT_EQ(3, released);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish messages shared with the local subscribers, which
+/// receive the published object itself instead of a copy.
+TEST(NodeTest, PubSharedMsg)
+{
+  reset();
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  std::mutex mutex;
+  std::vector<const transport::ProtoMsg *> received;
+  auto cb = [&mutex, &received](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(data, _msg.data());
+      std::lock_guard<std::mutex> lk(mutex);
+      received.push_back(&_msg);
+    };
+  EXPECT_TRUE(node.Subscribe<msgs::Int32>(g_topic, cb));
+
+  auto sharedMsg = std::make_shared<msgs::Int32>();
+  sharedMsg->set_data(data);
+  EXPECT_TRUE(pub.Publish(sharedMsg));
+
+  auto uniqueMsg = std::make_unique<msgs::Int32>();
+  uniqueMsg->set_data(data);
+  const transport::ProtoMsg *uniqueAddr = uniqueMsg.get();
+  EXPECT_TRUE(pub.Publish(std::move(uniqueMsg)));
+  EXPECT_EQ(nullptr, uniqueMsg);
+
+  // Empty and mismatched messages are rejected.
+  EXPECT_FALSE(pub.Publish(std::shared_ptr<const transport::ProtoMsg>()));
+  EXPECT_FALSE(pub.Publish(std::make_shared<msgs::StringMsg>()));
+  transport::Node::Publisher emptyPub;
+  EXPECT_FALSE(emptyPub.Publish(sharedMsg));
+
+  int retries = 0;
+  while (retries++ < 100)
+  {
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      if (received.size() >= 2u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::lock_guard<std::mutex> lk(mutex);
+  ASSERT_EQ(2u, received.size());
+  EXPECT_EQ(sharedMsg.get(), received[0]);
+  EXPECT_EQ(uniqueAddr, received[1]);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Publish with a publisher whose message type is fixed at compile
+/// time.
+TEST(NodeTest, PubTyped)
+{
+  reset();
+
+  transport::Node node;
+  transport::Node::TypedPublisher<msgs::Int32> emptyPub;
+  EXPECT_FALSE(emptyPub);
+  EXPECT_FALSE(emptyPub.Publish(msgs::Int32()));
+
+  auto pub = node.AdvertiseTyped<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+  EXPECT_EQ(msgs::Int32().GetTypeName(),
+    transport::Node::TypedPublisher<msgs::Int32>::TypeName());
+
+  std::mutex mutex;
+  std::vector<const transport::ProtoMsg *> received;
+  auto cb = [&mutex, &received](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(data, _msg.data());
+      std::lock_guard<std::mutex> lk(mutex);
+      received.push_back(&_msg);
+    };
+  EXPECT_TRUE(node.Subscribe<msgs::Int32>(g_topic, cb));
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+  EXPECT_TRUE(pub.Publish(msg));
+
+  auto sharedMsg = std::make_shared<msgs::Int32>();
+  sharedMsg->set_data(data);
+  EXPECT_TRUE(pub.Publish(sharedMsg));
+  EXPECT_FALSE(pub.Publish(std::shared_ptr<const msgs::Int32>()));
+
+  // It can be used as a regular publisher.
+  transport::Node::Publisher &basePub = pub;
+  EXPECT_TRUE(basePub.Publish(msg));
+  EXPECT_FALSE(basePub.Publish(msgs::StringMsg()));
+
+  int retries = 0;
+  while (retries++ < 100)
+  {
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      if (received.size() >= 3u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::lock_guard<std::mutex> lk(mutex);
+  ASSERT_EQ(3u, received.size());
+  EXPECT_EQ(sharedMsg.get(), received[1]);
+
+  reset();
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief Read the latest message of a topic from its blackboard.
+TEST(NodeTest, Blackboard)
+{
+  reset();
+
+  transport::Node node;
+  transport::Node::BlackboardReader emptyReader;
+  EXPECT_FALSE(emptyReader.Valid());
+  EXPECT_FALSE(node.OpenBlackboard("invalid topic").Valid());
+
+  // The reader may be created before the publisher.
+  auto reader = node.OpenBlackboard(g_topic);
+  EXPECT_TRUE(reader.Valid());
+  EXPECT_FALSE(reader.Updated());
+
+  transport::AdvertiseMessageOptions opts;
+  opts.SetBlackboard(true);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  ASSERT_TRUE(pub);
+
+  msgs::Int32 msg;
+  EXPECT_FALSE(reader.Read(msg));
+
+  // Only the latest message is read, without any subscriber.
+  for (int i = 1; i <= 3; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+  EXPECT_TRUE(reader.Updated());
+  msg.Clear();
+  ASSERT_TRUE(reader.Read(msg));
+  EXPECT_EQ(3, msg.data());
+  EXPECT_FALSE(reader.Updated());
+  EXPECT_FALSE(reader.Read(msg));
+
+  // Another reader gets the current value.
+  auto other = node.OpenBlackboard(g_topic);
+  std::string raw;
+  std::string msgType;
+  ASSERT_TRUE(other.ReadRaw(raw, msgType));
+  EXPECT_EQ(msg.GetTypeName(), msgType);
+  EXPECT_EQ(msg.SerializeAsString(), raw);
+
+  msg.set_data(4);
+  EXPECT_TRUE(pub.Publish(msg));
+  msgs::StringMsg wrongType;
+  EXPECT_FALSE(reader.Read(wrongType));
+  ASSERT_TRUE(reader.Read(msg));
+  EXPECT_EQ(4, msg.data());
+
+  reset();
+}
+#endif
+
 //////////////////////////////////////////////////
 /// \brief Subscribe to a topic using a lambda function.
 TEST(NodeTest, PubSubSameThreadLambda)
@@ -942,12 +1556,87 @@ TEST(NodeTest, PubSubSameThreadLambdaMessageInfo)
 }
 
 //////////////////////////////////////////////////
-/// \brief Advertise two topics with the same name. It's not possible to do it
-/// within the same node but it's valid on separate nodes.
-TEST(NodeTest, AdvertiseTwoEqualTopics)
+/// \brief Functor accepting the message with and without information.
+struct CallableCb
 {
-  transport::Node node1;
-  transport::Node node2;
+  void operator()(const msgs::Int32 &_msg)
+  {
+    EXPECT_EQ(_msg.data(), data);
+    ++(*this->withoutInfo);
+  }
+
+  void operator()(const msgs::Int32 &_msg,
+                  const transport::MessageInfo &_info)
+  {
+    EXPECT_EQ(_msg.data(), data);
+    EXPECT_EQ(_info.Topic(), g_topic);
+    ++(*this->withInfo);
+  }
+
+  std::shared_ptr<std::atomic<int>> withoutInfo;
+  std::shared_ptr<std::atomic<int>> withInfo;
+};
+
+//////////////////////////////////////////////////
+/// \brief Subscribe to a topic using callable objects stored without
+/// std::function: a move-only lambda and a functor.
+TEST(NodeTest, PubSubSameThreadCallable)
+{
+  reset();
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+
+  transport::Node node;
+
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  // A std::function can't hold a move-only lambda.
+  auto counter = std::make_unique<int>(0);
+  int *lambdaCount = counter.get();
+  EXPECT_TRUE(node.Subscribe<msgs::Int32>(g_topic,
+    [c = std::move(counter)](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(_msg.data(), data);
+      std::lock_guard<std::mutex> lk(cbMutex);
+      ++(*c);
+      cbCondition.notify_all();
+    }));
+
+  // The signature with message information is preferred.
+  CallableCb functor;
+  functor.withoutInfo = std::make_shared<std::atomic<int>>(0);
+  functor.withInfo = std::make_shared<std::atomic<int>>(0);
+  auto withoutInfo = functor.withoutInfo;
+  auto withInfo = functor.withInfo;
+  transport::Node node2;
+  EXPECT_TRUE(node2.Subscribe<msgs::Int32>(g_topic, functor));
+
+  // Give some time to the subscribers.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::unique_lock<std::mutex> lk(cbMutex);
+  EXPECT_TRUE(pub.Publish(msg));
+  EXPECT_TRUE(cbCondition.wait_for(lk, std::chrono::seconds(2),
+    [lambdaCount]{return *lambdaCount == 1;}));
+  lk.unlock();
+
+  for (int i = 0; i < 200 && *withInfo == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(1, *withInfo);
+  EXPECT_EQ(0, *withoutInfo);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Advertise two topics with the same name. It's not possible to do it
+/// within the same node but it's valid on separate nodes.
+TEST(NodeTest, AdvertiseTwoEqualTopics)
+{
+  transport::Node node1;
+  transport::Node node2;
 
   auto pub1 = node1.Advertise<msgs::Int32>(g_topic);
   EXPECT_TRUE(pub1);
@@ -1662,6 +2351,408 @@ TEST(NodeTest, ServiceCallSync)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief Make an asynchronous service call returning a future.
+TEST(NodeTest, ServiceCallFuture)
+{
+  reset();
+
+  msgs::Int32 req;
+  req.set_data(data);
+
+  transport::Node node;
+  EXPECT_TRUE(node.Advertise(g_topic, srvEcho));
+  EXPECT_TRUE(node.Advertise(g_topic + "_no_input", srvWithoutInput));
+
+  // Request an invalid service name.
+  auto invalid = node.RequestAsync<msgs::Int32>("invalid service", req);
+  ASSERT_EQ(std::future_status::ready,
+    invalid.wait_for(std::chrono::milliseconds(0)));
+  EXPECT_FALSE(invalid.get().has_value());
+
+  auto rep = node.RequestAsync<msgs::Int32>(g_topic, req);
+  ASSERT_EQ(std::future_status::ready,
+    rep.wait_for(std::chrono::milliseconds(1000)));
+  auto value = rep.get();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(req.data(), value->data());
+  EXPECT_TRUE(srvExecuted);
+
+  auto noInput = node.RequestAsync<msgs::Int32>(g_topic + "_no_input");
+  ASSERT_EQ(std::future_status::ready,
+    noInput.wait_for(std::chrono::milliseconds(1000)));
+  value = noInput.get();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(data, value->data());
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Make service calls with a prepared service client.
+TEST(NodeTest, ServiceClient)
+{
+  reset();
+
+  msgs::Int32 req;
+  req.set_data(data);
+
+  transport::NodeOptions opts;
+  opts.AddTopicRemap(g_topic_remap, g_topic);
+  transport::Node node(opts);
+  EXPECT_TRUE(node.Advertise(g_topic, srvEcho));
+
+  transport::Node::ServiceClient<msgs::Int32, msgs::Int32> none;
+  EXPECT_FALSE(none);
+  msgs::Int32 rep;
+  bool result = false;
+  EXPECT_FALSE(none.Request(req, 100, rep, result));
+
+  auto invalid =
+    node.CreateServiceClient<msgs::Int32, msgs::Int32>("invalid service");
+  EXPECT_FALSE(invalid.Valid());
+
+  // The client resolves the remapping once.
+  auto client = node.CreateServiceClient<msgs::Int32, msgs::Int32>(
+    g_topic_remap);
+  ASSERT_TRUE(client);
+  EXPECT_EQ(g_topic_remap, client.Service());
+
+  for (int i = 0; i < 3; ++i)
+  {
+    srvExecuted = false;
+    rep.Clear();
+    EXPECT_TRUE(client.Request(req, 1000, rep, result));
+    EXPECT_TRUE(result);
+    EXPECT_TRUE(srvExecuted);
+    EXPECT_EQ(data, rep.data());
+  }
+
+  auto future = client.RequestAsync(req);
+  ASSERT_EQ(std::future_status::ready,
+    future.wait_for(std::chrono::milliseconds(1000)));
+  auto value = future.get();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(data, value->data());
+
+  bool called = false;
+  EXPECT_TRUE(client.Request(req,
+    [&called](const msgs::Int32 &_rep, const bool _result)
+    {
+      EXPECT_TRUE(_result);
+      EXPECT_EQ(data, _rep.data());
+      called = true;
+    }));
+  EXPECT_TRUE(called);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Make a batch of service calls.
+TEST(NodeTest, ServiceCallBatch)
+{
+  reset();
+
+  std::vector<msgs::Int32> reqs(3);
+  for (int i = 0; i < 3; ++i)
+    reqs[i].set_data(i);
+
+  std::vector<msgs::Int32> reps;
+  std::vector<bool> results;
+
+  transport::Node node;
+
+  // A regular service runs the requests one by one.
+  EXPECT_TRUE(node.Advertise(g_topic, srvEcho));
+  EXPECT_TRUE(node.RequestBatch(g_topic, reqs, 1000u, reps, results));
+  ASSERT_EQ(3u, reps.size());
+  ASSERT_EQ(3u, results.size());
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_TRUE(results[i]);
+    EXPECT_EQ(i, reps[i].data());
+  }
+
+  // A batch service gets all the requests together.
+  std::size_t batchSize = 0;
+  std::function<bool(const std::vector<msgs::Int32> &,
+                     std::vector<msgs::Int32> &)> batchCb =
+    [&batchSize](const std::vector<msgs::Int32> &_reqs,
+                 std::vector<msgs::Int32> &_reps)
+  {
+    batchSize = _reqs.size();
+    _reps.resize(_reqs.size());
+    for (std::size_t i = 0; i < _reqs.size(); ++i)
+      _reps[i].set_data(_reqs[i].data() * 2);
+    return true;
+  };
+  const std::string batchTopic = g_topic + "_batch";
+  EXPECT_TRUE(node.AdvertiseBatch(batchTopic, batchCb));
+  EXPECT_TRUE(node.RequestBatch(batchTopic, reqs, 1000u, reps, results));
+  EXPECT_EQ(3u, batchSize);
+  ASSERT_EQ(3u, reps.size());
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_TRUE(results[i]);
+    EXPECT_EQ(2 * i, reps[i].data());
+  }
+
+  // Single requests are a batch of one.
+  msgs::Int32 rep;
+  bool result = false;
+  EXPECT_TRUE(node.Request(batchTopic, reqs[2], 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(1u, batchSize);
+  EXPECT_EQ(4, rep.data());
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Make a service call whose response is streamed.
+TEST(NodeTest, ServiceCallStream)
+{
+  reset();
+
+  msgs::Int32 req;
+  req.set_data(3);
+
+  std::vector<int> chunks;
+  bool done = false;
+  bool doneResult = false;
+  std::function<void(const msgs::Int32 &)> chunkCb =
+    [&chunks](const msgs::Int32 &_chunk)
+  {
+    chunks.push_back(_chunk.data());
+  };
+  std::function<void(const bool)> doneCb =
+    [&done, &doneResult](const bool _result)
+  {
+    done = true;
+    doneResult = _result;
+  };
+
+  transport::Node node;
+
+  // A regular service sends a single chunk.
+  EXPECT_TRUE(node.Advertise(g_topic, srvEcho));
+  EXPECT_TRUE(node.RequestStream(g_topic, req, chunkCb, doneCb));
+  EXPECT_TRUE(done);
+  EXPECT_TRUE(doneResult);
+  EXPECT_EQ(std::vector<int>({3}), chunks);
+
+  // A streaming service sends one chunk per emit.
+  std::function<bool(const msgs::Int32 &,
+    const std::function<bool(const msgs::Int32 &)> &)> streamCb =
+    [](const msgs::Int32 &_req,
+       const std::function<bool(const msgs::Int32 &)> &_emit)
+  {
+    msgs::Int32 chunk;
+    for (int i = 0; i < _req.data(); ++i)
+    {
+      chunk.set_data(i);
+      if (!_emit(chunk))
+        return false;
+    }
+    return true;
+  };
+  const std::string streamTopic = g_topic + "_stream";
+  EXPECT_TRUE(node.AdvertiseStream(streamTopic, streamCb));
+
+  chunks.clear();
+  done = false;
+  EXPECT_TRUE(node.RequestStream(streamTopic, req, chunkCb, doneCb));
+  EXPECT_TRUE(done);
+  EXPECT_TRUE(doneResult);
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), chunks);
+
+  // Regular requests get the chunks merged.
+  msgs::Int32 rep;
+  bool result = false;
+  EXPECT_TRUE(node.Request(streamTopic, req, 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(2, rep.data());
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a local service call passes the caller's messages to
+/// the responser without copying them.
+TEST(NodeTest, ServiceCallLocalNoCopy)
+{
+  reset();
+
+  msgs::Int32 req;
+  req.set_data(data);
+  msgs::Int32 rep;
+  bool result = false;
+
+  const msgs::Int32 *reqSeen = nullptr;
+  msgs::Int32 *repSeen = nullptr;
+  std::function<bool(const msgs::Int32 &, msgs::Int32 &)> cb =
+    [&reqSeen, &repSeen](const msgs::Int32 &_req, msgs::Int32 &_rep)
+  {
+    reqSeen = &_req;
+    repSeen = &_rep;
+    _rep.set_data(_req.data());
+    return true;
+  };
+
+  transport::Node node;
+  EXPECT_TRUE(node.Advertise(g_topic, cb));
+  EXPECT_TRUE(node.Request(g_topic, req, 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(data, rep.data());
+  EXPECT_EQ(&req, reqSeen);
+  EXPECT_EQ(&rep, repSeen);
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a local responser gets the deadline of the request and
+/// that expired requests are not made.
+TEST(NodeTest, ServiceCallDeadline)
+{
+  reset();
+
+  msgs::Int32 req;
+  req.set_data(data);
+  msgs::Int32 rep;
+  bool result = false;
+
+  int calls = 0;
+  auto deadline = std::chrono::steady_clock::time_point::max();
+  std::function<bool(const msgs::Int32 &, msgs::Int32 &)> cb =
+    [&calls, &deadline](const msgs::Int32 &_req, msgs::Int32 &_rep)
+  {
+    ++calls;
+    deadline = transport::ServiceContext::Deadline();
+    _rep.set_data(_req.data());
+    return true;
+  };
+
+  transport::Node node;
+  EXPECT_TRUE(node.Advertise(g_topic, cb));
+
+  const auto before = std::chrono::steady_clock::now();
+  EXPECT_TRUE(node.Request(g_topic, req, 500u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(1, calls);
+  EXPECT_GE(deadline, before + std::chrono::milliseconds(500));
+  EXPECT_LE(deadline,
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(500));
+
+  // The deadline of the thread is restored after the request.
+  EXPECT_EQ(std::chrono::steady_clock::time_point::max(),
+    transport::ServiceContext::Deadline());
+
+  {
+    transport::ServiceContext context(std::chrono::steady_clock::now());
+    EXPECT_FALSE(node.Request(g_topic, req, 500u, rep, result));
+    EXPECT_FALSE(node.Request(g_topic, req, response));
+    EXPECT_EQ(1, calls);
+  }
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that publications and service calls update the metrics.
+TEST(NodeTest, Metrics)
+{
+  reset();
+
+  transport::Metrics &metrics = transport::Metrics::Instance();
+  const std::string fqnTopic = "@" + g_FQNPartition + "@" + g_topic;
+  const uint64_t sent =
+    metrics.Value(fqnTopic, transport::Metrics::Counter::MSGS_SENT);
+  const uint64_t served =
+    metrics.Value(fqnTopic, transport::Metrics::Counter::REQUESTS_SERVED);
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  ASSERT_TRUE(pub);
+  msgs::Int32 msg;
+  msg.set_data(data);
+  EXPECT_TRUE(pub.Publish(msg));
+  EXPECT_TRUE(pub.Publish(msg));
+  EXPECT_EQ(sent + 2,
+    metrics.Value(fqnTopic, transport::Metrics::Counter::MSGS_SENT));
+
+  EXPECT_TRUE(node.Advertise(g_topic, srvEcho));
+  msgs::Int32 rep;
+  bool result = false;
+  EXPECT_TRUE(node.Request(g_topic, msg, 500u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(served + 1,
+    metrics.Value(fqnTopic, transport::Metrics::Counter::REQUESTS_SERVED));
+  EXPECT_LE(1u, metrics.RequestLatency(fqnTopic).Count());
+
+  const std::string text = metrics.OpenMetrics();
+  EXPECT_NE(std::string::npos, text.find("gz_transport_pub_queue_depth "));
+  EXPECT_NE(std::string::npos,
+    text.find("{topic=\"" + fqnTopic + "\"}"));
+
+  reset();
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the statistics measured by a publisher.
+TEST(NodeTest, PublisherStatistics)
+{
+  reset();
+
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetStatisticsTopic("/pub_stats", 1000u);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  ASSERT_TRUE(pub);
+
+  std::atomic<int> statsReceived{0};
+  std::function<void(const msgs::Metric &)> statsCb =
+    [&statsReceived](const msgs::Metric &_msg)
+    {
+      EXPECT_EQ(3, _msg.statistics_groups_size());
+      ++statsReceived;
+    };
+  EXPECT_TRUE(node.Subscribe("/pub_stats", statsCb));
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+
+  // Nobody subscribes to the topic yet.
+  EXPECT_TRUE(pub.Publish(msg));
+  transport::PublisherStatistics stats = pub.Statistics();
+  EXPECT_EQ(1u, stats.PublicationCount());
+  EXPECT_EQ(1u, stats.UnsubscribedCount());
+  EXPECT_EQ(0u, stats.SerializationCount());
+
+  // A local subscriber goes through the publication queue.
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+  EXPECT_TRUE(pub.Publish(msg));
+  for (int i = 0; i < 100 && !cbExecuted; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(cbExecuted);
+
+  stats = pub.Statistics();
+  EXPECT_EQ(2u, stats.PublicationCount());
+  EXPECT_EQ(1u, stats.UnsubscribedCount());
+  EXPECT_EQ(1u, stats.QueuedCount());
+  EXPECT_LE(stats.MaxQueueWaitTime(), stats.QueueWaitTime());
+  EXPECT_EQ(0u, stats.SendFailureCount());
+  EXPECT_LT(0u, stats.Bytes());
+
+  // The statistics are published with the messages.
+  for (int i = 0; i < 100 && statsReceived == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_LT(0, statsReceived);
+
+  reset();
+}
+
 //////////////////////////////////////////////////
 /// \brief Make a synchronous service call without input.
 TEST(NodeTest, ServiceCallWithoutInputSync)
@@ -2020,6 +3111,173 @@ TEST(NodeTest, PubThrottled)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief A publisher with a bounded queue drops its oldest messages while
+/// a slow local callback is running, and counts them in the statistics.
+TEST(NodeTest, PubQueueDropOldest)
+{
+  std::mutex mutex;
+  std::vector<int> received;
+  std::function<void(const msgs::Int32 &)> slowCb =
+    [&mutex, &received](const msgs::Int32 &_msg)
+    {
+      {
+        std::lock_guard<std::mutex> lk(mutex);
+        received.push_back(_msg.data());
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    };
+
+  transport::Node node;
+  EXPECT_TRUE(node.EnableStats(g_topic, true));
+
+  transport::AdvertiseMessageOptions opts;
+  opts.SetQueue(2u, transport::QueuePolicy_t::DROP_OLDEST);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  EXPECT_TRUE(pub);
+  EXPECT_TRUE(node.Subscribe(g_topic, slowCb));
+
+  msgs::Int32 msg;
+  msg.set_data(0);
+  EXPECT_TRUE(pub.Publish(msg));
+
+  // Let the callback start with the first message.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (int i = 1; i < 10; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    EXPECT_EQ(std::vector<int>({0, 8, 9}), received);
+  }
+
+  auto stats = node.TopicStats(g_topic);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(7u, stats->DroppedMsgCount());
+}
+
+//////////////////////////////////////////////////
+/// \brief Concurrent publishers with a KEEP_ALL queue wait for room while
+/// a slow local callback is running, and no message is lost.
+TEST(NodeTest, PubQueueKeepAll)
+{
+  std::atomic<int> received{0};
+  std::function<void(const msgs::Int32 &)> slowCb =
+    [&received](const msgs::Int32 &)
+    {
+      ++received;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    };
+
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetQueue(2u, transport::QueuePolicy_t::KEEP_ALL);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  EXPECT_TRUE(pub);
+  EXPECT_TRUE(node.Subscribe(g_topic, slowCb));
+
+  const int kThreads = 3;
+  const int kMsgs = 5;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    threads.emplace_back([&pub]()
+    {
+      msgs::Int32 msg;
+      for (int i = 0; i < kMsgs; ++i)
+      {
+        msg.set_data(i);
+        EXPECT_TRUE(pub.Publish(msg));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  for (int i = 0; i < 200 && received < kThreads * kMsgs; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(kThreads * kMsgs, received);
+}
+
+//////////////////////////////////////////////////
+/// \brief A slow callback of a regular topic doesn't delay the local
+/// subscribers of a high priority topic.
+TEST(NodeTest, PubPriorityLane)
+{
+  std::atomic<bool> bulkStarted{false};
+  std::function<void(const msgs::Int32 &)> slowCb =
+    [&bulkStarted](const msgs::Int32 &)
+    {
+      bulkStarted = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    };
+
+  std::atomic<bool> commandReceived{false};
+  std::function<void(const msgs::Int32 &)> commandCb =
+    [&commandReceived](const msgs::Int32 &)
+    {
+      commandReceived = true;
+    };
+
+  transport::Node node;
+  auto bulkPub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(bulkPub);
+  EXPECT_TRUE(node.Subscribe(g_topic, slowCb));
+
+  transport::AdvertiseMessageOptions opts;
+  opts.SetHighPriority(true);
+  auto commandPub = node.Advertise<msgs::Int32>(g_topic_remap, opts);
+  EXPECT_TRUE(commandPub);
+  EXPECT_TRUE(node.Subscribe(g_topic_remap, commandCb));
+
+  msgs::Int32 msg;
+  msg.set_data(data);
+  EXPECT_TRUE(bulkPub.Publish(msg));
+  for (int i = 0; i < 50 && !bulkStarted; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(bulkStarted);
+
+  // Another regular message waits for the slow callback.
+  EXPECT_TRUE(bulkPub.Publish(msg));
+  EXPECT_TRUE(commandPub.Publish(msg));
+  for (int i = 0; i < 50 && !commandReceived; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(commandReceived);
+}
+
+//////////////////////////////////////////////////
+/// \brief A topic advertised on a network interface is sent through a
+/// socket bound to that interface.
+TEST(NodeTest, PubInterface)
+{
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetInterface("127.0.0.1");
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  ASSERT_TRUE(pub);
+
+  std::vector<transport::MessagePublisher> publishers;
+  std::vector<transport::MessagePublisher> subscribers;
+  for (int i = 0; i < 50 && publishers.empty(); ++i)
+  {
+    EXPECT_TRUE(node.TopicInfo(g_topic, publishers, subscribers));
+    if (publishers.empty())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(1u, publishers.size());
+  EXPECT_EQ(0u, publishers[0].Addr().find("tcp://127.0.0.1:"));
+
+  // Addresses of unknown interfaces are rejected.
+  transport::AdvertiseMessageOptions badOpts;
+  badOpts.SetInterface("203.0.113.1");
+  EXPECT_FALSE(node.Advertise<msgs::Int32>(g_topic_remap, badOpts));
+}
+
 //////////////////////////////////////////////////
 /// \brief This test creates one local publisher and subscriber and
 /// checks that no messages are received when using SetIgnoreLocalMessages
@@ -2257,6 +3515,64 @@ TEST(NodeTest, TopicListRemap)
   EXPECT_EQ(g_topic_remap, topics.at(0));
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that WatchTopicGraph() returns the publishers already known
+/// and notifies the ones that come and go afterwards.
+TEST(NodeTest, WatchTopicGraph)
+{
+  transport::Node node1;
+  transport::Node watcher;
+
+  auto pub1 = node1.Advertise<msgs::Int32>("graph1");
+
+  std::vector<transport::MessagePublisher> added;
+  std::vector<transport::MessagePublisher> removed;
+  auto cb = [&](const transport::MessagePublisher &_pub, bool _added)
+  {
+    if (_added)
+      added.push_back(_pub);
+    else
+      removed.push_back(_pub);
+  };
+
+  std::vector<transport::MessagePublisher> snapshot;
+  EXPECT_FALSE(watcher.WatchTopicGraph(snapshot, nullptr));
+  ASSERT_TRUE(watcher.WatchTopicGraph(snapshot, cb));
+
+  bool found = false;
+  for (const auto &pub : snapshot)
+    found = found || pub.Topic().find("/graph1") != std::string::npos;
+  EXPECT_TRUE(found);
+  EXPECT_TRUE(added.empty());
+
+  // A new publisher is notified once.
+  {
+    auto pub2 = node1.Advertise<msgs::Int32>("graph2");
+    ASSERT_EQ(1u, added.size());
+    EXPECT_NE(std::string::npos, added.front().Topic().find("/graph2"));
+    EXPECT_TRUE(removed.empty());
+  }
+
+  // And so is its removal.
+  ASSERT_EQ(1u, removed.size());
+  EXPECT_NE(std::string::npos, removed.front().Topic().find("/graph2"));
+
+  // No more notifications.
+  EXPECT_TRUE(watcher.UnwatchTopicGraph());
+  EXPECT_FALSE(watcher.UnwatchTopicGraph());
+  auto pub3 = node1.Advertise<msgs::Int32>("graph3");
+  EXPECT_EQ(1u, added.size());
+
+  // Other partitions are not visible.
+  transport::NodeOptions opts;
+  opts.SetPartition("another_partition");
+  transport::Node other(opts);
+  ASSERT_TRUE(other.WatchTopicGraph(snapshot, cb));
+  EXPECT_TRUE(snapshot.empty());
+  auto pub4 = node1.Advertise<msgs::Int32>("graph4");
+  EXPECT_EQ(1u, added.size());
+}
+
 //////////////////////////////////////////////////
 /// \brief This test creates two nodes and advertises some services. The test
 /// verifies that ServiceList() returns the list of all the services advertised.
@@ -2331,6 +3647,104 @@ TEST(NodeTest, SndHwm)
   EXPECT_EQ(transport::kDefaultSndHwm, transport::sndHwm());
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that the callbacks of a node in spin mode run when the
+/// node is spun, on the spinning thread.
+TEST(NodeTest, SpinMode)
+{
+  transport::NodeOptions opts;
+  opts.SetSpinMode(true);
+  transport::Node spinNode(opts);
+  transport::Node node;
+
+  // A node not in spin mode never has callbacks to spin.
+  EXPECT_FALSE(node.SpinOnce());
+  EXPECT_EQ(0u, node.SpinSome());
+  EXPECT_EQ(-1, node.SpinFd());
+
+  std::vector<int> received;
+  std::thread::id cbThread;
+  std::function<void(const msgs::Int32 &)> spinCb =
+    [&received, &cbThread](const msgs::Int32 &_msg)
+    {
+      received.push_back(_msg.data());
+      cbThread = std::this_thread::get_id();
+    };
+  EXPECT_TRUE(spinNode.Subscribe(g_topic, spinCb));
+
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+
+  msgs::Int32 msg;
+  for (int i = 0; i < 3; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+
+  // Nothing runs until the node is spun.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_TRUE(received.empty());
+
+  EXPECT_TRUE(spinNode.SpinOnce(std::chrono::milliseconds(100)));
+  ASSERT_EQ(1u, received.size());
+  EXPECT_EQ(std::this_thread::get_id(), cbThread);
+
+  EXPECT_EQ(2u, spinNode.SpinSome());
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), received);
+  EXPECT_FALSE(spinNode.SpinOnce(std::chrono::milliseconds(10)));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the callbacks of a subscription assigned to a callback
+/// group run on the threads of the group.
+TEST(NodeTest, CallbackGroup)
+{
+  transport::Node node;
+  EXPECT_FALSE(node.CreateCallbackGroup(""));
+  EXPECT_TRUE(node.CreateCallbackGroup("control"));
+  EXPECT_FALSE(node.CreateCallbackGroup("control"));
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::thread::id groupThread;
+  std::thread::id sharedThread;
+  auto record = [&](std::thread::id &_thread)
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    _thread = std::this_thread::get_id();
+    condition.notify_all();
+  };
+
+  transport::SubscribeOptions opts;
+  opts.SetCallbackGroup("control");
+  std::function<void(const msgs::Int32 &)> groupCb =
+    [&](const msgs::Int32 &) { record(groupThread); };
+  EXPECT_TRUE(node.Subscribe(g_topic, groupCb, opts));
+
+  transport::Node other;
+  std::function<void(const msgs::Int32 &)> sharedCb =
+    [&](const msgs::Int32 &) { record(sharedThread); };
+  EXPECT_TRUE(other.Subscribe(g_topic, sharedCb));
+
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  EXPECT_TRUE(pub);
+  msgs::Int32 msg;
+  msg.set_data(data);
+  EXPECT_TRUE(pub.Publish(msg));
+
+  std::unique_lock<std::mutex> lk(mutex);
+  EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(5),
+    [&]()
+    {
+      return groupThread != std::thread::id() &&
+             sharedThread != std::thread::id();
+    }));
+  EXPECT_NE(groupThread, sharedThread);
+  EXPECT_NE(std::this_thread::get_id(), groupThread);
+  lk.unlock();
+}
+
 //////////////////////////////////////////////////
 /// \brief Check that we destruct a Node object before a Node::Publisher.
 TEST(NodePubTest, DestructionOrder)
@@ -2401,6 +3815,141 @@ TEST(NodeTest, relay) {
   }
 }
 
+//////////////////////////////////////////////////
+/// \brief Publish from a real-time thread without allocating.
+TEST(NodeTest, RealTimePublish)
+{
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetRealTime(4, 64);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  ASSERT_TRUE(pub);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<int> received;
+  std::function<void(const msgs::Int32 &)> cb =
+    [&](const msgs::Int32 &_msg)
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      received.push_back(_msg.data());
+      condition.notify_all();
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+
+  msgs::Int32 msg;
+  msg.set_data(7);
+  msgs::StringMsg wrongMsg;
+
+  countAllocations = true;
+  allocations = 0;
+  const bool published = pub.Publish(msg);
+  const bool wrongPublished = pub.Publish(wrongMsg);
+  countAllocations = false;
+
+  EXPECT_TRUE(published);
+  EXPECT_FALSE(wrongPublished);
+  EXPECT_EQ(0u, allocations);
+  EXPECT_EQ(1u, pub.Statistics().RealTimeDropCount());
+
+  // The sender thread delivers the message.
+  std::unique_lock<std::mutex> lk(mutex);
+  EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(1),
+    [&received]{return !received.empty();}));
+  EXPECT_EQ(std::vector<int>{7}, received);
+}
+
+//////////////////////////////////////////////////
+/// \brief A burst passes the rate limit up to the capacity of the bucket.
+TEST(NodeTest, RateLimitBurst)
+{
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetRateLimit(1, 3);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  ASSERT_TRUE(pub);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int received = 0;
+  std::function<void(const msgs::Int32 &)> cb =
+    [&](const msgs::Int32 &)
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      ++received;
+      condition.notify_all();
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+
+  msgs::Int32 msg;
+  for (int i = 0; i < 10; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+
+  std::unique_lock<std::mutex> lk(mutex);
+  EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(1),
+    [&received]{return received == 3;}));
+  lk.unlock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  lk.lock();
+  EXPECT_EQ(3, received);
+  EXPECT_EQ(7u, pub.Statistics().RateLimitedCount());
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief The subscribers of the process receive a duplicate of the file
+/// descriptor passed with a message.
+TEST(NodeTest, PublishFd)
+{
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetFdPassing(true);
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+  ASSERT_TRUE(pub);
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int received = -1;
+  std::function<void(const msgs::Int32 &, const transport::MessageInfo &)>
+    cb = [&](const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+    {
+      EXPECT_GE(_info.Fd(), 0);
+      EXPECT_EQ(1, write(_info.Fd(), "x", 1));
+      std::lock_guard<std::mutex> lk(mutex);
+      received = _msg.data();
+      condition.notify_all();
+    };
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+
+  int pipeFds[2];
+  ASSERT_EQ(0, pipe(pipeFds));
+  msgs::Int32 msg;
+  msg.set_data(3);
+  EXPECT_TRUE(pub.PublishFd(msg, pipeFds[1]));
+  close(pipeFds[1]);
+
+  {
+    std::unique_lock<std::mutex> lk(mutex);
+    EXPECT_TRUE(condition.wait_for(lk, std::chrono::seconds(1),
+      [&received]{return received == 3;}));
+  }
+
+  // The duplicate is closed once delivered, so the pipe ends.
+  char buffer[2];
+  EXPECT_EQ(1, read(pipeFds[0], buffer, 2));
+  EXPECT_EQ(0, read(pipeFds[0], buffer, 2));
+  close(pipeFds[0]);
+
+  // A publisher without descriptor passing refuses them.
+  auto otherPub = node.Advertise<msgs::Int32>(g_topic + "_other");
+  ASSERT_TRUE(otherPub);
+  EXPECT_FALSE(otherPub.PublishFd(msg, 0));
+}
+#endif
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_PROBES_HH_
+#define GZ_TRANSPORT_PROBES_HH_
+
+#include <utility>
+
+#include "gz/transport/config.hh"
+
+// Statically defined tracepoints (USDT) of the provider "gz_transport",
+// which bpftrace, perf or SystemTap attach to in a running process, e.g.
+//   bpftrace -e 'usdt:/usr/lib/libgz-transport14.so:gz_transport:receive
+//     { @[str(arg0)] = count(); }'
+// A probe is a single nop instruction until a tracer attaches to it. The
+// probes are compiled out when <sys/sdt.h> is missing, and their arguments
+// are then never evaluated.
+#ifdef HAVE_SDT
+#include <sys/sdt.h>
+#define GZ_TRANSPORT_PROBE1(_name, _a) \
+  DTRACE_PROBE1(gz_transport, _name, _a)
+#define GZ_TRANSPORT_PROBE2(_name, _a, _b) \
+  DTRACE_PROBE2(gz_transport, _name, _a, _b)
+#define GZ_TRANSPORT_PROBE3(_name, _a, _b, _c) \
+  DTRACE_PROBE3(gz_transport, _name, _a, _b, _c)
+#else
+#define GZ_TRANSPORT_PROBE1(_name, _a) ((void)0)
+#define GZ_TRANSPORT_PROBE2(_name, _a, _b) ((void)0)
+#define GZ_TRANSPORT_PROBE3(_name, _a, _b, _c) ((void)0)
+#endif
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Fires the probe ending a stage when the scope of the stage
+    /// is left, whichever way it is.
+    /// \tparam F Function firing the probe.
+    template<typename F>
+    class ProbeScope
+    {
+      /// \brief Constructor.
+      /// \param[in] _done Function firing the probe.
+      public: explicit ProbeScope(F _done)
+        : done(std::move(_done))
+      {
+      }
+
+      /// \brief Destructor. Fires the probe.
+      public: ~ProbeScope()
+      {
+        this->done();
+      }
+
+      /// \brief No copy.
+      public: ProbeScope(const ProbeScope &) = delete;
+
+      /// \brief No assignment.
+      public: ProbeScope &operator=(const ProbeScope &) = delete;
+
+      /// \brief Function firing the probe.
+      private: F done;
+    };
+    }
+  }
+}
+#endif
@@ -15,10 +15,17 @@
  *
 */
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
 #include "gz/transport/AdvertiseOptions.hh"
 #include "gz/transport/Helpers.hh"
@@ -26,43 +33,232 @@
 #include "gz/transport/NodeShared.hh"
 #include "gz/transport/SubscriptionHandler.hh"
 
+#include "Compression.hh"
+
 using namespace gz;
 using namespace transport;
 
+namespace
+{
+  /// \brief Key of the discovery header data used by a subscriber to
+  /// advertise its maximum rate.
+  const char kSubscriberRateKey[] = "gz.transport.subscriber_rate";
+
+  /// \brief Key of the discovery header data used by a subscriber to
+  /// advertise its content filter.
+  const char kSubscriberFilterKey[] = "gz.transport.subscriber_filter";
+
+  /// \brief Key of the discovery header data used by a subscriber to
+  /// advertise its flow control credits, followed by kConflatedSuffix if
+  /// it wants the latest message skipped.
+  const char kSubscriberCreditsKey[] = "gz.transport.subscriber_credits";
+
+  /// \brief Suffix of the credits of a conflated subscriber.
+  const char kConflatedSuffix[] = ":latest";
+
+  /// \brief Key of the discovery header data present when the publisher
+  /// passes file descriptors to the subscribers of its host.
+  const char kFdPassingKey[] = "gz.transport.fd_passing";
+
+  /// \brief Key of the discovery header data present when the publisher
+  /// retransmits the lost messages. The value is the retransmit depth.
+  const char kReliableKey[] = "gz.transport.reliable";
+
+  /// \brief Key of the discovery header data present when a topic is
+  /// published through the high priority lane.
+  const char kHighPriorityKey[] = "gz.transport.high_priority";
+
+  /// \brief Key of the discovery header data present when a service is
+  /// idempotent. The value is the time to live of the cached responses (ms).
+  const char kCacheTtlKey[] = "gz.transport.cache_ttl";
+
+  /// \brief Key of the discovery header data present when a responder
+  /// accepts the service requests sent in a single frame.
+  const char kSrvEnvelopeKey[] = "gz.transport.srv_envelope";
+
+  /// \brief Key of the discovery header data present when a topic is
+  /// also sent through multicast. The value is the multicast group.
+  const char kMulticastKey[] = "gz.transport.multicast";
+
+  //////////////////////////////////////////////////
+  /// \brief Set a value of the header data of a discovery message,
+  /// replacing the previous value of the key.
+  void SetHeaderData(msgs::Discovery &_msg, const std::string &_key,
+    const std::string &_value)
+  {
+    msgs::Header *header = _msg.mutable_header();
+    for (auto &data : *header->mutable_data())
+    {
+      if (data.key() == _key)
+      {
+        data.clear_value();
+        data.add_value(_value);
+        return;
+      }
+    }
+
+    auto *data = header->add_data();
+    data->set_key(_key);
+    data->add_value(_value);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get a value of the header data of a discovery message.
+  /// \return False if the key is not present.
+  bool HeaderData(const msgs::Discovery &_msg, const std::string &_key,
+    std::string &_value)
+  {
+    if (!_msg.has_header())
+      return false;
+
+    for (const auto &data : _msg.header().data())
+    {
+      if (data.key() == _key && data.value_size() > 0)
+      {
+        _value = data.value(0);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// \brief Hash of an interned string, by value.
+  struct InternHash
+  {
+    std::size_t operator()(const std::shared_ptr<const std::string> &_s) const
+    {
+      return std::hash<std::string>()(*_s);
+    }
+  };
+
+  /// \brief Equality of interned strings, by value.
+  struct InternEqual
+  {
+    bool operator()(const std::shared_ptr<const std::string> &_a,
+                    const std::shared_ptr<const std::string> &_b) const
+    {
+      return *_a == *_b;
+    }
+  };
+
+  /// \brief The interned strings of all the publishers of the process.
+  class InternPool
+  {
+    /// \brief Get the shared copy of a string, creating it if needed.
+    /// \param[in] _str The string, not empty.
+    /// \return The shared copy.
+    public: std::shared_ptr<const std::string> Get(const std::string &_str)
+    {
+      // Look up without copying the string: the key doesn't own it.
+      const std::shared_ptr<const std::string> key(
+        std::shared_ptr<const std::string>(), &_str);
+
+      std::lock_guard<std::mutex> lock(this->mutex);
+      auto it = this->strings.find(key);
+      if (it != this->strings.end())
+        return *it;
+
+      // Forget the strings that no publisher uses anymore once the pool
+      // has doubled.
+      if (this->strings.size() >= this->sweepSize)
+      {
+        for (auto s = this->strings.begin(); s != this->strings.end();)
+        {
+          if (s->use_count() == 1)
+            s = this->strings.erase(s);
+          else
+            ++s;
+        }
+        this->sweepSize = std::max<std::size_t>(kMinSweepSize,
+          this->strings.size() * 2);
+      }
+
+      auto str = std::make_shared<const std::string>(_str);
+      this->strings.insert(str);
+      return str;
+    }
+
+    /// \brief Pool size below which the unused strings are kept.
+    private: static constexpr std::size_t kMinSweepSize = 1024;
+
+    /// \brief Protects the strings.
+    private: std::mutex mutex;
+
+    /// \brief The interned strings.
+    private: std::unordered_set<std::shared_ptr<const std::string>,
+      InternHash, InternEqual> strings;
+
+    /// \brief Pool size that triggers the next sweep.
+    private: std::size_t sweepSize = kMinSweepSize;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Check whether two interned strings have the same value.
+  /// \return True if they have the same value.
+  bool sameStr(const std::shared_ptr<const std::string> &_a,
+    const std::shared_ptr<const std::string> &_b)
+  {
+    if (_a == _b)
+      return true;
+    if (!_a || !_b)
+      return false;
+    return *_a == *_b;
+  }
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const std::string> Publisher::Intern(const std::string &_str)
+{
+  if (_str.empty())
+    return nullptr;
+
+  // Never destroyed, so that static publishers can outlive it.
+  static InternPool *pool = new InternPool();
+  return pool->Get(_str);
+}
+
+//////////////////////////////////////////////////
+const std::string &Publisher::Str(
+  const std::shared_ptr<const std::string> &_str)
+{
+  static const std::string empty;
+  return _str ? *_str : empty;
+}
+
 //////////////////////////////////////////////////
 Publisher::Publisher(const std::string &_topic, const std::string &_addr,
   const std::string &_pUuid, const std::string &_nUuid,
   const AdvertiseOptions &_opts)
-  : topic(_topic),
-    addr(_addr),
-    pUuid(_pUuid),
-    nUuid(_nUuid),
+  : topic(Intern(_topic)),
+    addr(Intern(_addr)),
+    pUuid(Intern(_pUuid)),
+    nUuid(Intern(_nUuid)),
     opts(_opts)
 {
 }
 
 //////////////////////////////////////////////////
-std::string Publisher::Topic() const
+const std::string &Publisher::Topic() const
 {
-  return this->topic;
+  return Str(this->topic);
 }
 
 //////////////////////////////////////////////////
-std::string Publisher::Addr() const
+const std::string &Publisher::Addr() const
 {
-  return this->addr;
+  return Str(this->addr);
 }
 
 //////////////////////////////////////////////////
-std::string Publisher::PUuid() const
+const std::string &Publisher::PUuid() const
 {
-  return this->pUuid;
+  return Str(this->pUuid);
 }
 
 //////////////////////////////////////////////////
-std::string Publisher::NUuid() const
+const std::string &Publisher::NUuid() const
 {
-  return this->nUuid;
+  return Str(this->nUuid);
 }
 
 //////////////////////////////////////////////////
@@ -74,25 +270,25 @@ const AdvertiseOptions& Publisher::Options() const
 //////////////////////////////////////////////////
 void Publisher::SetTopic(const std::string &_topic)
 {
-  this->topic = _topic;
+  this->topic = Intern(_topic);
 }
 
 //////////////////////////////////////////////////
 void Publisher::SetAddr(const std::string &_addr)
 {
-  this->addr = _addr;
+  this->addr = Intern(_addr);
 }
 
 //////////////////////////////////////////////////
 void Publisher::SetPUuid(const std::string &_pUuid)
 {
-  this->pUuid = _pUuid;
+  this->pUuid = Intern(_pUuid);
 }
 
 //////////////////////////////////////////////////
 void Publisher::SetNUuid(const std::string &_nUuid)
 {
-  this->nUuid = _nUuid;
+  this->nUuid = Intern(_nUuid);
 }
 
 //////////////////////////////////////////////////
@@ -129,13 +325,13 @@ void Publisher::FillDiscovery(msgs::Discovery &_msg) const
 void Publisher::SetFromDiscovery(const msgs::Discovery &_msg)
 {
   if (_msg.has_sub())
-    this->topic = _msg.sub().topic();
+    this->topic = Intern(_msg.sub().topic());
   else if (_msg.has_pub())
   {
-    this->topic = _msg.pub().topic();
-    this->addr = _msg.pub().address();
-    this->pUuid = _msg.pub().process_uuid();
-    this->nUuid = _msg.pub().node_uuid();
+    this->topic = Intern(_msg.pub().topic());
+    this->addr = Intern(_msg.pub().address());
+    this->pUuid = Intern(_msg.pub().process_uuid());
+    this->nUuid = Intern(_msg.pub().node_uuid());
 
     switch (_msg.pub().scope())
     {
@@ -156,8 +352,8 @@ void Publisher::SetFromDiscovery(const msgs::Discovery &_msg)
 //////////////////////////////////////////////////
 bool Publisher::operator==(const Publisher &_pub) const
 {
-  return this->topic == _pub.topic && this->addr == _pub.addr &&
-    this->pUuid == _pub.pUuid && this->nUuid == _pub.nUuid &&
+  return sameStr(this->topic, _pub.topic) && sameStr(this->addr, _pub.addr) &&
+    sameStr(this->pUuid, _pub.pUuid) && sameStr(this->nUuid, _pub.nUuid) &&
     this->Options() == _pub.Options();
 }
 
@@ -173,34 +369,34 @@ MessagePublisher::MessagePublisher(const std::string &_topic,
   const std::string &_nUuid, const std::string &_msgTypeName,
   const AdvertiseMessageOptions &_opts)
   : Publisher(_topic, _addr, _pUuid, _nUuid, _opts),
-    ctrl(_ctrl),
-    msgTypeName(_msgTypeName),
+    ctrl(Intern(_ctrl)),
+    msgTypeName(Intern(_msgTypeName)),
     msgOpts(_opts)
 {
 }
 
 //////////////////////////////////////////////////
-std::string MessagePublisher::Ctrl() const
+const std::string &MessagePublisher::Ctrl() const
 {
-  return this->ctrl;
+  return Str(this->ctrl);
 }
 
 //////////////////////////////////////////////////
 void MessagePublisher::SetCtrl(const std::string &_ctrl)
 {
-  this->ctrl = _ctrl;
+  this->ctrl = Intern(_ctrl);
 }
 
 //////////////////////////////////////////////////
-std::string MessagePublisher::MsgTypeName() const
+const std::string &MessagePublisher::MsgTypeName() const
 {
-  return this->msgTypeName;
+  return Str(this->msgTypeName);
 }
 
 //////////////////////////////////////////////////
 void MessagePublisher::SetMsgTypeName(const std::string &_msgTypeName)
 {
-  this->msgTypeName = _msgTypeName;
+  this->msgTypeName = Intern(_msgTypeName);
 }
 
 //////////////////////////////////////////////////
@@ -215,6 +411,62 @@ void MessagePublisher::SetOptions(const AdvertiseMessageOptions &_opts)
   this->msgOpts = _opts;
 }
 
+//////////////////////////////////////////////////
+uint64_t MessagePublisher::SubscriberMsgsPerSec() const
+{
+  return this->subscriberMsgsPerSec;
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetSubscriberMsgsPerSec(const uint64_t _msgsPerSec)
+{
+  this->subscriberMsgsPerSec = _msgsPerSec;
+}
+
+//////////////////////////////////////////////////
+const std::string &MessagePublisher::SubscriberFilter() const
+{
+  return Str(this->subscriberFilter);
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetSubscriberFilter(const std::string &_filter)
+{
+  this->subscriberFilter = Intern(_filter);
+}
+
+//////////////////////////////////////////////////
+uint64_t MessagePublisher::SubscriberCredits() const
+{
+  return this->subscriberCredits;
+}
+
+//////////////////////////////////////////////////
+bool MessagePublisher::SubscriberConflated() const
+{
+  return this->subscriberConflated;
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetSubscriberCredits(const uint64_t _credits,
+  const bool _conflated)
+{
+  this->subscriberCredits = _credits;
+  this->subscriberConflated = _credits > 0 && _conflated;
+}
+
+//////////////////////////////////////////////////
+const std::string &MessagePublisher::MulticastGroup() const
+{
+  return Str(this->multicastGroup);
+}
+
+//////////////////////////////////////////////////
+void MessagePublisher::SetMulticastGroup(const std::string &_group)
+{
+  this->multicastGroup = Intern(_group);
+}
+
 //////////////////////////////////////////////////
 void MessagePublisher::FillDiscovery(msgs::Discovery &_msg) const
 {
@@ -226,27 +478,145 @@ void MessagePublisher::FillDiscovery(msgs::Discovery &_msg) const
   pub->mutable_msg_pub()->set_msg_type(this->MsgTypeName());
   pub->mutable_msg_pub()->set_throttled(this->msgOpts.Throttled());
   pub->mutable_msg_pub()->set_msgs_per_sec(this->msgOpts.MsgsPerSec());
+
+  // The codec travels in the header data, so processes that don't know
+  // about compression simply ignore it.
+  if (this->msgOpts.Compression() != Compression_t::NONE)
+  {
+    SetHeaderData(_msg, Compression::kDiscoveryKey,
+      Compression::Name(this->msgOpts.Compression()));
+  }
+
+  // Subscribers receive high priority topics with a dedicated thread.
+  if (this->msgOpts.HighPriority())
+    SetHeaderData(_msg, kHighPriorityKey, "1");
+
+  // Subscribers of the same host connect to the descriptor channel.
+  if (this->msgOpts.FdPassing())
+    SetHeaderData(_msg, kFdPassingKey, "1");
+
+  // Subscribers request the messages they lose.
+  if (this->msgOpts.Reliable())
+  {
+    SetHeaderData(_msg, kReliableKey,
+      std::to_string(this->msgOpts.ReliableDepth()));
+  }
+
+  // Remote subscribers with PGM support join the multicast group.
+  if (this->multicastGroup)
+    SetHeaderData(_msg, kMulticastKey, *this->multicastGroup);
+
+  // Throttled subscribers tell the publisher how fast they consume.
+  if (this->subscriberMsgsPerSec != kUnthrottled)
+  {
+    SetHeaderData(_msg, kSubscriberRateKey,
+      std::to_string(this->subscriberMsgsPerSec));
+  }
+
+  // Filtered subscribers tell the publisher which messages they want.
+  if (this->subscriberFilter)
+    SetHeaderData(_msg, kSubscriberFilterKey, *this->subscriberFilter);
+
+  // Flow controlled subscribers tell the publisher their credits.
+  if (this->subscriberCredits > 0)
+  {
+    SetHeaderData(_msg, kSubscriberCreditsKey,
+      std::to_string(this->subscriberCredits) +
+      (this->subscriberConflated ? kConflatedSuffix : ""));
+  }
 }
 
 //////////////////////////////////////////////////
 void MessagePublisher::SetFromDiscovery(const msgs::Discovery &_msg)
 {
   Publisher::SetFromDiscovery(_msg);
-  this->ctrl = _msg.pub().msg_pub().ctrl();
-  this->msgTypeName = _msg.pub().msg_pub().msg_type();
+  this->ctrl = Intern(_msg.pub().msg_pub().ctrl());
+  this->msgTypeName = Intern(_msg.pub().msg_pub().msg_type());
   this->msgOpts.SetScope(Publisher::Options().Scope());
   if (!_msg.pub().msg_pub().throttled())
     this->msgOpts.SetMsgsPerSec(kUnthrottled);
   else
     this->msgOpts.SetMsgsPerSec(_msg.pub().msg_pub().msgs_per_sec());
+
+  Compression_t codec = Compression_t::NONE;
+  std::string codecName;
+  if (HeaderData(_msg, Compression::kDiscoveryKey, codecName) &&
+      !Compression::FromName(codecName, codec))
+  {
+    codec = Compression_t::NONE;
+  }
+  this->msgOpts.SetCompression(codec);
+
+  std::string priority;
+  this->msgOpts.SetHighPriority(
+    HeaderData(_msg, kHighPriorityKey, priority) && priority == "1");
+
+  std::string fdPassing;
+  this->msgOpts.SetFdPassing(
+    HeaderData(_msg, kFdPassingKey, fdPassing) && fdPassing == "1");
+
+  this->msgOpts.SetReliableDepth(0);
+  std::string reliable;
+  if (HeaderData(_msg, kReliableKey, reliable))
+  {
+    try
+    {
+      this->msgOpts.SetReliableDepth(std::stoull(reliable));
+    }
+    catch (const std::exception &)
+    {
+      // Keep unreliable, the messages are simply not recovered.
+    }
+  }
+
+  std::string group;
+  HeaderData(_msg, kMulticastKey, group);
+  this->multicastGroup = Intern(group);
+  this->msgOpts.SetMulticast(!group.empty());
+
+  this->subscriberMsgsPerSec = kUnthrottled;
+  std::string rate;
+  if (HeaderData(_msg, kSubscriberRateKey, rate))
+  {
+    try
+    {
+      this->subscriberMsgsPerSec = std::stoull(rate);
+    }
+    catch (const std::exception &)
+    {
+      // Keep unthrottled, which is always safe.
+    }
+  }
+
+  std::string filter;
+  HeaderData(_msg, kSubscriberFilterKey, filter);
+  this->subscriberFilter = Intern(filter);
+
+  this->subscriberCredits = 0;
+  this->subscriberConflated = false;
+  std::string credits;
+  if (HeaderData(_msg, kSubscriberCreditsKey, credits))
+  {
+    try
+    {
+      this->subscriberCredits = std::stoull(credits);
+      this->subscriberConflated = credits.size() > sizeof(kConflatedSuffix) &&
+        credits.compare(credits.size() - (sizeof(kConflatedSuffix) - 1),
+          std::string::npos, kConflatedSuffix) == 0;
+    }
+    catch (const std::exception &)
+    {
+      // Without flow control, which is always safe.
+    }
+  }
 }
 
 //////////////////////////////////////////////////
 bool MessagePublisher::operator==(const MessagePublisher &_pub) const
 {
   return Publisher::operator==(_pub)      &&
-    this->ctrl == _pub.ctrl               &&
-    this->msgTypeName == _pub.msgTypeName;
+    sameStr(this->ctrl, _pub.ctrl)       &&
+    sameStr(this->msgTypeName, _pub.msgTypeName);
 }
 
 //////////////////////////////////////////////////
@@ -262,48 +632,48 @@ ServicePublisher::ServicePublisher(const std::string &_topic,
   const std::string &_reqType, const std::string &_repType,
   const AdvertiseServiceOptions &_opts)
   : Publisher(_topic, _addr, _pUuid, _nUuid, _opts),
-    socketId(_socketId),
-    reqTypeName(_reqType),
-    repTypeName(_repType),
+    socketId(Intern(_socketId)),
+    reqTypeName(Intern(_reqType)),
+    repTypeName(Intern(_repType)),
     srvOpts(_opts)
 {
 }
 
 
 //////////////////////////////////////////////////
-std::string ServicePublisher::SocketId() const
+const std::string &ServicePublisher::SocketId() const
 {
-  return this->socketId;
+  return Str(this->socketId);
 }
 
 //////////////////////////////////////////////////
 void ServicePublisher::SetSocketId(const std::string &_socketId)
 {
-  this->socketId = _socketId;
+  this->socketId = Intern(_socketId);
 }
 
 //////////////////////////////////////////////////
-std::string ServicePublisher::ReqTypeName() const
+const std::string &ServicePublisher::ReqTypeName() const
 {
-  return this->reqTypeName;
+  return Str(this->reqTypeName);
 }
 
 //////////////////////////////////////////////////
-std::string ServicePublisher::RepTypeName() const
+const std::string &ServicePublisher::RepTypeName() const
 {
-  return this->repTypeName;
+  return Str(this->repTypeName);
 }
 
 //////////////////////////////////////////////////
 void ServicePublisher::SetReqTypeName(const std::string &_reqTypeName)
 {
-  this->reqTypeName = _reqTypeName;
+  this->reqTypeName = Intern(_reqTypeName);
 }
 
 //////////////////////////////////////////////////
 void ServicePublisher::SetRepTypeName(const std::string &_repTypeName)
 {
-  this->repTypeName = _repTypeName;
+  this->repTypeName = Intern(_repTypeName);
 }
 
 //////////////////////////////////////////////////
@@ -318,6 +688,18 @@ void ServicePublisher::SetOptions(const AdvertiseServiceOptions &_opts)
   this->srvOpts = _opts;
 }
 
+//////////////////////////////////////////////////
+bool ServicePublisher::Envelope() const
+{
+  return this->envelope;
+}
+
+//////////////////////////////////////////////////
+void ServicePublisher::SetEnvelope(const bool _envelope)
+{
+  this->envelope = _envelope;
+}
+
 //////////////////////////////////////////////////
 void ServicePublisher::FillDiscovery(msgs::Discovery &_msg) const
 {
@@ -328,6 +710,18 @@ void ServicePublisher::FillDiscovery(msgs::Discovery &_msg) const
   pub->mutable_srv_pub()->set_socket_id(this->SocketId());
   pub->mutable_srv_pub()->set_request_type(this->ReqTypeName());
   pub->mutable_srv_pub()->set_response_type(this->RepTypeName());
+
+  // Requesters that don't know about caching ignore it.
+  if (this->srvOpts.Idempotent())
+  {
+    SetHeaderData(_msg, kCacheTtlKey,
+      std::to_string(this->srvOpts.CacheTtl().count()));
+  }
+
+  // Requesters that don't know about the single frame requests keep using
+  // one frame per field.
+  if (this->envelope)
+    SetHeaderData(_msg, kSrvEnvelopeKey, "1");
 }
 
 //////////////////////////////////////////////////
@@ -335,18 +729,37 @@ void ServicePublisher::SetFromDiscovery(const msgs::Discovery &_msg)
 {
   Publisher::SetFromDiscovery(_msg);
   this->srvOpts.SetScope(Publisher::Options().Scope());
-  this->socketId = _msg.pub().srv_pub().socket_id();
-  this->reqTypeName = _msg.pub().srv_pub().request_type();
-  this->repTypeName = _msg.pub().srv_pub().response_type();
+  this->socketId = Intern(_msg.pub().srv_pub().socket_id());
+  this->reqTypeName = Intern(_msg.pub().srv_pub().request_type());
+  this->repTypeName = Intern(_msg.pub().srv_pub().response_type());
+
+  this->srvOpts.SetIdempotent(false);
+  std::string ttl;
+  if (HeaderData(_msg, kCacheTtlKey, ttl))
+  {
+    try
+    {
+      this->srvOpts.SetIdempotent(true,
+        std::chrono::milliseconds(std::stoll(ttl)));
+    }
+    catch (const std::exception &)
+    {
+      // Not cached, which is always safe.
+    }
+  }
+
+  std::string envelopeStr;
+  this->envelope =
+    HeaderData(_msg, kSrvEnvelopeKey, envelopeStr) && envelopeStr == "1";
 }
 
 //////////////////////////////////////////////////
 bool ServicePublisher::operator==(const ServicePublisher &_srv) const
 {
   return Publisher::operator==(_srv)      &&
-    this->socketId == _srv.socketId       &&
-    this->reqTypeName == _srv.reqTypeName &&
-    this->repTypeName == _srv.repTypeName;
+    sameStr(this->socketId, _srv.socketId)       &&
+    sameStr(this->reqTypeName, _srv.reqTypeName) &&
+    sameStr(this->repTypeName, _srv.repTypeName);
 }
 
 //////////////////////////////////////////////////
@@ -15,6 +15,7 @@
  *
 */
 
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -106,6 +107,29 @@ TEST(PublisherTest, Publisher)
   EXPECT_EQ(publisher.Options(), g_opts2);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that the publishers share their strings, and that changing
+/// one of them doesn't change the others.
+TEST(PublisherTest, PublisherSharedStrings)
+{
+  Publisher pub1(g_topic, g_addr, g_puuid, g_nuuid, g_opts1);
+  Publisher pub2(g_newTopic, std::string(g_addr), g_puuid, g_newNUuid,
+    g_opts1);
+  EXPECT_EQ(&pub1.Addr(), &pub2.Addr());
+  EXPECT_EQ(&pub1.PUuid(), &pub2.PUuid());
+  EXPECT_NE(&pub1.NUuid(), &pub2.NUuid());
+
+  pub2.SetAddr(g_newAddr);
+  EXPECT_EQ(g_addr, pub1.Addr());
+  EXPECT_EQ(g_newAddr, pub2.Addr());
+
+  // Empty strings.
+  pub2.SetPUuid("");
+  EXPECT_TRUE(pub2.PUuid().empty());
+  EXPECT_TRUE(Publisher().Topic().empty());
+  EXPECT_FALSE(pub1 == pub2);
+}
+
 //////////////////////////////////////////////////
 /// \brief Check the Publisher Pack()/Unpack().
 TEST(PublisherTest, PublisherIO)
@@ -223,6 +247,184 @@ TEST(PublisherTest, MessagePublisherIO)
   EXPECT_EQ(publisher.Options(),     otherPublisher.Options());
 }
 
+//////////////////////////////////////////////////
+/// \brief Check that the compression codec is exchanged during discovery.
+TEST(PublisherTest, MessagePublisherCompressionIO)
+{
+  AdvertiseMessageOptions opts;
+  opts.SetCompression(Compression_t::ZSTD, 3);
+  MessagePublisher publisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, opts);
+
+  // Discovery fills ADVERTISE messages twice.
+  msgs::Discovery msg;
+  publisher.FillDiscovery(msg);
+  publisher.FillDiscovery(msg);
+  EXPECT_EQ(1, msg.header().data_size());
+
+  MessagePublisher otherPublisher;
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ(Compression_t::ZSTD, otherPublisher.Options().Compression());
+
+  // Publishers without compression don't send any header data.
+  MessagePublisher plainPublisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, g_msgOpts1);
+  msgs::Discovery plainMsg;
+  plainPublisher.FillDiscovery(plainMsg);
+  EXPECT_FALSE(plainMsg.has_header());
+  otherPublisher.SetFromDiscovery(plainMsg);
+  EXPECT_EQ(Compression_t::NONE, otherPublisher.Options().Compression());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the priority is exchanged during discovery.
+TEST(PublisherTest, MessagePublisherPriorityIO)
+{
+  AdvertiseMessageOptions opts;
+  opts.SetHighPriority(true);
+  MessagePublisher publisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, opts);
+
+  msgs::Discovery msg;
+  publisher.FillDiscovery(msg);
+  publisher.FillDiscovery(msg);
+  EXPECT_EQ(1, msg.header().data_size());
+
+  MessagePublisher otherPublisher;
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_TRUE(otherPublisher.Options().HighPriority());
+
+  // Regular publishers don't send any header data.
+  MessagePublisher plainPublisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, g_msgOpts1);
+  msgs::Discovery plainMsg;
+  plainPublisher.FillDiscovery(plainMsg);
+  EXPECT_FALSE(plainMsg.has_header());
+  otherPublisher.SetFromDiscovery(plainMsg);
+  EXPECT_FALSE(otherPublisher.Options().HighPriority());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the retransmit depth is exchanged during discovery.
+TEST(PublisherTest, MessagePublisherReliableIO)
+{
+  AdvertiseMessageOptions opts;
+  opts.SetReliableDepth(32u);
+  MessagePublisher publisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, opts);
+
+  msgs::Discovery msg;
+  publisher.FillDiscovery(msg);
+  publisher.FillDiscovery(msg);
+  EXPECT_EQ(1, msg.header().data_size());
+
+  MessagePublisher otherPublisher;
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ(32u, otherPublisher.Options().ReliableDepth());
+
+  // Unreliable publishers don't send it.
+  MessagePublisher plainPublisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, g_msgOpts1);
+  msgs::Discovery plainMsg;
+  plainPublisher.FillDiscovery(plainMsg);
+  EXPECT_FALSE(plainMsg.has_header());
+  otherPublisher.SetFromDiscovery(plainMsg);
+  EXPECT_FALSE(otherPublisher.Options().Reliable());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the rate of a subscriber is exchanged during discovery.
+TEST(PublisherTest, MessagePublisherSubscriberRateIO)
+{
+  MessagePublisher publisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, g_msgOpts1);
+  EXPECT_EQ(kUnthrottled, publisher.SubscriberMsgsPerSec());
+  publisher.SetSubscriberMsgsPerSec(5u);
+  EXPECT_EQ(5u, publisher.SubscriberMsgsPerSec());
+
+  msgs::Discovery msg;
+  publisher.FillDiscovery(msg);
+  publisher.FillDiscovery(msg);
+  EXPECT_EQ(1, msg.header().data_size());
+
+  MessagePublisher otherPublisher;
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ(5u, otherPublisher.SubscriberMsgsPerSec());
+
+  // Unthrottled subscribers don't send their rate.
+  publisher.SetSubscriberMsgsPerSec(kUnthrottled);
+  msgs::Discovery unthrottledMsg;
+  publisher.FillDiscovery(unthrottledMsg);
+  EXPECT_FALSE(unthrottledMsg.has_header());
+  otherPublisher.SetFromDiscovery(unthrottledMsg);
+  EXPECT_EQ(kUnthrottled, otherPublisher.SubscriberMsgsPerSec());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the credits of a subscriber are exchanged during
+/// discovery.
+TEST(PublisherTest, MessagePublisherSubscriberCreditsIO)
+{
+  MessagePublisher publisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, g_msgOpts1);
+  EXPECT_EQ(0u, publisher.SubscriberCredits());
+  EXPECT_FALSE(publisher.SubscriberConflated());
+  publisher.SetSubscriberCredits(32u);
+
+  msgs::Discovery msg;
+  publisher.FillDiscovery(msg);
+  EXPECT_EQ(1, msg.header().data_size());
+
+  MessagePublisher otherPublisher;
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ(32u, otherPublisher.SubscriberCredits());
+  EXPECT_FALSE(otherPublisher.SubscriberConflated());
+
+  publisher.SetSubscriberCredits(16u, true);
+  msgs::Discovery conflatedMsg;
+  publisher.FillDiscovery(conflatedMsg);
+  otherPublisher.SetFromDiscovery(conflatedMsg);
+  EXPECT_EQ(16u, otherPublisher.SubscriberCredits());
+  EXPECT_TRUE(otherPublisher.SubscriberConflated());
+
+  // Subscribers without flow control don't send credits.
+  publisher.SetSubscriberCredits(0u, true);
+  EXPECT_FALSE(publisher.SubscriberConflated());
+  msgs::Discovery plainMsg;
+  publisher.FillDiscovery(plainMsg);
+  EXPECT_FALSE(plainMsg.has_header());
+  otherPublisher.SetFromDiscovery(plainMsg);
+  EXPECT_EQ(0u, otherPublisher.SubscriberCredits());
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the multicast group of a MessagePublisher in discovery.
+TEST(PublisherTest, MessagePublisherMulticastIO)
+{
+  MessagePublisher publisher(g_topic, g_addr, g_ctrl, g_puuid, g_nuuid,
+    g_msgTypeName, g_msgOpts1);
+  EXPECT_TRUE(publisher.MulticastGroup().empty());
+  publisher.SetMulticastGroup("239.255.0.8:11320");
+  EXPECT_EQ("239.255.0.8:11320", publisher.MulticastGroup());
+
+  msgs::Discovery msg;
+  publisher.FillDiscovery(msg);
+
+  MessagePublisher otherPublisher;
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_EQ("239.255.0.8:11320", otherPublisher.MulticastGroup());
+  EXPECT_TRUE(otherPublisher.Options().Multicast());
+
+  // TCP publishers don't send a group.
+  publisher.SetMulticastGroup("");
+  msgs::Discovery tcpMsg;
+  publisher.FillDiscovery(tcpMsg);
+  EXPECT_FALSE(tcpMsg.has_header());
+  otherPublisher.SetFromDiscovery(tcpMsg);
+  EXPECT_TRUE(otherPublisher.MulticastGroup().empty());
+  EXPECT_FALSE(otherPublisher.Options().Multicast());
+}
+
 //////////////////////////////////////////////////
 /// \brief Check the << operator
 TEST(PublisherTest, MessagePublisherStreamInsertion)
@@ -327,6 +529,34 @@ TEST(PublisherTest, ServicePublisherIO)
   EXPECT_EQ(publisher.ReqTypeName(), otherPublisher.ReqTypeName());
   EXPECT_EQ(publisher.RepTypeName(), otherPublisher.RepTypeName());
   EXPECT_EQ(publisher.Options(), otherPublisher.Options());
+
+  // An idempotent service advertises the time to live of its responses.
+  AdvertiseServiceOptions opts = g_srvOpts2;
+  opts.SetIdempotent(true, std::chrono::milliseconds(300));
+  publisher.SetOptions(opts);
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_TRUE(otherPublisher.Options().Idempotent());
+  EXPECT_EQ(std::chrono::milliseconds(300),
+    otherPublisher.Options().CacheTtl());
+
+  opts.SetIdempotent(false);
+  publisher.SetOptions(opts);
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_FALSE(otherPublisher.Options().Idempotent());
+
+  // Responders accept single frame requests, unless their discovery
+  // message doesn't say so (older versions).
+  EXPECT_TRUE(publisher.Envelope());
+  EXPECT_TRUE(otherPublisher.Envelope());
+  publisher.SetEnvelope(false);
+  msg.Clear();
+  publisher.FillDiscovery(msg);
+  otherPublisher.SetFromDiscovery(msg);
+  EXPECT_FALSE(otherPublisher.Envelope());
 }
 
 //////////////////////////////////////////////////
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "RealTimeSlots.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+RealTimeSlots::RealTimeSlots(const std::size_t _slots,
+  const std::size_t _slotSize)
+  : slots(std::max<std::size_t>(_slots, 1)),
+    slotSize(_slotSize),
+    storage(new char[std::max<std::size_t>(slots * _slotSize, 1)]),
+    sizes(new std::size_t[slots])
+{
+  // Touch the memory now, so the real-time thread doesn't take the page
+  // faults.
+  std::memset(this->storage.get(), 0, this->slots * this->slotSize);
+  std::fill(this->sizes.get(), this->sizes.get() + this->slots, 0);
+}
+
+//////////////////////////////////////////////////
+char *RealTimeSlots::Reserve()
+{
+  const uint64_t writePos = this->head.load(std::memory_order_relaxed);
+  if (writePos - this->tail.load(std::memory_order_acquire) >= this->slots)
+    return nullptr;
+
+  return this->storage.get() + (writePos % this->slots) * this->slotSize;
+}
+
+//////////////////////////////////////////////////
+void RealTimeSlots::Commit(const std::size_t _size)
+{
+  const uint64_t writePos = this->head.load(std::memory_order_relaxed);
+  this->sizes[writePos % this->slots] = _size;
+  this->head.store(writePos + 1, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+void RealTimeSlots::CountDrop()
+{
+  this->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+bool RealTimeSlots::Front(const char *&_data, std::size_t &_size) const
+{
+  const uint64_t readPos = this->tail.load(std::memory_order_relaxed);
+  if (readPos == this->head.load(std::memory_order_acquire))
+    return false;
+
+  const std::size_t index = readPos % this->slots;
+  _data = this->storage.get() + index * this->slotSize;
+  _size = this->sizes[index];
+  return true;
+}
+
+//////////////////////////////////////////////////
+void RealTimeSlots::Pop()
+{
+  const uint64_t readPos = this->tail.load(std::memory_order_relaxed);
+  this->tail.store(readPos + 1, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+std::size_t RealTimeSlots::SlotSize() const
+{
+  return this->slotSize;
+}
+
+//////////////////////////////////////////////////
+uint64_t RealTimeSlots::Dropped() const
+{
+  return this->dropped.load(std::memory_order_relaxed);
+}
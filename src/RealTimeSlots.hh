@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_REALTIMESLOTS_HH_
+#define GZ_TRANSPORT_REALTIMESLOTS_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Fixed ring of pre-allocated message slots, written by a
+    /// real-time thread and read by a sender thread, see
+    /// AdvertiseMessageOptions::SetRealTime().
+    ///
+    /// The writer reserves the next slot, serializes a message into it and
+    /// commits it; the reader takes the committed slots in order and
+    /// releases them. Both sides only use atomic loads and stores: they
+    /// never allocate, lock or wait for each other. There must be one
+    /// writer and one reader at a time.
+    class GZ_TRANSPORT_VISIBLE RealTimeSlots
+    {
+      /// \brief Constructor. All the memory is allocated here.
+      /// \param[in] _slots Number of slots, at least one.
+      /// \param[in] _slotSize Size of a slot (bytes).
+      public: RealTimeSlots(const std::size_t _slots,
+                            const std::size_t _slotSize);
+
+      /// \brief No copy.
+      public: RealTimeSlots(const RealTimeSlots &) = delete;
+
+      /// \brief No assignment.
+      public: RealTimeSlots &operator=(const RealTimeSlots &) = delete;
+
+      /// \brief Reserve the next slot. Writer only.
+      /// \return The slot, SlotSize() bytes long, or nullptr if all the
+      /// slots wait for the reader.
+      public: char *Reserve();
+
+      /// \brief Hand the slot returned by Reserve() over to the reader.
+      /// Writer only.
+      /// \param[in] _size Number of bytes written in the slot.
+      public: void Commit(const std::size_t _size);
+
+      /// \brief Count a message that the writer couldn't publish.
+      public: void CountDrop();
+
+      /// \brief Get the oldest committed slot. Reader only.
+      /// \param[out] _data The slot.
+      /// \param[out] _size Number of bytes written in the slot.
+      /// \return False if there is no committed slot.
+      public: bool Front(const char *&_data, std::size_t &_size) const;
+
+      /// \brief Release the slot returned by Front(), so the writer can
+      /// reuse it. Reader only.
+      public: void Pop();
+
+      /// \brief Get the size of a slot.
+      /// \return The size (bytes).
+      public: std::size_t SlotSize() const;
+
+      /// \brief Get the number of messages dropped, see CountDrop().
+      /// \return The number of messages.
+      public: uint64_t Dropped() const;
+
+      /// \brief Number of slots.
+      private: const std::size_t slots;
+
+      /// \brief Size of a slot.
+      private: const std::size_t slotSize;
+
+      /// \brief Memory of the slots.
+      private: std::unique_ptr<char[]> storage;
+
+      /// \brief Number of bytes written in each slot.
+      private: std::unique_ptr<std::size_t[]> sizes;
+
+      /// \brief Number of slots committed so far, written by the writer.
+      private: alignas(64) std::atomic<uint64_t> head{0};
+
+      /// \brief Number of slots released so far, written by the reader.
+      private: alignas(64) std::atomic<uint64_t> tail{0};
+
+      /// \brief Number of messages dropped.
+      private: alignas(64) std::atomic<uint64_t> dropped{0};
+    };
+    }
+  }
+}
+#endif
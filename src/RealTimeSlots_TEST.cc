@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "RealTimeSlots.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief Write a string in the next slot.
+/// \param[in] _slots The slots.
+/// \param[in] _text The string.
+/// \return False if there is no free slot.
+bool write(RealTimeSlots &_slots, const std::string &_text)
+{
+  char *slot = _slots.Reserve();
+  if (!slot)
+    return false;
+
+  memcpy(slot, _text.data(), _text.size());
+  _slots.Commit(_text.size());
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Read the oldest slot as a string and release it.
+/// \param[in] _slots The slots.
+/// \return The string, or "none" if there is no committed slot.
+std::string read(RealTimeSlots &_slots)
+{
+  const char *data = nullptr;
+  std::size_t size = 0;
+  if (!_slots.Front(data, size))
+    return "none";
+
+  std::string text(data, size);
+  _slots.Pop();
+  return text;
+}
+
+//////////////////////////////////////////////////
+/// \brief Fill the slots and reuse them.
+TEST(RealTimeSlotsTest, Ring)
+{
+  RealTimeSlots slots(2, 8);
+  EXPECT_EQ(8u, slots.SlotSize());
+  EXPECT_EQ("none", read(slots));
+
+  // A reserved slot isn't visible until it is committed.
+  EXPECT_NE(nullptr, slots.Reserve());
+  EXPECT_EQ("none", read(slots));
+
+  EXPECT_TRUE(write(slots, "a"));
+  EXPECT_TRUE(write(slots, "bc"));
+  EXPECT_FALSE(write(slots, "d"));
+
+  EXPECT_EQ("a", read(slots));
+  EXPECT_TRUE(write(slots, "d"));
+  EXPECT_EQ("bc", read(slots));
+  EXPECT_EQ("d", read(slots));
+  EXPECT_EQ("none", read(slots));
+
+  EXPECT_EQ(0u, slots.Dropped());
+  slots.CountDrop();
+  EXPECT_EQ(1u, slots.Dropped());
+}
+
+//////////////////////////////////////////////////
+/// \brief A writer and a reader in their own threads see every message in
+/// order.
+TEST(RealTimeSlotsTest, Threads)
+{
+  RealTimeSlots slots(4, sizeof(int));
+  const int count = 10000;
+
+  std::thread writer([&slots]
+  {
+    for (int i = 0; i < count;)
+    {
+      char *slot = slots.Reserve();
+      if (!slot)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      memcpy(slot, &i, sizeof(i));
+      slots.Commit(sizeof(i));
+      ++i;
+    }
+  });
+
+  int expected = 0;
+  while (expected < count)
+  {
+    const char *data = nullptr;
+    std::size_t size = 0;
+    if (!slots.Front(data, size))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    int value = -1;
+    EXPECT_EQ(sizeof(value), size);
+    memcpy(&value, data, sizeof(value));
+    EXPECT_EQ(expected, value);
+    slots.Pop();
+    ++expected;
+  }
+
+  writer.join();
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <algorithm>
+
+#include "ReliableReceiver.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+ReliableReceiver::ReliableReceiver(const Clock::duration &_period,
+  const std::size_t _attempts, const std::size_t _maxMissing)
+  : period(_period),
+    attempts(std::max<std::size_t>(_attempts, 1u)),
+    maxMissing(_maxMissing)
+{
+}
+
+//////////////////////////////////////////////////
+ReliableReceiver::Delivery ReliableReceiver::Receive(const uint64_t _seq,
+  const Clock::time_point &_now)
+{
+  if (!this->started)
+  {
+    this->started = true;
+    this->next = _seq + 1;
+    return Delivery::NEW;
+  }
+
+  if (_seq >= this->next)
+  {
+    // Track the end of the gap, give up on what doesn't fit.
+    const uint64_t gap = _seq - this->next;
+    const uint64_t tracked = std::min<uint64_t>(gap,
+      this->maxMissing > this->missing.size() ?
+        this->maxMissing - this->missing.size() : 0u);
+    this->lost += gap - tracked;
+    for (uint64_t seq = _seq - tracked; seq < _seq; ++seq)
+      this->missing[seq].deadline = _now;
+    this->next = _seq + 1;
+    return Delivery::NEW;
+  }
+
+  auto it = this->missing.find(_seq);
+  if (it == this->missing.end())
+    return Delivery::DUPLICATE;
+
+  this->missing.erase(it);
+  return Delivery::RECOVERED;
+}
+
+//////////////////////////////////////////////////
+std::optional<ReliableReceiver::Clock::time_point> ReliableReceiver::Due(
+  const Clock::time_point &_now, std::vector<uint64_t> &_seqs)
+{
+  std::optional<Clock::time_point> nextDeadline;
+  for (auto it = this->missing.begin(); it != this->missing.end();)
+  {
+    Gap &gap = it->second;
+    if (gap.deadline <= _now)
+    {
+      if (gap.attempts >= this->attempts)
+      {
+        ++this->lost;
+        it = this->missing.erase(it);
+        continue;
+      }
+      ++gap.attempts;
+      gap.deadline = _now + this->period;
+      _seqs.push_back(it->first);
+    }
+
+    if (!nextDeadline || gap.deadline < *nextDeadline)
+      nextDeadline = gap.deadline;
+    ++it;
+  }
+  return nextDeadline;
+}
+
+//////////////////////////////////////////////////
+std::size_t ReliableReceiver::Missing() const
+{
+  return this->missing.size();
+}
+
+//////////////////////////////////////////////////
+uint64_t ReliableReceiver::TakeLost()
+{
+  const uint64_t value = this->lost;
+  this->lost = 0;
+  return value;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_RELIABLERECEIVER_HH_
+#define GZ_TRANSPORT_RELIABLERECEIVER_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Sequence numbers received from the publisher of a reliable
+    /// topic, see AdvertiseMessageOptions::SetReliableDepth.
+    ///
+    /// The receiver finds the gaps in the numbers, tells which missing
+    /// messages have to be requested and when, and discards the duplicates.
+    /// It isn't thread safe.
+    class GZ_TRANSPORT_VISIBLE ReliableReceiver
+    {
+      /// \brief Clock of the requests.
+      public: using Clock = std::chrono::steady_clock;
+
+      /// \brief Outcome of a message received.
+      public: enum class Delivery
+      {
+        /// \brief A new message, newer than all the previous ones.
+        NEW,
+
+        /// \brief A missing message, received again.
+        RECOVERED,
+
+        /// \brief A message already delivered, or given up on.
+        DUPLICATE
+      };
+
+      /// \brief Constructor.
+      /// \param[in] _period Time between two requests of a missing message.
+      /// \param[in] _attempts Number of requests of a missing message
+      /// before giving up on it.
+      /// \param[in] _maxMissing Maximum number of missing messages tracked.
+      /// The oldest ones of a larger gap are given up on at once.
+      public: ReliableReceiver(
+        const Clock::duration &_period = std::chrono::milliseconds(100),
+        const std::size_t _attempts = 5,
+        const std::size_t _maxMissing = 1024);
+
+      /// \brief Register a message received. The first message sets the
+      /// start of the sequence: the older ones are never requested.
+      /// \param[in] _seq Sequence number of the message.
+      /// \param[in] _now Current time. The missing messages found are due
+      /// for a request at this time.
+      /// \return Whether the message has to be delivered.
+      public: Delivery Receive(const uint64_t _seq,
+                               const Clock::time_point &_now);
+
+      /// \brief Get the missing messages whose request is due, and give up
+      /// on those requested too many times.
+      /// \param[in] _now Current time.
+      /// \param[out] _seqs Sequence numbers to request.
+      /// \return The next time a request will be due, if any message is
+      /// still missing.
+      public: std::optional<Clock::time_point> Due(
+        const Clock::time_point &_now, std::vector<uint64_t> &_seqs);
+
+      /// \brief Get the number of messages missing.
+      /// \return The number of messages.
+      public: std::size_t Missing() const;
+
+      /// \brief Get the number of messages given up on since the last call,
+      /// and reset it.
+      /// \return The number of messages lost.
+      public: uint64_t TakeLost();
+
+      /// \brief State of a missing message.
+      private: struct Gap
+      {
+        /// \brief Number of requests sent.
+        std::size_t attempts = 0;
+
+        /// \brief Time of the next request.
+        Clock::time_point deadline;
+      };
+
+      /// \brief Time between two requests.
+      private: Clock::duration period;
+
+      /// \brief Number of requests before giving up.
+      private: std::size_t attempts;
+
+      /// \brief Maximum number of missing messages tracked.
+      private: std::size_t maxMissing;
+
+      /// \brief Whether a message was received.
+      private: bool started = false;
+
+      /// \brief Sequence number expected next.
+      private: uint64_t next = 0;
+
+      /// \brief Missing messages, by sequence number.
+      private: std::map<uint64_t, Gap> missing;
+
+      /// \brief Number of messages given up on, not taken yet.
+      private: uint64_t lost = 0;
+    };
+    }
+  }
+}
+#endif
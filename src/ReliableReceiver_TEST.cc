@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "ReliableReceiver.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+using Delivery = ReliableReceiver::Delivery;
+
+//////////////////////////////////////////////////
+/// \brief The gaps are requested, recovered once and the duplicates are
+/// discarded.
+TEST(ReliableReceiverTest, Gaps)
+{
+  ReliableReceiver receiver(std::chrono::milliseconds(10), 2);
+  const auto now = ReliableReceiver::Clock::now();
+  std::vector<uint64_t> seqs;
+
+  // The sequence starts with the first message received.
+  EXPECT_EQ(Delivery::NEW, receiver.Receive(10, now));
+  EXPECT_EQ(Delivery::DUPLICATE, receiver.Receive(9, now));
+  EXPECT_EQ(Delivery::NEW, receiver.Receive(11, now));
+  EXPECT_EQ(Delivery::DUPLICATE, receiver.Receive(11, now));
+  EXPECT_FALSE(receiver.Due(now, seqs));
+  EXPECT_TRUE(seqs.empty());
+
+  // 12 and 13 are missing.
+  EXPECT_EQ(Delivery::NEW, receiver.Receive(14, now));
+  EXPECT_EQ(2u, receiver.Missing());
+  auto next = receiver.Due(now, seqs);
+  ASSERT_TRUE(next);
+  EXPECT_EQ(now + std::chrono::milliseconds(10), *next);
+  EXPECT_EQ((std::vector<uint64_t>{12, 13}), seqs);
+
+  // Nothing is due before the period elapses.
+  seqs.clear();
+  receiver.Due(now + std::chrono::milliseconds(5), seqs);
+  EXPECT_TRUE(seqs.empty());
+
+  EXPECT_EQ(Delivery::RECOVERED, receiver.Receive(13, now));
+  EXPECT_EQ(Delivery::DUPLICATE, receiver.Receive(13, now));
+  EXPECT_EQ(1u, receiver.Missing());
+
+  // 12 is requested again, then given up on.
+  receiver.Due(now + std::chrono::milliseconds(10), seqs);
+  EXPECT_EQ(std::vector<uint64_t>{12}, seqs);
+  seqs.clear();
+  EXPECT_FALSE(receiver.Due(now + std::chrono::milliseconds(20), seqs));
+  EXPECT_TRUE(seqs.empty());
+  EXPECT_EQ(0u, receiver.Missing());
+  EXPECT_EQ(1u, receiver.TakeLost());
+  EXPECT_EQ(0u, receiver.TakeLost());
+  EXPECT_EQ(Delivery::DUPLICATE, receiver.Receive(12, now));
+}
+
+//////////////////////////////////////////////////
+/// \brief Only the end of a large gap is tracked.
+TEST(ReliableReceiverTest, MaxMissing)
+{
+  ReliableReceiver receiver(std::chrono::milliseconds(10), 5, 3);
+  const auto now = ReliableReceiver::Clock::now();
+
+  EXPECT_EQ(Delivery::NEW, receiver.Receive(0, now));
+  EXPECT_EQ(Delivery::NEW, receiver.Receive(11, now));
+  EXPECT_EQ(3u, receiver.Missing());
+  EXPECT_EQ(7u, receiver.TakeLost());
+
+  std::vector<uint64_t> seqs;
+  receiver.Due(now, seqs);
+  EXPECT_EQ((std::vector<uint64_t>{8, 9, 10}), seqs);
+
+  // No room left for a new gap.
+  EXPECT_EQ(Delivery::NEW, receiver.Receive(13, now));
+  EXPECT_EQ(3u, receiver.Missing());
+  EXPECT_EQ(1u, receiver.TakeLost());
+  EXPECT_EQ(Delivery::DUPLICATE, receiver.Receive(1, now));
+  EXPECT_EQ(Delivery::RECOVERED, receiver.Receive(9, now));
+}
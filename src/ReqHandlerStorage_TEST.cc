@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/vector3d.pb.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gz/transport/ReqHandler.hh"
+#include "gz/transport/ReqHandlerStorage.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  std::string topic = "foo"; // NOLINT(*)
+  std::string nUuid = "node-UUID"; // NOLINT(*)
+  std::string int32Type = msgs::Int32().GetTypeName(); // NOLINT(*)
+
+  using Int32ReqHandler = ReqHandler<msgs::Int32, msgs::Int32>;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the identifiers of the request handlers.
+TEST(ReqHandlerStorageTest, Ids)
+{
+  Int32ReqHandler req1(nUuid);
+  Int32ReqHandler req2(nUuid);
+  EXPECT_NE(req1.Id(), req2.Id());
+  EXPECT_EQ(std::to_string(req1.Id()), req1.HandlerUuid());
+
+  uint64_t id = 0;
+  EXPECT_TRUE(ReqHandlerStorage::ParseId(req2.HandlerUuid(), id));
+  EXPECT_EQ(req2.Id(), id);
+  EXPECT_FALSE(ReqHandlerStorage::ParseId("", id));
+  EXPECT_FALSE(ReqHandlerStorage::ParseId("12a", id));
+  EXPECT_FALSE(ReqHandlerStorage::ParseId(
+    "4f8a1e6c-9d2b-4c3e-8f7a-123456789abc", id));
+}
+
+//////////////////////////////////////////////////
+/// \brief Add, find and remove request handlers.
+TEST(ReqHandlerStorageTest, AddFindRemove)
+{
+  ReqHandlerStorage reqs;
+  auto req1 = std::make_shared<Int32ReqHandler>(nUuid);
+  auto req2 = std::make_shared<Int32ReqHandler>(nUuid);
+
+  IReqHandlerPtr handler;
+  EXPECT_FALSE(reqs.Handler(topic, nUuid, req1->HandlerUuid(), handler));
+  EXPECT_FALSE(reqs.HasHandlersForTopic(topic));
+
+  reqs.AddHandler(topic, nUuid, req1);
+  reqs.AddHandler(topic, nUuid, req2);
+  EXPECT_EQ(2u, reqs.Size());
+  EXPECT_TRUE(reqs.HasHandlersForTopic(topic));
+
+  ASSERT_TRUE(reqs.Handler(topic, nUuid, req2->HandlerUuid(), handler));
+  EXPECT_EQ(req2, handler);
+
+  // The topic and the node have to match.
+  EXPECT_FALSE(reqs.Handler("bar", nUuid, req2->HandlerUuid(), handler));
+  EXPECT_FALSE(reqs.Handler(topic, "other", req2->HandlerUuid(), handler));
+  EXPECT_FALSE(reqs.RemoveHandler("bar", nUuid, req2->HandlerUuid()));
+
+  // Find a handler from its identifier only.
+  std::string foundTopic;
+  std::string foundNUuid;
+  ASSERT_TRUE(reqs.Handler(req2->Id(), foundTopic, foundNUuid, handler));
+  EXPECT_EQ(req2, handler);
+  EXPECT_EQ(topic, foundTopic);
+  EXPECT_EQ(nUuid, foundNUuid);
+  EXPECT_FALSE(reqs.Handler(req2->Id() + 100, foundTopic, foundNUuid,
+    handler));
+
+  EXPECT_TRUE(reqs.RemoveHandler(topic, nUuid, req1->HandlerUuid()));
+  EXPECT_FALSE(reqs.RemoveHandler(topic, nUuid, req1->HandlerUuid()));
+  EXPECT_EQ(1u, reqs.Size());
+
+  // The removed handler is not pending anymore.
+  std::vector<IReqHandlerPtr> unsent;
+  ASSERT_TRUE(reqs.TakeUnsent(topic, int32Type, int32Type, unsent));
+  ASSERT_EQ(1u, unsent.size());
+  EXPECT_EQ(req2, unsent[0]);
+}
+
+//////////////////////////////////////////////////
+/// \brief Take the requests that weren't sent yet.
+TEST(ReqHandlerStorageTest, TakeUnsent)
+{
+  ReqHandlerStorage reqs;
+  auto req1 = std::make_shared<Int32ReqHandler>(nUuid);
+  auto req2 =
+    std::make_shared<ReqHandler<msgs::Vector3d, msgs::Int32>>(nUuid);
+  auto req3 = std::make_shared<Int32ReqHandler>(nUuid);
+  reqs.AddHandler(topic, nUuid, req1);
+  reqs.AddHandler(topic, nUuid, req2);
+  reqs.AddHandler(topic, nUuid, req3);
+
+  IReqHandlerPtr handler;
+  ASSERT_TRUE(reqs.FirstHandler(topic, int32Type, int32Type, handler));
+  EXPECT_EQ(req1, handler);
+
+  std::vector<IReqHandlerPtr> unsent;
+  ASSERT_TRUE(reqs.TakeUnsent(topic, int32Type, int32Type, unsent));
+  ASSERT_EQ(2u, unsent.size());
+  EXPECT_EQ(req1, unsent[0]);
+  EXPECT_EQ(req3, unsent[1]);
+
+  // Taken only once, but still stored for the response.
+  EXPECT_FALSE(reqs.TakeUnsent(topic, int32Type, int32Type, unsent));
+  EXPECT_FALSE(reqs.FirstHandler(topic, int32Type, int32Type, handler));
+  EXPECT_TRUE(reqs.Handler(topic, nUuid, req1->HandlerUuid(), handler));
+  EXPECT_EQ(3u, reqs.Size());
+
+  // The request with other types is still pending.
+  const std::string vectorType = msgs::Vector3d().GetTypeName();
+  EXPECT_TRUE(reqs.FirstHandler(topic, vectorType, int32Type, handler));
+  EXPECT_EQ(req2, handler);
+}
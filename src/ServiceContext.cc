@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <chrono>
+
+#include "gz/transport/ServiceContext.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Deadline of the current thread.
+  thread_local std::chrono::steady_clock::time_point tDeadline =
+    std::chrono::steady_clock::time_point::max();
+}
+
+//////////////////////////////////////////////////
+ServiceContext::ServiceContext(
+  const std::chrono::steady_clock::time_point &_deadline)
+  : previous(tDeadline)
+{
+  tDeadline = std::min(tDeadline, _deadline);
+}
+
+//////////////////////////////////////////////////
+ServiceContext::~ServiceContext()
+{
+  tDeadline = this->previous;
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::time_point ServiceContext::Deadline()
+{
+  return tDeadline;
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::time_point ServiceContext::Deadline(
+  const unsigned int _timeout)
+{
+  return std::min(tDeadline,
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(_timeout));
+}
+
+//////////////////////////////////////////////////
+bool ServiceContext::Expired()
+{
+  return tDeadline != std::chrono::steady_clock::time_point::max() &&
+    tDeadline <= std::chrono::steady_clock::now();
+}
+
+//////////////////////////////////////////////////
+std::chrono::milliseconds ServiceContext::Remaining()
+{
+  if (tDeadline == std::chrono::steady_clock::time_point::max())
+    return std::chrono::milliseconds::max();
+
+  const auto now = std::chrono::steady_clock::now();
+  if (tDeadline <= now)
+    return std::chrono::milliseconds(0);
+
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+    tDeadline - now);
+}
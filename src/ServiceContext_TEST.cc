@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <thread>
+
+#include "gz/transport/ServiceContext.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using Clock = std::chrono::steady_clock;
+
+//////////////////////////////////////////////////
+TEST(ServiceContextTest, NoDeadline)
+{
+  EXPECT_EQ(Clock::time_point::max(), transport::ServiceContext::Deadline());
+  EXPECT_FALSE(transport::ServiceContext::Expired());
+  EXPECT_EQ(std::chrono::milliseconds::max(),
+    transport::ServiceContext::Remaining());
+
+  // The timeout of a request is kept.
+  const auto before = Clock::now();
+  const auto deadline = transport::ServiceContext::Deadline(100u);
+  EXPECT_GE(deadline, before + std::chrono::milliseconds(100));
+  EXPECT_LE(deadline, Clock::now() + std::chrono::milliseconds(100));
+}
+
+//////////////////////////////////////////////////
+TEST(ServiceContextTest, Scopes)
+{
+  const auto deadline = Clock::now() + std::chrono::seconds(10);
+  {
+    transport::ServiceContext context(deadline);
+    EXPECT_EQ(deadline, transport::ServiceContext::Deadline());
+    EXPECT_FALSE(transport::ServiceContext::Expired());
+    EXPECT_GT(transport::ServiceContext::Remaining(),
+      std::chrono::seconds(9));
+
+    // Requests are bounded by the deadline.
+    EXPECT_EQ(deadline, transport::ServiceContext::Deadline(60000u));
+    EXPECT_LT(transport::ServiceContext::Deadline(10u), deadline);
+
+    // A nested scope can't extend the deadline.
+    {
+      transport::ServiceContext later(deadline + std::chrono::seconds(1));
+      EXPECT_EQ(deadline, transport::ServiceContext::Deadline());
+    }
+
+    {
+      transport::ServiceContext earlier(Clock::now());
+      EXPECT_TRUE(transport::ServiceContext::Expired());
+      EXPECT_EQ(std::chrono::milliseconds(0),
+        transport::ServiceContext::Remaining());
+    }
+    EXPECT_EQ(deadline, transport::ServiceContext::Deadline());
+
+    // Other threads have their own deadline.
+    std::thread other([]
+    {
+      EXPECT_EQ(Clock::time_point::max(),
+        transport::ServiceContext::Deadline());
+    });
+    other.join();
+  }
+  EXPECT_EQ(Clock::time_point::max(), transport::ServiceContext::Deadline());
+}
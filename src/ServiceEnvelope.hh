@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_SERVICEENVELOPE_HH_
+#define GZ_TRANSPORT_SERVICEENVELOPE_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Little-endian encoding of the integers of the envelopes.
+    class EnvelopeCodec
+    {
+      /// \brief Write an unsigned integer.
+      /// \param[in] _value The value.
+      /// \param[in] _bytes Number of bytes to write.
+      /// \param[out] _buffer Destination.
+      public: static void Put(uint64_t _value, std::size_t _bytes,
+                              char *_buffer)
+      {
+        for (std::size_t i = 0; i < _bytes; ++i)
+          _buffer[i] = static_cast<char>((_value >> (8 * i)) & 0xFF);
+      }
+
+      /// \brief Read an unsigned integer.
+      /// \param[in] _buffer Source.
+      /// \param[in] _bytes Number of bytes to read.
+      /// \return The value.
+      public: static uint64_t Get(const char *_buffer, std::size_t _bytes)
+      {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(_buffer);
+        uint64_t value = 0;
+        for (std::size_t i = 0; i < _bytes; ++i)
+          value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        return value;
+      }
+    };
+
+    /// \brief Service request sent in a single frame, instead of one frame
+    /// per field. The service is identified by a numeric ID that the
+    /// responder computes from the services that it advertises.
+    ///
+    /// Layout: version (1 byte), flags (1 byte), sizes of the requester
+    /// address, requester socket identity and node UUID (2 bytes each),
+    /// service ID (8 bytes) and request ID (8 bytes), followed by the
+    /// timeout (8 bytes, only with kTimeoutFlag), the three strings and the
+    /// serialized request. The serialized request is passed separately, so
+    /// it is only copied into the frame.
+    ///
+    /// The timeout is the time left before the deadline of the request when
+    /// it was sent. A relative time doesn't depend on the clocks of the two
+    /// hosts being synchronized.
+    class ServiceRequestEnvelope
+    {
+      /// \brief Version of the layout.
+      public: static constexpr uint8_t kVersion = 1;
+
+      /// \brief Size of the fixed header.
+      public: static constexpr std::size_t kHeaderSize = 24;
+
+      /// \brief Flag set when the request carries a timeout.
+      public: static constexpr uint8_t kTimeoutFlag = 0x01;
+
+      /// \brief Size of an encoded request.
+      /// \param[in] _dataSize Size of the serialized request.
+      /// \return The size, or 0 if a string is too long for the envelope.
+      public: std::size_t Size(std::size_t _dataSize) const
+      {
+        if (this->sender.size() > 0xFFFF || this->dstId.size() > 0xFFFF ||
+            this->nodeUuid.size() > 0xFFFF)
+        {
+          return 0;
+        }
+        return kHeaderSize + this->TimeoutSize() + this->sender.size() +
+          this->dstId.size() + this->nodeUuid.size() + _dataSize;
+      }
+
+      /// \brief Encode the request.
+      /// \param[in] _data Serialized request.
+      /// \param[out] _buffer Destination, of at least Size() bytes.
+      public: void Encode(const std::string &_data, char *_buffer) const
+      {
+        EnvelopeCodec::Put(kVersion, 1, _buffer);
+        EnvelopeCodec::Put(this->timeout ? kTimeoutFlag : 0, 1, _buffer + 1);
+        EnvelopeCodec::Put(this->sender.size(), 2, _buffer + 2);
+        EnvelopeCodec::Put(this->dstId.size(), 2, _buffer + 4);
+        EnvelopeCodec::Put(this->nodeUuid.size(), 2, _buffer + 6);
+        EnvelopeCodec::Put(this->serviceId, 8, _buffer + 8);
+        EnvelopeCodec::Put(this->requestId, 8, _buffer + 16);
+
+        char *p = _buffer + kHeaderSize;
+        if (this->timeout)
+        {
+          EnvelopeCodec::Put(static_cast<uint64_t>(this->timeout->count()), 8,
+            p);
+          p += 8;
+        }
+        for (const std::string *str :
+          {&this->sender, &this->dstId, &this->nodeUuid, &_data})
+        {
+          if (!str->empty())
+            memcpy(p, str->data(), str->size());
+          p += str->size();
+        }
+      }
+
+      /// \brief Decode a request.
+      /// \param[in] _buffer Encoded request.
+      /// \param[in] _size Size of the encoded request.
+      /// \param[out] _data Serialized request.
+      /// \return False if the request is malformed or uses another version.
+      public: bool Decode(const char *_buffer, std::size_t _size,
+                          std::string &_data)
+      {
+        if (_size < kHeaderSize ||
+            EnvelopeCodec::Get(_buffer, 1) != kVersion)
+        {
+          return false;
+        }
+
+        const uint64_t flags = EnvelopeCodec::Get(_buffer + 1, 1);
+        const std::size_t timeoutSize = (flags & kTimeoutFlag) ? 8 : 0;
+        const std::size_t senderSize = EnvelopeCodec::Get(_buffer + 2, 2);
+        const std::size_t dstIdSize = EnvelopeCodec::Get(_buffer + 4, 2);
+        const std::size_t nodeUuidSize = EnvelopeCodec::Get(_buffer + 6, 2);
+        if (kHeaderSize + timeoutSize + senderSize + dstIdSize +
+            nodeUuidSize > _size)
+        {
+          return false;
+        }
+
+        this->serviceId = EnvelopeCodec::Get(_buffer + 8, 8);
+        this->requestId = EnvelopeCodec::Get(_buffer + 16, 8);
+
+        const char *p = _buffer + kHeaderSize;
+        this->timeout.reset();
+        if (timeoutSize > 0)
+        {
+          this->timeout = std::chrono::milliseconds(
+            static_cast<int64_t>(EnvelopeCodec::Get(p, 8)));
+          p += timeoutSize;
+        }
+        this->sender.assign(p, senderSize);
+        p += senderSize;
+        this->dstId.assign(p, dstIdSize);
+        p += dstIdSize;
+        this->nodeUuid.assign(p, nodeUuidSize);
+        p += nodeUuidSize;
+        _data.assign(p, _size - (p - _buffer));
+        return true;
+      }
+
+      /// \brief ID of the service.
+      public: uint64_t serviceId = 0;
+
+      /// \brief ID of the request (IReqHandler::Id()).
+      public: uint64_t requestId = 0;
+
+      /// \brief Address of the requester.
+      public: std::string sender;
+
+      /// \brief Socket identity of the requester.
+      public: std::string dstId;
+
+      /// \brief UUID of the requester node.
+      public: std::string nodeUuid;
+
+      /// \brief Time left before the deadline of the request, if it has
+      /// one.
+      public: std::optional<std::chrono::milliseconds> timeout;
+
+      /// \brief Size of the encoded timeout.
+      /// \return The size, or 0 without timeout.
+      private: std::size_t TimeoutSize() const
+      {
+        return this->timeout ? 8 : 0;
+      }
+    };
+
+    /// \brief Service response sent in a single frame. Responders only use
+    /// it to answer requests received in a ServiceRequestEnvelope.
+    ///
+    /// Layout: version (1 byte), status (1 byte: 0 failure, 1 success, 2
+    /// chunk of a streamed response) and request ID (8 bytes), followed by
+    /// the serialized response.
+    class ServiceResponseEnvelope
+    {
+      /// \brief Version of the layout.
+      public: static constexpr uint8_t kVersion = 1;
+
+      /// \brief Size of the fixed header.
+      public: static constexpr std::size_t kHeaderSize = 10;
+
+      /// \brief Size of an encoded response.
+      /// \param[in] _repSize Size of the serialized response.
+      /// \return The size.
+      public: static std::size_t Size(std::size_t _repSize)
+      {
+        return kHeaderSize + _repSize;
+      }
+
+      /// \brief Encode the response.
+      /// \param[in] _rep Serialized response.
+      /// \param[out] _buffer Destination, of at least Size() bytes.
+      public: void Encode(const std::string &_rep, char *_buffer) const
+      {
+        EnvelopeCodec::Put(kVersion, 1, _buffer);
+        EnvelopeCodec::Put(this->more ? 2 : (this->result ? 1 : 0), 1,
+          _buffer + 1);
+        EnvelopeCodec::Put(this->requestId, 8, _buffer + 2);
+        if (!_rep.empty())
+          memcpy(_buffer + kHeaderSize, _rep.data(), _rep.size());
+      }
+
+      /// \brief Decode a response.
+      /// \param[in] _buffer Encoded response.
+      /// \param[in] _size Size of the encoded response.
+      /// \param[out] _rep Serialized response.
+      /// \return False if the response is malformed or uses another version.
+      public: bool Decode(const char *_buffer, std::size_t _size,
+                          std::string &_rep)
+      {
+        if (_size < kHeaderSize ||
+            EnvelopeCodec::Get(_buffer, 1) != kVersion)
+        {
+          return false;
+        }
+
+        const uint64_t status = EnvelopeCodec::Get(_buffer + 1, 1);
+        if (status > 2)
+          return false;
+
+        this->result = status == 1;
+        this->more = status == 2;
+        this->requestId = EnvelopeCodec::Get(_buffer + 2, 8);
+        _rep.assign(_buffer + kHeaderSize, _size - kHeaderSize);
+        return true;
+      }
+
+      /// \brief ID of the request.
+      public: uint64_t requestId = 0;
+
+      /// \brief Result of the service call.
+      public: bool result = false;
+
+      /// \brief Whether this is a chunk of a streamed response.
+      public: bool more = false;
+    };
+    }
+  }
+}
+#endif
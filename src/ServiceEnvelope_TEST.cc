@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <string>
+#include <utility>
+
+#include "ServiceEnvelope.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+TEST(ServiceEnvelopeTest, Request)
+{
+  transport::ServiceRequestEnvelope env;
+  env.serviceId = 0x0123456789ABCDEFull;
+  env.requestId = 42;
+  env.sender = "tcp://127.0.0.1:12345";
+  env.dstId = "socket";
+  env.nodeUuid = "node";
+  const std::string data("\0data", 5);
+
+  const std::size_t size = env.Size(data.size());
+  EXPECT_EQ(transport::ServiceRequestEnvelope::kHeaderSize +
+    env.sender.size() + env.dstId.size() + env.nodeUuid.size() + data.size(),
+    size);
+  std::string buffer(size, '\0');
+  env.Encode(data, &buffer[0]);
+
+  transport::ServiceRequestEnvelope decoded;
+  std::string decodedData;
+  ASSERT_TRUE(decoded.Decode(buffer.data(), buffer.size(), decodedData));
+  EXPECT_EQ(env.serviceId, decoded.serviceId);
+  EXPECT_EQ(env.requestId, decoded.requestId);
+  EXPECT_EQ(env.sender, decoded.sender);
+  EXPECT_EQ(env.dstId, decoded.dstId);
+  EXPECT_EQ(env.nodeUuid, decoded.nodeUuid);
+  EXPECT_EQ(data, decodedData);
+  EXPECT_FALSE(decoded.timeout);
+
+  // A request with a deadline carries the time left.
+  env.timeout = std::chrono::milliseconds(250);
+  buffer.assign(env.Size(data.size()), '\0');
+  EXPECT_EQ(size + 8, buffer.size());
+  env.Encode(data, &buffer[0]);
+  ASSERT_TRUE(decoded.Decode(buffer.data(), buffer.size(), decodedData));
+  ASSERT_TRUE(decoded.timeout);
+  EXPECT_EQ(std::chrono::milliseconds(250), *decoded.timeout);
+  EXPECT_EQ(env.sender, decoded.sender);
+  EXPECT_EQ(env.nodeUuid, decoded.nodeUuid);
+  EXPECT_EQ(data, decodedData);
+
+  // Truncated.
+  EXPECT_FALSE(decoded.Decode(buffer.data(), 10, decodedData));
+  EXPECT_FALSE(decoded.Decode(buffer.data(),
+    transport::ServiceRequestEnvelope::kHeaderSize + 3, decodedData));
+
+  // Unknown version.
+  buffer[0] = 2;
+  EXPECT_FALSE(decoded.Decode(buffer.data(), buffer.size(), decodedData));
+
+  // The strings must fit in the header.
+  env.sender = std::string(0x10000, 'a');
+  EXPECT_EQ(0u, env.Size(data.size()));
+}
+
+//////////////////////////////////////////////////
+TEST(ServiceEnvelopeTest, Response)
+{
+  transport::ServiceResponseEnvelope env;
+  env.requestId = 7;
+  const std::string rep = "response";
+
+  for (auto [result, more] : {std::make_pair(false, false),
+    std::make_pair(true, false), std::make_pair(false, true)})
+  {
+    env.result = result;
+    env.more = more;
+    std::string buffer(
+      transport::ServiceResponseEnvelope::Size(rep.size()), '\0');
+    env.Encode(rep, &buffer[0]);
+
+    transport::ServiceResponseEnvelope decoded;
+    std::string decodedRep;
+    ASSERT_TRUE(decoded.Decode(buffer.data(), buffer.size(), decodedRep));
+    EXPECT_EQ(7u, decoded.requestId);
+    EXPECT_EQ(result, decoded.result);
+    EXPECT_EQ(more, decoded.more);
+    EXPECT_EQ(rep, decodedRep);
+
+    // Unknown status.
+    buffer[1] = 3;
+    EXPECT_FALSE(decoded.Decode(buffer.data(), buffer.size(), decodedRep));
+  }
+
+  std::string rep2;
+  transport::ServiceResponseEnvelope decoded;
+  EXPECT_FALSE(decoded.Decode("x", 1, rep2));
+}
@@ -0,0 +1,713 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Helpers.hh"
+
+#include "ShmSegment.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Identifies an initialized segment.
+  const uint32_t kShmMagic = 0x475a5348;
+
+  /// \brief Version of the segment layout.
+  const uint32_t kShmVersion = 1;
+
+  /// \brief Size of the string fields of the header.
+  const std::size_t kShmNameSize = 256;
+
+  /// \brief Size of the huge pages of the segments that use them.
+  const std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+  /// \brief Number of times that ReadLatest() tries again when the writer
+  /// overwrites the message being copied.
+  const int kReadLatestAttempts = 8;
+
+  /// \brief Reader entry states.
+  const uint32_t kReaderFree = 0;
+  const uint32_t kReaderClaimed = 1;
+  const uint32_t kReaderReady = 2;
+
+  /// \brief Header of a slot, followed by the message data.
+  struct SlotHeader
+  {
+    /// \brief 2 * message sequence number once the message is written, odd
+    /// while it is being written.
+    std::atomic<uint64_t> seq;
+
+    /// \brief Size of the message.
+    std::atomic<uint64_t> size;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "Shared memory segments require lock-free 64 bit atomics");
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+    std::atomic<uint32_t>::is_always_lock_free,
+    "Shared memory doorbells require lock-free 32 bit atomics");
+
+  /// \brief Time between two checks of a doorbell where futexes aren't
+  /// available.
+  const std::chrono::milliseconds kDoorbellPollPeriod{1};
+
+  //////////////////////////////////////////////////
+  void CopyName(char *_dst, const std::string &_src)
+  {
+    const std::size_t n = std::min(_src.size(), kShmNameSize - 1);
+    memcpy(_dst, _src.data(), n);
+    _dst[n] = '\0';
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Hexadecimal shared memory object name.
+  /// \param[in] _prefix Prefix of the name.
+  /// \param[in] _key Hashed into the name.
+  /// \return The name.
+  std::string HashName(const std::string &_prefix, const std::string &_key)
+  {
+    // Keep the name short, some systems limit it to 31 characters.
+    std::ostringstream name;
+    name << _prefix << std::hex << std::setw(16) << std::setfill('0')
+         << static_cast<uint64_t>(std::hash<std::string>()(_key));
+    return name.str();
+  }
+}
+
+// The layout is shared by processes, so it only contains trivial types.
+struct ShmSegment::Header
+{
+  /// \brief kShmMagic once the creator has initialized the segment.
+  std::atomic<uint32_t> magic;
+
+  /// \brief Layout version.
+  uint32_t version;
+
+  /// \brief Number of slots.
+  uint64_t slotCount;
+
+  /// \brief Size of the data of a slot.
+  uint64_t slotSize;
+
+  /// \brief Sequence number of the last message written.
+  std::atomic<uint64_t> writeSeq;
+
+  /// \brief Process UUID of the writer.
+  char pUuid[kShmNameSize];
+
+  /// \brief Topic name.
+  char topic[kShmNameSize];
+
+  /// \brief Message type.
+  char msgType[kShmNameSize];
+
+  /// \brief Registered reader processes.
+  struct
+  {
+    std::atomic<uint32_t> state;
+    char pUuid[kShmNameSize];
+  } readers[kMaxReaders];
+};
+
+//////////////////////////////////////////////////
+std::size_t ShmSegment::HeaderSize()
+{
+  // Slots start on a cache line boundary.
+  return (sizeof(Header) + 63) & ~static_cast<std::size_t>(63);
+}
+
+//////////////////////////////////////////////////
+std::string ShmSegment::Name(const std::string &_pUuid,
+    const std::string &_topic)
+{
+  return HashName("/gz_", _pUuid + _topic);
+}
+
+//////////////////////////////////////////////////
+#ifndef _WIN32
+std::unique_ptr<ShmSegment> ShmSegment::Create(const std::string &_pUuid,
+    const std::string &_topic, const std::string &_msgType,
+    std::size_t _slots, std::size_t _slotSize, const int _numaNode,
+    const bool _hugePages)
+{
+  if (_slots == 0 || _slotSize == 0)
+    return nullptr;
+
+  const std::string name = Name(_pUuid, _topic);
+  const std::size_t slotStride =
+    (sizeof(SlotHeader) + _slotSize + 63) & ~static_cast<std::size_t>(63);
+  const std::size_t headerSize = HeaderSize();
+  std::size_t size = headerSize + _slots * slotStride;
+
+  // The last huge page is whole. The readers map the size of the object.
+  if (_hugePages)
+    size = (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    std::cerr << "ShmSegment::Create(): Unable to create shared memory ["
+              << name << "]: " << strerror(errno) << std::endl;
+    return nullptr;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+  {
+    std::cerr << "ShmSegment::Create(): Unable to size shared memory ["
+              << name << "]: " << strerror(errno) << std::endl;
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    std::cerr << "ShmSegment::Create(): Unable to map shared memory ["
+              << name << "]: " << strerror(errno) << std::endl;
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // The pages are allocated when they are first written, below, so they
+  // are placed before. A segment that can't be placed still works.
+  if (_hugePages)
+  {
+#ifdef MADV_HUGEPAGE
+    if (madvise(addr, size, MADV_HUGEPAGE) != 0)
+    {
+      std::cerr << "ShmSegment::Create(): Unable to use huge pages for ["
+                << name << "]: " << strerror(errno) << std::endl;
+    }
+#else
+    std::cerr << "ShmSegment::Create(): Huge pages are only supported on "
+              << "Linux" << std::endl;
+#endif
+  }
+  if (_numaNode >= 0)
+    bindMemoryNode(addr, size, _numaNode);
+
+  // The memory is zero filled by ftruncate, which is a valid initial state
+  // for all the atomics.
+  Header *header = static_cast<Header *>(addr);
+  header->version = kShmVersion;
+  header->slotCount = _slots;
+  header->slotSize = slotStride - sizeof(SlotHeader);
+  header->writeSeq.store(0, std::memory_order_relaxed);
+  CopyName(header->pUuid, _pUuid);
+  CopyName(header->topic, _topic);
+  CopyName(header->msgType, _msgType);
+  header->magic.store(kShmMagic, std::memory_order_release);
+
+  return std::unique_ptr<ShmSegment>(new ShmSegment(name, addr, size, true));
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<ShmSegment> ShmSegment::Open(const std::string &_pUuid,
+    const std::string &_topic)
+{
+  const std::string name = Name(_pUuid, _topic);
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(Header))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return nullptr;
+
+  std::unique_ptr<ShmSegment> segment(
+    new ShmSegment(name, addr, size, false));
+
+  // Discard segments not initialized yet, from another layout version, or
+  // whose name collides with a different topic.
+  Header *header = segment->header;
+  if (header->magic.load(std::memory_order_acquire) != kShmMagic ||
+      header->version != kShmVersion ||
+      header->slotCount == 0 ||
+      std::strncmp(header->pUuid, _pUuid.c_str(), kShmNameSize) != 0 ||
+      std::strncmp(header->topic, _topic.c_str(), kShmNameSize) != 0)
+  {
+    return nullptr;
+  }
+
+  const std::size_t slotStride = sizeof(SlotHeader) + header->slotSize;
+  const std::size_t headerSize = HeaderSize();
+  if (headerSize + header->slotCount * slotStride > size)
+    return nullptr;
+
+  // Only new messages are read.
+  segment->readSeq = header->writeSeq.load(std::memory_order_acquire);
+  return segment;
+}
+
+//////////////////////////////////////////////////
+ShmSegment::~ShmSegment()
+{
+  munmap(this->header, this->size);
+  if (this->owner)
+    shm_unlink(this->name.c_str());
+}
+#else
+//////////////////////////////////////////////////
+std::unique_ptr<ShmSegment> ShmSegment::Create(const std::string &,
+    const std::string &, const std::string &, std::size_t, std::size_t,
+    const int, const bool)
+{
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<ShmSegment> ShmSegment::Open(const std::string &,
+    const std::string &)
+{
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+ShmSegment::~ShmSegment()
+{
+}
+#endif
+
+//////////////////////////////////////////////////
+ShmSegment::ShmSegment(const std::string &_name, void *_addr,
+    std::size_t _size, bool _owner)
+  : name(_name),
+    header(static_cast<Header *>(_addr)),
+    size(_size),
+    owner(_owner)
+{
+}
+
+//////////////////////////////////////////////////
+char *ShmSegment::Slot(uint64_t _seq) const
+{
+  const std::size_t headerSize = HeaderSize();
+  const std::size_t slotStride = sizeof(SlotHeader) + this->header->slotSize;
+  return reinterpret_cast<char *>(this->header) + headerSize +
+    (_seq % this->header->slotCount) * slotStride;
+}
+
+//////////////////////////////////////////////////
+bool ShmSegment::Write(const char *_data, std::size_t _size)
+{
+  if (_size > this->header->slotSize)
+    return false;
+
+  const uint64_t seq =
+    this->header->writeSeq.load(std::memory_order_relaxed) + 1;
+  char *slot = this->Slot(seq);
+  SlotHeader *slotHeader = reinterpret_cast<SlotHeader *>(slot);
+
+  // Mark the slot as being written before touching the data.
+  slotHeader->seq.store(2 * seq - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  memcpy(slot + sizeof(SlotHeader), _data, _size);
+  slotHeader->size.store(_size, std::memory_order_relaxed);
+
+  slotHeader->seq.store(2 * seq, std::memory_order_release);
+
+  // Sequentially consistent, so that either the readers see the message
+  // after ShmDoorbell::PrepareWait() or the writer sees them waiting.
+  this->header->writeSeq.store(seq, std::memory_order_seq_cst);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ShmSegment::Read(std::string &_data)
+{
+  const uint64_t writeSeq =
+    this->header->writeSeq.load(std::memory_order_acquire);
+  const uint64_t slotCount = this->header->slotCount;
+
+  while (this->readSeq < writeSeq)
+  {
+    uint64_t next = this->readSeq + 1;
+
+    // Skip the messages that have been overwritten already.
+    if (writeSeq - next >= slotCount)
+    {
+      const uint64_t oldest = writeSeq - slotCount + 1;
+      this->dropped += oldest - next;
+      this->readSeq = oldest - 1;
+      continue;
+    }
+
+    const char *slot = this->Slot(next);
+    const SlotHeader *slotHeader = reinterpret_cast<const SlotHeader *>(slot);
+    this->readSeq = next;
+
+    const uint64_t before = slotHeader->seq.load(std::memory_order_acquire);
+    const uint64_t msgSize = slotHeader->size.load(std::memory_order_relaxed);
+    if (before != 2 * next || msgSize > this->header->slotSize)
+    {
+      ++this->dropped;
+      continue;
+    }
+
+    _data.assign(slot + sizeof(SlotHeader), msgSize);
+
+    // The writer may have reused the slot while we were copying it.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slotHeader->seq.load(std::memory_order_relaxed) != before)
+    {
+      ++this->dropped;
+      continue;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool ShmSegment::Unread() const
+{
+  return this->header->writeSeq.load(std::memory_order_seq_cst) >
+    this->readSeq;
+}
+
+//////////////////////////////////////////////////
+bool ShmSegment::ReadLatest(std::string &_data, uint64_t &_seq) const
+{
+  for (int attempt = 0; attempt < kReadLatestAttempts; ++attempt)
+  {
+    const uint64_t seq =
+      this->header->writeSeq.load(std::memory_order_acquire);
+    if (seq == 0 || seq == _seq)
+      return false;
+
+    const char *slot = this->Slot(seq);
+    const SlotHeader *slotHeader = reinterpret_cast<const SlotHeader *>(slot);
+    const uint64_t before = slotHeader->seq.load(std::memory_order_acquire);
+    const uint64_t msgSize = slotHeader->size.load(std::memory_order_relaxed);
+    if (before != 2 * seq || msgSize > this->header->slotSize)
+      continue;
+
+    _data.assign(slot + sizeof(SlotHeader), msgSize);
+
+    // The writer may have reused the slot while we were copying it.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slotHeader->seq.load(std::memory_order_relaxed) != before)
+      continue;
+
+    _seq = seq;
+    return true;
+  }
+
+  return false;
+}
+
+//////////////////////////////////////////////////
+uint64_t ShmSegment::WriteSeq() const
+{
+  return this->header->writeSeq.load(std::memory_order_acquire);
+}
+
+//////////////////////////////////////////////////
+uint64_t ShmSegment::Dropped() const
+{
+  return this->dropped;
+}
+
+//////////////////////////////////////////////////
+bool ShmSegment::AddReader(const std::string &_pUuid)
+{
+  if (this->HasReader(_pUuid))
+    return true;
+
+  for (auto &reader : this->header->readers)
+  {
+    uint32_t expected = kReaderFree;
+    if (reader.state.compare_exchange_strong(expected, kReaderClaimed))
+    {
+      CopyName(reader.pUuid, _pUuid);
+      reader.state.store(kReaderReady, std::memory_order_release);
+      return true;
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+void ShmSegment::RemoveReader(const std::string &_pUuid)
+{
+  for (auto &reader : this->header->readers)
+  {
+    if (reader.state.load(std::memory_order_acquire) == kReaderReady &&
+        std::strncmp(reader.pUuid, _pUuid.c_str(), kShmNameSize) == 0)
+    {
+      reader.state.store(kReaderFree, std::memory_order_release);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool ShmSegment::HasReader(const std::string &_pUuid) const
+{
+  for (const auto &reader : this->header->readers)
+  {
+    if (reader.state.load(std::memory_order_acquire) == kReaderReady &&
+        std::strncmp(reader.pUuid, _pUuid.c_str(), kShmNameSize) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+std::string ShmSegment::Topic() const
+{
+  return this->header->topic;
+}
+
+//////////////////////////////////////////////////
+std::string ShmSegment::MsgType() const
+{
+  return this->header->msgType;
+}
+
+//////////////////////////////////////////////////
+std::size_t ShmSegment::SlotSize() const
+{
+  return this->header->slotSize;
+}
+
+// The layout is shared by processes, so it only contains trivial types.
+struct ShmDoorbell::Header
+{
+  /// \brief kShmMagic once the creator has initialized the doorbell.
+  std::atomic<uint32_t> magic;
+
+  /// \brief Layout version.
+  uint32_t version;
+
+  /// \brief Incremented every time the doorbell rings while the reader
+  /// waits. This is the futex word.
+  std::atomic<uint32_t> rings;
+
+  /// \brief Number of threads of the reader between PrepareWait() and the
+  /// end of Wait() or CancelWait().
+  std::atomic<uint32_t> waiters;
+
+  /// \brief Process UUID of the reader.
+  char pUuid[kShmNameSize];
+};
+
+//////////////////////////////////////////////////
+std::string ShmDoorbell::Name(const std::string &_pUuid)
+{
+  return HashName("/gz_d", _pUuid);
+}
+
+//////////////////////////////////////////////////
+#ifndef _WIN32
+std::unique_ptr<ShmDoorbell> ShmDoorbell::Create(const std::string &_pUuid)
+{
+  const std::string name = Name(_pUuid);
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    std::cerr << "ShmDoorbell::Create(): Unable to create shared memory ["
+              << name << "]: " << strerror(errno) << std::endl;
+    return nullptr;
+  }
+
+  if (ftruncate(fd, static_cast<off_t>(sizeof(Header))) != 0)
+  {
+    std::cerr << "ShmDoorbell::Create(): Unable to size shared memory ["
+              << name << "]: " << strerror(errno) << std::endl;
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  void *addr = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE,
+    MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    std::cerr << "ShmDoorbell::Create(): Unable to map shared memory ["
+              << name << "]: " << strerror(errno) << std::endl;
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // The memory is zero filled by ftruncate.
+  Header *header = static_cast<Header *>(addr);
+  header->version = kShmVersion;
+  CopyName(header->pUuid, _pUuid);
+  header->magic.store(kShmMagic, std::memory_order_release);
+
+  return std::unique_ptr<ShmDoorbell>(new ShmDoorbell(name, addr, true));
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<ShmDoorbell> ShmDoorbell::Open(const std::string &_pUuid)
+{
+  const std::string name = Name(_pUuid);
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(Header))
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  void *addr = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE,
+    MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return nullptr;
+
+  std::unique_ptr<ShmDoorbell> doorbell(new ShmDoorbell(name, addr, false));
+
+  // Discard doorbells not initialized yet, from another layout version, or
+  // whose name collides with another process.
+  Header *header = doorbell->header;
+  if (header->magic.load(std::memory_order_acquire) != kShmMagic ||
+      header->version != kShmVersion ||
+      std::strncmp(header->pUuid, _pUuid.c_str(), kShmNameSize) != 0)
+  {
+    return nullptr;
+  }
+  return doorbell;
+}
+
+//////////////////////////////////////////////////
+ShmDoorbell::~ShmDoorbell()
+{
+  munmap(this->header, sizeof(Header));
+  if (this->owner)
+    shm_unlink(this->name.c_str());
+}
+#else
+//////////////////////////////////////////////////
+std::unique_ptr<ShmDoorbell> ShmDoorbell::Create(const std::string &)
+{
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<ShmDoorbell> ShmDoorbell::Open(const std::string &)
+{
+  return nullptr;
+}
+
+//////////////////////////////////////////////////
+ShmDoorbell::~ShmDoorbell()
+{
+}
+#endif
+
+//////////////////////////////////////////////////
+ShmDoorbell::ShmDoorbell(const std::string &_name, void *_addr,
+    bool _owner)
+  : name(_name),
+    header(static_cast<Header *>(_addr)),
+    owner(_owner)
+{
+}
+
+//////////////////////////////////////////////////
+uint32_t ShmDoorbell::PrepareWait()
+{
+  // Sequentially consistent, so that either the writers see the waiter or
+  // the reader sees their messages, see ShmSegment::Write().
+  this->header->waiters.fetch_add(1, std::memory_order_seq_cst);
+  return this->header->rings.load(std::memory_order_seq_cst);
+}
+
+//////////////////////////////////////////////////
+void ShmDoorbell::Wait(const uint32_t _key)
+{
+#ifdef __linux__
+  // Not a private futex: the writers are other processes.
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&this->header->rings),
+    FUTEX_WAIT, _key, nullptr, nullptr, 0);
+#else
+  if (this->header->rings.load(std::memory_order_seq_cst) == _key)
+    std::this_thread::sleep_for(kDoorbellPollPeriod);
+#endif
+  this->CancelWait();
+}
+
+//////////////////////////////////////////////////
+void ShmDoorbell::CancelWait()
+{
+  this->header->waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+//////////////////////////////////////////////////
+void ShmDoorbell::Ring()
+{
+  if (this->header->waiters.load(std::memory_order_seq_cst) == 0)
+    return;
+
+  this->header->rings.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&this->header->rings),
+    FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
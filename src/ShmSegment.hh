@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_SHMSEGMENT_HH_
+#define GZ_TRANSPORT_SHMSEGMENT_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Shared memory ring buffer used to exchange the messages of a
+    /// topic between processes running on the same host.
+    ///
+    /// The publisher process creates one segment per advertised topic and is
+    /// its only writer. Subscriber processes map the segment, register their
+    /// process UUID as readers and read it when the writer rings their
+    /// ShmDoorbell. Every slot is protected by a sequence number (seqlock),
+    /// so readers never block the writer: a slow reader skips the messages
+    /// that were overwritten while it was behind. For the same reason, the
+    /// messages are copied out of the slots before being used.
+    ///
+    /// Segments are only available on POSIX systems. On other platforms
+    /// Create() and Open() always fail.
+    class GZ_TRANSPORT_VISIBLE ShmSegment
+    {
+      /// \brief Maximum number of reader processes of a segment.
+      public: static constexpr std::size_t kMaxReaders = 32;
+
+      /// \brief Create a new segment. An existing segment with the same name
+      /// is replaced.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \param[in] _msgType Message type published on the topic.
+      /// \param[in] _slots Number of messages that the ring can hold.
+      /// \param[in] _slotSize Maximum size of a message (bytes).
+      /// \param[in] _numaNode NUMA node of the memory of the segment, or -1
+      /// for the policy of the calling thread. Only supported on Linux.
+      /// \param[in] _hugePages Whether the segment should use transparent
+      /// huge pages, which the kernel only provides to shared memory when
+      /// /sys/kernel/mm/transparent_hugepage/shmem_enabled allows it. Only
+      /// supported on Linux.
+      /// \return The segment or nullptr on error.
+      public: static std::unique_ptr<ShmSegment> Create(
+        const std::string &_pUuid, const std::string &_topic,
+        const std::string &_msgType, std::size_t _slots,
+        std::size_t _slotSize, const int _numaNode = -1,
+        const bool _hugePages = false);
+
+      /// \brief Open an existing segment created by another process.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The segment or nullptr if it doesn't exist (e.g. the
+      /// publisher runs on a different host).
+      public: static std::unique_ptr<ShmSegment> Open(
+        const std::string &_pUuid, const std::string &_topic);
+
+      /// \brief Name of the segment of a topic.
+      /// \param[in] _pUuid Process UUID of the publisher.
+      /// \param[in] _topic Fully qualified topic name.
+      /// \return The shared memory object name.
+      public: static std::string Name(const std::string &_pUuid,
+                                      const std::string &_topic);
+
+      /// \brief Destructor. The creator of the segment removes it.
+      public: ~ShmSegment();
+
+      /// \brief No copy.
+      public: ShmSegment(const ShmSegment &) = delete;
+
+      /// \brief No assignment.
+      public: ShmSegment &operator=(const ShmSegment &) = delete;
+
+      /// \brief Write a message. Only the creator of the segment may write
+      /// and writes must not run concurrently.
+      /// \param[in] _data Serialized message.
+      /// \param[in] _size Size of the message (bytes).
+      /// \return False if the message doesn't fit in a slot.
+      public: bool Write(const char *_data, std::size_t _size);
+
+      /// \brief Copy the next message written since the last call.
+      /// \param[out] _data Serialized message.
+      /// \return True if a message was read or false if there is nothing
+      /// new to read.
+      public: bool Read(std::string &_data);
+
+      /// \brief Whether messages were written since the last call to
+      /// Read(), without copying anything.
+      /// \return True if Read() has something new.
+      public: bool Unread() const;
+
+      /// \brief Copy the last message written, skipping the older ones.
+      /// This is how the blackboards are read, see
+      /// AdvertiseMessageOptions::SetBlackboard. Can be called by several
+      /// threads.
+      /// \param[out] _data Serialized message.
+      /// \param[in, out] _seq Sequence number of the message that the
+      /// caller already has, or 0. On success, the one of the message read.
+      /// \return True if a message newer than _seq was read.
+      public: bool ReadLatest(std::string &_data, uint64_t &_seq) const;
+
+      /// \brief Sequence number of the last message written, which tells
+      /// without copying anything whether ReadLatest() has something new.
+      /// \return The sequence number, or 0 if nothing was written.
+      public: uint64_t WriteSeq() const;
+
+      /// \brief Number of messages that this reader missed because they
+      /// were overwritten before being read.
+      /// \return Number of dropped messages.
+      public: uint64_t Dropped() const;
+
+      /// \brief Register a reader process.
+      /// \param[in] _pUuid Process UUID of the reader.
+      /// \return False if there is no room for another reader.
+      public: bool AddReader(const std::string &_pUuid);
+
+      /// \brief Unregister a reader process.
+      /// \param[in] _pUuid Process UUID of the reader.
+      public: void RemoveReader(const std::string &_pUuid);
+
+      /// \brief Whether a process is registered as a reader.
+      /// \param[in] _pUuid Process UUID.
+      /// \return True if the process reads this segment.
+      public: bool HasReader(const std::string &_pUuid) const;
+
+      /// \brief Topic of the segment.
+      /// \return The fully qualified topic name.
+      public: std::string Topic() const;
+
+      /// \brief Message type of the segment.
+      /// \return The message type.
+      public: std::string MsgType() const;
+
+      /// \brief Maximum size of a message.
+      /// \return The slot size (bytes).
+      public: std::size_t SlotSize() const;
+
+      /// \brief Layout of the segment, defined in the source file.
+      private: struct Header;
+
+      /// \brief Constructor.
+      /// \param[in] _name Shared memory object name.
+      /// \param[in] _addr Address where the segment is mapped.
+      /// \param[in] _size Size of the mapping.
+      /// \param[in] _owner Whether this process created the segment.
+      private: ShmSegment(const std::string &_name, void *_addr,
+                          std::size_t _size, bool _owner);
+
+      /// \brief Size of the header, including padding.
+      /// \return Offset of the first slot.
+      private: static std::size_t HeaderSize();
+
+      /// \brief Address of a slot.
+      /// \param[in] _seq Sequence number of the message stored in the slot.
+      /// \return Pointer to the slot.
+      private: char *Slot(uint64_t _seq) const;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::string
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Shared memory object name.
+      private: std::string name;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+      /// \brief Mapped segment.
+      private: Header *header = nullptr;
+
+      /// \brief Size of the mapping.
+      private: std::size_t size = 0;
+
+      /// \brief Whether this process created (and will remove) the segment.
+      private: bool owner = false;
+
+      /// \brief Sequence number of the last message read.
+      private: uint64_t readSeq = 0;
+
+      /// \brief Messages that this reader missed.
+      private: uint64_t dropped = 0;
+    };
+
+    /// \brief Wakes up the reader of the shared memory segments of a
+    /// process, see ShmSegment. The reader process creates its doorbell and
+    /// blocks on it once all its segments are read; the writers ring it
+    /// after every message, which only costs a system call when the reader
+    /// is blocked.
+    ///
+    /// The reader waits on a futex on Linux. On the other POSIX systems it
+    /// checks the doorbell every millisecond. Doorbells aren't available on
+    /// Windows: Create() and Open() always fail.
+    class GZ_TRANSPORT_VISIBLE ShmDoorbell
+    {
+      /// \brief Create the doorbell of a reader process. An existing
+      /// doorbell with the same name is replaced.
+      /// \param[in] _pUuid Process UUID of the reader.
+      /// \return The doorbell or nullptr on error.
+      public: static std::unique_ptr<ShmDoorbell> Create(
+        const std::string &_pUuid);
+
+      /// \brief Open the doorbell of another reader process.
+      /// \param[in] _pUuid Process UUID of the reader.
+      /// \return The doorbell or nullptr if it doesn't exist.
+      public: static std::unique_ptr<ShmDoorbell> Open(
+        const std::string &_pUuid);
+
+      /// \brief Name of the doorbell of a process.
+      /// \param[in] _pUuid Process UUID of the reader.
+      /// \return The shared memory object name.
+      public: static std::string Name(const std::string &_pUuid);
+
+      /// \brief Destructor. The creator of the doorbell removes it.
+      public: ~ShmDoorbell();
+
+      /// \brief No copy.
+      public: ShmDoorbell(const ShmDoorbell &) = delete;
+
+      /// \brief No assignment.
+      public: ShmDoorbell &operator=(const ShmDoorbell &) = delete;
+
+      /// \brief Announce that the reader is about to wait. The reader must
+      /// then check once more whether there is something to read, and call
+      /// Wait() if not or CancelWait() otherwise.
+      /// \return The key to pass to Wait().
+      public: uint32_t PrepareWait();
+
+      /// \brief Block until the doorbell rings, unless it rang since
+      /// PrepareWait(). It may also return early.
+      /// \param[in] _key The key returned by PrepareWait().
+      public: void Wait(uint32_t _key);
+
+      /// \brief Don't wait after PrepareWait().
+      public: void CancelWait();
+
+      /// \brief Wake up the reader if it waits. Can be called by any
+      /// process and thread.
+      public: void Ring();
+
+      /// \brief Layout of the doorbell, defined in the source file.
+      private: struct Header;
+
+      /// \brief Constructor.
+      /// \param[in] _name Shared memory object name.
+      /// \param[in] _addr Address where the doorbell is mapped.
+      /// \param[in] _owner Whether this process created the doorbell.
+      private: ShmDoorbell(const std::string &_name, void *_addr,
+                           bool _owner);
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::string
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Shared memory object name.
+      private: std::string name;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+      /// \brief Mapped doorbell.
+      private: Header *header = nullptr;
+
+      /// \brief Whether this process created (and will remove) the
+      /// doorbell.
+      private: bool owner = false;
+    };
+    }
+  }
+}
+#endif
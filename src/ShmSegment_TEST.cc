@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "ShmSegment.hh"
+#include "gz/transport/Uuid.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+TEST(ShmSegmentTest, WriteRead)
+{
+  const std::string pUuid = transport::Uuid().ToString();
+  const std::string topic = "/foo";
+
+  EXPECT_EQ(nullptr, transport::ShmSegment::Open(pUuid, topic));
+
+  auto writer = transport::ShmSegment::Create(
+    pUuid, topic, "gz.msgs.Int32", 4, 16);
+  ASSERT_NE(nullptr, writer);
+  EXPECT_GE(writer->SlotSize(), 16u);
+  EXPECT_EQ(topic, writer->Topic());
+
+  // Only the messages written after opening the segment are read.
+  EXPECT_TRUE(writer->Write("old", 3));
+
+  auto reader = transport::ShmSegment::Open(pUuid, topic);
+  ASSERT_NE(nullptr, reader);
+  EXPECT_EQ("gz.msgs.Int32", reader->MsgType());
+
+  // The name must match the topic and the publisher.
+  EXPECT_EQ(nullptr, transport::ShmSegment::Open(pUuid, "/bar"));
+
+  std::string data;
+  EXPECT_FALSE(reader->Read(data));
+
+  EXPECT_TRUE(writer->Write("hello", 5));
+  EXPECT_TRUE(writer->Write("world", 5));
+  ASSERT_TRUE(reader->Read(data));
+  EXPECT_EQ("hello", data);
+  ASSERT_TRUE(reader->Read(data));
+  EXPECT_EQ("world", data);
+  EXPECT_FALSE(reader->Read(data));
+  EXPECT_EQ(0u, reader->Dropped());
+
+  // Too large for a slot.
+  const std::string large(writer->SlotSize() + 1, 'x');
+  EXPECT_FALSE(writer->Write(large.data(), large.size()));
+
+  // The creator removes the segment.
+  writer.reset();
+  EXPECT_EQ(nullptr, transport::ShmSegment::Open(pUuid, topic));
+}
+
+//////////////////////////////////////////////////
+TEST(ShmSegmentTest, Overrun)
+{
+  const std::string pUuid = transport::Uuid().ToString();
+  auto writer = transport::ShmSegment::Create(
+    pUuid, "/foo", "gz.msgs.Int32", 4, 16);
+  ASSERT_NE(nullptr, writer);
+  auto reader = transport::ShmSegment::Open(pUuid, "/foo");
+  ASSERT_NE(nullptr, reader);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    const std::string msg = std::to_string(i);
+    EXPECT_TRUE(writer->Write(msg.data(), msg.size()));
+  }
+
+  // Only the last 4 messages are still available.
+  std::string data;
+  for (int i = 6; i < 10; ++i)
+  {
+    ASSERT_TRUE(reader->Read(data));
+    EXPECT_EQ(std::to_string(i), data);
+  }
+  EXPECT_FALSE(reader->Read(data));
+  EXPECT_EQ(6u, reader->Dropped());
+}
+
+//////////////////////////////////////////////////
+/// \brief A segment placed on a NUMA node, with huge pages, works like
+/// the others, whether the host supports them or not.
+TEST(ShmSegmentTest, Placement)
+{
+  const std::string pUuid = transport::Uuid().ToString();
+  auto writer = transport::ShmSegment::Create(
+    pUuid, "/foo", "gz.msgs.Int32", 4, 16, 0, true);
+  ASSERT_NE(nullptr, writer);
+  auto reader = transport::ShmSegment::Open(pUuid, "/foo");
+  ASSERT_NE(nullptr, reader);
+
+  std::string data;
+  EXPECT_TRUE(writer->Write("hello", 5));
+  ASSERT_TRUE(reader->Read(data));
+  EXPECT_EQ("hello", data);
+}
+
+//////////////////////////////////////////////////
+TEST(ShmSegmentTest, ReadLatest)
+{
+  const std::string pUuid = transport::Uuid().ToString();
+  auto writer = transport::ShmSegment::Create(
+    pUuid, "/foo", "gz.msgs.Int32", 2, 16);
+  ASSERT_NE(nullptr, writer);
+  auto reader = transport::ShmSegment::Open(pUuid, "/foo");
+  ASSERT_NE(nullptr, reader);
+
+  std::string data;
+  uint64_t seq = 0;
+  EXPECT_FALSE(reader->ReadLatest(data, seq));
+  EXPECT_EQ(0u, reader->WriteSeq());
+
+  // Only the last message is read, whatever the number of slots.
+  for (int i = 0; i < 5; ++i)
+  {
+    const std::string msg = std::to_string(i);
+    EXPECT_TRUE(writer->Write(msg.data(), msg.size()));
+  }
+  EXPECT_EQ(5u, reader->WriteSeq());
+  ASSERT_TRUE(reader->ReadLatest(data, seq));
+  EXPECT_EQ("4", data);
+  EXPECT_EQ(5u, seq);
+
+  // Nothing new.
+  EXPECT_FALSE(reader->ReadLatest(data, seq));
+
+  // Another caller starts from scratch.
+  uint64_t otherSeq = 0;
+  ASSERT_TRUE(reader->ReadLatest(data, otherSeq));
+  EXPECT_EQ("4", data);
+
+  EXPECT_TRUE(writer->Write("5", 1));
+  ASSERT_TRUE(reader->ReadLatest(data, seq));
+  EXPECT_EQ("5", data);
+  EXPECT_EQ(0u, reader->Dropped());
+}
+
+//////////////////////////////////////////////////
+TEST(ShmSegmentTest, Readers)
+{
+  const std::string pUuid = transport::Uuid().ToString();
+  auto writer = transport::ShmSegment::Create(
+    pUuid, "/foo", "gz.msgs.Int32", 1, 16);
+  ASSERT_NE(nullptr, writer);
+  auto reader = transport::ShmSegment::Open(pUuid, "/foo");
+  ASSERT_NE(nullptr, reader);
+
+  EXPECT_FALSE(writer->HasReader("proc1"));
+  EXPECT_TRUE(reader->AddReader("proc1"));
+  EXPECT_TRUE(reader->AddReader("proc1"));
+  EXPECT_TRUE(writer->HasReader("proc1"));
+  EXPECT_FALSE(writer->HasReader("proc2"));
+
+  reader->RemoveReader("proc1");
+  EXPECT_FALSE(writer->HasReader("proc1"));
+
+  for (std::size_t i = 0; i < transport::ShmSegment::kMaxReaders; ++i)
+    EXPECT_TRUE(reader->AddReader("proc" + std::to_string(i)));
+  EXPECT_FALSE(reader->AddReader("onemore"));
+}
+
+//////////////////////////////////////////////////
+TEST(ShmSegmentTest, Doorbell)
+{
+  const std::string pUuid = transport::Uuid().ToString();
+  EXPECT_EQ(nullptr, transport::ShmDoorbell::Open(pUuid));
+
+  auto reader = transport::ShmDoorbell::Create(pUuid);
+  ASSERT_NE(nullptr, reader);
+  auto writer = transport::ShmDoorbell::Open(pUuid);
+  ASSERT_NE(nullptr, writer);
+
+  auto segment = transport::ShmSegment::Create(
+    pUuid, "/foo", "gz.msgs.Int32", 4, 16);
+  ASSERT_NE(nullptr, segment);
+  auto segmentReader = transport::ShmSegment::Open(pUuid, "/foo");
+  ASSERT_NE(nullptr, segmentReader);
+
+  // Rings without a waiter are ignored.
+  writer->Ring();
+
+  // A ring after PrepareWait() isn't missed, even before Wait().
+  uint32_t key = reader->PrepareWait();
+  writer->Ring();
+  reader->Wait(key);
+
+  // The reader blocks until the writer rings.
+  std::atomic<bool> woken{false};
+  std::thread thread([&]()
+  {
+    std::string data;
+    while (!segmentReader->Read(data))
+    {
+      const uint32_t waitKey = reader->PrepareWait();
+      if (segmentReader->Unread())
+        reader->CancelWait();
+      else
+        reader->Wait(waitKey);
+    }
+    EXPECT_EQ("hello", data);
+    woken = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(woken);
+  EXPECT_TRUE(segment->Write("hello", 5));
+  writer->Ring();
+  thread.join();
+  EXPECT_TRUE(woken);
+  EXPECT_FALSE(segmentReader->Unread());
+}
+#endif
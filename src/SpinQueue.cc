@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "SpinQueue.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+SpinQueue::~SpinQueue()
+{
+#ifndef _WIN32
+  if (this->writeFd >= 0 && this->writeFd != this->readFd)
+    close(this->writeFd);
+  if (this->readFd >= 0)
+    close(this->readFd);
+#endif
+}
+
+//////////////////////////////////////////////////
+void SpinQueue::Post(std::function<void()> _task)
+{
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    if (this->closed)
+      return;
+    this->tasks.push_back(std::move(_task));
+    this->Signal();
+  }
+  this->condition.notify_one();
+}
+
+//////////////////////////////////////////////////
+void SpinQueue::Post(const std::string &, std::function<void()> _task)
+{
+  this->Post(std::move(_task));
+}
+
+//////////////////////////////////////////////////
+bool SpinQueue::RunOne(const std::chrono::nanoseconds &_timeout)
+{
+  std::function<void()> task;
+  {
+    std::unique_lock<std::mutex> lk(this->mutex);
+    if (!this->condition.wait_for(lk, _timeout, [this]
+        {
+          return !this->tasks.empty() || this->closed;
+        }) || this->tasks.empty())
+    {
+      return false;
+    }
+
+    task = std::move(this->tasks.front());
+    this->tasks.pop_front();
+    this->Drain();
+  }
+
+  task();
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t SpinQueue::RunSome()
+{
+  std::deque<std::function<void()>> ready;
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    ready.swap(this->tasks);
+    this->Drain();
+  }
+
+  for (auto &task : ready)
+    task();
+  return ready.size();
+}
+
+//////////////////////////////////////////////////
+void SpinQueue::Close()
+{
+  std::deque<std::function<void()>> discarded;
+  {
+    std::lock_guard<std::mutex> lk(this->mutex);
+    this->closed = true;
+    discarded.swap(this->tasks);
+    this->Drain();
+  }
+  this->condition.notify_all();
+}
+
+//////////////////////////////////////////////////
+int SpinQueue::Fd()
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  if (this->readFd >= 0)
+    return this->readFd;
+
+#if defined(__linux__)
+  this->readFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->readFd < 0)
+  {
+    std::cerr << "SpinQueue::Fd(): Unable to create an eventfd: "
+              << strerror(errno) << std::endl;
+    return -1;
+  }
+  this->writeFd = this->readFd;
+#elif !defined(_WIN32)
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    std::cerr << "SpinQueue::Fd(): Unable to create a pipe: "
+              << strerror(errno) << std::endl;
+    return -1;
+  }
+  for (int fd : fds)
+  {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  this->readFd = fds[0];
+  this->writeFd = fds[1];
+#else
+  return -1;
+#endif
+
+  // Callbacks may be pending already.
+  this->Signal();
+  return this->readFd;
+}
+
+//////////////////////////////////////////////////
+void SpinQueue::Signal()
+{
+#ifndef _WIN32
+  if (this->writeFd < 0 || this->signaled || this->tasks.empty())
+    return;
+
+  // The file descriptor stays readable until it is drained, so a single
+  // write covers all the callbacks posted in the meantime.
+  const uint64_t one = 1;
+  if (write(this->writeFd, &one,
+        this->writeFd == this->readFd ? sizeof(one) : 1u) > 0)
+  {
+    this->signaled = true;
+  }
+#endif
+}
+
+//////////////////////////////////////////////////
+void SpinQueue::Drain()
+{
+#ifndef _WIN32
+  if (!this->signaled || !this->tasks.empty())
+    return;
+
+  uint64_t value;
+  while (read(this->readFd, &value, sizeof(value)) > 0)
+  {
+  }
+  this->signaled = false;
+#endif
+}
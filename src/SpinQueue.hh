@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_SPINQUEUE_HH_
+#define GZ_TRANSPORT_SPINQUEUE_HH_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+#include "CallbackExecutor.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Callbacks of a node waiting for the application to spin it,
+    /// see NodeOptions::SetSpinMode(). The transport threads post the
+    /// callbacks and the thread calling Node::SpinOnce() or
+    /// Node::SpinSome() runs them, in order.
+    ///
+    /// The queue can also expose a file descriptor, readable while
+    /// callbacks are pending, for applications waiting in their own event
+    /// loop (epoll, asio, libuv...).
+    class GZ_TRANSPORT_VISIBLE SpinQueue : public CallbackExecutor
+    {
+      /// \brief Constructor.
+      public: SpinQueue() = default;
+
+      /// \brief Destructor. Closes the file descriptor.
+      public: ~SpinQueue() override;
+
+      /// \brief No copy.
+      public: SpinQueue(const SpinQueue &) = delete;
+
+      /// \brief No assignment.
+      public: SpinQueue &operator=(const SpinQueue &) = delete;
+
+      /// \brief Post a callback. It is discarded once the queue is closed.
+      /// \param[in] _task The callback.
+      public: void Post(std::function<void()> _task);
+
+      /// \brief Post a callback. The callbacks run in order whatever their
+      /// key.
+      /// \param[in] _key Ordering key, unused.
+      /// \param[in] _task The callback.
+      public: void Post(const std::string &_key,
+                        std::function<void()> _task) override;
+
+      /// \brief Run the oldest callback, waiting for one if there are none.
+      /// \param[in] _timeout Maximum time to wait.
+      /// \return True if a callback was run.
+      public: bool RunOne(const std::chrono::nanoseconds &_timeout);
+
+      /// \brief Run the callbacks posted so far, without waiting. The
+      /// callbacks posted in the meantime wait for the next call.
+      /// \return Number of callbacks run.
+      public: std::size_t RunSome();
+
+      /// \brief Discard the pending callbacks and the callbacks posted from
+      /// now on.
+      public: void Close();
+
+      /// \brief Get a file descriptor that is readable while callbacks are
+      /// pending. It is created by the first call, and only becomes
+      /// unreadable when the callbacks are run: don't read from it.
+      /// \return The file descriptor, or -1 if it isn't supported on this
+      /// platform or couldn't be created.
+      public: int Fd();
+
+      /// \brief Make the file descriptor readable. The mutex must be
+      /// locked.
+      private: void Signal();
+
+      /// \brief Make the file descriptor unreadable once there are no
+      /// callbacks left. The mutex must be locked.
+      private: void Drain();
+
+      /// \brief Protects the members below.
+      private: std::mutex mutex;
+
+      /// \brief Wakes up RunOne().
+      private: std::condition_variable condition;
+
+      /// \brief Pending callbacks.
+      private: std::deque<std::function<void()>> tasks;
+
+      /// \brief True once closed.
+      private: bool closed = false;
+
+      /// \brief Readable end of the file descriptor, or -1.
+      private: int readFd = -1;
+
+      /// \brief Writable end of the file descriptor, or -1. It is the same
+      /// as readFd for an eventfd.
+      private: int writeFd = -1;
+
+      /// \brief True while the file descriptor is readable.
+      private: bool signaled = false;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+#include "SpinQueue.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief Check whether a file descriptor is readable.
+/// \param[in] _fd The file descriptor.
+/// \param[in] _timeout Maximum time to wait (ms).
+/// \return True if it is readable.
+bool readable(int _fd, int _timeout = 0)
+{
+  pollfd item{_fd, POLLIN, 0};
+  return poll(&item, 1, _timeout) == 1 && (item.revents & POLLIN);
+}
+#endif
+
+//////////////////////////////////////////////////
+/// \brief Run the callbacks in order.
+TEST(SpinQueueTest, Run)
+{
+  SpinQueue queue;
+  int last = 0;
+  for (int i = 1; i <= 3; ++i)
+    queue.Post([&last, i]() { EXPECT_EQ(i - 1, last); last = i; });
+
+  EXPECT_TRUE(queue.RunOne(std::chrono::milliseconds(0)));
+  EXPECT_EQ(1, last);
+  EXPECT_EQ(2u, queue.RunSome());
+  EXPECT_EQ(3, last);
+  EXPECT_EQ(0u, queue.RunSome());
+  EXPECT_FALSE(queue.RunOne(std::chrono::milliseconds(10)));
+
+  // Wait for a callback posted by another thread.
+  std::thread poster([&queue, &last]()
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.Post([&last]() { last = 4; });
+  });
+  EXPECT_TRUE(queue.RunOne(std::chrono::seconds(5)));
+  EXPECT_EQ(4, last);
+  poster.join();
+
+  // The callbacks are discarded once closed.
+  queue.Post([&last]() { last = 5; });
+  queue.Close();
+  queue.Post([&last]() { last = 6; });
+  EXPECT_EQ(0u, queue.RunSome());
+  EXPECT_EQ(4, last);
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief The file descriptor is readable while callbacks are pending.
+TEST(SpinQueueTest, Fd)
+{
+  SpinQueue queue;
+  queue.Post([]() {});
+
+  const int fd = queue.Fd();
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(fd, queue.Fd());
+  EXPECT_TRUE(readable(fd));
+
+  queue.Post([]() {});
+  EXPECT_TRUE(queue.RunOne(std::chrono::milliseconds(0)));
+  EXPECT_TRUE(readable(fd));
+  EXPECT_EQ(1u, queue.RunSome());
+  EXPECT_FALSE(readable(fd));
+
+  std::thread poster([&queue]()
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.Post([]() {});
+  });
+  EXPECT_TRUE(readable(fd, 5000));
+  poster.join();
+  EXPECT_EQ(1u, queue.RunSome());
+  EXPECT_FALSE(readable(fd));
+}
+#endif
@@ -16,7 +16,12 @@
 */
 
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "gz/transport/Clock.hh"
 #include "gz/transport/Helpers.hh"
 #include "gz/transport/SubscribeOptions.hh"
 
@@ -60,6 +65,18 @@ void SubscribeOptions::SetMsgsPerSec(const uint64_t _newMsgsPerSec)
   this->dataPtr->msgsPerSec = _newMsgsPerSec;
 }
 
+//////////////////////////////////////////////////
+void SubscribeOptions::SetThrottleClock(std::shared_ptr<const Clock> _clock)
+{
+  this->dataPtr->throttleClock = std::move(_clock);
+}
+
+//////////////////////////////////////////////////
+const std::shared_ptr<const Clock> &SubscribeOptions::ThrottleClock() const
+{
+  return this->dataPtr->throttleClock;
+}
+
 //////////////////////////////////////////////////
 bool SubscribeOptions::IgnoreLocalMessages() const
 {
@@ -71,3 +88,113 @@ void SubscribeOptions::SetIgnoreLocalMessages(bool _ignore)
 {
   this->dataPtr->ignoreLocalMessages = _ignore;
 }
+
+//////////////////////////////////////////////////
+bool SubscribeOptions::UseArena() const
+{
+  return this->dataPtr->useArena;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetUseArena(bool _useArena)
+{
+  this->dataPtr->useArena = _useArena;
+}
+
+//////////////////////////////////////////////////
+bool SubscribeOptions::ReuseMessages() const
+{
+  return this->dataPtr->reuseMessages;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetReuseMessages(bool _reuse)
+{
+  this->dataPtr->reuseMessages = _reuse;
+}
+
+//////////////////////////////////////////////////
+const std::vector<std::string> &SubscribeOptions::FieldMask() const
+{
+  return this->dataPtr->fieldMask;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetFieldMask(const std::vector<std::string> &_paths)
+{
+  this->dataPtr->fieldMask = _paths;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetFilter(const std::string &_expression)
+{
+  this->dataPtr->filter = _expression;
+}
+
+//////////////////////////////////////////////////
+const std::string &SubscribeOptions::Filter() const
+{
+  return this->dataPtr->filter;
+}
+
+//////////////////////////////////////////////////
+bool SubscribeOptions::Conflate() const
+{
+  return this->dataPtr->conflate;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetConflate(bool _conflate)
+{
+  this->dataPtr->conflate = _conflate;
+}
+
+//////////////////////////////////////////////////
+bool SubscribeOptions::Queued() const
+{
+  return this->QueueDepth() > 0;
+}
+
+//////////////////////////////////////////////////
+uint64_t SubscribeOptions::QueueDepth() const
+{
+  return this->dataPtr->queueDepth;
+}
+
+//////////////////////////////////////////////////
+QueuePolicy_t SubscribeOptions::QueuePolicy() const
+{
+  return this->dataPtr->queuePolicy;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetQueue(const uint64_t _depth,
+  const QueuePolicy_t _policy)
+{
+  this->dataPtr->queueDepth = _depth;
+  this->dataPtr->queuePolicy = _policy;
+}
+
+//////////////////////////////////////////////////
+uint64_t SubscribeOptions::Credits() const
+{
+  return this->dataPtr->credits;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetCredits(const uint64_t _credits)
+{
+  this->dataPtr->credits = _credits;
+}
+
+//////////////////////////////////////////////////
+const std::string &SubscribeOptions::CallbackGroup() const
+{
+  return this->dataPtr->callbackGroup;
+}
+
+//////////////////////////////////////////////////
+void SubscribeOptions::SetCallbackGroup(const std::string &_group)
+{
+  this->dataPtr->callbackGroup = _group;
+}
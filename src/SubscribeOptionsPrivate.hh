@@ -19,8 +19,13 @@
 #define GZ_TRANSPORT_SUBSCRIBEOPTIONSPRIVATE_HH_
 
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "gz/transport/Clock.hh"
 #include "gz/transport/Helpers.hh"
+#include "gz/transport/QueuePolicy.hh"
 
 namespace gz
 {
@@ -42,8 +47,40 @@ namespace gz
       /// \brief Default message subscription rate.
       public: uint64_t msgsPerSec = kUnthrottled;
 
+      /// \brief Clock of the throttling, or nullptr for the steady clock.
+      public: std::shared_ptr<const Clock> throttleClock;
+
       /// \brief Whether local messages should be ignored or not.
       public: bool ignoreLocalMessages = false;
+
+      /// \brief Whether received messages are deserialized into an arena.
+      public: bool useArena = false;
+
+      /// \brief Whether received messages are recycled.
+      public: bool reuseMessages = false;
+
+      /// \brief Paths of the fields parsed, or empty to parse the whole
+      /// messages.
+      public: std::vector<std::string> fieldMask;
+
+      /// \brief Predicate over the fields of the messages, or empty.
+      public: std::string filter;
+
+      /// \brief Whether only the latest message is delivered.
+      public: bool conflate = false;
+
+      /// \brief Maximum number of messages waiting for the callback, or 0
+      /// if the messages are not queued.
+      public: uint64_t queueDepth = 0;
+
+      /// \brief What happens when the queue is full.
+      public: QueuePolicy_t queuePolicy = QueuePolicy_t::DROP_OLDEST;
+
+      /// \brief Credits of the flow control, or 0 if it is disabled.
+      public: uint64_t credits = 0;
+
+      /// \brief Name of the callback group, or empty.
+      public: std::string callbackGroup;
     };
     }
   }
@@ -15,6 +15,9 @@
  *
 */
 
+#include <memory>
+
+#include "gz/transport/Clock.hh"
 #include "gz/transport/Helpers.hh"
 #include "gz/transport/SubscribeOptions.hh"
 #include "gtest/gtest.h"
@@ -42,6 +45,63 @@ TEST(SubscribeOptionsTest, accessors)
   EXPECT_EQ(opts.MsgsPerSec(), kUnthrottled);
   opts.SetMsgsPerSec(3u);
   EXPECT_EQ(opts.MsgsPerSec(), 3u);
+
+  // UseArena.
+  EXPECT_FALSE(opts.UseArena());
+  opts.SetUseArena(true);
+  EXPECT_TRUE(opts.UseArena());
+  SubscribeOptions opts2(opts);
+  EXPECT_TRUE(opts2.UseArena());
+
+  // ReuseMessages.
+  EXPECT_FALSE(opts.ReuseMessages());
+  opts.SetReuseMessages(true);
+  EXPECT_TRUE(opts.ReuseMessages());
+  SubscribeOptions opts5(opts);
+  EXPECT_TRUE(opts5.ReuseMessages());
+
+  // FieldMask.
+  EXPECT_TRUE(opts.FieldMask().empty());
+  opts.SetFieldMask({"header.stamp", "pose"});
+  ASSERT_EQ(2u, opts.FieldMask().size());
+  EXPECT_EQ("header.stamp", opts.FieldMask()[0]);
+  SubscribeOptions opts6(opts);
+  EXPECT_EQ(opts.FieldMask(), opts6.FieldMask());
+
+  // Conflate.
+  EXPECT_FALSE(opts.Conflate());
+  opts.SetConflate(true);
+  EXPECT_TRUE(opts.Conflate());
+  SubscribeOptions opts3(opts);
+  EXPECT_TRUE(opts3.Conflate());
+
+  // Queue.
+  EXPECT_FALSE(opts.Queued());
+  EXPECT_EQ(opts.QueueDepth(), 0u);
+  EXPECT_EQ(opts.QueuePolicy(), QueuePolicy_t::DROP_OLDEST);
+  opts.SetQueue(5u, QueuePolicy_t::KEEP_ALL);
+  EXPECT_TRUE(opts.Queued());
+  EXPECT_EQ(opts.QueueDepth(), 5u);
+  EXPECT_EQ(opts.QueuePolicy(), QueuePolicy_t::KEEP_ALL);
+  SubscribeOptions opts4(opts);
+  EXPECT_EQ(opts4.QueueDepth(), 5u);
+  EXPECT_EQ(opts4.QueuePolicy(), QueuePolicy_t::KEEP_ALL);
+  opts4.SetQueue(2u);
+  EXPECT_EQ(opts4.QueuePolicy(), QueuePolicy_t::DROP_OLDEST);
+
+  // Credits.
+  EXPECT_EQ(opts.Credits(), 0u);
+  opts.SetCredits(64u);
+  EXPECT_EQ(opts.Credits(), 64u);
+  SubscribeOptions opts7(opts);
+  EXPECT_EQ(opts7.Credits(), 64u);
+
+  // Callback group.
+  EXPECT_TRUE(opts.CallbackGroup().empty());
+  opts.SetCallbackGroup("control");
+  EXPECT_EQ(opts.CallbackGroup(), "control");
+  SubscribeOptions opts8(opts);
+  EXPECT_EQ(opts8.CallbackGroup(), "control");
 }
 
 //////////////////////////////////////////////////
@@ -53,3 +113,22 @@ TEST(SubscribeOptionsTest, throttled)
   opts.SetMsgsPerSec(3u);
   EXPECT_TRUE(opts.Throttled());
 }
+
+//////////////////////////////////////////////////
+/// \brief Check the clock of the throttling.
+TEST(SubscribeOptionsTest, throttleClock)
+{
+  SubscribeOptions opts;
+  EXPECT_EQ(nullptr, opts.ThrottleClock());
+
+  std::shared_ptr<const Clock> clock(WallClock::Instance(),
+    [](const Clock *){});
+  opts.SetThrottleClock(clock);
+  EXPECT_EQ(clock, opts.ThrottleClock());
+
+  SubscribeOptions opts2(opts);
+  EXPECT_EQ(clock, opts2.ThrottleClock());
+
+  opts.SetThrottleClock(nullptr);
+  EXPECT_EQ(nullptr, opts.ThrottleClock());
+}
@@ -15,14 +15,52 @@
  *
 */
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "gz/transport/Clock.hh"
 #include "gz/transport/SubscriptionHandler.hh"
 
+#include "ContentFilter.hh"
+#include "FieldFilter.hh"
+
 namespace gz
 {
   namespace transport
   {
     inline namespace GZ_TRANSPORT_VERSION_NAMESPACE
     {
+    /////////////////////////////////////////////////
+    /// \brief Bounded queue of a conflated or queued subscription.
+    class SubscriptionQueue
+    {
+      /// \brief A serialized message and its information.
+      public: using Msg = std::pair<std::string, MessageInfo>;
+
+      /// \brief Messages waiting for the callback, from the oldest to the
+      /// newest.
+      public: std::deque<Msg> msgs;
+
+      /// \brief Maximum number of messages.
+      public: std::size_t depth = 1;
+
+      /// \brief What happens when the queue is full.
+      public: QueuePolicy_t policy = QueuePolicy_t::DROP_OLDEST;
+
+      /// \brief Messages dropped because the queue was full.
+      public: uint64_t dropped = 0;
+
+      /// \brief Protects the queue.
+      public: mutable std::mutex mutex;
+
+      /// \brief Signals room in a KEEP_ALL queue.
+      public: std::condition_variable room;
+    };
+
     /////////////////////////////////////////////////
     SubscriptionHandlerBase::SubscriptionHandlerBase(
         const std::string &_nUuid,
@@ -33,34 +71,198 @@ namespace gz
         lastCbTimestamp(std::chrono::seconds{0}),
         nUuid(_nUuid)
     {
+      // A conflated subscription is a queue of a single message that
+      // replaces the oldest one.
+      if (this->opts.Conflate())
+      {
+        this->queue = std::make_shared<SubscriptionQueue>();
+      }
+      else if (this->opts.Queued())
+      {
+        this->queue = std::make_shared<SubscriptionQueue>();
+        this->queue->depth = static_cast<std::size_t>(this->opts.QueueDepth());
+        this->queue->policy = this->opts.QueuePolicy();
+      }
+
       if (this->opts.Throttled())
         this->periodNs = 1e9 / this->opts.MsgsPerSec();
     }
 
     /////////////////////////////////////////////////
-    std::string SubscriptionHandlerBase::NodeUuid() const
+    uint64_t SubscriptionHandlerBase::MsgsPerSec() const
+    {
+      // The publishers measure the rate with the steady clock.
+      if (!this->opts.Throttled() || this->opts.ThrottleClock())
+        return kUnthrottled;
+      return this->opts.MsgsPerSec();
+    }
+
+    /////////////////////////////////////////////////
+    bool SubscriptionHandlerBase::Conflated() const
+    {
+      return this->opts.Conflate();
+    }
+
+    /////////////////////////////////////////////////
+    uint64_t SubscriptionHandlerBase::Credits() const
+    {
+      return this->opts.Credits();
+    }
+
+    /////////////////////////////////////////////////
+    bool SubscriptionHandlerBase::Queued() const
+    {
+      return this->queue != nullptr;
+    }
+
+    /////////////////////////////////////////////////
+    bool SubscriptionHandlerBase::Enqueue(const std::string &_data,
+        const MessageInfo &_info, const std::atomic<bool> &_abort,
+        bool &_dropped)
+    {
+      _dropped = false;
+      if (!this->queue)
+        return false;
+
+      SubscriptionQueue &q = *this->queue;
+      std::unique_lock<std::mutex> lk(q.mutex);
+      if (q.msgs.size() >= q.depth)
+      {
+        switch (q.policy)
+        {
+          case QueuePolicy_t::DROP_OLDEST:
+          {
+            // Recycle the oldest message, so its buffer keeps its capacity.
+            SubscriptionQueue::Msg oldest = std::move(q.msgs.front());
+            q.msgs.pop_front();
+            oldest.first.assign(_data);
+            oldest.second = _info;
+            q.msgs.push_back(std::move(oldest));
+            ++q.dropped;
+            _dropped = true;
+            return false;
+          }
+          case QueuePolicy_t::DROP_NEWEST:
+          default:
+            ++q.dropped;
+            _dropped = true;
+            return false;
+          case QueuePolicy_t::KEEP_ALL:
+            while (q.msgs.size() >= q.depth)
+            {
+              if (_abort)
+              {
+                ++q.dropped;
+                _dropped = true;
+                return false;
+              }
+              q.room.wait_for(lk, std::chrono::milliseconds(100));
+            }
+            break;
+        }
+      }
+
+      const bool wasEmpty = q.msgs.empty();
+      q.msgs.emplace_back(_data, _info);
+      return wasEmpty;
+    }
+
+    /////////////////////////////////////////////////
+    bool SubscriptionHandlerBase::Dequeue(std::string &_data,
+        MessageInfo &_info)
+    {
+      if (!this->queue)
+        return false;
+
+      SubscriptionQueue &q = *this->queue;
+      {
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (q.msgs.empty())
+          return false;
+
+        _data.swap(q.msgs.front().first);
+        _info = q.msgs.front().second;
+        q.msgs.pop_front();
+      }
+      q.room.notify_one();
+      return true;
+    }
+
+    /////////////////////////////////////////////////
+    uint64_t SubscriptionHandlerBase::DroppedCount() const
+    {
+      if (!this->queue)
+        return 0;
+
+      std::lock_guard<std::mutex> lk(this->queue->mutex);
+      return this->queue->dropped;
+    }
+
+    /////////////////////////////////////////////////
+    bool SubscriptionHandlerBase::Alive() const
+    {
+      return this->alive.load(std::memory_order_acquire);
+    }
+
+    /////////////////////////////////////////////////
+    void SubscriptionHandlerBase::Detach()
+    {
+      this->alive.store(false, std::memory_order_release);
+    }
+
+    /////////////////////////////////////////////////
+    const std::string &SubscriptionHandlerBase::NodeUuid() const
     {
       return this->nUuid;
     }
 
     /////////////////////////////////////////////////
-    std::string SubscriptionHandlerBase::HandlerUuid() const
+    const std::string &SubscriptionHandlerBase::HandlerUuid() const
     {
       return this->hUuid;
     }
 
+    /////////////////////////////////////////////////
+    const std::string &SubscriptionHandlerBase::CallbackGroup() const
+    {
+      return this->opts.CallbackGroup();
+    }
+
     /////////////////////////////////////////////////
     bool SubscriptionHandlerBase::IgnoreLocalMessages() const
     {
       return this->opts.IgnoreLocalMessages();
     }
 
+    /////////////////////////////////////////////////
+    const std::string &SubscriptionHandlerBase::Filter() const
+    {
+      return this->opts.Filter();
+    }
+
     /////////////////////////////////////////////////
     bool SubscriptionHandlerBase::UpdateThrottling()
     {
       if (!this->opts.Throttled())
         return true;
 
+      const std::shared_ptr<const Clock> &clock = this->opts.ThrottleClock();
+      if (clock && clock->IsReady())
+      {
+        const std::chrono::nanoseconds time = clock->Time();
+
+        // The clock goes back when a simulation is reset.
+        if (this->lastClockTime.count() >= 0 &&
+            time >= this->lastClockTime &&
+            (time - this->lastClockTime).count() < this->periodNs)
+        {
+          return false;
+        }
+
+        this->lastClockTime = time;
+        return true;
+      }
+
       Timestamp now = std::chrono::steady_clock::now();
 
       // Elapsed time since the last callback execution.
@@ -83,7 +285,39 @@ namespace gz
         const SubscribeOptions &_opts)
       : SubscriptionHandlerBase(_nUuid, _opts)
     {
-      // Do nothing
+      if (this->opts.UseArena())
+        this->arenaPool = std::make_shared<ArenaPool>();
+      if (!this->opts.FieldMask().empty())
+      {
+        this->fieldFilter =
+          std::make_shared<FieldFilter>(this->opts.FieldMask());
+      }
+      if (!this->opts.Filter().empty())
+      {
+        this->contentFilter =
+          std::make_shared<ContentFilter>(this->opts.Filter());
+      }
+    }
+
+    /////////////////////////////////////////////////
+    bool ISubscriptionHandler::ParseMsg(const std::string &_data,
+      ProtoMsg &_msg) const
+    {
+      if (this->fieldFilter)
+      {
+        // The buffer keeps its capacity for the next messages.
+        thread_local std::string filtered;
+        if (this->fieldFilter->Filter(_data, _msg.GetDescriptor(), filtered))
+          return _msg.ParseFromString(filtered);
+      }
+
+      return _msg.ParseFromString(_data);
+    }
+
+    /////////////////////////////////////////////////
+    bool ISubscriptionHandler::Accept(const ProtoMsg &_msg) const
+    {
+      return !this->contentFilter || this->contentFilter->Matches(_msg);
     }
 
     /////////////////////////////////////////////////
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/stringmsg.pb.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "gz/transport/Clock.hh"
+#include "gz/transport/SubscriptionHandler.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+/// \brief A clock whose time is set by the test, as a simulation would.
+class ManualClock : public Clock
+{
+  // Documentation inherited.
+  public: std::chrono::nanoseconds Time() const override
+  {
+    return this->time;
+  }
+
+  // Documentation inherited.
+  public: bool IsReady() const override
+  {
+    return true;
+  }
+
+  /// \brief Current time.
+  public: std::chrono::nanoseconds time{0};
+};
+
+//////////////////////////////////////////////////
+/// \brief A generic subscription creates messages of every type it
+/// receives, even when the type changes.
+TEST(SubscriptionHandlerTest, GenericCreateMsg)
+{
+  msgs::Int32 intMsg;
+  intMsg.set_data(3);
+  std::string intData;
+  ASSERT_TRUE(intMsg.SerializeToString(&intData));
+
+  msgs::StringMsg strMsg;
+  strMsg.set_data("text");
+  std::string strData;
+  ASSERT_TRUE(strMsg.SerializeToString(&strData));
+
+  SubscriptionHandler<ProtoMsg> handler("nUuid");
+  for (int i = 0; i < 2; ++i)
+  {
+    auto msg = handler.CreateMsg(intData, intMsg.GetTypeName());
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(intMsg.GetTypeName(), msg->GetTypeName());
+    EXPECT_EQ(intMsg.DebugString(), msg->DebugString());
+
+    msg = handler.CreateMsg(strData, strMsg.GetTypeName());
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(strMsg.GetTypeName(), msg->GetTypeName());
+    EXPECT_EQ(strMsg.DebugString(), msg->DebugString());
+  }
+
+  // Unknown types can't be created.
+  EXPECT_EQ(nullptr, handler.CreateMsg(intData, "gz.msgs.Unknown"));
+
+  // The cached type is still valid.
+  auto msg = handler.CreateMsg(strData, strMsg.GetTypeName());
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ(strMsg.DebugString(), msg->DebugString());
+}
+
+//////////////////////////////////////////////////
+/// \brief A subscription throttled with its own clock follows the time of
+/// the clock: nothing is delivered while it is paused, and a reset of the
+/// clock delivers the next message.
+TEST(SubscriptionHandlerTest, ThrottleClock)
+{
+  auto clock = std::make_shared<ManualClock>();
+  SubscribeOptions opts;
+  opts.SetMsgsPerSec(10u);
+  opts.SetThrottleClock(clock);
+
+  int count = 0;
+  SubscriptionHandler<msgs::Int32> handler("nUuid", opts);
+  handler.SetCallback([&count](const msgs::Int32 &, const MessageInfo &)
+  {
+    ++count;
+  });
+  EXPECT_EQ(kUnthrottled, handler.MsgsPerSec());
+
+  msgs::Int32 msg;
+  MessageInfo info;
+
+  // Paused.
+  for (int i = 0; i < 3; ++i)
+    EXPECT_TRUE(handler.RunLocalCallback(msg, info));
+  EXPECT_EQ(1, count);
+
+  clock->time = std::chrono::milliseconds(50);
+  EXPECT_TRUE(handler.RunLocalCallback(msg, info));
+  EXPECT_EQ(1, count);
+
+  clock->time = std::chrono::milliseconds(100);
+  EXPECT_TRUE(handler.RunLocalCallback(msg, info));
+  EXPECT_EQ(2, count);
+
+  // Reset.
+  clock->time = std::chrono::milliseconds(10);
+  EXPECT_TRUE(handler.RunLocalCallback(msg, info));
+  EXPECT_EQ(3, count);
+  EXPECT_TRUE(handler.RunLocalCallback(msg, info));
+  EXPECT_EQ(3, count);
+}
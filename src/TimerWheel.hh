@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_TIMERWHEEL_HH_
+#define GZ_TRANSPORT_TIMERWHEEL_HH_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gz/transport/config.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Hashed timer wheel. Scheduling a deadline is constant time and
+    /// expiring the due keys only visits the slots that the clock went
+    /// through since the previous call, instead of every pending key.
+    ///
+    /// Keys are not cancelled: the owner ignores the expired keys that it
+    /// doesn't track anymore. Not thread safe.
+    template<typename Key> class TimerWheel
+    {
+      /// \brief Clock of the deadlines.
+      public: using Clock = std::chrono::steady_clock;
+
+      /// \brief Constructor.
+      /// \param[in] _tick Duration covered by a slot.
+      /// \param[in] _slots Number of slots. Deadlines further than
+      /// _tick * _slots wait for more than one turn.
+      public: TimerWheel(const Clock::duration &_tick, const std::size_t _slots)
+        : tick(_tick),
+          origin(Clock::now()),
+          slots(_slots > 0 ? _slots : 1)
+      {
+      }
+
+      /// \brief Schedule a key.
+      /// \param[in] _key The key.
+      /// \param[in] _deadline When the key expires.
+      public: void Schedule(const Key &_key, const Clock::time_point &_deadline)
+      {
+        // Deadlines in a slot already visited are seen in the next call.
+        const uint64_t t = std::max(this->TickOf(_deadline), this->next);
+        this->slots[t % this->slots.size()].emplace_back(_key, _deadline);
+        ++this->size;
+      }
+
+      /// \brief Remove the keys whose deadline is due. A key expires once
+      /// the tick of its deadline is over, so up to one tick late.
+      /// \param[in] _now Current time.
+      /// \param[out] _expired The expired keys, appended.
+      public: void Expire(const Clock::time_point &_now,
+                          std::vector<Key> &_expired)
+      {
+        const uint64_t now = this->TickOf(_now);
+        if (now <= this->next)
+          return;
+
+        // Visit each slot once at most. A slot also holds the keys of the
+        // following turns.
+        const uint64_t steps = std::min<uint64_t>(now - this->next,
+          this->slots.size());
+        for (uint64_t i = 0; i < steps && this->size > 0; ++i)
+        {
+          auto &slot = this->slots[(this->next + i) % this->slots.size()];
+          auto keep = slot.begin();
+          for (auto &entry : slot)
+          {
+            if (this->TickOf(entry.second) < now)
+              _expired.push_back(std::move(entry.first));
+            else
+              *keep++ = std::move(entry);
+          }
+          this->size -= static_cast<std::size_t>(slot.end() - keep);
+          slot.erase(keep, slot.end());
+        }
+        this->next = now;
+      }
+
+      /// \brief Number of scheduled keys.
+      /// \return The number of keys.
+      public: std::size_t Size() const
+      {
+        return this->size;
+      }
+
+      /// \brief Tick of a time point.
+      /// \param[in] _time The time point.
+      /// \return Number of ticks since the creation of the wheel.
+      private: uint64_t TickOf(const Clock::time_point &_time) const
+      {
+        if (_time <= this->origin)
+          return 0;
+        return static_cast<uint64_t>((_time - this->origin) / this->tick);
+      }
+
+      /// \brief Duration covered by a slot.
+      private: Clock::duration tick;
+
+      /// \brief Time of tick 0.
+      private: Clock::time_point origin;
+
+      /// \brief Next tick to visit.
+      private: uint64_t next = 0;
+
+      /// \brief Number of scheduled keys.
+      private: std::size_t size = 0;
+
+      /// \brief Keys and deadlines of each slot.
+      private: std::vector<std::vector<std::pair<Key, Clock::time_point>>>
+        slots;
+    };
+    }
+  }
+}
+
+#endif
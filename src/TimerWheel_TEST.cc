@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "TimerWheel.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+TEST(TimerWheelTest, Expire)
+{
+  using Clock = std::chrono::steady_clock;
+  transport::TimerWheel<int> wheel(std::chrono::milliseconds(10), 8);
+  const auto start = Clock::now();
+
+  wheel.Schedule(1, start + std::chrono::milliseconds(15));
+  wheel.Schedule(2, start + std::chrono::milliseconds(45));
+  // Further than a whole turn of the wheel.
+  wheel.Schedule(3, start + std::chrono::milliseconds(200));
+  EXPECT_EQ(3u, wheel.Size());
+
+  std::vector<int> expired;
+  wheel.Expire(start, expired);
+  EXPECT_TRUE(expired.empty());
+
+  wheel.Expire(start + std::chrono::milliseconds(40), expired);
+  EXPECT_EQ(std::vector<int>({1}), expired);
+  EXPECT_EQ(2u, wheel.Size());
+
+  // Skip several turns at once.
+  expired.clear();
+  wheel.Expire(start + std::chrono::milliseconds(100), expired);
+  EXPECT_EQ(std::vector<int>({2}), expired);
+
+  expired.clear();
+  wheel.Expire(start + std::chrono::milliseconds(500), expired);
+  EXPECT_EQ(std::vector<int>({3}), expired);
+  EXPECT_EQ(0u, wheel.Size());
+}
+
+//////////////////////////////////////////////////
+TEST(TimerWheelTest, PastDeadline)
+{
+  using Clock = std::chrono::steady_clock;
+  transport::TimerWheel<std::string> wheel(std::chrono::milliseconds(10), 4);
+  const auto start = Clock::now();
+
+  std::vector<std::string> expired;
+  wheel.Expire(start + std::chrono::milliseconds(50), expired);
+
+  // A deadline in a slot already visited expires in the next call.
+  wheel.Schedule("late", start);
+  wheel.Expire(start + std::chrono::milliseconds(50), expired);
+  EXPECT_TRUE(expired.empty());
+  wheel.Expire(start + std::chrono::milliseconds(70), expired);
+  EXPECT_EQ(std::vector<std::string>({"late"}), expired);
+}
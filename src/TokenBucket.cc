@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <algorithm>
+
+#include "TokenBucket.hh"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+TokenBucket::TokenBucket(const double _rate, const double _burst)
+  : rate(_rate),
+    burst(std::max(_burst, 1.0)),
+    tokens(std::max(_burst, 1.0))
+{
+}
+
+//////////////////////////////////////////////////
+bool TokenBucket::Ready(const double _tokens, const Clock::time_point &_now)
+{
+  if (this->started && _now > this->last)
+  {
+    const double elapsed =
+      std::chrono::duration<double>(_now - this->last).count();
+    this->tokens = std::min(this->burst, this->tokens + elapsed * this->rate);
+  }
+  if (!this->started || _now > this->last)
+    this->last = _now;
+  this->started = true;
+
+  return this->tokens >= _tokens || this->tokens >= this->burst;
+}
+
+//////////////////////////////////////////////////
+void TokenBucket::Take(const double _tokens)
+{
+  this->tokens -= _tokens;
+}
+
+//////////////////////////////////////////////////
+double TokenBucket::Tokens() const
+{
+  return this->tokens;
+}
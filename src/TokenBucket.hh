@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef GZ_TRANSPORT_TOKENBUCKET_HH_
+#define GZ_TRANSPORT_TOKENBUCKET_HH_
+
+#include <chrono>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief A token bucket, which bounds the average rate of an activity
+    /// while letting it burst, see AdvertiseMessageOptions::SetRateLimit.
+    ///
+    /// The bucket fills at a constant rate up to its capacity, and every
+    /// operation takes some tokens out of it. An operation larger than the
+    /// capacity passes when the bucket is full and leaves it in debt, so it
+    /// is delayed rather than blocked forever. The bucket isn't thread
+    /// safe.
+    class GZ_TRANSPORT_VISIBLE TokenBucket
+    {
+      /// \brief Clock used to refill the bucket.
+      public: using Clock = std::chrono::steady_clock;
+
+      /// \brief Constructor. The bucket starts full.
+      /// \param[in] _rate Tokens added per second.
+      /// \param[in] _burst Capacity of the bucket.
+      public: TokenBucket(const double _rate, const double _burst);
+
+      /// \brief Refill the bucket and check whether it holds enough tokens.
+      /// \param[in] _tokens Number of tokens needed.
+      /// \param[in] _now Current time.
+      /// \return True if Take(_tokens) can be called.
+      public: bool Ready(const double _tokens, const Clock::time_point &_now);
+
+      /// \brief Take tokens out of the bucket.
+      /// \param[in] _tokens Number of tokens.
+      public: void Take(const double _tokens);
+
+      /// \brief Get the number of tokens in the bucket, as of the last call
+      /// to Ready(). It is negative while the bucket is in debt.
+      /// \return The number of tokens.
+      public: double Tokens() const;
+
+      /// \brief Tokens added per second.
+      private: double rate;
+
+      /// \brief Capacity.
+      private: double burst;
+
+      /// \brief Tokens in the bucket.
+      private: double tokens;
+
+      /// \brief Last time the bucket was refilled.
+      private: Clock::time_point last;
+
+      /// \brief Whether the bucket was refilled at least once.
+      private: bool started = false;
+    };
+    }
+  }
+}
+#endif
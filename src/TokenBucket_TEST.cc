@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#include <chrono>
+
+#include "TokenBucket.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+using namespace std::chrono_literals;
+
+//////////////////////////////////////////////////
+/// \brief A full bucket lets a burst through, then the rate applies.
+TEST(TokenBucketTest, Burst)
+{
+  TokenBucket bucket(10.0, 3.0);
+  const TokenBucket::Clock::time_point start;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_TRUE(bucket.Ready(1.0, start));
+    bucket.Take(1.0);
+  }
+  EXPECT_FALSE(bucket.Ready(1.0, start));
+
+  // One token every 100 ms.
+  EXPECT_FALSE(bucket.Ready(1.0, start + 50ms));
+  EXPECT_TRUE(bucket.Ready(1.0, start + 100ms));
+  bucket.Take(1.0);
+  EXPECT_FALSE(bucket.Ready(1.0, start + 150ms));
+
+  // The bucket never holds more than its capacity.
+  EXPECT_TRUE(bucket.Ready(1.0, start + 10s));
+  EXPECT_DOUBLE_EQ(3.0, bucket.Tokens());
+
+  // Time going backwards doesn't add tokens.
+  bucket.Take(3.0);
+  EXPECT_FALSE(bucket.Ready(1.0, start));
+  EXPECT_DOUBLE_EQ(0.0, bucket.Tokens());
+}
+
+//////////////////////////////////////////////////
+/// \brief An operation larger than the capacity passes when the bucket is
+/// full and leaves it in debt.
+TEST(TokenBucketTest, Debt)
+{
+  TokenBucket bucket(100.0, 100.0);
+  const TokenBucket::Clock::time_point start;
+
+  EXPECT_TRUE(bucket.Ready(250.0, start));
+  bucket.Take(250.0);
+  EXPECT_DOUBLE_EQ(-150.0, bucket.Tokens());
+
+  EXPECT_FALSE(bucket.Ready(1.0, start + 1s));
+  EXPECT_TRUE(bucket.Ready(1.0, start + 1600ms));
+  EXPECT_FALSE(bucket.Ready(250.0, start + 1600ms));
+  EXPECT_TRUE(bucket.Ready(250.0, start + 2500ms));
+}
@@ -16,9 +16,14 @@
 */
 #include <gz/msgs/statistic.pb.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "gz/transport/TopicStatistics.hh"
 
@@ -37,9 +42,16 @@ class gz::transport::TopicStatisticsPrivate
             publication(_stats.publication),
             reception(_stats.reception),
             age(_stats.age),
+            transit(_stats.transit),
+            queueing(_stats.queueing),
+            publicationHist(_stats.publicationHist),
+            receptionHist(_stats.receptionHist),
+            ageHist(_stats.ageHist),
+            transitHist(_stats.transitHist),
+            queueingHist(_stats.queueingHist),
             droppedMsgCount(_stats.droppedMsgCount),
-            prevPublicationStamp(_stats.prevPublicationStamp),
-            prevReceptionStamp(_stats.prevReceptionStamp)
+            prevPublicationStampUs(_stats.prevPublicationStampUs),
+            prevReceptionStampUs(_stats.prevReceptionStampUs)
   {
   }
 
@@ -56,16 +68,183 @@ class gz::transport::TopicStatisticsPrivate
   /// \brief Age statistics.
   public: Statistics age;
 
+  /// \brief Transit statistics.
+  public: Statistics transit;
+
+  /// \brief Queueing statistics.
+  public: Statistics queueing;
+
+  /// \brief Publication period histogram (microseconds).
+  public: LatencyHistogram publicationHist;
+
+  /// \brief Reception period histogram (microseconds).
+  public: LatencyHistogram receptionHist;
+
+  /// \brief Age histogram (microseconds).
+  public: LatencyHistogram ageHist;
+
+  /// \brief Transit histogram (microseconds).
+  public: LatencyHistogram transitHist;
+
+  /// \brief Queueing histogram (microseconds).
+  public: LatencyHistogram queueingHist;
+
   /// \brief Total number of dropped messages.
   public: uint64_t droppedMsgCount = 0;
 
-  /// \brief Previous publication time stamp.
-  public: uint64_t prevPublicationStamp = 0;
+  /// \brief Previous publication time stamp (microseconds).
+  public: uint64_t prevPublicationStampUs = 0;
 
-  /// \brief Previous reception time stamp.
-  public: uint64_t prevReceptionStamp = 0;
+  /// \brief Previous reception time stamp (microseconds).
+  public: uint64_t prevReceptionStampUs = 0;
 };
 
+namespace
+{
+  /// \brief Add the percentiles of a histogram to a statistics group.
+  /// msgs::Statistic has no percentile type, so the statistics are
+  /// identified by name only.
+  /// \param[in] _hist Histogram (microseconds).
+  /// \param[in] _prefix Prefix of the statistic names.
+  /// \param[in] _group Group to populate, in milliseconds.
+  void FillPercentiles(const LatencyHistogram &_hist,
+    const std::string &_prefix, msgs::StatisticsGroup *_group)
+  {
+    static const std::pair<double, const char *> kPercentiles[] =
+      {{50.0, "p50_"}, {99.0, "p99_"}, {99.9, "p999_"}};
+
+    for (const auto &[percentile, name] : kPercentiles)
+    {
+      msgs::Statistic *stat = _group->add_statistics();
+      stat->set_type(msgs::Statistic::UNINITIALIZED);
+      stat->set_name(name + _prefix);
+      stat->set_value(
+        static_cast<double>(_hist.Percentile(percentile)) / 1000.0);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram::LatencyHistogram()
+  : buckets(new std::atomic<uint64_t>[kBucketCount])
+{
+  this->Reset();
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram::LatencyHistogram(const LatencyHistogram &_other)
+  : buckets(new std::atomic<uint64_t>[kBucketCount])
+{
+  *this = _other;
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram &LatencyHistogram::operator=(const LatencyHistogram &_other)
+{
+  if (this == &_other)
+    return *this;
+
+  for (std::size_t i = 0; i < kBucketCount; ++i)
+  {
+    this->buckets[i].store(_other.buckets[i].load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  }
+  this->count.store(_other.count.load(std::memory_order_relaxed),
+    std::memory_order_relaxed);
+  return *this;
+}
+
+//////////////////////////////////////////////////
+void LatencyHistogram::Record(uint64_t _value)
+{
+  this->buckets[BucketIndex(_value)].fetch_add(1, std::memory_order_relaxed);
+  this->count.fetch_add(1, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t LatencyHistogram::Count() const
+{
+  return this->count.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+uint64_t LatencyHistogram::Percentile(double _percentile) const
+{
+  // Take a snapshot of the buckets, so the total matches the bucket counts
+  // even if samples are recorded concurrently.
+  uint64_t total = 0;
+  std::vector<uint64_t> snapshot(kBucketCount);
+  for (std::size_t i = 0; i < kBucketCount; ++i)
+  {
+    snapshot[i] = this->buckets[i].load(std::memory_order_relaxed);
+    total += snapshot[i];
+  }
+
+  if (total == 0)
+    return 0;
+
+  const double percentile = std::clamp(_percentile, 0.0, 100.0);
+  uint64_t rank = static_cast<uint64_t>(
+    std::ceil(percentile / 100.0 * static_cast<double>(total)));
+  rank = std::clamp<uint64_t>(rank, 1u, total);
+
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < kBucketCount; ++i)
+  {
+    seen += snapshot[i];
+    if (seen >= rank)
+      return BucketValue(i);
+  }
+
+  return BucketValue(kBucketCount - 1);
+}
+
+//////////////////////////////////////////////////
+void LatencyHistogram::Reset()
+{
+  for (std::size_t i = 0; i < kBucketCount; ++i)
+    this->buckets[i].store(0, std::memory_order_relaxed);
+  this->count.store(0, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+std::size_t LatencyHistogram::BucketIndex(uint64_t _value)
+{
+  constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+  constexpr uint64_t kMaxValue = (uint64_t(1) << kMaxValueBits) - 1;
+
+  const uint64_t value = std::min(_value, kMaxValue);
+  if (value < kSubBuckets)
+    return static_cast<std::size_t>(value);
+
+  // Position of the most significant bit.
+  unsigned int msb = kSubBucketBits;
+  while ((value >> (msb + 1)) != 0)
+    ++msb;
+
+  // Keep the kSubBucketBits bits that follow the most significant one.
+  const unsigned int shift = msb - kSubBucketBits;
+  const uint64_t top = value >> shift;
+  return static_cast<std::size_t>(
+    ((shift + 1) << kSubBucketBits) + (top - kSubBuckets));
+}
+
+//////////////////////////////////////////////////
+uint64_t LatencyHistogram::BucketValue(std::size_t _index)
+{
+  constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+
+  // The first two ranges of buckets hold a single value each.
+  if (_index < 2 * kSubBuckets)
+    return _index;
+
+  const unsigned int shift =
+    static_cast<unsigned int>(_index >> kSubBucketBits) - 1;
+  const uint64_t top = kSubBuckets + (_index & (kSubBuckets - 1));
+  const uint64_t lower = top << shift;
+  return lower + ((uint64_t(1) << shift) >> 1);
+}
+
 //////////////////////////////////////////////////
 void Statistics::Update(double _stat)
 {
@@ -139,18 +318,43 @@ TopicStatistics::~TopicStatistics()
 void TopicStatistics::Update(const std::string &_sender,
     uint64_t _stamp, uint64_t _seq)
 {
-  // Current wall time
-  uint64_t now =
-    std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()).count();
+  this->Update(_sender,
+    std::chrono::steady_clock::time_point(std::chrono::milliseconds(_stamp)),
+    _seq, std::chrono::steady_clock::now());
+}
 
-  if (this->dataPtr->prevPublicationStamp != 0)
+//////////////////////////////////////////////////
+void TopicStatistics::Update(const std::string &_sender,
+    std::chrono::steady_clock::time_point _published, uint64_t _seq,
+    std::chrono::steady_clock::time_point _received)
+{
+  const uint64_t pubUs = static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      _published.time_since_epoch()).count());
+  const uint64_t nowUs = static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      _received.time_since_epoch()).count());
+
+  if (this->dataPtr->prevPublicationStampUs != 0)
   {
-    this->dataPtr->publication.Update(static_cast<double>(_stamp -
-        this->dataPtr->prevPublicationStamp));
-    this->dataPtr->reception.Update(static_cast<double>(now -
-          this->dataPtr->prevReceptionStamp));
-    this->dataPtr->age.Update(static_cast<double>(now - _stamp));
+    const uint64_t receptionUs = nowUs - this->dataPtr->prevReceptionStampUs;
+    const uint64_t ageUs = nowUs >= pubUs ? nowUs - pubUs : 0u;
+
+    // The publication stamps go backwards when the clock of the publisher
+    // is stepped or its offset estimate changes. Skip that period.
+    if (pubUs >= this->dataPtr->prevPublicationStampUs)
+    {
+      const uint64_t periodUs =
+        pubUs - this->dataPtr->prevPublicationStampUs;
+      this->dataPtr->publication.Update(static_cast<double>(periodUs) / 1e3);
+      this->dataPtr->publicationHist.Record(periodUs);
+    }
+
+    this->dataPtr->reception.Update(static_cast<double>(receptionUs) / 1e3);
+    this->dataPtr->age.Update(static_cast<double>(ageUs) / 1e3);
+
+    this->dataPtr->receptionHist.Record(receptionUs);
+    this->dataPtr->ageHist.Record(ageUs);
 
     if (this->dataPtr->seq[_sender] + 1 != _seq)
     {
@@ -158,12 +362,41 @@ void TopicStatistics::Update(const std::string &_sender,
     }
   }
 
-  this->dataPtr->prevPublicationStamp = _stamp;
-  this->dataPtr->prevReceptionStamp = now;
+  this->dataPtr->prevPublicationStampUs = pubUs;
+  this->dataPtr->prevReceptionStampUs = nowUs;
 
   this->dataPtr->seq[_sender] = _seq;
 }
 
+//////////////////////////////////////////////////
+void TopicStatistics::Update(const std::string &_sender,
+    std::chrono::steady_clock::time_point _published, uint64_t _seq,
+    std::chrono::steady_clock::time_point _arrived,
+    std::chrono::steady_clock::time_point _received)
+{
+  // Like the age, the first publication only sets the reference times.
+  if (this->dataPtr->prevPublicationStampUs != 0)
+  {
+    const int64_t transitUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        _arrived - _published).count();
+    const int64_t queueingUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+        _received - _arrived).count();
+    const uint64_t transit = static_cast<uint64_t>(std::max<int64_t>(
+      transitUs, 0));
+    const uint64_t queueing = static_cast<uint64_t>(std::max<int64_t>(
+      queueingUs, 0));
+
+    this->dataPtr->transit.Update(static_cast<double>(transit) / 1e3);
+    this->dataPtr->queueing.Update(static_cast<double>(queueing) / 1e3);
+    this->dataPtr->transitHist.Record(transit);
+    this->dataPtr->queueingHist.Record(queueing);
+  }
+
+  this->Update(_sender, _published, _seq, _received);
+}
+
 //////////////////////////////////////////////////
 void TopicStatistics::FillMessage(msgs::Metric &_msg) const
 {
@@ -195,6 +428,7 @@ void TopicStatistics::FillMessage(msgs::Metric &_msg) const
   stat->set_type(msgs::Statistic::STDDEV);
   stat->set_name("period_standard_devation");
   stat->set_value(this->dataPtr->publication.StdDev());
+  FillPercentiles(this->dataPtr->publicationHist, "period", statGroup);
 
   // Reception statistics
   statGroup = _msg.add_statistics_groups();
@@ -219,6 +453,7 @@ void TopicStatistics::FillMessage(msgs::Metric &_msg) const
   stat->set_type(msgs::Statistic::STDDEV);
   stat->set_name("period_standard_devation");
   stat->set_value(this->dataPtr->reception.StdDev());
+  FillPercentiles(this->dataPtr->receptionHist, "period", statGroup);
 
   // Age statistics
   statGroup = _msg.add_statistics_groups();
@@ -243,6 +478,46 @@ void TopicStatistics::FillMessage(msgs::Metric &_msg) const
   stat->set_type(msgs::Statistic::STDDEV);
   stat->set_name("age_standard_devation");
   stat->set_value(this->dataPtr->age.StdDev());
+  FillPercentiles(this->dataPtr->ageHist, "age", statGroup);
+
+  // Transit and queueing statistics, only known for some publications.
+  const std::tuple<const char *, const char *, const Statistics *,
+    const LatencyHistogram *> kSplit[] =
+  {
+    {"transit_statistics", "transit", &this->dataPtr->transit,
+      &this->dataPtr->transitHist},
+    {"queueing_statistics", "queueing", &this->dataPtr->queueing,
+      &this->dataPtr->queueingHist},
+  };
+  for (const auto &[groupName, name, stats, hist] : kSplit)
+  {
+    if (stats->Count() == 0)
+      continue;
+
+    statGroup = _msg.add_statistics_groups();
+    statGroup->set_name(groupName);
+
+    stat = statGroup->add_statistics();
+    stat->set_type(msgs::Statistic::AVERAGE);
+    stat->set_name(std::string("avg_") + name);
+    stat->set_value(stats->Avg());
+
+    stat = statGroup->add_statistics();
+    stat->set_type(msgs::Statistic::MINIMUM);
+    stat->set_name(std::string("min_") + name);
+    stat->set_value(stats->Min());
+
+    stat = statGroup->add_statistics();
+    stat->set_type(msgs::Statistic::MAXIMUM);
+    stat->set_name(std::string("max_") + name);
+    stat->set_value(stats->Max());
+
+    stat = statGroup->add_statistics();
+    stat->set_type(msgs::Statistic::STDDEV);
+    stat->set_name(std::string(name) + "_standard_deviation");
+    stat->set_value(stats->StdDev());
+    FillPercentiles(*hist, name, statGroup);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -251,6 +526,12 @@ uint64_t TopicStatistics::DroppedMsgCount() const
   return this->dataPtr->droppedMsgCount;
 }
 
+//////////////////////////////////////////////////
+void TopicStatistics::AddDroppedMsgs(uint64_t _count)
+{
+  this->dataPtr->droppedMsgCount += _count;
+}
+
 //////////////////////////////////////////////////
 Statistics TopicStatistics::PublicationStatistics() const
 {
@@ -268,3 +549,260 @@ Statistics TopicStatistics::AgeStatistics() const
 {
   return this->dataPtr->age;
 }
+
+//////////////////////////////////////////////////
+LatencyHistogram TopicStatistics::PublicationHistogram() const
+{
+  return this->dataPtr->publicationHist;
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram TopicStatistics::ReceptionHistogram() const
+{
+  return this->dataPtr->receptionHist;
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram TopicStatistics::AgeHistogram() const
+{
+  return this->dataPtr->ageHist;
+}
+
+//////////////////////////////////////////////////
+Statistics TopicStatistics::TransitStatistics() const
+{
+  return this->dataPtr->transit;
+}
+
+//////////////////////////////////////////////////
+Statistics TopicStatistics::QueueingStatistics() const
+{
+  return this->dataPtr->queueing;
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram TopicStatistics::TransitHistogram() const
+{
+  return this->dataPtr->transitHist;
+}
+
+//////////////////////////////////////////////////
+LatencyHistogram TopicStatistics::QueueingHistogram() const
+{
+  return this->dataPtr->queueingHist;
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::PublicationCount() const
+{
+  return this->publications;
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::UnsubscribedCount() const
+{
+  return this->unsubscribed;
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::SerializationCount() const
+{
+  return this->serializations;
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PublisherStatistics::SerializationTime() const
+{
+  return std::chrono::nanoseconds(this->serializationNs);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PublisherStatistics::MaxSerializationTime() const
+{
+  return std::chrono::nanoseconds(this->maxSerializationNs);
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::Bytes() const
+{
+  return this->bytes;
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::SendFailureCount() const
+{
+  return this->sendFailures;
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::QueuedCount() const
+{
+  return this->queued;
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PublisherStatistics::QueueWaitTime() const
+{
+  return std::chrono::nanoseconds(this->queueWaitNs);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds PublisherStatistics::MaxQueueWaitTime() const
+{
+  return std::chrono::nanoseconds(this->maxQueueWaitNs);
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::RealTimeDropCount() const
+{
+  return this->realTimeDropped;
+}
+
+//////////////////////////////////////////////////
+uint64_t PublisherStatistics::RateLimitedCount() const
+{
+  return this->rateLimited;
+}
+
+//////////////////////////////////////////////////
+void PublisherStatistics::FillMessage(msgs::Metric &_msg) const
+{
+  _msg.set_unit("milliseconds");
+
+  auto addStat = [](msgs::StatisticsGroup *_group,
+    msgs::Statistic::DataType _type, const std::string &_name, double _value)
+  {
+    msgs::Statistic *stat = _group->add_statistics();
+    stat->set_type(_type);
+    stat->set_name(_name);
+    stat->set_value(_value);
+  };
+
+  auto average = [](uint64_t _sum, uint64_t _count)
+  {
+    return _count == 0 ? 0.0 :
+      static_cast<double>(_sum) / static_cast<double>(_count);
+  };
+
+  msgs::StatisticsGroup *group = _msg.add_statistics_groups();
+  group->set_name("publication_statistics");
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "publication_count",
+    static_cast<double>(this->publications));
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "unsubscribed_count",
+    static_cast<double>(this->unsubscribed));
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "send_failure_count",
+    static_cast<double>(this->sendFailures));
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "real_time_drop_count",
+    static_cast<double>(this->realTimeDropped));
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "rate_limited_count",
+    static_cast<double>(this->rateLimited));
+  addStat(group, msgs::Statistic::AVERAGE, "avg_bytes",
+    average(this->bytes, this->publications));
+
+  group = _msg.add_statistics_groups();
+  group->set_name("serialization_statistics");
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "serialization_count",
+    static_cast<double>(this->serializations));
+  addStat(group, msgs::Statistic::AVERAGE, "avg_time",
+    average(this->serializationNs, this->serializations) / 1e6);
+  addStat(group, msgs::Statistic::MAXIMUM, "max_time",
+    static_cast<double>(this->maxSerializationNs) / 1e6);
+
+  group = _msg.add_statistics_groups();
+  group->set_name("queue_statistics");
+  addStat(group, msgs::Statistic::SAMPLE_COUNT, "queued_count",
+    static_cast<double>(this->queued));
+  addStat(group, msgs::Statistic::AVERAGE, "avg_wait",
+    average(this->queueWaitNs, this->queued) / 1e6);
+  addStat(group, msgs::Statistic::MAXIMUM, "max_wait",
+    static_cast<double>(this->maxQueueWaitNs) / 1e6);
+}
+
+//////////////////////////////////////////////////
+const std::string &CallbackProfile::Topic() const
+{
+  return this->topic;
+}
+
+//////////////////////////////////////////////////
+const std::string &CallbackProfile::NodeUuid() const
+{
+  return this->nodeUuid;
+}
+
+//////////////////////////////////////////////////
+const std::string &CallbackProfile::HandlerUuid() const
+{
+  return this->handlerUuid;
+}
+
+//////////////////////////////////////////////////
+uint64_t CallbackProfile::CallCount() const
+{
+  return this->calls;
+}
+
+//////////////////////////////////////////////////
+uint64_t CallbackProfile::OverrunCount() const
+{
+  return this->overruns;
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds CallbackProfile::TotalTime() const
+{
+  return std::chrono::nanoseconds(this->totalNs);
+}
+
+//////////////////////////////////////////////////
+std::chrono::nanoseconds CallbackProfile::MaxTime() const
+{
+  return std::chrono::nanoseconds(this->maxNs);
+}
+
+//////////////////////////////////////////////////
+const LatencyHistogram &CallbackProfile::Durations() const
+{
+  return this->durations;
+}
+
+//////////////////////////////////////////////////
+void CallbackProfile::FillMessage(msgs::StatisticsGroup &_group) const
+{
+  _group.set_name("callback_statistics");
+
+  auto addData = [&_group](const std::string &_key,
+    const std::string &_value)
+  {
+    msgs::Header::Map *data = _group.mutable_header()->add_data();
+    data->set_key(_key);
+    data->add_value(_value);
+  };
+  addData("topic", this->topic);
+  addData("node_uuid", this->nodeUuid);
+  addData("handler_uuid", this->handlerUuid);
+
+  auto addStat = [&_group](msgs::Statistic::DataType _type,
+    const std::string &_name, double _value)
+  {
+    msgs::Statistic *stat = _group.add_statistics();
+    stat->set_type(_type);
+    stat->set_name(_name);
+    stat->set_value(_value);
+  };
+
+  const double avgMs = this->calls == 0 ? 0.0 :
+    static_cast<double>(this->totalNs) / static_cast<double>(this->calls) /
+    1e6;
+  addStat(msgs::Statistic::SAMPLE_COUNT, "call_count",
+    static_cast<double>(this->calls));
+  addStat(msgs::Statistic::SAMPLE_COUNT, "overrun_count",
+    static_cast<double>(this->overruns));
+  addStat(msgs::Statistic::AVERAGE, "avg_time", avgMs);
+  addStat(msgs::Statistic::MAXIMUM, "max_time",
+    static_cast<double>(this->maxNs) / 1e6);
+  addStat(msgs::Statistic::UNINITIALIZED, "p50_time",
+    static_cast<double>(this->durations.Percentile(50)) / 1e3);
+  addStat(msgs::Statistic::UNINITIALIZED, "p99_time",
+    static_cast<double>(this->durations.Percentile(99)) / 1e3);
+}
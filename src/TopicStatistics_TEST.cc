@@ -15,6 +15,8 @@
  *
 */
 
+#include <chrono>
+
 #include "gtest/gtest.h"
 #include "gz/transport/TopicStatistics.hh"
 
@@ -63,6 +65,12 @@ TEST(TopicsStatistics, DroppedMsg)
 
   topicStats.Update("foo", 5, 6);
   EXPECT_EQ(2u, topicStats.DroppedMsgCount());
+
+  // Messages dropped by the process itself.
+  topicStats.AddDroppedMsgs(3u);
+  EXPECT_EQ(5u, topicStats.DroppedMsgCount());
+  TopicStatistics copy(topicStats);
+  EXPECT_EQ(5u, copy.DroppedMsgCount());
 }
 
 //////////////////////////////////////////////////
@@ -101,3 +109,199 @@ TEST(TopicsStatistics, AvgStdDev)
   EXPECT_DOUBLE_EQ(2.0, stats.Avg());
   EXPECT_NEAR(0.816, stats.StdDev(), 1e-3);
 }
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, HistogramEmpty)
+{
+  LatencyHistogram hist;
+  EXPECT_EQ(0u, hist.Count());
+  EXPECT_EQ(0u, hist.Percentile(50));
+  EXPECT_EQ(0u, hist.Percentile(99.9));
+}
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, HistogramPercentiles)
+{
+  LatencyHistogram hist;
+
+  // Small values are exact.
+  for (uint64_t i = 1; i <= 10; ++i)
+    hist.Record(i);
+  EXPECT_EQ(10u, hist.Count());
+  EXPECT_EQ(5u, hist.Percentile(50));
+  EXPECT_EQ(10u, hist.Percentile(100));
+  EXPECT_EQ(1u, hist.Percentile(0));
+
+  // Large values keep a bounded relative error.
+  hist.Reset();
+  EXPECT_EQ(0u, hist.Count());
+  for (uint64_t i = 1; i <= 100000; ++i)
+    hist.Record(i * 10);
+  const double maxError = 1.0 / (1u << LatencyHistogram::kSubBucketBits);
+  EXPECT_NEAR(500000.0, static_cast<double>(hist.Percentile(50)),
+    500000.0 * maxError);
+  EXPECT_NEAR(990000.0, static_cast<double>(hist.Percentile(99)),
+    990000.0 * maxError);
+  EXPECT_NEAR(999000.0, static_cast<double>(hist.Percentile(99.9)),
+    999000.0 * maxError);
+
+  // Values out of range are clamped.
+  LatencyHistogram outliers;
+  outliers.Record(std::numeric_limits<uint64_t>::max());
+  EXPECT_GT(outliers.Percentile(50),
+    uint64_t(1) << (LatencyHistogram::kMaxValueBits - 1));
+
+  // Copies are independent.
+  LatencyHistogram copy(hist);
+  hist.Reset();
+  EXPECT_EQ(100000u, copy.Count());
+  EXPECT_EQ(0u, hist.Count());
+  hist = copy;
+  EXPECT_EQ(copy.Percentile(99), hist.Percentile(99));
+}
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, HistogramFillMessage)
+{
+  TopicStatistics topicStats;
+  for (uint64_t i = 0; i < 10; ++i)
+    topicStats.Update("foo", 10 * (i + 1), i);
+
+  EXPECT_EQ(9u, topicStats.PublicationHistogram().Count());
+  EXPECT_EQ(9u, topicStats.ReceptionHistogram().Count());
+  EXPECT_EQ(9u, topicStats.AgeHistogram().Count());
+  const double maxError = 1.0 / (1u << LatencyHistogram::kSubBucketBits);
+  EXPECT_NEAR(10000.0, static_cast<double>(
+    topicStats.PublicationHistogram().Percentile(99)), 10000.0 * maxError);
+
+  msgs::Metric msg;
+  topicStats.FillMessage(msg);
+  ASSERT_EQ(3, msg.statistics_groups_size());
+  bool found = false;
+  for (const auto &stat : msg.statistics_groups(0).statistics())
+  {
+    if (stat.name() == "p99_period")
+    {
+      found = true;
+      EXPECT_NEAR(10.0, stat.value(), 10.0 * maxError);
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, ReceptionTime)
+{
+  // Samples aggregated later keep their reception time.
+  TopicStatistics topicStats;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < 5; ++i)
+  {
+    topicStats.Update("foo",
+      std::chrono::steady_clock::time_point(
+        std::chrono::milliseconds(10 * (i + 1))), i,
+      start + std::chrono::milliseconds(20 * i));
+  }
+
+  EXPECT_EQ(0u, topicStats.DroppedMsgCount());
+  EXPECT_EQ(4u, topicStats.ReceptionStatistics().Count());
+  EXPECT_DOUBLE_EQ(20.0, topicStats.ReceptionStatistics().Avg());
+  EXPECT_DOUBLE_EQ(10.0, topicStats.PublicationStatistics().Avg());
+}
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, StampGoesBackwards)
+{
+  // A publication stamp older than the previous one, e.g. after a clock
+  // step, doesn't produce a publication period.
+  TopicStatistics topicStats;
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t stampsMs[] = {100, 110, 50, 60};
+  for (uint64_t i = 0; i < 4; ++i)
+  {
+    topicStats.Update("foo",
+      std::chrono::steady_clock::time_point(
+        std::chrono::milliseconds(stampsMs[i])), i,
+      start + std::chrono::milliseconds(10 * i));
+  }
+
+  EXPECT_EQ(0u, topicStats.DroppedMsgCount());
+  EXPECT_EQ(2u, topicStats.PublicationStatistics().Count());
+  EXPECT_DOUBLE_EQ(10.0, topicStats.PublicationStatistics().Max());
+  EXPECT_EQ(3u, topicStats.ReceptionStatistics().Count());
+}
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, TransitQueueing)
+{
+  // Without an arrival time, the age isn't split.
+  TopicStatistics topicStats;
+  const auto start = std::chrono::steady_clock::now();
+  topicStats.Update("foo", start, 0, start + std::chrono::milliseconds(1));
+  topicStats.Update("foo", start, 1, start + std::chrono::milliseconds(1));
+  EXPECT_EQ(0u, topicStats.TransitStatistics().Count());
+
+  msgs::Metric msg;
+  topicStats.FillMessage(msg);
+  EXPECT_EQ(3, msg.statistics_groups_size());
+
+  // Each publication travels 2 ms and waits 1 ms in this process.
+  for (uint64_t i = 2; i < 6; ++i)
+  {
+    const auto published = start + std::chrono::milliseconds(10 * i);
+    topicStats.Update("foo", published, i,
+      published + std::chrono::milliseconds(2),
+      published + std::chrono::milliseconds(3));
+  }
+
+  EXPECT_EQ(4u, topicStats.TransitStatistics().Count());
+  EXPECT_DOUBLE_EQ(2.0, topicStats.TransitStatistics().Avg());
+  EXPECT_DOUBLE_EQ(1.0, topicStats.QueueingStatistics().Avg());
+  EXPECT_DOUBLE_EQ(0.0, topicStats.QueueingStatistics().StdDev());
+  EXPECT_EQ(5u, topicStats.AgeStatistics().Count());
+  EXPECT_EQ(4u, topicStats.TransitHistogram().Count());
+  const double maxError = 1.0 / (1u << LatencyHistogram::kSubBucketBits);
+  EXPECT_NEAR(1000.0,
+    static_cast<double>(topicStats.QueueingHistogram().Percentile(50)),
+    1000.0 * maxError);
+
+  msg.Clear();
+  topicStats.FillMessage(msg);
+  ASSERT_EQ(5, msg.statistics_groups_size());
+  EXPECT_EQ("transit_statistics", msg.statistics_groups(3).name());
+  EXPECT_EQ("queueing_statistics", msg.statistics_groups(4).name());
+  EXPECT_DOUBLE_EQ(2.0, msg.statistics_groups(3).statistics(0).value());
+
+  // An arrival before the publication, e.g. with a clock error, counts as
+  // no transit time.
+  const auto published = start + std::chrono::milliseconds(100);
+  topicStats.Update("foo", published, 6,
+    published - std::chrono::milliseconds(1), published);
+  EXPECT_DOUBLE_EQ(0.0, topicStats.TransitStatistics().Min());
+
+  // The copies keep the split.
+  TopicStatistics copy(topicStats);
+  EXPECT_EQ(5u, copy.QueueingStatistics().Count());
+}
+
+//////////////////////////////////////////////////
+TEST(TopicsStatistics, PublisherStatisticsFillMessage)
+{
+  PublisherStatistics stats;
+  EXPECT_EQ(0u, stats.PublicationCount());
+  EXPECT_EQ(0u, stats.SendFailureCount());
+  EXPECT_EQ(std::chrono::nanoseconds(0), stats.QueueWaitTime());
+  EXPECT_EQ(0u, stats.RealTimeDropCount());
+  EXPECT_EQ(0u, stats.RateLimitedCount());
+
+  msgs::Metric msg;
+  stats.FillMessage(msg);
+  ASSERT_EQ(3, msg.statistics_groups_size());
+  EXPECT_EQ("publication_statistics", msg.statistics_groups(0).name());
+  EXPECT_EQ("serialization_statistics", msg.statistics_groups(1).name());
+  EXPECT_EQ("queue_statistics", msg.statistics_groups(2).name());
+
+  // Averages without samples are zero.
+  for (const auto &stat : msg.statistics_groups(1).statistics())
+    EXPECT_DOUBLE_EQ(0.0, stat.value());
+}
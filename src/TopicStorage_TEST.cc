@@ -484,6 +484,96 @@ TEST(TopicStorageTest, PublishersByNode)
   EXPECT_EQ(pubs.at(0).Addr(), g_addr1);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check VisitPublishers().
+TEST(TopicStorageTest, VisitPublishers)
+{
+  init();
+
+  Publisher publisher1(g_topic1, g_addr1, g_pUuid1, g_nUuid1, g_opts1);
+  Publisher publisher2(g_topic1, g_addr1, g_pUuid1, g_nUuid2, g_opts2);
+  Publisher publisher3(g_topic1, g_addr2, g_pUuid2, g_nUuid3, g_opts3);
+
+  TopicStorage<Publisher> test;
+  EXPECT_TRUE(test.AddPublisher(publisher1));
+  EXPECT_TRUE(test.AddPublisher(publisher2));
+  EXPECT_TRUE(test.AddPublisher(publisher3));
+
+  std::vector<std::string> nodes;
+  auto visitor = [&nodes](const Publisher &_pub)
+  {
+    nodes.push_back(_pub.NUuid());
+  };
+
+  EXPECT_FALSE(test.VisitPublishers(g_topic2, visitor));
+  EXPECT_TRUE(nodes.empty());
+
+  EXPECT_TRUE(test.VisitPublishers(g_topic1, visitor));
+  EXPECT_EQ((std::vector<std::string>{g_nUuid1, g_nUuid2, g_nUuid3}), nodes);
+
+  nodes.clear();
+  EXPECT_FALSE(test.VisitPublishers(g_topic1, "unknown_puuid", visitor));
+  EXPECT_TRUE(test.VisitPublishers(g_topic1, g_pUuid2, visitor));
+  EXPECT_EQ(std::vector<std::string>{g_nUuid3}, nodes);
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the process, node and address indexes follow the
+/// removals.
+TEST(TopicStorageTest, Indexes)
+{
+  init();
+
+  Publisher publisher1(g_topic1, g_addr1, g_pUuid1, g_nUuid1, g_opts1);
+  Publisher publisher2(g_topic2, g_addr1, g_pUuid1, g_nUuid1, g_opts1);
+  Publisher publisher3(g_topic1, g_addr1, g_pUuid1, g_nUuid2, g_opts2);
+  Publisher publisher4(g_topic2, g_addr2, g_pUuid2, g_nUuid3, g_opts3);
+
+  TopicStorage<Publisher> test;
+  EXPECT_TRUE(test.AddPublisher(publisher1));
+  EXPECT_TRUE(test.AddPublisher(publisher2));
+  EXPECT_TRUE(test.AddPublisher(publisher3));
+  EXPECT_TRUE(test.AddPublisher(publisher4));
+
+  std::vector<Publisher> pubs;
+  test.PublishersByNode(g_pUuid1, g_nUuid1, pubs);
+  ASSERT_EQ(2u, pubs.size());
+  EXPECT_EQ(g_topic1, pubs.at(0).Topic());
+  EXPECT_EQ(g_topic2, pubs.at(1).Topic());
+
+  // The address is still used by other publishers.
+  EXPECT_TRUE(test.DelPublisherByNode(g_topic1, g_pUuid1, g_nUuid1));
+  EXPECT_FALSE(test.DelPublisherByNode(g_topic1, g_pUuid1, g_nUuid1));
+  EXPECT_TRUE(test.HasPublisher(g_addr1));
+  test.PublishersByNode(g_pUuid1, g_nUuid1, pubs);
+  ASSERT_EQ(1u, pubs.size());
+  EXPECT_EQ(g_topic2, pubs.at(0).Topic());
+
+  // Removing the process only touches its own topics.
+  EXPECT_TRUE(test.DelPublishersByProc(g_pUuid1));
+  EXPECT_FALSE(test.DelPublishersByProc(g_pUuid1));
+  EXPECT_FALSE(test.HasPublisher(g_addr1));
+  EXPECT_TRUE(test.HasPublisher(g_addr2));
+  EXPECT_FALSE(test.HasTopic(g_topic1));
+  EXPECT_TRUE(test.HasAnyPublishers(g_topic2, g_pUuid2));
+
+  std::map<std::string, std::vector<Publisher>> procPubs;
+  test.PublishersByProc(g_pUuid1, procPubs);
+  EXPECT_TRUE(procPubs.empty());
+  test.PublishersByProc(g_pUuid2, procPubs);
+  ASSERT_EQ(1u, procPubs.size());
+  EXPECT_EQ(g_addr2, procPubs[g_nUuid3].at(0).Addr());
+
+  // A publisher can be added again after its removal.
+  EXPECT_TRUE(test.AddPublisher(publisher1));
+  EXPECT_TRUE(test.HasPublisher(g_addr1));
+
+  test.Clear();
+  EXPECT_FALSE(test.HasPublisher(g_addr1));
+  test.PublishersByProc(g_pUuid2, procPubs);
+  EXPECT_TRUE(procPubs.empty());
+}
+
 //////////////////////////////////////////////////
 /// \brief Check HasTopic(<topic>, <type>).
 TEST(TopicStorageTest, HasTopicWithType)
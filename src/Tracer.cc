@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "gz/transport/Helpers.hh"
+
+#include "Tracer.hh"
+
+using namespace gz;
+using namespace transport;
+
+namespace
+{
+  /// \brief Trace of the publication processed by the current thread.
+  thread_local TraceMetadata tCurrent;
+
+  /// \brief Small ID of the current thread, easier to read than the native
+  /// one in the trace viewers.
+  /// \return The thread ID.
+  unsigned int ThreadId()
+  {
+    static std::atomic<unsigned int> next{1};
+    thread_local const unsigned int tid = next++;
+    return tid;
+  }
+
+  /// \brief Escape a string for JSON.
+  /// \param[in] _value The string.
+  /// \return The escaped string.
+  std::string EscapeJson(const std::string &_value)
+  {
+    std::string escaped;
+    escaped.reserve(_value.size());
+    for (const char c : _value)
+    {
+      if (c == '"' || c == '\\')
+      {
+        escaped += '\\';
+        escaped += c;
+      }
+      else if (static_cast<unsigned char>(c) < 0x20)
+      {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+        escaped += buffer;
+      }
+      else
+      {
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
+
+  /// \brief Format a trace ID.
+  /// \param[in] _traceId Trace ID.
+  /// \return Hexadecimal trace ID.
+  std::string TraceIdStr(uint64_t _traceId)
+  {
+    char buffer[24];
+    std::snprintf(buffer, sizeof(buffer), "0x%016llx",
+      static_cast<unsigned long long>(_traceId));  // NOLINT(runtime/int)
+    return buffer;
+  }
+}
+
+//////////////////////////////////////////////////
+Tracer &Tracer::Instance()
+{
+  // Never destroyed, the transport threads may still trace at exit. The
+  // trace is completed at exit instead.
+  static Tracer *instance = []()
+  {
+    Tracer *tracer = new Tracer();
+    std::atexit([]() {Tracer::Instance().Close();});
+    return tracer;
+  }();
+  return *instance;
+}
+
+//////////////////////////////////////////////////
+Tracer::Tracer()
+  : pid(getProcessId())
+{
+  std::random_device rd;
+  this->idSeed = (static_cast<uint64_t>(rd()) << 32) ^ rd() ^
+    (static_cast<uint64_t>(this->pid) << 16);
+
+  std::string path;
+  if (env("GZ_TRANSPORT_TRACE", path) && !path.empty())
+    this->Open(path);
+}
+
+//////////////////////////////////////////////////
+Tracer::~Tracer()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool Tracer::Open(const std::string &_path)
+{
+  this->Close();
+
+  std::string path = _path;
+  const std::string pidStr = std::to_string(this->pid);
+  for (auto pos = path.find("%p"); pos != std::string::npos;
+       pos = path.find("%p", pos + pidStr.size()))
+  {
+    path.replace(pos, 2, pidStr);
+  }
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->file.open(path, std::ios::out | std::ios::trunc);
+  if (!this->file.is_open())
+  {
+    std::cerr << "Unable to create the trace file [" << path << "]"
+              << std::endl;
+    return false;
+  }
+
+  this->file << "[\n";
+  this->first = true;
+  this->Write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" +
+    pidStr + ",\"args\":{\"name\":\"gz-transport " + pidStr + "\"}}");
+  this->enabled = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Tracer::Close()
+{
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->enabled = false;
+  if (!this->file.is_open())
+    return;
+
+  this->file << "\n]\n";
+  this->file.close();
+}
+
+//////////////////////////////////////////////////
+uint64_t Tracer::Now()
+{
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+//////////////////////////////////////////////////
+uint64_t Tracer::NewTraceId()
+{
+  uint64_t id = 0;
+  while (id == 0)
+    id = this->idSeed + this->nextId++;
+  return id;
+}
+
+//////////////////////////////////////////////////
+void Tracer::Span(const char *_name, const std::string &_topic,
+  uint64_t _traceId, uint64_t _start, uint64_t _end)
+{
+  if (!this->Enabled())
+    return;
+
+  std::ostringstream event;
+  event << "{\"name\":\"" << _name << "\",\"cat\":\"gz-transport\","
+        << "\"ph\":\"X\",\"ts\":" << _start << ",\"dur\":"
+        << (_end > _start ? _end - _start : 0) << ",\"pid\":" << this->pid
+        << ",\"tid\":" << ThreadId() << ",\"args\":{\"topic\":\""
+        << EscapeJson(_topic) << "\",\"trace_id\":\""
+        << TraceIdStr(_traceId) << "\"}}";
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->Write(event.str());
+}
+
+//////////////////////////////////////////////////
+void Tracer::Flow(bool _start, uint64_t _traceId, uint64_t _stamp)
+{
+  if (!this->Enabled())
+    return;
+
+  std::ostringstream event;
+  event << "{\"name\":\"publication\",\"cat\":\"gz-transport\",\"ph\":\""
+        << (_start ? "s" : "f\",\"bp\":\"e") << "\",\"id\":\""
+        << TraceIdStr(_traceId) << "\",\"ts\":" << _stamp << ",\"pid\":"
+        << this->pid << ",\"tid\":" << ThreadId() << "}";
+
+  std::lock_guard<std::mutex> lk(this->mutex);
+  this->Write(event.str());
+}
+
+//////////////////////////////////////////////////
+TraceMetadata &Tracer::Current()
+{
+  return tCurrent;
+}
+
+//////////////////////////////////////////////////
+void Tracer::Write(const std::string &_event)
+{
+  if (!this->file.is_open())
+    return;
+
+  if (!this->first)
+    this->file << ",\n";
+  this->first = false;
+  this->file << _event;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_TRACER_HH_
+#define GZ_TRANSPORT_TRACER_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "gz/transport/config.hh"
+#include "gz/transport/Export.hh"
+
+namespace gz
+{
+  namespace transport
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_TRANSPORT_VERSION_NAMESPACE {
+    //
+    /// \brief Trace of a publication, sent to the remote subscribers after
+    /// the publication metadata when tracing is enabled.
+    class TraceMetadata
+    {
+      /// \brief ID shared by all the spans of a publication, or 0 if the
+      /// publication isn't traced.
+      public: uint64_t traceId = 0;
+
+      /// \brief Time at which Node::Publisher::Publish() started (us).
+      public: uint64_t publishStamp = 0;
+
+      /// \brief Time at which the publication was handed to ZeroMQ (us).
+      public: uint64_t sendStamp = 0;
+    };
+
+    /// \brief Writes the time spent by the messages in every stage of the
+    /// transport as a Chrome trace (JSON array format), which can be opened
+    /// with Perfetto or chrome://tracing.
+    ///
+    /// Tracing is enabled by setting GZ_TRANSPORT_TRACE to the path of the
+    /// trace file. A "%p" in the path is replaced by the process ID, so
+    /// every process writes its own file. The spans of a publication share
+    /// a trace ID, carried to the remote subscribers, and flow events link
+    /// the send and the reception of a message in the merged traces. The
+    /// timestamps come from the system clock, hence the transit time
+    /// between hosts includes their clock offset.
+    class GZ_TRANSPORT_VISIBLE Tracer
+    {
+      /// \brief Get the tracer of this process.
+      /// \return The tracer.
+      public: static Tracer &Instance();
+
+      /// \brief Destructor. Closes the trace.
+      public: ~Tracer();
+
+      /// \brief No copy.
+      public: Tracer(const Tracer &) = delete;
+
+      /// \brief No assignment.
+      public: Tracer &operator=(const Tracer &) = delete;
+
+      /// \brief Whether tracing is enabled.
+      /// \return True if the spans are written.
+      public: bool Enabled() const
+      {
+        return this->enabled.load(std::memory_order_relaxed);
+      }
+
+      /// \brief Start writing a trace, closing the current one.
+      /// \param[in] _path Path of the trace file. "%p" is replaced by the
+      /// process ID.
+      /// \return False if the file can't be created.
+      public: bool Open(const std::string &_path);
+
+      /// \brief Stop tracing and complete the trace file.
+      public: void Close();
+
+      /// \brief Current time, as used in the traces.
+      /// \return Microseconds since the epoch.
+      public: static uint64_t Now();
+
+      /// \brief Create a trace ID, unique across processes with a very
+      /// high probability.
+      /// \return The trace ID, never 0.
+      public: uint64_t NewTraceId();
+
+      /// \brief Write a span.
+      /// \param[in] _name Name of the stage.
+      /// \param[in] _topic Topic of the message.
+      /// \param[in] _traceId Trace ID of the message.
+      /// \param[in] _start Start of the stage (us).
+      /// \param[in] _end End of the stage (us).
+      public: void Span(const char *_name, const std::string &_topic,
+                        uint64_t _traceId, uint64_t _start, uint64_t _end);
+
+      /// \brief Write one end of the arrow joining the send and the reception
+      /// of a message.
+      /// \param[in] _start True on the sender side.
+      /// \param[in] _traceId Trace ID of the message.
+      /// \param[in] _stamp Time of the event (us).
+      public: void Flow(bool _start, uint64_t _traceId, uint64_t _stamp);
+
+      /// \brief Trace of the publication being processed by the current
+      /// thread. Node::Publisher::Publish() sets it for NodeShared and the
+      /// reception threads set it for the subscription handlers.
+      /// \return The trace of the current thread.
+      public: static TraceMetadata &Current();
+
+      /// \brief Sets the trace of the current thread and restores the
+      /// previous one when destroyed.
+      public: class Scope
+      {
+        /// \brief Constructor.
+        /// \param[in] _trace Trace of the current thread.
+        public: explicit Scope(const TraceMetadata &_trace)
+          : previous(Current())
+        {
+          Current() = _trace;
+        }
+
+        /// \brief Destructor.
+        public: ~Scope()
+        {
+          Current() = this->previous;
+        }
+
+        /// \brief Trace before this scope.
+        private: TraceMetadata previous;
+      };
+
+      /// \brief Constructor. Opens the file of GZ_TRANSPORT_TRACE, if set.
+      private: Tracer();
+
+      /// \brief Write an event. Must be called with the mutex locked.
+      /// \param[in] _event The JSON object of the event.
+      private: void Write(const std::string &_event);
+
+      /// \brief Whether tracing is enabled.
+      private: std::atomic<bool> enabled{false};
+
+      /// \brief Protects the file.
+      private: std::mutex mutex;
+
+#ifdef _WIN32
+// Disable warning C4251 which is triggered by
+// std::ofstream
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+      /// \brief Trace file.
+      private: std::ofstream file;
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+      /// \brief Whether an event was already written to the file.
+      private: bool first = true;
+
+      /// \brief Process ID.
+      private: unsigned int pid = 0;
+
+      /// \brief Random part of the trace IDs.
+      private: uint64_t idSeed = 0;
+
+      /// \brief Counter part of the trace IDs.
+      private: std::atomic<uint64_t> nextId{1};
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gz/transport/Helpers.hh"
+#include "Tracer.hh"
+#include "gtest/gtest.h"
+
+using namespace gz;
+using namespace transport;
+
+//////////////////////////////////////////////////
+TEST(TracerTest, Current)
+{
+  EXPECT_EQ(0u, Tracer::Current().traceId);
+  {
+    TraceMetadata trace;
+    trace.traceId = 3u;
+    Tracer::Scope scope(trace);
+    EXPECT_EQ(3u, Tracer::Current().traceId);
+  }
+  EXPECT_EQ(0u, Tracer::Current().traceId);
+
+  Tracer &tracer = Tracer::Instance();
+  const uint64_t id = tracer.NewTraceId();
+  EXPECT_NE(0u, id);
+  EXPECT_NE(id, tracer.NewTraceId());
+}
+
+//////////////////////////////////////////////////
+TEST(TracerTest, ChromeTrace)
+{
+  Tracer &tracer = Tracer::Instance();
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  const std::string path = (dir / "gz_transport_trace_%p.json").string();
+  const std::string expected = (dir / ("gz_transport_trace_" +
+    std::to_string(getProcessId()) + ".json")).string();
+
+  ASSERT_TRUE(tracer.Open(path));
+  EXPECT_TRUE(tracer.Enabled());
+  tracer.Span("serialize", "/foo\"bar", 0x2a, 100, 150);
+  tracer.Flow(true, 0x2a, 120);
+  tracer.Flow(false, 0x2a, 200);
+  tracer.Close();
+  EXPECT_FALSE(tracer.Enabled());
+
+  // Nothing is written once the trace is closed.
+  tracer.Span("serialize", "/foo", 1, 1, 2);
+
+  std::ifstream file(expected);
+  ASSERT_TRUE(file.is_open());
+  std::stringstream content;
+  content << file.rdbuf();
+  const std::string text = content.str();
+
+  EXPECT_EQ(0u, text.find("[\n"));
+  EXPECT_EQ(text.size() - 3, text.rfind("\n]\n"));
+  EXPECT_NE(std::string::npos, text.find("\"ph\":\"M\""));
+  EXPECT_NE(std::string::npos, text.find(
+    "\"name\":\"serialize\",\"cat\":\"gz-transport\",\"ph\":\"X\","
+    "\"ts\":100,\"dur\":50"));
+  EXPECT_NE(std::string::npos, text.find("\"topic\":\"/foo\\\"bar\""));
+  EXPECT_NE(std::string::npos,
+    text.find("\"trace_id\":\"0x000000000000002a\""));
+  EXPECT_NE(std::string::npos, text.find("\"ph\":\"s\""));
+  EXPECT_NE(std::string::npos, text.find("\"ph\":\"f\",\"bp\":\"e\""));
+  EXPECT_EQ(std::string::npos, text.find("\"ts\":1,"));
+
+  file.close();
+  std::filesystem::remove(expected);
+}
+
+//////////////////////////////////////////////////
+TEST(TracerTest, OpenError)
+{
+  Tracer &tracer = Tracer::Instance();
+  EXPECT_FALSE(tracer.Open("/nonexistent_dir/trace.json"));
+  EXPECT_FALSE(tracer.Enabled());
+}
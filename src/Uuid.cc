@@ -15,76 +15,213 @@
  *
 */
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <random>
 #include <string>
-#include <vector>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 #include "gz/transport/Uuid.hh"
 
 using namespace gz;
 using namespace transport;
 
+namespace
+{
+  /// \brief Hexadecimal digits.
+  const char kHexDigits[] = "0123456789abcdef";
+
+  /// \brief Number of times the process was forked, so that a child doesn't
+  /// repeat the UUIDs of its parent.
+  std::atomic<uint64_t> forkGeneration{0};
+
+  //////////////////////////////////////////////////
+  /// \brief Get 128 random bits from the system UUID generator.
+  /// \param[out] _seed The random bits.
+  void systemRandom(std::array<uint32_t, 4> &_seed)
+  {
+    portable_uuid_t uuid;
 #ifdef _WIN32
-/* Windows implementation using libuuid library */
+    RPC_STATUS result = ::UuidCreate(&uuid);
+    if (result != RPC_S_OK)
+    {
+      std::cerr << "Call to UuidCreate return a non success RPC call. " <<
+                   "Return code: " << result << std::endl;
+    }
+#else
+    uuid_generate(uuid);
+#endif
+    static_assert(sizeof(uuid) == sizeof(_seed), "Unexpected UUID size");
+    std::memcpy(_seed.data(), &uuid, sizeof(_seed));
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Per-thread generator of random UUIDs. It's seeded by the
+  /// system generator, and again after a fork.
+  class Generator
+  {
+    /// \brief Fill a UUID with random bytes.
+    /// \param[out] _bytes The bytes.
+    public: void Generate(Uuid::Bytes &_bytes)
+    {
+      const uint64_t current = forkGeneration.load();
+      if (!this->seeded || current != this->generation)
+      {
+        std::array<uint32_t, 4> seed;
+        systemRandom(seed);
+        std::seed_seq seq(seed.begin(), seed.end());
+        this->engine.seed(seq);
+        this->generation = current;
+        this->seeded = true;
+      }
+
+      const uint64_t high = this->engine();
+      const uint64_t low = this->engine();
+      for (std::size_t i = 0; i < 8; ++i)
+      {
+        _bytes[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+        _bytes[8 + i] = static_cast<uint8_t>(low >> (56 - 8 * i));
+      }
+
+      // RFC 4122 version 4 (random) and variant 1.
+      _bytes[6] = static_cast<uint8_t>((_bytes[6] & 0x0F) | 0x40);
+      _bytes[8] = static_cast<uint8_t>((_bytes[8] & 0x3F) | 0x80);
+    }
+
+    /// \brief Random engine.
+    private: std::mt19937_64 engine;
+
+    /// \brief The fork generation when the engine was seeded.
+    private: uint64_t generation = 0;
+
+    /// \brief Whether the engine was seeded.
+    private: bool seeded = false;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Value of a hexadecimal digit.
+  /// \param[in] _c The digit.
+  /// \return The value, or -1 if _c isn't a hexadecimal digit.
+  int hexValue(const char _c)
+  {
+    if (_c >= '0' && _c <= '9')
+      return _c - '0';
+    if (_c >= 'a' && _c <= 'f')
+      return _c - 'a' + 10;
+    if (_c >= 'A' && _c <= 'F')
+      return _c - 'A' + 10;
+    return -1;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Whether a hyphen goes before the byte of a UUID in its string
+  /// representation (8-4-4-4-12).
+  /// \param[in] _i Index of the byte.
+  /// \return True if a hyphen goes before the byte.
+  bool hyphenBefore(const std::size_t _i)
+  {
+    return _i == 4 || _i == 6 || _i == 8 || _i == 10;
+  }
+}
+
 //////////////////////////////////////////////////
 Uuid::Uuid()
 {
-  RPC_STATUS Result = ::UuidCreate(&this->data);
-  if (Result != RPC_S_OK)
+#ifndef _WIN32
+  static std::once_flag atForkFlag;
+  std::call_once(atForkFlag, []
   {
-    std::cerr << "Call to UuidCreate return a non success RPC call. " <<
-                 "Return code: " << Result << std::endl;
-  }
+    pthread_atfork(nullptr, nullptr, []{ ++forkGeneration; });
+  });
+#endif
+  thread_local Generator generator;
+  generator.Generate(this->data);
+}
+
+//////////////////////////////////////////////////
+Uuid::Uuid(const Bytes &_bytes)
+  : data(_bytes)
+{
 }
 
 //////////////////////////////////////////////////
 Uuid::~Uuid()
 {
-  // No method in windows to release the uuid
 }
 
 //////////////////////////////////////////////////
 std::string Uuid::ToString() const
 {
-  std::string uuidStr;
-  char* szUuid = NULL;
-  if (::UuidToStringA(&this->data, reinterpret_cast<RPC_CSTR*>(&szUuid)) ==
-    RPC_S_OK)
+  std::string uuidStr(Uuid::UuidStrLen - 1, '-');
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < this->data.size(); ++i)
   {
-        uuidStr = szUuid;
-        ::RpcStringFreeA(reinterpret_cast<RPC_CSTR*>(&szUuid));
+    if (hyphenBefore(i))
+      ++pos;
+    uuidStr[pos++] = kHexDigits[this->data[i] >> 4];
+    uuidStr[pos++] = kHexDigits[this->data[i] & 0x0F];
   }
-
   return uuidStr;
 }
-#else
-/* Unix implementation using libuuid library */
 
 //////////////////////////////////////////////////
-Uuid::Uuid()
+bool Uuid::FromString(const std::string &_str, Uuid &_uuid)
 {
-  uuid_generate(this->data);
+  if (_str.size() != Uuid::UuidStrLen - 1)
+    return false;
+
+  Bytes bytes;
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < bytes.size(); ++i)
+  {
+    if (hyphenBefore(i) && _str[pos++] != '-')
+      return false;
+    const int high = hexValue(_str[pos++]);
+    const int low = hexValue(_str[pos++]);
+    if (high < 0 || low < 0)
+      return false;
+    bytes[i] = static_cast<uint8_t>((high << 4) | low);
+  }
+
+  _uuid.data = bytes;
+  return true;
 }
 
 //////////////////////////////////////////////////
-Uuid::~Uuid()
+const Uuid::Bytes &Uuid::Data() const
 {
-  uuid_clear(this->data);
+  return this->data;
 }
 
 //////////////////////////////////////////////////
-std::string Uuid::ToString() const
+std::size_t Uuid::Hash() const
 {
-  std::vector<char> uuidStr(Uuid::UuidStrLen);
+  // The bytes are random, so folding the two halves is enough.
+  uint64_t high;
+  uint64_t low;
+  std::memcpy(&high, this->data.data(), sizeof(high));
+  std::memcpy(&low, this->data.data() + sizeof(high), sizeof(low));
+  return static_cast<std::size_t>(high ^ (low * 0x9E3779B97F4A7C15ULL));
+}
 
-  snprintf(&uuidStr[0], Uuid::UuidStrLen,
-    "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-    this->data[0], this->data[1], this->data[2], this->data[3],
-    this->data[4], this->data[5], this->data[6], this->data[7],
-    this->data[8], this->data[9], this->data[10], this->data[11],
-    this->data[12], this->data[13], this->data[14], this->data[15]);
+//////////////////////////////////////////////////
+bool Uuid::operator==(const Uuid &_other) const
+{
+  return this->data == _other.data;
+}
 
-  // Do not include the \0 in the string.
-  return std::string(uuidStr.begin(), uuidStr.end() - 1);
+//////////////////////////////////////////////////
+bool Uuid::operator!=(const Uuid &_other) const
+{
+  return !(*this == _other);
 }
 
-#endif
+//////////////////////////////////////////////////
+bool Uuid::operator<(const Uuid &_other) const
+{
+  return this->data < _other.data;
+}
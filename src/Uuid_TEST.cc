@@ -17,7 +17,14 @@
 
 #include <cctype>
 #include <iostream>
+#include <set>
 #include <string>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "gz/transport/Uuid.hh"
 #include "gtest/gtest.h"
@@ -51,3 +58,95 @@ TEST(UuidTest, testToString)
   for (auto i = 24; i < 36; ++i)
     EXPECT_GT(isxdigit(output.str()[i]), 0);
 }
+
+//////////////////////////////////////////////////
+/// \brief Check the value semantics of Uuid.
+TEST(UuidTest, ValueType)
+{
+  transport::Uuid uuid1;
+  transport::Uuid uuid2;
+  EXPECT_NE(uuid1, uuid2);
+  EXPECT_TRUE(uuid1 < uuid2 || uuid2 < uuid1);
+
+  // Random UUIDs are RFC 4122 version 4.
+  EXPECT_EQ(0x40, uuid1.Data()[6] & 0xF0);
+  EXPECT_EQ(0x80, uuid1.Data()[8] & 0xC0);
+  EXPECT_EQ('4', uuid1.ToString()[14]);
+
+  transport::Uuid copy(uuid1.Data());
+  EXPECT_EQ(uuid1, copy);
+  EXPECT_EQ(uuid1.Hash(), copy.Hash());
+  EXPECT_EQ(uuid1.ToString(), copy.ToString());
+
+  std::unordered_set<transport::Uuid> uuids;
+  std::set<std::string> strings;
+  for (int i = 0; i < 1000; ++i)
+  {
+    transport::Uuid uuid;
+    EXPECT_TRUE(uuids.insert(uuid).second);
+    EXPECT_TRUE(strings.insert(uuid.ToString()).second);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the parsing of the string representation.
+TEST(UuidTest, FromString)
+{
+  transport::Uuid uuid;
+  transport::Uuid parsed(transport::Uuid::Bytes{});
+  EXPECT_TRUE(transport::Uuid::FromString(uuid.ToString(), parsed));
+  EXPECT_EQ(uuid, parsed);
+
+  EXPECT_TRUE(transport::Uuid::FromString(
+    "0123ABCD-4567-89ab-cdef-0123456789AB", parsed));
+  EXPECT_EQ("0123abcd-4567-89ab-cdef-0123456789ab", parsed.ToString());
+
+  EXPECT_FALSE(transport::Uuid::FromString("", parsed));
+  EXPECT_FALSE(transport::Uuid::FromString(
+    "0123abcd-4567-89ab-cdef-0123456789a", parsed));
+  EXPECT_FALSE(transport::Uuid::FromString(
+    "0123abcd-4567-89ab-cdef_0123456789ab", parsed));
+  EXPECT_FALSE(transport::Uuid::FromString(
+    "0123abcd-4567-89ab-cdef-0123456789ag", parsed));
+  EXPECT_EQ("0123abcd-4567-89ab-cdef-0123456789ab", parsed.ToString());
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////
+/// \brief A forked process must not repeat the UUIDs of its parent.
+TEST(UuidTest, Fork)
+{
+  // Seed the generator of this thread before forking.
+  transport::Uuid first;
+
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0)
+  {
+    const std::string str = transport::Uuid().ToString();
+    ssize_t written = write(fds[1], str.data(), str.size());
+    _exit(written == static_cast<ssize_t>(str.size()) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  const std::string parent = transport::Uuid().ToString();
+  std::string child(36, '\0');
+  ssize_t received = 0;
+  while (received < static_cast<ssize_t>(child.size()))
+  {
+    ssize_t n = read(fds[0], &child[received], child.size() - received);
+    if (n <= 0)
+      break;
+    received += n;
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_EQ(0, WEXITSTATUS(status));
+  ASSERT_EQ(36, received);
+  EXPECT_NE(parent, child);
+}
+#endif
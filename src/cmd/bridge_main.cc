@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/utils/cli/CLI.hpp>
+#include <gz/utils/cli/GzFormatter.hpp>
+
+#include <gz/transport/AdvertiseOptions.hh>
+#include <gz/transport/Bridge.hh>
+#include <gz/transport/config.hh>
+#include <gz/transport/Node.hh>
+#include <gz/transport/NodeOptions.hh>
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+/// \brief Structure to hold all available bridge options
+struct BridgeOptions
+{
+  /// \brief Source partition
+  std::string from;
+
+  /// \brief Destination partition
+  std::string to;
+
+  /// \brief Patterns of the topics forwarded
+  std::vector<std::string> topics;
+
+  /// \brief Maximum rate of each topic (msgs/sec), 0 for no limit
+  uint64_t rate{0};
+
+  /// \brief Number of messages per batch, 0 to disable batching
+  uint64_t batchSize{0};
+
+  /// \brief Maximum time a message waits in a batch (us.)
+  uint64_t batchPeriod{0};
+
+  /// \brief Compression codec: none, lz4 or zstd
+  std::string compression{"none"};
+
+  /// \brief Compression level
+  int level{0};
+};
+
+//////////////////////////////////////////////////
+/// \brief Callback fired when options are successfully parsed
+void runBridge(const BridgeOptions &_opt)
+{
+  transport::NodeOptions from;
+  transport::NodeOptions to;
+  if (!from.SetPartition(_opt.from) || !to.SetPartition(_opt.to))
+  {
+    std::cerr << "Invalid partition" << std::endl;
+    throw CLI::RuntimeError(1);
+  }
+
+  transport::AdvertiseMessageOptions opts;
+  if (_opt.rate > 0)
+    opts.SetMsgsPerSec(_opt.rate);
+  if (_opt.batchSize > 0)
+    opts.SetBatchSize(_opt.batchSize);
+  if (_opt.batchPeriod > 0)
+    opts.SetBatchPeriod(std::chrono::microseconds(_opt.batchPeriod));
+  if (_opt.compression == "lz4")
+    opts.SetCompression(transport::Compression_t::LZ4, _opt.level);
+  else if (_opt.compression == "zstd")
+    opts.SetCompression(transport::Compression_t::ZSTD, _opt.level);
+
+  transport::Bridge bridge(from, to);
+  for (const auto &pattern : _opt.topics)
+  {
+    if (!bridge.AddTopics(pattern, opts))
+      throw CLI::RuntimeError(1);
+  }
+
+  if (!bridge.Start())
+  {
+    std::cerr << "Unable to start the bridge" << std::endl;
+    throw CLI::RuntimeError(1);
+  }
+
+  std::cout << "Forwarding the topics of partition [" << _opt.from
+            << "] to partition [" << _opt.to << "]" << std::endl;
+  transport::waitForShutdown();
+  bridge.Stop();
+  std::cout << "Forwarded " << bridge.ForwardedMessages() << " messages"
+            << std::endl;
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  CLI::App app{R"(Forward topics from a partition to another one.
+The messages are forwarded without being parsed.)"};
+
+  app.add_flag_callback("--version", [](){
+      std::cout << GZ_TRANSPORT_VERSION_FULL << std::endl;
+      throw CLI::Success();
+  });
+
+  auto opt = std::make_shared<BridgeOptions>();
+  app.add_option("--from", opt->from, "Source partition.")
+    ->required();
+  app.add_option("--to", opt->to, "Destination partition.")
+    ->required();
+  app.add_option("-t,--topic", opt->topics,
+                 "Regular expression matching the topics forwarded. "
+                 "It can be repeated.")
+    ->required();
+  app.add_option("-r,--rate", opt->rate,
+                 "Maximum rate of each topic (msgs/sec).");
+  app.add_option("--batch-size", opt->batchSize,
+                 "Number of messages sent together.");
+  app.add_option("--batch-period", opt->batchPeriod,
+                 "Maximum time a message waits for a batch (us).");
+  app.add_option("-c,--compression", opt->compression,
+                 "Compression of the forwarded messages.")
+    ->check(CLI::IsMember({"none", "lz4", "zstd"}));
+  app.add_option("--level", opt->level, "Compression level.");
+  app.callback([opt](){runBridge(*opt); });
+
+  app.formatter(std::make_shared<GzFormatter>(&app));
+  CLI11_PARSE(app, argc, argv);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <iostream>
+#include <string>
+
+#include <gz/utils/cli/CLI.hpp>
+#include <gz/utils/cli/GzFormatter.hpp>
+
+#include <gz/transport/config.hh>
+#include <gz/transport/IntrospectionDaemon.hh>
+#include <gz/transport/Node.hh>
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+/// \brief Structure to hold all available daemon options
+struct DaemonOptions
+{
+  /// \brief ZeroMQ endpoint where the daemon listens
+  std::string endpoint{""};
+};
+
+//////////////////////////////////////////////////
+/// \brief Callback fired when options are successfully parsed
+void runDaemon(const DaemonOptions &_opt)
+{
+  transport::IntrospectionDaemon daemon(_opt.endpoint);
+  if (!daemon.Start())
+  {
+    std::cerr << "Unable to start the introspection daemon" << std::endl;
+    throw CLI::RuntimeError(1);
+  }
+
+  std::cout << "Introspection daemon listening on [" << daemon.Endpoint()
+            << "]" << std::endl;
+  transport::waitForShutdown();
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  CLI::App app{R"(Keep the discovery of a partition warm and answer the
+graph queries of the command line tools, so they don't have
+to discover the graph on every invocation.)"};
+
+  app.add_flag_callback("--version", [](){
+      std::cout << GZ_TRANSPORT_VERSION_FULL << std::endl;
+      throw CLI::Success();
+  });
+
+  auto opt = std::make_shared<DaemonOptions>();
+  app.add_option("--endpoint", opt->endpoint,
+                 "ZeroMQ endpoint where the daemon listens.\n"
+                 "By default, an IPC socket named after the partition.");
+  app.callback([opt](){runDaemon(*opt); });
+
+  app.formatter(std::make_shared<GzFormatter>(&app));
+  CLI11_PARSE(app, argc, argv);
+}
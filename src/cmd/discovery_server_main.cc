@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <iostream>
+
+#include <gz/utils/cli/CLI.hpp>
+#include <gz/utils/cli/GzFormatter.hpp>
+
+#include <gz/transport/config.hh>
+#include <gz/transport/DiscoveryServer.hh>
+#include <gz/transport/Node.hh>
+#include <gz/transport/NodeShared.hh>
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+/// \brief Structure to hold all available server options
+struct ServerOptions
+{
+  /// \brief UDP port used for message discovery
+  int msgPort{transport::NodeShared::kDefaultMsgDiscPort};
+
+  /// \brief UDP port used for service discovery
+  int srvPort{transport::NodeShared::kDefaultSrvDiscPort};
+
+  /// \brief Print the discovery activity
+  bool verbose{false};
+};
+
+//////////////////////////////////////////////////
+/// \brief Callback fired when options are successfully parsed
+void runServer(const ServerOptions &_opt)
+{
+  transport::DiscoveryServer server(_opt.msgPort, _opt.srvPort,
+    _opt.verbose);
+  if (!server.Start())
+  {
+    std::cerr << "Unable to start the discovery server" << std::endl;
+    throw CLI::RuntimeError(1);
+  }
+
+  std::cout << "Discovery server listening on ports [" << _opt.msgPort
+            << "] and [" << _opt.srvPort << "]" << std::endl;
+  transport::waitForShutdown();
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+  CLI::App app{R"(Discovery server for networks without multicast.
+Start the processes with GZ_DISCOVERY_SERVER set to the IP address
+of this host.)"};
+
+  app.add_flag_callback("--version", [](){
+      std::cout << GZ_TRANSPORT_VERSION_FULL << std::endl;
+      throw CLI::Success();
+  });
+
+  auto opt = std::make_shared<ServerOptions>();
+  app.add_option("--msg-port", opt->msgPort,
+                 "UDP port used for message discovery.");
+  app.add_option("--srv-port", opt->srvPort,
+                 "UDP port used for service discovery.");
+  app.add_flag("-v,--verbose", opt->verbose,
+               "Print the discovery activity.");
+  app.callback([opt](){runServer(*opt); });
+
+  app.formatter(std::make_shared<GzFormatter>(&app));
+  CLI11_PARSE(app, argc, argv);
+}
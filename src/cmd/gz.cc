@@ -18,17 +18,28 @@
 */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <condition_variable>
+#include <cstdint>
 #include <ctime>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <numeric>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4251)
@@ -43,18 +54,43 @@
 #include "gz.hh"
 #include "gz/transport/config.hh"
 #include "gz/transport/Helpers.hh"
+#include "gz/transport/IntrospectionDaemon.hh"
 #include "gz/transport/Node.hh"
+#include "gz/transport/NodeShared.hh"
+#include "gz/transport/TopicStatistics.hh"
+#include "gz/transport/TopicUtils.hh"
 
 using namespace gz;
 using namespace transport;
 
 //////////////////////////////////////////////////
-extern "C" void cmdTopicList()
+/// \brief Format a number of bytes with a unit.
+/// \param[in] _bytes Number of bytes.
+/// \return E.g. "1.50 MB".
+static std::string formatBytes(double _bytes)
 {
-  Node node;
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  if (_bytes >= 1e9)
+    out << _bytes / 1e9 << " GB";
+  else if (_bytes >= 1e6)
+    out << _bytes / 1e6 << " MB";
+  else if (_bytes >= 1e3)
+    out << _bytes / 1e3 << " KB";
+  else
+    out << _bytes << " B";
+  return out.str();
+}
 
+//////////////////////////////////////////////////
+extern "C" void cmdTopicList()
+{
   std::vector<std::string> topics;
-  node.TopicList(topics);
+  if (!IntrospectionClient().TopicList(topics))
+  {
+    Node node;
+    node.TopicList(topics);
+  }
 
   for (auto const &topic : topics)
     std::cout << topic << std::endl;
@@ -72,8 +108,11 @@ extern "C" void cmdTopicInfo(const char *_topic)
   // Get the publishers on the requested topic
   std::vector<MessagePublisher> publishers;
   std::vector<MessagePublisher> subscribers;
-  Node node;
-  node.TopicInfo(_topic, publishers, subscribers);
+  if (!IntrospectionClient().TopicInfo(_topic, publishers, subscribers))
+  {
+    Node node;
+    node.TopicInfo(_topic, publishers, subscribers);
+  }
 
   if (!publishers.empty())
   {
@@ -114,10 +153,12 @@ extern "C" void cmdTopicInfo(const char *_topic)
 //////////////////////////////////////////////////
 extern "C" void cmdServiceList()
 {
-  Node node;
-
   std::vector<std::string> services;
-  node.ServiceList(services);
+  if (!IntrospectionClient().ServiceList(services))
+  {
+    Node node;
+    node.ServiceList(services);
+  }
 
   for (auto const &service : services)
     std::cout << service << std::endl;
@@ -132,11 +173,13 @@ extern "C" void cmdServiceInfo(const char *_service)
     return;
   }
 
-  Node node;
-
   // Get the publishers on the requested topic
   std::vector<ServicePublisher> publishers;
-  node.ServiceInfo(_service, publishers);
+  if (!IntrospectionClient().ServiceInfo(_service, publishers))
+  {
+    Node node;
+    node.ServiceInfo(_service, publishers);
+  }
 
   if (!publishers.empty())
   {
@@ -209,6 +252,170 @@ extern "C" void cmdTopicPub(const char *_topic,
   }
 }
 
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Number of bytes of a varint.
+  /// \param[in] _value Value of the varint.
+  /// \return Its encoded size.
+  std::size_t varintSize(uint64_t _value)
+  {
+    std::size_t size = 1;
+    while (_value >= 0x80)
+    {
+      _value >>= 7;
+      ++size;
+    }
+    return size;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Append a varint to a string.
+  /// \param[in] _value Value of the varint.
+  /// \param[in] _width Number of bytes to use, which can be larger than
+  /// needed. Parsers accept the redundant continuation bytes.
+  /// \param[out] _out String to append to.
+  void appendVarint(uint64_t _value, std::size_t _width, std::string &_out)
+  {
+    for (std::size_t i = 1; i < _width; ++i)
+    {
+      _out += static_cast<char>((_value & 0x7f) | 0x80);
+      _value >>= 7;
+    }
+    _out += static_cast<char>(_value);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Grow a serialized message to an exact size by appending an
+  /// unknown length-delimited field, which receivers skip when parsing.
+  /// \param[in] _size Target size in bytes.
+  /// \param[in,out] _data Serialized message.
+  /// \return False if _size leaves no room for the padding field.
+  bool padSerializedMessage(std::size_t _size, std::string &_data)
+  {
+    if (_data.size() == _size)
+      return true;
+
+    // Highest field number, wire type 2 (length-delimited).
+    const uint64_t kTag = (uint64_t{536870911} << 3) | 2;
+    const std::size_t tagSize = varintSize(kTag);
+    for (std::size_t lenSize = 1; lenSize <= 5; ++lenSize)
+    {
+      if (_data.size() + tagSize + lenSize > _size)
+        return false;
+      const std::size_t len = _size - _data.size() - tagSize - lenSize;
+      if (varintSize(len) > lenSize)
+        continue;
+      appendVarint(kTag, tagSize, _data);
+      appendVarint(len, lenSize, _data);
+      _data.append(len, '\0');
+      return true;
+    }
+    return false;
+  }
+}
+
+//////////////////////////////////////////////////
+extern "C" void cmdTopicPubLoop(const char *_topic,
+  const char *_msgType, const char *_msgData, const double _rate,
+  int _count, int _size)
+{
+  if (!_topic)
+  {
+    std::cerr << "Topic name is null\n";
+    return;
+  }
+
+  if (!_msgType)
+  {
+    std::cerr << "Message type is null\n";
+    return;
+  }
+
+  if (!_msgData)
+  {
+    std::cerr << "Message data is null\n";
+    return;
+  }
+
+  auto msg = msgs::Factory::New(_msgType, _msgData);
+  if (!msg)
+  {
+    std::cerr << "Unable to create message of type[" << _msgType << "] "
+      << "with data[" << _msgData << "].\n";
+    return;
+  }
+
+  // The message is only serialized once.
+  std::string data;
+  if (!msg->SerializeToString(&data))
+  {
+    std::cerr << "Unable to serialize message of type[" << _msgType
+      << "].\n";
+    return;
+  }
+  if (_size > 0 && !padSerializedMessage(static_cast<std::size_t>(_size),
+        data))
+  {
+    std::cerr << "Unable to publish messages of [" << _size << "] bytes. "
+      << "The message takes [" << data.size() << "] bytes, and padding "
+      << "needs at least 6 more.\n";
+    return;
+  }
+  const std::string msgType = msg->GetTypeName();
+
+  Node node;
+  auto pub = node.Advertise(_topic, msgType);
+  if (!pub)
+  {
+    std::cerr << "Unable to publish on topic[" << _topic << "] "
+      << "with message type[" << _msgType << "].\n";
+    return;
+  }
+
+  // \todo(anyone) Change this sleep to a WaitForSubscribers() call.
+  // See issue #47.
+  std::this_thread::sleep_for(std::chrono::milliseconds(800));
+
+  using Clock = std::chrono::steady_clock;
+  const Clock::duration period = _rate > 0 ?
+    std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / _rate)) :
+    Clock::duration::zero();
+
+  const auto start = Clock::now();
+  auto next = start;
+  uint64_t published = 0;
+  uint64_t failed = 0;
+  while (_count <= 0 || published + failed < static_cast<uint64_t>(_count))
+  {
+    if (period > Clock::duration::zero())
+    {
+      std::this_thread::sleep_until(next);
+      next += period;
+      // Don't try to catch up after a long stall.
+      const auto now = Clock::now();
+      if (next + std::chrono::seconds(1) < now)
+        next = now;
+    }
+
+    if (pub.PublishRaw(data, msgType))
+      ++published;
+    else
+      ++failed;
+  }
+
+  const double elapsed =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "Published " << published << " messages of " << data.size()
+            << " bytes in " << std::fixed << std::setprecision(3) << elapsed
+            << " s (" << std::setprecision(1) << published / elapsed
+            << " Hz, " << published * data.size() / elapsed << " bytes/s)";
+  if (failed > 0)
+    std::cout << ", " << failed << " failed";
+  std::cout << std::endl;
+}
+
 //////////////////////////////////////////////////
 extern "C" void cmdServiceReq(const char *_service,
   const char *_reqType, const char *_repType, const int _timeout,
@@ -281,28 +488,172 @@ extern "C" void cmdServiceReq(const char *_service,
 }
 
 //////////////////////////////////////////////////
-extern "C" void cmdTopicEcho(const char *_topic,
-  const double _duration, int _count, MsgOutputFormat _outputFormat)
+extern "C" void cmdServiceBench(const char *_service,
+  const char *_reqType, const char *_repType, const int _timeout,
+  const char *_reqData, int _concurrency, double _qps, double _duration,
+  int _count)
 {
-  if (!_topic || std::string(_topic).empty())
+  if (!_service)
   {
-    std::cerr << "Invalid topic. Topic must not be empty.\n";
+    std::cerr << "Service name is null\n";
     return;
   }
 
-  std::mutex mutex;
-  std::condition_variable condition;
-  int count = 0;
+  if (!_reqType)
+  {
+    std::cerr << "Request type is null\n";
+    return;
+  }
 
-  std::function<void(const ProtoMsg&)> cb = [&](const ProtoMsg &_msg)
+  if (!_repType)
+  {
+    std::cerr << "Response type is null\n";
+    return;
+  }
+
+  if (!_reqData)
+  {
+    std::cerr << "Request data is null\n";
+    return;
+  }
+
+  if (_count <= 0 && _duration <= 0)
+  {
+    std::cerr << "Either the number of requests or the duration must be "
+              << "positive.\n";
+    return;
+  }
+
+  // The request is created once and shared by all the workers, which only
+  // read it.
+  std::unique_ptr<const ProtoMsg> req =
+    msgs::Factory::New(_reqType, _reqData);
+  if (!req)
+  {
+    std::cerr << "Unable to create request of type[" << _reqType << "] "
+              << "with data[" << _reqData << "].\n";
+    return;
+  }
+
+  if (!msgs::Factory::New(_repType))
+  {
+    std::cerr << "Unable to create response of type[" << _repType << "].\n";
+    return;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  const unsigned int workers =
+    static_cast<unsigned int>(std::max(1, _concurrency));
+  const Clock::duration period = _qps > 0 ?
+    std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / _qps)) :
+    Clock::duration::zero();
+
+  std::atomic<uint64_t> nextTicket{0};
+  std::atomic<uint64_t> succeeded{0};
+  std::atomic<uint64_t> failed{0};
+  std::atomic<uint64_t> timedOut{0};
+  std::atomic<uint64_t> maxLatency{0};
+  LatencyHistogram latencies;
+
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(_duration));
+
+  auto work = [&]()
+  {
+    // Every worker acts as an independent client.
+    Node node;
+    auto rep = msgs::Factory::New(_repType);
+    while (true)
+    {
+      const uint64_t ticket = nextTicket++;
+      if (_count > 0 && ticket >= static_cast<uint64_t>(_count))
+        break;
+
+      // With a target rate, every request has a scheduled time. Latencies
+      // are measured from it, so a slow responder also accounts for the
+      // requests it delayed.
+      auto sendTime = Clock::now();
+      if (period > Clock::duration::zero())
+      {
+        const auto scheduled = start + period * ticket;
+        std::this_thread::sleep_until(scheduled);
+        sendTime = scheduled;
+      }
+      if (_count <= 0 && sendTime >= end)
+        break;
+
+      bool result = false;
+      const bool executed =
+        node.Request(_service, *req, _timeout, *rep, result);
+
+      const uint64_t latency = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+          Clock::now() - sendTime).count());
+      if (!executed)
+      {
+        ++timedOut;
+        continue;
+      }
+
+      latencies.Record(latency);
+      uint64_t prevMax = maxLatency.load(std::memory_order_relaxed);
+      while (prevMax < latency &&
+             !maxLatency.compare_exchange_weak(prevMax, latency,
+                                               std::memory_order_relaxed))
+      {
+      }
+
+      if (result)
+        ++succeeded;
+      else
+        ++failed;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < workers; ++i)
+    threads.emplace_back(work);
+  for (auto &t : threads)
+    t.join();
+
+  const double elapsed =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  const uint64_t completed = succeeded + failed;
+
+  std::cout << "requests: " << completed + timedOut << " ("
+            << succeeded << " ok, " << failed << " failed, "
+            << timedOut << " timed out) in " << std::fixed
+            << std::setprecision(3) << elapsed << " s\n"
+            << "throughput: " << std::setprecision(1)
+            << completed / elapsed << " req/s\n";
+  if (completed > 0)
+  {
+    std::cout << "latency (us): p50 " << latencies.Percentile(50)
+              << ", p90 " << latencies.Percentile(90)
+              << ", p99 " << latencies.Percentile(99)
+              << ", p99.9 " << latencies.Percentile(99.9)
+              << ", max " << maxLatency << "\n";
+  }
+  std::cout << std::flush;
+}
+
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Print a deserialized message.
+  /// \param[in] _msg The message.
+  /// \param[in] _outputFormat kDefault, kDebugString or kJSON.
+  /// \return False if the output format is not valid.
+  bool printMessage(const ProtoMsg &_msg, MsgOutputFormat _outputFormat)
   {
-    std::lock_guard<std::mutex> lock(mutex);
     switch (_outputFormat)
     {
       case MsgOutputFormat::kDefault:
       case MsgOutputFormat::kDebugString:
         std::cout << _msg.DebugString() << std::endl;
-        break;
+        return true;
       case MsgOutputFormat::kJSON:
         {
           std::string jsonStr;
@@ -317,11 +668,107 @@ extern "C" void cmdTopicEcho(const char *_topic,
             std::cerr << status;
           }
         }
-        break;
+        return true;
       default:
         std::cerr << "Invalid output format selected.\n";
-        return;
+        return false;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Print the type, size and optionally the serialized data of a
+  /// message without deserializing it.
+  /// \param[in] _data Serialized message.
+  /// \param[in] _size Size of the serialized message.
+  /// \param[in] _type Message type.
+  /// \param[in] _hex Whether to print the serialized data.
+  void printRaw(const char *_data, std::size_t _size,
+                const std::string &_type, bool _hex)
+  {
+    std::cout << _type << ", " << _size << " bytes\n";
+    if (!_hex)
+      return;
+
+    static const char kDigits[] = "0123456789abcdef";
+    std::string line;
+    for (std::size_t i = 0; i < _size; ++i)
+    {
+      const auto byte = static_cast<unsigned char>(_data[i]);
+      if (i % 16 != 0)
+        line += ' ';
+      line += kDigits[byte >> 4];
+      line += kDigits[byte & 0xf];
+      if (i % 16 == 15 || i + 1 == _size)
+      {
+        std::cout << line << "\n";
+        line.clear();
+      }
     }
+    std::cout << std::endl;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Block until an echo command is done.
+  /// \param[in] _duration Duration (seconds) to run, see cmdTopicEcho.
+  /// \param[in] _count Number of messages to wait for, see cmdTopicEcho.
+  /// \param[in] _mutex Mutex protecting _received.
+  /// \param[in] _condition Notified each time _received changes.
+  /// \param[in] _received Number of messages echoed.
+  void waitForEcho(const double _duration, int _count, std::mutex &_mutex,
+                   std::condition_variable &_condition, const int &_received)
+  {
+    if (_duration >= 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(
+        static_cast<int64_t>(_duration * 1000)));
+      return;
+    }
+
+    // Wait forever if _count <= 0. Otherwise wait for a specific number of
+    // messages.
+    if (_count <= 0)
+    {
+      waitForShutdown();
+    }
+    else
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [&]{return _received >= _count;});
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+extern "C" void cmdTopicEcho(const char *_topic,
+  const double _duration, int _count, MsgOutputFormat _outputFormat)
+{
+  switch (_outputFormat)
+  {
+    case MsgOutputFormat::kSize:
+    case MsgOutputFormat::kHex:
+    case MsgOutputFormat::kRate:
+      // These formats never deserialize the messages.
+      cmdTopicEchoSampled(_topic, _duration, _count, _outputFormat, 0);
+      return;
+    default:
+      break;
+  }
+
+  if (!_topic || std::string(_topic).empty())
+  {
+    std::cerr << "Invalid topic. Topic must not be empty.\n";
+    return;
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int count = 0;
+
+  std::function<void(const ProtoMsg&)> cb = [&](const ProtoMsg &_msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!printMessage(_msg, _outputFormat))
+      return;
     ++count;
     condition.notify_one();
   };
@@ -330,27 +777,108 @@ extern "C" void cmdTopicEcho(const char *_topic,
   if (!node.Subscribe(_topic, cb))
     return;
 
-  if (_duration >= 0)
+  waitForEcho(_duration, _count, mutex, condition, count);
+}
+
+//////////////////////////////////////////////////
+extern "C" void cmdTopicEchoSampled(const char *_topic,
+  const double _duration, int _count, MsgOutputFormat _outputFormat,
+  const double _sampleRate)
+{
+  if (!_topic || std::string(_topic).empty())
   {
-    std::this_thread::sleep_for(std::chrono::milliseconds(
-      static_cast<int64_t>(_duration * 1000)));
+    std::cerr << "Invalid topic. Topic must not be empty.\n";
     return;
   }
 
-  // Wait forever if _count <= 0. Otherwise wait for a specific number of
-  // messages.
-  if (_count <= 0)
-  {
-    waitForShutdown();
-  }
-  else
+  using Clock = std::chrono::steady_clock;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  int count = 0;
+
+  // Minimum time between two printed messages.
+  const Clock::duration period = _sampleRate > 0 ?
+    std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / _sampleRate)) :
+    Clock::duration::zero();
+  Clock::time_point nextOutput;
+
+  // Rates accumulated since the last kRate report.
+  Clock::time_point rateStart;
+  uint64_t rateMsgs = 0;
+  uint64_t rateBytes = 0;
+
+  RawCallback cb = [&](const char *_data, const std::size_t _size,
+                       const MessageInfo &_info)
   {
-    while (count < _count)
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = Clock::now();
+
+    if (_outputFormat == MsgOutputFormat::kRate)
     {
-      std::unique_lock<std::mutex> lock(mutex);
-      condition.wait(lock, [&]{return count >= _count;});
+      if (rateMsgs == 0 && rateBytes == 0)
+        rateStart = now;
+      ++rateMsgs;
+      rateBytes += _size;
+      const std::chrono::duration<double> elapsed = now - rateStart;
+      if (elapsed.count() >= 1.0)
+      {
+        std::cout << std::fixed << std::setprecision(1)
+                  << rateMsgs / elapsed.count() << " msgs/s, "
+                  << rateBytes / elapsed.count() << " bytes/s, "
+                  << rateBytes / rateMsgs << " bytes/msg" << std::endl;
+        rateStart = now;
+        rateMsgs = 0;
+        rateBytes = 0;
+      }
+      ++count;
+      condition.notify_one();
+      return;
     }
-  }
+
+    // Drop the messages that arrive before the next sampling period,
+    // without deserializing them.
+    if (now < nextOutput)
+      return;
+    nextOutput = now + period;
+
+    switch (_outputFormat)
+    {
+      case MsgOutputFormat::kSize:
+      case MsgOutputFormat::kHex:
+        printRaw(_data, _size, _info.Type(),
+                 _outputFormat == MsgOutputFormat::kHex);
+        break;
+      default:
+        {
+          auto msg = msgs::Factory::New(_info.Type());
+          if (!msg)
+          {
+            std::cerr << "Unable to create message of type["
+                      << _info.Type() << "].\n";
+            return;
+          }
+          if (!msg->ParseFromArray(_data, static_cast<int>(_size)))
+          {
+            std::cerr << "Unable to parse message of type["
+                      << _info.Type() << "].\n";
+            return;
+          }
+          if (!printMessage(*msg, _outputFormat))
+            return;
+        }
+        break;
+    }
+    ++count;
+    condition.notify_one();
+  };
+
+  Node node;
+  if (!node.SubscribeRaw(_topic, cb))
+    return;
+
+  waitForEcho(_duration, _count, mutex, condition, count);
 }
 
 //////////////////////////////////////////////////
@@ -425,6 +953,433 @@ extern "C" void cmdTopicFrequency(const char *_topic)
   waitForShutdown();
 }
 
+//////////////////////////////////////////////////
+extern "C" void cmdTopicBandwidth(const char *_topic, const double _duration)
+{
+  if (!_topic || std::string(_topic).empty())
+  {
+    std::cerr << "Invalid topic. Topic must not be empty.\n";
+    return;
+  }
+
+  using Clock = std::chrono::steady_clock;
+
+  // Counters of the current report window.
+  std::mutex mutex;
+  Clock::time_point windowStart = Clock::now();
+  Clock::time_point lastReception;
+  uint64_t msgCount = 0;
+  uint64_t byteCount = 0;
+  uint64_t dropCount = 0;
+  bool withMetadata = false;
+  LatencyHistogram intervals;
+
+  // Last sequence number of each publisher.
+  std::map<std::string, uint64_t> lastSeqs;
+
+  // Only count the messages, they are never deserialized. The sequence
+  // numbers are only received from the publishers that send their metadata,
+  // see GZ_TRANSPORT_MESSAGE_METADATA.
+  RawCallback cb = [&](const char *, const std::size_t _size,
+                       const MessageInfo &_info)
+  {
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (lastReception != Clock::time_point())
+    {
+      intervals.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+          now - lastReception).count()));
+    }
+    lastReception = now;
+    ++msgCount;
+    byteCount += _size;
+
+    if (!_info.HasMetadata())
+      return;
+
+    withMetadata = true;
+    const uint64_t seq = _info.SequenceNumber();
+    auto it = lastSeqs.find(_info.PublisherUuid());
+    if (it == lastSeqs.end())
+    {
+      lastSeqs[_info.PublisherUuid()] = seq;
+      return;
+    }
+    if (seq > it->second + 1)
+      dropCount += seq - it->second - 1;
+    it->second = seq;
+  };
+
+  Node node;
+  if (!node.SubscribeRaw(_topic, cb))
+    return;
+
+  const auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(_duration));
+  while (_duration <= 0 || Clock::now() < end)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    uint64_t msgs = 0;
+    uint64_t bytes = 0;
+    uint64_t drops = 0;
+    bool metadata = false;
+    LatencyHistogram window;
+    double elapsed = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      const auto now = Clock::now();
+      elapsed = std::chrono::duration<double>(now - windowStart).count();
+      msgs = msgCount;
+      bytes = byteCount;
+      drops = dropCount;
+      metadata = withMetadata;
+      window = intervals;
+      windowStart = now;
+      msgCount = 0;
+      byteCount = 0;
+      dropCount = 0;
+      withMetadata = false;
+      intervals.Reset();
+    }
+
+    if (msgs == 0)
+    {
+      std::cout << "no new messages" << std::endl;
+      continue;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "rate: " << msgs / elapsed << " Hz"
+              << "  bw: " << formatBytes(bytes / elapsed) << "/s"
+              << "  mean size: " << formatBytes(
+                   static_cast<double>(bytes) / msgs);
+    if (window.Count() > 0)
+    {
+      std::cout << std::setprecision(3)
+                << "  interval (ms) p50: " << window.Percentile(50) / 1e3
+                << " p99: " << window.Percentile(99) / 1e3
+                << " max: " << window.Percentile(100) / 1e3;
+    }
+
+    // The drops are only known when the publishers send their sequence
+    // numbers.
+    if (metadata)
+      std::cout << "  drops: " << drops;
+    std::cout << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+extern "C" void cmdTopicProfile(const char *_topic, const double _duration)
+{
+  const std::string topic = _topic ? _topic : "";
+
+  // Last profiles of every process.
+  std::mutex mutex;
+  std::map<std::string, msgs::Metric> reports;
+
+  std::function<void(const msgs::Metric &)> cb =
+    [&](const msgs::Metric &_msg)
+  {
+    std::string pUuid;
+    for (const auto &data : _msg.header().data())
+    {
+      if (data.key() == "process_uuid" && data.value_size() > 0)
+        pUuid = data.value(0);
+    }
+
+    std::lock_guard<std::mutex> lk(mutex);
+    reports[pUuid] = _msg;
+  };
+
+  Node node;
+  if (!node.Subscribe(NodeShared::kCallbackProfileTopic, cb))
+    return;
+
+  const double duration = _duration > 0 ? _duration : 2.0;
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+    static_cast<int64_t>(duration * 1000)));
+
+  /// \brief One line of the report.
+  struct Row
+  {
+    std::string topic;
+    std::string nodeUuid;
+    std::map<std::string, double> stats;
+  };
+
+  std::vector<Row> rows;
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    for (const auto &[pUuid, msg] : reports)
+    {
+      for (const auto &group : msg.statistics_groups())
+      {
+        if (group.name() != "callback_statistics")
+          continue;
+
+        Row row;
+        for (const auto &data : group.header().data())
+        {
+          if (data.value_size() == 0)
+            continue;
+          if (data.key() == "topic")
+            row.topic = data.value(0);
+          else if (data.key() == "node_uuid")
+            row.nodeUuid = data.value(0);
+        }
+        if (!topic.empty() && row.topic != topic)
+          continue;
+
+        for (const auto &stat : group.statistics())
+          row.stats[stat.name()] = stat.value();
+        rows.push_back(std::move(row));
+      }
+    }
+  }
+
+  if (rows.empty())
+  {
+    std::cerr << "No callback profile received. Set "
+              << "GZ_TRANSPORT_CALLBACK_PROFILE=1 in the subscribers."
+              << std::endl;
+    return;
+  }
+
+  // The handlers that keep their thread busy for longer come first.
+  auto total = [](const Row &_row)
+  {
+    auto count = _row.stats.find("call_count");
+    auto avg = _row.stats.find("avg_time");
+    if (count == _row.stats.end() || avg == _row.stats.end())
+      return 0.0;
+    return count->second * avg->second;
+  };
+  std::sort(rows.begin(), rows.end(), [&](const Row &_a, const Row &_b)
+  {
+    return total(_a) > total(_b);
+  });
+
+  auto stat = [](const Row &_row, const std::string &_name)
+  {
+    auto it = _row.stats.find(_name);
+    return it == _row.stats.end() ? 0.0 : it->second;
+  };
+
+  std::cout << std::left << std::setw(32) << "TOPIC" << std::right
+            << std::setw(10) << "CALLS" << std::setw(10) << "OVERRUNS"
+            << std::setw(12) << "TOTAL(ms)" << std::setw(10) << "AVG(ms)"
+            << std::setw(10) << "P99(ms)" << std::setw(10) << "MAX(ms)"
+            << "  NODE" << std::endl;
+  for (const Row &row : rows)
+  {
+    std::cout << std::left << std::setw(32) << row.topic << std::right
+              << std::fixed << std::setprecision(3)
+              << std::setw(10) << static_cast<uint64_t>(
+                   stat(row, "call_count"))
+              << std::setw(10) << static_cast<uint64_t>(
+                   stat(row, "overrun_count"))
+              << std::setw(12) << total(row)
+              << std::setw(10) << stat(row, "avg_time")
+              << std::setw(10) << stat(row, "p99_time")
+              << std::setw(10) << stat(row, "max_time")
+              << "  " << row.nodeUuid << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+extern "C" void cmdTopicTop(const double _duration, int _count)
+{
+  using Clock = std::chrono::steady_clock;
+
+  /// \brief Counters of a topic since the start of its process.
+  struct Counters
+  {
+    double msgs = 0;
+    double bytes = 0;
+  };
+
+  /// \brief Last two reports of a process.
+  struct Report
+  {
+    double stamp = 0;
+    double prevStamp = 0;
+    std::map<std::string, Counters> topics;
+    std::map<std::string, Counters> prevTopics;
+    Clock::time_point received;
+  };
+
+  std::mutex mutex;
+  std::map<std::string, Report> reports;
+
+  std::function<void(const msgs::Metric &)> cb =
+    [&](const msgs::Metric &_msg)
+  {
+    std::string pUuid;
+    for (const auto &data : _msg.header().data())
+    {
+      if (data.key() == "process_uuid" && data.value_size() > 0)
+        pUuid = data.value(0);
+    }
+    if (pUuid.empty())
+      return;
+
+    std::map<std::string, Counters> topics;
+    for (const auto &group : _msg.statistics_groups())
+    {
+      if (group.name() != "topic_report")
+        continue;
+
+      std::string topic;
+      for (const auto &data : group.header().data())
+      {
+        if (data.key() == "topic" && data.value_size() > 0)
+          topic = data.value(0);
+      }
+      if (topic.empty())
+        continue;
+
+      Counters &counters = topics[topic];
+      for (const auto &stat : group.statistics())
+      {
+        if (stat.name() == "msgs_sent")
+          counters.msgs = stat.value();
+        else if (stat.name() == "bytes_sent")
+          counters.bytes = stat.value();
+      }
+    }
+
+    const double stamp = static_cast<double>(_msg.header().stamp().sec()) +
+      static_cast<double>(_msg.header().stamp().nsec()) * 1e-9;
+
+    std::lock_guard<std::mutex> lk(mutex);
+    Report &report = reports[pUuid];
+    report.prevStamp = report.stamp;
+    report.prevTopics = std::move(report.topics);
+    report.stamp = stamp;
+    report.topics = std::move(topics);
+    report.received = Clock::now();
+  };
+
+  // The reports of all the partitions share a partition.
+  NodeOptions opts;
+  opts.SetPartition(NodeShared::kTopicReportPartition);
+  Node node(opts);
+  if (!node.Subscribe(NodeShared::kTopicReportTopic, cb))
+    return;
+
+  /// \brief One line of the table.
+  struct Row
+  {
+    std::string partition;
+    std::string topic;
+    double msgsRate = 0;
+    double bytesRate = 0;
+    int publishers = 0;
+  };
+
+#ifndef _WIN32
+  const bool terminal = isatty(STDOUT_FILENO);
+#else
+  const bool terminal = false;
+#endif
+
+  const auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(_duration));
+  while (_duration <= 0 || Clock::now() < end)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    // The rates are the differences between the last two reports of every
+    // process, summed over the processes publishing the same topic.
+    std::map<std::string, Row> topics;
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      const auto now = Clock::now();
+      for (auto it = reports.begin(); it != reports.end();)
+      {
+        // The process exited or stopped publishing.
+        if (now - it->second.received > std::chrono::seconds(3))
+        {
+          it = reports.erase(it);
+          continue;
+        }
+
+        const Report &report = it->second;
+        const double elapsed = report.stamp - report.prevStamp;
+        for (const auto &[name, counters] : report.topics)
+        {
+          auto prev = report.prevTopics.find(name);
+          if (report.prevStamp <= 0 || elapsed <= 0 ||
+              prev == report.prevTopics.end())
+          {
+            continue;
+          }
+
+          Row &row = topics[name];
+          row.msgsRate += std::max(0.0, counters.msgs - prev->second.msgs) /
+            elapsed;
+          row.bytesRate += std::max(0.0,
+            counters.bytes - prev->second.bytes) / elapsed;
+          ++row.publishers;
+        }
+        ++it;
+      }
+    }
+
+    std::vector<Row> rows;
+    for (auto &[name, row] : topics)
+    {
+      if (!TopicUtils::DecomposeFullyQualifiedTopic(name, row.partition,
+            row.topic))
+      {
+        continue;
+      }
+      if (!row.partition.empty() && row.partition.front() == '/')
+        row.partition.erase(0, 1);
+      rows.push_back(std::move(row));
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row &_a, const Row &_b)
+    {
+      if (_a.bytesRate != _b.bytesRate)
+        return _a.bytesRate > _b.bytesRate;
+      if (_a.msgsRate != _b.msgsRate)
+        return _a.msgsRate > _b.msgsRate;
+      return _a.topic < _b.topic;
+    });
+    if (_count > 0 && rows.size() > static_cast<std::size_t>(_count))
+      rows.resize(static_cast<std::size_t>(_count));
+
+    // Redraw the table in place, like top.
+    if (terminal)
+      std::cout << "\033[2J\033[H";
+    else
+      std::cout << std::endl;
+
+    if (rows.empty())
+    {
+      std::cout << "no topic reported" << std::endl;
+      continue;
+    }
+
+    std::cout << std::left << std::setw(24) << "PARTITION"
+              << std::setw(40) << "TOPIC" << std::right
+              << std::setw(12) << "MSGS/S" << std::setw(14) << "BW"
+              << std::setw(6) << "PUBS" << std::endl;
+    for (const Row &row : rows)
+    {
+      std::cout << std::left << std::setw(24) << row.partition
+                << std::setw(40) << row.topic << std::right
+                << std::fixed << std::setprecision(1)
+                << std::setw(12) << row.msgsRate
+                << std::setw(14) << formatBytes(row.bytesRate) + "/s"
+                << std::setw(6) << row.publishers << std::endl;
+    }
+  }
+}
+
 //////////////////////////////////////////////////
 extern "C" const char *gzVersion()
 {
@@ -49,6 +49,27 @@ extern "C" void cmdTopicPub(const char *_topic,
                             const char *_msgType,
                             const char *_msgData);
 
+/// \brief External hook to execute 'gz topic -p' with --rate, --num or
+/// --size from the command line. The message is serialized once and
+/// published repeatedly with PublishRaw, to generate traffic.
+/// \param[in] _topic Topic name.
+/// \param[in] _msgType Message type.
+/// \param[in] _msgData The format expected is the same used by Protobuf
+/// DebugString().
+/// \param[in] _rate Messages per second. A value <= 0 publishes as fast as
+/// possible.
+/// \param[in] _count Number of messages to publish. A value <= 0 publishes
+/// until the process is interrupted.
+/// \param[in] _size Size in bytes of each serialized message. The message
+/// is padded with an unknown field, which subscribers ignore. A value <= 0
+/// publishes the message as is.
+extern "C" void cmdTopicPubLoop(const char *_topic,
+                                const char *_msgType,
+                                const char *_msgData,
+                                const double _rate,
+                                int _count,
+                                int _size);
+
 /// \brief External hook to execute 'gz service -r' from the command line.
 /// \param[in] _service Service name.
 /// \param[in] _reqType Message type used in the request.
@@ -67,6 +88,30 @@ extern "C" void cmdServiceReq(const char *_service,
                               const int _timeout,
                               const char *_reqData);
 
+/// \brief External hook to execute 'gz service --bench' from the command
+/// line. It drives a service with concurrent blocking requests and reports
+/// the throughput and the latency percentiles.
+/// \param[in] _service Service name.
+/// \param[in] _reqType Message type used in the request.
+/// \param[in] _repType Message type used in the response.
+/// \param[in] _timeout Every request will timeout after '_timeout' ms.
+/// \param[in] _reqData Input data sent in all the requests.
+/// The format expected is the same used by Protobuf DebugString().
+/// \param[in] _concurrency Number of requests in flight.
+/// \param[in] _qps Target number of requests per second, across all the
+/// workers. A value <= 0 sends the requests as fast as possible.
+/// \param[in] _duration Seconds to run. Ignored if _count > 0.
+/// \param[in] _count Number of requests to send.
+extern "C" void cmdServiceBench(const char *_service,
+                                const char *_reqType,
+                                const char *_repType,
+                                const int _timeout,
+                                const char *_reqData,
+                                int _concurrency,
+                                double _qps,
+                                double _duration,
+                                int _count);
+
 extern "C" {
   /// \brief Enum used for specifing the message output format for functions
   /// like cmdTopicEcho.
@@ -78,7 +123,18 @@ extern "C" {
     kDebugString,
 
     // JSON output.
-    kJSON
+    kJSON,
+
+    // Type and size of each message. Messages are not deserialized.
+    kSize,
+
+    // Type, size and hexadecimal dump of the serialized data of each
+    // message. Messages are not deserialized.
+    kHex,
+
+    // Message and byte rates, printed once per second. Messages are not
+    // deserialized.
+    kRate
   };
 }
 
@@ -94,10 +150,58 @@ extern "C" {
 extern "C" void cmdTopicEcho(const char *_topic, const double _duration,
                              int _count, MsgOutputFormat _outputFormat);
 
+/// \brief External hook to execute 'gz topic -e --sample' from the command
+/// line. Same as cmdTopicEcho, but the topic is subscribed to as raw bytes
+/// and a message is only deserialized when it is printed.
+/// \param[in] _topic Topic name.
+/// \param[in] _duration Duration (seconds) to run. A value <= 0 indicates
+/// no time limit. The _duration parameter overrides the _count parameter.
+/// \param[in] _count Number of messages to echo and then stop. A value <= 0
+/// indicates no limit. The _duration parameter overrides the _count
+/// parameter. Messages skipped by sampling are not counted.
+/// \param[in] _outputFormat Message output format.
+/// \param[in] _sampleRate Maximum number of messages (per second) to print.
+/// The other messages are dropped without being deserialized. A value <= 0
+/// prints every message.
+extern "C" void cmdTopicEchoSampled(const char *_topic,
+                                    const double _duration,
+                                    int _count,
+                                    MsgOutputFormat _outputFormat,
+                                    const double _sampleRate);
+
 /// \brief External hook to execute 'gz topic -f' from the command line.
 /// \param[in] _topic Topic name.
 extern "C" void cmdTopicFrequency(const char *_topic);
 
+/// \brief External hook to execute 'gz topic --bw' from the command line.
+/// Subscribes to the raw bytes of the topic and prints once per second the
+/// message rate, the bandwidth, the percentiles of the reception interval
+/// and, when the publishers send their sequence numbers
+/// (GZ_TRANSPORT_TOPIC_STATISTICS=1), the number of dropped messages.
+/// The messages are never deserialized.
+/// \param[in] _topic Topic name.
+/// \param[in] _duration Duration (seconds) to run. A value <= 0 indicates
+/// no time limit.
+extern "C" void cmdTopicBandwidth(const char *_topic, const double _duration);
+
+/// \brief External hook to execute 'gz topic --profile' from the command
+/// line. Prints the callback profiles published by the processes that set
+/// GZ_TRANSPORT_CALLBACK_PROFILE=1, slowest handlers first.
+/// \param[in] _topic Topic name, or an empty string for all the topics.
+/// \param[in] _duration Duration (seconds) to collect the profiles. A value
+/// <= 0 waits for two profile periods.
+extern "C" void cmdTopicProfile(const char *_topic, const double _duration);
+
+/// \brief External hook to execute 'gz topic --top' from the command line.
+/// Prints once per second the topics of every partition, sorted by the
+/// bandwidth of their remote publications, from the reports of their
+/// publishers (NodeShared::kTopicReportTopic). No topic is subscribed.
+/// \param[in] _duration Duration (seconds) to run. A value <= 0 indicates
+/// no time limit.
+/// \param[in] _count Maximum number of topics printed. A value <= 0
+/// prints all of them.
+extern "C" void cmdTopicTop(const double _duration, int _count);
+
 /// \brief External hook to read the library version.
 /// \return C-string representing the version. Ex.: 0.1.2
 extern "C" const char *gzVersion();
@@ -444,6 +444,26 @@ TEST(gzTest, TopicEcho)
   EXPECT_TRUE(output.cout.find("z: 3") != std::string::npos);
 }
 
+//////////////////////////////////////////////////
+/// \brief Check 'gz topic --bw' running a publisher with the default
+/// settings on a separate process: it doesn't send its metadata, so no drops
+/// are reported.
+TEST(gzTest, TopicBandwidth)
+{
+  // Launch a new publisher process that advertises a topic.
+  auto proc = gz::utils::Subprocess(
+    {test_executables::kTwoProcsPublisher, g_partition});
+
+  auto output = custom_exec_str(
+    {"topic", "--bw", "-t", "/foo", "-d", "3"});
+
+  // Three doubles, of 9 bytes each when serialized.
+  EXPECT_NE(std::string::npos, output.cout.find("rate: ")) << output.cout;
+  EXPECT_NE(std::string::npos, output.cout.find("mean size: 27.00 B"))
+    << output.cout;
+  EXPECT_EQ(std::string::npos, output.cout.find("drops: ")) << output.cout;
+}
+
 //////////////////////////////////////////////////
 /// \brief Check 'gz topic -e -n 2' running the publisher on a separate
 /// process.
@@ -18,8 +18,12 @@
 
 #include <gz/msgs/int32.pb.h>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <future>
 #include <string>
+#include <thread>
 #include <iostream>
 #include <sstream>
 
@@ -226,6 +230,49 @@ TEST(gzTest, cmdServiceReq)
   restoreIO();
 }
 
+//////////////////////////////////////////////////
+/// \brief Check cmdServiceBench running the advertiser on a the same process.
+TEST(gzTest, cmdServiceBench)
+{
+  std::stringstream  stdOutBuffer;
+  std::stringstream  stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  cmdServiceBench(nullptr, g_intType.c_str(), g_intType.c_str(), 1000,
+    g_reqData.c_str(), 1, -1, 1, -1);
+  EXPECT_EQ(stdErrBuffer.str(), "Service name is null\n");
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  transport::Node node;
+  std::function<bool(const msgs::Int32 &, msgs::Int32 &)> echo =
+    [](const msgs::Int32 &_req, msgs::Int32 &_rep)
+    {
+      _rep.set_data(_req.data());
+      return true;
+    };
+  const std::string service = "/bench";
+  ASSERT_TRUE(node.Advertise(service, echo));
+
+  cmdServiceBench(service.c_str(), g_intType.c_str(), g_intType.c_str(),
+    1000, g_reqData.c_str(), 4, -1, -1, 200);
+  EXPECT_TRUE(stdErrBuffer.str().empty()) << stdErrBuffer.str();
+  EXPECT_NE(std::string::npos, stdOutBuffer.str().find(
+    "requests: 200 (200 ok, 0 failed, 0 timed out)")) << stdOutBuffer.str();
+  EXPECT_NE(std::string::npos, stdOutBuffer.str().find("latency (us): p50"));
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  // The rate is limited to 100 requests per second.
+  const auto start = std::chrono::steady_clock::now();
+  cmdServiceBench(service.c_str(), g_intType.c_str(), g_intType.c_str(),
+    1000, g_reqData.c_str(), 2, 100, -1, 50);
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(450));
+  EXPECT_NE(std::string::npos, stdOutBuffer.str().find("50 ok"))
+    << stdOutBuffer.str();
+
+  restoreIO();
+}
+
 //////////////////////////////////////////////////
 /// \brief Check cmdTopicEcho running the advertiser on a the same process.
 TEST(gzTest, cmdTopicEcho)
@@ -285,6 +332,122 @@ TEST(gzTest, cmdTopicEchoOutputFormats)
 
   clearIOStreams(stdOutBuffer, stdErrBuffer);
 
+  // The raw formats print the serialized message: field 1, varint 10.
+  auto sizeOutput = std::async(std::launch::async, getSubscriberOutput,
+                               MsgOutputFormat::kSize);
+
+  cmdTopicPub(g_topic.c_str(), g_intType.c_str(), msg.DebugString().c_str());
+  EXPECT_EQ("gz.msgs.Int32, 2 bytes\n", sizeOutput.get());
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  auto hexOutput = std::async(std::launch::async, getSubscriberOutput,
+                              MsgOutputFormat::kHex);
+
+  cmdTopicPub(g_topic.c_str(), g_intType.c_str(), msg.DebugString().c_str());
+  EXPECT_EQ("gz.msgs.Int32, 2 bytes\n08 0a\n\n", hexOutput.get());
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  // Sampled messages are deserialized when they are printed.
+  auto sampledOutput = std::async(std::launch::async, [&]()
+  {
+    cmdTopicEchoSampled(g_topic.c_str(), 3.00, 1, MsgOutputFormat::kDefault,
+                        10);
+    return stdOutBuffer.str();
+  });
+
+  cmdTopicPub(g_topic.c_str(), g_intType.c_str(), msg.DebugString().c_str());
+  EXPECT_EQ("data: 10\n\n", sampledOutput.get());
+
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  restoreIO();
+}
+
+/////////////////////////////////////////////////
+TEST(gzTest, cmdTopicBandwidth)
+{
+  std::stringstream  stdOutBuffer;
+  std::stringstream  stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  cmdTopicBandwidth(nullptr, 1.0);
+  EXPECT_EQ(stdErrBuffer.str(), "Invalid topic. Topic must not be empty.\n");
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Int32>(g_topic);
+  ASSERT_TRUE(pub);
+
+  auto output = std::async(std::launch::async, [&]()
+  {
+    cmdTopicBandwidth(g_topic.c_str(), 2.5);
+    return stdOutBuffer.str();
+  });
+
+  msgs::Int32 msg;
+  msg.set_data(5);
+  const auto end =
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(2500);
+  while (std::chrono::steady_clock::now() < end)
+  {
+    pub.Publish(msg);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  const std::string report = output.get();
+  EXPECT_NE(std::string::npos, report.find("rate: ")) << report;
+  EXPECT_NE(std::string::npos, report.find("mean size: 2.00 B")) << report;
+
+  restoreIO();
+}
+
+/////////////////////////////////////////////////
+TEST(gzTest, cmdTopicPubLoop)
+{
+  std::stringstream  stdOutBuffer;
+  std::stringstream  stdErrBuffer;
+  redirectIO(stdOutBuffer, stdErrBuffer);
+
+  cmdTopicPubLoop(nullptr, g_intType.c_str(), g_reqData.c_str(), 10, 1, -1);
+  EXPECT_EQ(stdErrBuffer.str(), "Topic name is null\n");
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  // The target size is smaller than the message.
+  cmdTopicPubLoop(g_topic.c_str(), g_intType.c_str(), g_reqData.c_str(),
+                  10, 1, 1);
+  EXPECT_NE(std::string::npos, stdErrBuffer.str().find("Unable to publish"));
+  clearIOStreams(stdOutBuffer, stdErrBuffer);
+
+  std::atomic<int> received{0};
+  std::atomic<std::size_t> size{0};
+  std::function<void(const msgs::Int32 &)> cb =
+    [&](const msgs::Int32 &_msg)
+    {
+      EXPECT_EQ(10, _msg.data());
+      size = _msg.ByteSizeLong();
+      ++received;
+    };
+
+  transport::Node node;
+  ASSERT_TRUE(node.Subscribe(g_topic, cb));
+
+  cmdTopicPubLoop(g_topic.c_str(), g_intType.c_str(), g_reqData.c_str(),
+                  200, 20, 300);
+  EXPECT_TRUE(stdErrBuffer.str().empty()) << stdErrBuffer.str();
+  EXPECT_NE(std::string::npos,
+    stdOutBuffer.str().find("Published 20 messages of 300 bytes"))
+    << stdOutBuffer.str();
+
+  const auto end =
+    std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (received < 20 && std::chrono::steady_clock::now() < end)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(20, received);
+  // The padding is kept as an unknown field.
+  EXPECT_EQ(300u, size);
+
   restoreIO();
 }
 
@@ -30,6 +30,7 @@ enum class ServiceCommand
   kServiceList,
   kServiceInfo,
   kServiceReq,
+  kServiceBench,
 };
 
 //////////////////////////////////////////////////
@@ -53,6 +54,18 @@ struct ServiceOptions
 
   /// \brief Timeout to use when requesting (in milliseconds)
   int timeout{1000};
+
+  /// \brief Number of concurrent requests when benchmarking
+  int concurrency{1};
+
+  /// \brief Target requests per second when benchmarking
+  double qps{-1};
+
+  /// \brief Amount of time to benchmark (in seconds)
+  double duration{10};
+
+  /// \brief Number of requests to send when benchmarking
+  int count{-1};
 };
 
 //////////////////////////////////////////////////
@@ -90,6 +103,23 @@ void runServiceCommand(const ServiceOptions &_opt)
             _opt.timeout, _opt.reqData.c_str());
       }
       break;
+    case ServiceCommand::kServiceBench:
+      if (_opt.reqType.empty())
+      {
+        // No input service request.
+        cmdServiceBench(_opt.service.c_str(),
+            "gz.msgs.Empty", _opt.repType.c_str(),
+            _opt.timeout, "unused:true", _opt.concurrency, _opt.qps,
+            _opt.duration, _opt.count);
+      }
+      else
+      {
+        cmdServiceBench(_opt.service.c_str(),
+            _opt.reqType.c_str(), _opt.repType.c_str(),
+            _opt.timeout, _opt.reqData.c_str(), _opt.concurrency, _opt.qps,
+            _opt.duration, _opt.count);
+      }
+      break;
     case ServiceCommand::kNone:
     default:
       // In the event that there is no command, display help
@@ -106,8 +136,20 @@ void addServiceFlags(CLI::App &_app)
   auto serviceOpt = _app.add_option("-s,--service",
                                     opt->service, "Name of a service.");
   _app.add_option("--reqtype", opt->reqType, "Type of a request.");
-  _app.add_option("--reptype", opt->repType, "Type of a response.");
+  auto repTypeOpt = _app.add_option("--reptype", opt->repType,
+                                    "Type of a response.");
   _app.add_option("--timeout", opt->timeout, "Timeout in milliseconds.");
+  _app.add_option("--concurrency", opt->concurrency,
+                  "Number of concurrent requests with --bench.");
+  _app.add_option("--qps", opt->qps,
+                  "Target requests per second with --bench.\n"
+                  "By default, requests are sent as fast as possible.");
+  auto durationOpt = _app.add_option("-d,--duration", opt->duration,
+                                     "Duration (seconds) of --bench.");
+  auto countOpt = _app.add_option("-n,--num", opt->count,
+                                  "Number of requests to send with --bench.");
+  durationOpt->excludes(countOpt);
+  countOpt->excludes(durationOpt);
 
   auto command = _app.add_option_group("command", "Command to be executed.");
 
@@ -140,6 +182,25 @@ the same used by Protobuf DebugString(). E.g.:
     ->needs(serviceOpt)
     ->expected(0, 1);
 
+  command->add_option_function<std::string>("--bench",
+      [opt](const std::string &_reqData){
+        opt->command = ServiceCommand::kServiceBench;
+        opt->reqData = _reqData;
+      },
+R"(Benchmark a service.
+TEXT is the input data of all the requests.
+Reports the throughput and latency percentiles.
+E.g.:
+  gz service -s /echo \
+    --reqtype gz.msgs.StringMsg \
+    --reptype gz.msgs.StringMsg \
+    --concurrency 8 --qps 2000 -d 10 \
+    --bench 'data: "Hello"'
+)")
+    ->needs(serviceOpt)
+    ->needs(repTypeOpt)
+    ->expected(0, 1);
+
   _app.callback([opt](){runServiceCommand(*opt); });
 }
 
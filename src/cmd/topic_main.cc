@@ -33,7 +33,10 @@ enum class TopicCommand
   kTopicInfo,
   kTopicPub,
   kTopicEcho,
-  kTopicFrequency
+  kTopicFrequency,
+  kTopicBandwidth,
+  kTopicProfile,
+  kTopicTop
 };
 
 //////////////////////////////////////////////////
@@ -55,11 +58,20 @@ struct TopicOptions
   /// \brief Amount of time to echo (in seconds)
   double duration{-1};
 
-  /// \brief Number of messages to echo
+  /// \brief Number of messages to echo or publish
   int count{-1};
 
   /// \brief Message output format
   MsgOutputFormat msgOutputFormat {MsgOutputFormat::kDefault};
+
+  /// \brief Maximum number of messages per second to echo
+  double sampleRate{-1};
+
+  /// \brief Messages per second to publish
+  double pubRate{-1};
+
+  /// \brief Size in bytes of the published messages
+  int pubSize{-1};
 };
 
 //////////////////////////////////////////////////
@@ -75,17 +87,43 @@ void runTopicCommand(const TopicOptions &_opt)
       cmdTopicInfo(_opt.topic.c_str());
       break;
     case TopicCommand::kTopicPub:
-      cmdTopicPub(_opt.topic.c_str(),
-                  _opt.msgType.c_str(),
-                  _opt.msgData.c_str());
+      if (_opt.pubRate > 0 || _opt.count > 0 || _opt.pubSize > 0)
+      {
+        cmdTopicPubLoop(_opt.topic.c_str(), _opt.msgType.c_str(),
+                        _opt.msgData.c_str(), _opt.pubRate, _opt.count,
+                        _opt.pubSize);
+      }
+      else
+      {
+        cmdTopicPub(_opt.topic.c_str(),
+                    _opt.msgType.c_str(),
+                    _opt.msgData.c_str());
+      }
       break;
     case TopicCommand::kTopicEcho:
-      cmdTopicEcho(_opt.topic.c_str(), _opt.duration, _opt.count,
-                   _opt.msgOutputFormat);
+      if (_opt.sampleRate > 0)
+      {
+        cmdTopicEchoSampled(_opt.topic.c_str(), _opt.duration, _opt.count,
+                            _opt.msgOutputFormat, _opt.sampleRate);
+      }
+      else
+      {
+        cmdTopicEcho(_opt.topic.c_str(), _opt.duration, _opt.count,
+                     _opt.msgOutputFormat);
+      }
       break;
     case TopicCommand::kTopicFrequency:
       cmdTopicFrequency(_opt.topic.c_str());
       break;
+    case TopicCommand::kTopicBandwidth:
+      cmdTopicBandwidth(_opt.topic.c_str(), _opt.duration);
+      break;
+    case TopicCommand::kTopicProfile:
+      cmdTopicProfile(_opt.topic.c_str(), _opt.duration);
+      break;
+    case TopicCommand::kTopicTop:
+      cmdTopicTop(_opt.duration, _opt.count);
+      break;
     case TopicCommand::kNone:
     default:
       // In the event that there is no command, display help
@@ -105,9 +143,35 @@ void addTopicFlags(CLI::App &_app)
   auto durationOpt = _app.add_option("-d,--duration",
                                      opt->duration,
                                      "Duration (seconds) to run.");
-  auto countOpt = _app.add_option("-n,--num",
+  auto countOpt = _app.add_option("-n,--num,--count",
                                   opt->count,
-                                  "Number of messages to echo and then exit.");
+                                  "Number of messages to echo or publish\n"
+                                  "and then exit.");
+
+  _app.add_option("--sample",
+                  opt->sampleRate,
+R"(Maximum number of messages per second to echo.
+The other messages are dropped without being
+deserialized. E.g.:
+  gz topic -e -t /foo --sample 2)");
+
+  _app.add_option("--rate",
+                  opt->pubRate,
+R"(Messages per second to publish with -p. The message
+is serialized once and published until -n messages
+are sent or the command is interrupted. Without
+--rate the messages are published as fast as
+possible. E.g.:
+  gz topic -t /foo -m gz.msgs.Int32 -p 'data:1' \
+    --rate 1000 -n 10000)");
+
+  _app.add_option("--size",
+                  opt->pubSize,
+R"(Size in bytes of each message published with -p.
+The message is padded with a field that subscribers
+ignore. E.g.:
+  gz topic -t /foo -m gz.msgs.Int32 -p 'data:1' \
+    --rate 100 --size 65536)");
 
   durationOpt->excludes(countOpt);
   countOpt->excludes(durationOpt);
@@ -144,10 +208,56 @@ R"(Calculate the frequency of a topic:
   gz topic -f -t /foo)")
     ->needs(topicOpt);
 
+  command->add_flag_callback("--bw,--hz",
+    [opt](){
+      opt->command = TopicCommand::kTopicBandwidth;
+    },
+R"(Measure the rate, bandwidth, reception jitter and drops
+of a topic without deserializing its messages. Drops are
+reported when the publishers run with
+GZ_TRANSPORT_MESSAGE_METADATA=1. E.g.:
+  gz topic --bw -t /foo -d 10)")
+    ->needs(topicOpt);
+
+  command->add_flag_callback("--profile",
+    [opt](){
+      opt->command = TopicCommand::kTopicProfile;
+    },
+R"(Show the execution time of the subscription callbacks of
+the processes that set GZ_TRANSPORT_CALLBACK_PROFILE=1,
+slowest first. Optionally filter by topic. E.g.:
+  gz topic --profile -t /foo -d 5)");
+
+  command->add_flag_callback("--top",
+    [opt](){
+      opt->command = TopicCommand::kTopicTop;
+    },
+R"(Show the rate and bandwidth of all the topics of all the
+partitions, highest bandwidth first, refreshed every
+second. The publishers report their counters when they
+run with GZ_TRANSPORT_TOPIC_REPORT=1, no topic is
+subscribed. -n limits the number of topics. E.g.:
+  gz topic --top -n 20)");
+
   command->add_flag_callback("--json-output",
       [opt]() { opt->msgOutputFormat = MsgOutputFormat::kJSON; },
       "Output messages in JSON format.");
 
+  command->add_flag_callback("--size-output",
+      [opt]() { opt->msgOutputFormat = MsgOutputFormat::kSize; },
+      "Output only the type and size of the messages,\n"
+      "without deserializing them.");
+
+  command->add_flag_callback("--hex-output",
+      [opt]() { opt->msgOutputFormat = MsgOutputFormat::kHex; },
+      "Output the serialized messages in hexadecimal,\n"
+      "without deserializing them.");
+
+  command->add_flag_callback("--rate-output",
+      [opt]() { opt->msgOutputFormat = MsgOutputFormat::kRate; },
+      "Output the message and byte rates once per second,\n"
+      "without deserializing the messages.");
+
   command->add_option_function<std::string>("-p,--pub",
       [opt](const std::string &_msgData){
         opt->command = TopicCommand::kTopicPub;
@@ -55,9 +55,14 @@ GZ_SERVICE_COMPLETION_LIST="
   --reqtype
   --reptype
   --timeout
+  --concurrency
+  --qps
+  -d --duration
+  -n --num
   -l --list
   -i --info
   -r --req
+  --bench
 "
 
 GZ_TOPIC_COMPLETION_LIST="
@@ -66,12 +71,23 @@ GZ_TOPIC_COMPLETION_LIST="
   -m --msgtype
   -d --duration
   -n --num
+  --count
   -l --list
   -i --info
   -e --echo
   -p --pub
   -v --version
   --json-output
+  --size-output
+  --hex-output
+  --rate-output
+  --sample
+  --rate
+  --size
+  --bw
+  --hz
+  --profile
+  --top
 "
 
 function __get_comp_from_list {
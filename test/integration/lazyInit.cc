@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <string>
+
+#include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/Node.hh"
+#include "gz/transport/NodeShared.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief A process that only advertises topics of its own scope doesn't
+/// open the network, even with the topic report enabled.
+TEST(lazyInit, ProcessScopeKeepsNetworkClosed)
+{
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetScope(transport::Scope_t::PROCESS);
+  auto pub = node.Advertise<msgs::Int32>("/process_only", opts);
+  ASSERT_TRUE(pub);
+
+  msgs::Int32 msg;
+  msg.set_data(1);
+  EXPECT_TRUE(pub.Publish(msg));
+
+  // The publisher socket is bound when the network starts.
+  EXPECT_TRUE(transport::NodeShared::Instance()->myAddress.empty());
+
+  // A topic leaving the process opens it.
+  auto remotePub = node.Advertise<msgs::Int32>("/remote");
+  ASSERT_TRUE(remotePub);
+  EXPECT_FALSE(transport::NodeShared::Instance()->myAddress.empty());
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // Create the network resources on first use, and report the topics.
+  gz::utils::setenv("GZ_TRANSPORT_LAZY_INIT", "1");
+  gz::utils::setenv("GZ_TRANSPORT_TOPIC_REPORT", "1");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "test_utils.hh"
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+/// \brief A slow local callback should not delay the callbacks of other
+/// topics when the local callbacks are executed by the dispatcher pool.
+TEST(LocalDispatch, SlowTopicDoesNotBlockOthers)
+{
+  transport::Node node;
+  auto slowPub = node.Advertise<msgs::Int32>("/slow");
+  auto fastPub = node.Advertise<msgs::Int32>("/fast");
+  ASSERT_TRUE(slowPub);
+  ASSERT_TRUE(fastPub);
+
+  std::atomic<bool> slowRunning{false};
+  std::atomic<bool> slowDone{false};
+  std::atomic<int> fastCount{0};
+  std::atomic<int> lastFast{-1};
+  std::atomic<bool> outOfOrder{false};
+
+  std::function<void(const msgs::Int32 &)> slowCb =
+    [&](const msgs::Int32 &)
+    {
+      slowRunning = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      slowDone = true;
+    };
+
+  std::function<void(const msgs::Int32 &)> fastCb =
+    [&](const msgs::Int32 &_msg)
+    {
+      // Publications on the same topic must keep their order.
+      if (_msg.data() != lastFast + 1)
+        outOfOrder = true;
+      lastFast = _msg.data();
+      ++fastCount;
+    };
+
+  EXPECT_TRUE(node.Subscribe("/slow", slowCb));
+  EXPECT_TRUE(node.Subscribe("/fast", fastCb));
+
+  msgs::Int32 msg;
+  msg.set_data(0);
+  EXPECT_TRUE(slowPub.Publish(msg));
+
+  // Wait until the slow callback is running.
+  for (int i = 0; i < 100 && !slowRunning; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_TRUE(slowRunning);
+
+  const int kFastMsgs = 50;
+  for (int i = 0; i < kFastMsgs; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(fastPub.Publish(msg));
+  }
+
+  for (int i = 0; i < 100 && fastCount < kFastMsgs; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+  // All the fast messages were delivered while the slow callback was still
+  // running.
+  EXPECT_EQ(kFastMsgs, fastCount);
+  EXPECT_FALSE(slowDone);
+  EXPECT_FALSE(outOfOrder);
+
+  for (int i = 0; i < 100 && !slowDone; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_TRUE(slowDone);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  std::string partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // Run the local callbacks on a thread pool.
+  gz::utils::setenv("GZ_TRANSPORT_DISPATCH_THREADS", "2");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
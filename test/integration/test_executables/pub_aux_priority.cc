@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/stringmsg.pb.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+
+using namespace gz;
+
+static std::string g_bulkTopic = "/map"; // NOLINT(*)
+static std::string g_commandTopic = "/cmd"; // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief A publisher node that interleaves large messages on a regular
+/// topic with small messages on a high priority topic.
+void advertiseAndPublish()
+{
+  transport::Node node;
+  auto bulkPub = node.Advertise<msgs::StringMsg>(g_bulkTopic);
+
+  transport::AdvertiseMessageOptions opts;
+  opts.SetHighPriority(true);
+  auto commandPub = node.Advertise<msgs::Int32>(g_commandTopic, opts);
+
+  // Give the subscribers some time to join.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  msgs::StringMsg bulk;
+  bulk.set_data(std::string(4 * 1024 * 1024, 'x'));
+  msgs::Int32 command;
+  for (auto i = 0; i < 200; ++i)
+  {
+    if (i % 10 == 0)
+    {
+      EXPECT_TRUE(bulkPub.Publish(bulk));
+    }
+
+    command.set_data(i);
+    EXPECT_TRUE(commandPub.Publish(command));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "Partition name has not be passed as argument" << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this test.
+  gz::utils::setenv("GZ_PARTITION", argv[1]);
+
+  advertiseAndPublish();
+}
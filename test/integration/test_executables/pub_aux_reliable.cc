@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+
+using namespace gz;
+
+static std::string g_topic = "/foo"; // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief A publisher node that sends a burst of messages on a reliable
+/// topic once a subscriber is connected, then stays alive to answer the
+/// retransmission requests.
+void advertiseAndPublish()
+{
+  transport::Node node;
+  transport::AdvertiseMessageOptions opts;
+  opts.SetReliableDepth(1000u);
+
+  auto pub = node.Advertise<msgs::Int32>(g_topic, opts);
+
+  for (auto i = 0; i < 50 && !pub.HasConnections(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // Give the subscription some time to reach our socket.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  msgs::Int32 msg;
+  for (auto i = 0; i < 1000; ++i)
+  {
+    msg.set_data(i);
+    EXPECT_TRUE(pub.Publish(msg));
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5000));
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    std::cerr << "Partition name has not be passed as argument" << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this test.
+  gz::utils::setenv("GZ_PARTITION", argv[1]);
+
+  advertiseAndPublish();
+}
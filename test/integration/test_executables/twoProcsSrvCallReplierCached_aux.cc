@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+
+using namespace gz;
+
+static transport::Node *g_node = nullptr;
+static int g_calls = 0;
+
+//////////////////////////////////////////////////
+/// \brief Reply with the number of executions of the service. A negative
+/// request invalidates the cached responses first.
+bool srvCounter(const msgs::Int32 &_req, msgs::Int32 &_rep)
+{
+  if (_req.data() < 0)
+  {
+    EXPECT_TRUE(g_node->InvalidateServiceCache("/counter"));
+  }
+
+  _rep.set_data(++g_calls);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void runReplier(const int _ttlMs)
+{
+  transport::AdvertiseServiceOptions opts;
+  opts.SetIdempotent(true, std::chrono::milliseconds(_ttlMs));
+
+  transport::Node node;
+  g_node = &node;
+  EXPECT_TRUE(node.Advertise("/counter", srvCounter, opts));
+  std::this_thread::sleep_for(std::chrono::milliseconds(8000));
+  g_node = nullptr;
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc != 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <partition> <ttl_ms>"
+              << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this test.
+  gz::utils::setenv("GZ_PARTITION", argv[1]);
+
+  runReplier(std::stoi(argv[2]));
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+
+using namespace gz;
+
+static transport::Node *node = nullptr;
+static std::atomic<int> executed{0};
+
+//////////////////////////////////////////////////
+/// \brief Reply with the time left before the deadline of the request
+/// (milliseconds), or -1 if it has none.
+bool srvRemaining(const msgs::Int32 &/*_req*/, msgs::Int32 &_rep)
+{
+  const auto remaining = transport::ServiceContext::Remaining();
+  if (remaining == std::chrono::milliseconds::max())
+  {
+    _rep.set_data(-1);
+  }
+  else
+  {
+    _rep.set_data(static_cast<int>(std::min<int64_t>(remaining.count(),
+      std::numeric_limits<int>::max())));
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Call another service with a long timeout. The nested call is
+/// bounded by the deadline of this one.
+bool srvChain(const msgs::Int32 &_req, msgs::Int32 &_rep)
+{
+  bool result = false;
+  return node->Request("/remaining", _req, 60000u, _rep, result) && result;
+}
+
+//////////////////////////////////////////////////
+/// \brief A slow service.
+bool srvSlow(const msgs::Int32 &_req, msgs::Int32 &_rep)
+{
+  ++executed;
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  _rep.set_data(_req.data());
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Reply with the number of slow requests executed.
+bool srvExecuted(const msgs::Int32 &/*_req*/, msgs::Int32 &_rep)
+{
+  _rep.set_data(executed);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void runReplier()
+{
+  transport::Node replier;
+  node = &replier;
+  EXPECT_TRUE(replier.Advertise("/remaining", srvRemaining));
+  EXPECT_TRUE(replier.Advertise("/chain", srvChain));
+  EXPECT_TRUE(replier.Advertise("/executed", srvExecuted));
+
+  // The requests wait for the only worker.
+  transport::AdvertiseServiceOptions opts;
+  opts.SetConcurrency(1u);
+  EXPECT_TRUE(replier.Advertise("/slow", srvSlow, opts));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(8000));
+  node = nullptr;
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc != 2)
+  {
+    std::cerr << "Partition name has not be passed as argument" << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this test.
+  gz::utils::setenv("GZ_PARTITION", argv[1]);
+
+  runReplier();
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+
+using namespace gz;
+
+static int g_id = 0;
+static int g_delayMs = 0;
+
+//////////////////////////////////////////////////
+/// \brief Reply with the identifier of this responder.
+bool srvId(const msgs::Int32 &/*_req*/, msgs::Int32 &_rep)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(g_delayMs));
+  _rep.set_data(g_id);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void runReplier()
+{
+  transport::AdvertiseServiceOptions opts;
+  opts.SetConcurrency(4u);
+
+  transport::Node node;
+  EXPECT_TRUE(node.Advertise("/id", srvId, opts));
+  std::this_thread::sleep_for(std::chrono::milliseconds(8000));
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  if (argc != 4)
+  {
+    std::cerr << "Usage: " << argv[0] << " <partition> <id> <delay_ms>"
+              << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this test.
+  gz::utils::setenv("GZ_PARTITION", argv[1]);
+  g_id = std::stoi(argv[2]);
+  g_delayMs = std::stoi(argv[3]);
+
+  runReplier();
+}
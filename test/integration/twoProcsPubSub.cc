@@ -323,6 +323,33 @@ TEST(twoProcPubSub, FastPublisher)
   EXPECT_TRUE(node.Subscribe(g_topic, cbVector));
 }
 
+//////////////////////////////////////////////////
+/// \brief Unsubscribing from the last topic of a remote publisher drops the
+/// connection to it. Subscribing again has to connect again.
+TEST(twoProcPubSub, ResubscribeTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsPublisher, partition});
+
+  reset();
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cbVector));
+
+  // The first message is published after 500 ms.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  EXPECT_EQ(1, counter);
+
+  EXPECT_TRUE(node.Unsubscribe(g_topic));
+  EXPECT_TRUE(node.Subscribe(g_topic, cbVector));
+
+  // The second message is published after 2000 ms.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  EXPECT_EQ(2, counter);
+
+  reset();
+}
+
 //////////////////////////////////////////////////
 /// \brief This test creates one publisher and one subscriber on different
 /// processes. The publisher publishes at higher frequency than the rate set
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::mutex receivedMutex;
+static std::vector<int> received;  // NOLINT(*)
+static int rawCounter = 0;
+
+//////////////////////////////////////////////////
+/// \brief Function called each time a topic update is received.
+void cb(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  received.push_back(_msg.data());
+}
+
+//////////////////////////////////////////////////
+void cbRaw(const char *_msgData, const size_t _size,
+           const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(msgs::Int32().GetTypeName(), _info.Type());
+  msgs::Int32 msg;
+  EXPECT_TRUE(msg.ParseFromArray(_msgData, static_cast<int>(_size)));
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  ++rawCounter;
+}
+
+//////////////////////////////////////////////////
+/// \brief The messages of a batched publisher in another process are
+/// received one by one and in order, including the ones of the last partial
+/// batch.
+TEST(twoProcPubSubBatch, PubSubTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubBatched, partition});
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+  EXPECT_TRUE(node.SubscribeRaw(g_topic, cbRaw));
+
+  // The publisher sends its messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  ASSERT_EQ(205u, received.size());
+  for (int i = 0; i < 205; ++i)
+    EXPECT_EQ(i, received[i]);
+  EXPECT_EQ(205, rawCounter);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/vector3d.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static std::string g_FQNPartition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::atomic<int> counter{0};
+static std::mutex receivedMutex;
+static std::vector<int> received;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Function called each time a topic update is received.
+void cb(const msgs::Vector3d &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(g_topic, _info.Topic());
+  EXPECT_EQ(g_FQNPartition, _info.Partition());
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  EXPECT_FALSE(_info.IntraProcess());
+  EXPECT_DOUBLE_EQ(1.0, _msg.x());
+  EXPECT_DOUBLE_EQ(2.0, _msg.y());
+  EXPECT_DOUBLE_EQ(3.0, _msg.z());
+  ++counter;
+}
+
+//////////////////////////////////////////////////
+void cbInt(const msgs::Int32 &_msg)
+{
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  received.push_back(_msg.data());
+}
+
+//////////////////////////////////////////////////
+/// \brief Topic, type and sender are recovered from the topic ID of the
+/// compact header.
+TEST(twoProcPubSubCompact, PubSubTwoProcs)
+{
+  counter = 0;
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsPublisher, partition});
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+
+  // The publisher publishes two messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+
+  EXPECT_EQ(2, counter);
+}
+
+//////////////////////////////////////////////////
+/// \brief Batches also work with the compact header.
+TEST(twoProcPubSubCompact, PubSubBatched)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubBatched, partition});
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cbInt));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  ASSERT_EQ(205u, received.size());
+  for (int i = 0; i < 205; ++i)
+    EXPECT_EQ(i, received[i]);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+  g_FQNPartition = std::string("/") + partition;
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // Enable the compact header. The publishers inherit it.
+  gz::utils::setenv("GZ_TRANSPORT_COMPACT_HEADER", "1");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
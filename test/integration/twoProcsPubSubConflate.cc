@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::mutex receivedMutex;
+static std::vector<int> received;  // NOLINT(*)
+static std::vector<int> receivedRaw;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief A slow callback.
+void cb(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  {
+    std::lock_guard<std::mutex> lk(receivedMutex);
+    received.push_back(_msg.data());
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+//////////////////////////////////////////////////
+/// \brief A slow raw callback.
+void cbRaw(const char *_msgData, const size_t _size,
+           const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(msgs::Int32().GetTypeName(), _info.Type());
+  msgs::Int32 msg;
+  EXPECT_TRUE(msg.ParseFromArray(_msgData, static_cast<int>(_size)));
+  {
+    std::lock_guard<std::mutex> lk(receivedMutex);
+    receivedRaw.push_back(msg.data());
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that a message sequence only moves forward and ends with
+/// the last message published.
+void checkConflated(const std::vector<int> &_msgs)
+{
+  ASSERT_FALSE(_msgs.empty());
+  EXPECT_LT(_msgs.size(), 205u);
+  for (std::size_t i = 1; i < _msgs.size(); ++i)
+    EXPECT_LT(_msgs[i - 1], _msgs[i]);
+  EXPECT_EQ(204, _msgs.back());
+}
+
+//////////////////////////////////////////////////
+/// \brief Conflated subscribers with slow callbacks skip the messages
+/// superseded while their callback runs, but always get the latest one.
+TEST(twoProcPubSubConflate, PubSubTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubBatched, partition});
+
+  transport::SubscribeOptions opts;
+  opts.SetConflate(true);
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb, opts));
+  EXPECT_TRUE(node.SubscribeRaw(g_topic, cbRaw, msgs::Int32().GetTypeName(),
+    opts));
+
+  // The publisher sends its messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  checkConflated(received);
+  checkConflated(receivedRaw);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/vector3d.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::atomic<int> counter{0};
+static std::atomic<int> prefixCounter{0};
+
+//////////////////////////////////////////////////
+/// \brief Function called each time a topic update is received.
+void cb(const msgs::Vector3d &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(g_topic, _info.Topic());
+  EXPECT_FALSE(_info.IntraProcess());
+  EXPECT_DOUBLE_EQ(1.0, _msg.x());
+  EXPECT_DOUBLE_EQ(2.0, _msg.y());
+  EXPECT_DOUBLE_EQ(3.0, _msg.z());
+  ++counter;
+}
+
+//////////////////////////////////////////////////
+/// \brief Function called if a message of a topic sharing the prefix of
+/// the subscribed topic is delivered.
+void cbPrefix(const msgs::Vector3d &)
+{
+  ++prefixCounter;
+}
+
+//////////////////////////////////////////////////
+/// \brief The topic frame is terminated, and the subscriptions are exact.
+TEST(twoProcPubSubExact, PubSubTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsPublisher, partition});
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+  EXPECT_TRUE(node.Subscribe(g_topic.substr(0, 3), cbPrefix));
+
+  // The publisher publishes two messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+
+  EXPECT_EQ(2, counter);
+  EXPECT_EQ(0, prefixCounter);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // Enable the exact topics. The publisher inherits it.
+  gz::utils::setenv("GZ_TRANSPORT_EXACT_TOPICS", "1");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::mutex receivedMutex;
+static std::vector<int> received1;  // NOLINT(*)
+static std::vector<int> received2;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Callback of the first subscriber node.
+void cb1(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  received1.push_back(_msg.data());
+}
+
+//////////////////////////////////////////////////
+/// \brief Callback of the second subscriber node.
+void cb2(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  received2.push_back(_msg.data());
+}
+
+//////////////////////////////////////////////////
+/// \brief Late subscribers of a latched topic receive the last messages
+/// published, and only the new subscriber receives them.
+TEST(twoProcPubSubLatched, PubSubTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubLatched, partition});
+
+  // The publisher sends its messages before we subscribe.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+
+  const std::vector<int> expected = {2, 3, 4};
+
+  transport::Node node1;
+  EXPECT_TRUE(node1.Subscribe(g_topic, cb1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  {
+    std::lock_guard<std::mutex> lk(receivedMutex);
+    EXPECT_EQ(expected, received1);
+  }
+
+  transport::Node node2;
+  EXPECT_TRUE(node2.Subscribe(g_topic, cb2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+  {
+    std::lock_guard<std::mutex> lk(receivedMutex);
+    EXPECT_EQ(expected, received2);
+    EXPECT_EQ(expected, received1);
+  }
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
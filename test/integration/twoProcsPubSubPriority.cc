@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/stringmsg.pb.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_bulkTopic = "/map";  // NOLINT(*)
+static const std::string g_commandTopic = "/cmd";  // NOLINT(*)
+static std::mutex receivedMutex;
+static std::vector<int> commands;  // NOLINT(*)
+static int bulkCount = 0;
+
+//////////////////////////////////////////////////
+/// \brief Callback of the regular topic.
+void bulkCb(const msgs::StringMsg &_msg)
+{
+  EXPECT_EQ(4u * 1024u * 1024u, _msg.data().size());
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  ++bulkCount;
+}
+
+//////////////////////////////////////////////////
+/// \brief Callback of the high priority topic.
+void commandCb(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  commands.push_back(_msg.data());
+}
+
+//////////////////////////////////////////////////
+/// \brief A high priority topic and a regular topic published by another
+/// process are both received, each one in order.
+TEST(twoProcPubSubPriority, PubSubTwoProcs)
+{
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_bulkTopic, bulkCb));
+  EXPECT_TRUE(node.Subscribe(g_commandTopic, commandCb));
+
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubPriority, partition});
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5000));
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  EXPECT_GT(bulkCount, 0);
+  ASSERT_FALSE(commands.empty());
+  for (std::size_t i = 1; i < commands.size(); ++i)
+    EXPECT_LT(commands[i - 1], commands[i]);
+  EXPECT_EQ(199, commands.back());
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
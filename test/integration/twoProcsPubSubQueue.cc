@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::mutex receivedMutex;
+static std::vector<int> received;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief A slow callback.
+void cb(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  EXPECT_EQ(_msg.GetTypeName(), _info.Type());
+  {
+    std::lock_guard<std::mutex> lk(receivedMutex);
+    received.push_back(_msg.data());
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+//////////////////////////////////////////////////
+/// \brief A bounded best effort queue drops the oldest messages while the
+/// callback is busy, but keeps the order and the latest message.
+TEST(twoProcPubSubQueue, DropOldest)
+{
+  received.clear();
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubBatched, partition});
+
+  transport::SubscribeOptions opts;
+  opts.SetQueue(5u, transport::QueuePolicy_t::DROP_OLDEST);
+
+  transport::Node node;
+  EXPECT_TRUE(node.EnableStats(g_topic, true));
+  EXPECT_TRUE(node.Subscribe(g_topic, cb, opts));
+
+  // The publisher sends its messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  ASSERT_FALSE(received.empty());
+  EXPECT_LT(received.size(), 205u);
+  for (std::size_t i = 1; i < received.size(); ++i)
+    EXPECT_LT(received[i - 1], received[i]);
+  EXPECT_EQ(204, received.back());
+
+  auto stats = node.TopicStats(g_topic);
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(205u - received.size(), stats->DroppedMsgCount());
+}
+
+//////////////////////////////////////////////////
+/// \brief A keep all queue delivers every message in order.
+TEST(twoProcPubSubQueue, KeepAll)
+{
+  received.clear();
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubBatched, partition});
+
+  transport::SubscribeOptions opts;
+  opts.SetQueue(5u, transport::QueuePolicy_t::KEEP_ALL);
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb, opts));
+
+  // The publisher sends its messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  ASSERT_EQ(205u, received.size());
+  for (int i = 0; i < 205; ++i)
+    EXPECT_EQ(i, received[i]);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
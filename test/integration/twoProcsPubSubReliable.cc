@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::mutex receivedMutex;
+static std::set<int> received;  // NOLINT(*)
+static std::set<uint64_t> seqs;  // NOLINT(*)
+static int duplicates = 0;
+
+//////////////////////////////////////////////////
+/// \brief Slow callback, which makes the subscriber lose messages.
+void cb(const msgs::Int32 &_msg, const transport::MessageInfo &_info)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(500));
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  if (!received.insert(_msg.data()).second)
+    ++duplicates;
+  seqs.insert(_info.SequenceNumber());
+}
+
+//////////////////////////////////////////////////
+/// \brief A slow subscriber of a reliable topic receives every message
+/// exactly once, even if its queue overflows.
+TEST(twoProcPubSubReliable, PubSubTwoProcs)
+{
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kPubReliable, partition});
+
+  for (auto i = 0; i < 100; ++i)
+  {
+    {
+      std::lock_guard<std::mutex> lk(receivedMutex);
+      if (received.size() == 1000u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  std::lock_guard<std::mutex> lk(receivedMutex);
+  EXPECT_EQ(1000u, received.size());
+  EXPECT_EQ(1000u, seqs.size());
+  EXPECT_EQ(0, duplicates);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // A tiny queue, so the burst overflows it.
+  gz::utils::setenv("GZ_TRANSPORT_RCVHWM", "10");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
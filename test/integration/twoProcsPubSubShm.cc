@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/vector3d.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+#include "gz/transport/TransportTypes.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static std::atomic<int> counter{0};
+static std::atomic<int> rawCounter{0};
+
+//////////////////////////////////////////////////
+/// \brief Function called each time a topic update is received.
+void cb(const msgs::Vector3d &_msg)
+{
+  EXPECT_DOUBLE_EQ(1.0, _msg.x());
+  EXPECT_DOUBLE_EQ(2.0, _msg.y());
+  EXPECT_DOUBLE_EQ(3.0, _msg.z());
+  ++counter;
+}
+
+//////////////////////////////////////////////////
+void cbRaw(const char * /*_msgData*/, const size_t /*_size*/,
+           const transport::MessageInfo &_info)
+{
+  EXPECT_FALSE(_info.IntraProcess());
+  ++rawCounter;
+}
+
+//////////////////////////////////////////////////
+/// \brief Receive messages from a publisher on the same host when the shared
+/// memory transport is enabled in both processes. Every message must be
+/// delivered exactly once.
+TEST(twoProcPubSubShm, PubSubTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsPublisher, partition});
+
+  transport::Node node;
+  EXPECT_TRUE(node.Subscribe(g_topic, cb));
+  EXPECT_TRUE(node.SubscribeRaw(g_topic, cbRaw));
+
+  // The publisher publishes two messages during the next seconds.
+  std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+
+  EXPECT_EQ(2, counter);
+  EXPECT_EQ(2, rawCounter);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // Enable the shared memory transport. The publisher inherits it.
+  gz::utils::setenv("GZ_TRANSPORT_SHM", "1");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -18,8 +18,10 @@
 #include <gz/msgs/vector3d.pb.h>
 
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -142,6 +144,65 @@ TEST_F(twoProcSrvCall, SrvTwoProcs)
   reset();
 }
 
+//////////////////////////////////////////////////
+/// \brief This test spawns a service responser and a service requester. The
+/// requester sends a batch of requests in one message.
+TEST_F(twoProcSrvCall, SrvTwoProcsBatch)
+{
+  std::vector<msgs::Int32> reqs(10);
+  for (int i = 0; i < 10; ++i)
+    reqs[i].set_data(i);
+
+  std::vector<msgs::Int32> reps;
+  std::vector<bool> results;
+
+  transport::Node node;
+  ASSERT_TRUE(node.RequestBatch(g_topic, reqs, 5000u, reps, results));
+  ASSERT_EQ(10u, reps.size());
+  ASSERT_EQ(10u, results.size());
+  for (int i = 0; i < 10; ++i)
+  {
+    EXPECT_TRUE(results[i]);
+    EXPECT_EQ(i, reps[i].data());
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Request a streamed response from a regular service in another
+/// process. The response is a single chunk.
+TEST_F(twoProcSrvCall, SrvTwoProcsStream)
+{
+  msgs::Int32 req;
+  req.set_data(data);
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> chunks;
+  bool done = false;
+  bool doneResult = false;
+  std::function<void(const msgs::Int32 &)> chunkCb =
+    [&](const msgs::Int32 &_chunk)
+  {
+    std::lock_guard<std::mutex> lk(m);
+    chunks.push_back(_chunk.data());
+  };
+  std::function<void(const bool)> doneCb = [&](const bool _result)
+  {
+    std::lock_guard<std::mutex> lk(m);
+    done = true;
+    doneResult = _result;
+    cv.notify_one();
+  };
+
+  transport::Node node;
+  ASSERT_TRUE(node.RequestStream(g_topic, req, chunkCb, doneCb));
+
+  std::unique_lock<std::mutex> lk(m);
+  ASSERT_TRUE(cv.wait_for(lk, std::chrono::seconds(5), [&]{return done;}));
+  EXPECT_TRUE(doneResult);
+  EXPECT_EQ(std::vector<int>({data}), chunks);
+}
+
 //////////////////////////////////////////////////
 /// \brief This test spawns a service responser and a service requester. The
 /// requester uses a wrong type for the request argument. The test should verify
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Wait until a number of responders of the /id service are known.
+bool waitForResponders(transport::Node &_node, std::size_t _count)
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    std::vector<transport::ServicePublisher> publishers;
+    if (_node.ServiceInfo("/id", publishers) &&
+        publishers.size() >= _count)
+    {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+/// \brief Round-robin requests are shared by the responders.
+TEST(twoProcSrvCallBalancing, RoundRobin)
+{
+  auto pi1 = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierId, partition, "1", "0"});
+  auto pi2 = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierId, partition, "2", "0"});
+
+  transport::NodeOptions opts;
+  EXPECT_TRUE(opts.SetServiceBalancing("/id",
+    transport::ServiceBalancing_t::ROUND_ROBIN));
+  transport::Node node(opts);
+  ASSERT_TRUE(waitForResponders(node, 2u));
+
+  std::set<int> ids;
+  for (int i = 0; i < 10; ++i)
+  {
+    msgs::Int32 req;
+    msgs::Int32 rep;
+    bool result = false;
+    ASSERT_TRUE(node.Request("/id", req, 2000u, rep, result));
+    EXPECT_TRUE(result);
+    ids.insert(rep.data());
+  }
+
+  EXPECT_EQ((std::set<int>{1, 2}), ids);
+}
+
+//////////////////////////////////////////////////
+/// \brief Hedged requests are answered by the fast responder, even when
+/// they are first sent to the slow one.
+TEST(twoProcSrvCallBalancing, Hedged)
+{
+  auto pi1 = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierId, partition, "1", "3000"});
+  auto pi2 = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierId, partition, "2", "0"});
+
+  transport::NodeOptions opts;
+  EXPECT_TRUE(opts.SetServiceBalancing("/id",
+    transport::ServiceBalancing_t::HEDGED));
+  transport::Node node(opts);
+  ASSERT_TRUE(waitForResponders(node, 2u));
+
+  for (int i = 0; i < 4; ++i)
+  {
+    msgs::Int32 req;
+    msgs::Int32 rep;
+    bool result = false;
+    ASSERT_TRUE(node.Request("/id", req, 1000u, rep, result));
+    EXPECT_TRUE(result);
+    EXPECT_EQ(2, rep.data());
+  }
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Wait until the /counter service is known.
+bool waitForResponder(transport::Node &_node)
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    std::vector<transport::ServicePublisher> publishers;
+    if (_node.ServiceInfo("/counter", publishers) && !publishers.empty())
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+/// \brief Call the /counter service.
+/// \param[in] _node The requester.
+/// \param[in] _data The request.
+/// \return The number of executions of the service, or -1 on error.
+int counter(transport::Node &_node, const int _data)
+{
+  msgs::Int32 req;
+  req.set_data(_data);
+  msgs::Int32 rep;
+  bool result = false;
+  if (!_node.Request("/counter", req, 2000u, rep, result) || !result)
+    return -1;
+  return rep.data();
+}
+
+//////////////////////////////////////////////////
+/// \brief The responses are cached until they expire.
+TEST(twoProcSrvCallCached, Expiration)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierCached, partition, "500"});
+
+  transport::Node node;
+  ASSERT_TRUE(waitForResponder(node));
+
+  EXPECT_EQ(1, counter(node, 0));
+  EXPECT_EQ(1, counter(node, 0));
+
+  // Another request is not cached yet.
+  EXPECT_EQ(2, counter(node, 1));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(700));
+  EXPECT_EQ(3, counter(node, 0));
+}
+
+//////////////////////////////////////////////////
+/// \brief The responder invalidates the cached responses.
+TEST(twoProcSrvCallCached, Invalidation)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierCached, partition, "60000"});
+
+  transport::Node node;
+  ASSERT_TRUE(waitForResponder(node));
+
+  EXPECT_EQ(1, counter(node, 0));
+  EXPECT_EQ(1, counter(node, 0));
+
+  EXPECT_EQ(2, counter(node, -1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  ASSERT_TRUE(waitForResponder(node));
+  EXPECT_EQ(3, counter(node, 0));
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <future>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief The requests of a concurrent service run at the same time.
+TEST(twoProcSrvCallConcurrent, Parallel)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierConcurrent, partition});
+
+  transport::Node node;
+
+  // Wait for the service to be discovered.
+  msgs::Int32 req;
+  req.set_data(-1);
+  msgs::Int32 rep;
+  bool result = false;
+  ASSERT_TRUE(node.Request("/concurrent", req, 5000u, rep, result));
+  EXPECT_TRUE(result);
+
+  std::vector<std::future<std::optional<msgs::Int32>>> futures;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 4; ++i)
+  {
+    req.set_data(i);
+    futures.push_back(node.RequestAsync<msgs::Int32>("/concurrent", req));
+  }
+
+  for (int i = 0; i < 4; ++i)
+  {
+    ASSERT_EQ(std::future_status::ready,
+      futures[i].wait_for(std::chrono::seconds(3)));
+    auto reply = futures[i].get();
+    ASSERT_TRUE(reply);
+    EXPECT_EQ(i, reply->data());
+  }
+
+  // Executed one after the other, the requests would take 2 seconds.
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+    std::chrono::milliseconds(1500));
+}
+
+//////////////////////////////////////////////////
+/// \brief The requests beyond the waiting limit fail right away.
+TEST(twoProcSrvCallConcurrent, Bounded)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierConcurrent, partition});
+
+  transport::Node node;
+
+  // Wait for the service to be discovered.
+  msgs::Int32 req;
+  msgs::Int32 rep;
+  bool result = false;
+  ASSERT_TRUE(node.Request("/bounded", req, 5000u, rep, result));
+  EXPECT_TRUE(result);
+
+  std::vector<std::future<std::optional<msgs::Int32>>> futures;
+  for (int i = 0; i < 4; ++i)
+  {
+    req.set_data(i);
+    futures.push_back(node.RequestAsync<msgs::Int32>("/bounded", req));
+  }
+
+  int succeeded = 0;
+  for (auto &future : futures)
+  {
+    ASSERT_EQ(std::future_status::ready,
+      future.wait_for(std::chrono::seconds(3)));
+    if (future.get())
+      ++succeeded;
+  }
+
+  // One running and one waiting.
+  EXPECT_GE(succeeded, 1);
+  EXPECT_LT(succeeded, 4);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
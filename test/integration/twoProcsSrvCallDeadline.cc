@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+
+//////////////////////////////////////////////////
+/// \brief Wait for the services of the replier to be discovered.
+void waitForReplier(transport::Node &_node)
+{
+  msgs::Int32 req;
+  msgs::Int32 rep;
+  bool result = false;
+  ASSERT_TRUE(_node.Request("/executed", req, 5000u, rep, result));
+  EXPECT_TRUE(result);
+}
+
+//////////////////////////////////////////////////
+/// \brief The responder gets the deadline of the request.
+TEST(twoProcSrvCallDeadline, Remaining)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierDeadline, partition});
+
+  transport::Node node;
+  waitForReplier(node);
+
+  msgs::Int32 req;
+  msgs::Int32 rep;
+  bool result = false;
+  ASSERT_TRUE(node.Request("/remaining", req, 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_GT(rep.data(), 0);
+  EXPECT_LE(rep.data(), 1000);
+
+  // A thread deadline shortens the timeout.
+  {
+    transport::ServiceContext context(
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(500));
+    ASSERT_TRUE(node.Request("/remaining", req, 5000u, rep, result));
+    EXPECT_TRUE(result);
+    EXPECT_GT(rep.data(), 0);
+    EXPECT_LE(rep.data(), 500);
+  }
+
+  // A service called by a service inherits its deadline.
+  ASSERT_TRUE(node.Request("/chain", req, 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_GT(rep.data(), 0);
+  EXPECT_LE(rep.data(), 1000);
+}
+
+//////////////////////////////////////////////////
+/// \brief The requests whose requester gave up are not executed.
+TEST(twoProcSrvCallDeadline, Skip)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplierDeadline, partition});
+
+  transport::Node node;
+  waitForReplier(node);
+
+  // The first request keeps the worker busy for one second. The next ones
+  // time out while waiting.
+  msgs::Int32 req;
+  msgs::Int32 rep;
+  bool result = false;
+  for (int i = 0; i < 3; ++i)
+    EXPECT_FALSE(node.Request("/slow", req, 300u, rep, result));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  ASSERT_TRUE(node.Request("/executed", req, 1000u, rep, result));
+  EXPECT_TRUE(result);
+  EXPECT_EQ(1, rep.data());
+
+  // The requests that already expired are not sent.
+  transport::ServiceContext context(std::chrono::steady_clock::now());
+  EXPECT_FALSE(node.Request("/slow", req, 1000u, rep, result));
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
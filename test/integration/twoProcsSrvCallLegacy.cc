@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const std::string g_topic = "/foo";  // NOLINT(*)
+static const int data = 5;
+
+//////////////////////////////////////////////////
+/// \brief The requests are sent with one frame per field and the responder
+/// answers in the same format.
+TEST(twoProcSrvCallLegacy, SrvTwoProcs)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplier, partition});
+
+  msgs::Int32 req;
+  req.set_data(data);
+  msgs::Int32 rep;
+  bool result = false;
+
+  transport::Node node;
+  for (int i = 0; i < 3; ++i)
+  {
+    rep.Clear();
+    ASSERT_TRUE(node.Request(g_topic, req, 3000u, rep, result));
+    EXPECT_TRUE(result);
+    EXPECT_EQ(data, rep.data());
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief The chunks of a streamed response use the legacy format too.
+TEST(twoProcSrvCallLegacy, SrvTwoProcsStream)
+{
+  auto pi = gz::utils::Subprocess(
+    {test_executables::kTwoProcsSrvCallReplier, partition});
+
+  msgs::Int32 req;
+  req.set_data(data);
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<int> chunks;
+  bool done = false;
+  bool doneResult = false;
+  std::function<void(const msgs::Int32 &)> chunkCb =
+    [&](const msgs::Int32 &_chunk)
+  {
+    std::lock_guard<std::mutex> lk(m);
+    chunks.push_back(_chunk.data());
+  };
+  std::function<void(const bool)> doneCb = [&](const bool _result)
+  {
+    std::lock_guard<std::mutex> lk(m);
+    done = true;
+    doneResult = _result;
+    cv.notify_one();
+  };
+
+  transport::Node node;
+  ASSERT_TRUE(node.RequestStream(g_topic, req, chunkCb, doneCb));
+
+  std::unique_lock<std::mutex> lk(m);
+  ASSERT_TRUE(cv.wait_for(lk, std::chrono::seconds(5), [&]{return done;}));
+  EXPECT_TRUE(doneResult);
+  EXPECT_EQ(std::vector<int>({data}), chunks);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name.
+  partition = testing::getRandomNumber();
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  // Keep the legacy service frames, as the processes of a previous version.
+  gz::utils::setenv("GZ_TRANSPORT_SERVICE_ENVELOPE", "0");
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "bench_utils.hh"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const auto kTimeout = std::chrono::milliseconds(10000);
+static const unsigned int kTimeoutMs = 10000;
+
+/// \brief Operations measured per path and payload size.
+static const std::size_t kIterations = 2000;
+
+/// \brief Operations run before the measurement, so that the pools of the
+/// transport are warm.
+static const std::size_t kWarmup = 200;
+
+/// \brief Allocations of the whole process.
+static std::atomic<uint64_t> processAllocs{0};
+
+/// \brief Bytes allocated by the whole process.
+static std::atomic<uint64_t> processBytes{0};
+
+/// \brief Allocations of the current thread.
+static thread_local uint64_t threadAllocs = 0;
+
+/// \brief Bytes allocated by the current thread.
+static thread_local uint64_t threadBytes = 0;
+
+//////////////////////////////////////////////////
+/// \brief Every allocation of the process made with operator new, including
+/// those of the transport library, ZeroMQ excepted since it calls malloc().
+/// The other forms of operator new end up here, except the aligned ones.
+void *operator new(std::size_t _size)
+{
+  processAllocs.fetch_add(1, std::memory_order_relaxed);
+  processBytes.fetch_add(_size, std::memory_order_relaxed);
+  ++threadAllocs;
+  threadBytes += _size;
+
+  if (void *ptr = std::malloc(_size == 0 ? 1 : _size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+/// \brief Allocations and CPU time of the process and of the current
+/// thread.
+struct Cost
+{
+  /// \brief Read the counters.
+  /// \return The counters now.
+  static Cost Now()
+  {
+    Cost cost;
+    cost.allocs = processAllocs.load(std::memory_order_relaxed);
+    cost.bytes = processBytes.load(std::memory_order_relaxed);
+    cost.threadAllocs = threadAllocs;
+    cost.threadBytes = threadBytes;
+    cost.cpuNs = static_cast<double>(std::clock()) * 1e9 / CLOCKS_PER_SEC;
+
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    cost.threadCpuNs = static_cast<double>(ts.tv_sec) * 1e9 +
+      static_cast<double>(ts.tv_nsec);
+    return cost;
+  }
+
+  /// \brief Counters accumulated since an earlier reading.
+  /// \param[in] _start The earlier reading.
+  /// \return The difference.
+  Cost operator-(const Cost &_start) const
+  {
+    Cost cost;
+    cost.allocs = this->allocs - _start.allocs;
+    cost.bytes = this->bytes - _start.bytes;
+    cost.threadAllocs = this->threadAllocs - _start.threadAllocs;
+    cost.threadBytes = this->threadBytes - _start.threadBytes;
+    cost.cpuNs = this->cpuNs - _start.cpuNs;
+    cost.threadCpuNs = this->threadCpuNs - _start.threadCpuNs;
+    return cost;
+  }
+
+  /// \brief Allocations of the process.
+  uint64_t allocs = 0;
+
+  /// \brief Bytes allocated by the process.
+  uint64_t bytes = 0;
+
+  /// \brief Allocations of the current thread.
+  uint64_t threadAllocs = 0;
+
+  /// \brief Bytes allocated by the current thread.
+  uint64_t threadBytes = 0;
+
+  /// \brief CPU time of the process (ns).
+  double cpuNs = 0;
+
+  /// \brief CPU time of the current thread (ns).
+  double threadCpuNs = 0;
+};
+
+//////////////////////////////////////////////////
+/// \brief Run an operation repeatedly and record its cost per operation:
+/// the allocations, the bytes allocated and the CPU time of the calling
+/// thread (the publication or the request) and of the other threads of the
+/// process (the delivery or the response).
+/// \param[in] _name Prefix of the results.
+/// \param[in] _caller Name of the stage of the calling thread.
+/// \param[in] _others Name of the stage of the other threads.
+/// \param[in] _op Runs one operation and waits for its completion.
+/// Returns false on failure.
+void measure(const std::string &_name, const std::string &_caller,
+             const std::string &_others, const std::function<bool()> &_op)
+{
+  for (std::size_t i = 0; i < kWarmup; ++i)
+    ASSERT_TRUE(_op()) << "Warm-up operation " << i << " failed";
+
+  const Cost start = Cost::Now();
+  for (std::size_t i = 0; i < kIterations; ++i)
+    ASSERT_TRUE(_op()) << "Operation " << i << " failed";
+  const Cost cost = Cost::Now() - start;
+
+  const double n = static_cast<double>(kIterations);
+  bench::Record(_name + "." + _caller + ".allocs_per_msg",
+    static_cast<double>(cost.threadAllocs) / n);
+  bench::Record(_name + "." + _caller + ".bytes_per_msg",
+    static_cast<double>(cost.threadBytes) / n);
+  bench::Record(_name + "." + _caller + ".cpu_ns_per_msg",
+    cost.threadCpuNs / n);
+  bench::Record(_name + "." + _others + ".allocs_per_msg",
+    static_cast<double>(cost.allocs - cost.threadAllocs) / n);
+  bench::Record(_name + "." + _others + ".bytes_per_msg",
+    static_cast<double>(cost.bytes - cost.threadBytes) / n);
+  bench::Record(_name + "." + _others + ".cpu_ns_per_msg",
+    std::max(0.0, cost.cpuNs - cost.threadCpuNs) / n);
+}
+
+//////////////////////////////////////////////////
+/// \brief Measure the publications of one topic, one message at a time.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _pubTopic Topic published.
+/// \param[in] _subTopic Topic subscribed, the same one or the topic of the
+/// echo process.
+/// \param[in] _raw Whether the messages are published and received
+/// serialized.
+/// \param[in] _size Payload size (bytes).
+void runPubSub(const std::string &_name, const std::string &_pubTopic,
+               const std::string &_subTopic, bool _raw, std::size_t _size)
+{
+  bench::Counter counter;
+  std::function<void(const msgs::Bytes &)> cb =
+    [&counter](const msgs::Bytes &)
+    {
+      counter.Add();
+    };
+  transport::RawCallback rawCb =
+    [&counter](const char *, const std::size_t,
+               const transport::MessageInfo &)
+    {
+      counter.Add();
+    };
+
+  transport::Node subNode;
+  if (_raw)
+    ASSERT_TRUE(subNode.SubscribeRaw(_subTopic, rawCb, "gz.msgs.Bytes"));
+  else
+    ASSERT_TRUE(subNode.Subscribe(_subTopic, cb));
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Bytes>(_pubTopic);
+  ASSERT_TRUE(pub);
+
+  // Wait for the discovery and the connections, if any.
+  msgs::Bytes msg;
+  msg.set_data("x");
+  bool connected = false;
+  for (int i = 0; i < 100 && !connected; ++i)
+  {
+    pub.Publish(msg);
+    connected = counter.Wait(1, std::chrono::milliseconds(100));
+  }
+  ASSERT_TRUE(connected) << "No message received on [" << _subTopic << "]";
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  msg.set_data(std::string(_size, 'x'));
+  const std::string data = msg.SerializeAsString();
+  measure(_name + "." + bench::SizeName(_size), "publish", "delivery",
+    [&]()
+    {
+      counter.Reset();
+      const bool published = _raw ?
+        pub.PublishRaw(data, msg.GetTypeName()) : pub.Publish(msg);
+      return published && counter.Wait(1, kTimeout);
+    });
+}
+
+//////////////////////////////////////////////////
+/// \brief Measure the blocking requests of a service.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _service Service name.
+/// \param[in] _size Payload size (bytes).
+void runSrvCall(const std::string &_name, const std::string &_service,
+                std::size_t _size)
+{
+  transport::Node node;
+
+  // Wait for the discovery of the responder.
+  msgs::Bytes req;
+  msgs::Bytes rep;
+  bool result = false;
+  bool executed = false;
+  for (int i = 0; i < 100 && !executed; ++i)
+    executed = node.Request(_service, req, 100u, rep, result);
+  ASSERT_TRUE(executed) << "No response from [" << _service << "]";
+
+  req.set_data(std::string(_size, 'x'));
+  measure(_name + "." + bench::SizeName(_size), "call", "response",
+    [&]()
+    {
+      return node.Request(_service, req, kTimeoutMs, rep, result) && result;
+    });
+}
+
+//////////////////////////////////////////////////
+/// \brief Typed publications to a subscriber of the same process.
+TEST(AllocationCost, LocalTyped)
+{
+  for (const std::size_t size : {64u, 4096u, 262144u})
+    runPubSub("local_typed", "/bench_alloc", "/bench_alloc", false, size);
+}
+
+//////////////////////////////////////////////////
+/// \brief Serialized publications to a raw subscriber of the same process.
+TEST(AllocationCost, LocalRaw)
+{
+  for (const std::size_t size : {64u, 4096u, 262144u})
+    runPubSub("local_raw", "/bench_alloc", "/bench_alloc", true, size);
+}
+
+//////////////////////////////////////////////////
+/// \brief Typed publications to another process, which sends them back.
+TEST(AllocationCost, RemoteTyped)
+{
+  gz::utils::Subprocess echo(std::vector<std::string>(
+    {test_executables::kBenchmark, partition, "echo"}));
+
+  for (const std::size_t size : {64u, 4096u, 262144u})
+    runPubSub("remote_typed", "/bench_ping", "/bench_pong", false, size);
+
+  echo.Terminate();
+  echo.Join();
+}
+
+//////////////////////////////////////////////////
+/// \brief Serialized publications to another process, which sends them
+/// back.
+TEST(AllocationCost, RemoteRaw)
+{
+  gz::utils::Subprocess echo(std::vector<std::string>(
+    {test_executables::kBenchmark, partition, "echo"}));
+
+  for (const std::size_t size : {64u, 4096u, 262144u})
+    runPubSub("remote_raw", "/bench_ping", "/bench_pong", true, size);
+
+  echo.Terminate();
+  echo.Join();
+}
+
+//////////////////////////////////////////////////
+/// \brief Service calls answered by the same process and by another one.
+TEST(AllocationCost, ServiceCall)
+{
+  std::function<bool(const msgs::Bytes &, msgs::Bytes &)> cb =
+    [](const msgs::Bytes &_req, msgs::Bytes &_rep)
+    {
+      _rep = _req;
+      return true;
+    };
+  transport::Node node;
+  ASSERT_TRUE(node.Advertise("/bench_alloc_srv", cb));
+
+  gz::utils::Subprocess echo(std::vector<std::string>(
+    {test_executables::kBenchmark, partition, "echo"}));
+
+  for (const std::size_t size : {64u, 4096u})
+  {
+    runSrvCall("service_local", "/bench_alloc_srv", size);
+    runSrvCall("service_remote", "/bench_srv", size);
+  }
+
+  echo.Terminate();
+  echo.Join();
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name, shared with the echo process.
+  partition = testing::getRandomNumber();
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
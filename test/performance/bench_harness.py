@@ -0,0 +1,382 @@
+#!/usr/bin/env python3
+# Copyright (C) 2024 Open Source Robotics Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""Run the performance benchmarks repeatedly and track regressions.
+
+The benchmarks of test/performance and log/test/performance record their
+results as gtest properties. This script runs them with a fixed CPU
+affinity, discards the warm-up trials, repeats the measured trials and
+writes a JSON report with the value of every result in every trial. A
+report can be compared against a baseline report: a result regresses when
+it got worse by more than the threshold and a Mann-Whitney U test says that
+the difference is significant.
+
+Usage:
+  # Measure the current build and store the report.
+  bench_harness.py run --build-dir build --output current.json
+
+  # Compare against a baseline, exits with 1 on regressions.
+  bench_harness.py compare baseline.json current.json
+
+  # Write gnuplot data files for example/latency.gp and throughput.gp.
+  bench_harness.py plot current.json --output-dir plots
+"""
+
+import argparse
+import datetime
+import json
+import math
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+
+# Benchmark runs: name, executable and environment. The inter-process
+# pub/sub benchmark runs on every transport, as in CMakeLists.txt.
+SCENARIOS = [
+    ('localPubSubLatency', 'PERFORMANCE_localPubSubLatency', {}),
+    ('remotePubSubLatency', 'PERFORMANCE_remotePubSubLatency', {}),
+    ('remotePubSubLatency_loopback', 'PERFORMANCE_remotePubSubLatency',
+     {'GZ_IP': '127.0.0.1'}),
+    ('remotePubSubLatency_shm', 'PERFORMANCE_remotePubSubLatency',
+     {'GZ_TRANSPORT_SHM': '1'}),
+    ('srvCallLatency', 'PERFORMANCE_srvCallLatency', {}),
+    ('allocationCost', 'PERFORMANCE_allocationCost', {}),
+    ('dataStructures', 'PERFORMANCE_dataStructures', {}),
+    ('discoveryLatency', 'PERFORMANCE_discoveryLatency', {}),
+    ('discoveryScalability', 'PERFORMANCE_discoveryScalability', {}),
+    ('logRecorder', 'PERFORMANCE_logRecorder', {}),
+    ('logQuery', 'PERFORMANCE_logQuery', {}),
+    ('logPlayback', 'PERFORMANCE_logPlayback', {}),
+]
+
+# Suffixes of the results where a larger value is better. For the other
+# results (times) a smaller value is better.
+HIGHER_IS_BETTER = ('.msgs_per_s', '.mib_per_s')
+
+# Results that don't measure performance.
+IGNORED = ('.samples', '.processes', '.nodes', '.topics')
+
+# Result of a payload size, e.g. "typed.4KiB.latency.p50_us".
+SIZE_RE = re.compile(r'^(?P<scenario>.+?)\.(?P<size>\d+)(?P<unit>B|KiB|MiB)'
+                     r'\.(?P<metric>.+)$')
+UNITS = {'B': 1, 'KiB': 1024, 'MiB': 1024 * 1024}
+
+
+def find_executable(build_dir, name):
+    """Find a benchmark executable in a build directory."""
+    for root, _, files in os.walk(build_dir):
+        if name in files:
+            path = os.path.join(root, name)
+            if os.access(path, os.X_OK):
+                return path
+    return None
+
+
+def parse_cpus(value):
+    """Parse a CPU list such as "2,3" or "0-3"."""
+    cpus = set()
+    for part in value.split(','):
+        if '-' in part:
+            first, last = part.split('-')
+            cpus.update(range(int(first), int(last) + 1))
+        elif part:
+            cpus.add(int(part))
+    return cpus
+
+
+def default_cpus():
+    """Two CPUs of the current affinity mask, one per process of the
+    inter-process benchmarks."""
+    if not hasattr(os, 'sched_getaffinity'):
+        return set()
+    return set(sorted(os.sched_getaffinity(0))[-2:])
+
+
+def run_trial(path, env, cpus, timeout):
+    """Run a benchmark once and return its results {test/name: value}."""
+    with tempfile.TemporaryDirectory() as tmp:
+        output = os.path.join(tmp, 'results.json')
+        trial_env = dict(os.environ)
+        trial_env.update(env)
+
+        def pin():
+            # Inherited by the peer processes started by the benchmark.
+            if cpus and hasattr(os, 'sched_setaffinity'):
+                os.sched_setaffinity(0, cpus)
+
+        proc = subprocess.run(
+            [path, '--gtest_output=json:' + output], env=trial_env,
+            preexec_fn=pin if os.name == 'posix' else None,
+            stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+            timeout=timeout, check=False)
+        if proc.returncode != 0 or not os.path.exists(output):
+            sys.stderr.write(proc.stdout.decode(errors='replace'))
+            raise RuntimeError('%s failed with code %d' %
+                               (path, proc.returncode))
+
+        with open(output) as f:
+            report = json.load(f)
+
+    results = {}
+    for suite in report.get('testsuites', []):
+        for test in suite.get('testsuite', []):
+            prefix = '%s.%s/' % (suite['name'], test['name'])
+            for key, value in test.items():
+                try:
+                    results[prefix + key] = float(value)
+                except (TypeError, ValueError):
+                    continue
+    # Drop the gtest fields that happen to be numeric.
+    return {k: v for k, v in results.items()
+            if not k.endswith(('/time', '/timestamp'))}
+
+
+def command_run(args):
+    """Run the benchmarks and write a report."""
+    cpus = parse_cpus(args.cpus) if args.cpus else default_cpus()
+    selected = set(args.scenario or [])
+    report = {
+        'meta': {
+            'date': datetime.datetime.now(datetime.timezone.utc).isoformat(),
+            'host': platform.node(),
+            'platform': platform.platform(),
+            'cpus': sorted(cpus),
+            'warmup': args.warmup,
+            'trials': args.trials,
+            'label': args.label,
+        },
+        'results': {},
+    }
+
+    for name, executable, env in SCENARIOS:
+        if selected and name not in selected:
+            continue
+        path = find_executable(args.build_dir, executable)
+        if not path:
+            print('Skipping %s: %s not found' % (name, executable))
+            continue
+
+        for i in range(args.warmup + args.trials):
+            measured = i >= args.warmup
+            print('%s: %s %d' % (name, 'trial' if measured else 'warm-up',
+                                 i - args.warmup + 1 if measured else i + 1))
+            results = run_trial(path, env, cpus, args.timeout)
+            if not measured:
+                continue
+            for key, value in results.items():
+                report['results'].setdefault(
+                    '%s/%s' % (name, key), []).append(value)
+
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print('Wrote %d results to %s' % (len(report['results']), args.output))
+    return 0
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test. Exact for small samples
+    without ties, normal approximation with tie correction otherwise."""
+    n1, n2 = len(a), len(b)
+    values = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+
+    # Average ranks of the ties.
+    ranks = [0.0] * len(values)
+    ties = []
+    i = 0
+    while i < len(values):
+        j = i
+        while j + 1 < len(values) and values[j + 1][0] == values[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1.0
+        ties.append(j - i + 1)
+        i = j + 1
+
+    r1 = sum(r for r, (_, group) in zip(ranks, values) if group == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    u = min(u1, n1 * n2 - u1)
+
+    if n1 + n2 <= 40 and all(t == 1 for t in ties):
+        # counts[k] = number of arrangements with U = k.
+        counts = [[[0] * (n1 * n2 + 1) for _ in range(n2 + 1)]
+                  for _ in range(n1 + 1)]
+        for i in range(n1 + 1):
+            for j in range(n2 + 1):
+                if i == 0 or j == 0:
+                    counts[i][j][0] = 1
+                    continue
+                for k in range(i * j + 1):
+                    c = counts[i][j - 1][k]
+                    if k >= j:
+                        c += counts[i - 1][j][k - j]
+                    counts[i][j][k] = c
+        total = math.comb(n1 + n2, n1)
+        tail = sum(counts[n1][n2][:int(u) + 1])
+        return min(1.0, 2.0 * tail / total)
+
+    n = n1 + n2
+    tie_term = sum(t ** 3 - t for t in ties) / (n * (n - 1))
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - tie_term))
+    if sigma == 0:
+        return 1.0
+    z = (abs(u1 - n1 * n2 / 2.0) - 0.5) / sigma
+    return min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2.0)))
+
+
+def command_compare(args):
+    """Compare a report against a baseline."""
+    with open(args.baseline) as f:
+        baseline = json.load(f)['results']
+    with open(args.current) as f:
+        current = json.load(f)['results']
+
+    regressions = []
+    improvements = []
+    for key in sorted(set(baseline) & set(current)):
+        if key.endswith(IGNORED):
+            continue
+        old, new = baseline[key], current[key]
+        if len(old) < 2 or len(new) < 2:
+            continue
+        old_median = statistics.median(old)
+        new_median = statistics.median(new)
+        if old_median == 0:
+            continue
+
+        change = (new_median - old_median) / abs(old_median)
+        worse = -change if key.endswith(HIGHER_IS_BETTER) else change
+        if abs(worse) < args.threshold:
+            continue
+        p = mann_whitney_p(old, new)
+        if p >= args.alpha:
+            continue
+
+        line = '%-70s %12.4g -> %12.4g (%+6.1f%%, p=%.3g)' % (
+            key, old_median, new_median, 100.0 * change, p)
+        (regressions if worse > 0 else improvements).append(line)
+
+    for title, lines in (('Regressions', regressions),
+                         ('Improvements', improvements)):
+        print('%s: %d' % (title, len(lines)))
+        for line in lines:
+            print('  ' + line)
+
+    return 1 if regressions else 0
+
+
+def command_plot(args):
+    """Write the data files of the gnuplot scripts in example/."""
+    with open(args.report) as f:
+        results = json.load(f)['results']
+
+    # series[(run, test, scenario)][size][metric] = median
+    series = {}
+    for key, values in results.items():
+        run, test, name = key.split('/', 2)
+        match = SIZE_RE.match(name)
+        if not match:
+            continue
+        size = int(match.group('size')) * UNITS[match.group('unit')]
+        series.setdefault((run, test, match.group('scenario')), {}) \
+            .setdefault(size, {})[match.group('metric')] = \
+            statistics.median(values)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    for (run, test, scenario), sizes in sorted(series.items()):
+        prefix = '%s-%s-%s' % (run, test.split('.')[-1], scenario)
+        latency = []
+        throughput = []
+        for index, size in enumerate(sorted(sizes), start=1):
+            metrics = sizes[size]
+            # Round trips are halved, as the "bench" example does.
+            for kind, factor in (('latency', 1.0), ('rtt', 0.5)):
+                if kind + '.mean_us' in metrics:
+                    latency.append('%d\t%d\t%f\t%f\t%f' % (
+                        index, size, metrics[kind + '.mean_us'] * factor,
+                        metrics[kind + '.p50_us'] * factor,
+                        metrics[kind + '.p99_us'] * factor))
+            if 'msgs_per_s' in metrics:
+                throughput.append('%d\t%d\t\t%f\t%f' % (
+                    index, size, metrics['msgs_per_s'] * size * 1e-6,
+                    metrics['msgs_per_s'] * 1e-3))
+
+        for kind, header, lines in (
+                ('latency', '# Test\tSize(B)\tAvg_(us)\tP50_(us)\tP99_(us)',
+                 latency),
+                ('throughput', '# Test\tSize(B)\t\tMB/s\t\tKmsg/s',
+                 throughput)):
+            if not lines:
+                continue
+            path = os.path.join(args.output_dir,
+                                '%s-%s.dat' % (kind, prefix))
+            with open(path, 'w') as f:
+                f.write(header + '\n' + '\n'.join(lines) + '\n')
+            print('gnuplot -e "filename=\'%s\'; prefix=\'%s\'" %s.gp' %
+                  (path, prefix, kind))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    run = commands.add_parser('run', help='run the benchmarks')
+    run.add_argument('--build-dir', required=True,
+                     help='CMake build directory with the benchmarks')
+    run.add_argument('--output', required=True, help='JSON report to write')
+    run.add_argument('--scenario', action='append',
+                     choices=[s[0] for s in SCENARIOS],
+                     help='run only this scenario (repeatable)')
+    run.add_argument('--trials', type=int, default=5,
+                     help='measured trials (default: 5)')
+    run.add_argument('--warmup', type=int, default=1,
+                     help='discarded trials (default: 1)')
+    run.add_argument('--cpus',
+                     help='CPU list to pin to, e.g. "2,3" (default: the '
+                          'last two CPUs available)')
+    run.add_argument('--timeout', type=float, default=1800,
+                     help='timeout of a trial in seconds (default: 1800)')
+    run.add_argument('--label', default='',
+                     help='free text stored in the report, e.g. a commit')
+    run.set_defaults(func=command_run)
+
+    compare = commands.add_parser('compare',
+                                  help='compare a report with a baseline')
+    compare.add_argument('baseline', help='JSON report of the baseline')
+    compare.add_argument('current', help='JSON report to check')
+    compare.add_argument('--alpha', type=float, default=0.05,
+                         help='significance level (default: 0.05)')
+    compare.add_argument('--threshold', type=float, default=0.05,
+                         help='minimum relative change (default: 0.05)')
+    compare.set_defaults(func=command_compare)
+
+    plot = commands.add_parser('plot', help='write gnuplot data files')
+    plot.add_argument('report', help='JSON report')
+    plot.add_argument('--output-dir', default='.',
+                      help='directory of the data files')
+    plot.set_defaults(func=command_plot)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
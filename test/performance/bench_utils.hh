@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_TRANSPORT_TEST_PERFORMANCE_BENCH_UTILS_HH_
+#define GZ_TRANSPORT_TEST_PERFORMANCE_BENCH_UTILS_HH_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/// \brief Helpers shared by the benchmarks. Every result is printed and
+/// recorded as a property of the test, so running a benchmark with
+/// --gtest_output=json:<file> (or xml) produces machine-readable results.
+namespace bench
+{
+  using Clock = std::chrono::steady_clock;
+
+  /// \brief Payload sizes (bytes) measured by the pub/sub and service
+  /// benchmarks, from 8 B to 64 MiB.
+  inline const std::vector<std::size_t> &PayloadSizes()
+  {
+    static const std::vector<std::size_t> sizes =
+      {8u, 64u, 512u, 4096u, 32768u, 262144u, 2097152u, 16777216u,
+       67108864u};
+    return sizes;
+  }
+
+  /// \brief Number of samples to take for a payload size, so that every
+  /// size moves roughly the same amount of data.
+  /// \param[in] _size Payload size (bytes).
+  /// \return Number of iterations.
+  inline std::size_t Iterations(std::size_t _size)
+  {
+    constexpr std::size_t kBudget = 256u * 1024u * 1024u;
+    return std::clamp<std::size_t>(kBudget / std::max<std::size_t>(_size, 1u),
+      4u, 2000u);
+  }
+
+  /// \brief Human readable payload size, used in the result names.
+  /// \param[in] _size Payload size (bytes).
+  /// \return E.g. "8B", "4KiB" or "64MiB".
+  inline std::string SizeName(std::size_t _size)
+  {
+    if (_size >= 1024u * 1024u && _size % (1024u * 1024u) == 0)
+      return std::to_string(_size / (1024u * 1024u)) + "MiB";
+    if (_size >= 1024u && _size % 1024u == 0)
+      return std::to_string(_size / 1024u) + "KiB";
+    return std::to_string(_size) + "B";
+  }
+
+  /// \brief Elapsed time in microseconds.
+  /// \param[in] _start Start of the interval.
+  /// \param[in] _end End of the interval.
+  /// \return Microseconds.
+  inline double Us(Clock::time_point _start, Clock::time_point _end)
+  {
+    return std::chrono::duration<double, std::micro>(_end - _start).count();
+  }
+
+  /// \brief Counts the messages received by the callbacks and lets the
+  /// benchmark wait for them.
+  class Counter
+  {
+    /// \brief Count a message.
+    public: void Add()
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      ++this->count;
+      this->last = Clock::now();
+      this->condition.notify_all();
+    }
+
+    /// \brief Wait until a number of messages were counted.
+    /// \param[in] _count Number of messages.
+    /// \param[in] _timeout Maximum time to wait.
+    /// \return False if the timeout expired.
+    public: bool Wait(std::size_t _count, std::chrono::milliseconds _timeout)
+    {
+      std::unique_lock<std::mutex> lk(this->mutex);
+      return this->condition.wait_for(lk, _timeout,
+        [this, _count]{return this->count >= _count;});
+    }
+
+    /// \brief Number of messages counted.
+    /// \return The count.
+    public: std::size_t Count()
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      return this->count;
+    }
+
+    /// \brief Time at which the last message was counted.
+    /// \return The time of the last message.
+    public: Clock::time_point Last()
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      return this->last;
+    }
+
+    /// \brief Restart the count.
+    public: void Reset()
+    {
+      std::lock_guard<std::mutex> lk(this->mutex);
+      this->count = 0;
+    }
+
+    /// \brief Protects the count.
+    private: std::mutex mutex;
+
+    /// \brief Notified on every message.
+    private: std::condition_variable condition;
+
+    /// \brief Number of messages.
+    private: std::size_t count = 0;
+
+    /// \brief Time of the last message.
+    private: Clock::time_point last;
+  };
+
+  /// \brief Record a result of the current test.
+  /// \param[in] _name Result name, e.g. "typed.4KiB.p50_us".
+  /// \param[in] _value Value.
+  inline void Record(const std::string &_name, double _value)
+  {
+    std::ostringstream value;
+    value << std::setprecision(6) << _value;
+    ::testing::Test::RecordProperty(_name, value.str());
+    std::cout << "[ BENCH    ] " << _name << " = " << value.str()
+              << std::endl;
+  }
+
+  /// \brief Record the distribution of latency samples: sample count, mean,
+  /// p50, p99 and maximum.
+  /// \param[in] _name Prefix of the results.
+  /// \param[in] _samplesUs Samples (microseconds), reordered.
+  inline void RecordLatency(const std::string &_name,
+                            std::vector<double> &_samplesUs)
+  {
+    Record(_name + ".samples", static_cast<double>(_samplesUs.size()));
+    if (_samplesUs.empty())
+      return;
+
+    std::sort(_samplesUs.begin(), _samplesUs.end());
+    auto percentile = [&_samplesUs](double _p)
+    {
+      const std::size_t index = std::min(_samplesUs.size() - 1,
+        static_cast<std::size_t>(_p / 100.0 *
+          static_cast<double>(_samplesUs.size())));
+      return _samplesUs[index];
+    };
+
+    Record(_name + ".mean_us",
+      std::accumulate(_samplesUs.begin(), _samplesUs.end(), 0.0) /
+      static_cast<double>(_samplesUs.size()));
+    Record(_name + ".p50_us", percentile(50));
+    Record(_name + ".p99_us", percentile(99));
+    Record(_name + ".max_us", _samplesUs.back());
+  }
+
+  /// \brief Record the throughput of a burst of messages.
+  /// \param[in] _name Prefix of the results.
+  /// \param[in] _msgs Messages delivered.
+  /// \param[in] _size Payload size (bytes).
+  /// \param[in] _elapsedUs Duration of the burst (microseconds).
+  inline void RecordThroughput(const std::string &_name, std::size_t _msgs,
+                               std::size_t _size, double _elapsedUs)
+  {
+    if (_elapsedUs <= 0)
+      return;
+    const double secs = _elapsedUs / 1e6;
+    Record(_name + ".msgs_per_s", static_cast<double>(_msgs) / secs);
+    Record(_name + ".mib_per_s",
+      static_cast<double>(_msgs * _size) / secs / (1024.0 * 1024.0));
+  }
+}
+
+#endif
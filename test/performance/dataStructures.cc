@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/discovery.pb.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/HandlerStorage.hh"
+#include "gz/transport/Publisher.hh"
+#include "gz/transport/TopicStorage.hh"
+#include "gz/transport/TopicUtils.hh"
+#include "bench_utils.hh"
+
+using namespace gz;
+
+/// \brief Number of topics of the graphs measured.
+static const std::vector<std::size_t> kGraphSizes = {1000u, 10000u, 100000u};
+
+/// \brief Number of names qualified or packed per measurement.
+static const std::size_t kNames = 100000;
+
+/// \brief Node of the publishers and handlers.
+static const char kNUuid[] = "9a3b51d4-6cb7-4c5a-9f3e-2b1d7e0c4a88";
+
+/// \brief Process of the publishers.
+static const char kPUuid[] = "1f6e2c0a-8d4b-4b7e-a3c2-5e9d0f1b7c36";
+
+//////////////////////////////////////////////////
+/// \brief Run an operation on every element of a range and record its
+/// average duration.
+/// \param[in] _name Name of the result.
+/// \param[in] _count Number of operations.
+/// \param[in] _op Operation, called with the index of the element.
+template<typename F>
+void recordNsPerOp(const std::string &_name, std::size_t _count, F &&_op)
+{
+  const auto start = bench::Clock::now();
+  for (std::size_t i = 0; i < _count; ++i)
+    _op(i);
+  const auto end = bench::Clock::now();
+  bench::Record(_name + "_ns", bench::Us(start, end) * 1e3 /
+    static_cast<double>(std::max<std::size_t>(_count, 1u)));
+}
+
+//////////////////////////////////////////////////
+/// \brief Fully qualified names of a graph, as the discovery stores them.
+/// \param[in] _count Number of topics.
+/// \return The names.
+static std::vector<std::string> topicNames(std::size_t _count)
+{
+  std::vector<std::string> names;
+  names.reserve(_count);
+  for (std::size_t i = 0; i < _count; ++i)
+  {
+    names.push_back("@/bench_host:partition@/robot_" +
+      std::to_string(i % 100) + "/sensors/topic_" + std::to_string(i));
+  }
+  return names;
+}
+
+//////////////////////////////////////////////////
+/// \brief A publisher of a topic of the graph.
+/// \param[in] _topic Fully qualified topic name.
+/// \return The publisher.
+static transport::MessagePublisher publisher(const std::string &_topic)
+{
+  return transport::MessagePublisher(_topic, "tcp://192.168.1.10:45123",
+    "tcp://192.168.1.10:45124", kPUuid, kNUuid, "gz.msgs.Pose",
+    transport::AdvertiseMessageOptions());
+}
+
+//////////////////////////////////////////////////
+/// \brief Minimal handler stored in a HandlerStorage.
+class BenchHandler
+{
+  /// \brief Constructor.
+  /// \param[in] _hUuid Handler UUID.
+  public: explicit BenchHandler(const std::string &_hUuid)
+    : hUuid(_hUuid)
+  {
+  }
+
+  /// \brief Get the handler UUID.
+  /// \return The UUID.
+  public: const std::string &HandlerUuid() const
+  {
+    return this->hUuid;
+  }
+
+  /// \brief Handler UUID.
+  private: std::string hUuid;
+};
+
+//////////////////////////////////////////////////
+/// \brief Insertion, lookup and removal of the publishers of the discovery,
+/// one publisher per topic.
+TEST(DataStructures, TopicStorage)
+{
+  for (const std::size_t topics : kGraphSizes)
+  {
+    const std::string name = "topic_storage.topics" + std::to_string(topics);
+    const std::vector<std::string> names = topicNames(topics);
+    std::vector<transport::MessagePublisher> pubs;
+    pubs.reserve(topics);
+    for (const std::string &topic : names)
+      pubs.push_back(publisher(topic));
+
+    // Lookups in random order, as the messages arrive.
+    std::vector<std::size_t> order(topics);
+    for (std::size_t i = 0; i < topics; ++i)
+      order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(0));
+
+    transport::TopicStorage<transport::MessagePublisher> storage;
+    std::size_t found = 0;
+    recordNsPerOp(name + ".insert", topics, [&](std::size_t _i)
+    {
+      found += storage.AddPublisher(pubs[_i]) ? 1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+
+    found = 0;
+    recordNsPerOp(name + ".has_topic", topics, [&](std::size_t _i)
+    {
+      found += storage.HasTopic(names[order[_i]]) ? 1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+
+    found = 0;
+    transport::MessagePublisher pub;
+    recordNsPerOp(name + ".lookup", topics, [&](std::size_t _i)
+    {
+      found += storage.Publisher(names[order[_i]], kPUuid, kNUuid, pub) ?
+        1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+
+    found = 0;
+    recordNsPerOp(name + ".remove", topics, [&](std::size_t _i)
+    {
+      found += storage.DelPublisherByNode(names[order[_i]], kPUuid, kNUuid) ?
+        1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Insertion, lookup and removal of the handlers of a process, one
+/// handler per topic.
+TEST(DataStructures, HandlerStorage)
+{
+  for (const std::size_t topics : kGraphSizes)
+  {
+    const std::string name =
+      "handler_storage.topics" + std::to_string(topics);
+    const std::vector<std::string> names = topicNames(topics);
+    std::vector<std::shared_ptr<BenchHandler>> handlers;
+    handlers.reserve(topics);
+    for (std::size_t i = 0; i < topics; ++i)
+    {
+      handlers.push_back(
+        std::make_shared<BenchHandler>("handler_" + std::to_string(i)));
+    }
+
+    std::vector<std::size_t> order(topics);
+    for (std::size_t i = 0; i < topics; ++i)
+      order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(0));
+
+    transport::HandlerStorage<BenchHandler> storage;
+    recordNsPerOp(name + ".insert", topics, [&](std::size_t _i)
+    {
+      storage.AddHandler(names[_i], kNUuid, handlers[_i]);
+    });
+
+    std::size_t found = 0;
+    std::map<std::string,
+      std::map<std::string, std::shared_ptr<BenchHandler>>> topicHandlers;
+    recordNsPerOp(name + ".handlers", topics, [&](std::size_t _i)
+    {
+      found += storage.Handlers(names[order[_i]], topicHandlers) ? 1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+
+    found = 0;
+    std::shared_ptr<BenchHandler> handler;
+    recordNsPerOp(name + ".lookup", topics, [&](std::size_t _i)
+    {
+      const std::size_t index = order[_i];
+      found += storage.Handler(names[index], kNUuid,
+        handlers[index]->HandlerUuid(), handler) ? 1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+
+    found = 0;
+    recordNsPerOp(name + ".remove", topics, [&](std::size_t _i)
+    {
+      const std::size_t index = order[_i];
+      found += storage.RemoveHandler(names[index], kNUuid,
+        handlers[index]->HandlerUuid()) ? 1u : 0u;
+    });
+    EXPECT_EQ(topics, found);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Qualification of the names of the advertised and subscribed
+/// topics, and the reverse operation done on the received publications.
+TEST(DataStructures, TopicNames)
+{
+  std::vector<std::string> topics;
+  topics.reserve(kNames);
+  for (std::size_t i = 0; i < kNames; ++i)
+    topics.push_back("sensors/topic_" + std::to_string(i));
+
+  std::vector<std::string> qualified(kNames);
+  std::size_t valid = 0;
+  recordNsPerOp("names.qualify", kNames, [&](std::size_t _i)
+  {
+    valid += transport::TopicUtils::FullyQualifiedName("bench_host:partition",
+      "/robot_" + std::to_string(_i % 100), topics[_i], qualified[_i]) ?
+      1u : 0u;
+  });
+  EXPECT_EQ(kNames, valid);
+
+  valid = 0;
+  std::string partition;
+  std::string topic;
+  recordNsPerOp("names.decompose", kNames, [&](std::size_t _i)
+  {
+    valid += transport::TopicUtils::DecomposeFullyQualifiedTopic(
+      qualified[_i], partition, topic) ? 1u : 0u;
+  });
+  EXPECT_EQ(kNames, valid);
+
+  valid = 0;
+  recordNsPerOp("names.validate", kNames, [&](std::size_t _i)
+  {
+    valid += transport::TopicUtils::IsValidTopic(topics[_i]) ? 1u : 0u;
+  });
+  EXPECT_EQ(kNames, valid);
+}
+
+//////////////////////////////////////////////////
+/// \brief Packing of the publishers in the discovery messages, and their
+/// unpacking by the other processes.
+TEST(DataStructures, MessagePublisher)
+{
+  const std::vector<std::string> names = topicNames(kNames);
+  std::vector<transport::MessagePublisher> pubs;
+  pubs.reserve(kNames);
+  for (const std::string &topic : names)
+    pubs.push_back(publisher(topic));
+
+  std::vector<std::string> packed(kNames);
+  msgs::Discovery msg;
+  recordNsPerOp("publisher.pack", kNames, [&](std::size_t _i)
+  {
+    msg.Clear();
+    pubs[_i].FillDiscovery(msg);
+    msg.SerializeToString(&packed[_i]);
+  });
+
+  std::size_t matches = 0;
+  transport::MessagePublisher pub;
+  recordNsPerOp("publisher.unpack", kNames, [&](std::size_t _i)
+  {
+    msg.ParseFromString(packed[_i]);
+    pub.SetFromDiscovery(msg);
+    matches += pub.Topic() == names[_i] ? 1u : 0u;
+  });
+  EXPECT_EQ(kNames, matches);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "bench_utils.hh"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static const auto kTimeout = std::chrono::seconds(60);
+
+//////////////////////////////////////////////////
+/// \brief Start a process that advertises many topics and measure how long
+/// it takes to discover them. The time to discover the first topic includes
+/// the start of the process, the difference with the time to discover all
+/// of them is the cost of the discovery of the topics.
+TEST(DiscoveryLatency, Topics)
+{
+  for (const int count : {10, 100, 1000})
+  {
+    // Every run starts with a clean partition.
+    const std::string partition = testing::getRandomNumber();
+    gz::utils::setenv("GZ_PARTITION", partition);
+    transport::Node node;
+
+    const auto start = bench::Clock::now();
+    gz::utils::Subprocess pub(std::vector<std::string>(
+      {test_executables::kBenchmark, partition, "advertise",
+       std::to_string(count)}));
+
+    bench::Clock::time_point first;
+    std::size_t discovered = 0;
+    while (bench::Clock::now() - start < kTimeout)
+    {
+      std::vector<std::string> topics;
+      node.TopicList(topics);
+
+      discovered = 0;
+      for (const std::string &topic : topics)
+      {
+        if (topic.rfind("/bench_topic_", 0) == 0)
+          ++discovered;
+      }
+      if (discovered > 0 && first == bench::Clock::time_point())
+        first = bench::Clock::now();
+      if (discovered >= static_cast<std::size_t>(count))
+        break;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const auto end = bench::Clock::now();
+
+    pub.Terminate();
+    pub.Join();
+
+    ASSERT_EQ(static_cast<std::size_t>(count), discovered);
+    const std::string name = "topics" + std::to_string(count);
+    bench::Record(name + ".first_us", bench::Us(start, first));
+    bench::Record(name + ".all_us", bench::Us(start, end));
+    bench::Record(name + ".discovery_us", bench::Us(first, end));
+  }
+}
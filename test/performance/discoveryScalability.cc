@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/AdvertiseOptions.hh"
+#include "gz/transport/Discovery.hh"
+#include "gz/transport/Publisher.hh"
+#include "gz/transport/Uuid.hh"
+#include "bench_utils.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+using namespace transport;
+
+static const std::string kIp = "239.255.0.7";  // NOLINT(*)
+static const auto kConvergenceTimeout = std::chrono::seconds(300);
+static const auto kSteadyState = std::chrono::seconds(5);
+
+//////////////////////////////////////////////////
+/// \brief Read a positive integer from the environment.
+/// \param[in] _name Variable name.
+/// \param[in] _default Value if the variable isn't set.
+/// \return The value.
+static int envInt(const std::string &_name, int _default)
+{
+  std::string value;
+  if (!gz::utils::env(_name, value) || value.empty())
+    return _default;
+  const int result = std::atoi(value.c_str());
+  return result > 0 ? result : _default;
+}
+
+//////////////////////////////////////////////////
+/// \brief UDP datagram counters of the host.
+struct UdpCounters
+{
+  /// \brief Datagrams received.
+  uint64_t in = 0;
+
+  /// \brief Datagrams sent.
+  uint64_t out = 0;
+
+  /// \brief Datagrams dropped because a socket buffer was full.
+  uint64_t rcvbufErrors = 0;
+};
+
+//////////////////////////////////////////////////
+/// \brief Read the UDP counters of the host from /proc/net/snmp.
+/// \param[out] _counters The counters.
+/// \return False if they are not available.
+static bool readUdpCounters(UdpCounters &_counters)
+{
+  std::ifstream snmp("/proc/net/snmp");
+  std::string header;
+  std::string line;
+  while (std::getline(snmp, line))
+  {
+    if (line.rfind("Udp:", 0) != 0)
+      continue;
+    if (header.empty())
+    {
+      header = line;
+      continue;
+    }
+
+    std::istringstream names(header);
+    std::istringstream values(line);
+    std::string name;
+    std::string value;
+    while (names >> name && values >> value)
+    {
+      if (name == "InDatagrams")
+        _counters.in = std::stoull(value);
+      else if (name == "OutDatagrams")
+        _counters.out = std::stoull(value);
+      else if (name == "RcvbufErrors")
+        _counters.rcvbufErrors = std::stoull(value);
+    }
+    return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+/// \brief CPU time used by this process.
+/// \return CPU time (user and system), in seconds.
+static double cpuSeconds()
+{
+#ifndef _WIN32
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+    static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) /
+    1e6;
+#else
+  return 0;
+#endif
+}
+
+//////////////////////////////////////////////////
+/// \brief Resident memory of this process.
+/// \return Bytes, or 0 if not available.
+static double rssBytes()
+{
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (!(statm >> size >> resident))
+    return 0;
+  return static_cast<double>(resident) * 4096.0;
+}
+
+//////////////////////////////////////////////////
+/// \brief Estimate the heap memory used by the discovery information.
+/// \param[in] _storage The discovery information.
+/// \return Bytes.
+static std::size_t storageBytes(const TopicStorage<MessagePublisher> &_storage)
+{
+  // Red-black tree node overhead of std::map.
+  constexpr std::size_t kMapNode = 32u;
+  auto heap = [](const std::string &_str) -> std::size_t
+  {
+    // Short strings are stored inline.
+    return _str.size() > 15u ? _str.size() + 1u : 0u;
+  };
+
+  std::size_t bytes = 0;
+  std::vector<std::string> topics;
+  _storage.TopicList(topics);
+  for (const std::string &topic : topics)
+  {
+    std::map<std::string, std::vector<MessagePublisher>> info;
+    _storage.Publishers(topic, info);
+    bytes += kMapNode + sizeof(std::string) + heap(topic) +
+      sizeof(std::map<std::string, std::vector<MessagePublisher>>);
+    for (const auto &[pUuid, pubs] : info)
+    {
+      bytes += kMapNode + sizeof(std::string) + heap(pUuid) +
+        sizeof(std::vector<MessagePublisher>) +
+        pubs.size() * sizeof(MessagePublisher);
+      for (const MessagePublisher &pub : pubs)
+      {
+        bytes += heap(pub.Topic()) + heap(pub.Addr()) + heap(pub.Ctrl()) +
+          heap(pub.PUuid()) + heap(pub.NUuid()) + heap(pub.MsgTypeName());
+      }
+    }
+  }
+  return bytes;
+}
+
+//////////////////////////////////////////////////
+/// \brief Simulate many processes in this one, every one with its own
+/// discovery instance on the same multicast group, and measure how the
+/// discovery scales.
+///
+/// The size of the simulation and the discovery parameters are read from:
+///   GZ_BENCH_DISCOVERY_PROCESSES: simulated processes (default 50).
+///   GZ_BENCH_DISCOVERY_NODES: nodes per process (default 20).
+///   GZ_BENCH_DISCOVERY_TOPICS: topics advertised per node (default 2).
+///   GZ_BENCH_DISCOVERY_HEARTBEAT_MS: heartbeat interval.
+///   GZ_BENCH_DISCOVERY_SILENCE_MS: silence interval.
+///   GZ_DISCOVERY_DELTA and GZ_DISCOVERY_BATCH, as in the transport.
+///
+/// Results: time until every process knows every publisher, UDP datagrams
+/// per second of the host and CPU per simulated process in steady state,
+/// and memory of the discovery information per process.
+TEST(DiscoveryScalability, Convergence)
+{
+  const int processes = envInt("GZ_BENCH_DISCOVERY_PROCESSES", 50);
+  const int nodes = envInt("GZ_BENCH_DISCOVERY_NODES", 20);
+  const int topics = envInt("GZ_BENCH_DISCOVERY_TOPICS", 2);
+  const int heartbeat = envInt("GZ_BENCH_DISCOVERY_HEARTBEAT_MS", 0);
+  const int silence = envInt("GZ_BENCH_DISCOVERY_SILENCE_MS", 0);
+  const bool delta = envInt("GZ_DISCOVERY_DELTA", 0) > 0;
+  const bool batch = envInt("GZ_DISCOVERY_BATCH", 0) > 0;
+
+  bench::Record("scale.processes", processes);
+  bench::Record("scale.nodes", processes * nodes);
+  bench::Record("scale.topics", processes * nodes * topics);
+
+  // Isolate the simulation from other discovery traffic.
+  const int port = 14000 + std::stoi(testing::getRandomNumber()) % 20000;
+
+  // Every process discovers the publishers of all the others.
+  const std::size_t expected = static_cast<std::size_t>(processes - 1) *
+    static_cast<std::size_t>(nodes * topics);
+  std::vector<std::unique_ptr<std::atomic<std::size_t>>> discovered;
+  std::vector<std::unique_ptr<MsgDiscovery>> discoveries;
+  std::vector<std::string> pUuids;
+
+  const double rssStart = rssBytes();
+  for (int p = 0; p < processes; ++p)
+  {
+    pUuids.push_back(Uuid().ToString());
+    discovered.push_back(std::make_unique<std::atomic<std::size_t>>(0u));
+    auto discovery = std::make_unique<MsgDiscovery>(pUuids.back(), kIp, port);
+    if (heartbeat > 0)
+      discovery->SetHeartbeatInterval(heartbeat);
+    if (silence > 0)
+      discovery->SetSilenceInterval(silence);
+    discovery->SetDeltaMode(delta);
+    discovery->SetBatching(batch);
+
+    std::atomic<std::size_t> *counter = discovered.back().get();
+    const std::string pUuid = pUuids.back();
+    discovery->ConnectionsCb([counter, pUuid](const MessagePublisher &_pub)
+    {
+      if (_pub.PUuid() != pUuid)
+        ++(*counter);
+    });
+    discoveries.push_back(std::move(discovery));
+  }
+
+  for (auto &discovery : discoveries)
+    discovery->Start();
+
+  const auto start = bench::Clock::now();
+  for (int p = 0; p < processes; ++p)
+  {
+    const std::string addr = "tcp://127.0.0.1:" + std::to_string(20000 + p);
+    for (int n = 0; n < nodes; ++n)
+    {
+      const std::string nUuid = Uuid().ToString();
+      for (int t = 0; t < topics; ++t)
+      {
+        const std::string topic = "/bench/p" + std::to_string(p) + "/n" +
+          std::to_string(n) + "/t" + std::to_string(t);
+        MessagePublisher pub(topic, addr, addr, pUuids[p], nUuid,
+          "gz.msgs.Int32", AdvertiseMessageOptions());
+        EXPECT_TRUE(discoveries[p]->Advertise(pub));
+      }
+    }
+  }
+
+  // Convergence: every process knows all the remote publishers.
+  bool converged = false;
+  while (!converged && bench::Clock::now() - start < kConvergenceTimeout)
+  {
+    converged = true;
+    for (const auto &counter : discovered)
+    {
+      if (*counter < expected)
+      {
+        converged = false;
+        break;
+      }
+    }
+    if (!converged)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  const auto end = bench::Clock::now();
+  ASSERT_TRUE(converged) << "Discovery didn't converge";
+  bench::Record("scale.convergence_us", bench::Us(start, end));
+
+  // Steady state: heartbeats only.
+  UdpCounters udpStart;
+  UdpCounters udpEnd;
+  const bool haveUdp = readUdpCounters(udpStart);
+  const double cpuStart = cpuSeconds();
+  std::this_thread::sleep_for(kSteadyState);
+  const double cpuEnd = cpuSeconds();
+  const double secs =
+    std::chrono::duration<double>(kSteadyState).count();
+  if (haveUdp && readUdpCounters(udpEnd))
+  {
+    bench::Record("scale.udp_out_per_s",
+      static_cast<double>(udpEnd.out - udpStart.out) / secs);
+    bench::Record("scale.udp_in_per_s",
+      static_cast<double>(udpEnd.in - udpStart.in) / secs);
+    bench::Record("scale.udp_rcvbuf_errors",
+      static_cast<double>(udpEnd.rcvbufErrors - udpStart.rcvbufErrors));
+  }
+  bench::Record("scale.cpu_us_per_s_per_process",
+    (cpuEnd - cpuStart) * 1e6 / secs / processes);
+
+  std::size_t bytes = 0;
+  for (const auto &discovery : discoveries)
+    bytes += storageBytes(discovery->Info());
+  bench::Record("scale.storage_bytes_per_process",
+    static_cast<double>(bytes) / processes);
+  bench::Record("scale.rss_bytes_per_process",
+    (rssBytes() - rssStart) / processes);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+
+using namespace gz;
+
+static const int kPublishers = 4;
+static const auto kDuration = std::chrono::seconds(2);
+
+//////////////////////////////////////////////////
+/// \brief Several threads publish on their own local topics while another
+/// thread keeps subscribing and unsubscribing. Reports the aggregated
+/// publication rate.
+TEST(LocalPubSubContention, PublishWhileChurning)
+{
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> received{0};
+  std::atomic<uint64_t> published{0};
+
+  std::function<void(const msgs::Int32 &)> cb =
+    [&received](const msgs::Int32 &)
+    {
+      ++received;
+    };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kPublishers; ++i)
+  {
+    threads.emplace_back([&, i]()
+    {
+      const std::string topic = "/contention_" + std::to_string(i);
+      transport::Node node;
+      auto pub = node.Advertise<msgs::Int32>(topic);
+      ASSERT_TRUE(pub);
+      ASSERT_TRUE(node.Subscribe(topic, cb));
+
+      msgs::Int32 msg;
+      msg.set_data(i);
+      while (!stop)
+      {
+        if (pub.Publish(msg))
+          ++published;
+      }
+    });
+  }
+
+  // Subscription churn on unrelated topics.
+  threads.emplace_back([&]()
+  {
+    transport::Node node;
+    while (!stop)
+    {
+      EXPECT_TRUE(node.Subscribe("/contention_churn", cb));
+      EXPECT_TRUE(node.Unsubscribe("/contention_churn"));
+    }
+  });
+
+  std::this_thread::sleep_for(kDuration);
+  stop = true;
+  for (auto &t : threads)
+    t.join();
+
+  const double secs =
+    std::chrono::duration_cast<std::chrono::duration<double>>(
+      kDuration).count();
+  std::cout << "Publishers: " << kPublishers << std::endl
+            << "Published: " << published / secs << " msgs/s" << std::endl
+            << "Received: " << received / secs << " msgs/s" << std::endl;
+
+  EXPECT_GT(published, 0u);
+}
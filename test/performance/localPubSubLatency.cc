@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/utils/Environment.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "bench_utils.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static const auto kTimeout = std::chrono::milliseconds(5000);
+
+//////////////////////////////////////////////////
+/// \brief Publish messages to subscribers of the same process. Records the
+/// latency between the publication and the last callback, one message at a
+/// time, and the throughput of a burst of messages.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _raw Whether the subscribers receive the serialized message.
+/// \param[in] _subscribers Number of subscribers.
+/// \param[in] _size Payload size (bytes).
+void runLocalPubSub(const std::string &_name, bool _raw,
+                    std::size_t _subscribers, std::size_t _size)
+{
+  const std::string topic = "/bench_local";
+  bench::Counter counter;
+
+  std::function<void(const msgs::Bytes &)> cb =
+    [&counter](const msgs::Bytes &)
+    {
+      counter.Add();
+    };
+  transport::RawCallback rawCb =
+    [&counter](const char *, const std::size_t, const transport::MessageInfo &)
+    {
+      counter.Add();
+    };
+
+  std::vector<std::unique_ptr<transport::Node>> nodes;
+  for (std::size_t i = 0; i < _subscribers; ++i)
+  {
+    nodes.push_back(std::make_unique<transport::Node>());
+    if (_raw)
+      ASSERT_TRUE(nodes.back()->SubscribeRaw(topic, rawCb, "gz.msgs.Bytes"));
+    else
+      ASSERT_TRUE(nodes.back()->Subscribe(topic, cb));
+  }
+
+  transport::Node node;
+  auto pub = node.Advertise<msgs::Bytes>(topic);
+  ASSERT_TRUE(pub);
+
+  msgs::Bytes msg;
+  msg.set_data(std::string(_size, 'x'));
+  const std::size_t iterations = bench::Iterations(_size);
+
+  std::vector<double> latency;
+  for (std::size_t i = 0; i < iterations; ++i)
+  {
+    counter.Reset();
+    const auto start = bench::Clock::now();
+    ASSERT_TRUE(pub.Publish(msg));
+    ASSERT_TRUE(counter.Wait(_subscribers, kTimeout));
+    latency.push_back(bench::Us(start, counter.Last()));
+  }
+  bench::RecordLatency(_name + ".latency", latency);
+
+  // The publication queue may drop messages, only the delivered ones count.
+  counter.Reset();
+  const auto start = bench::Clock::now();
+  for (std::size_t i = 0; i < iterations; ++i)
+    EXPECT_TRUE(pub.Publish(msg));
+  counter.Wait(iterations * _subscribers, kTimeout);
+  bench::RecordThroughput(_name, counter.Count() / _subscribers, _size,
+    bench::Us(start, counter.Last()));
+}
+
+//////////////////////////////////////////////////
+/// \brief Typed subscribers, for every payload size.
+TEST(LocalPubSubLatency, Typed)
+{
+  for (const std::size_t size : bench::PayloadSizes())
+    runLocalPubSub("typed." + bench::SizeName(size), false, 1, size);
+}
+
+//////////////////////////////////////////////////
+/// \brief Raw subscribers, for every payload size.
+TEST(LocalPubSubLatency, Raw)
+{
+  for (const std::size_t size : bench::PayloadSizes())
+    runLocalPubSub("raw." + bench::SizeName(size), true, 1, size);
+}
+
+//////////////////////////////////////////////////
+/// \brief Fan-out to 1, 8 and 64 typed subscribers.
+TEST(LocalPubSubLatency, FanOut)
+{
+  for (const std::size_t subscribers : {1u, 8u, 64u})
+  {
+    runLocalPubSub("fanout" + std::to_string(subscribers) + ".4KiB", false,
+      subscribers, 4096u);
+  }
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Don't interfere with other benchmarks running on the network.
+  gz::utils::setenv("GZ_PARTITION", testing::getRandomNumber());
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
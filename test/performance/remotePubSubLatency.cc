@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "bench_utils.hh"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const auto kTimeout = std::chrono::milliseconds(10000);
+
+//////////////////////////////////////////////////
+/// \brief Exchange messages with an echo process on the same host. The
+/// transport depends on the environment of the benchmark: TCP on the host
+/// address by default, loopback with GZ_IP=127.0.0.1 or shared memory with
+/// GZ_TRANSPORT_SHM=1, inherited by the echo process.
+class RemotePubSubLatency : public testing::Test
+{
+  /// \brief Start the echo process once for all the benchmarks.
+  protected: static void SetUpTestSuite()
+  {
+    echo = std::make_unique<gz::utils::Subprocess>(
+      std::vector<std::string>({test_executables::kBenchmark, partition,
+        "echo"}));
+  }
+
+  /// \brief Stop the echo process.
+  protected: static void TearDownTestSuite()
+  {
+    echo->Terminate();
+    echo->Join();
+    echo.reset();
+  }
+
+  /// \brief Send pings of one size to the echo process and wait for the
+  /// pongs. Records the round trip time, one message at a time, and the
+  /// throughput of a burst of messages.
+  /// \param[in] _name Prefix of the results.
+  /// \param[in] _raw Whether the subscribers receive the serialized message.
+  /// \param[in] _subscribers Number of subscribers of the pongs.
+  /// \param[in] _size Payload size (bytes).
+  protected: void Run(const std::string &_name, bool _raw,
+                      std::size_t _subscribers, std::size_t _size)
+  {
+    bench::Counter counter;
+    std::function<void(const msgs::Bytes &)> cb =
+      [&counter](const msgs::Bytes &)
+      {
+        counter.Add();
+      };
+    transport::RawCallback rawCb =
+      [&counter](const char *, const std::size_t,
+                 const transport::MessageInfo &)
+      {
+        counter.Add();
+      };
+
+    std::vector<std::unique_ptr<transport::Node>> nodes;
+    for (std::size_t i = 0; i < _subscribers; ++i)
+    {
+      nodes.push_back(std::make_unique<transport::Node>());
+      if (_raw)
+      {
+        ASSERT_TRUE(
+          nodes.back()->SubscribeRaw("/bench_pong", rawCb, "gz.msgs.Bytes"));
+      }
+      else
+      {
+        ASSERT_TRUE(nodes.back()->Subscribe("/bench_pong", cb));
+      }
+    }
+
+    transport::Node node;
+    auto pub = node.Advertise<msgs::Bytes>("/bench_ping");
+    ASSERT_TRUE(pub);
+
+    // Wait for the discovery and the connections in both directions.
+    msgs::Bytes msg;
+    msg.set_data("x");
+    bool connected = false;
+    for (int i = 0; i < 100 && !connected; ++i)
+    {
+      pub.Publish(msg);
+      connected = counter.Wait(_subscribers, std::chrono::milliseconds(100));
+    }
+    ASSERT_TRUE(connected) << "No response from the echo process";
+
+    // Let the echoes of the other attempts arrive.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    msg.set_data(std::string(_size, 'x'));
+    const std::size_t iterations = bench::Iterations(_size);
+
+    std::vector<double> rtt;
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+      counter.Reset();
+      const auto start = bench::Clock::now();
+      ASSERT_TRUE(pub.Publish(msg));
+      if (!counter.Wait(_subscribers, kTimeout))
+      {
+        ADD_FAILURE() << "Message " << i << " was lost";
+        break;
+      }
+      rtt.push_back(bench::Us(start, counter.Last()));
+    }
+    bench::RecordLatency(_name + ".rtt", rtt);
+
+    // Messages may be dropped by the high water marks, only the echoed ones
+    // count.
+    counter.Reset();
+    const auto start = bench::Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+      EXPECT_TRUE(pub.Publish(msg));
+    counter.Wait(iterations * _subscribers, kTimeout);
+    bench::RecordThroughput(_name, counter.Count() / _subscribers, _size,
+      bench::Us(start, counter.Last()));
+  }
+
+  /// \brief The echo process.
+  private: static std::unique_ptr<gz::utils::Subprocess> echo;
+};
+
+std::unique_ptr<gz::utils::Subprocess> RemotePubSubLatency::echo;
+
+//////////////////////////////////////////////////
+/// \brief Typed subscribers, for every payload size.
+TEST_F(RemotePubSubLatency, Typed)
+{
+  for (const std::size_t size : bench::PayloadSizes())
+    this->Run("typed." + bench::SizeName(size), false, 1, size);
+}
+
+//////////////////////////////////////////////////
+/// \brief Raw subscribers, for every payload size.
+TEST_F(RemotePubSubLatency, Raw)
+{
+  for (const std::size_t size : bench::PayloadSizes())
+    this->Run("raw." + bench::SizeName(size), true, 1, size);
+}
+
+//////////////////////////////////////////////////
+/// \brief Fan-out of the remote messages to 1, 8 and 64 typed subscribers.
+TEST_F(RemotePubSubLatency, FanOut)
+{
+  for (const std::size_t subscribers : {1u, 8u, 64u})
+  {
+    this->Run("fanout" + std::to_string(subscribers) + ".4KiB", false,
+      subscribers, 4096u);
+  }
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name, shared with the echo process.
+  partition = testing::getRandomNumber();
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/utils/Environment.hh>
+#include <gz/utils/Subprocess.hh>
+
+#include "gtest/gtest.h"
+#include "gz/transport/Node.hh"
+#include "bench_utils.hh"
+#include "test_config.hh"
+#include "test_utils.hh"
+
+using namespace gz;
+
+static std::string partition;  // NOLINT(*)
+static const unsigned int kTimeoutMs = 10000;
+
+//////////////////////////////////////////////////
+/// \brief Call a service with requests of every payload size. Records the
+/// round trip time of blocking requests.
+/// \param[in] _name Prefix of the results.
+/// \param[in] _service Service name.
+void runSrvCall(const std::string &_name, const std::string &_service)
+{
+  transport::Node node;
+
+  // Wait for the discovery of the responder.
+  msgs::Bytes req;
+  msgs::Bytes rep;
+  bool result = false;
+  bool executed = false;
+  for (int i = 0; i < 100 && !executed; ++i)
+    executed = node.Request(_service, req, 100u, rep, result);
+  ASSERT_TRUE(executed) << "No response from [" << _service << "]";
+
+  for (const std::size_t size : bench::PayloadSizes())
+  {
+    req.set_data(std::string(size, 'x'));
+    const std::size_t iterations = bench::Iterations(size);
+
+    std::vector<double> rtt;
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+      const auto start = bench::Clock::now();
+      ASSERT_TRUE(node.Request(_service, req, kTimeoutMs, rep, result));
+      rtt.push_back(bench::Us(start, bench::Clock::now()));
+      ASSERT_TRUE(result);
+      ASSERT_EQ(size, rep.data().size());
+    }
+    bench::RecordLatency(_name + "." + bench::SizeName(size) + ".rtt", rtt);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Responder in the same process.
+TEST(SrvCallLatency, Local)
+{
+  std::function<bool(const msgs::Bytes &, msgs::Bytes &)> cb =
+    [](const msgs::Bytes &_req, msgs::Bytes &_rep)
+    {
+      _rep = _req;
+      return true;
+    };
+
+  transport::Node node;
+  ASSERT_TRUE(node.Advertise("/bench_local_srv", cb));
+  runSrvCall("local", "/bench_local_srv");
+}
+
+//////////////////////////////////////////////////
+/// \brief Responder in another process of the same host.
+TEST(SrvCallLatency, Remote)
+{
+  gz::utils::Subprocess echo(std::vector<std::string>(
+    {test_executables::kBenchmark, partition, "echo"}));
+
+  runSrvCall("remote", "/bench_srv");
+
+  echo.Terminate();
+  echo.Join();
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  // Get a random partition name, shared with the echo process.
+  partition = testing::getRandomNumber();
+  gz::utils::setenv("GZ_PARTITION", partition);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
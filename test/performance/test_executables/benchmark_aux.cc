@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gz/msgs/bytes.pb.h>
+#include <gz/msgs/int32.pb.h>
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gz/transport/Node.hh"
+
+#include <gz/utils/Environment.hh>
+
+using namespace gz;
+
+//////////////////////////////////////////////////
+/// \brief Peer process of the benchmarks. It runs until it's terminated.
+///
+/// Usage:
+///   benchmark_aux <partition> echo
+///     Republishes every message of /bench_ping on /bench_pong and answers
+///     the /bench_srv service with its request.
+///   benchmark_aux <partition> advertise <N>
+///     Advertises the topics /bench_topic_0 ... /bench_topic_<N-1>.
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <partition> echo|advertise [N]"
+              << std::endl;
+    return -1;
+  }
+
+  // Set the partition name for this process.
+  gz::utils::setenv("GZ_PARTITION", argv[1]);
+
+  transport::Node node;
+  const std::string mode = argv[2];
+  if (mode == "echo")
+  {
+    auto pub = node.Advertise<msgs::Bytes>("/bench_pong");
+    transport::RawCallback cb =
+      [&pub](const char *_data, const std::size_t _size,
+             const transport::MessageInfo &)
+      {
+        pub.PublishRaw(std::string(_data, _size), "gz.msgs.Bytes");
+      };
+    if (!pub || !node.SubscribeRaw("/bench_ping", cb, "gz.msgs.Bytes"))
+      return -1;
+
+    std::function<bool(const msgs::Bytes &, msgs::Bytes &)> srvCb =
+      [](const msgs::Bytes &_req, msgs::Bytes &_rep)
+      {
+        _rep = _req;
+        return true;
+      };
+    if (!node.Advertise("/bench_srv", srvCb))
+      return -1;
+
+    transport::waitForShutdown();
+  }
+  else if (mode == "advertise" && argc == 4)
+  {
+    const int topics = std::stoi(argv[3]);
+    std::vector<transport::Node::Publisher> pubs;
+    for (int i = 0; i < topics; ++i)
+    {
+      pubs.push_back(
+        node.Advertise<msgs::Int32>("/bench_topic_" + std::to_string(i)));
+    }
+
+    transport::waitForShutdown();
+  }
+  else
+  {
+    std::cerr << "Unknown mode [" << mode << "]" << std::endl;
+    return -1;
+  }
+}